@@ -35,6 +35,10 @@ namespace dmCrash
     static char g_FilePathDefault[AppState::FILEPATH_MAX];
     static bool g_CrashDumpEnabled = true;
 
+    // The scope names interned into g_AppState.m_ScopeNames, compared by pointer
+    static const char* g_ScopeNamePtrs[AppState::SCOPE_NAMES_MAX];
+    static uint32_t g_ScopeNameCount = 0;
+
     void SetExtraInfoCallback(FCallstackExtraInfoCallback cbk);
     char g_FilePath[AppState::FILEPATH_MAX];
 
@@ -47,6 +51,7 @@ namespace dmCrash
     {
         memset(g_FilePath, 0x0, sizeof(g_FilePath));
         memset(&g_AppState, 0x0, sizeof(g_AppState));
+        g_ScopeNameCount = 0;
 
         // Construct a file path with the app name 'Defold' until it is modified by the application;
         // this also means crash files can be stored in two different places. At the default path or in the
@@ -118,6 +123,51 @@ namespace dmCrash
         return RESULT_INVALID_PARAM;
     }
 
+    static uint8_t InternScopeName(const char* name)
+    {
+        for (uint32_t i = 0; i < g_ScopeNameCount; ++i)
+        {
+            if (g_ScopeNamePtrs[i] == name)
+                return (uint8_t) i;
+        }
+        if (g_ScopeNameCount == AppState::SCOPE_NAMES_MAX)
+            return AppState::SCOPE_NONE;
+
+        uint32_t i = g_ScopeNameCount++;
+        g_ScopeNamePtrs[i] = name;
+        dmStrlCpy(g_AppState.m_ScopeNames[i], name, AppState::SCOPE_NAME_SIZE);
+        return (uint8_t) i;
+    }
+
+    void RecordFrame(const FrameInfo* info)
+    {
+        FrameRecord* record = &g_AppState.m_Frames[g_AppState.m_FrameCount % AppState::FRAMES_MAX];
+        record->m_FrameTime = info->m_FrameTime;
+        record->m_LuaMem = info->m_LuaMem;
+        record->m_Mem = info->m_Mem;
+        for (uint32_t i = 0; i < FRAME_SCOPES_MAX; ++i)
+        {
+            const char* name = info->m_ScopeNames[i];
+            record->m_Scopes[i] = name ? InternScopeName(name) : AppState::SCOPE_NONE;
+            record->m_ScopeTimes[i] = name ? info->m_ScopeTimes[i] : 0.0f;
+        }
+        // Written last, so that a crash while recording sees the complete previous frames
+        g_AppState.m_FrameCount++;
+    }
+
+    void RecordResourceLoad(const char* path, uint32_t size)
+    {
+        ResourceLoadRecord* record = &g_AppState.m_ResourceLoads[g_AppState.m_ResourceLoadCount % AppState::RESOURCE_LOADS_MAX];
+        record->m_Frame = g_AppState.m_FrameCount;
+        record->m_Size = size;
+        // Keep the end of the path, the file name is more useful than the directories
+        uint32_t len = (uint32_t) strlen(path);
+        if (len >= sizeof(record->m_Path))
+            path += len - (sizeof(record->m_Path) - 1);
+        dmStrlCpy(record->m_Path, path, sizeof(record->m_Path));
+        g_AppState.m_ResourceLoadCount++;
+    }
+
     static HDump LoadPrevious(FILE *f)
     {
         AppStateHeader header;
@@ -316,6 +366,76 @@ namespace dmCrash
         return 0;
     }
 
+    uint32_t GetFrameCount(HDump dump)
+    {
+        AppState* state = Check(dump);
+        if (state != NULL)
+        {
+            return dmMath::Min(AppState::FRAMES_MAX, state->m_FrameCount);
+        }
+
+        return 0;
+    }
+
+    bool GetFrame(HDump dump, uint32_t index, FrameInfo* info)
+    {
+        AppState* state = Check(dump);
+        uint32_t count = GetFrameCount(dump);
+        if (state == NULL || index >= count)
+        {
+            return false;
+        }
+
+        const FrameRecord& record = state->m_Frames[(state->m_FrameCount - count + index) % AppState::FRAMES_MAX];
+        info->m_FrameTime = record.m_FrameTime;
+        info->m_LuaMem = record.m_LuaMem;
+        info->m_Mem = record.m_Mem;
+        for (uint32_t i = 0; i < FRAME_SCOPES_MAX; ++i)
+        {
+            uint8_t scope = record.m_Scopes[i];
+            if (scope < AppState::SCOPE_NAMES_MAX)
+            {
+                char* name = state->m_ScopeNames[scope];
+                name[AppState::SCOPE_NAME_SIZE - 1] = 0;
+                info->m_ScopeNames[i] = name;
+                info->m_ScopeTimes[i] = record.m_ScopeTimes[i];
+            }
+            else
+            {
+                info->m_ScopeNames[i] = 0;
+                info->m_ScopeTimes[i] = 0.0f;
+            }
+        }
+        return true;
+    }
+
+    uint32_t GetResourceLoadCount(HDump dump)
+    {
+        AppState* state = Check(dump);
+        if (state != NULL)
+        {
+            return dmMath::Min(AppState::RESOURCE_LOADS_MAX, state->m_ResourceLoadCount);
+        }
+
+        return 0;
+    }
+
+    const char* GetResourceLoad(HDump dump, uint32_t index, uint32_t* frames_ago, uint32_t* size)
+    {
+        AppState* state = Check(dump);
+        uint32_t count = GetResourceLoadCount(dump);
+        if (state == NULL || index >= count)
+        {
+            return 0;
+        }
+
+        ResourceLoadRecord& record = state->m_ResourceLoads[(state->m_ResourceLoadCount - count + index) % AppState::RESOURCE_LOADS_MAX];
+        record.m_Path[sizeof(record.m_Path) - 1] = 0;
+        *frames_ago = state->m_FrameCount - record.m_Frame;
+        *size = record.m_Size;
+        return record.m_Path;
+    }
+
     void LogCallstack(char* extras)
     {
         bool is_debug_mode = dLib::IsDebugMode();
@@ -40,6 +40,21 @@ namespace dmCrash
 
     typedef int HDump;
 
+    /// Number of profile scopes recorded per frame by the flight recorder
+    const uint32_t FRAME_SCOPES_MAX = 3;
+
+    /**
+     * Timings and memory state of a frame, see RecordFrame
+     */
+    struct FrameInfo
+    {
+        const char* m_ScopeNames[FRAME_SCOPES_MAX]; // The most expensive profile scopes, or null
+        float       m_ScopeTimes[FRAME_SCOPES_MAX]; // ms
+        float       m_FrameTime;                    // ms
+        uint32_t    m_LuaMem;                       // Kb
+        uint32_t    m_Mem;                          // Kb used by the process, 0 if unknown
+    };
+
     /**
      * Initializes the crash reporting library, installs crash signal handlers.
      * @param version string for SYSFIELD_ENGINE_VERSION field
@@ -89,6 +104,21 @@ namespace dmCrash
      */
     Result SetUserField(uint32_t index, const char* value);
 
+    /**
+     * Record a frame into the flight recorder. The last frames and resource loads are
+     * kept in ring buffers that are written into the crash dump as is, so that the
+     * performance leading up to a crash can be inspected.
+     * @param info The frame. The scope names should be static strings, e.g. profile scope names
+     */
+    void RecordFrame(const FrameInfo* info);
+
+    /**
+     * Record a resource load into the flight recorder, see RecordFrame
+     * @param path Resource path, only the end is kept if it is too long
+     * @param size Size of the resource on disc
+     */
+    void RecordResourceLoad(const char* path, uint32_t size);
+
     /**
      * Load a previously written crash dump. First, the default path is examined, and then
      * the path set by SetFilePath.
@@ -182,6 +212,39 @@ namespace dmCrash
      * @return address of the module, null if there are no more
      */
     void* GetModuleAddr(HDump dump, uint32_t index);
+
+    /**
+     * Get the number of frames recorded by the flight recorder in a crash dump.
+     * @param dump crash dump handle
+     * @return Number of recorded frames
+     */
+    uint32_t GetFrameCount(HDump dump);
+
+    /**
+     * Get a frame recorded by the flight recorder, see RecordFrame
+     * @param dump crash dump handle
+     * @param index index of the frame, 0 is the oldest
+     * @param info [out] the frame. The scope names point into the dump
+     * @return true if the frame was found
+     */
+    bool GetFrame(HDump dump, uint32_t index, FrameInfo* info);
+
+    /**
+     * Get the number of resource loads recorded by the flight recorder in a crash dump.
+     * @param dump crash dump handle
+     * @return Number of recorded resource loads
+     */
+    uint32_t GetResourceLoadCount(HDump dump);
+
+    /**
+     * Get a resource load recorded by the flight recorder, see RecordResourceLoad
+     * @param dump crash dump handle
+     * @param index index of the load, 0 is the oldest
+     * @param frames_ago [out] the number of frames recorded after the load
+     * @param size [out] size of the resource on disc
+     * @return the resource path, null if the load wasn't found
+     */
+    const char* GetResourceLoad(HDump dump, uint32_t index, uint32_t* frames_ago, uint32_t* size);
 }
 
 #endif
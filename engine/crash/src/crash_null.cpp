@@ -145,5 +145,44 @@ namespace dmCrash
         (void)index;
         return 0;
     }
-}
 
+    void RecordFrame(const FrameInfo* info)
+    {
+        (void)info;
+    }
+
+    void RecordResourceLoad(const char* path, uint32_t size)
+    {
+        (void)path;
+        (void)size;
+    }
+
+    uint32_t GetFrameCount(HDump dump)
+    {
+        (void)dump;
+        return 0;
+    }
+
+    bool GetFrame(HDump dump, uint32_t index, FrameInfo* info)
+    {
+        (void)dump;
+        (void)index;
+        (void)info;
+        return false;
+    }
+
+    uint32_t GetResourceLoadCount(HDump dump)
+    {
+        (void)dump;
+        return 0;
+    }
+
+    const char* GetResourceLoad(HDump dump, uint32_t index, uint32_t* frames_ago, uint32_t* size)
+    {
+        (void)dump;
+        (void)index;
+        (void)frames_ago;
+        (void)size;
+        return 0;
+    }
+}
@@ -31,9 +31,27 @@ namespace dmCrash
         }
     };
 
+    // Packed version of FrameInfo
+    struct FrameRecord
+    {
+        float       m_FrameTime;
+        uint32_t    m_LuaMem;
+        uint32_t    m_Mem;
+        float       m_ScopeTimes[FRAME_SCOPES_MAX];
+        uint8_t     m_Scopes[FRAME_SCOPES_MAX];     // Index into AppState::m_ScopeNames, SCOPE_NONE if unused
+        uint8_t     m_Pad;
+    };
+
+    struct ResourceLoadRecord
+    {
+        uint32_t    m_Frame;
+        uint32_t    m_Size;
+        char        m_Path[64];
+    };
+
     struct AppState
     {
-        static const uint32_t VERSION          = 2;
+        static const uint32_t VERSION          = 3;
         static const uint32_t MODULES_MAX      = 128;
         static const uint32_t MODULE_NAME_SIZE = 64;
         static const uint32_t PTRS_MAX         = 64;
@@ -41,6 +59,11 @@ namespace dmCrash
         static const uint32_t USERDATA_SIZE    = 256;
         static const uint32_t EXTRA_MAX        = 32768;
         static const uint32_t FILEPATH_MAX     = 1024;
+        static const uint32_t FRAMES_MAX       = 600;
+        static const uint32_t SCOPE_NAMES_MAX  = 64;
+        static const uint32_t SCOPE_NAME_SIZE  = 32;
+        static const uint32_t SCOPE_NONE       = 0xff;
+        static const uint32_t RESOURCE_LOADS_MAX = 64;
 
         // Version of app (defold)
         char m_EngineVersion[32];
@@ -64,6 +87,13 @@ namespace dmCrash
         void* m_Ptr[PTRS_MAX];
         char m_Extra[EXTRA_MAX];
 
+        // Flight recorder. The ring buffers are written to at index m_*Count % *_MAX
+        FrameRecord m_Frames[FRAMES_MAX];
+        uint32_t m_FrameCount;
+        char m_ScopeNames[SCOPE_NAMES_MAX][SCOPE_NAME_SIZE];
+        ResourceLoadRecord m_ResourceLoads[RESOURCE_LOADS_MAX];
+        uint32_t m_ResourceLoadCount;
+
         AppState()
         {
             memset(this, 0x0, sizeof(*this));
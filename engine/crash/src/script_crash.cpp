@@ -301,6 +301,111 @@ namespace dmCrash
         return 1;
     }
 
+    /*# read the frames recorded before the crash
+     *
+     * The flight recorder keeps the timings of the last 600 frames, which are
+     * written into the crash dump. A table is returned with a sub-table for each frame,
+     * oldest first, with the fields:
+     *
+     * `frame_time`
+     * : [type:number] time of the frame in milliseconds
+     *
+     * `lua_mem`
+     * : [type:number] Lua memory in kilobytes
+     *
+     * `mem`
+     * : [type:number] memory used by the process in kilobytes, 0 if unknown
+     *
+     * `scopes`
+     * : [type:table] the most expensive profile scopes of the frame, with fields `name` and `time` (ms)
+     *
+     * @name crash.get_frames
+     * @param handle [type:number] crash dump handle
+     * @return frames [type:table] table containing the frames
+     */
+    static int Crash_GetFrames(lua_State* L)
+    {
+        int top = lua_gettop(L);
+        HDump h = CheckHandle(L, 1);
+        uint32_t count = GetFrameCount(h);
+        lua_createtable(L, count, 0);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            FrameInfo info;
+            GetFrame(h, i, &info);
+
+            lua_newtable(L);
+            lua_pushnumber(L, info.m_FrameTime);
+            lua_setfield(L, -2, "frame_time");
+            lua_pushnumber(L, info.m_LuaMem);
+            lua_setfield(L, -2, "lua_mem");
+            lua_pushnumber(L, info.m_Mem);
+            lua_setfield(L, -2, "mem");
+
+            lua_newtable(L);
+            for (uint32_t s = 0, n = 1; s < FRAME_SCOPES_MAX; ++s)
+            {
+                if (!info.m_ScopeNames[s])
+                    continue;
+                lua_newtable(L);
+                lua_pushstring(L, info.m_ScopeNames[s]);
+                lua_setfield(L, -2, "name");
+                lua_pushnumber(L, info.m_ScopeTimes[s]);
+                lua_setfield(L, -2, "time");
+                lua_rawseti(L, -2, n++);
+            }
+            lua_setfield(L, -2, "scopes");
+
+            lua_rawseti(L, -2, i + 1);
+        }
+
+        assert(lua_gettop(L) == (top+1));
+        return 1;
+    }
+
+    /*# read the resource loads recorded before the crash
+     *
+     * The flight recorder keeps the last 64 resource loads. A table is returned
+     * with a sub-table for each load, oldest first, with the fields:
+     *
+     * `path`
+     * : [type:string] the resource path. Long paths are truncated from the start
+     *
+     * `size`
+     * : [type:number] size of the resource on disc, in bytes
+     *
+     * `frames_ago`
+     * : [type:number] number of frames recorded after the load
+     *
+     * @name crash.get_resource_loads
+     * @param handle [type:number] crash dump handle
+     * @return loads [type:table] table containing the resource loads
+     */
+    static int Crash_GetResourceLoads(lua_State* L)
+    {
+        int top = lua_gettop(L);
+        HDump h = CheckHandle(L, 1);
+        uint32_t count = GetResourceLoadCount(h);
+        lua_createtable(L, count, 0);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t frames_ago, size;
+            const char* path = GetResourceLoad(h, i, &frames_ago, &size);
+
+            lua_newtable(L);
+            lua_pushstring(L, path);
+            lua_setfield(L, -2, "path");
+            lua_pushnumber(L, size);
+            lua_setfield(L, -2, "size");
+            lua_pushnumber(L, frames_ago);
+            lua_setfield(L, -2, "frames_ago");
+            lua_rawseti(L, -2, i + 1);
+        }
+
+        assert(lua_gettop(L) == (top+1));
+        return 1;
+    }
+
     static const luaL_reg Crash_methods[] =
     {
         {"set_file_path", Crash_SetFilePath},
@@ -311,6 +416,8 @@ namespace dmCrash
         {"get_modules", Crash_GetModules},
         {"get_extra_data", Crash_GetExtraData},
         {"get_signum", Crash_GetSignum},
+        {"get_frames", Crash_GetFrames},
+        {"get_resource_loads", Crash_GetResourceLoads},
         {"release", Crash_ReleasePrevious},
         {"set_user_field", Crash_SetUserField},
         {"write_dump", Crash_WriteDump},
@@ -116,6 +116,76 @@ TEST_F(dmCrashTest, TestLoad)
     ASSERT_GT(count, 3);
 }
 
+TEST_F(dmCrashTest, TestFlightRecorder)
+{
+    static const char* scope_a = "Update";
+    static const char* scope_b = "Render";
+
+    const uint32_t frame_count = dmCrash::AppState::FRAMES_MAX + 10;
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        dmCrash::FrameInfo info;
+        memset(&info, 0, sizeof(info));
+        info.m_FrameTime = (float) i;
+        info.m_LuaMem = i * 2;
+        info.m_Mem = i * 3;
+        info.m_ScopeNames[0] = scope_a;
+        info.m_ScopeTimes[0] = 1.0f;
+        info.m_ScopeNames[1] = (i & 1) ? scope_b : 0;
+        info.m_ScopeTimes[1] = 0.5f;
+        dmCrash::RecordFrame(&info);
+
+        if (i == frame_count - 3)
+            dmCrash::RecordResourceLoad("/a/very/long/path/to/a/resource/that/does/not/fit/into/the/crash/dump/main.collectionc", 1234);
+    }
+    dmCrash::RecordResourceLoad("/main/main.scriptc", 16);
+
+    dmCrash::WriteDump();
+    dmCrash::HDump d = dmCrash::LoadPrevious();
+    ASSERT_NE(d, 0);
+
+    // Only the last frames are kept, oldest first
+    ASSERT_EQ(dmCrash::AppState::FRAMES_MAX, dmCrash::GetFrameCount(d));
+    for (uint32_t i = 0; i < dmCrash::AppState::FRAMES_MAX; ++i)
+    {
+        uint32_t frame = i + 10;
+        dmCrash::FrameInfo info;
+        ASSERT_TRUE(dmCrash::GetFrame(d, i, &info));
+        ASSERT_EQ((float) frame, info.m_FrameTime);
+        ASSERT_EQ(frame * 2, info.m_LuaMem);
+        ASSERT_EQ(frame * 3, info.m_Mem);
+        ASSERT_STREQ(scope_a, info.m_ScopeNames[0]);
+        ASSERT_EQ(1.0f, info.m_ScopeTimes[0]);
+        if (frame & 1)
+        {
+            ASSERT_STREQ(scope_b, info.m_ScopeNames[1]);
+            ASSERT_EQ(0.5f, info.m_ScopeTimes[1]);
+        }
+        else
+        {
+            ASSERT_EQ((const char*) 0, info.m_ScopeNames[1]);
+        }
+        ASSERT_EQ((const char*) 0, info.m_ScopeNames[2]);
+    }
+    dmCrash::FrameInfo info;
+    ASSERT_FALSE(dmCrash::GetFrame(d, dmCrash::AppState::FRAMES_MAX, &info));
+
+    ASSERT_EQ(2u, dmCrash::GetResourceLoadCount(d));
+    uint32_t frames_ago, size;
+    const char* path = dmCrash::GetResourceLoad(d, 0, &frames_ago, &size);
+    ASSERT_NE((const char*) 0, path);
+    // The end of a long path is kept
+    ASSERT_STREQ("main.collectionc", path + strlen(path) - strlen("main.collectionc"));
+    ASSERT_EQ(2u, frames_ago);
+    ASSERT_EQ(1234u, size);
+    ASSERT_STREQ("/main/main.scriptc", dmCrash::GetResourceLoad(d, 1, &frames_ago, &size));
+    ASSERT_EQ(0u, frames_ago);
+    ASSERT_EQ(16u, size);
+    ASSERT_EQ((const char*) 0, dmCrash::GetResourceLoad(d, 2, &frames_ago, &size));
+
+    dmCrash::Release(d);
+}
+
 TEST_F(dmCrashTest, TestPurgeCustomPath)
 {
     dmCrash::SetFilePath(MOUNTFS "remove-me");
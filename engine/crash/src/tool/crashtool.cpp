@@ -456,6 +456,32 @@ int main(int argc, char** argv)
         }
         printf("\n");
 
+        printf("%s:\n", "FRAMES");
+        printf("%6s %10s %8s %8s  %s\n", "frame", "time (ms)", "lua (kb)", "mem (kb)", "top scopes (ms)");
+        uint32_t frame_count = dmCrash::GetFrameCount(dump);
+        for (uint32_t i = 0; i < frame_count; ++i)
+        {
+            dmCrash::FrameInfo info;
+            dmCrash::GetFrame(dump, i, &info);
+            printf("%6d %10.2f %8u %8u ", (int)i - (int)frame_count, info.m_FrameTime, info.m_LuaMem, info.m_Mem);
+            for (uint32_t s = 0; s < dmCrash::FRAME_SCOPES_MAX; ++s)
+            {
+                if (info.m_ScopeNames[s])
+                    printf(" %s %.2f", info.m_ScopeNames[s], info.m_ScopeTimes[s]);
+            }
+            printf("\n");
+        }
+
+        printf("\n%s:\n", "RESOURCE LOADS");
+        uint32_t load_count = dmCrash::GetResourceLoadCount(dump);
+        for (uint32_t i = 0; i < load_count; ++i)
+        {
+            uint32_t frames_ago, size;
+            const char* path = dmCrash::GetResourceLoad(dump, i, &frames_ago, &size);
+            printf("%6d %s (%u bytes)\n", -(int)frames_ago, path, size);
+        }
+        printf("\n");
+
         // Win32 try outs
     // uintptr_t moduleaddr = (uintptr_t)GetProcessBaseAddress(info, info.pi.dwProcessId);
     // printf("MODULE BASE ADDR: 0x%016lx\n", moduleaddr);
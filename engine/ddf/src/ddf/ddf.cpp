@@ -21,6 +21,7 @@
 #include <dlib/hash.h>
 #include <dlib/hashtable.h>
 #include "ddf.h"
+#include "ddf_baked.h"
 #include "ddf_inputbuffer.h"
 #include "ddf_load.h"
 #include "ddf_save.h"
@@ -79,11 +80,32 @@ namespace dmDDF
         return GetDescriptorFromHash(dmHashString64(name));
     }
 
+    // Memory for the default strings of the optional fields, that are allocated if the fields are missing
+    static uint32_t DefaultsMemoryBound(const Descriptor* desc)
+    {
+        uint32_t size = 0;
+        for (int i = 0; i < desc->m_FieldCount; ++i)
+        {
+            const FieldDescriptor* f = &desc->m_Fields[i];
+            if (f->m_Label != LABEL_OPTIONAL)
+                continue;
+            if (f->m_Type == TYPE_STRING && f->m_DefaultValue)
+                size += strlen(f->m_DefaultValue) + 1;
+            else if (f->m_Type == TYPE_MESSAGE)
+                size += DefaultsMemoryBound(f->m_MessageDescriptor);
+        }
+        return size;
+    }
+
     static Result CalculateRepeated(LoadContext* load_context, InputBuffer* ib, const Descriptor* desc)
     {
         assert(desc);
 
-        // Calculate number of entries in arrays, ie memory requirements for the entire message
+        // Calculate number of entries in arrays, and an upper bound of the memory requirements for the entire message
+        // Every allocation except strings is 16 byte aligned
+        const uint32_t align_pad = 15;
+        load_context->IncreaseMemoryBound(DefaultsMemoryBound(desc));
+
         uint32_t start = ib->Tell();
         while (!ib->Eof())
         {
@@ -109,9 +131,22 @@ namespace dmDDF
                     if (field->m_Label == LABEL_REPEATED)
                     {
                         load_context->IncreaseArrayCount(start, field->m_Number);
+                        uint32_t first = load_context->GetArrayCount(start, field->m_Number) == 1 ? align_pad : 0;
+                        load_context->IncreaseMemoryBound(first + RepeatedElementSize(field));
                     }
 
-                    if (field->m_Type != TYPE_MESSAGE)
+                    if ((field->m_Type == TYPE_STRING || field->m_Type == TYPE_BYTES) && type == WIRETYPE_LENGTH_DELIMITED)
+                    {
+                        uint32_t length;
+                        if (!ib->ReadVarInt32(&length) || !ib->Skip(length))
+                            return RESULT_WIRE_FORMAT_ERROR;
+
+                        if (field->m_Type == TYPE_STRING)
+                            load_context->IncreaseMemoryBound(length + 1);
+                        else if ((load_context->GetOptions() & OPTION_IN_PLACE) == 0)
+                            load_context->IncreaseMemoryBound(length + align_pad);
+                    }
+                    else if (field->m_Type != TYPE_MESSAGE)
                     {
                         Result e = SkipField(ib, type);
                         if (e != RESULT_OK)
@@ -155,21 +190,27 @@ namespace dmDDF
         return LoadMessage(buffer, buffer_size, desc, out_message, 0, 0);
     }
 
-    Result LoadMessage(const void* buffer, uint32_t buffer_size, const Descriptor* desc, void** out_message, uint32_t options, uint32_t* size)
+    // Loads the message into memory, or into memory allocated here if memory is null. The message is measured while
+    // the repeated fields are counted, so the fields are only read once
+    static Result DoLoadMessageIntoMemory(const void* buffer, uint32_t buffer_size, const Descriptor* desc, void* memory, uint32_t memory_size,
+                                          uint32_t options, void** out_message, uint32_t* size)
     {
-        DM_PROFILE(DDF, "LoadMessage");
         assert(buffer);
         assert(desc);
         assert(out_message);
+        assert((options & (OPTION_OFFSET_POINTERS | OPTION_IN_PLACE)) != (OPTION_OFFSET_POINTERS | OPTION_IN_PLACE));
 
+        *out_message = 0;
         if (size)
             *size = 0;
 
         if (desc->m_MajorVersion != DDF_MAJOR_VERSION)
             return RESULT_VERSION_MISMATCH;
 
+        if ((options & OPTION_OFFSET_POINTERS) == 0 && IsBakedMessage(buffer, buffer_size))
+            return DoLoadBakedMessage(buffer, buffer_size, desc, memory, memory_size, out_message, size);
+
         LoadContext load_context(0, 0, true, options);
-        Message dry_message = load_context.AllocMessage(desc);
 
         InputBuffer input_buffer((const char*) buffer, buffer_size);
 
@@ -179,13 +220,25 @@ namespace dmDDF
             return e;
         }
 
-        input_buffer.Seek(0);
-        e = DoLoadMessage(&load_context, &input_buffer, desc, &dry_message);
+        // The top level message
+        int message_buffer_size = (int) (load_context.GetMemoryBound() + desc->m_Size);
+        char* message_buffer = (char*) memory;
+        if (message_buffer)
+        {
+            if ((uint32_t) message_buffer_size > memory_size)
+            {
+                if (size)
+                    *size = message_buffer_size;
+                return RESULT_BUFFER_TOO_SMALL;
+            }
+        }
+        else
+        {
+            dmMemory::AlignedMalloc((void**)&message_buffer, 16, message_buffer_size);
+            assert(message_buffer);
+        }
+        assert(((uintptr_t) message_buffer & 15) == 0);
 
-        int message_buffer_size = load_context.GetMemoryUsage();
-        char* message_buffer = 0;
-        dmMemory::AlignedMalloc((void**)&message_buffer, 16, message_buffer_size);
-        assert(message_buffer);
         load_context.SetMemoryBuffer(message_buffer, message_buffer_size, false);
         Message message = load_context.AllocMessage(desc);
 
@@ -193,18 +246,31 @@ namespace dmDDF
         e = DoLoadMessage(&load_context, &input_buffer, desc, &message);
         if ( e == RESULT_OK )
         {
+            assert(load_context.GetMemoryUsage() <= message_buffer_size);
             if (size)
-                *size = message_buffer_size;
+                *size = load_context.GetMemoryUsage();
             *out_message = (void*) message_buffer;
         }
-        else
+        else if (!memory)
         {
             dmMemory::AlignedFree((void*) message_buffer);
-            *out_message = 0;
         }
         return e;
     }
 
+    Result LoadMessage(const void* buffer, uint32_t buffer_size, const Descriptor* desc, void** out_message, uint32_t options, uint32_t* size)
+    {
+        DM_PROFILE(DDF, "LoadMessage");
+        return DoLoadMessageIntoMemory(buffer, buffer_size, desc, 0, 0, options, out_message, size);
+    }
+
+    Result LoadMessageIntoMemory(const void* buffer, uint32_t buffer_size, const Descriptor* desc, void* memory, uint32_t memory_size, uint32_t options, void** message, uint32_t* size)
+    {
+        DM_PROFILE(DDF, "LoadMessage");
+        assert(memory);
+        return DoLoadMessageIntoMemory(buffer, buffer_size, desc, memory, memory_size, options, message, size);
+    }
+
     Result LoadMessageFromFile(const char* file_name, const Descriptor* desc, void** message)
     {
         FILE* f = fopen(file_name, "rb");
@@ -112,6 +112,7 @@ namespace dmDDF
         RESULT_IO_ERROR = 3,
         RESULT_VERSION_MISMATCH = 4,
         RESULT_MISSING_REQUIRED = 5,
+        RESULT_BUFFER_TOO_SMALL = 6,
         RESULT_INTERNAL_ERROR = 1000,
     };
 
@@ -127,6 +128,10 @@ namespace dmDDF
 
     /// Store pointers as offset from base address. Needed when serializing entire messages (copy)
     const uint32_t OPTION_OFFSET_POINTERS = (1 << 0);
+    /// Let bytes fields point into the input buffer instead of copying them. The input buffer must outlive the message,
+    /// and the data is not aligned. Strings are still copied since they are not null terminated in the input.
+    /// Can't be combined with OPTION_OFFSET_POINTERS
+    const uint32_t OPTION_IN_PLACE = (1 << 1);
 
     /**
      * Internal. Do not use.
@@ -177,6 +182,35 @@ namespace dmDDF
      */
     Result LoadMessage(const void* buffer, uint32_t buffer_size, const Descriptor* desc, void** message, uint32_t options, uint32_t* size);
 
+    /**
+     * Load/decode a DDF message into caller supplied memory, e.g. an arena shared by several messages.
+     * Nothing is allocated and the message must not be freed with FreeMessage().
+     * @param buffer Input buffer
+     * @param buffer_size Input buffer size in bytes
+     * @param desc DDF descriptor
+     * @param memory Memory to load the message into, 16 byte aligned
+     * @param memory_size Memory size in bytes
+     * @param options options, eg OPTION_IN_PLACE
+     * @param message Pointer to message, equal to memory on success
+     * @param size load message size [out]. The size needed if RESULT_BUFFER_TOO_SMALL is returned
+     * @return RESULT_OK on success, RESULT_BUFFER_TOO_SMALL if the memory is too small
+     */
+    Result LoadMessageIntoMemory(const void* buffer, uint32_t buffer_size, const Descriptor* desc, void* memory, uint32_t memory_size, uint32_t options, void** message, uint32_t* size);
+
+    /**
+     * Bake a DDF message into a format that is loaded without decoding. The baked message is the loaded message
+     * as is, with its pointers stored as offsets, so loading it is a copy and a single pass that resolves the offsets.
+     * LoadMessage() and LoadMessageIntoMemory() accept both baked and protobuf encoded messages.
+     * @note The baked format depends on the struct layout, so it must be baked with the pointer size of the target,
+     * and it is rejected with RESULT_VERSION_MISMATCH if the generated struct changes
+     * @param buffer Protobuf encoded input buffer
+     * @param buffer_size Input buffer size in bytes
+     * @param desc DDF descriptor
+     * @param baked Baked message [out]
+     * @return RESULT_OK on success
+     */
+    Result BakeMessage(const void* buffer, uint32_t buffer_size, const Descriptor* desc, dmArray<uint8_t>& baked);
+
     /**
      * Save function call-back
      * @param context Save context
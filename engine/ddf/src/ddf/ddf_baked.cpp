@@ -0,0 +1,194 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <string.h>
+#include <dlib/memory.h>
+#include "ddf_baked.h"
+#include "ddf_util.h"
+#include "config.h"
+
+namespace dmDDF
+{
+    // Converts a pointer to an offset from the start of the message. Null is stored as zero, which is the top level message
+    static inline void ToOffset(uintptr_t* pointer, const char* base, uint32_t size)
+    {
+        if (*pointer != 0)
+        {
+            assert(*pointer > (uintptr_t) base && *pointer <= (uintptr_t) base + size);
+            *pointer -= (uintptr_t) base;
+        }
+    }
+
+    static inline bool ResolveOffset(uintptr_t* offset, char* base, uint32_t size, uint32_t length)
+    {
+        if (*offset == 0)
+            return true;
+        if (*offset > size || length > size - *offset)
+            return false;
+        *offset += (uintptr_t) base;
+        return true;
+    }
+
+    static inline bool ResolveString(uintptr_t* offset, char* base, uint32_t size)
+    {
+        if (*offset != 0 && (*offset >= size || memchr(base + *offset, 0, size - *offset) == 0))
+            return false;
+        return ResolveOffset(offset, base, size, 0);
+    }
+
+    // Converts all pointers in the message to offsets, or back when resolve is set. Offsets are validated against the message size
+    static bool RelocatePointers(const Descriptor* desc, char* message, char* base, uint32_t size, bool resolve)
+    {
+        for (int i = 0; i < desc->m_FieldCount; ++i)
+        {
+            const FieldDescriptor* field = &desc->m_Fields[i];
+            char* fieldptr = message + field->m_Offset;
+
+            if (field->m_Label == LABEL_REPEATED || field->m_Type == TYPE_BYTES)
+            {
+                RepeatedField* repeated_field = (RepeatedField*) fieldptr;
+                uint32_t element_size = field->m_Type == TYPE_BYTES ? 1 : RepeatedElementSize(field);
+                if (repeated_field->m_ArrayCount == 0)
+                {
+                    repeated_field->m_Array = 0;
+                    continue;
+                }
+
+                if (resolve)
+                {
+                    if (repeated_field->m_Array == 0 || repeated_field->m_ArrayCount > size / element_size ||
+                        !ResolveOffset(&repeated_field->m_Array, base, size, repeated_field->m_ArrayCount * element_size))
+                        return false;
+                }
+
+                char* array = (char*) repeated_field->m_Array;
+                for (uint32_t j = 0; j < repeated_field->m_ArrayCount; ++j)
+                {
+                    char* element = array + j * element_size;
+                    if (field->m_Type == TYPE_MESSAGE)
+                    {
+                        if (!RelocatePointers(field->m_MessageDescriptor, element, base, size, resolve))
+                            return false;
+                    }
+                    else if (field->m_Type == TYPE_STRING)
+                    {
+                        if (!resolve)
+                            ToOffset((uintptr_t*) element, base, size);
+                        else if (!ResolveString((uintptr_t*) element, base, size))
+                            return false;
+                    }
+                }
+
+                if (!resolve)
+                    ToOffset(&repeated_field->m_Array, base, size);
+            }
+            else if (field->m_Type == TYPE_MESSAGE)
+            {
+                if (!RelocatePointers(field->m_MessageDescriptor, fieldptr, base, size, resolve))
+                    return false;
+            }
+            else if (field->m_Type == TYPE_STRING)
+            {
+                if (!resolve)
+                    ToOffset((uintptr_t*) fieldptr, base, size);
+                else if (!ResolveString((uintptr_t*) fieldptr, base, size))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool IsBakedMessage(const void* buffer, uint32_t buffer_size)
+    {
+        BakedHeader header;
+        if (buffer_size < sizeof(header))
+            return false;
+        memcpy(&header, buffer, sizeof(header));
+        return header.m_Magic == BAKED_MAGIC;
+    }
+
+    Result DoLoadBakedMessage(const void* buffer, uint32_t buffer_size, const Descriptor* desc, void* memory, uint32_t memory_size,
+                              void** out_message, uint32_t* size)
+    {
+        BakedHeader header;
+        memcpy(&header, buffer, sizeof(header));
+        if (header.m_Version != DDF_MAJOR_VERSION || header.m_PointerSize != sizeof(void*) ||
+            header.m_NameHash != desc->m_NameHash || header.m_MessageSize != desc->m_Size)
+        {
+            return RESULT_VERSION_MISMATCH;
+        }
+        if (header.m_Size < desc->m_Size || header.m_Size > buffer_size - sizeof(header))
+        {
+            return RESULT_WIRE_FORMAT_ERROR;
+        }
+
+        char* message = (char*) memory;
+        if (message)
+        {
+            if (header.m_Size > memory_size)
+            {
+                if (size)
+                    *size = header.m_Size;
+                return RESULT_BUFFER_TOO_SMALL;
+            }
+        }
+        else
+        {
+            dmMemory::AlignedMalloc((void**)&message, 16, header.m_Size);
+            assert(message);
+        }
+
+        // The only pass over the data
+        memcpy(message, (const char*) buffer + sizeof(header), header.m_Size);
+        if (!RelocatePointers(desc, message, message, header.m_Size, true))
+        {
+            if (!memory)
+                dmMemory::AlignedFree(message);
+            return RESULT_WIRE_FORMAT_ERROR;
+        }
+
+        if (size)
+            *size = header.m_Size;
+        *out_message = message;
+        return RESULT_OK;
+    }
+
+    Result BakeMessage(const void* buffer, uint32_t buffer_size, const Descriptor* desc, dmArray<uint8_t>& baked)
+    {
+        void* message;
+        uint32_t message_size;
+        Result e = LoadMessage(buffer, buffer_size, desc, &message, 0, &message_size);
+        if (e != RESULT_OK)
+        {
+            return e;
+        }
+
+        BakedHeader header;
+        memset(&header, 0, sizeof(header));
+        header.m_Magic = BAKED_MAGIC;
+        header.m_Version = DDF_MAJOR_VERSION;
+        header.m_PointerSize = (uint8_t) sizeof(void*);
+        header.m_NameHash = desc->m_NameHash;
+        header.m_MessageSize = desc->m_Size;
+        header.m_Size = message_size;
+
+        RelocatePointers(desc, (char*) message, (char*) message, message_size, false);
+
+        baked.SetCapacity(sizeof(header) + message_size);
+        baked.SetSize(0);
+        baked.PushArray((const uint8_t*) &header, sizeof(header));
+        baked.PushArray((const uint8_t*) message, message_size);
+
+        FreeMessage(message);
+        return RESULT_OK;
+    }
+}
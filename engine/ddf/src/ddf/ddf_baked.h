@@ -0,0 +1,44 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DDF_BAKED_H
+#define DDF_BAKED_H
+
+#include <stdint.h>
+#include "ddf.h"
+
+namespace dmDDF
+{
+    // The first byte is zero, which is never a valid protobuf tag
+    const uint32_t BAKED_MAGIC = 0x42444400;
+
+    // A baked message is the loaded message stored as is, with pointers as offsets from the start of the message
+    struct BakedHeader
+    {
+        uint32_t m_Magic;
+        uint16_t m_Version;
+        // The struct layout depends on the pointer size and the size of the generated struct
+        uint8_t  m_PointerSize;
+        uint8_t  m_Reserved;
+        uint64_t m_NameHash;
+        uint32_t m_MessageSize;
+        // Size of the message data following the header
+        uint32_t m_Size;
+    };
+
+    bool IsBakedMessage(const void* buffer, uint32_t buffer_size);
+
+    Result DoLoadBakedMessage(const void* buffer, uint32_t buffer_size, const Descriptor* desc, void* memory, uint32_t memory_size,
+                              void** out_message, uint32_t* size);
+}
+
+#endif // DDF_BAKED_H
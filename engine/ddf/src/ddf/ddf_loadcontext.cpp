@@ -25,6 +25,7 @@ namespace dmDDF
         m_End = buffer + buffer_size;
         m_DryRun = dry_run;
         m_Options = options;
+        m_MemoryBound = 0;
         if (!dry_run)
         {
             memset(buffer, 0, buffer_size);
@@ -44,22 +45,12 @@ namespace dmDDF
 
     void* LoadContext::AllocRepeated(const FieldDescriptor* field_desc, int count)
     {
-        Type type = (Type) field_desc->m_Type;
+        // Empty arrays take no memory, and don't need to be aligned
+        if (count == 0)
+            return (void*) m_Current;
 
         m_Current = (char*) DM_ALIGN(m_Current, 16);
-        int element_size = 0;
-        if ( field_desc->m_Type == TYPE_MESSAGE )
-        {
-            element_size = field_desc->m_MessageDescriptor->m_Size;
-        }
-        else if ( field_desc->m_Type == TYPE_STRING )
-        {
-            element_size = sizeof(const char*);
-        }
-        else
-        {
-            element_size = ScalarTypeSize(type);
-        }
+        int element_size = RepeatedElementSize(field_desc);
 
         char* b = m_Current;
         m_Current += count * element_size;
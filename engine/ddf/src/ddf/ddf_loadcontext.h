@@ -44,6 +44,17 @@ namespace dmDDF
             return m_Options;
         }
 
+        // Upper bound of the memory usage, accumulated while the repeated fields are counted
+        inline void IncreaseMemoryBound(uint32_t size)
+        {
+            m_MemoryBound += size;
+        }
+
+        inline uint32_t GetMemoryBound()
+        {
+            return m_MemoryBound;
+        }
+
     private:
         dmHashTable32<uint32_t> m_ArrayCount;
 
@@ -52,6 +63,7 @@ namespace dmDDF
         char* m_Current;
         bool  m_DryRun;
         uint32_t m_Options;
+        uint32_t m_MemoryBound;
     };
 }
 
@@ -26,6 +26,13 @@ namespace dmDDF
      */
     int ScalarTypeSize(uint32_t type);
 
+    /**
+     * Calculates the size of an element in the array of a repeated field
+     * @param field Field descriptor
+     * @return Element size
+     */
+    int RepeatedElementSize(const FieldDescriptor* field);
+
     static inline uint32_t DDFAlign(uint32_t index, uint32_t align)
     {
         index += (align - 1);
@@ -12,6 +12,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <string>
 #include <iostream>
 #include <fstream>
@@ -478,6 +479,53 @@ TEST(Mesh, Load)
     dmDDF::FreeMessage(message);
 }
 
+TEST(Mesh, LoadBaked)
+{
+    TestDDF::Mesh mesh;
+    for (int i = 0; i < 10; ++i)
+    {
+        mesh.add_vertices((float) i);
+        mesh.add_indices(i);
+    }
+    mesh.set_primitive_count(10);
+    mesh.set_name("MyMesh");
+    mesh.set_primitive_type(TestDDF::Mesh_Primitive_TRIANGLES);
+    std::string msg_str = mesh.SerializeAsString();
+
+    dmArray<uint8_t> baked;
+    dmDDF::Result e = dmDDF::BakeMessage((void*) msg_str.c_str(), msg_str.size(), &DUMMY::TestDDF_Mesh_DESCRIPTOR, baked);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+
+    void* message;
+    e = dmDDF::LoadMessage(baked.Begin(), baked.Size(), &DUMMY::TestDDF_Mesh_DESCRIPTOR, &message);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+
+    DUMMY::TestDDF::Mesh* msg = (DUMMY::TestDDF::Mesh*) message;
+    ASSERT_EQ(10U, msg->m_PrimitiveCount);
+    ASSERT_STREQ("MyMesh", msg->m_Name);
+    ASSERT_EQ(10U, msg->m_Vertices.m_Count);
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(mesh.vertices(i), msg->m_Vertices.m_Data[i]);
+        ASSERT_EQ(mesh.indices(i), msg->m_Indices.m_Data[i]);
+    }
+
+    // Saved as protobuf again
+    std::string msg_str2;
+    e = DDFSaveToString(message, &DUMMY::TestDDF_Mesh_DESCRIPTOR, msg_str2);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+    ASSERT_EQ(msg_str, msg_str2);
+    dmDDF::FreeMessage(message);
+
+    // Baked for another type
+    e = dmDDF::LoadMessage(baked.Begin(), baked.Size(), &DUMMY::TestDDF_NestedArray_DESCRIPTOR, &message);
+    ASSERT_EQ(dmDDF::RESULT_VERSION_MISMATCH, e);
+
+    // Truncated
+    e = dmDDF::LoadMessage(baked.Begin(), baked.Size() - 1, &DUMMY::TestDDF_Mesh_DESCRIPTOR, &message);
+    ASSERT_EQ(dmDDF::RESULT_WIRE_FORMAT_ERROR, e);
+}
+
 TEST(NestedArray, Load)
 {
     const int count1 = 2;
@@ -561,6 +609,83 @@ TEST(Bytes, Load)
     dmDDF::FreeMessage(message);
 }
 
+TEST(Bytes, LoadInPlace)
+{
+    TestDDF::Bytes bytes;
+    bytes.set_pad("..");
+    bytes.set_data((void*) "foo", 3);
+    std::string msg_str = bytes.SerializeAsString();
+    const char* msg_buf = msg_str.c_str();
+    uint32_t msg_buf_size = msg_str.size();
+    void* message;
+    uint32_t size;
+
+    dmDDF::Result e = dmDDF::LoadMessage((void*) msg_buf, msg_buf_size, &DUMMY::TestDDF_Bytes_DESCRIPTOR, &message, dmDDF::OPTION_IN_PLACE, &size);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+
+    DUMMY::TestDDF::Bytes* msg = (DUMMY::TestDDF::Bytes*) message;
+    ASSERT_STREQ("..", msg->m_Pad);
+    ASSERT_EQ(3U, msg->m_Data.m_Count);
+    // The data is referenced in the input buffer
+    ASSERT_GE((uintptr_t) msg->m_Data.m_Data, (uintptr_t) msg_buf);
+    ASSERT_LE((uintptr_t) msg->m_Data.m_Data + 3, (uintptr_t) msg_buf + msg_buf_size);
+    ASSERT_EQ(0, memcmp("foo", msg->m_Data.m_Data, 3));
+
+    dmDDF::FreeMessage(message);
+}
+
+TEST(NestedArray, LoadIntoMemory)
+{
+    TestDDF::NestedArray pb_nested;
+    pb_nested.set_d(1);
+    pb_nested.set_e(2);
+    for (int i = 0; i < 3; ++i)
+    {
+        TestDDF::NestedArraySub1* sub1 = pb_nested.add_array1();
+        sub1->set_b(i);
+        sub1->set_c(i*2);
+        for (int j = 0; j < i; ++j)
+        {
+            sub1->add_array2()->set_a(i*10+j);
+        }
+    }
+
+    std::string pb_msg_str = pb_nested.SerializeAsString();
+    void* message;
+    uint32_t size;
+    uint32_t loaded_size;
+
+    dmDDF::Result e = dmDDF::LoadMessage((void*) pb_msg_str.c_str(), pb_msg_str.size(), &DUMMY::TestDDF_NestedArray_DESCRIPTOR, &message, 0, &loaded_size);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+    dmDDF::FreeMessage(message);
+
+    // Too small, the required size is returned
+    char* memory = 0;
+    dmMemory::AlignedMalloc((void**)&memory, 16, 1024);
+    e = dmDDF::LoadMessageIntoMemory((void*) pb_msg_str.c_str(), pb_msg_str.size(), &DUMMY::TestDDF_NestedArray_DESCRIPTOR, memory, 4, 0, &message, &size);
+    ASSERT_EQ(dmDDF::RESULT_BUFFER_TOO_SMALL, e);
+    ASSERT_GE(size, loaded_size);
+    ASSERT_LE(size, 1024U);
+
+    e = dmDDF::LoadMessageIntoMemory((void*) pb_msg_str.c_str(), pb_msg_str.size(), &DUMMY::TestDDF_NestedArray_DESCRIPTOR, memory, size, 0, &message, &size);
+    ASSERT_EQ(dmDDF::RESULT_OK, e);
+    ASSERT_EQ((void*) memory, message);
+    ASSERT_EQ(loaded_size, size);
+
+    DUMMY::TestDDF::NestedArray* nested = (DUMMY::TestDDF::NestedArray*) message;
+    ASSERT_EQ(3U, nested->m_Array1.m_Count);
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_EQ((uint32_t) i, nested->m_Array1.m_Data[i].m_Array2.m_Count);
+        for (int j = 0; j < i; ++j)
+        {
+            ASSERT_EQ(pb_nested.array1(i).array2(j).a(), nested->m_Array1.m_Data[i].m_Array2.m_Data[j].m_A);
+        }
+    }
+
+    dmMemory::AlignedFree(memory);
+}
+
 TEST(Material, Load)
 {
     TestDDF::MaterialDesc material_desc;
@@ -29,6 +29,7 @@
 
 //! Type definitions of atomic types
 typedef volatile int32_t int32_atomic_t;
+typedef volatile int64_t int64_atomic_t;
 
 /**
  * Atomic increment of a int32_atomic_t.
@@ -119,4 +120,61 @@ inline int32_t dmAtomicCompareStore32(int32_atomic_t *ptr, int32_t value, int32_
 #endif
 }
 
+/**
+ * Atomic exchange of a int64_atomic_t if comparand is equal to the value of #ptr
+ * @param ptr Pointer to a int64_atomic_t to store into.
+ * @param value Value to store.
+ * @param comparand Value to compare to.
+ * @return Previous value
+ */
+inline int64_t dmAtomicCompareStore64(int64_atomic_t *ptr, int64_t value, int64_t comparand)
+{
+#if defined(_MSC_VER)
+	return InterlockedCompareExchange64((volatile LONG64*) ptr, (LONG64) value, (LONG64) comparand);
+#else
+	return __sync_val_compare_and_swap((int64_atomic_t*) ptr, comparand, value);
+#endif
+}
+
+/**
+ * Atomic exchange of a pointer
+ * @param ptr Pointer to the pointer to store into.
+ * @param value Value to store.
+ * @return Previous value.
+ */
+inline void* dmAtomicStorePtr(void* volatile* ptr, void* value)
+{
+#if defined(_MSC_VER)
+	return InterlockedExchangePointer(ptr, value);
+#else
+	return __sync_lock_test_and_set(ptr, value);
+#endif
+}
+
+/**
+ * Atomic exchange of a pointer if comparand is equal to the value of #ptr
+ * @param ptr Pointer to the pointer to store into.
+ * @param value Value to store.
+ * @param comparand Value to compare to.
+ * @return Previous value
+ */
+inline void* dmAtomicCompareStorePtr(void* volatile* ptr, void* value, void* comparand)
+{
+#if defined(_MSC_VER)
+	return InterlockedCompareExchangePointer(ptr, value, comparand);
+#else
+	return __sync_val_compare_and_swap(ptr, comparand, value);
+#endif
+}
+
+/**
+ * Atomic read of a pointer, with a full memory barrier
+ * @param ptr Pointer to the pointer to read.
+ * @return Current value
+ */
+inline void* dmAtomicGetPtr(void* volatile* ptr)
+{
+	return dmAtomicCompareStorePtr(ptr, 0, 0);
+}
+
 #endif //DM_ATOMIC_H
@@ -0,0 +1,165 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "array.h"
+#include "benchmark.h"
+#include "dstrings.h"
+#include "time.h"
+
+namespace dmBenchmark
+{
+    // Number of runs of each benchmark, of which the fastest is reported
+    static const uint32_t RUN_COUNT = 3;
+    static const uint32_t MAX_ITERATIONS = 1 << 30;
+
+    struct Result
+    {
+        char     m_Name[128];
+        uint64_t m_Iterations;
+        double   m_NsPerIteration;
+        double   m_ItemsPerSecond;
+    };
+
+    struct Context
+    {
+        dmArray<Result> m_Results;
+        const char*     m_Executable;
+        const char*     m_Filter;
+        const char*     m_OutputPath;
+        uint64_t        m_MinTime;
+    };
+
+    static Context g_Context;
+
+    static const char* GetArgument(const char* arg, const char* name)
+    {
+        size_t length = strlen(name);
+        if (strncmp(arg, name, length) == 0 && arg[length] == '=')
+            return arg + length + 1;
+        return 0;
+    }
+
+    void Init(int argc, char** argv)
+    {
+        g_Context.m_Results.SetSize(0);
+        g_Context.m_Executable = argc > 0 ? argv[0] : "";
+        g_Context.m_Filter = 0;
+        g_Context.m_OutputPath = 0;
+        g_Context.m_MinTime = 100000;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const char* value;
+            if ((value = GetArgument(argv[i], "--benchmark_filter")))
+                g_Context.m_Filter = value;
+            else if ((value = GetArgument(argv[i], "--benchmark_out")))
+                g_Context.m_OutputPath = value;
+            else if ((value = GetArgument(argv[i], "--benchmark_min_time")))
+                g_Context.m_MinTime = (uint64_t)(atof(value) * 1000000.0);
+        }
+    }
+
+    bool Run(const char* name, Function fn, void* context, uint32_t items_per_iteration)
+    {
+        if (g_Context.m_Filter && strstr(name, g_Context.m_Filter) == 0)
+            return false;
+
+        // Warm up the caches and find the iteration count that runs for at least the minimum time
+        uint32_t iterations = 1;
+        uint64_t elapsed = 0;
+        while (true)
+        {
+            uint64_t start = dmTime::GetTime();
+            fn(context, iterations);
+            elapsed = dmTime::GetTime() - start;
+            if (elapsed >= g_Context.m_MinTime || iterations >= MAX_ITERATIONS)
+                break;
+            iterations *= 2;
+        }
+
+        uint64_t best = elapsed;
+        for (uint32_t i = 1; i < RUN_COUNT; ++i)
+        {
+            uint64_t start = dmTime::GetTime();
+            fn(context, iterations);
+            elapsed = dmTime::GetTime() - start;
+            if (elapsed < best)
+                best = elapsed;
+        }
+
+        Result result;
+        dmStrlCpy(result.m_Name, name, sizeof(result.m_Name));
+        result.m_Iterations = iterations;
+        result.m_NsPerIteration = best * 1000.0 / iterations;
+        result.m_ItemsPerSecond = best > 0 ? (double)iterations * items_per_iteration * 1000000.0 / best : 0.0;
+
+        if (g_Context.m_Results.Full())
+        {
+            g_Context.m_Results.OffsetCapacity(32);
+        }
+        g_Context.m_Results.Push(result);
+
+        printf("%-48s %14.1f ns %12llu iterations %14.0f items/s\n", result.m_Name, result.m_NsPerIteration,
+                (unsigned long long)result.m_Iterations, result.m_ItemsPerSecond);
+        fflush(stdout);
+        return true;
+    }
+
+    static bool WriteJson(const char* path)
+    {
+        FILE* f = fopen(path, "wb");
+        if (!f)
+            return false;
+
+        char date[64];
+        time_t now = time(0);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+#if defined(NDEBUG)
+        const char* build_type = "release";
+#else
+        const char* build_type = "debug";
+#endif
+
+        fprintf(f, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"executable\": \"%s\",\n    \"library_build_type\": \"%s\"\n  },\n  \"benchmarks\": [\n",
+                date, g_Context.m_Executable, build_type);
+        for (uint32_t i = 0; i < g_Context.m_Results.Size(); ++i)
+        {
+            const Result& r = g_Context.m_Results[i];
+            fprintf(f, "    {\n      \"name\": \"%s\",\n      \"iterations\": %llu,\n      \"real_time\": %f,\n      \"cpu_time\": %f,\n      \"time_unit\": \"ns\",\n      \"items_per_second\": %f\n    }%s\n",
+                    r.m_Name, (unsigned long long)r.m_Iterations, r.m_NsPerIteration, r.m_NsPerIteration, r.m_ItemsPerSecond,
+                    i + 1 < g_Context.m_Results.Size() ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+        return fclose(f) == 0;
+    }
+
+    int Finalize()
+    {
+        if (g_Context.m_OutputPath && !WriteJson(g_Context.m_OutputPath))
+        {
+            fprintf(stderr, "Failed to write benchmark results to '%s'\n", g_Context.m_OutputPath);
+            return 1;
+        }
+        return 0;
+    }
+
+    void DoNotOptimize(const void* p)
+    {
+        // Being defined in another translation unit is enough to keep the value alive
+        (void)p;
+    }
+}
@@ -0,0 +1,69 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_BENCHMARK_H
+#define DM_BENCHMARK_H
+
+#include <stdint.h>
+
+/**
+ * Minimal micro-benchmark harness for the bench_* programs next to the tests.
+ *
+ * Each benchmark is run with a doubling iteration count until it takes at least the minimum time,
+ * and the best of a few such runs is reported. The results are printed, and written in the JSON
+ * format of Google Benchmark when an output file is given, so that they can be compared across versions.
+ *
+ * Command line arguments, parsed by Init():
+ *   --benchmark_filter=<text>      only run the benchmarks whose name contains the text
+ *   --benchmark_out=<path>         write the results as JSON to the path
+ *   --benchmark_min_time=<seconds> minimum time of each run. Default 0.1
+ */
+namespace dmBenchmark
+{
+    /**
+     * Benchmark function
+     * @param context user context
+     * @param iterations number of times to run the measured operation
+     */
+    typedef void (*Function)(void* context, uint32_t iterations);
+
+    /**
+     * Parse the command line arguments and reset the results
+     * @param argc argument count
+     * @param argv arguments
+     */
+    void Init(int argc, char** argv);
+
+    /**
+     * Run and record a benchmark, unless it is filtered out
+     * @param name unique name, by convention "Operation/size"
+     * @param fn benchmark function
+     * @param context user context passed to the function
+     * @param items_per_iteration number of items processed by each iteration, used to report items per second
+     * @return true if the benchmark was run
+     */
+    bool Run(const char* name, Function fn, void* context, uint32_t items_per_iteration);
+
+    /**
+     * Write the results to the output file, if any. Each result is printed as soon as it is run
+     * @return exit code for main(), non-zero if the results couldn't be written
+     */
+    int Finalize();
+
+    /**
+     * Keep the compiler from optimizing away a computed value
+     * @param p pointer to the value
+     */
+    void DoNotOptimize(const void* p);
+}
+
+#endif // DM_BENCHMARK_H
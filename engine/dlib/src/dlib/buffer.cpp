@@ -20,6 +20,14 @@
 #include <string.h>
 #include <assert.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DM_BUFFER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define DM_BUFFER_NEON
+#endif
+
 #if defined(_WIN32)
 #include <malloc.h>
 #endif
@@ -49,11 +57,17 @@ namespace dmBuffer
 
         void*    m_Data;            // All stream data, including guard bytes after each stream and 16 byte aligned.
         Stream*  m_Streams;
-        uint32_t m_Stride;          // The struct size (in bytes)
+        uint32_t m_Stride;          // The struct size (in bytes), or 0 for struct of arrays buffers
         uint32_t m_Count;           // The number of "structs" in the buffer (e.g. vertex count)
+        uint32_t m_DataSize;        // The size of the stream data (in bytes), excluding the guard bytes
+        DirtyRange m_DirtyRanges[MAX_DIRTY_RANGES]; // Element ranges changed since m_DirtyBaseVersion
         uint16_t m_Version;
         uint16_t m_ContentVersion;  // A running number, which user can use to signal content changes
+        uint16_t m_DirtyBaseVersion;
         uint8_t  m_NumStreams;
+        uint8_t  m_Flags;           // dmBuffer::CreateFlags
+        uint8_t  m_DirtyRangeCount;
+        uint8_t  m_DirtyAll : 1;    // Changed without a known range
     };
 
     struct BufferContext
@@ -277,7 +291,7 @@ namespace dmBuffer
         }
 
         // Check guard
-        uint8_t* ptr = (uint8_t*)buffer->m_Data + (buffer->m_Count * buffer->m_Stride);
+        uint8_t* ptr = (uint8_t*)buffer->m_Data + buffer->m_DataSize;
         if (!ValidateGuard(ptr)) {
                 return RESULT_GUARD_INVALID;
         }
@@ -319,10 +333,28 @@ namespace dmBuffer
         }
 
         // Write guard bytes after payload data
-        uint8_t* ptr = (uint8_t*)buffer->m_Data + (buffer->m_Count * buffer->m_Stride);
+        uint8_t* ptr = (uint8_t*)buffer->m_Data + buffer->m_DataSize;
         WriteGuard((void*)ptr);
     }
 
+    // Calculates the offsets of each stream stored as a separate array, each starting on a 16 byte boundary
+    static Result CalcStructOfArraysSize(uint32_t count, uint32_t num_streams, const StreamDeclaration* streams, uint32_t* size, uint32_t* offsets)
+    {
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < num_streams; ++i) {
+            if (streams[i].m_Count == 0) {
+                return RESULT_STREAM_SIZE_ERROR;
+            }
+            offsets[i] = (uint32_t)total;
+            total += DM_ALIGN((uint64_t)count * streams[i].m_Count * GetSizeForValueType(streams[i].m_Type), ADDR_ALIGNMENT);
+            if (total > 0xFFFFFFFF - ADDR_ALIGNMENT) {
+                return RESULT_BUFFER_SIZE_ERROR;
+            }
+        }
+        *size = (uint32_t)total;
+        return RESULT_OK;
+    }
+
     bool IsBufferValid(HBuffer hbuffer)
     {
         Buffer* buffer = GetBuffer(g_BufferContext, hbuffer);
@@ -330,6 +362,11 @@ namespace dmBuffer
     }
 
     Result Create(uint32_t count, const StreamDeclaration* streams_decl, uint8_t streams_decl_count, HBuffer* out_buffer)
+    {
+        return Create(count, streams_decl, streams_decl_count, 0, out_buffer);
+    }
+
+    Result Create(uint32_t count, const StreamDeclaration* streams_decl, uint8_t streams_decl_count, uint32_t flags, HBuffer* out_buffer)
     {
         BufferContext* ctx = g_BufferContext;
         assert(ctx && "Buffer context not initialized");
@@ -347,19 +384,30 @@ namespace dmBuffer
         uint32_t header_size = sizeof(Buffer) + sizeof(Buffer::Stream)*streams_decl_count;
         uint32_t buffer_size = header_size;
 
-        // Interleaved streams
         uint32_t struct_size = 0;
+        uint32_t data_size = 0;
         uint32_t* offsets = (uint32_t*)alloca(streams_decl_count * sizeof(uint32_t));
-        dmBuffer::Result res = CalcStructSize(streams_decl_count, streams_decl, &struct_size, offsets);
+        dmBuffer::Result res;
+        if (flags & CREATE_FLAG_STRUCT_OF_ARRAYS)
+        {
+            res = CalcStructOfArraysSize(count, streams_decl_count, streams_decl, &data_size, offsets);
+        }
+        else
+        {
+            // Interleaved streams
+            res = CalcStructSize(streams_decl_count, streams_decl, &struct_size, offsets);
+            data_size = struct_size * count;
+        }
         if (res != RESULT_OK) {
             return res;
         }
 
         // Make sure the data is aligned at the start
-        buffer_size = DM_ALIGN(buffer_size, ADDR_ALIGNMENT);
+        header_size = DM_ALIGN(header_size, ADDR_ALIGNMENT);
+        buffer_size = header_size;
         assert(buffer_size % ADDR_ALIGNMENT == 0);
 
-        buffer_size += struct_size * count;
+        buffer_size += data_size;
 
         // Add some guard bytes at the end
         buffer_size += GUARD_SIZE;
@@ -393,7 +441,12 @@ namespace dmBuffer
         buffer->m_Streams = (Buffer::Stream*)((uintptr_t)data_block + sizeof(Buffer));
         buffer->m_Data = (void*)((uintptr_t)data_block + header_size);
         buffer->m_Stride = struct_size;
+        buffer->m_DataSize = data_size;
         buffer->m_ContentVersion = 0;
+        buffer->m_Flags = (uint8_t)flags;
+        buffer->m_DirtyBaseVersion = 0;
+        buffer->m_DirtyRangeCount = 0;
+        buffer->m_DirtyAll = 0;
 
         CreateStreamsInterleaved(buffer, streams_decl, offsets);
 
@@ -414,7 +467,7 @@ namespace dmBuffer
         const Buffer* src_buffer = GetBuffer(g_BufferContext, src_buffer_handle);
 
         // Verify stream declaration is 1:1
-        if (src_buffer->m_NumStreams != dst_buffer->m_NumStreams) {
+        if (src_buffer->m_NumStreams != dst_buffer->m_NumStreams || src_buffer->m_Flags != dst_buffer->m_Flags) {
             return RESULT_STREAM_COUNT_MISMATCH;
         }
 
@@ -439,6 +492,11 @@ namespace dmBuffer
             return RESULT_BUFFER_SIZE_ERROR;
         }
 
+        // The streams of a struct of arrays buffer start at offsets depending on the count
+        if ((src_buffer->m_Flags & CREATE_FLAG_STRUCT_OF_ARRAYS) && src_buffer->m_Count != dst_buffer->m_Count) {
+            return RESULT_BUFFER_SIZE_ERROR;
+        }
+
         // Get buffer pointers for dst and src
         void* dst_bytes = 0x0;
         uint32_t dst_size = 0;
@@ -488,6 +546,14 @@ namespace dmBuffer
         return RESULT_OK;
     }
 
+    // The stride of a stream, in number of values
+    static inline uint32_t GetStreamStride(const Buffer* buffer, const Buffer::Stream* stream)
+    {
+        if (buffer->m_Flags & CREATE_FLAG_STRUCT_OF_ARRAYS)
+            return stream->m_ValueCount;
+        return buffer->m_Stride / GetSizeForValueType((dmBuffer::ValueType)stream->m_ValueType);
+    }
+
     static Buffer::Stream* GetStream(Buffer* buffer, dmhash_t stream_name)
     {
         for (uint8_t i = 0; i < buffer->m_NumStreams; ++i) {
@@ -545,7 +611,7 @@ namespace dmBuffer
         if (component_count)
             *component_count = stream->m_ValueCount;
         if (stride)
-            *stride = buffer->m_Stride / GetSizeForValueType((dmBuffer::ValueType)stream->m_ValueType);
+            *stride = GetStreamStride(buffer, stream);
         return RESULT_OK;
     }
 
@@ -561,7 +627,7 @@ namespace dmBuffer
             return RESULT_GUARD_INVALID;
         }
 
-        *out_size = buffer->m_Stride * buffer->m_Count;
+        *out_size = buffer->m_DataSize;
         *out_buffer = (void*)buffer->m_Data;
 
         return RESULT_OK;
@@ -594,6 +660,197 @@ namespace dmBuffer
         return RESULT_OK;
     }
 
+    // Gets a stream and verifies that the elements [offset, offset+count) are inside the buffer
+    static Result GetStreamRange(HBuffer hbuffer, dmhash_t stream_name, uint32_t offset, uint32_t count, Buffer** out_buffer, Buffer::Stream** out_stream)
+    {
+        Buffer* buffer = GetBuffer(g_BufferContext, hbuffer);
+        if (!buffer) {
+            return RESULT_BUFFER_INVALID;
+        }
+
+        Buffer::Stream* stream = GetStream(buffer, stream_name);
+        if (stream == 0x0) {
+            return RESULT_STREAM_MISSING;
+        }
+
+        if (RESULT_OK != dmBuffer::ValidateBuffer(buffer)) {
+            return RESULT_GUARD_INVALID;
+        }
+
+        if ((uint64_t)offset + count > buffer->m_Count) {
+            return RESULT_BUFFER_SIZE_ERROR;
+        }
+        *out_buffer = buffer;
+        *out_stream = stream;
+        return RESULT_OK;
+    }
+
+    Result FillStream(HBuffer hbuffer, dmhash_t stream_name, const void* value, uint32_t offset, uint32_t count)
+    {
+        Buffer* buffer;
+        Buffer::Stream* stream;
+        Result r = GetStreamRange(hbuffer, stream_name, offset, count, &buffer, &stream);
+        if (r != RESULT_OK || count == 0) {
+            return r;
+        }
+
+        uint32_t value_size = GetSizeForValueType((dmBuffer::ValueType)stream->m_ValueType);
+        uint32_t element_size = stream->m_ValueCount * value_size;
+        uint32_t stride = GetStreamStride(buffer, stream) * value_size;
+        uint8_t* ptr = (uint8_t*)buffer->m_Data + stream->m_Offset + offset * stride;
+
+        if (stride == element_size)
+        {
+            // Packed elements: fill in doubling chunks
+            uint32_t size = count * element_size;
+            uint32_t filled = element_size;
+            memcpy(ptr, value, element_size);
+            while (filled < size)
+            {
+                uint32_t chunk = dmMath::Min(filled, size - filled);
+                memcpy(ptr + filled, ptr, chunk);
+                filled += chunk;
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < count; ++i, ptr += stride)
+            {
+                memcpy(ptr, value, element_size);
+            }
+        }
+        return RESULT_OK;
+    }
+
+    Result CopyStream(HBuffer dst_buffer_handle, dmhash_t dst_stream_name, uint32_t dst_offset,
+                      HBuffer src_buffer_handle, dmhash_t src_stream_name, uint32_t src_offset, uint32_t count)
+    {
+        Buffer* dst_buffer;
+        Buffer::Stream* dst_stream;
+        Result r = GetStreamRange(dst_buffer_handle, dst_stream_name, dst_offset, count, &dst_buffer, &dst_stream);
+        if (r != RESULT_OK) {
+            return r;
+        }
+        Buffer* src_buffer;
+        Buffer::Stream* src_stream;
+        r = GetStreamRange(src_buffer_handle, src_stream_name, src_offset, count, &src_buffer, &src_stream);
+        if (r != RESULT_OK) {
+            return r;
+        }
+
+        if (src_stream->m_ValueType != dst_stream->m_ValueType) {
+            return RESULT_STREAM_TYPE_MISMATCH;
+        }
+        if (src_stream->m_ValueCount != dst_stream->m_ValueCount) {
+            return RESULT_STREAM_COUNT_MISMATCH;
+        }
+        if (count == 0) {
+            return RESULT_OK;
+        }
+
+        uint32_t value_size = GetSizeForValueType((dmBuffer::ValueType)src_stream->m_ValueType);
+        uint32_t element_size = src_stream->m_ValueCount * value_size;
+        uint32_t dst_stride = GetStreamStride(dst_buffer, dst_stream) * value_size;
+        uint32_t src_stride = GetStreamStride(src_buffer, src_stream) * value_size;
+        uint8_t* dst = (uint8_t*)dst_buffer->m_Data + dst_stream->m_Offset + dst_offset * dst_stride;
+        const uint8_t* src = (const uint8_t*)src_buffer->m_Data + src_stream->m_Offset + src_offset * src_stride;
+
+        if (dst_stride == element_size && src_stride == element_size)
+        {
+            memmove(dst, src, count * element_size);
+        }
+        else if (dst <= src)
+        {
+            for (uint32_t i = 0; i < count; ++i, dst += dst_stride, src += src_stride)
+            {
+                memmove(dst, src, element_size);
+            }
+        }
+        else
+        {
+            // Copy backwards, in case the ranges overlap
+            dst += (count - 1) * dst_stride;
+            src += (count - 1) * src_stride;
+            for (uint32_t i = 0; i < count; ++i, dst -= dst_stride, src -= src_stride)
+            {
+                memmove(dst, src, element_size);
+            }
+        }
+        return RESULT_OK;
+    }
+
+    Result TransformPositions(HBuffer hbuffer, dmhash_t stream_name, const float* m, uint32_t offset, uint32_t count)
+    {
+        Buffer* buffer;
+        Buffer::Stream* stream;
+        Result r = GetStreamRange(hbuffer, stream_name, offset, count, &buffer, &stream);
+        if (r != RESULT_OK) {
+            return r;
+        }
+        if (stream->m_ValueType != VALUE_TYPE_FLOAT32) {
+            return RESULT_STREAM_TYPE_MISMATCH;
+        }
+        if (stream->m_ValueCount != 3 && stream->m_ValueCount != 4) {
+            return RESULT_STREAM_COUNT_MISMATCH;
+        }
+
+        uint32_t components = stream->m_ValueCount;
+        uint32_t stride = GetStreamStride(buffer, stream);
+        float* p = (float*)((uint8_t*)buffer->m_Data + stream->m_Offset) + offset * stride;
+
+#if defined(DM_BUFFER_SSE2)
+        const __m128 c0 = _mm_loadu_ps(m + 0);
+        const __m128 c1 = _mm_loadu_ps(m + 4);
+        const __m128 c2 = _mm_loadu_ps(m + 8);
+        const __m128 c3 = _mm_loadu_ps(m + 12);
+        for (uint32_t i = 0; i < count; ++i, p += stride)
+        {
+            __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p[0])), _mm_mul_ps(c1, _mm_set1_ps(p[1]))),
+                                  _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+            if (components == 4)
+            {
+                _mm_storeu_ps(p, _mm_add_ps(v, _mm_mul_ps(c3, _mm_set1_ps(p[3]))));
+            }
+            else
+            {
+                v = _mm_add_ps(v, c3);
+                _mm_storel_pi((__m64*)p, v);
+                _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+            }
+        }
+#elif defined(DM_BUFFER_NEON)
+        const float32x4_t c0 = vld1q_f32(m + 0);
+        const float32x4_t c1 = vld1q_f32(m + 4);
+        const float32x4_t c2 = vld1q_f32(m + 8);
+        const float32x4_t c3 = vld1q_f32(m + 12);
+        for (uint32_t i = 0; i < count; ++i, p += stride)
+        {
+            float32x4_t v = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(components == 4 ? vmulq_n_f32(c3, p[3]) : c3, c0, p[0]), c1, p[1]), c2, p[2]);
+            if (components == 4)
+            {
+                vst1q_f32(p, v);
+            }
+            else
+            {
+                vst1_f32(p, vget_low_f32(v));
+                vst1q_lane_f32(p + 2, v, 2);
+            }
+        }
+#else
+        for (uint32_t i = 0; i < count; ++i, p += stride)
+        {
+            float x = p[0], y = p[1], z = p[2];
+            float w = components == 4 ? p[3] : 1.0f;
+            p[0] = m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+            p[1] = m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+            p[2] = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+            if (components == 4)
+                p[3] = m[3] * x + m[7] * y + m[11] * z + m[15] * w;
+        }
+#endif
+        return RESULT_OK;
+    }
+
     Result GetContentVersion(HBuffer hbuffer, uint32_t* version)
     {
         Buffer* buffer = GetBuffer(g_BufferContext, hbuffer);
@@ -611,6 +868,79 @@ namespace dmBuffer
             return RESULT_BUFFER_INVALID;
         }
         buffer->m_ContentVersion++;
+        buffer->m_DirtyAll = 1;
+        return RESULT_OK;
+    }
+
+    Result AddDirtyRange(HBuffer hbuffer, uint32_t offset, uint32_t count)
+    {
+        Buffer* buffer = GetBuffer(g_BufferContext, hbuffer);
+        if (!buffer) {
+            return RESULT_BUFFER_INVALID;
+        }
+        if ((uint64_t)offset + count > buffer->m_Count) {
+            return RESULT_BUFFER_SIZE_ERROR;
+        }
+        buffer->m_ContentVersion++;
+        if (count == 0 || buffer->m_DirtyAll) {
+            return RESULT_OK;
+        }
+
+        uint32_t end = offset + count;
+        // Find the range closest to the new one. Overlapping or adjacent ranges have no gap.
+        // Writes usually continue where the last one ended, so start at the back.
+        uint32_t best = MAX_DIRTY_RANGES;
+        uint32_t best_gap = 0xFFFFFFFF;
+        for (int32_t i = (int32_t)buffer->m_DirtyRangeCount - 1; i >= 0; --i)
+        {
+            const DirtyRange& range = buffer->m_DirtyRanges[i];
+            uint32_t range_end = range.m_Offset + range.m_Count;
+            uint32_t gap = end < range.m_Offset ? range.m_Offset - end : (offset > range_end ? offset - range_end : 0);
+            if (gap < best_gap)
+            {
+                best = (uint32_t)i;
+                best_gap = gap;
+                if (gap == 0)
+                    break;
+            }
+        }
+
+        if (best_gap != 0 && buffer->m_DirtyRangeCount < MAX_DIRTY_RANGES)
+        {
+            DirtyRange& range = buffer->m_DirtyRanges[buffer->m_DirtyRangeCount++];
+            range.m_Offset = offset;
+            range.m_Count = count;
+            return RESULT_OK;
+        }
+
+        DirtyRange& range = buffer->m_DirtyRanges[best];
+        uint32_t range_end = dmMath::Max(range.m_Offset + range.m_Count, end);
+        range.m_Offset = dmMath::Min(range.m_Offset, offset);
+        range.m_Count = range_end - range.m_Offset;
+        return RESULT_OK;
+    }
+
+    Result GetDirtyRanges(HBuffer hbuffer, uint32_t* base_version, const DirtyRange** ranges, uint32_t* range_count)
+    {
+        Buffer* buffer = GetBuffer(g_BufferContext, hbuffer);
+        if (!buffer) {
+            return RESULT_BUFFER_INVALID;
+        }
+        *base_version = buffer->m_DirtyBaseVersion;
+        *ranges = buffer->m_DirtyAll ? 0 : buffer->m_DirtyRanges;
+        *range_count = buffer->m_DirtyAll ? 0 : buffer->m_DirtyRangeCount;
+        return RESULT_OK;
+    }
+
+    Result ClearDirtyRanges(HBuffer hbuffer)
+    {
+        Buffer* buffer = GetBuffer(g_BufferContext, hbuffer);
+        if (!buffer) {
+            return RESULT_BUFFER_INVALID;
+        }
+        buffer->m_DirtyBaseVersion = buffer->m_ContentVersion;
+        buffer->m_DirtyRangeCount = 0;
+        buffer->m_DirtyAll = 0;
         return RESULT_OK;
     }
 }
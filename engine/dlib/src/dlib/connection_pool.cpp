@@ -12,6 +12,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "connection_pool.h"
 #include "hashtable.h"
 #include "array.h"
@@ -154,13 +155,17 @@ namespace dmConnectionPool
         }
     }
 
-    static dmhash_t CalculateConnectionID(dmSocket::Address address, uint16_t port, bool ssl)
+    static dmhash_t CalculateConnectionID(const char* host, dmSocket::Address address, uint16_t port, bool ssl)
     {
         HashState64 hs;
         dmHashInit64(&hs, false);
         dmHashUpdateBuffer64(&hs, &address, sizeof(address));
         dmHashUpdateBuffer64(&hs, &port, sizeof(port));
         dmHashUpdateBuffer64(&hs, &ssl, sizeof(ssl));
+        // A TLS connection is negotiated for the host name (SNI), so hosts sharing an address can't share connections
+        if (ssl) {
+            dmHashUpdateBuffer64(&hs, host, strlen(host));
+        }
 
         return dmHashFinal64(&hs);
     }
@@ -354,7 +359,7 @@ namespace dmConnectionPool
             }
         }
 
-        dmhash_t conn_id = CalculateConnectionID(address, port, ssl);
+        dmhash_t conn_id = CalculateConnectionID(host, address, port, ssl);
 
         Connection* c = 0;
         uint32_t index;
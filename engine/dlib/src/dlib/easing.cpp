@@ -59,5 +59,19 @@ namespace dmEasing
         float diff = (t - index1 * (1.0f / (sample_count-1))) * (sample_count-1);
         return val1 * (1.0f - diff) + val2 * diff;
     }
-}
 
+    void GetValues(const uint8_t* types, const float* t, float* out, uint32_t count)
+    {
+        const int last_sample = EASING_SAMPLES - 1;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            assert(types[i] < TYPE_FLOAT_VECTOR);
+            float ti = dmMath::Clamp(t[i], 0.0f, 1.0f);
+            const float* lookup = EASING_LOOKUP + types[i] * (EASING_SAMPLES + 1);
+            int index = (int) (ti * last_sample);
+            float diff = (ti - index * (1.0f / last_sample)) * last_sample;
+            // The last sample is duplicated, so index + 1 is always within the curve
+            out[i] = lookup[index] * (1.0f - diff) + lookup[index + 1] * diff;
+        }
+    }
+}
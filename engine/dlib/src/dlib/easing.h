@@ -103,6 +103,16 @@ namespace dmEasing
      */
     float GetValue(Type type, float t);
     float GetValue(Curve curve, float t);
+
+    /**
+     * Easing-curve evaluation of many values at once. The built-in curves are
+     * evaluated without branches, which is cheaper than calling GetValue for each value.
+     * @param types curve type of each value, TYPE_FLOAT_VECTOR is not supported
+     * @param t time of each value in the range [0,1]
+     * @param out [out] curve value of each value
+     * @param count number of values
+     */
+    void GetValues(const uint8_t* types, const float* t, float* out, uint32_t count);
 }
 
 #endif // DM_EASING
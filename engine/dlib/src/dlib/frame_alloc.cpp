@@ -0,0 +1,175 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "align.h"
+#include "array.h"
+#include "frame_alloc.h"
+#include "math.h"
+#include "memory.h"
+#include "profile.h"
+
+namespace dmFrameAlloc
+{
+    struct Buffer
+    {
+        uint8_t*        m_Data;
+        uint32_t        m_Size;
+        // Heap allocations made when the buffer was full, freed when the buffer is reused
+        dmArray<void*>  m_Overflow;
+    };
+
+    struct Arena
+    {
+        Buffer      m_Buffers[2];
+        // Bytes allocated this frame, including the overflow
+        uint32_t    m_Used;
+        uint32_t    m_HighWaterMark;
+    };
+
+    struct Allocator
+    {
+        Arena*      m_Arenas;
+        uint32_t    m_ArenaCount;
+        uint32_t    m_HighWaterMark;
+        uint8_t     m_Current : 1;
+    };
+
+    NewParams::NewParams()
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = 256 * 1024;
+        m_ThreadSize = 32 * 1024;
+    }
+
+    static void AllocBuffer(Buffer* buffer, uint32_t size)
+    {
+        buffer->m_Size = (uint32_t) DM_ALIGN(size, ALIGNMENT);
+        dmMemory::AlignedMalloc((void**)&buffer->m_Data, ALIGNMENT, buffer->m_Size);
+    }
+
+    static void FreeOverflow(Buffer* buffer)
+    {
+        for (uint32_t i = 0; i < buffer->m_Overflow.Size(); ++i)
+        {
+            dmMemory::AlignedFree(buffer->m_Overflow[i]);
+        }
+        buffer->m_Overflow.SetSize(0);
+    }
+
+    HAllocator New(const NewParams& params)
+    {
+        Allocator* allocator = new Allocator;
+        allocator->m_ArenaCount = 1 + params.m_ThreadCount;
+        allocator->m_Arenas = new Arena[allocator->m_ArenaCount];
+        allocator->m_HighWaterMark = 0;
+        allocator->m_Current = 0;
+        for (uint32_t i = 0; i < allocator->m_ArenaCount; ++i)
+        {
+            Arena* arena = &allocator->m_Arenas[i];
+            uint32_t size = i == 0 ? params.m_Size : params.m_ThreadSize;
+            AllocBuffer(&arena->m_Buffers[0], size);
+            AllocBuffer(&arena->m_Buffers[1], size);
+            arena->m_Used = 0;
+            arena->m_HighWaterMark = 0;
+        }
+        return allocator;
+    }
+
+    void Delete(HAllocator allocator)
+    {
+        for (uint32_t i = 0; i < allocator->m_ArenaCount; ++i)
+        {
+            for (uint32_t j = 0; j < 2; ++j)
+            {
+                Buffer* buffer = &allocator->m_Arenas[i].m_Buffers[j];
+                FreeOverflow(buffer);
+                dmMemory::AlignedFree(buffer->m_Data);
+            }
+        }
+        delete [] allocator->m_Arenas;
+        delete allocator;
+    }
+
+    void NewFrame(HAllocator allocator)
+    {
+        uint32_t used = 0;
+        allocator->m_Current ^= 1;
+        for (uint32_t i = 0; i < allocator->m_ArenaCount; ++i)
+        {
+            Arena* arena = &allocator->m_Arenas[i];
+            used += arena->m_Used;
+            arena->m_HighWaterMark = dmMath::Max(arena->m_HighWaterMark, arena->m_Used);
+            arena->m_Used = 0;
+
+            // The buffer of the previous frame is still in use, but the one from the frame before can be recycled
+            Buffer* buffer = &arena->m_Buffers[allocator->m_Current];
+            FreeOverflow(buffer);
+            if (buffer->m_Size < arena->m_HighWaterMark)
+            {
+                dmMemory::AlignedFree(buffer->m_Data);
+                AllocBuffer(buffer, arena->m_HighWaterMark);
+            }
+        }
+
+        allocator->m_HighWaterMark = dmMath::Max(allocator->m_HighWaterMark, used);
+        DM_COUNTER("FrameAlloc", used);
+        DM_COUNTER("FrameAllocHighWater", allocator->m_HighWaterMark);
+    }
+
+    void* AllocThread(HAllocator allocator, uint32_t thread_index, uint32_t size)
+    {
+        assert(thread_index < allocator->m_ArenaCount);
+        Arena* arena = &allocator->m_Arenas[thread_index];
+        Buffer* buffer = &arena->m_Buffers[allocator->m_Current];
+
+        size = (uint32_t) DM_ALIGN(size, ALIGNMENT);
+        uint32_t offset = arena->m_Used;
+        arena->m_Used += size;
+        if (offset + size <= buffer->m_Size)
+        {
+            return buffer->m_Data + offset;
+        }
+
+        DM_COUNTER("FrameAllocOverflow", size);
+        void* memory;
+        dmMemory::AlignedMalloc(&memory, ALIGNMENT, size);
+        if (buffer->m_Overflow.Full())
+        {
+            buffer->m_Overflow.OffsetCapacity(16);
+        }
+        buffer->m_Overflow.Push(memory);
+        return memory;
+    }
+
+    void* Alloc(HAllocator allocator, uint32_t size)
+    {
+        return AllocThread(allocator, 0, size);
+    }
+
+    uint32_t GetUsage(HAllocator allocator)
+    {
+        uint32_t used = 0;
+        for (uint32_t i = 0; i < allocator->m_ArenaCount; ++i)
+        {
+            used += allocator->m_Arenas[i].m_Used;
+        }
+        return used;
+    }
+
+    uint32_t GetHighWaterMark(HAllocator allocator)
+    {
+        return dmMath::Max(allocator->m_HighWaterMark, GetUsage(allocator));
+    }
+}
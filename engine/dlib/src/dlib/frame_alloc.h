@@ -0,0 +1,103 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_FRAME_ALLOC_H
+#define DM_FRAME_ALLOC_H
+
+#include <stdint.h>
+
+/**
+ * Linear allocator for transient data that only needs to live for a frame.
+ *
+ * Each arena has two buffers that are used every other frame. Memory allocated during a frame
+ * stays valid until the end of the next frame, and is then reused as a whole. Individual allocations
+ * are never freed. When a buffer runs out, allocations fall back to the heap and the buffer is grown
+ * to the high-water mark the next time it is reused.
+ *
+ * Arena 0 belongs to the thread that calls NewFrame(). Job workers use their own arenas, 1 to thread count,
+ * typically indexed with dmJob::GetThreadIndex(), so that allocations never need to be synchronized.
+ */
+namespace dmFrameAlloc
+{
+    /// Frame allocator handle
+    typedef struct Allocator* HAllocator;
+
+    /// All allocations are aligned to this
+    const uint32_t ALIGNMENT = 16;
+
+    struct NewParams
+    {
+        /// Initial size of each buffer of arena 0. Default 256kb
+        uint32_t m_Size;
+        /// Number of worker thread arenas. Default 0
+        uint32_t m_ThreadCount;
+        /// Initial size of each buffer of the worker thread arenas. Default 32kb
+        uint32_t m_ThreadSize;
+
+        NewParams();
+    };
+
+    /**
+     * Create a new frame allocator
+     * @param params parameters
+     * @return frame allocator handle
+     */
+    HAllocator New(const NewParams& params);
+
+    /**
+     * Delete the frame allocator and free all memory
+     * @param allocator frame allocator handle
+     */
+    void Delete(HAllocator allocator);
+
+    /**
+     * Start a new frame. The memory allocated two frames ago is reused, and the usage and
+     * high-water mark of the previous frame are reported to the profiler.
+     * @note No thread may allocate while this is called
+     * @param allocator frame allocator handle
+     */
+    void NewFrame(HAllocator allocator);
+
+    /**
+     * Allocate memory from arena 0, which belongs to the thread calling NewFrame()
+     * @param allocator frame allocator handle
+     * @param size size in bytes
+     * @return pointer to memory, valid until the end of the next frame
+     */
+    void* Alloc(HAllocator allocator, uint32_t size);
+
+    /**
+     * Allocate memory from the arena of a thread
+     * @note Each arena must only be used by one thread at a time
+     * @param allocator frame allocator handle
+     * @param thread_index arena index, 0 to thread count
+     * @param size size in bytes
+     * @return pointer to memory, valid until the end of the next frame
+     */
+    void* AllocThread(HAllocator allocator, uint32_t thread_index, uint32_t size);
+
+    /**
+     * Get the number of bytes allocated this frame, for all arenas
+     * @param allocator frame allocator handle
+     * @return number of bytes
+     */
+    uint32_t GetUsage(HAllocator allocator);
+
+    /**
+     * Get the highest number of bytes allocated during a single frame, for all arenas
+     * @param allocator frame allocator handle
+     * @return number of bytes
+     */
+    uint32_t GetHighWaterMark(HAllocator allocator);
+}
+
+#endif // DM_FRAME_ALLOC_H
@@ -18,8 +18,8 @@
 #include "array.h"
 #include "index_pool.h"
 #include "align.h"
+#include "interntable.h"
 #include <dlib/mutex.h>
-#include <dlib/hashtable.h>
 
 struct ReverseHashEntry
 {
@@ -30,16 +30,14 @@ struct ReverseHashEntry
 
 struct ReverseHashContainer
 {
-    static const size_t m_HashTableSize = 1024;
-    static const size_t m_HashTableCapacity = 512;
-    static const size_t m_HashTableCapacityIncrement = 256;
     static const size_t m_HashStatesCapacity = 512;
     static const size_t m_HashStatesCapacityIncrement = 256;
 
+    // Protects the incremental hash states. The reverse strings are lock free
     dmMutex::HMutex                 m_Mutex;
     bool                            m_Enabled;
-    dmHashTable32<ReverseHashEntry> m_HashTable32Entries;
-    dmHashTable64<ReverseHashEntry> m_HashTable64Entries;
+    dmInternTable<uint32_t>         m_Strings32;
+    dmInternTable<uint64_t>         m_Strings64;
     dmArray<ReverseHashEntry>       m_HashStates;
     dmIndexPool32                   m_HashStatesSlots;
 
@@ -55,12 +53,6 @@ struct ReverseHashContainer
         dmMutex::Delete(m_Mutex);
     }
 
-    template <typename KEY>
-    static inline void FreeEntryCallback(void* context, const KEY* key, ReverseHashEntry* value)
-    {
-        free(value->m_Value);
-    }
-
     template <typename INDEX>
     static inline void FreeStateCallback(void* context, const INDEX index)
     {
@@ -77,13 +69,6 @@ struct ReverseHashContainer
 
         if(enable)
         {
-
-            if(m_HashTable32Entries.Capacity() < m_HashTableCapacity)
-                m_HashTable32Entries.SetCapacity(m_HashTableSize, m_HashTableCapacity);
-            m_HashTable32Entries.Clear();
-            if(m_HashTable64Entries.Capacity() < m_HashTableCapacity)
-                m_HashTable64Entries.SetCapacity(m_HashTableSize, m_HashTableCapacity);
-            m_HashTable64Entries.Clear();
             m_HashStates.SetCapacity(m_HashStatesCapacity);
             m_HashStates.SetSize(m_HashStatesCapacity);
             m_HashStatesSlots.SetCapacity(m_HashStatesCapacity);
@@ -93,10 +78,8 @@ struct ReverseHashContainer
         }
         else
         {
-            m_HashTable32Entries.Iterate(FreeEntryCallback, (void*) 0);
-            m_HashTable32Entries.Clear();
-            m_HashTable64Entries.Iterate(FreeEntryCallback, (void*) 0);
-            m_HashTable64Entries.Clear();
+            m_Strings32.Clear();
+            m_Strings64.Clear();
             if(m_HashStatesSlots.Size() != 0)
             {
                 m_HashStatesSlots.Push(0);
@@ -224,19 +207,8 @@ uint32_t dmHashBuffer32(const void * key, uint32_t len)
 
     if (dmHashContainer().m_Enabled && len <= DMHASH_MAX_REVERSE_LENGTH)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable32<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable32Entries;
-        if (hash_table->Get(h) == 0)
-        {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            char* copy = (char*) malloc(len + 1);
-            memcpy(copy, key, len);
-            copy[len] = '\0';
-            hash_table->Put(h, ReverseHashEntry(copy, len));
-        }
+        // Lock free, and only copies the string the first time it's seen
+        dmHashContainer().m_Strings32.Put(h, key, len);
     }
 
     return h;
@@ -301,19 +273,8 @@ uint64_t dmHashBuffer64(const void * key, uint32_t len)
 
     if (dmHashContainer().m_Enabled && len <= DMHASH_MAX_REVERSE_LENGTH)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable64<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable64Entries;
-        if (hash_table->Get(h) == 0)
-        {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            char* copy = (char*) malloc(len + 1);
-            memcpy(copy, key, len);
-            copy[len] = '\0';
-            hash_table->Put(h, ReverseHashEntry(copy, len));
-        }
+        // Lock free, and only copies the string the first time it's seen
+        dmHashContainer().m_Strings64.Put(h, key, len);
     }
 
     return h;
@@ -429,19 +390,9 @@ uint32_t dmHashFinal32(HashState32* hash_state)
     if (dmHashContainer().m_Enabled && hash_state->m_ReverseHashEntryIndex && hash_state->m_Size <= DMHASH_MAX_REVERSE_LENGTH)
     {
         DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable32<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable32Entries;
-        if (hash_table->Get(hash_state->m_Hash) == 0)
-        {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            hash_table->Put(hash_state->m_Hash, dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex]);
-        }
-        else
-        {
-            free(dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex].m_Value);
-        }
+        ReverseHashEntry& state = dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex];
+        dmHashContainer().m_Strings32.Put(hash_state->m_Hash, state.m_Value ? state.m_Value : "", state.m_Length);
+        free(state.m_Value);
         dmHashContainer().FreeReverseHashStatesSlot(hash_state->m_ReverseHashEntryIndex);
         hash_state->m_ReverseHashEntryIndex = 0;
     }
@@ -565,19 +516,9 @@ uint64_t dmHashFinal64(HashState64* hash_state)
     if (dmHashContainer().m_Enabled && hash_state->m_ReverseHashEntryIndex && hash_state->m_Size <= DMHASH_MAX_REVERSE_LENGTH)
     {
         DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable64<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable64Entries;
-        if (hash_table->Get(hash_state->m_Hash) == 0)
-        {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            hash_table->Put(hash_state->m_Hash, dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex]);
-        }
-        else
-        {
-            free(dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex].m_Value);
-        }
+        ReverseHashEntry& state = dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex];
+        dmHashContainer().m_Strings64.Put(hash_state->m_Hash, state.m_Value ? state.m_Value : "", state.m_Length);
+        free(state.m_Value);
         dmHashContainer().FreeReverseHashStatesSlot(hash_state->m_ReverseHashEntryIndex);
         hash_state->m_ReverseHashEntryIndex = 0;
     }
@@ -600,16 +541,7 @@ DM_DLLEXPORT const void* dmHashReverse32(uint32_t hash, uint32_t* length)
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable32Entries.Get(hash);
-        if (reverse)
-        {
-            if (length)
-            {
-                *length = reverse->m_Length;
-            }
-            return reverse->m_Value;
-        }
+        return dmHashContainer().m_Strings32.Get(hash, length);
     }
     return 0;
 }
@@ -618,16 +550,7 @@ DM_DLLEXPORT const void* dmHashReverse64(uint64_t hash, uint32_t* length)
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable64Entries.Get(hash);
-        if (reverse)
-        {
-            if (length)
-            {
-                *length = reverse->m_Length;
-            }
-            return reverse->m_Value;
-        }
+        return dmHashContainer().m_Strings64.Get(hash, length);
     }
     return 0;
 }
@@ -636,13 +559,7 @@ DM_DLLEXPORT void dmHashReverseErase32(uint32_t hash)
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable32Entries.Get(hash);
-        if (reverse)
-        {
-            free(reverse->m_Value);
-            dmHashContainer().m_HashTable32Entries.Erase(hash);
-        }
+        dmHashContainer().m_Strings32.Erase(hash);
     }
 }
 
@@ -650,13 +567,7 @@ DM_DLLEXPORT void dmHashReverseErase64(uint64_t hash)
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable64Entries.Get(hash);
-        if (reverse)
-        {
-            free(reverse->m_Value);
-            dmHashContainer().m_HashTable64Entries.Erase(hash);
-        }
+        dmHashContainer().m_Strings64.Erase(hash);
     }
 }
 
@@ -0,0 +1,481 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_HASHMAP_H
+#define DM_HASHMAP_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+// The control bytes of a group are matched with SSE2 or NEON when the target always has it, otherwise plain C
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_HASHMAP_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define DM_HASHMAP_NEON
+    #include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace dmHashMapInternal
+{
+    static const uint32_t GROUP_SIZE = 16;
+
+    static const int8_t CTRL_EMPTY = -128; // 0x80
+    static const int8_t CTRL_DELETED = -2; // 0xfe
+
+    // One bit per slot in the group. The NEON version uses four bits per slot.
+    typedef uint64_t BitMask;
+
+#if defined(DM_HASHMAP_NEON)
+    static const uint32_t BITMASK_SHIFT = 2;
+    static inline BitMask ToBitMask(uint8x16_t cmp)
+    {
+        uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+    }
+#else
+    static const uint32_t BITMASK_SHIFT = 0;
+#endif
+
+#if !defined(DM_HASHMAP_SSE2) && !defined(DM_HASHMAP_NEON)
+    static const uint64_t LSBS = 0x0101010101010101ULL;
+    static const uint64_t MSBS = 0x8080808080808080ULL;
+
+    // Gathers the top bit of each byte of the two (little endian) words into a 16 bit mask
+    static inline BitMask PackMsbs(uint64_t lo, uint64_t hi)
+    {
+        const uint64_t gather = 0x0102040810204080ULL;
+        return (((lo & MSBS) >> 7) * gather >> 56) | ((((hi & MSBS) >> 7) * gather >> 56) << 8);
+    }
+
+    static inline void LoadGroup(const int8_t* group, uint64_t* lo, uint64_t* hi)
+    {
+        memcpy(lo, group, sizeof(uint64_t));
+        memcpy(hi, group + sizeof(uint64_t), sizeof(uint64_t));
+    }
+#endif
+
+    static inline uint32_t LowestBit(BitMask mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+    #if defined(_M_X64) || defined(_M_ARM64)
+        _BitScanForward64(&index, mask);
+    #else
+        if (!_BitScanForward(&index, (uint32_t)mask))
+        {
+            _BitScanForward(&index, (uint32_t)(mask >> 32));
+            index += 32;
+        }
+    #endif
+        return (uint32_t)index >> BITMASK_SHIFT;
+#else
+        return (uint32_t)__builtin_ctzll(mask) >> BITMASK_SHIFT;
+#endif
+    }
+
+    // Slots of the group whose control byte equals h2
+    static inline BitMask Match(const int8_t* group, int8_t h2)
+    {
+#if defined(DM_HASHMAP_SSE2)
+        __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)));
+#elif defined(DM_HASHMAP_NEON)
+        int8x16_t ctrl = vld1q_s8(group);
+        return ToBitMask(vceqq_s8(ctrl, vdupq_n_s8(h2)));
+#else
+        // Bytes equal to h2 become zero. This may report false positives, which are rejected by the key compare
+        uint64_t lo, hi;
+        LoadGroup(group, &lo, &hi);
+        const uint64_t pattern = LSBS * (uint8_t)h2;
+        lo ^= pattern;
+        hi ^= pattern;
+        return PackMsbs((lo - LSBS) & ~lo, (hi - LSBS) & ~hi);
+#endif
+    }
+
+    // Slots of the group that are empty or deleted, i.e. have the sign bit set
+    static inline BitMask MatchEmptyOrDeleted(const int8_t* group)
+    {
+#if defined(DM_HASHMAP_SSE2)
+        __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+        return (uint32_t)_mm_movemask_epi8(ctrl);
+#elif defined(DM_HASHMAP_NEON)
+        int8x16_t ctrl = vld1q_s8(group);
+        return ToBitMask(vcltq_s8(ctrl, vdupq_n_s8(0)));
+#else
+        uint64_t lo, hi;
+        LoadGroup(group, &lo, &hi);
+        return PackMsbs(lo, hi);
+#endif
+    }
+
+    // Must be exact, since a lookup stops at a group with an empty slot
+    static inline BitMask MatchEmpty(const int8_t* group)
+    {
+#if defined(DM_HASHMAP_SSE2) || defined(DM_HASHMAP_NEON)
+        return Match(group, CTRL_EMPTY);
+#else
+        // Empty (0x80) is the only control byte with the top bit set and bit 1 clear
+        uint64_t lo, hi;
+        LoadGroup(group, &lo, &hi);
+        return PackMsbs(lo & ~(lo << 6), hi & ~(hi << 6));
+#endif
+    }
+
+    // Spreads the key bits so that both the slot index (low bits) and the control byte (top 7 bits) are well distributed.
+    // Keys are often already hashes (dmhash_t), but may also be small integers such as glyph code points.
+    static inline uint64_t HashKey(uint64_t key)
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return key;
+    }
+}
+
+/*# hashmap
+ * Open addressing hash map with memcpy-copy semantics (POD types).
+ * Slots are grouped 16 at a time and each slot has a control byte holding 7 bits of the key hash,
+ * so that a lookup compares a whole group of candidates with a single SSE2/NEON instruction
+ * and touches the key/value storage only for likely matches.
+ * Like dmHashTable, the capacity is fixed until SetCapacity() is called, and pointers to values stay
+ * valid until the next call to SetCapacity(), Clear() or Swap().
+ * @note The key type needs to be an integer type, and support ==
+ * @type class
+ * @name dmHashMap
+ */
+template <typename KEY, typename T>
+class dmHashMap
+{
+public:
+    struct Entry
+    {
+        KEY      m_Key;
+        T        m_Value;
+    };
+
+    dmHashMap()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    ~dmHashMap()
+    {
+        free(m_Ctrl);
+    }
+
+    /**
+     * Removes all the entries from the table.
+     */
+    void Clear()
+    {
+        if (m_Ctrl)
+        {
+            memset(m_Ctrl, dmHashMapInternal::CTRL_EMPTY, m_SlotCount);
+        }
+        m_Count = 0;
+        m_Deleted = 0;
+    }
+
+    /**
+     * Number of entries stored in table
+     * @return Number of entries.
+     */
+    uint32_t Size() const
+    {
+        return m_Count;
+    }
+
+    /**
+     * Maximum number of entries possible to store in table
+     * @return the capacity of the table
+     */
+    uint32_t Capacity() const
+    {
+        return m_Capacity;
+    }
+
+    /**
+     * Set table capacity. New capacity must be greater or equal to current capacity.
+     * The number of slots is derived from the capacity, keeping the load factor at or below 7/8.
+     * @param capacity Capacity. capacity < 0x80000000
+     */
+    void SetCapacity(uint32_t capacity)
+    {
+        assert(capacity < 0x80000000);
+        assert(capacity >= m_Capacity);
+
+        uint32_t slot_count = dmHashMapInternal::GROUP_SIZE;
+        while (slot_count - slot_count / 8 < capacity)
+        {
+            slot_count *= 2;
+        }
+
+        dmHashMap<KEY, T> new_map;
+        new_map.Allocate(slot_count);
+        new_map.m_Capacity = capacity;
+        if (m_Count)
+        {
+            Iterate<dmHashMap<KEY, T> >(&FillCallback<KEY, T>, &new_map);
+        }
+        Swap(new_map);
+    }
+
+    /**
+     * Swaps the contents of two hash maps
+     * @param other the other map
+     */
+    void Swap(dmHashMap<KEY, T>& other)
+    {
+        char buf[sizeof(*this)];
+        memcpy(buf, (void*)&other, sizeof(buf));
+        memcpy((void*)&other, (void*)this, sizeof(buf));
+        memcpy((void*)this, buf, sizeof(buf));
+    }
+
+    bool Full() const
+    {
+        return m_Count == m_Capacity;
+    }
+
+    bool Empty() const
+    {
+        return m_Count == 0;
+    }
+
+    /**
+     * Put key/value pair in the map. NOTE: The method will "assert" if the key is new and the map is full.
+     * @param key Key
+     * @param value Value
+     */
+    void Put(KEY key, const T& value)
+    {
+        uint64_t hash = dmHashMapInternal::HashKey((uint64_t)key);
+        uint32_t index = FindIndex(key, hash);
+        if (index != 0xffffffff)
+        {
+            m_Entries[index].m_Value = value;
+            return;
+        }
+
+        assert(!Full());
+        index = FindInsertIndex(hash);
+        if (m_Ctrl[index] == dmHashMapInternal::CTRL_DELETED)
+        {
+            --m_Deleted;
+        }
+        m_Ctrl[index] = H2(hash);
+        m_Entries[index].m_Key = key;
+        m_Entries[index].m_Value = value;
+        ++m_Count;
+    }
+
+    /**
+     * Get pointer to value from key
+     * @param key Key
+     * @return Pointer to value. NULL if the key/value pair doesn't exist.
+     */
+    T* Get(KEY key)
+    {
+        uint32_t index = FindIndex(key, dmHashMapInternal::HashKey((uint64_t)key));
+        return index != 0xffffffff ? &m_Entries[index].m_Value : 0;
+    }
+
+    const T* Get(KEY key) const
+    {
+        uint32_t index = FindIndex(key, dmHashMapInternal::HashKey((uint64_t)key));
+        return index != 0xffffffff ? &m_Entries[index].m_Value : 0;
+    }
+
+    /**
+     * Remove key/value pair.
+     * @param key Key to remove
+     * @note Only valid if key exists in table
+     */
+    void Erase(KEY key)
+    {
+        uint32_t index = FindIndex(key, dmHashMapInternal::HashKey((uint64_t)key));
+        assert(index != 0xffffffff && "Key not found (erase)");
+
+        // A lookup stops at the first group with an empty slot. If this group has none, a lookup may
+        // need to probe past it, so the slot becomes a tombstone instead
+        int8_t* group = &m_Ctrl[index & ~(dmHashMapInternal::GROUP_SIZE - 1)];
+        if (dmHashMapInternal::MatchEmpty(group))
+        {
+            m_Ctrl[index] = dmHashMapInternal::CTRL_EMPTY;
+        }
+        else
+        {
+            m_Ctrl[index] = dmHashMapInternal::CTRL_DELETED;
+            ++m_Deleted;
+        }
+        --m_Count;
+
+        if (m_Count == 0 && m_Deleted)
+        {
+            Clear();
+        }
+    }
+
+    /**
+     * Iterate over all entries in table
+     * @param call_back Call-back called for every entry
+     * @param context Context
+     */
+    template <typename CONTEXT>
+    void Iterate(void (*call_back)(CONTEXT *context, const KEY* key, T* value), CONTEXT* context)
+    {
+        for (uint32_t i = 0; i < m_SlotCount; ++i)
+        {
+            if (m_Ctrl[i] >= 0)
+            {
+                Entry* e = &m_Entries[i];
+                call_back(context, &e->m_Key, &e->m_Value);
+            }
+        }
+    }
+
+    /**
+     * Verify internal structure. "assert" if invalid. For unit testing
+     */
+    void Verify()
+    {
+        uint32_t real_count = 0;
+        uint32_t real_deleted = 0;
+        for (uint32_t i = 0; i < m_SlotCount; ++i)
+        {
+            if (m_Ctrl[i] >= 0)
+            {
+                KEY key = m_Entries[i].m_Key;
+                uint64_t hash = dmHashMapInternal::HashKey((uint64_t)key);
+                assert(m_Ctrl[i] == H2(hash));
+                assert(FindIndex(key, hash) == i);
+                ++real_count;
+            }
+            else if (m_Ctrl[i] == dmHashMapInternal::CTRL_DELETED)
+            {
+                ++real_deleted;
+            }
+        }
+        assert(real_count == m_Count);
+        assert(real_deleted == m_Deleted);
+    }
+
+private:
+    // Forbid assignment operator and copy-constructor
+    dmHashMap(const dmHashMap<KEY, T>&);
+    const dmHashMap<KEY, T>& operator=(const dmHashMap<KEY, T>&);
+
+    template <typename KEY2, typename T2>
+    static void FillCallback(dmHashMap<KEY2,T2>* map, const KEY2* key, T2* value)
+    {
+        map->Put(*key, *value);
+    }
+
+    static inline int8_t H2(uint64_t hash)
+    {
+        return (int8_t)(hash >> 57);
+    }
+
+    void Allocate(uint32_t slot_count)
+    {
+        // Control bytes first, then the entries. The slot count is a multiple of the group size, which keeps the entries aligned
+        m_Ctrl = (int8_t*) malloc(slot_count + slot_count * sizeof(Entry));
+        m_Entries = (Entry*) (m_Ctrl + slot_count);
+        m_SlotCount = slot_count;
+        memset(m_Ctrl, dmHashMapInternal::CTRL_EMPTY, slot_count);
+    }
+
+    // Groups are probed quadratically (triangular numbers), which visits every group once since the group count is a power of two
+    uint32_t FindIndex(KEY key, uint64_t hash) const
+    {
+        if (!m_SlotCount)
+            return 0xffffffff;
+
+        const int8_t h2 = H2(hash);
+        const uint32_t group_mask = m_SlotCount / dmHashMapInternal::GROUP_SIZE - 1;
+        uint32_t group_index = (uint32_t)hash & group_mask;
+        for (uint32_t probe = 1; probe <= group_mask + 1; ++probe)
+        {
+            const uint32_t base = group_index * dmHashMapInternal::GROUP_SIZE;
+            const int8_t* group = &m_Ctrl[base];
+            dmHashMapInternal::BitMask match = dmHashMapInternal::Match(group, h2);
+            while (match)
+            {
+                uint32_t index = base + dmHashMapInternal::LowestBit(match);
+                if (m_Entries[index].m_Key == key)
+                {
+                    return index;
+                }
+                match &= match - 1;
+            }
+            if (dmHashMapInternal::MatchEmpty(group))
+            {
+                return 0xffffffff;
+            }
+            group_index = (group_index + probe) & group_mask;
+        }
+        return 0xffffffff;
+    }
+
+    // First empty or deleted slot along the probe sequence. There is always one, since the load factor is below 1
+    uint32_t FindInsertIndex(uint64_t hash) const
+    {
+        const uint32_t group_mask = m_SlotCount / dmHashMapInternal::GROUP_SIZE - 1;
+        uint32_t group_index = (uint32_t)hash & group_mask;
+        for (uint32_t probe = 1; ; ++probe)
+        {
+            const uint32_t base = group_index * dmHashMapInternal::GROUP_SIZE;
+            dmHashMapInternal::BitMask free_slots = dmHashMapInternal::MatchEmptyOrDeleted(&m_Ctrl[base]);
+            if (free_slots)
+            {
+                return base + dmHashMapInternal::LowestBit(free_slots);
+            }
+            group_index = (group_index + probe) & group_mask;
+        }
+    }
+
+    // Control bytes, one per slot: CTRL_EMPTY, CTRL_DELETED or the top 7 bits of the key hash
+    int8_t*   m_Ctrl;
+    Entry*    m_Entries;
+    uint32_t  m_SlotCount;
+    uint32_t  m_Capacity;
+    // Number of key/value pairs in table
+    uint32_t  m_Count;
+    // Number of tombstones
+    uint32_t  m_Deleted;
+};
+
+/*#
+ * Specialized hash map with [type:uint32_t] as keys
+ * @type class
+ * @name dmHashMap32
+ */
+template <typename T>
+class dmHashMap32 : public dmHashMap<uint32_t, T> {};
+
+/*#
+ * Specialized hash map with [type:uint64_t] as keys
+ * @type class
+ * @name dmHashMap64
+ */
+template <typename T>
+class dmHashMap64 : public dmHashMap<uint64_t, T> {};
+
+#endif // DM_HASHMAP_H
@@ -10,6 +10,7 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,7 +36,10 @@ namespace dmHttpCache
     // Magic file header for index file
     const uint32_t MAGIC = 0xCAAAAAAC;
     // Current index file version
-    const uint32_t VERSION = 7;
+    const uint32_t VERSION = 8;
+
+    // Entry not yet written to the index file
+    const uint32_t INVALID_SLOT = 0xffffffff;
 
     // Maximum number of cache entry creations in flight
     const uint32_t MAX_CACHE_CREATORS = 16;
@@ -47,8 +51,6 @@ namespace dmHttpCache
         uint32_t m_Magic;
         // Index file version number
         uint32_t m_Version;
-        // Checksum of the index payload, ie the data that follows the header
-        uint64_t m_Checksum;
         uint32_t m_SizeOfEntry;     // Making sure the size is double checked
         uint32_t m_SizeOfFileEntry; // Making sure the size is double checked
     };
@@ -61,14 +63,21 @@ namespace dmHttpCache
         Entry()
         {
             memset(this, 0, sizeof(*this));
+            m_Slot = INVALID_SLOT;
         }
         EntryInfo m_Info;
+        // Slot in the index file, or INVALID_SLOT
+        uint32_t m_Slot;
         uint8_t  m_ReadLockCount : 8;
         uint8_t  m_WriteLock : 1;
+        // Changed since the last flush
+        uint8_t  m_Dirty : 1;
     };
 
     /*
-     * Disk (index) representation of a cache entry
+     * Disk (index) representation of a cache entry. The index is a header followed by
+     * fixed size slots, one per entry, so that a flush only writes the entries that changed.
+     * A zeroed slot is free.
      */
     struct FileEntry
     {
@@ -85,6 +94,8 @@ namespace dmHttpCache
         uint64_t m_Expires;
         // Checksum
         uint64_t m_Checksum;
+        // Checksum of the members above
+        uint64_t m_EntryChecksum;
     };
 
     /*
@@ -114,7 +125,9 @@ namespace dmHttpCache
             m_Mutex = dmMutex::New();
             m_Policy = CONSISTENCY_POLICY_VERIFY;
             m_StringAllocator = dmPoolAllocator::New(4096);
+            m_SlotCount = 0;
             m_Dirty = false;
+            m_RewriteIndex = false;
         }
 
         ~Cache()
@@ -132,7 +145,16 @@ namespace dmHttpCache
         dmArray<CacheCreator> m_CacheCreators;
         ConsistencyPolicy    m_Policy;
         dmPoolAllocator::HPool m_StringAllocator;
+        // Uri hashes of the entries to write on the next flush
+        dmArray<uint64_t>    m_DirtyEntries;
+        // Free slots in the index file
+        dmArray<uint32_t>    m_FreeSlots;
+        // Slots of removed entries, cleared on the next flush
+        dmArray<uint32_t>    m_ClearedSlots;
+        uint32_t             m_SlotCount;
         bool                 m_Dirty;
+        // Write the whole index on the next flush, eg after a write error
+        bool                 m_RewriteIndex;
     };
 
     void SetDefaultParams(NewParams* params)
@@ -141,6 +163,41 @@ namespace dmHttpCache
         params->m_MaxCacheEntryAge = 60 * 60 * 24 * 5;
     }
 
+    template <typename T>
+    static void PushGrow(dmArray<T>& array, T value)
+    {
+        if (array.Full())
+        {
+            array.OffsetCapacity(dmMath::Max(64U, array.Capacity() / 2));
+        }
+        array.Push(value);
+    }
+
+    static void MarkDirty(HCache cache, uint64_t uri_hash, Entry* entry)
+    {
+        if (!entry->m_Dirty)
+        {
+            entry->m_Dirty = 1;
+            PushGrow(cache->m_DirtyEntries, uri_hash);
+        }
+        cache->m_Dirty = true;
+    }
+
+    static void EraseEntry(HCache cache, uint64_t uri_hash, Entry* entry)
+    {
+        if (entry->m_Slot != INVALID_SLOT)
+        {
+            PushGrow(cache->m_ClearedSlots, entry->m_Slot);
+            cache->m_Dirty = true;
+        }
+        cache->m_CacheTable.Erase(uri_hash);
+    }
+
+    static uint64_t FileEntryChecksum(const FileEntry* file_entry)
+    {
+        return dmHashBuffer64(file_entry, offsetof(FileEntry, m_EntryChecksum));
+    }
+
     static void HashToString(uint64_t hash, char* str)
     {
         static const char hex_chars[] = "0123456789abcdef";
@@ -238,39 +295,49 @@ namespace dmHttpCache
             }
             else
             {
-                uint64_t checksum = dmHashBuffer64((void*) (((uintptr_t) buffer) + sizeof(IndexHeader)), size - sizeof(IndexHeader));
-                if (checksum != header->m_Checksum)
+                uint32_t n_entries = (size - sizeof(IndexHeader)) / sizeof(FileEntry);
+                FileEntry* entries = (FileEntry*) (((uintptr_t) buffer) + sizeof(IndexHeader));
+                uint32_t capacity = n_entries + 128;
+                c->m_CacheTable.SetCapacity(2 * capacity / 3, capacity);
+                c->m_SlotCount = n_entries;
+                uint64_t current_time = dmTime::GetTime();
+                uint32_t n_corrupt = 0;
+                for (uint32_t i = 0; i < n_entries; ++i)
                 {
-                    dmLogError("Corrupt cache index file '%s'. Removing file.", cache_file);
-                }
-                else
-                {
-                    uint32_t n_entries = (size - sizeof(IndexHeader)) / sizeof(FileEntry);
-                    FileEntry* entries = (FileEntry*) (((uintptr_t) buffer) + sizeof(IndexHeader));
-                    uint32_t capacity = n_entries + 128;
-                    c->m_CacheTable.SetCapacity(2 * capacity / 3, capacity);
-                    uint64_t current_time = dmTime::GetTime();
-                    for (uint32_t i = 0; i < n_entries; ++i)
+                    if (entries[i].m_UriHash == 0)
+                    {
+                        PushGrow(c->m_FreeSlots, i);
+                    }
+                    else if (entries[i].m_EntryChecksum != FileEntryChecksum(&entries[i]) || c->m_CacheTable.Get(entries[i].m_UriHash))
+                    {
+                        ++n_corrupt;
+                        PushGrow(c->m_ClearedSlots, i);
+                    }
+                    else if (entries[i].m_LastAccessed + c->m_MaxCacheEntryAge >= current_time)
                     {
-                        if (entries[i].m_LastAccessed + c->m_MaxCacheEntryAge >= current_time)
-                        {
-                            // Keep cache entry, ie within max age
-                            Entry e;
-                            memcpy(e.m_Info.m_ETag, entries[i].m_ETag, sizeof(e.m_Info.m_ETag));
-                            e.m_Info.m_URI = dmPoolAllocator::Duplicate(c->m_StringAllocator, entries[i].m_URI);
-                            e.m_Info.m_IdentifierHash = entries[i].m_IdentifierHash;
-                            e.m_Info.m_LastAccessed = entries[i].m_LastAccessed;
-                            e.m_Info.m_Expires = entries[i].m_Expires;
-                            e.m_Info.m_Checksum = entries[i].m_Checksum;
-                            c->m_CacheTable.Put(entries[i].m_UriHash, e);
-                        }
-                        else
-                        {
-                            // Remove old cache entry
-                            RemoveCachedContentFile(c, entries[i].m_IdentifierHash);
-                        }
+                        // Keep cache entry, ie within max age
+                        Entry e;
+                        memcpy(e.m_Info.m_ETag, entries[i].m_ETag, sizeof(e.m_Info.m_ETag));
+                        e.m_Info.m_URI = dmPoolAllocator::Duplicate(c->m_StringAllocator, entries[i].m_URI);
+                        e.m_Info.m_IdentifierHash = entries[i].m_IdentifierHash;
+                        e.m_Info.m_LastAccessed = entries[i].m_LastAccessed;
+                        e.m_Info.m_Expires = entries[i].m_Expires;
+                        e.m_Info.m_Checksum = entries[i].m_Checksum;
+                        e.m_Slot = i;
+                        c->m_CacheTable.Put(entries[i].m_UriHash, e);
+                    }
+                    else
+                    {
+                        // Remove old cache entry
+                        RemoveCachedContentFile(c, entries[i].m_IdentifierHash);
+                        PushGrow(c->m_ClearedSlots, i);
                     }
                 }
+                if (n_corrupt > 0)
+                {
+                    dmLogError("Corrupt cache index file '%s'. Removing %u entries.", cache_file, n_corrupt);
+                }
+                c->m_Dirty = !c->m_ClearedSlots.Empty();
             }
             free(buffer);
             fclose(f);
@@ -280,86 +347,130 @@ namespace dmHttpCache
         return RESULT_OK;
     }
 
-    struct WriteEntryContext
+    static bool WriteSlot(FILE* f, uint32_t slot, const FileEntry* file_entry)
     {
-        FILE* m_File;
-        bool m_Error;
-        HashState64 m_HashState;
-        WriteEntryContext(FILE* f)
-        {
-            m_File = f;
-            m_Error = false;
-            dmHashInit64(&m_HashState, false);
-        }
-    };
+        long offset = (long) (sizeof(IndexHeader) + slot * sizeof(FileEntry));
+        return fseek(f, offset, SEEK_SET) == 0 && fwrite(file_entry, 1, sizeof(*file_entry), f) == sizeof(*file_entry);
+    }
 
-    static void WriteEntry(WriteEntryContext* context, const uint64_t* key, Entry* entry)
+    static bool WriteEntry(HCache cache, FILE* f, uint64_t uri_hash, Entry* entry)
     {
-        if (context->m_Error)
-            return;
+        entry->m_Dirty = 0;
+        if (entry->m_WriteLock)
+        {
+            // Written when the update is done, see End()
+            return true;
+        }
 
-        if(entry->m_WriteLock)
+        if (entry->m_Slot == INVALID_SLOT)
         {
-            dmLogWarning("Invalid http cache state. Not yet flushed cache entry (etag: %s).", entry->m_Info.m_ETag);
-            return;
+            if (cache->m_FreeSlots.Empty())
+            {
+                entry->m_Slot = cache->m_SlotCount++;
+            }
+            else
+            {
+                entry->m_Slot = cache->m_FreeSlots.Back();
+                cache->m_FreeSlots.Pop();
+            }
         }
 
         FileEntry file_entry;
         memset(&file_entry, 0, sizeof(file_entry));
 
-        file_entry.m_UriHash = *key;
+        file_entry.m_UriHash = uri_hash;
         memcpy(file_entry.m_ETag, entry->m_Info.m_ETag, sizeof(file_entry.m_ETag));
         dmStrlCpy(file_entry.m_URI, entry->m_Info.m_URI, sizeof(file_entry.m_URI));
         file_entry.m_IdentifierHash = entry->m_Info.m_IdentifierHash;
         file_entry.m_LastAccessed = entry->m_Info.m_LastAccessed;
         file_entry.m_Expires = entry->m_Info.m_Expires;
         file_entry.m_Checksum = entry->m_Info.m_Checksum;
-
-        dmHashUpdateBuffer64(&context->m_HashState, &file_entry, sizeof(file_entry));
-        size_t n_written = fwrite(&file_entry, 1, sizeof(file_entry), context->m_File);
-        if (n_written != sizeof(file_entry))
-        {
-            context->m_Error = true;
-        }
+        file_entry.m_EntryChecksum = FileEntryChecksum(&file_entry);
+        return WriteSlot(f, entry->m_Slot, &file_entry);
     }
 
-    static Result WriteIndex(HCache cache, FILE* f)
+    static bool WriteHeader(FILE* f)
     {
         IndexHeader header;
-
+        memset(&header, 0, sizeof(header));
         header.m_Magic = MAGIC;
         header.m_Version = VERSION;
-        header.m_Checksum = 0;
         header.m_SizeOfEntry = (uint32_t)sizeof(Entry);
         header.m_SizeOfFileEntry = (uint32_t)sizeof(FileEntry);
-        size_t n_written = fwrite(&header, 1, sizeof(header), f);
-        if (n_written != sizeof(header))
-        {
-            return RESULT_IO_ERROR;
-        }
-        else
+        return fwrite(&header, 1, sizeof(header), f) == sizeof(header);
+    }
+
+    // Writes the changes since the last flush to their slots
+    static Result WriteChanges(HCache cache, FILE* f)
+    {
+        FileEntry empty_entry;
+        memset(&empty_entry, 0, sizeof(empty_entry));
+        for (uint32_t i = 0; i < cache->m_ClearedSlots.Size(); ++i)
         {
-            WriteEntryContext context(f);
-            cache->m_CacheTable.Iterate(&WriteEntry, &context);
-            if (context.m_Error)
+            uint32_t slot = cache->m_ClearedSlots[i];
+            if (!WriteSlot(f, slot, &empty_entry))
             {
                 return RESULT_IO_ERROR;
             }
-            else
+            PushGrow(cache->m_FreeSlots, slot);
+        }
+        cache->m_ClearedSlots.SetSize(0);
+
+        for (uint32_t i = 0; i < cache->m_DirtyEntries.Size(); ++i)
+        {
+            uint64_t uri_hash = cache->m_DirtyEntries[i];
+            Entry* entry = cache->m_CacheTable.Get(uri_hash);
+            // Removed, or written already
+            if (entry == 0 || !entry->m_Dirty)
+                continue;
+            if (!WriteEntry(cache, f, uri_hash, entry))
             {
-                // Rewrite header with checksum
-                fseek(f, 0, SEEK_SET);
-                header.m_Checksum = dmHashFinal64(&context.m_HashState);
-                size_t n_written = fwrite(&header, 1, sizeof(header), f);
-                if (n_written != sizeof(header))
-                {
-                    return RESULT_IO_ERROR;
-                }
+                return RESULT_IO_ERROR;
             }
         }
+        cache->m_DirtyEntries.SetSize(0);
         return RESULT_OK;
     }
 
+    struct RewriteIndexContext
+    {
+        HCache m_Cache;
+        FILE*  m_File;
+        bool   m_Error;
+    };
+
+    static void RewriteEntry(RewriteIndexContext* context, const uint64_t* key, Entry* entry)
+    {
+        if (context->m_Error)
+            return;
+        // Slots are handed out in order
+        entry->m_Slot = INVALID_SLOT;
+        if (!WriteEntry(context->m_Cache, context->m_File, *key, entry))
+        {
+            context->m_Error = true;
+        }
+    }
+
+    // Writes all entries to a new index file
+    static Result RewriteIndex(HCache cache, FILE* f)
+    {
+        cache->m_SlotCount = 0;
+        cache->m_FreeSlots.SetSize(0);
+        cache->m_ClearedSlots.SetSize(0);
+        cache->m_DirtyEntries.SetSize(0);
+        if (!WriteHeader(f))
+        {
+            return RESULT_IO_ERROR;
+        }
+
+        RewriteIndexContext context;
+        context.m_Cache = cache;
+        context.m_File = f;
+        context.m_Error = false;
+        cache->m_CacheTable.Iterate(&RewriteEntry, &context);
+        return context.m_Error ? RESULT_IO_ERROR : RESULT_OK;
+    }
+
     Result Flush(HCache cache)
     {
         dmMutex::ScopedLock lock(cache->m_Mutex);
@@ -372,17 +483,24 @@ namespace dmHttpCache
 
         char cache_file[DMPATH_MAX_PATH];
         dmSnPrintf(cache_file, sizeof(cache_file), "%s/%s", cache->m_Path, "index");
-        FILE* f = fopen(cache_file, "wb");
+        FILE* f = cache->m_RewriteIndex ? 0 : fopen(cache_file, "r+b");
+        bool rewrite = f == 0;
+        if (rewrite) {
+            f = fopen(cache_file, "wb");
+        }
         if (f) {
-            Result r = WriteIndex(cache, f);
+            Result r = rewrite ? RewriteIndex(cache, f) : WriteChanges(cache, f);
             fclose(f);
             if (r != RESULT_OK) {
                 dmLogError("Error writing to index file '%s'", cache_file);
                 dmSys::Unlink(cache_file);
+                cache->m_RewriteIndex = true;
                 return RESULT_IO_ERROR;
             }
+            cache->m_RewriteIndex = false;
         } else {
             dmLogError("Unable to open index file '%s'", cache_file);
+            cache->m_RewriteIndex = true;
             return RESULT_IO_ERROR;
         }
 
@@ -564,7 +682,7 @@ namespace dmHttpCache
         if (cache_creator->m_Error)
         {
             FreeCacheCreator(cache, cache_creator);
-            cache->m_CacheTable.Erase(uri_hash);
+            EraseEntry(cache, uri_hash, entry);
             return RESULT_IO_ERROR;
         }
 
@@ -578,7 +696,7 @@ namespace dmHttpCache
             {
                 dmLogError("Unable to remove cache file: %s", path);
                 FreeCacheCreator(cache, cache_creator);
-                cache->m_CacheTable.Erase(uri_hash);
+                EraseEntry(cache, uri_hash, entry);
                 return RESULT_IO_ERROR;
             }
         }
@@ -598,7 +716,7 @@ namespace dmHttpCache
                 {
                     dmLogError("Unable to create directory '%s'", path);
                     FreeCacheCreator(cache, cache_creator);
-                    cache->m_CacheTable.Erase(uri_hash);
+                    EraseEntry(cache, uri_hash, entry);
                     return RESULT_IO_ERROR;
                 }
             }
@@ -617,12 +735,12 @@ namespace dmHttpCache
             char* error_msg = strerror(errno);
             dmLogError("Unable to rename temporary cache file from '%s' to '%s'. %s (%d)", cache_creator->m_Filename, path, error_msg, errno);
             FreeCacheCreator(cache, cache_creator);
-            cache->m_CacheTable.Erase(uri_hash);
+            EraseEntry(cache, uri_hash, entry);
             return RESULT_IO_ERROR;
         }
 
         FreeCacheCreator(cache, cache_creator);
-        cache->m_Dirty = true;
+        MarkDirty(cache, uri_hash, entry);
 
         return RESULT_OK;
     }
@@ -687,6 +805,7 @@ namespace dmHttpCache
             }
 
             entry->m_Info.m_LastAccessed = dmTime::GetTime();
+            MarkDirty(cache, uri_hash, entry);
 
             char path[DMPATH_MAX_PATH];
             ContentFilePath(cache, identifier_hash, path, sizeof(path));
@@ -702,7 +821,7 @@ namespace dmHttpCache
             {
                 dmLogError("Unable to open %s", path);
                 // Remove invalid cache entry
-                cache->m_CacheTable.Erase(uri_hash);
+                EraseEntry(cache, uri_hash, entry);
                 return RESULT_NO_ENTRY;
             }
         }
@@ -18,6 +18,9 @@
 #include "log.h"
 #include "time.h"
 #include "math.h"
+#include "hash.h"
+#include "array.h"
+#include "hashtable.h"
 #include "dstrings.h"
 #include "http_cache_verify.h"
 
@@ -207,4 +210,165 @@ namespace dmHttpCacheVerify
         }
     }
 
+    struct ContentContext
+    {
+        dmArray<char> m_Manifest;
+        int           m_HttpStatus;
+    };
+
+    static void ContentHttpContent(dmHttpClient::HResponse, void* user_data, int status_code, const void* content_data, uint32_t content_data_size)
+    {
+        ContentContext* context = (ContentContext*) user_data;
+        context->m_HttpStatus = status_code;
+        if (status_code != 200 || content_data_size == 0)
+        {
+            return;
+        }
+
+        dmArray<char>& manifest = context->m_Manifest;
+        if (manifest.Remaining() < content_data_size)
+        {
+            manifest.OffsetCapacity(dmMath::Max(content_data_size, manifest.Capacity()));
+        }
+        manifest.PushArray((const char*) content_data, content_data_size);
+    }
+
+    Result VerifyCacheContent(dmHttpCache::HCache cache, dmURI::Parts* uri)
+    {
+        ContentContext context;
+        context.m_HttpStatus = 0;
+
+        dmHttpClient::NewParams params;
+        params.m_HttpContent = ContentHttpContent;
+        params.m_Userdata = &context;
+        dmHttpClient::HClient client = dmHttpClient::New(&params, uri->m_Hostname, uri->m_Port);
+        if (client == 0)
+        {
+            return RESULT_OUT_OF_RESOURCES;
+        }
+
+        dmHttpClient::Result get_result = Get(client, "/__content_hashes__");
+        dmHttpClient::Delete(client);
+
+        if (get_result == dmHttpClient::RESULT_NOT_200_OK)
+        {
+            return context.m_HttpStatus == 404 ? RESULT_UNSUPPORTED : RESULT_UNKNOWN_ERROR;
+        }
+        else if (get_result != dmHttpClient::RESULT_OK)
+        {
+            return RESULT_NETWORK_ERROR;
+        }
+
+        uint32_t verified_count;
+        uint32_t added_count;
+        Result r = ApplyContentManifest(cache, context.m_Manifest.Begin(), context.m_Manifest.Size(), &verified_count, &added_count);
+        if (r == RESULT_OK)
+        {
+            dmLogInfo("Verified %u cached resources (%u added from identical content)", verified_count, added_count);
+        }
+        return r;
+    }
+
+    // Maps ETags to the uri of a cached entry with that ETag
+    typedef dmHashTable64<const char*> ContentTable;
+
+    static void CollectContentCallback(void* context, const dmHttpCache::EntryInfo* entry_info)
+    {
+        ContentTable* table = (ContentTable*) context;
+        if (entry_info->m_ETag[0] && !table->Full())
+        {
+            table->Put(dmHashString64(entry_info->m_ETag), entry_info->m_URI);
+        }
+    }
+
+    // Copy the content of the entry for src_uri into a new entry for uri
+    static bool AddFromEntry(dmHttpCache::HCache cache, const char* src_uri, const char* uri, const char* etag)
+    {
+        FILE* file;
+        uint64_t checksum;
+        if (dmHttpCache::Get(cache, src_uri, etag, &file, &checksum) != dmHttpCache::RESULT_OK)
+        {
+            return false;
+        }
+
+        dmHttpCache::HCacheCreator cache_creator;
+        dmHttpCache::Result r = dmHttpCache::Begin(cache, uri, etag, 0, &cache_creator);
+        if (r == dmHttpCache::RESULT_OK)
+        {
+            char buffer[4096];
+            size_t n;
+            while (r == dmHttpCache::RESULT_OK && (n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                r = dmHttpCache::Add(cache, cache_creator, buffer, (uint32_t) n);
+            }
+            dmHttpCache::Result end_r = dmHttpCache::End(cache, cache_creator);
+            if (r == dmHttpCache::RESULT_OK)
+            {
+                r = end_r;
+            }
+        }
+        dmHttpCache::Release(cache, src_uri, etag, file);
+        return r == dmHttpCache::RESULT_OK;
+    }
+
+    Result ApplyContentManifest(dmHttpCache::HCache cache, const char* manifest, uint32_t manifest_size, uint32_t* verified_count, uint32_t* added_count)
+    {
+        *verified_count = 0;
+        *added_count = 0;
+
+        // The uri strings are owned by the cache and stay valid while it is open
+        ContentTable content;
+        uint32_t capacity = dmHttpCache::GetEntryCount(cache) + 1;
+        content.SetCapacity(dmMath::Max(1U, 2 * capacity / 3), capacity);
+        dmHttpCache::Iterate(cache, &content, &CollectContentCallback);
+
+        char line[dmHttpCache::MAX_URI_LEN + dmHttpCache::MAX_TAG_LEN + 1];
+        const char* current = manifest;
+        const char* end = manifest + manifest_size;
+        while (current < end)
+        {
+            const char* line_end = (const char*) memchr(current, '\n', end - current);
+            if (line_end == 0)
+            {
+                line_end = end;
+            }
+            uint32_t line_len = (uint32_t) (line_end - current);
+            const char* line_start = current;
+            current = line_end + 1;
+
+            if (line_len >= sizeof(line))
+            {
+                dmLogError("Http cache manifest entry too long");
+                continue;
+            }
+            memcpy(line, line_start, line_len);
+            line[line_len] = '\0';
+
+            char* separator = strrchr(line, ' ');
+            if (separator == 0 || separator == line || separator[1] == '\0')
+            {
+                continue;
+            }
+            *separator = '\0';
+            const char* uri = line;
+            const char* etag = separator + 1;
+
+            dmHttpCache::EntryInfo info;
+            if (dmHttpCache::GetInfo(cache, uri, &info) == dmHttpCache::RESULT_OK && strcmp(info.m_ETag, etag) == 0)
+            {
+                dmHttpCache::SetVerified(cache, uri, true);
+                ++*verified_count;
+                continue;
+            }
+
+            const char** src_uri = content.Get(dmHashString64(etag));
+            if (src_uri && strcmp(*src_uri, uri) != 0 && AddFromEntry(cache, *src_uri, uri, etag))
+            {
+                dmHttpCache::SetVerified(cache, uri, true);
+                ++*verified_count;
+                ++*added_count;
+            }
+        }
+        return RESULT_OK;
+    }
 }
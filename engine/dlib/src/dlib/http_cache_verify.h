@@ -53,6 +53,41 @@ namespace dmHttpCacheVerify
      * @return RESULT_OK on success
      */
     Result VerifyCache(dmHttpCache::HCache cache, dmURI::Parts* uri, uint64_t max_age);
+
+    /**
+     * Verify HTTP-cache using a manifest of the server content, fetched with a single get request to /__content_hashes__
+     * <pre>
+     * Response format:
+     * URI <SPACE> ETAG'\n'
+     * URI <SPACE> ETAG'\n'
+     * ...
+     * </pre>
+     *
+     * The manifest lists the current ETag of every resource on the server, see ApplyContentManifest.
+     *
+     * @param cache cache handle
+     * @param uri uri
+     * @return RESULT_OK on success, RESULT_UNSUPPORTED if the server doesn't provide a manifest
+     */
+    Result VerifyCacheContent(dmHttpCache::HCache cache, dmURI::Parts* uri);
+
+    /**
+     * Verify HTTP-cache entries against a manifest, see VerifyCacheContent. The ETags must be
+     * hashes of the content, i.e. they are the same for identical resources.
+     *
+     * Cached entries with the listed ETag are verified. Listed resources that aren't cached,
+     * but have the same ETag as another cached entry, e.g. copied or moved files, are added from
+     * that entry and verified. Neither needs a network round-trip when the policy is
+     * dmHttpCache::CONSISTENCY_POLICY_TRUST_CACHE.
+     *
+     * @param cache cache handle
+     * @param manifest manifest data, not null terminated
+     * @param manifest_size size of the manifest data
+     * @param verified_count number of verified entries, including added entries (out)
+     * @param added_count number of added entries (out)
+     * @return RESULT_OK on success
+     */
+    Result ApplyContentManifest(dmHttpCache::HCache cache, const char* manifest, uint32_t manifest_size, uint32_t* verified_count, uint32_t* added_count);
 }
 
 #endif
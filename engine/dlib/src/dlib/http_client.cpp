@@ -27,6 +27,7 @@
 #include "path.h"
 #include "time.h"
 #include "connection_pool.h"
+#include "zlib.h"
 #include <dlib/mutex.h>
 #include <dlib/socket.h>
 #include <dlib/sslsocket.h>
@@ -121,6 +122,9 @@ namespace dmHttpClient
         // Cache
         dmHttpCache::HCacheCreator m_CacheCreator;
 
+        // Set when the content is gzip or deflate encoded and the client decodes content
+        dmZlib::HInflater m_Inflater;
+
         // Connection
         dmConnectionPool::HPool         m_Pool;
         dmConnectionPool::HConnection   m_Connection;
@@ -141,6 +145,7 @@ namespace dmHttpClient
             m_CloseConnection = 0;
             m_MaxAge = 0;
             m_CacheCreator = 0;
+            m_Inflater = 0;
             m_Pool = 0;
             m_Connection = 0;
             m_Socket = 0;
@@ -183,6 +188,7 @@ namespace dmHttpClient
         bool                m_Secure;
         uint16_t            m_Port;
         uint16_t            m_IgnoreCache:1;
+        uint16_t            m_DecodeContent:1;
         int*                m_CancelFlag;
 
         // Used both for reading header and content. NOTE: Extra byte for null-termination
@@ -210,6 +216,9 @@ namespace dmHttpClient
 
     Response::~Response()
     {
+        if (m_Inflater) {
+            dmZlib::DeleteInflater(m_Inflater);
+        }
         if (m_Connection) {
             if (m_CloseConnection || m_Client->m_SocketResult != dmSocket::RESULT_OK) {
                 dmConnectionPool::Close(m_Pool, m_Connection);
@@ -238,6 +247,7 @@ namespace dmHttpClient
         params->m_HttpCache = 0;
         params->m_MaxGetRetries = 1;
         params->m_RequestTimeout = 0;
+        params->m_DecodeContent = 0;
     }
 
     HClient New(const NewParams* params, const char* hostname, uint16_t port, bool secure, int* cancelflag)
@@ -267,6 +277,7 @@ namespace dmHttpClient
         client->m_Secure = secure;
         client->m_Port = port;
         client->m_IgnoreCache = params->m_HttpCache != 0 ? 0 : 1;
+        client->m_DecodeContent = params->m_DecodeContent;
         client->m_CancelFlag = cancelflag;
 
         return client;
@@ -386,6 +397,12 @@ namespace dmHttpClient
         {
             resp->m_Chunked = 1;
         }
+        else if (dmStrCaseCmp(key, "Content-Encoding") == 0 && resp->m_Client->m_DecodeContent && resp->m_Inflater == 0 &&
+                 (dmStrCaseCmp(value, "gzip") == 0 || dmStrCaseCmp(value, "deflate") == 0))
+        {
+            // Both formats are auto-detected by the inflater
+            resp->m_Inflater = dmZlib::NewInflater();
+        }
         else if (dmStrCaseCmp(key, "Connection") == 0 && dmStrCaseCmp(value, "close") == 0)
         {
             resp->m_CloseConnection = 1;
@@ -555,6 +572,10 @@ if (sock_res != dmSocket::RESULT_OK)\
                 goto bail;
             }
         }
+        if (client->m_DecodeContent)
+        {
+            HTTP_CLIENT_SENDALL_AND_BAIL("Accept-Encoding: gzip, deflate\r\n");
+        }
         if (!client->m_IgnoreCache && client->m_HttpCache)
         {
             char etag[64];
@@ -630,6 +651,26 @@ bail:
         return client->m_SocketResult;
     }
 
+    struct DecodeContext
+    {
+        HClient     m_Client;
+        Response*   m_Response;
+        HttpContent m_HttpContent;
+    };
+
+    static bool DecodedContentWriter(void* context, const void* data, uint32_t data_len)
+    {
+        DecodeContext* ctx = (DecodeContext*) context;
+        HClient client = ctx->m_Client;
+        Response* response = ctx->m_Response;
+        ctx->m_HttpContent(response, client->m_Userdata, response->m_Status, data, data_len);
+        if (response->m_CacheCreator)
+        {
+            dmHttpCache::Add(client->m_HttpCache, response->m_CacheCreator, data, data_len);
+        }
+        return true;
+    }
+
     static Result DoTransfer(HClient client, Response* response, int to_transfer, HttpContent http_content, bool add_to_cache)
     {
         // to_transfer can be set to -1 when the "Content-Length" is unknown
@@ -644,11 +685,27 @@ bail:
             } else {
                 n = dmMath::Min(to_transfer - total_transferred, response->m_TotalReceived - response->m_ContentOffset);
             }
-            http_content(response, client->m_Userdata, response->m_Status, client->m_Buffer + response->m_ContentOffset, n);
-
-            if (response->m_CacheCreator && add_to_cache)
+            if (response->m_Inflater && add_to_cache)
             {
-                dmHttpCache::Add(client->m_HttpCache, response->m_CacheCreator, client->m_Buffer + response->m_ContentOffset, n);
+                // Encoded content is inflated chunk by chunk, and the decoded data is what gets cached
+                DecodeContext ctx = { client, response, http_content };
+                dmZlib::Result zr = dmZlib::Inflate(response->m_Inflater, client->m_Buffer + response->m_ContentOffset, n, &ctx, DecodedContentWriter);
+                if (zr != dmZlib::RESULT_OK && zr != dmZlib::RESULT_STREAM_END)
+                {
+                    dmLogError("Failed to decode content (%d)", zr);
+                    response->m_CloseConnection = 1;
+                    response->m_TotalReceived = 0;
+                    return RESULT_INVALID_RESPONSE;
+                }
+            }
+            else
+            {
+                http_content(response, client->m_Userdata, response->m_Status, client->m_Buffer + response->m_ContentOffset, n);
+
+                if (response->m_CacheCreator && add_to_cache)
+                {
+                    dmHttpCache::Add(client->m_HttpCache, response->m_CacheCreator, client->m_Buffer + response->m_ContentOffset, n);
+                }
             }
 
             total_transferred += n;
@@ -146,6 +146,10 @@ namespace dmHttpClient
         /// Request timeout in us
         int m_RequestTimeout;
 
+        /// Send "Accept-Encoding: gzip, deflate" and inflate compressed responses as they arrive,
+        /// so that the content callback and the http-cache only see decoded data. Default 0
+        uint8_t m_DecodeContent : 1;
+
         NewParams()
         {
             SetDefaultParams(this);
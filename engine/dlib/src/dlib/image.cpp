@@ -31,21 +31,62 @@
 #define STBI_NO_THREAD_LOCALS
 #include "../stb/stb_image.h"
 
+// Premultiplication is done with SSE2 or NEON when the target always has it, otherwise plain C
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_IMAGE_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define DM_IMAGE_NEON
+    #include <arm_neon.h>
+#endif
+
 namespace dmImage
 {
     void Premultiply(uint8_t* buffer, int width, int height)
     {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                int index = (y * width + x) * 4;
-                uint32_t a = buffer[index + 3];
-                uint32_t r = (buffer[index + 0] * a + 255) >> 8;
-                uint32_t g = (buffer[index + 1] * a + 255) >> 8;
-                uint32_t b = (buffer[index + 2] * a + 255) >> 8;
-                buffer[index + 0] = r;
-                buffer[index + 1] = g;
-                buffer[index + 2] = b;
-            }
+        uint32_t count = (uint32_t) (width * height);
+        uint32_t i = 0;
+
+#if defined(DM_IMAGE_SSE2)
+        // Four pixels at a time. The alpha of each pixel is broadcast to its four 16-bit lanes
+        // and the original alpha is blended back in after the multiplication.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(255);
+        const __m128i alpha_mask = _mm_set1_epi32((int) 0xff000000);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i* p = (__m128i*) (buffer + i * 4);
+            __m128i v = _mm_loadu_si128(p);
+            __m128i lo = _mm_unpacklo_epi8(v, zero);
+            __m128i hi = _mm_unpackhi_epi8(v, zero);
+            __m128i alpha_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            __m128i alpha_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, alpha_lo), bias), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, alpha_hi), bias), 8);
+            __m128i r = _mm_packus_epi16(lo, hi);
+            _mm_storeu_si128(p, _mm_or_si128(_mm_andnot_si128(alpha_mask, r), _mm_and_si128(alpha_mask, v)));
+        }
+#elif defined(DM_IMAGE_NEON)
+        // Eight pixels at a time, deinterleaved into one register per channel
+        const uint16x8_t bias = vdupq_n_u16(255);
+        for (; i + 8 <= count; i += 8)
+        {
+            uint8_t* p = buffer + i * 4;
+            uint8x8x4_t v = vld4_u8(p);
+            v.val[0] = vshrn_n_u16(vaddq_u16(vmull_u8(v.val[0], v.val[3]), bias), 8);
+            v.val[1] = vshrn_n_u16(vaddq_u16(vmull_u8(v.val[1], v.val[3]), bias), 8);
+            v.val[2] = vshrn_n_u16(vaddq_u16(vmull_u8(v.val[2], v.val[3]), bias), 8);
+            vst4_u8(p, v);
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            uint8_t* p = buffer + i * 4;
+            uint32_t a = p[3];
+            p[0] = (uint8_t) ((p[0] * a + 255) >> 8);
+            p[1] = (uint8_t) ((p[1] * a + 255) >> 8);
+            p[2] = (uint8_t) ((p[2] * a + 255) >> 8);
         }
     }
 
@@ -64,9 +105,11 @@ namespace dmImage
                 i.m_Type = TYPE_LUMINANCE;
                 break;
             case 2:
-                // Luminance + alpha. Convert to luminance
+                // Luminance + alpha. Convert to luminance in place, the buffer is only shrunk
                 i.m_Type = TYPE_LUMINANCE;
-                ret = stbi__convert_format(ret, 2, 1, x, y);
+                for (int p = 0; p < x * y; ++p) {
+                    ret[p] = ret[p * 2];
+                }
                 break;
             case 3:
                 i.m_Type = TYPE_RGB;
@@ -58,6 +58,16 @@ namespace dmImage
      */
     Result Load(const void* buffer, uint32_t buffer_size, bool premult, Image* image);
 
+    /**
+     * Premultiply the color channels of an RGBA image with the alpha channel, in place.
+     * Uses SSE2 or NEON when available.
+     *
+     * @param buffer RGBA pixels, 4 bytes per pixel
+     * @param width image width
+     * @param height image height
+     */
+    void Premultiply(uint8_t* buffer, int width, int height);
+
     /**
      * Free loaded image
      * @param image image to free
@@ -0,0 +1,526 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_INTERNTABLE_H
+#define DM_INTERNTABLE_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "align.h"
+#include "atomic.h"
+#include "mutex.h"
+#include "time.h"
+
+/**
+ * Concurrent table of strings keyed by their hash, used for string interning.
+ *
+ * Get() and Put() are lock free. The table is open addressed and each slot is claimed once, with a
+ * compare-and-swap on the key, after which the string is published with a compare-and-swap on the value.
+ * When the table fills up it's copied to a larger table. The old slots are closed while they are copied,
+ * and threads that find a closed slot continue in the new table once it's published.
+ * Old tables are kept until Clear(), so a concurrent reader never touches freed memory.
+ *
+ * Strings are stored null terminated in pages that are bump allocated with an atomic add.
+ * Erased strings are recycled by later strings of the same size.
+ *
+ * Growing, allocating new pages and Erase() take a mutex. Clear() must not be called concurrently
+ * with the other functions.
+ *
+ * The key type must be uint32_t or uint64_t.
+ */
+template <typename KEY>
+class dmInternTable
+{
+public:
+    dmInternTable()
+    {
+        m_Mutex = dmMutex::New();
+        m_Table = 0;
+        m_Page = 0;
+        memset((void*) m_Reserved, 0, sizeof(m_Reserved));
+        memset((void*) m_FreeBlocks, 0, sizeof(m_FreeBlocks));
+    }
+
+    ~dmInternTable()
+    {
+        Clear();
+        dmMutex::Delete(m_Mutex);
+    }
+
+    /**
+     * Remove all strings and free all memory. Not thread safe.
+     */
+    void Clear()
+    {
+        Table* table = (Table*) m_Table;
+        while (table)
+        {
+            Table* prev = table->m_Prev;
+            free(table);
+            table = prev;
+        }
+        Page* page = (Page*) m_Page;
+        while (page)
+        {
+            Page* next = page->m_Next;
+            free(page);
+            page = next;
+        }
+        m_Table = 0;
+        m_Page = 0;
+        memset((void*) m_Reserved, 0, sizeof(m_Reserved));
+        memset((void*) m_FreeBlocks, 0, sizeof(m_FreeBlocks));
+    }
+
+    /**
+     * Get a string
+     * @param hash Hash of the string
+     * @param length Set to the length of the string, if not null
+     * @return Null terminated string, 0 if not found
+     */
+    const char* Get(KEY hash, uint32_t* length)
+    {
+        const char* value;
+        if (hash < RESERVED_KEY_COUNT)
+        {
+            value = m_Reserved[hash].m_Value;
+        }
+        else
+        {
+            Table* table = (Table*) m_Table;
+            Slot* slot = table ? Find(&table, hash) : 0;
+            value = slot ? slot->m_Value : 0;
+        }
+        if (!IsString(value))
+            return 0;
+        if (length)
+            *length = GetBlock(value)->m_Length;
+        return value;
+    }
+
+    /**
+     * Add a string, unless a string with the same hash already exists
+     * @param hash Hash of the string
+     * @param string String, doesn't have to be null terminated
+     * @param length Length of the string
+     * @return The stored string
+     */
+    const char* Put(KEY hash, const void* string, uint32_t length)
+    {
+        char* copy = 0;
+        const char* value;
+        if (hash < RESERVED_KEY_COUNT)
+        {
+            value = Publish(&m_Reserved[hash], true, string, length, &copy);
+        }
+        else
+        {
+            Table* table = GetTable();
+            for (;;)
+            {
+                Slot* slot;
+                bool claimed;
+                if (Claim(table, hash, &slot, &claimed))
+                {
+                    value = Publish(slot, claimed, string, length, &copy);
+                    if (value != VALUE_MOVED)
+                        break;
+                }
+                table = WaitForGrow(table);
+            }
+        }
+        if (copy && copy != value)
+            FreeString(copy);
+        return value;
+    }
+
+    /**
+     * Erase a string. The memory of the string is reused by later strings.
+     * @param hash Hash of the string
+     */
+    void Erase(KEY hash)
+    {
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        Slot* slot = 0;
+        if (hash < RESERVED_KEY_COUNT)
+        {
+            slot = &m_Reserved[hash];
+        }
+        else if (m_Table)
+        {
+            // No table is growing while we hold the lock
+            Table* table = (Table*) m_Table;
+            slot = Find(&table, hash);
+        }
+        if (slot && IsString(slot->m_Value))
+        {
+            // Only Erase replaces a published string, so the value can't change under us
+            char* value = (char*) slot->m_Value;
+            dmAtomicStorePtr((void* volatile*) &slot->m_Value, (void*) VALUE_TOMBSTONE);
+            PushFreeBlock(GetBlock(value));
+        }
+    }
+
+private:
+    // Slot keys. The strings with these hashes are stored outside the table
+    static const KEY KEY_EMPTY = 0;
+    static const KEY KEY_MOVED = 1;
+    static const uint32_t RESERVED_KEY_COUNT = 2;
+
+    // Slot values that aren't strings
+    static const char* const VALUE_PENDING;
+    static const char* const VALUE_TOMBSTONE;
+    static const char* const VALUE_MOVED;
+
+    static const uint32_t INITIAL_CAPACITY = 1024;
+    static const uint32_t PAGE_SIZE = 16 * 1024;
+    // Block sizes are rounded up to keep the number of free block classes down
+    static const uint32_t BLOCK_ALIGNMENT = 16;
+    static const uint32_t FREE_BLOCK_CLASS_COUNT = 64;
+
+    struct Slot
+    {
+        volatile KEY         m_Key;
+        const char* volatile m_Value;
+    };
+
+    struct Table
+    {
+        Table*          m_Prev;
+        uint32_t        m_Capacity;
+        int32_atomic_t  m_Count;
+        Slot            m_Slots[1];
+    };
+
+    struct Page
+    {
+        Page*           m_Next;
+        uint32_t        m_Capacity;
+        int32_atomic_t  m_Used;
+        // Followed by the blocks
+    };
+
+    // Header of a stored string, followed by the characters
+    struct Block
+    {
+        union
+        {
+            uint32_t    m_Length;
+            Block*      m_NextFree;
+        };
+        uint32_t        m_Size;
+    };
+
+    static inline bool IsString(const char* value)
+    {
+        return (uintptr_t) value > (uintptr_t) VALUE_MOVED;
+    }
+
+    static inline Block* GetBlock(const char* value)
+    {
+        return (Block*) value - 1;
+    }
+
+    static inline uint32_t GetIndex(uint32_t hash)
+    {
+        return hash;
+    }
+
+    static inline uint32_t GetIndex(uint64_t hash)
+    {
+        return (uint32_t) (hash ^ (hash >> 32));
+    }
+
+    static inline uint32_t CompareStoreKey(volatile uint32_t* key, uint32_t value, uint32_t comparand)
+    {
+        return (uint32_t) dmAtomicCompareStore32((int32_atomic_t*) key, (int32_t) value, (int32_t) comparand);
+    }
+
+    static inline uint64_t CompareStoreKey(volatile uint64_t* key, uint64_t value, uint64_t comparand)
+    {
+        return (uint64_t) dmAtomicCompareStore64((int64_atomic_t*) key, (int64_t) value, (int64_t) comparand);
+    }
+
+    static inline const char* CompareStoreValue(const char* volatile* value, const char* new_value, const char* comparand)
+    {
+        return (const char*) dmAtomicCompareStorePtr((void* volatile*) value, (void*) new_value, (void*) comparand);
+    }
+
+    static Table* NewTable(uint32_t capacity)
+    {
+        size_t size = sizeof(Table) + (capacity - 1) * sizeof(Slot);
+        Table* table = (Table*) malloc(size);
+        memset(table, 0, size);
+        table->m_Capacity = capacity;
+        return table;
+    }
+
+    Table* GetTable()
+    {
+        Table* table = (Table*) m_Table;
+        if (!table)
+        {
+            Table* new_table = NewTable(INITIAL_CAPACITY);
+            table = (Table*) dmAtomicCompareStorePtr((void* volatile*) &m_Table, new_table, 0);
+            if (table)
+                free(new_table);
+            else
+                table = new_table;
+        }
+        return table;
+    }
+
+    /*
+     * Find the slot of a key. Continues in the newer table if the slots are being moved,
+     * in which case *table is updated.
+     */
+    Slot* Find(Table** table, KEY hash)
+    {
+        Table* t = *table;
+        for (;;)
+        {
+            uint32_t mask = t->m_Capacity - 1;
+            uint32_t index = GetIndex(hash) & mask;
+            bool moved = false;
+            for (uint32_t i = 0; i < t->m_Capacity; ++i)
+            {
+                Slot* slot = &t->m_Slots[index];
+                KEY key = slot->m_Key;
+                if (key == KEY_EMPTY)
+                    return 0;
+                if (key == hash)
+                {
+                    if (slot->m_Value != VALUE_MOVED)
+                    {
+                        *table = t;
+                        return slot;
+                    }
+                    moved = true;
+                    break;
+                }
+                if (key == KEY_MOVED)
+                {
+                    moved = true;
+                    break;
+                }
+                index = (index + 1) & mask;
+            }
+            if (!moved)
+                return 0;
+            t = WaitForGrow(t);
+        }
+    }
+
+    /*
+     * Find or claim the slot of a key.
+     * Returns false if the table is being moved and the key should be claimed in the new table.
+     */
+    bool Claim(Table* table, KEY hash, Slot** out_slot, bool* out_claimed)
+    {
+        uint32_t mask = table->m_Capacity - 1;
+        uint32_t index = GetIndex(hash) & mask;
+        for (uint32_t i = 0; i < table->m_Capacity; ++i)
+        {
+            Slot* slot = &table->m_Slots[index];
+            KEY key = slot->m_Key;
+            bool claimed = false;
+            if (key == KEY_EMPTY)
+            {
+                key = CompareStoreKey(&slot->m_Key, hash, KEY_EMPTY);
+                if (key == KEY_EMPTY)
+                {
+                    key = hash;
+                    claimed = true;
+                    uint32_t count = (uint32_t) dmAtomicIncrement32(&table->m_Count) + 1;
+                    if (count > table->m_Capacity - table->m_Capacity / 4)
+                    {
+                        // The new slot is closed while growing, and is claimed again in the new table
+                        Grow(table);
+                    }
+                }
+            }
+            if (key == KEY_MOVED)
+                return false;
+            if (key == hash)
+            {
+                *out_slot = slot;
+                *out_claimed = claimed;
+                return true;
+            }
+            index = (index + 1) & mask;
+        }
+        // Full, the threads that filled it are growing it
+        return false;
+    }
+
+    /*
+     * Publish a string in a slot, unless the slot already holds one.
+     * Only the thread that claimed the slot may publish in a pending slot, the others wait for it.
+     * The string is copied to *copy once, and reused if the slot moves.
+     * Returns the string in the slot, or VALUE_MOVED if the slot was closed by a growing table.
+     */
+    const char* Publish(Slot* slot, bool claimed, const void* string, uint32_t length, char** copy)
+    {
+        for (;;)
+        {
+            const char* value = slot->m_Value;
+            if (IsString(value) || value == VALUE_MOVED)
+                return value;
+            if (value == VALUE_PENDING && !claimed)
+            {
+                dmTime::Sleep(0);
+                continue;
+            }
+            if (!*copy)
+                *copy = AllocString(string, length);
+            if (CompareStoreValue(&slot->m_Value, *copy, value) == value)
+                return *copy;
+        }
+    }
+
+    Table* WaitForGrow(Table* table)
+    {
+        // The table is moved while the lock is held, and the new table is published before it's released
+        Grow(table);
+        return (Table*) m_Table;
+    }
+
+    void Grow(Table* table)
+    {
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        if (m_Table != table)
+            return;
+
+        uint32_t live = 0;
+        for (uint32_t i = 0; i < table->m_Capacity; ++i)
+        {
+            live += IsString(table->m_Slots[i].m_Value) ? 1 : 0;
+        }
+        // Erased slots aren't moved, so a table full of erased strings is copied to one of the same size
+        uint32_t capacity = INITIAL_CAPACITY;
+        while (capacity < live * 2 + table->m_Capacity / 4)
+            capacity *= 2;
+
+        Table* new_table = NewTable(capacity);
+        uint32_t mask = capacity - 1;
+        for (uint32_t i = 0; i < table->m_Capacity; ++i)
+        {
+            Slot* slot = &table->m_Slots[i];
+            if (slot->m_Key == KEY_EMPTY && CompareStoreKey(&slot->m_Key, KEY_MOVED, KEY_EMPTY) == KEY_EMPTY)
+                continue;
+
+            // Close pending and erased slots. A published string never changes while we hold the lock
+            const char* value = slot->m_Value;
+            while (!IsString(value))
+            {
+                const char* prev = CompareStoreValue(&slot->m_Value, VALUE_MOVED, value);
+                if (prev == value)
+                    break;
+                value = prev;
+            }
+            if (!IsString(value))
+                continue;
+
+            // The new table isn't visible to other threads yet
+            uint32_t index = GetIndex(slot->m_Key) & mask;
+            while (new_table->m_Slots[index].m_Key != KEY_EMPTY)
+                index = (index + 1) & mask;
+            new_table->m_Slots[index].m_Key = slot->m_Key;
+            new_table->m_Slots[index].m_Value = value;
+            new_table->m_Count++;
+        }
+
+        new_table->m_Prev = table;
+        dmAtomicStorePtr((void* volatile*) &m_Table, new_table);
+    }
+
+    char* AllocString(const void* string, uint32_t length)
+    {
+        uint32_t size = DM_ALIGN(sizeof(Block) + length + 1, BLOCK_ALIGNMENT);
+        Block* block = PopFreeBlock(size);
+        if (!block)
+            block = AllocBlock(size);
+        block->m_Length = length;
+        block->m_Size = size;
+        char* s = (char*) (block + 1);
+        memcpy(s, string, length);
+        s[length] = '\0';
+        return s;
+    }
+
+    void FreeString(char* string)
+    {
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        PushFreeBlock(GetBlock(string));
+    }
+
+    Block* AllocBlock(uint32_t size)
+    {
+        for (;;)
+        {
+            Page* page = (Page*) m_Page;
+            if (page)
+            {
+                uint32_t offset = (uint32_t) dmAtomicAdd32(&page->m_Used, (int32_t) size);
+                if (offset + size <= page->m_Capacity)
+                    return (Block*) ((uint8_t*) (page + 1) + offset);
+            }
+
+            DM_MUTEX_SCOPED_LOCK(m_Mutex);
+            if (m_Page == page)
+            {
+                uint32_t capacity = size > PAGE_SIZE ? size : PAGE_SIZE;
+                Page* new_page = (Page*) malloc(sizeof(Page) + capacity);
+                new_page->m_Next = page;
+                new_page->m_Capacity = capacity;
+                new_page->m_Used = 0;
+                dmAtomicStorePtr((void* volatile*) &m_Page, new_page);
+            }
+        }
+    }
+
+    // Must be called with the lock held
+    void PushFreeBlock(Block* block)
+    {
+        uint32_t block_class = block->m_Size / BLOCK_ALIGNMENT;
+        if (block_class >= FREE_BLOCK_CLASS_COUNT)
+            return; // Larger strings are rare, and are freed by Clear()
+        block->m_NextFree = m_FreeBlocks[block_class];
+        m_FreeBlocks[block_class] = block;
+    }
+
+    Block* PopFreeBlock(uint32_t size)
+    {
+        uint32_t block_class = size / BLOCK_ALIGNMENT;
+        if (block_class >= FREE_BLOCK_CLASS_COUNT || !m_FreeBlocks[block_class])
+            return 0;
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        Block* block = m_FreeBlocks[block_class];
+        if (block)
+            m_FreeBlocks[block_class] = block->m_NextFree;
+        return block;
+    }
+
+    dmMutex::HMutex     m_Mutex;
+    Table* volatile     m_Table;
+    Page* volatile      m_Page;
+    Slot                m_Reserved[RESERVED_KEY_COUNT];
+    Block* volatile     m_FreeBlocks[FREE_BLOCK_CLASS_COUNT];
+};
+
+template <typename KEY> const char* const dmInternTable<KEY>::VALUE_PENDING = (const char*) 0;
+template <typename KEY> const char* const dmInternTable<KEY>::VALUE_TOMBSTONE = (const char*) 1;
+template <typename KEY> const char* const dmInternTable<KEY>::VALUE_MOVED = (const char*) 2;
+
+#endif // DM_INTERNTABLE_H
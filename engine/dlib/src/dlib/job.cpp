@@ -0,0 +1,589 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include "safe_windows.h"
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__EMSCRIPTEN_PTHREADS__)
+#include <emscripten/threading.h>
+#endif
+
+#include "job.h"
+#include "array.h"
+#include "atomic.h"
+#include "condition_variable.h"
+#include "log.h"
+#include "math.h"
+#include "mutex.h"
+#include "profile.h"
+#include "spinlocktypes.h"
+#include "thread.h"
+#include "time.h"
+
+namespace dmJob
+{
+    static const uint32_t MAX_JOBS          = 0xffff;
+    static const uint32_t MAX_CONTINUATIONS = 8;
+    static const uint16_t INVALID_INDEX     = 0xffff;
+
+    struct Job
+    {
+        JobFunc         m_Func;
+        RangeFunc       m_RangeFunc;
+        void*           m_Context;
+        void*           m_Data;
+        uint32_t        m_Start;
+        uint32_t        m_End;
+        HJob            m_Parent;
+        /// One for the job itself plus one per unfinished child
+        int32_atomic_t  m_Unfinished;
+        /// One until Run() is called plus one per unfinished dependency
+        int32_atomic_t  m_Pending;
+        dmSpinlock::lock_t m_Lock;
+        uint16_t        m_Continuations[MAX_CONTINUATIONS];
+        uint16_t        m_ContinuationCount;
+        /// Bumped when the job is freed, stale handles are treated as finished
+        int32_atomic_t  m_Version;
+        uint16_t        m_Finished : 1;
+        uint16_t        m_Started : 1;
+    };
+
+    /// Ring buffer of job indices. The owning thread pushes and pops at the bottom,
+    /// other threads steal from the top.
+    struct Queue
+    {
+        dmSpinlock::lock_t  m_Lock;
+        uint16_t*           m_Jobs;
+        uint32_t            m_Mask;
+        uint32_t            m_Top;
+        uint32_t            m_Bottom;
+    };
+
+    struct Worker
+    {
+        HContext            m_Context;
+        uint32_t            m_Index;
+        dmThread::Thread    m_Thread;
+    };
+
+    struct Context
+    {
+        dmArray<Job>            m_Jobs;
+        dmArray<uint16_t>       m_FreeJobs;
+        dmSpinlock::lock_t      m_FreeJobsLock;
+        dmArray<Queue>          m_Queues;
+        dmArray<Worker>         m_Workers;
+        dmThread::TlsKey        m_ThreadIndexKey;
+        dmMutex::HMutex         m_Mutex;
+        dmConditionVariable::HConditionVariable m_WakeUp;
+        int32_atomic_t          m_QueuedCount;
+        int32_atomic_t          m_SleepingCount;
+        int32_atomic_t          m_Running;
+    };
+
+    NewContextParams::NewContextParams()
+    {
+        uint32_t core_count = GetCoreCount();
+        m_WorkerCount = core_count > 1 ? core_count - 1 : 0;
+        m_MaxJobs = 4096;
+        m_QueueCapacity = 2048;
+    }
+
+    uint32_t GetCoreCount()
+    {
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        ::GetSystemInfo(&info);
+        long count = (long) info.dwNumberOfProcessors;
+#elif defined(__EMSCRIPTEN_PTHREADS__)
+        // navigator.hardwareConcurrency
+        long count = emscripten_num_logical_cores();
+#elif defined(__EMSCRIPTEN__) || defined(__NX__)
+        long count = 1;
+#else
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        return count > 0 ? (uint32_t) count : 1;
+    }
+
+    static inline int32_t AtomicGet32(int32_atomic_t* ptr)
+    {
+        return dmAtomicAdd32(ptr, 0);
+    }
+
+    static inline HJob MakeHandle(uint16_t version, uint16_t index)
+    {
+        return ((uint32_t) version << 16) | index;
+    }
+
+    static inline uint16_t GetIndex(HJob job)
+    {
+        return (uint16_t) (job & 0xffff);
+    }
+
+    static inline Job* GetJob(HContext context, HJob job)
+    {
+        if (job == INVALID_JOB)
+            return 0;
+        uint16_t index = GetIndex(job);
+        if (index >= context->m_Jobs.Size())
+            return 0;
+        Job* j = &context->m_Jobs[index];
+        if (AtomicGet32(&j->m_Version) != (int32_t) (job >> 16))
+            return 0;
+        return j;
+    }
+
+    uint32_t GetThreadIndex(HContext context)
+    {
+        // Threads not owned by the context share the queue with the creating thread
+        uintptr_t value = (uintptr_t) dmThread::GetTlsValue(context->m_ThreadIndexKey);
+        return value != 0 ? (uint32_t) (value - 1) : 0;
+    }
+
+    static bool PushQueue(Queue* queue, uint16_t index)
+    {
+        dmSpinlock::Lock(&queue->m_Lock);
+        bool full = (queue->m_Bottom - queue->m_Top) > queue->m_Mask;
+        if (!full)
+        {
+            queue->m_Jobs[queue->m_Bottom & queue->m_Mask] = index;
+            queue->m_Bottom++;
+        }
+        dmSpinlock::Unlock(&queue->m_Lock);
+        return !full;
+    }
+
+    static uint16_t PopQueue(Queue* queue)
+    {
+        uint16_t index = INVALID_INDEX;
+        dmSpinlock::Lock(&queue->m_Lock);
+        if (queue->m_Bottom != queue->m_Top)
+        {
+            queue->m_Bottom--;
+            index = queue->m_Jobs[queue->m_Bottom & queue->m_Mask];
+        }
+        dmSpinlock::Unlock(&queue->m_Lock);
+        return index;
+    }
+
+    static uint16_t StealQueue(Queue* queue)
+    {
+        uint16_t index = INVALID_INDEX;
+        dmSpinlock::Lock(&queue->m_Lock);
+        if (queue->m_Bottom != queue->m_Top)
+        {
+            index = queue->m_Jobs[queue->m_Top & queue->m_Mask];
+            queue->m_Top++;
+        }
+        dmSpinlock::Unlock(&queue->m_Lock);
+        return index;
+    }
+
+    static uint16_t AcquireJob(HContext context, uint32_t thread_index)
+    {
+        if (AtomicGet32(&context->m_QueuedCount) == 0)
+            return INVALID_INDEX;
+
+        uint16_t index = PopQueue(&context->m_Queues[thread_index]);
+        const uint32_t queue_count = context->m_Queues.Size();
+        for (uint32_t i = 1; index == INVALID_INDEX && i < queue_count; ++i)
+        {
+            index = StealQueue(&context->m_Queues[(thread_index + i) % queue_count]);
+        }
+
+        if (index != INVALID_INDEX)
+            dmAtomicDecrement32(&context->m_QueuedCount);
+        return index;
+    }
+
+    static void ExecuteJob(HContext context, uint16_t index);
+
+    static void Schedule(HContext context, uint16_t index)
+    {
+        Queue* queue = &context->m_Queues[GetThreadIndex(context)];
+        if (!PushQueue(queue, index))
+        {
+            // The queue is full, keep going rather than dropping the job
+            ExecuteJob(context, index);
+            return;
+        }
+
+        dmAtomicIncrement32(&context->m_QueuedCount);
+        if (AtomicGet32(&context->m_SleepingCount) > 0)
+        {
+            DM_MUTEX_SCOPED_LOCK(context->m_Mutex);
+            dmConditionVariable::Signal(context->m_WakeUp);
+        }
+    }
+
+    static void FreeJob(HContext context, uint16_t index)
+    {
+        Job* job = &context->m_Jobs[index];
+        int32_t version = (AtomicGet32(&job->m_Version) + 1) & 0xffff;
+        if (version == 0xffff) // Never produce INVALID_JOB
+            version = 0;
+        dmAtomicStore32(&job->m_Version, version);
+
+        dmSpinlock::Lock(&context->m_FreeJobsLock);
+        context->m_FreeJobs.Push(index);
+        dmSpinlock::Unlock(&context->m_FreeJobsLock);
+    }
+
+    static void Release(HContext context, uint16_t index)
+    {
+        Job* job = &context->m_Jobs[index];
+        if (dmAtomicDecrement32(&job->m_Pending) == 1)
+        {
+            Schedule(context, index);
+        }
+    }
+
+    static void FinishJob(HContext context, uint16_t index)
+    {
+        Job* job = &context->m_Jobs[index];
+        if (dmAtomicDecrement32(&job->m_Unfinished) != 1)
+            return;
+
+        uint16_t continuations[MAX_CONTINUATIONS];
+        dmSpinlock::Lock(&job->m_Lock);
+        job->m_Finished = 1;
+        uint32_t continuation_count = job->m_ContinuationCount;
+        memcpy(continuations, job->m_Continuations, sizeof(uint16_t) * continuation_count);
+        dmSpinlock::Unlock(&job->m_Lock);
+
+        HJob parent = job->m_Parent;
+        FreeJob(context, index);
+
+        for (uint32_t i = 0; i < continuation_count; ++i)
+        {
+            Release(context, continuations[i]);
+        }
+
+        Job* parent_job = GetJob(context, parent);
+        if (parent_job)
+        {
+            FinishJob(context, GetIndex(parent));
+        }
+    }
+
+    static void ExecuteJob(HContext context, uint16_t index)
+    {
+        Job* job = &context->m_Jobs[index];
+        if (job->m_Func)
+        {
+            job->m_Func(job->m_Context, job->m_Data);
+        }
+        else if (job->m_RangeFunc)
+        {
+            job->m_RangeFunc(job->m_Context, job->m_Start, job->m_End);
+        }
+        FinishJob(context, index);
+    }
+
+    static void WorkerThread(void* arg)
+    {
+        Worker* worker = (Worker*) arg;
+        HContext context = worker->m_Context;
+        dmThread::SetTlsValue(context->m_ThreadIndexKey, (void*) (uintptr_t) (worker->m_Index + 1));
+
+        while (AtomicGet32(&context->m_Running))
+        {
+            uint16_t index = AcquireJob(context, worker->m_Index);
+            if (index != INVALID_INDEX)
+            {
+                ExecuteJob(context, index);
+                continue;
+            }
+
+            DM_MUTEX_SCOPED_LOCK(context->m_Mutex);
+            dmAtomicIncrement32(&context->m_SleepingCount);
+            while (AtomicGet32(&context->m_QueuedCount) == 0 && AtomicGet32(&context->m_Running))
+            {
+                dmConditionVariable::Wait(context->m_WakeUp, context->m_Mutex);
+            }
+            dmAtomicDecrement32(&context->m_SleepingCount);
+        }
+    }
+
+    HContext NewContext(const NewContextParams& params)
+    {
+        if (params.m_MaxJobs == 0 || params.m_MaxJobs > MAX_JOBS)
+        {
+            dmLogError("Invalid max job count %u (max %u)", params.m_MaxJobs, MAX_JOBS);
+            return 0;
+        }
+        if (params.m_QueueCapacity == 0 || (params.m_QueueCapacity & (params.m_QueueCapacity - 1)) != 0)
+        {
+            dmLogError("Job queue capacity %u must be a power of two", params.m_QueueCapacity);
+            return 0;
+        }
+
+        Context* context = new Context;
+        context->m_QueuedCount = 0;
+        context->m_SleepingCount = 0;
+        context->m_Running = 1;
+        context->m_Mutex = dmMutex::New();
+        context->m_WakeUp = dmConditionVariable::New();
+        context->m_ThreadIndexKey = dmThread::AllocTls();
+        dmSpinlock::Init(&context->m_FreeJobsLock);
+
+        context->m_Jobs.SetCapacity(params.m_MaxJobs);
+        context->m_Jobs.SetSize(params.m_MaxJobs);
+        context->m_FreeJobs.SetCapacity(params.m_MaxJobs);
+        for (uint32_t i = 0; i < params.m_MaxJobs; ++i)
+        {
+            Job* job = &context->m_Jobs[i];
+            memset(job, 0, sizeof(Job));
+            dmSpinlock::Init(&job->m_Lock);
+            // Hand out the low indices first
+            context->m_FreeJobs.Push((uint16_t) (params.m_MaxJobs - 1 - i));
+        }
+
+        const uint32_t queue_count = params.m_WorkerCount + 1;
+        context->m_Queues.SetCapacity(queue_count);
+        context->m_Queues.SetSize(queue_count);
+        for (uint32_t i = 0; i < queue_count; ++i)
+        {
+            Queue* queue = &context->m_Queues[i];
+            dmSpinlock::Init(&queue->m_Lock);
+            queue->m_Jobs = new uint16_t[params.m_QueueCapacity];
+            queue->m_Mask = params.m_QueueCapacity - 1;
+            queue->m_Top = 0;
+            queue->m_Bottom = 0;
+        }
+
+        // The creating thread is thread zero
+        dmThread::SetTlsValue(context->m_ThreadIndexKey, (void*) (uintptr_t) 1);
+
+        context->m_Workers.SetCapacity(params.m_WorkerCount);
+        context->m_Workers.SetSize(params.m_WorkerCount);
+        for (uint32_t i = 0; i < params.m_WorkerCount; ++i)
+        {
+            Worker* worker = &context->m_Workers[i];
+            worker->m_Context = context;
+            worker->m_Index = i + 1;
+            worker->m_Thread = dmThread::New(WorkerThread, 0x80000, worker, "job_worker");
+        }
+
+        return context;
+    }
+
+    void DeleteContext(HContext context)
+    {
+        {
+            DM_MUTEX_SCOPED_LOCK(context->m_Mutex);
+            dmAtomicStore32(&context->m_Running, 0);
+            dmConditionVariable::Broadcast(context->m_WakeUp);
+        }
+
+        for (uint32_t i = 0; i < context->m_Workers.Size(); ++i)
+        {
+            dmThread::Join(context->m_Workers[i].m_Thread);
+        }
+
+        for (uint32_t i = 0; i < context->m_Queues.Size(); ++i)
+        {
+            delete [] context->m_Queues[i].m_Jobs;
+        }
+
+        dmThread::SetTlsValue(context->m_ThreadIndexKey, 0);
+        dmThread::FreeTls(context->m_ThreadIndexKey);
+        dmConditionVariable::Delete(context->m_WakeUp);
+        dmMutex::Delete(context->m_Mutex);
+        delete context;
+    }
+
+    uint32_t GetWorkerCount(HContext context)
+    {
+        return context->m_Workers.Size();
+    }
+
+    static HJob AllocJob(HContext context, HJob parent)
+    {
+        dmSpinlock::Lock(&context->m_FreeJobsLock);
+        if (context->m_FreeJobs.Empty())
+        {
+            dmSpinlock::Unlock(&context->m_FreeJobsLock);
+            return INVALID_JOB;
+        }
+        uint16_t index = context->m_FreeJobs.Back();
+        context->m_FreeJobs.Pop();
+        dmSpinlock::Unlock(&context->m_FreeJobsLock);
+
+        Job* job = &context->m_Jobs[index];
+        job->m_Func = 0;
+        job->m_RangeFunc = 0;
+        job->m_Context = 0;
+        job->m_Data = 0;
+        job->m_Start = 0;
+        job->m_End = 0;
+        job->m_Parent = INVALID_JOB;
+        job->m_ContinuationCount = 0;
+        job->m_Finished = 0;
+        job->m_Started = 0;
+        dmAtomicStore32(&job->m_Pending, 1);
+        dmAtomicStore32(&job->m_Unfinished, 1);
+
+        Job* parent_job = GetJob(context, parent);
+        if (parent_job)
+        {
+            assert(AtomicGet32(&parent_job->m_Unfinished) > 0);
+            dmAtomicIncrement32(&parent_job->m_Unfinished);
+            job->m_Parent = parent;
+        }
+
+        return MakeHandle((uint16_t) job->m_Version, index);
+    }
+
+    HJob CreateJob(HContext context, JobFunc func, void* user_context, void* user_data, HJob parent)
+    {
+        HJob handle = AllocJob(context, parent);
+        if (handle == INVALID_JOB)
+            return INVALID_JOB;
+
+        Job* job = &context->m_Jobs[GetIndex(handle)];
+        job->m_Func = func;
+        job->m_Context = user_context;
+        job->m_Data = user_data;
+        return handle;
+    }
+
+    HJob CreateGroup(HContext context, HJob parent)
+    {
+        return AllocJob(context, parent);
+    }
+
+    Result AddDependency(HContext context, HJob job, HJob dependency)
+    {
+        Job* j = GetJob(context, job);
+        if (!j || j->m_Started)
+            return j ? RESULT_ALREADY_STARTED : RESULT_INVALID_PARAM;
+
+        Job* dep = GetJob(context, dependency);
+        if (!dep)
+            return RESULT_OK; // Already finished
+
+        Result result = RESULT_OK;
+        dmSpinlock::Lock(&dep->m_Lock);
+        if (AtomicGet32(&dep->m_Version) != (int32_t) (dependency >> 16) || dep->m_Finished)
+        {
+            // Finished while we were looking at it
+        }
+        else if (dep->m_ContinuationCount == MAX_CONTINUATIONS)
+        {
+            result = RESULT_OUT_OF_RESOURCES;
+        }
+        else
+        {
+            dep->m_Continuations[dep->m_ContinuationCount++] = GetIndex(job);
+            dmAtomicIncrement32(&j->m_Pending);
+        }
+        dmSpinlock::Unlock(&dep->m_Lock);
+        return result;
+    }
+
+    Result Run(HContext context, HJob job)
+    {
+        Job* j = GetJob(context, job);
+        if (!j)
+            return RESULT_INVALID_PARAM;
+        if (j->m_Started)
+            return RESULT_ALREADY_STARTED;
+        j->m_Started = 1;
+        Release(context, GetIndex(job));
+        return RESULT_OK;
+    }
+
+    bool IsFinished(HContext context, HJob job)
+    {
+        Job* j = GetJob(context, job);
+        return j == 0 || AtomicGet32(&j->m_Unfinished) == 0;
+    }
+
+    void Wait(HContext context, HJob job)
+    {
+        if (IsFinished(context, job))
+            return;
+
+        DM_PROFILE(Job, "Wait");
+        uint32_t thread_index = GetThreadIndex(context);
+        while (!IsFinished(context, job))
+        {
+            uint16_t index = AcquireJob(context, thread_index);
+            if (index != INVALID_INDEX)
+            {
+                ExecuteJob(context, index);
+            }
+            else
+            {
+                // Another thread is busy with the last of our jobs
+                dmTime::Sleep(0);
+            }
+        }
+    }
+
+    void Flush(HContext context)
+    {
+        uint32_t thread_index = GetThreadIndex(context);
+        uint16_t index;
+        while ((index = AcquireJob(context, thread_index)) != INVALID_INDEX)
+        {
+            ExecuteJob(context, index);
+        }
+    }
+
+    HJob ParallelFor(HContext context, RangeFunc func, void* user_context, uint32_t count, uint32_t min_batch_size, HJob parent)
+    {
+        if (count == 0)
+            return INVALID_JOB;
+
+        min_batch_size = dmMath::Max(1U, min_batch_size);
+        HJob group = context ? CreateGroup(context, parent) : INVALID_JOB;
+        if (group == INVALID_JOB)
+        {
+            func(user_context, 0, count);
+            return INVALID_JOB;
+        }
+
+        // A few batches per thread gives the stealing something to balance with
+        const uint32_t max_batches = (GetWorkerCount(context) + 1) * 4;
+        uint32_t batch_count = dmMath::Min(max_batches, (count + min_batch_size - 1) / min_batch_size);
+        uint32_t batch_size = (count + batch_count - 1) / batch_count;
+
+        for (uint32_t start = 0; start < count; start += batch_size)
+        {
+            uint32_t end = dmMath::Min(count, start + batch_size);
+            HJob batch = AllocJob(context, group);
+            if (batch == INVALID_JOB)
+            {
+                func(user_context, start, end);
+                continue;
+            }
+            Job* job = &context->m_Jobs[GetIndex(batch)];
+            job->m_RangeFunc = func;
+            job->m_Context = user_context;
+            job->m_Start = start;
+            job->m_End = end;
+            Run(context, batch);
+        }
+
+        Run(context, group);
+        return group;
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_JOB_H
+#define DM_JOB_H
+
+#include <dmsdk/dlib/job.h>
+
+/**
+ * Work-stealing job system.
+ *
+ * A context owns one worker thread per core (minus the calling thread) and one job queue
+ * per thread. Jobs pushed from a worker are put on the local queue, idle workers steal from
+ * the other queues. The thread that created the context is worker zero and takes part in the
+ * work when calling Wait().
+ *
+ * Jobs can be grouped by creating them with a parent. A job is not finished until all its
+ * children are finished, which makes it possible to use the parent as a counter that is waited on.
+ * Ordering between jobs is expressed with AddDependency().
+ *
+ * When the context is created with zero worker threads, all jobs are executed by the thread calling Wait().
+ */
+namespace dmJob
+{
+    /**
+     * Context creation parameters
+     */
+    struct NewContextParams
+    {
+        /// Number of worker threads. Default is the number of cores minus one, 0 runs all jobs on the waiting thread.
+        uint32_t m_WorkerCount;
+        /// Maximum number of jobs alive at the same time. Max is 65535
+        uint32_t m_MaxJobs;
+        /// Capacity of each thread queue, must be a power of two
+        uint32_t m_QueueCapacity;
+
+        NewContextParams();
+    };
+
+    /**
+     * Create a new job context and start the worker threads
+     * @param params parameters
+     * @return job context, 0 on failure
+     */
+    HContext NewContext(const NewContextParams& params);
+
+    /**
+     * Stop the worker threads and delete the job context.
+     * @note All jobs should be waited for before deleting the context
+     * @param context job context
+     */
+    void DeleteContext(HContext context);
+
+    /**
+     * Get the index of the calling thread within the context. The thread that created the context is 0
+     * and the worker threads are 1 to GetWorkerCount(). Threads not owned by the context also get 0.
+     * @param context job context
+     * @return thread index
+     */
+    uint32_t GetThreadIndex(HContext context);
+
+    /**
+     * Get the number of cores available to the process
+     * @return number of cores, at least 1
+     */
+    uint32_t GetCoreCount();
+
+    /**
+     * Execute queued jobs until the job queues are empty.
+     * @param context job context
+     */
+    void Flush(HContext context);
+}
+
+#endif // DM_JOB_H
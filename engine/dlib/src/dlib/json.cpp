@@ -198,8 +198,8 @@ namespace dmJson
 
         memset(doc, 0, sizeof(Document));
         jsmn_parser parser;
-        // NOTE: count may be increased in do-while, at a higher cost because of extra malloc/free and parsing
-        // Tested wth a +1mb json to achieve a single iteration in the while loop below
+        // NOTE: The token array is grown if the initial estimate is too small. jsmn leaves the parser
+        // at the start of the token that didn't fit, so parsing resumes from there instead of restarting.
         unsigned int token_count = dmMath::Max(64U, buffer_length/8);
 
         if(!buffer)
@@ -209,15 +209,15 @@ namespace dmJson
             return RESULT_OK;
         }
 
-        jsmnerr_t err = (jsmnerr_t) 0;
-        jsmntok_t* tokens = 0;
-        do {
-            jsmn_init(&parser);
-            token_count += dmMath::Min(256U, token_count);
-            free(tokens);
-            tokens = (jsmntok_t*) malloc(sizeof(jsmntok_t) * token_count);
+        jsmn_init(&parser);
+        jsmntok_t* tokens = (jsmntok_t*) malloc(sizeof(jsmntok_t) * token_count);
+        jsmnerr_t err = jsmn_parse(&parser, buffer, buffer_length, tokens, token_count);
+        while (err == JSMN_ERROR_NOMEM)
+        {
+            token_count *= 2;
+            tokens = (jsmntok_t*) realloc(tokens, sizeof(jsmntok_t) * token_count);
             err = jsmn_parse(&parser, buffer, buffer_length, tokens, token_count);
-        } while (err == JSMN_ERROR_NOMEM);
+        }
 
         if (err >= 0)
         {
@@ -225,7 +225,9 @@ namespace dmJson
             {
                 doc->m_Nodes = (Node*) malloc(sizeof(Node) * parser.toknext);
                 doc->m_NodeCount = CopyToken(tokens, doc->m_Nodes, 0);
-                doc->m_Json = strdup(buffer);
+                doc->m_Json = (char*) malloc(buffer_length + 1);
+                memcpy(doc->m_Json, buffer, buffer_length);
+                doc->m_Json[buffer_length] = '\0';
                 UnescapeStrings(doc);
             }
             else
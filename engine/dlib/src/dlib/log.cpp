@@ -16,6 +16,7 @@
 #include <assert.h>
 #include "dlib.h"
 #include "array.h"
+#include "atomic.h"
 #include "dstrings.h"
 #include "log.h"
 #include "socket.h"
@@ -72,6 +73,60 @@ static FILE* g_LogFile = 0;
 static dmCustomLogCallback g_CustomLogCallback = 0;
 static void* g_CustomLogCallbackUserData = 0;
 
+// Messages per second and call site (i.e. format string) before the messages are suppressed
+static const int32_t DM_LOG_RATE_LIMIT = 32;
+static const uint32_t DM_LOG_RATE_LIMIT_SITE_COUNT = 256;
+static const uint32_t DM_LOG_RATE_LIMIT_MAX_PROBES = 8;
+
+struct dmLogRateLimitSite
+{
+    void* volatile  m_Format;
+    int32_atomic_t  m_Second;
+    int32_atomic_t  m_Count;
+    int32_atomic_t  m_Suppressed;
+};
+
+static dmLogRateLimitSite g_RateLimitSites[DM_LOG_RATE_LIMIT_SITE_COUNT];
+
+static dmLogRateLimitSite* GetRateLimitSite(const char* format)
+{
+    uint32_t start = (uint32_t) (((uintptr_t) format) >> 3);
+    for (uint32_t i = 0; i < DM_LOG_RATE_LIMIT_MAX_PROBES; ++i)
+    {
+        dmLogRateLimitSite* site = &g_RateLimitSites[(start + i) % DM_LOG_RATE_LIMIT_SITE_COUNT];
+        void* prev = dmAtomicCompareStorePtr(&site->m_Format, (void*) format, 0);
+        if (prev == 0 || prev == format)
+            return site;
+    }
+    // Too many call sites, don't limit this one
+    return 0;
+}
+
+// Returns false if the message should be suppressed. When a call site starts a new second after having
+// suppressed messages, the number of suppressed messages is returned in suppressed.
+static bool CheckRateLimit(const char* format, int32_t* suppressed)
+{
+    *suppressed = 0;
+    dmLogRateLimitSite* site = GetRateLimitSite(format);
+    if (!site)
+        return true;
+
+    // The counters are reset by the first thread that sees a new second, the others count on
+    int32_t second = (int32_t) (dmTime::GetTime() / 1000000);
+    int32_t site_second = site->m_Second;
+    if (site_second != second && dmAtomicCompareStore32(&site->m_Second, second, site_second) == site_second)
+    {
+        dmAtomicStore32(&site->m_Count, 0);
+        *suppressed = dmAtomicStore32(&site->m_Suppressed, 0);
+    }
+
+    if (dmAtomicIncrement32(&site->m_Count) < DM_LOG_RATE_LIMIT)
+        return true;
+
+    dmAtomicIncrement32(&site->m_Suppressed);
+    return false;
+}
+
 // create and bind the server socket, will reuse old port if supplied handle valid
 static void dmLogInitSocket( dmSocket::Socket& server_socket )
 {
@@ -429,6 +484,20 @@ void dmLogInternal(dmLogSeverity severity, const char* domain, const char* forma
     if (severity < g_LogLevel)
         return;
 
+    // Log storms (e.g. a warning each frame for every instance) are limited per call site, before any
+    // formatting or output. User prints share a call site and are never limited.
+    if (severity != DM_LOG_SEVERITY_USER_DEBUG && severity != DM_LOG_SEVERITY_FATAL)
+    {
+        int32_t suppressed;
+        bool log = CheckRateLimit(format, &suppressed);
+        if (suppressed > 0)
+        {
+            dmLogInternal(severity, domain, "Suppressed %d more log messages like \"%s\"", suppressed, format);
+        }
+        if (!log)
+            return;
+    }
+
     va_list lst;
     va_start(lst, format);
 
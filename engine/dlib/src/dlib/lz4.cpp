@@ -71,6 +71,36 @@ namespace dmLZ4
         return r;
     }
 
+    Result DecompressBufferWithDictionary(const void* buffer, uint32_t buffer_size, void* decompressed_buffer, uint32_t decompressed_size, const void* dictionary, uint32_t dictionary_size)
+    {
+        if(decompressed_size > DMLZ4_MAX_OUTPUT_SIZE)
+            return dmLZ4::RESULT_OUTPUT_SIZE_TOO_LARGE;
+
+        if(dictionary_size > DMLZ4_MAX_DICTIONARY_SIZE)
+        {
+            dictionary = (const char*)dictionary + (dictionary_size - DMLZ4_MAX_DICTIONARY_SIZE);
+            dictionary_size = DMLZ4_MAX_DICTIONARY_SIZE;
+        }
+
+        int result = LZ4_decompress_safe_usingDict((const char*)buffer, (char*)decompressed_buffer, buffer_size, decompressed_size, (const char*)dictionary, dictionary_size);
+        if(result != (int)decompressed_size)
+            return dmLZ4::RESULT_OUTBUFFER_TOO_SMALL;
+        return dmLZ4::RESULT_OK;
+    }
+
+    Result CompressBufferWithDictionary(const void* buffer, uint32_t buffer_size, void* compressed_buffer, int* compressed_size, const void* dictionary, uint32_t dictionary_size)
+    {
+        LZ4_streamHC_t* stream = LZ4_createStreamHC();
+        LZ4_resetStreamHC(stream, 9);
+        LZ4_loadDictHC(stream, (const char*)dictionary, dictionary_size);
+        *compressed_size = LZ4_compress_HC_continue(stream, (const char*)buffer, (char*)compressed_buffer, buffer_size, LZ4_compressBound(buffer_size));
+        LZ4_freeStreamHC(stream);
+
+        if(*compressed_size == 0)
+            return dmLZ4::RESULT_COMPRESSION_FAILED;
+        return dmLZ4::RESULT_OK;
+    }
+
     Result MaxCompressedSize(int uncompressed_size, int *max_compressed_size)
     {
         *max_compressed_size = LZ4_compressBound(uncompressed_size);
@@ -96,6 +126,11 @@ extern "C" {
         return dmLZ4::CompressBuffer(buffer, buffer_size, compressed_buffer, compressed_size);
     }
 
+    DM_DLLEXPORT int LZ4CompressBufferWithDictionary(const void* buffer, uint32_t buffer_size, void* compressed_buffer, int* compressed_size, const void* dictionary, uint32_t dictionary_size)
+    {
+        return dmLZ4::CompressBufferWithDictionary(buffer, buffer_size, compressed_buffer, compressed_size, dictionary, dictionary_size);
+    }
+
     DM_DLLEXPORT int LZ4MaxCompressedSize(int uncompressed_size, int* max_compressed_size)
     {
         return dmLZ4::MaxCompressedSize(uncompressed_size, max_compressed_size);
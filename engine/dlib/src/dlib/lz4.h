@@ -17,6 +17,7 @@
 #include "shared_library.h"
 
 #define DMLZ4_MAX_OUTPUT_SIZE (1 << 30)
+#define DMLZ4_MAX_DICTIONARY_SIZE (64 * 1024)
 
 namespace dmLZ4
 {
@@ -73,6 +74,35 @@ namespace dmLZ4
      */
     Result CompressBuffer(const void* buffer, uint32_t buffer_size, void* compressed_buffer, int* compressed_size);
 
+    /**
+     * Decompress buffer compressed with CompressBufferWithDictionary. The same dictionary must be supplied.
+     * Only the last DMLZ4_MAX_DICTIONARY_SIZE bytes of the dictionary are used.
+     *
+     * @param buffer buffer to decompress
+     * @param buffer_size buffer size
+     * @param decompressed_buffer Pre-allocated buffer to decompress data into
+     * @param decompressed_size size of decompressed data
+     * @param dictionary dictionary data
+     * @param dictionary_size dictionary size
+     * @return dmLZ4::RESULT_OK on success
+     */
+    Result DecompressBufferWithDictionary(const void* buffer, uint32_t buffer_size, void* decompressed_buffer, uint32_t decompressed_size, const void* dictionary, uint32_t dictionary_size);
+
+    /**
+     * Compress buffer to LZ4-format using a dictionary with data similar to the buffer.
+     * Gives much better compression for small buffers than CompressBuffer.
+     * Only the last DMLZ4_MAX_DICTIONARY_SIZE bytes of the dictionary are used.
+     *
+     * @param buffer buffer to compress
+     * @param buffer_size buffer size
+     * @param compressed_buffer Pre-allocated buffer to compress data into, at least MaxCompressedSize() bytes
+     * @param compressed_size Actual compressed size will be written to this
+     * @param dictionary dictionary data
+     * @param dictionary_size dictionary size
+     * @return dmLZ4::RESULT_OK on success
+     */
+    Result CompressBufferWithDictionary(const void* buffer, uint32_t buffer_size, void* compressed_buffer, int* compressed_size, const void* dictionary, uint32_t dictionary_size);
+
     /**
      * Helper method to get a "worst case" size of compressed data.
      *
@@ -16,6 +16,7 @@
 #include <string.h>
 #include "profile.h"
 #include "memprofile.h"
+#include "thread.h"
 
 #if !(defined(_MSC_VER) || defined(ANDROID) || defined(__EMSCRIPTEN__) || defined(__NX__))
 
@@ -47,6 +48,7 @@ namespace dmMemProfile
         Stats* m_Stats;
         bool*  m_IsEnabled;
         void (*m_AddCounter)(const char*, uint32_t);
+        Tag* (*m_GetTag)();
     };
 }
 
@@ -58,6 +60,7 @@ namespace dmMemProfile
     // Common code and data
     Stats g_Stats = {0};
     bool g_IsEnabled = false;
+    dmThread::TlsKey g_TagTlsKey;
 
     void Initialize()
     {
@@ -71,7 +74,9 @@ namespace dmMemProfile
             data.m_Stats = &dmMemProfile::g_Stats;
             data.m_IsEnabled = &dmMemProfile::g_IsEnabled;
             data.m_AddCounter = dmProfile::AddCounter;
+            data.m_GetTag = GetTag;
 
+            g_TagTlsKey = dmThread::AllocTls();
             init(&data);
         }
 #endif
@@ -90,6 +95,22 @@ namespace dmMemProfile
     {
         *stats = g_Stats;
     }
+
+    Tag* SetTag(Tag* tag)
+    {
+        if (!g_IsEnabled)
+            return 0;
+        Tag* previous = (Tag*) dmThread::GetTlsValue(g_TagTlsKey);
+        dmThread::SetTlsValue(g_TagTlsKey, tag);
+        return previous;
+    }
+
+    Tag* GetTag()
+    {
+        if (!g_IsEnabled)
+            return 0;
+        return (Tag*) dmThread::GetTlsValue(g_TagTlsKey);
+    }
 }
 
 #endif
@@ -172,6 +193,7 @@ namespace dmMemProfile
     pthread_mutex_t* g_Mutex = 0;
     Stats* g_ExtStats = 0;
     void (*g_AddCounter)(const char*, uint32_t) = 0;
+    Tag* (*g_GetTag)() = 0;
 
     int g_TraceFile = -1;
 
@@ -194,6 +216,7 @@ namespace dmMemProfile
         *internal_data->m_IsEnabled = true;
         g_ExtStats = internal_data->m_Stats;
         g_AddCounter = internal_data->m_AddCounter;
+        g_GetTag = internal_data->m_GetTag;
 
         char* trace = getenv("DMMEMPROFILE_TRACE");
         if (trace && strlen(trace) > 0 && trace[0] != '0')
@@ -222,6 +245,19 @@ namespace dmMemProfile
         // We leak a mutex delibrity here
     }
 
+    static void AddAllocationCounters(size_t usable_size)
+    {
+        g_AddCounter("Memory.Allocations", 1U);
+        g_AddCounter("Memory.Amount", usable_size);
+
+        Tag* tag = g_GetTag ? g_GetTag() : 0;
+        if (tag)
+        {
+            g_AddCounter(tag->m_AllocationsCounter, 1U);
+            g_AddCounter(tag->m_AmountCounter, usable_size);
+        }
+    }
+
     void DumpBacktrace(char type, void* ptr, uint32_t size)
     {
         static int32_atomic_t call_depth = 0;
@@ -297,8 +333,7 @@ DM_DLLEXPORT void *malloc(size_t size)
             dmAtomicAdd32(&dmMemProfile::g_ExtStats->m_TotalActive, (uint32_t) usable_size);
             dmAtomicAdd32(&dmMemProfile::g_ExtStats->m_AllocationCount, 1U);
 
-            dmMemProfile::g_AddCounter("Memory.Allocations", 1U);
-            dmMemProfile::g_AddCounter("Memory.Amount", usable_size);
+            dmMemProfile::AddAllocationCounters(usable_size);
         }
     }
     else
@@ -338,8 +373,7 @@ DM_DLLEXPORT void *memalign(size_t alignment, size_t size)
             dmAtomicAdd32(&dmMemProfile::g_ExtStats->m_TotalActive, (uint32_t) usable_size);
             dmAtomicAdd32(&dmMemProfile::g_ExtStats->m_AllocationCount, 1U);
 
-            dmMemProfile::g_AddCounter("Memory.Allocations", 1U);
-            dmMemProfile::g_AddCounter("Memory.Amount", usable_size);
+            dmMemProfile::AddAllocationCounters(usable_size);
         }
     }
     else
@@ -379,8 +413,7 @@ DM_DLLEXPORT int posix_memalign(void **memptr, size_t alignment, size_t size)
             dmAtomicAdd32(&dmMemProfile::g_ExtStats->m_TotalActive, (uint32_t) usable_size);
             dmAtomicAdd32(&dmMemProfile::g_ExtStats->m_AllocationCount, 1U);
 
-            dmMemProfile::g_AddCounter("Memory.Allocations", 1U);
-            dmMemProfile::g_AddCounter("Memory.Amount", usable_size);
+            dmMemProfile::AddAllocationCounters(usable_size);
         }
     }
     else
@@ -419,8 +452,7 @@ DM_DLLEXPORT void *calloc(size_t count, size_t size)
             dmAtomicAdd32(&dmMemProfile::g_ExtStats->m_TotalActive, (uint32_t) usable_size);
             dmAtomicAdd32(&dmMemProfile::g_ExtStats->m_AllocationCount, 1U);
 
-            dmMemProfile::g_AddCounter("Memory.Allocations", 1U);
-            dmMemProfile::g_AddCounter("Memory.Amount", usable_size);
+            dmMemProfile::AddAllocationCounters(usable_size);
         }
     }
     else
@@ -475,8 +507,7 @@ DM_DLLEXPORT void *realloc(void* ptr, size_t size)
             dmAtomicAdd32(&dmMemProfile::g_ExtStats->m_TotalActive, (uint32_t) usable_size);
             dmAtomicAdd32(&dmMemProfile::g_ExtStats->m_AllocationCount, 1U);
 
-            dmMemProfile::g_AddCounter("Memory.Allocations", 1U);
-            dmMemProfile::g_AddCounter("Memory.Amount", usable_size);
+            dmMemProfile::AddAllocationCounters(usable_size);
         }
     }
     else
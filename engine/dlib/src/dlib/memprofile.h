@@ -15,8 +15,42 @@
 
 #include "atomic.h"
 
+#define DM_MEM_PASTE(x, y) x ## y
+#define DM_MEM_PASTE2(x, y) DM_MEM_PASTE(x, y)
+
+/**
+ * Tag the allocations made by the calling thread within the current scope, e.g. DM_MEM_SCOPE(Render).
+ * The number of allocations and bytes of each tag are added to the profiler counters
+ * "Memory.<name>.Allocations" and "Memory.<name>.Amount" every frame. The innermost scope wins.
+ * Only has an effect when the memory profiler library is loaded.
+ * name is the tag name. Must be a literal identifier
+ */
+#define DM_MEM_SCOPE(name)
+#undef DM_MEM_SCOPE
+
+#if defined(NDEBUG)
+    #define DM_MEM_SCOPE(name)
+#else
+    #define DM_MEM_SCOPE(name) \
+        static dmMemProfile::Tag DM_MEM_PASTE2(mem_tag, __LINE__) = { #name, "Memory." #name ".Allocations", "Memory." #name ".Amount" }; \
+        dmMemProfile::TagScope DM_MEM_PASTE2(mem_scope, __LINE__)(&DM_MEM_PASTE2(mem_tag, __LINE__));
+#endif
+
 namespace dmMemProfile
 {
+    /**
+     * Allocation tag, see DM_MEM_SCOPE
+     */
+    struct Tag
+    {
+        /// Tag name
+        const char* m_Name;
+        /// Counter name for the number of allocations
+        const char* m_AllocationsCounter;
+        /// Counter name for the number of bytes allocated
+        const char* m_AmountCounter;
+    };
+
     /**
      * Memory statistics
      */
@@ -53,6 +87,37 @@ namespace dmMemProfile
      * @param stats Pointer to memory stats struct
      */
     void GetStats(Stats* stats);
+
+    /**
+     * Set the allocation tag of the calling thread
+     * @param tag Tag, 0 for none
+     * @return The previous tag of the thread
+     */
+    Tag* SetTag(Tag* tag);
+
+    /**
+     * Get the allocation tag of the calling thread
+     * @return The tag, 0 for none
+     */
+    Tag* GetTag();
+
+    /**
+     * Sets the allocation tag of the calling thread for the lifetime of the scope
+     */
+    struct TagScope
+    {
+        Tag* m_Previous;
+
+        TagScope(Tag* tag)
+        {
+            m_Previous = SetTag(tag);
+        }
+
+        ~TagScope()
+        {
+            SetTag(m_Previous);
+        }
+    };
 }
 
 #endif // DM_MEMPROFILE_H
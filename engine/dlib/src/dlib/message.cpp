@@ -20,6 +20,7 @@
 #include "array.h"
 #include "condition_variable.h"
 #include "dstrings.h"
+#include <dlib/math.h>
 #include <dlib/mutex.h>
 #include <dlib/static_assert.h>
 #include <dlib/spinlock.h>
@@ -31,11 +32,14 @@ namespace dmMessage
 
     struct MemoryPage
     {
-        uint8_t     m_Memory[DM_MESSAGE_PAGE_SIZE];
-        uint32_t    m_Current;
-        MemoryPage* m_NextPage;
+        uint8_t         m_Memory[DM_MESSAGE_PAGE_SIZE];
+        // Bumped by the posting threads. Might grow past the page size when an allocation doesn't fit
+        int32_atomic_t  m_Current;
+        MemoryPage*     m_NextPage;
     };
 
+    // Messages are allocated lock-free from the current page. Replacing a full page is the only
+    // part of a post that takes a (spin) lock, i.e. once per DM_MESSAGE_PAGE_SIZE bytes.
     struct MemoryAllocator
     {
         MemoryAllocator()
@@ -43,10 +47,14 @@ namespace dmMessage
             m_CurrentPage = 0;
             m_FreePages = 0;
             m_FullPages = 0;
-        }
-        MemoryPage* m_CurrentPage;
-        MemoryPage* m_FreePages;
-        MemoryPage* m_FullPages;
+            m_DeferredPages = 0;
+            dmSpinlock::Init(&m_Lock);
+        }
+        MemoryPage* volatile    m_CurrentPage;
+        MemoryPage*             m_FreePages;        // Protected by m_Lock
+        MemoryPage*             m_FullPages;        // Protected by m_Lock
+        MemoryPage*             m_DeferredPages;    // Full pages that might still be written to. Only used by the dispatching thread
+        dmSpinlock::lock_t      m_Lock;
     };
 
     struct GlobalInit
@@ -58,13 +66,15 @@ namespace dmMessage
 
     } g_MessageInit;
 
+    // Must be called with the allocator lock held
     static void AllocateNewPage(MemoryAllocator* allocator)
     {
-        if (allocator->m_CurrentPage)
+        MemoryPage* current_page = (MemoryPage*) dmAtomicGetPtr((void* volatile*) &allocator->m_CurrentPage);
+        if (current_page)
         {
             // Link current page to full pages
-            allocator->m_CurrentPage->m_NextPage = allocator->m_FullPages;
-            allocator->m_FullPages = allocator->m_CurrentPage;
+            current_page->m_NextPage = allocator->m_FullPages;
+            allocator->m_FullPages = current_page;
         }
 
         MemoryPage* new_page = 0;
@@ -84,38 +94,83 @@ namespace dmMessage
         new_page->m_Current = 0;
         new_page->m_NextPage = 0;
 
-        allocator->m_CurrentPage = new_page;
+        // Publish the page with a full barrier
+        dmAtomicCompareStorePtr((void* volatile*) &allocator->m_CurrentPage, new_page, current_page);
     }
 
-    static void* AllocateMessage(MemoryAllocator* allocator, uint32_t size)
+    static uint32_t AlignSize(uint32_t size)
     {
         // At least ALIGNMENT bytes alignment of size in order to ensure that the next allocation is aligned
         size += DM_MESSAGE_ALIGNMENT-1;
         size &= ~(DM_MESSAGE_ALIGNMENT-1);
-        assert(size <= DM_MESSAGE_PAGE_SIZE);
+        return size;
+    }
+
+    // Reserve at least min_size and at most size bytes of the current page. Both must be aligned.
+    static void* ReserveMemory(MemoryAllocator* allocator, uint32_t size, uint32_t min_size, uint32_t* out_size)
+    {
+        assert(min_size <= size && size <= DM_MESSAGE_PAGE_SIZE);
 
-        if (allocator->m_CurrentPage == 0 || (DM_MESSAGE_PAGE_SIZE-allocator->m_CurrentPage->m_Current) < size)
+        while (true)
         {
+            MemoryPage* page = (MemoryPage*) dmAtomicGetPtr((void* volatile*) &allocator->m_CurrentPage);
+            if (page)
+            {
+                uint32_t offset = (uint32_t) dmAtomicAdd32(&page->m_Current, (int32_t) size);
+                // The rest of the page is ours if the start of the reservation is within the page
+                if (offset + min_size <= DM_MESSAGE_PAGE_SIZE)
+                {
+                    *out_size = dmMath::Min(size, DM_MESSAGE_PAGE_SIZE - offset);
+                    return (void*) ((uintptr_t) &page->m_Memory[0] + offset);
+                }
+            }
+
             // No current page or allocation didn't fit.
-            AllocateNewPage(allocator);
+            // Another thread might already have replaced the page while we were waiting for the lock
+            DM_SPINLOCK_SCOPED_LOCK(allocator->m_Lock);
+            if (dmAtomicGetPtr((void* volatile*) &allocator->m_CurrentPage) == page)
+            {
+                AllocateNewPage(allocator);
+            }
         }
+    }
 
-        MemoryPage* page = allocator->m_CurrentPage;
-        void* ret = (void*) ((uintptr_t) &page->m_Memory[0] + page->m_Current);
-        page->m_Current += size;
-        return ret;
+    static void* AllocateMessage(MemoryAllocator* allocator, uint32_t size)
+    {
+        size = AlignSize(size);
+        uint32_t reserved;
+        return ReserveMemory(allocator, size, size, &reserved);
     }
 
+    static void FreePages(MemoryPage* p)
+    {
+        while (p)
+        {
+            MemoryPage* next = p->m_NextPage;
+            delete p;
+            p = next;
+        }
+    }
+
+    // The message queue is a lock-free stack that the posting threads push onto. The dispatching thread
+    // takes the whole stack in one go and reverses it into posting order.
     struct MessageSocket
     {
-        uint32_t        m_RefCount; // Is protected by "g_MessageContext->m_Spinlock"
-        dmhash_t        m_NameHash;
-        Message*        m_Header;
-        Message*        m_Tail;
-        const char*     m_Name;
-        dmMutex::HMutex m_Mutex;
+        uint32_t            m_RefCount; // Is protected by "g_MessageContext->m_Spinlock"
+        dmhash_t            m_NameHash;
+        Message* volatile   m_Head;     // Most recently posted message
+        const char*         m_Name;
+        // Only used by DispatchBlocking
+        dmMutex::HMutex     m_Mutex;
         dmConditionVariable::HConditionVariable m_Condition;
-        MemoryAllocator m_Allocator;
+        int32_atomic_t      m_Waiting;
+        // Number of Post() calls in progress. Full pages are only reused when no post could still be writing to them
+        int32_atomic_t      m_ActivePosts;
+        int32_atomic_t      m_PostCount;
+        int32_atomic_t      m_QueueDepth;
+        uint32_t            m_DispatchCount;
+        uint32_t            m_MaxQueueDepth;
+        MemoryAllocator     m_Allocator;
     };
 
     const uint32_t MAX_SOCKETS = 256;
@@ -178,12 +233,17 @@ namespace dmMessage
 
         MessageSocket s;
         s.m_RefCount = 1;
-        s.m_Header = 0;
-        s.m_Tail = 0;
+        s.m_Head = 0;
         s.m_NameHash = name_hash;
         s.m_Name = strdup(name);
         s.m_Mutex = dmMutex::New();
         s.m_Condition = dmConditionVariable::New();
+        s.m_Waiting = 0;
+        s.m_ActivePosts = 0;
+        s.m_PostCount = 0;
+        s.m_QueueDepth = 0;
+        s.m_DispatchCount = 0;
+        s.m_MaxQueueDepth = 0;
 
         g_MessageContext->m_Sockets.Put(name_hash, s);
         *socket = name_hash;
@@ -191,9 +251,27 @@ namespace dmMessage
         return RESULT_OK;
     }
 
+    // Reverse the pushed messages into posting order
+    static Message* ReverseMessages(Message* message_object, uint32_t* out_count)
+    {
+        Message* prev = 0;
+        uint32_t count = 0;
+        while (message_object)
+        {
+            Message* next = message_object->m_Next;
+            message_object->m_Next = prev;
+            prev = message_object;
+            message_object = next;
+            ++count;
+        }
+        *out_count = count;
+        return prev;
+    }
+
     static void DisposeSocket(MessageSocket* s)
     {
-        Message *message_object = s->m_Header;
+        uint32_t count;
+        Message *message_object = ReverseMessages(s->m_Head, &count);
         while (message_object)
         {
             if (message_object->m_DestroyCallback)
@@ -205,20 +283,9 @@ namespace dmMessage
 
         free((void*) s->m_Name);
 
-        MemoryPage* p = s->m_Allocator.m_FreePages;
-        while (p)
-        {
-            MemoryPage* next = p->m_NextPage;
-            delete p;
-            p = next;
-        }
-        p = s->m_Allocator.m_FullPages;
-        while (p)
-        {
-            MemoryPage* next = p->m_NextPage;
-            delete p;
-            p = next;
-        }
+        FreePages(s->m_Allocator.m_FreePages);
+        FreePages(s->m_Allocator.m_FullPages);
+        FreePages(s->m_Allocator.m_DeferredPages);
         if (s->m_Allocator.m_CurrentPage)
         {
             delete s->m_Allocator.m_CurrentPage;
@@ -343,17 +410,28 @@ namespace dmMessage
         MessageSocket* s = AcquireSocket(socket);
         if (s != 0)
         {
-            bool has_messages;
-            {
-                DM_MUTEX_SCOPED_LOCK(s->m_Mutex);
-                has_messages = s->m_Header != 0;
-            }
+            bool has_messages = dmAtomicGetPtr((void* volatile*) &s->m_Head) != 0;
             ReleaseSocket(s);
             return has_messages;
         }
         return false;
     }
 
+    Result GetSocketStats(HSocket socket, SocketStats* out_stats)
+    {
+        MessageSocket* s = AcquireSocket(socket);
+        if (s == 0)
+        {
+            return RESULT_SOCKET_NOT_FOUND;
+        }
+        out_stats->m_PostCount = (uint32_t) dmAtomicAdd32(&s->m_PostCount, 0);
+        out_stats->m_DispatchCount = s->m_DispatchCount;
+        out_stats->m_QueueDepth = (uint32_t) dmAtomicAdd32(&s->m_QueueDepth, 0);
+        out_stats->m_MaxQueueDepth = s->m_MaxQueueDepth;
+        ReleaseSocket(s);
+        return RESULT_OK;
+    }
+
     void ResetURL(URL* url)
     {
         memset((void*)url, 0, sizeof(URL));
@@ -394,6 +472,54 @@ namespace dmMessage
         url->m_Fragment = fragment;
     }
 
+    static void InitMessage(Message* message, const URL* sender, const URL* receiver, dmhash_t message_id, uintptr_t user_data1, uintptr_t user_data2,
+                                uintptr_t descriptor, uint32_t message_data_size, MessageDestroyCallback destroy_callback)
+    {
+        if (sender != 0x0)
+        {
+            message->m_Sender = *sender;
+        }
+        else
+        {
+            ResetURL(&message->m_Sender);
+        }
+        message->m_Receiver = *receiver;
+        message->m_Id = message_id;
+        message->m_UserData1 = user_data1;
+        message->m_UserData2 = user_data2;
+        message->m_Descriptor = descriptor;
+        message->m_DataSize = message_data_size;
+        message->m_Next = 0;
+        message->m_DestroyCallback = destroy_callback;
+    }
+
+    // Push a chain of messages, linked from the last posted (first) to the first posted (last)
+    static void PushMessages(MessageSocket* s, Message* first, Message* last, uint32_t count)
+    {
+        // Counted before the push, so that a concurrent dispatch never makes the depth negative
+        dmAtomicAdd32(&s->m_QueueDepth, (int32_t) count);
+
+        // Guess that the queue is empty, a failed exchange returns the current head to try again with
+        Message* head = 0;
+        while (true)
+        {
+            last->m_Next = head;
+            Message* prev = (Message*) dmAtomicCompareStorePtr((void* volatile*) &s->m_Head, first, head);
+            if (prev == head)
+                break;
+            head = prev;
+        }
+
+        dmAtomicAdd32(&s->m_PostCount, (int32_t) count);
+
+        // Only wake a blocking dispatch when the queue goes from empty to non-empty
+        if (head == 0 && dmAtomicAdd32(&s->m_Waiting, 0) != 0)
+        {
+            DM_MUTEX_SCOPED_LOCK(s->m_Mutex);
+            dmConditionVariable::Signal(s->m_Condition);
+        }
+    }
+
     Result Post(const URL* sender, const URL* receiver, dmhash_t message_id, uintptr_t user_data1, uintptr_t user_data2,
                     uintptr_t descriptor, const void* message_data, uint32_t message_data_size, MessageDestroyCallback destroy_callback)
     {
@@ -411,59 +537,103 @@ namespace dmMessage
             return RESULT_SOCKET_NOT_FOUND;
         }
 
-        dmMutex::Lock(s->m_Mutex);
+        dmAtomicIncrement32(&s->m_ActivePosts);
 
         MemoryAllocator* allocator = &s->m_Allocator;
         uint32_t data_size = sizeof(Message) + message_data_size;
         Message *new_message = (Message *) AllocateMessage(allocator, data_size);
-        if (sender != 0x0)
-        {
-            new_message->m_Sender = *sender;
-        }
-        else
-        {
-            ResetURL(&new_message->m_Sender);
-        }
-        new_message->m_Receiver = *receiver;
-        new_message->m_Id = message_id;
-        new_message->m_UserData1 = user_data1;
-        new_message->m_UserData2 = user_data2;
-        new_message->m_Descriptor = descriptor;
-        new_message->m_DataSize = message_data_size;
-        new_message->m_Next = 0;
-        new_message->m_DestroyCallback = destroy_callback;
+        InitMessage(new_message, sender, receiver, message_id, user_data1, user_data2, descriptor, message_data_size, destroy_callback);
         memcpy(&new_message->m_Data[0], message_data, message_data_size);
 
-        bool is_first_message = !s->m_Header;
+        PushMessages(s, new_message, new_message, 1);
+        dmAtomicDecrement32(&s->m_ActivePosts);
 
-        if (!s->m_Header)
+        ReleaseSocket(s);
+
+        return RESULT_OK;
+    }
+
+    Result Post(const URL* sender, const URL* receiver, dmhash_t message_id, uintptr_t user_data1, uintptr_t descriptor,
+                    const void* message_data, uint32_t message_data_size, MessageDestroyCallback destroy_callback)
+    {
+        return Post(sender, receiver, message_id, user_data1, 0, descriptor, message_data, message_data_size, destroy_callback);
+    }
+
+
+    Result BeginBatch(HSocket socket, uint32_t message_count, uint32_t message_data_size, Batch* batch)
+    {
+        memset(batch, 0, sizeof(Batch));
+        MessageSocket* s = AcquireSocket(socket);
+        if (s == 0x0)
         {
-            s->m_Header = new_message;
-            s->m_Tail = new_message;
+            return RESULT_SOCKET_NOT_FOUND;
         }
-        else
+        // Keeps the pages of the batch from being reused until the batch is ended
+        dmAtomicIncrement32(&s->m_ActivePosts);
+
+        batch->m_Socket = socket;
+        batch->m_Internal = s;
+        batch->m_ReserveSize = message_count * AlignSize(sizeof(Message) + message_data_size);
+        return RESULT_OK;
+    }
+
+    void* BatchPost(Batch* batch, const URL* sender, const URL* receiver, dmhash_t message_id, uintptr_t user_data1, uintptr_t user_data2,
+                    uintptr_t descriptor, uint32_t message_data_size, MessageDestroyCallback destroy_callback)
+    {
+        DM_COUNTER("Messages", 1)
+
+        MessageSocket* s = (MessageSocket*) batch->m_Internal;
+        if (s == 0x0 || receiver == 0x0 || receiver->m_Socket != batch->m_Socket)
         {
-            s->m_Tail->m_Next = new_message;
-            s->m_Tail = new_message;
+            return 0x0;
         }
 
-        if (is_first_message)
+        uint32_t size = AlignSize(sizeof(Message) + message_data_size);
+        if ((uint32_t) (batch->m_End - batch->m_Current) < size)
         {
-            dmConditionVariable::Signal(s->m_Condition);
+            // Reserve room for the rest of the expected messages in one go
+            uint32_t reserve_size = dmMath::Min(DM_MESSAGE_PAGE_SIZE, dmMath::Max(size, batch->m_ReserveSize));
+            uint32_t reserved;
+            batch->m_Current = (uint8_t*) ReserveMemory(&s->m_Allocator, reserve_size, size, &reserved);
+            batch->m_End = batch->m_Current + reserved;
+            batch->m_ReserveSize -= dmMath::Min(batch->m_ReserveSize, reserved);
         }
-        dmMutex::Unlock(s->m_Mutex);
 
-        ReleaseSocket(s);
+        Message* message = (Message*) batch->m_Current;
+        batch->m_Current += size;
+        InitMessage(message, sender, receiver, message_id, user_data1, user_data2, descriptor, message_data_size, destroy_callback);
 
-        return RESULT_OK;
+        // Chained in the same order as the socket queue, most recent first
+        message->m_Next = (Message*) batch->m_First;
+        batch->m_First = message;
+        if (batch->m_Last == 0x0)
+        {
+            batch->m_Last = message;
+        }
+        batch->m_Count++;
+        return &message->m_Data[0];
     }
 
-    Result Post(const URL* sender, const URL* receiver, dmhash_t message_id, uintptr_t user_data1, uintptr_t descriptor,
-                    const void* message_data, uint32_t message_data_size, MessageDestroyCallback destroy_callback)
+    uint32_t EndBatch(Batch* batch)
     {
-        return Post(sender, receiver, message_id, user_data1, 0, descriptor, message_data, message_data_size, destroy_callback);
-    }
+        MessageSocket* s = (MessageSocket*) batch->m_Internal;
+        if (s == 0x0)
+        {
+            return 0;
+        }
+        DM_PROFILE(Message, "EndBatch")
+
+        uint32_t count = batch->m_Count;
+        if (count > 0)
+        {
+            PushMessages(s, (Message*) batch->m_First, (Message*) batch->m_Last, count);
+        }
+        dmAtomicDecrement32(&s->m_ActivePosts);
+        ReleaseSocket(s);
 
+        memset(batch, 0, sizeof(Batch));
+        return count;
+    }
 
     // Fast length limited string concatenation that assume we already point to
     // the end of the string. Returns the new end of the string so we do not need
@@ -505,16 +675,19 @@ namespace dmMessage
             return 0;
         }
 
-        dmMutex::Lock(s->m_Mutex);
-
         MemoryAllocator* allocator = &s->m_Allocator;
 
-        if (!s->m_Header)
+        if (dmAtomicGetPtr((void* volatile*) &s->m_Head) == 0)
         {
             if (blocking) {
-                dmConditionVariable::Wait(s->m_Condition, s->m_Mutex);
+                DM_MUTEX_SCOPED_LOCK(s->m_Mutex);
+                dmAtomicStore32(&s->m_Waiting, 1);
+                while (dmAtomicGetPtr((void* volatile*) &s->m_Head) == 0)
+                {
+                    dmConditionVariable::Wait(s->m_Condition, s->m_Mutex);
+                }
+                dmAtomicStore32(&s->m_Waiting, 0);
             } else {
-                dmMutex::Unlock(s->m_Mutex);
                 ReleaseSocket(s);
                 return 0;
             }
@@ -524,39 +697,61 @@ namespace dmMessage
         const char* profiler_string = GetProfilerString(s->m_Name, &profiler_hash);
         DM_PROFILE_DYN(Message, profiler_string, profiler_hash);
 
-        uint32_t dispatch_count = 0;
-
-        Message *message_object = s->m_Header;
-        s->m_Header = 0;
-        s->m_Tail = 0;
+        // Unlink full pages. A post that started before the page was replaced might still be writing
+        // to it, so the pages are only reclaimed once no posts are in progress. If there are none now,
+        // all messages in these pages are already pushed and part of the messages taken below.
+        {
+            DM_SPINLOCK_SCOPED_LOCK(allocator->m_Lock);
+            MemoryPage* p = allocator->m_FullPages;
+            while (p)
+            {
+                MemoryPage* next = p->m_NextPage;
+                p->m_NextPage = allocator->m_DeferredPages;
+                allocator->m_DeferredPages = p;
+                p = next;
+            }
+            allocator->m_FullPages = 0;
+        }
+        MemoryPage* full_pages = 0;
+        if (dmAtomicAdd32(&s->m_ActivePosts, 0) == 0)
+        {
+            full_pages = allocator->m_DeferredPages;
+            allocator->m_DeferredPages = 0;
+        }
 
-        // Unlink full pages
-        MemoryPage* full_pages = allocator->m_FullPages;
-        allocator->m_FullPages = 0;
+        uint32_t dispatch_count = 0;
+        Message* head = (Message*) dmAtomicStorePtr((void* volatile*) &s->m_Head, 0);
+        Message* message_object = ReverseMessages(head, &dispatch_count);
 
-        dmMutex::Unlock(s->m_Mutex);
+        dmAtomicSub32(&s->m_QueueDepth, (int32_t) dispatch_count);
+        s->m_DispatchCount += dispatch_count;
+        if (dispatch_count > s->m_MaxQueueDepth)
+            s->m_MaxQueueDepth = dispatch_count;
 
         while (message_object)
         {
+            // The callback might post to this socket, but new messages are pushed to m_Head
+            Message* next = message_object->m_Next;
             dispatch_callback(message_object, user_ptr);
             if (message_object->m_DestroyCallback) {
                 message_object->m_DestroyCallback(message_object);
             }
-            message_object = message_object->m_Next;
-            dispatch_count++;
+            message_object = next;
         }
 
         // Reclaim all full pages active when dispatch started
-        dmMutex::Lock(s->m_Mutex);
-        MemoryPage* p = full_pages;
-        while (p)
+        if (full_pages)
         {
-            MemoryPage* next = p->m_NextPage;
-            p->m_NextPage = allocator->m_FreePages;
-            allocator->m_FreePages = p;
-            p = next;
+            DM_SPINLOCK_SCOPED_LOCK(allocator->m_Lock);
+            MemoryPage* p = full_pages;
+            while (p)
+            {
+                MemoryPage* next = p->m_NextPage;
+                p->m_NextPage = allocator->m_FreePages;
+                allocator->m_FreePages = p;
+                p = next;
+            }
         }
-        dmMutex::Unlock(s->m_Mutex);
 
         ReleaseSocket(s);
 
@@ -56,6 +56,29 @@ namespace dmMessage
      */
     Result GetSocket(const char *name, HSocket* out_socket);
 
+    /**
+     * Socket statistics, see GetSocketStats()
+     */
+    struct SocketStats
+    {
+        /// Number of messages posted to the socket since it was created
+        uint32_t m_PostCount;
+        /// Number of messages dispatched from the socket since it was created
+        uint32_t m_DispatchCount;
+        /// Number of messages currently waiting to be dispatched
+        uint32_t m_QueueDepth;
+        /// Largest number of messages handled by a single dispatch
+        uint32_t m_MaxQueueDepth;
+    };
+
+    /**
+     * Get the message statistics of a socket. The message rate is the difference in post count between two calls.
+     * @param socket Socket
+     * @param out_stats Statistics (out value)
+     * @return RESULT_OK on success, RESULT_SOCKET_NOT_FOUND if the socket doesn't exist
+     */
+    Result GetSocketStats(HSocket socket, SocketStats* out_stats);
+
     /**
      * Test if a socket has any messages
      * @param socket Socket
@@ -66,6 +89,50 @@ namespace dmMessage
     // Internal legacy function
     Result Post(const URL* sender, const URL* receiver, dmhash_t message_id, uintptr_t user_data1, uintptr_t descriptor, const void* message_data, uint32_t message_data_size, MessageDestroyCallback destroy_callback);
 
+    /**
+     * Batch of messages posted to one socket, see BeginBatch()
+     */
+    struct Batch
+    {
+        HSocket     m_Socket;
+        void*       m_Internal;
+        void*       m_First;
+        void*       m_Last;
+        uint8_t*    m_Current;
+        uint8_t*    m_End;
+        uint32_t    m_Count;
+        uint32_t    m_ReserveSize;
+    };
+
+    /**
+     * Begin a batch of messages to a socket. The batch reserves message memory for several messages at a time
+     * and the messages are written in place. The messages are not visible to Dispatch() until EndBatch() is called.
+     * @note The batch must be ended before the socket is deleted
+     * @param socket Socket to post to
+     * @param message_count Expected number of messages, used to reserve memory up front
+     * @param message_data_size Expected data size of each message
+     * @param batch Batch (out value)
+     * @return RESULT_OK on success, RESULT_SOCKET_NOT_FOUND if the socket doesn't exist
+     */
+    Result BeginBatch(HSocket socket, uint32_t message_count, uint32_t message_data_size, Batch* batch);
+
+    /**
+     * Add a message to a batch. Same parameters as Post(), but the message data is written by the caller
+     * in the returned memory rather than copied.
+     * @param batch Batch
+     * @param message_data_size Size of the message data, at most DM_MESSAGE_MAX_DATA_SIZE
+     * @return Pointer to message_data_size bytes of message data, 0 if the receiver socket isn't the batch socket
+     */
+    void* BatchPost(Batch* batch, const URL* sender, const URL* receiver, dmhash_t message_id, uintptr_t user_data1, uintptr_t user_data2,
+                    uintptr_t descriptor, uint32_t message_data_size, MessageDestroyCallback destroy_callback);
+
+    /**
+     * Post all messages of a batch to the socket
+     * @param batch Batch
+     * @return Number of posted messages
+     */
+    uint32_t EndBatch(Batch* batch);
+
     /**
      * Dispatch messages
      * @note When dispatched, the messages are considered destroyed. Messages posted during dispatch
@@ -0,0 +1,224 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_PAGED_OBJECT_POOL_H
+#define DM_PAGED_OBJECT_POOL_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlib/array.h>
+
+/**
+ * Object pool with the same properties as dmObjectPool, but the objects are stored
+ * in fixed size pages instead of a single contiguous block.
+ * - Mapping from logical index to physical index
+ * - Logical index does not change
+ * - Allocated objects are densely packed, GetPhysical(i) for i in [0..Size()-1] iterates all objects
+ * - Growing the pool allocates new pages, existing objects are never copied and keep their address.
+ *   As in dmObjectPool, Free moves the last object into the freed slot.
+ *
+ * Memory for the capacity is allocated page by page as objects are allocated, so a pool can be given
+ * a large capacity up front without paying for it until it is used.
+ * The objects are stored as plain memory, T must be a POD type. New pages are zero initialized.
+ */
+template <typename T, uint32_t PAGE_BITS = 6>
+struct dmPagedObjectPool
+{
+    static const uint32_t PAGE_SIZE = 1 << PAGE_BITS;
+    static const uint32_t PAGE_MASK = PAGE_SIZE - 1;
+
+    // all fields are private
+    struct Entry
+    {
+        uint32_t m_Physical;
+        uint32_t m_Next;
+    };
+
+    dmArray<T*>         m_Pages;
+    dmArray<Entry>      m_Entries;
+    dmArray<uint32_t>   m_ToLogical;
+    uint32_t            m_FirstFree;
+    uint32_t            m_Size;
+    uint32_t            m_Capacity;
+
+    dmPagedObjectPool()
+    {
+        m_FirstFree = 0xffffffff;
+        m_Size = 0;
+        m_Capacity = 0;
+    }
+
+    ~dmPagedObjectPool()
+    {
+        for (uint32_t i = 0; i < m_Pages.Size(); ++i)
+        {
+            free(m_Pages[i]);
+        }
+    }
+
+    /**
+     * Set capacity. New capacity must be >= old capacity. No memory is allocated for the objects until they are allocated.
+     * @param capacity max number of objects to store
+     */
+    void SetCapacity(uint32_t capacity)
+    {
+        assert(capacity >= m_Capacity);
+        m_Capacity = capacity;
+        uint32_t page_count = (capacity + PAGE_MASK) >> PAGE_BITS;
+        if (m_Pages.Capacity() < page_count)
+        {
+            m_Pages.SetCapacity(page_count);
+        }
+    }
+
+    /**
+     * Allocate a new object, allocating a new page if needed
+     * @return logical index
+     */
+    uint32_t Alloc()
+    {
+        assert(m_Size < m_Capacity);
+        uint32_t physical = m_Size++;
+        if ((physical >> PAGE_BITS) == m_Pages.Size())
+        {
+            T* page = (T*) malloc(sizeof(T) * PAGE_SIZE);
+            memset((void*) page, 0, sizeof(T) * PAGE_SIZE);
+            m_Pages.Push(page);
+        }
+
+        Entry* e = 0;
+        if (m_FirstFree != 0xffffffff) {
+            e = &m_Entries[m_FirstFree];
+            m_FirstFree = e->m_Next;
+        } else {
+            if (m_Entries.Full()) {
+                m_Entries.OffsetCapacity(PAGE_SIZE);
+            }
+            m_Entries.SetSize(m_Entries.Size() + 1);
+            e = &m_Entries.Back();
+        }
+        e->m_Next = 0xffffffff;
+        e->m_Physical = physical;
+
+        if (m_ToLogical.Full()) {
+            m_ToLogical.OffsetCapacity(PAGE_SIZE);
+        }
+        m_ToLogical.SetSize(m_Size);
+        uint32_t index = e - m_Entries.Begin();
+        m_ToLogical[physical] = index;
+        return index;
+    }
+
+    /**
+     * Returns object index to the object pool. The last object is moved into the freed slot.
+     * @param index index of object
+     * @param clear If set, memset's the object memory, including the slot vacated by the moved object
+     */
+    void Free(uint32_t index, bool clear)
+    {
+        Entry* e = &m_Entries[index];
+        uint32_t last_physical = m_Size - 1;
+        uint32_t last = m_ToLogical[last_physical];
+        assert(e->m_Physical < m_Size);
+
+        T* o = &GetPhysical(e->m_Physical);
+        T* last_o = &GetPhysical(last_physical);
+        if (o != last_o) {
+            memcpy((void*) o, last_o, sizeof(T));
+        }
+        if (clear) {
+            memset((void*) last_o, 0, sizeof(T));
+        }
+
+        // Remap logical/physical
+        m_Entries[last].m_Physical = e->m_Physical;
+        m_ToLogical[e->m_Physical] = last;
+        m_ToLogical.SetSize(last_physical);
+        m_Size = last_physical;
+
+        // Put in free list
+        e->m_Next = m_FirstFree;
+        m_FirstFree = index;
+    }
+
+    /**
+     * Get object from logical index
+     * @param index index of the object
+     * @return a reference to the object
+     */
+    T& Get(uint32_t index)
+    {
+        return GetPhysical(m_Entries[index].m_Physical);
+    }
+
+    /**
+     * Set object from logical index
+     * @param index index of object
+     * @param object reference to object. The object stored is copied by value.
+     */
+    void Set(uint32_t index, T& object)
+    {
+        Get(index) = object;
+    }
+
+    /**
+     * Get object from physical index, used to iterate all objects
+     * @param physical physical index in [0..Size()-1]
+     * @return a reference to the object
+     */
+    T& GetPhysical(uint32_t physical)
+    {
+        return m_Pages[physical >> PAGE_BITS][physical & PAGE_MASK];
+    }
+
+    /**
+     * Get number of objects currently stored
+     * @return the number of objects currently stored
+     */
+    uint32_t Size()
+    {
+        return m_Size;
+    }
+
+    /**
+     * Checks if the pool is full
+     * @return true if the pool is full
+     */
+    bool Full()
+    {
+        return m_Size == m_Capacity;
+    }
+
+    /**
+     * @return maximum number of objects
+     */
+    uint32_t Capacity()
+    {
+        return m_Capacity;
+    }
+
+    /**
+     * @return number of objects memory is allocated for
+     */
+    uint32_t AllocatedCapacity()
+    {
+        return m_Pages.Size() * PAGE_SIZE;
+    }
+
+private:
+    dmPagedObjectPool(const dmPagedObjectPool&);
+    dmPagedObjectPool& operator=(const dmPagedObjectPool&);
+};
+
+#endif // DM_PAGED_OBJECT_POOL_H
@@ -39,4 +39,9 @@
 #error "Unsupported platform"
 #endif
 
+// Web builds only have threads when built with wasm threads (emcc -pthread, which requires SharedArrayBuffer)
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define DM_NO_THREAD_SUPPORT
+#endif
+
 #endif
@@ -13,6 +13,7 @@
 #include "profile.h"
 
 #include <algorithm>
+#include <stdio.h>
 #include <string.h>
 
 #if defined(_WIN32)
@@ -25,6 +26,19 @@
 #include <sys/time.h>
 #endif
 
+// Samples are timed with the cycle counter where it can be read from user mode
+#if defined(__EMSCRIPTEN__)
+#elif defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define DM_PROFILE_RDTSC
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+    #define DM_PROFILE_CNTVCT
+#endif
+
 #include "dlib.h"
 
 #include "hashtable.h"
@@ -34,6 +48,8 @@
 #include "math.h"
 #include "time.h"
 #include "thread.h"
+#include "mutex.h"
+#include "condition_variable.h"
 #include "array.h"
 
 namespace dmProfile
@@ -67,8 +83,13 @@ namespace dmProfile
     dmHashTable<uintptr_t, const char*> g_StringTable;
     dmStringPool::HPool g_StringPool = 0;
 
-    uint32_t g_BeginTime = 0;
+    uint64_t g_BeginTime = 0;
     uint64_t g_TicksPerSecond = 1000000;
+#if defined(DM_PROFILE_RDTSC)
+    // Reference point used to measure the frequency of the time stamp counter, see UpdateTicksPerSecond()
+    uint64_t g_CalibrationTick = 0;
+    uint64_t g_CalibrationTime = 0;
+#endif
     float g_FrameTime = 0.0f;
     float g_MaxFrameTime = 0.0f;
     uint32_t g_MaxFrameTimeCounter = 0;
@@ -79,6 +100,64 @@ namespace dmProfile
     bool g_Paused = false;
     dmSpinlock::lock_t g_ProfileLock;
 
+    /*
+      Samples are recorded into buffers owned by the thread taking them, so that DM_PROFILE
+      never writes to memory shared with other threads. Each thread has two buffers that are
+      used every other frame. Begin() advances g_FrameIndex and merges the buffers of the frame
+      that ended into the profile, while the threads carry on in their other buffer.
+      A buffer is reset by its owner thread when it's first used in a new frame.
+      Buffers are chunked so that samples never move when a buffer grows. They are kept until exit
+      as threads may still hold on to them.
+     */
+    const uint32_t SAMPLE_CHUNK_SIZE = 512;
+    // Elapsed time of a sample that hasn't ended yet
+    const uint32_t SAMPLE_OPEN = 0xffffffffu;
+
+    struct ThreadSample
+    {
+        const char* m_Name;
+        Scope*      m_Scope;
+        uint64_t    m_Start;
+        uint32_t    m_Elapsed;
+        uint32_t    m_NameHash;
+    };
+
+    struct SampleChunk
+    {
+        ThreadSample m_Samples[SAMPLE_CHUNK_SIZE];
+        SampleChunk* m_Next;
+    };
+
+    struct SampleBuffer
+    {
+        SampleChunk*   m_First;
+        // Chunk of the last sample, 0 if empty
+        SampleChunk*   m_Current;
+        // Frame index the samples belong to
+        uint32_t       m_Frame;
+        // Written by the owner thread only, after the sample is written
+        int32_atomic_t m_Count;
+        bool           m_Full;
+    };
+
+    struct ThreadProfile
+    {
+        SampleBuffer m_Buffers[2];
+        uint16_t     m_ThreadId;
+        // Keep the buffers of different threads on separate cache lines
+        uint8_t      m_Pad[64];
+    };
+
+    dmArray<ThreadProfile*> g_ThreadProfiles;
+    // Samples added with AddGpuSample()
+    ThreadProfile* g_GpuThreadProfile = 0;
+    uint32_t g_GpuScopeIndex = 0xffffffffu;
+    // Samples added with AddLuaSample()
+    ThreadProfile* g_LuaThreadProfile = 0;
+    uint32_t g_LuaScopeIndex = 0xffffffffu;
+    int32_atomic_t g_FrameIndex = 0;
+    uint32_t g_MaxSamples = 0;
+
     dmThread::TlsKey g_TlsKey = dmThread::AllocTls();
     int32_atomic_t g_ThreadCount = 0;
 
@@ -96,6 +175,40 @@ namespace dmProfile
 
     InitSpinLocks g_InitSpinlocks;
 
+    struct Capture;
+    // Active frame capture, see StartCapture()
+    Capture* g_Capture = 0;
+
+    static void CaptureFrame(Capture* capture, Profile* profile, uint32_t begin_tick);
+
+#if defined(DM_PROFILE_RDTSC)
+    static void CalibrateTicksPerSecond()
+    {
+        // Initial estimate, refined every frame by UpdateTicksPerSecond()
+        const uint64_t calibration_time = 2000;
+        g_CalibrationTime = dmTime::GetTime();
+        g_CalibrationTick = __rdtsc();
+        uint64_t time;
+        do
+        {
+            time = dmTime::GetTime();
+        } while (time - g_CalibrationTime < calibration_time);
+        g_TicksPerSecond = (uint64_t)((__rdtsc() - g_CalibrationTick) * 1000000.0 / (time - g_CalibrationTime));
+    }
+#endif
+
+    static void UpdateTicksPerSecond()
+    {
+#if defined(DM_PROFILE_RDTSC)
+        // The time stamp counter runs at a constant rate, the longer it is measured the more accurate it gets
+        uint64_t elapsed = dmTime::GetTime() - g_CalibrationTime;
+        if (elapsed > 1000000)
+        {
+            g_TicksPerSecond = (uint64_t)((__rdtsc() - g_CalibrationTick) * 1000000.0 / elapsed);
+        }
+#endif
+    }
+
     void Initialize(uint32_t max_scopes, uint32_t max_samples, uint32_t max_counters)
     {
         if (!dLib::IsDebugMode())
@@ -126,6 +239,7 @@ namespace dmProfile
         {
             Profile* p = &g_AllProfiles[i];
 
+            // Grown in Begin() if the threads record more samples
             p->m_Samples.SetCapacity(max_samples);
             p->m_Samples.SetSize(0); // Could be > 0 if Initialized is called again after Finalize
 
@@ -166,7 +280,15 @@ namespace dmProfile
         g_Counters.SetCapacity(max_counters);
         g_Counters.SetSize(0);
 
-#if defined(_WIN32)
+        g_MaxSamples = max_samples;
+        // Samples recorded before Finalize are never merged
+        dmAtomicIncrement32(&g_FrameIndex);
+
+#if defined(DM_PROFILE_RDTSC)
+        CalibrateTicksPerSecond();
+#elif defined(DM_PROFILE_CNTVCT)
+        __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(g_TicksPerSecond));
+#elif defined(_WIN32)
         QueryPerformanceFrequency((LARGE_INTEGER*)&g_TicksPerSecond);
 #elif defined(__APPLE__)
         mach_timebase_info_data_t info;
@@ -184,6 +306,8 @@ namespace dmProfile
 
     void Finalize()
     {
+        StopCapture();
+
         // NOTE: We do not clear g_Scopes here
         // Might be dangerous as we have static references to Scope* in functions due to DM_PROFILE
         // See Initialize. It's not even valid to change the number of scopes
@@ -341,6 +465,66 @@ namespace dmProfile
         active_threads.Iterate(&CalculateScopeProfileThread, profile);
     }
 
+    static void MergeSamples(Profile* profile, uint32_t frame, uint64_t frame_end)
+    {
+        uint32_t thread_count = g_ThreadProfiles.Size();
+        uint32_t sample_count = 0;
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            SampleBuffer* buffer = &g_ThreadProfiles[i]->m_Buffers[frame & 1];
+            if (buffer->m_Frame == frame)
+            {
+                sample_count += (uint32_t) buffer->m_Count;
+            }
+        }
+
+        dmArray<Sample>& samples = profile->m_Samples;
+        samples.SetSize(0);
+        if (samples.Capacity() < sample_count)
+        {
+            samples.SetCapacity(sample_count);
+        }
+
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            ThreadProfile* thread = g_ThreadProfiles[i];
+            SampleBuffer* buffer = &thread->m_Buffers[frame & 1];
+            if (buffer->m_Frame != frame)
+            {
+                continue;
+            }
+            g_OutOfSamples |= buffer->m_Full;
+
+            // A thread that read the frame index just before it was advanced might still add a sample
+            uint32_t count = dmMath::Min((uint32_t) buffer->m_Count, samples.Remaining());
+            SampleChunk* chunk = buffer->m_First;
+            for (uint32_t j = 0; j < count; ++j)
+            {
+                uint32_t offset = j % SAMPLE_CHUNK_SIZE;
+                if (offset == 0 && j > 0)
+                {
+                    chunk = chunk->m_Next;
+                }
+                const ThreadSample* thread_sample = &chunk->m_Samples[offset];
+
+                Sample* sample = samples.End();
+                samples.SetSize(samples.Size() + 1);
+                sample->m_Name = thread_sample->m_Name;
+                sample->m_Scope = thread_sample->m_Scope;
+                sample->m_Start = (uint32_t)(thread_sample->m_Start - g_BeginTime);
+                sample->m_Elapsed = thread_sample->m_Elapsed;
+                if (sample->m_Elapsed == SAMPLE_OPEN)
+                {
+                    // Still running, cut at the end of the frame
+                    sample->m_Elapsed = (uint32_t)(frame_end - thread_sample->m_Start);
+                }
+                sample->m_NameHash = thread_sample->m_NameHash;
+                sample->m_ThreadId = thread->m_ThreadId;
+                sample->m_Pad = 0;
+            }
+        }
+    }
+
     HProfile Begin()
     {
         if (!g_IsInitialized)
@@ -351,6 +535,13 @@ namespace dmProfile
 
         dmSpinlock::Lock(&g_ProfileLock);
 
+        uint64_t frame_end = GetNowTicks();
+        int32_t frame = g_FrameIndex;
+        dmAtomicStore32(&g_FrameIndex, frame + 1);
+
+        g_OutOfSamples = false;
+        MergeSamples(g_ActiveProfile, (uint32_t) frame, frame_end);
+        UpdateTicksPerSecond();
         CalculateScopeProfile(g_ActiveProfile);
 
         Profile* ret = g_ActiveProfile;
@@ -394,13 +585,19 @@ namespace dmProfile
 
         profile->m_Samples.SetSize(0);
 
-        g_BeginTime = GetNowTicks();
+        uint32_t frame_begin = (uint32_t) g_BeginTime;
+        g_BeginTime = frame_end;
 
         g_OutOfScopes = false;
-        g_OutOfSamples = false;
         g_OutOfCounters = false;
 
         dmSpinlock::Unlock(&g_ProfileLock);
+
+        // The finished profile isn't touched by other threads, serialize it outside of the lock
+        if (g_Capture)
+        {
+            CaptureFrame(g_Capture, ret, frame_begin);
+        }
         return ret;
     }
 
@@ -458,56 +655,130 @@ namespace dmProfile
         }
     }
 
-    // Used when out of samples in order to remove conditional branches
-    Sample g_DummySample = { "OUT_OF_SAMPLES", 0, 0, 0, 0 };
+    static ThreadProfile* NewThreadProfile(uint16_t thread_id)
+    {
+        // The buffers start out in frame 0, which is never merged, see Initialize()
+        ThreadProfile* thread = new ThreadProfile;
+        memset(thread, 0, sizeof(*thread));
+        thread->m_ThreadId = thread_id;
 
-    static Sample* AllocateNewSample()
+        DM_SPINLOCK_SCOPED_LOCK(g_ProfileLock)
+        if (g_ThreadProfiles.Full())
+        {
+            g_ThreadProfiles.OffsetCapacity(16);
+        }
+        g_ThreadProfiles.Push(thread);
+        return thread;
+    }
+
+    static ThreadProfile* GetThreadProfile()
     {
+        ThreadProfile* thread = (ThreadProfile*) dmThread::GetTlsValue(g_TlsKey);
+        if (thread != 0)
+        {
+            return thread;
+        }
+
         // NOTE: We can't take the spinlock if paused
         // as it might already been taken in dmProfile:Begin()
         // A deadlock case occur in dmMessage::Post if http-server is logging
-        // TODO: Use mutex instead?
         if (g_Paused)
         {
-            return &g_DummySample;
+            return 0;
         }
 
-        DM_SPINLOCK_SCOPED_LOCK(g_ProfileLock)
-        Profile* profile = g_ActiveProfile;
+        thread = NewThreadProfile((uint16_t) dmAtomicIncrement32(&g_ThreadCount));
+        dmThread::SetTlsValue(g_TlsKey, thread);
+        return thread;
+    }
 
-        bool full = profile->m_Samples.Full();
-        if (full)
+    static SampleBuffer* GetSampleBuffer(ThreadProfile* thread, uint32_t frame)
+    {
+        SampleBuffer* buffer = &thread->m_Buffers[frame & 1];
+        if (buffer->m_Frame != frame)
         {
-            g_OutOfSamples = true;
-            return &g_DummySample;
+            buffer->m_Current = 0;
+            buffer->m_Count = 0;
+            buffer->m_Full = false;
+            buffer->m_Frame = frame;
         }
-        profile->m_Samples.SetSize(profile->m_Samples.Size() + 1);
-        Sample* ret = profile->m_Samples.End() - 1;
-        return ret;
+        return buffer;
     }
 
-    Sample* AllocateSample()
+    // The sample is merged once it's published by incrementing the count of the buffer
+    static ThreadSample* AllocateSample(SampleBuffer* buffer)
     {
-        Sample* ret = AllocateNewSample();
-        if (ret == &g_DummySample)
+        uint32_t count = (uint32_t) buffer->m_Count;
+        if (count >= g_MaxSamples)
         {
-            return ret;
+            buffer->m_Full = true;
+            return 0;
         }
 
-        void* tls_data = dmThread::GetTlsValue(g_TlsKey);
-        if (tls_data == 0)
+        uint32_t offset = count % SAMPLE_CHUNK_SIZE;
+        if (offset == 0)
         {
-            // NOTE: We store thread_id + 1. Otherwise we can't differentiate between thread-id 0 and not initialized
-            int32_t next_thread_id = dmAtomicIncrement32(&g_ThreadCount) + 1;
-            void* thread_id = (void*)((uintptr_t)next_thread_id);
-            dmThread::SetTlsValue(g_TlsKey, thread_id);
-            tls_data = thread_id;
+            SampleChunk* next = buffer->m_Current ? buffer->m_Current->m_Next : buffer->m_First;
+            if (next == 0)
+            {
+                next = new SampleChunk;
+                next->m_Next = 0;
+                if (buffer->m_Current)
+                    buffer->m_Current->m_Next = next;
+                else
+                    buffer->m_First = next;
+            }
+            buffer->m_Current = next;
         }
-        intptr_t thread_id = ((intptr_t)tls_data) - 1;
-        assert(thread_id >= 0);
+        return &buffer->m_Current->m_Samples[offset];
+    }
 
-        ret->m_ThreadId = thread_id;
-        return ret;
+    // Adds a sample to a thread profile that isn't owned by a real thread, e.g. the GPU
+    static void AddFrameSample(ThreadProfile** thread, uint16_t thread_id, uint32_t* scope_index, const char* scope_name,
+                               const char* name, uint32_t name_hash, uint64_t start, uint64_t elapsed)
+    {
+        if (!g_IsInitialized || g_Paused)
+        {
+            return;
+        }
+
+        if (*thread == 0)
+        {
+            *thread = NewThreadProfile(thread_id);
+        }
+        if (*scope_index == 0xffffffffu)
+        {
+            *scope_index = AllocateScope(scope_name);
+            if (*scope_index == 0xffffffffu)
+            {
+                return;
+            }
+        }
+
+        SampleBuffer* buffer = GetSampleBuffer(*thread, (uint32_t) g_FrameIndex);
+        ThreadSample* s = AllocateSample(buffer);
+        if (s == 0)
+        {
+            return;
+        }
+
+        s->m_Name = name;
+        s->m_Scope = &g_Scopes[*scope_index];
+        s->m_NameHash = name_hash;
+        s->m_Start = g_BeginTime + start;
+        s->m_Elapsed = (uint32_t) dmMath::Min(elapsed, (uint64_t) SAMPLE_OPEN - 1);
+        dmAtomicStore32(&buffer->m_Count, buffer->m_Count + 1);
+    }
+
+    void AddGpuSample(const char* name, uint32_t name_hash, uint64_t start, uint64_t elapsed)
+    {
+        double ticks_per_ns = g_TicksPerSecond / 1000000000.0;
+        AddFrameSample(&g_GpuThreadProfile, GPU_THREAD_ID, &g_GpuScopeIndex, "GPU", name, name_hash, (uint64_t) (start * ticks_per_ns), (uint64_t) (elapsed * ticks_per_ns));
+    }
+
+    void AddLuaSample(const char* name, uint32_t name_hash, uint64_t start, uint64_t elapsed)
+    {
+        AddFrameSample(&g_LuaThreadProfile, LUA_THREAD_ID, &g_LuaScopeIndex, "Lua", name, name_hash, start, elapsed);
     }
 
     const char* Internalize(const char* string, uint32_t string_length, uint32_t string_hash)
@@ -786,7 +1057,11 @@ namespace dmProfile
     uint64_t GetNowTicks()
     {
         uint64_t now;
-#if defined(_WIN32)
+#if defined(DM_PROFILE_RDTSC)
+        now = __rdtsc();
+#elif defined(DM_PROFILE_CNTVCT)
+        __asm__ volatile("mrs %0, cntvct_el0" : "=r"(now));
+#elif defined(_WIN32)
         QueryPerformanceCounter((LARGE_INTEGER*)&now);
 #elif defined(__EMSCRIPTEN__)
         now = (uint64_t)(emscripten_get_now() * 1000.0);
@@ -802,24 +1077,471 @@ namespace dmProfile
 
     void ProfileScope::StartScope(uint32_t scope_index, const char* name, uint32_t name_hash)
     {
-        m_StartTick = GetNowTicks();
-        Sample* s = AllocateSample();
+        m_Sample = 0;
+        if (!g_IsInitialized)
+        {
+            return;
+        }
+
+        ThreadProfile* thread = GetThreadProfile();
+        if (thread == 0 || g_Paused)
+        {
+            return;
+        }
+
+        uint32_t frame = (uint32_t) g_FrameIndex;
+        SampleBuffer* buffer = GetSampleBuffer(thread, frame);
+        ThreadSample* s = AllocateSample(buffer);
+        if (s == 0)
+        {
+            return;
+        }
+
         s->m_Name = name;
         s->m_Scope = &g_Scopes[scope_index];
         s->m_NameHash = name_hash;
-        s->m_Start = (uint32_t)(m_StartTick - g_BeginTime);
+        s->m_Elapsed = SAMPLE_OPEN;
+        s->m_Start = GetNowTicks();
+        dmAtomicStore32(&buffer->m_Count, buffer->m_Count + 1);
+
         m_Sample = s;
+        m_Buffer = buffer;
+        m_Frame = frame;
     }
 
     void ProfileScope::EndScope()
     {
+        // The buffer is reused by the thread two frames later, and the sample might have been overwritten
+        if (m_Buffer->m_Frame != m_Frame)
+        {
+            return;
+        }
+
         uint64_t end = GetNowTicks();
-        m_Sample->m_Elapsed = (uint32_t)(end - m_StartTick);
-        if (m_Sample->m_Elapsed > (dmProfile::GetTicksPerSecond() * 2))
+        uint64_t elapsed = end - m_Sample->m_Start;
+        m_Sample->m_Elapsed = (uint32_t) dmMath::Min(elapsed, (uint64_t) SAMPLE_OPEN - 1);
+        if (elapsed > (dmProfile::GetTicksPerSecond() * 2))
         {
-            double elapsed_s = (double)(m_Sample->m_Elapsed) / dmProfile::GetTicksPerSecond();
+            double elapsed_s = (double)(elapsed) / dmProfile::GetTicksPerSecond();
             dmLogWarning("Profiler %s.%s took %.3lf seconds", m_Sample->m_Scope->m_Name, m_Sample->m_Name, elapsed_s);
         }
+    }
+
+    // Frame capture
+    //
+    // File layout, all values are little endian:
+    //   CaptureHeader
+    //   String area: CaptureString records followed by the string bytes. Only appended to.
+    //   Ring area: CaptureFrameHeader records, each followed by its CaptureSample and CaptureCounter entries.
+    // When the end of the ring area is reached the writer wraps around and overwrites the oldest frames.
+    // The header is rewritten after every frame so a partially written file is still readable.
+    // See profile_capture.py for the importer.
+
+    const uint32_t CAPTURE_MAGIC            = 0x54504d44; // "DMPT"
+    const uint32_t CAPTURE_FRAME_MAGIC      = 0x4d415246; // "FRAM"
+    const uint32_t CAPTURE_VERSION          = 1;
+    const uint32_t CAPTURE_STRING_AREA_SIZE = 64 * 1024;
+    const uint32_t CAPTURE_MIN_SIZE         = 256 * 1024;
+
+    enum CaptureStringType
+    {
+        CAPTURE_STRING_NAME  = 0, // Sample or counter name, key is the name hash
+        CAPTURE_STRING_SCOPE = 1, // Scope name, key is the scope index
+    };
+
+    struct CaptureHeader
+    {
+        uint32_t m_Magic;
+        uint32_t m_Version;
+        uint64_t m_TicksPerSecond;
+        uint32_t m_StringOffset;
+        uint32_t m_StringSize;
+        uint32_t m_StringUsed;
+        uint32_t m_RingOffset;
+        uint32_t m_RingSize;
+        /// Offsets within the ring area
+        uint32_t m_OldestFrame;
+        uint32_t m_WriteOffset;
+        /// End of the frames before the write offset has wrapped around, 0 if not wrapped
+        uint32_t m_WrapOffset;
+        uint32_t m_FrameCount;
+        uint32_t m_DroppedFrames;
+    };
+
+    struct CaptureString
+    {
+        uint32_t m_Key;
+        uint16_t m_Type;
+        uint16_t m_Length;
+    };
+
+    struct CaptureFrameHeader
+    {
+        uint32_t m_Magic;
+        /// Size of the record including samples and counters
+        uint32_t m_Size;
+        uint32_t m_FrameIndex;
+        /// Frame begin time in ticks, sample start times are relative to this
+        uint32_t m_BeginTick;
+        uint32_t m_SampleCount;
+        uint32_t m_CounterCount;
+    };
+
+    struct CaptureSample
+    {
+        uint32_t m_NameHash;
+        uint32_t m_Start;
+        uint32_t m_Elapsed;
+        uint16_t m_ScopeIndex;
+        uint16_t m_ThreadId;
+    };
+
+    struct CaptureCounter
+    {
+        uint32_t m_NameHash;
+        uint32_t m_Value;
+    };
+
+    struct Capture
+    {
+        FILE*                                   m_File;
+        dmThread::Thread                        m_Thread;
+        dmMutex::HMutex                         m_Mutex;
+        dmConditionVariable::HConditionVariable m_Condition;
+
+        // Owned by the thread calling Begin()
+        dmArray<uint8_t>                        m_Frame;
+        dmArray<uint8_t>                        m_Strings;
+        dmHashTable32<bool>                     m_Names;
+        uint32_t                                m_ScopeCount;
+        uint32_t                                m_StringBytes;
+        uint32_t                                m_FrameIndex;
+        bool                                    m_StringsFull;
+
+        // Protected by m_Mutex
+        dmArray<uint8_t>                        m_PendingFrame;
+        dmArray<uint8_t>                        m_PendingStrings;
+        uint32_t                                m_DroppedFrames;
+        bool                                    m_Quit;
+
+        // Owned by the writer thread
+        dmArray<uint8_t>                        m_WriteFrame;
+        dmArray<uint8_t>                        m_WriteStrings;
+        /// Ring offsets of the frames in the file, oldest first starting at m_FirstFrame
+        dmArray<uint32_t>                       m_FrameOffsets;
+        uint32_t                                m_FirstFrame;
+        CaptureHeader                           m_Header;
+    };
+
+    static void CaptureWriteHeader(Capture* capture)
+    {
+        CaptureHeader* header = &capture->m_Header;
+        uint32_t live_frames = capture->m_FrameOffsets.Size() - capture->m_FirstFrame;
+        header->m_OldestFrame = live_frames > 0 ? capture->m_FrameOffsets[capture->m_FirstFrame] : header->m_WriteOffset;
+        fseek(capture->m_File, 0, SEEK_SET);
+        fwrite(header, sizeof(*header), 1, capture->m_File);
+    }
+
+    static void CaptureWriteStrings(Capture* capture, dmArray<uint8_t>& strings)
+    {
+        CaptureHeader* header = &capture->m_Header;
+        uint32_t size = strings.Size();
+        // The budget is checked when the strings are added, see CaptureAddString()
+        assert(header->m_StringUsed + size <= header->m_StringSize);
+        fseek(capture->m_File, header->m_StringOffset + header->m_StringUsed, SEEK_SET);
+        fwrite(strings.Begin(), 1, size, capture->m_File);
+        header->m_StringUsed += size;
+    }
+
+    static void CaptureWriteFrame(Capture* capture, dmArray<uint8_t>& frame)
+    {
+        CaptureHeader* header = &capture->m_Header;
+        uint32_t size = frame.Size();
+        if (size > header->m_RingSize)
+        {
+            header->m_DroppedFrames++;
+            return;
+        }
+
+        dmArray<uint32_t>& offsets = capture->m_FrameOffsets;
+        uint32_t offset = header->m_WriteOffset;
+        if (offset + size > header->m_RingSize)
+        {
+            // Frames left after the write offset are from the previous lap and are no longer reachable
+            while (capture->m_FirstFrame < offsets.Size() && offsets[capture->m_FirstFrame] >= offset)
+            {
+                capture->m_FirstFrame++;
+            }
+            header->m_WrapOffset = offset;
+            offset = 0;
+        }
+
+        // Drop the oldest frames that are overwritten
+        while (capture->m_FirstFrame < offsets.Size() && offsets[capture->m_FirstFrame] >= offset && offsets[capture->m_FirstFrame] < offset + size)
+        {
+            capture->m_FirstFrame++;
+        }
+
+        if (capture->m_FirstFrame > 1024 && capture->m_FirstFrame * 2 > offsets.Size())
+        {
+            uint32_t live_frames = offsets.Size() - capture->m_FirstFrame;
+            memmove(offsets.Begin(), offsets.Begin() + capture->m_FirstFrame, live_frames * sizeof(uint32_t));
+            offsets.SetSize(live_frames);
+            capture->m_FirstFrame = 0;
+        }
+
+        if (offsets.Full())
+        {
+            offsets.OffsetCapacity(dmMath::Max(1024U, offsets.Capacity()));
+        }
+        offsets.Push(offset);
+
+        fseek(capture->m_File, header->m_RingOffset + offset, SEEK_SET);
+        fwrite(frame.Begin(), 1, size, capture->m_File);
+        header->m_WriteOffset = offset + size;
+        header->m_FrameCount++;
+    }
 
+    static void CaptureThread(void* arg)
+    {
+        Capture* capture = (Capture*) arg;
+
+        dmMutex::Lock(capture->m_Mutex);
+        while (true)
+        {
+            while (!capture->m_Quit && capture->m_PendingFrame.Empty() && capture->m_PendingStrings.Empty())
+            {
+                dmConditionVariable::Wait(capture->m_Condition, capture->m_Mutex);
+            }
+
+            if (capture->m_PendingFrame.Empty() && capture->m_PendingStrings.Empty())
+            {
+                break;
+            }
+
+            capture->m_WriteFrame.Swap(capture->m_PendingFrame);
+            capture->m_WriteStrings.Swap(capture->m_PendingStrings);
+            capture->m_Header.m_DroppedFrames += capture->m_DroppedFrames;
+            capture->m_DroppedFrames = 0;
+            dmMutex::Unlock(capture->m_Mutex);
+
+            // Strings first, so that every name in the frame is resolved when the header is written
+            if (!capture->m_WriteStrings.Empty())
+            {
+                CaptureWriteStrings(capture, capture->m_WriteStrings);
+            }
+            if (!capture->m_WriteFrame.Empty())
+            {
+                CaptureWriteFrame(capture, capture->m_WriteFrame);
+            }
+            CaptureWriteHeader(capture);
+            fflush(capture->m_File);
+
+            capture->m_WriteFrame.SetSize(0);
+            capture->m_WriteStrings.SetSize(0);
+
+            dmMutex::Lock(capture->m_Mutex);
+        }
+        dmMutex::Unlock(capture->m_Mutex);
+    }
+
+    static void CaptureAddString(Capture* capture, uint32_t key, CaptureStringType type, const char* string)
+    {
+        uint32_t length = dmMath::Min((uint32_t) strlen(string), 0xffffU);
+        uint32_t size = sizeof(CaptureString) + length;
+        if (capture->m_StringBytes + size > CAPTURE_STRING_AREA_SIZE)
+        {
+            if (!capture->m_StringsFull)
+            {
+                dmLogWarning("Profile capture string area full, new names are stored as hashes");
+                capture->m_StringsFull = true;
+            }
+            return;
+        }
+        capture->m_StringBytes += size;
+
+        CaptureString record;
+        record.m_Key = key;
+        record.m_Type = (uint16_t) type;
+        record.m_Length = (uint16_t) length;
+
+        dmArray<uint8_t>& strings = capture->m_Strings;
+        if (strings.Remaining() < size)
+        {
+            strings.OffsetCapacity(dmMath::Max(size, 4096U));
+        }
+        strings.PushArray((const uint8_t*) &record, sizeof(record));
+        strings.PushArray((const uint8_t*) string, length);
+    }
+
+    static void CaptureAddName(Capture* capture, uint32_t name_hash, const char* name)
+    {
+        if (capture->m_Names.Get(name_hash))
+        {
+            return;
+        }
+        if (capture->m_Names.Full())
+        {
+            uint32_t capacity = capture->m_Names.Capacity() + 1024;
+            capture->m_Names.SetCapacity(capacity / 2, capacity);
+        }
+        capture->m_Names.Put(name_hash, true);
+        CaptureAddString(capture, name_hash, CAPTURE_STRING_NAME, name);
+    }
+
+    static void CaptureFrame(Capture* capture, Profile* profile, uint32_t begin_tick)
+    {
+        DM_PROFILE(Profile, "Capture");
+
+        for (uint32_t i = capture->m_ScopeCount; i < profile->m_ScopeCount; ++i)
+        {
+            CaptureAddString(capture, i, CAPTURE_STRING_SCOPE, g_Scopes[i].m_Name);
+        }
+        capture->m_ScopeCount = dmMath::Max(capture->m_ScopeCount, profile->m_ScopeCount);
+
+        uint32_t sample_count = profile->m_Samples.Size();
+        uint32_t counter_count = profile->m_CounterCount;
+        uint32_t size = sizeof(CaptureFrameHeader) + sample_count * sizeof(CaptureSample) + counter_count * sizeof(CaptureCounter);
+
+        dmArray<uint8_t>& data = capture->m_Frame;
+        if (data.Capacity() < size)
+        {
+            data.SetCapacity(size);
+        }
+        data.SetSize(size);
+
+        CaptureFrameHeader* frame = (CaptureFrameHeader*) data.Begin();
+        frame->m_Magic = CAPTURE_FRAME_MAGIC;
+        frame->m_Size = size;
+        frame->m_FrameIndex = capture->m_FrameIndex++;
+        frame->m_BeginTick = begin_tick;
+        frame->m_SampleCount = sample_count;
+        frame->m_CounterCount = counter_count;
+
+        CaptureSample* samples = (CaptureSample*) (frame + 1);
+        for (uint32_t i = 0; i < sample_count; ++i)
+        {
+            const Sample* sample = &profile->m_Samples[i];
+            CaptureSample* s = &samples[i];
+            s->m_NameHash = sample->m_NameHash;
+            s->m_Start = sample->m_Start;
+            s->m_Elapsed = sample->m_Elapsed;
+            s->m_ScopeIndex = sample->m_Scope->m_Index;
+            s->m_ThreadId = sample->m_ThreadId;
+            CaptureAddName(capture, sample->m_NameHash, sample->m_Name);
+        }
+
+        CaptureCounter* counters = (CaptureCounter*) (samples + sample_count);
+        for (uint32_t i = 0; i < counter_count; ++i)
+        {
+            const CounterData* counter_data = &profile->m_CountersData[i];
+            counters[i].m_NameHash = counter_data->m_Counter->m_NameHash;
+            counters[i].m_Value = (uint32_t) counter_data->m_Value;
+            CaptureAddName(capture, counter_data->m_Counter->m_NameHash, counter_data->m_Counter->m_Name);
+        }
+
+        DM_MUTEX_SCOPED_LOCK(capture->m_Mutex);
+        if (capture->m_PendingFrame.Empty())
+        {
+            capture->m_PendingFrame.Swap(capture->m_Frame);
+        }
+        else
+        {
+            // The writer is behind, drop the frame rather than stalling the frame loop
+            capture->m_DroppedFrames++;
+        }
+        if (!capture->m_Strings.Empty())
+        {
+            dmArray<uint8_t>& pending = capture->m_PendingStrings;
+            if (pending.Remaining() < capture->m_Strings.Size())
+            {
+                pending.OffsetCapacity(capture->m_Strings.Size());
+            }
+            pending.PushArray(capture->m_Strings.Begin(), capture->m_Strings.Size());
+            capture->m_Strings.SetSize(0);
+        }
+        dmConditionVariable::Signal(capture->m_Condition);
+    }
+
+    bool StartCapture(const char* path, uint32_t max_size)
+    {
+        if (!g_IsInitialized)
+        {
+            dmLogError("Unable to start profile capture, dmProfile is not initialized");
+            return false;
+        }
+        if (g_Capture)
+        {
+            dmLogWarning("Profile capture already started");
+            return false;
+        }
+        if (max_size < CAPTURE_MIN_SIZE)
+        {
+            dmLogError("Profile capture size %u is too small, minimum is %u bytes", max_size, CAPTURE_MIN_SIZE);
+            return false;
+        }
+
+        FILE* file = fopen(path, "wb");
+        if (!file)
+        {
+            dmLogError("Unable to open profile capture file '%s'", path);
+            return false;
+        }
+
+        Capture* capture = new Capture;
+        capture->m_File = file;
+        capture->m_Names.SetCapacity(512, 1024);
+        capture->m_ScopeCount = 0;
+        capture->m_StringBytes = 0;
+        capture->m_FrameIndex = 0;
+        capture->m_StringsFull = false;
+        capture->m_DroppedFrames = 0;
+        capture->m_Quit = false;
+        capture->m_FirstFrame = 0;
+
+        CaptureHeader* header = &capture->m_Header;
+        memset(header, 0, sizeof(*header));
+        header->m_Magic = CAPTURE_MAGIC;
+        header->m_Version = CAPTURE_VERSION;
+        header->m_TicksPerSecond = g_TicksPerSecond;
+        header->m_StringOffset = sizeof(CaptureHeader);
+        header->m_StringSize = CAPTURE_STRING_AREA_SIZE;
+        header->m_RingOffset = header->m_StringOffset + header->m_StringSize;
+        header->m_RingSize = max_size - header->m_RingOffset;
+        CaptureWriteHeader(capture);
+        fflush(file);
+
+        capture->m_Mutex = dmMutex::New();
+        capture->m_Condition = dmConditionVariable::New();
+        capture->m_Thread = dmThread::New(CaptureThread, 0x80000, capture, "profile_capture");
+
+        g_Capture = capture;
+        return true;
+    }
+
+    void StopCapture()
+    {
+        Capture* capture = g_Capture;
+        if (!capture)
+        {
+            return;
+        }
+        g_Capture = 0;
+
+        dmMutex::Lock(capture->m_Mutex);
+        capture->m_Quit = true;
+        dmConditionVariable::Signal(capture->m_Condition);
+        dmMutex::Unlock(capture->m_Mutex);
+        dmThread::Join(capture->m_Thread);
+
+        fclose(capture->m_File);
+        dmConditionVariable::Delete(capture->m_Condition);
+        dmMutex::Delete(capture->m_Mutex);
+        delete capture;
+    }
+
+    bool IsCapturing()
+    {
+        return g_Capture != 0;
     }
 } // namespace dmProfile
@@ -181,7 +181,7 @@ namespace dmProfile
     /**
      * Initialize profiler
      * @param max_scopes Maximum scopes
-     * @param max_samples Maximum samples
+     * @param max_samples Maximum samples per thread and frame
      * @param max_counters Maximum counters
      */
     void Initialize(uint32_t max_scopes, uint32_t max_samples, uint32_t max_counters);
@@ -210,6 +210,30 @@ namespace dmProfile
      */
     void Release(HProfile profile);
 
+    /**
+     * Start streaming the samples and counters of every frame to a binary capture file.
+     * The file is kept below max_size bytes by overwriting the oldest frames. Frames are serialized
+     * in #Begin and written by a background thread, frames are dropped if the writer falls behind.
+     * Use profile_capture.py to convert the file to the Chrome trace format.
+     * @note Must be called from the thread calling #Begin
+     * @param path Capture file path
+     * @param max_size Maximum file size in bytes
+     * @return True if the capture was started
+     */
+    bool StartCapture(const char* path, uint32_t max_size);
+
+    /**
+     * Stop the capture started with #StartCapture and close the file.
+     * Pending frames are written before the function returns.
+     */
+    void StopCapture();
+
+    /**
+     * Check if a capture is running
+     * @return True if capturing
+     */
+    bool IsCapturing();
+
     /**
      * Get ticks per second
      * @return Ticks per second
@@ -273,12 +297,6 @@ namespace dmProfile
      */
     uint32_t AllocateScope(const char* name);
 
-    /**
-     * Internal function
-     * @return #Sample
-     */
-    Sample* AllocateSample();
-
     /**
      * Create an internalized string. Use this function in DM_PROFILE if the
      * name isn't valid for the life-time of the application
@@ -318,6 +336,35 @@ namespace dmProfile
      */
     void AddCounterIndex(uint32_t counter_index, uint32_t amount);
 
+    /// Thread id of the samples added with #AddGpuSample
+    const uint16_t GPU_THREAD_ID = 0xffff;
+
+    /**
+     * Add a sample measured on the GPU, in the scope "GPU". The GPU timers are read back
+     * a few frames late, so the samples are placed relative to the start of the frame they are added in.
+     * @note Must only be called from one thread
+     * @param name Sample name, must be valid for the life-time of the profile. See #Internalize
+     * @param name_hash Sample name hash
+     * @param start Start time in nanoseconds, relative to the start of the frame on the GPU
+     * @param elapsed Elapsed time in nanoseconds
+     */
+    void AddGpuSample(const char* name, uint32_t name_hash, uint64_t start, uint64_t elapsed);
+
+    /// Thread id of the samples added with #AddLuaSample
+    const uint16_t LUA_THREAD_ID = 0xfffe;
+
+    /**
+     * Add a sample of time spent in Lua code, in the scope "Lua". The samples are reconstructed from
+     * a sampling profile of the scripts, so they are placed relative to the start of the frame, with
+     * callees nested inside their callers.
+     * @note Must only be called from one thread
+     * @param name Sample name, must be valid for the life-time of the profile. See #Internalize
+     * @param name_hash Sample name hash
+     * @param start Start time in ticks, relative to the start of the frame
+     * @param elapsed Elapsed time in ticks
+     */
+    void AddLuaSample(const char* name, uint32_t name_hash, uint64_t start, uint64_t elapsed);
+
     /**
      * Get time for the frame total
      * @return Total frame time
@@ -347,11 +394,15 @@ namespace dmProfile
 
     uint64_t GetNowTicks();
 
+    struct ThreadSample;
+    struct SampleBuffer;
+
     /// Internal, do not use.
     struct ProfileScope
     {
-        Sample* m_Sample;
-        uint64_t m_StartTick;
+        ThreadSample* m_Sample;
+        SampleBuffer* m_Buffer;
+        uint32_t      m_Frame;
         inline ProfileScope(uint32_t scope_index, const char* name, uint32_t name_hash)
         {
             if (scope_index != 0xffffffffu)
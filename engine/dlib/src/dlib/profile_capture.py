@@ -0,0 +1,148 @@
+# Copyright 2020 The Defold Foundation
+# Licensed under the Defold License version 1.0 (the "License"); you may not use
+# this file except in compliance with the License.
+#
+# You may obtain a copy of the License, together with FAQs at
+# https://www.defold.com/license
+#
+# Unless required by applicable law or agreed to in writing, software distributed
+# under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied. See the License for the
+# specific language governing permissions and limitations under the License.
+
+# Converts a capture file written by dmProfile::StartCapture() to the Chrome trace
+# event format, which can be opened in chrome://tracing or https://ui.perfetto.dev
+#
+# Usage: profile_capture.py capture.dmpt trace.json [--min-frame-time <ms>]
+#
+# With --min-frame-time only frames taking at least the given time are exported,
+# which is useful for finding hitches in a long capture.
+
+import sys, struct, json, optparse
+
+CAPTURE_MAGIC = 0x54504d44
+CAPTURE_FRAME_MAGIC = 0x4d415246
+CAPTURE_VERSION = 1
+
+STRING_NAME = 0
+STRING_SCOPE = 1
+
+HEADER = struct.Struct('<IIQIIIIIIIIII')
+STRING = struct.Struct('<IHH')
+FRAME = struct.Struct('<IIIIII')
+SAMPLE = struct.Struct('<IIIHH')
+COUNTER = struct.Struct('<II')
+
+class Frame(object):
+    def __init__(self, index, begin, samples, counters):
+        self.index = index
+        self.begin = begin
+        self.samples = samples
+        self.counters = counters
+
+    def duration(self):
+        # Frame time is the longest sample on the main thread, see CalculateScopeProfileThread in profile.cpp
+        main = [s[2] for s in self.samples if s[4] == 0]
+        return max(main) if main else 0
+
+class Capture(object):
+    def __init__(self, data):
+        (magic, version, self.ticks_per_second, string_offset, string_size, string_used,
+         ring_offset, ring_size, oldest, write_offset, wrap_offset,
+         self.frame_count, self.dropped_frames) = HEADER.unpack_from(data, 0)
+        if magic != CAPTURE_MAGIC:
+            raise Exception('Not a profile capture file')
+        if version != CAPTURE_VERSION:
+            raise Exception('Unsupported capture version %d' % version)
+
+        self.names = {}
+        self.scopes = {}
+        offset = string_offset
+        end = string_offset + string_used
+        while offset < end:
+            key, type, length = STRING.unpack_from(data, offset)
+            offset += STRING.size
+            string = data[offset:offset + length].decode('utf-8', 'replace')
+            offset += length
+            if type == STRING_SCOPE:
+                self.scopes[key] = string
+            else:
+                self.names[key] = string
+
+        self.frames = []
+        if self.frame_count == 0:
+            return
+        if oldest < write_offset:
+            ranges = [(oldest, write_offset)]
+        else:
+            ranges = [(oldest, wrap_offset), (0, write_offset)]
+        for start, end in ranges:
+            offset = start
+            while offset < end:
+                offset += self._read_frame(data, ring_offset + offset)
+
+    def _read_frame(self, data, offset):
+        magic, size, index, begin, sample_count, counter_count = FRAME.unpack_from(data, offset)
+        if magic != CAPTURE_FRAME_MAGIC:
+            raise Exception('Corrupt frame at offset %d' % offset)
+        p = offset + FRAME.size
+        samples = []
+        for i in range(sample_count):
+            samples.append(SAMPLE.unpack_from(data, p))
+            p += SAMPLE.size
+        counters = []
+        for i in range(counter_count):
+            counters.append(COUNTER.unpack_from(data, p))
+            p += COUNTER.size
+        self.frames.append(Frame(index, begin, samples, counters))
+        return size
+
+    def name(self, name_hash):
+        return self.names.get(name_hash, '%08x' % name_hash)
+
+    def scope(self, index):
+        return self.scopes.get(index, 'scope%d' % index)
+
+    def to_trace(self, min_frame_ticks = 0):
+        us_per_tick = 1000000.0 / self.ticks_per_second
+        events = []
+        # Begin ticks are 32 bit and wrap around, make them monotonic
+        base = 0
+        last_begin = None
+        for frame in self.frames:
+            if last_begin is not None and frame.begin < last_begin:
+                base += 1 << 32
+            last_begin = frame.begin
+            if frame.duration() < min_frame_ticks:
+                continue
+            begin = base + frame.begin
+            ts = begin * us_per_tick
+            events.append({'name': 'Frame %d' % frame.index, 'ph': 'i', 's': 'g', 'pid': 0, 'tid': 0, 'ts': ts})
+            for name_hash, start, elapsed, scope, thread in frame.samples:
+                events.append({'name': self.name(name_hash), 'cat': self.scope(scope), 'ph': 'X',
+                               'pid': 0, 'tid': thread,
+                               'ts': (begin + start) * us_per_tick, 'dur': elapsed * us_per_tick})
+            for name_hash, value in frame.counters:
+                events.append({'name': self.name(name_hash), 'ph': 'C', 'pid': 0, 'ts': ts,
+                               'args': {'value': value}})
+        return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+def main():
+    parser = optparse.OptionParser(usage = 'usage: %prog [options] capture trace.json')
+    parser.add_option('--min-frame-time', dest = 'min_frame_time', type = 'float', default = 0.0,
+                      help = 'Only export frames taking at least this many milliseconds')
+    options, args = parser.parse_args()
+    if len(args) != 2:
+        parser.error('capture and output file required')
+
+    with open(args[0], 'rb') as f:
+        capture = Capture(f.read())
+
+    min_frame_ticks = options.min_frame_time * capture.ticks_per_second / 1000.0
+    with open(args[1], 'w') as f:
+        json.dump(capture.to_trace(min_frame_ticks), f)
+
+    print('%d frames in capture, %d written in total, %d dropped' % (len(capture.frames), capture.frame_count, capture.dropped_frames))
+
+if __name__ == '__main__':
+    main()
@@ -43,6 +43,8 @@ typedef int socklen_t;
 #include "thread.h"
 #include "atomic.h"
 #include "time.h"
+#include "hash.h"
+#include "spinlock.h"
 
 // Helper and utility functions
 namespace dmSocket
@@ -211,8 +213,11 @@ namespace dmSocket
 {
 
 
+    static void InitializeHostCache();
+
     Result Initialize()
     {
+        InitializeHostCache();
 #if defined(__NX__)
         return PlatformInitialize();
 #elif defined(_WIN32)
@@ -960,10 +965,97 @@ namespace dmSocket
     }
 #endif
 
+    // Resolved host names shared by all GetHostByNameT callers. getaddrinfo doesn't expose the TTL
+    // of the records, so entries live for a fixed time. Failed lookups are cached briefly as well,
+    // which makes the ipv4 then ipv6 fallback in the connection pool cheap on single stack networks.
+    static const uint32_t HOST_CACHE_SIZE = 32;
+    static const uint64_t HOST_CACHE_TTL = 60 * 1000000U;
+    static const uint64_t HOST_CACHE_NEGATIVE_TTL = 5 * 1000000U;
+
+    struct HostCacheEntry
+    {
+        dmhash_t    m_Key;
+        uint64_t    m_Expires;
+        Address     m_Address;
+        Result      m_Result;
+    };
+
+    static HostCacheEntry       g_HostCache[HOST_CACHE_SIZE];
+    static dmSpinlock::lock_t   g_HostCacheLock;
+
+    static void InitializeHostCache()
+    {
+        dmSpinlock::Init(&g_HostCacheLock);
+        memset(g_HostCache, 0, sizeof(g_HostCache));
+    }
+
+    void ClearHostCache()
+    {
+        DM_SPINLOCK_SCOPED_LOCK(g_HostCacheLock);
+        memset(g_HostCache, 0, sizeof(g_HostCache));
+    }
+
+    static dmhash_t GetHostCacheKey(const char* name, bool ipv4, bool ipv6)
+    {
+        uint8_t families = (ipv4 ? 1 : 0) | (ipv6 ? 2 : 0);
+        HashState64 hs;
+        dmHashInit64(&hs, false);
+        dmHashUpdateBuffer64(&hs, name, strlen(name));
+        dmHashUpdateBuffer64(&hs, &families, sizeof(families));
+        return dmHashFinal64(&hs);
+    }
+
+    static bool GetCachedHost(dmhash_t key, Address* address, Result* result)
+    {
+        uint64_t now = dmTime::GetTime();
+        DM_SPINLOCK_SCOPED_LOCK(g_HostCacheLock);
+        for (uint32_t i = 0; i < HOST_CACHE_SIZE; ++i)
+        {
+            HostCacheEntry* entry = &g_HostCache[i];
+            if (entry->m_Key == key && entry->m_Expires > now)
+            {
+                *address = entry->m_Address;
+                *result = entry->m_Result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void PutCachedHost(dmhash_t key, const Address& address, Result result)
+    {
+        // Only definite answers are cached, other errors are retried
+        if (result != RESULT_OK && result != RESULT_HOST_NOT_FOUND)
+            return;
+
+        uint64_t now = dmTime::GetTime();
+        DM_SPINLOCK_SCOPED_LOCK(g_HostCacheLock);
+        // Replace the entry for the same key, or else the one closest to (or past) expiring
+        HostCacheEntry* slot = &g_HostCache[0];
+        for (uint32_t i = 0; i < HOST_CACHE_SIZE; ++i)
+        {
+            HostCacheEntry* entry = &g_HostCache[i];
+            if (entry->m_Key == key)
+            {
+                slot = entry;
+                break;
+            }
+            if (entry->m_Expires < slot->m_Expires)
+            {
+                slot = entry;
+            }
+        }
+        slot->m_Key = key;
+        slot->m_Address = address;
+        slot->m_Result = result;
+        slot->m_Expires = now + (result == RESULT_OK ? HOST_CACHE_TTL : HOST_CACHE_NEGATIVE_TTL);
+    }
+
     struct GetHostByNameThreadContext
     {
         int32_atomic_t m_Finished;
         const char* m_Name;
+        dmhash_t m_CacheKey;
         Address m_Address;
         Result m_Result;
         bool m_Ipv4;
@@ -974,6 +1066,8 @@ namespace dmSocket
     {
         GetHostByNameThreadContext* ctx = (GetHostByNameThreadContext*)arg;
         ctx->m_Result = GetHostByName(ctx->m_Name, &ctx->m_Address, ctx->m_Ipv4, ctx->m_Ipv6);
+        // Also when the caller has timed out, so that the next lookup of the host doesn't have to wait
+        PutCachedHost(ctx->m_CacheKey, ctx->m_Address, ctx->m_Result);
 
         if (dmAtomicIncrement32(&ctx->m_Finished)+1 == 2)
         {
@@ -993,8 +1087,16 @@ namespace dmSocket
     {
         const uint32_t THREAD_STACK_SIZE = 0x20000;
 
+        dmhash_t cache_key = GetHostCacheKey(name, ipv4, ipv6);
+        Result cached_result;
+        if (GetCachedHost(cache_key, address, &cached_result))
+        {
+            return cached_result;
+        }
+
         GetHostByNameThreadContext* ctx = new GetHostByNameThreadContext;
         ctx->m_Name = strdup(name);
+        ctx->m_CacheKey = cache_key;
         ctx->m_Ipv4 = ipv4;
         ctx->m_Ipv6 = ipv6;
         ctx->m_Result = RESULT_HOSTUNREACH;
@@ -66,6 +66,11 @@ namespace dmSocket
      */
     Result Finalize();
 
+    /**
+     * Clear the host name cache used by GetHostByNameT, e.g. after a network change
+     */
+    void ClearHostCache();
+
     /**
      * Add multicast membership
      * @param socket socket to add membership on
@@ -3,7 +3,7 @@
 
 #include <stdint.h>
 
-#if defined(__linux__) && !defined(ANDROID)
+#if (defined(__linux__) && !defined(ANDROID)) || defined(__EMSCRIPTEN_PTHREADS__)
 #include <pthread.h>
 namespace dmSpinlock
 {
@@ -1,7 +1,9 @@
 
 #include "sslsocket.h"
+#include "hash.h"
 #include "log.h"
 #include "math.h"
+#include "mutex.h"
 #include "time.h"
 
 #include <errno.h>
@@ -59,11 +61,23 @@ struct SSLSocket
     uint64_t                m_TimeLimit2;
 };
 
+// Sessions from earlier handshakes, used to resume (abbreviated handshake) when connecting to the same host again
+struct CachedSession
+{
+    dmhash_t                m_HostHash;
+    uint64_t                m_LastUsed;
+    mbedtls_ssl_session     m_Session;
+};
+
+static const uint32_t SESSION_CACHE_SIZE = 16;
+
 struct SSLSocketContext
 {
     mbedtls_entropy_context     m_MbedEntropy;
     mbedtls_ctr_drbg_context    m_MbedCtrDrbg;
     mbedtls_ssl_config          m_MbedConf;
+    CachedSession               m_Sessions[SESSION_CACHE_SIZE];
+    dmMutex::HMutex             m_SessionMutex;
 } g_SSLSocketContext;
 
 #define MBEDTLS_RESULT_TO_STRING_CASE(x) case x: return #x;
@@ -155,6 +169,14 @@ Result Initialize()
     mbedtls_ctr_drbg_init( &g_SSLSocketContext.m_MbedCtrDrbg );
     mbedtls_entropy_init( &g_SSLSocketContext.m_MbedEntropy );
 
+    for (uint32_t i = 0; i < SESSION_CACHE_SIZE; ++i)
+    {
+        g_SSLSocketContext.m_Sessions[i].m_HostHash = 0;
+        g_SSLSocketContext.m_Sessions[i].m_LastUsed = 0;
+        mbedtls_ssl_session_init( &g_SSLSocketContext.m_Sessions[i].m_Session );
+    }
+    g_SSLSocketContext.m_SessionMutex = dmMutex::New();
+
 #if defined(MBEDTLS_DEBUG_C)
     mbedtls_debug_set_threshold( MBED_DEBUG_LEVEL );
     mbedtls_ssl_conf_dbg( &g_SSLSocketContext.m_MbedConf, mbedtls_debug, 0 );
@@ -181,12 +203,26 @@ Result Initialize()
 
     mbedtls_ssl_conf_rng( &g_SSLSocketContext.m_MbedConf, mbedtls_ctr_drbg_random, &g_SSLSocketContext.m_MbedCtrDrbg );
     mbedtls_ssl_conf_authmode( &g_SSLSocketContext.m_MbedConf, MBEDTLS_SSL_VERIFY_NONE );
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets( &g_SSLSocketContext.m_MbedConf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED );
+#endif
 
     return RESULT_OK;
 }
 
 Result Finalize()
 {
+    for (uint32_t i = 0; i < SESSION_CACHE_SIZE; ++i)
+    {
+        mbedtls_ssl_session_free( &g_SSLSocketContext.m_Sessions[i].m_Session );
+        g_SSLSocketContext.m_Sessions[i].m_HostHash = 0;
+    }
+    if (g_SSLSocketContext.m_SessionMutex)
+    {
+        dmMutex::Delete(g_SSLSocketContext.m_SessionMutex);
+        g_SSLSocketContext.m_SessionMutex = 0;
+    }
+
     mbedtls_ssl_config_free( &g_SSLSocketContext.m_MbedConf );
     mbedtls_ctr_drbg_free( &g_SSLSocketContext.m_MbedCtrDrbg );
     mbedtls_entropy_free( &g_SSLSocketContext.m_MbedEntropy );
@@ -265,6 +301,67 @@ static int RecvTimeout( void* _ctx, unsigned char *buf, size_t len, uint32_t tim
     return( mbedtls_net_recv( ctx, buf, len ) );
 }
 
+// Loads the cached session for the host (if any) into the context, so that the handshake can resume it
+static void ResumeSession(mbedtls_ssl_context* context, dmhash_t host_hash)
+{
+    DM_MUTEX_SCOPED_LOCK(g_SSLSocketContext.m_SessionMutex);
+    for (uint32_t i = 0; i < SESSION_CACHE_SIZE; ++i)
+    {
+        CachedSession* cached = &g_SSLSocketContext.m_Sessions[i];
+        if (cached->m_HostHash == host_hash)
+        {
+            if (mbedtls_ssl_set_session( context, &cached->m_Session ) == 0)
+            {
+                cached->m_LastUsed = dmTime::GetTime();
+            }
+            return;
+        }
+    }
+}
+
+// Stores the negotiated session (including any session ticket) for the host, replacing the least recently used entry
+static void StoreSession(mbedtls_ssl_context* context, dmhash_t host_hash)
+{
+    DM_MUTEX_SCOPED_LOCK(g_SSLSocketContext.m_SessionMutex);
+    CachedSession* slot = &g_SSLSocketContext.m_Sessions[0];
+    for (uint32_t i = 0; i < SESSION_CACHE_SIZE; ++i)
+    {
+        CachedSession* cached = &g_SSLSocketContext.m_Sessions[i];
+        if (cached->m_HostHash == host_hash)
+        {
+            slot = cached;
+            break;
+        }
+        if (cached->m_LastUsed < slot->m_LastUsed)
+        {
+            slot = cached;
+        }
+    }
+
+    slot->m_HostHash = 0;
+    if (mbedtls_ssl_get_session( context, &slot->m_Session ) == 0)
+    {
+        slot->m_HostHash = host_hash;
+        slot->m_LastUsed = dmTime::GetTime();
+    }
+}
+
+static void ForgetSession(dmhash_t host_hash)
+{
+    DM_MUTEX_SCOPED_LOCK(g_SSLSocketContext.m_SessionMutex);
+    for (uint32_t i = 0; i < SESSION_CACHE_SIZE; ++i)
+    {
+        CachedSession* cached = &g_SSLSocketContext.m_Sessions[i];
+        if (cached->m_HostHash == host_hash)
+        {
+            mbedtls_ssl_session_free( &cached->m_Session );
+            mbedtls_ssl_session_init( &cached->m_Session );
+            cached->m_HostHash = 0;
+            cached->m_LastUsed = 0;
+        }
+    }
+}
+
 Result New(dmSocket::Socket socket, const char* host, uint64_t timeout, SSLSocket** sslsocket)
 {
     uint64_t handshakestart = dmTime::GetTime();
@@ -312,6 +409,9 @@ Result New(dmSocket::Socket socket, const char* host, uint64_t timeout, SSLSocke
     mbedtls_ssl_set_bio(c->m_SSLContext, c->m_SSLNetContext, mbedtls_net_send, NULL, RecvTimeout);
     mbedtls_ssl_set_timer_cb(c->m_SSLContext, c, TimingSetDelay, TimingGetDelay);
 
+    dmhash_t host_hash = dmHashString64(host);
+    ResumeSession(c->m_SSLContext, host_hash);
+
     do
     {
         ret = mbedtls_ssl_handshake( c->m_SSLContext );
@@ -326,6 +426,9 @@ Result New(dmSocket::Socket socket, const char* host, uint64_t timeout, SSLSocke
 
     if (ret != 0)
     {
+        // Don't offer the same session again if the server rejected it
+        ForgetSession(host_hash);
+
         SSL_LOGE("mbedtls_ssl_handshake failed", ret);
         if (ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED)
         {
@@ -349,6 +452,8 @@ Result New(dmSocket::Socket socket, const char* host, uint64_t timeout, SSLSocke
         return RESULT_HANDSHAKE_FAILED;
     }
 
+    StoreSession(c->m_SSLContext, host_hash);
+
     *sslsocket = c;
     return RESULT_OK;
 }
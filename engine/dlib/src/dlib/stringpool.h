@@ -21,7 +21,7 @@ namespace dmStringPool
     typedef struct Pool* HPool;
 
     /**
-     * Create a new string pool. Internally strings are allocated in pages of 4k.
+     * Create a new string pool. Internally strings are allocated in pages of 16k.
      * @return String pool
      */
     HPool New();
@@ -38,7 +38,8 @@ namespace dmStringPool
      * guaranteed that two identical strings will have the same pointer value.
      * @note The identical property is valid if and only if two distinct strings result
      * in two distinct hash values.
-     * 
+     * @note Thread safe, and lock free unless a new page is allocated or the pool grows.
+     *
      * @param pool String pool
      * @param string String to add to pool
      * @return Pointer to string added
@@ -77,5 +77,32 @@ Result GetEntryData(HZip zip, void* buffer, uint32_t buffer_size)
     return RESULT_OK;
 }
 
+struct StreamContext
+{
+    void*   m_Context;
+    Writer  m_Writer;
+    bool    m_WriteFailed;
+};
+
+static size_t StreamEntryData(void* arg, unsigned long long offset, const void* data, size_t size)
+{
+    (void)offset;
+    StreamContext* ctx = (StreamContext*)arg;
+    if (!ctx->m_Writer(ctx->m_Context, data, (uint32_t)size))
+    {
+        ctx->m_WriteFailed = true;
+        return 0; // Aborts the extraction
+    }
+    return size;
+}
+
+Result GetEntryDataStreamed(HZip zip, void* context, Writer writer)
+{
+    StreamContext ctx = { context, writer, false };
+    int r = zip_entry_extract(zip, StreamEntryData, &ctx);
+    if (ctx.m_WriteFailed)
+        return RESULT_WRITE_FAILED;
+    return r == 0 ? RESULT_OK : RESULT_NO_SUCH_ENTRY;
+}
 
 } // namespace
@@ -26,8 +26,14 @@ namespace dmZip
         RESULT_OK,
         RESULT_NO_SUCH_ENTRY,
         RESULT_BUFFER_NOT_LARGE_ENOUGH,
+        RESULT_WRITE_FAILED,
     };
 
+    /*# Entry data write callback
+     * @return true on success
+     */
+    typedef bool (*Writer)(void* context, const void* data, uint32_t data_len);
+
     /*# Opens a read only zip archive
      *
      * @param path [type: const char*] path to the zip archive
@@ -77,6 +83,12 @@ namespace dmZip
      *
      */
     Result GetEntryData(HZip zip, void* buffer, uint32_t buffer_size);
+
+    /*# streams the data for an entry
+     * The entry is decompressed in chunks that are passed to the writer in order,
+     * so that the whole entry never has to be in memory.
+     */
+    Result GetEntryDataStreamed(HZip zip, void* context, Writer writer);
 }
 
 #endif // DM_ZIP_H
\ No newline at end of file
@@ -16,105 +16,158 @@
 
 namespace dmZlib
 {
-    static Result ToResult(int e) {
-        switch (e) {
-        case Z_OK:
-            return RESULT_OK;
-        case Z_STREAM_END:
-            return RESULT_STREAM_END;
-        case Z_NEED_DICT:
-            return RESULT_NEED_DICT;
-        case Z_ERRNO:
-            return RESULT_ERRNO;
-        case Z_STREAM_ERROR:
-            return RESULT_STREAM_ERROR;
-        case Z_DATA_ERROR:
-            return RESULT_DATA_ERROR;
-        case Z_MEM_ERROR:
-            return RESULT_MEM_ERROR;
-        case Z_BUF_ERROR:
-            return RESULT_BUF_ERROR;
-        case Z_VERSION_ERROR:
-            return RESULT_VERSION_ERROR;
+    static const uint32_t OUT_BUFFER_SIZE = 16384;
+
+    struct Inflater
+    {
+        z_stream        m_Stream;
+        unsigned char   m_Out[OUT_BUFFER_SIZE];
+        Result          m_Result;
+    };
+
+    struct Deflater
+    {
+        z_stream        m_Stream;
+        unsigned char   m_Out[OUT_BUFFER_SIZE];
+        Result          m_Result;
+    };
+
+    HInflater NewInflater()
+    {
+        Inflater* inflater = new Inflater;
+        z_stream* strm = &inflater->m_Stream;
+        strm->zalloc = Z_NULL;
+        strm->zfree = Z_NULL;
+        strm->opaque = Z_NULL;
+        strm->avail_in = 0;
+        strm->next_in = Z_NULL;
+        inflater->m_Result = RESULT_OK;
+
+        if (inflateInit2(strm, MAX_WBITS + 32) != Z_OK)
+        {
+            delete inflater;
+            return 0;
         }
-        return RESULT_UNKNOWN;
+        return inflater;
     }
 
-    Result InflateBuffer(const void* buffer, uint32_t buffer_size, void* context, Writer writer)
+    void DeleteInflater(HInflater inflater)
     {
-        z_stream strm;
-        unsigned char out[16384];
-
-        strm.zalloc = Z_NULL;
-        strm.zfree = Z_NULL;
-        strm.opaque = Z_NULL;
-        strm.avail_in = 0;
-        strm.next_in = Z_NULL;
+        (void)inflateEnd(&inflater->m_Stream);
+        delete inflater;
+    }
 
-        int ret = inflateInit2(&strm, MAX_WBITS + 32);
-        if (ret != Z_OK)
-            return ToResult(ret);
+    Result Inflate(HInflater inflater, const void* buffer, uint32_t buffer_size, void* context, Writer writer)
+    {
+        if (inflater->m_Result != RESULT_OK)
+            return inflater->m_Result;
 
-        strm.avail_in = buffer_size;
-        strm.next_in = (const uint8_t*) buffer;
+        z_stream* strm = &inflater->m_Stream;
+        strm->avail_in = buffer_size;
+        strm->next_in = (z_const Bytef*) buffer;
 
+        int ret;
         do {
-            strm.avail_out = sizeof(out);
-            strm.next_out = out;
-            ret = inflate(&strm, Z_NO_FLUSH);
+            strm->avail_out = sizeof(inflater->m_Out);
+            strm->next_out = inflater->m_Out;
+            ret = inflate(strm, Z_NO_FLUSH);
             assert(ret != Z_STREAM_ERROR);
+            if (ret == Z_BUF_ERROR) {
+                // No progress possible until more input arrives
+                ret = Z_OK;
+            }
             if (ret < 0 || ret == Z_NEED_DICT) {
-                (void)inflateEnd(&strm);
-                return RESULT_DATA_ERROR;
+                inflater->m_Result = RESULT_DATA_ERROR;
+                return inflater->m_Result;
             }
-            uint32_t have = sizeof(out) - strm.avail_out;
-            if (!writer(context, out, have)) {
-                (void)inflateEnd(&strm);
-                return ToResult(Z_ERRNO);
+            uint32_t have = sizeof(inflater->m_Out) - strm->avail_out;
+            if (have > 0 && !writer(context, inflater->m_Out, have)) {
+                inflater->m_Result = RESULT_ERRNO;
+                return inflater->m_Result;
             }
-        } while (strm.avail_out == 0);
+        } while (strm->avail_out == 0 && ret != Z_STREAM_END);
 
-        inflateEnd(&strm);
-        return ret == Z_STREAM_END ? RESULT_OK : RESULT_DATA_ERROR;
+        if (ret == Z_STREAM_END)
+            inflater->m_Result = RESULT_STREAM_END;
+        return inflater->m_Result;
     }
 
-    Result DeflateBuffer(const void* buffer, uint32_t buffer_size, int level, void* context, Writer writer)
+    HDeflater NewDeflater(int level)
     {
-        int ret, flush;
-        unsigned have;
-        z_stream strm;
-        unsigned char out[16384];
-
-        strm.zalloc = Z_NULL;
-        strm.zfree = Z_NULL;
-        strm.opaque = Z_NULL;
-        ret = deflateInit(&strm, level);
-        if (ret != Z_OK)
-            return ToResult(ret);
-
-        strm.avail_in = buffer_size;
-        flush = Z_FINISH;
-        strm.next_in = (const uint8_t*) buffer;
+        Deflater* deflater = new Deflater;
+        z_stream* strm = &deflater->m_Stream;
+        strm->zalloc = Z_NULL;
+        strm->zfree = Z_NULL;
+        strm->opaque = Z_NULL;
+        deflater->m_Result = RESULT_OK;
+
+        if (deflateInit(strm, level) != Z_OK)
+        {
+            delete deflater;
+            return 0;
+        }
+        return deflater;
+    }
 
+    void DeleteDeflater(HDeflater deflater)
+    {
+        (void)deflateEnd(&deflater->m_Stream);
+        delete deflater;
+    }
+
+    Result Deflate(HDeflater deflater, const void* buffer, uint32_t buffer_size, bool finish, void* context, Writer writer)
+    {
+        if (deflater->m_Result != RESULT_OK)
+            return deflater->m_Result;
+
+        z_stream* strm = &deflater->m_Stream;
+        strm->avail_in = buffer_size;
+        strm->next_in = (z_const Bytef*) buffer;
+
+        int ret;
         do {
-            strm.avail_out = sizeof(out);
-            strm.next_out = out;
+            strm->avail_out = sizeof(deflater->m_Out);
+            strm->next_out = deflater->m_Out;
 
-            ret = deflate(&strm, flush);
+            ret = deflate(strm, finish ? Z_FINISH : Z_NO_FLUSH);
             assert(ret != Z_STREAM_ERROR);
-            have = sizeof(out) - strm.avail_out;
+            uint32_t have = sizeof(deflater->m_Out) - strm->avail_out;
 
-            if (!writer(context, out, have)) {
-                (void)deflateEnd(&strm);
-                return RESULT_ERRNO;
+            if (have > 0 && !writer(context, deflater->m_Out, have)) {
+                deflater->m_Result = RESULT_ERRNO;
+                return deflater->m_Result;
             }
-        } while (strm.avail_out == 0);
-
-        assert(strm.avail_in == 0);
-        assert(ret == Z_STREAM_END);
+        } while (strm->avail_out == 0);
 
-        (void)deflateEnd(&strm);
+        assert(strm->avail_in == 0);
+        assert(!finish || ret == Z_STREAM_END);
+        if (finish)
+            deflater->m_Result = RESULT_STREAM_END;
         return RESULT_OK;
     }
 
+    Result InflateBuffer(const void* buffer, uint32_t buffer_size, void* context, Writer writer)
+    {
+        HInflater inflater = NewInflater();
+        if (!inflater)
+            return RESULT_MEM_ERROR;
+
+        Result r = Inflate(inflater, buffer, buffer_size, context, writer);
+        DeleteInflater(inflater);
+        if (r == RESULT_STREAM_END)
+            return RESULT_OK;
+        return r == RESULT_OK ? RESULT_DATA_ERROR : r;
+    }
+
+    Result DeflateBuffer(const void* buffer, uint32_t buffer_size, int level, void* context, Writer writer)
+    {
+        HDeflater deflater = NewDeflater(level);
+        if (!deflater)
+            return RESULT_STREAM_ERROR;
+
+        Result r = Deflate(deflater, buffer, buffer_size, true, context, writer);
+        DeleteDeflater(deflater);
+        return r;
+    }
+
 }
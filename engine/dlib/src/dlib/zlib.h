@@ -65,6 +65,64 @@ namespace dmZlib
      * @return RESULT_OK on success
      */
     Result DeflateBuffer(const void* buffer, uint32_t buffer_size, int level, void* context, Writer writer);
+
+    /// Streaming inflate handle
+    typedef struct Inflater* HInflater;
+
+    /// Streaming deflate handle
+    typedef struct Deflater* HDeflater;
+
+    /**
+     * Create a streaming inflater. Both gzip and zlib format is supported and is
+     * auto-detected from the first chunk
+     * @return inflater handle, 0 on failure
+     */
+    HInflater NewInflater();
+
+    /**
+     * Delete a streaming inflater
+     * @param inflater inflater handle
+     */
+    void DeleteInflater(HInflater inflater);
+
+    /**
+     * Inflate the next chunk of a stream. The chunk can be of any size and doesn't need to
+     * end on a block boundary. All output that can be produced from the data seen so far
+     * is passed to the writer before the function returns.
+     * @param inflater inflater handle
+     * @param buffer chunk to inflate
+     * @param buffer_size chunk size
+     * @param context context
+     * @param writer writer (inflated data)
+     * @return RESULT_OK if more data is expected, RESULT_STREAM_END when the end of the stream is reached,
+     *         a negative result on error. Data passed after the end of the stream is ignored.
+     */
+    Result Inflate(HInflater inflater, const void* buffer, uint32_t buffer_size, void* context, Writer writer);
+
+    /**
+     * Create a streaming deflater producing zlib-format
+     * @param level compression level
+     * @return deflater handle, 0 on failure
+     */
+    HDeflater NewDeflater(int level);
+
+    /**
+     * Delete a streaming deflater
+     * @param deflater deflater handle
+     */
+    void DeleteDeflater(HDeflater deflater);
+
+    /**
+     * Deflate the next chunk of a stream
+     * @param deflater deflater handle
+     * @param buffer chunk to deflate
+     * @param buffer_size chunk size
+     * @param finish true for the last chunk, which flushes all pending output
+     * @param context context
+     * @param writer writer (compressed data)
+     * @return RESULT_OK on success
+     */
+    Result Deflate(HDeflater deflater, const void* buffer, uint32_t buffer_size, bool finish, void* context, Writer writer);
 }
 
 
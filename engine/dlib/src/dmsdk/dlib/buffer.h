@@ -165,6 +165,43 @@ namespace dmBuffer
      */
     Result Create(uint32_t count, const StreamDeclaration* streams_decl, uint8_t streams_decl_count, HBuffer* out_buffer);
 
+    /*# Buffer creation flags
+     *
+     * @enum
+     * @name dmBuffer::CreateFlags
+     * @member dmBuffer::CREATE_FLAG_STRUCT_OF_ARRAYS Store each stream in a separate, tightly packed array.
+     * Each array starts on a 16 byte boundary and is padded to a multiple of 16 bytes, so that streams
+     * can be processed with SIMD instructions. The stride of each stream equals its component count.
+     * Such buffers can't be used as interleaved vertex data.
+     */
+    enum CreateFlags
+    {
+        CREATE_FLAG_STRUCT_OF_ARRAYS = 1,
+    };
+
+    /*# create Buffer with flags
+     *
+     * Creates a new HBuffer with a number of different streams, and a specific layout.
+     *
+     * @name dmBuffer::Create
+     * @param count [type:uint32_t] The number of "structs" the buffer should hold (e.g. vertex count)
+     * @param streams_decl [type:const dmBuffer::StreamDeclaration*] Array of stream declarations
+     * @param streams_decl_count [type:uint8_t] Number of stream declarations inside the decl array (max 256)
+     * @param flags [type:uint32_t] A combination of dmBuffer::CreateFlags
+     * @param out_buffer [type:dmBuffer::HBuffer*] Pointer to HBuffer where to store the newly allocated buffer
+     * @return result [type:dmBuffer::Result] BUFFER_OK if buffer was allocated successfully
+     * @examples
+     *
+     * ```cpp
+     * const dmBuffer::StreamDeclaration streams_decl[] = {
+     *     {dmHashString64("position"), dmBuffer::VALUE_TYPE_FLOAT32, 4},
+     * };
+     * dmBuffer::HBuffer buffer = 0x0;
+     * dmBuffer::Result r = dmBuffer::Create(1024, streams_decl, 1, dmBuffer::CREATE_FLAG_STRUCT_OF_ARRAYS, &buffer);
+     * ```
+     */
+    Result Create(uint32_t count, const StreamDeclaration* streams_decl, uint8_t streams_decl_count, uint32_t flags, HBuffer* out_buffer);
+
     /*# copy a Buffer
      *
      * Copies the data from one buffer to another buffer. The stream declaration needs to be the same in both buffers.
@@ -187,6 +224,59 @@ namespace dmBuffer
      */
     Result Copy(const HBuffer dst_buffer_handle, const HBuffer src_buffer_handle);
 
+    /*# fill a stream
+     *
+     * Sets a range of elements in a stream to the same value.
+     *
+     * @name dmBuffer::FillStream
+     * @param buffer [type:dmBuffer::HBuffer] buffer handle.
+     * @param stream_name [type:dmhash_t] Hash of stream name
+     * @param value [type:const void*] One element, i.e. the component count of values of the stream value type
+     * @param offset [type:uint32_t] The first element to set
+     * @param count [type:uint32_t] The number of elements to set
+     * @return result [type:dmBuffer::Result] BUFFER_OK if the stream was filled
+     * @examples
+     *
+     * ```cpp
+     * float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+     * dmBuffer::Result r = dmBuffer::FillStream(buffer, dmHashString64("color"), white, 0, vertex_count);
+     * ```
+     */
+    Result FillStream(HBuffer buffer, dmhash_t stream_name, const void* value, uint32_t offset, uint32_t count);
+
+    /*# copy elements between streams
+     *
+     * Copies a range of elements from one stream to another. The value type and component count
+     * of the streams must match. The streams may be in the same buffer, and may overlap.
+     *
+     * @name dmBuffer::CopyStream
+     * @param dst_buffer [type:dmBuffer::HBuffer] destination buffer handle.
+     * @param dst_stream_name [type:dmhash_t] Hash of destination stream name
+     * @param dst_offset [type:uint32_t] The first element to write
+     * @param src_buffer [type:dmBuffer::HBuffer] source buffer handle.
+     * @param src_stream_name [type:dmhash_t] Hash of source stream name
+     * @param src_offset [type:uint32_t] The first element to read
+     * @param count [type:uint32_t] The number of elements to copy
+     * @return result [type:dmBuffer::Result] BUFFER_OK if the elements were copied
+     */
+    Result CopyStream(HBuffer dst_buffer, dmhash_t dst_stream_name, uint32_t dst_offset,
+                      HBuffer src_buffer, dmhash_t src_stream_name, uint32_t src_offset, uint32_t count);
+
+    /*# transform positions in a stream
+     *
+     * Transforms a range of positions in place by a 4x4 matrix. The stream must be a
+     * VALUE_TYPE_FLOAT32 stream with 3 or 4 components. Positions with 3 components get a w of 1.
+     *
+     * @name dmBuffer::TransformPositions
+     * @param buffer [type:dmBuffer::HBuffer] buffer handle.
+     * @param stream_name [type:dmhash_t] Hash of stream name
+     * @param matrix [type:const float*] 16 floats, column major
+     * @param offset [type:uint32_t] The first element to transform
+     * @param count [type:uint32_t] The number of elements to transform
+     * @return result [type:dmBuffer::Result] BUFFER_OK if the positions were transformed
+     */
+    Result TransformPositions(HBuffer buffer, dmhash_t stream_name, const float* matrix, uint32_t offset, uint32_t count);
+
     /*# destroy Buffer.
      *
      * Destroys a HBuffer and it's streams.
@@ -284,6 +374,7 @@ namespace dmBuffer
     /*# get buffer as a byte array.
      *
      * Gets the buffer as a byte array. If the buffer is interleaved (default), a pointer to the whole memory is returned.
+     * For a dmBuffer::CREATE_FLAG_STRUCT_OF_ARRAYS buffer, the streams follow each other, including their padding.
      *
      * @name dmBuffer::GetBytes
      * @param buffer [type:dmBuffer::HBuffer] buffer handle.
@@ -387,12 +478,81 @@ namespace dmBuffer
 
     /*# Update the internal frame counter.
      * Used to know if a buffer has been updated.
+     * Since the changed elements aren't known, the whole buffer is considered dirty.
+     * Use dmBuffer::AddDirtyRange when only a few elements changed.
      *
      * @name dmBuffer::UpdateContentVersion
      * @param type [type:dmBuffer::HBuffer] The value type
      * @return result [type:dmBuffer::Result] Returns BUFFER_OK if all went ok
      */
     Result UpdateContentVersion(HBuffer hbuffer);
+
+    /*# A range of changed elements
+     *
+     * @struct
+     * @name dmBuffer::DirtyRange
+     * @member m_Offset [type:uint32_t] The first changed element
+     * @member m_Count [type:uint32_t] The number of changed elements
+     */
+    struct DirtyRange
+    {
+        uint32_t m_Offset;
+        uint32_t m_Count;
+    };
+
+    /*# The maximum number of dirty ranges tracked per buffer
+     * Ranges added past this limit are merged with the closest range.
+     *
+     * @constant
+     * @name dmBuffer::MAX_DIRTY_RANGES
+     */
+    const uint32_t MAX_DIRTY_RANGES = 8;
+
+    /*# mark a range of elements as changed
+     *
+     * Marks a range of elements (in all streams) as changed, and updates the content version.
+     * Consumers of the buffer, such as meshes, only need to upload the changed ranges.
+     *
+     * @name dmBuffer::AddDirtyRange
+     * @param hbuffer [type:dmBuffer::HBuffer] buffer handle.
+     * @param offset [type:uint32_t] The first changed element
+     * @param count [type:uint32_t] The number of changed elements
+     * @return result [type:dmBuffer::Result] BUFFER_OK if the range was added
+     * @examples
+     *
+     * ```cpp
+     * for (uint32_t i = first; i < first + count; ++i)
+     *     positions[i * stride + 1] += height;
+     * dmBuffer::AddDirtyRange(buffer, first, count);
+     * ```
+     */
+    Result AddDirtyRange(HBuffer hbuffer, uint32_t offset, uint32_t count);
+
+    /*# get the changed element ranges
+     *
+     * Gets the element ranges changed since dmBuffer::ClearDirtyRanges was last called.
+     * The ranges are only valid for updating a copy of the buffer taken at `base_version`.
+     * If the whole buffer has changed (e.g. through dmBuffer::UpdateContentVersion), `ranges` is set to 0.
+     *
+     * @name dmBuffer::GetDirtyRanges
+     * @param hbuffer [type:dmBuffer::HBuffer] buffer handle.
+     * @param base_version [type:uint32_t*] The content version when the ranges were last cleared
+     * @param ranges [type:const dmBuffer::DirtyRange**] The changed ranges, or 0 if the whole buffer changed
+     * @param range_count [type:uint32_t*] The number of changed ranges
+     * @return result [type:dmBuffer::Result] BUFFER_OK if the ranges were returned
+     */
+    Result GetDirtyRanges(HBuffer hbuffer, uint32_t* base_version, const DirtyRange** ranges, uint32_t* range_count);
+
+    /*# clear the changed element ranges
+     *
+     * Clears the dirty ranges, and sets the base version to the current content version.
+     * Other consumers holding a copy of an older version will have to update the whole buffer.
+     *
+     * @name dmBuffer::ClearDirtyRanges
+     * @param hbuffer [type:dmBuffer::HBuffer] buffer handle.
+     * @return result [type:dmBuffer::Result] BUFFER_OK if the ranges were cleared
+     */
+    Result ClearDirtyRanges(HBuffer hbuffer);
 }
 
 #endif // DMSDK_BUFFER_H
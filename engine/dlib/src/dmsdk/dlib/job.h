@@ -0,0 +1,203 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DMSDK_JOB_H
+#define DMSDK_JOB_H
+
+#include <stdint.h>
+
+/*# SDK Job API documentation
+ *
+ * Job system used by the engine to spread work over all cores.
+ * The engine owns the job context, native extensions get it through `dmExtension::Params::m_JobContext`.
+ *
+ * Jobs are created, optionally ordered with [ref:AddDependency], and then scheduled with [ref:Run].
+ * A job created with a parent keeps the parent from finishing until the child is finished,
+ * so a group created with [ref:CreateGroup] can be used to wait on a whole graph of jobs.
+ *
+ * A job graph that is built each frame should be waited for before the frame ends, typically in a
+ * `CALLBACK_POST_UPDATE` or `CALLBACK_PRE_RENDER` callback, see [ref:dmExtension::RegisterCallback].
+ *
+ * @document
+ * @name Job
+ * @namespace dmJob
+ * @path engine/dlib/src/dmsdk/dlib/job.h
+ */
+
+namespace dmJob
+{
+    /*# job context handle
+     * @typedef
+     * @name HContext
+     */
+    typedef struct Context* HContext;
+
+    /*# job handle
+     * Job handles are only valid until the job is finished, after that they report the job as finished.
+     * @typedef
+     * @name HJob
+     */
+    typedef uint32_t HJob;
+
+    /*# invalid job handle
+     * @constant
+     * @name INVALID_JOB
+     */
+    const HJob INVALID_JOB = 0xffffffff;
+
+    /*# result enumeration
+     *
+     * @enum
+     * @name Result
+     * @member dmJob::RESULT_OK
+     * @member dmJob::RESULT_INVALID_PARAM
+     * @member dmJob::RESULT_OUT_OF_RESOURCES
+     * @member dmJob::RESULT_ALREADY_STARTED
+     */
+    enum Result
+    {
+        RESULT_OK               = 0,
+        RESULT_INVALID_PARAM    = -1,
+        RESULT_OUT_OF_RESOURCES = -2,
+        RESULT_ALREADY_STARTED  = -3,
+    };
+
+    /*# job function
+     * Executed on any of the job threads, including the thread waiting for the job.
+     * @typedef
+     * @name JobFunc
+     * @param context [type:void*] user context
+     * @param data [type:void*] user data
+     */
+    typedef void (*JobFunc)(void* context, void* data);
+
+    /*# job function operating on a range of elements
+     * @typedef
+     * @name RangeFunc
+     * @param context [type:void*] user context
+     * @param start [type:uint32_t] first element
+     * @param end [type:uint32_t] one past the last element
+     */
+    typedef void (*RangeFunc)(void* context, uint32_t start, uint32_t end);
+
+    /*# get number of worker threads
+     * Get number of worker threads, not including the thread that created the context.
+     * @name GetWorkerCount
+     * @param context [type:dmJob::HContext] job context
+     * @return count [type:uint32_t] number of worker threads. 0 means that all jobs run on the waiting thread.
+     */
+    uint32_t GetWorkerCount(HContext context);
+
+    /*# create a job
+     * Create a job. The job is not scheduled until [ref:Run] is called.
+     * @name CreateJob
+     * @param context [type:dmJob::HContext] job context
+     * @param func [type:dmJob::JobFunc] job function
+     * @param user_context [type:void*] user context passed to the job function
+     * @param user_data [type:void*] user data passed to the job function
+     * @param parent [type:dmJob::HJob] parent job or INVALID_JOB. The parent isn't finished until all children are finished.
+     * @return job [type:dmJob::HJob] job handle, INVALID_JOB if out of jobs
+     */
+    HJob CreateJob(HContext context, JobFunc func, void* user_context, void* user_data, HJob parent);
+
+    /*# create a job group
+     * Create a job without a function, used as a counter for a group of child jobs.
+     * @name CreateGroup
+     * @param context [type:dmJob::HContext] job context
+     * @param parent [type:dmJob::HJob] parent job or INVALID_JOB
+     * @return job [type:dmJob::HJob] job handle, INVALID_JOB if out of jobs
+     */
+    HJob CreateGroup(HContext context, HJob parent);
+
+    /*# add a job dependency
+     * Make a job wait for another job to finish before it is executed.
+     * Must be called before [ref:Run] is called for the job. Depending on a finished job is allowed.
+     * @name AddDependency
+     * @param context [type:dmJob::HContext] job context
+     * @param job [type:dmJob::HJob] job to delay
+     * @param dependency [type:dmJob::HJob] job to wait for
+     * @return result [type:dmJob::Result] RESULT_OK on success
+     */
+    Result AddDependency(HContext context, HJob job, HJob dependency);
+
+    /*# schedule a job
+     * Schedule a job. The job is executed as soon as all its dependencies are finished.
+     * @name Run
+     * @param context [type:dmJob::HContext] job context
+     * @param job [type:dmJob::HJob] job handle
+     * @return result [type:dmJob::Result] RESULT_OK on success
+     */
+    Result Run(HContext context, HJob job);
+
+    /*# check if a job is finished
+     * Check if a job and all its children are finished.
+     * @name IsFinished
+     * @param context [type:dmJob::HContext] job context
+     * @param job [type:dmJob::HJob] job handle
+     * @return finished [type:bool] true if finished
+     */
+    bool IsFinished(HContext context, HJob job);
+
+    /*# wait for a job
+     * Wait for a job and all its children to finish. The calling thread executes queued jobs while waiting.
+     * @name Wait
+     * @param context [type:dmJob::HContext] job context
+     * @param job [type:dmJob::HJob] job handle
+     */
+    void Wait(HContext context, HJob job);
+
+    /*# process a range of elements in parallel
+     * Split a range of elements into batches and run them as child jobs of a group.
+     * The returned group is already scheduled and finishes when all batches are processed.
+     * If the context or jobs are not available, the whole range is processed immediately
+     * on the calling thread and INVALID_JOB is returned.
+     *
+     * @name ParallelFor
+     * @param context [type:dmJob::HContext] job context, may be 0
+     * @param func [type:dmJob::RangeFunc] range function
+     * @param user_context [type:void*] user context passed to the range function
+     * @param count [type:uint32_t] number of elements
+     * @param min_batch_size [type:uint32_t] minimum number of elements per job
+     * @param parent [type:dmJob::HJob] parent job or INVALID_JOB
+     * @return group [type:dmJob::HJob] group job handle or INVALID_JOB
+     *
+     * @examples
+     *
+     * Build a small job graph in the pre update callback and wait for it in the post update callback:
+     *
+     * ```cpp
+     * static dmJob::HJob g_Frame = dmJob::INVALID_JOB;
+     *
+     * static dmExtension::Result PreUpdate(dmExtension::Params* params)
+     * {
+     *     dmJob::HContext jobs = params->m_JobContext;
+     *     g_Frame = dmJob::CreateGroup(jobs, dmJob::INVALID_JOB);
+     *     dmJob::HJob simulate = dmJob::CreateJob(jobs, Simulate, &g_State, 0, g_Frame);
+     *     dmJob::HJob upload = dmJob::CreateJob(jobs, Upload, &g_State, 0, g_Frame);
+     *     dmJob::AddDependency(jobs, upload, simulate);
+     *     dmJob::Run(jobs, simulate);
+     *     dmJob::Run(jobs, upload);
+     *     dmJob::Run(jobs, g_Frame);
+     *     return dmExtension::RESULT_OK;
+     * }
+     *
+     * static dmExtension::Result PostUpdate(dmExtension::Params* params)
+     * {
+     *     dmJob::Wait(params->m_JobContext, g_Frame);
+     *     return dmExtension::RESULT_OK;
+     * }
+     * ```
+     */
+    HJob ParallelFor(HContext context, RangeFunc func, void* user_context, uint32_t count, uint32_t min_batch_size, HJob parent);
+}
+
+#endif // DMSDK_JOB_H
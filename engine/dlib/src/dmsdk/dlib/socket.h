@@ -375,6 +375,7 @@ namespace dmSocket
     /*# get host by name with timeout and cancelability
      * Get host by name with timeout and cancelability
      * @note On HTML5, this function is a wrapper for dmSocket::GetHostByName
+     * @note Results are cached for a short while, and a lookup that times out still populates the cache when it completes
      * @name GetHostByName
      * @param name [type:const char*] Hostname to resolve
      * @param address [type:Address*] Host address result
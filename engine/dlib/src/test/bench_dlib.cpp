@@ -0,0 +1,122 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <string.h>
+#include <dlib/benchmark.h>
+#include <dlib/dstrings.h>
+#include <dlib/hash.h>
+#include <dlib/hashtable.h>
+#include <dlib/message.h>
+
+// Benchmarks of the dlib hot paths. Run with --benchmark_out=<path> to get the results as JSON.
+
+static const uint32_t MESSAGE_BATCH_SIZE = 64;
+
+struct HashTableContext
+{
+    dmHashTable64<uint32_t> m_Table;
+    dmhash_t*               m_Keys;
+    uint32_t                m_Count;
+};
+
+static void BenchHashTableGet(void* _ctx, uint32_t iterations)
+{
+    HashTableContext* ctx = (HashTableContext*)_ctx;
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        // Step with a large prime, to not just walk the keys in insertion order
+        uint32_t* value = ctx->m_Table.Get(ctx->m_Keys[(i * 7919) % ctx->m_Count]);
+        sum += *value;
+    }
+    dmBenchmark::DoNotOptimize(&sum);
+}
+
+static void RunHashTable(uint32_t count)
+{
+    HashTableContext ctx;
+    ctx.m_Count = count;
+    ctx.m_Keys = new dmhash_t[count];
+    ctx.m_Table.SetCapacity(count / 2 + 1, count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        char name[32];
+        dmSnPrintf(name, sizeof(name), "/instance%u", i);
+        ctx.m_Keys[i] = dmHashString64(name);
+        ctx.m_Table.Put(ctx.m_Keys[i], i);
+    }
+
+    char name[64];
+    dmSnPrintf(name, sizeof(name), "HashTable64Get/%u", count);
+    dmBenchmark::Run(name, BenchHashTableGet, &ctx, 1);
+    delete [] ctx.m_Keys;
+}
+
+static void BenchHashString64(void* ctx, uint32_t iterations)
+{
+    const char* id = (const char*)ctx;
+    uint32_t id_length = strlen(id);
+    dmhash_t sum = 0;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        sum += dmHashBufferNoReverse64(id, id_length);
+    }
+    dmBenchmark::DoNotOptimize(&sum);
+}
+
+struct MessageData
+{
+    float m_Position[4];
+};
+
+static void HandleMessage(dmMessage::Message* message, void* user_ptr)
+{
+    uint32_t* count = (uint32_t*)user_ptr;
+    *count += message->m_DataSize;
+}
+
+static void BenchMessagePostDispatch(void* ctx, uint32_t iterations)
+{
+    dmMessage::URL* receiver = (dmMessage::URL*)ctx;
+    dmhash_t message_id = dmHashString64("set_position");
+    MessageData data;
+    memset(&data, 0, sizeof(data));
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        for (uint32_t j = 0; j < MESSAGE_BATCH_SIZE; ++j)
+        {
+            dmMessage::Post(0x0, receiver, message_id, 0, 0, 0x0, &data, sizeof(data), 0);
+        }
+        dmMessage::Dispatch(receiver->m_Socket, HandleMessage, &count);
+    }
+    dmBenchmark::DoNotOptimize(&count);
+}
+
+int main(int argc, char **argv)
+{
+    dmBenchmark::Init(argc, argv);
+
+    RunHashTable(1000);
+    RunHashTable(100000);
+
+    dmBenchmark::Run("HashString64/32", BenchHashString64, (void*)"/level/enemies/enemy_with_a_name", 1);
+
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(&receiver);
+    dmMessage::NewSocket("bench_socket", &receiver.m_Socket);
+    dmBenchmark::Run("MessagePostDispatch/64", BenchMessagePostDispatch, &receiver, MESSAGE_BATCH_SIZE);
+    dmMessage::DeleteSocket(receiver.m_Socket);
+
+    return dmBenchmark::Finalize();
+}
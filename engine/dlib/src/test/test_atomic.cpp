@@ -67,6 +67,16 @@ TEST(atomic, CompareStore)
     ASSERT_EQ(123, x);
 }
 
+TEST(atomic, CompareStore64)
+{
+    int64_atomic_t x = 0x100000000LL;
+    // Nop, only the high word matches
+    ASSERT_EQ(0x100000000LL, dmAtomicCompareStore64(&x, 123, 0x100000001LL));
+    ASSERT_EQ(0x100000000LL, x);
+    ASSERT_EQ(0x100000000LL, dmAtomicCompareStore64(&x, 0x200000000LL, 0x100000000LL));
+    ASSERT_EQ(0x200000000LL, x);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
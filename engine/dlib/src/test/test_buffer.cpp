@@ -469,6 +469,217 @@ TEST_F(GetDataTest, CheckOverwrite)
     }
 }
 
+TEST_F(BufferTest, StructOfArrays)
+{
+    dmBuffer::StreamDeclaration streams_decl[] = {
+        {dmHashString64("rgb"), dmBuffer::VALUE_TYPE_UINT8, 3},
+        {dmHashString64("position"), dmBuffer::VALUE_TYPE_FLOAT32, 3},
+    };
+
+    dmBuffer::HBuffer buffer = 0;
+    dmBuffer::Result r = dmBuffer::Create(5, streams_decl, 2, dmBuffer::CREATE_FLAG_STRUCT_OF_ARRAYS, &buffer);
+    ASSERT_EQ(dmBuffer::RESULT_OK, r);
+
+    uint8_t* data = 0;
+    uint32_t datasize = 0;
+    r = dmBuffer::GetBytes(buffer, (void**)&data, &datasize);
+    ASSERT_EQ(dmBuffer::RESULT_OK, r);
+    ASSERT_EQ(0u, ((uintptr_t)data) % 16);
+    ASSERT_EQ(16u + 64u, datasize); // 15 bytes padded to 16, 60 bytes padded to 64
+
+    uint8_t* rgb = 0;
+    uint32_t count, components, stride;
+    r = dmBuffer::GetStream(buffer, dmHashString64("rgb"), (void**)&rgb, &count, &components, &stride);
+    ASSERT_EQ(dmBuffer::RESULT_OK, r);
+    ASSERT_EQ(data, rgb);
+    ASSERT_EQ(5u, count);
+    ASSERT_EQ(3u, stride);
+
+    float* positions = 0;
+    r = dmBuffer::GetStream(buffer, dmHashString64("position"), (void**)&positions, &count, &components, &stride);
+    ASSERT_EQ(dmBuffer::RESULT_OK, r);
+    ASSERT_EQ(data + 16, (uint8_t*)positions);
+    ASSERT_EQ(3u, stride);
+
+    // Writing the padding doesn't trip the guard, but writing past the last stream does
+    memset(data, 0, datasize);
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::ValidateBuffer(buffer));
+    data[datasize] = 0;
+    ASSERT_EQ(dmBuffer::RESULT_GUARD_INVALID, dmBuffer::ValidateBuffer(buffer));
+
+    dmBuffer::Destroy(buffer);
+}
+
+TEST_F(GetDataTest, FillStream)
+{
+    const uint16_t value[] = {7, 9};
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::FillStream(buffer, dmHashString64("texcoord"), value, 1, 3));
+    ASSERT_EQ(dmBuffer::RESULT_BUFFER_SIZE_ERROR, dmBuffer::FillStream(buffer, dmHashString64("texcoord"), value, 2, 3));
+    ASSERT_EQ(dmBuffer::RESULT_STREAM_MISSING, dmBuffer::FillStream(buffer, dmHashString64("missing"), value, 0, 1));
+
+    uint16_t* ptr = 0;
+    CLEAR_OUT_VARS();
+    dmBuffer::Result r = dmBuffer::GetStream(buffer, dmHashString64("texcoord"), (void**)&ptr, &out_count, &out_components, &out_stride);
+    ASSERT_EQ(dmBuffer::RESULT_OK, r);
+    for (uint32_t i = 1; i < out_count; ++i)
+    {
+        ASSERT_EQ(7, ptr[i * out_stride + 0]);
+        ASSERT_EQ(9, ptr[i * out_stride + 1]);
+    }
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::ValidateBuffer(buffer));
+}
+
+TEST_F(BufferTest, CopyStream)
+{
+    dmBuffer::StreamDeclaration streams_decl[] = {
+        {dmHashString64("position"), dmBuffer::VALUE_TYPE_FLOAT32, 3},
+        {dmHashString64("texcoord"), dmBuffer::VALUE_TYPE_FLOAT32, 2},
+    };
+    dmBuffer::HBuffer interleaved = 0;
+    dmBuffer::HBuffer soa = 0;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::Create(8, streams_decl, 2, &interleaved));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::Create(8, streams_decl, 2, dmBuffer::CREATE_FLAG_STRUCT_OF_ARRAYS, &soa));
+
+    float* src = 0;
+    uint32_t count, components, stride;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetStream(soa, dmHashString64("position"), (void**)&src, &count, &components, &stride));
+    for (uint32_t i = 0; i < count * 3; ++i)
+        src[i] = (float)i;
+
+    dmhash_t position = dmHashString64("position");
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::CopyStream(interleaved, position, 2, soa, position, 0, 6));
+    ASSERT_EQ(dmBuffer::RESULT_BUFFER_SIZE_ERROR, dmBuffer::CopyStream(interleaved, position, 3, soa, position, 0, 6));
+    ASSERT_EQ(dmBuffer::RESULT_STREAM_COUNT_MISMATCH, dmBuffer::CopyStream(interleaved, dmHashString64("texcoord"), 0, soa, position, 0, 1));
+
+    float* dst = 0;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetStream(interleaved, position, (void**)&dst, &count, &components, &stride));
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+            ASSERT_EQ(src[i * 3 + c], dst[(i + 2) * stride + c]);
+    }
+
+    // Overlapping copy within the same stream
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::CopyStream(soa, position, 1, soa, position, 0, 7));
+    for (uint32_t i = 1; i < 8; ++i)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+            ASSERT_EQ((float)((i - 1) * 3 + c), src[i * 3 + c]);
+    }
+
+    dmBuffer::Destroy(interleaved);
+    dmBuffer::Destroy(soa);
+}
+
+TEST_F(BufferTest, TransformPositions)
+{
+    dmBuffer::StreamDeclaration streams_decl[] = {
+        {dmHashString64("position"), dmBuffer::VALUE_TYPE_FLOAT32, 3},
+        {dmHashString64("color"), dmBuffer::VALUE_TYPE_UINT8, 4},
+    };
+    dmBuffer::HBuffer buffer = 0;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::Create(3, streams_decl, 2, &buffer));
+
+    float* p = 0;
+    uint32_t count, components, stride;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetStream(buffer, dmHashString64("position"), (void**)&p, &count, &components, &stride));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        p[i * stride + 0] = 1.0f + i;
+        p[i * stride + 1] = 2.0f;
+        p[i * stride + 2] = 3.0f;
+    }
+
+    // Scale by 2 on x, then translate by (10, 20, 30). Column major.
+    const float m[16] = {
+        2.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        10.0f, 20.0f, 30.0f, 1.0f,
+    };
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::TransformPositions(buffer, dmHashString64("position"), m, 1, 2));
+    ASSERT_EQ(dmBuffer::RESULT_STREAM_TYPE_MISMATCH, dmBuffer::TransformPositions(buffer, dmHashString64("color"), m, 0, 1));
+
+    ASSERT_NEAR(1.0f, p[0], RIG_EPSILON);
+    for (uint32_t i = 1; i < count; ++i)
+    {
+        ASSERT_NEAR(2.0f * (1.0f + i) + 10.0f, p[i * stride + 0], RIG_EPSILON);
+        ASSERT_NEAR(22.0f, p[i * stride + 1], RIG_EPSILON);
+        ASSERT_NEAR(33.0f, p[i * stride + 2], RIG_EPSILON);
+    }
+    // The neighbouring stream is left untouched
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::ValidateBuffer(buffer));
+
+    dmBuffer::Destroy(buffer);
+}
+
+TEST_F(GetDataTest, DirtyRanges)
+{
+    uint32_t base_version, version, range_count;
+    const dmBuffer::DirtyRange* ranges;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRanges(buffer, &base_version, &ranges, &range_count));
+    ASSERT_EQ(0u, base_version);
+    ASSERT_EQ(0u, range_count);
+
+    // Adjacent and overlapping ranges are merged
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::AddDirtyRange(buffer, 0, 1));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::AddDirtyRange(buffer, 1, 1));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::AddDirtyRange(buffer, 3, 1));
+    ASSERT_EQ(dmBuffer::RESULT_BUFFER_SIZE_ERROR, dmBuffer::AddDirtyRange(buffer, 3, 2));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRanges(buffer, &base_version, &ranges, &range_count));
+    ASSERT_EQ(2u, range_count);
+    ASSERT_EQ(0u, ranges[0].m_Offset);
+    ASSERT_EQ(2u, ranges[0].m_Count);
+    ASSERT_EQ(3u, ranges[1].m_Offset);
+    ASSERT_EQ(1u, ranges[1].m_Count);
+
+    dmBuffer::GetContentVersion(buffer, &version);
+    ASSERT_EQ(3u, version);
+
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::ClearDirtyRanges(buffer));
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRanges(buffer, &base_version, &ranges, &range_count));
+    ASSERT_EQ(version, base_version);
+    ASSERT_EQ(0u, range_count);
+
+    // An update without a range makes the whole buffer dirty
+    dmBuffer::AddDirtyRange(buffer, 2, 1);
+    dmBuffer::UpdateContentVersion(buffer);
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRanges(buffer, &base_version, &ranges, &range_count));
+    ASSERT_EQ((const dmBuffer::DirtyRange*)0, ranges);
+    ASSERT_EQ(version, base_version);
+}
+
+TEST_F(BufferTest, DirtyRangesOverflow)
+{
+    dmBuffer::StreamDeclaration streams_decl[] = {
+        {dmHashString64("position"), dmBuffer::VALUE_TYPE_FLOAT32, 3},
+    };
+    dmBuffer::HBuffer buffer = 0;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::Create(1000, streams_decl, 1, &buffer));
+
+    for (uint32_t i = 0; i < dmBuffer::MAX_DIRTY_RANGES + 4; ++i)
+    {
+        ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::AddDirtyRange(buffer, i * 10, 2));
+    }
+
+    uint32_t base_version, range_count;
+    const dmBuffer::DirtyRange* ranges;
+    ASSERT_EQ(dmBuffer::RESULT_OK, dmBuffer::GetDirtyRanges(buffer, &base_version, &ranges, &range_count));
+    ASSERT_EQ(dmBuffer::MAX_DIRTY_RANGES, range_count);
+
+    // Every added element is still covered by a range
+    for (uint32_t i = 0; i < dmBuffer::MAX_DIRTY_RANGES + 4; ++i)
+    {
+        bool covered = false;
+        for (uint32_t r = 0; r < range_count; ++r)
+        {
+            covered |= ranges[r].m_Offset <= i * 10 && i * 10 + 2 <= ranges[r].m_Offset + ranges[r].m_Count;
+        }
+        ASSERT_TRUE(covered);
+    }
+
+    dmBuffer::Destroy(buffer);
+}
 
 TEST_P(AlignmentTest, CheckAlignment)
 {
@@ -18,6 +18,8 @@
 #include <jc_test/jc_test.h>
 #include "../dlib/hash.h"
 #include "../dlib/log.h"
+#include "../dlib/thread.h"
+#include "../dlib/dstrings.h"
 
 class dlib : public jc_test_base_class
 {
@@ -425,6 +427,58 @@ TEST_F(dlib, HashMaxReverse)
     free((void*) buffer);
 }
 
+static const uint32_t REVERSE_THREAD_COUNT = 4;
+static const uint32_t REVERSE_STRING_COUNT = 10000;
+
+static void HashReverseConcurrentWorker(void* ctx)
+{
+    uint32_t thread_index = (uint32_t) (uintptr_t) ctx;
+    char tmp[32];
+    for (uint32_t i = 0; i < REVERSE_STRING_COUNT; ++i)
+    {
+        // Strings shared by all threads, and strings that are erased again like generated instance ids
+        uint32_t length = dmSnPrintf(tmp, sizeof(tmp), "reverse_shared_%u", i);
+        dmHashBuffer64(tmp, length);
+
+        length = dmSnPrintf(tmp, sizeof(tmp), "reverse_%u_%u", thread_index, i);
+        uint64_t own = dmHashBuffer64(tmp, length);
+        if ((i % 2) == 0)
+            dmHashReverseErase64(own);
+    }
+}
+
+TEST_F(dlib, HashReverseConcurrent)
+{
+    dmThread::Thread threads[REVERSE_THREAD_COUNT];
+    for (uint32_t t = 0; t < REVERSE_THREAD_COUNT; ++t)
+    {
+        threads[t] = dmThread::New(HashReverseConcurrentWorker, 0x80000, (void*) (uintptr_t) t, "reverse");
+    }
+    for (uint32_t t = 0; t < REVERSE_THREAD_COUNT; ++t)
+    {
+        dmThread::Join(threads[t]);
+    }
+
+    char tmp[32];
+    for (uint32_t i = 0; i < REVERSE_STRING_COUNT; ++i)
+    {
+        uint32_t length = dmSnPrintf(tmp, sizeof(tmp), "reverse_shared_%u", i);
+        uint32_t reverse_length = 0;
+        ASSERT_STREQ(tmp, (const char*) dmHashReverse64(dmHashBufferNoReverse64(tmp, length), &reverse_length));
+        ASSERT_EQ(length, reverse_length);
+
+        for (uint32_t t = 0; t < REVERSE_THREAD_COUNT; ++t)
+        {
+            length = dmSnPrintf(tmp, sizeof(tmp), "reverse_%u_%u", t, i);
+            const char* reverse = (const char*) dmHashReverse64(dmHashBufferNoReverse64(tmp, length), 0);
+            if ((i % 2) == 0)
+                ASSERT_EQ((const char*) 0, reverse);
+            else
+                ASSERT_STREQ(tmp, reverse);
+        }
+    }
+}
+
 TEST_F(dlib, HashIncrementalReverse)
 {
     char* buffer = (char*) malloc(DMHASH_MAX_REVERSE_LENGTH + 1);
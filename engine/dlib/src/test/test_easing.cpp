@@ -41,6 +41,27 @@ TEST(dmEasing, Linear)
     }
 }
 
+TEST(dmEasing, Batch)
+{
+    const uint32_t count = 101;
+    for (uint32_t type = 0; type < dmEasing::TYPE_FLOAT_VECTOR; ++type)
+    {
+        uint8_t types[count];
+        float t[count];
+        float values[count];
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            types[i] = (uint8_t) type;
+            t[i] = i / 99.0f - 0.005f; // also slightly outside [0,1]
+        }
+        dmEasing::GetValues(types, t, values, count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ASSERT_EQ(dmEasing::GetValue((dmEasing::Type) type, t[i]), values[i]);
+        }
+    }
+}
+
 TEST(dmEasing, CurstomCurve)
 {
     dmVMath::FloatVector vector_empty(0);
@@ -0,0 +1,122 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <string.h>
+
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+
+#include "dlib/frame_alloc.h"
+
+static dmFrameAlloc::HAllocator NewAllocator(uint32_t size, uint32_t thread_count)
+{
+    dmFrameAlloc::NewParams params;
+    params.m_Size = size;
+    params.m_ThreadCount = thread_count;
+    params.m_ThreadSize = size;
+    return dmFrameAlloc::New(params);
+}
+
+TEST(dmFrameAlloc, Alignment)
+{
+    dmFrameAlloc::HAllocator allocator = NewAllocator(1024, 0);
+    for (uint32_t i = 1; i < 20; ++i)
+    {
+        void* p = dmFrameAlloc::Alloc(allocator, i);
+        ASSERT_EQ(0U, (uint32_t)((uintptr_t)p % dmFrameAlloc::ALIGNMENT));
+    }
+    dmFrameAlloc::Delete(allocator);
+}
+
+TEST(dmFrameAlloc, DoubleBuffered)
+{
+    dmFrameAlloc::HAllocator allocator = NewAllocator(1024, 0);
+
+    uint8_t* frame0 = (uint8_t*) dmFrameAlloc::Alloc(allocator, 256);
+    memset(frame0, 0xab, 256);
+    ASSERT_EQ(256U, dmFrameAlloc::GetUsage(allocator));
+
+    // The memory of the previous frame is kept intact
+    dmFrameAlloc::NewFrame(allocator);
+    ASSERT_EQ(0U, dmFrameAlloc::GetUsage(allocator));
+    uint8_t* frame1 = (uint8_t*) dmFrameAlloc::Alloc(allocator, 256);
+    ASSERT_NE(frame0, frame1);
+    memset(frame1, 0xcd, 256);
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        ASSERT_EQ(0xab, frame0[i]);
+    }
+
+    // The memory from two frames ago is reused
+    dmFrameAlloc::NewFrame(allocator);
+    uint8_t* frame2 = (uint8_t*) dmFrameAlloc::Alloc(allocator, 256);
+    ASSERT_EQ(frame0, frame2);
+
+    dmFrameAlloc::Delete(allocator);
+}
+
+TEST(dmFrameAlloc, Overflow)
+{
+    dmFrameAlloc::HAllocator allocator = NewAllocator(64, 0);
+
+    // Allocations that don't fit still succeed
+    uint8_t* p[8];
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        p[i] = (uint8_t*) dmFrameAlloc::Alloc(allocator, 48);
+        ASSERT_NE((uint8_t*)0, p[i]);
+        memset(p[i], i, 48);
+    }
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        ASSERT_EQ((uint8_t)i, p[i][47]);
+    }
+    ASSERT_EQ(8U * 48U, dmFrameAlloc::GetHighWaterMark(allocator));
+
+    // Both buffers grow to the high-water mark when they are reused
+    dmFrameAlloc::NewFrame(allocator);
+    dmFrameAlloc::NewFrame(allocator);
+    uint8_t* first = (uint8_t*) dmFrameAlloc::Alloc(allocator, 48);
+    for (uint32_t i = 1; i < 8; ++i)
+    {
+        uint8_t* next = (uint8_t*) dmFrameAlloc::Alloc(allocator, 48);
+        ASSERT_EQ(first + i * 48, next);
+    }
+    ASSERT_EQ(8U * 48U, dmFrameAlloc::GetHighWaterMark(allocator));
+
+    dmFrameAlloc::Delete(allocator);
+}
+
+TEST(dmFrameAlloc, ThreadArenas)
+{
+    dmFrameAlloc::HAllocator allocator = NewAllocator(1024, 2);
+
+    uint8_t* main = (uint8_t*) dmFrameAlloc::Alloc(allocator, 32);
+    uint8_t* worker1 = (uint8_t*) dmFrameAlloc::AllocThread(allocator, 1, 64);
+    uint8_t* worker2 = (uint8_t*) dmFrameAlloc::AllocThread(allocator, 2, 128);
+    ASSERT_NE(main, worker1);
+    ASSERT_NE(worker1, worker2);
+    ASSERT_EQ(32U + 64U + 128U, dmFrameAlloc::GetUsage(allocator));
+
+    dmFrameAlloc::NewFrame(allocator);
+    ASSERT_EQ(0U, dmFrameAlloc::GetUsage(allocator));
+    ASSERT_EQ(32U + 64U + 128U, dmFrameAlloc::GetHighWaterMark(allocator));
+
+    dmFrameAlloc::Delete(allocator);
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
@@ -0,0 +1,290 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <map>
+
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+
+#include "dlib/hashmap.h"
+#include "dlib/hashtable.h"
+#include "dlib/math.h"
+
+TEST(dmHashMap, EmptyConstructor)
+{
+    dmHashMap32<int> map;
+
+    EXPECT_EQ(0U, map.Size());
+    EXPECT_EQ(0U, map.Capacity());
+    EXPECT_TRUE(map.Full());
+    EXPECT_TRUE(map.Empty());
+    EXPECT_EQ(0, map.Get(1));
+}
+
+TEST(dmHashMap, SimplePut)
+{
+    dmHashMap<uint32_t, uint32_t> map;
+    map.SetCapacity(10);
+    map.Put(12, 23);
+
+    uint32_t* val = map.Get(12);
+    ASSERT_NE((uintptr_t) 0, (uintptr_t) val);
+    EXPECT_EQ((uint32_t) 23, *val);
+
+    // Overwriting keeps the count
+    map.Put(12, 24);
+    EXPECT_EQ(1U, map.Size());
+    EXPECT_EQ((uint32_t) 24, *map.Get(12));
+    map.Verify();
+}
+
+TEST(dmHashMap, SimpleErase)
+{
+    dmHashMap<uint32_t, uint32_t> map;
+    map.SetCapacity(2);
+    map.Put(1, 10);
+    map.Put(2, 20);
+
+    map.Verify();
+    map.Erase(1);
+    map.Verify();
+
+    EXPECT_EQ(0, map.Get(1));
+    ASSERT_NE((uintptr_t) 0, (uintptr_t) map.Get(2));
+    EXPECT_EQ((uint32_t) 20, *map.Get(2));
+
+    map.Erase(2);
+    map.Verify();
+    EXPECT_TRUE(map.Empty());
+}
+
+TEST(dmHashMap, Exhaustive)
+{
+    const int N = 300;
+    for (int count = 1; count < N; count += 7)
+    {
+        std::map<uint64_t, uint32_t> ref;
+        dmHashMap64<uint32_t> map;
+        map.SetCapacity(count);
+
+        // Fill, erase half and fill again, to exercise the tombstones
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            while (ref.size() < (uint32_t) count)
+            {
+                uint64_t key = rand() & 0x3ff;
+                uint32_t val = rand();
+                ref[key] = val;
+                map.Put(key, val);
+            }
+            ASSERT_TRUE(map.Full());
+            map.Verify();
+
+            std::map<uint64_t, uint32_t>::iterator iter;
+            for (iter = ref.begin(); iter != ref.end(); ++iter)
+            {
+                ASSERT_NE((void*) 0, map.Get(iter->first));
+                ASSERT_EQ(iter->second, *map.Get(iter->first));
+            }
+
+            int i = 0;
+            for (iter = ref.begin(); iter != ref.end();)
+            {
+                if (i++ & 1)
+                {
+                    map.Erase(iter->first);
+                    ref.erase(iter++);
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
+            map.Verify();
+            ASSERT_EQ((uint32_t) ref.size(), map.Size());
+        }
+    }
+}
+
+TEST(dmHashMap, CollidingControlBytes)
+{
+    // Keys that share the low bits of their hash end up in the same group
+    dmHashMap64<uint32_t> map;
+    map.SetCapacity(1000);
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        map.Put((uint64_t)i << 40, i);
+    }
+    map.Verify();
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        ASSERT_EQ(i, *map.Get((uint64_t)i << 40));
+    }
+    ASSERT_EQ(0, map.Get(1000ULL << 40));
+}
+
+static void IterateCallback(int* context, const uint32_t* key, int* value)
+{
+    *context += *value;
+}
+
+TEST(dmHashMap, Iterate)
+{
+    dmHashMap32<int> map;
+    map.SetCapacity(100);
+    int expected = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        map.Put(i, i * 3);
+        expected += i * 3;
+    }
+    int sum = 0;
+    map.Iterate(IterateCallback, &sum);
+    ASSERT_EQ(expected, sum);
+}
+
+TEST(dmHashMap, Grow)
+{
+    dmHashMap32<uint32_t> map;
+    const uint32_t n = 1000;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        if (map.Full())
+        {
+            map.SetCapacity(map.Capacity() + 17);
+        }
+        map.Put(i, i * 2);
+    }
+    map.Verify();
+    ASSERT_EQ(n, map.Size());
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ(i * 2, *map.Get(i));
+    }
+}
+
+TEST(dmHashMap, Clear)
+{
+    dmHashMap32<uint32_t> map;
+    map.SetCapacity(10);
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        map.Put(i, i);
+    }
+    map.Clear();
+    ASSERT_TRUE(map.Empty());
+    ASSERT_EQ(10U, map.Capacity());
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(0, map.Get(i));
+    }
+    map.Put(5, 50);
+    ASSERT_EQ(50U, *map.Get(5));
+    map.Verify();
+}
+
+TEST(dmHashMap, Swap)
+{
+    dmHashMap32<int> m1;
+    m1.SetCapacity(4);
+    m1.Put(1, 10);
+
+    dmHashMap32<int> m2;
+    m2.SetCapacity(4);
+    m2.Put(2, 20);
+
+    m1.Swap(m2);
+
+    ASSERT_EQ(20, *m1.Get(2));
+    ASSERT_EQ(0, m1.Get(1));
+    ASSERT_EQ(10, *m2.Get(1));
+}
+
+// Compares lookups in dmHashTable and dmHashMap, with dmhash_t-like keys and a hit rate of 50%.
+// Only the timings are printed, as they vary too much on CI machines to be asserted
+template <typename TABLE>
+static float BenchmarkGet(TABLE& table, const uint64_t* keys, uint32_t key_count, uint32_t iterations)
+{
+    uint32_t found = 0;
+    clock_t start = clock();
+    for (uint32_t iter = 0; iter < iterations; ++iter)
+    {
+        for (uint32_t i = 0; i < key_count; ++i)
+        {
+            found += table.Get(keys[i]) != 0;
+        }
+    }
+    clock_t end = clock();
+    EXPECT_EQ(iterations * key_count / 2, found);
+    return (float)(end - start) * 1000.0f / CLOCKS_PER_SEC;
+}
+
+static uint64_t RandomKey()
+{
+    return ((uint64_t)rand() << 48) ^ ((uint64_t)rand() << 32) ^ ((uint64_t)rand() << 16) ^ (uint64_t)rand();
+}
+
+TEST(dmHashMap, Benchmark)
+{
+    const uint32_t sizes[] = { 64, 1024, 16384, 262144 };
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        const uint32_t n = sizes[s];
+        const uint32_t iterations = dmMath::Max(1U, 4000000 / n);
+
+        // Every other key is inserted
+        uint64_t* keys = new uint64_t[n * 2];
+        for (uint32_t i = 0; i < n * 2; ++i)
+        {
+            keys[i] = RandomKey();
+        }
+
+        // The table sizes used by the engine, e.g. the resource factory
+        dmHashTable64<uint32_t> ht;
+        ht.SetCapacity((3 * n) / 4, n);
+        dmHashMap64<uint32_t> map;
+        map.SetCapacity(n);
+
+        clock_t start = clock();
+        for (uint32_t i = 0; i < n * 2; i += 2)
+        {
+            ht.Put(keys[i], i);
+        }
+        float ht_put = (float)(clock() - start) * 1000.0f / CLOCKS_PER_SEC;
+
+        start = clock();
+        for (uint32_t i = 0; i < n * 2; i += 2)
+        {
+            map.Put(keys[i], i);
+        }
+        float map_put = (float)(clock() - start) * 1000.0f / CLOCKS_PER_SEC;
+
+        float ht_get = BenchmarkGet(ht, keys, n * 2, iterations);
+        float map_get = BenchmarkGet(map, keys, n * 2, iterations);
+
+        printf("%7u entries: Put dmHashTable %7.2f ms dmHashMap %7.2f ms, %u x Get dmHashTable %7.2f ms dmHashMap %7.2f ms\n",
+                n, ht_put, map_put, iterations * n * 2, ht_get, map_get);
+
+        delete [] keys;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
@@ -15,6 +15,7 @@
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include "../dlib/http_cache.h"
+#include "../dlib/http_cache_verify.h"
 #include "../dlib/sys.h"
 #include "../dlib/time.h"
 #include "../dlib/hash.h"
@@ -682,6 +683,95 @@ TEST_F(dmHttpCacheTest, Persist)
     dmHttpCache::Close(cache);
 }
 
+TEST_F(dmHttpCacheTest, PersistUpdate)
+{
+    dmHttpCache::HCache cache;
+    dmHttpCache::NewParams params;
+    params.m_Path = "tmp/cache";
+    dmHttpCache::Result r = dmHttpCache::Open(&params, &cache);
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+
+    const char* data1 = "data1";
+    const char* data2 = "data2";
+    const char* data3 = "data3";
+    r = Put(cache, "uri1", "etag1", data1, strlen(data1));
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    r = Put(cache, "uri2", "etag2", data2, strlen(data2));
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    ASSERT_EQ(dmHttpCache::RESULT_OK, dmHttpCache::Flush(cache));
+
+    // Only the changed entries are written on flush
+    r = Put(cache, "uri2", "etag2b", data3, strlen(data3));
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    r = Put(cache, "uri3", "etag3", data3, strlen(data3));
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    dmHttpCache::Close(cache);
+
+    r = dmHttpCache::Open(&params, &cache);
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    ASSERT_EQ(3U, dmHttpCache::GetEntryCount(cache));
+
+    char tag_buffer[16];
+    r = dmHttpCache::GetETag(cache, "uri1", tag_buffer, sizeof(tag_buffer));
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    ASSERT_STREQ("etag1", tag_buffer);
+    r = dmHttpCache::GetETag(cache, "uri2", tag_buffer, sizeof(tag_buffer));
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    ASSERT_STREQ("etag2b", tag_buffer);
+
+    void* buffer = 0;
+    uint64_t checksum;
+    r = Get(cache, "uri3", "etag3", &buffer, &checksum);
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    ASSERT_EQ(dmHashString64(data3), checksum);
+    free(buffer);
+
+    dmHttpCache::Close(cache);
+}
+
+TEST_F(dmHttpCacheTest, ContentManifest)
+{
+    dmHttpCache::HCache cache;
+    dmHttpCache::NewParams params;
+    params.m_Path = "tmp/cache";
+    dmHttpCache::Result r = dmHttpCache::Open(&params, &cache);
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+
+    ASSERT_EQ(dmHttpCache::RESULT_OK, Put(cache, "/a", "hash_a", "data_a", strlen("data_a")));
+    ASSERT_EQ(dmHttpCache::RESULT_OK, Put(cache, "/b", "hash_b", "data_b", strlen("data_b")));
+
+    // a is unchanged, b is changed, c has the same content as a and d is new
+    const char* manifest = "/a hash_a\n/b hash_b2\n/c hash_a\n/d hash_d";
+    uint32_t verified_count;
+    uint32_t added_count;
+    dmHttpCacheVerify::Result vr = dmHttpCacheVerify::ApplyContentManifest(cache, manifest, strlen(manifest), &verified_count, &added_count);
+    ASSERT_EQ(dmHttpCacheVerify::RESULT_OK, vr);
+    ASSERT_EQ(2U, verified_count);
+    ASSERT_EQ(1U, added_count);
+    ASSERT_EQ(3U, dmHttpCache::GetEntryCount(cache));
+
+    dmHttpCache::EntryInfo info;
+    ASSERT_EQ(dmHttpCache::RESULT_OK, dmHttpCache::GetInfo(cache, "/a", &info));
+    ASSERT_TRUE(info.m_Verified);
+    ASSERT_EQ(dmHttpCache::RESULT_OK, dmHttpCache::GetInfo(cache, "/b", &info));
+    ASSERT_FALSE(info.m_Verified);
+    ASSERT_EQ(dmHttpCache::RESULT_OK, dmHttpCache::GetInfo(cache, "/c", &info));
+    ASSERT_TRUE(info.m_Verified);
+    ASSERT_STREQ("hash_a", info.m_ETag);
+    ASSERT_EQ(dmHttpCache::RESULT_NO_ENTRY, dmHttpCache::GetInfo(cache, "/d", &info));
+
+    void* buffer = 0;
+    uint64_t checksum;
+    r = Get(cache, "/c", "hash_a", &buffer, &checksum);
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    ASSERT_EQ(dmHashString64("data_a"), checksum);
+    ASSERT_TRUE(memcmp("data_a", buffer, strlen("data_a")) == 0);
+    free(buffer);
+
+    r = dmHttpCache::Close(cache);
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -120,6 +120,35 @@ TEST(dmImage, Premult)
     dmImage::Free(&image);
 }
 
+TEST(dmImage, PremultiplyBuffer)
+{
+    // Odd sizes so that both the vectorized loop and the remainder are used
+    const int width = 13;
+    const int height = 3;
+    uint8_t buffer[width * height * 4];
+    uint8_t expected[width * height * 4];
+    for (int i = 0; i < width * height * 4; ++i)
+    {
+        buffer[i] = (uint8_t) ((i * 97 + 31) & 0xff);
+    }
+    buffer[3] = 0;
+    buffer[7] = 255;
+    for (int i = 0; i < width * height; ++i)
+    {
+        uint32_t a = buffer[i * 4 + 3];
+        expected[i * 4 + 0] = (uint8_t) ((buffer[i * 4 + 0] * a + 255) >> 8);
+        expected[i * 4 + 1] = (uint8_t) ((buffer[i * 4 + 1] * a + 255) >> 8);
+        expected[i * 4 + 2] = (uint8_t) ((buffer[i * 4 + 2] * a + 255) >> 8);
+        expected[i * 4 + 3] = (uint8_t) a;
+    }
+
+    dmImage::Premultiply(buffer, width, height);
+    for (int i = 0; i < width * height * 4; ++i)
+    {
+        ASSERT_EQ((uint32_t) expected[i], (uint32_t) buffer[i]);
+    }
+}
+
 TEST(dmImage, Indexed)
 {
     dmImage::Image image;
@@ -0,0 +1,237 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <string.h>
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+#include "../dlib/job.h"
+#include "../dlib/atomic.h"
+#include "../dlib/time.h"
+
+class JobTest : public jc_test_params_class<uint32_t>
+{
+protected:
+    virtual void SetUp()
+    {
+        dmJob::NewContextParams params;
+        params.m_WorkerCount = GetParam();
+        params.m_MaxJobs = 1024;
+        params.m_QueueCapacity = 256;
+        m_Context = dmJob::NewContext(params);
+        ASSERT_NE((dmJob::HContext) 0, m_Context);
+    }
+
+    virtual void TearDown()
+    {
+        dmJob::DeleteContext(m_Context);
+    }
+
+    dmJob::HContext m_Context;
+};
+
+static void IncrementJob(void* context, void* data)
+{
+    dmAtomicIncrement32((int32_atomic_t*) context);
+}
+
+struct OrderContext
+{
+    int32_atomic_t  m_Next;
+    int32_t         m_Order[4];
+};
+
+static void OrderJob(void* context, void* data)
+{
+    OrderContext* ctx = (OrderContext*) context;
+    int32_t slot = dmAtomicIncrement32(&ctx->m_Next);
+    ctx->m_Order[slot] = (int32_t) (uintptr_t) data;
+}
+
+static void RangeJob(void* context, uint32_t start, uint32_t end)
+{
+    uint32_t* values = (uint32_t*) context;
+    for (uint32_t i = start; i < end; ++i)
+    {
+        values[i] += i;
+    }
+}
+
+TEST_P(JobTest, Single)
+{
+    int32_atomic_t count = 0;
+    dmJob::HJob job = dmJob::CreateJob(m_Context, IncrementJob, (void*) &count, 0, dmJob::INVALID_JOB);
+    ASSERT_NE(dmJob::INVALID_JOB, job);
+    ASSERT_FALSE(dmJob::IsFinished(m_Context, job));
+    ASSERT_EQ(dmJob::RESULT_OK, dmJob::Run(m_Context, job));
+    ASSERT_NE(dmJob::RESULT_OK, dmJob::Run(m_Context, job));
+    dmJob::Wait(m_Context, job);
+    ASSERT_TRUE(dmJob::IsFinished(m_Context, job));
+    ASSERT_EQ(1, count);
+}
+
+TEST_P(JobTest, Children)
+{
+    int32_atomic_t count = 0;
+    dmJob::HJob group = dmJob::CreateGroup(m_Context, dmJob::INVALID_JOB);
+    for (uint32_t i = 0; i < 500; ++i)
+    {
+        dmJob::HJob job = dmJob::CreateJob(m_Context, IncrementJob, (void*) &count, 0, group);
+        ASSERT_NE(dmJob::INVALID_JOB, job);
+        dmJob::Run(m_Context, job);
+    }
+    dmJob::Run(m_Context, group);
+    dmJob::Wait(m_Context, group);
+    ASSERT_EQ(500, count);
+}
+
+TEST_P(JobTest, Dependencies)
+{
+    OrderContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+
+    dmJob::HJob a = dmJob::CreateJob(m_Context, OrderJob, &ctx, (void*) 0, dmJob::INVALID_JOB);
+    dmJob::HJob b = dmJob::CreateJob(m_Context, OrderJob, &ctx, (void*) 1, dmJob::INVALID_JOB);
+    dmJob::HJob c = dmJob::CreateJob(m_Context, OrderJob, &ctx, (void*) 2, dmJob::INVALID_JOB);
+    ASSERT_EQ(dmJob::RESULT_OK, dmJob::AddDependency(m_Context, c, b));
+    ASSERT_EQ(dmJob::RESULT_OK, dmJob::AddDependency(m_Context, b, a));
+
+    dmJob::Run(m_Context, c);
+    dmJob::Run(m_Context, b);
+    ASSERT_FALSE(dmJob::IsFinished(m_Context, c));
+    dmJob::Run(m_Context, a);
+    dmJob::Wait(m_Context, c);
+
+    ASSERT_EQ(3, ctx.m_Next);
+    ASSERT_EQ(0, ctx.m_Order[0]);
+    ASSERT_EQ(1, ctx.m_Order[1]);
+    ASSERT_EQ(2, ctx.m_Order[2]);
+}
+
+TEST_P(JobTest, DependencyFinished)
+{
+    int32_atomic_t count = 0;
+    dmJob::HJob a = dmJob::CreateJob(m_Context, IncrementJob, (void*) &count, 0, dmJob::INVALID_JOB);
+    dmJob::Run(m_Context, a);
+    dmJob::Wait(m_Context, a);
+
+    dmJob::HJob b = dmJob::CreateJob(m_Context, IncrementJob, (void*) &count, 0, dmJob::INVALID_JOB);
+    ASSERT_EQ(dmJob::RESULT_OK, dmJob::AddDependency(m_Context, b, a));
+    dmJob::Run(m_Context, b);
+    dmJob::Wait(m_Context, b);
+    ASSERT_EQ(2, count);
+}
+
+TEST_P(JobTest, ParallelFor)
+{
+    const uint32_t count = 10000;
+    uint32_t* values = new uint32_t[count];
+    memset(values, 0, sizeof(uint32_t) * count);
+
+    dmJob::HJob job = dmJob::ParallelFor(m_Context, RangeJob, values, count, 64, dmJob::INVALID_JOB);
+    dmJob::Wait(m_Context, job);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(i, values[i]);
+    }
+    delete [] values;
+}
+
+TEST_P(JobTest, ParallelForNoContext)
+{
+    uint32_t values[16] = {0};
+    dmJob::HJob job = dmJob::ParallelFor(0, RangeJob, values, 16, 4, dmJob::INVALID_JOB);
+    ASSERT_EQ(dmJob::INVALID_JOB, job);
+    ASSERT_EQ(15U, values[15]);
+}
+
+TEST_P(JobTest, OutOfJobs)
+{
+    int32_atomic_t count = 0;
+    dmJob::HJob jobs[1024];
+    for (uint32_t i = 0; i < 1024; ++i)
+    {
+        jobs[i] = dmJob::CreateJob(m_Context, IncrementJob, (void*) &count, 0, dmJob::INVALID_JOB);
+        ASSERT_NE(dmJob::INVALID_JOB, jobs[i]);
+    }
+    ASSERT_EQ(dmJob::INVALID_JOB, dmJob::CreateJob(m_Context, IncrementJob, (void*) &count, 0, dmJob::INVALID_JOB));
+
+    // More jobs than the queue capacity, overflowing jobs are executed immediately
+    for (uint32_t i = 0; i < 1024; ++i)
+    {
+        dmJob::Run(m_Context, jobs[i]);
+    }
+    for (uint32_t i = 0; i < 1024; ++i)
+    {
+        dmJob::Wait(m_Context, jobs[i]);
+    }
+    ASSERT_EQ(1024, count);
+}
+
+TEST_P(JobTest, Flush)
+{
+    int32_atomic_t count = 0;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        dmJob::Run(m_Context, dmJob::CreateJob(m_Context, IncrementJob, (void*) &count, 0, dmJob::INVALID_JOB));
+    }
+    dmJob::Flush(m_Context);
+    if (dmJob::GetWorkerCount(m_Context) == 0)
+    {
+        ASSERT_EQ(100, count);
+    }
+    // Jobs may still be running on the workers
+    while (dmAtomicAdd32(&count, 0) != 100)
+    {
+        dmTime::Sleep(0);
+    }
+}
+
+struct ThreadIndexContext
+{
+    dmJob::HContext m_Context;
+    int32_atomic_t  m_Invalid;
+};
+
+static void ThreadIndexJob(void* context, void* data)
+{
+    ThreadIndexContext* ctx = (ThreadIndexContext*) context;
+    if (dmJob::GetThreadIndex(ctx->m_Context) > dmJob::GetWorkerCount(ctx->m_Context))
+        dmAtomicIncrement32(&ctx->m_Invalid);
+}
+
+TEST_P(JobTest, ThreadIndex)
+{
+    ASSERT_EQ(0U, dmJob::GetThreadIndex(m_Context));
+
+    ThreadIndexContext ctx;
+    ctx.m_Context = m_Context;
+    ctx.m_Invalid = 0;
+    dmJob::HJob group = dmJob::CreateGroup(m_Context, dmJob::INVALID_JOB);
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        dmJob::Run(m_Context, dmJob::CreateJob(m_Context, ThreadIndexJob, &ctx, 0, group));
+    }
+    dmJob::Run(m_Context, group);
+    dmJob::Wait(m_Context, group);
+    ASSERT_EQ(0, ctx.m_Invalid);
+}
+
+const uint32_t worker_counts[] = {0, 1, 4};
+INSTANTIATE_TEST_CASE_P(JobTest, JobTest, jc_test_values_in(worker_counts));
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
@@ -670,6 +670,34 @@ TEST_F(dmJsonTest, Flickr)
     ASSERT_EQ(dmJson::RESULT_OK, dmJson::Parse(json.c_str(), &doc));
 }
 
+TEST_F(dmJsonTest, LargeArray)
+{
+    // Many more tokens than the initial estimate, forcing the token array to grow while parsing
+    const uint32_t count = 100000;
+    std::string json = "[";
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        json += i == 0 ? "1" : ",1";
+    }
+    json += ",\"a\\nb\"]";
+
+    ASSERT_EQ(dmJson::RESULT_OK, dmJson::Parse(json.c_str(), json.size(), &doc));
+    ASSERT_EQ((int) count + 2, doc.m_NodeCount);
+    ASSERT_EQ(dmJson::TYPE_ARRAY, doc.m_Nodes[0].m_Type);
+    ASSERT_EQ((int) count + 1, doc.m_Nodes[0].m_Size);
+    const dmJson::Node& last = doc.m_Nodes[count + 1];
+    ASSERT_EQ(dmJson::TYPE_STRING, last.m_Type);
+    ASSERT_EQ(0, strncmp("a\nb", doc.m_Json + last.m_Start, last.m_End - last.m_Start));
+}
+
+TEST_F(dmJsonTest, NotNullTerminated)
+{
+    const char json[] = { '[', '1', ',', '2', ']', 'x' };
+    ASSERT_EQ(dmJson::RESULT_OK, dmJson::Parse(json, 5, &doc));
+    ASSERT_EQ(3, doc.m_NodeCount);
+    ASSERT_EQ('\0', doc.m_Json[5]);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -151,6 +151,41 @@ TEST(dmLog, TestCapture)
     dmSetCustomLogCallback(0x0, 0x0);
 }
 
+static void TestLogCountCallback(void* user_data, const char* log)
+{
+    uint32_t* count = (uint32_t*)user_data;
+    *count += 1;
+}
+
+TEST(dmLog, TestRateLimit)
+{
+    uint32_t count = 0;
+    dmSetCustomLogCallback(TestLogCountCallback, &count);
+    for (int i = 0; i < 100; ++i)
+    {
+        dmLogWarning("Rate limited warning %d", i);
+    }
+    ASSERT_GT(100u, count);
+
+    // User prints are never suppressed
+    count = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        dmLogUserDebug("%s", "print");
+    }
+    ASSERT_EQ(100u, count);
+
+    // The number of suppressed messages is logged the next second
+    dmArray<char> log_output;
+    dmSetCustomLogCallback(TestLogCaptureCallback, &log_output);
+    dmTime::Sleep(1100000);
+    dmLogWarning("Rate limited warning %d", 0);
+    log_output.Push(0);
+    ASSERT_TRUE(strstr(log_output.Begin(), "WARNING:DLIB: Suppressed") != 0);
+    ASSERT_TRUE(strstr(log_output.Begin(), "WARNING:DLIB: Rate limited warning 0\n") != 0);
+    dmSetCustomLogCallback(0x0, 0x0);
+}
+
 int main(int argc, char **argv)
 {
     dmSocket::Initialize();
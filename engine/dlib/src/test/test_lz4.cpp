@@ -74,6 +74,33 @@ TEST(dmLZ4, Compress)
     ASSERT_EQ(memcmp("bar", decompressed, 3), 0);
 }
 
+TEST(dmLZ4, CompressWithDictionary)
+{
+    const char* dictionary = "material: \"/builtins/materials/sprite.material\" blend_mode: BLEND_MODE_ALPHA default_animation: \"anim\"";
+    const char* data = "tile_set: \"/main/main.atlas\" default_animation: \"anim\" material: \"/builtins/materials/sprite.material\"";
+    uint32_t dictionary_size = strlen(dictionary);
+    uint32_t data_size = strlen(data);
+
+    char compressed[256];
+    char compressed_with_dictionary[256];
+    char decompressed[256];
+
+    int compressed_size, compressed_with_dictionary_size;
+    dmLZ4::Result r = dmLZ4::CompressBuffer(data, data_size, compressed, &compressed_size);
+    ASSERT_EQ(dmLZ4::RESULT_OK, r);
+    r = dmLZ4::CompressBufferWithDictionary(data, data_size, compressed_with_dictionary, &compressed_with_dictionary_size, dictionary, dictionary_size);
+    ASSERT_EQ(dmLZ4::RESULT_OK, r);
+    ASSERT_LT(compressed_with_dictionary_size, compressed_size);
+
+    r = dmLZ4::DecompressBufferWithDictionary(compressed_with_dictionary, compressed_with_dictionary_size, decompressed, data_size, dictionary, dictionary_size);
+    ASSERT_EQ(dmLZ4::RESULT_OK, r);
+    ASSERT_ARRAY_EQ_LEN(data, decompressed, data_size);
+
+    // Wrong size
+    r = dmLZ4::DecompressBufferWithDictionary(compressed_with_dictionary, compressed_with_dictionary_size, decompressed, data_size - 1, dictionary, dictionary_size);
+    ASSERT_NE(dmLZ4::RESULT_OK, r);
+}
+
 char * RandomCharArray(int max, int *real)
 {
     char *tmp;
@@ -321,6 +321,30 @@ TEST(dmMemProfile, TestTrace1)
 }
 #endif
 
+TEST(dmMemProfile, TestTagScope)
+{
+    dmMemProfile::Tag* before = dmMemProfile::GetTag();
+    {
+        DM_MEM_SCOPE(Outer);
+        {
+            DM_MEM_SCOPE(Inner);
+            if (g_MemprofileActive)
+            {
+                ASSERT_STREQ("Inner", dmMemProfile::GetTag()->m_Name);
+                ASSERT_STREQ("Memory.Inner.Amount", dmMemProfile::GetTag()->m_AmountCounter);
+            }
+            void* p = malloc(256);
+            g_dont_optimize = p;
+            free(p);
+        }
+        if (g_MemprofileActive)
+        {
+            ASSERT_STREQ("Outer", dmMemProfile::GetTag()->m_Name);
+        }
+    }
+    ASSERT_EQ(before, dmMemProfile::GetTag());
+}
+
 #endif // SANITIZE ADDRESS/MEMORY
 
 int main(int argc, char **argv)
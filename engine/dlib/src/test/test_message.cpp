@@ -355,6 +355,142 @@ TEST(dmMessage, ThreadTest2)
     ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
 }
 
+struct OrderPostContext
+{
+    dmMessage::URL  m_Receiver;
+    uint32_t        m_Thread;
+};
+
+static void OrderPostThread(void* arg)
+{
+    OrderPostContext* ctx = (OrderPostContext*) arg;
+    for (uint32_t i = 0; i < 4096; ++i)
+    {
+        uint32_t m[2] = {ctx->m_Thread, i};
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &ctx->m_Receiver, m_HashMessage1, 0, 0x0, m, sizeof(m), 0));
+    }
+}
+
+static void HandleOrderMessage(dmMessage::Message *message_object, void *user_ptr)
+{
+    uint32_t* next = (uint32_t*) user_ptr;
+    uint32_t* m = (uint32_t*) message_object->m_Data;
+    assert(m[0] < 4);
+    // Messages from the same thread arrive in posting order
+    assert(next[m[0]] == m[1]);
+    next[m[0]]++;
+}
+
+TEST(dmMessage, ThreadOrder)
+{
+    OrderPostContext ctx[4];
+    dmThread::Thread threads[4];
+    dmMessage::HSocket socket;
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &socket));
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        dmMessage::ResetURL(&ctx[i].m_Receiver);
+        ctx[i].m_Receiver.m_Socket = socket;
+        ctx[i].m_Thread = i;
+        threads[i] = dmThread::New(&OrderPostThread, 0xf0000, (void*) &ctx[i], "post");
+    }
+
+    uint32_t next[4] = {0};
+    uint32_t count = 0;
+    while (count < 4096 * 4)
+    {
+        count += dmMessage::Dispatch(socket, HandleOrderMessage, next);
+    }
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        dmThread::Join(threads[i]);
+        ASSERT_EQ(4096U, next[i]);
+    }
+
+    dmMessage::SocketStats stats;
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::GetSocketStats(socket, &stats));
+    ASSERT_EQ(4096U * 4U, stats.m_PostCount);
+    ASSERT_EQ(4096U * 4U, stats.m_DispatchCount);
+    ASSERT_EQ(0U, stats.m_QueueDepth);
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(socket));
+}
+
+TEST(dmMessage, SocketStats)
+{
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(&receiver);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &receiver.m_Socket));
+
+    dmMessage::SocketStats stats;
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &receiver, m_HashMessage1, 0, 0x0, 0x0, 0, 0));
+    }
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::GetSocketStats(receiver.m_Socket, &stats));
+    ASSERT_EQ(10U, stats.m_PostCount);
+    ASSERT_EQ(0U, stats.m_DispatchCount);
+    ASSERT_EQ(10U, stats.m_QueueDepth);
+
+    ASSERT_EQ(10U, dmMessage::Dispatch(receiver.m_Socket, HandleMessage, 0));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &receiver, m_HashMessage1, 0, 0x0, 0x0, 0, 0));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::GetSocketStats(receiver.m_Socket, &stats));
+    ASSERT_EQ(11U, stats.m_PostCount);
+    ASSERT_EQ(10U, stats.m_DispatchCount);
+    ASSERT_EQ(1U, stats.m_QueueDepth);
+    ASSERT_EQ(10U, stats.m_MaxQueueDepth);
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
+    ASSERT_EQ(dmMessage::RESULT_SOCKET_NOT_FOUND, dmMessage::GetSocketStats(receiver.m_Socket, &stats));
+}
+
+static void HandleBatchMessage(dmMessage::Message *message_object, void *user_ptr)
+{
+    uint32_t* next = (uint32_t*) user_ptr;
+    assert(message_object->m_DataSize == sizeof(uint32_t) * 3);
+    uint32_t* m = (uint32_t*) message_object->m_Data;
+    assert(m[0] == *next && m[1] == ~*next && m[2] == *next);
+    (*next)++;
+}
+
+TEST(dmMessage, Batch)
+{
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(&receiver);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &receiver.m_Socket));
+
+    const uint32_t count = 1000; // Spans several pages
+    dmMessage::Batch batch;
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::BeginBatch(receiver.m_Socket, count, sizeof(uint32_t) * 3, &batch));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t* m = (uint32_t*) dmMessage::BatchPost(&batch, 0x0, &receiver, m_HashMessage1, 0, 0, 0, sizeof(uint32_t) * 3, 0);
+        ASSERT_NE((uint32_t*) 0, m);
+        m[0] = i;
+        m[1] = ~i;
+        m[2] = i;
+    }
+
+    // Not visible until the batch is ended
+    ASSERT_FALSE(dmMessage::HasMessages(receiver.m_Socket));
+    ASSERT_EQ(count, dmMessage::EndBatch(&batch));
+    ASSERT_TRUE(dmMessage::HasMessages(receiver.m_Socket));
+
+    uint32_t next = 0;
+    ASSERT_EQ(count, dmMessage::Dispatch(receiver.m_Socket, HandleBatchMessage, &next));
+    ASSERT_EQ(count, next);
+
+    // Wrong socket
+    dmMessage::URL other;
+    dmMessage::ResetURL(&other);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::BeginBatch(receiver.m_Socket, 1, 0, &batch));
+    ASSERT_EQ((void*) 0, dmMessage::BatchPost(&batch, 0x0, &other, m_HashMessage1, 0, 0, 0, 0, 0));
+    ASSERT_EQ(0U, dmMessage::EndBatch(&batch));
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
+    ASSERT_EQ(dmMessage::RESULT_SOCKET_NOT_FOUND, dmMessage::BeginBatch(receiver.m_Socket, 1, 0, &batch));
+}
+
 void HandleIntegrityMessage(dmMessage::Message *message_object, void *user_ptr)
 {
     dmhash_t hash = dmHashBuffer64(message_object->m_Data, message_object->m_DataSize);
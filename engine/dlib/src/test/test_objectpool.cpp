@@ -21,6 +21,7 @@
 #include <jc_test/jc_test.h>
 
 #include "dlib/object_pool.h"
+#include "dlib/paged_object_pool.h"
 
 struct Object
 {
@@ -177,6 +178,100 @@ TEST(dmObjectPool, Stress)
 }
 
 
+TEST(dmPagedObjectPool, Test)
+{
+    dmPagedObjectPool<Object, 2> pool;
+    const uint32_t n = 10;
+    pool.SetCapacity(n);
+    ASSERT_EQ(0U, pool.AllocatedCapacity());
+
+    uint32_t ids[n];
+    Object* addresses[n];
+    for (uint32_t i = 0; i < n; i++) {
+        ids[i] = pool.Alloc();
+        Object* o = &pool.Get(ids[i]);
+        ASSERT_EQ(0U, o->m_Value);
+        o->m_Value = i;
+        addresses[i] = o;
+    }
+    ASSERT_TRUE(pool.Full());
+    ASSERT_EQ(12U, pool.AllocatedCapacity());
+
+    // Growing doesn't move the objects
+    pool.SetCapacity(n + 6);
+    for (uint32_t i = 0; i < 6; i++) {
+        pool.Get(pool.Alloc()).m_Value = 0;
+    }
+    ASSERT_TRUE(pool.Full());
+    ASSERT_EQ(16U, pool.AllocatedCapacity());
+    for (uint32_t i = 0; i < n; i++) {
+        ASSERT_EQ(addresses[i], &pool.Get(ids[i]));
+        ASSERT_EQ(i, pool.Get(ids[i]).m_Value);
+    }
+
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < pool.Size(); i++) {
+        sum += pool.GetPhysical(i).m_Value;
+    }
+    ASSERT_EQ((n - 1) * n / 2, sum);
+
+    pool.Free(ids[7], true);
+    pool.Free(ids[2], true);
+    ASSERT_FALSE(pool.Full());
+    ASSERT_EQ(n + 4, pool.Size());
+
+    sum = 0;
+    for (uint32_t i = 0; i < pool.Size(); i++) {
+        sum += pool.GetPhysical(i).m_Value;
+    }
+    ASSERT_EQ((n - 1) * n / 2 - 7 - 2, sum);
+    for (uint32_t i = 0; i < n; i++) {
+        if (i != 7 && i != 2) {
+            ASSERT_EQ(i, pool.Get(ids[i]).m_Value);
+        }
+    }
+
+    // Cleared slots are reused
+    uint32_t id = pool.Alloc();
+    ASSERT_EQ(0U, pool.Get(id).m_Value);
+}
+
+TEST(dmPagedObjectPool, Stress)
+{
+    dmPagedObjectPool<Object, 3> pool;
+    const uint32_t n = 100;
+    pool.SetCapacity(n);
+    uint32_t next_value = 0;
+
+    std::map<uint32_t, uint32_t> values;
+    for (uint32_t iter = 0; iter < 5000; iter++) {
+        if (rand() % 3 != 0) {
+            if (!pool.Full()) {
+                uint32_t id = pool.Alloc();
+                pool.Get(id).m_Value = next_value;
+                values[id] = next_value++;
+            }
+        } else if (pool.Size() > 0) {
+            std::map<uint32_t, uint32_t>::iterator it = values.begin();
+            std::advance(it, rand() % values.size());
+            pool.Free(it->first, true);
+            values.erase(it);
+        }
+        ASSERT_EQ((uint32_t) values.size(), pool.Size());
+    }
+
+    uint64_t sum = 0;
+    uint64_t sum2 = 0;
+    for (uint32_t i = 0; i < pool.Size(); i++) {
+        sum += pool.GetPhysical(i).m_Value;
+    }
+    for (std::map<uint32_t, uint32_t>::iterator i = values.begin(); i != values.end(); ++i) {
+        ASSERT_EQ(i->second, pool.Get(i->first).m_Value);
+        sum2 += i->second;
+    }
+    ASSERT_EQ(sum, sum2);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
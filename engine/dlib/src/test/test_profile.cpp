@@ -21,6 +21,7 @@
 #include "dlib/profile.h"
 #include "dlib/time.h"
 #include "dlib/thread.h"
+#include "dlib/sys.h"
 
 #if !defined(_WIN32)
 
@@ -388,6 +389,124 @@ TEST(dmProfile, ThreadProfile)
     dmProfile::Finalize();
 }
 
+void ProfileThreadShort(void* arg)
+{
+    for (int i = 0; i < 1000; ++i)
+    {
+        DM_PROFILE(X, "a")
+    }
+}
+
+TEST(dmProfile, ThreadSampleLimit)
+{
+    // The sample limit is per thread
+    dmProfile::Initialize(128, 1000, 16);
+
+    dmProfile::HProfile profile = dmProfile::Begin();
+    dmProfile::Release(profile);
+    dmThread::Thread threads[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        threads[i] = dmThread::New(ProfileThreadShort, 0xf0000, 0, "p");
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        dmThread::Join(threads[i]);
+    }
+
+    std::vector<dmProfile::Sample> samples;
+    profile = dmProfile::Begin();
+    dmProfile::IterateSamples(profile, &samples, false, &ProfileSampleCallback);
+    ASSERT_FALSE(dmProfile::IsOutOfSamples());
+    dmProfile::Release(profile);
+
+    ASSERT_EQ(4000U, samples.size());
+    for (uint32_t i = 1; i < samples.size(); ++i)
+    {
+        // Samples are grouped per thread, in the order they were started
+        if (samples[i].m_ThreadId == samples[i-1].m_ThreadId)
+        {
+            ASSERT_GE(samples[i].m_Start, samples[i-1].m_Start);
+        }
+    }
+
+    // The buffers are reset when the threads profile in a new frame
+    profile = dmProfile::Begin();
+    samples.clear();
+    dmProfile::IterateSamples(profile, &samples, false, &ProfileSampleCallback);
+    dmProfile::Release(profile);
+    ASSERT_EQ(0U, samples.size());
+
+    dmProfile::Finalize();
+}
+
+TEST(dmProfile, GpuSamples)
+{
+    dmProfile::Initialize(128, 1024, 16);
+
+    dmProfile::HProfile profile = dmProfile::Begin();
+    dmProfile::Release(profile);
+    {
+        DM_PROFILE(A, "a")
+    }
+    dmProfile::AddGpuSample("gpu_a", dmProfile::GetNameHash("gpu_a", 5), 0, 2000000);
+    dmProfile::AddGpuSample("gpu_b", dmProfile::GetNameHash("gpu_b", 5), 2000000, 1000000);
+
+    std::vector<dmProfile::Sample> samples;
+    std::map<std::string, const dmProfile::ScopeData*> scopes;
+    profile = dmProfile::Begin();
+    dmProfile::IterateSamples(profile, &samples, false, &ProfileSampleCallback);
+    dmProfile::IterateScopeData(profile, &scopes, false, &ProfileScopeCallback);
+    dmProfile::Release(profile);
+
+    ASSERT_EQ(3U, samples.size());
+    ASSERT_STREQ("a", samples[0].m_Name);
+    ASSERT_STREQ("gpu_a", samples[1].m_Name);
+    ASSERT_STREQ("gpu_b", samples[2].m_Name);
+    ASSERT_EQ(dmProfile::GPU_THREAD_ID, samples[1].m_ThreadId);
+    ASSERT_EQ(dmProfile::GPU_THREAD_ID, samples[2].m_ThreadId);
+    ASSERT_NE(dmProfile::GPU_THREAD_ID, samples[0].m_ThreadId);
+
+    double ticks_per_sec = dmProfile::GetTicksPerSecond();
+    ASSERT_NEAR(0.002, samples[1].m_Elapsed / ticks_per_sec, 0.0001);
+    ASSERT_NEAR(0.002, (samples[2].m_Start - samples[1].m_Start) / ticks_per_sec, 0.0001);
+    ASSERT_NEAR(0.003, scopes["GPU"]->m_Elapsed / ticks_per_sec, 0.0001);
+    ASSERT_EQ(2U, scopes["GPU"]->m_Count);
+
+    dmProfile::Finalize();
+}
+
+TEST(dmProfile, LuaSamples)
+{
+    dmProfile::Initialize(128, 1024, 16);
+
+    dmProfile::HProfile profile = dmProfile::Begin();
+    dmProfile::Release(profile);
+    uint64_t ticks_per_ms = dmProfile::GetTicksPerSecond() / 1000;
+    dmProfile::AddLuaSample("update", dmProfile::GetNameHash("update", 6), 0, 3 * ticks_per_ms);
+    dmProfile::AddLuaSample("move", dmProfile::GetNameHash("move", 4), ticks_per_ms, ticks_per_ms);
+
+    std::vector<dmProfile::Sample> samples;
+    std::map<std::string, const dmProfile::ScopeData*> scopes;
+    profile = dmProfile::Begin();
+    dmProfile::IterateSamples(profile, &samples, false, &ProfileSampleCallback);
+    dmProfile::IterateScopeData(profile, &scopes, false, &ProfileScopeCallback);
+    dmProfile::Release(profile);
+
+    ASSERT_EQ(2U, samples.size());
+    ASSERT_STREQ("update", samples[0].m_Name);
+    ASSERT_STREQ("move", samples[1].m_Name);
+    ASSERT_EQ(dmProfile::LUA_THREAD_ID, samples[0].m_ThreadId);
+    ASSERT_EQ(dmProfile::LUA_THREAD_ID, samples[1].m_ThreadId);
+    ASSERT_EQ(ticks_per_ms, samples[1].m_Start - samples[0].m_Start);
+
+    // Nested samples are not counted twice
+    ASSERT_EQ(3 * ticks_per_ms, scopes["Lua"]->m_Elapsed);
+    ASSERT_EQ(1U, scopes["Lua"]->m_Count);
+
+    dmProfile::Finalize();
+}
+
 TEST(dmProfile, DynamicScope)
 {
     const char* FUNCTION_NAMES[] = {
@@ -481,6 +600,120 @@ TEST(dmProfile, DynamicScope)
     dmProfile::Finalize();
 }
 
+static uint32_t ReadU32(const std::vector<uint8_t>& data, uint32_t offset)
+{
+    uint32_t value;
+    memcpy(&value, &data[offset], sizeof(value));
+    return value;
+}
+
+TEST(dmProfile, Capture)
+{
+    const char* path = "tmp/profile_capture.dmpt";
+    const uint32_t max_size = 256 * 1024;
+    const uint32_t frame_count = 500;
+
+    dmSys::Mkdir("tmp", 0755);
+    dmProfile::Initialize(128, 1024, 16);
+
+    ASSERT_FALSE(dmProfile::IsCapturing());
+    ASSERT_FALSE(dmProfile::StartCapture(path, 1024));
+    ASSERT_TRUE(dmProfile::StartCapture(path, max_size));
+    ASSERT_TRUE(dmProfile::IsCapturing());
+    ASSERT_FALSE(dmProfile::StartCapture(path, max_size));
+
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        for (uint32_t j = 0; j < 32; ++j)
+        {
+            DM_PROFILE(CaptureScope, "CaptureSample");
+            DM_COUNTER("CaptureCounter", 1);
+        }
+        dmProfile::HProfile profile = dmProfile::Begin();
+        dmProfile::Release(profile);
+    }
+
+    dmProfile::StopCapture();
+    ASSERT_FALSE(dmProfile::IsCapturing());
+    dmProfile::Finalize();
+
+    FILE* f = fopen(path, "rb");
+    ASSERT_NE((FILE*) 0, f);
+    std::vector<uint8_t> data(max_size);
+    size_t size = fread(&data[0], 1, data.size(), f);
+    fclose(f);
+    ASSERT_LE(size, (size_t) max_size);
+
+    // See CaptureHeader in profile.cpp
+    ASSERT_EQ(0x54504d44U, ReadU32(data, 0));
+    ASSERT_EQ(1U, ReadU32(data, 4));
+    uint32_t string_offset = ReadU32(data, 16);
+    uint32_t string_used   = ReadU32(data, 24);
+    uint32_t ring_offset   = ReadU32(data, 28);
+    uint32_t oldest        = ReadU32(data, 36);
+    uint32_t write_offset  = ReadU32(data, 40);
+    uint32_t wrap_offset   = ReadU32(data, 44);
+    uint32_t written       = ReadU32(data, 48);
+    uint32_t dropped       = ReadU32(data, 52);
+    ASSERT_EQ(frame_count, written + dropped);
+    ASSERT_GT(written, 0U);
+
+    std::map<std::string, uint32_t> strings;
+    uint32_t offset = string_offset;
+    while (offset < string_offset + string_used)
+    {
+        uint16_t length;
+        memcpy(&length, &data[offset + 6], sizeof(length));
+        strings[std::string((const char*) &data[offset + 8], length)] = ReadU32(data, offset);
+        offset += 8 + length;
+    }
+    ASSERT_EQ(string_offset + string_used, offset);
+    ASSERT_EQ(1U, strings.count("CaptureScope"));
+    ASSERT_EQ(1U, strings.count("CaptureSample"));
+    ASSERT_EQ(1U, strings.count("CaptureCounter"));
+
+    // Frames are stored oldest first, from the oldest frame to the wrap offset and then from the start of the ring
+    std::vector<uint32_t> frame_offsets;
+    if (oldest < write_offset)
+    {
+        for (offset = oldest; offset < write_offset; offset += ReadU32(data, ring_offset + offset + 4))
+            frame_offsets.push_back(offset);
+    }
+    else
+    {
+        ASSERT_NE(0U, wrap_offset);
+        for (offset = oldest; offset < wrap_offset; offset += ReadU32(data, ring_offset + offset + 4))
+            frame_offsets.push_back(offset);
+        for (offset = 0; offset < write_offset; offset += ReadU32(data, ring_offset + offset + 4))
+            frame_offsets.push_back(offset);
+    }
+    ASSERT_EQ(write_offset, offset);
+    ASSERT_LT(0U, frame_offsets.size());
+    ASSERT_GE(written, frame_offsets.size());
+
+    uint32_t last_index = 0;
+    for (size_t i = 0; i < frame_offsets.size(); ++i)
+    {
+        uint32_t frame = ring_offset + frame_offsets[i];
+        ASSERT_EQ(0x4d415246U, ReadU32(data, frame));
+        uint32_t index = ReadU32(data, frame + 8);
+        if (i > 0)
+        {
+            ASSERT_LT(last_index, index);
+        }
+        last_index = index;
+
+        // Every frame but the first also has the sample of the capture itself
+        uint32_t sample_count = ReadU32(data, frame + 16);
+        ASSERT_EQ(index > 0 ? 33U : 32U, sample_count);
+        ASSERT_EQ(strings["CaptureSample"], ReadU32(data, frame + 24 + (sample_count - 1) * 16));
+        ASSERT_EQ(1U, ReadU32(data, frame + 20));
+        ASSERT_EQ(strings["CaptureCounter"], ReadU32(data, frame + 24 + sample_count * 16));
+        ASSERT_EQ(32U, ReadU32(data, frame + 24 + sample_count * 16 + 4));
+    }
+    ASSERT_GE(frame_count - 1, last_index);
+}
+
 #else
 #endif
 
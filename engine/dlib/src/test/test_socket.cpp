@@ -916,6 +916,25 @@ TEST(Socket, GetHostByName_IPv6_External)
 }
 #endif
 
+TEST(Socket, GetHostByNameT_Cached)
+{
+    dmSocket::ClearHostCache();
+
+    dmSocket::Address address1;
+    dmSocket::Address address2;
+    const char* hostname = DM_LOOPBACK_ADDRESS_IPV4;
+
+    ASSERT_EQ(dmSocket::RESULT_OK, dmSocket::GetHostByNameT(hostname, &address1, 0, 0, true, false));
+    ASSERT_EQ(dmSocket::RESULT_OK, dmSocket::GetHostByNameT(hostname, &address2, 0, 0, true, false));
+    ASSERT_EQ(dmSocket::DOMAIN_IPV4, address2.m_family);
+    ASSERT_EQ(address1, address2);
+
+    ASSERT_EQ(dmSocket::RESULT_HOST_NOT_FOUND, dmSocket::GetHostByNameT("localhost.invalid", &address1, 0, 0, true, false));
+    ASSERT_EQ(dmSocket::RESULT_HOST_NOT_FOUND, dmSocket::GetHostByNameT("localhost.invalid", &address1, 0, 0, true, false));
+
+    dmSocket::ClearHostCache();
+}
+
 TEST(Socket, GetHostByName_IPv4_Unavailable)
 {
     dmSocket::Address address;
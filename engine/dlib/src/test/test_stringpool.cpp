@@ -23,6 +23,8 @@
 
 #include "dlib/stringpool.h"
 #include "dlib/hash.h"
+#include "dlib/thread.h"
+#include "dlib/dstrings.h"
 
 TEST(dmStringPool, Test01)
 {
@@ -65,6 +67,61 @@ TEST(dmStringPool, Test01)
     dmStringPool::Delete(pool);
 }
 
+static const uint32_t CONCURRENT_THREAD_COUNT = 4;
+static const uint32_t CONCURRENT_STRING_COUNT = 20000;
+
+struct ConcurrentAddContext
+{
+    dmStringPool::HPool m_Pool;
+    uint32_t            m_Offset;
+    const char*         m_Strings[CONCURRENT_STRING_COUNT];
+};
+
+static void ConcurrentAdd(void* _ctx)
+{
+    ConcurrentAddContext* ctx = (ConcurrentAddContext*) _ctx;
+    for (uint32_t i = 0; i < CONCURRENT_STRING_COUNT; ++i)
+    {
+        // The threads start at different strings, so that they both add and find strings while the pool grows
+        uint32_t index = (i + ctx->m_Offset) % CONCURRENT_STRING_COUNT;
+        char tmp[32];
+        uint32_t length = dmSnPrintf(tmp, sizeof(tmp), "string_%u", index);
+        ctx->m_Strings[index] = dmStringPool::Add(ctx->m_Pool, tmp, length, dmHashBufferNoReverse32(tmp, length));
+    }
+}
+
+TEST(dmStringPool, Concurrent)
+{
+    dmStringPool::HPool pool = dmStringPool::New();
+
+    ConcurrentAddContext* contexts = new ConcurrentAddContext[CONCURRENT_THREAD_COUNT];
+    dmThread::Thread threads[CONCURRENT_THREAD_COUNT];
+    for (uint32_t t = 0; t < CONCURRENT_THREAD_COUNT; ++t)
+    {
+        contexts[t].m_Pool = pool;
+        contexts[t].m_Offset = t * CONCURRENT_STRING_COUNT / CONCURRENT_THREAD_COUNT;
+        threads[t] = dmThread::New(ConcurrentAdd, 0x80000, &contexts[t], "stringpool");
+    }
+    for (uint32_t t = 0; t < CONCURRENT_THREAD_COUNT; ++t)
+    {
+        dmThread::Join(threads[t]);
+    }
+
+    for (uint32_t i = 0; i < CONCURRENT_STRING_COUNT; ++i)
+    {
+        char tmp[32];
+        dmSnPrintf(tmp, sizeof(tmp), "string_%u", i);
+        ASSERT_STREQ(tmp, contexts[0].m_Strings[i]);
+        for (uint32_t t = 1; t < CONCURRENT_THREAD_COUNT; ++t)
+        {
+            ASSERT_EQ(contexts[0].m_Strings[i], contexts[t].m_Strings[i]);
+        }
+    }
+
+    delete [] contexts;
+    dmStringPool::Delete(pool);
+}
+
 
 int main(int argc, char **argv)
 {
@@ -74,6 +74,36 @@ TEST(dmZip, Read)
     dmZip::Close(zip);
 }
 
+static bool StreamWriter(void* context, const void* data, uint32_t data_len)
+{
+    char* buffer = (char*)context;
+    uint32_t len = strlen(buffer);
+    memcpy(buffer + len, data, data_len);
+    buffer[len + data_len] = 0;
+    return true;
+}
+
+TEST(dmZip, ReadStreamed)
+{
+    char path[64];
+    dmSnPrintf(path, 64, MOUNTFS PATH_FORMAT, "foo.zip");
+
+    dmZip::HZip zip;
+    dmZip::Result zr = dmZip::Open(path, &zip);
+    ASSERT_EQ(dmZip::RESULT_OK, zr);
+
+    zr = dmZip::OpenEntry(zip, "hello.txt");
+    ASSERT_EQ(dmZip::RESULT_OK, zr);
+
+    char data[64] = {0};
+    zr = dmZip::GetEntryDataStreamed(zip, data, StreamWriter);
+    ASSERT_EQ(dmZip::RESULT_OK, zr);
+    ASSERT_STREQ("Hello World", data);
+
+    dmZip::CloseEntry(zip);
+    dmZip::Close(zip);
+}
+
 TEST(dmZip, Iterate)
 {
     char path[64];
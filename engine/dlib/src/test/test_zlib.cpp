@@ -62,6 +62,57 @@ TEST(dmZlib, Deflate)
     ASSERT_STREQ("bar", decompressed.c_str());
 }
 
+TEST(dmZlib, Stream)
+{
+    std::string ref;
+    for (int i = 0; i < 1000; ++i)
+        ref += "streamed data ";
+
+    // Deflate and inflate in small chunks of uneven size
+    std::string compressed;
+    dmZlib::HDeflater deflater = dmZlib::NewDeflater(5);
+    ASSERT_NE((dmZlib::HDeflater)0, deflater);
+    for (uint32_t offset = 0; offset < ref.size(); offset += 333)
+    {
+        uint32_t n = ref.size() - offset < 333 ? ref.size() - offset : 333;
+        ASSERT_EQ(dmZlib::RESULT_OK, dmZlib::Deflate(deflater, ref.c_str() + offset, n, false, &compressed, Writer));
+    }
+    ASSERT_EQ(dmZlib::RESULT_OK, dmZlib::Deflate(deflater, 0, 0, true, &compressed, Writer));
+    dmZlib::DeleteDeflater(deflater);
+
+    std::string decompressed;
+    dmZlib::HInflater inflater = dmZlib::NewInflater();
+    ASSERT_NE((dmZlib::HInflater)0, inflater);
+    dmZlib::Result r = dmZlib::RESULT_OK;
+    for (uint32_t offset = 0; offset < compressed.size(); offset += 7)
+    {
+        uint32_t n = compressed.size() - offset < 7 ? compressed.size() - offset : 7;
+        r = dmZlib::Inflate(inflater, compressed.c_str() + offset, n, &decompressed, Writer);
+        ASSERT_TRUE(r == dmZlib::RESULT_OK || r == dmZlib::RESULT_STREAM_END);
+    }
+    ASSERT_EQ(dmZlib::RESULT_STREAM_END, r);
+    dmZlib::DeleteInflater(inflater);
+    ASSERT_TRUE(ref == decompressed);
+
+    // Gzip one byte at a time
+    decompressed = "";
+    inflater = dmZlib::NewInflater();
+    for (uint32_t i = 0; i < FOO_GZ_SIZE; ++i)
+    {
+        r = dmZlib::Inflate(inflater, FOO_GZ + i, 1, &decompressed, Writer);
+    }
+    ASSERT_EQ(dmZlib::RESULT_STREAM_END, r);
+    dmZlib::DeleteInflater(inflater);
+    ASSERT_STREQ("foo", decompressed.c_str());
+
+    // Truncated streams never end
+    decompressed = "";
+    inflater = dmZlib::NewInflater();
+    r = dmZlib::Inflate(inflater, compressed.c_str(), compressed.size() / 2, &decompressed, Writer);
+    ASSERT_EQ(dmZlib::RESULT_OK, r);
+    dmZlib::DeleteInflater(inflater);
+}
+
 std::string RandomString(int max)
 {
     std::string tmp;
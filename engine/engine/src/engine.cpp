@@ -26,10 +26,12 @@
 #include <dlib/dstrings.h>
 #include <dlib/hash.h>
 #include <dlib/http_client.h>
+#include <dlib/job.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
 #include <dlib/memprofile.h>
 #include <dlib/path.h>
+#include <dlib/platform.h>
 #include <dlib/profile.h>
 #include <dlib/socket.h>
 #include <dlib/sslsocket.h>
@@ -107,6 +109,13 @@ namespace dmEngine
 {
 #define SYSTEM_SOCKET_NAME "@system"
 
+#if defined(DM_HEADLESS_SERVER)
+    // The dedicated server runs the simulation only, nothing is rendered or played
+    static const bool HEADLESS_SERVER = true;
+#else
+    static const bool HEADLESS_SERVER = false;
+#endif
+
     dmEngineService::HEngineService g_EngineService = 0;
 
     static void OnWindowResize(void* user_data, uint32_t width, uint32_t height)
@@ -154,16 +163,29 @@ namespace dmEngine
 
     static void Dispatch(dmMessage::Message *message_object, void* user_ptr);
 
+    static void InitExtensionParams(Engine* engine, dmExtension::Params* params)
+    {
+        params->m_ConfigFile = engine->m_Config;
+        if (engine->m_SharedScriptContext) {
+            params->m_L = dmScript::GetLuaState(engine->m_SharedScriptContext);
+        } else {
+            params->m_L = dmScript::GetLuaState(engine->m_GOScriptContext);
+        }
+        params->m_JobContext = engine->m_JobContext;
+    }
+
     static void OnWindowFocus(void* user_data, uint32_t focus)
     {
         Engine* engine = (Engine*)user_data;
         dmExtension::Params params;
         params.m_ConfigFile = engine->m_Config;
         params.m_L          = 0;
+        params.m_JobContext = engine->m_JobContext;
         dmExtension::Event event;
         event.m_Event = focus ? dmExtension::EVENT_ID_ACTIVATEAPP : dmExtension::EVENT_ID_DEACTIVATEAPP;
         dmExtension::DispatchEvent( &params, &event );
 
+        engine->m_ForceRender = true;
         dmGameSystem::OnWindowFocus(focus != 0);
     }
 
@@ -178,10 +200,12 @@ namespace dmEngine
         dmExtension::Params params;
         params.m_ConfigFile = engine->m_Config;
         params.m_L          = 0;
+        params.m_JobContext = engine->m_JobContext;
         dmExtension::Event event;
         event.m_Event = iconify ? dmExtension::EVENT_ID_ICONIFYAPP : dmExtension::EVENT_ID_DEICONIFYAPP;
         dmExtension::DispatchEvent( &params, &event );
 
+        engine->m_ForceRender = true;
         dmGameSystem::OnWindowIconify(iconify != 0);
     }
 
@@ -194,6 +218,8 @@ namespace dmEngine
     Engine::Engine(dmEngineService::HEngineService engine_service)
     : m_Config(0)
     , m_Alive(true)
+    , m_JobContext(0)
+    , m_FrameAllocator(0)
     , m_MainCollection(0)
     , m_LastReloadMTime(0)
     , m_MouseSensitivity(1.0f)
@@ -216,11 +242,16 @@ namespace dmEngine
     , m_QuitOnEsc(false)
     , m_ConnectionAppMode(false)
     , m_RunWhileIconified(0)
+    , m_RenderOnDemand(false)
+    , m_ForceRender(true)
+    , m_LateInputSample(false)
+    , m_NextTickTime(0)
     , m_Width(960)
     , m_Height(640)
     , m_InvPhysicalWidth(1.0f/960)
     , m_InvPhysicalHeight(1.0f/640)
     {
+        memset(&m_FramePacing, 0, sizeof(m_FramePacing));
         m_EngineService = engine_service;
         m_Register = dmGameObject::NewRegister();
         m_InputBuffer.SetCapacity(64);
@@ -246,6 +277,10 @@ namespace dmEngine
 
     void Delete(HEngine engine)
     {
+        // Released resources must be destroyed while their type contexts are still alive, so stop caching them
+        if (engine->m_Factory)
+            dmResource::SetColdCacheSize(engine->m_Factory, 0);
+
         if (engine->m_MainCollection)
             dmResource::Release(engine->m_Factory, engine->m_MainCollection);
         dmGameObject::PostUpdate(engine->m_Register);
@@ -281,10 +316,29 @@ namespace dmEngine
 
         UnloadBootstrapContent(engine);
 
+        FinalizeBenchmark(&engine->m_Benchmark);
+
         dmSound::Finalize();
 
+        if (engine->m_JobContext)
+        {
+            if (engine->m_GraphicsContext)
+                dmGraphics::SetJobContext(engine->m_GraphicsContext, 0);
+            dmLiveUpdate::SetVerifyParams(0, false);
+            dmArray<dmScript::HContext>& script_contexts = engine->m_ModuleContext.m_ScriptContexts;
+            for (uint32_t i = 0; i < script_contexts.Size(); ++i)
+            {
+                dmScript::SetJobContext(script_contexts[i], 0);
+            }
+            dmJob::DeleteContext(engine->m_JobContext);
+        }
+
+        if (engine->m_FrameAllocator)
+            dmFrameAlloc::Delete(engine->m_FrameAllocator);
+
         dmInput::DeleteContext(engine->m_InputContext);
 
+        dmGameSystem::FinalizeTextureStreaming();
         dmRender::DeleteRenderContext(engine->m_RenderContext, engine->m_RenderScriptContext);
 
         if (engine->m_HidContext)
@@ -444,6 +498,79 @@ namespace dmEngine
         dmProfiler::SetUpdateFrequency(engine->m_UpdateFrequency);
     }
 
+    static void InitFramePacing(HEngine engine, uint32_t refresh_rate, uint32_t target_frequency, uint32_t swap_interval)
+    {
+        FramePacing& pacing = engine->m_FramePacing;
+        memset(&pacing, 0, sizeof(pacing));
+        pacing.m_Enabled          = engine->m_VsyncMode == VSYNC_HARDWARE && dmConfigFile::GetInt(engine->m_Config, "display.frame_pacing", 0) != 0;
+        pacing.m_AutoSwapInterval = 1;
+        pacing.m_RefreshRate      = refresh_rate;
+        pacing.m_TargetFrequency  = target_frequency;
+        pacing.m_SwapInterval     = dmMath::Max(1U, swap_interval);
+        pacing.m_VsyncPeriod      = 1.0f / dmMath::Max(1U, refresh_rate);
+        pacing.m_FrameDt          = pacing.m_VsyncPeriod * pacing.m_SwapInterval;
+    }
+
+    static int FloatCompare(const void* a, const void* b)
+    {
+        float fa = *(const float*) a;
+        float fb = *(const float*) b;
+        return fa < fb ? -1 : (fa > fb ? 1 : 0);
+    }
+
+    // Called after each flip with the time since the previous flip. The median of the recent flip intervals
+    // is used as the refresh period, which is robust against the occasional dropped or late frame. Once
+    // the window is full, the swap interval and update frequency are adjusted if the display refreshes
+    // at a different rate than we assumed, e.g. on 90/120Hz phones that report 60Hz.
+    static void UpdateFramePacing(HEngine engine, uint64_t flip_interval)
+    {
+        FramePacing& pacing = engine->m_FramePacing;
+        if (!pacing.m_Enabled || engine->m_UseSwVsync || flip_interval == 0)
+        {
+            return;
+        }
+
+        float interval = (float)(flip_interval * 0.000001);
+        pacing.m_Samples[pacing.m_SampleIndex] = interval / pacing.m_SwapInterval;
+        pacing.m_SampleIndex = (pacing.m_SampleIndex + 1) % FRAME_PACING_SAMPLE_COUNT;
+        pacing.m_SampleCount = dmMath::Min(pacing.m_SampleCount + 1, FRAME_PACING_SAMPLE_COUNT);
+
+        // Snap the dt to whole refresh periods, so that timing noise doesn't cause judder while a dropped
+        // frame still advances the game by the time it took
+        uint32_t periods = (uint32_t) (interval / pacing.m_VsyncPeriod + 0.5f);
+        periods = dmMath::Max(pacing.m_SwapInterval, dmMath::Min(periods, pacing.m_SwapInterval * 25));
+        pacing.m_FrameDt = periods * pacing.m_VsyncPeriod;
+
+        if (pacing.m_SampleCount < FRAME_PACING_SAMPLE_COUNT || pacing.m_SampleIndex != 0)
+        {
+            return;
+        }
+
+        float sorted[FRAME_PACING_SAMPLE_COUNT];
+        memcpy(sorted, pacing.m_Samples, sizeof(sorted));
+        qsort(sorted, FRAME_PACING_SAMPLE_COUNT, sizeof(float), FloatCompare);
+        float period = sorted[FRAME_PACING_SAMPLE_COUNT / 2];
+        uint32_t refresh_rate = (uint32_t) (1.0f / period + 0.5f);
+        pacing.m_VsyncPeriod = period;
+        DM_COUNTER("RefreshRate", refresh_rate);
+
+        // Ignore small variations, to avoid changing the swap interval back and forth
+        if (!pacing.m_AutoSwapInterval || dmMath::Abs((int32_t) refresh_rate - (int32_t) pacing.m_RefreshRate) < 3)
+        {
+            return;
+        }
+
+        uint32_t target = pacing.m_TargetFrequency > 0 ? pacing.m_TargetFrequency : refresh_rate;
+        uint32_t swap_interval = dmMath::Max(1U, (uint32_t) ((float) refresh_rate / target + 0.5f));
+        dmLogInfo("Display refresh rate is %u Hz, using swap interval %u", refresh_rate, swap_interval);
+
+        pacing.m_RefreshRate  = refresh_rate;
+        pacing.m_SwapInterval = swap_interval;
+        SetUpdateFrequency(engine, refresh_rate);
+        SetSwapInterval(engine, swap_interval);
+        pacing.m_FrameDt      = pacing.m_VsyncPeriod * swap_interval;
+    }
+
     struct LuaCallstackCtx
     {
         bool     m_First;
@@ -470,6 +597,136 @@ namespace dmEngine
         ctx->m_BufferSize -= nwritten;
     }
 
+    static void ResourceLoadedCallback(void* user_data, const char* path, uint32_t size)
+    {
+        dmCrash::RecordResourceLoad(path, size);
+    }
+
+    // Durations of the Init phases, logged once the engine has booted.
+    // The phases are also profile scopes, and show up in the first frame of a profiler capture
+    static const uint32_t MAX_BOOT_PHASES = 16;
+
+    struct BootPhases
+    {
+        const char* m_Names[MAX_BOOT_PHASES];
+        uint64_t    m_Durations[MAX_BOOT_PHASES];
+        bool        m_Parallel[MAX_BOOT_PHASES];
+        uint32_t    m_Count;
+        uint64_t    m_Start;
+        uint64_t    m_PhaseStart;
+    };
+
+    static void AddBootPhase(BootPhases* phases, const char* name, uint64_t duration, bool parallel)
+    {
+        if (phases->m_Count < MAX_BOOT_PHASES)
+        {
+            phases->m_Names[phases->m_Count] = name;
+            phases->m_Durations[phases->m_Count] = duration;
+            phases->m_Parallel[phases->m_Count] = parallel;
+            phases->m_Count++;
+        }
+    }
+
+    // Ends the current phase on the main thread, and starts the next one
+    static void EndBootPhase(BootPhases* phases, const char* name)
+    {
+        uint64_t now = dmTime::GetTime();
+        AddBootPhase(phases, name, now - phases->m_PhaseStart, false);
+        phases->m_PhaseStart = now;
+    }
+
+    static void LogBootPhases(const BootPhases* phases)
+    {
+        char buffer[512];
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < phases->m_Count && n < sizeof(buffer); ++i)
+        {
+            int r = dmSnPrintf(buffer + n, sizeof(buffer) - n, "%s%s%s %.1f", i > 0 ? ", " : "", phases->m_Names[i], phases->m_Parallel[i] ? "*" : "", phases->m_Durations[i] / 1000.0f);
+            if (r < 0)
+                break;
+            n += (uint32_t)r;
+        }
+        buffer[dmMath::Min(n, (uint32_t)sizeof(buffer) - 1)] = 0;
+        dmLogInfo("Engine booted in %.1f ms (%s ms, * = in parallel)", (dmTime::GetTime() - phases->m_Start) / 1000.0f, buffer);
+    }
+
+    // Independent work done on a thread of its own during Init, while the main thread sets up the graphics
+    struct BootTask
+    {
+        void             (*m_Function)(void* context);
+        void*            m_Context;
+        dmThread::Thread m_Thread;
+        uint64_t         m_Duration;
+        bool             m_Parallel;
+        bool             m_Running;
+    };
+
+    static void BootTaskThread(void* arg)
+    {
+        BootTask* task = (BootTask*)arg;
+        uint64_t start = dmTime::GetTime();
+        task->m_Function(task->m_Context);
+        task->m_Duration = dmTime::GetTime() - start;
+    }
+
+    static void StartBootTask(BootTask* task, void (*function)(void*), void* context, const char* name, bool parallel)
+    {
+        task->m_Function = function;
+        task->m_Context = context;
+        task->m_Duration = 0;
+        task->m_Parallel = false;
+        task->m_Running = false;
+#if !defined(DM_NO_THREAD_SUPPORT)
+        if (parallel)
+        {
+            task->m_Thread = dmThread::New(BootTaskThread, 0x80000, task, name);
+            task->m_Parallel = true;
+            task->m_Running = true;
+            return;
+        }
+#endif
+        BootTaskThread(task);
+    }
+
+    static void FinishBootTask(BootTask* task)
+    {
+        if (task->m_Running)
+        {
+            dmThread::Join(task->m_Thread);
+            task->m_Running = false;
+        }
+    }
+
+    struct BootFactoryContext
+    {
+        dmResource::NewFactoryParams* m_Params;
+        const char*                   m_Uri;
+        dmResource::HFactory          m_Factory;
+    };
+
+    // Mounts the builtins and game archives, and loads the manifest
+    static void BootNewFactory(void* context)
+    {
+        DM_PROFILE(Engine, "NewFactory");
+        BootFactoryContext* ctx = (BootFactoryContext*)context;
+        ctx->m_Factory = dmResource::NewFactory(ctx->m_Params, ctx->m_Uri);
+    }
+
+    struct BootSoundContext
+    {
+        dmConfigFile::HConfig     m_Config;
+        dmSound::InitializeParams m_Params;
+        dmSound::Result           m_Result;
+    };
+
+    // Opens the sound device, which can take a long time on some platforms
+    static void BootInitializeSound(void* context)
+    {
+        DM_PROFILE(Engine, "SoundInitialize");
+        BootSoundContext* ctx = (BootSoundContext*)context;
+        ctx->m_Result = dmSound::Initialize(ctx->m_Config, &ctx->m_Params);
+    }
+
     static void CrashHandlerCallback(void* ctx, char* buffer, uint32_t buffersize)
     {
         HEngine engine = (HEngine)ctx;
@@ -500,6 +757,11 @@ namespace dmEngine
     */
     bool Init(HEngine engine, int argc, char *argv[])
     {
+        BootPhases boot_phases;
+        memset(&boot_phases, 0, sizeof(boot_phases));
+        boot_phases.m_Start = dmTime::GetTime();
+        boot_phases.m_PhaseStart = boot_phases.m_Start;
+
         dmLogInfo("Defold Engine %s (%.7s)", dmEngineVersion::VERSION, dmEngineVersion::VERSION_SHA1);
 
         dmCrash::SetExtraInfoCallback(CrashHandlerCallback, engine);
@@ -567,6 +829,7 @@ namespace dmEngine
             engine->m_ConnectionAppMode = true;
 #endif
         }
+        EndBootPhase(&boot_phases, "config");
 
         #if defined(__EMSCRIPTEN__)
         if (1 == dmConfigFile::GetInt(engine->m_Config, "html5.show_console_banner", 1))
@@ -644,6 +907,10 @@ namespace dmEngine
         }
         new_hid_params.m_IgnoreAcceleration = use_accelerometer ? 0 : 1;
 
+        engine->m_LateInputSample = dmConfigFile::GetInt(engine->m_Config, "input.late_sample", 0) != 0;
+        // Poll gamepads on a background thread at this rate (Hz), some drivers are slow to query
+        new_hid_params.m_GamepadPollRate = (uint32_t) dmMath::Max(0, dmConfigFile::GetInt(engine->m_Config, "input.gamepad_poll_rate", 0));
+
 #if defined(__EMSCRIPTEN__)
         // DEF-2450 Reverse scroll direction for firefox browser
         dmSys::SystemInfo info;
@@ -681,10 +948,120 @@ namespace dmEngine
             }
         }
 
+        const char* profile_capture = dmConfigFile::GetString(engine->m_Config, "profiler.capture_file", 0);
+        if (profile_capture && !dmProfile::IsCapturing()) {
+            uint32_t capture_size = dmConfigFile::GetInt(engine->m_Config, "profiler.capture_size", 64) * 1024*1024; // MB -> bytes
+            dmProfile::StartCapture(profile_capture, capture_size);
+        }
+
+        if (!InitBenchmark(&engine->m_Benchmark, engine->m_Config))
+        {
+            dmLogFatal("Unable to initialize the benchmark.");
+            return false;
+        }
+
         const char* update_order = dmConfigFile::GetString(engine->m_Config, "gameobject.update_order", 0);
 
         // This scope is mainly here to make sure the "Main" scope is created first
         DM_PROFILE(Engine, "Init");
+        EndBootPhase(&boot_phases, "extensions");
+
+        // Created before the resource factory, which uses it when loading the archives
+        dmJob::NewContextParams job_params;
+#if !defined(__EMSCRIPTEN__)
+        int32_t job_worker_count = dmConfigFile::GetInt(engine->m_Config, "job.worker_count", -1);
+        if (job_worker_count >= 0)
+            job_params.m_WorkerCount = (uint32_t) job_worker_count;
+#else
+        job_params.m_WorkerCount = 0;
+#endif
+        job_params.m_MaxJobs = (uint32_t) dmConfigFile::GetInt(engine->m_Config, "job.max_count", 4096);
+        engine->m_JobContext = dmJob::NewContext(job_params);
+        if (!engine->m_JobContext)
+        {
+            dmLogFatal("Failed to create job context");
+            return false;
+        }
+        dmLogInfo("Job system started with %u worker threads", dmJob::GetWorkerCount(engine->m_JobContext));
+
+        // One arena per job thread, indexed with dmJob::GetThreadIndex()
+        dmFrameAlloc::NewParams frame_alloc_params;
+        frame_alloc_params.m_Size = (uint32_t) dmConfigFile::GetInt(engine->m_Config, "engine.frame_alloc_size", frame_alloc_params.m_Size);
+        frame_alloc_params.m_ThreadCount = dmJob::GetWorkerCount(engine->m_JobContext);
+        engine->m_FrameAllocator = dmFrameAlloc::New(frame_alloc_params);
+
+        const uint32_t max_resources = dmConfigFile::GetInt(engine->m_Config, dmResource::MAX_RESOURCES_KEY, 1024);
+        dmResource::NewFactoryParams params;
+        params.m_MaxResources = max_resources;
+        params.m_Flags = 0;
+        params.m_LoaderThreadCount = dmConfigFile::GetInt(engine->m_Config, "resource.loader_threads", 0);
+        params.m_LoadOrderPath = dmConfigFile::GetString(engine->m_Config, "resource.load_order_file", 0);
+        params.m_ColdCacheSize = dmConfigFile::GetInt(engine->m_Config, "resource.cold_cache_size", 0) * 1024*1024; // MB -> bytes
+        params.m_PreloadBudget = dmConfigFile::GetInt(engine->m_Config, "resource.preload_budget", 0);
+
+        dmResourceArchive::ClearArchiveLoaders(); // in case we've rebooted
+        dmResourceArchive::RegisterDefaultArchiveLoader();
+
+        if (dLib::IsDebugMode())
+        {
+            params.m_Flags = RESOURCE_FACTORY_FLAGS_RELOAD_SUPPORT;
+
+            int32_t http_cache = dmConfigFile::GetInt(engine->m_Config, "resource.http_cache", 1);
+            if (http_cache)
+                params.m_Flags |= RESOURCE_FACTORY_FLAGS_HTTP_CACHE;
+        }
+
+        int32_t liveupdate_enable = dmConfigFile::GetInt(engine->m_Config, "liveupdate.enabled", 1);
+        if (liveupdate_enable)
+        {
+            params.m_Flags |= RESOURCE_FACTORY_FLAGS_LIVE_UPDATE;
+
+            dmLiveUpdate::RegisterArchiveLoaders();
+            dmLiveUpdate::SetVerifyParams(engine->m_JobContext, dmConfigFile::GetInt(engine->m_Config, "liveupdate.verify_lazy", 0) != 0);
+        }
+
+#if defined(DM_RELEASE)
+        params.m_ArchiveIndex.m_Data = (const void*) BUILTINS_RELEASE_ARCI;
+        params.m_ArchiveIndex.m_Size = BUILTINS_RELEASE_ARCI_SIZE;
+        params.m_ArchiveData.m_Data = (const void*) BUILTINS_RELEASE_ARCD;
+        params.m_ArchiveData.m_Size = BUILTINS_RELEASE_ARCD_SIZE;
+        params.m_ArchiveManifest.m_Data = (const void*) BUILTINS_RELEASE_DMANIFEST;
+        params.m_ArchiveManifest.m_Size = BUILTINS_RELEASE_DMANIFEST_SIZE;
+#else
+        params.m_ArchiveIndex.m_Data = (const void*) BUILTINS_ARCI;
+        params.m_ArchiveIndex.m_Size = BUILTINS_ARCI_SIZE;
+        params.m_ArchiveData.m_Data = (const void*) BUILTINS_ARCD;
+        params.m_ArchiveData.m_Size = BUILTINS_ARCD_SIZE;
+        params.m_ArchiveManifest.m_Data = (const void*) BUILTINS_DMANIFEST;
+        params.m_ArchiveManifest.m_Size = BUILTINS_DMANIFEST_SIZE;
+#endif
+
+        const char* resource_uri = dmConfigFile::GetString(engine->m_Config, "resource.uri", content_root);
+        dmLogInfo("Loading data from: %s", resource_uri);
+
+        // The archives are mounted and the sound device opened while the main thread creates the window
+        bool parallel_init = dmConfigFile::GetInt(engine->m_Config, "engine.parallel_init", 1) != 0;
+
+        BootFactoryContext factory_ctx;
+        factory_ctx.m_Params = &params;
+        factory_ctx.m_Uri = resource_uri;
+        factory_ctx.m_Factory = 0;
+        BootTask factory_task;
+        StartBootTask(&factory_task, BootNewFactory, &factory_ctx, "boot_factory", parallel_init);
+
+        BootSoundContext sound_ctx;
+        sound_ctx.m_Config = engine->m_Config;
+        sound_ctx.m_Params.m_OutputDevice = "default";
+        sound_ctx.m_Params.m_JobContext = engine->m_JobContext;
+#if defined(__EMSCRIPTEN__)
+        sound_ctx.m_Params.m_UseThread = false;
+#else
+        sound_ctx.m_Params.m_UseThread = dmConfigFile::GetInt(engine->m_Config, "sound.use_thread", 1) != 0;
+#endif
+        sound_ctx.m_Result = dmSound::RESULT_OK;
+        BootTask sound_task;
+        StartBootTask(&sound_task, BootInitializeSound, &sound_ctx, "boot_sound", parallel_init);
+        EndBootPhase(&boot_phases, "setup");
 
         dmGraphics::ContextParams graphics_context_params;
         graphics_context_params.m_DefaultTextureMinFilter = ConvertMinTextureFilter(dmConfigFile::GetString(engine->m_Config, "graphics.default_texture_min_filter", "linear"));
@@ -694,11 +1071,32 @@ namespace dmEngine
 
         graphics_context_params.m_UseValidationLayers = use_validation_layers || dmConfigFile::GetInt(engine->m_Config, "graphics.use_validationlayers", 0) != 0;
         graphics_context_params.m_GraphicsMemorySize = dmConfigFile::GetInt(engine->m_Config, "graphics.memory_size", 0) * 1024*1024; // MB -> bytes
+        graphics_context_params.m_TextureUploadBudget = dmConfigFile::GetInt(engine->m_Config, "graphics.texture_upload_budget", 0) * 1024; // KB -> bytes
+        graphics_context_params.m_DrawCallBudget = dmConfigFile::GetInt(engine->m_Config, "graphics.draw_call_budget", 0);
+        graphics_context_params.m_UploadBudget = dmConfigFile::GetInt(engine->m_Config, "graphics.upload_budget", 0) * 1024; // KB -> bytes
+
+        char pipeline_cache_directory[DMPATH_MAX_PATH];
+        if (dmConfigFile::GetInt(engine->m_Config, "graphics.pipeline_cache", 1) != 0)
+        {
+            const char* application_name = dmConfigFile::GetString(engine->m_Config, "project.title", "TestTitle");
+            if (dmSys::GetApplicationSavePath(application_name, pipeline_cache_directory, sizeof(pipeline_cache_directory)) == dmSys::RESULT_OK)
+            {
+                graphics_context_params.m_PipelineCacheDirectory = pipeline_cache_directory;
+            }
+        }
+        graphics_context_params.m_PipelineWarmup = dmConfigFile::GetInt(engine->m_Config, "graphics.pipeline_warmup", 0) != 0;
+        graphics_context_params.m_PipelinedPresent = dmConfigFile::GetInt(engine->m_Config, "graphics.pipelined_present", 0) != 0;
 
-        engine->m_GraphicsContext = dmGraphics::NewContext(graphics_context_params);
+        {
+            DM_PROFILE(Engine, "NewGraphicsContext");
+            engine->m_GraphicsContext = dmGraphics::NewContext(graphics_context_params);
+        }
         if (engine->m_GraphicsContext == 0x0)
         {
             dmLogFatal("Unable to create the graphics context.");
+            FinishBootTask(&factory_task);
+            FinishBootTask(&sound_task);
+            engine->m_Factory = factory_ctx.m_Factory;
             return false;
         }
 
@@ -722,10 +1120,17 @@ namespace dmEngine
         window_params.m_PrintDeviceInfo = dmConfigFile::GetInt(engine->m_Config, "display.display_device_info", 0);
         window_params.m_HighDPI = (bool) dmConfigFile::GetInt(engine->m_Config, "display.high_dpi", 0);
 
-        dmGraphics::WindowResult window_result = dmGraphics::OpenWindow(engine->m_GraphicsContext, &window_params);
+        dmGraphics::WindowResult window_result;
+        {
+            DM_PROFILE(Engine, "OpenWindow");
+            window_result = dmGraphics::OpenWindow(engine->m_GraphicsContext, &window_params);
+        }
         if (window_result != dmGraphics::WINDOW_RESULT_OK)
         {
             dmLogFatal("Could not open window (%d).", window_result);
+            FinishBootTask(&factory_task);
+            FinishBootTask(&sound_task);
+            engine->m_Factory = factory_ctx.m_Factory;
             return false;
         }
 
@@ -736,6 +1141,8 @@ namespace dmEngine
         engine->m_InvPhysicalHeight = 1.0f / physical_height;
 
         engine->m_UseSwVsync = false;
+        // Every frame is rendered when benchmarking, to measure the same work each frame
+        engine->m_RenderOnDemand = engine->m_Benchmark.m_FrameCount == 0 && dmConfigFile::GetInt(engine->m_Config, "display.render_on_demand", 0) != 0;
 
 #if defined(__MACH__) || defined(__linux__) || defined(_WIN32)
         engine->m_RunWhileIconified = dmConfigFile::GetInt(engine->m_Config, "engine.run_while_iconified", 0);
@@ -785,57 +1192,33 @@ namespace dmEngine
             engine->m_VsyncMode = VSYNC_HARDWARE;
         }
 
+#if defined(DM_HEADLESS_SERVER)
+        // There is no display to sync with. The server ticks at a fixed rate, paced by the precise frame timer in Step()
+        engine->m_UseVariableDt = 0;
+        engine->m_VsyncMode = VSYNC_SOFTWARE;
+        update_frequency = setting_update_frequency > 0 ? setting_update_frequency : 60;
+        swap_interval = 0;
+#endif
+
         SetUpdateFrequency(engine, update_frequency);
         SetSwapInterval(engine, swap_interval);
+        InitFramePacing(engine, update_frequency, setting_update_frequency, swap_interval);
+        EndBootPhase(&boot_phases, "graphics");
 
-        const uint32_t max_resources = dmConfigFile::GetInt(engine->m_Config, dmResource::MAX_RESOURCES_KEY, 1024);
-        dmResource::NewFactoryParams params;
-        params.m_MaxResources = max_resources;
-        params.m_Flags = 0;
-
-        dmResourceArchive::ClearArchiveLoaders(); // in case we've rebooted
-        dmResourceArchive::RegisterDefaultArchiveLoader();
-
-        if (dLib::IsDebugMode())
         {
-            params.m_Flags = RESOURCE_FACTORY_FLAGS_RELOAD_SUPPORT;
-
-            int32_t http_cache = dmConfigFile::GetInt(engine->m_Config, "resource.http_cache", 1);
-            if (http_cache)
-                params.m_Flags |= RESOURCE_FACTORY_FLAGS_HTTP_CACHE;
-        }
-
-        int32_t liveupdate_enable = dmConfigFile::GetInt(engine->m_Config, "liveupdate.enabled", 1);
-        if (liveupdate_enable)
-        {
-            params.m_Flags |= RESOURCE_FACTORY_FLAGS_LIVE_UPDATE;
-
-            dmLiveUpdate::RegisterArchiveLoaders();
+            DM_PROFILE(Engine, "WaitFactory");
+            FinishBootTask(&factory_task);
         }
+        EndBootPhase(&boot_phases, "factory_wait");
+        AddBootPhase(&boot_phases, "factory", factory_task.m_Duration, factory_task.m_Parallel);
 
-#if defined(DM_RELEASE)
-        params.m_ArchiveIndex.m_Data = (const void*) BUILTINS_RELEASE_ARCI;
-        params.m_ArchiveIndex.m_Size = BUILTINS_RELEASE_ARCI_SIZE;
-        params.m_ArchiveData.m_Data = (const void*) BUILTINS_RELEASE_ARCD;
-        params.m_ArchiveData.m_Size = BUILTINS_RELEASE_ARCD_SIZE;
-        params.m_ArchiveManifest.m_Data = (const void*) BUILTINS_RELEASE_DMANIFEST;
-        params.m_ArchiveManifest.m_Size = BUILTINS_RELEASE_DMANIFEST_SIZE;
-#else
-        params.m_ArchiveIndex.m_Data = (const void*) BUILTINS_ARCI;
-        params.m_ArchiveIndex.m_Size = BUILTINS_ARCI_SIZE;
-        params.m_ArchiveData.m_Data = (const void*) BUILTINS_ARCD;
-        params.m_ArchiveData.m_Size = BUILTINS_ARCD_SIZE;
-        params.m_ArchiveManifest.m_Data = (const void*) BUILTINS_DMANIFEST;
-        params.m_ArchiveManifest.m_Size = BUILTINS_DMANIFEST_SIZE;
-#endif
-
-        const char* resource_uri = dmConfigFile::GetString(engine->m_Config, "resource.uri", content_root);
-        dmLogInfo("Loading data from: %s", resource_uri);
-        engine->m_Factory = dmResource::NewFactory(&params, resource_uri);
+        engine->m_Factory = factory_ctx.m_Factory;
         if (!engine->m_Factory)
         {
+            FinishBootTask(&sound_task);
             return false;
         }
+        dmResource::SetResourceLoadedCallback(engine->m_Factory, ResourceLoadedCallback, engine);
 
         dmScript::ClearLuaRefCount(); // Reset the debug counter to 0
 
@@ -844,7 +1227,6 @@ namespace dmEngine
         bool shared = dmConfigFile::GetInt(engine->m_Config, "script.shared_state", 0);
         if (shared) {
             engine->m_SharedScriptContext = dmScript::NewContext(engine->m_Config, engine->m_Factory, true);
-            dmScript::Initialize(engine->m_SharedScriptContext);
             engine->m_GOScriptContext = engine->m_SharedScriptContext;
             engine->m_RenderScriptContext = engine->m_SharedScriptContext;
             engine->m_GuiScriptContext = engine->m_SharedScriptContext;
@@ -852,37 +1234,34 @@ namespace dmEngine
             module_script_contexts.Push(engine->m_SharedScriptContext);
         } else {
             engine->m_GOScriptContext = dmScript::NewContext(engine->m_Config, engine->m_Factory, true);
-            dmScript::Initialize(engine->m_GOScriptContext);
             engine->m_RenderScriptContext = dmScript::NewContext(engine->m_Config, engine->m_Factory, true);
-            dmScript::Initialize(engine->m_RenderScriptContext);
             engine->m_GuiScriptContext = dmScript::NewContext(engine->m_Config, engine->m_Factory, true);
-            dmScript::Initialize(engine->m_GuiScriptContext);
             module_script_contexts.SetCapacity(3);
             module_script_contexts.Push(engine->m_GOScriptContext);
             module_script_contexts.Push(engine->m_RenderScriptContext);
             module_script_contexts.Push(engine->m_GuiScriptContext);
         }
 
+        for (uint32_t i = 0; i < module_script_contexts.Size(); ++i)
+        {
+            // Set before initializing, so that native extensions get the job context in their Initialize()
+            dmScript::SetJobContext(module_script_contexts[i], engine->m_JobContext);
+            dmScript::Initialize(module_script_contexts[i]);
+        }
+
         dmHID::Init(engine->m_HidContext);
 
-        dmSound::InitializeParams sound_params;
-        sound_params.m_OutputDevice = "default";
-#if defined(__EMSCRIPTEN__)
-        sound_params.m_UseThread = false;
-#else
-        sound_params.m_UseThread = dmConfigFile::GetInt(engine->m_Config, "sound.use_thread", 1) != 0;
-#endif
-        dmSound::Result soundInit = dmSound::Initialize(engine->m_Config, &sound_params);
-        if (dmSound::RESULT_OK == soundInit) {
-            dmLogInfo("Initialised sound device '%s'", sound_params.m_OutputDevice);
-        } else {
-            dmLogWarning("Failed to initialize sound system.");
-        }
+        dmGameObject::SetJobContext(engine->m_Register, engine->m_JobContext);
+        dmGameObject::SetFrameAllocator(engine->m_Register, engine->m_FrameAllocator);
+        dmGraphics::SetJobContext(engine->m_GraphicsContext, engine->m_JobContext);
+
+        EndBootPhase(&boot_phases, "scripts");
 
         dmGameObject::Result go_result = dmGameObject::SetCollectionDefaultCapacity(engine->m_Register, dmConfigFile::GetInt(engine->m_Config, dmGameObject::COLLECTION_MAX_INSTANCES_KEY, dmGameObject::DEFAULT_MAX_COLLECTION_CAPACITY));
         if(go_result != dmGameObject::RESULT_OK)
         {
             dmLogFatal("Failed to set max instance count for collections (%d)", go_result);
+            FinishBootTask(&sound_task);
             return false;
         }
         dmGameObject::SetInputStackDefaultCapacity(engine->m_Register, dmConfigFile::GetInt(engine->m_Config, dmGameObject::COLLECTION_MAX_INPUT_STACK_ENTRIES_KEY, dmGameObject::DEFAULT_MAX_INPUT_STACK_CAPACITY));
@@ -899,6 +1278,7 @@ namespace dmEngine
         render_params.m_CommandBufferSize = 1024;
         render_params.m_ScriptContext = engine->m_RenderScriptContext;
         render_params.m_MaxDebugVertexCount = (uint32_t) dmConfigFile::GetInt(engine->m_Config, "graphics.max_debug_vertices", 10000);
+        render_params.m_JobContext = engine->m_JobContext;
         engine->m_RenderContext = dmRender::NewRenderContext(engine->m_GraphicsContext, render_params);
 
         dmGameObject::Initialize(engine->m_Register, engine->m_GOScriptContext);
@@ -907,7 +1287,9 @@ namespace dmEngine
         engine->m_ParticleFXContext.m_RenderContext = engine->m_RenderContext;
         engine->m_ParticleFXContext.m_MaxParticleFXCount = dmConfigFile::GetInt(engine->m_Config, dmParticle::MAX_INSTANCE_COUNT_KEY, 64);
         engine->m_ParticleFXContext.m_MaxParticleCount = dmConfigFile::GetInt(engine->m_Config, dmParticle::MAX_PARTICLE_COUNT_KEY, 1024);
+        engine->m_ParticleFXContext.m_OffscreenUpdate = dmConfigFile::GetInt(engine->m_Config, dmParticle::OFFSCREEN_UPDATE_KEY, dmParticle::OFFSCREEN_UPDATE_ALWAYS);
         engine->m_ParticleFXContext.m_Debug = false;
+        engine->m_ParticleFXContext.m_Instancing = dmConfigFile::GetInt(engine->m_Config, "particle_fx.instancing", 0) != 0;
 
         dmInput::NewContextParams input_params;
         input_params.m_HidContext = engine->m_HidContext;
@@ -919,6 +1301,7 @@ namespace dmEngine
         if (mr != dmMessage::RESULT_OK)
         {
             dmLogFatal("Unable to create system socket: %s (%d)", SYSTEM_SOCKET_NAME, mr);
+            FinishBootTask(&sound_task);
             return false;
         }
 
@@ -969,6 +1352,10 @@ namespace dmEngine
         }
         physics_params.m_ContactImpulseLimit = dmConfigFile::GetFloat(engine->m_Config, "physics.contact_impulse_limit", 0.0f);
         physics_params.m_AllowDynamicTransforms = dmConfigFile::GetInt(engine->m_Config, "physics.allow_dynamic_transforms", 1) ? 1 : 0;
+        if (dmConfigFile::GetInt(engine->m_Config, "physics.parallel_islands", 0))
+        {
+            physics_params.m_JobContext = engine->m_JobContext;
+        }
         if (dmStrCaseCmp(physics_type, "3D") == 0)
         {
             engine->m_PhysicsContext.m_3D = true;
@@ -987,6 +1374,9 @@ namespace dmEngine
         }
         engine->m_PhysicsContext.m_MaxCollisionCount = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::PHYSICS_MAX_COLLISIONS_KEY, 64);
         engine->m_PhysicsContext.m_MaxContactPointCount = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::PHYSICS_MAX_CONTACTS_KEY, 128);
+        engine->m_PhysicsContext.m_FixedUpdateFrequency = (uint32_t) dmMath::Max(0, dmConfigFile::GetInt(engine->m_Config, dmGameSystem::PHYSICS_FIXED_UPDATE_FREQUENCY_KEY, 0));
+        engine->m_PhysicsContext.m_MaxFixedTimesteps = (uint32_t) dmMath::Max(1, dmConfigFile::GetInt(engine->m_Config, dmGameSystem::PHYSICS_MAX_FIXED_TIMESTEPS_KEY, 4));
+        engine->m_PhysicsContext.m_Interpolate = (bool) dmConfigFile::GetInt(engine->m_Config, dmGameSystem::PHYSICS_INTERPOLATE_KEY, 1);
         // TODO: Should move inside the ifdef release? Is this usable without the debug callbacks?
         engine->m_PhysicsContext.m_Debug = (bool) dmConfigFile::GetInt(engine->m_Config, "physics.debug", 0);
 
@@ -1008,18 +1398,27 @@ namespace dmEngine
         engine->m_SpriteContext.m_RenderContext = engine->m_RenderContext;
         engine->m_SpriteContext.m_MaxSpriteCount = dmConfigFile::GetInt(engine->m_Config, "sprite.max_count", 128);
         engine->m_SpriteContext.m_Subpixels = dmConfigFile::GetInt(engine->m_Config, "sprite.subpixels", 1);
+        engine->m_SpriteContext.m_Instancing = dmConfigFile::GetInt(engine->m_Config, "sprite.instancing", 0);
+        engine->m_SpriteContext.m_GrowOnDemand = dmConfigFile::GetInt(engine->m_Config, "sprite.grow_on_demand", 0);
+        engine->m_SpriteContext.m_CompactVertices = dmConfigFile::GetInt(engine->m_Config, "sprite.compact_vertices", 0);
 
         engine->m_ModelContext.m_RenderContext = engine->m_RenderContext;
         engine->m_ModelContext.m_Factory = engine->m_Factory;
         engine->m_ModelContext.m_MaxModelCount = max_model_count;
+        engine->m_ModelContext.m_Instancing = dmConfigFile::GetInt(engine->m_Config, "model.instancing", 0);
+        engine->m_ModelContext.m_AnimationLodDistance = dmConfigFile::GetFloat(engine->m_Config, "model.animation_lod_distance", 0.0f);
+        engine->m_ModelContext.m_AnimationLodInterval = dmConfigFile::GetInt(engine->m_Config, "model.animation_lod_interval", 4);
+        engine->m_ModelContext.m_BakedAnimations = dmConfigFile::GetInt(engine->m_Config, "model.baked_animations", 0);
 
         engine->m_MeshContext.m_RenderContext = engine->m_RenderContext;
         engine->m_MeshContext.m_Factory       = engine->m_Factory;
         engine->m_MeshContext.m_MaxMeshCount = dmConfigFile::GetInt(engine->m_Config, "mesh.max_count", 128);
+        engine->m_MeshContext.m_Instancing = dmConfigFile::GetInt(engine->m_Config, "mesh.instancing", 0);
 
         engine->m_LabelContext.m_RenderContext      = engine->m_RenderContext;
         engine->m_LabelContext.m_MaxLabelCount      = dmConfigFile::GetInt(engine->m_Config, "label.max_count", 64);
         engine->m_LabelContext.m_Subpixels          = dmConfigFile::GetInt(engine->m_Config, "label.subpixels", 1);
+        engine->m_LabelContext.m_Instancing         = dmConfigFile::GetInt(engine->m_Config, "label.instancing", 0);
 
         engine->m_TilemapContext.m_RenderContext    = engine->m_RenderContext;
         engine->m_TilemapContext.m_MaxTilemapCount  = dmConfigFile::GetInt(engine->m_Config, "tilemap.max_count", 16);
@@ -1029,9 +1428,11 @@ namespace dmEngine
 
         engine->m_CollectionProxyContext.m_Factory = engine->m_Factory;
         engine->m_CollectionProxyContext.m_MaxCollectionProxyCount = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::COLLECTION_PROXY_MAX_COUNT_KEY, 8);
+        engine->m_CollectionProxyContext.m_TimeBudget = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::COLLECTION_PROXY_TIME_BUDGET_KEY, 4000);
 
         engine->m_FactoryContext.m_MaxFactoryCount = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::FACTORY_MAX_COUNT_KEY, 128);
         engine->m_CollectionFactoryContext.m_MaxCollectionFactoryCount = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::COLLECTION_FACTORY_MAX_COUNT_KEY, 128);
+        engine->m_CollectionFactoryContext.m_InitTimeBudget = (uint32_t)(dmConfigFile::GetFloat(engine->m_Config, dmGameSystem::COLLECTION_FACTORY_INIT_TIME_BUDGET_KEY, 4.0f) * 1000.0f);
         if (shared)
         {
             engine->m_FactoryContext.m_ScriptContext = engine->m_SharedScriptContext;
@@ -1052,6 +1453,20 @@ namespace dmEngine
         component_create_ctx.m_Contexts.Put(dmHashString64("graphics"), engine->m_GraphicsContext);
         component_create_ctx.m_Contexts.Put(dmHashString64("render"), engine->m_RenderContext);
 
+        EndBootPhase(&boot_phases, "contexts");
+
+        {
+            DM_PROFILE(Engine, "WaitSound");
+            FinishBootTask(&sound_task);
+        }
+        EndBootPhase(&boot_phases, "sound_wait");
+        AddBootPhase(&boot_phases, "sound", sound_task.m_Duration, sound_task.m_Parallel);
+        if (dmSound::RESULT_OK == sound_ctx.m_Result) {
+            dmLogInfo("Initialised sound device '%s'", sound_ctx.m_Params.m_OutputDevice);
+        } else {
+            dmLogWarning("Failed to initialize sound system.");
+        }
+
         dmResource::Result fact_result;
         dmGameSystem::ScriptLibContext script_lib_context;
 
@@ -1067,14 +1482,35 @@ namespace dmEngine
         if (fact_result != dmResource::RESULT_OK)
             goto bail;
 
-        fact_result = dmGameSystem::RegisterResourceTypes(engine->m_Factory, engine->m_RenderContext, &engine->m_GuiContext, engine->m_InputContext, &engine->m_PhysicsContext);
+        fact_result = dmGameSystem::RegisterResourceTypes(engine->m_Factory, engine->m_RenderContext, &engine->m_GuiContext, engine->m_InputContext, &engine->m_PhysicsContext, HEADLESS_SERVER);
         if (fact_result != dmResource::RESULT_OK)
             goto bail;
 
+        if (dmConfigFile::GetInt(engine->m_Config, "graphics.texture_streaming_budget", 0) > 0)
+        {
+            dmGameSystem::TextureStreamingParams texture_streaming_params;
+            texture_streaming_params.m_Factory = engine->m_Factory;
+            texture_streaming_params.m_RenderContext = engine->m_RenderContext;
+            texture_streaming_params.m_MemoryBudget = dmConfigFile::GetInt(engine->m_Config, "graphics.texture_streaming_budget", 0) * 1024*1024; // MB -> bytes
+            texture_streaming_params.m_InitialMaxSize = dmConfigFile::GetInt(engine->m_Config, "graphics.texture_streaming_initial_size", 256);
+            dmGameSystem::InitializeTextureStreaming(texture_streaming_params);
+        }
+
+        if (dmConfigFile::GetInt(engine->m_Config, "graphics.transcode_cache", 1) != 0)
+        {
+            const char* application_name = dmConfigFile::GetString(engine->m_Config, "project.title", "TestTitle");
+            char transcode_cache_directory[DMPATH_MAX_PATH];
+            if (dmSys::GetApplicationSavePath(application_name, transcode_cache_directory, sizeof(transcode_cache_directory)) == dmSys::RESULT_OK &&
+                dmStrlCat(transcode_cache_directory, "/transcode_cache", sizeof(transcode_cache_directory)) < sizeof(transcode_cache_directory))
+            {
+                dmGameSystem::SetTranscodeCacheDirectory(transcode_cache_directory);
+            }
+        }
+
         go_result = dmGameSystem::RegisterComponentTypes(engine->m_Factory, engine->m_Register, engine->m_RenderContext, &engine->m_PhysicsContext, &engine->m_ParticleFXContext, &engine->m_GuiContext, &engine->m_SpriteContext,
                                                                                                 &engine->m_CollectionProxyContext, &engine->m_FactoryContext, &engine->m_CollectionFactoryContext,
                                                                                                 &engine->m_ModelContext, &engine->m_MeshContext, &engine->m_LabelContext, &engine->m_TilemapContext,
-                                                                                                &engine->m_SoundContext);
+                                                                                                &engine->m_SoundContext, HEADLESS_SERVER);
         if (go_result != dmGameObject::RESULT_OK)
             goto bail;
 
@@ -1083,11 +1519,14 @@ namespace dmEngine
         if (go_result != dmGameObject::RESULT_OK)
             goto bail;
 
+        EndBootPhase(&boot_phases, "types");
+
         if (!LoadBootstrapContent(engine, engine->m_Config))
         {
             dmLogError("Unable to load bootstrap data.");
             goto bail;
         }
+        EndBootPhase(&boot_phases, "bootstrap");
 
 #if !defined(DM_RELEASE)
         {
@@ -1142,7 +1581,7 @@ namespace dmEngine
         dmGui::SetDisplayProfiles(engine->m_GuiContext.m_GuiContext, engine->m_DisplayProfiles);
 
         // clear it a couple of times, due to initialization of extensions might stall the updates
-        for (int i = 0; i < 3; ++i) {
+        for (int i = 0; i < 3 && !HEADLESS_SERVER; ++i) {
             dmGraphics::BeginFrame(engine->m_GraphicsContext);
             dmGraphics::SetViewport(engine->m_GraphicsContext, 0, 0, dmGraphics::GetWindowWidth(engine->m_GraphicsContext), dmGraphics::GetWindowHeight(engine->m_GraphicsContext));
             dmGraphics::Clear(engine->m_GraphicsContext, dmGraphics::BUFFER_TYPE_COLOR_BIT,
@@ -1260,6 +1699,10 @@ namespace dmEngine
         engine->m_PreviousFrameTime = dmTime::GetTime() - 1000000/60;
         engine->m_FlipTime = dmTime::GetTime();
         engine->m_PreviousRenderTime = 0;
+        engine->m_NextTickTime = 0;
+
+        EndBootPhase(&boot_phases, "main_collection");
+        LogBootPhases(&boot_phases);
 
         return true;
 
@@ -1324,10 +1767,34 @@ bail:
         input_action.m_GamepadConnected = action->m_GamepadConnected;
         input_action.m_GamepadPacket = action->m_GamepadPacket;
         input_action.m_HasGamepadPacket = action->m_HasGamepadPacket;
+        input_action.m_Timestamp = action->m_Timestamp;
 
         input_buffer->Push(input_action);
     }
 
+    static bool HasActionChanged(const dmInput::Action* action)
+    {
+        if (action->m_Pressed || action->m_Released || action->m_Dirty || action->m_HasText || action->m_GamepadConnected || action->m_GamepadDisconnected)
+            return true;
+        if (action->m_PositionSet && (action->m_DX != 0 || action->m_DY != 0))
+            return true;
+        for (int i = 0; i < action->m_TouchCount; ++i)
+        {
+            if (action->m_Touch[i].m_Phase != dmHID::PHASE_STATIONARY)
+                return true;
+        }
+        return false;
+    }
+
+    static void LateActionCallback(dmhash_t action_id, dmInput::Action* action, void* user_data)
+    {
+        // Inputs that are merely held down were already reported this frame
+        if (HasActionChanged(action))
+        {
+            GOActionCallback(action_id, action, user_data);
+        }
+    }
+
     uint16_t GetHttpPort(HEngine engine)
     {
         if (engine->m_EngineService)
@@ -1346,6 +1813,31 @@ bail:
         return a_is_text - b_is_text;
     }
 
+    /*
+     * Samples the input devices once more after the game update and dispatches what changed since the
+     * update, e.g. cursor and touch movement. Scripts can then react (for instance by messaging the
+     * render script about a camera change) with less latency than waiting for the next frame.
+     * The actions are computed relative to the previous sample, so nothing is reported twice.
+     */
+    static uint32_t LateInputSample(HEngine engine)
+    {
+        DM_PROFILE(Engine, "LateInputSample");
+        dmHID::Update(engine->m_HidContext);
+        dmInput::UpdateBinding(engine->m_GameInputBinding, 0.0f);
+
+        engine->m_InputBuffer.SetSize(0);
+        dmInput::ForEachActive(engine->m_GameInputBinding, LateActionCallback, engine);
+        qsort(engine->m_InputBuffer.Begin(), engine->m_InputBuffer.Size(), sizeof(dmGameObject::InputAction), InputBufferOrderSort);
+
+        dmArray<dmGameObject::InputAction>& input_buffer = engine->m_InputBuffer;
+        uint32_t input_buffer_size = input_buffer.Size();
+        if (input_buffer_size > 0)
+        {
+            dmGameObject::DispatchInput(engine->m_MainCollection, &input_buffer[0], input_buffer_size);
+        }
+        return input_buffer_size;
+    }
+
     static uint32_t GetLuaMemCount(HEngine engine)
     {
         uint32_t memcount = 0;
@@ -1361,6 +1853,107 @@ bail:
         return memcount;
     }
 
+    struct CrashFrameContext
+    {
+        dmCrash::FrameInfo* m_Info;
+        float               m_TicksToMs;
+        uint32_t            m_MemCounterHash;
+    };
+
+    static void CrashFrameScope(void* context, const dmProfile::ScopeData* scope_data)
+    {
+        CrashFrameContext* ctx = (CrashFrameContext*)context;
+        dmCrash::FrameInfo* info = ctx->m_Info;
+        if (scope_data->m_Count == 0)
+            return;
+
+        // Keep the most expensive scopes, sorted by time
+        float time = scope_data->m_Elapsed * ctx->m_TicksToMs;
+        uint32_t i = dmCrash::FRAME_SCOPES_MAX;
+        while (i > 0 && (info->m_ScopeNames[i-1] == 0 || info->m_ScopeTimes[i-1] < time))
+            --i;
+        if (i == dmCrash::FRAME_SCOPES_MAX)
+            return;
+        for (uint32_t j = dmCrash::FRAME_SCOPES_MAX - 1; j > i; --j)
+        {
+            info->m_ScopeNames[j] = info->m_ScopeNames[j-1];
+            info->m_ScopeTimes[j] = info->m_ScopeTimes[j-1];
+        }
+        info->m_ScopeNames[i] = scope_data->m_Scope->m_Name;
+        info->m_ScopeTimes[i] = time;
+    }
+
+    static void CrashFrameCounter(void* context, const dmProfile::CounterData* counter_data)
+    {
+        CrashFrameContext* ctx = (CrashFrameContext*)context;
+        if (counter_data->m_Counter->m_NameHash == ctx->m_MemCounterHash)
+            ctx->m_Info->m_Mem = (uint32_t)counter_data->m_Value;
+    }
+
+    // Records the frame into the crash dump flight recorder. Like the benchmark, the frame time is
+    // paired with the profile returned by dmProfile::Begin, which holds the scopes of the previous frame
+    static void RecordCrashFrame(HEngine engine, dmProfile::HProfile profile, uint64_t frame_time)
+    {
+        dmCrash::FrameInfo info;
+        memset(&info, 0, sizeof(info));
+        info.m_FrameTime = frame_time / 1000.0f;
+        info.m_LuaMem = GetLuaMemCount(engine);
+        if (profile)
+        {
+            // Set by the profiler extension, when it is enabled
+            static const char* mem_counter = "Mem Usage (Kb)";
+            CrashFrameContext ctx;
+            ctx.m_Info = &info;
+            ctx.m_TicksToMs = 1000.0f / (float)dmProfile::GetTicksPerSecond();
+            ctx.m_MemCounterHash = dmProfile::GetNameHash(mem_counter, (uint32_t)strlen(mem_counter));
+            dmProfile::IterateScopeData(profile, &ctx, false, CrashFrameScope);
+            dmProfile::IterateCounterData(profile, &ctx, CrashFrameCounter);
+        }
+        dmCrash::RecordFrame(&info);
+    }
+
+    // When rendering on demand, a frame is only rendered if the game changed anything that is drawn,
+    // there was input, or the render script has messages waiting (e.g. window_resized or draw_text)
+    static bool NeedsRender(HEngine engine, uint32_t input_count)
+    {
+        // Always consume the changes, so that they don't carry over to the next frame
+        bool changed = dmGameObject::ConsumeChanges(engine->m_Register);
+        if (changed || engine->m_ForceRender || input_count > 0)
+            return true;
+
+        dmMessage::HSocket render_socket;
+        return dmMessage::GetSocket(dmRender::RENDER_SOCKET_NAME, &render_socket) == dmMessage::RESULT_OK
+            && dmMessage::HasMessages(render_socket);
+    }
+
+    static void IgnoreMessage(dmMessage::Message* message, void* user_ptr)
+    {
+    }
+
+    // Waits until the start of the next tick. The deadline is absolute, so that the sleep granularity
+    // doesn't add up to a drift over time. The last millisecond is spun, since sleeping can overshoot.
+    static void WaitForNextTick(HEngine engine, uint64_t target_frametime)
+    {
+        uint64_t now = dmTime::GetTime();
+        uint64_t deadline = engine->m_NextTickTime + target_frametime;
+        if (engine->m_NextTickTime == 0 || deadline < now)
+        {
+            // First tick, or we're running behind. Start over from now, instead of trying to catch up
+            engine->m_NextTickTime = now;
+            return;
+        }
+        engine->m_NextTickTime = deadline;
+
+        const uint64_t spin_time = 1000;
+        if (deadline - now > spin_time)
+        {
+            dmTime::Sleep((uint32_t)(deadline - now - spin_time));
+        }
+        while (dmTime::GetTime() < deadline)
+        {
+        }
+    }
+
     void Step(HEngine engine)
     {
         engine->m_Alive = true;
@@ -1385,10 +1978,16 @@ bail:
                 dt = max;
             }
         }
+        else if (engine->m_FramePacing.m_Enabled && !engine->m_UseSwVsync) {
+            dt = engine->m_FramePacing.m_FrameDt;
+        }
 
         if (engine->m_WasIconified && !engine->m_RunWhileIconified && dt > 0.5f) {
             dt = fixed_dt;
         }
+        if (engine->m_Benchmark.m_FrameCount != 0) {
+            dt = engine->m_Benchmark.m_Dt;
+        }
         engine->m_PreviousFrameTime = time;
 
         if (engine->m_Alive)
@@ -1438,6 +2037,9 @@ bail:
             {
                 DM_PROFILE(Engine, "Frame");
 
+                dmFrameAlloc::NewFrame(engine->m_FrameAllocator);
+
+                bool render = !HEADLESS_SERVER;
                 {
                     DM_PROFILE(Engine, "Sim");
 
@@ -1491,6 +2093,10 @@ bail:
 
                     engine->m_InputBuffer.SetSize(0);
                     dmInput::ForEachActive(engine->m_GameInputBinding, GOActionCallback, engine);
+                    if (engine->m_Benchmark.m_FrameCount != 0)
+                    {
+                        ReplayBenchmarkInput(&engine->m_Benchmark, GOActionCallback, engine);
+                    }
 
                     // Sort input so that text and marked text is triggered last
                     // NOTE: Due to Korean keyboards on iOS will send a backspace sometimes to "replace" a character with a new one,
@@ -1507,23 +2113,35 @@ bail:
                     }
 
 
+                    dmExtension::Params ext_update_params;
+                    InitExtensionParams(engine, &ext_update_params);
+                    dmExtension::PreUpdate(&ext_update_params);
+
                     dmGameObject::UpdateContext update_context;
                     update_context.m_DT = dt;
                     dmGameObject::Update(engine->m_MainCollection, &update_context);
 
+                    dmExtension::PostUpdate(&ext_update_params);
+
+                    if (engine->m_LateInputSample)
+                    {
+                        input_buffer_size += LateInputSample(engine);
+                    }
+
+                    if (engine->m_RenderOnDemand)
+                    {
+                        render = NeedsRender(engine, input_buffer_size);
+                        engine->m_ForceRender = false;
+                    }
+
                     // Don't render while iconified
-                    if (!dmGraphics::GetWindowState(engine->m_GraphicsContext, dmGraphics::WINDOW_STATE_ICONIFIED))
+                    if (render && !dmGraphics::GetWindowState(engine->m_GraphicsContext, dmGraphics::WINDOW_STATE_ICONIFIED))
                     {
                         // Call pre render functions for extensions, if available.
                         // We do it here before we render rest of the frame
                         // if any extension wants to render on under of the game.
                         dmExtension::Params ext_params;
-                        ext_params.m_ConfigFile = engine->m_Config;
-                        if (engine->m_SharedScriptContext) {
-                            ext_params.m_L = dmScript::GetLuaState(engine->m_SharedScriptContext);
-                        } else {
-                            ext_params.m_L = dmScript::GetLuaState(engine->m_GOScriptContext);
-                        }
+                        InitExtensionParams(engine, &ext_params);
                         dmExtension::PreRender(&ext_params);
 
                         // Make the render list that will be used later.
@@ -1562,6 +2180,7 @@ bail:
                     dmGameObject::PostUpdate(engine->m_Register);
 
                     dmRender::ClearRenderObjects(engine->m_RenderContext);
+                    dmGameSystem::UpdateTextureStreaming();
 
 
                     dmMessage::Dispatch(engine->m_SystemSocket, Dispatch, engine);
@@ -1583,71 +2202,113 @@ bail:
                     dmEngineService::Update(engine->m_EngineService, profile);
                 }
 
-                dmProfiler::RenderProfiler(profile, engine->m_GraphicsContext, engine->m_RenderContext, engine->m_SystemFontMap);
+                if (HEADLESS_SERVER)
+                {
+                    // Messages to the render script are never dispatched, so drop them before they fill up the socket
+                    dmMessage::HSocket render_socket;
+                    if (dmMessage::GetSocket(dmRender::RENDER_SOCKET_NAME, &render_socket) == dmMessage::RESULT_OK)
+                    {
+                        dmMessage::Dispatch(render_socket, IgnoreMessage, 0x0);
+                    }
 
-                // Call post render functions for extensions, if available.
-                // We do it here at the end of the frame (before swap buffers/flip)
-                // if any extension wants to render on top of the game.
-                // Don't do this while iconified
-                if (!dmGraphics::GetWindowState(engine->m_GraphicsContext, dmGraphics::WINDOW_STATE_ICONIFIED))
+                    DM_PROFILE(Engine, "Idle");
+                    if (engine->m_Benchmark.m_FrameCount == 0)
+                    {
+                        WaitForNextTick(engine, target_frametime);
+                    }
+                    engine->m_FlipTime = dmTime::GetTime();
+                }
+                else if (!render)
                 {
-                    dmExtension::Params ext_params;
-                    ext_params.m_ConfigFile = engine->m_Config;
-                    if (engine->m_SharedScriptContext) {
-                        ext_params.m_L = dmScript::GetLuaState(engine->m_SharedScriptContext);
-                    } else {
-                        ext_params.m_L = dmScript::GetLuaState(engine->m_GOScriptContext);
+                    // Nothing changed, so there is no need to present the frame again. Sleep for the rest of
+                    // the frame instead, the simulation still runs at the update frequency
+                    DM_PROFILE(Engine, "Idle");
+                    uint64_t frame_dt = dmTime::GetTime() - time;
+                    if (frame_dt < target_frametime)
+                    {
+                        dmTime::Sleep((uint32_t)(target_frametime - frame_dt));
                     }
-                    dmExtension::PostRender(&ext_params);
+                    engine->m_FlipTime = dmTime::GetTime();
                 }
-
-                if (engine->m_UseSwVsync)
+                else
                 {
-                    uint64_t flip_dt = dmTime::GetTime() - prev_flip_time;
-                    int remainder = (int)((target_frametime - flip_dt) - engine->m_PreviousRenderTime);
-                    if (!engine->m_UseVariableDt && flip_dt < target_frametime && remainder > 1000) // only bother with sleep if diff b/w target and actual time is big enough
+                    dmProfiler::RenderProfiler(profile, engine->m_GraphicsContext, engine->m_RenderContext, engine->m_SystemFontMap);
+
+                    // Call post render functions for extensions, if available.
+                    // We do it here at the end of the frame (before swap buffers/flip)
+                    // if any extension wants to render on top of the game.
+                    // Don't do this while iconified
+                    if (!dmGraphics::GetWindowState(engine->m_GraphicsContext, dmGraphics::WINDOW_STATE_ICONIFIED))
+                    {
+                        dmExtension::Params ext_params;
+                        InitExtensionParams(engine, &ext_params);
+                        dmExtension::PostRender(&ext_params);
+                    }
+
+                    if (engine->m_UseSwVsync)
                     {
-                        DM_PROFILE(Engine, "SoftwareVsync");
-                        while (remainder > 500) // dont bother with less than 0.5ms
+                        uint64_t flip_dt = dmTime::GetTime() - prev_flip_time;
+                        int remainder = (int)((target_frametime - flip_dt) - engine->m_PreviousRenderTime);
+                        if (!engine->m_UseVariableDt && engine->m_Benchmark.m_FrameCount == 0 && flip_dt < target_frametime && remainder > 1000) // only bother with sleep if diff b/w target and actual time is big enough
                         {
-                            uint64_t t1 = dmTime::GetTime();
-                            dmTime::Sleep(100); // sleep in chunks of 0.1ms
-                            uint64_t t2 = dmTime::GetTime();
-                            remainder -= (t2-t1);
+                            DM_PROFILE(Engine, "SoftwareVsync");
+                            while (remainder > 500) // dont bother with less than 0.5ms
+                            {
+                                uint64_t t1 = dmTime::GetTime();
+                                dmTime::Sleep(100); // sleep in chunks of 0.1ms
+                                uint64_t t2 = dmTime::GetTime();
+                                remainder -= (t2-t1);
+                            }
                         }
                     }
-                }
-                uint64_t flip_time_start = dmTime::GetTime();
+                    uint64_t flip_time_start = dmTime::GetTime();
 
-                dmGraphics::Flip(engine->m_GraphicsContext);
+                    dmGraphics::Flip(engine->m_GraphicsContext);
 
-                engine->m_FlipTime = dmTime::GetTime();
-                engine->m_PreviousRenderTime = engine->m_FlipTime - flip_time_start;
+                    engine->m_FlipTime = dmTime::GetTime();
+                    engine->m_PreviousRenderTime = engine->m_FlipTime - flip_time_start;
+                    UpdateFramePacing(engine, engine->m_FlipTime - prev_flip_time);
 
-                RecordData* record_data = &engine->m_RecordData;
-                if (record_data->m_Recorder)
-                {
-                    if (record_data->m_FrameCount % record_data->m_FramePeriod == 0)
+                    RecordData* record_data = &engine->m_RecordData;
+                    if (record_data->m_Recorder)
                     {
-                        uint32_t width = dmGraphics::GetWidth(engine->m_GraphicsContext);
-                        uint32_t height = dmGraphics::GetHeight(engine->m_GraphicsContext);
-                        uint32_t buffer_size = width * height * 4;
+                        if (record_data->m_FrameCount % record_data->m_FramePeriod == 0)
+                        {
+                            uint32_t width = dmGraphics::GetWidth(engine->m_GraphicsContext);
+                            uint32_t height = dmGraphics::GetHeight(engine->m_GraphicsContext);
+                            uint32_t buffer_size = width * height * 4;
 
-                        dmGraphics::ReadPixels(engine->m_GraphicsContext, record_data->m_Buffer, buffer_size);
+                            dmGraphics::ReadPixels(engine->m_GraphicsContext, record_data->m_Buffer, buffer_size);
 
-                        dmRecord::Result r = dmRecord::RecordFrame(record_data->m_Recorder, record_data->m_Buffer, buffer_size, dmRecord::BUFFER_FORMAT_BGRA);
-                        if (r != dmRecord::RESULT_OK)
-                        {
-                            dmLogError("Error while recoding frame (%d)", r);
+                            dmRecord::Result r = dmRecord::RecordFrame(record_data->m_Recorder, record_data->m_Buffer, buffer_size, dmRecord::BUFFER_FORMAT_BGRA);
+                            if (r != dmRecord::RESULT_OK)
+                            {
+                                dmLogError("Error while recoding frame (%d)", r);
+                            }
                         }
+                        record_data->m_FrameCount++;
                     }
-                    record_data->m_FrameCount++;
                 }
             }
+            uint64_t frame_time = dmTime::GetTime() - time;
+            RecordCrashFrame(engine, profile, frame_time);
+            bool benchmark_done = false;
+            if (engine->m_Benchmark.m_FrameCount != 0)
+            {
+                benchmark_done = RecordBenchmarkFrame(&engine->m_Benchmark, profile, frame_time);
+            }
             dmProfile::Release(profile);
 
 
             ++engine->m_Stats.m_FrameCount;
+
+            if (benchmark_done)
+            {
+                bool written = WriteBenchmarkResults(&engine->m_Benchmark);
+                engine->m_Alive = false;
+                engine->m_RunResult.m_ExitCode = written ? 0 : 1;
+                engine->m_RunResult.m_Action = dmEngine::RunResult::EXIT;
+            }
         }
     }
 
@@ -1776,6 +2437,7 @@ bail:
             {
                 dmSystemDDF::SetUpdateFrequency* m = (dmSystemDDF::SetUpdateFrequency*) message->m_Data;
                 SetUpdateFrequency(self, (uint32_t) m->m_Frequency);
+                self->m_FramePacing.m_AutoSwapInterval = 0;
             }
             else if (descriptor == dmEngineDDF::HideApp::m_DDFDescriptor) // "hide_app"
             {
@@ -1785,6 +2447,8 @@ bail:
             {
                 dmSystemDDF::SetVsync* m = (dmSystemDDF::SetVsync*) message->m_Data;
                 SetSwapInterval(self, m->m_SwapInterval);
+                self->m_FramePacing.m_SwapInterval = (uint32_t) dmMath::Max(1, (int) m->m_SwapInterval);
+                self->m_FramePacing.m_AutoSwapInterval = 0;
             }
             else if (descriptor == dmEngineDDF::RunScript::m_DDFDescriptor) // "run_script"
             {
@@ -1826,6 +2490,7 @@ bail:
     {
         dmResource::Result fact_error;
 
+#if !defined(DM_HEADLESS_SERVER)
         const char* system_font_map = "/builtins/fonts/system_font.fontc";
         fact_error = dmResource::Get(engine->m_Factory, system_font_map, (void**) &engine->m_SystemFontMap);
         if (fact_error != dmResource::RESULT_OK)
@@ -1834,6 +2499,7 @@ bail:
             return false;
         }
         dmRender::SetSystemFontMap(engine->m_RenderContext, engine->m_SystemFontMap);
+#endif
 
         // The system font is currently the only resource we need from the connection app
         // After this point, the rest of the resources should be loaded the ordinary way
@@ -1862,6 +2528,8 @@ bail:
         if (fact_error != dmResource::RESULT_OK)
             return false;
 
+#if !defined(DM_HEADLESS_SERVER)
+        // The server stubs the render and display profile resource types
         const char* render_path = dmConfigFile::GetString(config, "bootstrap.render", "/builtins/render/default.renderc");
         fact_error = dmResource::Get(engine->m_Factory, render_path, (void**)&engine->m_RenderScriptPrototype);
         if (fact_error != dmResource::RESULT_OK)
@@ -1871,6 +2539,7 @@ bail:
         fact_error = dmResource::Get(engine->m_Factory, display_profiles_path, (void**)&engine->m_DisplayProfiles);
         if (fact_error != dmResource::RESULT_OK)
             return false;
+#endif
 
         return true;
     }
@@ -0,0 +1,301 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "engine_private.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include <dlib/hash.h>
+#include <dlib/log.h>
+
+namespace dmEngine
+{
+    BenchmarkData::BenchmarkData()
+    : m_FrameTimes(0x0)
+    , m_OutputPath(0x0)
+    , m_FrameCount(0)
+    , m_Frame(0)
+    , m_InputIndex(0)
+    , m_Dt(0.0f)
+    {
+        memset(m_ScopeTimes, 0, sizeof(m_ScopeTimes));
+        memset(m_ScopeNames, 0, sizeof(m_ScopeNames));
+    }
+
+    static bool LoadInputEvents(BenchmarkData* data, const char* path)
+    {
+        FILE* f = fopen(path, "rb");
+        if (!f)
+        {
+            dmLogError("Unable to open the benchmark input '%s'", path);
+            return false;
+        }
+
+        bool result = true;
+        uint32_t line_number = 0;
+        char line[256];
+        while (fgets(line, sizeof(line), f))
+        {
+            ++line_number;
+            const char* p = line;
+            while (*p == ' ' || *p == '\t')
+                ++p;
+            if (*p == '#' || *p == '\r' || *p == '\n' || *p == '\0')
+                continue;
+
+            BenchmarkInputEvent event;
+            memset(&event, 0, sizeof(event));
+            char action[128];
+            int count = sscanf(p, "%u %127s %f %d %d", &event.m_Frame, action, &event.m_Value, &event.m_X, &event.m_Y);
+            if (count != 3 && count != 5)
+            {
+                dmLogError("%s:%u: Expected '<frame> <action> <value> [<x> <y>]'", path, line_number);
+                result = false;
+                break;
+            }
+            if (!data->m_InputEvents.Empty() && event.m_Frame < data->m_InputEvents.Back().m_Frame)
+            {
+                dmLogError("%s:%u: The frames must be in ascending order", path, line_number);
+                result = false;
+                break;
+            }
+            // "-" is an action without id, e.g. a mouse movement
+            event.m_ActionId = strcmp(action, "-") == 0 ? 0 : dmHashString64(action);
+            event.m_PositionSet = count == 5;
+
+            if (data->m_InputEvents.Full())
+                data->m_InputEvents.OffsetCapacity(64);
+            data->m_InputEvents.Push(event);
+        }
+        fclose(f);
+        return result;
+    }
+
+    bool InitBenchmark(BenchmarkData* data, dmConfigFile::HConfig config)
+    {
+        int32_t frame_count = dmConfigFile::GetInt(config, "engine.benchmark_frames", 0);
+        if (frame_count <= 0)
+            return true;
+
+        int32_t update_frequency = dmConfigFile::GetInt(config, "engine.benchmark_update_frequency", 60);
+        data->m_FrameCount = (uint32_t)frame_count;
+        data->m_Dt = 1.0f / (float)(update_frequency > 0 ? update_frequency : 60);
+        data->m_OutputPath = dmConfigFile::GetString(config, "engine.benchmark_out", 0);
+        data->m_FrameTimes = (float*)calloc(data->m_FrameCount, sizeof(float));
+
+        const char* input_path = dmConfigFile::GetString(config, "engine.benchmark_input", 0);
+        if (input_path && !LoadInputEvents(data, input_path))
+            return false;
+
+        dmLogInfo("Benchmarking %u frames with dt %f", data->m_FrameCount, data->m_Dt);
+        return true;
+    }
+
+    void FinalizeBenchmark(BenchmarkData* data)
+    {
+        for (uint32_t i = 0; i < MAX_BENCHMARK_SCOPES; ++i)
+        {
+            free(data->m_ScopeTimes[i]);
+            data->m_ScopeTimes[i] = 0x0;
+        }
+        free(data->m_FrameTimes);
+        data->m_FrameTimes = 0x0;
+        data->m_FrameCount = 0;
+    }
+
+    static BenchmarkAction* GetAction(BenchmarkData* data, dmhash_t action_id)
+    {
+        dmArray<BenchmarkAction>& actions = data->m_Actions;
+        for (uint32_t i = 0; i < actions.Size(); ++i)
+        {
+            if (actions[i].m_ActionId == action_id)
+                return &actions[i];
+        }
+        if (actions.Full())
+            actions.OffsetCapacity(16);
+        BenchmarkAction action;
+        memset(&action, 0, sizeof(action));
+        action.m_ActionId = action_id;
+        actions.Push(action);
+        return &actions.Back();
+    }
+
+    void ReplayBenchmarkInput(BenchmarkData* data, BenchmarkActionCallback callback, void* user_data)
+    {
+        dmArray<BenchmarkAction>& actions = data->m_Actions;
+        for (uint32_t i = 0; i < actions.Size(); ++i)
+        {
+            actions[i].m_PrevValue = actions[i].m_Value;
+            actions[i].m_DX = 0;
+            actions[i].m_DY = 0;
+            actions[i].m_Changed = 0;
+        }
+
+        dmArray<BenchmarkInputEvent>& events = data->m_InputEvents;
+        while (data->m_InputIndex < events.Size() && events[data->m_InputIndex].m_Frame <= data->m_Frame)
+        {
+            const BenchmarkInputEvent& event = events[data->m_InputIndex++];
+            BenchmarkAction* action = GetAction(data, event.m_ActionId);
+            action->m_Value = event.m_Value;
+            if (event.m_PositionSet)
+            {
+                if (action->m_PositionSet)
+                {
+                    action->m_DX = event.m_X - action->m_X;
+                    action->m_DY = event.m_Y - action->m_Y;
+                }
+                action->m_X = event.m_X;
+                action->m_Y = event.m_Y;
+                action->m_PositionSet = 1;
+            }
+            action->m_Changed = 1;
+        }
+
+        for (uint32_t i = 0; i < actions.Size(); ++i)
+        {
+            const BenchmarkAction& a = actions[i];
+            if (a.m_Value == 0.0f && !a.m_Changed)
+                continue;
+
+            dmInput::Action action;
+            memset(&action, 0, sizeof(action));
+            action.m_Value = a.m_Value;
+            action.m_PrevValue = a.m_PrevValue;
+            action.m_Pressed = a.m_PrevValue == 0.0f && a.m_Value != 0.0f;
+            action.m_Released = a.m_PrevValue != 0.0f && a.m_Value == 0.0f;
+            action.m_X = a.m_X;
+            action.m_Y = a.m_Y;
+            action.m_DX = a.m_DX;
+            action.m_DY = a.m_DY;
+            action.m_PositionSet = a.m_PositionSet;
+            callback(a.m_ActionId, &action, user_data);
+        }
+
+        // Released actions are forgotten, unless their position is needed for the next delta
+        uint32_t held = 0;
+        for (uint32_t i = 0; i < actions.Size(); ++i)
+        {
+            if (actions[i].m_Value != 0.0f || actions[i].m_PositionSet)
+                actions[held++] = actions[i];
+        }
+        actions.SetSize(held);
+    }
+
+    struct RecordScopeContext
+    {
+        BenchmarkData*  m_Data;
+        float           m_TicksToMs;
+    };
+
+    static void RecordScope(void* context, const dmProfile::ScopeData* scope_data)
+    {
+        RecordScopeContext* ctx = (RecordScopeContext*)context;
+        BenchmarkData* data = ctx->m_Data;
+        uint32_t index = scope_data->m_Scope->m_Index;
+        if (index >= MAX_BENCHMARK_SCOPES || scope_data->m_Count == 0)
+            return;
+
+        if (data->m_ScopeTimes[index] == 0x0)
+        {
+            // Frames before the scope was first sampled count as zero time
+            data->m_ScopeTimes[index] = (float*)calloc(data->m_FrameCount, sizeof(float));
+            data->m_ScopeNames[index] = scope_data->m_Scope->m_Name;
+        }
+        data->m_ScopeTimes[index][data->m_Frame] = scope_data->m_Elapsed * ctx->m_TicksToMs;
+    }
+
+    bool RecordBenchmarkFrame(BenchmarkData* data, dmProfile::HProfile profile, uint64_t frame_time)
+    {
+        if (data->m_Frame >= data->m_FrameCount)
+            return true;
+
+        data->m_FrameTimes[data->m_Frame] = frame_time / 1000.0f;
+        if (profile)
+        {
+            RecordScopeContext ctx;
+            ctx.m_Data = data;
+            ctx.m_TicksToMs = 1000.0f / (float)dmProfile::GetTicksPerSecond();
+            dmProfile::IterateScopeData(profile, &ctx, false, RecordScope);
+        }
+        return ++data->m_Frame == data->m_FrameCount;
+    }
+
+    struct ScopeStats
+    {
+        float m_Mean;
+        float m_P95;
+        float m_Max;
+    };
+
+    static void CalcStats(const float* times, uint32_t count, float* sorted, ScopeStats* stats)
+    {
+        memcpy(sorted, times, count * sizeof(float));
+        std::sort(sorted, sorted + count);
+        double sum = 0.0;
+        for (uint32_t i = 0; i < count; ++i)
+            sum += sorted[i];
+        // Nearest rank percentile
+        uint32_t p95 = (count * 95 + 99) / 100;
+        stats->m_Mean = (float)(sum / count);
+        stats->m_P95 = sorted[p95 > 0 ? p95 - 1 : 0];
+        stats->m_Max = sorted[count - 1];
+    }
+
+    bool WriteBenchmarkResults(BenchmarkData* data)
+    {
+        uint32_t count = data->m_Frame;
+        if (count == 0)
+            return true;
+
+        FILE* f = 0x0;
+        if (data->m_OutputPath)
+        {
+            f = fopen(data->m_OutputPath, "wb");
+            if (!f)
+            {
+                dmLogError("Unable to write the benchmark results to '%s'", data->m_OutputPath);
+            }
+            else
+            {
+                fprintf(f, "{\n  \"frames\": %u,\n  \"dt\": %f,\n  \"scopes\": [\n", count, data->m_Dt);
+            }
+        }
+
+        float* sorted = (float*)malloc(count * sizeof(float));
+        dmLogInfo("Benchmark of %u frames (ms)     mean      p95      max", count);
+
+        ScopeStats stats;
+        CalcStats(data->m_FrameTimes, count, sorted, &stats);
+        dmLogInfo("  %-24s %8.3f %8.3f %8.3f", "Frame", stats.m_Mean, stats.m_P95, stats.m_Max);
+        if (f)
+            fprintf(f, "    {\"name\": \"Frame\", \"mean_ms\": %f, \"p95_ms\": %f, \"max_ms\": %f}", stats.m_Mean, stats.m_P95, stats.m_Max);
+
+        for (uint32_t i = 0; i < MAX_BENCHMARK_SCOPES; ++i)
+        {
+            if (data->m_ScopeTimes[i] == 0x0)
+                continue;
+            CalcStats(data->m_ScopeTimes[i], count, sorted, &stats);
+            dmLogInfo("  %-24s %8.3f %8.3f %8.3f", data->m_ScopeNames[i], stats.m_Mean, stats.m_P95, stats.m_Max);
+            if (f)
+                fprintf(f, ",\n    {\"name\": \"%s\", \"mean_ms\": %f, \"p95_ms\": %f, \"max_ms\": %f}", data->m_ScopeNames[i], stats.m_Mean, stats.m_P95, stats.m_Max);
+        }
+        free(sorted);
+
+        if (!f)
+            return data->m_OutputPath == 0x0;
+        fprintf(f, "\n  ]\n}\n");
+        return fclose(f) == 0;
+    }
+}
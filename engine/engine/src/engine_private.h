@@ -16,8 +16,11 @@
 #include <stdint.h>
 
 #include <dlib/configfile.h>
+#include <dlib/frame_alloc.h>
 #include <dlib/hashtable.h>
+#include <dlib/job.h>
 #include <dlib/message.h>
+#include <dlib/profile.h>
 
 #include <resource/resource.h>
 
@@ -98,6 +101,53 @@ namespace dmEngine
         uint32_t            m_Fps;
     };
 
+    const uint32_t MAX_BENCHMARK_SCOPES = 256;
+
+    // An input action replayed by the benchmark, see engine.benchmark_input
+    struct BenchmarkInputEvent
+    {
+        dmhash_t    m_ActionId;
+        uint32_t    m_Frame;
+        float       m_Value;
+        int32_t     m_X;
+        int32_t     m_Y;
+        uint8_t     m_PositionSet : 1;
+        uint8_t     : 7;
+    };
+
+    // State of a replayed action that is held down, or has a position to compute the next delta from
+    struct BenchmarkAction
+    {
+        dmhash_t    m_ActionId;
+        float       m_Value;
+        float       m_PrevValue;
+        int32_t     m_X;
+        int32_t     m_Y;
+        int32_t     m_DX;
+        int32_t     m_DY;
+        uint8_t     m_PositionSet : 1;
+        uint8_t     m_Changed : 1;
+        uint8_t     : 6;
+    };
+
+    // Runs a fixed number of frames at a fixed dt and records the time spent in each profile scope
+    // every frame. The statistics are written when the last frame is done. See InitBenchmark
+    struct BenchmarkData
+    {
+        BenchmarkData();
+
+        dmArray<BenchmarkInputEvent>    m_InputEvents;                          // Sorted by frame
+        dmArray<BenchmarkAction>        m_Actions;
+        float*                          m_ScopeTimes[MAX_BENCHMARK_SCOPES];     // Per frame (ms), allocated when the scope is first sampled
+        const char*                     m_ScopeNames[MAX_BENCHMARK_SCOPES];
+        float*                          m_FrameTimes;                           // Per frame (ms)
+        const char*                     m_OutputPath;
+        uint32_t                        m_FrameCount;                           // Frames to run, 0 if not benchmarking
+        uint32_t                        m_Frame;
+        uint32_t                        m_InputIndex;                           // Next event in m_InputEvents
+        float                           m_Dt;
+    };
+
     enum Vsync
     {
         VSYNC_SOFTWARE = 0,
@@ -105,6 +155,26 @@ namespace dmEngine
 
     };
 
+    const uint32_t FRAME_PACING_SAMPLE_COUNT = 64;
+
+    // Measures the time between flips with hardware vsync, to find the actual display refresh period.
+    // The frame dt is snapped to whole refresh periods, and the swap interval and update frequency
+    // follow the measured refresh rate. See UpdateFramePacing
+    struct FramePacing
+    {
+        float       m_Samples[FRAME_PACING_SAMPLE_COUNT];  // Flip intervals divided by the swap interval (seconds)
+        uint32_t    m_SampleCount;
+        uint32_t    m_SampleIndex;
+        float       m_VsyncPeriod;                          // Estimated display refresh period (seconds)
+        float       m_FrameDt;                              // The dt of the next frame (seconds)
+        uint32_t    m_RefreshRate;
+        uint32_t    m_TargetFrequency;                      // display.update_frequency, 0 for the display refresh rate
+        uint32_t    m_SwapInterval;
+        uint8_t     m_Enabled : 1;
+        uint8_t     m_AutoSwapInterval : 1;                 // Cleared when the swap interval or update frequency is set by the game
+        uint8_t     : 6;
+    };
+
     struct Engine
     {
         Engine(dmEngineService::HEngineService engine_service);
@@ -114,6 +184,8 @@ namespace dmEngine
         RunResult                                   m_RunResult;
         bool                                        m_Alive;
 
+        dmJob::HContext                             m_JobContext;
+        dmFrameAlloc::HAllocator                    m_FrameAllocator;
         dmGameObject::HRegister                     m_Register;
         dmGameObject::HCollection                   m_MainCollection;
         dmArray<dmGameObject::InputAction>          m_InputBuffer;
@@ -162,9 +234,13 @@ namespace dmEngine
         bool                                        m_QuitOnEsc;
         bool                                        m_ConnectionAppMode;        //!< If the app was started on a device, listening for connections
         bool                                        m_RunWhileIconified;
+        bool                                        m_RenderOnDemand;           //!< Only render frames where something changed, see NeedsRender()
+        bool                                        m_ForceRender;              //!< Render the next frame even if nothing changed in the game
+        bool                                        m_LateInputSample;          //!< Sample input again right before rendering, see LateInputSample()
         uint64_t                                    m_PreviousFrameTime;
         uint64_t                                    m_PreviousRenderTime;
         uint64_t                                    m_FlipTime;
+        uint64_t                                    m_NextTickTime;             //!< Start of the next tick of the headless server
         uint32_t                                    m_UpdateFrequency;
         uint32_t                                    m_Width;
         uint32_t                                    m_Height;
@@ -172,8 +248,10 @@ namespace dmEngine
         float                                       m_InvPhysicalWidth;
         float                                       m_InvPhysicalHeight;
         Vsync                                       m_VsyncMode;
+        FramePacing                                 m_FramePacing;
 
         RecordData                                  m_RecordData;
+        BenchmarkData                               m_Benchmark;
     };
 
 
@@ -182,6 +260,41 @@ namespace dmEngine
     bool Init(HEngine engine, int argc, char *argv[]);
     void Step(HEngine engine);
 
+    typedef void (*BenchmarkActionCallback)(dmhash_t action_id, dmInput::Action* action, void* user_data);
+
+    /**
+     * Read the benchmark settings from the config. Benchmarking is enabled when engine.benchmark_frames is set:
+     *   engine.benchmark_frames            number of frames to run before the engine exits
+     *   engine.benchmark_update_frequency  frames per simulated second, the dt of every frame. Default 60
+     *   engine.benchmark_input             input replay file, see ReplayBenchmarkInput
+     *   engine.benchmark_out               path of the JSON statistics. They are always logged
+     * @return false if the input replay file couldn't be loaded
+     */
+    bool InitBenchmark(BenchmarkData* data, dmConfigFile::HConfig config);
+    void FinalizeBenchmark(BenchmarkData* data);
+
+    /**
+     * Dispatch the replayed input of the current frame. Each line of the replay file is an
+     * input action "<frame> <action> <value> [<x> <y>]", with the frames in ascending order.
+     * The action is held with its value until a later line sets it to 0. Positions are in window
+     * coordinates, with the origin in the top left corner. Lines starting with # are comments.
+     */
+    void ReplayBenchmarkInput(BenchmarkData* data, BenchmarkActionCallback callback, void* user_data);
+
+    /**
+     * Record the times of the frame and advance to the next one
+     * @param profile profile of the frame, or 0 if profiling is disabled
+     * @param frame_time time of the whole frame, in microseconds
+     * @return true if it was the last frame
+     */
+    bool RecordBenchmarkFrame(BenchmarkData* data, dmProfile::HProfile profile, uint64_t frame_time);
+
+    /**
+     * Log the mean, 95th percentile and max time of each scope, and write them to engine.benchmark_out
+     * @return false if the output file couldn't be written
+     */
+    bool WriteBenchmarkResults(BenchmarkData* data);
+
     void ReloadResources(HEngine engine, const char* extension);
     bool LoadBootstrapContent(HEngine engine, dmConfigFile::HConfig config);
     void UnloadBootstrapContent(HEngine engine);
@@ -11,10 +11,12 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <dlib/webserver.h>
 #include <dlib/message.h>
 #include <dlib/dstrings.h>
+#include <dlib/array.h>
 #include <dlib/math.h>
 #include <dlib/log.h>
 #include <dlib/ssdp.h>
@@ -22,6 +24,7 @@
 #include <dlib/sys.h>
 #include <dlib/template.h>
 #include <dlib/profile.h>
+#include <dlib/time.h>
 #include <ddf/ddf.h>
 #include <resource/resource.h>
 #include <gameobject/gameobject.h>
@@ -57,6 +60,284 @@ namespace dmEngineService
     static const char INTERNAL_SERVER_ERROR[] = "(500) Internal server error";
     const char* const FOURCC_RESOURCES = "RESS";
 
+    //
+    // Metrics exporter
+    //
+    // Aggregates the frame times and the profile counters into a rolling window, for soak testing.
+    // The metrics are served in the Prometheus text format at /metrics. If DM_METRICS_STATSD=host:port
+    // is set, each finished window slot is also pushed as StatsD gauges over UDP.
+
+    static const uint32_t METRICS_SLOT_COUNT = 6;
+    static const uint64_t METRICS_SLOT_DURATION = 10 * 1000000; // us, the window is 60 seconds
+    static const uint32_t METRICS_MAX_COUNTERS = 128;            // Same as the profiler max counters
+    static const uint32_t METRICS_STATSD_PACKET_SIZE = 1400;
+    // Upper bounds (seconds) of the frame time histogram buckets, excluding +Inf
+    static const float METRICS_FRAME_TIME_BUCKETS[] = {0.0085f, 0.017f, 0.034f, 0.05f, 0.1f, 0.25f, 1.0f};
+    static const uint32_t METRICS_FRAME_TIME_BUCKET_COUNT = DM_ARRAY_SIZE(METRICS_FRAME_TIME_BUCKETS) + 1;
+
+    struct MetricsSlot
+    {
+        uint32_t m_FrameCount;
+        float    m_FrameTimeSum;
+        float    m_FrameTimeMax;
+    };
+
+    struct MetricsCounter
+    {
+        const dmProfile::Counter* m_Counter;
+        int32_t                   m_Value;                      // Last frame
+        int64_t                   m_Sum[METRICS_SLOT_COUNT];
+        int32_t                   m_Max[METRICS_SLOT_COUNT];
+    };
+
+    struct Metrics
+    {
+        // Since start, as Prometheus expects histograms to be cumulative
+        uint64_t            m_FrameTimeBuckets[METRICS_FRAME_TIME_BUCKET_COUNT];
+        double              m_FrameTimeSum;
+        uint64_t            m_FrameCount;
+
+        MetricsSlot         m_Slots[METRICS_SLOT_COUNT];
+        MetricsCounter      m_Counters[METRICS_MAX_COUNTERS];
+        uint32_t            m_CounterCount;
+        uint32_t            m_Slot;
+        uint64_t            m_SlotStart;
+        uint64_t            m_PrevTime;
+
+        dmSocket::Socket    m_StatsDSocket;
+        dmSocket::Address   m_StatsDAddress;
+        uint16_t            m_StatsDPort;
+    };
+
+    static void InitMetrics(Metrics* metrics)
+    {
+        memset(metrics->m_FrameTimeBuckets, 0, sizeof(metrics->m_FrameTimeBuckets));
+        memset(metrics->m_Slots, 0, sizeof(metrics->m_Slots));
+        metrics->m_FrameTimeSum = 0.0;
+        metrics->m_FrameCount = 0;
+        metrics->m_CounterCount = 0;
+        metrics->m_Slot = 0;
+        metrics->m_SlotStart = 0;
+        metrics->m_PrevTime = 0;
+        metrics->m_StatsDPort = 0;
+        metrics->m_StatsDSocket = dmSocket::INVALID_SOCKET_HANDLE;
+
+        const char* statsd_env = getenv("DM_METRICS_STATSD");
+        if (!statsd_env)
+            return;
+
+        char host[128];
+        dmStrlCpy(host, statsd_env, sizeof(host));
+        char* port = strrchr(host, ':');
+        unsigned int statsd_port = 0;
+        if (!port || sscanf(port + 1, "%u", &statsd_port) != 1 || statsd_port > 0xffff)
+        {
+            dmLogWarning("Invalid DM_METRICS_STATSD '%s', expected host:port", statsd_env);
+            return;
+        }
+        *port = 0;
+
+        dmSocket::Result sr = dmSocket::GetHostByName(host, &metrics->m_StatsDAddress);
+        if (sr == dmSocket::RESULT_OK)
+        {
+            sr = dmSocket::New(metrics->m_StatsDAddress.m_family, dmSocket::TYPE_DGRAM, dmSocket::PROTOCOL_UDP, &metrics->m_StatsDSocket);
+        }
+        if (sr != dmSocket::RESULT_OK)
+        {
+            dmLogWarning("Unable to push metrics to '%s' (%s)", statsd_env, dmSocket::ResultToString(sr));
+            metrics->m_StatsDSocket = dmSocket::INVALID_SOCKET_HANDLE;
+            return;
+        }
+        dmSocket::SetBlocking(metrics->m_StatsDSocket, false);
+        metrics->m_StatsDPort = (uint16_t) statsd_port;
+    }
+
+    static void FinalMetrics(Metrics* metrics)
+    {
+        if (metrics->m_StatsDSocket != dmSocket::INVALID_SOCKET_HANDLE)
+        {
+            dmSocket::Delete(metrics->m_StatsDSocket);
+        }
+    }
+
+    // Writes the name with everything but [A-Za-z0-9] replaced by '_', e.g. "Lua.Mem (Kb)" -> "lua_mem_kb"
+    static void SanitizeMetricName(const char* name, char* buffer, uint32_t buffer_size)
+    {
+        uint32_t n = 0;
+        bool separator = false;
+        for (const char* c = name; *c && n < buffer_size - 1; ++c)
+        {
+            char ch = *c;
+            if ((ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9'))
+            {
+            }
+            else if (ch >= 'A' && ch <= 'Z')
+            {
+                ch = ch - 'A' + 'a';
+            }
+            else
+            {
+                separator = n > 0;
+                continue;
+            }
+            if (separator && n < buffer_size - 2)
+                buffer[n++] = '_';
+            separator = false;
+            buffer[n++] = ch;
+        }
+        buffer[n] = 0;
+    }
+
+    static void SendStatsD(Metrics* metrics, const char* packet, uint32_t size)
+    {
+        int sent_bytes = 0;
+        // Dropped packets are fine, the next slot is pushed anyway
+        dmSocket::SendTo(metrics->m_StatsDSocket, packet, (int) size, &sent_bytes, metrics->m_StatsDAddress, metrics->m_StatsDPort);
+    }
+
+    static void AppendStatsD(Metrics* metrics, char* packet, uint32_t* size, const char* line, int len)
+    {
+        if (len <= 0 || len >= (int) METRICS_STATSD_PACKET_SIZE)
+            return;
+        if (*size + len > METRICS_STATSD_PACKET_SIZE)
+        {
+            SendStatsD(metrics, packet, *size);
+            *size = 0;
+        }
+        memcpy(packet + *size, line, len);
+        *size += len;
+    }
+
+    static void PushStatsD(Metrics* metrics, uint32_t slot_index)
+    {
+        const MetricsSlot& slot = metrics->m_Slots[slot_index];
+        if (slot.m_FrameCount == 0)
+            return;
+
+        char packet[METRICS_STATSD_PACKET_SIZE];
+        uint32_t size = 0;
+        char line[256];
+        char name[128];
+
+        AppendStatsD(metrics, packet, &size, line, dmSnPrintf(line, sizeof(line), "defold.frames:%u|c\n", slot.m_FrameCount));
+        AppendStatsD(metrics, packet, &size, line, dmSnPrintf(line, sizeof(line), "defold.frame_time.mean:%.3f|ms\n", 1000.0f * slot.m_FrameTimeSum / slot.m_FrameCount));
+        AppendStatsD(metrics, packet, &size, line, dmSnPrintf(line, sizeof(line), "defold.frame_time.max:%.3f|ms\n", 1000.0f * slot.m_FrameTimeMax));
+        for (uint32_t i = 0; i < metrics->m_CounterCount; ++i)
+        {
+            const MetricsCounter& counter = metrics->m_Counters[i];
+            SanitizeMetricName(counter.m_Counter->m_Name, name, sizeof(name));
+            AppendStatsD(metrics, packet, &size, line, dmSnPrintf(line, sizeof(line), "defold.%s.mean:%.2f|g\n", name, (double) counter.m_Sum[slot_index] / slot.m_FrameCount));
+            AppendStatsD(metrics, packet, &size, line, dmSnPrintf(line, sizeof(line), "defold.%s.max:%d|g\n", name, counter.m_Max[slot_index]));
+        }
+        if (size > 0)
+        {
+            SendStatsD(metrics, packet, size);
+        }
+    }
+
+    static void ClearMetricsSlot(Metrics* metrics, uint32_t slot_index)
+    {
+        memset(&metrics->m_Slots[slot_index], 0, sizeof(MetricsSlot));
+        for (uint32_t i = 0; i < metrics->m_CounterCount; ++i)
+        {
+            metrics->m_Counters[i].m_Sum[slot_index] = 0;
+            metrics->m_Counters[i].m_Max[slot_index] = 0;
+        }
+    }
+
+    struct RecordCountersContext
+    {
+        Metrics* m_Metrics;
+        uint32_t m_Index;
+    };
+
+    static void RecordCounter(void* context, const dmProfile::CounterData* counter_data)
+    {
+        RecordCountersContext* ctx = (RecordCountersContext*) context;
+        Metrics* metrics = ctx->m_Metrics;
+        // The counters are only ever appended, so the iteration order is stable
+        uint32_t index = ctx->m_Index++;
+        if (index >= METRICS_MAX_COUNTERS)
+            return;
+        if (index >= metrics->m_CounterCount)
+        {
+            MetricsCounter* counter = &metrics->m_Counters[index];
+            memset(counter, 0, sizeof(*counter));
+            counter->m_Counter = counter_data->m_Counter;
+            metrics->m_CounterCount = index + 1;
+        }
+
+        MetricsCounter* counter = &metrics->m_Counters[index];
+        int32_t value = counter_data->m_Value;
+        counter->m_Value = value;
+        counter->m_Sum[metrics->m_Slot] += value;
+        counter->m_Max[metrics->m_Slot] = dmMath::Max(counter->m_Max[metrics->m_Slot], value);
+    }
+
+    // Called once per frame, with the profile of the previous frame (if profiling is enabled)
+    static void UpdateMetrics(Metrics* metrics, dmProfile::HProfile profile)
+    {
+        uint64_t now = dmTime::GetTime();
+        if (metrics->m_PrevTime == 0)
+        {
+            metrics->m_PrevTime = now;
+            metrics->m_SlotStart = now;
+            return;
+        }
+
+        // Advance the window, clearing the slots that were skipped over during a stall
+        uint32_t slots_passed = 0;
+        while (now - metrics->m_SlotStart >= METRICS_SLOT_DURATION && slots_passed < METRICS_SLOT_COUNT)
+        {
+            if (slots_passed == 0 && metrics->m_StatsDSocket != dmSocket::INVALID_SOCKET_HANDLE)
+            {
+                PushStatsD(metrics, metrics->m_Slot);
+            }
+            metrics->m_Slot = (metrics->m_Slot + 1) % METRICS_SLOT_COUNT;
+            metrics->m_SlotStart += METRICS_SLOT_DURATION;
+            ClearMetricsSlot(metrics, metrics->m_Slot);
+            ++slots_passed;
+        }
+        if (now - metrics->m_SlotStart >= METRICS_SLOT_DURATION)
+        {
+            metrics->m_SlotStart = now;
+        }
+
+        float frame_time = (float) ((now - metrics->m_PrevTime) * 0.000001);
+        metrics->m_PrevTime = now;
+
+        uint32_t bucket = 0;
+        while (bucket < METRICS_FRAME_TIME_BUCKET_COUNT - 1 && frame_time > METRICS_FRAME_TIME_BUCKETS[bucket])
+            ++bucket;
+        metrics->m_FrameTimeBuckets[bucket]++;
+        metrics->m_FrameTimeSum += frame_time;
+        metrics->m_FrameCount++;
+
+        MetricsSlot* slot = &metrics->m_Slots[metrics->m_Slot];
+        slot->m_FrameCount++;
+        slot->m_FrameTimeSum += frame_time;
+        slot->m_FrameTimeMax = dmMath::Max(slot->m_FrameTimeMax, frame_time);
+
+        if (profile)
+        {
+            RecordCountersContext ctx;
+            ctx.m_Metrics = metrics;
+            ctx.m_Index = 0;
+            dmProfile::IterateCounterData(profile, &ctx, RecordCounter);
+        }
+    }
+
+    // Copies a counter name for use as a Prometheus label value
+    static void EscapeMetricLabel(const char* name, char* buffer, uint32_t buffer_size)
+    {
+        uint32_t n = 0;
+        for (const char* c = name; *c && n < buffer_size - 1; ++c)
+        {
+            buffer[n++] = (*c == '"' || *c == '\\' || *c == '\n') ? '_' : *c;
+        }
+        buffer[n] = 0;
+    }
+
     struct EngineService
     {
         static void HttpServerHeader(void* user_data, const char* key, const char* value)
@@ -205,6 +486,89 @@ namespace dmEngineService
             dmWebServer::Send(request, service->m_InfoJson, strlen(service->m_InfoJson));
         }
 
+        static void SendMetricsText(dmWebServer::Request* request, const char* text)
+        {
+            dmWebServer::Send(request, text, strlen(text));
+        }
+
+        // Serves the metrics in the Prometheus text format. The window values cover the last 50-60 seconds
+        static void MetricsHandler(void* user_data, dmWebServer::Request* request)
+        {
+            EngineService* service = (EngineService*) user_data;
+            const Metrics* metrics = &service->m_Metrics;
+
+            dmWebServer::SetStatusCode(request, 200);
+            dmWebServer::SendAttribute(request, "Content-Type", "text/plain; version=0.0.4");
+            dmWebServer::SendAttribute(request, "Cache-Control", "no-store");
+
+            char buffer[256];
+            SendMetricsText(request, "# HELP defold_frame_time_seconds Time between engine frames.\n"
+                                     "# TYPE defold_frame_time_seconds histogram\n");
+            uint64_t cumulative = 0;
+            for (uint32_t i = 0; i < METRICS_FRAME_TIME_BUCKET_COUNT - 1; ++i)
+            {
+                cumulative += metrics->m_FrameTimeBuckets[i];
+                dmSnPrintf(buffer, sizeof(buffer), "defold_frame_time_seconds_bucket{le=\"%g\"} %llu\n", METRICS_FRAME_TIME_BUCKETS[i], (unsigned long long) cumulative);
+                SendMetricsText(request, buffer);
+            }
+            dmSnPrintf(buffer, sizeof(buffer), "defold_frame_time_seconds_bucket{le=\"+Inf\"} %llu\n"
+                                               "defold_frame_time_seconds_sum %f\n"
+                                               "defold_frame_time_seconds_count %llu\n",
+                                               (unsigned long long) metrics->m_FrameCount, metrics->m_FrameTimeSum, (unsigned long long) metrics->m_FrameCount);
+            SendMetricsText(request, buffer);
+
+            uint32_t window_frames = 0;
+            float window_frame_time_sum = 0.0f;
+            float window_frame_time_max = 0.0f;
+            for (uint32_t i = 0; i < METRICS_SLOT_COUNT; ++i)
+            {
+                window_frames += metrics->m_Slots[i].m_FrameCount;
+                window_frame_time_sum += metrics->m_Slots[i].m_FrameTimeSum;
+                window_frame_time_max = dmMath::Max(window_frame_time_max, metrics->m_Slots[i].m_FrameTimeMax);
+            }
+            float window_frames_inv = window_frames > 0 ? 1.0f / window_frames : 0.0f;
+
+            SendMetricsText(request, "# HELP defold_window_frame_time_seconds Frame time over the last minute.\n"
+                                     "# TYPE defold_window_frame_time_seconds gauge\n");
+            dmSnPrintf(buffer, sizeof(buffer), "defold_window_frame_time_seconds{stat=\"mean\"} %f\n"
+                                               "defold_window_frame_time_seconds{stat=\"max\"} %f\n",
+                                               window_frame_time_sum * window_frames_inv, window_frame_time_max);
+            SendMetricsText(request, buffer);
+
+            if (metrics->m_CounterCount == 0)
+                return;
+
+            char name[128];
+            SendMetricsText(request, "# HELP defold_counter Profile counter value of the last frame.\n"
+                                     "# TYPE defold_counter gauge\n");
+            for (uint32_t i = 0; i < metrics->m_CounterCount; ++i)
+            {
+                const MetricsCounter& counter = metrics->m_Counters[i];
+                EscapeMetricLabel(counter.m_Counter->m_Name, name, sizeof(name));
+                dmSnPrintf(buffer, sizeof(buffer), "defold_counter{name=\"%s\"} %d\n", name, counter.m_Value);
+                SendMetricsText(request, buffer);
+            }
+
+            SendMetricsText(request, "# HELP defold_window_counter Profile counter per frame over the last minute.\n"
+                                     "# TYPE defold_window_counter gauge\n");
+            for (uint32_t i = 0; i < metrics->m_CounterCount; ++i)
+            {
+                const MetricsCounter& counter = metrics->m_Counters[i];
+                int64_t sum = 0;
+                int32_t max = 0;
+                for (uint32_t s = 0; s < METRICS_SLOT_COUNT; ++s)
+                {
+                    sum += counter.m_Sum[s];
+                    max = dmMath::Max(max, counter.m_Max[s]);
+                }
+                EscapeMetricLabel(counter.m_Counter->m_Name, name, sizeof(name));
+                dmSnPrintf(buffer, sizeof(buffer), "defold_window_counter{name=\"%s\",stat=\"mean\"} %f\n"
+                                                   "defold_window_counter{name=\"%s\",stat=\"max\"} %d\n",
+                                                   name, sum * window_frames_inv, name, max);
+                SendMetricsText(request, buffer);
+            }
+        }
+
         // This is equivalent to what SSDP is doing when serving the UPNP descriptor through its own http server
         // See ssdp.cpp#ReplaceHttpHostVar
         static const char* ReplaceHttpHostVar(void *user_data, const char *key)
@@ -442,6 +806,11 @@ namespace dmEngineService
             info_params.m_Userdata = this;
             dmWebServer::AddHandler(web_server, "/info", &info_params);
 
+            dmWebServer::HandlerParams metrics_params;
+            metrics_params.m_Handler = MetricsHandler;
+            metrics_params.m_Userdata = this;
+            dmWebServer::AddHandler(web_server, "/metrics", &metrics_params);
+
             // The purpose of this handler is both for debugging but also for Editor2,
             // where the user can manually specify an IP (and optionally port) to connect to.
             // The port is known (8001) or set via environment variable DM_SERVICE_PORT and logged on startup.
@@ -463,6 +832,7 @@ namespace dmEngineService
             m_WebServerRedirect = web_server_redirect;
             m_SSDP = ssdp;
             m_Profile = 0; // Set during the update
+            InitMetrics(&m_Metrics);
 
             dmLogInfo("Target listening with name: %s", m_Name);
 
@@ -472,6 +842,7 @@ namespace dmEngineService
         void Final()
         {
             dmWebServer::Delete(m_WebServer);
+            FinalMetrics(&m_Metrics);
 
             if (m_WebServerRedirect)
             {
@@ -501,6 +872,7 @@ namespace dmEngineService
         char                 m_InfoJson[sizeof(INFO_TEMPLATE) + 512]; // 512 is rather arbitrary :-)
 
         dmProfile::HProfile  m_Profile;
+        Metrics              m_Metrics;
     };
 
     HEngineService New(uint16_t port)
@@ -532,6 +904,7 @@ namespace dmEngineService
     {
         DM_PROFILE(Engine, "Service");
         engine_service->m_Profile = profile;
+        UpdateMetrics(&engine_service->m_Metrics, profile);
         dmWebServer::Update(engine_service->m_WebServer);
         if (engine_service->m_WebServerRedirect)
         {
@@ -645,6 +1018,37 @@ namespace dmEngineService
         dmResource::IterateResources(factory, ResourceIteratorFunction, (void*)request);
     }
 
+    // Syntax: http://host:port/patch/<resource path>, with the resource type specific patch data as content
+    static void HttpResourcePatchCallback(void* context, dmWebServer::Request* request)
+    {
+        dmResource::HFactory factory = (dmResource::HFactory)context;
+        const char* name = request->m_Resource + strlen("/patch");
+
+        uint8_t* patch = (uint8_t*) malloc(dmMath::Max(1u, request->m_ContentLength));
+        uint32_t total_recv = 0;
+        while (total_recv < request->m_ContentLength)
+        {
+            uint32_t recv_bytes = 0;
+            dmWebServer::Result r = dmWebServer::Receive(request, patch + total_recv, request->m_ContentLength - total_recv, &recv_bytes);
+            if (r != dmWebServer::RESULT_OK || recv_bytes == 0)
+            {
+                dmLogError("Error while reading patch data for %s (%d)", name, r);
+                free(patch);
+                dmWebServer::SetStatusCode(request, 500);
+                dmWebServer::Send(request, INTERNAL_SERVER_ERROR, strlen(INTERNAL_SERVER_ERROR));
+                return;
+            }
+            total_recv += recv_bytes;
+        }
+
+        dmResource::Result r = dmResource::PatchResource(factory, name, patch, total_recv, 0);
+        free(patch);
+
+        const char* response = r == dmResource::RESULT_OK ? "OK" : "Failed to patch resource";
+        dmWebServer::SetStatusCode(request, r == dmResource::RESULT_OK ? 200 : 400);
+        dmWebServer::Send(request, response, strlen(response));
+    }
+
     //
     // GameObject profiler
     //
@@ -989,6 +1393,12 @@ namespace dmEngineService
         scenegraph_params.m_Userdata = regist;
         dmWebServer::AddHandler(engine_service->m_WebServer, "/scene_graph", &scenegraph_params);
 
+        // Partial hot reload of large resources, e.g. the changed region of a texture
+        dmWebServer::HandlerParams patch_params;
+        patch_params.m_Handler = HttpResourcePatchCallback;
+        patch_params.m_Userdata = factory;
+        dmWebServer::AddHandler(engine_service->m_WebServer, "/patch", &patch_params);
+
         // The entry point to the engine service profiler
         dmWebServer::HandlerParams profile_params;
         profile_params.m_Handler = ProfileHandler;
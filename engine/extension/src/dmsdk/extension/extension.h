@@ -16,6 +16,7 @@
 #include <string.h>
 #include <dmsdk/dlib/configfile.h>
 #include <dmsdk/dlib/align.h>
+#include <dmsdk/dlib/job.h>
 
 extern "C"
 {
@@ -85,6 +86,7 @@ namespace dmExtension
      * @name dmExtension::Params
      * @member m_ConfigFile [type:dmConfigFile::HConfig]
      * @member m_L [type:lua_State*]
+     * @member m_JobContext [type:dmJob::HContext] The engine job context, see [ref:dmJob]. May be 0 if the engine runs without a job system.
      *
      */
     struct Params
@@ -92,6 +94,7 @@ namespace dmExtension
         Params();
         dmConfigFile::HConfig   m_ConfigFile;
         lua_State*              m_L;
+        dmJob::HContext         m_JobContext;
     };
 
     /*# event id enumeration
@@ -119,17 +122,30 @@ namespace dmExtension
     /*# extra callback enumeration
      *
      * Extra callback enumeration for RegisterCallback function.
+     * The callbacks are called once per engine frame, in this order:
+     *
+     * - `CALLBACK_PRE_UPDATE` after input is dispatched, before the game objects are updated.
+     * - `CALLBACK_POST_UPDATE` after the game objects are updated, before anything is rendered.
+     * - `CALLBACK_PRE_RENDER` before the render script is run. Not called when the frame isn't rendered.
+     * - `CALLBACK_POST_RENDER` before the frame is presented. Not called when the frame isn't rendered.
+     *
+     * Jobs started with `dmExtension::Params::m_JobContext` in an early callback can be waited for in a later one,
+     * which lets them run in parallel with the engine update.
      *
      * @enum
      * @name dmExtension::CallbackType
      * @member dmExtension::CALLBACK_PRE_RENDER
      * @member dmExtension::CALLBACK_POST_RENDER
+     * @member dmExtension::CALLBACK_PRE_UPDATE
+     * @member dmExtension::CALLBACK_POST_UPDATE
      *
      */
     enum CallbackType
     {
         CALLBACK_PRE_RENDER,
         CALLBACK_POST_RENDER,
+        CALLBACK_PRE_UPDATE,
+        CALLBACK_POST_UPDATE,
     };
 
     /*# event callback data
@@ -52,6 +52,8 @@ namespace dmExtension
 
         desc->PreRender = 0x0;
         desc->PostRender = 0x0;
+        desc->PreUpdate = 0x0;
+        desc->PostUpdate = 0x0;
         g_FirstExtension = desc;
     }
 
@@ -124,6 +126,28 @@ namespace dmExtension
         }
     }
 
+    void PreUpdate(Params* params)
+    {
+        dmExtension::Desc* ed = (dmExtension::Desc*) dmExtension::GetFirstExtension();
+        while (ed) {
+            if (ed->PreUpdate && ed->m_AppInitialized) {
+                ed->PreUpdate(params);
+            }
+            ed = (dmExtension::Desc*) ed->m_Next;
+        }
+    }
+
+    void PostUpdate(Params* params)
+    {
+        dmExtension::Desc* ed = (dmExtension::Desc*) dmExtension::GetFirstExtension();
+        while (ed) {
+            if (ed->PostUpdate && ed->m_AppInitialized) {
+                ed->PostUpdate(params);
+            }
+            ed = (dmExtension::Desc*) ed->m_Next;
+        }
+    }
+
     bool RegisterCallback(CallbackType callback_type, extension_callback_t func)
     {
         if (!g_CurrentExtension) {
@@ -139,6 +163,12 @@ namespace dmExtension
             case dmExtension::CALLBACK_POST_RENDER:
                 g_CurrentExtension->PostRender = func;
                 break;
+            case dmExtension::CALLBACK_PRE_UPDATE:
+                g_CurrentExtension->PreUpdate = func;
+                break;
+            case dmExtension::CALLBACK_POST_UPDATE:
+                g_CurrentExtension->PostUpdate = func;
+                break;
             default:
                 return false;
         }
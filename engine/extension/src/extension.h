@@ -27,6 +27,8 @@ namespace dmExtension
         Result (*AppInitialize)(AppParams* params);
         extension_callback_t PreRender;
         extension_callback_t PostRender;
+        extension_callback_t PreUpdate;
+        extension_callback_t PostUpdate;
         Result (*AppFinalize)(AppParams* params);
         Result (*Initialize)(Params* params);
         Result (*Finalize)(Params* params);
@@ -61,6 +63,18 @@ namespace dmExtension
      */
     void PostRender(Params* params);
 
+    /**
+     * Call pre update functions for extensions
+     * @param params parameters
+     */
+    void PreUpdate(Params* params);
+
+    /**
+     * Call post update functions for extensions
+     * @param params parameters
+     */
+    void PostUpdate(Params* params);
+
     /**
      * Initialize all extends at application level
      * @param params parameters
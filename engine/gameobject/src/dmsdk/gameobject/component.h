@@ -243,6 +243,8 @@ namespace dmGameObject
     {
         /// True if a component type updated any game object transforms
         bool m_TransformsUpdated;
+        /// True if a component type changed anything that is rendered, e.g. advanced an animation
+        bool m_Changed;
     };
 
     /*#
@@ -585,6 +587,40 @@ namespace dmGameObject
      */
     void ComponentTypeSetReadsTransforms(ComponentType* type, bool reads_transforms);
 
+    /*#
+     * Shared state a component type accesses in its update function. Component types that have declared
+     * their dependencies with [ref:ComponentTypeSetUpdateDependencies] may be updated concurrently with
+     * other component types on the job threads, as long as the dependencies don't conflict.
+     * Component types that haven't declared any dependencies are always updated on the main thread.
+     * @enum
+     * @name ComponentUpdateDependency
+     * @member dmGameObject::COMPONENT_UPDATE_DEPENDENCY_NONE only the component world is accessed
+     * @member dmGameObject::COMPONENT_UPDATE_DEPENDENCY_READS_TRANSFORMS reads the transforms of the game objects
+     * @member dmGameObject::COMPONENT_UPDATE_DEPENDENCY_WRITES_TRANSFORMS writes the transforms of the game objects
+     * @member dmGameObject::COMPONENT_UPDATE_DEPENDENCY_POSTS_MESSAGES posts messages to game objects, which are dispatched before the next component type is updated
+     * @member dmGameObject::COMPONENT_UPDATE_DEPENDENCY_RESOURCES acquires or releases resources, main thread only
+     * @member dmGameObject::COMPONENT_UPDATE_DEPENDENCY_LUA runs Lua code, main thread only
+     */
+    enum ComponentUpdateDependency
+    {
+        COMPONENT_UPDATE_DEPENDENCY_NONE              = 0,
+        COMPONENT_UPDATE_DEPENDENCY_READS_TRANSFORMS  = 1,
+        COMPONENT_UPDATE_DEPENDENCY_WRITES_TRANSFORMS = 2,
+        COMPONENT_UPDATE_DEPENDENCY_POSTS_MESSAGES    = 4,
+        COMPONENT_UPDATE_DEPENDENCY_RESOURCES         = 8,
+        COMPONENT_UPDATE_DEPENDENCY_LUA               = 16,
+    };
+
+    /*# set the component type update dependencies
+     * Declare the shared state the update function of the component type accesses, which allows
+     * the update to run on a job thread together with other component types.
+     * The update function must not touch any other state than its own world and what is declared.
+     * @name ComponentTypeSetUpdateDependencies
+     * @param type [type: ComponentType*] the type
+     * @param dependencies [type: uint32_t] bitwise or of [type:dmGameObject::ComponentUpdateDependency] values
+     */
+    void ComponentTypeSetUpdateDependencies(ComponentType* type, uint32_t dependencies);
+
     /*# set the component type prio order
      * Set the component type prio order. Defines the update order of the component types.
      * @name ComponentTypeSetPrio
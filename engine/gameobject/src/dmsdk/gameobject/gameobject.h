@@ -360,6 +360,8 @@ namespace dmGameObject
         uint32_t m_TextCount;
         uint32_t m_GamepadIndex;
         dmHID::GamepadPacket m_GamepadPacket;
+        /// Time when the input was sampled, in microseconds
+        uint64_t m_Timestamp;
 
         uint8_t  m_IsGamepad : 1;
         uint8_t  m_GamepadDisconnected : 1;
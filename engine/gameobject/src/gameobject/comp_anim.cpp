@@ -19,6 +19,7 @@
 #include <script/script.h>
 
 #include "component.h"
+#include "gameobject_private.h"
 #include "gameobject_script.h"
 #include "gameobject_props_lua.h"
 
@@ -36,12 +37,9 @@ namespace dmGameObject
 
     struct Animation
     {
-        HInstance           m_Instance;
-        dmhash_t            m_ComponentId;
-        dmhash_t            m_PropertyId;
+        PropertyHandle      m_Property;
         Playback            m_Playback;
         dmEasing::Curve     m_Easing;
-        float*              m_Value;
         float               m_From;
         float               m_To;
         float               m_Delay;
@@ -69,6 +67,11 @@ namespace dmGameObject
         dmIndexPool<uint16_t>               m_AnimMapIndexPool;
         dmHashTable<uintptr_t, uint16_t>    m_InstanceToIndex;
         dmHashTable<uintptr_t, uint16_t>    m_ListenerInstanceToIndex;
+        // Animations with built-in easing curves are evaluated in a batch during the update.
+        // One entry per animation evaluated in the current update
+        dmArray<uint16_t>                   m_EvalAnimations;   // Index into m_Animations
+        dmArray<uint8_t>                    m_EvalEasingTypes;
+        dmArray<float>                      m_EvalT;            // Curve time, and then the curve value
         uint32_t                            m_InUpdate : 1;
     };
 
@@ -124,7 +127,7 @@ namespace dmGameObject
             while (index != INVALID_INDEX)
             {
                 Animation* anim = &world->m_Animations[world->m_AnimMap[index]];
-                if (anim->m_ComponentId == component_id && anim->m_PropertyId == property_id)
+                if (anim->m_Property.m_ComponentId == component_id && anim->m_Property.m_PropertyId == property_id)
                 {
                     StopAnimation(anim, false);
                 }
@@ -149,6 +152,22 @@ namespace dmGameObject
 
     static void RemoveAnimationCallback(AnimWorld* world, Animation* anim);
 
+    // Writes the value of an animation, t is the eased curve value
+    static inline void ApplyAnimationValue(Animation* anim, float t)
+    {
+        float v = anim->m_From + (anim->m_To - anim->m_From) * t;
+        if (anim->m_Property.m_ValuePtr != 0x0)
+        {
+            *anim->m_Property.m_ValuePtr = v;
+            // The value might be part of the instance transform
+            SetTransformDirty(anim->m_Property.m_Instance);
+        }
+        else
+        {
+            SetProperty(anim->m_Property, PropertyVar(v));
+        }
+    }
+
     CreateResult CompAnimAddToUpdate(const ComponentAddToUpdateParams& params) {
         // Intentional pass-through
         return CREATE_RESULT_OK;
@@ -180,6 +199,15 @@ namespace dmGameObject
         uint32_t size = world->m_Animations.Size();
         uint32_t orig_size = size;
         DM_COUNTER("animc", size);
+        if (world->m_EvalT.Capacity() < size)
+        {
+            world->m_EvalAnimations.SetCapacity(size);
+            world->m_EvalEasingTypes.SetCapacity(size);
+            world->m_EvalT.SetCapacity(size);
+        }
+        world->m_EvalAnimations.SetSize(0);
+        world->m_EvalEasingTypes.SetSize(0);
+        world->m_EvalT.SetSize(0);
         uint32_t i = 0;
         for (i = 0; i < size; ++i)
         {
@@ -198,17 +226,17 @@ namespace dmGameObject
                 // Update from-value
                 if (!anim.m_Composite)
                 {
-                    if (anim.m_Value != 0x0)
-                        anim.m_From = *anim.m_Value;
+                    if (anim.m_Property.m_ValuePtr != 0x0)
+                        anim.m_From = *anim.m_Property.m_ValuePtr;
                     else
                     {
                         PropertyDesc desc;
-                        GetProperty(anim.m_Instance, anim.m_ComponentId, anim.m_PropertyId, desc);
+                        GetProperty(anim.m_Property, desc);
                         anim.m_From = (float)desc.m_Variant.m_Number;
                     }
                 }
                 // Cancel other currently playing animations
-                uint16_t* head_ptr = world->m_InstanceToIndex.Get((uintptr_t)anim.m_Instance);
+                uint16_t* head_ptr = world->m_InstanceToIndex.Get((uintptr_t)anim.m_Property.m_Instance);
                 if (head_ptr != 0x0)
                 {
                     uint16_t index = *head_ptr;
@@ -216,8 +244,8 @@ namespace dmGameObject
                     {
                         uint16_t anim_index = world->m_AnimMap[index];
                         Animation* a2 = &world->m_Animations[anim_index];
-                        if (anim_index != i && !a2->m_FirstUpdate && a2->m_ComponentId == anim.m_ComponentId
-                                && a2->m_PropertyId == anim.m_PropertyId && a2->m_Delay <= 0.0f)
+                        if (anim_index != i && !a2->m_FirstUpdate && a2->m_Property.m_ComponentId == anim.m_Property.m_ComponentId
+                                && a2->m_Property.m_PropertyId == anim.m_Property.m_PropertyId && a2->m_Delay <= 0.0f)
                         {
                             StopAnimation(a2, false);
                         }
@@ -300,15 +328,15 @@ namespace dmGameObject
                         t = 2.0f - t;
                     }
                 }
-                t = dmEasing::GetValue(anim.m_Easing, t);
-                float v = anim.m_From + (anim.m_To - anim.m_From) * t;
-                if (anim.m_Value != 0x0)
+                if (anim.m_Easing.type != dmEasing::TYPE_FLOAT_VECTOR)
                 {
-                    *anim.m_Value = v;
+                    world->m_EvalAnimations.Push((uint16_t)i);
+                    world->m_EvalEasingTypes.Push((uint8_t)anim.m_Easing.type);
+                    world->m_EvalT.Push(t);
                 }
                 else
                 {
-                    SetProperty(anim.m_Instance, anim.m_ComponentId, anim.m_PropertyId, PropertyVar(v));
+                    ApplyAnimationValue(&anim, dmEasing::GetValue(anim.m_Easing, t));
                 }
             }
             if (completed)
@@ -316,6 +344,18 @@ namespace dmGameObject
                 StopAnimation(&anim, true);
             }
         }
+        // Evaluate the built-in curves in one go, and write the values
+        uint32_t eval_count = world->m_EvalT.Size();
+        if (eval_count > 0)
+        {
+            float* curve_values = world->m_EvalT.Begin();
+            dmEasing::GetValues(world->m_EvalEasingTypes.Begin(), curve_values, curve_values, eval_count);
+            const uint16_t* eval_animations = world->m_EvalAnimations.Begin();
+            for (uint32_t e = 0; e < eval_count; ++e)
+            {
+                ApplyAnimationValue(&world->m_Animations[eval_animations[e]], curve_values[e]);
+            }
+        }
         i = 0;
         // Prune canceled animations and call callbacks
         while (i < size)
@@ -326,7 +366,7 @@ namespace dmGameObject
                 if (anim->m_AnimationStopped != 0x0)
                 {
                     uint32_t orig_size = size;
-                    anim->m_AnimationStopped(anim->m_Instance, anim->m_ComponentId, anim->m_PropertyId, anim->m_Finished,
+                    anim->m_AnimationStopped(anim->m_Property.m_Instance, anim->m_Property.m_ComponentId, anim->m_Property.m_PropertyId, anim->m_Finished,
                             anim->m_Userdata1, anim->m_Userdata2);
                     // Check if the callback added animations, in which case we need to update the pointer (possible relocation)
                     size = world->m_Animations.Size();
@@ -339,7 +379,7 @@ namespace dmGameObject
                         anim->m_Easing.release_callback(&anim->m_Easing);
                     }
                 }
-                uint16_t* head_ptr = world->m_InstanceToIndex.Get((uintptr_t)anim->m_Instance);
+                uint16_t* head_ptr = world->m_InstanceToIndex.Get((uintptr_t)anim->m_Property.m_Instance);
                 uint16_t* index_ptr = head_ptr;
                 while (*index_ptr != INVALID_INDEX)
                 {
@@ -357,7 +397,7 @@ namespace dmGameObject
                 // Remove instance when the list is empty
                 if (*head_ptr == INVALID_INDEX)
                 {
-                    world->m_InstanceToIndex.Erase((uintptr_t)anim->m_Instance);
+                    world->m_InstanceToIndex.Erase((uintptr_t)anim->m_Property.m_Instance);
                 }
                 // delete the instance from the list
                 anim = &world->m_Animations.EraseSwap(i);
@@ -389,10 +429,8 @@ namespace dmGameObject
         return (AnimWorld*)dmGameObject::GetWorld(hcollection, component_index);
     }
 
-    static bool PlayAnimation(AnimWorld* world, HInstance instance, dmhash_t component_id,
-                     dmhash_t property_id,
+    static bool PlayAnimation(AnimWorld* world, const PropertyHandle& property,
                      Playback playback,
-                     float* value,
                      float from,
                      float to,
                      dmEasing::Curve easing,
@@ -408,6 +446,7 @@ namespace dmGameObject
             dmLogError("Animation could not be stored since the buffer is full (%d).", MAX_CAPACITY);
             return false;
         }
+        HInstance instance = property.m_Instance;
         uint16_t index = world->m_AnimMapIndexPool.Pop();
         uint16_t* index_ptr = world->m_InstanceToIndex.Get((uintptr_t)instance);
         if (index_ptr == 0x0)
@@ -447,12 +486,9 @@ namespace dmGameObject
         world->m_AnimMap[index] = top;
         animation.m_Index = index;
 
-        animation.m_Instance = instance;
-        animation.m_ComponentId = component_id;
-        animation.m_PropertyId = property_id;
+        animation.m_Property = property;
         animation.m_Playback = playback;
         animation.m_Easing = easing;
-        animation.m_Value = value;
         animation.m_From = from;
         animation.m_To = to;
         animation.m_Delay = dmMath::Max(delay, 0.0f);
@@ -496,11 +532,11 @@ namespace dmGameObject
         return true;
     }
 
-    static bool PlayCompositeAnimation(AnimWorld* world, HInstance instance, dmhash_t component_id,
-            dmhash_t property_id, Playback playback, float duration, float delay, dmEasing::Curve easing, AnimationStopped animation_stopped,
+    static bool PlayCompositeAnimation(AnimWorld* world, const PropertyHandle& property, Playback playback,
+            float duration, float delay, dmEasing::Curve easing, AnimationStopped animation_stopped,
             void* userdata1, void* userdata2)
     {
-        return PlayAnimation(world, instance, component_id, property_id, playback, 0x0, 0, 0, easing,
+        return PlayAnimation(world, property, playback, 0, 0, easing,
                 duration, delay, animation_stopped, userdata1, userdata2, true);
     }
 
@@ -532,8 +568,9 @@ namespace dmGameObject
     {
         if (instance == 0)
             return PROPERTY_RESULT_INVALID_INSTANCE;
+        PropertyHandle property;
         PropertyDesc prop_desc;
-        PropertyResult prop_result = GetProperty(instance, component_id, property_id, prop_desc);
+        PropertyResult prop_result = GetPropertyHandle(instance, component_id, property_id, property, prop_desc);
         if (prop_result != PROPERTY_RESULT_OK)
         {
             return prop_result;
@@ -565,26 +602,30 @@ namespace dmGameObject
 
         if (element_count > 1)
         {
-            if (!PlayCompositeAnimation(world, instance, component_id, property_id, playback,
+            if (!PlayCompositeAnimation(world, property, playback,
                     duration, delay, easing, animation_stopped, userdata1, userdata2))
                 return PROPERTY_RESULT_BUFFER_OVERFLOW;
 
             // Clear the release_callback for element animation to make sure we only call it once in the composite animation
             easing.release_callback = 0x0;
             float* v = prop_desc.m_Variant.m_V4;
+            // The elements are animated separately, through the component index resolved for the whole property
+            PropertyHandle element = property;
+            element.m_Type = PROPERTY_TYPE_NUMBER;
             for (uint32_t i = 0; i < element_count; ++i)
             {
-                float* val_ptr = 0x0;
-                if (prop_desc.m_ValuePtr != 0x0)
-                    val_ptr = prop_desc.m_ValuePtr + i;
-                if (!PlayAnimation(world, instance, component_id, prop_desc.m_ElementIds[i], playback, val_ptr,
+                element.m_PropertyId = prop_desc.m_ElementIds[i];
+                element.m_ValuePtr = 0x0;
+                if (property.m_ValuePtr != 0x0)
+                    element.m_ValuePtr = property.m_ValuePtr + i;
+                if (!PlayAnimation(world, element, playback,
                         *(v + i), to.m_V4[i], easing, duration, delay, 0x0, 0x0, 0x0, false))
                     return PROPERTY_RESULT_BUFFER_OVERFLOW;
             }
         }
         else
         {
-            if (!PlayAnimation(world, instance, component_id, property_id, playback, prop_desc.m_ValuePtr,
+            if (!PlayAnimation(world, property, playback,
                     (float)prop_desc.m_Variant.m_Number, (float)to.m_Number, easing, duration, delay, animation_stopped,
                     userdata1, userdata2, false))
                 return PROPERTY_RESULT_BUFFER_OVERFLOW;
@@ -643,7 +684,7 @@ namespace dmGameObject
                     StopAnimation(anim, false);
                     if (anim->m_AnimationStopped != 0x0)
                     {
-                        anim->m_AnimationStopped(anim->m_Instance, anim->m_ComponentId, anim->m_PropertyId, anim->m_Finished,
+                        anim->m_AnimationStopped(anim->m_Property.m_Instance, anim->m_Property.m_ComponentId, anim->m_Property.m_PropertyId, anim->m_Finished,
                                 anim->m_Userdata1, anim->m_Userdata2);
                         RemoveAnimationCallback(world, anim);
                     }
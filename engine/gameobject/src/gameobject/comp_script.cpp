@@ -13,6 +13,8 @@
 
 #include "comp_script.h"
 
+#include <algorithm>
+
 #include <dlib/dstrings.h>
 #include <dlib/profile.h>
 
@@ -209,6 +211,73 @@ namespace dmGameObject
         return CREATE_RESULT_OK;
     }
 
+    // The iterator passed to update_all. Makes each instance the current instance before it is returned
+    static int UpdateAllNext(lua_State* L)
+    {
+        int i = (int) lua_tointeger(L, lua_upvalueindex(2)) + 1;
+        lua_pushinteger(L, i);
+        lua_replace(L, lua_upvalueindex(2));
+
+        lua_rawgeti(L, lua_upvalueindex(1), i);
+        lua_pushvalue(L, -1);
+        dmScript::SetInstance(L);
+        return 1;
+    }
+
+    static ScriptResult RunUpdateAll(lua_State* L, HScript script, ScriptInstance** instances, uint32_t count, const UpdateContext* update_context)
+    {
+        DM_PROFILE(Script, "RunScript");
+
+        int top = lua_gettop(L);
+        (void) top;
+
+        lua_rawgeti(L, LUA_REGISTRYINDEX, script->m_FunctionReferences[SCRIPT_FUNCTION_UPDATE_ALL]);
+
+        lua_createtable(L, count, 0);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            lua_rawgeti(L, LUA_REGISTRYINDEX, instances[i]->m_InstanceReference);
+            lua_rawseti(L, -2, i + 1);
+        }
+        lua_pushinteger(L, 0);
+        lua_pushcclosure(L, UpdateAllNext, 2);
+        // Keep the iterator to end it after the call
+        lua_pushvalue(L, -1);
+        lua_insert(L, -3);
+
+        lua_pushnumber(L, update_context->m_DT);
+
+        ScriptResult result = SCRIPT_RESULT_OK;
+        {
+            uint32_t profiler_hash = 0;
+            const char* profiler_string = dmScript::GetProfilerString(L, 0, script->m_LuaModule->m_Source.m_Filename, SCRIPT_FUNCTION_NAMES[SCRIPT_FUNCTION_UPDATE_ALL], 0, &profiler_hash);
+            DM_PROFILE_DYN(Script, profiler_string, profiler_hash);
+            if (dmScript::PCall(L, 2, 0) != 0)
+            {
+                result = SCRIPT_RESULT_FAILED;
+            }
+        }
+
+        // The iterator might have been stored by the script
+        lua_pushinteger(L, (lua_Integer) count);
+        lua_setupvalue(L, -2, 2);
+        lua_pop(L, 1);
+
+        lua_pushnil(L);
+        dmScript::SetInstance(L);
+
+        assert(top == lua_gettop(L));
+        return result;
+    }
+
+    struct ScriptInstanceScriptPred
+    {
+        bool operator()(const ScriptInstance* a, const ScriptInstance* b) const
+        {
+            return a->m_Script < b->m_Script;
+        }
+    };
+
     UpdateResult CompScriptUpdate(const ComponentsUpdateParams& params, ComponentsUpdateResult& update_result)
     {
         lua_State* L = GetLuaState(params.m_Context);
@@ -220,11 +289,21 @@ namespace dmGameObject
         CompScriptWorld* script_world = (CompScriptWorld*)params.m_World;
         dmScript::UpdateScriptWorld(script_world->m_ScriptWorld, params.m_UpdateContext->m_DT);
 
+        dmArray<ScriptInstance*>& update_all = script_world->m_UpdateAllInstances;
+        update_all.SetSize(0);
+
         uint32_t size = script_world->m_Instances.Size();
         for (uint32_t i = 0; i < size; ++i)
         {
             HScriptInstance script_instance = script_world->m_Instances[i];
             if (script_instance->m_Update) {
+                if (script_instance->m_Script->m_FunctionReferences[SCRIPT_FUNCTION_UPDATE_ALL] != LUA_NOREF)
+                {
+                    update_all.Push(script_instance);
+                    continue;
+                }
+                // An update function might change anything directly, e.g. through the component script modules
+                update_result.m_Changed |= script_instance->m_Script->m_FunctionReferences[SCRIPT_FUNCTION_UPDATE] != LUA_NOREF;
                 ScriptResult ret = RunScript(L, script_instance->m_Script, SCRIPT_FUNCTION_UPDATE, script_instance, run_params);
                 if (ret == SCRIPT_RESULT_FAILED)
                 {
@@ -233,6 +312,29 @@ namespace dmGameObject
             }
         }
 
+        // One call per script for the scripts that update all their instances at once
+        if (!update_all.Empty())
+        {
+            update_result.m_Changed = true;
+            std::sort(update_all.Begin(), update_all.End(), ScriptInstanceScriptPred());
+            uint32_t start = 0;
+            uint32_t count = update_all.Size();
+            while (start < count)
+            {
+                HScript script = update_all[start]->m_Script;
+                uint32_t end = start + 1;
+                while (end < count && update_all[end]->m_Script == script)
+                    ++end;
+
+                ScriptResult ret = RunUpdateAll(L, script, &update_all[start], end - start, params.m_UpdateContext);
+                if (ret == SCRIPT_RESULT_FAILED)
+                {
+                    result = UPDATE_RESULT_UNKNOWN_ERROR;
+                }
+                start = end;
+            }
+        }
+
         // TODO: Find out if the scripts actually sent any transform events
         update_result.m_TransformsUpdated = true;
 
@@ -339,6 +441,12 @@ namespace dmGameObject
 
         ScriptInstance* script_instance = (ScriptInstance*)*params.m_UserData;
 
+        const dmArray<dmhash_t>& filter = script_instance->m_InputFilter;
+        if (!filter.Empty() && !std::binary_search(filter.Begin(), filter.End(), params.m_InputAction->m_ActionId))
+        {
+            return INPUT_RESULT_IGNORED;
+        }
+
         int function_ref = script_instance->m_Script->m_FunctionReferences[SCRIPT_FUNCTION_ONINPUT];
         if (function_ref != LUA_NOREF)
         {
@@ -440,6 +548,13 @@ namespace dmGameObject
                 lua_settable(L, action_table);
             }
 
+            if (params.m_InputAction->m_Timestamp != 0)
+            {
+                lua_pushliteral(L, "timestamp");
+                lua_pushnumber(L, params.m_InputAction->m_Timestamp / 1000000.0);
+                lua_settable(L, action_table);
+            }
+
             if (params.m_InputAction->m_PositionSet)
             {
                 lua_pushliteral(L, "x");
@@ -93,6 +93,7 @@ void ComponentTypeSetGetPropertyFn(ComponentType* type, ComponentGetProperty fn)
 void ComponentTypeSetSetPropertyFn(ComponentType* type, ComponentSetProperty fn)            { type->m_SetPropertyFunction = fn; }
 void ComponentTypeSetContext(ComponentType* type, void* context)                            { type->m_Context = context; }
 void ComponentTypeSetReadsTransforms(ComponentType* type, bool reads_transforms)            { type->m_ReadsTransforms = reads_transforms?1:0; }
+void ComponentTypeSetUpdateDependencies(ComponentType* type, uint32_t dependencies)      { type->m_UpdateDependencies = dependencies; type->m_HasUpdateDependencies = 1; }
 void ComponentTypeSetPrio(ComponentType* type, uint16_t prio)                               { type->m_UpdateOrderPrio = prio; }
 void ComponentTypeSetHasUserData(ComponentType* type, bool has_user_data)                   { type->m_InstanceHasUserData = has_user_data; }
 void ComponentTypeSetChilldIteratorFn(ComponentType* type, FIteratorChildren fn)            { type->m_IterChildren = fn; }
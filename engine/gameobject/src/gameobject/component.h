@@ -52,7 +52,10 @@ namespace dmGameObject
         FIteratorProperties     m_IterProperties; // for debug/testing
         uint32_t                m_InstanceHasUserData : 1;
         uint32_t                m_ReadsTransforms : 1;
-        uint32_t                m_Reserved : 30;
+        // ComponentUpdateDependency bits, only valid if m_HasUpdateDependencies is set
+        uint32_t                m_UpdateDependencies : 8;
+        uint32_t                m_HasUpdateDependencies : 1;
+        uint32_t                m_Reserved : 21;
         uint16_t                m_UpdateOrderPrio;
     };
 
@@ -20,10 +20,12 @@
 #include <dlib/hash.h>
 #include <dlib/array.h>
 #include <dlib/index_pool.h>
+#include <dlib/memprofile.h>
 #include <dlib/profile.h>
 #include <dlib/math.h>
 #include <dlib/vmath.h>
 #include <dlib/mutex.h>
+#include <dlib/time.h>
 #include <ddf/ddf.h>
 #include "gameobject.h"
 #include "gameobject_script.h"
@@ -39,6 +41,8 @@ namespace dmGameObject
     const char* COLLECTION_MAX_INPUT_STACK_ENTRIES_KEY = "collection.max_input_stack_entries";
     const dmhash_t UNNAMED_IDENTIFIER = dmHashBuffer64("__unnamed__", strlen("__unnamed__"));
     const char* ID_SEPARATOR = "/";
+    // Collection path of instances spawned outside of a collection
+    static const dmhash_t ROOT_PATH_HASH = dmHashBuffer64("/", 1);
     const uint32_t MAX_DISPATCH_ITERATION_COUNT = 10;
 
     static Prototype EMPTY_PROTOTYPE;
@@ -75,6 +79,8 @@ namespace dmGameObject
     static void DeallocCollection(Collection* collection);
     static bool InitCollection(Collection* collection);
     static bool FinalCollection(Collection* collection);
+    static bool InitCollectionIncremental(Collection* collection, uint32_t time_budget, bool* done);
+    static bool FinalCollectionIncremental(Collection* collection, uint32_t time_budget, bool* done);
 
     Prototype::~Prototype()
     {
@@ -156,6 +162,9 @@ namespace dmGameObject
         m_ComponentTypeCount = 0;
         m_DefaultCollectionCapacity = DEFAULT_MAX_COLLECTION_CAPACITY;
         m_DefaultInputStackCapacity = DEFAULT_MAX_INPUT_STACK_CAPACITY;
+        m_JobContext = 0;
+        m_FrameAllocator = 0;
+        m_Changed = 1;
         m_Mutex = dmMutex::New();
     }
 
@@ -189,7 +198,26 @@ namespace dmGameObject
         m_InstanceIndices.SetCapacity(max_instances);
         m_WorldTransforms.SetCapacity(max_instances);
         m_WorldTransforms.SetSize(max_instances);
-        m_IDToInstance.SetCapacity(dmMath::Max(1U, max_instances/3), max_instances);
+        m_LocalTransforms.SetCapacity(max_instances);
+        m_LocalTransforms.SetSize(max_instances);
+        m_EulerRotations.SetCapacity(max_instances);
+        m_EulerRotations.SetSize(max_instances);
+        m_PrevEulerRotations.SetCapacity(max_instances);
+        m_PrevEulerRotations.SetSize(max_instances);
+        m_ParentIndices.SetCapacity(max_instances);
+        m_ParentIndices.SetSize(max_instances);
+        m_TransformFlags.SetCapacity(max_instances);
+        m_TransformFlags.SetSize(max_instances);
+        m_WorldTransformVersions.SetCapacity(max_instances);
+        m_WorldTransformVersions.SetSize(max_instances);
+        m_IDToInstance.SetCapacity(max_instances);
+        memset(m_MessageReceiverCache, 0, sizeof(m_MessageReceiverCache));
+        m_MessageReceiverGeneration = 1;
+        m_SpatialIndex = 0;
+        m_InstancePoolSize = 0;
+        m_DeferredInitHead = 0;
+        m_DeferredInitTimeBudget = 0;
+        m_DeferredSpawnCounter = 0;
         m_InputFocusStack.SetCapacity(max_input_stack_entries);
         m_NameHash = 0;
         m_ComponentSocket = 0;
@@ -205,6 +233,10 @@ namespace dmGameObject
         m_ScaleAlongZ = 0;
         m_DirtyTransforms = 1;
         m_Initialized = 0;
+        m_IncrementalState = INCREMENTAL_STATE_NONE;
+        m_IncrementalFailed = 0;
+        m_IncrementalIndex = 0;
+        m_IncrementalCount = 0;
 
         m_InstancesToDeleteHead = INVALID_INSTANCE_INDEX;
         m_InstancesToDeleteTail = INVALID_INSTANCE_INDEX;
@@ -214,10 +246,288 @@ namespace dmGameObject
 
         memset(&m_Instances[0], 0, sizeof(Instance*) * max_instances);
         memset(&m_WorldTransforms[0], 0xcc, sizeof(dmTransform::Transform) * max_instances);
+        memset(&m_ParentIndices[0], 0xff, sizeof(InstanceIndex) * max_instances);
+        memset(&m_TransformFlags[0], 0, sizeof(uint8_t) * max_instances);
+        memset(&m_WorldTransformVersions[0], 0, sizeof(uint32_t) * max_instances);
         memset(&m_LevelIndices[0], 0, sizeof(m_LevelIndices));
         memset(&m_ComponentInstanceCount[0], 0, sizeof(uint32_t) * MAX_COMPONENT_TYPES);
     }
 
+    // Cell coordinates are stored as 21 bit integers in the key
+    static const int32_t SPATIAL_INDEX_CELL_RANGE = 1 << 20;
+
+    SpatialIndex::SpatialIndex(uint32_t max_instances, float cell_size)
+    {
+        m_Cells.SetCapacity(dmMath::Max(1U, max_instances/3), dmMath::Max(1U, max_instances));
+        m_CellKeys.SetCapacity(max_instances);
+        m_CellKeys.SetSize(max_instances);
+        m_Next.SetCapacity(max_instances);
+        m_Next.SetSize(max_instances);
+        m_Prev.SetCapacity(max_instances);
+        m_Prev.SetSize(max_instances);
+        m_Positions.SetCapacity(max_instances);
+        m_Positions.SetSize(max_instances);
+        m_CellSize = cell_size;
+        m_InvCellSize = 1.0f / cell_size;
+        if (max_instances > 0)
+            memset(&m_CellKeys[0], 0xff, sizeof(uint64_t) * max_instances);
+    }
+
+    static int32_t GetSpatialCellCoord(const SpatialIndex* index, float v)
+    {
+        // Written so that NaN ends up in the lowest cell
+        float c = floorf(v * index->m_InvCellSize);
+        c = c > (float)-SPATIAL_INDEX_CELL_RANGE ? c : (float)-SPATIAL_INDEX_CELL_RANGE;
+        c = c < (float)(SPATIAL_INDEX_CELL_RANGE - 1) ? c : (float)(SPATIAL_INDEX_CELL_RANGE - 1);
+        return (int32_t)c;
+    }
+
+    static uint64_t GetSpatialCellKey(int32_t x, int32_t y, int32_t z)
+    {
+        return  (uint64_t)(x + SPATIAL_INDEX_CELL_RANGE) |
+               ((uint64_t)(y + SPATIAL_INDEX_CELL_RANGE) << 21) |
+               ((uint64_t)(z + SPATIAL_INDEX_CELL_RANGE) << 42);
+    }
+
+    static uint64_t GetSpatialCellKey(const SpatialIndex* index, const Point3& p)
+    {
+        return GetSpatialCellKey(GetSpatialCellCoord(index, p.getX()), GetSpatialCellCoord(index, p.getY()), GetSpatialCellCoord(index, p.getZ()));
+    }
+
+    static void SpatialIndexRemove(SpatialIndex* index, InstanceIndex instance_index)
+    {
+        uint64_t key = index->m_CellKeys[instance_index];
+        if (key == SPATIAL_INDEX_INVALID_CELL)
+            return;
+
+        InstanceIndex prev = index->m_Prev[instance_index];
+        InstanceIndex next = index->m_Next[instance_index];
+        if (prev != INVALID_INSTANCE_INDEX)
+            index->m_Next[prev] = next;
+        else if (next != INVALID_INSTANCE_INDEX)
+            *index->m_Cells.Get(key) = next;
+        else
+            index->m_Cells.Erase(key);
+
+        if (next != INVALID_INSTANCE_INDEX)
+            index->m_Prev[next] = prev;
+        index->m_CellKeys[instance_index] = SPATIAL_INDEX_INVALID_CELL;
+    }
+
+    static void SpatialIndexInsert(SpatialIndex* index, InstanceIndex instance_index, uint64_t key)
+    {
+        index->m_Prev[instance_index] = INVALID_INSTANCE_INDEX;
+        InstanceIndex* head = index->m_Cells.Get(key);
+        if (head)
+        {
+            index->m_Next[instance_index] = *head;
+            index->m_Prev[*head] = instance_index;
+            *head = instance_index;
+        }
+        else
+        {
+            index->m_Next[instance_index] = INVALID_INSTANCE_INDEX;
+            index->m_Cells.Put(key, instance_index);
+        }
+        index->m_CellKeys[instance_index] = key;
+    }
+
+    static void SpatialIndexUpdate(SpatialIndex* index, InstanceIndex instance_index, const Point3& position)
+    {
+        index->m_Positions[instance_index] = position;
+        uint64_t key = GetSpatialCellKey(index, position);
+        if (key != index->m_CellKeys[instance_index])
+        {
+            SpatialIndexRemove(index, instance_index);
+            SpatialIndexInsert(index, instance_index, key);
+        }
+    }
+
+    static void RemoveFromSpatialIndex(Collection* collection, InstanceIndex instance_index)
+    {
+        if (collection->m_SpatialIndex)
+            SpatialIndexRemove(collection->m_SpatialIndex, instance_index);
+    }
+
+    // Re-index the instances whose world transforms were recomputed by the last UpdateTransforms
+    static void UpdateSpatialIndex(Collection* collection)
+    {
+        SpatialIndex* index = collection->m_SpatialIndex;
+        if (!index)
+            return;
+
+        DM_PROFILE(GameObject, "UpdateSpatialIndex");
+        const Matrix4* world_transforms = collection->m_WorldTransforms.Begin();
+        const uint8_t* flags = collection->m_TransformFlags.Begin();
+        for (uint32_t level_i = 0; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
+        {
+            const dmArray<InstanceIndex>& level = collection->m_LevelIndices[level_i];
+            if (level.Empty())
+                break;
+            for (uint32_t i = 0; i < level.Size(); ++i)
+            {
+                InstanceIndex instance_index = level[i];
+                if (flags[instance_index] & TRANSFORM_FLAG_CHANGED)
+                {
+                    SpatialIndexUpdate(index, instance_index, Point3(world_transforms[instance_index].getCol3().getXYZ()));
+                }
+            }
+        }
+    }
+
+    Result EnableSpatialIndex(HCollection hcollection, float cell_size)
+    {
+        Collection* collection = hcollection->m_Collection;
+        if (!(cell_size > 0.0f))
+        {
+            dmLogError("The spatial index cell size must be positive (%f).", cell_size);
+            return RESULT_INVALID_OPERATION;
+        }
+
+        if (collection->m_SpatialIndex)
+        {
+            if (collection->m_SpatialIndex->m_CellSize == cell_size)
+                return RESULT_OK;
+            delete collection->m_SpatialIndex;
+        }
+
+        SpatialIndex* index = new SpatialIndex(collection->m_MaxInstances, cell_size);
+        collection->m_SpatialIndex = index;
+
+        // Instances that haven't got a world transform yet are added by the next UpdateTransforms
+        for (uint32_t i = 0; i < collection->m_MaxInstances; ++i)
+        {
+            if (collection->m_Instances[i] && collection->m_WorldTransformVersions[i] != 0)
+            {
+                SpatialIndexUpdate(index, (InstanceIndex)i, Point3(collection->m_WorldTransforms[i].getCol3().getXYZ()));
+            }
+        }
+        return RESULT_OK;
+    }
+
+    void DisableSpatialIndex(HCollection hcollection)
+    {
+        Collection* collection = hcollection->m_Collection;
+        delete collection->m_SpatialIndex;
+        collection->m_SpatialIndex = 0;
+    }
+
+    struct SpatialQueryContext
+    {
+        Point3                  m_Min;
+        Point3                  m_Max;
+        Point3                  m_Center;
+        float                   m_RadiusSq;
+        Collection*             m_Collection;
+        SpatialQueryCallback    m_Callback;
+        void*                   m_UserData;
+        uint32_t                m_Count;
+        uint32_t                m_Sphere : 1;
+    };
+
+    static void QuerySpatialCell(SpatialQueryContext* ctx, InstanceIndex head)
+    {
+        Collection* collection = ctx->m_Collection;
+        const SpatialIndex* index = collection->m_SpatialIndex;
+        for (InstanceIndex i = head; i != INVALID_INSTANCE_INDEX; i = index->m_Next[i])
+        {
+            const Point3& p = index->m_Positions[i];
+            bool inside;
+            if (ctx->m_Sphere)
+            {
+                inside = distSqr(p, ctx->m_Center) <= ctx->m_RadiusSq;
+            }
+            else
+            {
+                inside = p.getX() >= ctx->m_Min.getX() && p.getX() <= ctx->m_Max.getX() &&
+                         p.getY() >= ctx->m_Min.getY() && p.getY() <= ctx->m_Max.getY() &&
+                         p.getZ() >= ctx->m_Min.getZ() && p.getZ() <= ctx->m_Max.getZ();
+            }
+            if (inside)
+            {
+                ctx->m_Callback(collection->m_Instances[i], ctx->m_UserData);
+                ++ctx->m_Count;
+            }
+        }
+    }
+
+    static void QuerySpatialCellIterate(SpatialQueryContext* ctx, const uint64_t* key, InstanceIndex* head)
+    {
+        (void)key;
+        QuerySpatialCell(ctx, *head);
+    }
+
+    static uint32_t QuerySpatialIndex(Collection* collection, SpatialQueryContext* ctx)
+    {
+        DM_PROFILE(GameObject, "QuerySpatialIndex");
+        if (!collection->m_SpatialIndex)
+            EnableSpatialIndex(collection->m_HCollection, SPATIAL_INDEX_DEFAULT_CELL_SIZE);
+
+        const SpatialIndex* index = collection->m_SpatialIndex;
+        ctx->m_Collection = collection;
+        ctx->m_Count = 0;
+
+        int32_t lo[3], hi[3];
+        uint64_t cell_count = 1;
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            lo[i] = GetSpatialCellCoord(index, ctx->m_Min.getElem(i));
+            hi[i] = GetSpatialCellCoord(index, ctx->m_Max.getElem(i));
+            if (hi[i] < lo[i])
+                return 0;
+            cell_count *= (uint64_t)(hi[i] - lo[i] + 1);
+        }
+
+        // Large queries are cheaper to answer by visiting the occupied cells only
+        if (cell_count > index->m_Cells.Size())
+        {
+            collection->m_SpatialIndex->m_Cells.Iterate(QuerySpatialCellIterate, ctx);
+            return ctx->m_Count;
+        }
+
+        for (int32_t z = lo[2]; z <= hi[2]; ++z)
+        {
+            for (int32_t y = lo[1]; y <= hi[1]; ++y)
+            {
+                for (int32_t x = lo[0]; x <= hi[0]; ++x)
+                {
+                    const InstanceIndex* head = index->m_Cells.Get(GetSpatialCellKey(x, y, z));
+                    if (head)
+                        QuerySpatialCell(ctx, *head);
+                }
+            }
+        }
+        return ctx->m_Count;
+    }
+
+    uint32_t QueryAABB(HCollection hcollection, const Point3& min, const Point3& max, SpatialQueryCallback callback, void* user_data)
+    {
+        SpatialQueryContext ctx;
+        ctx.m_Min = min;
+        ctx.m_Max = max;
+        ctx.m_Center = Point3(0.0f);
+        ctx.m_RadiusSq = 0.0f;
+        ctx.m_Callback = callback;
+        ctx.m_UserData = user_data;
+        ctx.m_Sphere = 0;
+        return QuerySpatialIndex(hcollection->m_Collection, &ctx);
+    }
+
+    uint32_t QueryRadius(HCollection hcollection, const Point3& center, float radius, SpatialQueryCallback callback, void* user_data)
+    {
+        if (!(radius >= 0.0f))
+            return 0;
+        SpatialQueryContext ctx;
+        ctx.m_Min = center - Vector3(radius);
+        ctx.m_Max = center + Vector3(radius);
+        ctx.m_Center = center;
+        ctx.m_RadiusSq = radius * radius;
+        ctx.m_Callback = callback;
+        ctx.m_UserData = user_data;
+        ctx.m_Sphere = 1;
+        return QuerySpatialIndex(hcollection->m_Collection, &ctx);
+    }
+
     Result SetCollectionDefaultCapacity(HRegister regist, uint32_t capacity)
     {
         assert(regist != 0x0);
@@ -239,6 +549,47 @@ namespace dmGameObject
         regist->m_DefaultInputStackCapacity = capacity;
     }
 
+    void SetJobContext(HRegister regist, dmJob::HContext job_context)
+    {
+        assert(regist != 0x0);
+        regist->m_JobContext = job_context;
+    }
+
+    dmJob::HContext GetJobContext(HRegister regist)
+    {
+        assert(regist != 0x0);
+        return regist->m_JobContext;
+    }
+
+    void SetFrameAllocator(HRegister regist, dmFrameAlloc::HAllocator frame_allocator)
+    {
+        assert(regist != 0x0);
+        regist->m_FrameAllocator = frame_allocator;
+    }
+
+    dmFrameAlloc::HAllocator GetFrameAllocator(HRegister regist)
+    {
+        assert(regist != 0x0);
+        return regist->m_FrameAllocator;
+    }
+
+    // Gives the array a fixed capacity from the frame allocator, if there is one.
+    // The array can't grow beyond it, and the memory is only valid until the end of the next frame.
+    template <typename T>
+    static void SetTransientCapacity(HRegister regist, dmArray<T>& array, uint32_t capacity)
+    {
+        if (regist->m_FrameAllocator && capacity > 0)
+        {
+            T* memory = (T*) dmFrameAlloc::Alloc(regist->m_FrameAllocator, capacity * sizeof(T));
+            dmArray<T> transient(memory, 0, capacity);
+            array.Swap(transient);
+        }
+        else
+        {
+            array.SetCapacity(capacity);
+        }
+    }
+
     static uint32_t GetInputStackDefaultCapacity(HRegister regist)
     {
         assert(regist != 0x0);
@@ -296,6 +647,15 @@ namespace dmGameObject
                 regist->m_ComponentTypes[i].m_DeleteWorldFunction(params);
         }
         dmMutex::Delete(collection->m_Mutex);
+        delete collection->m_SpatialIndex;
+        for (uint32_t i = 0; i < INSTANCE_POOL_BUCKET_COUNT; ++i)
+        {
+            dmArray<void*>& bucket = collection->m_InstancePool[i];
+            for (uint32_t j = 0; j < bucket.Size(); ++j)
+            {
+                operator delete (bucket[j]);
+            }
+        }
         delete collection;
     }
 
@@ -544,12 +904,12 @@ namespace dmGameObject
          * Remove instance from m_LevelIndices using an erase-swap operation
          */
 
-        dmArray<uint16_t>& level = collection->m_LevelIndices[instance->m_Depth];
+        dmArray<InstanceIndex>& level = collection->m_LevelIndices[instance->m_Depth];
         assert(level.Size() > 0);
         assert(instance->m_LevelIndex < level.Size());
 
-        uint16_t level_index = instance->m_LevelIndex;
-        uint16_t swap_in_index = level.EraseSwap(level_index);
+        InstanceIndex level_index = instance->m_LevelIndex;
+        InstanceIndex swap_in_index = level.EraseSwap(level_index);
         HInstance swap_in_instance = collection->m_Instances[swap_in_index];
         assert(swap_in_instance->m_Index == swap_in_index);
         swap_in_instance->m_LevelIndex = level_index;
@@ -561,7 +921,7 @@ namespace dmGameObject
      * ** 10 elements as min
      * ** Up to max_instances as max
      */
-    static void ExpandLevel(dmArray<uint16_t>& level, uint32_t max_instances)
+    static void ExpandLevel(dmArray<InstanceIndex>& level, uint32_t max_instances)
     {
         const uint32_t min_offset = 10;
         const uint32_t max_offset = max_instances - level.Capacity();
@@ -574,18 +934,18 @@ namespace dmGameObject
         /*
          * Insert instance in m_LevelIndices at level set in instance->m_Depth
          */
-        dmArray<uint16_t>& level = collection->m_LevelIndices[instance->m_Depth];
+        dmArray<InstanceIndex>& level = collection->m_LevelIndices[instance->m_Depth];
         if (level.Full())
             ExpandLevel(level, collection->m_MaxInstances);
         assert(!level.Full());
 
-        uint16_t level_index = (uint16_t)level.Size();
+        InstanceIndex level_index = (InstanceIndex)level.Size();
         level.SetSize(level_index + 1);
         level[level_index] = instance->m_Index;
         instance->m_LevelIndex = level_index;
     }
 
-    static HInstance AllocInstance(Prototype* proto, const char* prototype_name) {
+    static uint32_t GetComponentUserDataCount(Prototype* proto, const char* prototype_name) {
         // Count number of component userdata fields required
         uint32_t component_instance_userdata_count = 0;
         for (uint32_t i = 0; i < proto->m_ComponentCount; ++i)
@@ -600,16 +960,56 @@ namespace dmGameObject
             if (component_type->m_InstanceHasUserData)
                 component_instance_userdata_count++;
         }
+        return component_instance_userdata_count;
+    }
 
+    static uint32_t GetInstanceMemorySize(uint32_t component_instance_userdata_count) {
         uint32_t component_userdata_size = sizeof(((Instance*)0)->m_ComponentInstanceUserData[0]);
+        return sizeof(Instance) + component_instance_userdata_count * component_userdata_size;
+    }
+
+    // Spawning and deleting instances of the same prototypes in a collection recycles the allocations
+    static void* AllocInstanceMemory(Collection* collection, uint32_t component_instance_userdata_count) {
+        if (component_instance_userdata_count < INSTANCE_POOL_BUCKET_COUNT)
+        {
+            dmArray<void*>& bucket = collection->m_InstancePool[component_instance_userdata_count];
+            if (!bucket.Empty())
+            {
+                void* instance_memory = bucket.Back();
+                bucket.Pop();
+                collection->m_InstancePoolSize--;
+                return instance_memory;
+            }
+        }
+        return ::operator new (GetInstanceMemorySize(component_instance_userdata_count));
+    }
+
+    static void FreeInstanceMemory(Collection* collection, void* instance_memory, uint32_t component_instance_userdata_count) {
+        if (component_instance_userdata_count < INSTANCE_POOL_BUCKET_COUNT && collection->m_InstancePoolSize < collection->m_MaxInstances)
+        {
+            dmArray<void*>& bucket = collection->m_InstancePool[component_instance_userdata_count];
+            if (bucket.Full())
+            {
+                bucket.OffsetCapacity(dmMath::Max(16U, bucket.Capacity()));
+            }
+            bucket.Push(instance_memory);
+            collection->m_InstancePoolSize++;
+            return;
+        }
+        operator delete (instance_memory);
+    }
+
+    static HInstance AllocInstance(Collection* collection, Prototype* proto, const char* prototype_name) {
+        uint32_t component_instance_userdata_count = GetComponentUserDataCount(proto, prototype_name);
         // NOTE: Allocate actual Instance with *all* component instance user-data accounted
-        void* instance_memory = ::operator new (sizeof(Instance) + component_instance_userdata_count * component_userdata_size);
+        void* instance_memory = AllocInstanceMemory(collection, component_instance_userdata_count);
         Instance* instance = new(instance_memory) Instance(proto);
         instance->m_ComponentInstanceUserDataCount = component_instance_userdata_count;
         return instance;
     }
 
-    static void DeallocInstance(HInstance instance) {
+    static void DeallocInstance(Collection* collection, HInstance instance) {
+        uint32_t component_instance_userdata_count = instance->m_ComponentInstanceUserDataCount;
         instance->~Instance();
         void* instance_memory = (void*) instance;
 
@@ -617,7 +1017,27 @@ namespace dmGameObject
         // TODO: #ifdef on something...?
         // Clear all memory excluding ComponentInstanceUserData
         memset(instance_memory, 0xcc, sizeof(Instance));
-        operator delete (instance_memory);
+        FreeInstanceMemory(collection, instance_memory, component_instance_userdata_count);
+    }
+
+    void PrewarmInstances(HCollection hcollection, HPrototype proto, uint32_t count) {
+        Collection* collection = hcollection->m_Collection;
+        uint32_t component_instance_userdata_count = GetComponentUserDataCount(proto, "<prewarm>");
+        if (component_instance_userdata_count >= INSTANCE_POOL_BUCKET_COUNT)
+        {
+            return;
+        }
+        dmArray<void*>& bucket = collection->m_InstancePool[component_instance_userdata_count];
+        uint32_t size = GetInstanceMemorySize(component_instance_userdata_count);
+        while (bucket.Size() < count && collection->m_InstancePoolSize < collection->m_MaxInstances)
+        {
+            if (bucket.Full())
+            {
+                bucket.OffsetCapacity(dmMath::Max(count - bucket.Size(), 16U));
+            }
+            bucket.Push(::operator new (size));
+            collection->m_InstancePoolSize++;
+        }
     }
 
     HInstance NewInstance(Collection* collection, Prototype* proto, const char* prototype_name) {
@@ -626,14 +1046,21 @@ namespace dmGameObject
             dmLogError("The game object instance could not be created since the buffer is full (%d).", collection->m_InstanceIndices.Capacity());
             return 0;
         }
-        HInstance instance = AllocInstance(proto, prototype_name);
+        HInstance instance = AllocInstance(collection, proto, prototype_name);
         instance->m_Collection = collection;
         instance->m_ScaleAlongZ = collection->m_ScaleAlongZ;
-        uint16_t instance_index = collection->m_InstanceIndices.Pop();
+        InstanceIndex instance_index = collection->m_InstanceIndices.Pop();
         instance->m_Index = instance_index;
         assert(collection->m_Instances[instance_index] == 0);
         collection->m_Instances[instance_index] = instance;
 
+        collection->m_LocalTransforms[instance_index].SetIdentity();
+        collection->m_EulerRotations[instance_index] = Vector3(0.0f, 0.0f, 0.0f);
+        collection->m_PrevEulerRotations[instance_index] = Vector3(0.0f, 0.0f, 0.0f);
+        collection->m_ParentIndices[instance_index] = INVALID_INSTANCE_INDEX;
+        collection->m_TransformFlags[instance_index] = TRANSFORM_FLAG_DIRTY;
+        collection->m_WorldTransformVersions[instance_index] = 0;
+
         InsertInstanceInLevelIndex(collection, instance);
 
         return instance;
@@ -654,8 +1081,11 @@ namespace dmGameObject
             Unlink(collection, instance);
         }
 
-        uint16_t instance_index = instance->m_Index;
-        operator delete ((void*)instance);
+        ReleaseCollectionPath(collection, instance);
+
+        InstanceIndex instance_index = instance->m_Index;
+        FreeInstanceMemory(collection, (void*)instance, instance->m_ComponentInstanceUserDataCount);
+        RemoveFromSpatialIndex(collection, instance_index);
         collection->m_Instances[instance_index] = 0x0;
         collection->m_InstanceIndices.Push(instance_index);
         assert(collection->m_IDToInstance.Size() <= collection->m_InstanceIndices.Size());
@@ -876,6 +1306,7 @@ namespace dmGameObject
 
         instance->m_Identifier = id;
         collection->m_IDToInstance.Put(id, instance);
+        collection->m_MessageReceiverGeneration++;
 
         assert(collection->m_IDToInstance.Size() <= collection->m_InstanceIndices.Size());
         return RESULT_OK;
@@ -890,10 +1321,86 @@ namespace dmGameObject
     {
         if (instance->m_Identifier != UNNAMED_IDENTIFIER) {
             collection->m_IDToInstance.Erase(instance->m_Identifier);
+            collection->m_MessageReceiverGeneration++;
             instance->m_Identifier = UNNAMED_IDENTIFIER;
         }
     }
 
+    void SetCollectionPath(Collection* collection, HInstance instance, HashState64* path_state)
+    {
+        ReleaseCollectionPath(collection, instance);
+
+        HashState64 tmp_state;
+        dmHashClone64(&tmp_state, path_state, false);
+        dmhash_t path_hash = dmHashFinal64(&tmp_state);
+
+        uint16_t* existing = collection->m_CollectionPathIndices.Get(path_hash);
+        if (existing)
+        {
+            ShareCollectionPath(collection, instance, *existing);
+            dmHashRelease64(path_state);
+            return;
+        }
+
+        uint16_t path_index;
+        if (collection->m_CollectionPathFreeList.Empty())
+        {
+            if (collection->m_CollectionPaths.Full())
+            {
+                collection->m_CollectionPaths.OffsetCapacity(16);
+            }
+            path_index = (uint16_t)collection->m_CollectionPaths.Size();
+            collection->m_CollectionPaths.SetSize(path_index + 1);
+        }
+        else
+        {
+            path_index = collection->m_CollectionPathFreeList.Back();
+            collection->m_CollectionPathFreeList.Pop();
+        }
+
+        // The state is moved rather than cloned, to keep a reverse hash entry it might have
+        CollectionPath& path = collection->m_CollectionPaths[path_index];
+        memcpy(&path.m_State, path_state, sizeof(HashState64));
+        path.m_Hash = path_hash;
+        path.m_RefCount = 1;
+
+        if (collection->m_CollectionPathIndices.Full())
+        {
+            uint32_t capacity = collection->m_CollectionPathIndices.Capacity() + 32;
+            collection->m_CollectionPathIndices.SetCapacity(capacity / 2, capacity);
+        }
+        collection->m_CollectionPathIndices.Put(path_hash, path_index);
+        instance->m_CollectionPathIndex = path_index;
+    }
+
+    void ShareCollectionPath(Collection* collection, HInstance instance, uint16_t path_index)
+    {
+        ReleaseCollectionPath(collection, instance);
+        collection->m_CollectionPaths[path_index].m_RefCount++;
+        instance->m_CollectionPathIndex = path_index;
+    }
+
+    void ReleaseCollectionPath(Collection* collection, HInstance instance)
+    {
+        uint16_t path_index = instance->m_CollectionPathIndex;
+        if (path_index == INVALID_COLLECTION_PATH_INDEX)
+            return;
+        instance->m_CollectionPathIndex = INVALID_COLLECTION_PATH_INDEX;
+
+        CollectionPath& path = collection->m_CollectionPaths[path_index];
+        assert(path.m_RefCount > 0);
+        if (--path.m_RefCount == 0)
+        {
+            dmHashRelease64(&path.m_State);
+            collection->m_CollectionPathIndices.Erase(path.m_Hash);
+            if (collection->m_CollectionPathFreeList.Full())
+            {
+                collection->m_CollectionPathFreeList.OffsetCapacity(16);
+            }
+            collection->m_CollectionPathFreeList.Push(path_index);
+        }
+    }
+
     // Schedule instance to be added to update
     static void AddToUpdate(Collection* collection, HInstance instance)
     {
@@ -903,8 +1410,8 @@ namespace dmGameObject
             return;
         }
         instance->m_ToBeAdded = 1;
-        uint16_t index = instance->m_Index;
-        uint16_t tail = collection->m_InstancesToAddTail;
+        InstanceIndex index = instance->m_Index;
+        InstanceIndex tail = collection->m_InstancesToAddTail;
         if (tail != INVALID_INSTANCE_INDEX) {
             HInstance tail_instance = collection->m_Instances[tail];
             tail_instance->m_NextToAdd = index;
@@ -963,7 +1470,7 @@ namespace dmGameObject
             dmLogError("Instances can not be added to update during the update.");
             return false;
         }
-        uint16_t index = collection->m_InstancesToAddHead;
+        InstanceIndex index = collection->m_InstancesToAddHead;
         bool result = true;
         while (index != INVALID_INSTANCE_INDEX) {
             HInstance instance = collection->m_Instances[index];
@@ -1035,10 +1542,20 @@ namespace dmGameObject
         SetPosition(instance, position);
         SetRotation(instance, rotation);
         SetScale(instance, scale);
-        collection->m_WorldTransforms[instance->m_Index] = dmTransform::ToMatrix4(instance->m_Transform);
+        SetWorldTransform(collection, instance->m_Index, dmTransform::ToMatrix4(GetLocalTransform(instance)));
 
-        dmHashInit64(&instance->m_CollectionPathHashState, true);
-        dmHashUpdateBuffer64(&instance->m_CollectionPathHashState, ID_SEPARATOR, strlen(ID_SEPARATOR));
+        uint16_t* root_path_index = collection->m_CollectionPathIndices.Get(ROOT_PATH_HASH);
+        if (root_path_index)
+        {
+            ShareCollectionPath(collection, instance, *root_path_index);
+        }
+        else
+        {
+            HashState64 path_state;
+            dmHashInit64(&path_state, false);
+            dmHashUpdateBuffer64(&path_state, ID_SEPARATOR, strlen(ID_SEPARATOR));
+            SetCollectionPath(collection, instance, &path_state);
+        }
 
         Result result = SetIdentifier(collection, instance, id);
         if (result == RESULT_IDENTIFIER_IN_USE)
@@ -1074,7 +1591,7 @@ namespace dmGameObject
     }
 
     // Returns if successful or not
-    static bool CollectionSpawnFromDescInternal(Collection* collection, dmGameObjectDDF::CollectionDesc* collection_desc, InstancePropertyBuffers *property_buffers, InstanceIdMap *id_mapping, dmTransform::Transform const &transform)
+    static bool CollectionSpawnFromDescInternal(Collection* collection, dmGameObjectDDF::CollectionDesc* collection_desc, InstancePropertyBuffers *property_buffers, InstanceIdMap *id_mapping, dmTransform::Transform const &transform, uint32_t deferred_spawn_id)
     {
         // Path prefix for collection objects
         char root_path[32];
@@ -1087,9 +1604,12 @@ namespace dmGameObject
         id_mapping->SetCapacity(32, collection_desc->m_Instances.m_Count);
 
         dmArray<HInstance> new_instances;
-        new_instances.SetCapacity(collection_desc->m_Instances.m_Count);
+        SetTransientCapacity(collection->m_Register, new_instances, collection_desc->m_Instances.m_Count);
 
         bool success = true;
+        const char* prev_path = 0;
+        uint32_t prev_path_length = 0;
+        uint16_t prev_path_index = INVALID_COLLECTION_PATH_INDEX;
 
         for (uint32_t i = 0; i < collection_desc->m_Instances.m_Count; ++i)
         {
@@ -1122,15 +1642,26 @@ namespace dmGameObject
             if (scale.getX() == 0 && scale.getY() == 0 && scale.getZ() == 0)
                     scale = Vector3(instance_desc.m_Scale, instance_desc.m_Scale, instance_desc.m_Scale);
 
-            instance->m_Transform = dmTransform::Transform(Vector3(instance_desc.m_Position), instance_desc.m_Rotation, scale);
-            dmHashClone64(&instance->m_CollectionPathHashState, &prefixHashState, true);
-
+            GetLocalTransform(instance) = dmTransform::Transform(Vector3(instance_desc.m_Position), instance_desc.m_Rotation, scale);
             const char* path_end = strrchr(instance_desc.m_Id, *ID_SEPARATOR);
+            uint32_t path_length = path_end ? (uint32_t)(path_end - instance_desc.m_Id + 1) : 0;
             if (path_end == 0x0) {
                 dmLogError("The id of %s has an incorrect format, missing path specifier.", instance_desc.m_Id);
                 success = false;
+            }
+
+            // Most instances have the same path as the previous one, which saves hashing it again
+            if (prev_path_index != INVALID_COLLECTION_PATH_INDEX && path_length == prev_path_length && strncmp(instance_desc.m_Id, prev_path, path_length) == 0) {
+                ShareCollectionPath(collection, instance, prev_path_index);
             } else {
-                dmHashUpdateBuffer64(&instance->m_CollectionPathHashState, instance_desc.m_Id, path_end - instance_desc.m_Id + 1);
+                // Reverse hashing isn't used for the path, see GetAbsoluteIdentifier()
+                HashState64 path_state;
+                dmHashClone64(&path_state, &prefixHashState, false);
+                dmHashUpdateBuffer64(&path_state, instance_desc.m_Id, path_length);
+                SetCollectionPath(collection, instance, &path_state);
+                prev_path = instance_desc.m_Id;
+                prev_path_length = path_length;
+                prev_path_index = instance->m_CollectionPathIndex;
             }
 
             // Construct the full new path id and store in the id mapping table (mapping from prefixless
@@ -1202,11 +1733,11 @@ namespace dmGameObject
             {
                 if (!GetParent(new_instances[i]))
                 {
-                    new_instances[i]->m_Transform = dmTransform::Mul(transform, new_instances[i]->m_Transform);
+                    GetLocalTransform(new_instances[i]) = dmTransform::Mul(transform, GetLocalTransform(new_instances[i]));
                 }
 
                 // world transforms need to be up to date in time for the script init calls
-                collection->m_WorldTransforms[new_instances[i]->m_Index] = dmTransform::ToMatrix4(new_instances[i]->m_Transform);
+                SetWorldTransform(collection, new_instances[i]->m_Index, dmTransform::ToMatrix4(GetLocalTransform(new_instances[i])));
             }
         }
 
@@ -1230,7 +1761,7 @@ namespace dmGameObject
         // After this point, instances are either removed (through undo) on error, or added
         // to the 'created' array from which they can be deleted on error.
         dmArray<HInstance> created;
-        created.SetCapacity(collection_desc->m_Instances.m_Count);
+        SetTransientCapacity(collection->m_Register, created, collection_desc->m_Instances.m_Count);
 
         for (uint32_t i = 0; i < collection_desc->m_Instances.m_Count; ++i)
         {
@@ -1353,7 +1884,7 @@ namespace dmGameObject
             }
         }
 
-        if (success)
+        if (success && deferred_spawn_id == 0)
         {
             for (uint32_t i=0;i!=created.Size();i++)
             {
@@ -1374,6 +1905,25 @@ namespace dmGameObject
             return false;
         }
 
+        if (deferred_spawn_id != 0)
+        {
+            // Initialized and added to update later, see UpdateDeferredInits()
+            dmArray<DeferredInit>& inits = collection->m_DeferredInits;
+            if (inits.Remaining() < created.Size())
+            {
+                inits.OffsetCapacity(dmMath::Max(created.Size() - inits.Remaining(), 64U));
+            }
+            for (uint32_t i=0;i!=created.Size();i++)
+            {
+                DeferredInit deferred;
+                deferred.m_Identifier = created[i]->m_Identifier;
+                deferred.m_SpawnId = deferred_spawn_id;
+                deferred.m_Index = created[i]->m_Index;
+                inits.Push(deferred);
+            }
+            return true;
+        }
+
         for (uint32_t i=0;i!=created.Size();i++)
         {
             AddToUpdate(collection, created[i]);
@@ -1391,11 +1941,87 @@ namespace dmGameObject
         transform.SetRotation(rotation);
         transform.SetScale(scale);
 
-        bool success = CollectionSpawnFromDescInternal(hcollection->m_Collection, (dmGameObjectDDF::CollectionDesc*)collection_desc, property_buffers, instances, transform);
+        bool success = CollectionSpawnFromDescInternal(hcollection->m_Collection, (dmGameObjectDDF::CollectionDesc*)collection_desc, property_buffers, instances, transform, 0);
 
         return success;
     }
 
+    bool SpawnFromCollectionDeferredInit(HCollection hcollection, HCollectionDesc collection_desc, InstancePropertyBuffers *property_buffers,
+                             const Point3& position, const Quat& rotation, const Vector3& scale, uint32_t init_time_budget,
+                             InstanceIdMap *instances, uint32_t* spawn_id)
+    {
+        Collection* collection = hcollection->m_Collection;
+        dmTransform::Transform transform;
+        transform.SetTranslation(Vector3(position));
+        transform.SetRotation(rotation);
+        transform.SetScale(scale);
+
+        // 0 is reserved for spawns that initialize immediately
+        if (++collection->m_DeferredSpawnCounter == 0)
+        {
+            collection->m_DeferredSpawnCounter = 1;
+        }
+        *spawn_id = collection->m_DeferredSpawnCounter;
+        collection->m_DeferredInitTimeBudget = init_time_budget;
+
+        return CollectionSpawnFromDescInternal(collection, (dmGameObjectDDF::CollectionDesc*)collection_desc, property_buffers, instances, transform, *spawn_id);
+    }
+
+    bool IsDeferredInitDone(HCollection hcollection, uint32_t spawn_id)
+    {
+        Collection* collection = hcollection->m_Collection;
+        const dmArray<DeferredInit>& inits = collection->m_DeferredInits;
+        for (uint32_t i = collection->m_DeferredInitHead; i < inits.Size(); ++i)
+        {
+            if (inits[i].m_SpawnId == spawn_id)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void UpdateDeferredInits(Collection* collection)
+    {
+        dmArray<DeferredInit>& inits = collection->m_DeferredInits;
+        if (collection->m_DeferredInitHead == inits.Size())
+        {
+            return;
+        }
+
+        DM_PROFILE(GameObject, "DeferredInit");
+        uint64_t start = dmTime::GetTime();
+        // At least one instance is initialized each update, so that the spawns always complete
+        while (collection->m_DeferredInitHead < inits.Size())
+        {
+            DeferredInit deferred = inits[collection->m_DeferredInitHead++];
+            HInstance instance = collection->m_Instances[deferred.m_Index];
+            // The instance might have been deleted before it was initialized
+            if (instance != 0x0 && instance->m_Identifier == deferred.m_Identifier && !instance->m_Initialized && !instance->m_ToBeDeleted)
+            {
+                if (InitInstance(collection, instance))
+                {
+                    AddToUpdate(collection, instance);
+                }
+                else
+                {
+                    dmLogError("Could not initialize %s when spawning.", dmHashReverseSafe64(deferred.m_Identifier));
+                    Delete(collection, instance, false);
+                }
+            }
+            if (dmTime::GetTime() - start >= collection->m_DeferredInitTimeBudget)
+            {
+                break;
+            }
+        }
+
+        if (collection->m_DeferredInitHead == inits.Size())
+        {
+            inits.SetSize(0);
+            collection->m_DeferredInitHead = 0;
+        }
+    }
+
     HInstance Spawn(HCollection hcollection, HPrototype proto, const char* prototype_name, dmhash_t id, uint8_t* property_buffer, uint32_t property_buffer_size, const Point3& position, const Quat& rotation, const Vector3& scale)
     {
         if (proto == 0x0) {
@@ -1438,7 +2064,7 @@ namespace dmGameObject
                 index = collection->m_Instances[index]->m_SiblingIndex;
             }
             instance->m_SiblingIndex = INVALID_INSTANCE_INDEX;
-            instance->m_Parent = INVALID_INSTANCE_INDEX;
+            SetParentIndex(instance, INVALID_INSTANCE_INDEX);
         }
     }
 
@@ -1556,23 +2182,24 @@ namespace dmGameObject
             assert(collection->m_Instances[instance->m_Index] == instance);
 
             // Update world transforms since some components might need them in their init-callback
-            Matrix4* trans = &collection->m_WorldTransforms[instance->m_Index];
+            Matrix4 trans;
             if (instance->m_Parent == INVALID_INSTANCE_INDEX)
             {
-                *trans = dmTransform::ToMatrix4(instance->m_Transform);
+                trans = dmTransform::ToMatrix4(GetLocalTransform(instance));
             }
             else
             {
                 const Matrix4* parent_trans = &collection->m_WorldTransforms[instance->m_Parent];
                 if (instance->m_ScaleAlongZ)
                 {
-                    *trans = (*parent_trans) * dmTransform::ToMatrix4(instance->m_Transform);
+                    trans = (*parent_trans) * dmTransform::ToMatrix4(GetLocalTransform(instance));
                 }
                 else
                 {
-                    *trans = dmTransform::MulNoScaleZ(*parent_trans, dmTransform::ToMatrix4(instance->m_Transform));
+                    trans = dmTransform::MulNoScaleZ(*parent_trans, dmTransform::ToMatrix4(GetLocalTransform(instance)));
                 }
             }
+            SetWorldTransform(collection, instance->m_Index, trans);
             return InitComponents(collection, instance);
         }
 
@@ -1587,23 +2214,43 @@ namespace dmGameObject
         return collection->m_Initialized;
     }
 
-    static bool InitCollection(Collection* collection)
+    static bool InitCollectionIncremental(Collection* collection, uint32_t time_budget, bool* done)
     {
         DM_PROFILE(GameObject, "Init");
         assert(collection->m_InUpdate == 0 && "Initializing instances during Update(.) is not permitted");
 
-        // Update transform cache
-        UpdateTransforms(collection);
+        if (collection->m_IncrementalState != INCREMENTAL_STATE_INIT)
+        {
+            // Update transform cache
+            UpdateTransforms(collection);
+
+            collection->m_IncrementalState = INCREMENTAL_STATE_INIT;
+            collection->m_IncrementalIndex = 0;
+            collection->m_IncrementalCount = collection->m_InstanceIndices.Size();
+            collection->m_IncrementalFailed = 0;
+        }
 
-        bool result = true;
         // Update scripts
-        uint32_t count = collection->m_InstanceIndices.Size();
-        for (uint32_t i = 0; i < count; ++i) {
-            Instance* instance = collection->m_Instances[i];
+        uint64_t start = dmTime::GetTime();
+        uint32_t count = collection->m_IncrementalCount;
+        while (collection->m_IncrementalIndex < count)
+        {
+            Instance* instance = collection->m_Instances[collection->m_IncrementalIndex++];
+            if (instance == 0x0)
+                continue;
             if (!InitInstance(collection, instance)) {
-                result = false;
+                collection->m_IncrementalFailed = 1;
             }
+            if (dmTime::GetTime() - start >= time_budget)
+                break;
         }
+
+        *done = collection->m_IncrementalIndex == count;
+        if (!*done)
+            return !collection->m_IncrementalFailed;
+
+        bool result = !collection->m_IncrementalFailed;
+        collection->m_IncrementalState = INCREMENTAL_STATE_NONE;
         for (uint32_t i = 0; i < count; ++i) {
             Instance* instance = collection->m_Instances[i];
             if (!DoAddToUpdate(collection, instance)) {
@@ -1618,11 +2265,22 @@ namespace dmGameObject
         return result;
     }
 
+    static bool InitCollection(Collection* collection)
+    {
+        bool done;
+        return InitCollectionIncremental(collection, 0xFFFFFFFF, &done);
+    }
+
     bool Init(HCollection hcollection)
     {
         return InitCollection(hcollection->m_Collection);
     }
 
+    bool InitIncremental(HCollection hcollection, uint32_t time_budget, bool* done)
+    {
+        return InitCollectionIncremental(hcollection->m_Collection, time_budget, done);
+    }
+
     static bool FinalComponents(Collection* collection, HInstance instance)
     {
         uint32_t next_component_instance_data = 0;
@@ -1674,24 +2332,47 @@ namespace dmGameObject
         return true;
     }
 
-    static bool FinalCollection(Collection* collection)
+    static bool FinalCollectionIncremental(Collection* collection, uint32_t time_budget, bool* done)
     {
         DM_PROFILE(GameObject, "Final");
         assert(collection->m_InUpdate == 0 && "Finalizing instances during Update(.) is not permitted");
 
-        bool result = true;
+        // Instances not yet initialized by an incremental init are skipped below
+        if (collection->m_IncrementalState != INCREMENTAL_STATE_FINAL)
+        {
+            collection->m_IncrementalState = INCREMENTAL_STATE_FINAL;
+            collection->m_IncrementalIndex = 0;
+            collection->m_IncrementalFailed = 0;
+        }
+
+        uint64_t start = dmTime::GetTime();
         uint32_t n_objects = collection->m_Instances.Size();
-        for (uint32_t i = 0; i < n_objects; ++i)
+        while (collection->m_IncrementalIndex < n_objects)
         {
-            Instance* instance = collection->m_Instances[i];
-            if (instance != 0x0 && instance->m_Initialized && ! FinalInstance(collection, instance))
+            Instance* instance = collection->m_Instances[collection->m_IncrementalIndex++];
+            if (instance == 0x0 || !instance->m_Initialized)
+                continue;
+            if (!FinalInstance(collection, instance))
             {
-                result = false;
+                collection->m_IncrementalFailed = 1;
             }
+            if (dmTime::GetTime() - start >= time_budget)
+                break;
         }
 
-        collection->m_Initialized = 0;
-        return result;
+        *done = collection->m_IncrementalIndex == n_objects;
+        if (*done)
+        {
+            collection->m_IncrementalState = INCREMENTAL_STATE_NONE;
+            collection->m_Initialized = 0;
+        }
+        return !collection->m_IncrementalFailed;
+    }
+
+    static bool FinalCollection(Collection* collection)
+    {
+        bool done;
+        return FinalCollectionIncremental(collection, 0xFFFFFFFF, &done);
     }
 
     bool Final(HCollection hcollection)
@@ -1699,6 +2380,42 @@ namespace dmGameObject
         return FinalCollection(hcollection->m_Collection);
     }
 
+    bool FinalIncremental(HCollection hcollection, uint32_t time_budget, bool* done)
+    {
+        return FinalCollectionIncremental(hcollection->m_Collection, time_budget, done);
+    }
+
+    void DeleteIncremental(HCollection hcollection, uint32_t time_budget, bool* done)
+    {
+        DM_PROFILE(GameObject, "DeleteIncremental");
+        Collection* collection = hcollection->m_Collection;
+        assert(collection->m_InUpdate == 0 && "Deleting instances during Update(.) is not permitted");
+
+        if (collection->m_IncrementalState != INCREMENTAL_STATE_DELETE)
+        {
+            collection->m_IncrementalState = INCREMENTAL_STATE_DELETE;
+            collection->m_IncrementalIndex = 0;
+        }
+
+        uint64_t start = dmTime::GetTime();
+        uint32_t n_objects = collection->m_Instances.Size();
+        while (collection->m_IncrementalIndex < n_objects)
+        {
+            Instance* instance = collection->m_Instances[collection->m_IncrementalIndex++];
+            if (instance == 0x0)
+                continue;
+            DoDeleteInstance(collection, instance);
+            if (dmTime::GetTime() - start >= time_budget)
+                break;
+        }
+
+        *done = collection->m_IncrementalIndex == n_objects;
+        if (*done)
+        {
+            collection->m_IncrementalState = INCREMENTAL_STATE_NONE;
+        }
+    }
+
     void Delete(Collection* collection, HInstance instance, bool recursive)
     {
         assert(collection->m_Instances[instance->m_Index] == instance);
@@ -1729,8 +2446,8 @@ namespace dmGameObject
         // Delete instance
         instance->m_ToBeDeleted = 1;
 
-        uint16_t index = instance->m_Index;
-        uint16_t tail = collection->m_InstancesToDeleteTail;
+        InstanceIndex index = instance->m_Index;
+        InstanceIndex tail = collection->m_InstancesToDeleteTail;
         if (tail != INVALID_INSTANCE_INDEX) {
             HInstance tail_instance = collection->m_Instances[tail];
             tail_instance->m_NextToDelete = index;
@@ -1747,10 +2464,10 @@ namespace dmGameObject
 
     static void RemoveFromAddToUpdate(Collection* collection, HInstance instance)
     {
-        uint16_t index = instance->m_Index;
+        InstanceIndex index = instance->m_Index;
         assert(collection->m_InstancesToAddTail == index || instance->m_NextToAdd != INVALID_INSTANCE_INDEX);
-        uint16_t* prev_index_ptr = &collection->m_InstancesToAddHead;
-        uint16_t prev_index = *prev_index_ptr;
+        InstanceIndex* prev_index_ptr = &collection->m_InstancesToAddHead;
+        InstanceIndex prev_index = *prev_index_ptr;
         while (prev_index != index) {
             prev_index_ptr = &collection->m_Instances[prev_index]->m_NextToAdd;
             if (collection->m_InstancesToAddTail == *prev_index_ptr) {
@@ -1766,41 +2483,15 @@ namespace dmGameObject
         instance->m_ToBeAdded = 0;
     }
 
-    static void DoDeleteInstance(Collection* collection, HInstance instance)
+    static void ReparentChildren(Collection* collection, HInstance instance)
     {
-        DM_PROFILE(GameObject, "DoDeleteInstance");
-        HCollection hcollection = collection->m_HCollection;
-        CancelAnimations(hcollection, instance);
-        if (instance->m_ToBeAdded) {
-            RemoveFromAddToUpdate(collection, instance);
-        }
-        dmResource::HFactory factory = collection->m_Factory;
-        Prototype* prototype = instance->m_Prototype;
-        DestroyComponents(collection, instance);
-
-        dmHashRelease64(&instance->m_CollectionPathHashState);
-        if(instance->m_Generated)
-        {
-            dmHashReverseErase64(instance->m_Identifier);
-        }
-
-        if (instance->m_IdentifierIndex < collection->m_MaxInstances)
-        {
-            // The identifier (hash) for this gameobject comes from the pool!
-            ReleaseInstanceIndex(instance->m_IdentifierIndex, hcollection);
-        }
-        ReleaseIdentifier(collection, instance);
-
-        assert(collection->m_LevelIndices[instance->m_Depth].Size() > 0);
-        assert(instance->m_LevelIndex < collection->m_LevelIndices[instance->m_Depth].Size());
-
         // Reparent child nodes
         uint32_t index = instance->m_FirstChildIndex;
         while (index != INVALID_INSTANCE_INDEX)
         {
             Instance* child = collection->m_Instances[index];
             assert(child->m_Parent == instance->m_Index);
-            child->m_Parent = instance->m_Parent;
+            SetParentIndex(child, instance->m_Parent);
             index = collection->m_Instances[index]->m_SiblingIndex;
         }
 
@@ -1828,6 +2519,38 @@ namespace dmGameObject
                 parent->m_FirstChildIndex = instance->m_FirstChildIndex;
             }
         }
+    }
+
+    static void DoDeleteInstance(Collection* collection, HInstance instance)
+    {
+        DM_PROFILE(GameObject, "DoDeleteInstance");
+        HCollection hcollection = collection->m_HCollection;
+        CancelAnimations(hcollection, instance);
+        if (instance->m_ToBeAdded) {
+            RemoveFromAddToUpdate(collection, instance);
+        }
+        dmAtomicStore32(&collection->m_Register->m_Changed, 1);
+        dmResource::HFactory factory = collection->m_Factory;
+        Prototype* prototype = instance->m_Prototype;
+        DestroyComponents(collection, instance);
+
+        ReleaseCollectionPath(collection, instance);
+        if(instance->m_Generated)
+        {
+            dmHashReverseErase64(instance->m_Identifier);
+        }
+
+        if (instance->m_IdentifierIndex < collection->m_MaxInstances)
+        {
+            // The identifier (hash) for this gameobject comes from the pool!
+            ReleaseInstanceIndex(instance->m_IdentifierIndex, hcollection);
+        }
+        ReleaseIdentifier(collection, instance);
+
+        assert(collection->m_LevelIndices[instance->m_Depth].Size() > 0);
+        assert(instance->m_LevelIndex < collection->m_LevelIndices[instance->m_Depth].Size());
+
+        ReparentChildren(collection, instance);
 
         // Unlink "me" from parent
         Unlink(collection, instance);
@@ -1837,6 +2560,7 @@ namespace dmGameObject
         if (prototype != &EMPTY_PROTOTYPE)
             dmResource::Release(factory, prototype);
         collection->m_InstanceIndices.Push(instance->m_Index);
+        RemoveFromSpatialIndex(collection, instance->m_Index);
         collection->m_Instances[instance->m_Index] = 0;
 
         // Erase from input stack
@@ -1859,10 +2583,192 @@ namespace dmGameObject
         {
             collection->m_InputFocusStack.Pop();
         }
-
-        DeallocInstance(instance);
+
+        DeallocInstance(collection, instance);
+
+        assert(collection->m_IDToInstance.Size() <= collection->m_InstanceIndices.Size());
+    }
+
+    struct ComponentToDestroyPred
+    {
+        bool operator()(const ComponentToDestroy& a, const ComponentToDestroy& b) const
+        {
+            return a.m_TypeIndex < b.m_TypeIndex;
+        }
+    };
+
+    static void DestroyComponents(Collection* collection, dmArray<Instance*>& instances)
+    {
+        DM_PROFILE(GameObject, "DestroyComponents");
+
+        dmArray<ComponentToDestroy>& components = collection->m_ComponentsToDestroy;
+        components.SetSize(0);
+        for (uint32_t i = 0; i < instances.Size(); ++i)
+        {
+            Instance* instance = instances[i];
+            HPrototype prototype = instance->m_Prototype;
+            uint32_t next_component_instance_data = 0;
+            for (uint32_t j = 0; j < prototype->m_ComponentCount; ++j)
+            {
+                Prototype::Component* component = &prototype->m_Components[j];
+                ComponentToDestroy c;
+                c.m_Instance = instance;
+                c.m_UserData = 0;
+                c.m_TypeIndex = component->m_TypeIndex;
+                if (component->m_Type->m_InstanceHasUserData)
+                {
+                    c.m_UserData = &instance->m_ComponentInstanceUserData[next_component_instance_data++];
+                }
+                assert(next_component_instance_data <= instance->m_ComponentInstanceUserDataCount);
+                if (components.Full())
+                    components.OffsetCapacity(dmMath::Max(64U, components.Capacity() / 2));
+                components.Push(c);
+            }
+        }
+
+        // Destroy the components one type at a time, in the order the instances were deleted
+        std::stable_sort(components.Begin(), components.End(), ComponentToDestroyPred());
+
+        HRegister regist = collection->m_Register;
+        uint32_t count = components.Size();
+        uint32_t start = 0;
+        while (start < count)
+        {
+            uint16_t type_index = components[start].m_TypeIndex;
+            ComponentType* component_type = &regist->m_ComponentTypes[type_index];
+            DM_PROFILE_DYN(GameObjectDestroyComponents, component_type->m_Name, component_type->m_NameHash);
+
+            ComponentDestroyParams params;
+            params.m_Collection = collection->m_HCollection;
+            params.m_World = collection->m_ComponentWorlds[type_index];
+            params.m_Context = component_type->m_Context;
+
+            uint32_t end = start;
+            while (end < count && components[end].m_TypeIndex == type_index)
+            {
+                params.m_Instance = components[end].m_Instance;
+                params.m_UserData = components[end].m_UserData;
+                component_type->m_DestroyFunction(params);
+                ++end;
+            }
+            collection->m_ComponentInstanceCount[type_index] -= end - start;
+            start = end;
+        }
+        components.SetSize(0);
+    }
+
+    /*
+     * Delete all instances in the deletion list starting at head, in bulk.
+     * Same as calling DoDeleteInstance for each instance in list order, except that
+     * the components are destroyed one type at a time and the level index arrays are compacted
+     * once per level, instead of one erase-swap per instance.
+     */
+    static uint32_t DoDeleteInstances(Collection* collection, InstanceIndex head)
+    {
+        DM_PROFILE(GameObject, "DoDeleteInstances");
+        HCollection hcollection = collection->m_HCollection;
+        dmResource::HFactory factory = collection->m_Factory;
+
+        dmArray<Instance*>& batch = collection->m_DeleteBatch;
+        batch.SetSize(0);
+        InstanceIndex index = head;
+        while (index != INVALID_INSTANCE_INDEX)
+        {
+            Instance* instance = collection->m_Instances[index];
+            assert(collection->m_Instances[instance->m_Index] == instance);
+            assert(instance->m_ToBeDeleted);
+            index = instance->m_NextToDelete;
+
+            CancelAnimations(hcollection, instance);
+            if (instance->m_ToBeAdded) {
+                RemoveFromAddToUpdate(collection, instance);
+            }
+            instance->m_InDeleteBatch = 1;
+            if (batch.Full())
+                batch.OffsetCapacity(dmMath::Max(16U, batch.Capacity() / 2));
+            batch.Push(instance);
+        }
+        uint32_t batch_size = batch.Size();
+        if (batch_size == 0)
+            return 0;
+
+        dmAtomicStore32(&collection->m_Register->m_Changed, 1);
+        DestroyComponents(collection, batch);
+
+        for (uint32_t i = 0; i < batch_size; ++i)
+        {
+            Instance* instance = batch[i];
+            ReleaseCollectionPath(collection, instance);
+            if(instance->m_Generated)
+            {
+                dmHashReverseErase64(instance->m_Identifier);
+            }
+            if (instance->m_IdentifierIndex < collection->m_MaxInstances)
+            {
+                ReleaseInstanceIndex(instance->m_IdentifierIndex, hcollection);
+            }
+            ReleaseIdentifier(collection, instance);
+
+            // The instance is left in its level index array, MoveAllUp only erase-swaps the surviving children
+            ReparentChildren(collection, instance);
+            Unlink(collection, instance);
+            MoveAllUp(collection, instance);
+
+            Prototype* prototype = instance->m_Prototype;
+            if (prototype != &EMPTY_PROTOTYPE)
+                dmResource::Release(factory, prototype);
+            collection->m_InstanceIndices.Push(instance->m_Index);
+            RemoveFromSpatialIndex(collection, instance->m_Index);
+        }
+
+        // Compact each level holding deleted instances in a single pass.
+        // The depths are read after all instances are unlinked, since MoveAllUp might have moved deleted instances as well
+        bool levels[MAX_HIERARCHICAL_DEPTH];
+        memset(levels, 0, sizeof(levels));
+        for (uint32_t i = 0; i < batch_size; ++i)
+        {
+            levels[batch[i]->m_Depth] = true;
+        }
+        for (uint32_t depth = 0; depth < MAX_HIERARCHICAL_DEPTH; ++depth)
+        {
+            if (!levels[depth])
+                continue;
+            dmArray<InstanceIndex>& level = collection->m_LevelIndices[depth];
+            uint32_t level_size = level.Size();
+            uint32_t kept = 0;
+            for (uint32_t i = 0; i < level_size; ++i)
+            {
+                InstanceIndex instance_index = level[i];
+                Instance* instance = collection->m_Instances[instance_index];
+                if (instance->m_InDeleteBatch)
+                    continue;
+                level[kept] = instance_index;
+                instance->m_LevelIndex = kept;
+                ++kept;
+            }
+            level.SetSize(kept);
+        }
+
+        // Erase from input stack, keeping the order of the remaining instances
+        dmArray<Instance*>& focus_stack = collection->m_InputFocusStack;
+        uint32_t focus_count = 0;
+        for (uint32_t i = 0; i < focus_stack.Size(); ++i)
+        {
+            if (!focus_stack[i]->m_InDeleteBatch)
+                focus_stack[focus_count++] = focus_stack[i];
+        }
+        focus_stack.SetSize(focus_count);
+
+        for (uint32_t i = 0; i < batch_size; ++i)
+        {
+            Instance* instance = batch[i];
+            collection->m_Instances[instance->m_Index] = 0;
+            DeallocInstance(collection, instance);
+        }
+        batch.SetSize(0);
 
         assert(collection->m_IDToInstance.Size() <= collection->m_InstanceIndices.Size());
+        return batch_size;
     }
 
     void DeleteAll(HCollection hcollection)
@@ -1903,9 +2809,13 @@ namespace dmGameObject
         }
         else
         {
+            if (instance->m_CollectionPathIndex == INVALID_COLLECTION_PATH_INDEX)
+            {
+                return dmHashBuffer64(id, id_size);
+            }
             // Make a copy of the state.
             HashState64 tmp_state;
-            dmHashClone64(&tmp_state, &instance->m_CollectionPathHashState, false);
+            dmHashClone64(&tmp_state, &instance->m_Collection->m_CollectionPaths[instance->m_CollectionPathIndex].m_State, false);
             dmHashUpdateBuffer64(&tmp_state, id, id_size);
             return dmHashFinal64(&tmp_state);
         }
@@ -1951,6 +2861,11 @@ namespace dmGameObject
         return RESULT_COMPONENT_NOT_FOUND;
     }
 
+    uint32_t GetWorldTransformVersion(HInstance instance)
+    {
+        return instance->m_Collection->m_WorldTransformVersions[instance->m_Index];
+    }
+
     bool ScaleAlongZ(HInstance instance)
     {
         return instance->m_ScaleAlongZ != 0;
@@ -1971,11 +2886,11 @@ namespace dmGameObject
         return instance->m_Bone;
     }
 
-    static uint32_t DoSetBoneTransforms(HCollection hcollection, dmTransform::Transform* component_transform, uint16_t first_index, dmTransform::Transform* transforms, uint32_t transform_count)
+    static uint32_t DoSetBoneTransforms(HCollection hcollection, dmTransform::Transform* component_transform, InstanceIndex first_index, dmTransform::Transform* transforms, uint32_t transform_count)
     {
         if (transform_count == 0)
             return 0;
-        uint16_t current_index = first_index;
+        InstanceIndex current_index = first_index;
         uint32_t count = 0;
         Collection* collection = hcollection->m_Collection;
         while (current_index != INVALID_INSTANCE_INDEX)
@@ -1983,10 +2898,11 @@ namespace dmGameObject
             HInstance instance = collection->m_Instances[current_index];
             if (instance->m_Bone)
             {
-                instance->m_Transform = transforms[count++];
+                GetLocalTransform(instance) = transforms[count++];
                 if (component_transform && count == 1) {
-                    instance->m_Transform = dmTransform::Mul(*component_transform, instance->m_Transform);
+                    GetLocalTransform(instance) = dmTransform::Mul(*component_transform, GetLocalTransform(instance));
                 }
+                SetTransformDirty(instance);
                 if (count < transform_count)
                 {
                     count += DoSetBoneTransforms(hcollection, 0x0, instance->m_FirstChildIndex, &transforms[count], transform_count - count);
@@ -2006,8 +2922,8 @@ namespace dmGameObject
         return DoSetBoneTransforms(instance->m_Collection->m_HCollection, &component_transform, instance->m_Index, transforms, transform_count);
     }
 
-    static void DeleteBones(Collection* collection, uint16_t first_index) {
-        uint16_t current_index = first_index;
+    static void DeleteBones(Collection* collection, InstanceIndex first_index) {
+        InstanceIndex current_index = first_index;
         while (current_index != INVALID_INSTANCE_INDEX) {
             HInstance instance = collection->m_Instances[current_index];
             if (instance->m_Bone && instance->m_ToBeDeleted == 0) {
@@ -2035,6 +2951,8 @@ namespace dmGameObject
         Collection* collection = context->m_Collection;
 
         Instance* instance = 0x0;
+        MessageReceiver* receiver = 0x0;
+        uint16_t component_index = INVALID_COMPONENT_INDEX;
         // Start by looking for the instance in the user-data,
         // which is the case when an instance sends to itself.
         if (message->m_UserData1 != 0
@@ -2049,7 +2967,19 @@ namespace dmGameObject
         }
         if (instance == 0x0)
         {
-            instance = GetInstanceFromIdentifier(context->m_Collection, message->m_Receiver.m_Path);
+            dmhash_t path = message->m_Receiver.m_Path;
+            dmhash_t fragment = message->m_Receiver.m_Fragment;
+            receiver = &collection->m_MessageReceiverCache[(uint32_t)(path ^ fragment) & (MESSAGE_RECEIVER_CACHE_SIZE - 1)];
+            if (receiver->m_Generation == collection->m_MessageReceiverGeneration && receiver->m_Path == path && receiver->m_Fragment == fragment)
+            {
+                instance = receiver->m_Instance;
+                component_index = receiver->m_ComponentIndex;
+                receiver = 0x0;
+            }
+            else
+            {
+                instance = GetInstanceFromIdentifier(context->m_Collection, path);
+            }
         }
         if (instance == 0x0)
         {
@@ -2123,27 +3053,27 @@ namespace dmGameObject
 
                 if (sp->m_KeepWorldTransform == 0)
                 {
-                    Matrix4& world = collection->m_WorldTransforms[instance->m_Index];
                     if (instance->m_ScaleAlongZ)
                     {
-                        world = parent_t * dmTransform::ToMatrix4(instance->m_Transform);
+                        SetWorldTransform(collection, instance->m_Index, parent_t * dmTransform::ToMatrix4(GetLocalTransform(instance)));
                     }
                     else
                     {
-                        world = dmTransform::MulNoScaleZ(parent_t, dmTransform::ToMatrix4(instance->m_Transform));
+                        SetWorldTransform(collection, instance->m_Index, dmTransform::MulNoScaleZ(parent_t, dmTransform::ToMatrix4(GetLocalTransform(instance))));
                     }
                 }
                 else
                 {
                     if (instance->m_ScaleAlongZ)
                     {
-                        instance->m_Transform = dmTransform::ToTransform(inverse(parent_t) * collection->m_WorldTransforms[instance->m_Index]);
+                        GetLocalTransform(instance) = dmTransform::ToTransform(inverse(parent_t) * collection->m_WorldTransforms[instance->m_Index]);
                     }
                     else
                     {
                         Matrix4 tmp = dmTransform::MulNoScaleZ(inverse(parent_t), collection->m_WorldTransforms[instance->m_Index]);
-                        instance->m_Transform = dmTransform::ToTransform(tmp);
+                        GetLocalTransform(instance) = dmTransform::ToTransform(tmp);
                     }
+                    SetTransformDirty(instance);
                 }
 
                 dmGameObject::Result result = dmGameObject::SetParent(instance, parent);
@@ -2158,9 +3088,8 @@ namespace dmGameObject
         }
         Prototype* prototype = instance->m_Prototype;
 
-        if (message->m_Receiver.m_Fragment != 0)
+        if (message->m_Receiver.m_Fragment != 0 && component_index == INVALID_COMPONENT_INDEX)
         {
-            uint16_t component_index;
             Result result = GetComponentIndex(instance, message->m_Receiver.m_Fragment, &component_index);
             if (result != RESULT_OK)
             {
@@ -2177,6 +3106,18 @@ namespace dmGameObject
                 context->m_Success = false;
                 return;
             }
+        }
+        if (receiver != 0x0)
+        {
+            receiver->m_Path = message->m_Receiver.m_Path;
+            receiver->m_Fragment = message->m_Receiver.m_Fragment;
+            receiver->m_Instance = instance;
+            receiver->m_Generation = collection->m_MessageReceiverGeneration;
+            receiver->m_ComponentIndex = component_index;
+        }
+
+        if (message->m_Receiver.m_Fragment != 0)
+        {
             Prototype::Component* component = &prototype->m_Components[component_index];
             ComponentType* component_type = component->m_Type;
             assert(component_type);
@@ -2285,6 +3226,8 @@ namespace dmGameObject
                 uint32_t message_count = dmMessage::Dispatch(sockets[i], &DispatchMessagesFunction, (void*) &ctx);
                 if (message_count)
                 {
+                    // Messages may change anything, e.g. play an animation or change a text
+                    dmAtomicStore32(&collection->m_Register->m_Changed, 1);
                     collection->m_DirtyTransforms = true;
                     iterate = true;
                 }
@@ -2295,84 +3238,134 @@ namespace dmGameObject
         return ctx.m_Success;
     }
 
-    static void UpdateEulerToRotation(HInstance instance);
-
     static inline bool Vec3Equals(const uint32_t* a, const uint32_t* b)
     {
         return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
     }
 
-    static void CheckEuler(Instance* instance)
+    static inline void CheckEuler(Collection* collection, InstanceIndex index)
     {
-        Vector3& euler = instance->m_EulerRotation;
-        Vector3& prev_euler = instance->m_PrevEulerRotation;
+        Vector3& euler = collection->m_EulerRotations[index];
+        Vector3& prev_euler = collection->m_PrevEulerRotations[index];
         if (!Vec3Equals((uint32_t*)(&euler), (uint32_t*)(&prev_euler)))
         {
-            UpdateEulerToRotation(instance);
+            prev_euler = euler;
+            collection->m_LocalTransforms[index].SetRotation(dmVMath::EulerToQuat(euler));
         }
     }
 
-    void UpdateTransforms(Collection* collection)
+    // Levels smaller than this are updated on the calling thread
+    static const uint32_t TRANSFORMS_JOB_BATCH_SIZE = 256;
+
+    struct UpdateTransformsContext
     {
-        DM_PROFILE(GameObject, "UpdateTransforms");
+        Collection*          m_Collection;
+        const InstanceIndex* m_Level;
+    };
 
-        // Calculate world transforms
-        // First root-level instances
-        dmArray<uint16_t>& root_level = collection->m_LevelIndices[0];
-        uint32_t root_count = root_level.Size();
-        for (uint32_t i = 0; i < root_count; ++i)
+    static void UpdateRootTransforms(void* _ctx, uint32_t start, uint32_t end)
+    {
+        UpdateTransformsContext* ctx = (UpdateTransformsContext*) _ctx;
+        Collection* collection = ctx->m_Collection;
+        const dmTransform::Transform* local_transforms = collection->m_LocalTransforms.Begin();
+        uint8_t* flags = collection->m_TransformFlags.Begin();
+        bool changed = false;
+        for (uint32_t i = start; i < end; ++i)
         {
-            uint16_t index = root_level[i];
-            Instance* instance = collection->m_Instances[index];
-            CheckEuler(instance);
-            collection->m_WorldTransforms[index] = dmTransform::ToMatrix4(instance->m_Transform);
-            uint16_t parent_index = instance->m_Parent;
-            assert(parent_index == INVALID_INSTANCE_INDEX);
+            InstanceIndex index = ctx->m_Level[i];
+            assert(collection->m_ParentIndices[index] == INVALID_INSTANCE_INDEX);
+            if ((flags[index] & TRANSFORM_FLAG_DIRTY) == 0)
+            {
+                flags[index] = 0;
+                continue;
+            }
+            CheckEuler(collection, index);
+            SetWorldTransform(collection, index, dmTransform::ToMatrix4(local_transforms[index]));
+            flags[index] = TRANSFORM_FLAG_CHANGED;
+            changed = true;
+        }
+        if (changed)
+            dmAtomicStore32(&collection->m_Register->m_Changed, 1);
+    }
+
+    template <bool SCALE_ALONG_Z>
+    static void UpdateChildTransforms(void* _ctx, uint32_t start, uint32_t end)
+    {
+        UpdateTransformsContext* ctx = (UpdateTransformsContext*) _ctx;
+        Collection* collection = ctx->m_Collection;
+        const dmTransform::Transform* local_transforms = collection->m_LocalTransforms.Begin();
+        const InstanceIndex* parent_indices = collection->m_ParentIndices.Begin();
+        const Matrix4* world_transforms = collection->m_WorldTransforms.Begin();
+        uint8_t* flags = collection->m_TransformFlags.Begin();
+        bool changed = false;
+        for (uint32_t i = start; i < end; ++i)
+        {
+            InstanceIndex index = ctx->m_Level[i];
+            InstanceIndex parent_index = parent_indices[index];
+            assert(parent_index != INVALID_INSTANCE_INDEX);
+
+            // The parent level is already done, so its flags tell if the parent moved in this update
+            if ((flags[index] & TRANSFORM_FLAG_DIRTY) == 0 && (flags[parent_index] & TRANSFORM_FLAG_CHANGED) == 0)
+            {
+                flags[index] = 0;
+                continue;
+            }
+
+            CheckEuler(collection, index);
+            Matrix4 own = dmTransform::ToMatrix4(local_transforms[index]);
+            if (SCALE_ALONG_Z)
+                SetWorldTransform(collection, index, world_transforms[parent_index] * own);
+            else
+                SetWorldTransform(collection, index, dmTransform::MulNoScaleZ(world_transforms[parent_index], own));
+            flags[index] = TRANSFORM_FLAG_CHANGED;
+            changed = true;
         }
+        if (changed)
+            dmAtomicStore32(&collection->m_Register->m_Changed, 1);
+    }
 
+    static void UpdateLevelTransforms(Collection* collection, uint32_t level_i, dmJob::RangeFunc func)
+    {
+        dmArray<InstanceIndex>& level = collection->m_LevelIndices[level_i];
+        uint32_t instance_count = level.Size();
+        if (instance_count == 0)
+            return;
 
-        if (collection->m_ScaleAlongZ) {
-            for (uint32_t level_i = 1; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
-            {
-                dmArray<uint16_t>& level = collection->m_LevelIndices[level_i];
-                uint32_t instance_count = level.Size();
-                for (uint32_t i = 0; i < instance_count; ++i)
-                {
-                    uint16_t index = level[i];
-                    Instance* instance = collection->m_Instances[index];
-                    CheckEuler(instance);
-                    Matrix4* trans = &collection->m_WorldTransforms[index];
+        UpdateTransformsContext ctx;
+        ctx.m_Collection = collection;
+        ctx.m_Level = level.Begin();
+
+        // The instances within a level only depend on the previous level, so each level can be split
+        // into independent batches. The level must be complete before the next one is started.
+        dmJob::HContext job_context = collection->m_Register->m_JobContext;
+        if (job_context == 0 || instance_count < TRANSFORMS_JOB_BATCH_SIZE * 2)
+        {
+            func(&ctx, 0, instance_count);
+            return;
+        }
 
-                    uint16_t parent_index = instance->m_Parent;
-                    assert(parent_index != INVALID_INSTANCE_INDEX);
+        dmJob::HJob job = dmJob::ParallelFor(job_context, func, &ctx, instance_count, TRANSFORMS_JOB_BATCH_SIZE, dmJob::INVALID_JOB);
+        dmJob::Wait(job_context, job);
+    }
 
-                    Matrix4* parent_trans = &collection->m_WorldTransforms[parent_index];
-                    Matrix4 own = dmTransform::ToMatrix4(instance->m_Transform);
-                    *trans = *parent_trans * own;
-                }
-            }
-        } else {
-            for (uint32_t level_i = 1; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
-            {
-                dmArray<uint16_t>& level = collection->m_LevelIndices[level_i];
-                uint32_t instance_count = level.Size();
-                for (uint32_t i = 0; i < instance_count; ++i)
-                {
-                    uint16_t index = level[i];
-                    Instance* instance = collection->m_Instances[index];
-                    CheckEuler(instance);
-                    Matrix4* trans = &collection->m_WorldTransforms[index];
+    void UpdateTransforms(Collection* collection)
+    {
+        DM_PROFILE(GameObject, "UpdateTransforms");
 
-                    uint16_t parent_index = instance->m_Parent;
-                    assert(parent_index != INVALID_INSTANCE_INDEX);
+        // Calculate world transforms
+        // First root-level instances
+        UpdateLevelTransforms(collection, 0, UpdateRootTransforms);
 
-                    Matrix4* parent_trans = &collection->m_WorldTransforms[parent_index];
-                    Matrix4 own = dmTransform::ToMatrix4(instance->m_Transform);
-                    *trans = dmTransform::MulNoScaleZ(*parent_trans, own);
-                }
-            }
+        dmJob::RangeFunc child_func = collection->m_ScaleAlongZ ? UpdateChildTransforms<true> : UpdateChildTransforms<false>;
+        for (uint32_t level_i = 1; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
+        {
+            if (collection->m_LevelIndices[level_i].Empty())
+                break; // Levels are filled from the root and down
+            UpdateLevelTransforms(collection, level_i, child_func);
         }
 
+        UpdateSpatialIndex(collection);
+
         collection->m_DirtyTransforms = false;
     }
 
@@ -2381,13 +3374,142 @@ namespace dmGameObject
         UpdateTransforms(hcollection->m_Collection);
     }
 
+    // Max number of component types updated concurrently on the job threads
+    static const uint32_t MAX_CONCURRENT_COMPONENT_UPDATES = 16;
+
+    // The update of a component type, run on a job thread when several component types are updated concurrently
+    struct ComponentUpdateJob
+    {
+        Collection*             m_Collection;
+        const UpdateContext*    m_UpdateContext;
+        ComponentsUpdateResult  m_UpdateResult;
+        UpdateResult            m_Result;
+        uint16_t                m_UpdateIndex;
+    };
+
+    static UpdateResult UpdateComponentType(Collection* collection, const UpdateContext* update_context, uint16_t update_index, ComponentsUpdateResult& update_result)
+    {
+        ComponentType* component_type = &collection->m_Register->m_ComponentTypes[update_index];
+        DM_PROFILE_DYN(GameObject, component_type->m_Name, component_type->m_NameHash);
+        ComponentsUpdateParams params;
+        params.m_Collection = collection->m_HCollection;
+        params.m_UpdateContext = update_context;
+        params.m_World = collection->m_ComponentWorlds[update_index];
+        params.m_Context = component_type->m_Context;
+
+        update_result.m_TransformsUpdated = false;
+        update_result.m_Changed = false;
+        return component_type->m_UpdateFunction(params, update_result);
+    }
+
+    static void ComponentUpdateJobFunc(void* context, void* data)
+    {
+        ComponentUpdateJob* job = (ComponentUpdateJob*) data;
+        job->m_Result = UpdateComponentType(job->m_Collection, job->m_UpdateContext, job->m_UpdateIndex, job->m_UpdateResult);
+    }
+
+    static bool CanUpdateConcurrently(const ComponentType* component_type)
+    {
+        const uint32_t main_thread_only = COMPONENT_UPDATE_DEPENDENCY_RESOURCES | COMPONENT_UPDATE_DEPENDENCY_LUA;
+        return component_type->m_UpdateFunction != 0 && component_type->m_HasUpdateDependencies &&
+               (component_type->m_UpdateDependencies & main_thread_only) == 0;
+    }
+
+    static bool ReadsTransforms(const ComponentType* component_type)
+    {
+        return component_type->m_ReadsTransforms || (component_type->m_UpdateDependencies & COMPONENT_UPDATE_DEPENDENCY_READS_TRANSFORMS);
+    }
+
+    // Returns the end of the batch of component types, in update order, starting at first that can be updated concurrently.
+    // Transforms written by one type must not be accessed by another, and the messages posted by a type must be dispatched
+    // before the next type is updated, so a type posting messages ends the batch.
+    static uint32_t GetUpdateBatchEnd(Register* regist, uint32_t first)
+    {
+        const uint32_t transforms = COMPONENT_UPDATE_DEPENDENCY_READS_TRANSFORMS | COMPONENT_UPDATE_DEPENDENCY_WRITES_TRANSFORMS;
+        const uint32_t writes = COMPONENT_UPDATE_DEPENDENCY_WRITES_TRANSFORMS;
+
+        uint32_t batch_dependencies = 0;
+        uint32_t end = first;
+        while (end < regist->m_ComponentTypeCount && end - first < MAX_CONCURRENT_COMPONENT_UPDATES)
+        {
+            const ComponentType* component_type = &regist->m_ComponentTypes[regist->m_ComponentTypesOrder[end]];
+            if (!CanUpdateConcurrently(component_type))
+                break;
+            uint32_t dependencies = component_type->m_UpdateDependencies;
+            if (((dependencies & writes) && (batch_dependencies & transforms)) || ((batch_dependencies & writes) && (dependencies & transforms)))
+                break;
+            batch_dependencies |= dependencies;
+            ++end;
+            if (dependencies & COMPONENT_UPDATE_DEPENDENCY_POSTS_MESSAGES)
+                break;
+        }
+        return end;
+    }
+
+    static bool UpdateComponentTypesConcurrently(Collection* collection, const UpdateContext* update_context, uint32_t first, uint32_t end)
+    {
+        DM_PROFILE(GameObject, "UpdateConcurrently");
+        Register* regist = collection->m_Register;
+        dmJob::HContext job_context = regist->m_JobContext;
+
+        bool reads_transforms = false;
+        for (uint32_t i = first; i < end; ++i)
+        {
+            reads_transforms |= ReadsTransforms(&regist->m_ComponentTypes[regist->m_ComponentTypesOrder[i]]);
+        }
+        if (reads_transforms && collection->m_DirtyTransforms) {
+            UpdateTransforms(collection);
+        }
+
+        ComponentUpdateJob jobs[MAX_CONCURRENT_COMPONENT_UPDATES];
+        dmJob::HJob group = dmJob::CreateGroup(job_context, dmJob::INVALID_JOB);
+        for (uint32_t i = first; i < end; ++i)
+        {
+            uint16_t update_index = regist->m_ComponentTypesOrder[i];
+            DM_COUNTER_DYN(regist->m_ComponentProfileCounterIndex[update_index], collection->m_ComponentInstanceCount[update_index]);
+
+            ComponentUpdateJob& job = jobs[i - first];
+            job.m_Collection = collection;
+            job.m_UpdateContext = update_context;
+            job.m_UpdateIndex = update_index;
+
+            dmJob::HJob handle = group != dmJob::INVALID_JOB ? dmJob::CreateJob(job_context, ComponentUpdateJobFunc, 0, &job, group) : dmJob::INVALID_JOB;
+            if (handle != dmJob::INVALID_JOB)
+                dmJob::Run(job_context, handle);
+            else
+                ComponentUpdateJobFunc(0, &job); // Out of jobs
+        }
+        if (group != dmJob::INVALID_JOB)
+        {
+            dmJob::Run(job_context, group);
+            dmJob::Wait(job_context, group);
+        }
+
+        bool ret = true;
+        for (uint32_t i = 0; i < end - first; ++i)
+        {
+            if (jobs[i].m_Result != UPDATE_RESULT_OK)
+                ret = false;
+            collection->m_DirtyTransforms |= jobs[i].m_UpdateResult.m_TransformsUpdated;
+            if (jobs[i].m_UpdateResult.m_Changed)
+                dmAtomicStore32(&regist->m_Changed, 1);
+        }
+
+        if (!DispatchMessages(collection, &collection->m_ComponentSocket, 1))
+            ret = false;
+        return ret;
+    }
+
     static bool Update(Collection* collection, const UpdateContext* update_context)
     {
         DM_PROFILE(GameObject, "Update");
+        DM_MEM_SCOPE(GameObject);
         DM_COUNTER("Instances", collection->m_InstanceIndices.Size());
 
         assert(collection != 0x0);
 
+        UpdateDeferredInits(collection);
+
         // Add to update
         DoAddToUpdate(collection);
 
@@ -2395,37 +3517,44 @@ namespace dmGameObject
 
         bool ret = true;
 
-        uint32_t component_types = collection->m_Register->m_ComponentTypeCount;
+        Register* regist = collection->m_Register;
+        bool concurrent = regist->m_JobContext != 0 && dmJob::GetWorkerCount(regist->m_JobContext) > 0;
+
+        uint32_t component_types = regist->m_ComponentTypeCount;
         for (uint32_t i = 0; i < component_types; ++i)
         {
-            uint16_t update_index = collection->m_Register->m_ComponentTypesOrder[i];
-            ComponentType* component_type = &collection->m_Register->m_ComponentTypes[update_index];
+            // Consecutive component types with non-conflicting dependencies are updated on the job threads
+            uint32_t batch_end = concurrent ? GetUpdateBatchEnd(regist, i) : i;
+            if (batch_end - i > 1)
+            {
+                if (!UpdateComponentTypesConcurrently(collection, update_context, i, batch_end))
+                    ret = false;
+                i = batch_end - 1;
+                continue;
+            }
 
-            DM_COUNTER_DYN(collection->m_Register->m_ComponentProfileCounterIndex[update_index], collection->m_ComponentInstanceCount[update_index]);
+            uint16_t update_index = regist->m_ComponentTypesOrder[i];
+            ComponentType* component_type = &regist->m_ComponentTypes[update_index];
+
+            DM_COUNTER_DYN(regist->m_ComponentProfileCounterIndex[update_index], collection->m_ComponentInstanceCount[update_index]);
 
             // Avoid to call UpdateTransforms for each/all component types.
-            if (component_type->m_ReadsTransforms && collection->m_DirtyTransforms) {
+            if (ReadsTransforms(component_type) && collection->m_DirtyTransforms) {
                 UpdateTransforms(collection);
             }
 
             if (component_type->m_UpdateFunction)
             {
-                DM_PROFILE_DYN(GameObject, component_type->m_Name, component_type->m_NameHash);
-                ComponentsUpdateParams params;
-                params.m_Collection = collection->m_HCollection;
-                params.m_UpdateContext = update_context;
-                params.m_World = collection->m_ComponentWorlds[update_index];
-                params.m_Context = component_type->m_Context;
-
                 ComponentsUpdateResult update_result;
-                update_result.m_TransformsUpdated = false;
-                UpdateResult res = component_type->m_UpdateFunction(params, update_result);
+                UpdateResult res = UpdateComponentType(collection, update_context, update_index, update_result);
                 if (res != UPDATE_RESULT_OK)
                     ret = false;
 
                 // Mark the collections transforms as dirty if this component has updated
                 // them in its update function.
                 collection->m_DirtyTransforms |= update_result.m_TransformsUpdated;
+                if (update_result.m_Changed)
+                    dmAtomicStore32(&regist->m_Changed, 1);
             }
 
             if (!DispatchMessages(collection, &collection->m_ComponentSocket, 1))
@@ -2524,11 +3653,11 @@ namespace dmGameObject
             while (collection->m_InstancesToDeleteHead != INVALID_INSTANCE_INDEX && pass_count < max_pass_count) {
                 ++pass_count;
                 // Save the list and clear the head and tail
-                uint16_t head = collection->m_InstancesToDeleteHead;
+                InstanceIndex head = collection->m_InstancesToDeleteHead;
                 collection->m_InstancesToDeleteHead = INVALID_INSTANCE_INDEX;
                 collection->m_InstancesToDeleteTail = INVALID_INSTANCE_INDEX;
 
-                uint16_t index = head;
+                InstanceIndex index = head;
                 while (index != INVALID_INSTANCE_INDEX) {
                     Instance* instance = collection->m_Instances[index];
 
@@ -2546,17 +3675,7 @@ namespace dmGameObject
                     result = false;
                 }
 
-                // Reset to iterate for actual deletion
-                index = head;
-                while (index != INVALID_INSTANCE_INDEX) {
-                    Instance* instance = collection->m_Instances[index];
-
-                    assert(collection->m_Instances[instance->m_Index] == instance);
-                    assert(instance->m_ToBeDeleted);
-                    index = instance->m_NextToDelete;
-                    DoDeleteInstance(collection, instance);
-                    ++instances_deleted;
-                }
+                instances_deleted += DoDeleteInstances(collection, head);
             }
             if (pass_count == max_pass_count) {
                 dmLogWarning("Creation/deletion cycles encountered, postponing to next frame to avoid infinite hang.");
@@ -2577,6 +3696,11 @@ namespace dmGameObject
         return PostUpdate(hcollection->m_Collection);
     }
 
+    bool ConsumeChanges(HRegister regist)
+    {
+        return dmAtomicStore32(&regist->m_Changed, 0) != 0;
+    }
+
     bool PostUpdate(HRegister reg)
     {
         DM_PROFILE(GameObject, "PostUpdateRegister");
@@ -2769,42 +3893,46 @@ namespace dmGameObject
 
     void SetPosition(HInstance instance, Point3 position)
     {
-        instance->m_Transform.SetTranslation(Vector3(position));
+        GetLocalTransform(instance).SetTranslation(Vector3(position));
+        SetTransformDirty(instance);
     }
 
     Point3 GetPosition(HInstance instance)
     {
-        return Point3(instance->m_Transform.GetTranslation());
+        return Point3(GetLocalTransform(instance).GetTranslation());
     }
 
     void SetRotation(HInstance instance, Quat rotation)
     {
-        instance->m_Transform.SetRotation(rotation);
+        GetLocalTransform(instance).SetRotation(rotation);
+        SetTransformDirty(instance);
     }
 
     Quat GetRotation(HInstance instance)
     {
-        return instance->m_Transform.GetRotation();
+        return GetLocalTransform(instance).GetRotation();
     }
 
     void SetScale(HInstance instance, float scale)
     {
-        instance->m_Transform.SetUniformScale(scale);
+        GetLocalTransform(instance).SetUniformScale(scale);
+        SetTransformDirty(instance);
     }
 
     void SetScale(HInstance instance, Vector3 scale)
     {
-        instance->m_Transform.SetScale(scale);
+        GetLocalTransform(instance).SetScale(scale);
+        SetTransformDirty(instance);
     }
 
     float GetUniformScale(HInstance instance)
     {
-        return instance->m_Transform.GetUniformScale();
+        return GetLocalTransform(instance).GetUniformScale();
     }
 
     Vector3 GetScale(HInstance instance)
     {
-        return instance->m_Transform.GetScale();
+        return GetLocalTransform(instance).GetScale();
     }
 
     Point3 GetWorldPosition(HInstance instance)
@@ -2909,12 +4037,12 @@ namespace dmGameObject
         int original_child_depth = child->m_Depth;
         if (parent != 0)
         {
-            child->m_Parent = parent->m_Index;
+            SetParentIndex(child, parent->m_Index);
             child->m_Depth = parent->m_Depth + 1;
         }
         else
         {
-            child->m_Parent = INVALID_INSTANCE_INDEX;
+            SetParentIndex(child, INVALID_INSTANCE_INDEX);
             child->m_Depth = 0;
         }
         InsertInstanceInLevelIndex(collection, child);
@@ -2986,15 +4114,94 @@ namespace dmGameObject
 
     static void UpdateRotationToEuler(HInstance instance)
     {
-        Quat q = instance->m_Transform.GetRotation();
-        instance->m_EulerRotation = dmVMath::QuatToEuler(q.getX(), q.getY(), q.getZ(), q.getW());
-        instance->m_PrevEulerRotation = instance->m_EulerRotation;
+        Quat q = GetLocalTransform(instance).GetRotation();
+        GetEulerRotation(instance) = dmVMath::QuatToEuler(q.getX(), q.getY(), q.getZ(), q.getW());
+        GetPrevEulerRotation(instance) = GetEulerRotation(instance);
     }
 
     static void UpdateEulerToRotation(HInstance instance)
     {
-        instance->m_PrevEulerRotation = instance->m_EulerRotation;
-        instance->m_Transform.SetRotation(dmVMath::EulerToQuat(instance->m_EulerRotation));
+        GetPrevEulerRotation(instance) = GetEulerRotation(instance);
+        GetLocalTransform(instance).SetRotation(dmVMath::EulerToQuat(GetEulerRotation(instance)));
+    }
+
+    static uintptr_t* GetComponentInstanceUserData(HInstance instance, uint16_t component_index)
+    {
+        Prototype::Component* components = instance->m_Prototype->m_Components;
+        if (!components[component_index].m_Type->m_InstanceHasUserData)
+            return 0;
+        uint32_t next_component_instance_data = 0;
+        for (uint32_t i = 0; i < component_index; ++i)
+        {
+            if (components[i].m_Type->m_InstanceHasUserData)
+                ++next_component_instance_data;
+        }
+        return &instance->m_ComponentInstanceUserData[next_component_instance_data];
+    }
+
+    Result GetComponent(HInstance instance, dmhash_t component_id, const char* component_ext, void** out_world, uintptr_t* out_user_data)
+    {
+        uint16_t component_index;
+        Result result = GetComponentIndex(instance, component_id, &component_index);
+        if (result != RESULT_OK)
+        {
+            return result;
+        }
+
+        dmResource::ResourceType resource_type;
+        Prototype::Component& component = instance->m_Prototype->m_Components[component_index];
+        if (dmResource::GetTypeFromExtension(instance->m_Collection->m_Factory, component_ext, &resource_type) != dmResource::RESULT_OK ||
+            component.m_Type->m_ResourceType != resource_type)
+        {
+            return RESULT_COMPONENT_NOT_FOUND;
+        }
+
+        uintptr_t* user_data = GetComponentInstanceUserData(instance, component_index);
+        *out_world = instance->m_Collection->m_ComponentWorlds[component.m_TypeIndex];
+        *out_user_data = user_data ? *user_data : 0;
+        return RESULT_OK;
+    }
+
+    static PropertyResult GetComponentProperty(HInstance instance, uint16_t component_index, dmhash_t property_id, PropertyDesc& out_value)
+    {
+        Prototype::Component& component = instance->m_Prototype->m_Components[component_index];
+        ComponentType* type = component.m_Type;
+        if (!type->m_GetPropertyFunction)
+        {
+            return PROPERTY_RESULT_NOT_FOUND;
+        }
+        ComponentGetPropertyParams p;
+        p.m_Context = type->m_Context;
+        p.m_World = instance->m_Collection->m_ComponentWorlds[component.m_TypeIndex];
+        p.m_Instance = instance;
+        p.m_PropertyId = property_id;
+        p.m_UserData = GetComponentInstanceUserData(instance, component_index);
+        PropertyDesc prop_desc;
+        PropertyResult result = type->m_GetPropertyFunction(p, prop_desc);
+        if (result == PROPERTY_RESULT_OK)
+        {
+            out_value = prop_desc;
+        }
+        return result;
+    }
+
+    static PropertyResult SetComponentProperty(HInstance instance, uint16_t component_index, dmhash_t property_id, const PropertyVar& value)
+    {
+        Prototype::Component& component = instance->m_Prototype->m_Components[component_index];
+        ComponentType* type = component.m_Type;
+        if (!type->m_SetPropertyFunction)
+        {
+            return PROPERTY_RESULT_NOT_FOUND;
+        }
+        ComponentSetPropertyParams p;
+        p.m_Context = type->m_Context;
+        p.m_World = instance->m_Collection->m_ComponentWorlds[component.m_TypeIndex];
+        p.m_Instance = instance;
+        p.m_PropertyId = property_id;
+        p.m_UserData = GetComponentInstanceUserData(instance, component_index);
+        p.m_Value = value;
+        dmAtomicStore32(&instance->m_Collection->m_Register->m_Changed, 1);
+        return type->m_SetPropertyFunction(p);
     }
 
     PropertyResult GetProperty(HInstance instance, dmhash_t component_id, dmhash_t property_id, PropertyDesc& out_value)
@@ -3008,117 +4215,117 @@ namespace dmGameObject
             // Scale used to be a uniform scalar, but is now a non-uniform 3-component scale
             if (property_id == PROP_SCALE)
             {
-                float* scale = instance->m_Transform.GetScalePtr();
+                float* scale = GetLocalTransform(instance).GetScalePtr();
                 out_value.m_ValuePtr = scale;
                 out_value.m_ElementIds[0] = PROP_SCALE_X;
                 out_value.m_ElementIds[1] = PROP_SCALE_Y;
                 out_value.m_ElementIds[2] = PROP_SCALE_Z;
-                out_value.m_Variant = PropertyVar(instance->m_Transform.GetScale());
+                out_value.m_Variant = PropertyVar(GetLocalTransform(instance).GetScale());
             }
             else if (property_id == PROP_SCALE_X)
             {
-                float* scale = instance->m_Transform.GetScalePtr();
+                float* scale = GetLocalTransform(instance).GetScalePtr();
                 out_value.m_ValuePtr = scale;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_SCALE_Y)
             {
-                float* scale = instance->m_Transform.GetScalePtr();
+                float* scale = GetLocalTransform(instance).GetScalePtr();
                 out_value.m_ValuePtr = scale + 1;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_SCALE_Z)
             {
-                float* scale = instance->m_Transform.GetScalePtr();
+                float* scale = GetLocalTransform(instance).GetScalePtr();
                 out_value.m_ValuePtr = scale + 2;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_POSITION)
             {
-                float* position = instance->m_Transform.GetPositionPtr();
+                float* position = GetLocalTransform(instance).GetPositionPtr();
                 out_value.m_ValuePtr = position;
                 out_value.m_ElementIds[0] = PROP_POSITION_X;
                 out_value.m_ElementIds[1] = PROP_POSITION_Y;
                 out_value.m_ElementIds[2] = PROP_POSITION_Z;
-                out_value.m_Variant = PropertyVar(instance->m_Transform.GetTranslation());
+                out_value.m_Variant = PropertyVar(GetLocalTransform(instance).GetTranslation());
             }
             else if (property_id == PROP_POSITION_X)
             {
-                float* position = instance->m_Transform.GetPositionPtr();
+                float* position = GetLocalTransform(instance).GetPositionPtr();
                 out_value.m_ValuePtr = position;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_POSITION_Y)
             {
-                float* position = instance->m_Transform.GetPositionPtr();
+                float* position = GetLocalTransform(instance).GetPositionPtr();
                 out_value.m_ValuePtr = position + 1;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_POSITION_Z)
             {
-                float* position = instance->m_Transform.GetPositionPtr();
+                float* position = GetLocalTransform(instance).GetPositionPtr();
                 out_value.m_ValuePtr = position + 2;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_ROTATION)
             {
-                float* rotation = instance->m_Transform.GetRotationPtr();
+                float* rotation = GetLocalTransform(instance).GetRotationPtr();
                 out_value.m_ValuePtr = rotation;
                 out_value.m_ElementIds[0] = PROP_ROTATION_X;
                 out_value.m_ElementIds[1] = PROP_ROTATION_Y;
                 out_value.m_ElementIds[2] = PROP_ROTATION_Z;
                 out_value.m_ElementIds[3] = PROP_ROTATION_W;
-                out_value.m_Variant = PropertyVar(instance->m_Transform.GetRotation());
+                out_value.m_Variant = PropertyVar(GetLocalTransform(instance).GetRotation());
             }
             else if (property_id == PROP_ROTATION_X)
             {
-                float* rotation = instance->m_Transform.GetRotationPtr();
+                float* rotation = GetLocalTransform(instance).GetRotationPtr();
                 out_value.m_ValuePtr = rotation;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_ROTATION_Y)
             {
-                float* rotation = instance->m_Transform.GetRotationPtr();
+                float* rotation = GetLocalTransform(instance).GetRotationPtr();
                 out_value.m_ValuePtr = rotation + 1;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_ROTATION_Z)
             {
-                float* rotation = instance->m_Transform.GetRotationPtr();
+                float* rotation = GetLocalTransform(instance).GetRotationPtr();
                 out_value.m_ValuePtr = rotation + 2;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_ROTATION_W)
             {
-                float* rotation = instance->m_Transform.GetRotationPtr();
+                float* rotation = GetLocalTransform(instance).GetRotationPtr();
                 out_value.m_ValuePtr = rotation + 3;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_EULER)
             {
                 UpdateRotationToEuler(instance);
-                out_value.m_ValuePtr = (float*)&instance->m_EulerRotation;
+                out_value.m_ValuePtr = (float*)&GetEulerRotation(instance);
                 out_value.m_ElementIds[0] = PROP_EULER_X;
                 out_value.m_ElementIds[1] = PROP_EULER_Y;
                 out_value.m_ElementIds[2] = PROP_EULER_Z;
-                out_value.m_Variant = PropertyVar(instance->m_EulerRotation);
+                out_value.m_Variant = PropertyVar(GetEulerRotation(instance));
             }
             else if (property_id == PROP_EULER_X)
             {
                 UpdateRotationToEuler(instance);
-                out_value.m_ValuePtr = ((float*)&instance->m_EulerRotation);
+                out_value.m_ValuePtr = ((float*)&GetEulerRotation(instance));
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_EULER_Y)
             {
                 UpdateRotationToEuler(instance);
-                out_value.m_ValuePtr = ((float*)&instance->m_EulerRotation) + 1;
+                out_value.m_ValuePtr = ((float*)&GetEulerRotation(instance)) + 1;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             else if (property_id == PROP_EULER_Z)
             {
                 UpdateRotationToEuler(instance);
-                out_value.m_ValuePtr = ((float*)&instance->m_EulerRotation) + 2;
+                out_value.m_ValuePtr = ((float*)&GetEulerRotation(instance)) + 2;
                 out_value.m_Variant = PropertyVar(*out_value.m_ValuePtr);
             }
             if (out_value.m_ValuePtr != 0x0)
@@ -3135,40 +4342,7 @@ namespace dmGameObject
             uint16_t component_index;
             if (RESULT_OK == GetComponentIndex(instance, component_id, &component_index))
             {
-                Prototype::Component* components = instance->m_Prototype->m_Components;
-                Prototype::Component& component = components[component_index];
-                ComponentType* type = component.m_Type;
-                if (type->m_GetPropertyFunction)
-                {
-                    uintptr_t* user_data = 0;
-                    if (type->m_InstanceHasUserData)
-                    {
-                        uint32_t next_component_instance_data = 0;
-                        for (uint32_t i = 0; i < component_index; ++i)
-                        {
-                            if (components[i].m_Type->m_InstanceHasUserData)
-                                ++next_component_instance_data;
-                        }
-                        user_data = &instance->m_ComponentInstanceUserData[next_component_instance_data];
-                    }
-                    ComponentGetPropertyParams p;
-                    p.m_Context = type->m_Context;
-                    p.m_World = instance->m_Collection->m_ComponentWorlds[component.m_TypeIndex];
-                    p.m_Instance = instance;
-                    p.m_PropertyId = property_id;
-                    p.m_UserData = user_data;
-                    PropertyDesc prop_desc;
-                    PropertyResult result = type->m_GetPropertyFunction(p, prop_desc);
-                    if (result == PROPERTY_RESULT_OK)
-                    {
-                        out_value = prop_desc;
-                    }
-                    return result;
-                }
-                else
-                {
-                    return PROPERTY_RESULT_NOT_FOUND;
-                }
+                return GetComponentProperty(instance, component_index, property_id, out_value);
             }
             else
             {
@@ -3183,9 +4357,10 @@ namespace dmGameObject
             return PROPERTY_RESULT_INVALID_INSTANCE;
         if (component_id == 0)
         {
-            float* position = instance->m_Transform.GetPositionPtr();
-            float* rotation = instance->m_Transform.GetRotationPtr();
-            float* scale = instance->m_Transform.GetScalePtr();
+            SetTransformDirty(instance);
+            float* position = GetLocalTransform(instance).GetPositionPtr();
+            float* rotation = GetLocalTransform(instance).GetRotationPtr();
+            float* scale = GetLocalTransform(instance).GetScalePtr();
             if (property_id == PROP_POSITION)
             {
                 if (value.m_Type != PROPERTY_TYPE_VECTOR3)
@@ -3297,7 +4472,7 @@ namespace dmGameObject
             {
                 if (value.m_Type != PROPERTY_TYPE_VECTOR3)
                     return PROPERTY_RESULT_TYPE_MISMATCH;
-                instance->m_EulerRotation = Vector3(value.m_V4[0], value.m_V4[1], value.m_V4[2]);
+                GetEulerRotation(instance) = Vector3(value.m_V4[0], value.m_V4[1], value.m_V4[2]);
                 UpdateEulerToRotation(instance);
                 return PROPERTY_RESULT_OK;
             }
@@ -3305,7 +4480,7 @@ namespace dmGameObject
             {
                 if (value.m_Type != PROPERTY_TYPE_NUMBER)
                     return PROPERTY_RESULT_TYPE_MISMATCH;
-                instance->m_EulerRotation.setX((float)value.m_Number);
+                GetEulerRotation(instance).setX((float)value.m_Number);
                 UpdateEulerToRotation(instance);
                 return PROPERTY_RESULT_OK;
             }
@@ -3313,7 +4488,7 @@ namespace dmGameObject
             {
                 if (value.m_Type != PROPERTY_TYPE_NUMBER)
                     return PROPERTY_RESULT_TYPE_MISMATCH;
-                instance->m_EulerRotation.setY((float)value.m_Number);
+                GetEulerRotation(instance).setY((float)value.m_Number);
                 UpdateEulerToRotation(instance);
                 return PROPERTY_RESULT_OK;
             }
@@ -3321,7 +4496,7 @@ namespace dmGameObject
             {
                 if (value.m_Type != PROPERTY_TYPE_NUMBER)
                     return PROPERTY_RESULT_TYPE_MISMATCH;
-                instance->m_EulerRotation.setZ((float)value.m_Number);
+                GetEulerRotation(instance).setZ((float)value.m_Number);
                 UpdateEulerToRotation(instance);
                 return PROPERTY_RESULT_OK;
             }
@@ -3335,35 +4510,7 @@ namespace dmGameObject
             uint16_t component_index;
             if (RESULT_OK == GetComponentIndex(instance, component_id, &component_index))
             {
-                Prototype::Component* components = instance->m_Prototype->m_Components;
-                Prototype::Component& component = components[component_index];
-                ComponentType* type = component.m_Type;
-                if (type->m_SetPropertyFunction)
-                {
-                    uintptr_t* user_data = 0;
-                    if (type->m_InstanceHasUserData)
-                    {
-                        uint32_t next_component_instance_data = 0;
-                        for (uint32_t i = 0; i < component_index; ++i)
-                        {
-                            if (components[i].m_Type->m_InstanceHasUserData)
-                                ++next_component_instance_data;
-                        }
-                        user_data = &instance->m_ComponentInstanceUserData[next_component_instance_data];
-                    }
-                    ComponentSetPropertyParams p;
-                    p.m_Context = type->m_Context;
-                    p.m_World = instance->m_Collection->m_ComponentWorlds[component.m_TypeIndex];
-                    p.m_Instance = instance;
-                    p.m_PropertyId = property_id;
-                    p.m_UserData = user_data;
-                    p.m_Value = value;
-                    return type->m_SetPropertyFunction(p);
-                }
-                else
-                {
-                    return PROPERTY_RESULT_NOT_FOUND;
-                }
+                return SetComponentProperty(instance, component_index, property_id, value);
             }
             else
             {
@@ -3373,18 +4520,148 @@ namespace dmGameObject
         return PROPERTY_RESULT_OK;
     }
 
+    static bool IsEulerProperty(dmhash_t property_id)
+    {
+        return property_id == PROP_EULER || property_id == PROP_EULER_X || property_id == PROP_EULER_Y || property_id == PROP_EULER_Z;
+    }
+
+    static uint32_t GetValueElementCount(PropertyType type)
+    {
+        switch (type)
+        {
+        case PROPERTY_TYPE_NUMBER:
+            return 1;
+        case PROPERTY_TYPE_VECTOR3:
+            return 3;
+        case PROPERTY_TYPE_VECTOR4:
+        case PROPERTY_TYPE_QUAT:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    PropertyResult GetPropertyHandle(HInstance instance, dmhash_t component_id, dmhash_t property_id, PropertyHandle& out_handle, PropertyDesc& out_value)
+    {
+        if (instance == 0)
+            return PROPERTY_RESULT_INVALID_INSTANCE;
+        uint16_t component_index = 0;
+        PropertyResult result;
+        if (component_id == 0)
+        {
+            result = GetProperty(instance, component_id, property_id, out_value);
+        }
+        else if (RESULT_OK == GetComponentIndex(instance, component_id, &component_index))
+        {
+            result = GetComponentProperty(instance, component_index, property_id, out_value);
+        }
+        else
+        {
+            return PROPERTY_RESULT_COMP_NOT_FOUND;
+        }
+        if (result != PROPERTY_RESULT_OK)
+        {
+            return result;
+        }
+        out_handle.m_Instance = instance;
+        out_handle.m_ComponentId = component_id;
+        out_handle.m_PropertyId = property_id;
+        out_handle.m_ValuePtr = out_value.m_ValuePtr;
+        // Only plain float values are read through the pointer
+        if (GetValueElementCount(out_value.m_Variant.m_Type) == 0)
+            out_handle.m_ValuePtr = 0x0;
+        out_handle.m_Type = out_value.m_Variant.m_Type;
+        out_handle.m_ComponentIndex = component_index;
+        out_handle.m_ReadOnly = out_value.m_ReadOnly;
+        out_handle.m_Euler = component_id == 0 && IsEulerProperty(property_id);
+        return PROPERTY_RESULT_OK;
+    }
+
+    PropertyResult GetProperty(const PropertyHandle& handle, PropertyDesc& out_value)
+    {
+        HInstance instance = handle.m_Instance;
+        if (instance == 0)
+            return PROPERTY_RESULT_INVALID_INSTANCE;
+        if (handle.m_ValuePtr == 0x0)
+        {
+            if (handle.m_ComponentId == 0)
+                return GetProperty(instance, 0, handle.m_PropertyId, out_value);
+            return GetComponentProperty(instance, handle.m_ComponentIndex, handle.m_PropertyId, out_value);
+        }
+
+        if (handle.m_Euler)
+        {
+            UpdateRotationToEuler(instance);
+        }
+        const float* v = handle.m_ValuePtr;
+        PropertyVar& var = out_value.m_Variant;
+        var.m_Type = handle.m_Type;
+        if (handle.m_Type == PROPERTY_TYPE_NUMBER)
+        {
+            var.m_Number = *v;
+        }
+        else
+        {
+            uint32_t element_count = GetValueElementCount(handle.m_Type);
+            for (uint32_t i = 0; i < element_count; ++i)
+            {
+                var.m_V4[i] = v[i];
+            }
+        }
+        out_value.m_ValuePtr = handle.m_ValuePtr;
+        out_value.m_ReadOnly = handle.m_ReadOnly;
+        return PROPERTY_RESULT_OK;
+    }
+
+    PropertyResult SetProperty(const PropertyHandle& handle, const PropertyVar& value)
+    {
+        HInstance instance = handle.m_Instance;
+        if (instance == 0)
+            return PROPERTY_RESULT_INVALID_INSTANCE;
+        if (handle.m_ComponentId != 0)
+        {
+            // Components might do more than storing the value, e.g. marking a state dirty
+            return SetComponentProperty(instance, handle.m_ComponentIndex, handle.m_PropertyId, value);
+        }
+        // Conversions (e.g. uniform scale) and type errors are handled by the regular path
+        if (handle.m_ValuePtr == 0x0 || value.m_Type != handle.m_Type)
+        {
+            return SetProperty(instance, 0, handle.m_PropertyId, value);
+        }
+
+        float* v = handle.m_ValuePtr;
+        if (value.m_Type == PROPERTY_TYPE_NUMBER)
+        {
+            *v = (float)value.m_Number;
+        }
+        else
+        {
+            uint32_t element_count = GetValueElementCount(value.m_Type);
+            for (uint32_t i = 0; i < element_count; ++i)
+            {
+                v[i] = value.m_V4[i];
+            }
+        }
+        if (handle.m_Euler)
+        {
+            UpdateEulerToRotation(instance);
+        }
+        SetTransformDirty(instance);
+        return PROPERTY_RESULT_OK;
+    }
+
     // Recreate the instance at the given index with a new prototype.
     // Specifically:
     //  - recreate components and call init/final functions
     //  - patch data structures for identification and input stack
     //  - copy the rest of the fields
     // The old instance is destroyed.
-    static void RecreateInstance(Collection* collection, uint16_t index, Prototype* old_proto, Prototype* new_proto, const char* new_proto_name) {
+    static void RecreateInstance(Collection* collection, InstanceIndex index, Prototype* old_proto, Prototype* new_proto, const char* new_proto_name) {
         HInstance instance = collection->m_Instances[index];
         // We don't support recreating instances that are 'transitioning'
         assert(instance->m_ToBeAdded == 0);
         assert(instance->m_ToBeDeleted == 0);
-        HInstance new_instance = AllocInstance(new_proto, new_proto_name);
+        HInstance new_instance = AllocInstance(collection, new_proto, new_proto_name);
         if (!new_instance) {
             return;
         }
@@ -3397,21 +4674,16 @@ namespace dmGameObject
         new_instance->m_Parent = instance->m_Parent;
         new_instance->m_FirstChildIndex = instance->m_FirstChildIndex;
         new_instance->m_SiblingIndex = instance->m_SiblingIndex;
-        // transform-related
-        new_instance->m_Transform = instance->m_Transform;
-        new_instance->m_EulerRotation = instance->m_EulerRotation;
-        new_instance->m_PrevEulerRotation = instance->m_PrevEulerRotation;
+        // transform-related, the transform data is kept by the collection at m_Index
         new_instance->m_ScaleAlongZ = instance->m_ScaleAlongZ;
         // id-related
         new_instance->m_Identifier = instance->m_Identifier;
         new_instance->m_IdentifierIndex = instance->m_IdentifierIndex;
-        dmHashClone64(&new_instance->m_CollectionPathHashState, &instance->m_CollectionPathHashState, true);
         new_instance->m_Generated = instance->m_Generated;
         HCollection hcollection = collection->m_HCollection;
         bool res = CreateComponents(hcollection, new_instance);
         if (!res) {
-            dmHashRelease64(&new_instance->m_CollectionPathHashState);
-            DeallocInstance(new_instance);
+            DeallocInstance(collection, new_instance);
             return;
         }
         if (instance->m_Initialized) {
@@ -3424,9 +4696,11 @@ namespace dmGameObject
             FinalComponents(collection, instance);
         }
         DestroyComponents(collection, instance);
-        dmHashRelease64(&instance->m_CollectionPathHashState);
+        // The reference to the collection path is handed over to the new instance
+        new_instance->m_CollectionPathIndex = instance->m_CollectionPathIndex;
         collection->m_Instances[index] = new_instance;
         collection->m_IDToInstance.Put(new_instance->m_Identifier, new_instance);
+        collection->m_MessageReceiverGeneration++;
 
         dmArray<Instance*>& stack = collection->m_InputFocusStack;
         uint32_t n_stack = stack.Size();
@@ -3437,7 +4711,7 @@ namespace dmGameObject
                 break;
             }
         }
-        DeallocInstance(instance);
+        DeallocInstance(collection, instance);
         DoAddToUpdate(collection, new_instance);
     }
 
@@ -3446,11 +4720,11 @@ namespace dmGameObject
         Collection* collection = (Collection*) params.m_UserData;
         for (uint32_t level_i = 0; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
         {
-            dmArray<uint16_t>& level = collection->m_LevelIndices[level_i];
+            dmArray<InstanceIndex>& level = collection->m_LevelIndices[level_i];
             uint32_t instance_count = level.Size();
             for (uint32_t i = 0; i < instance_count; ++i)
             {
-                uint16_t index = level[i];
+                InstanceIndex index = level[i];
                 Instance* instance = collection->m_Instances[index];
                 if (instance->m_Prototype == params.m_Resource->m_Resource) {
                     RecreateInstance(collection, index, (Prototype*)params.m_Resource->m_PrevResource, (Prototype*)params.m_Resource->m_Resource, params.m_Name);
@@ -3493,7 +4767,7 @@ namespace dmGameObject
     {
         Collection* collection = hcollection->m_Collection;
         uint32_t count = 0;
-        uint16_t index = collection->m_InstancesToAddHead;
+        InstanceIndex index = collection->m_InstancesToAddHead;
         while (index != INVALID_INSTANCE_INDEX) {
             index = collection->m_Instances[index]->m_NextToAdd;
             ++count;
@@ -3505,7 +4779,7 @@ namespace dmGameObject
     {
         Collection* collection = hcollection->m_Collection;
         uint32_t count = 0;
-        uint16_t index = collection->m_InstancesToDeleteHead;
+        InstanceIndex index = collection->m_InstancesToDeleteHead;
         while (index != INVALID_INSTANCE_INDEX) {
             index = collection->m_Instances[index]->m_NextToDelete;
             ++count;
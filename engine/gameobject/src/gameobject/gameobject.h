@@ -18,7 +18,9 @@
 #include <dmsdk/gameobject/gameobject.h>
 
 #include <dlib/easing.h>
+#include <dlib/frame_alloc.h>
 #include <dlib/hashtable.h>
+#include <dlib/job.h>
 #include <dlib/message.h>
 #include <dlib/transform.h>
 
@@ -69,7 +71,7 @@ namespace dmGameObject
     /**
      * Set default capacity of collections in this register. This does not affect existing collections.
      * @param regist Register
-     * @param capacity Default capacity of collections in this register (0-32766).
+     * @param capacity Default capacity of collections in this register (0-32766, or larger when built with wide instance indices).
      * @return RESULT_OK on success or RESULT_INVALID_OPERATION if max_count is not within range
      */
     Result SetCollectionDefaultCapacity(HRegister regist, uint32_t capacity);
@@ -88,6 +90,36 @@ namespace dmGameObject
      */
     void SetInputStackDefaultCapacity(HRegister regist, uint32_t capacity);
 
+    /**
+     * Set the job context used to spread work over worker threads, e.g. the transform update.
+     * Without a job context all work is done on the calling thread.
+     * @param regist Register
+     * @param job_context Job context, may be 0
+     */
+    void SetJobContext(HRegister regist, dmJob::HContext job_context);
+
+    /**
+     * Get the job context of the register
+     * @param regist Register
+     * @return Job context, may be 0
+     */
+    dmJob::HContext GetJobContext(HRegister regist);
+
+    /**
+     * Set the frame allocator used for transient data, e.g. the scratch arrays when spawning collections.
+     * Without a frame allocator the data is allocated on the heap.
+     * @param regist Register
+     * @param frame_allocator Frame allocator, may be 0
+     */
+    void SetFrameAllocator(HRegister regist, dmFrameAlloc::HAllocator frame_allocator);
+
+    /**
+     * Get the frame allocator of the register
+     * @param regist Register
+     * @return Frame allocator, may be 0
+     */
+    dmFrameAlloc::HAllocator GetFrameAllocator(HRegister regist);
+
     /**
      * Creates a new gameobject collection
      * @param name Collection name, which must be unique and follow the same naming as for sockets
@@ -133,6 +165,15 @@ namespace dmGameObject
      */
     HInstance Spawn(HCollection collection, HPrototype prototype, const char* prototype_name, dmhash_t id, uint8_t* property_buffer, uint32_t property_buffer_size, const Point3& position, const Quat& rotation, const Vector3& scale);
 
+    /**
+     * Preallocates memory for instances of a prototype, so that spawning the first count instances doesn't allocate.
+     * Allocations of deleted instances are recycled the same way. The preallocated memory is kept until the collection is deleted.
+     * @param collection Gameobject collection
+     * @param prototype Prototype of the instances
+     * @param count Number of instances to have memory for, limited by the max instance count of the collection
+     */
+    void PrewarmInstances(HCollection collection, HPrototype prototype, uint32_t count);
+
     struct InstancePropertyBuffer
     {
         uint8_t *property_buffer;
@@ -167,6 +208,35 @@ namespace dmGameObject
                              const Point3& position, const Quat& rotation, const Vector3& scale,
                              InstanceIdMap *instances);
 
+    /**
+     * Spawns a collection like SpawnFromCollection, but leaves the instances uninitialized. They are initialized
+     * and added to update by the following calls to Update(), spending at most init_time_budget per update on it.
+     * The instances and their components are created, and have their identifiers and hierarchy, when the function returns.
+     *
+     * @param collection Gameobject collection to spawn into
+     * @param collection_desc Collection definition
+     * @param property_buffers Serialized property buffers hashtable (key: game object identifier, value: property buffer)
+     * @param position Position for the root object
+     * @param rotation Rotation for the root object
+     * @param scale Scale of the root object
+     * @param init_time_budget Max time spent initializing instances in each update, in microseconds. Applies to all deferred spawns of the collection
+     * @param instances Hash table to be filled with instance identifier mapping
+     * @param spawn_id Id to check completion of the init with IsDeferredInitDone (out)
+     * return true on success
+     */
+    bool SpawnFromCollectionDeferredInit(HCollection collection, HCollectionDesc collection_desc, InstancePropertyBuffers *property_buffers,
+                             const Point3& position, const Quat& rotation, const Vector3& scale, uint32_t init_time_budget,
+                             InstanceIdMap *instances, uint32_t* spawn_id);
+
+    /**
+     * Checks if all instances of a SpawnFromCollectionDeferredInit call have been initialized.
+     * Instances deleted before they were initialized count as done.
+     * @param collection Gameobject collection
+     * @param spawn_id Id returned by SpawnFromCollectionDeferredInit
+     * @return true if there are no more instances of the spawn to initialize
+     */
+    bool IsDeferredInitDone(HCollection collection, uint32_t spawn_id);
+
     /**
      * Delete all gameobject instances in the collection
      * @param collection Gameobject collection
@@ -202,6 +272,80 @@ namespace dmGameObject
      */
     Result GetComponentIndex(HInstance instance, dmhash_t component_id, uint16_t* component_index);
 
+    /**
+     * Get the world and user data of a component of a given type. This function has complexity O(n), where n is the number of components of the instance.
+     * The user data is what the component type stored when the component was created, and can be kept for as long as the component exists.
+     * @param instance Instance
+     * @param component_id Component id
+     * @param component_ext Resource extension of the expected component type, e.g. "spritec"
+     * @param out_world World of the component type as out-argument
+     * @param out_user_data Component user data as out-argument, 0 if the component type has no instance user data
+     * @return RESULT_OK if a component of the type was found, RESULT_COMPONENT_NOT_FOUND otherwise
+     */
+    Result GetComponent(HInstance instance, dmhash_t component_id, const char* component_ext, void** out_world, uintptr_t* out_user_data);
+
+    /**
+     * Get a counter that is incremented each time the world transform of the instance is recomputed.
+     * Components that derive their own world transforms from the instance can store the value and
+     * skip the work as long as it is unchanged.
+     * @param instance Instance
+     * @return world transform version
+     */
+    uint32_t GetWorldTransformVersion(HInstance instance);
+
+    /**
+     * Default cell size when the spatial index is enabled by a query, see EnableSpatialIndex()
+     */
+    const float SPATIAL_INDEX_DEFAULT_CELL_SIZE = 128.0f;
+
+    /**
+     * Callback for spatial queries, called once for each instance found
+     * @param instance Instance found by the query
+     * @param user_data User data supplied to the query
+     */
+    typedef void (*SpatialQueryCallback)(HInstance instance, void* user_data);
+
+    /**
+     * Enable the spatial index of the collection. The index is a uniform grid over the world positions
+     * of the instances and is kept up to date by UpdateTransforms(), so only instances that moved are re-indexed.
+     * The queries use the world positions of the last UpdateTransforms(). Enabling an already enabled index
+     * with a different cell size rebuilds it.
+     * @param collection Collection
+     * @param cell_size Size of the grid cells, ideally around the typical query radius
+     * @return RESULT_OK on success or RESULT_INVALID_OPERATION if cell_size is not positive
+     */
+    Result EnableSpatialIndex(HCollection collection, float cell_size);
+
+    /**
+     * Disable and free the spatial index of the collection
+     * @param collection Collection
+     */
+    void DisableSpatialIndex(HCollection collection);
+
+    /**
+     * Find the instances with a world position inside an axis aligned box. The spatial index is enabled with
+     * SPATIAL_INDEX_DEFAULT_CELL_SIZE if it isn't already.
+     * @param collection Collection
+     * @param min Minimum corner of the box
+     * @param max Maximum corner of the box
+     * @param callback Called for each instance found, in no particular order
+     * @param user_data User data passed to the callback
+     * @return Number of instances found
+     */
+    uint32_t QueryAABB(HCollection collection, const Point3& min, const Point3& max, SpatialQueryCallback callback, void* user_data);
+
+    /**
+     * Find the instances with a world position within a radius. The spatial index is enabled with
+     * SPATIAL_INDEX_DEFAULT_CELL_SIZE if it isn't already.
+     * @param collection Collection
+     * @param center Center of the sphere
+     * @param radius Radius of the sphere
+     * @param callback Called for each instance found, in no particular order
+     * @param user_data User data passed to the callback
+     * @return Number of instances found
+     */
+    uint32_t QueryRadius(HCollection collection, const Point3& center, float radius, SpatialQueryCallback callback, void* user_data);
+
     /**
      * Returns whether the scale of the supplied instance should be applied along Z or not.
      * @param instance Instance
@@ -233,6 +377,39 @@ namespace dmGameObject
      */
     bool Final(HCollection collection);
 
+    /**
+     * Initializes the game object instances in the supplied collection over several calls.
+     * Each call initializes instances until time_budget is spent, but at least one.
+     * When all instances are initialized, they are added to update like with Init().
+     * Calling Init() completes an incremental init in progress, and Final() cancels it.
+     * @param collection Game object collection
+     * @param time_budget Max time to spend, in microseconds
+     * @param done Set to true when the whole collection is initialized (out)
+     * @return false if any instance failed to initialize
+     */
+    bool InitIncremental(HCollection collection, uint32_t time_budget, bool* done);
+
+    /**
+     * Finalizes the initialized game object instances in the supplied collection over several calls.
+     * Each call finalizes instances until time_budget is spent, but at least one.
+     * Can be called while an incremental init is in progress, which is then cancelled.
+     * @param collection Game object collection
+     * @param time_budget Max time to spend, in microseconds
+     * @param done Set to true when the whole collection is finalized (out)
+     * @return false if any instance failed to finalize
+     */
+    bool FinalIncremental(HCollection collection, uint32_t time_budget, bool* done);
+
+    /**
+     * Deletes the game object instances in the supplied collection over several calls, releasing
+     * their resources. Each call deletes instances until time_budget is spent, but at least one.
+     * The instances are deleted immediately, so the collection should be finalized and no longer updated.
+     * @param collection Game object collection
+     * @param time_budget Max time to spend, in microseconds
+     * @param done Set to true when all instances are deleted (out)
+     */
+    void DeleteIncremental(HCollection collection, uint32_t time_budget, bool* done);
+
     /**
      * Update all gameobjects and its components and dispatches all message to script.
      * The order is to update each component type, one at a time, of the collection each iteration.
@@ -263,6 +440,15 @@ namespace dmGameObject
      */
     bool PostUpdate(HRegister reg);
 
+    /**
+     * Check if anything that is rendered changed since the last call, and reset the state.
+     * Moved instances, dispatched messages, set component properties, deleted instances and
+     * components that report changes from their update function all count as changes.
+     * @param regist Game object register
+     * @return True if anything changed
+     */
+    bool ConsumeChanges(HRegister regist);
+
     /**
      * Dispatches input actions to the input focus stacks in the supplied game object collection.
      * @param collection Game object collection
@@ -356,6 +542,54 @@ namespace dmGameObject
      */
     PropertyResult SetProperty(HInstance instance, dmhash_t component_id, dmhash_t property_id, const PropertyVar& value);
 
+    /**
+     * A property resolved once by GetPropertyHandle, for repeated access without
+     * looking up the component and matching the property id each time.
+     * @note The handle is only valid as long as the instance is alive
+     */
+    struct PropertyHandle
+    {
+        HInstance       m_Instance;
+        dmhash_t        m_ComponentId;
+        dmhash_t        m_PropertyId;
+        // Pointer to the value, 0x0 if the property can only be accessed through the component
+        float*          m_ValuePtr;
+        PropertyType    m_Type;
+        uint16_t        m_ComponentIndex;
+        uint16_t        m_ReadOnly : 1;
+        // The euler rotation needs to be synced with the rotation when accessed
+        uint16_t        m_Euler : 1;
+        uint16_t        : 14;
+    };
+
+    /**
+     * Resolve a property into a handle.
+     * @param instance Instance of the game object
+     * @param component_id Id of the component, 0 for the game object itself
+     * @param property_id Id of the property
+     * @param out_handle Resolved handle
+     * @param out_value Description of the current property value
+     * @return PROPERTY_RESULT_OK if the out-parameters were written
+     */
+    PropertyResult GetPropertyHandle(HInstance instance, dmhash_t component_id, dmhash_t property_id, PropertyHandle& out_handle, PropertyDesc& out_value);
+
+    /**
+     * Retrieve a property through a handle.
+     * @note The element ids of out_value are not written when the property is read through the value pointer
+     * @param handle Handle from GetPropertyHandle
+     * @param out_value Description of the retrieved property value
+     * @return PROPERTY_RESULT_OK if the out-parameters were written
+     */
+    PropertyResult GetProperty(const PropertyHandle& handle, PropertyDesc& out_value);
+
+    /**
+     * Sets the value of a property through a handle.
+     * @param handle Handle from GetPropertyHandle
+     * @param value Value and type of the property
+     * @return PROPERTY_RESULT_OK if the value could be set
+     */
+    PropertyResult SetProperty(const PropertyHandle& handle, const PropertyVar& value);
+
     typedef void (*AnimationStopped)(dmGameObject::HInstance instance, dmhash_t component_id, dmhash_t property_id,
                                         bool finished, void* userdata1, void* userdata2);
 
@@ -13,9 +13,12 @@
 #ifndef GAMEOBJECT_COMMON_H
 #define GAMEOBJECT_COMMON_H
 
+#include <dlib/atomic.h>
 #include <dlib/hash.h>
+#include <dlib/hashmap.h>
 #include <dlib/hashtable.h>
 #include <dlib/index_pool.h>
+#include <dlib/job.h>
 #include <dlib/math.h>
 #include <dlib/mutex.h>
 #include <dlib/transform.h>
@@ -83,8 +86,32 @@ namespace dmGameObject
         dmArray<void*> m_PropertyResources;
     };
 
-    // Invalid instance index. Implies that maximum number of instances is 32766 (ie 0x7fff - 1)
-    const uint32_t INVALID_INSTANCE_INDEX = 0x7fff;
+    // Index of an instance in a collection, see Instance::m_Index.
+    // By default the indices are 16 bit, which limits a collection to 32766 instances. Define
+    // DM_GAMEOBJECT_WIDE_INSTANCE_INDEX when building the gameobject library to use 32 bit indices instead.
+    // Only the instance and hierarchy indices are widened, the per instance transform arrays are unaffected.
+#if defined(DM_GAMEOBJECT_WIDE_INSTANCE_INDEX)
+    typedef uint32_t InstanceIndex;
+    typedef dmIndexPool32 InstanceIndexPool;
+    const uint32_t INSTANCE_INDEX_BITS = 31;
+#else
+    typedef uint16_t InstanceIndex;
+    typedef dmIndexPool16 InstanceIndexPool;
+    const uint32_t INSTANCE_INDEX_BITS = 15;
+#endif
+
+    // Invalid instance index. Implies that maximum number of instances is INVALID_INSTANCE_INDEX - 1,
+    // i.e. 32766 (0x7fff - 1) unless DM_GAMEOBJECT_WIDE_INSTANCE_INDEX is defined
+    const uint32_t INVALID_INSTANCE_INDEX = (1U << INSTANCE_INDEX_BITS) - 1;
+
+    const uint16_t INVALID_COLLECTION_PATH_INDEX = 0xffff;
+
+    struct CollectionPath
+    {
+        HashState64 m_State;
+        dmhash_t    m_Hash;
+        uint32_t    m_RefCount;
+    };
 
     // NOTE: Actual size of Instance is sizeof(Instance) + sizeof(uintptr_t) * m_UserDataCount
     struct Instance
@@ -92,13 +119,10 @@ namespace dmGameObject
         Instance(Prototype* prototype)
         {
             m_Collection = 0;
-            m_Transform.SetIdentity();
-            m_EulerRotation = Vector3(0.0f, 0.0f, 0.0f);
-            m_PrevEulerRotation = Vector3(0.0f, 0.0f, 0.0f);
             m_Prototype = prototype;
             m_IdentifierIndex = INVALID_INSTANCE_POOL_INDEX;
             m_Identifier = UNNAMED_IDENTIFIER;
-            dmHashInit64(&m_CollectionPathHashState, false);
+            m_CollectionPathIndex = INVALID_COLLECTION_PATH_INDEX;
             m_Depth = 0;
             m_Initialized = 0;
             m_ScaleAlongZ = 0;
@@ -112,6 +136,7 @@ namespace dmGameObject
             m_NextToDelete = INVALID_INSTANCE_INDEX;
             m_NextToAdd = INVALID_INSTANCE_INDEX;
             m_ToBeDeleted = 0;
+            m_InDeleteBatch = 0;
             m_ToBeAdded = 0;
         }
 
@@ -119,23 +144,12 @@ namespace dmGameObject
         {
         }
 
-        dmTransform::Transform m_Transform;
-
-        // Shadowed rotation expressed in euler coordinates
-        Vector3 m_EulerRotation;
-        // Previous euler rotation, used to detect if the euler rotation has changed and should overwrite the real rotation (needed by animation)
-        Vector3 m_PrevEulerRotation;
-        // Collection this instances belongs to. Added for GetWorldPosition.
-        // We should consider to remove this (memory footprint)
+        // Collection this instances belongs to. Also owns the transform data of the instance, see Collection::m_LocalTransforms
         struct Collection* m_Collection;
         Prototype*      m_Prototype;
 
-        uint32_t        m_IdentifierIndex;
         dmhash_t        m_Identifier;
-
-        // Collection path hash-state. Used for calculating global identifiers. Contains the hash-state for the collection-path to the instance.
-        // We might, in the future, for memory reasons, move this hash-state to a data-structure shared among all instances from the same collection.
-        HashState64     m_CollectionPathHashState;
+        uint32_t        m_IdentifierIndex;
 
         // Hierarchical depth
         uint16_t        m_Depth : 8;
@@ -151,32 +165,37 @@ namespace dmGameObject
         uint16_t        m_Pad : 4;
 
         // Index to parent
-        uint16_t        m_Parent : 16;
+        InstanceIndex   m_Parent;
 
         // Index to Collection::m_Instances
-        uint16_t        m_Index : 15;
+        InstanceIndex   m_Index : INSTANCE_INDEX_BITS;
         // Used for deferred deletion
-        uint16_t        m_ToBeDeleted : 1;
+        InstanceIndex   m_ToBeDeleted : 1;
 
         // Index to Collection::m_LevelIndex. Index is relative to current level (m_Depth), eg first object in level L always has level-index 0
         // Level-index is used to reorder Collection::m_LevelIndex entries in O(1). Given an instance we need to find where the
         // instance index is located in Collection::m_LevelIndex
-        uint16_t        m_LevelIndex : 15;
-        uint16_t        m_Pad2 : 1;
+        InstanceIndex   m_LevelIndex : INSTANCE_INDEX_BITS;
+        // Set while the instance is part of the batch being deleted in PostUpdate, see DoDeleteInstances()
+        InstanceIndex   m_InDeleteBatch : 1;
 
         // Index to next instance to delete or INVALID_INSTANCE_INDEX
-        uint16_t        m_NextToDelete : 16;
+        InstanceIndex   m_NextToDelete;
 
         // Index to next instance to add-to-update or INVALID_INSTANCE_INDEX
-        uint16_t        m_NextToAdd;
+        InstanceIndex   m_NextToAdd;
 
         // Next sibling index. Index to Collection::m_Instances
-        uint16_t        m_SiblingIndex : 15;
-        uint16_t        m_ToBeAdded : 1;
+        InstanceIndex   m_SiblingIndex : INSTANCE_INDEX_BITS;
+        InstanceIndex   m_ToBeAdded : 1;
 
         // First child index. Index to Collection::m_Instances
-        uint16_t        m_FirstChildIndex : 15;
-        uint16_t        m_Pad4 : 1;
+        InstanceIndex   m_FirstChildIndex : INSTANCE_INDEX_BITS;
+        InstanceIndex   m_Pad4 : 1;
+
+        // Index to Collection::m_CollectionPaths, the hash-state of the collection-path to the instance.
+        // Used for calculating global identifiers. INVALID_COLLECTION_PATH_INDEX for an empty path.
+        uint16_t        m_CollectionPathIndex;
 
         uint32_t        m_ComponentInstanceUserDataCount;
         uintptr_t       m_ComponentInstanceUserData[0];
@@ -200,15 +219,85 @@ namespace dmGameObject
         // Default capacity of collections
         uint32_t                    m_DefaultCollectionCapacity;
         uint32_t                    m_DefaultInputStackCapacity;
+        // Optional job context used to spread work over worker threads
+        dmJob::HContext             m_JobContext;
+        // Optional allocator for per-frame transient data
+        dmFrameAlloc::HAllocator    m_FrameAllocator;
+        // Set when anything that is rendered changed, see ConsumeChanges(). Written from transform jobs
+        int32_atomic_t              m_Changed;
 
         Register();
         ~Register();
     };
 
+    // Uniform grid over the world positions of the instances in a collection, see EnableSpatialIndex()
+    // Each instance is linked into the list of the cell it is in, the lists are indexed by Instance::m_Index
+    struct SpatialIndex
+    {
+        SpatialIndex(uint32_t max_instances, float cell_size);
+
+        // Cell key to first instance index in the cell
+        dmHashTable64<InstanceIndex> m_Cells;
+        // Cell key of each instance, SPATIAL_INDEX_INVALID_CELL if not in the index
+        dmArray<uint64_t>        m_CellKeys;
+        dmArray<InstanceIndex>   m_Next;
+        dmArray<InstanceIndex>   m_Prev;
+        // World positions as of the last UpdateTransforms
+        dmArray<Point3>          m_Positions;
+        float                    m_CellSize;
+        float                    m_InvCellSize;
+    };
+
+    const uint64_t SPATIAL_INDEX_INVALID_CELL = 0xffffffffffffffffULL;
+
+    // Operation in progress by InitIncremental(), FinalIncremental() or DeleteIncremental()
+    enum IncrementalState
+    {
+        INCREMENTAL_STATE_NONE   = 0,
+        INCREMENTAL_STATE_INIT   = 1,
+        INCREMENTAL_STATE_FINAL  = 2,
+        INCREMENTAL_STATE_DELETE = 3,
+    };
+
+    // An instance spawned by SpawnFromCollectionDeferredInit(), waiting to be initialized
+    struct DeferredInit
+    {
+        dmhash_t                 m_Identifier;
+        uint32_t                 m_SpawnId;
+        InstanceIndex            m_Index;
+    };
+
+    // Component of an instance to destroy, see DoDeleteInstances()
+    struct ComponentToDestroy
+    {
+        Instance*                m_Instance;
+        uintptr_t*               m_UserData;
+        uint16_t                 m_TypeIndex;
+    };
+
     // Max hierarchical depth
     // depth is interpreted as up to <depth> levels of child nodes including root-nodes
     // Must be greater than zero
     const uint32_t MAX_HIERARCHICAL_DEPTH = 128;
+
+    // Instances with fewer component user data fields than this have their allocations recycled, see AllocInstance()
+    const uint32_t INSTANCE_POOL_BUCKET_COUNT = 16;
+
+    const uint32_t MESSAGE_RECEIVER_CACHE_SIZE = 512;
+    const uint16_t INVALID_COMPONENT_INDEX = 0xffff;
+
+    // Resolved receiver of a message, see Collection::m_MessageReceiverCache
+    struct MessageReceiver
+    {
+        dmhash_t    m_Path;
+        dmhash_t    m_Fragment;
+        Instance*   m_Instance;
+        // Collection::m_MessageReceiverGeneration at the time of the lookup, 0 for an unused entry
+        uint32_t    m_Generation;
+        // Index of the component when m_Fragment is set
+        uint16_t    m_ComponentIndex;
+    };
+
     struct Collection
     {
         Collection(dmResource::HFactory factory, HRegister regist, uint32_t max_instances, uint32_t max_input_stack_entries);
@@ -236,7 +325,7 @@ namespace dmGameObject
         dmArray<Instance*>       m_Instances;
 
         // Index pool for mapping Instance::m_Index to m_Instances
-        dmIndexPool16            m_InstanceIndices;
+        InstanceIndexPool        m_InstanceIndices;
 
         // Resources referenced through property overrides inside the collection
         dmArray<void*>           m_PropertyResources;
@@ -246,13 +335,59 @@ namespace dmGameObject
         // Two dimensional table of indices with stride "max_instances"
         // Level 0 contains root-nodes in [0..m_LevelIndices[0].Size()-1]
         // Level 1 contains level 1 indices in [0..m_LevelIndices[1].Size()-1]
-        dmArray<uint16_t>        m_LevelIndices[MAX_HIERARCHICAL_DEPTH];
+        dmArray<InstanceIndex>   m_LevelIndices[MAX_HIERARCHICAL_DEPTH];
 
         // Array of world transforms. Calculated using m_LevelIndices above
         dmArray<Matrix4>         m_WorldTransforms;
 
+        // Transform data of the instances, stored as arrays indexed by Instance::m_Index
+        // so that UpdateTransforms doesn't need to touch the instances themselves.
+        // Local transforms
+        dmArray<dmTransform::Transform> m_LocalTransforms;
+        // Shadowed rotation expressed in euler coordinates
+        dmArray<Vector3>         m_EulerRotations;
+        // Previous euler rotation, used to detect if the euler rotation has changed and should overwrite the real rotation (needed by animation)
+        dmArray<Vector3>         m_PrevEulerRotations;
+        // Copy of Instance::m_Parent
+        dmArray<InstanceIndex>   m_ParentIndices;
+        // Per instance TRANSFORM_FLAG_* bits, used to only recompute the world transforms of moved subtrees
+        dmArray<uint8_t>         m_TransformFlags;
+        // Incremented each time the world transform of the instance is recomputed, see GetWorldTransformVersion()
+        dmArray<uint32_t>        m_WorldTransformVersions;
+
+        // Free instance allocations, indexed by component user data count.
+        // Never holds more than m_MaxInstances allocations in total
+        dmArray<void*>           m_InstancePool[INSTANCE_POOL_BUCKET_COUNT];
+        uint32_t                 m_InstancePoolSize;
+
+        // Instances left to initialize from deferred spawns, in spawn order starting at m_DeferredInitHead
+        dmArray<DeferredInit>    m_DeferredInits;
+        uint32_t                 m_DeferredInitHead;
+        // Max time spent on deferred inits in each update, in microseconds
+        uint32_t                 m_DeferredInitTimeBudget;
+        uint32_t                 m_DeferredSpawnCounter;
+
+        // Next instance index of the incremental operation in m_IncrementalState
+        uint32_t                 m_IncrementalIndex;
+        uint32_t                 m_IncrementalCount;
+
+        // Optional index for spatial queries, 0 until enabled
+        SpatialIndex*            m_SpatialIndex;
+
+        // Collection path hash-states shared among all instances spawned with the same path, see Instance::m_CollectionPathIndex
+        dmArray<CollectionPath>  m_CollectionPaths;
+        dmArray<uint16_t>        m_CollectionPathFreeList;
+        // Hash of the collection path to index in m_CollectionPaths
+        dmHashTable64<uint16_t>  m_CollectionPathIndices;
+
         // Identifier to Instance mapping
-        dmHashTable64<Instance*> m_IDToInstance;
+        dmHashMap64<Instance*>   m_IDToInstance;
+
+        // Direct mapped cache of resolved message receivers, to skip the instance and component lookups
+        // when the same urls are posted to frequently
+        MessageReceiver          m_MessageReceiverCache[MESSAGE_RECEIVER_CACHE_SIZE];
+        // Incremented whenever m_IDToInstance changes, which invalidates all entries of m_MessageReceiverCache
+        uint32_t                 m_MessageReceiverGeneration;
 
         // Stack keeping track of which instance has the input focus
         dmArray<Instance*>       m_InputFocusStack;
@@ -273,14 +408,17 @@ namespace dmGameObject
         dmIndexPool32            m_InstanceIdPool;
 
         // Head of linked list of instances scheduled for deferred deletion
-        uint16_t                 m_InstancesToDeleteHead;
+        InstanceIndex            m_InstancesToDeleteHead;
         // Tail of the same list, for O(1) appending
-        uint16_t                 m_InstancesToDeleteTail;
+        InstanceIndex            m_InstancesToDeleteTail;
+        // Scratch arrays for deleting the instances of the list in one batch, see DoDeleteInstances()
+        dmArray<Instance*>           m_DeleteBatch;
+        dmArray<ComponentToDestroy>  m_ComponentsToDestroy;
 
         // Head of linked list of instances scheduled to be added to update
-        uint16_t                 m_InstancesToAddHead;
+        InstanceIndex            m_InstancesToAddHead;
         // Tail of the same list, for O(1) appending
-        uint16_t                 m_InstancesToAddTail;
+        InstanceIndex            m_InstancesToAddTail;
 
         // Set to 1 if in update-loop
         uint32_t                 m_InUpdate : 1;
@@ -290,6 +428,9 @@ namespace dmGameObject
         uint32_t                 m_ScaleAlongZ : 1;
         uint32_t                 m_DirtyTransforms : 1;
         uint32_t                 m_Initialized : 1;
+        // IncrementalState
+        uint32_t                 m_IncrementalState : 2;
+        uint32_t                 m_IncrementalFailed : 1;
     };
 
     struct CollectionHandle
@@ -297,6 +438,47 @@ namespace dmGameObject
         Collection* m_Collection;
     };
 
+    enum TransformFlag
+    {
+        // The local transform (or parent) has changed since the last UpdateTransforms
+        TRANSFORM_FLAG_DIRTY    = 1,
+        // The world transform was recomputed by the last UpdateTransforms, read by the children
+        TRANSFORM_FLAG_CHANGED  = 2,
+    };
+
+    inline void SetTransformDirty(Instance* instance)
+    {
+        instance->m_Collection->m_TransformFlags[instance->m_Index] |= TRANSFORM_FLAG_DIRTY;
+    }
+
+    inline void SetWorldTransform(Collection* collection, InstanceIndex index, const Matrix4& world)
+    {
+        collection->m_WorldTransforms[index] = world;
+        collection->m_WorldTransformVersions[index]++;
+    }
+
+    inline dmTransform::Transform& GetLocalTransform(Instance* instance)
+    {
+        return instance->m_Collection->m_LocalTransforms[instance->m_Index];
+    }
+
+    inline Vector3& GetEulerRotation(Instance* instance)
+    {
+        return instance->m_Collection->m_EulerRotations[instance->m_Index];
+    }
+
+    inline Vector3& GetPrevEulerRotation(Instance* instance)
+    {
+        return instance->m_Collection->m_PrevEulerRotations[instance->m_Index];
+    }
+
+    inline void SetParentIndex(Instance* instance, InstanceIndex parent_index)
+    {
+        instance->m_Parent = parent_index;
+        instance->m_Collection->m_ParentIndices[instance->m_Index] = parent_index;
+        SetTransformDirty(instance);
+    }
+
     ComponentType* FindComponentType(Register* regist, uint32_t resource_type, uint32_t* index);
 
     // Used by res_collection.cpp
@@ -305,6 +487,10 @@ namespace dmGameObject
     void ReleaseInstanceIndex(uint32_t index, HCollection collection);
     Result SetIdentifier(Collection* collection, HInstance instance, const char* identifier);
     void ReleaseIdentifier(Collection* collection, HInstance instance);
+    // Takes ownership of path_state and shares it with all instances having the same collection path
+    void SetCollectionPath(Collection* collection, HInstance instance, HashState64* path_state);
+    void ShareCollectionPath(Collection* collection, HInstance instance, uint16_t path_index);
+    void ReleaseCollectionPath(Collection* collection, HInstance instance);
     void UndoNewInstance(Collection* collection, HInstance instance);
     bool CreateComponents(Collection* collection, HInstance instance);
     void Delete(Collection* collection, HInstance instance, bool recursive);
@@ -26,7 +26,7 @@ static bool IterateCollectionGetNext(SceneNodeIterator* it)
     HCollection hcollection = (HCollection)it->m_Parent.m_Node;
     Collection* collection = hcollection->m_Collection;
 
-    const dmArray<uint16_t>& root_level = collection->m_LevelIndices[0];
+    const dmArray<InstanceIndex>& root_level = collection->m_LevelIndices[0];
 
     // If the index is still valid
     uint64_t index = it->m_NextChild.m_Node;
@@ -69,7 +69,7 @@ static bool IterateGameObjectGetNext(SceneNodeIterator* it)
     // The first range is the valid ranges for game objects, which is less than INVALID_INSTANCE_INDEX
     // The second range is at a safe range above that (component_count_offset)
     const uint32_t invalid_index = 0xFFFFFFFF;
-    const uint32_t component_count_offset = 0xFFFF;
+    const uint32_t component_count_offset = INVALID_INSTANCE_INDEX + 1;
     DM_STATIC_ASSERT(component_count_offset >= INVALID_INSTANCE_INDEX, _ranges_must_not_overlap);
 
     uint32_t index = (uint32_t)it->m_NextChild.m_Node;
@@ -13,6 +13,7 @@
 #include <assert.h>
 #include <string.h>
 #include <inttypes.h>
+#include <algorithm>
 
 #include <ddf/ddf.h>
 
@@ -144,9 +145,11 @@ namespace dmGameObject
 
 #define SCRIPTINSTANCE "GOScriptInstance"
 #define SCRIPT "GOScript"
+#define PROPERTYHANDLE "GOPropertyHandle"
 
     static uint32_t SCRIPT_TYPE_HASH = 0;
     static uint32_t SCRIPTINSTANCE_TYPE_HASH = 0;
+    static uint32_t PROPERTYHANDLE_TYPE_HASH = 0;
 
     using namespace dmPropertiesDDF;
 
@@ -159,16 +162,19 @@ namespace dmGameObject
         "update",
         "on_message",
         "on_input",
-        "on_reload"
+        "on_reload",
+        "update_all"
     };
 
     HRegister g_Register = 0;
 
     CompScriptWorld::CompScriptWorld(uint32_t max_instance_count)
     : m_Instances()
+    , m_UpdateAllInstances()
     , m_ScriptWorld(0x0)
     {
         m_Instances.SetCapacity(max_instance_count);
+        m_UpdateAllInstances.SetCapacity(max_instance_count);
     }
 
     static Script* GetScript(lua_State *L)
@@ -364,6 +370,33 @@ namespace dmGameObject
         {0, 0}
     };
 
+    // Lua side of a property handle, see go.property_handle
+    struct ScriptPropertyHandle
+    {
+        HCollection     m_Collection;
+        // Used to detect that the instance has been deleted
+        dmhash_t        m_InstanceId;
+        PropertyHandle  m_Handle;
+    };
+
+    static int PropertyHandle_tostring(lua_State *L)
+    {
+        ScriptPropertyHandle* h = (ScriptPropertyHandle*)lua_touserdata(L, 1);
+        lua_pushfstring(L, "PropertyHandle: %s %s", dmHashReverseSafe64(h->m_InstanceId), dmHashReverseSafe64(h->m_Handle.m_PropertyId));
+        return 1;
+    }
+
+    static const luaL_reg PropertyHandle_methods[] =
+    {
+        {0,0}
+    };
+
+    static const luaL_reg PropertyHandle_meta[] =
+    {
+        {"__tostring",  PropertyHandle_tostring},
+        {0, 0}
+    };
+
     /**
      * Get instance utility function helper.
      * The function will use the default "this" instance by default
@@ -513,10 +546,180 @@ namespace dmGameObject
         }
     }
 
+    static const char* GetPropertyTypeName(PropertyType type)
+    {
+        switch (type)
+        {
+        case PROPERTY_TYPE_NUMBER:
+            return "number";
+        case PROPERTY_TYPE_HASH:
+            return "hash";
+        case PROPERTY_TYPE_URL:
+            return "msg.url";
+        case PROPERTY_TYPE_VECTOR3:
+            return "vmath.vector3";
+        case PROPERTY_TYPE_VECTOR4:
+            return "vmath.vector4";
+        case PROPERTY_TYPE_QUAT:
+            return "vmath.quat";
+        case PROPERTY_TYPE_BOOLEAN:
+            return "boolean";
+        default:
+            return "unknown";
+        }
+    }
+
+    static int PropertyHandleError(lua_State* L, const char* function_name, PropertyResult result, const ScriptPropertyHandle* handle)
+    {
+        const char* path = dmHashReverseSafe64(handle->m_InstanceId);
+        const char* property = dmHashReverseSafe64(handle->m_Handle.m_PropertyId);
+        switch (result)
+        {
+        case PROPERTY_RESULT_UNSUPPORTED_TYPE:
+        case PROPERTY_RESULT_TYPE_MISMATCH:
+            return luaL_error(L, "the property '%s' of '%s' must be a %s", property, path, GetPropertyTypeName(handle->m_Handle.m_Type));
+        case PROPERTY_RESULT_UNSUPPORTED_VALUE:
+            return luaL_error(L, "%s failed because the value is unsupported", function_name);
+        case PROPERTY_RESULT_UNSUPPORTED_OPERATION:
+            return luaL_error(L, "could not perform unsupported operation on '%s'", property);
+        default:
+            // Should never happen, programmer error
+            return luaL_error(L, "%s failed with error code %d", function_name, result);
+        }
+    }
+
+    static void CheckHandleInstance(lua_State* L, const char* function_name, ScriptInstance* i, const ScriptPropertyHandle* handle)
+    {
+        HCollection collection = dmGameObject::GetCollection(i->m_Instance);
+        if (handle->m_Collection != collection)
+        {
+            luaL_error(L, "%s can only access instances within the same collection.", function_name);
+        }
+        if (dmGameObject::GetInstanceFromIdentifier(collection, handle->m_InstanceId) != handle->m_Handle.m_Instance)
+        {
+            luaL_error(L, "the instance '%s' of the property handle has been deleted", dmHashReverseSafe64(handle->m_InstanceId));
+        }
+    }
+
+    static int GetHandleProperty(lua_State* L, ScriptInstance* i, const ScriptPropertyHandle* handle)
+    {
+        CheckHandleInstance(L, "go.get", i, handle);
+        dmGameObject::PropertyDesc property_desc;
+        dmGameObject::PropertyResult result = dmGameObject::GetProperty(handle->m_Handle, property_desc);
+        if (result != PROPERTY_RESULT_OK)
+        {
+            return PropertyHandleError(L, "go.get", result, handle);
+        }
+        dmGameObject::LuaPushVar(L, property_desc.m_Variant);
+        return 1;
+    }
+
+    static int SetHandleProperty(lua_State* L, ScriptInstance* i, const ScriptPropertyHandle* handle)
+    {
+        CheckHandleInstance(L, "go.set", i, handle);
+        dmGameObject::PropertyVar property_var;
+        dmGameObject::PropertyResult result = dmGameObject::LuaToVar(L, 2, property_var);
+        if (result == PROPERTY_RESULT_OK)
+        {
+            result = dmGameObject::SetProperty(handle->m_Handle, property_var);
+        }
+        if (result != PROPERTY_RESULT_OK)
+        {
+            return PropertyHandleError(L, "go.set", result, handle);
+        }
+        return 0;
+    }
+
+    /*# resolves a property of a game object or component into a handle
+     * Resolves the game object, component and property once, so that the property
+     * can be read and written repeatedly with [ref:go.get] and [ref:go.set] without
+     * looking them up again. This is faster when the same property is accessed every frame.
+     *
+     * The handle can only be used from scripts in the same collection,
+     * and becomes invalid when the game object is deleted.
+     *
+     * @name go.property_handle
+     * @param url [type:string|hash|url] url of the game object or component having the property
+     * @param property [type:string|hash] id of the property
+     * @return handle [type:property_handle] handle to pass to [ref:go.get] and [ref:go.set]
+     * @examples
+     *
+     * ```lua
+     * function init(self)
+     *     self.x = go.property_handle("/player", "position.x")
+     * end
+     *
+     * function update(self, dt)
+     *     go.set(self.x, go.get(self.x) + self.speed * dt)
+     * end
+     * ```
+     */
+    int Script_PropertyHandle(lua_State* L)
+    {
+        ScriptInstance* i = ScriptInstance_Check(L);
+        HCollection collection = dmGameObject::GetCollection(i->m_Instance);
+        dmMessage::URL sender;
+        dmScript::GetURL(L, &sender);
+        dmMessage::URL target;
+        dmScript::ResolveURL(L, 1, &target, &sender);
+        if (target.m_Socket != dmGameObject::GetMessageSocket(collection))
+        {
+            return luaL_error(L, "go.property_handle can only access instances within the same collection.");
+        }
+        dmhash_t property_id = 0;
+        if (lua_isstring(L, 2))
+        {
+            property_id = dmScript::HashString(L, 2);
+        }
+        else
+        {
+            property_id = dmScript::CheckHash(L, 2);
+        }
+        dmGameObject::HInstance target_instance = dmGameObject::GetInstanceFromIdentifier(collection, target.m_Path);
+        if (target_instance == 0)
+            return luaL_error(L, "Could not find any instance with id '%s'.", dmHashReverseSafe64(target.m_Path));
+
+        dmGameObject::PropertyHandle property_handle;
+        dmGameObject::PropertyDesc property_desc;
+        dmGameObject::PropertyResult result = dmGameObject::GetPropertyHandle(target_instance, target.m_Fragment, property_id, property_handle, property_desc);
+        switch (result)
+        {
+        case dmGameObject::PROPERTY_RESULT_OK:
+            break;
+        case dmGameObject::PROPERTY_RESULT_NOT_FOUND:
+            {
+                const char* path = dmHashReverseSafe64(target.m_Path);
+                const char* property = dmHashReverseSafe64(property_id);
+                if (target.m_Fragment)
+                {
+                    return luaL_error(L, "'%s#%s' does not have any property called '%s'", path, dmHashReverseSafe64(target.m_Fragment), property);
+                }
+                else
+                {
+                    return luaL_error(L, "'%s' does not have any property called '%s'", path, property);
+                }
+            }
+        case dmGameObject::PROPERTY_RESULT_COMP_NOT_FOUND:
+            return luaL_error(L, "could not find component '%s' when resolving '%s'", dmHashReverseSafe64(target.m_Fragment), lua_tostring(L, 1));
+        default:
+            // Should never happen, programmer error
+            return luaL_error(L, "go.property_handle failed with error code %d", result);
+        }
+
+        ScriptPropertyHandle* handle = (ScriptPropertyHandle*)lua_newuserdata(L, sizeof(ScriptPropertyHandle));
+        handle->m_Collection = collection;
+        handle->m_InstanceId = target.m_Path;
+        handle->m_Handle = property_handle;
+        luaL_getmetatable(L, PROPERTYHANDLE);
+        lua_setmetatable(L, -2);
+        return 1;
+    }
+
     /*# gets a named property of the specified game object or component
      *
      * @name go.get
-     * @param url [type:string|hash|url] url of the game object or component having the property
+     * @param url [type:string|hash|url|property_handle] url of the game object or component having the property,
+     * or a handle from [ref:go.property_handle], in which case the property argument is omitted
      * @param property [type:string|hash] id of the property to retrieve
      * @return value [type:any] the value of the specified property
      * @examples
@@ -537,6 +740,11 @@ namespace dmGameObject
     {
         ScriptInstance* i = ScriptInstance_Check(L);
         Instance* instance = i->m_Instance;
+        ScriptPropertyHandle* handle = (ScriptPropertyHandle*)dmScript::ToUserType(L, 1, PROPERTYHANDLE_TYPE_HASH);
+        if (handle)
+        {
+            return GetHandleProperty(L, i, handle);
+        }
         dmMessage::URL sender;
         dmScript::GetURL(L, &sender);
         dmMessage::URL target;
@@ -548,7 +756,7 @@ namespace dmGameObject
         dmhash_t property_id = 0;
         if (lua_isstring(L, 2))
         {
-            property_id = dmHashString64(lua_tostring(L, 2));
+            property_id = dmScript::HashString(L, 2);
         }
         else
         {
@@ -585,33 +793,11 @@ namespace dmGameObject
         }
     }
 
-    static const char* GetPropertyTypeName(PropertyType type)
-    {
-        switch (type)
-        {
-        case PROPERTY_TYPE_NUMBER:
-            return "number";
-        case PROPERTY_TYPE_HASH:
-            return "hash";
-        case PROPERTY_TYPE_URL:
-            return "msg.url";
-        case PROPERTY_TYPE_VECTOR3:
-            return "vmath.vector3";
-        case PROPERTY_TYPE_VECTOR4:
-            return "vmath.vector4";
-        case PROPERTY_TYPE_QUAT:
-            return "vmath.quat";
-        case PROPERTY_TYPE_BOOLEAN:
-            return "boolean";
-        default:
-            return "unknown";
-        }
-    }
-
     /*# sets a named property of the specified game object or component, or a material constant
      *
      * @name go.set
-     * @param url [type:string|hash|url] url of the game object or component having the property
+     * @param url [type:string|hash|url|property_handle] url of the game object or component having the property,
+     * or a handle from [ref:go.property_handle], in which case the property argument is omitted
      * @param property [type:string|hash] id of the property to set
      * @param value [type:any] the value to set
      * @examples
@@ -632,6 +818,11 @@ namespace dmGameObject
     {
         ScriptInstance* i = ScriptInstance_Check(L);
         Instance* instance = i->m_Instance;
+        ScriptPropertyHandle* handle = (ScriptPropertyHandle*)dmScript::ToUserType(L, 1, PROPERTYHANDLE_TYPE_HASH);
+        if (handle)
+        {
+            return SetHandleProperty(L, i, handle);
+        }
         dmMessage::URL sender;
         dmScript::GetURL(L, &sender);
         dmMessage::URL target;
@@ -643,7 +834,7 @@ namespace dmGameObject
         dmhash_t property_id = 0;
         if (lua_isstring(L, 2))
         {
-            property_id = dmHashString64(lua_tostring(L, 2));
+            property_id = dmScript::HashString(L, 2);
         }
         else
         {
@@ -696,6 +887,250 @@ namespace dmGameObject
         }
     }
 
+    // Resolves the url at the top of the stack for go.get_many/go.set_many
+    static HInstance CheckManyTarget(lua_State* L, const char* function_name, HCollection collection, dmMessage::URL* sender, uint32_t url_index, dmMessage::URL* target)
+    {
+        dmScript::ResolveURL(L, lua_gettop(L), target, sender);
+        if (target->m_Socket != dmGameObject::GetMessageSocket(collection))
+        {
+            luaL_error(L, "%s can only access instances within the same collection.", function_name);
+        }
+        HInstance target_instance = dmGameObject::GetInstanceFromIdentifier(collection, target->m_Path);
+        if (target_instance == 0)
+        {
+            luaL_error(L, "could not find any instance with id '%s' (urls[%d]).", dmHashReverseSafe64(target->m_Path), url_index);
+        }
+        return target_instance;
+    }
+
+    static int PropertyManyError(lua_State* L, const char* function_name, PropertyResult result, HInstance target_instance, const dmMessage::URL* target, uint32_t url_index, dmhash_t property_id)
+    {
+        const char* path = dmHashReverseSafe64(target->m_Path);
+        const char* property = dmHashReverseSafe64(property_id);
+        switch (result)
+        {
+        case PROPERTY_RESULT_NOT_FOUND:
+            if (target->m_Fragment)
+            {
+                return luaL_error(L, "'%s#%s' (urls[%d]) does not have any property called '%s'", path, dmHashReverseSafe64(target->m_Fragment), url_index, property);
+            }
+            return luaL_error(L, "'%s' (urls[%d]) does not have any property called '%s'", path, url_index, property);
+        case PROPERTY_RESULT_UNSUPPORTED_TYPE:
+        case PROPERTY_RESULT_TYPE_MISMATCH:
+            {
+                dmGameObject::PropertyDesc property_desc;
+                dmGameObject::GetProperty(target_instance, target->m_Fragment, property_id, property_desc);
+                return luaL_error(L, "the property '%s' of '%s' (urls[%d]) must be a %s", property, path, url_index, GetPropertyTypeName(property_desc.m_Variant.m_Type));
+            }
+        case PROPERTY_RESULT_COMP_NOT_FOUND:
+            return luaL_error(L, "could not find component '%s' when resolving urls[%d]", dmHashReverseSafe64(target->m_Fragment), url_index);
+        case PROPERTY_RESULT_UNSUPPORTED_VALUE:
+            return luaL_error(L, "%s failed because the value is unsupported", function_name);
+        case PROPERTY_RESULT_UNSUPPORTED_OPERATION:
+            return luaL_error(L, "could not perform unsupported operation on '%s'", property);
+        default:
+            // Should never happen, programmer error
+            return luaL_error(L, "%s failed with error code %d", function_name, result);
+        }
+    }
+
+    // Writes vector values into the vector already at the top of the stack, to avoid creating garbage each frame
+    static bool UpdateVarInPlace(lua_State* L, const PropertyVar& var)
+    {
+        switch (var.m_Type)
+        {
+        case PROPERTY_TYPE_VECTOR3:
+            {
+                Vectormath::Aos::Vector3* v = dmScript::ToVector3(L, -1);
+                if (v)
+                {
+                    *v = Vectormath::Aos::Vector3(var.m_V4[0], var.m_V4[1], var.m_V4[2]);
+                }
+                return v != 0;
+            }
+        case PROPERTY_TYPE_VECTOR4:
+            {
+                Vectormath::Aos::Vector4* v = dmScript::ToVector4(L, -1);
+                if (v)
+                {
+                    *v = Vectormath::Aos::Vector4(var.m_V4[0], var.m_V4[1], var.m_V4[2], var.m_V4[3]);
+                }
+                return v != 0;
+            }
+        case PROPERTY_TYPE_QUAT:
+            {
+                Vectormath::Aos::Quat* q = dmScript::ToQuat(L, -1);
+                if (q)
+                {
+                    *q = Vectormath::Aos::Quat(var.m_V4[0], var.m_V4[1], var.m_V4[2], var.m_V4[3]);
+                }
+                return q != 0;
+            }
+        default:
+            return false;
+        }
+    }
+
+    /*# gets a named property of several game objects or components
+     * Gets the same property from every url in a list, with a single call.
+     * This is considerably faster than calling [ref:go.get] for each url when there are many instances.
+     *
+     * If a table to fill is supplied, vector and quaternion values already in it are updated
+     * in place instead of being replaced, so that reading the property every frame doesn't create any garbage.
+     *
+     * @name go.get_many
+     * @param urls [type:table] list of urls of the game objects or components having the property
+     * @param property [type:string|hash] id of the property to retrieve
+     * @param [values] [type:table] optional table to fill with the values, a new table is created by default
+     * @return values [type:table] the value of the property for each url, in the same order as the urls
+     * @examples
+     *
+     * Read the positions of a crowd of game objects each frame:
+     *
+     * ```lua
+     * function init(self)
+     *     self.crowd = { hash("/walker1"), hash("/walker2"), hash("/walker3") }
+     *     self.positions = {}
+     * end
+     *
+     * function update(self, dt)
+     *     go.get_many(self.crowd, "position", self.positions)
+     * end
+     * ```
+     */
+    int Script_GetMany(lua_State* L)
+    {
+        ScriptInstance* i = ScriptInstance_Check(L);
+        HCollection collection = dmGameObject::GetCollection(i->m_Instance);
+        luaL_checktype(L, 1, LUA_TTABLE);
+        dmhash_t property_id = 0;
+        if (lua_isstring(L, 2))
+        {
+            property_id = dmScript::HashString(L, 2);
+        }
+        else
+        {
+            property_id = dmScript::CheckHash(L, 2);
+        }
+        uint32_t count = (uint32_t) lua_objlen(L, 1);
+        if (lua_isnoneornil(L, 3))
+        {
+            lua_createtable(L, count, 0);
+        }
+        else
+        {
+            luaL_checktype(L, 3, LUA_TTABLE);
+            lua_pushvalue(L, 3);
+        }
+        int values_index = lua_gettop(L);
+
+        dmMessage::URL sender;
+        dmScript::GetURL(L, &sender);
+        for (uint32_t n = 1; n <= count; ++n)
+        {
+            dmMessage::URL target;
+            lua_rawgeti(L, 1, n);
+            HInstance target_instance = CheckManyTarget(L, "go.get_many", collection, &sender, n, &target);
+            lua_pop(L, 1);
+
+            dmGameObject::PropertyDesc property_desc;
+            dmGameObject::PropertyResult result = dmGameObject::GetProperty(target_instance, target.m_Fragment, property_id, property_desc);
+            if (result != PROPERTY_RESULT_OK)
+            {
+                return PropertyManyError(L, "go.get_many", result, target_instance, &target, n, property_id);
+            }
+
+            lua_rawgeti(L, values_index, n);
+            bool updated = UpdateVarInPlace(L, property_desc.m_Variant);
+            lua_pop(L, 1);
+            if (!updated)
+            {
+                dmGameObject::LuaPushVar(L, property_desc.m_Variant);
+                lua_rawseti(L, values_index, n);
+            }
+        }
+        return 1;
+    }
+
+    /*# sets a named property of several game objects or components
+     * Sets the same property on every url in a list, with a single call.
+     * This is considerably faster than calling [ref:go.set] for each url when there are many instances.
+     *
+     * @name go.set_many
+     * @param urls [type:table] list of urls of the game objects or components having the property
+     * @param property [type:string|hash] id of the property to set
+     * @param values [type:table|any] the value for each url, in the same order as the urls, or a single value to set on all of them
+     * @examples
+     *
+     * Move a crowd of game objects each frame:
+     *
+     * ```lua
+     * function update(self, dt)
+     *     for i, p in ipairs(self.positions) do
+     *         p.x = p.x + self.speed * dt
+     *     end
+     *     go.set_many(self.crowd, "position", self.positions)
+     * end
+     * ```
+     *
+     * Hide a group of sprites:
+     *
+     * ```lua
+     * go.set_many({ "/a#sprite", "/b#sprite" }, "tint.w", 0)
+     * ```
+     */
+    int Script_SetMany(lua_State* L)
+    {
+        ScriptInstance* i = ScriptInstance_Check(L);
+        HCollection collection = dmGameObject::GetCollection(i->m_Instance);
+        luaL_checktype(L, 1, LUA_TTABLE);
+        dmhash_t property_id = 0;
+        if (lua_isstring(L, 2))
+        {
+            property_id = dmScript::HashString(L, 2);
+        }
+        else
+        {
+            property_id = dmScript::CheckHash(L, 2);
+        }
+        luaL_checkany(L, 3);
+        bool per_instance = lua_type(L, 3) == LUA_TTABLE;
+        uint32_t count = (uint32_t) lua_objlen(L, 1);
+
+        dmMessage::URL sender;
+        dmScript::GetURL(L, &sender);
+        dmGameObject::PropertyVar property_var;
+        for (uint32_t n = 1; n <= count; ++n)
+        {
+            dmMessage::URL target;
+            lua_rawgeti(L, 1, n);
+            HInstance target_instance = CheckManyTarget(L, "go.set_many", collection, &sender, n, &target);
+            lua_pop(L, 1);
+
+            dmGameObject::PropertyResult result = PROPERTY_RESULT_OK;
+            if (per_instance)
+            {
+                lua_rawgeti(L, 3, n);
+                result = dmGameObject::LuaToVar(L, -1, property_var);
+                lua_pop(L, 1);
+            }
+            else if (n == 1)
+            {
+                // The same value for all instances, only converted once
+                result = dmGameObject::LuaToVar(L, 3, property_var);
+            }
+            if (result == PROPERTY_RESULT_OK)
+            {
+                result = dmGameObject::SetProperty(target_instance, target.m_Fragment, property_id, property_var);
+            }
+            if (result != PROPERTY_RESULT_OK)
+            {
+                return PropertyManyError(L, "go.set_many", result, target_instance, &target, n, property_id);
+            }
+        }
+        return 0;
+    }
+
     /*# gets the position of a game object instance
      * The position is relative the parent (if any). Use [ref:go.get_world_position] to retrieve the global world position.
      *
@@ -1260,6 +1695,55 @@ namespace dmGameObject
         return 1;
     }
 
+    /*# limits the input actions passed to on_input
+     * Only the listed actions are passed to the `on_input` function of the calling script.
+     * Other actions skip the script entirely, which saves a call into Lua for every action
+     * the script would ignore anyway. This is useful when many scripts have input focus.
+     *
+     * While a filter is set, cursor movement that is not bound to an action (`action_id` is `nil`)
+     * is not passed to the script either.
+     *
+     * Call the function without arguments to pass all actions to the script again.
+     *
+     * @name go.set_input_filter
+     * @param [actions] [type:table] list of action ids, as hashes or strings
+     * @examples
+     *
+     * Only receive touch and jump actions:
+     *
+     * ```lua
+     * function init(self)
+     *     msg.post(".", "acquire_input_focus")
+     *     go.set_input_filter({ hash("touch"), "jump" })
+     * end
+     * ```
+     */
+    int Script_SetInputFilter(lua_State* L)
+    {
+        ScriptInstance* i = ScriptInstance_Check(L);
+        dmArray<dmhash_t>& filter = i->m_InputFilter;
+        filter.SetSize(0);
+        if (lua_isnoneornil(L, 1))
+        {
+            return 0;
+        }
+
+        luaL_checktype(L, 1, LUA_TTABLE);
+        uint32_t count = (uint32_t) lua_objlen(L, 1);
+        if (filter.Capacity() < count)
+        {
+            filter.SetCapacity(count);
+        }
+        for (uint32_t j = 0; j < count; ++j)
+        {
+            lua_rawgeti(L, 1, (int) j + 1);
+            filter.Push(dmScript::CheckHashOrString(L, -1));
+            lua_pop(L, 1);
+        }
+        std::sort(filter.Begin(), filter.End());
+        return 0;
+    }
+
     static lua_State* GetLuaState(ScriptInstance* instance) {
         return instance->m_Script->m_LuaState;
     }
@@ -1402,7 +1886,7 @@ namespace dmGameObject
         dmhash_t property_id = 0;
         if (lua_isstring(L, 2))
         {
-            property_id = dmHashString64(lua_tostring(L, 2));
+            property_id = dmScript::HashString(L, 2);
         }
         else
         {
@@ -1539,7 +2023,7 @@ namespace dmGameObject
         dmhash_t property_id = 0;
         if (lua_isstring(L, 2))
         {
-            property_id = dmHashString64(lua_tostring(L, 2));
+            property_id = dmScript::HashString(L, 2);
         }
         else
         {
@@ -1778,6 +2262,93 @@ namespace dmGameObject
         return result;
     }
 
+    struct QueryResultContext
+    {
+        lua_State*  m_L;
+        int         m_Table;
+        uint32_t    m_Count;
+    };
+
+    static void PushQueryResult(HInstance instance, void* user_data)
+    {
+        QueryResultContext* ctx = (QueryResultContext*) user_data;
+        dmScript::PushHash(ctx->m_L, dmGameObject::GetIdentifier(instance));
+        lua_rawseti(ctx->m_L, ctx->m_Table, ++ctx->m_Count);
+    }
+
+    /*# finds game objects inside a box
+     * Returns the ids of the game object instances in the collection of the calling script
+     * with a world position inside the axis aligned box. The world positions are the ones calculated
+     * at the end of the previous frame, see [ref:go.get_world_position].
+     *
+     * The query uses a spatial index of the collection that is created on the first query
+     * and then kept up to date with the instances that move.
+     *
+     * @name go.query_aabb
+     * @param min [type:vector3] minimum corner of the box
+     * @param max [type:vector3] maximum corner of the box
+     * @return ids [type:table] the ids of the instances found, in no particular order
+     * @examples
+     *
+     * ```lua
+     * local ids = go.query_aabb(vmath.vector3(0, 0, -1), vmath.vector3(100, 100, 1))
+     * for _, id in ipairs(ids) do
+     *     msg.post(id, "alert")
+     * end
+     * ```
+     */
+    int Script_QueryAABB(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 1);
+        ScriptInstance* i = ScriptInstance_Check(L);
+        Vectormath::Aos::Vector3* min = dmScript::CheckVector3(L, 1);
+        Vectormath::Aos::Vector3* max = dmScript::CheckVector3(L, 2);
+
+        lua_newtable(L);
+        QueryResultContext ctx;
+        ctx.m_L = L;
+        ctx.m_Table = lua_gettop(L);
+        ctx.m_Count = 0;
+        dmGameObject::QueryAABB(dmGameObject::GetCollection(i->m_Instance), Vectormath::Aos::Point3(*min), Vectormath::Aos::Point3(*max), PushQueryResult, &ctx);
+        return 1;
+    }
+
+    /*# finds game objects within a radius
+     * Returns the ids of the game object instances in the collection of the calling script
+     * with a world position within the radius. The world positions are the ones calculated
+     * at the end of the previous frame, see [ref:go.get_world_position].
+     *
+     * The query uses a spatial index of the collection that is created on the first query
+     * and then kept up to date with the instances that move.
+     *
+     * @name go.query_radius
+     * @param position [type:vector3] center of the query
+     * @param radius [type:number] radius of the query
+     * @return ids [type:table] the ids of the instances found, in no particular order
+     * @examples
+     *
+     * Find the neighbours of the instance of the calling script:
+     *
+     * ```lua
+     * local ids = go.query_radius(go.get_world_position(), 50)
+     * ```
+     */
+    int Script_QueryRadius(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 1);
+        ScriptInstance* i = ScriptInstance_Check(L);
+        Vectormath::Aos::Vector3* position = dmScript::CheckVector3(L, 1);
+        float radius = (float) luaL_checknumber(L, 2);
+
+        lua_newtable(L);
+        QueryResultContext ctx;
+        ctx.m_L = L;
+        ctx.m_Table = lua_gettop(L);
+        ctx.m_Count = 0;
+        dmGameObject::QueryRadius(dmGameObject::GetCollection(i->m_Instance), Vectormath::Aos::Point3(*position), radius, PushQueryResult, &ctx);
+        return 1;
+    }
+
     /* OMITTED FROM API DOCS!
      * constructs a ray in world space from a position in screen space
      *
@@ -1887,6 +2458,9 @@ namespace dmGameObject
     {
         {"get",                     Script_Get},
         {"set",                     Script_Set},
+        {"get_many",                Script_GetMany},
+        {"set_many",                Script_SetMany},
+        {"property_handle",         Script_PropertyHandle},
         {"get_position",            Script_GetPosition},
         {"get_rotation",            Script_GetRotation},
         {"get_scale",               Script_GetScale},
@@ -1903,10 +2477,13 @@ namespace dmGameObject
         {"get_world_scale_uniform", Script_GetWorldScaleUniform},
         {"get_world_transform",     Script_GetWorldTransform},
         {"get_id",                  Script_GetId},
+        {"set_input_filter",        Script_SetInputFilter},
         {"animate",                 Script_Animate},
         {"cancel_animations",       Script_CancelAnimations},
         {"delete",                  Script_Delete},
         {"delete_all",              Script_DeleteAll},
+        {"query_aabb",              Script_QueryAABB},
+        {"query_radius",            Script_QueryRadius},
         {"screen_ray",              Script_ScreenRay},
         {"property",                Script_Property},
         {0, 0}
@@ -1925,6 +2502,8 @@ namespace dmGameObject
 
         SCRIPTINSTANCE_TYPE_HASH = dmScript::RegisterUserType(L, SCRIPTINSTANCE, ScriptInstance_methods, ScriptInstance_meta);
 
+        PROPERTYHANDLE_TYPE_HASH = dmScript::RegisterUserType(L, PROPERTYHANDLE, PropertyHandle_methods, PropertyHandle_meta);
+
         luaL_register(L, "go", GO_methods);
 
 #define SETPLAYBACK(name) \
@@ -2455,6 +3034,39 @@ const char* TYPE_NAMES[PROPERTY_TYPE_COUNT] = {
      * ```
      */
 
+    /*# called every frame to update all instances of the script component
+     *
+     * This is an optional callback-function, which is called by the engine once every frame for all instances
+     * of the script component in a collection, instead of calling `update` once per instance. It is useful when
+     * there are many instances of the same script, since calling into the script is much more expensive than
+     * iterating over the instances within the script.
+     *
+     * The `instances` parameter is an iterator function. Each call returns the next instance and makes it the
+     * current instance, so that functions like `go.get_position()` operate on it, and returns `nil` when there
+     * are no more instances. The iterator can only be used during the call.
+     *
+     * If a script defines `update_all`, its `update` function is not called.
+     *
+     * @name update_all
+     * @param instances [type:function] iterator over the script instances, returns the next `self`
+     * @param dt [type:number] the time-step of the frame update
+     * @examples
+     *
+     * This example demonstrates how to move all instances of a script component:
+     *
+     * ```lua
+     * function init(self)
+     *     self.my_velocity = vmath.vector3(1, 0, 0)
+     * end
+     *
+     * function update_all(instances, dt)
+     *     for self in instances do
+     *         go.set_position(go.get_position() + dt * self.my_velocity)
+     *     end
+     * end
+     * ```
+     */
+
     /*# called when a message has been sent to the script component
      *
      * This is a callback-function, which is called by the engine whenever a message has been sent to the script component.
@@ -2542,6 +3154,7 @@ const char* TYPE_NAMES[PROPERTY_TYPE_COUNT] = {
      * `screen_dx` | The change in screen space x value of a pointer device, if present.
      * `screen_dy` | The change in screen space y value of a pointer device, if present.
      * `gamepad`   | The index of the gamepad device that provided the input.
+     * `timestamp` | The time, in seconds, when the input was sampled. Use it to measure the time between inputs, e.g. for gestures.
      * `touch`     | List of touch input, one element per finger, if present. See table below about touch input
      *
      * Touch input table:
@@ -48,6 +48,7 @@ namespace dmGameObject
         SCRIPT_FUNCTION_ONMESSAGE,
         SCRIPT_FUNCTION_ONINPUT,
         SCRIPT_FUNCTION_ONRELOAD,
+        SCRIPT_FUNCTION_UPDATE_ALL,
         MAX_SCRIPT_FUNCTION_COUNT
     };
 
@@ -76,6 +77,8 @@ namespace dmGameObject
         int         m_ContextTableReference;
         uint16_t    m_ComponentIndex;
         HProperties m_Properties;
+        // Sorted ids of the actions passed to on_input, all actions if empty (see go.set_input_filter)
+        dmArray<dmhash_t> m_InputFilter;
         uint16_t    m_Update : 1;
         uint16_t    m_Padding : 15;
     };
@@ -85,6 +88,8 @@ namespace dmGameObject
         CompScriptWorld(uint32_t max_instance_count);
 
         dmArray<ScriptInstance*> m_Instances;
+        // Instances of scripts with an update_all function, grouped by script each update
+        dmArray<ScriptInstance*> m_UpdateAllInstances;
         dmScript::HScriptWorld m_ScriptWorld;
     };
 
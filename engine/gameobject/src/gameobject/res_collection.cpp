@@ -74,9 +74,10 @@ namespace dmGameObject
                     scale = Vector3(instance_desc.m_Scale, instance_desc.m_Scale, instance_desc.m_Scale);
                 }
 
-                instance->m_Transform = dmTransform::Transform(Vector3(instance_desc.m_Position), instance_desc.m_Rotation, scale);
+                GetLocalTransform(instance) = dmTransform::Transform(Vector3(instance_desc.m_Position), instance_desc.m_Rotation, scale);
 
-                dmHashInit64(&instance->m_CollectionPathHashState, true);
+                HashState64 path_state;
+                dmHashInit64(&path_state, false);
                 const char* path_end = strrchr(instance_desc.m_Id, *ID_SEPARATOR);
                 if (path_end == 0x0)
                 {
@@ -84,8 +85,9 @@ namespace dmGameObject
                 }
                 else
                 {
-                    dmHashUpdateBuffer64(&instance->m_CollectionPathHashState, instance_desc.m_Id, path_end - instance_desc.m_Id + 1);
+                    dmHashUpdateBuffer64(&path_state, instance_desc.m_Id, path_end - instance_desc.m_Id + 1);
                 }
+                dmGameObject::SetCollectionPath(collection, instance, &path_state);
 
                 if (dmGameObject::SetIdentifier(collection, instance, instance_desc.m_Id) != dmGameObject::RESULT_OK)
                 {
@@ -241,8 +243,12 @@ bail:
     static size_t CalcSize(Collection* collection)
     {
         size_t size = sizeof(Collection) + sizeof(CollectionHandle);
-        size += collection->m_InstanceIndices.Capacity()*sizeof(uint16_t);
+        size += collection->m_InstanceIndices.Capacity()*sizeof(InstanceIndex);
         size += collection->m_WorldTransforms.Capacity()*sizeof(Matrix4);
+        size += collection->m_LocalTransforms.Capacity()*sizeof(dmTransform::Transform);
+        size += collection->m_EulerRotations.Capacity()*sizeof(Vector3);
+        size += collection->m_PrevEulerRotations.Capacity()*sizeof(Vector3);
+        size += collection->m_ParentIndices.Capacity()*sizeof(InstanceIndex);
         size += collection->m_IDToInstance.Capacity()*(sizeof(Instance*)+sizeof(dmhash_t));
         size += collection->m_InputFocusStack.Capacity()*sizeof(Instance*);
         size += collection->m_Instances.Capacity()*sizeof(Instance*);
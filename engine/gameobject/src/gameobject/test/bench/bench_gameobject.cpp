@@ -0,0 +1,113 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <dlib/benchmark.h>
+#include <dlib/dstrings.h>
+#include <dlib/hash.h>
+#include <dlib/hashtable.h>
+#include <resource/resource.h>
+#include "../../gameobject.h"
+#include "../../gameobject_private.h"
+
+// Benchmarks of the game object hot paths. Run with --benchmark_out=<path> to get the results as JSON.
+
+using namespace Vectormath::Aos;
+
+// Instance count of the largest benchmark. A collection can't hold more than INVALID_INSTANCE_INDEX - 1 instances.
+static const uint32_t MAX_INSTANCES = 30000;
+
+// Every fourth instance is a root, with the three following instances as a chain of children
+static const uint32_t CHAIN_LENGTH = 4;
+
+struct TransformContext
+{
+    dmGameObject::HCollection   m_Collection;
+    dmGameObject::HInstance*    m_Instances;
+    uint32_t                    m_Count;
+};
+
+static void BenchUpdateTransformsMoved(void* _ctx, uint32_t iterations)
+{
+    TransformContext* ctx = (TransformContext*)_ctx;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        float x = (float)(i & 255);
+        for (uint32_t j = 0; j < ctx->m_Count; j += CHAIN_LENGTH)
+        {
+            dmGameObject::SetPosition(ctx->m_Instances[j], Point3(x, 0.0f, 0.0f));
+        }
+        dmGameObject::UpdateTransforms(ctx->m_Collection->m_Collection);
+    }
+}
+
+static void BenchUpdateTransformsStatic(void* _ctx, uint32_t iterations)
+{
+    TransformContext* ctx = (TransformContext*)_ctx;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        dmGameObject::UpdateTransforms(ctx->m_Collection->m_Collection);
+    }
+}
+
+static void RunTransforms(dmResource::HFactory factory, dmGameObject::HRegister regist, uint32_t count)
+{
+    TransformContext ctx;
+    ctx.m_Collection = dmGameObject::NewCollection("bench", factory, regist, count);
+    ctx.m_Instances = new dmGameObject::HInstance[count];
+    ctx.m_Count = count;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        dmGameObject::HInstance instance = dmGameObject::New(ctx.m_Collection, 0x0);
+        dmGameObject::SetPosition(instance, Point3(1.0f, 2.0f, 0.0f));
+        dmGameObject::SetRotation(instance, Quat::rotationZ(0.1f));
+        if (i % CHAIN_LENGTH != 0)
+        {
+            dmGameObject::SetParent(instance, ctx.m_Instances[i - 1]);
+        }
+        ctx.m_Instances[i] = instance;
+    }
+
+    char name[64];
+    dmSnPrintf(name, sizeof(name), "UpdateTransformsMoved/%u", count);
+    dmBenchmark::Run(name, BenchUpdateTransformsMoved, &ctx, count);
+    dmSnPrintf(name, sizeof(name), "UpdateTransformsStatic/%u", count);
+    dmBenchmark::Run(name, BenchUpdateTransformsStatic, &ctx, count);
+
+    dmGameObject::DeleteCollection(ctx.m_Collection);
+    delete [] ctx.m_Instances;
+}
+
+int main(int argc, char **argv)
+{
+    dmBenchmark::Init(argc, argv);
+
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_Flags = RESOURCE_FACTORY_FLAGS_EMPTY;
+    dmResource::HFactory factory = dmResource::NewFactory(&params, ".");
+    dmScript::HContext script_context = dmScript::NewContext(0, 0, true);
+    dmScript::Initialize(script_context);
+    dmGameObject::HRegister regist = dmGameObject::NewRegister();
+    dmGameObject::Initialize(regist, script_context);
+
+    RunTransforms(factory, regist, 1000);
+    RunTransforms(factory, regist, 10000);
+    RunTransforms(factory, regist, MAX_INSTANCES);
+
+    dmGameObject::PostUpdate(regist);
+    dmScript::Finalize(script_context);
+    dmScript::DeleteContext(script_context);
+    dmResource::DeleteFactory(factory);
+    dmGameObject::DeleteRegister(regist);
+
+    return dmBenchmark::Finalize();
+}
@@ -165,7 +165,7 @@ dmGameObject::ComponentDestroy CollectionTest::AComponentDestroy = TestComponent
 
 static bool Spawn(dmResource::HFactory factory, dmGameObject::HCollection collection, const char* path, dmGameObject::InstancePropertyBuffers *property_buffers,
         const Point3& position, const Quat& rotation, const Vector3& scale,
-        dmGameObject::InstanceIdMap *instances)
+        dmGameObject::InstanceIdMap *instances, uint32_t* deferred_spawn_id = 0)
 {
     void *msg;
     uint32_t msg_size;
@@ -182,7 +182,16 @@ static bool Spawn(dmResource::HFactory factory, dmGameObject::HCollection collec
         dmLogError("Failed to parse collection [%s]", path);
         return false;
     }
-    bool result = dmGameObject::SpawnFromCollection(collection, desc, property_buffers, position, rotation, scale, instances);
+    bool result;
+    if (deferred_spawn_id)
+    {
+        // No budget, one instance is initialized each update
+        result = dmGameObject::SpawnFromCollectionDeferredInit(collection, desc, property_buffers, position, rotation, scale, 0, instances, deferred_spawn_id);
+    }
+    else
+    {
+        result = dmGameObject::SpawnFromCollection(collection, desc, property_buffers, position, rotation, scale, instances);
+    }
     dmDDF::FreeMessage(desc);
     free(msg);
     return result;
@@ -260,6 +269,102 @@ TEST_F(CollectionTest, CollectionSpawning)
     dmGameObject::PostUpdate(m_Register);
 }
 
+struct DeferredInitCount
+{
+    dmGameObject::HCollection m_Collection;
+    uint32_t m_Initialized;
+};
+
+static void CountInitialized(DeferredInitCount* context, const dmhash_t* key, dmhash_t* value)
+{
+    dmGameObject::HInstance instance = dmGameObject::GetInstanceFromIdentifier(context->m_Collection, *value);
+    if (instance && instance->m_Initialized)
+    {
+        context->m_Initialized++;
+    }
+}
+
+TEST_F(CollectionTest, CollectionSpawningDeferredInit)
+{
+    dmGameObject::HCollection coll;
+    dmResource::Result r = dmResource::Get(m_Factory, "/empty.collectionc", (void**) &coll);
+    ASSERT_EQ(dmResource::RESULT_OK, r);
+    dmGameObject::Init(coll);
+
+    dmGameObject::InstanceIdMap output;
+    dmGameObject::InstancePropertyBuffers props;
+    uint32_t spawn_id = 0;
+    bool result = Spawn(m_Factory, coll, "/root1.collectionc", &props, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1), &output, &spawn_id);
+    ASSERT_TRUE(result);
+    ASSERT_NE(0u, spawn_id);
+    ASSERT_LT(1u, output.Size());
+
+    // The instances exist, but aren't initialized
+    DeferredInitCount count = { coll, 0 };
+    output.Iterate(CountInitialized, &count);
+    ASSERT_EQ(0u, count.m_Initialized);
+    ASSERT_FALSE(dmGameObject::IsDeferredInitDone(coll, spawn_id));
+
+    for (uint32_t i = 0; i < output.Size(); ++i)
+    {
+        ASSERT_FALSE(dmGameObject::IsDeferredInitDone(coll, spawn_id));
+        ASSERT_TRUE(dmGameObject::Update(coll, &m_UpdateContext));
+
+        count.m_Initialized = 0;
+        output.Iterate(CountInitialized, &count);
+        ASSERT_EQ(i + 1, count.m_Initialized);
+    }
+    ASSERT_TRUE(dmGameObject::IsDeferredInitDone(coll, spawn_id));
+
+    dmResource::Release(m_Factory, (void*) coll);
+    dmGameObject::PostUpdate(m_Register);
+}
+
+TEST_F(CollectionTest, IncrementalInitFinalDelete)
+{
+    dmGameObject::HCollection coll;
+    dmResource::Result r = dmResource::Get(m_Factory, "/test.collectionc", (void**) &coll);
+    ASSERT_EQ(dmResource::RESULT_OK, r);
+
+    dmGameObject::HInstance go01 = dmGameObject::GetInstanceFromIdentifier(coll, dmHashString64("/go1"));
+    dmGameObject::HInstance go02 = dmGameObject::GetInstanceFromIdentifier(coll, dmHashString64("/go2"));
+    ASSERT_NE((void*) 0, go01);
+    ASSERT_NE((void*) 0, go02);
+
+    // With no time budget, one instance is initialized in each call
+    bool done = false;
+    ASSERT_TRUE(dmGameObject::InitIncremental(coll, 0, &done));
+    ASSERT_FALSE(done);
+    ASSERT_EQ(1u, (uint32_t)(go01->m_Initialized + go02->m_Initialized));
+    while (!done)
+    {
+        ASSERT_TRUE(dmGameObject::InitIncremental(coll, 0, &done));
+    }
+    ASSERT_TRUE(go01->m_Initialized && go02->m_Initialized);
+    ASSERT_TRUE(dmGameObject::Update(coll, &m_UpdateContext));
+
+    ASSERT_TRUE(dmGameObject::FinalIncremental(coll, 0, &done));
+    ASSERT_FALSE(done);
+    ASSERT_EQ(1u, (uint32_t)(go01->m_Initialized + go02->m_Initialized));
+    while (!done)
+    {
+        ASSERT_TRUE(dmGameObject::FinalIncremental(coll, 0, &done));
+    }
+    ASSERT_FALSE(go01->m_Initialized || go02->m_Initialized);
+
+    dmGameObject::DeleteIncremental(coll, 0, &done);
+    ASSERT_FALSE(done);
+    while (!done)
+    {
+        dmGameObject::DeleteIncremental(coll, 0, &done);
+    }
+    ASSERT_EQ((void*) 0, dmGameObject::GetInstanceFromIdentifier(coll, dmHashString64("/go1")));
+    ASSERT_EQ((void*) 0, dmGameObject::GetInstanceFromIdentifier(coll, dmHashString64("/go2")));
+
+    dmResource::Release(m_Factory, (void*) coll);
+    dmGameObject::PostUpdate(m_Register);
+}
+
 TEST_F(CollectionTest, CollectionSpawningToFail)
 {
     const uint32_t max = 100;
@@ -418,6 +523,10 @@ TEST_F(CollectionTest, CollectionInCollection)
         dmGameObject::HInstance child_sub2 = dmGameObject::GetInstanceFromIdentifier(coll, child_sub2_ident);
         ASSERT_NE((void*) 0, child_sub2);
 
+        // Instances with the same collection path share its hash-state
+        ASSERT_EQ(parent_sub1->m_CollectionPathIndex, child_sub1->m_CollectionPathIndex);
+        ASSERT_NE(parent_sub1->m_CollectionPathIndex, parent_sub2->m_CollectionPathIndex);
+
         // Relative identifiers
         ASSERT_EQ(dmHashString64("/a"), dmGameObject::GetAbsoluteIdentifier(go01, "a", strlen("a")));
         ASSERT_EQ(dmHashString64("/a"), dmGameObject::GetAbsoluteIdentifier(go02, "a", strlen("a")));
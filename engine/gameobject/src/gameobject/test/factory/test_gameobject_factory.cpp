@@ -271,6 +271,47 @@ TEST_F(FactoryTest, FactoryCreateCallback)
     ASSERT_NE((void*)0, instance);
 }
 
+TEST_F(FactoryTest, FactoryPrewarm)
+{
+    dmGameObject::Collection* collection = m_Collection->m_Collection;
+    dmGameObject::HPrototype prototype = 0x0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/test.goc", (void**)&prototype));
+
+    dmGameObject::PrewarmInstances(m_Collection, prototype, 4);
+    ASSERT_EQ(4u, collection->m_InstancePoolSize);
+    // Already prewarmed
+    dmGameObject::PrewarmInstances(m_Collection, prototype, 4);
+    ASSERT_EQ(4u, collection->m_InstancePoolSize);
+
+    dmGameObject::HInstance instances[6];
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        uint32_t index = dmGameObject::AcquireInstanceIndex(m_Collection);
+        dmhash_t id = dmGameObject::ConstructInstanceId(index);
+        instances[i] = dmGameObject::Spawn(m_Collection, prototype, "/test.goc", id, 0x0, 0, Point3(), Quat(), Vector3(1, 1, 1));
+        ASSERT_NE((dmGameObject::HInstance)0, instances[i]);
+        dmGameObject::AssignInstanceIndex(index, instances[i]);
+    }
+    ASSERT_EQ(0u, collection->m_InstancePoolSize);
+
+    // The allocations of deleted instances are reused
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        dmGameObject::Delete(m_Collection, instances[i], false);
+    }
+    dmGameObject::PostUpdate(m_Collection);
+    ASSERT_EQ(6u, collection->m_InstancePoolSize);
+
+    uint32_t index = dmGameObject::AcquireInstanceIndex(m_Collection);
+    dmhash_t id = dmGameObject::ConstructInstanceId(index);
+    dmGameObject::HInstance instance = dmGameObject::Spawn(m_Collection, prototype, "/test.goc", id, 0x0, 0, Point3(), Quat(), Vector3(1, 1, 1));
+    ASSERT_NE((dmGameObject::HInstance)0, instance);
+    dmGameObject::AssignInstanceIndex(index, instance);
+    ASSERT_EQ(5u, collection->m_InstancePoolSize);
+
+    dmResource::Release(m_Factory, prototype);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
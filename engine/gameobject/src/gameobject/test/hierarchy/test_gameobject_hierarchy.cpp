@@ -20,6 +20,7 @@
 #include <dlib/dstrings.h>
 #include <dlib/time.h>
 #include <dlib/log.h>
+#include <dlib/job.h>
 #include <resource/resource.h>
 #include "../gameobject.h"
 #include "../gameobject_private.h"
@@ -1051,6 +1052,152 @@ TEST_F(HierarchyTest, TestIterateHierarchy)
 
 }
 
+// Enough instances per level to split the transform update into jobs
+TEST_F(HierarchyTest, TestHierarchyJobs)
+{
+    dmJob::NewContextParams job_params;
+    job_params.m_WorkerCount = 2;
+    dmJob::HContext job_context = dmJob::NewContext(job_params);
+    dmGameObject::SetJobContext(m_Register, job_context);
+
+    const uint32_t child_count = 600;
+    dmGameObject::HInstance parent = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::SetPosition(parent, Point3(1, 2, 0));
+    dmGameObject::SetRotation(parent, Quat::rotationZ(3.14159265f / 2.0f));
+
+    dmGameObject::HInstance children[child_count];
+    for (uint32_t i = 0; i < child_count; ++i)
+    {
+        children[i] = dmGameObject::New(m_Collection, "/go.goc");
+        dmGameObject::SetPosition(children[i], Point3((float) i, 0, 0));
+        dmGameObject::SetParent(children[i], parent);
+    }
+
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    for (uint32_t i = 0; i < child_count; ++i)
+    {
+        Point3 expected(1.0f, 2.0f + (float) i, 0.0f);
+        ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(children[i]) - expected), 0.001f);
+    }
+
+    for (uint32_t i = 0; i < child_count; ++i)
+    {
+        dmGameObject::Delete(m_Collection, children[i], false);
+    }
+    dmGameObject::Delete(m_Collection, parent, false);
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+
+    dmGameObject::SetJobContext(m_Register, 0);
+    dmJob::DeleteContext(job_context);
+}
+
+TEST_F(HierarchyTest, TestHierarchyDirtyTransforms)
+{
+    dmGameObject::HInstance parent = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::HInstance child = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::HInstance other = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::SetPosition(child, Point3(1, 0, 0));
+    dmGameObject::SetParent(child, parent);
+
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    uint32_t parent_version = dmGameObject::GetWorldTransformVersion(parent);
+    uint32_t child_version = dmGameObject::GetWorldTransformVersion(child);
+    uint32_t other_version = dmGameObject::GetWorldTransformVersion(other);
+
+    // Nothing moved
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_EQ(parent_version, dmGameObject::GetWorldTransformVersion(parent));
+    ASSERT_EQ(child_version, dmGameObject::GetWorldTransformVersion(child));
+    ASSERT_EQ(other_version, dmGameObject::GetWorldTransformVersion(other));
+
+    // Moving the parent propagates to the child only
+    dmGameObject::SetPosition(parent, Point3(0, 2, 0));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_NE(parent_version, dmGameObject::GetWorldTransformVersion(parent));
+    ASSERT_NE(child_version, dmGameObject::GetWorldTransformVersion(child));
+    ASSERT_EQ(other_version, dmGameObject::GetWorldTransformVersion(other));
+    ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(child) - Point3(1, 2, 0)), EPSILON);
+
+    // Moving the child leaves the parent untouched
+    parent_version = dmGameObject::GetWorldTransformVersion(parent);
+    dmGameObject::SetPosition(child, Point3(3, 0, 0));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_EQ(parent_version, dmGameObject::GetWorldTransformVersion(parent));
+    ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(child) - Point3(3, 2, 0)), EPSILON);
+
+    dmGameObject::Delete(m_Collection, child, false);
+    dmGameObject::Delete(m_Collection, parent, false);
+    dmGameObject::Delete(m_Collection, other, false);
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+}
+
+static void CollectQueryResult(dmGameObject::HInstance instance, void* user_data)
+{
+    dmArray<dmGameObject::HInstance>* result = (dmArray<dmGameObject::HInstance>*) user_data;
+    if (result->Full())
+        result->OffsetCapacity(8);
+    result->Push(instance);
+}
+
+static bool QueryContains(const dmArray<dmGameObject::HInstance>& result, dmGameObject::HInstance instance)
+{
+    for (uint32_t i = 0; i < result.Size(); ++i)
+        if (result[i] == instance)
+            return true;
+    return false;
+}
+
+TEST_F(HierarchyTest, TestSpatialQuery)
+{
+    dmGameObject::HInstance parent = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::HInstance child = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::HInstance other = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::SetPosition(parent, Point3(10, 10, 0));
+    dmGameObject::SetPosition(child, Point3(5, 0, 0));
+    dmGameObject::SetParent(child, parent);
+    dmGameObject::SetPosition(other, Point3(1000, 1000, 0));
+
+    ASSERT_EQ(dmGameObject::RESULT_INVALID_OPERATION, dmGameObject::EnableSpatialIndex(m_Collection, 0.0f));
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::EnableSpatialIndex(m_Collection, 16.0f));
+
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    dmArray<dmGameObject::HInstance> result;
+    ASSERT_EQ(2U, dmGameObject::QueryRadius(m_Collection, Point3(12, 10, 0), 4.0f, CollectQueryResult, &result));
+    ASSERT_TRUE(QueryContains(result, parent));
+    ASSERT_TRUE(QueryContains(result, child));
+
+    result.SetSize(0);
+    ASSERT_EQ(1U, dmGameObject::QueryAABB(m_Collection, Point3(14, 9, -1), Point3(16, 11, 1), CollectQueryResult, &result));
+    ASSERT_TRUE(QueryContains(result, child));
+
+    // A large box visits the occupied cells instead
+    result.SetSize(0);
+    ASSERT_EQ(3U, dmGameObject::QueryAABB(m_Collection, Point3(-10000, -10000, -10000), Point3(10000, 10000, 10000), CollectQueryResult, &result));
+
+    // Moving the parent re-indexes the child
+    dmGameObject::SetPosition(parent, Point3(990, 1000, 0));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    result.SetSize(0);
+    ASSERT_EQ(0U, dmGameObject::QueryRadius(m_Collection, Point3(12, 10, 0), 4.0f, CollectQueryResult, &result));
+    result.SetSize(0);
+    ASSERT_EQ(3U, dmGameObject::QueryRadius(m_Collection, Point3(1000, 1000, 0), 10.0f, CollectQueryResult, &result));
+
+    // Deleted instances are removed from the index
+    dmGameObject::Delete(m_Collection, other, false);
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    result.SetSize(0);
+    ASSERT_EQ(2U, dmGameObject::QueryRadius(m_Collection, Point3(1000, 1000, 0), 10.0f, CollectQueryResult, &result));
+    ASSERT_FALSE(QueryContains(result, other));
+
+    dmGameObject::DisableSpatialIndex(m_Collection);
+    dmGameObject::Delete(m_Collection, child, false);
+    dmGameObject::Delete(m_Collection, parent, false);
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+}
+
 #undef EPSILON
 
 int main(int argc, char **argv)
@@ -282,6 +282,37 @@ TEST_F(MessageTest, TestComponentMessage)
     dmGameObject::Delete(m_Collection, go, false);
 }
 
+// The resolved receivers are cached by the collection, a new instance with the same id must receive the messages
+TEST_F(MessageTest, TestComponentMessageRecreatedReceiver)
+{
+    dmGameObject::HInstance go = dmGameObject::New(m_Collection, "/component_message.goc");
+    ASSERT_NE((void*) 0, (void*) go);
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetIdentifier(m_Collection, go, "test_instance"));
+
+    dmMessage::URL receiver;
+    receiver.m_Socket = dmGameObject::GetMessageSocket(m_Collection);
+    receiver.m_Path = dmGameObject::GetIdentifier(go);
+    receiver.m_Fragment = dmHashString64("mt");
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &receiver, dmHashString64("inc"), 0, 0, 0x0, 0, 0));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_EQ(1U, m_MessageTargetCounter);
+
+    dmGameObject::Delete(m_Collection, go, false);
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    dmGameObject::PostUpdate(m_Collection);
+
+    go = dmGameObject::New(m_Collection, "/component_message.goc");
+    ASSERT_NE((void*) 0, (void*) go);
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetIdentifier(m_Collection, go, "test_instance"));
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &receiver, dmHashString64("dec"), 0, 0, 0x0, 0, 0));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_EQ(0U, m_MessageTargetCounter);
+
+    dmGameObject::Delete(m_Collection, go, false);
+}
+
 TEST_F(MessageTest, TestComponentMessageFail)
 {
     dmGameObject::HInstance go = dmGameObject::New(m_Collection, "/component_message.goc");
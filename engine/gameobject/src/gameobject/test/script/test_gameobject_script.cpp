@@ -563,6 +563,42 @@ TEST_F(ScriptTest, TestInstanceContext)
     dmGameObject::PostUpdate(m_Collection);
 }
 
+TEST_F(ScriptTest, TestUpdateAll)
+{
+    lua_State* L = dmScript::GetLuaState(m_ScriptContext);
+    lua_pushinteger(L, 0);
+    lua_setglobal(L, "UPDATE_ALL_CALLS");
+    lua_pushinteger(L, 0);
+    lua_setglobal(L, "UPDATE_ALL_INSTANCES");
+
+    const uint32_t count = 8;
+    dmGameObject::HInstance instances[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        instances[i] = dmGameObject::New(m_Collection, "/update_all.goc");
+        ASSERT_NE((void*) 0, (void*) instances[i]);
+        char id[16];
+        dmSnPrintf(id, sizeof(id), "go%d", i);
+        ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetIdentifier(m_Collection, instances[i], id));
+    }
+
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    // One call per update for all instances of the script
+    lua_getglobal(L, "UPDATE_ALL_CALLS");
+    ASSERT_EQ(2, lua_tointeger(L, -1));
+    lua_getglobal(L, "UPDATE_ALL_INSTANCES");
+    ASSERT_EQ(2 * count, (uint32_t) lua_tointeger(L, -1));
+    lua_pop(L, 2);
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+    for (uint32_t i = 0; i < count; ++i)
+        dmGameObject::Delete(m_Collection, instances[i], false);
+    dmGameObject::PostUpdate(m_Collection);
+}
+
 int main(int argc, char **argv)
 {
     dmDDF::RegisterAllTypes();
@@ -0,0 +1,83 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DMSDK_GAMESYS_LABEL_H
+#define DMSDK_GAMESYS_LABEL_H
+
+#include <stdint.h>
+#include <dmsdk/dlib/hash.h>
+#include <dmsdk/dlib/vmath.h>
+#include <dmsdk/gameobject/gameobject.h>
+
+/*# Label component API documentation
+ * [file:<dmsdk/gamesys/label.h>]
+ *
+ * Api for updating label components from native code, without going through messages or Lua
+ *
+ * @document
+ * @name Label
+ * @namespace dmGameSystem
+ */
+
+namespace dmGameSystem
+{
+    /*#
+     * Label component handle. Resolve it once with GetLabelHandle() and use it with the setters below.
+     * The handle is valid for as long as the label component exists.
+     * @struct
+     * @name LabelHandle
+     */
+    struct LabelHandle
+    {
+        void*       m_World;
+        uint32_t    m_Index;
+    };
+
+    /*#
+     * Get the handle of a label component
+     * @name GetLabelHandle
+     * @param instance [type: dmGameObject::HInstance] the game object instance
+     * @param component_id [type: dmhash_t] the id of the label component, e.g. hash("label")
+     * @param out_handle [type: dmGameSystem::LabelHandle*] the handle
+     * @return result [type: bool] true if the instance has a label component with the id
+     */
+    bool GetLabelHandle(dmGameObject::HInstance instance, dmhash_t component_id, LabelHandle* out_handle);
+
+    /*#
+     * Set the color of labels. Same as setting the "color" property
+     * @name SetLabelColors
+     * @param handles [type: const dmGameSystem::LabelHandle*] the labels
+     * @param colors [type: const dmVMath::Vector4*] one color per label
+     * @param count [type: uint32_t] the number of labels
+     */
+    void SetLabelColors(const LabelHandle* handles, const dmVMath::Vector4* colors, uint32_t count);
+
+    /*#
+     * Set the scale of labels. Same as setting the "scale" property
+     * @name SetLabelScales
+     * @param handles [type: const dmGameSystem::LabelHandle*] the labels
+     * @param scales [type: const dmVMath::Vector3*] one scale per label
+     * @param count [type: uint32_t] the number of labels
+     */
+    void SetLabelScales(const LabelHandle* handles, const dmVMath::Vector3* scales, uint32_t count);
+
+    /*#
+     * Set the text of labels. Same as label.set_text(), the text is copied
+     * @name SetLabelTexts
+     * @param handles [type: const dmGameSystem::LabelHandle*] the labels
+     * @param texts [type: const char**] one null terminated text per label
+     * @param count [type: uint32_t] the number of labels
+     */
+    void SetLabelTexts(const LabelHandle* handles, const char** texts, uint32_t count);
+}
+
+#endif // DMSDK_GAMESYS_LABEL_H
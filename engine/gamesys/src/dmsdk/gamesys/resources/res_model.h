@@ -34,6 +34,13 @@ namespace dmGameSystem
         dmhash_t                m_TexturePaths[dmRender::RenderObject::MAX_TEXTURE_COUNT];
         dmGraphics::Type        m_IndexBufferElementType;
         uint32_t                m_ElementCount;
+        /// Local space bounds of the meshes, used for culling
+        dmVMath::Point3         m_AabbCenter;
+        dmVMath::Vector3        m_AabbExtents;
+        /// The vertex buffer holds dmRig::RigSkinnedModelVertex, skinned in the vertex shader
+        uint8_t                 m_SkinnedVertices : 1;
+        /// Set if the bounds are known. Animated models have no bounds, since the bones can move the vertices anywhere
+        uint8_t                 m_HasAabb : 1;
     };
 }
 
@@ -39,6 +39,8 @@ namespace dmGameSystem
 
         dmArray<uint32_t>       m_PoseIdxToInfluence;
         dmArray<uint32_t>       m_TrackIdxToPose;
+        /// Baked on first use, see GetBakedAnimationSet
+        dmRig::BakedAnimationSet m_BakedAnimationSet;
     };
 }
 
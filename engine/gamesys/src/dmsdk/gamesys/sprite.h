@@ -0,0 +1,103 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DMSDK_GAMESYS_SPRITE_H
+#define DMSDK_GAMESYS_SPRITE_H
+
+#include <stdint.h>
+#include <dmsdk/dlib/hash.h>
+#include <dmsdk/dlib/vmath.h>
+#include <dmsdk/gameobject/gameobject.h>
+
+/*# Sprite component API documentation
+ * [file:<dmsdk/gamesys/sprite.h>]
+ *
+ * Api for updating sprite components from native code, without going through messages or Lua
+ *
+ * @document
+ * @name Sprite
+ * @namespace dmGameSystem
+ */
+
+namespace dmGameSystem
+{
+    /*#
+     * Sprite component handle. Resolve it once with GetSpriteHandle() and use it with the setters below.
+     * The handle is valid for as long as the sprite component exists.
+     * @struct
+     * @name SpriteHandle
+     */
+    struct SpriteHandle
+    {
+        void*       m_World;
+        uint32_t    m_Index;
+    };
+
+    /*#
+     * Get the handle of a sprite component
+     * @name GetSpriteHandle
+     * @param instance [type: dmGameObject::HInstance] the game object instance
+     * @param component_id [type: dmhash_t] the id of the sprite component, e.g. hash("sprite")
+     * @param out_handle [type: dmGameSystem::SpriteHandle*] the handle
+     * @return result [type: bool] true if the instance has a sprite component with the id
+     */
+    bool GetSpriteHandle(dmGameObject::HInstance instance, dmhash_t component_id, SpriteHandle* out_handle);
+
+    /*#
+     * Set the tint of sprites. Same as setting the "tint" property
+     * @name SetSpriteTints
+     * @param handles [type: const dmGameSystem::SpriteHandle*] the sprites
+     * @param tints [type: const dmVMath::Vector4*] one tint per sprite
+     * @param count [type: uint32_t] the number of sprites
+     *
+     * @examples
+     *
+     * ```cpp
+     * for (uint32_t i = 0; i < count; ++i)
+     *     tints[i] = dmVMath::Vector4(1.0f, 1.0f, 1.0f, alpha[i]);
+     * dmGameSystem::SetSpriteTints(handles, tints, count);
+     * ```
+     */
+    void SetSpriteTints(const SpriteHandle* handles, const dmVMath::Vector4* tints, uint32_t count);
+
+    /*#
+     * Set the scale of sprites. Same as setting the "scale" property
+     * @name SetSpriteScales
+     * @param handles [type: const dmGameSystem::SpriteHandle*] the sprites
+     * @param scales [type: const dmVMath::Vector3*] one scale per sprite
+     * @param count [type: uint32_t] the number of sprites
+     */
+    void SetSpriteScales(const SpriteHandle* handles, const dmVMath::Vector3* scales, uint32_t count);
+
+    /*#
+     * Set the normalized animation cursor of sprites. Same as setting the "cursor" property
+     * @name SetSpriteCursors
+     * @param handles [type: const dmGameSystem::SpriteHandle*] the sprites
+     * @param cursors [type: const float*] one cursor in [0,1] per sprite
+     * @param count [type: uint32_t] the number of sprites
+     */
+    void SetSpriteCursors(const SpriteHandle* handles, const float* cursors, uint32_t count);
+
+    /*#
+     * Flag sprites as static. The vertices of static sprites are baked into buffers that are shared by all static
+     * sprites with the same material, image, blend mode, render layer and z. The sprites are then no longer animated
+     * or updated each frame. Changing a property or the transform of a static sprite, or sending it a message, makes it dynamic again.
+     * Sprites that play an animation or have render constants (e.g. a tint) set are drawn dynamically even if they are flagged as static.
+     * @name SetSpritesStatic
+     * @param handles [type: const dmGameSystem::SpriteHandle*] the sprites
+     * @param count [type: uint32_t] the number of sprites
+     * @param enable [type: bool] true to flag the sprites as static, false to make them dynamic
+     */
+    void SetSpritesStatic(const SpriteHandle* handles, uint32_t count, bool enable);
+}
+
+#endif // DMSDK_GAMESYS_SPRITE_H
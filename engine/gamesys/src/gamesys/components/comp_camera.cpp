@@ -30,6 +30,8 @@ namespace dmGameSystem
     const uint8_t MAX_COUNT = 64;
     const uint8_t MAX_STACK_COUNT = 8;
 
+    static const dmhash_t CAMERA_PROP_LAYER_MASK = dmHashString64("layer_mask");
+
     struct CameraWorld;
 
     struct CameraComponent
@@ -40,6 +42,8 @@ namespace dmGameSystem
         float m_Fov;
         float m_NearZ;
         float m_FarZ;
+        /// Render layers drawn while the camera has focus, see dmRender::SetLayerMask
+        uint32_t m_LayerMask;
         uint32_t m_AutoAspectRatio : 1;
         uint32_t m_AddedToUpdate : 1;
         uint16_t m_ComponentIndex;
@@ -80,6 +84,7 @@ namespace dmGameSystem
             camera.m_NearZ = cam_resource->m_DDF->m_NearZ;
             camera.m_FarZ = cam_resource->m_DDF->m_FarZ;
             camera.m_AutoAspectRatio = cam_resource->m_DDF->m_AutoAspectRatio != 0;
+            camera.m_LayerMask = 0xffffffff;
             camera.m_AddedToUpdate = 0;
             camera.m_ComponentIndex = params.m_ComponentIndex;
             w->m_Cameras.Push(camera);
@@ -188,6 +193,7 @@ namespace dmGameSystem
             // TODO: Remove this once render scripts are implemented everywhere
             dmRender::SetProjectionMatrix(render_context, projection);
             dmRender::SetViewMatrix(render_context, view);
+            dmRender::SetLayerMask(render_context, camera->m_LayerMask);
         }
         return dmGameObject::UPDATE_RESULT_OK;
     }
@@ -263,4 +269,31 @@ namespace dmGameSystem
         camera->m_FarZ = cam_resource->m_DDF->m_FarZ;
         camera->m_AutoAspectRatio = cam_resource->m_DDF->m_AutoAspectRatio != 0;
     }
+
+    dmGameObject::PropertyResult CompCameraGetProperty(const dmGameObject::ComponentGetPropertyParams& params, dmGameObject::PropertyDesc& out_value)
+    {
+        CameraComponent* camera = (CameraComponent*)*params.m_UserData;
+        if (params.m_PropertyId == CAMERA_PROP_LAYER_MASK)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar((double)camera->m_LayerMask);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+        return dmGameObject::PROPERTY_RESULT_NOT_FOUND;
+    }
+
+    dmGameObject::PropertyResult CompCameraSetProperty(const dmGameObject::ComponentSetPropertyParams& params)
+    {
+        CameraComponent* camera = (CameraComponent*)*params.m_UserData;
+        if (params.m_PropertyId == CAMERA_PROP_LAYER_MASK)
+        {
+            if (params.m_Value.m_Type != dmGameObject::PROPERTY_TYPE_NUMBER)
+                return dmGameObject::PROPERTY_RESULT_TYPE_MISMATCH;
+            if (params.m_Value.m_Number < 0 || params.m_Value.m_Number > 0xffffffff)
+                return dmGameObject::PROPERTY_RESULT_UNSUPPORTED_VALUE;
+
+            camera->m_LayerMask = (uint32_t)params.m_Value.m_Number;
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+        return dmGameObject::PROPERTY_RESULT_NOT_FOUND;
+    }
 }
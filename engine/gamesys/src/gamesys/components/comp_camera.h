@@ -32,6 +32,10 @@ namespace dmGameSystem
     dmGameObject::UpdateResult CompCameraOnMessage(const dmGameObject::ComponentOnMessageParams& params);
 
     void CompCameraOnReload(const dmGameObject::ComponentOnReloadParams& params);
+
+    dmGameObject::PropertyResult CompCameraGetProperty(const dmGameObject::ComponentGetPropertyParams& params, dmGameObject::PropertyDesc& out_value);
+
+    dmGameObject::PropertyResult CompCameraSetProperty(const dmGameObject::ComponentSetPropertyParams& params);
 }
 
 #endif // DM_GAMESYS_COMP_CAMERA_H
@@ -32,6 +32,7 @@ namespace dmGameSystem
     using namespace Vectormath::Aos;
 
     const char* COLLECTION_FACTORY_MAX_COUNT_KEY = "collectionfactory.max_count";
+    const char* COLLECTION_FACTORY_INIT_TIME_BUDGET_KEY = "collectionfactory.init_time_budget";
 
     static void CleanupAsyncLoading(lua_State*, CollectionFactoryComponent*);
     static bool PreloadCompleteCallback(const dmResource::PreloaderCompleteCallbackParams*);
@@ -39,13 +40,34 @@ namespace dmGameSystem
     static dmResource::Result LoadCollectionResources(dmResource::HFactory, CollectionFactoryComponent*);
     static void UnloadCollectionResources(dmResource::HFactory, CollectionFactoryComponent*);
 
-    struct FactoryWorld
+    // A collectionfactory.create_deferred call waiting for its game objects to be initialized
+    struct DeferredSpawn
+    {
+        CollectionFactoryComponent* m_Component;
+        uint32_t                    m_SpawnId;
+        int                         m_CallbackRef;
+        int                         m_SelfRef;
+        int                         m_URLRef;
+        int                         m_IdsRef;
+    };
+
+    struct CollectionFactoryWorld
     {
         dmArray<CollectionFactoryComponent>   m_Components;
         dmIndexPool32               m_IndexPool;
         uint32_t                    m_TotalFactoryCount;
+        dmArray<DeferredSpawn>      m_DeferredSpawns;
+        uint32_t                    m_InitTimeBudget;
     };
 
+    static void UnrefDeferredSpawn(lua_State* L, DeferredSpawn* spawn)
+    {
+        dmScript::Unref(L, LUA_REGISTRYINDEX, spawn->m_CallbackRef);
+        dmScript::Unref(L, LUA_REGISTRYINDEX, spawn->m_SelfRef);
+        dmScript::Unref(L, LUA_REGISTRYINDEX, spawn->m_URLRef);
+        dmScript::Unref(L, LUA_REGISTRYINDEX, spawn->m_IdsRef);
+    }
+
     void CollectionFactoryComponent::Init()
     {
         memset(this, 0x0, sizeof(CollectionFactoryComponent));
@@ -57,7 +79,7 @@ namespace dmGameSystem
     dmGameObject::CreateResult CompCollectionFactoryNewWorld(const dmGameObject::ComponentNewWorldParams& params)
     {
         CollectionFactoryContext* context = (CollectionFactoryContext*)params.m_Context;
-        FactoryWorld* fw = new FactoryWorld();
+        CollectionFactoryWorld* fw = new CollectionFactoryWorld();
         const uint32_t max_component_count = context->m_MaxCollectionFactoryCount;
         fw->m_Components.SetCapacity(max_component_count);
         fw->m_Components.SetSize(max_component_count);
@@ -66,19 +88,20 @@ namespace dmGameSystem
         {
             fw->m_Components[i].Init();
         }
+        fw->m_InitTimeBudget = context->m_InitTimeBudget;
         *params.m_World = fw;
         return dmGameObject::CREATE_RESULT_OK;
     }
 
     dmGameObject::CreateResult CompCollectionFactoryDeleteWorld(const dmGameObject::ComponentDeleteWorldParams& params)
     {
-        delete (FactoryWorld*)params.m_World;
+        delete (CollectionFactoryWorld*)params.m_World;
         return dmGameObject::CREATE_RESULT_OK;
     }
 
     dmGameObject::CreateResult CompCollectionFactoryCreate(const dmGameObject::ComponentCreateParams& params)
     {
-        FactoryWorld* fw = (FactoryWorld*)params.m_World;
+        CollectionFactoryWorld* fw = (CollectionFactoryWorld*)params.m_World;
         CollectionFactoryComponent* component;
         if (fw->m_IndexPool.Remaining() > 0)
         {
@@ -97,9 +120,22 @@ namespace dmGameSystem
 
     dmGameObject::CreateResult CompCollectionFactoryDestroy(const dmGameObject::ComponentDestroyParams& params)
     {
-        FactoryWorld* fw = (FactoryWorld*)params.m_World;
+        CollectionFactoryWorld* fw = (CollectionFactoryWorld*)params.m_World;
         CollectionFactoryComponent* fc = (CollectionFactoryComponent*)*params.m_UserData;
-        CleanupAsyncLoading(dmScript::GetLuaState(((CollectionFactoryContext*)params.m_Context)->m_ScriptContext), fc);
+        lua_State* L = dmScript::GetLuaState(((CollectionFactoryContext*)params.m_Context)->m_ScriptContext);
+        CleanupAsyncLoading(L, fc);
+        for (uint32_t i = 0; i < fw->m_DeferredSpawns.Size();)
+        {
+            if (fw->m_DeferredSpawns[i].m_Component == fc)
+            {
+                UnrefDeferredSpawn(L, &fw->m_DeferredSpawns[i]);
+                fw->m_DeferredSpawns.EraseSwap(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
         uint32_t index = fc - &fw->m_Components[0];
         fc->m_Resource = 0x0;
         fc->m_AddedToUpdate = 0;
@@ -114,9 +150,44 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
+    static void RunDeferredSpawnCallbacks(const dmGameObject::ComponentsUpdateParams& params, CollectionFactoryWorld* world)
+    {
+        lua_State* L = dmScript::GetLuaState(((CollectionFactoryContext*)params.m_Context)->m_ScriptContext);
+        for (uint32_t i = 0; i < world->m_DeferredSpawns.Size();)
+        {
+            if (!dmGameObject::IsDeferredInitDone(params.m_Collection, world->m_DeferredSpawns[i].m_SpawnId))
+            {
+                ++i;
+                continue;
+            }
+            // The callback might spawn again
+            DeferredSpawn spawn = world->m_DeferredSpawns[i];
+            world->m_DeferredSpawns.EraseSwap(i);
+
+            int top = lua_gettop(L);
+            lua_rawgeti(L, LUA_REGISTRYINDEX, spawn.m_CallbackRef);
+            lua_rawgeti(L, LUA_REGISTRYINDEX, spawn.m_SelfRef);
+            lua_pushvalue(L, -1);
+            dmScript::SetInstance(L);
+            if (!dmScript::IsInstanceValid(L))
+            {
+                lua_pop(L, 2);
+                dmLogError("Could not run collectionfactory.create_deferred complete callback because the instance has been deleted.");
+            }
+            else
+            {
+                lua_rawgeti(L, LUA_REGISTRYINDEX, spawn.m_URLRef);
+                lua_rawgeti(L, LUA_REGISTRYINDEX, spawn.m_IdsRef);
+                dmScript::PCall(L, 3, 0);
+            }
+            UnrefDeferredSpawn(L, &spawn);
+            assert(top == lua_gettop(L));
+        }
+    }
+
     dmGameObject::UpdateResult CompCollectionFactoryUpdate(const dmGameObject::ComponentsUpdateParams& params, dmGameObject::ComponentsUpdateResult& update_result)
     {
-        FactoryWorld* world = (FactoryWorld*)params.m_World;
+        CollectionFactoryWorld* world = (CollectionFactoryWorld*)params.m_World;
         dmGameObject::UpdateResult result = dmGameObject::UPDATE_RESULT_OK;
         for (uint32_t i = 0; i < world->m_Components.Size(); ++i)
         {
@@ -141,9 +212,36 @@ namespace dmGameSystem
             }
         }
 
+        if (!world->m_DeferredSpawns.Empty())
+        {
+            RunDeferredSpawnCallbacks(params, world);
+        }
+
         return result;
     }
 
+    uint32_t CompCollectionFactoryGetInitTimeBudget(void* world)
+    {
+        return ((CollectionFactoryWorld*)world)->m_InitTimeBudget;
+    }
+
+    void CompCollectionFactoryAddDeferredSpawn(void* world, CollectionFactoryComponent* component, uint32_t spawn_id, int callback_ref, int self_ref, int url_ref, int ids_ref)
+    {
+        CollectionFactoryWorld* fw = (CollectionFactoryWorld*)world;
+        if (fw->m_DeferredSpawns.Full())
+        {
+            fw->m_DeferredSpawns.OffsetCapacity(8);
+        }
+        DeferredSpawn spawn;
+        spawn.m_Component = component;
+        spawn.m_SpawnId = spawn_id;
+        spawn.m_CallbackRef = callback_ref;
+        spawn.m_SelfRef = self_ref;
+        spawn.m_URLRef = url_ref;
+        spawn.m_IdsRef = ids_ref;
+        fw->m_DeferredSpawns.Push(spawn);
+    }
+
     bool CompCollectionFactoryLoad(dmGameObject::HCollection collection, CollectionFactoryComponent* component)
     {
         if(!component->m_Resource->m_LoadDynamically)
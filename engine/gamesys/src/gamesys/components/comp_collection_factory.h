@@ -66,6 +66,12 @@ namespace dmGameSystem
 
 
     CompCollectionFactoryStatus CompCollectionFactoryGetStatus(CollectionFactoryComponent* component);
+
+    uint32_t CompCollectionFactoryGetInitTimeBudget(void* world);
+
+    // Calls the callback once the instances of a deferred spawn have been initialized, see collectionfactory.create_deferred.
+    // Takes ownership of the references
+    void CompCollectionFactoryAddDeferredSpawn(void* world, CollectionFactoryComponent* component, uint32_t spawn_id, int callback_ref, int self_ref, int url_ref, int ids_ref);
 }
 
 #endif
@@ -46,6 +46,7 @@ namespace dmGameSystem
     using namespace Vectormath::Aos;
 
     const char* COLLECTION_PROXY_MAX_COUNT_KEY = "collection_proxy.max_count";
+    const char* COLLECTION_PROXY_TIME_BUDGET_KEY = "collection_proxy.time_budget";
 
     struct CollectionProxyComponent
     {
@@ -62,6 +63,10 @@ namespace dmGameSystem
         uint32_t                        m_DelayedEnable : 1;
         uint32_t                        m_Unloaded : 1;
         uint32_t                        m_AddedToUpdate : 1;
+        // Time-sliced operations in progress, stepped in order each update
+        uint32_t                        m_AsyncInit : 1;
+        uint32_t                        m_AsyncFinal : 1;
+        uint32_t                        m_AsyncUnload : 1;
 
         dmResource::HPreloader          m_Preloader;
         dmMessage::URL                  m_LoadSender, m_LoadReceiver;
@@ -126,6 +131,72 @@ namespace dmGameSystem
         return comp_url_hash;
     }
 
+    static void PostUnloaded(CollectionProxyComponent* proxy)
+    {
+        if (dmMessage::IsSocketValid(proxy->m_Unloader.m_Socket))
+        {
+            dmMessage::URL sender;
+            sender.m_Socket = dmGameObject::GetMessageSocket(dmGameObject::GetCollection(proxy->m_Instance));
+            sender.m_Path = dmGameObject::GetIdentifier(proxy->m_Instance);
+            dmGameObject::GetComponentId(proxy->m_Instance, proxy->m_ComponentIndex, &sender.m_Fragment);
+            dmMessage::Result msg_result = dmMessage::Post(&sender, &proxy->m_Unloader, dmHashString64("proxy_unloaded"), 0, 0, 0, 0, 0);
+            if (msg_result != dmMessage::RESULT_OK)
+            {
+                dmLogWarning("proxy_unloaded could not be posted: %d", msg_result);
+            }
+        }
+    }
+
+    // Steps the time-sliced init, final or unload in progress. Returns true while any of them is in progress.
+    static bool UpdateAsync(CollectionProxyContext* context, CollectionProxyComponent* proxy)
+    {
+        bool done = true;
+        if (proxy->m_AsyncInit)
+        {
+            if (!dmGameObject::InitIncremental(proxy->m_Collection, context->m_TimeBudget, &done))
+            {
+                dmLogError("The collection %s could not be fully initialized.", proxy->m_Resource->m_DDF->m_Collection);
+            }
+            if (done)
+            {
+                proxy->m_AsyncInit = 0;
+                proxy->m_Initialized = 1;
+            }
+        }
+        else if (proxy->m_AsyncFinal)
+        {
+            if (!dmGameObject::FinalIncremental(proxy->m_Collection, context->m_TimeBudget, &done))
+            {
+                dmLogError("The collection %s could not be fully finalized.", proxy->m_Resource->m_DDF->m_Collection);
+            }
+            if (done)
+            {
+                proxy->m_AsyncFinal = 0;
+                proxy->m_Initialized = 0;
+            }
+        }
+        else if (proxy->m_AsyncUnload)
+        {
+            // Deleting the instances releases their resources, leaving little work for the final release
+            dmGameObject::DeleteIncremental(proxy->m_Collection, context->m_TimeBudget, &done);
+            if (done)
+            {
+                dmResource::Release(context->m_Factory, proxy->m_Collection);
+                proxy->m_Collection = 0;
+                proxy->m_AsyncUnload = 0;
+                proxy->m_Unloaded = 1;
+            }
+        }
+        return proxy->m_AsyncInit || proxy->m_AsyncFinal || proxy->m_AsyncUnload;
+    }
+
+    static void CancelAsync(CollectionProxyComponent* proxy)
+    {
+        proxy->m_AsyncInit = 0;
+        proxy->m_AsyncFinal = 0;
+        proxy->m_AsyncUnload = 0;
+    }
+
     dmGameObject::CreateResult CompCollectionProxyNewWorld(const dmGameObject::ComponentNewWorldParams& params)
     {
         CollectionProxyWorld* proxy_world = new CollectionProxyWorld();
@@ -149,7 +220,7 @@ namespace dmGameSystem
             dmGameObject::HCollection collection = proxy_world->m_Components[i].m_Collection;
             if (collection != 0)
             {
-                if (proxy_world->m_Components[i].m_Initialized)
+                if (proxy_world->m_Components[i].m_Initialized || proxy_world->m_Components[i].m_AsyncInit)
                     dmGameObject::Final(collection);
                 dmResource::Release(factory, collection);
             }
@@ -202,9 +273,11 @@ namespace dmGameSystem
     dmGameObject::CreateResult CompCollectionProxyFinal(const dmGameObject::ComponentFinalParams& params)
     {
         CollectionProxyComponent* proxy = (CollectionProxyComponent*)*params.m_UserData;
-        if (proxy->m_Initialized)
+        if (proxy->m_Initialized || proxy->m_AsyncInit)
         {
             proxy->m_Initialized = 0;
+            proxy->m_AsyncInit = 0;
+            proxy->m_AsyncFinal = 0;
             dmGameObject::Final(proxy->m_Collection);
         }
         return dmGameObject::CREATE_RESULT_OK;
@@ -244,7 +317,12 @@ namespace dmGameSystem
                     proxy->m_Preloader = 0;
                 }
             }
-            if (proxy->m_Collection != 0)
+            if (proxy->m_Collection != 0 && UpdateAsync((CollectionProxyContext*)params.m_Context, proxy))
+            {
+                // The collection isn't updated until the time-sliced operations are done
+                proxy->m_AccumulatedTime = 0.0f;
+            }
+            else if (proxy->m_Collection != 0)
             {
                 if (proxy->m_DelayedEnable != proxy->m_Enabled)
                 {
@@ -289,18 +367,7 @@ namespace dmGameSystem
             if (proxy->m_Unloaded)
             {
                 proxy->m_Unloaded = 0;
-                if (dmMessage::IsSocketValid(proxy->m_Unloader.m_Socket))
-                {
-                    dmMessage::URL sender;
-                    sender.m_Socket = dmGameObject::GetMessageSocket(dmGameObject::GetCollection(proxy->m_Instance));
-                    sender.m_Path = dmGameObject::GetIdentifier(proxy->m_Instance);
-                    dmGameObject::GetComponentId(proxy->m_Instance, proxy->m_ComponentIndex, &sender.m_Fragment);
-                    dmMessage::Result msg_result = dmMessage::Post(&sender, &proxy->m_Unloader, dmHashString64("proxy_unloaded"), 0, 0, 0, 0, 0);
-                    if (msg_result != dmMessage::RESULT_OK)
-                    {
-                        dmLogWarning("proxy_unloaded could not be posted: %d", msg_result);
-                    }
-                }
+                PostUnloaded(proxy);
             }
         }
         return result;
@@ -329,7 +396,7 @@ namespace dmGameSystem
         for (uint32_t i = 0; i < proxy_world->m_Components.Size(); ++i)
         {
             CollectionProxyComponent* proxy = &proxy_world->m_Components[i];
-            if (proxy->m_Collection != 0)
+            if (proxy->m_Collection != 0 && !proxy->m_AsyncInit && !proxy->m_AsyncFinal && !proxy->m_AsyncUnload)
             {
                 if (proxy->m_Enabled)
                 {
@@ -428,6 +495,7 @@ namespace dmGameSystem
             }
             if (proxy->m_Collection != 0)
             {
+                CancelAsync(proxy);
                 dmResource::Release(context->m_Factory, proxy->m_Collection);
                 proxy->m_Collection = 0;
                 proxy->m_Initialized = 0;
@@ -441,14 +509,52 @@ namespace dmGameSystem
                 LogMessageError(params.m_Message, "The collection %s could not be unloaded since it was never loaded.", proxy->m_Resource->m_DDF->m_Collection);
             }
         }
-        else if (params.m_Message->m_Id == dmHashString64("init"))
+        else if (params.m_Message->m_Id == dmHashString64("async_unload"))
+        {
+            if (proxy->m_Preloader != 0)
+            {
+                dmResource::DeletePreloader(proxy->m_Preloader);
+                proxy->m_Preloader = 0;
+            }
+            if (proxy->m_Collection != 0 && !proxy->m_AsyncUnload)
+            {
+                if (proxy->m_Initialized || proxy->m_AsyncInit)
+                {
+                    proxy->m_AsyncInit = 0;
+                    proxy->m_AsyncFinal = 1;
+                }
+                proxy->m_AsyncUnload = 1;
+                proxy->m_Enabled = 0;
+                proxy->m_DelayedEnable = 0;
+                proxy->m_Unloader = params.m_Message->m_Sender;
+            }
+            else if (proxy->m_Collection != 0)
+            {
+                LogMessageError(params.m_Message, "The collection %s could not be unloaded since it is already being unloaded.", proxy->m_Resource->m_DDF->m_Collection);
+            }
+            else
+            {
+                LogMessageError(params.m_Message, "The collection %s could not be unloaded since it was never loaded.", proxy->m_Resource->m_DDF->m_Collection);
+            }
+        }
+        else if (params.m_Message->m_Id == dmHashString64("init") || params.m_Message->m_Id == dmHashString64("async_init"))
         {
             if (proxy->m_Collection != 0)
             {
-                if (proxy->m_Initialized == 0)
+                if (proxy->m_AsyncFinal || proxy->m_AsyncUnload)
+                {
+                    LogMessageError(params.m_Message, "The collection %s could not be initialized since it is being finalized.", proxy->m_Resource->m_DDF->m_Collection);
+                }
+                else if (proxy->m_Initialized == 0 && params.m_Message->m_Id == dmHashString64("async_init"))
                 {
+                    proxy->m_AsyncInit = 1;
+                }
+                else if (proxy->m_Initialized == 0)
+                {
+                    // Completes an async init in progress
                     dmGameObject::Init(proxy->m_Collection);
                     proxy->m_Initialized = 1;
+                    proxy->m_AsyncInit = 0;
                 }
                 else
                 {
@@ -460,12 +566,25 @@ namespace dmGameSystem
                 LogMessageError(params.m_Message, "The collection %s could not be initialized since it has not been loaded.", proxy->m_Resource->m_DDF->m_Collection);
             }
         }
-        else if (params.m_Message->m_Id == dmHashString64("final"))
+        else if (params.m_Message->m_Id == dmHashString64("final") || params.m_Message->m_Id == dmHashString64("async_final"))
         {
-            if (proxy->m_Initialized == 1 && proxy->m_Collection != 0x0)
+            if (proxy->m_AsyncUnload)
+            {
+                LogMessageError(params.m_Message, "The collection %s could not be finalized since it is being unloaded.", proxy->m_Resource->m_DDF->m_Collection);
+            }
+            else if ((proxy->m_Initialized == 1 || proxy->m_AsyncInit) && proxy->m_Collection != 0x0 && params.m_Message->m_Id == dmHashString64("async_final"))
+            {
+                // Cancels an async init in progress
+                proxy->m_AsyncInit = 0;
+                proxy->m_AsyncFinal = 1;
+            }
+            else if ((proxy->m_Initialized == 1 || proxy->m_AsyncInit) && proxy->m_Collection != 0x0)
             {
+                // Cancels an async init, or completes an async final, in progress
                 dmGameObject::Final(proxy->m_Collection);
                 proxy->m_Initialized = 0;
+                proxy->m_AsyncInit = 0;
+                proxy->m_AsyncFinal = 0;
             }
             else
             {
@@ -476,11 +595,12 @@ namespace dmGameSystem
         {
             if (proxy->m_Collection != 0)
             {
-                if (proxy->m_Enabled == 0 && proxy->m_DelayedEnable == 0)
+                if (proxy->m_Enabled == 0 && proxy->m_DelayedEnable == 0 && !proxy->m_AsyncUnload)
                 {
                     proxy->m_DelayedEnable = 1;
 
-                    if (proxy->m_Initialized == 0)
+                    // With an async init in progress, the collection is enabled when it is done
+                    if (proxy->m_Initialized == 0 && !proxy->m_AsyncInit)
                     {
                         dmGameObject::Init(proxy->m_Collection);
                         proxy->m_Initialized = 1;
@@ -525,7 +645,7 @@ namespace dmGameSystem
     dmGameObject::InputResult CompCollectionProxyOnInput(const dmGameObject::ComponentOnInputParams& params)
     {
         CollectionProxyComponent* proxy = (CollectionProxyComponent*) *params.m_UserData;
-        if (proxy->m_Enabled)
+        if (proxy->m_Enabled && !proxy->m_AsyncFinal)
         {
             dmGameObject::InputAction* input_action = (dmGameObject::InputAction*)params.m_InputAction;
             dmGameObject::DispatchInput(proxy->m_Collection, input_action, 1);
@@ -656,6 +776,26 @@ namespace dmGameSystem
      * ```
      */
 
+    /*# tells a collection proxy to initialize the loaded collection over several frames
+     * Post this message to a collection-proxy-component to initialize the game objects and components in the referenced collection,
+     * spending at most `collection_proxy.time_budget` microseconds (from game.project) on it each frame.
+     * The collection isn't updated until all of it is initialized. An [ref:enable] posted meanwhile takes effect when the init is done.
+     *
+     * @message
+     * @name async_init
+     * @examples
+     *
+     * ```lua
+     * function on_message(self, message_id, message, sender)
+     *     if message_id == hash("proxy_loaded") then
+     *         -- spread the init of the large level over several frames, then enable it
+     *         msg.post(sender, "async_init")
+     *         msg.post(sender, "enable")
+     *     end
+     * end
+     * ```
+     */
+
     /*# tells a collection proxy to enable the referenced collection
      * Post this message to a collection-proxy-component to enable the referenced collection, which in turn enables the contained game objects and components.
      * If the referenced collection was not initialized prior to this call, it will automatically be initialized.
@@ -740,6 +880,15 @@ namespace dmGameSystem
      * ```
      */
 
+    /*# tells a collection proxy to finalize the referenced collection over several frames
+     * Post this message to a collection-proxy-component to finalize the referenced collection,
+     * spending at most `collection_proxy.time_budget` microseconds (from game.project) on it each frame.
+     * The collection isn't updated until all of it is finalized.
+     *
+     * @message
+     * @name async_final
+     */
+
     /*# tells a collection proxy to start unloading the referenced collection
      *
      * Post this message to a collection-proxy-component to start the unloading of the referenced collection.
@@ -770,6 +919,28 @@ namespace dmGameSystem
      * ```
      */
 
+    /*# tells a collection proxy to unload the referenced collection over several frames
+     *
+     * Post this message to a collection-proxy-component to disable, finalize and unload the referenced collection,
+     * spending at most `collection_proxy.time_budget` microseconds (from game.project) on it each frame.
+     * The game objects are deleted a few at a time, releasing their resources.
+     * When the unloading has completed, the message [ref:proxy_unloaded] will be sent back to the script.
+     *
+     * @message
+     * @name async_unload
+     * @examples
+     *
+     * ```lua
+     * function on_message(self, message_id, message, sender)
+     *     if message_id == hash("end_level") then
+     *         msg.post("#proxy", "async_unload")
+     *     elseif message_id == hash("proxy_unloaded") then
+     *         msg.post("#next_level_proxy", "async_load")
+     *     end
+     * end
+     * ```
+     */
+
     /*# reports that a collection proxy has unloaded its referenced collection
      *
      * This message is sent back to the script that initiated an unload with a collection proxy when
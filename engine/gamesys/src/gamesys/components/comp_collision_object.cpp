@@ -17,6 +17,7 @@
 #include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/message.h>
 
 #include <physics/physics.h>
 
@@ -38,6 +39,12 @@ namespace dmGameSystem
     const char* PHYSICS_MAX_COLLISIONS_KEY  = "physics.max_collisions";
     /// Config key to use for tweaking maximum number of contacts reported
     const char* PHYSICS_MAX_CONTACTS_KEY    = "physics.max_contacts";
+    /// Config key for the frequency of fixed physics steps, 0 steps once per frame with the frame dt
+    const char* PHYSICS_FIXED_UPDATE_FREQUENCY_KEY = "physics.fixed_update_frequency";
+    /// Config key for the maximum number of fixed steps in one frame
+    const char* PHYSICS_MAX_FIXED_TIMESTEPS_KEY    = "physics.max_fixed_timesteps";
+    /// Config key to interpolate the transforms of dynamic objects between the fixed steps
+    const char* PHYSICS_INTERPOLATE_KEY            = "physics.interpolate";
 
     static const dmhash_t PROP_LINEAR_DAMPING = dmHashString64("linear_damping");
     static const dmhash_t PROP_ANGULAR_DAMPING = dmHashString64("angular_damping");
@@ -74,10 +81,14 @@ namespace dmGameSystem
         JointEntry* m_JointEntry;
     };
 
+    struct CollisionWorld;
+
     struct CollisionComponent
     {
         CollisionObjectResource* m_Resource;
         dmGameObject::HInstance m_Instance;
+        // The world is needed in the SetWorldTransform callback, which only gets the component
+        CollisionWorld* m_World;
 
         union
         {
@@ -93,6 +104,8 @@ namespace dmGameSystem
 
         uint16_t m_Mask;
         uint16_t m_ComponentIndex;
+        // The contact messages the component receives, see dmPhysics::ContactEvents
+        uint16_t m_ContactEvents;
         // True if the physics is 3D
         // This is used to determine physics engine kind and to preserve
         // z for the 2d-case
@@ -106,6 +119,21 @@ namespace dmGameSystem
         uint8_t m_StartAsEnabled : 1;
         uint8_t m_FlippedX : 1; // set if it's been flipped
         uint8_t m_FlippedY : 1;
+        // Set if the transform is interpolated between the last two fixed steps, see ApplyInterpolatedTransforms
+        uint8_t m_Interpolate : 1;
+        // Set if m_PrevPosition etc are valid
+        uint8_t m_HasPhysicsState : 1;
+
+        // The last fixed step that reported the state of the body
+        uint32_t m_PhysicsStep;
+        // Body states of the last two fixed steps
+        Vectormath::Aos::Point3 m_PrevPosition;
+        Vectormath::Aos::Point3 m_Position;
+        Vectormath::Aos::Quat m_PrevRotation;
+        Vectormath::Aos::Quat m_Rotation;
+        // The interpolated transform last set on the instance, to detect if it has been moved by someone else
+        Vectormath::Aos::Point3 m_AppliedPosition;
+        Vectormath::Aos::Quat m_AppliedRotation;
     };
 
     struct CollisionWorld
@@ -117,8 +145,17 @@ namespace dmGameSystem
             dmPhysics::HWorld3D m_World3D;
         };
         float m_LastDT; // Used to calculate joint reaction force and torque.
+        // Time not yet simulated when using fixed steps
+        float m_Accumulator;
+        // Number of fixed steps taken
+        uint32_t m_StepCount;
+        // Number of instance transforms set by the physics during the current update
+        uint32_t m_TransformsUpdated;
         uint8_t m_ComponentIndex;
         uint8_t m_3D : 1;
+        // Set while the message buffers are full, to only warn once
+        uint8_t m_CollisionOverflowWarning : 1;
+        uint8_t m_ContactOverflowWarning : 1;
         dmArray<CollisionComponent*> m_Components;
     };
 
@@ -126,6 +163,22 @@ namespace dmGameSystem
     static void DeleteJoint(CollisionWorld* world, dmPhysics::HJoint joint);
     static void DeleteJoint(CollisionWorld* world, JointEntry* joint_entry);
 
+    static bool IsInterpolated(CollisionComponent* component)
+    {
+        // Only root instances are interpolated, their local transforms are their world transforms
+        return component->m_Interpolate && dmGameObject::GetParent(component->m_Instance) == 0;
+    }
+
+    static bool IsEqual(const Vectormath::Aos::Point3& a, const Vectormath::Aos::Point3& b)
+    {
+        return a.getX() == b.getX() && a.getY() == b.getY() && a.getZ() == b.getZ();
+    }
+
+    static bool IsEqual(const Vectormath::Aos::Quat& a, const Vectormath::Aos::Quat& b)
+    {
+        return a.getX() == b.getX() && a.getY() == b.getY() && a.getZ() == b.getZ() && a.getW() == b.getW();
+    }
+
     static void GetWorldTransform(void* user_data, dmTransform::Transform& world_transform)
     {
         if (!user_data)
@@ -133,16 +186,26 @@ namespace dmGameSystem
         CollisionComponent* component = (CollisionComponent*)user_data;
         dmGameObject::HInstance instance = component->m_Instance;
         world_transform = dmGameObject::GetWorldTransform(instance);
-    }
 
-    // TODO: Allow the SetWorldTransform to have a physics context which we can check instead!!
-    static int g_NumPhysicsTransformsUpdated = 0;
+        // The instance is somewhere between the last two steps, so read back the state of the last step
+        // unless the instance has been moved since the interpolated transform was applied
+        if (component->m_HasPhysicsState && IsInterpolated(component))
+        {
+            if (IsEqual(dmGameObject::GetPosition(instance), component->m_AppliedPosition) &&
+                IsEqual(dmGameObject::GetRotation(instance), component->m_AppliedRotation))
+            {
+                world_transform.SetTranslation(Vectormath::Aos::Vector3(component->m_Position));
+                world_transform.SetRotation(component->m_Rotation);
+            }
+            else
+            {
+                component->m_HasPhysicsState = 0;
+            }
+        }
+    }
 
-    static void SetWorldTransform(void* user_data, const Vectormath::Aos::Point3& position, const Vectormath::Aos::Quat& rotation)
+    static void ApplyWorldTransform(CollisionComponent* component, const Vectormath::Aos::Point3& position, const Vectormath::Aos::Quat& rotation)
     {
-        if (!user_data)
-            return;
-        CollisionComponent* component = (CollisionComponent*)user_data;
         dmGameObject::HInstance instance = component->m_Instance;
         if (component->m_3D)
         {
@@ -157,7 +220,71 @@ namespace dmGameSystem
             dmGameObject::SetPosition(instance, p);
         }
         dmGameObject::SetRotation(instance, rotation);
-        ++g_NumPhysicsTransformsUpdated;
+        ++component->m_World->m_TransformsUpdated;
+    }
+
+    static void SetWorldTransform(void* user_data, const Vectormath::Aos::Point3& position, const Vectormath::Aos::Quat& rotation)
+    {
+        if (!user_data)
+            return;
+        CollisionComponent* component = (CollisionComponent*)user_data;
+        if (!IsInterpolated(component))
+        {
+            ApplyWorldTransform(component, position, rotation);
+            return;
+        }
+
+        // Applied after all the steps of the frame
+        if (component->m_HasPhysicsState)
+        {
+            component->m_PrevPosition = component->m_Position;
+            component->m_PrevRotation = component->m_Rotation;
+        }
+        else
+        {
+            component->m_PrevPosition = position;
+            component->m_PrevRotation = rotation;
+        }
+        component->m_Position = position;
+        component->m_Rotation = rotation;
+        component->m_PhysicsStep = component->m_World->m_StepCount;
+        component->m_HasPhysicsState = 1;
+    }
+
+    static void ApplyInterpolatedTransforms(CollisionWorld* world, float alpha)
+    {
+        DM_PROFILE(Physics, "Interpolate");
+        uint32_t num_components = world->m_Components.Size();
+        for (uint32_t i = 0; i < num_components; ++i)
+        {
+            CollisionComponent* component = world->m_Components[i];
+            if (!component->m_HasPhysicsState)
+                continue;
+            if (!IsInterpolated(component))
+            {
+                component->m_HasPhysicsState = 0;
+                continue;
+            }
+            // Not reported by the last step, e.g. fallen asleep or disabled. Settle at the last reported
+            // state, unless the instance has been moved since the interpolated transform was applied
+            if (component->m_PhysicsStep != world->m_StepCount)
+            {
+                dmGameObject::HInstance instance = component->m_Instance;
+                if (IsEqual(dmGameObject::GetPosition(instance), component->m_AppliedPosition) &&
+                    IsEqual(dmGameObject::GetRotation(instance), component->m_AppliedRotation))
+                {
+                    ApplyWorldTransform(component, component->m_Position, component->m_Rotation);
+                }
+                component->m_HasPhysicsState = 0;
+                continue;
+            }
+
+            Vectormath::Aos::Point3 position = lerp(alpha, component->m_PrevPosition, component->m_Position);
+            Vectormath::Aos::Quat rotation = slerp(alpha, component->m_PrevRotation, component->m_Rotation);
+            ApplyWorldTransform(component, position, rotation);
+            component->m_AppliedPosition = dmGameObject::GetPosition(component->m_Instance);
+            component->m_AppliedRotation = rotation;
+        }
     }
 
     dmGameObject::CreateResult CompCollisionObjectNewWorld(const dmGameObject::ComponentNewWorldParams& params)
@@ -326,6 +453,7 @@ namespace dmGameSystem
         out_data.m_LockedRotation = ddf->m_LockedRotation;
         out_data.m_Bullet = ddf->m_Bullet;
         out_data.m_Enabled = enabled;
+        out_data.m_ContactEvents = component->m_ContactEvents;
         for (uint32_t i = 0; i < 16 && resource->m_Mask[i] != 0; ++i)
         {
             out_data.m_Mask |= GetGroupBitIndex(world, resource->m_Mask[i]);
@@ -415,14 +543,19 @@ namespace dmGameSystem
         component->m_3D = (uint8_t) physics_context->m_3D;
         component->m_Resource = (CollisionObjectResource*)params.m_Resource;
         component->m_Instance = params.m_Instance;
+        component->m_World = (CollisionWorld*)params.m_World;
         component->m_Object2D = 0;
         component->m_ComponentIndex = params.m_ComponentIndex;
+        component->m_ContactEvents = dmPhysics::CONTACT_EVENTS_DEFAULT;
         component->m_AddedToUpdate = false;
         component->m_StartAsEnabled = true;
         component->m_Joints = 0x0;
         component->m_JointEndPoints = 0x0;
         component->m_FlippedX = 0;
         component->m_FlippedY = 0;
+        component->m_Interpolate = physics_context->m_FixedUpdateFrequency > 0 && physics_context->m_Interpolate;
+        component->m_HasPhysicsState = 0;
+        component->m_PhysicsStep = 0;
 
         CollisionWorld* world = (CollisionWorld*)params.m_World;
         if (!CreateCollisionObject(physics_context, world, params.m_Instance, component, false))
@@ -513,6 +646,8 @@ namespace dmGameSystem
     {
         CollisionWorld* m_World;
         PhysicsContext* m_Context;
+        // Shared by the collision and contact callbacks to keep the message order
+        dmMessage::Batch* m_Batch;
         uint32_t m_Count;
     };
 
@@ -542,6 +677,40 @@ namespace dmGameSystem
         }
     }
 
+    // Like BroadCast, but the message is written in place in the step message batch
+    template <class DDFMessage>
+    static DDFMessage* BatchBroadCast(CollisionUserData* cud, dmGameObject::HInstance instance, dmhash_t instance_id, uint16_t component_index)
+    {
+        dmMessage::URL receiver;
+        dmMessage::ResetURL(&receiver);
+        receiver.m_Socket = dmGameObject::GetMessageSocket(dmGameObject::GetCollection(instance));
+        receiver.m_Path = instance_id;
+        // sender is the same as receiver, but with the specific collision object as fragment
+        dmMessage::URL sender = receiver;
+        dmGameObject::Result r = dmGameObject::GetComponentId(instance, component_index, &sender.m_Fragment);
+        if (r != dmGameObject::RESULT_OK)
+        {
+            dmLogError("Could not retrieve sender component when reporting %s: %d", DDFMessage::m_DDFDescriptor->m_Name, r);
+        }
+
+        dmMessage::Batch* batch = cud->m_Batch;
+        if (batch->m_Socket != receiver.m_Socket)
+        {
+            // All objects of a world are normally in the same collection, and this only happens for the first message
+            dmMessage::EndBatch(batch);
+            uint32_t expected_count = 2 * dmMath::Max(cud->m_Context->m_MaxCollisionCount, cud->m_Context->m_MaxContactPointCount);
+            dmMessage::Result result = dmMessage::BeginBatch(receiver.m_Socket, expected_count, sizeof(DDFMessage), batch);
+            if (result != dmMessage::RESULT_OK)
+            {
+                dmLogError("Could not send %s to component: %d", DDFMessage::m_DDFDescriptor->m_Name, result);
+                return 0;
+            }
+        }
+
+        uintptr_t descriptor = (uintptr_t)DDFMessage::m_DDFDescriptor;
+        return (DDFMessage*) dmMessage::BatchPost(batch, &sender, &receiver, DDFMessage::m_DDFDescriptor->m_NameHash, 0, 0, descriptor, sizeof(DDFMessage), 0);
+    }
+
     bool CollisionCallback(void* user_data_a, uint16_t group_a, void* user_data_b, uint16_t group_b, void* user_data)
     {
         CollisionUserData* cud = (CollisionUserData*)user_data;
@@ -556,26 +725,39 @@ namespace dmGameSystem
             dmhash_t instance_a_id = dmGameObject::GetIdentifier(instance_a);
             dmhash_t instance_b_id = dmGameObject::GetIdentifier(instance_b);
 
-            dmPhysicsDDF::CollisionResponse ddf;
-
             uint64_t group_hash_a = GetLSBGroupHash(cud->m_World, group_a);
             uint64_t group_hash_b = GetLSBGroupHash(cud->m_World, group_b);
 
-            // Broadcast to A components
-            ddf.m_OwnGroup = group_hash_a;
-            ddf.m_OtherGroup = group_hash_b;
-            ddf.m_Group = group_hash_b;
-            ddf.m_OtherId = instance_b_id;
-            ddf.m_OtherPosition = dmGameObject::GetWorldPosition(instance_b);
-            BroadCast(&ddf, instance_a, instance_a_id, component_a->m_ComponentIndex);
-
-            // Broadcast to B components
-            ddf.m_OwnGroup = group_hash_b;
-            ddf.m_OtherGroup = group_hash_a;
-            ddf.m_Group = group_hash_a;
-            ddf.m_OtherId = instance_a_id;
-            ddf.m_OtherPosition = dmGameObject::GetWorldPosition(instance_a);
-            BroadCast(&ddf, instance_b, instance_b_id, component_b->m_ComponentIndex);
+            // The contact is reported if either component subscribes to it, only post to those that do
+            dmPhysicsDDF::CollisionResponse* ddf = 0;
+            if (component_a->m_ContactEvents & dmPhysics::CONTACT_EVENTS_COLLISION)
+            {
+                // Broadcast to A components
+                ddf = BatchBroadCast<dmPhysicsDDF::CollisionResponse>(cud, instance_a, instance_a_id, component_a->m_ComponentIndex);
+            }
+            if (ddf)
+            {
+                ddf->m_OwnGroup = group_hash_a;
+                ddf->m_OtherGroup = group_hash_b;
+                ddf->m_Group = group_hash_b;
+                ddf->m_OtherId = instance_b_id;
+                ddf->m_OtherPosition = dmGameObject::GetWorldPosition(instance_b);
+            }
+
+            ddf = 0;
+            if (component_b->m_ContactEvents & dmPhysics::CONTACT_EVENTS_COLLISION)
+            {
+                // Broadcast to B components
+                ddf = BatchBroadCast<dmPhysicsDDF::CollisionResponse>(cud, instance_b, instance_b_id, component_b->m_ComponentIndex);
+            }
+            if (ddf)
+            {
+                ddf->m_OwnGroup = group_hash_b;
+                ddf->m_OtherGroup = group_hash_a;
+                ddf->m_Group = group_hash_a;
+                ddf->m_OtherId = instance_a_id;
+                ddf->m_OtherPosition = dmGameObject::GetWorldPosition(instance_a);
+            }
 
             return true;
         }
@@ -599,44 +781,58 @@ namespace dmGameSystem
             dmhash_t instance_a_id = dmGameObject::GetIdentifier(instance_a);
             dmhash_t instance_b_id = dmGameObject::GetIdentifier(instance_b);
 
-            dmPhysicsDDF::ContactPointResponse ddf;
             float mass_a = dmMath::Select(-contact_point.m_MassA, 0.0f, contact_point.m_MassA);
             float mass_b = dmMath::Select(-contact_point.m_MassB, 0.0f, contact_point.m_MassB);
 
             uint64_t group_hash_a = GetLSBGroupHash(cud->m_World, contact_point.m_GroupA);
             uint64_t group_hash_b = GetLSBGroupHash(cud->m_World, contact_point.m_GroupB);
 
-            // Broadcast to A components
-            ddf.m_Position = contact_point.m_PositionA;
-            ddf.m_Normal = -contact_point.m_Normal;
-            ddf.m_RelativeVelocity = -contact_point.m_RelativeVelocity;
-            ddf.m_Distance = contact_point.m_Distance;
-            ddf.m_AppliedImpulse = contact_point.m_AppliedImpulse;
-            ddf.m_Mass = mass_a;
-            ddf.m_OtherMass = mass_b;
-            ddf.m_OtherId = instance_b_id;
-            ddf.m_OtherPosition = dmGameObject::GetWorldPosition(instance_b);
-            ddf.m_Group = group_hash_b;
-            ddf.m_OwnGroup = group_hash_a;
-            ddf.m_OtherGroup = group_hash_b;
-            ddf.m_LifeTime = 0;
-            BroadCast(&ddf, instance_a, instance_a_id, component_a->m_ComponentIndex);
-
-            // Broadcast to B components
-            ddf.m_Position = contact_point.m_PositionB;
-            ddf.m_Normal = contact_point.m_Normal;
-            ddf.m_RelativeVelocity = contact_point.m_RelativeVelocity;
-            ddf.m_Distance = contact_point.m_Distance;
-            ddf.m_AppliedImpulse = contact_point.m_AppliedImpulse;
-            ddf.m_Mass = mass_b;
-            ddf.m_OtherMass = mass_a;
-            ddf.m_OtherId = instance_a_id;
-            ddf.m_OtherPosition = dmGameObject::GetWorldPosition(instance_a);
-            ddf.m_Group = group_hash_a;
-            ddf.m_OwnGroup = group_hash_b;
-            ddf.m_OtherGroup = group_hash_a;
-            ddf.m_LifeTime = 0;
-            BroadCast(&ddf, instance_b, instance_b_id, component_b->m_ComponentIndex);
+            // The contact is reported if either component subscribes to it, only post to those that do
+            dmPhysicsDDF::ContactPointResponse* ddf = 0;
+            if (component_a->m_ContactEvents & dmPhysics::CONTACT_EVENTS_CONTACT_POINT)
+            {
+                // Broadcast to A components
+                ddf = BatchBroadCast<dmPhysicsDDF::ContactPointResponse>(cud, instance_a, instance_a_id, component_a->m_ComponentIndex);
+            }
+            if (ddf)
+            {
+                ddf->m_Position = contact_point.m_PositionA;
+                ddf->m_Normal = -contact_point.m_Normal;
+                ddf->m_RelativeVelocity = -contact_point.m_RelativeVelocity;
+                ddf->m_Distance = contact_point.m_Distance;
+                ddf->m_AppliedImpulse = contact_point.m_AppliedImpulse;
+                ddf->m_Mass = mass_a;
+                ddf->m_OtherMass = mass_b;
+                ddf->m_OtherId = instance_b_id;
+                ddf->m_OtherPosition = dmGameObject::GetWorldPosition(instance_b);
+                ddf->m_Group = group_hash_b;
+                ddf->m_OwnGroup = group_hash_a;
+                ddf->m_OtherGroup = group_hash_b;
+                ddf->m_LifeTime = 0;
+            }
+
+            ddf = 0;
+            if (component_b->m_ContactEvents & dmPhysics::CONTACT_EVENTS_CONTACT_POINT)
+            {
+                // Broadcast to B components
+                ddf = BatchBroadCast<dmPhysicsDDF::ContactPointResponse>(cud, instance_b, instance_b_id, component_b->m_ComponentIndex);
+            }
+            if (ddf)
+            {
+                ddf->m_Position = contact_point.m_PositionB;
+                ddf->m_Normal = contact_point.m_Normal;
+                ddf->m_RelativeVelocity = contact_point.m_RelativeVelocity;
+                ddf->m_Distance = contact_point.m_Distance;
+                ddf->m_AppliedImpulse = contact_point.m_AppliedImpulse;
+                ddf->m_Mass = mass_b;
+                ddf->m_OtherMass = mass_a;
+                ddf->m_OtherId = instance_a_id;
+                ddf->m_OtherPosition = dmGameObject::GetWorldPosition(instance_a);
+                ddf->m_Group = group_hash_a;
+                ddf->m_OwnGroup = group_hash_b;
+                ddf->m_OtherGroup = group_hash_a;
+                ddf->m_LifeTime = 0;
+            }
 
             return true;
         }
@@ -646,8 +842,6 @@ namespace dmGameSystem
         }
     }
 
-    static bool g_CollisionOverflowWarning = false;
-    static bool g_ContactOverflowWarning = false;
 
     void TriggerEnteredCallback(const dmPhysics::TriggerEnter& trigger_enter, void* user_data)
     {
@@ -915,17 +1109,22 @@ namespace dmGameSystem
             }
         }
 
+        // The collision and contact messages of a step are posted in one batch
+        dmMessage::Batch message_batch;
+        memset(&message_batch, 0, sizeof(message_batch));
+
         CollisionUserData collision_user_data;
         collision_user_data.m_World = world;
         collision_user_data.m_Context = physics_context;
+        collision_user_data.m_Batch = &message_batch;
         collision_user_data.m_Count = 0;
         CollisionUserData contact_user_data;
         contact_user_data.m_World = world;
         contact_user_data.m_Context = physics_context;
+        contact_user_data.m_Batch = &message_batch;
         contact_user_data.m_Count = 0;
 
         dmPhysics::StepWorldContext step_world_context;
-        step_world_context.m_DT = params.m_UpdateContext->m_DT;
         step_world_context.m_CollisionCallback = CollisionCallback;
         step_world_context.m_CollisionUserData = &collision_user_data;
         step_world_context.m_ContactPointCallback = ContactPointCallback;
@@ -937,44 +1136,72 @@ namespace dmGameSystem
         step_world_context.m_RayCastCallback = RayCastCallback;
         step_world_context.m_RayCastUserData = world;
 
-        world->m_LastDT = params.m_UpdateContext->m_DT;
+        world->m_TransformsUpdated = 0;
 
-        g_NumPhysicsTransformsUpdated = 0;
+        // With a fixed update frequency the world is stepped zero or more times to catch up with the frame time
+        float dt = params.m_UpdateContext->m_DT;
+        uint32_t step_count = 1;
+        if (physics_context->m_FixedUpdateFrequency > 0)
+        {
+            float fixed_dt = 1.0f / physics_context->m_FixedUpdateFrequency;
+            world->m_Accumulator += dt;
+            step_count = (uint32_t)(world->m_Accumulator / fixed_dt);
+            world->m_Accumulator -= step_count * fixed_dt;
+            if (step_count > physics_context->m_MaxFixedTimesteps)
+            {
+                // Too far behind, let the simulation run slower rather than spending even more time on it
+                step_count = physics_context->m_MaxFixedTimesteps;
+            }
+            dt = fixed_dt;
+        }
 
-        if (physics_context->m_3D)
+        step_world_context.m_DT = dt;
+        for (uint32_t i = 0; i < step_count; ++i)
         {
-            dmPhysics::StepWorld3D(world->m_World3D, step_world_context);
+            world->m_LastDT = dt;
+            ++world->m_StepCount;
+            if (physics_context->m_3D)
+            {
+                dmPhysics::StepWorld3D(world->m_World3D, step_world_context);
+            }
+            else
+            {
+                dmPhysics::StepWorld2D(world->m_World2D, step_world_context);
+            }
         }
-        else
+
+        if (physics_context->m_FixedUpdateFrequency > 0 && physics_context->m_Interpolate)
         {
-            dmPhysics::StepWorld2D(world->m_World2D, step_world_context);
+            ApplyInterpolatedTransforms(world, world->m_Accumulator * physics_context->m_FixedUpdateFrequency);
         }
 
-        update_result.m_TransformsUpdated = g_NumPhysicsTransformsUpdated > 0;
+        dmMessage::EndBatch(&message_batch);
+
+        update_result.m_TransformsUpdated = world->m_TransformsUpdated > 0;
 
         if (collision_user_data.m_Count >= physics_context->m_MaxCollisionCount)
         {
-            if (!g_CollisionOverflowWarning)
+            if (!world->m_CollisionOverflowWarning)
             {
                 dmLogWarning("Maximum number of collisions (%d) reached, messages have been lost. Tweak \"%s\" in the config file.", physics_context->m_MaxCollisionCount, PHYSICS_MAX_COLLISIONS_KEY);
-                g_CollisionOverflowWarning = true;
+                world->m_CollisionOverflowWarning = true;
             }
         }
         else
         {
-            g_CollisionOverflowWarning = false;
+            world->m_CollisionOverflowWarning = false;
         }
         if (contact_user_data.m_Count >= physics_context->m_MaxContactPointCount)
         {
-            if (!g_ContactOverflowWarning)
+            if (!world->m_ContactOverflowWarning)
             {
                 dmLogWarning("Maximum number of contacts (%d) reached, messages have been lost. Tweak \"%s\" in the config file.", physics_context->m_MaxContactPointCount, PHYSICS_MAX_CONTACTS_KEY);
-                g_ContactOverflowWarning = true;
+                world->m_ContactOverflowWarning = true;
             }
         }
         else
         {
-            g_ContactOverflowWarning = false;
+            world->m_ContactOverflowWarning = false;
         }
         if (physics_context->m_3D)
             dmPhysics::SetDrawDebug3D(world->m_World3D, physics_context->m_Debug);
@@ -1264,6 +1491,45 @@ namespace dmGameSystem
         }
     }
 
+    void RayCastBatch(void* _world, const dmPhysics::RayCastRequest* requests, dmPhysics::RayCastResponse* responses, uint32_t count, dmJob::HContext job_context)
+    {
+        CollisionWorld* world = (CollisionWorld*)_world;
+        if (world->m_3D)
+        {
+            dmPhysics::RayCastBatch3D(world->m_World3D, requests, responses, count, job_context);
+        }
+        else
+        {
+            dmPhysics::RayCastBatch2D(world->m_World2D, requests, responses, count, job_context);
+        }
+    }
+
+    void OverlapBatch(void* _world, const dmPhysics::ShapeQueryRequest* requests, uint32_t count, dmArray<dmPhysics::OverlapResponse>& results, uint32_t* result_counts)
+    {
+        CollisionWorld* world = (CollisionWorld*)_world;
+        if (world->m_3D)
+        {
+            dmPhysics::OverlapBatch3D(world->m_World3D, requests, count, results, result_counts);
+        }
+        else
+        {
+            dmPhysics::OverlapBatch2D(world->m_World2D, requests, count, results, result_counts);
+        }
+    }
+
+    void ShapeCastBatch(void* _world, const dmPhysics::ShapeQueryRequest* requests, dmPhysics::RayCastResponse* responses, uint32_t count)
+    {
+        CollisionWorld* world = (CollisionWorld*)_world;
+        if (world->m_3D)
+        {
+            dmPhysics::ShapeCastBatch3D(world->m_World3D, requests, responses, count);
+        }
+        else
+        {
+            dmPhysics::ShapeCastBatch2D(world->m_World2D, requests, responses, count);
+        }
+    }
+
     // Find a JointEntry in the linked list of a collision component based on the joint id.
     static JointEntry* FindJointEntry(CollisionWorld* world, CollisionComponent* component, dmhash_t id)
     {
@@ -1594,4 +1860,24 @@ namespace dmGameSystem
         }
     }
 
+    void SetContactEvents(void* _world, void* _component, uint16_t events)
+    {
+        CollisionWorld* world = (CollisionWorld*)_world;
+        CollisionComponent* component = (CollisionComponent*)_component;
+
+        component->m_ContactEvents = events;
+        if (world->m_3D)
+        {
+            dmPhysics::SetContactEvents3D(world->m_World3D, component->m_Object3D, events);
+        } else
+        {
+            dmPhysics::SetContactEvents2D(world->m_World2D, component->m_Object2D, events);
+        }
+    }
+
+    uint16_t GetContactEvents(void* _component)
+    {
+        CollisionComponent* component = (CollisionComponent*)_component;
+        return component->m_ContactEvents;
+    }
 }
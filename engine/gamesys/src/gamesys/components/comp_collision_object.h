@@ -51,6 +51,9 @@ namespace dmGameSystem
 
     // For script_physics.cpp
     void RayCast(void* world, const dmPhysics::RayCastRequest& request, dmArray<dmPhysics::RayCastResponse>& results);
+    void RayCastBatch(void* world, const dmPhysics::RayCastRequest* requests, dmPhysics::RayCastResponse* responses, uint32_t count, dmJob::HContext job_context);
+    void OverlapBatch(void* world, const dmPhysics::ShapeQueryRequest* requests, uint32_t count, dmArray<dmPhysics::OverlapResponse>& results, uint32_t* result_counts);
+    void ShapeCastBatch(void* world, const dmPhysics::ShapeQueryRequest* requests, dmPhysics::RayCastResponse* responses, uint32_t count);
     uint64_t GetLSBGroupHash(void* world, uint16_t mask);
     dmhash_t CompCollisionObjectGetIdentifier(void* component);
 
@@ -69,6 +72,8 @@ namespace dmGameSystem
     void SetCollisionFlipH(void* _component, bool flip);
     void SetCollisionFlipV(void* _component, bool flip);
     void WakeupCollision(void* _world, void* _component);
+    void SetContactEvents(void* _world, void* _component, uint16_t events);
+    uint16_t GetContactEvents(void* _component);
 }
 
 #endif // DM_GAMESYS_COMP_COLLISION_OBJECT_H
@@ -11,6 +11,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <string.h>
+#include <float.h>
 
 #include <dlib/array.h>
 #include <dlib/hash.h>
@@ -114,7 +115,8 @@ namespace dmGameSystem
         gui_world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(dmRender::GetGraphicsContext(gui_context->m_RenderContext), ve, sizeof(ve) / sizeof(dmGraphics::VertexElement));
         // Grows automatically
         gui_world->m_ClientVertexBuffer.SetCapacity(512);
-        gui_world->m_VertexBuffer = dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(gui_context->m_RenderContext), 0, 0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+        gui_world->m_DynamicVertexBuffer = dmGraphics::NewDynamicVertexBuffer(dmRender::GetGraphicsContext(gui_context->m_RenderContext));
+        gui_world->m_VertexBuffer = 0;
 
         uint8_t white_texture[] = { 0xff, 0xff, 0xff, 0xff,
                                     0xff, 0xff, 0xff, 0xff,
@@ -146,6 +148,7 @@ namespace dmGameSystem
         gui_world->m_MaxParticleFXCount = gui_context->m_MaxParticleFXCount;
         gui_world->m_MaxParticleCount = gui_context->m_MaxParticleCount;
         gui_world->m_ParticleContext = dmParticle::CreateContext(gui_world->m_MaxParticleFXCount, gui_world->m_MaxParticleCount);
+        dmParticle::SetJobContext(gui_world->m_ParticleContext, dmRender::GetJobContext(gui_context->m_RenderContext));
 
         gui_world->m_ScriptWorld = dmScript::NewScriptWorld(gui_context->m_ScriptContext);
 
@@ -175,7 +178,7 @@ namespace dmGameSystem
         dmParticle::DestroyContext(gui_world->m_ParticleContext);
 
         dmGraphics::DeleteVertexDeclaration(gui_world->m_VertexDeclaration);
-        dmGraphics::DeleteVertexBuffer(gui_world->m_VertexBuffer);
+        dmGraphics::DeleteDynamicVertexBuffer(gui_world->m_DynamicVertexBuffer);
         dmGraphics::DeleteTexture(gui_world->m_WhiteTexture);
 
         dmRig::DeleteContext(gui_world->m_RigContext);
@@ -190,6 +193,11 @@ namespace dmGameSystem
     {
         bool result = true;
 
+        // When a layout is set the node usually keeps its resources, which are then not set up again.
+        // A size from the texture is kept with them.
+        dmGui::SizeMode prev_size_mode = dmGui::GetNodeSizeMode(scene, n);
+        Vector4 prev_size = dmGui::GetNodeProperty(scene, n, dmGui::PROPERTY_SIZE);
+
         // properties
         dmGui::SetNodePosition(scene, n, Point3(node_desc->m_Position.getXYZ()));
         dmGui::SetNodeProperty(scene, n, dmGui::PROPERTY_ROTATION, node_desc->m_Rotation);
@@ -227,7 +235,24 @@ namespace dmGameSystem
                 if(texture_anim_name)
                     *texture_anim_name++ = 0;
 
-                dmGui::Result gui_result = dmGui::SetNodeTexture(scene, n, texture_str);
+                dmhash_t texture_id = dmHashString64(texture_str);
+                dmhash_t texture_anim_id = texture_anim_name ? dmHashString64(texture_anim_name) : 0;
+                dmGui::Result gui_result = dmGui::RESULT_OK;
+                dmGui::NodeTextureType texture_type;
+                bool texture_unchanged = dmGui::GetNodeTexture(scene, n, &texture_type) != 0x0
+                                      && dmGui::GetNodeTextureId(scene, n) == texture_id
+                                      && dmGui::GetNodeFlipbookAnimId(scene, n) == texture_anim_id
+                                      && prev_size_mode == (dmGui::SizeMode) node_desc->m_SizeMode;
+                if (texture_unchanged)
+                {
+                    if (prev_size_mode != dmGui::SIZE_MODE_MANUAL)
+                        dmGui::SetNodeProperty(scene, n, dmGui::PROPERTY_SIZE, prev_size);
+                    texture_anim_name = NULL;
+                }
+                else
+                {
+                    gui_result = dmGui::SetNodeTexture(scene, n, texture_id);
+                }
                 if (gui_result != dmGui::RESULT_OK)
                 {
                     dmLogError("The texture '%s' could not be set for '%s', result: %d.", texture_str, node_desc->m_Id != 0x0 ? node_desc->m_Id : "unnamed", gui_result);
@@ -253,7 +278,11 @@ namespace dmGameSystem
         // layer setup
         if (node_desc->m_Layer != 0x0 && *node_desc->m_Layer != '\0')
         {
-            dmGui::Result gui_result = dmGui::SetNodeLayer(scene, n, node_desc->m_Layer);
+            dmhash_t layer_id = dmHashString64(node_desc->m_Layer);
+            // Setting the layer sorts the render entries again
+            dmGui::Result gui_result = dmGui::RESULT_OK;
+            if (dmGui::GetNodeLayerId(scene, n) != layer_id)
+                gui_result = dmGui::SetNodeLayer(scene, n, layer_id);
             if (gui_result != dmGui::RESULT_OK)
             {
                 dmLogError("The layer '%s' could not be set for the '%s', result: %d.", node_desc->m_Layer, node_desc->m_Id != 0x0 ? node_desc->m_Id : "unnamed", gui_result);
@@ -290,11 +319,17 @@ namespace dmGameSystem
         switch(node_desc->m_Type)
         {
             case dmGuiDDF::NodeDesc::TYPE_TEXT:
-                dmGui::SetNodeText(scene, n, node_desc->m_Text);
-                dmGui::SetNodeFont(scene, n, node_desc->m_Font);
+            {
+                const char* text = dmGui::GetNodeText(scene, n);
+                if (text == 0x0 || node_desc->m_Text == 0x0 || strcmp(text, node_desc->m_Text) != 0)
+                    dmGui::SetNodeText(scene, n, node_desc->m_Text);
+                dmhash_t font_id = dmHashString64(node_desc->m_Font);
+                if (dmGui::GetNodeFontId(scene, n) != font_id)
+                    dmGui::SetNodeFont(scene, n, font_id);
                 dmGui::SetNodeLineBreak(scene, n, node_desc->m_LineBreak);
                 dmGui::SetNodeTextLeading(scene, n, node_desc->m_TextLeading);
                 dmGui::SetNodeTextTracking(scene, n, node_desc->m_TextTracking);
+            }
             break;
 
             case dmGuiDDF::NodeDesc::TYPE_PIE:
@@ -305,7 +340,19 @@ namespace dmGameSystem
             break;
 
             case dmGuiDDF::NodeDesc::TYPE_SPINE:
-                dmGui::SetNodeSpineScene(scene, n, node_desc->m_SpineScene, dmHashString64(node_desc->m_SpineSkin), dmHashString64(node_desc->m_SpineDefaultAnimation), false);
+            {
+                // Setting the spine scene creates a new rig instance
+                dmhash_t spine_scene_id = dmHashString64(node_desc->m_SpineScene);
+                dmhash_t skin_id = dmHashString64(node_desc->m_SpineSkin);
+                dmhash_t default_animation_id = dmHashString64(node_desc->m_SpineDefaultAnimation);
+                if (dmGui::GetNodeRigInstance(scene, n) == 0x0
+                    || dmGui::GetNodeSpineScene(scene, n) != spine_scene_id
+                    || dmGui::GetNodeSpineSkin(scene, n) != skin_id
+                    || dmGui::GetNodeSpineAnimation(scene, n) != default_animation_id)
+                {
+                    dmGui::SetNodeSpineScene(scene, n, spine_scene_id, skin_id, default_animation_id, false);
+                }
+            }
             break;
 
             case dmGuiDDF::NodeDesc::TYPE_PARTICLEFX:
@@ -739,7 +786,7 @@ namespace dmGameSystem
     }
 
     static void ApplyStencilClipping(RenderGuiContext* gui_context, const dmGui::StencilScope* state, dmRender::StencilTestParams& stp) {
-        if (state != 0x0) {
+        if (state != 0x0 && !state->m_Scissor) {
             stp.m_Front.m_Func = dmGraphics::COMPARE_FUNC_EQUAL;
             stp.m_Front.m_OpSFail = dmGraphics::STENCIL_OP_KEEP;
             stp.m_Front.m_OpDPFail = dmGraphics::STENCIL_OP_REPLACE;
@@ -774,11 +821,19 @@ namespace dmGameSystem
     static void ApplyStencilClipping(RenderGuiContext* gui_context, const dmGui::StencilScope* state, dmRender::RenderObject& ro) {
         ro.m_SetStencilTest = 1;
         ApplyStencilClipping(gui_context, state, ro.m_StencilTestParams);
+        ro.m_SetScissor = state != 0x0 && state->m_Scissor;
+        if (ro.m_SetScissor) {
+            memcpy(ro.m_ScissorRect, state->m_ScissorRect, sizeof(ro.m_ScissorRect));
+        }
     }
 
     static void ApplyStencilClipping(RenderGuiContext* gui_context, const dmGui::StencilScope* state, dmRender::DrawTextParams& params) {
         params.m_StencilTestParamsSet = 1;
         ApplyStencilClipping(gui_context, state, params.m_StencilTestParams);
+        params.m_ScissorSet = state != 0x0 && state->m_Scissor;
+        if (params.m_ScissorSet) {
+            memcpy(params.m_ScissorRect, state->m_ScissorRect, sizeof(params.m_ScissorRect));
+        }
     }
 
     static dmGraphics::HTexture GetNodeTexture(dmGui::HScene scene, dmGui::HNode node)
@@ -1068,6 +1123,51 @@ namespace dmGameSystem
         gui_world->m_ClientVertexBuffer.SetSize(vb_end - gui_world->m_ClientVertexBuffer.Begin());
     }
 
+    // Keeps the vertices of a node, written at key.m_VertexStart in the client vertex buffer, for the next frame
+    static void StoreBoxVertices(GuiWorld* gui_world, const BoxVertexCacheKey& key)
+    {
+        uint32_t write_index = gui_world->m_BoxCacheFrame & 1;
+        dmArray<BoxVertexCacheKey>& keys = gui_world->m_BoxCacheKeys[write_index];
+        dmArray<BoxVertex>& vertices = gui_world->m_BoxCacheVertices[write_index];
+        if (keys.Full()) {
+            keys.OffsetCapacity(dmMath::Max(64U, keys.Capacity()));
+        }
+        if (vertices.Remaining() < key.m_VertexCount) {
+            vertices.OffsetCapacity(dmMath::Max(dmMath::Max(1024U, vertices.Capacity()), key.m_VertexCount));
+        }
+
+        BoxVertexCacheKey cached = key;
+        cached.m_VertexStart = vertices.Size();
+        keys.Push(cached);
+        vertices.PushArray(gui_world->m_ClientVertexBuffer.Begin() + key.m_VertexStart, key.m_VertexCount);
+    }
+
+    // Copies the vertices generated last frame if the node was rendered at the same position in the frame with the same inputs.
+    // Returns false if the vertices need to be generated
+    static bool ReuseBoxVertices(GuiWorld* gui_world, BoxVertexCacheKey& key)
+    {
+        uint32_t write_index = gui_world->m_BoxCacheFrame & 1;
+        const dmArray<BoxVertexCacheKey>& prev_keys = gui_world->m_BoxCacheKeys[write_index ^ 1];
+        uint32_t index = gui_world->m_BoxCacheKeys[write_index].Size();
+        if (index >= prev_keys.Size())
+            return false;
+
+        const BoxVertexCacheKey& prev = prev_keys[index];
+        const size_t key_size = (const uint8_t*) &key.m_VertexStart - (const uint8_t*) &key;
+        if (memcmp(&prev, &key, key_size) != 0)
+            return false;
+
+        if (gui_world->m_ClientVertexBuffer.Remaining() < prev.m_VertexCount) {
+            gui_world->m_ClientVertexBuffer.OffsetCapacity(dmMath::Max(128U, prev.m_VertexCount));
+        }
+        key.m_VertexStart = gui_world->m_ClientVertexBuffer.Size();
+        key.m_VertexCount = prev.m_VertexCount;
+        gui_world->m_ClientVertexBuffer.PushArray(gui_world->m_BoxCacheVertices[write_index ^ 1].Begin() + prev.m_VertexStart, prev.m_VertexCount);
+        StoreBoxVertices(gui_world, key);
+        gui_world->m_BoxCacheHits++;
+        return true;
+    }
+
     void RenderBoxNodes(dmGui::HScene scene,
                         const dmGui::RenderEntry* entries,
                         const Matrix4* node_transforms,
@@ -1194,10 +1294,37 @@ namespace dmGameSystem
             if (!manually_set_texture)
                 GetNodeFlipbookAnimUVFlip(scene, node, flip_u, flip_v);
 
+            int32_t frame_index = texture_set_ddf ? dmGui::GetNodeAnimationFrame(scene, node) : 0;
+            Point3 size = dmGui::GetNodeSize(scene, node);
+
+            BoxVertexCacheKey key;
+            memset(&key, 0, sizeof(key));
+            key.m_Transform = node_transforms[i];
+            key.m_Color = pm_color;
+            key.m_Slice9 = slice9;
+            memcpy(key.m_TexCoords, tc, sizeof(key.m_TexCoords));
+            key.m_Size[0] = size.getX();
+            key.m_Size[1] = size.getY();
+            key.m_TextureSize[0] = org_width;
+            key.m_TextureSize[1] = org_height;
+            key.m_Scene = scene;
+            key.m_Texture = ro.m_Textures[0];
+            key.m_TextureSet = texture_set_ddf;
+            key.m_Node = node;
+            key.m_Frame = frame_index;
+            key.m_Flip = (flip_u ? 1 : 0) | (flip_v ? 2 : 0);
+
+            if (ReuseBoxVertices(gui_world, key))
+            {
+                rendered_vert_count += key.m_VertexCount;
+                continue;
+            }
+
+            key.m_VertexStart = gui_world->m_ClientVertexBuffer.Size();
+
             // render using geometries without 9-slicing
             if (!use_slice_nine && use_geometries)
             {
-                int32_t frame_index = dmGui::GetNodeAnimationFrame(scene, node);
                 frame_index = texture_set_ddf->m_FrameIndices[frame_index];
 
                 const dmGameSystemDDF::SpriteGeometry* geometry = &texture_set_ddf->m_Geometries.m_Data[frame_index];
@@ -1235,124 +1362,125 @@ namespace dmGameSystem
                     BoxVertex v(p, uv[0], uv[1], pm_color);
                     gui_world->m_ClientVertexBuffer.Push(v);
                 }
-
-                rendered_vert_count += index_count;
-                continue;
-            }
-
-            // render 9-sliced node
-
-            //   0 1     2 3
-            // 0 *-*-----*-*
-            //   | |  y  | |
-            // 1 *-*-----*-*
-            //   | |     | |
-            //   |x|     |z|
-            //   | |     | |
-            // 2 *-*-----*-*
-            //   | |  w  | |
-            // 3 *-*-----*-*
-            float us[4], vs[4], xs[4], ys[4];
-
-            // v are '1-v'
-            xs[0] = ys[0] = 0;
-            xs[3] = ys[3] = 1;
-
-            // disable slice9 computation below a certain dimension
-            // (avoid div by zero)
-            const float s9_min_dim = 0.001f;
-
-            const float su = 1.0f / org_width;
-            const float sv = 1.0f / org_height;
-
-            Point3 size = dmGui::GetNodeSize(scene, node);
-            const float sx = size.getX() > s9_min_dim ? 1.0f / size.getX() : 0;
-            const float sy = size.getY() > s9_min_dim ? 1.0f / size.getY() : 0;
-
-            static const uint32_t uvIndex[2][4] = {{0,1,2,3}, {3,2,1,0}};
-            bool uv_rotated = tc[0] != tc[2] && tc[3] != tc[5];
-            if(uv_rotated)
-            {
-                const uint32_t *uI = flip_v ? uvIndex[1] : uvIndex[0];
-                const uint32_t *vI = flip_u ? uvIndex[1] : uvIndex[0];
-                us[uI[0]] = tc[0];
-                us[uI[1]] = tc[0] + (su * slice9.getW());
-                us[uI[2]] = tc[2] - (su * slice9.getY());
-                us[uI[3]] = tc[2];
-                vs[vI[0]] = tc[1];
-                vs[vI[1]] = tc[1] - (sv * slice9.getX());
-                vs[vI[2]] = tc[5] + (sv * slice9.getZ());
-                vs[vI[3]] = tc[5];
             }
             else
             {
-                const uint32_t *uI = flip_u ? uvIndex[1] : uvIndex[0];
-                const uint32_t *vI = flip_v ? uvIndex[1] : uvIndex[0];
-                us[uI[0]] = tc[0];
-                us[uI[1]] = tc[0] + (su * slice9.getX());
-                us[uI[2]] = tc[4] - (su * slice9.getZ());
-                us[uI[3]] = tc[4];
-                vs[vI[0]] = tc[1];
-                vs[vI[1]] = tc[1] + (sv * slice9.getW());
-                vs[vI[2]] = tc[3] - (sv * slice9.getY());
-                vs[vI[3]] = tc[3];
-            }
-
-            xs[1] = sx * slice9.getX();
-            xs[2] = 1 - sx * slice9.getZ();
-            ys[1] = sy * slice9.getW();
-            ys[2] = 1 - sy * slice9.getY();
-
-            const Matrix4* transform = &node_transforms[i];
-            Vectormath::Aos::Vector4 pts[4][4];
-            for (int y=0;y<4;y++)
-            {
-                for (int x=0;x<4;x++)
+                // render 9-sliced node
+
+                //   0 1     2 3
+                // 0 *-*-----*-*
+                //   | |  y  | |
+                // 1 *-*-----*-*
+                //   | |     | |
+                //   |x|     |z|
+                //   | |     | |
+                // 2 *-*-----*-*
+                //   | |  w  | |
+                // 3 *-*-----*-*
+                float us[4], vs[4], xs[4], ys[4];
+
+                // v are '1-v'
+                xs[0] = ys[0] = 0;
+                xs[3] = ys[3] = 1;
+
+                // disable slice9 computation below a certain dimension
+                // (avoid div by zero)
+                const float s9_min_dim = 0.001f;
+
+                const float su = 1.0f / org_width;
+                const float sv = 1.0f / org_height;
+
+                const float sx = size.getX() > s9_min_dim ? 1.0f / size.getX() : 0;
+                const float sy = size.getY() > s9_min_dim ? 1.0f / size.getY() : 0;
+
+                static const uint32_t uvIndex[2][4] = {{0,1,2,3}, {3,2,1,0}};
+                bool uv_rotated = tc[0] != tc[2] && tc[3] != tc[5];
+                if(uv_rotated)
                 {
-                    pts[y][x] = (*transform * Vectormath::Aos::Point3(xs[x], ys[y], 0));
+                    const uint32_t *uI = flip_v ? uvIndex[1] : uvIndex[0];
+                    const uint32_t *vI = flip_u ? uvIndex[1] : uvIndex[0];
+                    us[uI[0]] = tc[0];
+                    us[uI[1]] = tc[0] + (su * slice9.getW());
+                    us[uI[2]] = tc[2] - (su * slice9.getY());
+                    us[uI[3]] = tc[2];
+                    vs[vI[0]] = tc[1];
+                    vs[vI[1]] = tc[1] - (sv * slice9.getX());
+                    vs[vI[2]] = tc[5] + (sv * slice9.getZ());
+                    vs[vI[3]] = tc[5];
+                }
+                else
+                {
+                    const uint32_t *uI = flip_u ? uvIndex[1] : uvIndex[0];
+                    const uint32_t *vI = flip_v ? uvIndex[1] : uvIndex[0];
+                    us[uI[0]] = tc[0];
+                    us[uI[1]] = tc[0] + (su * slice9.getX());
+                    us[uI[2]] = tc[4] - (su * slice9.getZ());
+                    us[uI[3]] = tc[4];
+                    vs[vI[0]] = tc[1];
+                    vs[vI[1]] = tc[1] + (sv * slice9.getW());
+                    vs[vI[2]] = tc[3] - (sv * slice9.getY());
+                    vs[vI[3]] = tc[3];
                 }
-            }
 
-            BoxVertex v00, v10, v01, v11;
-            v00.SetColor(pm_color);
-            v10.SetColor(pm_color);
-            v01.SetColor(pm_color);
-            v11.SetColor(pm_color);
-            for (int y=0;y<3;y++)
-            {
-                for (int x=0;x<3;x++)
+                xs[1] = sx * slice9.getX();
+                xs[2] = 1 - sx * slice9.getZ();
+                ys[1] = sy * slice9.getW();
+                ys[2] = 1 - sy * slice9.getY();
+
+                const Matrix4* transform = &node_transforms[i];
+                Vectormath::Aos::Vector4 pts[4][4];
+                for (int y=0;y<4;y++)
                 {
-                    const int x0 = x;
-                    const int x1 = x+1;
-                    const int y0 = y;
-                    const int y1 = y+1;
-                    v00.SetPosition(pts[y0][x0]);
-                    v10.SetPosition(pts[y0][x1]);
-                    v01.SetPosition(pts[y1][x0]);
-                    v11.SetPosition(pts[y1][x1]);
-                    if(uv_rotated)
+                    for (int x=0;x<4;x++)
                     {
-                        v00.SetUV(us[y0], vs[x0]);
-                        v10.SetUV(us[y0], vs[x1]);
-                        v01.SetUV(us[y1], vs[x0]);
-                        v11.SetUV(us[y1], vs[x1]);
+                        pts[y][x] = (*transform * Vectormath::Aos::Point3(xs[x], ys[y], 0));
                     }
-                    else
+                }
+
+                BoxVertex v00, v10, v01, v11;
+                v00.SetColor(pm_color);
+                v10.SetColor(pm_color);
+                v01.SetColor(pm_color);
+                v11.SetColor(pm_color);
+                for (int y=0;y<3;y++)
+                {
+                    for (int x=0;x<3;x++)
                     {
-                        v00.SetUV(us[x0], vs[y0]);
-                        v10.SetUV(us[x1], vs[y0]);
-                        v01.SetUV(us[x0], vs[y1]);
-                        v11.SetUV(us[x1], vs[y1]);
+                        const int x0 = x;
+                        const int x1 = x+1;
+                        const int y0 = y;
+                        const int y1 = y+1;
+                        v00.SetPosition(pts[y0][x0]);
+                        v10.SetPosition(pts[y0][x1]);
+                        v01.SetPosition(pts[y1][x0]);
+                        v11.SetPosition(pts[y1][x1]);
+                        if(uv_rotated)
+                        {
+                            v00.SetUV(us[y0], vs[x0]);
+                            v10.SetUV(us[y0], vs[x1]);
+                            v01.SetUV(us[y1], vs[x0]);
+                            v11.SetUV(us[y1], vs[x1]);
+                        }
+                        else
+                        {
+                            v00.SetUV(us[x0], vs[y0]);
+                            v10.SetUV(us[x1], vs[y0]);
+                            v01.SetUV(us[x0], vs[y1]);
+                            v11.SetUV(us[x1], vs[y1]);
+                        }
+                        gui_world->m_ClientVertexBuffer.Push(v00);
+                        gui_world->m_ClientVertexBuffer.Push(v10);
+                        gui_world->m_ClientVertexBuffer.Push(v11);
+                        gui_world->m_ClientVertexBuffer.Push(v00);
+                        gui_world->m_ClientVertexBuffer.Push(v11);
+                        gui_world->m_ClientVertexBuffer.Push(v01);
                     }
-                    gui_world->m_ClientVertexBuffer.Push(v00);
-                    gui_world->m_ClientVertexBuffer.Push(v10);
-                    gui_world->m_ClientVertexBuffer.Push(v11);
-                    gui_world->m_ClientVertexBuffer.Push(v00);
-                    gui_world->m_ClientVertexBuffer.Push(v11);
-                    gui_world->m_ClientVertexBuffer.Push(v01);
                 }
             }
-            rendered_vert_count += verts_per_node;
+
+            key.m_VertexCount = gui_world->m_ClientVertexBuffer.Size() - key.m_VertexStart;
+            StoreBoxVertices(gui_world, key);
+            rendered_vert_count += key.m_VertexCount;
         }
 
         ro.m_VertexCount = rendered_vert_count;
@@ -1573,6 +1701,170 @@ namespace dmGameSystem
         ro.m_VertexCount = gui_world->m_ClientVertexBuffer.Size() - ro.m_VertexStart;
     }
 
+    // How far ahead ReorderRenderNodes looks for nodes to move into the current batch
+    static const uint32_t REORDER_WINDOW = 128;
+
+    static void CalcNodeBounds(const Matrix4& transform, float x0, float y0, float x1, float y1, GuiRenderNodeInfo& info)
+    {
+        info.m_Min[0] = info.m_Min[1] = FLT_MAX;
+        info.m_Max[0] = info.m_Max[1] = -FLT_MAX;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            Vector4 p = transform * Point3((i & 1) ? x1 : x0, (i & 2) ? y1 : y0, 0.0f);
+            info.m_Min[0] = dmMath::Min(info.m_Min[0], p.getX());
+            info.m_Min[1] = dmMath::Min(info.m_Min[1], p.getY());
+            info.m_Max[0] = dmMath::Max(info.m_Max[0], p.getX());
+            info.m_Max[1] = dmMath::Max(info.m_Max[1], p.getY());
+        }
+    }
+
+    static void GetRenderNodeInfo(dmGui::HScene scene, const dmGui::RenderEntry& entry, const Matrix4& transform, const dmGui::StencilScope* stencil_scope, GuiRenderNodeInfo& info)
+    {
+        dmGui::HNode node = entry.m_Node;
+        info.m_NodeType = (uint16_t) dmGui::GetNodeType(scene, node);
+        info.m_BlendMode = (uint16_t) dmGui::GetNodeBlendMode(scene, node);
+        info.m_Texture = dmGameSystem::GetNodeTexture(scene, node);
+        info.m_Font = dmGui::GetNodeFont(scene, node);
+        info.m_StencilScope = stencil_scope;
+        info.m_EmitterBatchKey = 0;
+        info.m_Emitted = 0;
+        // Nodes drawing to the stencil buffer change how the nodes after them are clipped
+        info.m_Barrier = stencil_scope != 0x0 && !stencil_scope->m_Scissor && stencil_scope->m_WriteMask != 0;
+
+        if (dmGui::GetNodeIsBone(scene, node))
+        {
+            // Not rendered, so it never overlaps anything
+            info.m_Min[0] = info.m_Min[1] = FLT_MAX;
+            info.m_Max[0] = info.m_Max[1] = -FLT_MAX;
+            return;
+        }
+
+        switch (info.m_NodeType)
+        {
+            case dmGui::NODE_TYPE_BOX:
+            case dmGui::NODE_TYPE_PIE:
+                // The transform includes the node size, the geometry is within the unit square
+                CalcNodeBounds(transform, 0.0f, 0.0f, 1.0f, 1.0f, info);
+                break;
+            case dmGui::NODE_TYPE_TEXT:
+                {
+                    // The text is aligned within the node size, but can overflow it in any direction
+                    dmRender::HFontMap font_map = (dmRender::HFontMap) info.m_Font;
+                    Vector4 size = dmGui::GetNodeProperty(scene, node, dmGui::PROPERTY_SIZE);
+                    dmRender::TextMetrics metrics;
+                    dmRender::GetTextMetrics(font_map, dmGui::GetNodeText(scene, node), size.getX(), dmGui::GetNodeLineBreak(scene, node),
+                        dmGui::GetNodeTextLeading(scene, node), dmGui::GetNodeTextTracking(scene, node), &metrics);
+                    float margin = dmRender::GetFontMapGlyphMargin(font_map);
+                    CalcNodeBounds(transform,
+                        dmMath::Min(0.0f, size.getX() - metrics.m_Width) - margin,
+                        dmMath::Min(0.0f, size.getY() - metrics.m_Height) - margin,
+                        dmMath::Max(size.getX(), metrics.m_Width) + margin,
+                        dmMath::Max(size.getY(), metrics.m_Height) + margin, info);
+                }
+                break;
+            case dmGui::NODE_TYPE_PARTICLEFX:
+                info.m_EmitterBatchKey = ((dmParticle::EmitterRenderData*) entry.m_RenderData)->m_MixedHashNoMaterial;
+                info.m_Barrier = 1;
+                break;
+            default:
+                // Spine and custom nodes have no cheaply known bounds
+                info.m_Barrier = 1;
+                break;
+        }
+    }
+
+    static inline bool IsSameBatch(const GuiRenderNodeInfo& a, const GuiRenderNodeInfo& b)
+    {
+        return a.m_NodeType == b.m_NodeType && a.m_BlendMode == b.m_BlendMode && a.m_Texture == b.m_Texture && a.m_Font == b.m_Font
+            && a.m_StencilScope == b.m_StencilScope && a.m_EmitterBatchKey == b.m_EmitterBatchKey;
+    }
+
+    static inline bool Overlaps(const GuiRenderNodeInfo& a, const GuiRenderNodeInfo& b)
+    {
+        return a.m_Min[0] <= b.m_Max[0] && b.m_Min[0] <= a.m_Max[0] && a.m_Min[1] <= b.m_Max[1] && b.m_Min[1] <= a.m_Max[1];
+    }
+
+    // Moves nodes forward into the batch of an earlier node with the same state, as long as they don't overlap any node they
+    // are moved in front of. Nodes that overlap keep their relative order, so the result looks the same as the sorted order.
+    // Returns the number of nodes that were moved.
+    static uint32_t ReorderRenderNodes(dmGui::HScene scene, GuiWorld* gui_world, const dmGui::RenderEntry* entries, const Matrix4* node_transforms,
+                                       const float* node_opacities, const dmGui::StencilScope** stencil_scopes, uint32_t node_count)
+    {
+        DM_PROFILE(Gui, "ReorderRenderNodes");
+
+        dmArray<GuiRenderNodeInfo>& infos = gui_world->m_RenderNodeInfos;
+        if (infos.Capacity() < node_count)
+        {
+            infos.SetCapacity(node_count);
+            gui_world->m_ReorderBlockers.SetCapacity(dmMath::Min(node_count, REORDER_WINDOW));
+            gui_world->m_ReorderedEntries.SetCapacity(node_count);
+            gui_world->m_ReorderedTransforms.SetCapacity(node_count);
+            gui_world->m_ReorderedOpacities.SetCapacity(node_count);
+            gui_world->m_ReorderedStencilScopes.SetCapacity(node_count);
+        }
+        infos.SetSize(node_count);
+        gui_world->m_ReorderedEntries.SetSize(0);
+        gui_world->m_ReorderedTransforms.SetSize(0);
+        gui_world->m_ReorderedOpacities.SetSize(0);
+        gui_world->m_ReorderedStencilScopes.SetSize(0);
+
+        for (uint32_t i = 0; i < node_count; ++i)
+        {
+            GetRenderNodeInfo(scene, entries[i], node_transforms[i], stencil_scopes[i], infos[i]);
+        }
+
+        uint32_t moved = 0;
+        dmArray<uint32_t>& blockers = gui_world->m_ReorderBlockers;
+        for (uint32_t i = 0; i < node_count; ++i)
+        {
+            if (infos[i].m_Emitted)
+                continue;
+
+            uint32_t emit = i;
+            uint32_t end = dmMath::Min(node_count, i + REORDER_WINDOW);
+            uint32_t j = i;
+            blockers.SetSize(0);
+            while (true)
+            {
+                infos[emit].m_Emitted = 1;
+                gui_world->m_ReorderedEntries.Push(entries[emit]);
+                gui_world->m_ReorderedTransforms.Push(node_transforms[emit]);
+                gui_world->m_ReorderedOpacities.Push(node_opacities[emit]);
+                gui_world->m_ReorderedStencilScopes.Push(stencil_scopes[emit]);
+                if (!blockers.Empty())
+                    ++moved;
+
+                if (infos[i].m_Barrier)
+                    break;
+
+                // Find the next node of the same batch that can be moved up past the nodes that are left in between
+                for (++j; j < end; ++j)
+                {
+                    const GuiRenderNodeInfo& info = infos[j];
+                    if (info.m_Emitted)
+                        continue;
+                    if (info.m_Barrier)
+                    {
+                        end = j;
+                        break;
+                    }
+                    bool blocked = !IsSameBatch(infos[i], info);
+                    for (uint32_t b = 0; !blocked && b < blockers.Size(); ++b)
+                    {
+                        blocked = Overlaps(infos[blockers[b]], info);
+                    }
+                    if (!blocked)
+                        break;
+                    blockers.Push(j);
+                }
+                if (j >= end)
+                    break;
+                emit = j;
+            }
+        }
+        return moved;
+    }
+
     void RenderNodes(dmGui::HScene scene,
                     const dmGui::RenderEntry* entries,
                     const Matrix4* node_transforms,
@@ -1592,6 +1884,15 @@ namespace dmGameSystem
         gui_world->m_RenderedParticlesSize = 0;
         gui_context->m_FirstStencil = true;
 
+        if (node_count > 1)
+        {
+            gui_world->m_ReorderedNodes += ReorderRenderNodes(scene, gui_world, entries, node_transforms, node_opacities, stencil_scopes, node_count);
+            entries = gui_world->m_ReorderedEntries.Begin();
+            node_transforms = gui_world->m_ReorderedTransforms.Begin();
+            node_opacities = gui_world->m_ReorderedOpacities.Begin();
+            stencil_scopes = gui_world->m_ReorderedStencilScopes.Begin();
+        }
+
         dmGui::HNode first_node = entries[0].m_Node;
         dmGui::BlendMode prev_blend_mode = dmGui::GetNodeBlendMode(scene, first_node);
         dmGui::NodeType prev_node_type = dmGui::GetNodeType(scene, first_node);
@@ -1692,12 +1993,6 @@ namespace dmGameSystem
                     break;
             }
         }
-
-        dmGraphics::SetVertexBufferData(gui_world->m_VertexBuffer,
-                                        gui_world->m_ClientVertexBuffer.Size() * sizeof(BoxVertex),
-                                        gui_world->m_ClientVertexBuffer.Begin(),
-                                        dmGraphics::BUFFER_USAGE_STREAM_DRAW);
-        DM_COUNTER("Gui.VertexCount", gui_world->m_ClientVertexBuffer.Size());
     }
 
     static dmGraphics::TextureFormat ToGraphicsFormat(dmImage::Type type) {
@@ -1761,6 +2056,22 @@ namespace dmGameSystem
         dmGraphics::SetTexture((dmGraphics::HTexture) texture, tparams);
     }
 
+    static void SetTextureSubData(dmGui::HScene scene, void* texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, dmImage::Type type, const void* buffer, void* context)
+    {
+        dmGraphics::TextureParams tparams;
+        tparams.m_X = x;
+        tparams.m_Y = y;
+        tparams.m_Width = width;
+        tparams.m_Height = height;
+        tparams.m_SubUpdate = true;
+        tparams.m_MinFilter = dmGraphics::TEXTURE_FILTER_LINEAR;
+        tparams.m_MagFilter = dmGraphics::TEXTURE_FILTER_LINEAR;
+        tparams.m_Data = buffer;
+        tparams.m_DataSize = dmImage::BytesPerPixel(type) * width * height;
+        tparams.m_Format = ToGraphicsFormat(type);
+        dmGraphics::SetTexture((dmGraphics::HTexture) texture, tparams);
+    }
+
     dmGui::FetchTextureSetAnimResult FetchTextureSetAnimCallback(void* texture_set_ptr, dmhash_t animation, dmGui::TextureSetAnimDesc* out_data)
     {
         TextureSetResource* texture_set_res = (TextureSetResource*)texture_set_ptr;
@@ -1824,7 +2135,8 @@ namespace dmGameSystem
 
         dmScript::UpdateScriptWorld(gui_world->m_ScriptWorld, params.m_UpdateContext->m_DT);
 
-        dmRig::Update(gui_world->m_RigContext, params.m_UpdateContext->m_DT);
+        dmRig::Result rig_res = dmRig::Update(gui_world->m_RigContext, params.m_UpdateContext->m_DT);
+        update_result.m_Changed = rig_res == dmRig::RESULT_UPDATED_POSE;
 
         gui_world->m_DT = params.m_UpdateContext->m_DT;
         dmParticle::Update(gui_world->m_ParticleContext, params.m_UpdateContext->m_DT, &FetchAnimationCallback);
@@ -1834,6 +2146,7 @@ namespace dmGameSystem
             if (gui_component->m_Enabled && gui_component->m_AddedToUpdate)
             {
                 dmGui::UpdateScene(gui_component->m_Scene, params.m_UpdateContext->m_DT);
+                update_result.m_Changed |= dmGui::IsAnimating(gui_component->m_Scene);
             }
         }
 
@@ -1866,6 +2179,8 @@ namespace dmGameSystem
         rp.m_NewTexture = &NewTexture;
         rp.m_DeleteTexture = &DeleteTexture;
         rp.m_SetTextureData = &SetTextureData;
+        rp.m_SetTextureSubData = &SetTextureSubData;
+        rp.m_ScissorClipping = true;
 
         RenderGuiContext render_gui_context;
         render_gui_context.m_RenderContext = gui_context->m_RenderContext;
@@ -1890,6 +2205,14 @@ namespace dmGameSystem
         gui_world->m_GuiRenderObjects.SetSize(0);
         gui_world->m_ClientVertexBuffer.SetSize(0);
 
+        // The vertices cached last frame are read from the other half of the box vertex cache
+        gui_world->m_BoxCacheFrame++;
+        gui_world->m_BoxCacheKeys[gui_world->m_BoxCacheFrame & 1].SetSize(0);
+        gui_world->m_BoxCacheVertices[gui_world->m_BoxCacheFrame & 1].SetSize(0);
+        gui_world->m_BoxCacheHits = 0;
+        gui_world->m_ReorderedNodes = 0;
+        gui_world->m_VertexBuffer = dmGraphics::AcquireDynamicVertexBuffer(gui_world->m_DynamicVertexBuffer);
+
         uint32_t lastEnd = 0;
 
         for (uint32_t i = 0; i < gui_world->m_Components.Size(); ++i)
@@ -1925,6 +2248,14 @@ namespace dmGameSystem
             dmRender::RenderListSubmit(gui_context->m_RenderContext, render_list, write_ptr);
         }
 
+        // Upload the vertices of all scenes at once
+        dmGraphics::SetDynamicVertexBufferData(gui_world->m_DynamicVertexBuffer,
+                                               gui_world->m_ClientVertexBuffer.Size() * sizeof(BoxVertex),
+                                               gui_world->m_ClientVertexBuffer.Begin());
+        DM_COUNTER("Gui.VertexCount", gui_world->m_ClientVertexBuffer.Size());
+        DM_COUNTER("Gui.CachedBoxNodes", gui_world->m_BoxCacheHits);
+        DM_COUNTER("Gui.ReorderedNodes", gui_world->m_ReorderedNodes);
+
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
@@ -1978,6 +2309,7 @@ namespace dmGameSystem
             gui_input_action.m_AccY = params.m_InputAction->m_AccY;
             gui_input_action.m_AccZ = params.m_InputAction->m_AccZ;
             gui_input_action.m_AccelerationSet = params.m_InputAction->m_AccelerationSet;
+            gui_input_action.m_Timestamp = params.m_InputAction->m_Timestamp;
 
             gui_input_action.m_TouchCount = params.m_InputAction->m_TouchCount;
             int tc = params.m_InputAction->m_TouchCount;
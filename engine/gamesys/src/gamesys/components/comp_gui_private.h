@@ -71,6 +71,43 @@ namespace dmGameSystem
         float m_Color[4];
     };
 
+    // The inputs a box node's vertices were generated from, see RenderBoxNodes.
+    // Everything up to m_VertexStart is compared to decide if the cached vertices can be reused
+    struct BoxVertexCacheKey
+    {
+        Vectormath::Aos::Matrix4    m_Transform;
+        Vectormath::Aos::Vector4    m_Color;
+        Vectormath::Aos::Vector4    m_Slice9;
+        float                       m_TexCoords[6];
+        float                       m_Size[2];
+        float                       m_TextureSize[2];
+        dmGui::HScene               m_Scene;
+        dmGraphics::HTexture        m_Texture;
+        const void*                 m_TextureSet;
+        dmGui::HNode                m_Node;
+        int32_t                     m_Frame;
+        uint32_t                    m_Flip;
+
+        uint32_t                    m_VertexStart;
+        uint32_t                    m_VertexCount;
+    };
+
+    // The batch state and gui space bounds of a node, see ReorderRenderNodes
+    struct GuiRenderNodeInfo
+    {
+        float                       m_Min[2];
+        float                       m_Max[2];
+        dmGraphics::HTexture        m_Texture;
+        void*                       m_Font;
+        const dmGui::StencilScope*  m_StencilScope;
+        uint32_t                    m_EmitterBatchKey;
+        uint16_t                    m_NodeType;
+        uint16_t                    m_BlendMode;
+        // Nothing is moved across a barrier, e.g. nodes writing to the stencil buffer or with unknown bounds
+        uint8_t                     m_Barrier : 1;
+        uint8_t                     m_Emitted : 1;
+    };
+
     struct GuiRenderObject
     {
         dmRender::RenderObject m_RenderObject;
@@ -82,8 +119,24 @@ namespace dmGameSystem
         dmArray<GuiRenderObject>         m_GuiRenderObjects;
         dmArray<GuiComponent*>           m_Components;
         dmGraphics::HVertexDeclaration   m_VertexDeclaration;
+        dmGraphics::HDynamicVertexBuffer m_DynamicVertexBuffer;
+        // The buffer of m_DynamicVertexBuffer used this frame
         dmGraphics::HVertexBuffer        m_VertexBuffer;
         dmArray<BoxVertex>               m_ClientVertexBuffer;
+        // Vertices of the sliced and geometry box nodes generated last frame, reused for the nodes that are rendered
+        // in the same order with unchanged inputs. Double buffered, this frame writes to index m_BoxCacheFrame & 1
+        dmArray<BoxVertexCacheKey>       m_BoxCacheKeys[2];
+        dmArray<BoxVertex>               m_BoxCacheVertices[2];
+        uint32_t                         m_BoxCacheFrame;
+        uint32_t                         m_BoxCacheHits;
+        // Render nodes reordered into fewer batches, see ReorderRenderNodes
+        dmArray<GuiRenderNodeInfo>       m_RenderNodeInfos;
+        dmArray<uint32_t>                m_ReorderBlockers;
+        dmArray<dmGui::RenderEntry>      m_ReorderedEntries;
+        dmArray<Vectormath::Aos::Matrix4> m_ReorderedTransforms;
+        dmArray<float>                   m_ReorderedOpacities;
+        dmArray<const dmGui::StencilScope*> m_ReorderedStencilScopes;
+        uint32_t                         m_ReorderedNodes;
         dmGraphics::HTexture             m_WhiteTexture;
         dmParticle::HParticleContext     m_ParticleContext;
         uint32_t                         m_MaxParticleFXCount;
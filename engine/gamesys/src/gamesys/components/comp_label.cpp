@@ -38,6 +38,7 @@
 
 #include <gamesys/label_ddf.h>
 #include <gamesys/gamesys_ddf.h>
+#include <dmsdk/gamesys/label.h>
 
 using namespace Vectormath::Aos;
 namespace dmGameSystem
@@ -127,7 +128,8 @@ namespace dmGameSystem
 
     void ReHash(LabelComponent* component)
     {
-        // Hash resource-ptr, material-handle, blend mode and render constants
+        // Hash resource-ptr, material-handle, blend mode and render constants.
+        // The colors are vertex data, so labels of different colors can share a batch.
         HashState32 state;
         bool reverse = false;
         LabelResource* resource = component->m_Resource;
@@ -139,9 +141,6 @@ namespace dmGameSystem
         dmHashUpdateBuffer32(&state, &material, sizeof(material));
         dmHashUpdateBuffer32(&state, &font_map, sizeof(font_map));
         dmHashUpdateBuffer32(&state, &ddf->m_BlendMode, sizeof(ddf->m_BlendMode));
-        dmHashUpdateBuffer32(&state, &ddf->m_Color, sizeof(ddf->m_Color));
-        dmHashUpdateBuffer32(&state, &ddf->m_Outline, sizeof(ddf->m_Outline));
-        dmHashUpdateBuffer32(&state, &ddf->m_Shadow, sizeof(ddf->m_Shadow));
 
         if (component->m_RenderConstants) {
             dmGameSystem::HashRenderConstants(component->m_RenderConstants, &state);
@@ -445,6 +444,7 @@ namespace dmGameSystem
 
             dmRender::DrawTextParams params;
             CreateDrawTextParams(component, params);
+            params.m_Instancing = label_context->m_Instancing;
 
             if (component->m_RenderConstants)
             {
@@ -480,6 +480,16 @@ namespace dmGameSystem
         component->m_ReHash = 1;
     }
 
+    static void SetText(LabelComponent* component, const char* text)
+    {
+        if (component->m_UserAllocatedText)
+        {
+            free((void*)component->m_Text);
+        }
+        component->m_Text = strdup(text);
+        component->m_UserAllocatedText = 1;
+    }
+
     dmGameObject::UpdateResult CompLabelOnMessage(const dmGameObject::ComponentOnMessageParams& params)
     {
         LabelWorld* world = (LabelWorld*)params.m_World;
@@ -502,12 +512,7 @@ namespace dmGameSystem
         else if (params.m_Message->m_Id == dmGameSystemDDF::SetText::m_DDFDescriptor->m_NameHash)
         {
             dmGameSystemDDF::SetText* textmsg = (dmGameSystemDDF::SetText*)params.m_Message->m_Data;
-            if (component->m_UserAllocatedText)
-            {
-                free((void*)component->m_Text);
-            }
-            component->m_Text = strdup(textmsg->m_Text);
-            component->m_UserAllocatedText = 1;
+            SetText(component, textmsg->m_Text);
         }
 
         return dmGameObject::UPDATE_RESULT_OK;
@@ -619,4 +624,47 @@ namespace dmGameSystem
         }
         return SetMaterialConstant(GetMaterial(component, component->m_Resource), set_property, params.m_Value, CompLabelSetConstantCallback, component);
     }
+
+    bool GetLabelHandle(dmGameObject::HInstance instance, dmhash_t component_id, LabelHandle* out_handle)
+    {
+        void* world;
+        uintptr_t user_data;
+        if (dmGameObject::GetComponent(instance, component_id, "labelc", &world, &user_data) != dmGameObject::RESULT_OK)
+        {
+            return false;
+        }
+        out_handle->m_World = world;
+        out_handle->m_Index = (uint32_t) user_data;
+        return true;
+    }
+
+    static inline LabelComponent* GetLabelComponent(const LabelHandle& handle)
+    {
+        return &((LabelWorld*) handle.m_World)->m_Components.Get(handle.m_Index);
+    }
+
+    void SetLabelColors(const LabelHandle* handles, const dmVMath::Vector4* colors, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            GetLabelComponent(handles[i])->m_Color = colors[i];
+        }
+    }
+
+    void SetLabelScales(const LabelHandle* handles, const dmVMath::Vector3* scales, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            GetLabelComponent(handles[i])->m_Scale = scales[i];
+        }
+    }
+
+    void SetLabelTexts(const LabelHandle* handles, const char** texts, uint32_t count)
+    {
+        DM_PROFILE(Label, "SetTexts");
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            SetText(GetLabelComponent(handles[i]), texts[i]);
+        }
+    }
 }
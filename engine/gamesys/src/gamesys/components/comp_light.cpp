@@ -14,6 +14,8 @@
 #include "resources/res_light.h"
 #include <gamesys/gamesys_ddf.h>
 
+#include <math.h>
+
 #include <dlib/array.h>
 #include <dlib/log.h>
 #include <dlib/hash.h>
@@ -146,6 +148,35 @@ namespace dmGameSystem
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
+    dmGameObject::UpdateResult CompLightRender(const dmGameObject::ComponentsRenderParams& params)
+    {
+        dmRender::HRenderContext render_context = (dmRender::HRenderContext) params.m_Context;
+        LightWorld* light_world = (LightWorld*) params.m_World;
+        for (uint32_t i = 0; i < light_world->m_Lights.Size(); ++i)
+        {
+            Light* light = light_world->m_Lights[i];
+            if (!light->m_AddedToUpdate) {
+                continue;
+            }
+            dmGameSystemDDF::LightDesc* light_desc = *light->m_LightResource;
+
+            // Assigned to the light clusters of the materials that sample them, see dmRender::AddLight
+            dmRender::Light render_light;
+            render_light.m_Position = dmGameObject::GetWorldPosition(light->m_Instance);
+            render_light.m_Direction = rotate(dmGameObject::GetWorldRotation(light->m_Instance), Vector3(0.0f, 0.0f, -1.0f));
+            render_light.m_Color = Vector3(light_desc->m_Color) * light_desc->m_Intensity;
+            render_light.m_Range = light_desc->m_Range;
+            render_light.m_ConeCos = -1.0f;
+            if (light_desc->m_Type == dmGameSystemDDF::SPOT)
+            {
+                // The cone angle is the full angle of the cone, in degrees
+                render_light.m_ConeCos = cosf(light_desc->m_ConeAngle * 0.5f * (M_PI / 180.0f));
+            }
+            dmRender::AddLight(render_context, render_light);
+        }
+        return dmGameObject::UPDATE_RESULT_OK;
+    }
+
     dmGameObject::UpdateResult CompLightOnMessage(const dmGameObject::ComponentOnMessageParams& params)
     {
         return dmGameObject::UPDATE_RESULT_OK;
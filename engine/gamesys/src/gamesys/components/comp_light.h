@@ -29,6 +29,8 @@ namespace dmGameSystem
 
     dmGameObject::UpdateResult CompLightUpdate(const dmGameObject::ComponentsUpdateParams& params, dmGameObject::ComponentsUpdateResult& update_result);
 
+    dmGameObject::UpdateResult CompLightRender(const dmGameObject::ComponentsRenderParams& params);
+
     dmGameObject::UpdateResult CompLightOnMessage(const dmGameObject::ComponentOnMessageParams& params);
 }
 
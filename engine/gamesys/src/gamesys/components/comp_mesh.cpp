@@ -44,6 +44,11 @@ namespace dmGameSystem
     using namespace Vectormath::Aos;
     using namespace dmGameSystemDDF;
 
+    /// Level 0 is the vertices buffer of the component, the others are set with the vertices_lod properties
+    static const uint32_t MAX_LOD_COUNT = 4;
+    /// A mesh goes back to a more detailed level only when closer than this fraction of the LOD distance
+    static const float LOD_HYSTERESIS = 0.9f;
+
     struct MeshComponent
     {
         dmGameObject::HInstance         m_Instance;
@@ -63,12 +68,30 @@ namespace dmGameSystem
         uint32_t                        m_ElementCount;
         uint16_t                        m_VertSize;
 
+        /// Less detailed buffers with the same vertex layout, drawn beyond the matching camera distance
+        dmGameSystem::BufferResource*   m_LodBuffers[MAX_LOD_COUNT - 1];
+        Vector3                         m_LodDistances;
+
         /// Component enablement
         uint8_t                         m_Enabled : 1;
         /// Added to update or not
         uint8_t                         m_AddedToUpdate : 1;
         uint8_t                         m_ReHash : 1;
-        uint8_t                         :5;
+        /// The level drawn, selected at render time
+        uint8_t                         m_LodLevel : 2;
+        /// Rasterized as an occluder, see dmRender::AddOccluder
+        uint8_t                         m_Occluder : 1;
+        /// m_AabbCenter and m_AabbExtents hold the bounds of m_AabbBuffer
+        uint8_t                         m_HasAabb : 1;
+        uint8_t                         :1;
+        /// Render layer, see dmRender::SetLayerMask
+        uint8_t                         m_RenderLayer;
+
+        /// Local space bounds of the drawn buffer, used for culling
+        Point3                          m_AabbCenter;
+        Vector3                         m_AabbExtents;
+        dmGameSystem::BufferResource*   m_AabbBuffer;
+        uint32_t                        m_AabbVersion;
     };
 
     struct VertexBufferInfo
@@ -92,7 +115,12 @@ namespace dmGameSystem
         /// Keep track of how much vertex data we have rendered so it can be
         /// reported to the profiler at end of the render dispatching.
         uint32_t                           m_RenderedVertexSize;
-
+        dmGraphics::HVertexDeclaration     m_InstanceVertexDeclaration;
+        dmGraphics::HDynamicVertexBuffer   m_DynamicInstanceBuffer;
+        // The buffer of m_DynamicInstanceBuffer used by the current render list dispatch
+        dmGraphics::HVertexBuffer          m_InstanceBuffer;
+        dmArray<WorldTransformInstance>    m_InstanceData;
+        uint8_t                            m_UseInstancing : 1;
     };
 
     static inline void DeallocVertexBuffer(MeshWorld* world, dmGraphics::HVertexBuffer vertex_buffer)
@@ -165,6 +193,42 @@ namespace dmGameSystem
         dmGraphics::SetVertexBufferData(vertex_buffer, vert_size * elem_count, bytes, buffer_usage);
     }
 
+    // Uploads the changed elements of the buffer. If the vertex buffer doesn't hold the version
+    // the dirty ranges are based on, or the whole buffer has changed, all of it is uploaded.
+    static uint32_t UpdateVertexBuffer(dmBuffer::HBuffer buffer, dmGraphics::HVertexBuffer vertex_buffer, uint32_t vertex_buffer_version, uint32_t vert_size, uint32_t elem_count)
+    {
+        uint32_t base_version, range_count;
+        const dmBuffer::DirtyRange* ranges;
+        dmBuffer::Result r = dmBuffer::GetDirtyRanges(buffer, &base_version, &ranges, &range_count);
+        assert(r == dmBuffer::RESULT_OK);
+
+        if (ranges == 0 || base_version != vertex_buffer_version)
+        {
+            CopyBufferToVertexBuffer(buffer, vertex_buffer, vert_size, elem_count, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+        }
+        else
+        {
+            uint8_t* bytes = 0x0;
+            uint32_t size = 0;
+            r = dmBuffer::GetBytes(buffer, (void**)&bytes, &size);
+            assert(r == dmBuffer::RESULT_OK);
+
+            for (uint32_t i = 0; i < range_count; ++i)
+            {
+                uint32_t offset = ranges[i].m_Offset;
+                if (offset >= elem_count)
+                    continue;
+                uint32_t count = dmMath::Min(ranges[i].m_Count, elem_count - offset);
+                dmGraphics::SetVertexBufferSubData(vertex_buffer, offset * vert_size, count * vert_size, bytes + offset * vert_size);
+            }
+        }
+
+        dmBuffer::ClearDirtyRanges(buffer);
+        uint32_t version;
+        dmBuffer::GetContentVersion(buffer, &version);
+        return version;
+    }
+
     static void CreateVertexBuffer(MeshWorld* world, dmGameSystem::BufferResource* br, uint32_t vert_size)
     {
         dmGraphics::HVertexBuffer vertex_buffer = GetVertexBuffer(world, br->m_NameHash);
@@ -186,6 +250,14 @@ namespace dmGameSystem
     static const uint32_t MAX_TEXTURE_COUNT = dmRender::RenderObject::MAX_TEXTURE_COUNT;
 
     static const dmhash_t PROP_VERTICES = dmHashString64("vertices");
+    static const dmhash_t PROP_VERTICES_LOD[MAX_LOD_COUNT - 1] = {
+        dmHashString64("vertices_lod1"),
+        dmHashString64("vertices_lod2"),
+        dmHashString64("vertices_lod3"),
+    };
+    DM_GAMESYS_PROP_VECTOR3(MESH_PROP_LOD_DISTANCES, lod_distances, false);
+    /// Boolean, set to rasterize the triangles of the mesh as an occluder
+    static const dmhash_t PROP_OCCLUDER = dmHashString64("occluder");
 
     static void ResourceReloadedCallback(const dmResource::ResourceReloadedParams& params);
 
@@ -206,6 +278,14 @@ namespace dmGameSystem
 
         world->m_RenderedVertexSize = 0;
 
+        world->m_GraphicsContext = dmRender::GetGraphicsContext(context->m_RenderContext);
+        world->m_UseInstancing = context->m_Instancing && dmGraphics::IsInstancingSupported(world->m_GraphicsContext);
+        if (world->m_UseInstancing)
+        {
+            world->m_InstanceVertexDeclaration = NewWorldTransformInstanceDeclaration(world->m_GraphicsContext);
+            world->m_DynamicInstanceBuffer = dmGraphics::NewDynamicVertexBuffer(world->m_GraphicsContext);
+        }
+
         *params.m_World = world;
 
         dmResource::RegisterResourceReloadedCallback(context->m_Factory, ResourceReloadedCallback, world);
@@ -232,6 +312,12 @@ namespace dmGameSystem
             free(world->m_WorldVertexData);
         }
 
+        if (world->m_UseInstancing)
+        {
+            dmGraphics::DeleteVertexDeclaration(world->m_InstanceVertexDeclaration);
+            dmGraphics::DeleteDynamicVertexBuffer(world->m_DynamicInstanceBuffer);
+        }
+
         dmResource::UnregisterResourceReloadedCallback(((MeshContext*)params.m_Context)->m_Factory, ResourceReloadedCallback, world);
 
         delete world;
@@ -247,6 +333,11 @@ namespace dmGameSystem
         return component->m_BufferResource;
     }
 
+    // The buffer drawn, i.e. the vertices buffer or one of the LOD buffers
+    static inline dmGameSystem::BufferResource* GetLodVerticesBuffer(const MeshComponent* component) {
+        return component->m_LodLevel ? component->m_LodBuffers[component->m_LodLevel - 1] : GetVerticesBuffer(component, component->m_Resource);
+    }
+
     static inline dmRender::HMaterial GetMaterial(const MeshComponent* component, const MeshResource* resource) {
         return component->m_Material ? component->m_Material : resource->m_Material;
     }
@@ -285,8 +376,12 @@ namespace dmGameSystem
             dmHashUpdateBuffer32(&state, &texture, sizeof(texture));
         }
 
-        dmGameSystem::BufferResource* br = GetVerticesBuffer(component, component->m_Resource);
+        dmGameSystem::BufferResource* br = GetLodVerticesBuffer(component);
         dmHashUpdateBuffer32(&state, &br->m_Version, sizeof(br->m_Version));
+        // Local space meshes are only batched with meshes of the same buffer, so that they can be drawn instanced
+        if (dmRender::GetMaterialVertexSpace(material) == dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL) {
+            dmHashUpdateBuffer32(&state, &br->m_NameHash, sizeof(br->m_NameHash));
+        }
 
         // Make sure there is a vertex declaration
         // If the mesh uses a buffer that has zero elements we couldn't
@@ -367,6 +462,17 @@ namespace dmGameSystem
             if (component->m_BufferResource) {
                 dmResource::Release(factory, component->m_BufferResource);
             }
+
+            for (uint32_t i = 0; i < MAX_LOD_COUNT - 1; ++i) {
+                if (component->m_LodBuffers[i]) {
+                    DecRefVertexBuffer(world, component->m_LodBuffers[i]->m_NameHash);
+                }
+            }
+        }
+        for (uint32_t i = 0; i < MAX_LOD_COUNT - 1; ++i) {
+            if (component->m_LodBuffers[i]) {
+                dmResource::Release(factory, component->m_LodBuffers[i]);
+            }
         }
         if (!component->m_RenderConstants)
             dmGameSystem::DestroyRenderConstants(component->m_RenderConstants);
@@ -427,7 +533,7 @@ namespace dmGameSystem
                 continue;
 
             // Check the buffer version
-            BufferResource* br = GetVerticesBuffer(&component, component.m_Resource);
+            BufferResource* br = GetLodVerticesBuffer(&component);
             dmBuffer::GetContentVersion(br->m_Buffer, &br->m_Version);
 
             if (component.m_ReHash || (component.m_RenderConstants && dmGameSystem::AreRenderConstantsUpdated(component.m_RenderConstants)))
@@ -594,7 +700,7 @@ namespace dmGameSystem
         for (uint32_t *i=begin;i!=end;i++)
         {
             const MeshComponent* c = (MeshComponent*) buf[*i].m_UserData;
-            const BufferResource* br = GetVerticesBuffer(c, c->m_Resource);
+            const BufferResource* br = GetLodVerticesBuffer(c);
 
             element_count += br->m_ElementCount;
         }
@@ -612,7 +718,7 @@ namespace dmGameSystem
         {
             const MeshComponent* component = (MeshComponent*) buf[*i].m_UserData;
             const MeshResource* mr = component->m_Resource;
-            const BufferResource* br = GetVerticesBuffer(component, mr);
+            const BufferResource* br = GetLodVerticesBuffer(component);
 
             // No idea of rendering with zero element count.
             if (br->m_ElementCount == 0) {
@@ -660,14 +766,28 @@ namespace dmGameSystem
     {
         DM_PROFILE(Mesh, "RenderBatchLocal");
 
-        for (uint32_t *i=begin;i!=end;i++)
+        uint32_t* i = begin;
+        while (i != end)
         {
             dmRender::RenderObject& ro = *world->m_RenderObjects.End();
             world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
 
             const MeshComponent* component = (MeshComponent*) buf[*i].m_UserData;
             const MeshResource* mr = component->m_Resource;
-            dmGameSystem::BufferResource* br = GetVerticesBuffer(component, component->m_Resource);
+            dmGameSystem::BufferResource* br = GetLodVerticesBuffer(component);
+
+            // Meshes sharing the same buffer and vertex format are drawn with one instanced call
+            uint32_t* run_end = i + 1;
+            if (world->m_UseInstancing)
+            {
+                while (run_end != end)
+                {
+                    const MeshComponent* c = (MeshComponent*) buf[*run_end].m_UserData;
+                    if (GetLodVerticesBuffer(c) != br || GetVertexDeclaration(c) != GetVertexDeclaration(component) || c->m_Resource->m_PrimitiveType != mr->m_PrimitiveType)
+                        break;
+                    ++run_end;
+                }
+            }
 
             // Setup vertex declaration, buffer, count and sizes etc.
             // These defaults to values in the mesh and buffer resources,
@@ -679,34 +799,50 @@ namespace dmGameSystem
             if (HasCustomVerticesBuffer(component)) {
                 vert_decl = component->m_VertexDeclaration;
                 vert_size = component->m_VertSize;
-                elem_count = component->m_ElementCount;
+                if (!component->m_LodLevel)
+                    elem_count = component->m_ElementCount;
             }
 
-            dmGraphics::HVertexBuffer vertex_buffer = 0;
-            uint32_t info_version;
             VertexBufferInfo* info = world->m_ResourceToVertexBuffer.Get(br->m_NameHash);
             if (!info)
             {
-                vertex_buffer = AllocVertexBuffer(world, world->m_GraphicsContext);
-                AddVertexBufferInfo(world, br->m_NameHash, vertex_buffer, br->m_Version);
-                info_version = ~br->m_Version; // make sure it differs
-            }
-            else {
-                vertex_buffer = info->m_VertexBuffer;
-                info_version = info->m_Version;
+                dmGraphics::HVertexBuffer new_vertex_buffer = AllocVertexBuffer(world, world->m_GraphicsContext);
+                AddVertexBufferInfo(world, br->m_NameHash, new_vertex_buffer, ~br->m_Version); // make sure it differs
+                info = world->m_ResourceToVertexBuffer.Get(br->m_NameHash);
             }
+            dmGraphics::HVertexBuffer vertex_buffer = info->m_VertexBuffer;
 
             // Data has changed, and we need to update the vertex buffer
-            if (info_version != br->m_Version)
+            if (info->m_Version != br->m_Version)
             {
-                info->m_Version = br->m_Version;
-
-                CopyBufferToVertexBuffer(br->m_Buffer, vertex_buffer, vert_size, elem_count, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+                info->m_Version = UpdateVertexBuffer(br->m_Buffer, vertex_buffer, info->m_Version, vert_size, elem_count);
             }
 
             world->m_RenderedVertexSize += vert_size * elem_count;
 
             FillRenderObject(ro, mr->m_PrimitiveType, material, mr->m_Textures, component->m_Textures, vert_decl, vertex_buffer, 0, elem_count, component->m_World, component->m_RenderConstants);
+
+            if (run_end - i > 1)
+            {
+                dmArray<WorldTransformInstance>& instances = world->m_InstanceData;
+                uint32_t instance_count = run_end - i;
+                if (instances.Remaining() < instance_count) {
+                    instances.OffsetCapacity(dmMath::Max(instance_count - instances.Remaining(), 256U));
+                }
+                ro.m_InstanceVertexDeclaration = world->m_InstanceVertexDeclaration;
+                ro.m_InstanceVertexBuffer = world->m_InstanceBuffer;
+                ro.m_InstanceStart = instances.Size();
+                ro.m_InstanceCount = instance_count;
+                ro.m_WorldTransform = Matrix4::identity();
+                for (; i != run_end; ++i)
+                {
+                    const MeshComponent* c = (MeshComponent*) buf[*i].m_UserData;
+                    instances.SetSize(instances.Size() + 1);
+                    SetWorldTransformInstance(&instances.Back(), c->m_World);
+                }
+            }
+            i = run_end;
+
             dmRender::AddToRender(render_context, &ro);
         }
     }
@@ -743,6 +879,11 @@ namespace dmGameSystem
             {
                 world->m_RenderedVertexSize = 0;
                 world->m_RenderObjects.SetSize(0);
+                if (world->m_UseInstancing)
+                {
+                    world->m_InstanceData.SetSize(0);
+                    world->m_InstanceBuffer = dmGraphics::AcquireDynamicVertexBuffer(world->m_DynamicInstanceBuffer);
+                }
 
                 if (world->m_VertexBufferPool.Capacity() < world->m_VertexBufferPool.Size()+world->m_VertexBufferWorld.Size())
                     world->m_VertexBufferPool.OffsetCapacity(world->m_VertexBufferWorld.Size());
@@ -758,6 +899,12 @@ namespace dmGameSystem
             case dmRender::RENDER_LIST_OPERATION_END:
             {
                 DM_COUNTER("MeshVertexBuffer", world->m_RenderedVertexSize);
+                if (!world->m_InstanceData.Empty())
+                {
+                    uint32_t instance_size = sizeof(WorldTransformInstance) * world->m_InstanceData.Size();
+                    dmGraphics::SetDynamicVertexBufferData(world->m_DynamicInstanceBuffer, instance_size, world->m_InstanceData.Begin());
+                    DM_COUNTER("MeshInstanceBuffer", instance_size);
+                }
                 break;
             }
             default:
@@ -766,6 +913,125 @@ namespace dmGameSystem
         }
     }
 
+    static uint32_t SelectLod(const MeshComponent* component, float distance)
+    {
+        uint32_t lod = 0;
+        for (uint32_t i = 1; i < MAX_LOD_COUNT; ++i)
+        {
+            float lod_distance = component->m_LodDistances[i - 1];
+            if (!component->m_LodBuffers[i - 1] || lod_distance <= 0.0f)
+                continue;
+            if (i <= component->m_LodLevel)
+                lod_distance *= LOD_HYSTERESIS;
+            if (distance > lod_distance)
+                lod = i;
+        }
+        return lod;
+    }
+
+    // Picks the level of detail of each mesh from its distance to the camera. The camera is taken from the view of the last frame.
+    static void UpdateLods(MeshWorld* world, dmRender::HRenderContext render_context)
+    {
+        DM_PROFILE(Mesh, "UpdateLods");
+
+        const Vector3 camera_position = inverse(dmRender::GetViewMatrix(render_context)).getTranslation();
+
+        dmArray<MeshComponent*>& components = world->m_Components.m_Objects;
+        uint32_t n = components.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            MeshComponent* c = components[i];
+            if (!c->m_Enabled || (!c->m_LodLevel && !c->m_LodBuffers[0] && !c->m_LodBuffers[1] && !c->m_LodBuffers[2]))
+                continue;
+
+            uint32_t lod = SelectLod(c, length(c->m_World.getTranslation() - camera_position));
+            if (lod != c->m_LodLevel)
+            {
+                c->m_LodLevel = lod;
+                ReHash(c);
+            }
+        }
+    }
+
+    static bool GetPositionStream(const MeshComponent* component, const BufferResource* br, float** positions, uint32_t* count, uint32_t* components, uint32_t* stride)
+    {
+        const MeshResource* mr = component->m_Resource;
+        if (!mr->m_PositionStreamId || mr->m_PositionStreamType != dmBufferDDF::VALUE_TYPE_FLOAT32)
+            return false;
+        dmBuffer::Result r = dmBuffer::GetStream(br->m_Buffer, mr->m_PositionStreamId, (void**)positions, count, components, stride);
+        return r == dmBuffer::RESULT_OK && *components >= 2;
+    }
+
+    // Updates the local bounds if the drawn buffer or its content has changed. Meshes without float positions have no bounds
+    static void UpdateAabb(MeshComponent* component)
+    {
+        BufferResource* br = GetLodVerticesBuffer(component);
+        uint32_t version = 0;
+        dmBuffer::GetContentVersion(br->m_Buffer, &version);
+        if (br == component->m_AabbBuffer && version == component->m_AabbVersion)
+            return;
+        component->m_AabbBuffer = br;
+        component->m_AabbVersion = version;
+        component->m_HasAabb = 0;
+
+        float* positions;
+        uint32_t count, components, stride;
+        if (!GetPositionStream(component, br, &positions, &count, &components, &stride) || count == 0)
+            return;
+
+        float min[3] = { FLT_MAX, FLT_MAX, 0.0f };
+        float max[3] = { -FLT_MAX, -FLT_MAX, 0.0f };
+        if (components > 2)
+        {
+            min[2] = FLT_MAX;
+            max[2] = -FLT_MAX;
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const float* p = positions + i * stride;
+            for (uint32_t c = 0; c < 3 && c < components; ++c)
+            {
+                min[c] = dmMath::Min(min[c], p[c]);
+                max[c] = dmMath::Max(max[c], p[c]);
+            }
+        }
+        component->m_AabbCenter = Point3(0.5f * (min[0] + max[0]), 0.5f * (min[1] + max[1]), 0.5f * (min[2] + max[2]));
+        component->m_AabbExtents = Vector3(0.5f * (max[0] - min[0]), 0.5f * (max[1] - min[1]), 0.5f * (max[2] - min[2]));
+        component->m_HasAabb = 1;
+    }
+
+    static void RenderListVisibility(dmRender::RenderListVisibilityParams const &params)
+    {
+        DM_PROFILE(Mesh, "RenderListVisibility");
+        for (uint32_t i = 0; i < params.m_NumEntries; ++i)
+        {
+            MeshComponent* component = (MeshComponent*) params.m_Entries[params.m_Indices[i]].m_UserData;
+            UpdateAabb(component);
+            if (!component->m_HasAabb)
+            {
+                params.m_Bounds[i].m_Center = Point3(component->m_World.getCol3().getXYZ());
+                params.m_Bounds[i].m_Extents = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+                continue;
+            }
+            const Matrix4& w = component->m_World;
+            const Vector3& e = component->m_AabbExtents;
+            params.m_Bounds[i].m_Center = Point3((w * component->m_AabbCenter).getXYZ());
+            params.m_Bounds[i].m_Extents = absPerElem(w.getCol0().getXYZ()) * e.getX() + absPerElem(w.getCol1().getXYZ()) * e.getY() + absPerElem(w.getCol2().getXYZ()) * e.getZ();
+        }
+    }
+
+    // Occluders are rasterized from their most detailed buffer, only triangle lists with float positions are supported
+    static void AddMeshOccluder(dmRender::HRenderContext render_context, const MeshComponent* component)
+    {
+        if (component->m_Resource->m_PrimitiveType != dmGraphics::PRIMITIVE_TRIANGLES)
+            return;
+        float* positions;
+        uint32_t count, components, stride;
+        if (!GetPositionStream(component, GetVerticesBuffer(component, component->m_Resource), &positions, &count, &components, &stride) || components < 3)
+            return;
+        dmRender::AddOccluder(render_context, component->m_World, positions, stride, count);
+    }
+
     dmGameObject::UpdateResult CompMeshRender(const dmGameObject::ComponentsRenderParams& params)
     {
         MeshContext* context = (MeshContext*)params.m_Context;
@@ -773,13 +1039,14 @@ namespace dmGameSystem
         MeshWorld* world = (MeshWorld*)params.m_World;
 
         UpdateTransforms(world);
+        UpdateLods(world, render_context);
 
         dmArray<MeshComponent*>& components = world->m_Components.m_Objects;
         const uint32_t count = components.Size();
 
         // Prepare list submit
         dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(render_context, count);
-        dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, world);
+        dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, &RenderListVisibility, world);
         dmRender::RenderListEntry* write_ptr = render_list;
 
         for (uint32_t i = 0; i < count; ++i)
@@ -788,6 +1055,9 @@ namespace dmGameSystem
             if (!component.m_Enabled)
                 continue;
 
+            if (component.m_Occluder)
+                AddMeshOccluder(render_context, &component);
+
             const Vector4 trans = component.m_World.getCol(3);
             write_ptr->m_WorldPosition = Point3(trans.getX(), trans.getY(), trans.getZ());
             write_ptr->m_UserData = (uintptr_t) &component;
@@ -795,6 +1065,7 @@ namespace dmGameSystem
             write_ptr->m_TagListKey = dmRender::GetMaterialTagListKey(component.m_Resource->m_Material);
             write_ptr->m_Dispatch = dispatch;
             write_ptr->m_MinorOrder = 0;
+            write_ptr->m_Layer = component.m_RenderLayer;
             write_ptr->m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
             ++write_ptr;
 
@@ -878,6 +1149,33 @@ namespace dmGameSystem
         if (params.m_PropertyId == PROP_VERTICES) {
             return GetResourceProperty(dmGameObject::GetFactory(params.m_Instance), GetVerticesBuffer(component, component->m_Resource), out_value);
         }
+        else if (IsReferencingProperty(MESH_PROP_LOD_DISTANCES, params.m_PropertyId))
+        {
+            return GetProperty(out_value, params.m_PropertyId, component->m_LodDistances, MESH_PROP_LOD_DISTANCES);
+        }
+        else if (params.m_PropertyId == PROP_LAYER)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar((float)component->m_RenderLayer);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+        else if (params.m_PropertyId == PROP_OCCLUDER)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar(component->m_Occluder != 0);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+
+        for (uint32_t i = 0; i < MAX_LOD_COUNT - 1; ++i)
+        {
+            if (params.m_PropertyId == PROP_VERTICES_LOD[i])
+            {
+                if (!component->m_LodBuffers[i])
+                {
+                    out_value.m_Variant = dmGameObject::PropertyVar((dmhash_t)0);
+                    return dmGameObject::PROPERTY_RESULT_OK;
+                }
+                return GetResourceProperty(dmGameObject::GetFactory(params.m_Instance), component->m_LodBuffers[i], out_value);
+            }
+        }
         else if (params.m_PropertyId == PROP_MATERIAL)
         {
             return GetResourceProperty(dmGameObject::GetFactory(params.m_Instance), GetMaterial(component, component->m_Resource), out_value);
@@ -894,6 +1192,55 @@ namespace dmGameSystem
         return GetMaterialConstant(GetMaterial(component, component->m_Resource), params.m_PropertyId, out_value, true, CompMeshGetConstantCallback, component);
     }
 
+    static bool HasSameStreams(const BufferResource* a, const BufferResource* b)
+    {
+        const dmBufferDDF::BufferDesc* ddf_a = a->m_BufferDDF;
+        const dmBufferDDF::BufferDesc* ddf_b = b->m_BufferDDF;
+        if (ddf_a->m_Streams.m_Count != ddf_b->m_Streams.m_Count)
+            return false;
+        for (uint32_t i = 0; i < ddf_a->m_Streams.m_Count; ++i)
+        {
+            const dmBufferDDF::StreamDesc& stream_a = ddf_a->m_Streams[i];
+            const dmBufferDDF::StreamDesc& stream_b = ddf_b->m_Streams[i];
+            if (strcmp(stream_a.m_Name, stream_b.m_Name) != 0 || stream_a.m_ValueType != stream_b.m_ValueType || stream_a.m_ValueCount != stream_b.m_ValueCount)
+                return false;
+        }
+        return true;
+    }
+
+    static dmGameObject::PropertyResult SetLodVerticesBuffer(MeshWorld* world, MeshComponent* component, uint32_t index, dmResource::HFactory factory, const dmGameObject::PropertyVar& value)
+    {
+        BufferResource* prev_buffer_resource = component->m_LodBuffers[index];
+        dmGameObject::PropertyResult res = SetResourceProperty(factory, value, BUFFER_EXT_HASH, (void**)&component->m_LodBuffers[index]);
+        BufferResource* br = component->m_LodBuffers[index];
+        if (res != dmGameObject::PROPERTY_RESULT_OK || br == prev_buffer_resource)
+            return res;
+
+        bool local_space = dmRender::GetMaterialVertexSpace(GetMaterial(component, component->m_Resource)) == dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL;
+        if (prev_buffer_resource && local_space)
+        {
+            DecRefVertexBuffer(world, prev_buffer_resource->m_NameHash);
+        }
+
+        // All levels are drawn with the vertex declaration of the component
+        if (!HasSameStreams(br, GetVerticesBuffer(component, component->m_Resource)))
+        {
+            dmLogError("The streams of the buffer for LOD %d differ from the vertices buffer of the mesh.", index + 1);
+            dmResource::Release(factory, br);
+            component->m_LodBuffers[index] = 0;
+            res = dmGameObject::PROPERTY_RESULT_UNSUPPORTED_VALUE;
+        }
+        else if (local_space)
+        {
+            CreateVertexBuffer(world, br, GetVertexSize(component));
+        }
+
+        // Selected again at the next render
+        component->m_LodLevel = 0;
+        component->m_ReHash = 1;
+        return res;
+    }
+
     dmGameObject::PropertyResult CompMeshSetProperty(const dmGameObject::ComponentSetPropertyParams& params)
     {
         MeshWorld* world = (MeshWorld*)params.m_World;
@@ -939,6 +1286,21 @@ namespace dmGameSystem
 
             return res;
         }
+        else if (IsReferencingProperty(MESH_PROP_LOD_DISTANCES, params.m_PropertyId))
+        {
+            return SetProperty(params.m_PropertyId, params.m_Value, component->m_LodDistances, MESH_PROP_LOD_DISTANCES);
+        }
+        else if (params.m_PropertyId == PROP_LAYER)
+        {
+            return SetLayerProperty(params.m_Value, &component->m_RenderLayer);
+        }
+        else if (params.m_PropertyId == PROP_OCCLUDER)
+        {
+            if (params.m_Value.m_Type != dmGameObject::PROPERTY_TYPE_BOOLEAN)
+                return dmGameObject::PROPERTY_RESULT_TYPE_MISMATCH;
+            component->m_Occluder = params.m_Value.m_Bool;
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
         else if (params.m_PropertyId == PROP_MATERIAL)
         {
             bool prev_material_local = dmRender::GetMaterialVertexSpace(GetMaterial(component, component->m_Resource)) == dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL;
@@ -954,11 +1316,24 @@ namespace dmGameSystem
                 {
                     BufferResource* br = GetVerticesBuffer(component, component->m_Resource);
                     DecRefVertexBuffer(world, br->m_NameHash);
+                    for (uint32_t i = 0; i < MAX_LOD_COUNT - 1; ++i)
+                    {
+                        if (component->m_LodBuffers[i])
+                            DecRefVertexBuffer(world, component->m_LodBuffers[i]->m_NameHash);
+                    }
                 }
             }
             return res;
         }
 
+        for (uint32_t i = 0; i < MAX_LOD_COUNT - 1; ++i)
+        {
+            if (params.m_PropertyId == PROP_VERTICES_LOD[i])
+            {
+                return SetLodVerticesBuffer(world, component, i, dmGameObject::GetFactory(params.m_Instance), params.m_Value);
+            }
+        }
+
         for(uint32_t i = 0; i < MAX_TEXTURE_COUNT; ++i)
         {
             if(params.m_PropertyId == PROP_TEXTURE[i])
@@ -1004,6 +1379,15 @@ namespace dmGameSystem
                         break;
                     }
                 }
+
+                for (uint32_t i = 0; i < MAX_LOD_COUNT - 1; ++i)
+                {
+                    if (component->m_LodBuffers[i] == params.m_Resource->m_Resource)
+                    {
+                        component->m_ReHash = 1;
+                        break;
+                    }
+                }
             }
         }
     }
@@ -61,9 +61,13 @@ namespace dmGameSystem
         HComponentRenderConstants   m_RenderConstants;
         dmGraphics::HTexture        m_Textures[dmRender::RenderObject::MAX_TEXTURE_COUNT];
         dmRender::HMaterial         m_Material;
+        /// Bone matrices for models skinned in the vertex shader
+        dmGraphics::HTexture        m_SkinPalette;
 
         /// Node instances corresponding to the bones
         dmArray<dmGameObject::HInstance> m_NodeInstances;
+        /// World transform version of the instance when m_World was last calculated
+        uint32_t                    m_WorldVersion;
         uint16_t                    m_ComponentIndex;
         /// Component enablement
         uint8_t                     m_Enabled : 1;
@@ -71,6 +75,10 @@ namespace dmGameSystem
         /// Added to update or not
         uint8_t                     m_AddedToUpdate : 1;
         uint8_t                     m_ReHash : 1;
+        /// Drawn since the last update, used by the animation LOD
+        uint8_t                     m_Rendered : 1;
+        /// Render layer, see dmRender::SetLayerMask
+        uint8_t                     m_RenderLayer;
     };
 
     struct ModelWorld
@@ -78,14 +86,27 @@ namespace dmGameSystem
         dmObjectPool<ModelComponent*>   m_Components;
         dmArray<dmRender::RenderObject> m_RenderObjects;
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
+        dmGraphics::HVertexDeclaration  m_SkinnedVertexDeclaration;
+        dmGraphics::HVertexDeclaration  m_InstanceVertexDeclaration;
+        dmGraphics::HDynamicVertexBuffer m_DynamicInstanceBuffer;
+        // The buffer of m_DynamicInstanceBuffer used by the current render list dispatch
+        dmGraphics::HVertexBuffer       m_InstanceBuffer;
+        dmArray<WorldTransformInstance> m_InstanceData;
+        dmGraphics::HContext            m_GraphicsContext;
         dmGraphics::HVertexBuffer*      m_VertexBuffers;
         dmArray<dmRig::RigModelVertex>* m_VertexBufferData;
         // Temporary scratch array for instances, only used during the creation phase of components
         dmArray<dmGameObject::HInstance> m_ScratchInstances;
         dmRig::HRigContext              m_RigContext;
+        // Scratch entries for generating the vertex data of a batch on the job workers
+        dmArray<dmRig::RigVertexDataEntry> m_VertexDataEntries;
+        // Scratch rows of bone matrices, uploaded to the skin palette textures
+        dmArray<float>                  m_SkinPaletteData;
         uint32_t                        m_MaxElementsVertices;
         uint32_t                        m_VertexBufferSwapChainIndex;
         uint32_t                        m_VertexBufferSwapChainSize;
+        uint8_t                         m_UseInstancing : 1;
+        uint8_t                         m_UseBakedAnimations : 1;
     };
 
     static const uint32_t VERTEX_BUFFER_MAX_BATCHES = 16;     // Max dmRender::RenderListEntry.m_MinorOrder (4 bits)
@@ -95,6 +116,10 @@ namespace dmGameSystem
     static const dmhash_t PROP_CURSOR = dmHashString64("cursor");
     static const dmhash_t PROP_PLAYBACK_RATE = dmHashString64("playback_rate");
 
+    static const dmhash_t SKIN_PALETTE_SAMPLER = dmHashString64("skin_palette");
+    static const dmhash_t SKIN_PALETTE_SIZE_CONSTANT = dmHashString64("skin_palette_size");
+    static const uint32_t SKIN_PALETTE_MAX_BONES = 1024;    // Three RGBA32F texels per bone
+
     static const uint32_t MAX_TEXTURE_COUNT = dmRender::RenderObject::MAX_TEXTURE_COUNT;
 
     static void ResourceReloadedCallback(const dmResource::ResourceReloadedParams& params);
@@ -109,6 +134,7 @@ namespace dmGameSystem
         dmRig::NewContextParams rig_params = {0};
         rig_params.m_Context = &world->m_RigContext;
         rig_params.m_MaxRigInstanceCount = context->m_MaxModelCount;
+        rig_params.m_JobContext = dmRender::GetJobContext(render_context);
         dmRig::Result rr = dmRig::NewContext(rig_params);
         if (rr != dmRig::RESULT_OK)
         {
@@ -127,6 +153,24 @@ namespace dmGameSystem
         };
         dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
         world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, ve, sizeof(ve) / sizeof(dmGraphics::VertexElement));
+
+        dmGraphics::VertexElement ve_skinned[] =
+        {
+                {"position", 0, 3, dmGraphics::TYPE_FLOAT, false},
+                {"texcoord0", 1, 2, dmGraphics::TYPE_FLOAT, false},
+                {"normal", 2, 3, dmGraphics::TYPE_FLOAT, false},
+                {"bone_weights", 3, 4, dmGraphics::TYPE_FLOAT, false},
+                {"bone_indices", 4, 4, dmGraphics::TYPE_FLOAT, false},
+        };
+        world->m_SkinnedVertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, ve_skinned, sizeof(ve_skinned) / sizeof(dmGraphics::VertexElement));
+        world->m_GraphicsContext = graphics_context;
+        world->m_UseInstancing = context->m_Instancing && dmGraphics::IsInstancingSupported(graphics_context);
+        world->m_UseBakedAnimations = context->m_BakedAnimations;
+        if (world->m_UseInstancing)
+        {
+            world->m_InstanceVertexDeclaration = NewWorldTransformInstanceDeclaration(graphics_context);
+            world->m_DynamicInstanceBuffer = dmGraphics::NewDynamicVertexBuffer(graphics_context);
+        }
         world->m_MaxElementsVertices = dmGraphics::GetMaxElementsVertices(graphics_context);
         world->m_VertexBuffers = new dmGraphics::HVertexBuffer[VERTEX_BUFFER_MAX_BATCHES];
         world->m_VertexBufferData = new dmArray<dmRig::RigModelVertex>[VERTEX_BUFFER_MAX_BATCHES];
@@ -146,6 +190,12 @@ namespace dmGameSystem
     {
         ModelWorld* world = (ModelWorld*)params.m_World;
         dmGraphics::DeleteVertexDeclaration(world->m_VertexDeclaration);
+        dmGraphics::DeleteVertexDeclaration(world->m_SkinnedVertexDeclaration);
+        if (world->m_UseInstancing)
+        {
+            dmGraphics::DeleteVertexDeclaration(world->m_InstanceVertexDeclaration);
+            dmGraphics::DeleteDynamicVertexBuffer(world->m_DynamicInstanceBuffer);
+        }
         for(uint32_t i = 0; i < VERTEX_BUFFER_MAX_BATCHES; ++i)
         {
             dmGraphics::DeleteVertexBuffer(world->m_VertexBuffers[i]);
@@ -249,6 +299,10 @@ namespace dmGameSystem
         dmHashInit32(&state, reverse);
         dmRender::HMaterial material = GetMaterial(component, resource);
         dmHashUpdateBuffer32(&state, &material, sizeof(material));
+        // Local space models are only batched with models of the same mesh, so that they can be drawn instanced
+        if (dmRender::GetMaterialVertexSpace(material) == dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL) {
+            dmHashUpdateBuffer32(&state, &resource, sizeof(resource));
+        }
         // We have to hash individually since we don't know which textures are set as properties
         for (uint32_t i = 0; i < MAX_TEXTURE_COUNT; ++i) {
             dmGraphics::HTexture texture = GetTexture(component, resource, i);
@@ -370,6 +424,7 @@ namespace dmGameSystem
         component->m_ComponentIndex = params.m_ComponentIndex;
         component->m_Enabled = 1;
         component->m_World = Matrix4::identity();
+        component->m_WorldVersion = 0xffffffff;
         component->m_DoRender = 0;
         component->m_FunctionRef = 0;
         component->m_RenderConstants = 0;
@@ -402,6 +457,7 @@ namespace dmGameSystem
         create_params.m_MeshSet          = rig_resource->m_MeshSetRes->m_MeshSet;
         create_params.m_PoseIdxToInfluence = &rig_resource->m_PoseIdxToInfluence;
         create_params.m_TrackIdxToPose     = &rig_resource->m_TrackIdxToPose;
+        create_params.m_BakedAnimationSet  = world->m_UseBakedAnimations ? GetBakedAnimationSet(rig_resource) : 0x0;
         create_params.m_MeshId           = 0; // not implemented for models
         create_params.m_DefaultAnimation = dmHashString64(resource->m_Model->m_DefaultAnimation);
 
@@ -437,6 +493,10 @@ namespace dmGameSystem
             dmGameSystem::DestroyRenderConstants(component->m_RenderConstants);
         }
 
+        if (component->m_SkinPalette) {
+            dmGraphics::DeleteTexture(component->m_SkinPalette);
+        }
+
         delete component;
         world->m_Components.Free(index, true);
     }
@@ -459,11 +519,54 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
+    // Uploads the bone matrices of the component to its skin palette texture and binds it to the render object
+    static void ApplySkinPalette(ModelWorld* world, ModelComponent* component, dmRender::RenderObject& ro)
+    {
+        int32_t unit = dmRender::GetMaterialSamplerUnit(ro.m_Material, SKIN_PALETTE_SAMPLER);
+        if (unit < 0 || unit >= (int32_t) MAX_TEXTURE_COUNT) {
+            return;
+        }
+
+        dmArray<float>& palette = world->m_SkinPaletteData;
+        uint32_t max_bone_count = dmMath::Min(dmRig::GetMaxBoneCount(component->m_RigInstance), SKIN_PALETTE_MAX_BONES);
+        if (palette.Capacity() < max_bone_count * 12) {
+            palette.SetCapacity(max_bone_count * 12);
+        }
+        uint32_t bone_count = dmRig::GenerateSkinPalette(world->m_RigContext, component->m_RigInstance, palette.Begin(), max_bone_count);
+        if (bone_count == 0) {
+            return;
+        }
+
+        uint32_t width = bone_count * 3;
+        if (!component->m_SkinPalette) {
+            dmGraphics::TextureCreationParams create_params;
+            create_params.m_Width = width;
+            create_params.m_Height = 1;
+            create_params.m_OriginalWidth = width;
+            create_params.m_OriginalHeight = 1;
+            component->m_SkinPalette = dmGraphics::NewTexture(world->m_GraphicsContext, create_params);
+        }
+
+        dmGraphics::TextureParams params;
+        params.m_Format = dmGraphics::TEXTURE_FORMAT_RGBA32F;
+        params.m_Data = palette.Begin();
+        params.m_DataSize = width * 4 * sizeof(float);
+        params.m_Width = width;
+        params.m_Height = 1;
+        params.m_MinFilter = dmGraphics::TEXTURE_FILTER_NEAREST;
+        params.m_MagFilter = dmGraphics::TEXTURE_FILTER_NEAREST;
+        dmGraphics::SetTexture(component->m_SkinPalette, params);
+
+        ro.m_Textures[unit] = component->m_SkinPalette;
+        dmRender::EnableRenderObjectConstant(&ro, SKIN_PALETTE_SIZE_CONSTANT, Vector4((float) width, 1.0f / width, 0.0f, 0.0f));
+    }
+
     static inline void RenderBatchLocalVS(ModelWorld* world, dmRender::HMaterial material, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
     {
         DM_PROFILE(Model, "RenderBatchLocal");
 
-        for (uint32_t *i=begin;i!=end;i++)
+        uint32_t* i = begin;
+        while (i != end)
         {
             dmRender::RenderObject& ro = *world->m_RenderObjects.End();
             world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
@@ -472,8 +575,16 @@ namespace dmGameSystem
             const ModelResource* mr = component->m_Resource;
             assert(mr->m_VertexBuffer);
 
+            // Models sharing the same static mesh are drawn with one instanced call
+            uint32_t* run_end = i + 1;
+            if (world->m_UseInstancing && !mr->m_SkinnedVertices)
+            {
+                while (run_end != end && ((ModelComponent*) buf[*run_end].m_UserData)->m_Resource == mr)
+                    ++run_end;
+            }
+
             ro.Init();
-            ro.m_VertexDeclaration = world->m_VertexDeclaration;
+            ro.m_VertexDeclaration = mr->m_SkinnedVertices ? world->m_SkinnedVertexDeclaration : world->m_VertexDeclaration;
             ro.m_VertexBuffer = mr->m_VertexBuffer;
             ro.m_Material = GetMaterial(component, mr);
             ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
@@ -487,15 +598,40 @@ namespace dmGameSystem
                 ro.m_IndexType = mr->m_IndexBufferElementType;
             }
 
-            for(uint32_t i = 0; i < MAX_TEXTURE_COUNT; ++i)
+            for(uint32_t t = 0; t < MAX_TEXTURE_COUNT; ++t)
             {
-                ro.m_Textures[i] = GetTexture(component, mr, i);
+                ro.m_Textures[t] = GetTexture(component, mr, t);
             }
 
             if (component->m_RenderConstants) {
                 dmGameSystem::EnableRenderObjectConstants(&ro, component->m_RenderConstants);
             }
 
+            if (mr->m_SkinnedVertices) {
+                ApplySkinPalette(world, component, ro);
+            }
+
+            if (run_end - i > 1)
+            {
+                dmArray<WorldTransformInstance>& instances = world->m_InstanceData;
+                uint32_t instance_count = run_end - i;
+                if (instances.Remaining() < instance_count) {
+                    instances.OffsetCapacity(dmMath::Max(instance_count - instances.Remaining(), 256U));
+                }
+                ro.m_InstanceVertexDeclaration = world->m_InstanceVertexDeclaration;
+                ro.m_InstanceVertexBuffer = world->m_InstanceBuffer;
+                ro.m_InstanceStart = instances.Size();
+                ro.m_InstanceCount = instance_count;
+                ro.m_WorldTransform = Matrix4::identity();
+                for (; i != run_end; ++i)
+                {
+                    const ModelComponent* c = (ModelComponent*) buf[*i].m_UserData;
+                    instances.SetSize(instances.Size() + 1);
+                    SetWorldTransformInstance(&instances.Back(), c->m_World);
+                }
+            }
+            i = run_end;
+
             dmRender::AddToRender(render_context, &ro);
         }
     }
@@ -529,17 +665,26 @@ namespace dmGameSystem
 
         dmGraphics::HVertexBuffer& gfx_vertex_buffer = world->m_VertexBuffers[batchIndex];
 
-        // Fill in vertex buffer
+        // Fill in vertex buffer, each component writes to its own range so they can be skinned in parallel
         dmRig::RigModelVertex *vb_begin = vertex_buffer.End();
         dmRig::RigModelVertex *vb_end = vb_begin;
+        dmArray<dmRig::RigVertexDataEntry>& entries = world->m_VertexDataEntries;
+        entries.SetSize(0);
+        if (entries.Capacity() < (uint32_t)(end - begin))
+            entries.SetCapacity(end - begin);
         for (uint32_t *i=begin;i!=end;i++)
         {
             const ModelComponent* c = (ModelComponent*) buf[*i].m_UserData;
-            dmRig::HRigContext rig_context = world->m_RigContext;
-            Matrix4 normal_matrix = inverse(c->m_World);
-            normal_matrix = transpose(normal_matrix);
-            vb_end = (dmRig::RigModelVertex *)dmRig::GenerateVertexData(rig_context, c->m_RigInstance, c->m_World, normal_matrix, Vector4(1.0), dmRig::RIG_VERTEX_FORMAT_MODEL, (void*)vb_end);
+            entries.SetSize(entries.Size() + 1);
+            dmRig::RigVertexDataEntry& entry = entries.Back();
+            entry.m_ModelMatrix = c->m_World;
+            entry.m_NormalMatrix = transpose(inverse(c->m_World));
+            entry.m_Color = Vector4(1.0);
+            entry.m_Instance = c->m_RigInstance;
+            entry.m_VertexDataOut = vb_end;
+            vb_end += dmRig::GetVertexCount(c->m_RigInstance);
         }
+        dmRig::GenerateVertexDataBatch(world->m_RigContext, entries.Begin(), entries.Size(), dmRig::RIG_VERTEX_FORMAT_MODEL);
         vertex_buffer.SetSize(vb_end - vertex_buffer.Begin());
 
         // Ninja in-place writing of render object.
@@ -573,6 +718,10 @@ namespace dmGameSystem
 
         const ModelComponent* first = (ModelComponent*) buf[*begin].m_UserData;
         dmRender::HMaterial material = first->m_Resource->m_Material;
+        for (uint32_t *i=begin;i!=end;i++)
+        {
+            ((ModelComponent*) buf[*i].m_UserData)->m_Rendered = 1;
+        }
         switch(dmRender::GetMaterialVertexSpace(material))
         {
             case dmRenderDDF::MaterialDesc::VERTEX_SPACE_WORLD:
@@ -605,6 +754,12 @@ namespace dmGameSystem
 
             if (dmRig::IsValid(c->m_RigInstance))
             {
+                // The local transform is constant, only recalculate when the instance has moved
+                uint32_t version = dmGameObject::GetWorldTransformVersion(c->m_Instance);
+                if (version == c->m_WorldVersion)
+                    continue;
+                c->m_WorldVersion = version;
+
                 const Matrix4& go_world = dmGameObject::GetWorldMatrix(c->m_Instance);
                 const Matrix4 local = dmTransform::ToMatrix4(c->m_Transform);
                 if (dmGameObject::ScaleAlongZ(c->m_Instance))
@@ -628,9 +783,38 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
+    // Evaluates the pose of models far from the camera less often, and freezes the pose of models that
+    // were not drawn since the last update, e.g. culled ones. The camera is taken from the view of the last frame.
+    static void UpdateAnimationLod(ModelWorld* world, ModelContext* context)
+    {
+        DM_PROFILE(Model, "UpdateAnimationLod");
+
+        const Vector3 camera_position = inverse(dmRender::GetViewMatrix(context->m_RenderContext)).getTranslation();
+        const float lod_distance_sq = context->m_AnimationLodDistance * context->m_AnimationLodDistance;
+
+        dmArray<ModelComponent*>& components = world->m_Components.m_Objects;
+        uint32_t n = components.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            ModelComponent* c = components[i];
+            if (!c->m_Enabled || !c->m_AddedToUpdate || !dmRig::IsValid(c->m_RigInstance))
+                continue;
+
+            float distance_sq = lengthSqr(c->m_World.getTranslation() - camera_position);
+            dmRig::SetUpdateInterval(c->m_RigInstance, distance_sq > lod_distance_sq ? context->m_AnimationLodInterval : 1);
+            dmRig::SetPoseFrozen(c->m_RigInstance, !c->m_Rendered);
+            c->m_Rendered = 0;
+        }
+    }
+
     dmGameObject::UpdateResult CompModelUpdate(const dmGameObject::ComponentsUpdateParams& params, dmGameObject::ComponentsUpdateResult& update_result)
     {
         ModelWorld* world = (ModelWorld*)params.m_World;
+        ModelContext* context = (ModelContext*)params.m_Context;
+
+        if (context->m_AnimationLodDistance > 0.0f) {
+            UpdateAnimationLod(world, context);
+        }
 
         dmRig::Result rig_res = dmRig::Update(world->m_RigContext, params.m_UpdateContext->m_DT);
 
@@ -654,6 +838,7 @@ namespace dmGameSystem
         }
 
         update_result.m_TransformsUpdated = rig_res == dmRig::RESULT_UPDATED_POSE;
+        update_result.m_Changed = rig_res == dmRig::RESULT_UPDATED_POSE;
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
@@ -670,6 +855,11 @@ namespace dmGameSystem
                 {
                     world->m_VertexBufferData[batch_index].SetSize(0);
                 }
+                if (world->m_UseInstancing)
+                {
+                    world->m_InstanceData.SetSize(0);
+                    world->m_InstanceBuffer = dmGraphics::AcquireDynamicVertexBuffer(world->m_DynamicInstanceBuffer);
+                }
                 break;
             }
             case dmRender::RENDER_LIST_OPERATION_BATCH:
@@ -693,6 +883,13 @@ namespace dmGameSystem
                     total_size += vb_size;
                 }
                 DM_COUNTER("ModelVertexBuffer", total_size);
+
+                if (!world->m_InstanceData.Empty())
+                {
+                    uint32_t instance_size = sizeof(WorldTransformInstance) * world->m_InstanceData.Size();
+                    dmGraphics::SetDynamicVertexBufferData(world->m_DynamicInstanceBuffer, instance_size, world->m_InstanceData.Begin());
+                    DM_COUNTER("ModelInstanceBuffer", instance_size);
+                }
                 break;
             }
             default:
@@ -701,6 +898,26 @@ namespace dmGameSystem
         }
     }
 
+    static void RenderListVisibility(dmRender::RenderListVisibilityParams const &params)
+    {
+        DM_PROFILE(Model, "RenderListVisibility");
+        for (uint32_t i = 0; i < params.m_NumEntries; ++i)
+        {
+            const ModelComponent* component = (const ModelComponent*) params.m_Entries[params.m_Indices[i]].m_UserData;
+            const ModelResource* resource = component->m_Resource;
+            const Matrix4& w = component->m_World;
+            if (!resource->m_HasAabb)
+            {
+                params.m_Bounds[i].m_Center = Point3(w.getCol3().getXYZ());
+                params.m_Bounds[i].m_Extents = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+                continue;
+            }
+            const Vector3& e = resource->m_AabbExtents;
+            params.m_Bounds[i].m_Center = Point3((w * resource->m_AabbCenter).getXYZ());
+            params.m_Bounds[i].m_Extents = absPerElem(w.getCol0().getXYZ()) * e.getX() + absPerElem(w.getCol1().getXYZ()) * e.getY() + absPerElem(w.getCol2().getXYZ()) * e.getZ();
+        }
+    }
+
     dmGameObject::UpdateResult CompModelRender(const dmGameObject::ComponentsRenderParams& params)
     {
         ModelContext* context = (ModelContext*)params.m_Context;
@@ -714,7 +931,7 @@ namespace dmGameSystem
 
         // Prepare list submit
         dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(render_context, count);
-        dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, world);
+        dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, &RenderListVisibility, world);
         dmRender::RenderListEntry* write_ptr = render_list;
 
         const uint32_t max_elements_vertices = world->m_MaxElementsVertices;
@@ -741,6 +958,7 @@ namespace dmGameSystem
             write_ptr->m_TagListKey = dmRender::GetMaterialTagListKey(GetMaterial(&component, component.m_Resource));
             write_ptr->m_Dispatch = dispatch;
             write_ptr->m_MinorOrder = minor_order;
+            write_ptr->m_Layer = component.m_RenderLayer;
             write_ptr->m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
             ++write_ptr;
         }
@@ -861,6 +1079,7 @@ namespace dmGameSystem
         create_params.m_MeshSet          = rig_resource->m_MeshSetRes->m_MeshSet;
         create_params.m_PoseIdxToInfluence = &rig_resource->m_PoseIdxToInfluence;
         create_params.m_TrackIdxToPose     = &rig_resource->m_TrackIdxToPose;
+        create_params.m_BakedAnimationSet  = world->m_UseBakedAnimations ? GetBakedAnimationSet(rig_resource) : 0x0;
         create_params.m_MeshId           = 0; // not implemented for models
         create_params.m_DefaultAnimation = dmHashString64(component->m_Resource->m_Model->m_DefaultAnimation);
 
@@ -913,6 +1132,11 @@ namespace dmGameSystem
             out_value.m_Variant = dmGameObject::PropertyVar(dmRig::GetPlaybackRate(component->m_RigInstance));
             return dmGameObject::PROPERTY_RESULT_OK;
         }
+        else if (params.m_PropertyId == PROP_LAYER)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar((float)component->m_RenderLayer);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
         else if (params.m_PropertyId == PROP_MATERIAL)
         {
             return GetResourceProperty(dmGameObject::GetFactory(params.m_Instance), GetMaterial(component, component->m_Resource), out_value);
@@ -970,6 +1194,10 @@ namespace dmGameSystem
             }
             return dmGameObject::PROPERTY_RESULT_OK;
         }
+        else if (params.m_PropertyId == PROP_LAYER)
+        {
+            return SetLayerProperty(params.m_Value, &component->m_RenderLayer);
+        }
         else if (params.m_PropertyId == PROP_MATERIAL)
         {
             dmGameObject::PropertyResult res = SetResourceProperty(dmGameObject::GetFactory(params.m_Instance), params.m_Value, MATERIAL_EXT_HASH, (void**)&component->m_Material);
@@ -57,6 +57,15 @@ namespace dmGameSystem
         uint16_t m_Padding : 15;
     };
 
+    // Vertex of the static quad used when drawing instanced.
+    // The corner selects which of the four instance texture coordinates to use.
+    struct ParticleQuadVertex
+    {
+        float x;
+        float y;
+        float corner[4];
+    };
+
     struct ParticleFXWorld
     {
         dmArray<ParticleFXComponent> m_Components;
@@ -65,12 +74,20 @@ namespace dmGameSystem
         dmIndexPool32 m_PrototypeIndices;
         ParticleFXContext* m_Context;
         dmParticle::HParticleContext m_ParticleContext;
+        dmGraphics::HDynamicVertexBuffer m_DynamicVertexBuffer;
         dmGraphics::HVertexBuffer m_VertexBuffer;
         dmArray<dmParticle::Vertex> m_VertexBufferData;
+        dmArray<const dmParticle::EmitterRenderData*> m_RenderBatch;
         dmGraphics::HVertexDeclaration m_VertexDeclaration;
+        dmGraphics::HVertexDeclaration m_QuadVertexDeclaration;
+        dmGraphics::HVertexBuffer m_QuadVertexBuffer;
+        dmGraphics::HIndexBuffer m_QuadIndexBuffer;
+        dmGraphics::HVertexDeclaration m_InstanceVertexDeclaration;
+        dmArray<dmParticle::ParticleInstance> m_InstanceData;
         uint32_t m_EmitterCount;
         float m_DT;
         uint32_t m_WarnOutOfROs : 1;
+        uint32_t m_UseInstancing : 1;
     };
 
     dmGameObject::CreateResult CompParticleFXNewWorld(const dmGameObject::ComponentNewWorldParams& params)
@@ -82,23 +99,69 @@ namespace dmGameSystem
         world->m_Context = ctx;
         uint32_t particle_fx_count = ctx->m_MaxParticleFXCount;
         world->m_ParticleContext = dmParticle::CreateContext(particle_fx_count, ctx->m_MaxParticleCount);
+        dmParticle::SetJobContext(world->m_ParticleContext, dmRender::GetJobContext(ctx->m_RenderContext));
+        dmParticle::SetOffscreenUpdate(world->m_ParticleContext, (dmParticle::OffscreenUpdate)ctx->m_OffscreenUpdate);
         world->m_Components.SetCapacity(particle_fx_count);
         world->m_RenderObjects.SetCapacity(particle_fx_count);
         world->m_Prototypes.SetCapacity(particle_fx_count);
         world->m_Prototypes.SetSize(particle_fx_count);
         world->m_PrototypeIndices.SetCapacity(particle_fx_count);
-        uint32_t buffer_size = dmParticle::GetVertexBufferSize(ctx->m_MaxParticleCount, dmParticle::PARTICLE_GO);
-        world->m_VertexBuffer = dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(ctx->m_RenderContext), buffer_size, 0x0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
-        world->m_VertexBufferData.SetCapacity(ctx->m_MaxParticleCount * 6);
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(ctx->m_RenderContext);
+        world->m_DynamicVertexBuffer = dmGraphics::NewDynamicVertexBuffer(graphics_context);
+        world->m_VertexBuffer = 0;
         world->m_WarnOutOfROs = 0;
         world->m_EmitterCount = 0;
+        world->m_UseInstancing = 0;
+        world->m_QuadVertexDeclaration = 0;
+        world->m_QuadVertexBuffer = 0;
+        world->m_QuadIndexBuffer = 0;
+        world->m_InstanceVertexDeclaration = 0;
         dmGraphics::VertexElement ve[] =
         {
             {"position",  0, 3, dmGraphics::TYPE_FLOAT, false},
             {"color",     1, 4, dmGraphics::TYPE_FLOAT, true},
             {"texcoord0", 2, 2, dmGraphics::TYPE_FLOAT, true},
         };
-        world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(dmRender::GetGraphicsContext(ctx->m_RenderContext), ve, 3);
+        world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, ve, 3);
+
+        if (ctx->m_Instancing && dmGraphics::IsInstancingSupported(graphics_context))
+        {
+            dmGraphics::VertexElement quad_ve[] =
+            {
+                    {"position", 0, 2, dmGraphics::TYPE_FLOAT, false},
+                    {"corner", 1, 4, dmGraphics::TYPE_FLOAT, false},
+            };
+            dmGraphics::VertexElement instance_ve[] =
+            {
+                    {"instance_position", 2, 3, dmGraphics::TYPE_FLOAT, false},
+                    {"instance_axis_x", 3, 3, dmGraphics::TYPE_FLOAT, false},
+                    {"instance_axis_y", 4, 3, dmGraphics::TYPE_FLOAT, false},
+                    {"instance_color", 5, 4, dmGraphics::TYPE_FLOAT, false},
+                    {"instance_uv01", 6, 4, dmGraphics::TYPE_FLOAT, false},
+                    {"instance_uv23", 7, 4, dmGraphics::TYPE_FLOAT, false},
+            };
+
+            // Same corner order as the texture coordinates of dmParticle::ParticleInstance
+            const ParticleQuadVertex quad[] =
+            {
+                {-1.0f, -1.0f, {1.0f, 0.0f, 0.0f, 0.0f}},
+                {-1.0f,  1.0f, {0.0f, 1.0f, 0.0f, 0.0f}},
+                { 1.0f,  1.0f, {0.0f, 0.0f, 1.0f, 0.0f}},
+                { 1.0f, -1.0f, {0.0f, 0.0f, 0.0f, 1.0f}},
+            };
+            const uint16_t quad_indices[] = { 0, 1, 2, 2, 3, 0 };
+
+            world->m_QuadVertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, quad_ve, sizeof(quad_ve) / sizeof(dmGraphics::VertexElement));
+            world->m_QuadVertexBuffer = dmGraphics::NewVertexBuffer(graphics_context, sizeof(quad), quad, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+            world->m_QuadIndexBuffer = dmGraphics::NewIndexBuffer(graphics_context, sizeof(quad_indices), quad_indices, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+            world->m_InstanceVertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, instance_ve, sizeof(instance_ve) / sizeof(dmGraphics::VertexElement));
+            world->m_InstanceData.SetCapacity(ctx->m_MaxParticleCount);
+            world->m_UseInstancing = 1;
+        }
+        else
+        {
+            world->m_VertexBufferData.SetCapacity(ctx->m_MaxParticleCount * 6);
+        }
         *params.m_World = world;
         return dmGameObject::CREATE_RESULT_OK;
     }
@@ -113,8 +176,15 @@ namespace dmGameSystem
             dmParticle::DestroyInstance(pfx_world->m_ParticleContext, c->m_ParticleInstance);
         }
         dmParticle::DestroyContext(pfx_world->m_ParticleContext);
-        dmGraphics::DeleteVertexBuffer(pfx_world->m_VertexBuffer);
+        dmGraphics::DeleteDynamicVertexBuffer(pfx_world->m_DynamicVertexBuffer);
         dmGraphics::DeleteVertexDeclaration(pfx_world->m_VertexDeclaration);
+        if (pfx_world->m_UseInstancing)
+        {
+            dmGraphics::DeleteVertexDeclaration(pfx_world->m_QuadVertexDeclaration);
+            dmGraphics::DeleteVertexBuffer(pfx_world->m_QuadVertexBuffer);
+            dmGraphics::DeleteIndexBuffer(pfx_world->m_QuadIndexBuffer);
+            dmGraphics::DeleteVertexDeclaration(pfx_world->m_InstanceVertexDeclaration);
+        }
         delete pfx_world;
         return dmGameObject::CREATE_RESULT_OK;
     }
@@ -174,6 +244,9 @@ namespace dmGameSystem
         if (components.Empty())
             return dmGameObject::UPDATE_RESULT_OK;
 
+        // Live effects change every frame, and the frame they are pruned in removes them from the screen
+        update_result.m_Changed = true;
+
         dmParticle::HParticleContext particle_context = w->m_ParticleContext;
         uint32_t count = components.Size();
 
@@ -228,35 +301,68 @@ namespace dmGameSystem
         ParticleFXContext* pfx_context = pfx_world->m_Context;
         dmParticle::HParticleContext particle_context = pfx_world->m_ParticleContext;
 
-        dmArray<dmParticle::Vertex> &vertex_buffer = pfx_world->m_VertexBufferData;
-        dmParticle::Vertex* vb_begin = vertex_buffer.End();
-        dmParticle::Vertex* vb_end = vb_begin;
-
-        uint32_t vb_size_init = vertex_buffer.Size() * sizeof(dmParticle::Vertex);
-        uint32_t vb_size = vb_size_init;
-        uint32_t vb_max_size =  dmParticle::GetVertexBufferSize(pfx_context->m_MaxParticleCount, dmParticle::PARTICLE_GO);
-
+        dmArray<const dmParticle::EmitterRenderData*>& batch = pfx_world->m_RenderBatch;
+        batch.SetSize(0);
+        uint32_t batch_size = end - begin;
+        if (batch.Capacity() < batch_size)
+            batch.SetCapacity(batch_size);
         for (uint32_t *i = begin; i != end; ++i)
         {
-            const dmParticle::EmitterRenderData* emitter_render_data = (dmParticle::EmitterRenderData*) buf[*i].m_UserData;
-            dmParticle::GenerateVertexData(particle_context, pfx_world->m_DT, emitter_render_data->m_Instance, emitter_render_data->m_EmitterIndex, Vector4(1,1,1,1), (void*)vertex_buffer.Begin(), vb_max_size, &vb_size, dmParticle::PARTICLE_GO);
+            batch.Push((dmParticle::EmitterRenderData*) buf[*i].m_UserData);
         }
 
-        vb_end = (vb_begin + (vb_size - vb_size_init) / sizeof(dmParticle::Vertex));
-
-        uint32_t ro_vertex_count = vb_end - vb_begin;
-        vertex_buffer.SetSize(vb_end - vertex_buffer.Begin());
-
         // Ninja in-place writing of render object
         dmRender::RenderObject& ro = *pfx_world->m_RenderObjects.End();
         pfx_world->m_RenderObjects.SetSize(pfx_world->m_RenderObjects.Size()+1);
         ro.Init();
         ro.m_Material = (dmRender::HMaterial)first->m_Material;
         ro.m_Textures[0] = (dmGraphics::HTexture)first->m_Texture;
-        ro.m_VertexStart = vb_begin - vertex_buffer.Begin();
-        ro.m_VertexCount = ro_vertex_count;
-        ro.m_VertexBuffer = pfx_world->m_VertexBuffer;
-        ro.m_VertexDeclaration = pfx_world->m_VertexDeclaration;
+
+        if (pfx_world->m_UseInstancing)
+        {
+            dmArray<dmParticle::ParticleInstance>& instance_buffer = pfx_world->m_InstanceData;
+            uint32_t instance_start = instance_buffer.Size();
+            uint32_t ib_size = instance_start * sizeof(dmParticle::ParticleInstance);
+            uint32_t ib_max_size = dmParticle::GetVertexBufferSize(pfx_context->m_MaxParticleCount, dmParticle::PARTICLE_GO_INSTANCE);
+
+            // One record per particle, the quads are expanded by the vertex shader
+            dmParticle::GenerateVertexDataBatch(particle_context, pfx_world->m_DT, batch.Begin(), batch.Size(), Vector4(1,1,1,1), (void*)instance_buffer.Begin(), ib_max_size, &ib_size, dmParticle::PARTICLE_GO_INSTANCE);
+            instance_buffer.SetSize(ib_size / sizeof(dmParticle::ParticleInstance));
+
+            ro.m_VertexDeclaration = pfx_world->m_QuadVertexDeclaration;
+            ro.m_VertexBuffer = pfx_world->m_QuadVertexBuffer;
+            ro.m_IndexBuffer = pfx_world->m_QuadIndexBuffer;
+            ro.m_IndexType = dmGraphics::TYPE_UNSIGNED_SHORT;
+            ro.m_VertexStart = 0;
+            ro.m_VertexCount = 6;
+            ro.m_InstanceVertexDeclaration = pfx_world->m_InstanceVertexDeclaration;
+            ro.m_InstanceVertexBuffer = pfx_world->m_VertexBuffer;
+            ro.m_InstanceStart = instance_start;
+            ro.m_InstanceCount = instance_buffer.Size() - instance_start;
+        }
+        else
+        {
+            dmArray<dmParticle::Vertex> &vertex_buffer = pfx_world->m_VertexBufferData;
+            dmParticle::Vertex* vb_begin = vertex_buffer.End();
+            dmParticle::Vertex* vb_end = vb_begin;
+
+            uint32_t vb_size_init = vertex_buffer.Size() * sizeof(dmParticle::Vertex);
+            uint32_t vb_size = vb_size_init;
+            uint32_t vb_max_size =  dmParticle::GetVertexBufferSize(pfx_context->m_MaxParticleCount, dmParticle::PARTICLE_GO);
+
+            // The emitters of the batch are written in parallel, each into its own range of the vertex buffer
+            dmParticle::GenerateVertexDataBatch(particle_context, pfx_world->m_DT, batch.Begin(), batch.Size(), Vector4(1,1,1,1), (void*)vertex_buffer.Begin(), vb_max_size, &vb_size, dmParticle::PARTICLE_GO);
+
+            vb_end = (vb_begin + (vb_size - vb_size_init) / sizeof(dmParticle::Vertex));
+
+            uint32_t ro_vertex_count = vb_end - vb_begin;
+            vertex_buffer.SetSize(vb_end - vertex_buffer.Begin());
+
+            ro.m_VertexStart = vb_begin - vertex_buffer.Begin();
+            ro.m_VertexCount = ro_vertex_count;
+            ro.m_VertexBuffer = pfx_world->m_VertexBuffer;
+            ro.m_VertexDeclaration = pfx_world->m_VertexDeclaration;
+        }
         ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
         ro.m_SetBlendFactors = 1;
         SetBlendFactors(&ro, first->m_BlendMode);
@@ -271,8 +377,9 @@ namespace dmGameSystem
 
         if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_BEGIN)
         {
-            dmGraphics::SetVertexBufferData(pfx_world->m_VertexBuffer, 0, 0x0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+            pfx_world->m_VertexBuffer = dmGraphics::AcquireDynamicVertexBuffer(pfx_world->m_DynamicVertexBuffer);
             pfx_world->m_VertexBufferData.SetSize(0);
+            pfx_world->m_InstanceData.SetSize(0);
             pfx_world->m_RenderObjects.SetSize(0);
         }
         else if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_BATCH)
@@ -281,9 +388,31 @@ namespace dmGameSystem
         }
         else if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_END)
         {
-            dmGraphics::SetVertexBufferData(pfx_world->m_VertexBuffer, sizeof(dmParticle::Vertex) * pfx_world->m_VertexBufferData.Size(),
-                                            pfx_world->m_VertexBufferData.Begin(), dmGraphics::BUFFER_USAGE_STREAM_DRAW);
-            DM_COUNTER("ParticleFXVertexBuffer", pfx_world->m_VertexBufferData.Size() * sizeof(dmParticle::Vertex));
+            if (pfx_world->m_UseInstancing)
+            {
+                dmGraphics::SetDynamicVertexBufferData(pfx_world->m_DynamicVertexBuffer, sizeof(dmParticle::ParticleInstance) * pfx_world->m_InstanceData.Size(),
+                                                       pfx_world->m_InstanceData.Begin());
+                DM_COUNTER("ParticleFXInstanceBuffer", pfx_world->m_InstanceData.Size() * sizeof(dmParticle::ParticleInstance));
+            }
+            else
+            {
+                dmGraphics::SetDynamicVertexBufferData(pfx_world->m_DynamicVertexBuffer, sizeof(dmParticle::Vertex) * pfx_world->m_VertexBufferData.Size(),
+                                                       pfx_world->m_VertexBufferData.Begin());
+                DM_COUNTER("ParticleFXVertexBuffer", pfx_world->m_VertexBufferData.Size() * sizeof(dmParticle::Vertex));
+            }
+        }
+    }
+
+    static void RenderListVisibility(dmRender::RenderListVisibilityParams const &params)
+    {
+        DM_PROFILE(Particle, "RenderListVisibility");
+        for (uint32_t i = 0; i < params.m_NumEntries; ++i)
+        {
+            const dmParticle::EmitterRenderData* render_data = (dmParticle::EmitterRenderData*) params.m_Entries[params.m_Indices[i]].m_UserData;
+            const Vector3 min_p(render_data->m_AabbMin);
+            const Vector3 max_p(render_data->m_AabbMax);
+            params.m_Bounds[i].m_Center = Point3((min_p + max_p) * 0.5f);
+            params.m_Bounds[i].m_Extents = (max_p - min_p) * 0.5f;
         }
     }
 
@@ -303,7 +432,7 @@ namespace dmGameSystem
         }
 
         dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(ctx->m_RenderContext, world_emitter_count);
-        dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(ctx->m_RenderContext, &RenderListDispatch, pfx_world);
+        dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(ctx->m_RenderContext, &RenderListDispatch, &RenderListVisibility, pfx_world);
         dmRender::RenderListEntry* write_ptr = render_list;
 
         for (uint32_t i = 0; i < count; ++i)
@@ -255,6 +255,16 @@ dmGameObject::PropertyResult SetProperty(dmhash_t set_property, const dmGameObje
     return result;
 }
 
+dmGameObject::PropertyResult SetLayerProperty(const dmGameObject::PropertyVar& in_value, uint8_t* layer)
+{
+    if (in_value.m_Type != dmGameObject::PROPERTY_TYPE_NUMBER)
+        return dmGameObject::PROPERTY_RESULT_TYPE_MISMATCH;
+    if (in_value.m_Number < 0 || in_value.m_Number >= dmRender::MAX_LAYER_COUNT)
+        return dmGameObject::PROPERTY_RESULT_UNSUPPORTED_VALUE;
+    *layer = (uint8_t)in_value.m_Number;
+    return dmGameObject::PROPERTY_RESULT_OK;
+}
+
 dmGameObject::PropertyResult GetResourceProperty(dmResource::HFactory factory, void* resource, dmGameObject::PropertyDesc& out_value)
 {
     dmhash_t path;
@@ -415,6 +425,30 @@ int AreRenderConstantsUpdated(HComponentRenderConstants constants)
     return 0;
 }
 
+dmGraphics::HVertexDeclaration NewWorldTransformInstanceDeclaration(dmGraphics::HContext context)
+{
+    dmGraphics::VertexElement ve[] =
+    {
+            {"instance_axis_x", 8, 3, dmGraphics::TYPE_FLOAT, false},
+            {"instance_axis_y", 9, 3, dmGraphics::TYPE_FLOAT, false},
+            {"instance_axis_z", 10, 3, dmGraphics::TYPE_FLOAT, false},
+            {"instance_position", 11, 3, dmGraphics::TYPE_FLOAT, false},
+    };
+    return dmGraphics::NewVertexDeclaration(context, ve, sizeof(ve) / sizeof(dmGraphics::VertexElement));
+}
+
+void SetWorldTransformInstance(WorldTransformInstance* instance, const Matrix4& world)
+{
+    float* out = instance->axis_x;
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        const Vector4 col = world.getCol(c);
+        *out++ = col.getX();
+        *out++ = col.getY();
+        *out++ = col.getZ();
+    }
+}
+
 void EnableRenderObjectConstants(dmRender::RenderObject* ro, HComponentRenderConstants _constants)
 {
     const dmArray<dmRender::Constant>& constants = _constants->m_RenderConstants;
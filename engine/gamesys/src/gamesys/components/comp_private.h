@@ -25,11 +25,30 @@ namespace dmGameSystem
 {
     const uint32_t MAX_COMP_RENDER_CONSTANTS = 16;
 
+    /*
+     * Per instance data when static geometry is drawn instanced, the columns of its world transform.
+     * The vertex shader calculates the world position as
+     *     instance_position + instance_axis_x * position.x + instance_axis_y * position.y + instance_axis_z * position.z
+     */
+    struct WorldTransformInstance
+    {
+        float axis_x[3];
+        float axis_y[3];
+        float axis_z[3];
+        float position[3];
+    };
+
+    dmGraphics::HVertexDeclaration NewWorldTransformInstanceDeclaration(dmGraphics::HContext context);
+    void SetWorldTransformInstance(WorldTransformInstance* instance, const Vectormath::Aos::Matrix4& world);
+
     dmGameObject::PropertyResult GetProperty(dmGameObject::PropertyDesc& out_value, dmhash_t get_property, const Vectormath::Aos::Vector3& ref_value, const PropVector3& property);
     dmGameObject::PropertyResult SetProperty(dmhash_t set_property, const dmGameObject::PropertyVar& in_value, Vectormath::Aos::Vector3& set_value, const PropVector3& property);
 
     dmGameObject::PropertyResult GetProperty(dmGameObject::PropertyDesc& out_value, dmhash_t get_property, const Vectormath::Aos::Vector4& ref_value, const PropVector4& property);
     dmGameObject::PropertyResult SetProperty(dmhash_t set_property, const dmGameObject::PropertyVar& in_value, Vectormath::Aos::Vector4& set_value, const PropVector4& property);
+
+    // Sets the render layer [0, 31] of a component, see dmRender::SetLayerMask
+    dmGameObject::PropertyResult SetLayerProperty(const dmGameObject::PropertyVar& in_value, uint8_t* layer);
 }
 
 #endif // DM_GAMESYS_COMP_PRIVATE_H
@@ -52,6 +52,7 @@ namespace dmGameSystem
         float   m_Pan;
         float   m_Gain;
         float   m_Speed;
+        float   m_Priority;
     };
 
     struct SoundWorld
@@ -64,6 +65,7 @@ namespace dmGameSystem
     static const dmhash_t SOUND_PROP_GAIN   = dmHashString64("gain");
     static const dmhash_t SOUND_PROP_PAN    = dmHashString64("pan");
     static const dmhash_t SOUND_PROP_SPEED  = dmHashString64("speed");
+    static const dmhash_t SOUND_PROP_PRIORITY = dmHashString64("priority");
     static const dmhash_t SOUND_PROP_SOUND  = dmHashString64("sound");
 
     dmGameObject::CreateResult CompSoundNewWorld(const dmGameObject::ComponentNewWorldParams& params)
@@ -118,6 +120,7 @@ namespace dmGameSystem
         component->m_Gain   = component->m_Resource->m_Gain;
         component->m_Pan    = component->m_Resource->m_Pan;
         component->m_Speed  = component->m_Resource->m_Speed;
+        component->m_Priority = 0.0f;
 
         *params.m_UserData = (uintptr_t)index;
         return dmGameObject::CREATE_RESULT_OK;
@@ -303,6 +306,7 @@ namespace dmGameSystem
         case dmSound::PARAMETER_GAIN:   component->m_Gain   = value; break;
         case dmSound::PARAMETER_PAN:    component->m_Pan    = value; break;
         case dmSound::PARAMETER_SPEED:  component->m_Speed  = value; break;
+        case dmSound::PARAMETER_PRIORITY: component->m_Priority = value; break;
         default:
             return dmGameObject::PROPERTY_RESULT_NOT_FOUND;
         }
@@ -319,6 +323,7 @@ namespace dmGameSystem
                 case dmSound::PARAMETER_GAIN:   v *= entry.m_Sound->m_Gain; break;
                 case dmSound::PARAMETER_PAN:    v += entry.m_Sound->m_Pan; break;
                 case dmSound::PARAMETER_SPEED:  v *= entry.m_Sound->m_Speed; break;
+                case dmSound::PARAMETER_PRIORITY: break;
                 default:
                     return dmGameObject::PROPERTY_RESULT_NOT_FOUND;
                 }
@@ -340,6 +345,7 @@ namespace dmGameSystem
         case dmSound::PARAMETER_GAIN:   value = component->m_Gain; break;
         case dmSound::PARAMETER_PAN:    value = component->m_Pan; break;
         case dmSound::PARAMETER_SPEED:  value = component->m_Speed; break;
+        case dmSound::PARAMETER_PRIORITY: value = component->m_Priority; break;
         default:
             return dmGameObject::PROPERTY_RESULT_NOT_FOUND;
         }
@@ -391,6 +397,7 @@ namespace dmGameSystem
                     dmSound::SetParameter(entry.m_SoundInstance, dmSound::PARAMETER_GAIN, Vectormath::Aos::Vector4(gain, 0, 0, 0));
                     dmSound::SetParameter(entry.m_SoundInstance, dmSound::PARAMETER_PAN, Vectormath::Aos::Vector4(pan, 0, 0, 0));
                     dmSound::SetParameter(entry.m_SoundInstance, dmSound::PARAMETER_SPEED, Vectormath::Aos::Vector4(speed, 0, 0, 0));
+                    dmSound::SetParameter(entry.m_SoundInstance, dmSound::PARAMETER_PRIORITY, Vectormath::Aos::Vector4(component->m_Priority, 0, 0, 0));
                     dmSound::SetLooping(entry.m_SoundInstance, sound->m_Looping, (sound->m_Looping && !sound->m_Loopcount) ? -1 : sound->m_Loopcount ); // loopcounter semantics differ a bit from loopcount. If -1, it means loopforever, otherwise it contains the # of loops remaining.
 
                     entry.m_Listener = params.m_Message->m_Sender;
@@ -463,6 +470,7 @@ namespace dmGameSystem
         if (propertyId == SOUND_PROP_GAIN) return dmSound::PARAMETER_GAIN;
         if (propertyId == SOUND_PROP_PAN) return dmSound::PARAMETER_PAN;
         if (propertyId == SOUND_PROP_SPEED) return dmSound::PARAMETER_SPEED;
+        if (propertyId == SOUND_PROP_PRIORITY) return dmSound::PARAMETER_PRIORITY;
         return dmSound::PARAMETER_MAX;
     }
 
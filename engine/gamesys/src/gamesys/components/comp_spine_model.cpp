@@ -68,6 +68,12 @@ namespace dmGameSystem
         dmRender::HRenderContext    m_RenderContext;
         dmGraphics::HContext        m_GraphicsContext;
         uint32_t                    m_MaxSpineModelCount;
+        /// Distance to the camera beyond which the pose is evaluated less often, 0 disables animation LOD
+        float                       m_AnimationLodDistance;
+        /// Updates per pose evaluation beyond the LOD distance
+        uint32_t                    m_AnimationLodInterval;
+        /// Draw all spine models with the same batch key at the depth of their group, see SubmitGroups
+        uint32_t                    m_GroupBatches : 1;
     };
 
     // Translation table to translate from dmGameObject playback mode into dmRig playback mode.
@@ -95,6 +101,7 @@ namespace dmGameSystem
         dmRig::NewContextParams rig_params = {0};
         rig_params.m_Context = &world->m_RigContext;
         rig_params.m_MaxRigInstanceCount = context->m_MaxSpineModelCount;
+        rig_params.m_JobContext = dmRender::GetJobContext(render_context);
         dmRig::Result rr = dmRig::NewContext(rig_params);
         if (rr != dmRig::RESULT_OK)
         {
@@ -444,18 +451,17 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
-    static void RenderBatch(SpineModelWorld* world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    static void RenderBatch(SpineModelWorld* world, dmRender::HRenderContext render_context, SpineModelComponent** begin, SpineModelComponent** end)
     {
         DM_PROFILE(SpineModel, "RenderBatch");
 
-        SpineModelComponent* first = (SpineModelComponent*) buf[*begin].m_UserData;
+        SpineModelComponent* first = *begin;
         const SpineModelResource* resource = first->m_Resource;
 
         uint32_t vertex_count = 0;
-        for (uint32_t *i=begin;i!=end;i++)
+        for (SpineModelComponent** i=begin;i!=end;i++)
         {
-            const SpineModelComponent* c = (SpineModelComponent*) buf[*i].m_UserData;
-            uint32_t count = dmRig::GetVertexCount(c->m_RigInstance);
+            uint32_t count = dmRig::GetVertexCount((*i)->m_RigInstance);
             vertex_count += count;
         }
 
@@ -463,15 +469,27 @@ namespace dmGameSystem
         if (vertex_buffer.Remaining() < vertex_count)
             vertex_buffer.OffsetCapacity(vertex_count - vertex_buffer.Remaining());
 
-        // Fill in vertex buffer
+        // Fill in vertex buffer, each component writes to its own range so they can be skinned in parallel
         dmRig::RigSpineModelVertex *vb_begin = vertex_buffer.End();
         dmRig::RigSpineModelVertex *vb_end = vb_begin;
-        dmRig::HRigContext rig_context = world->m_RigContext;
-        for (uint32_t *i=begin;i!=end;i++)
+        dmArray<dmRig::RigVertexDataEntry>& entries = world->m_VertexDataEntries;
+        entries.SetSize(0);
+        if (entries.Capacity() < (uint32_t)(end - begin))
+            entries.SetCapacity(end - begin);
+        for (SpineModelComponent** i=begin;i!=end;i++)
         {
-            const SpineModelComponent* c = (SpineModelComponent*) buf[*i].m_UserData;
-            vb_end = (dmRig::RigSpineModelVertex*)dmRig::GenerateVertexData(rig_context, c->m_RigInstance, c->m_World, Matrix4::identity(), Vector4(1.0), dmRig::RIG_VERTEX_FORMAT_SPINE, (void*)vb_end);
+            SpineModelComponent* c = *i;
+            c->m_Rendered = 1;
+            entries.SetSize(entries.Size() + 1);
+            dmRig::RigVertexDataEntry& entry = entries.Back();
+            entry.m_ModelMatrix = c->m_World;
+            entry.m_NormalMatrix = Matrix4::identity();
+            entry.m_Color = Vector4(1.0);
+            entry.m_Instance = c->m_RigInstance;
+            entry.m_VertexDataOut = vb_end;
+            vb_end += dmRig::GetVertexCount(c->m_RigInstance);
         }
+        dmRig::GenerateVertexDataBatch(world->m_RigContext, entries.Begin(), entries.Size(), dmRig::RIG_VERTEX_FORMAT_SPINE);
         vertex_buffer.SetSize(vb_end - vertex_buffer.Begin());
 
         // Ninja in-place writing of render object.
@@ -564,9 +582,38 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
+    // Evaluates the pose of spine models far from the camera less often, and freezes the pose of the ones
+    // that were not drawn since the last update. The camera is taken from the view of the last frame.
+    static void UpdateAnimationLod(SpineModelWorld* world, SpineModelContext* context)
+    {
+        DM_PROFILE(SpineModel, "UpdateAnimationLod");
+
+        const Vector3 camera_position = inverse(dmRender::GetViewMatrix(context->m_RenderContext)).getTranslation();
+        const float lod_distance_sq = context->m_AnimationLodDistance * context->m_AnimationLodDistance;
+
+        dmArray<SpineModelComponent*>& components = world->m_Components.m_Objects;
+        uint32_t n = components.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            SpineModelComponent* c = components[i];
+            if (!c->m_Enabled || !c->m_AddedToUpdate || !dmRig::IsValid(c->m_RigInstance))
+                continue;
+
+            float distance_sq = lengthSqr(c->m_World.getTranslation() - camera_position);
+            dmRig::SetUpdateInterval(c->m_RigInstance, distance_sq > lod_distance_sq ? context->m_AnimationLodInterval : 1);
+            dmRig::SetPoseFrozen(c->m_RigInstance, !c->m_Rendered);
+            c->m_Rendered = 0;
+        }
+    }
+
     dmGameObject::UpdateResult CompSpineModelUpdate(const dmGameObject::ComponentsUpdateParams& params, dmGameObject::ComponentsUpdateResult& update_result)
     {
         SpineModelWorld* world = (SpineModelWorld*)params.m_World;
+        SpineModelContext* context = (SpineModelContext*)params.m_Context;
+
+        if (context->m_AnimationLodDistance > 0.0f) {
+            UpdateAnimationLod(world, context);
+        }
 
         dmRig::Result rig_res = dmRig::Update(world->m_RigContext, params.m_UpdateContext->m_DT);
 
@@ -590,6 +637,7 @@ namespace dmGameSystem
         }
 
         update_result.m_TransformsUpdated = rig_res == dmRig::RESULT_UPDATED_POSE;
+        update_result.m_Changed = rig_res == dmRig::RESULT_UPDATED_POSE;
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
@@ -609,7 +657,15 @@ namespace dmGameSystem
             }
             case dmRender::RENDER_LIST_OPERATION_BATCH:
             {
-                RenderBatch(world, params.m_Context, params.m_Buf, params.m_Begin, params.m_End);
+                dmArray<SpineModelComponent*>& batch = world->m_BatchComponents;
+                batch.SetSize(0);
+                if (batch.Capacity() < (uint32_t)(params.m_End - params.m_Begin))
+                    batch.SetCapacity(params.m_End - params.m_Begin);
+                for (uint32_t* i = params.m_Begin; i != params.m_End; ++i)
+                {
+                    batch.Push((SpineModelComponent*) params.m_Buf[*i].m_UserData);
+                }
+                RenderBatch(world, params.m_Context, batch.Begin(), batch.End());
                 break;
             }
             case dmRender::RENDER_LIST_OPERATION_END:
@@ -625,6 +681,129 @@ namespace dmGameSystem
         }
     }
 
+    // Back to front, as the render list orders the entries
+    struct GroupDepthGreater
+    {
+        GroupDepthGreater(const Matrix4& view_proj) : m_ViewProj(view_proj) {}
+
+        float GetDepth(const SpineModelComponent* c) const
+        {
+            const Vector4 p = m_ViewProj * c->m_World.getCol(3);
+            return p.getZ() / p.getW();
+        }
+
+        bool operator()(const SpineModelComponent* a, const SpineModelComponent* b) const
+        {
+            return GetDepth(a) > GetDepth(b);
+        }
+
+        Matrix4 m_ViewProj;
+    };
+
+    static void GroupRenderListDispatch(dmRender::RenderListDispatchParams const &params)
+    {
+        if (params.m_Operation != dmRender::RENDER_LIST_OPERATION_BATCH)
+        {
+            RenderListDispatch(params);
+            return;
+        }
+
+        SpineModelWorld *world = (SpineModelWorld *) params.m_UserData;
+        dmArray<SpineModelComponent*>& batch = world->m_BatchComponents;
+        batch.SetSize(0);
+        for (uint32_t* i = params.m_Begin; i != params.m_End; ++i)
+        {
+            const SpineModelGroup& group = world->m_Groups[params.m_Buf[*i].m_UserData];
+            if (batch.Remaining() < group.m_Count)
+                batch.OffsetCapacity(group.m_Count - batch.Remaining());
+            for (uint32_t j = 0; j < group.m_Count; ++j)
+            {
+                batch.Push(world->m_GroupComponents[group.m_Begin + j]);
+            }
+        }
+
+        std::sort(batch.Begin(), batch.End(), GroupDepthGreater(dmRender::GetViewProjectionMatrix(params.m_Context)));
+        RenderBatch(world, params.m_Context, batch.Begin(), batch.End());
+    }
+
+    static bool GroupBatchKeyLess(const SpineModelComponent* a, const SpineModelComponent* b)
+    {
+        return a->m_MixedHash < b->m_MixedHash;
+    }
+
+    // Submits one render list entry per batch key, placed at the center of its spine models, instead of one
+    // entry per spine model. The spine models sharing an atlas, material and blend mode are then drawn in a
+    // single draw call, even if other render list entries are between them in depth. Within a group they
+    // are drawn back to front.
+    static void SubmitGroups(SpineModelWorld* world, dmRender::HRenderContext render_context)
+    {
+        DM_PROFILE(SpineModel, "SubmitGroups");
+
+        dmArray<SpineModelComponent*>& components = world->m_Components.m_Objects;
+        const uint32_t count = components.Size();
+
+        dmArray<SpineModelComponent*>& group_components = world->m_GroupComponents;
+        group_components.SetSize(0);
+        if (group_components.Capacity() < count)
+            group_components.SetCapacity(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            SpineModelComponent* component = components[i];
+            if (component->m_DoRender && component->m_Enabled)
+                group_components.Push(component);
+        }
+        std::sort(group_components.Begin(), group_components.End(), GroupBatchKeyLess);
+
+        dmArray<SpineModelGroup>& groups = world->m_Groups;
+        groups.SetSize(0);
+        const uint32_t group_component_count = group_components.Size();
+        for (uint32_t begin = 0; begin < group_component_count; )
+        {
+            uint32_t end = begin + 1;
+            while (end < group_component_count && group_components[end]->m_MixedHash == group_components[begin]->m_MixedHash)
+                ++end;
+
+            if (groups.Full())
+                groups.OffsetCapacity(16);
+            SpineModelGroup group;
+            group.m_Begin = begin;
+            group.m_Count = end - begin;
+            groups.Push(group);
+            begin = end;
+        }
+
+        const uint32_t group_count = groups.Size();
+        dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(render_context, group_count);
+        dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(render_context, &GroupRenderListDispatch, world);
+        dmRender::RenderListEntry* write_ptr = render_list;
+
+        for (uint32_t i = 0; i < group_count; ++i)
+        {
+            const SpineModelGroup& group = groups[i];
+            SpineModelComponent* first = group_components[group.m_Begin];
+
+            Vector3 min_p(FLT_MAX);
+            Vector3 max_p(-FLT_MAX);
+            for (uint32_t j = group.m_Begin; j < group.m_Begin + group.m_Count; ++j)
+            {
+                const Vector3 p = group_components[j]->m_World.getCol3().getXYZ();
+                min_p = minPerElem(min_p, p);
+                max_p = maxPerElem(max_p, p);
+            }
+
+            write_ptr->m_WorldPosition = Point3(0.5f * (min_p + max_p));
+            write_ptr->m_UserData = i;
+            write_ptr->m_BatchKey = first->m_MixedHash;
+            write_ptr->m_TagListKey = dmRender::GetMaterialTagListKey(GetMaterial(first, first->m_Resource));
+            write_ptr->m_Dispatch = dispatch;
+            write_ptr->m_MinorOrder = 0;
+            write_ptr->m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+            ++write_ptr;
+        }
+
+        dmRender::RenderListSubmit(render_context, render_list, write_ptr);
+    }
+
     dmGameObject::UpdateResult CompSpineModelRender(const dmGameObject::ComponentsRenderParams& params)
     {
         SpineModelContext* context = (SpineModelContext*)params.m_Context;
@@ -633,6 +812,12 @@ namespace dmGameSystem
 
         UpdateTransforms(world);
 
+        if (context->m_GroupBatches)
+        {
+            SubmitGroups(world, render_context);
+            return dmGameObject::UPDATE_RESULT_OK;
+        }
+
         dmArray<SpineModelComponent*>& components = world->m_Components.m_Objects;
         const uint32_t count = components.Size();
 
@@ -976,6 +1161,9 @@ namespace dmGameSystem
 
         int32_t max_rig_instance = max_rig_instance = dmConfigFile::GetInt(ctx->m_Config, "rig.max_instance_count", 128);
         spinemodelctx->m_MaxSpineModelCount = dmMath::Max(dmConfigFile::GetInt(ctx->m_Config, "spine.max_count", 128), max_rig_instance);
+        spinemodelctx->m_AnimationLodDistance = dmConfigFile::GetFloat(ctx->m_Config, "spine.animation_lod_distance", 0.0f);
+        spinemodelctx->m_AnimationLodInterval = dmConfigFile::GetInt(ctx->m_Config, "spine.animation_lod_interval", 4);
+        spinemodelctx->m_GroupBatches = dmConfigFile::GetInt(ctx->m_Config, "spine.group_batches", 0) != 0;
 
         // Ideally, we'd like to move this priority a lot earlier
         // We sould be able to avoid doing UpdateTransforms again in the Render() function
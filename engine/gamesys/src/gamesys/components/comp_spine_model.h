@@ -75,6 +75,15 @@ namespace dmGameSystem
         /// Added to update or not
         uint8_t                     m_AddedToUpdate : 1;
         uint8_t                     m_ReHash : 1;
+        /// Drawn since the last update, used by the animation LOD
+        uint8_t                     m_Rendered : 1;
+    };
+
+    // Components with the same batch key, submitted as a single render list entry, see spine.group_batches
+    struct SpineModelGroup
+    {
+        uint32_t                    m_Begin;        // Index into SpineModelWorld::m_GroupComponents
+        uint32_t                    m_Count;
     };
 
     struct SpineModelWorld
@@ -87,6 +96,13 @@ namespace dmGameSystem
         // Temporary scratch array for instances, only used during the creation phase of components
         dmArray<dmGameObject::HInstance>    m_ScratchInstances;
         dmRig::HRigContext                  m_RigContext;
+        // Scratch entries for generating the vertex data of a batch on the job workers
+        dmArray<dmRig::RigVertexDataEntry>  m_VertexDataEntries;
+        // The components of the batch being drawn
+        dmArray<SpineModelComponent*>       m_BatchComponents;
+        // The components drawn this frame sorted by batch key, and their groups. Only used with spine.group_batches
+        dmArray<SpineModelComponent*>       m_GroupComponents;
+        dmArray<SpineModelGroup>            m_Groups;
     };
 
     bool CompSpineModelSetIKTargetInstance(SpineModelComponent* component, dmhash_t constraint_id, float mix, dmhash_t instance_id);
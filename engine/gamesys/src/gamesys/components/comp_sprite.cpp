@@ -16,13 +16,22 @@
 #include <float.h>
 #include <algorithm>
 
+// The quad corners are transformed with SSE2 or NEON when the target always has it, otherwise plain C
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_SPRITE_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define DM_SPRITE_NEON
+    #include <arm_neon.h>
+#endif
+
 #include <dlib/array.h>
 #include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/message.h>
 #include <dlib/profile.h>
 #include <dlib/dstrings.h>
-#include <dlib/object_pool.h>
+#include <dlib/paged_object_pool.h>
 #include <dlib/math.h>
 #include <graphics/graphics.h>
 #include <render/render.h>
@@ -35,6 +44,7 @@
 
 #include <gamesys/sprite_ddf.h>
 #include <gamesys/gamesys_ddf.h>
+#include <dmsdk/gamesys/sprite.h>
 
 using namespace Vectormath::Aos;
 namespace dmGameSystem
@@ -65,6 +75,10 @@ namespace dmGameSystem
         /// Timer in local space: [0,1]
         float                       m_AnimTimer;
         float                       m_PlaybackRate;
+        /// Number of frames of the current animation, m_End - m_Start
+        uint32_t                    m_AnimFrameInterval;
+        /// World transform version of the instance when m_World was last calculated
+        uint32_t                    m_WorldVersion;
         uint16_t                    m_ComponentIndex;
         uint16_t                    m_AnimPingPong : 1;
         uint16_t                    m_AnimBackwards : 1;
@@ -75,7 +89,15 @@ namespace dmGameSystem
         uint16_t                    m_FlipVertical : 1;
         uint16_t                    m_AddedToUpdate : 1;
         uint16_t                    m_ReHash : 1;
-        uint16_t                    m_Padding : 7;
+        uint16_t                    m_DirtyTransform : 1;
+        uint16_t                    m_AnimOnce : 1;
+        /// Flagged with SetSpritesStatic, baked into a static batch when it doesn't animate and has no render constants
+        uint16_t                    m_Static : 1;
+        /// Part of the current static batches, see BakeStaticBatches
+        uint16_t                    m_InStaticBatch : 1;
+        uint16_t                    m_Padding : 3;
+        /// Render layer, see dmRender::SetLayerMask
+        uint8_t                     m_RenderLayer;
     };
 
     struct SpriteVertex
@@ -87,20 +109,85 @@ namespace dmGameSystem
         float v;
     };
 
+    // Same as SpriteVertex, with the texture coordinates as normalized 16 bit integers (sprite.compact_vertices)
+    struct SpriteVertexCompact
+    {
+        float x;
+        float y;
+        float z;
+        uint16_t u;
+        uint16_t v;
+    };
+
+    // Vertex of the static quad used when drawing instanced.
+    // The corner selects which of the four instance texture coordinates to use.
+    struct SpriteQuadVertex
+    {
+        float x;
+        float y;
+        float corner[4];
+    };
+
+    // Per sprite data when drawing instanced. The vertex shader calculates the world position of a quad vertex as
+    //     instance_position + instance_axis_x * position.x + instance_axis_y * position.y
+    // and picks the texture coordinate (u,v) as
+    //     (dot(corner, vec4(instance_uv01.xz, instance_uv23.xz)), dot(corner, vec4(instance_uv01.yw, instance_uv23.yw)))
+    // The texture coordinates are stored in quad vertex order, with flipping already applied.
+    struct SpriteInstance
+    {
+        float position[3];
+        float axis_x[3];
+        float axis_y[3];
+        float uv[4][2];
+    };
+
+    // Static sprites with the same material, texture set, blend mode, render layer and z, drawn from the static buffers
+    struct SpriteStaticBatch
+    {
+        dmRender::RenderObject          m_RenderObject;
+        Point3                          m_Center;
+        Vector3                         m_Extents;
+        uint32_t                        m_BatchKey;
+        uint32_t                        m_TagListKey;
+        uint8_t                         m_RenderLayer;
+    };
+
     struct SpriteWorld
     {
-        dmObjectPool<SpriteComponent>   m_Components;
+        dmPagedObjectPool<SpriteComponent> m_Components;
         dmArray<dmRender::RenderObject> m_RenderObjects;
+        // Indices of the components whose once-animation completed during Animate
+        dmArray<uint32_t>               m_AnimationsDone;
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
+        dmGraphics::HDynamicVertexBuffer m_DynamicVertexBuffer;
+        // The buffer of m_DynamicVertexBuffer used by the current render list dispatch
         dmGraphics::HVertexBuffer       m_VertexBuffer;
-        SpriteVertex*                   m_VertexBufferData;
-        SpriteVertex*                   m_VertexBufferWritePtr;
+        // SpriteVertex or SpriteVertexCompact records, see m_VertexSize
+        uint8_t*                        m_VertexBufferData;
+        uint8_t*                        m_VertexBufferWritePtr;
         dmGraphics::HIndexBuffer        m_IndexBuffer;
         uint8_t*                        m_IndexBufferData;
         uint8_t*                        m_IndexBufferWritePtr;
+        dmGraphics::HVertexDeclaration  m_QuadVertexDeclaration;
+        dmGraphics::HVertexBuffer       m_QuadVertexBuffer;
+        dmGraphics::HIndexBuffer        m_QuadIndexBuffer;
+        dmGraphics::HVertexDeclaration  m_InstanceVertexDeclaration;
+        dmGraphics::HDynamicVertexBuffer m_DynamicInstanceBuffer;
+        dmGraphics::HVertexBuffer       m_InstanceBuffer;
+        SpriteInstance*                 m_InstanceData;
+        SpriteInstance*                 m_InstanceWritePtr;
+        dmArray<SpriteStaticBatch>      m_StaticBatches;
+        dmGraphics::HVertexBuffer       m_StaticVertexBuffer;
+        dmGraphics::HIndexBuffer        m_StaticIndexBuffer;
+        // Number of sprites the vertex, index and instance buffers are allocated for
+        uint32_t                        m_BufferCapacity;
+        uint32_t                        m_VertexSize;
         uint8_t                         m_Is16BitIndex : 1;
         uint8_t                         m_UseGeometries : 1;
         uint8_t                         m_ReallocBuffers : 1;
+        uint8_t                         m_UseInstancing : 1;
+        uint8_t                         m_UseCompactVertices : 1;
+        uint8_t                         m_StaticBatchesDirty : 1;
     };
 
     DM_GAMESYS_PROP_VECTOR3(SPRITE_PROP_SCALE, scale, false);
@@ -108,6 +195,7 @@ namespace dmGameSystem
 
     static const dmhash_t SPRITE_PROP_CURSOR = dmHashString64("cursor");
     static const dmhash_t SPRITE_PROP_PLAYBACK_RATE = dmHashString64("playback_rate");
+    static const dmhash_t SPRITE_PROP_TINT = dmHashString64("tint");
 
     static float GetCursor(SpriteComponent* component);
     static void SetCursor(SpriteComponent* component, float cursor);
@@ -128,17 +216,19 @@ namespace dmGameSystem
     }
 
     static void ReAllocateBuffers(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, uint32_t max_sprite_count, uint32_t num_vertices_per_sprite, uint32_t num_indices_per_sprite) {
-        if (sprite_world->m_VertexBuffer) {
-            dmGraphics::DeleteVertexBuffer(sprite_world->m_VertexBuffer);
-            sprite_world->m_VertexBuffer = 0;
+        {
+            uint32_t memsize = sprite_world->m_VertexSize * num_vertices_per_sprite * max_sprite_count;
+            sprite_world->m_VertexBufferData = (uint8_t*) realloc(sprite_world->m_VertexBufferData, memsize);
         }
 
-        if (sprite_world->m_VertexBuffer == 0)
-            sprite_world->m_VertexBuffer = dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(render_context), 0, 0x0, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+        if (sprite_world->m_UseInstancing)
+        {
+            sprite_world->m_InstanceData = (SpriteInstance*) realloc(sprite_world->m_InstanceData, sizeof(SpriteInstance) * max_sprite_count);
+        }
 
+        if (sprite_world->m_RenderObjects.Capacity() < max_sprite_count)
         {
-            uint32_t memsize = sizeof(SpriteVertex) * num_vertices_per_sprite * max_sprite_count;
-            sprite_world->m_VertexBufferData = (SpriteVertex*) malloc(memsize);
+            sprite_world->m_RenderObjects.SetCapacity(max_sprite_count);
         }
 
         {
@@ -167,27 +257,49 @@ namespace dmGameSystem
             sprite_world->m_IndexBuffer = dmGraphics::NewIndexBuffer(dmRender::GetGraphicsContext(render_context), indices_size, (void*)sprite_world->m_IndexBufferData, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
         }
 
+        sprite_world->m_BufferCapacity = max_sprite_count;
         sprite_world->m_ReallocBuffers = 0;
     }
 
+    static void DeleteStaticBuffers(SpriteWorld* sprite_world)
+    {
+        if (sprite_world->m_StaticVertexBuffer)
+        {
+            dmGraphics::DeleteVertexBuffer(sprite_world->m_StaticVertexBuffer);
+            sprite_world->m_StaticVertexBuffer = 0;
+        }
+        if (sprite_world->m_StaticIndexBuffer)
+        {
+            dmGraphics::DeleteIndexBuffer(sprite_world->m_StaticIndexBuffer);
+            sprite_world->m_StaticIndexBuffer = 0;
+        }
+    }
+
     dmGameObject::CreateResult CompSpriteNewWorld(const dmGameObject::ComponentNewWorldParams& params)
     {
         SpriteContext* sprite_context = (SpriteContext*)params.m_Context;
         dmRender::HRenderContext render_context = sprite_context->m_RenderContext;
         SpriteWorld* sprite_world = new SpriteWorld();
 
+        // The component pages are allocated as sprites are created, the buffers are allocated when rendering, see CompSpriteRender
         sprite_world->m_Components.SetCapacity(sprite_context->m_MaxSpriteCount);
-        memset(sprite_world->m_Components.m_Objects.Begin(), 0, sizeof(SpriteComponent) * sprite_context->m_MaxSpriteCount);
-        sprite_world->m_RenderObjects.SetCapacity(sprite_context->m_MaxSpriteCount);
 
         dmGraphics::VertexElement ve[] =
         {
                 {"position", 0, 3, dmGraphics::TYPE_FLOAT, false},
                 {"texcoord0", 1, 2, dmGraphics::TYPE_FLOAT, false},
         };
+        if (sprite_context->m_CompactVertices)
+        {
+            ve[1].m_Type = dmGraphics::TYPE_UNSIGNED_SHORT;
+            ve[1].m_Normalize = true;
+        }
 
         sprite_world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(dmRender::GetGraphicsContext(render_context), ve, sizeof(ve) / sizeof(dmGraphics::VertexElement));
+        sprite_world->m_UseCompactVertices = sprite_context->m_CompactVertices;
+        sprite_world->m_VertexSize = sprite_context->m_CompactVertices ? sizeof(SpriteVertexCompact) : sizeof(SpriteVertex);
 
+        sprite_world->m_DynamicVertexBuffer = dmGraphics::NewDynamicVertexBuffer(dmRender::GetGraphicsContext(render_context));
         sprite_world->m_VertexBuffer = 0;
         sprite_world->m_VertexBufferData = 0;
         sprite_world->m_IndexBuffer = 0;
@@ -195,6 +307,54 @@ namespace dmGameSystem
 
         sprite_world->m_UseGeometries = 0;
         sprite_world->m_ReallocBuffers = 1;
+        sprite_world->m_UseInstancing = 0;
+        sprite_world->m_QuadVertexDeclaration = 0;
+        sprite_world->m_QuadVertexBuffer = 0;
+        sprite_world->m_QuadIndexBuffer = 0;
+        sprite_world->m_InstanceVertexDeclaration = 0;
+        sprite_world->m_DynamicInstanceBuffer = 0;
+        sprite_world->m_InstanceBuffer = 0;
+        sprite_world->m_InstanceData = 0;
+        sprite_world->m_BufferCapacity = 0;
+        sprite_world->m_StaticVertexBuffer = 0;
+        sprite_world->m_StaticIndexBuffer = 0;
+        sprite_world->m_StaticBatchesDirty = 0;
+
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        if (sprite_context->m_Instancing && dmGraphics::IsInstancingSupported(graphics_context))
+        {
+            dmGraphics::VertexElement quad_ve[] =
+            {
+                    {"position", 0, 2, dmGraphics::TYPE_FLOAT, false},
+                    {"corner", 1, 4, dmGraphics::TYPE_FLOAT, false},
+            };
+            dmGraphics::VertexElement instance_ve[] =
+            {
+                    {"instance_position", 2, 3, dmGraphics::TYPE_FLOAT, false},
+                    {"instance_axis_x", 3, 3, dmGraphics::TYPE_FLOAT, false},
+                    {"instance_axis_y", 4, 3, dmGraphics::TYPE_FLOAT, false},
+                    {"instance_uv01", 5, 4, dmGraphics::TYPE_FLOAT, false},
+                    {"instance_uv23", 6, 4, dmGraphics::TYPE_FLOAT, false},
+            };
+
+            // Same corner order as the vertices in CreateVertexData
+            const SpriteQuadVertex quad[] =
+            {
+                {-0.5f, -0.5f, {1.0f, 0.0f, 0.0f, 0.0f}},
+                {-0.5f,  0.5f, {0.0f, 1.0f, 0.0f, 0.0f}},
+                { 0.5f,  0.5f, {0.0f, 0.0f, 1.0f, 0.0f}},
+                { 0.5f, -0.5f, {0.0f, 0.0f, 0.0f, 1.0f}},
+            };
+            uint16_t quad_indices[6];
+            fillIndices<uint16_t>(quad_indices, 6);
+
+            sprite_world->m_QuadVertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, quad_ve, sizeof(quad_ve) / sizeof(dmGraphics::VertexElement));
+            sprite_world->m_QuadVertexBuffer = dmGraphics::NewVertexBuffer(graphics_context, sizeof(quad), quad, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+            sprite_world->m_QuadIndexBuffer = dmGraphics::NewIndexBuffer(graphics_context, sizeof(quad_indices), quad_indices, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+            sprite_world->m_InstanceVertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, instance_ve, sizeof(instance_ve) / sizeof(dmGraphics::VertexElement));
+            sprite_world->m_DynamicInstanceBuffer = dmGraphics::NewDynamicVertexBuffer(graphics_context);
+            sprite_world->m_UseInstancing = 1;
+        }
 
         *params.m_World = sprite_world;
         return dmGameObject::CREATE_RESULT_OK;
@@ -204,10 +364,21 @@ namespace dmGameSystem
     {
         SpriteWorld* sprite_world = (SpriteWorld*)params.m_World;
         dmGraphics::DeleteVertexDeclaration(sprite_world->m_VertexDeclaration);
-        dmGraphics::DeleteVertexBuffer(sprite_world->m_VertexBuffer);
+        dmGraphics::DeleteDynamicVertexBuffer(sprite_world->m_DynamicVertexBuffer);
         free(sprite_world->m_VertexBufferData);
         dmGraphics::DeleteIndexBuffer(sprite_world->m_IndexBuffer);
         free(sprite_world->m_IndexBufferData);
+        DeleteStaticBuffers(sprite_world);
+
+        if (sprite_world->m_UseInstancing)
+        {
+            dmGraphics::DeleteVertexDeclaration(sprite_world->m_QuadVertexDeclaration);
+            dmGraphics::DeleteVertexBuffer(sprite_world->m_QuadVertexBuffer);
+            dmGraphics::DeleteIndexBuffer(sprite_world->m_QuadIndexBuffer);
+            dmGraphics::DeleteVertexDeclaration(sprite_world->m_InstanceVertexDeclaration);
+            dmGraphics::DeleteDynamicVertexBuffer(sprite_world->m_DynamicInstanceBuffer);
+            free(sprite_world->m_InstanceData);
+        }
 
         delete sprite_world;
         return dmGameObject::CREATE_RESULT_OK;
@@ -240,24 +411,28 @@ namespace dmGameSystem
         return component->m_TextureSet ? component->m_TextureSet : resource->m_TextureSet;
     }
 
-    static void UpdateCurrentAnimationFrame(SpriteComponent* component) {
-        TextureSetResource* texture_set = GetTextureSet(component, component->m_Resource);
-        dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
-        dmGameSystemDDF::TextureSetAnimation* animation_ddf = &texture_set_ddf->m_Animations[component->m_AnimationID];
+    // Caches the playback state of the animation on the component, so that animating doesn't need to look it up
+    static void SetAnimationState(SpriteComponent* component, const dmGameSystemDDF::TextureSetAnimation* animation)
+    {
+        uint32_t playback = animation->m_Playback;
+        component->m_AnimFrameInterval = animation->m_End - animation->m_Start;
+        component->m_AnimPingPong = playback == dmGameSystemDDF::PLAYBACK_ONCE_PINGPONG || playback == dmGameSystemDDF::PLAYBACK_LOOP_PINGPONG;
+        component->m_AnimBackwards = playback == dmGameSystemDDF::PLAYBACK_ONCE_BACKWARD || playback == dmGameSystemDDF::PLAYBACK_LOOP_BACKWARD;
+        component->m_AnimOnce = playback == dmGameSystemDDF::PLAYBACK_ONCE_FORWARD || playback == dmGameSystemDDF::PLAYBACK_ONCE_BACKWARD || playback == dmGameSystemDDF::PLAYBACK_ONCE_PINGPONG;
+    }
 
+    static void UpdateCurrentAnimationFrame(SpriteComponent* component) {
         // Set frame from cursor (tileindex or animframe)
         float t = component->m_AnimTimer;
-        float backwards = (animation_ddf->m_Playback == dmGameSystemDDF::PLAYBACK_ONCE_BACKWARD
-                        || animation_ddf->m_Playback == dmGameSystemDDF::PLAYBACK_LOOP_BACKWARD) ? 1.0f : 0;
+        float backwards = component->m_AnimBackwards ? 1.0f : 0;
 
         // Original: t = backwards ? (1.0f - t) : t;
         // which translates to:
         t = backwards - 2 * t * backwards + t;
 
-        uint32_t interval = animation_ddf->m_End - animation_ddf->m_Start;
+        uint32_t interval = component->m_AnimFrameInterval;
         uint32_t frame_count = interval;
-        if (animation_ddf->m_Playback == dmGameSystemDDF::PLAYBACK_ONCE_PINGPONG
-                || animation_ddf->m_Playback == dmGameSystemDDF::PLAYBACK_LOOP_PINGPONG)
+        if (component->m_AnimPingPong)
         {
             frame_count = dmMath::Max(1u, frame_count * 2 - 2);
         }
@@ -271,7 +446,9 @@ namespace dmGameSystem
 
         if (frame != frame_current)
         {
-            component->m_Size = GetSize(component, texture_set_ddf, component->m_AnimationID);
+            TextureSetResource* texture_set = GetTextureSet(component, component->m_Resource);
+            component->m_Size = GetSize(component, texture_set->m_TextureSet, component->m_AnimationID);
+            component->m_DirtyTransform = 1;
         }
     }
 
@@ -289,10 +466,10 @@ namespace dmGameSystem
                     || animation->m_Playback == dmGameSystemDDF::PLAYBACK_LOOP_PINGPONG)
                 frame_count = dmMath::Max(1u, frame_count * 2 - 2);
             component->m_AnimInvDuration = (float)animation->m_Fps / frame_count;
-            component->m_AnimPingPong = animation->m_Playback == dmGameSystemDDF::PLAYBACK_ONCE_PINGPONG || animation->m_Playback == dmGameSystemDDF::PLAYBACK_LOOP_PINGPONG;
-            component->m_AnimBackwards = animation->m_Playback == dmGameSystemDDF::PLAYBACK_ONCE_BACKWARD || animation->m_Playback == dmGameSystemDDF::PLAYBACK_LOOP_BACKWARD;
+            SetAnimationState(component, animation);
             component->m_Playing = animation->m_Playback != dmGameSystemDDF::PLAYBACK_NONE;
             component->m_Size = GetSize(component, texture_set->m_TextureSet, component->m_AnimationID);
+            component->m_DirtyTransform = 1;
 
             offset = dmMath::Clamp(offset, 0.0f, 1.0f);
             if (animation->m_Playback == dmGameSystemDDF::PLAYBACK_ONCE_BACKWARD || animation->m_Playback == dmGameSystemDDF::PLAYBACK_LOOP_BACKWARD) {
@@ -309,6 +486,9 @@ namespace dmGameSystem
             component->m_Playing = 0;
             component->m_CurrentAnimation = 0x0;
             component->m_CurrentAnimationFrame = 0;
+            // A single frame, so that setting the cursor keeps the frame
+            component->m_AnimFrameInterval = 1;
+            component->m_AnimPingPong = 0;
             dmLogError("Unable to play animation '%s' from texture '%s' since it could not be found.", dmHashReverseSafe64(animation), dmHashReverseSafe64(texture_set->m_TexturePath));
         }
         return anim_id != 0;
@@ -334,6 +514,17 @@ namespace dmGameSystem
         component->m_ReHash = 0;
     }
 
+    // Called before a sprite is changed. A baked static sprite goes back to being drawn dynamically, and the static batches are rebuilt without it
+    static inline void MakeDynamic(SpriteWorld* sprite_world, SpriteComponent* component)
+    {
+        if (component->m_InStaticBatch)
+        {
+            component->m_Static = 0;
+            component->m_InStaticBatch = 0;
+            sprite_world->m_StaticBatchesDirty = 1;
+        }
+    }
+
     dmGameObject::CreateResult CompSpriteCreate(const dmGameObject::ComponentCreateParams& params)
     {
         SpriteWorld* sprite_world = (SpriteWorld*)params.m_World;
@@ -359,6 +550,7 @@ namespace dmGameSystem
         component->m_FunctionRef = 0;
 
         component->m_ReHash = 1;
+        component->m_DirtyTransform = 1;
 
         component->m_Size = Vector3(0.0f, 0.0f, 0.0f);
         component->m_AnimationID = 0;
@@ -378,6 +570,7 @@ namespace dmGameSystem
         SpriteWorld* sprite_world = (SpriteWorld*)params.m_World;
         uint32_t index = *params.m_UserData;
         SpriteComponent* component = &sprite_world->m_Components.Get(index);
+        MakeDynamic(sprite_world, component);
         dmResource::HFactory factory = dmGameObject::GetFactory(params.m_Instance);
         if (component->m_Material) {
             dmResource::Release(factory, component->m_Material);
@@ -394,7 +587,80 @@ namespace dmGameSystem
     }
 
 
-    static void CreateVertexData(SpriteWorld* sprite_world, SpriteVertex** vb_where, uint8_t** ib_where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    static const int g_TexCoordOrder[] = {
+        0,1,2,2,3,0,
+        3,2,1,1,0,3,    //h
+        1,0,3,3,2,1,    //v
+        2,3,0,0,1,2     //hv
+    };
+
+    // Writes the world positions of the quad corners (-0.5,-0.5), (-0.5,0.5), (0.5,0.5) and (0.5,-0.5) to out, four floats per corner.
+    // The corners are col3 -/+ col0/2 -/+ col1/2 of the world matrix, so all four are done with two multiplications and six additions.
+    static inline void TransformQuadCorners(const Matrix4& w, float* out)
+    {
+        const float* m = (const float*) &w;
+#if defined(DM_SPRITE_SSE2)
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 x = _mm_mul_ps(_mm_loadu_ps(m), half);
+        const __m128 y = _mm_mul_ps(_mm_loadu_ps(m + 4), half);
+        const __m128 t = _mm_loadu_ps(m + 12);
+        const __m128 left = _mm_sub_ps(t, x);
+        const __m128 right = _mm_add_ps(t, x);
+        _mm_storeu_ps(out, _mm_sub_ps(left, y));
+        _mm_storeu_ps(out + 4, _mm_add_ps(left, y));
+        _mm_storeu_ps(out + 8, _mm_add_ps(right, y));
+        _mm_storeu_ps(out + 12, _mm_sub_ps(right, y));
+#elif defined(DM_SPRITE_NEON)
+        const float32x4_t x = vmulq_n_f32(vld1q_f32(m), 0.5f);
+        const float32x4_t y = vmulq_n_f32(vld1q_f32(m + 4), 0.5f);
+        const float32x4_t t = vld1q_f32(m + 12);
+        const float32x4_t left = vsubq_f32(t, x);
+        const float32x4_t right = vaddq_f32(t, x);
+        vst1q_f32(out, vsubq_f32(left, y));
+        vst1q_f32(out + 4, vaddq_f32(left, y));
+        vst1q_f32(out + 8, vaddq_f32(right, y));
+        vst1q_f32(out + 12, vsubq_f32(right, y));
+#else
+        for (uint32_t e = 0; e < 4; ++e)
+        {
+            const float x = m[e] * 0.5f;
+            const float y = m[4 + e] * 0.5f;
+            const float left = m[12 + e] - x;
+            const float right = m[12 + e] + x;
+            out[e] = left - y;
+            out[4 + e] = left + y;
+            out[8 + e] = right + y;
+            out[12 + e] = right - y;
+        }
+#endif
+    }
+
+    static inline void SetVertex(SpriteVertex* vertex, const float* p, float u, float v)
+    {
+        vertex->x = p[0];
+        vertex->y = p[1];
+        vertex->z = p[2];
+        vertex->u = u;
+        vertex->v = v;
+    }
+
+    static inline uint16_t PackUnorm16(float f)
+    {
+        return (uint16_t) (dmMath::Clamp(f, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    }
+
+    static inline void SetVertex(SpriteVertexCompact* vertex, const float* p, float u, float v)
+    {
+        vertex->x = p[0];
+        vertex->y = p[1];
+        vertex->z = p[2];
+        vertex->u = PackUnorm16(u);
+        vertex->v = PackUnorm16(v);
+    }
+
+    // Indices are written relative to vb_base. Quad sprites don't write any indices, the index buffer is filled up front with fillIndices
+    template <typename Vertex>
+    static void CreateVertexData(SpriteWorld* sprite_world, Vertex* vb_base, Vertex** vb_where, uint8_t** ib_where, bool is_16bit_index, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
     {
         DM_PROFILE(Sprite, "CreateVertexData");
 
@@ -402,17 +668,17 @@ namespace dmGameSystem
         dmGameSystemDDF::TextureSetAnimation* animations = texture_set_ddf->m_Animations.m_Data;
         uint32_t* frame_indices = texture_set_ddf->m_FrameIndices.m_Data;
 
-        SpriteVertex*   vertices = *vb_where;
+        Vertex*         vertices = *vb_where;
         uint8_t*        indices = *ib_where;
 
-        uint32_t index_type_size = sprite_world->m_Is16BitIndex ? sizeof(uint16_t) : sizeof(uint32_t);
+        uint32_t index_type_size = is_16bit_index ? sizeof(uint16_t) : sizeof(uint32_t);
 
         if (sprite_world->m_UseGeometries)
         {
             const dmGameSystemDDF::SpriteGeometry* geometries = texture_set_ddf->m_Geometries.m_Data;
 
             // The offset for the indices
-            uint32_t vertex_offset = *vb_where - sprite_world->m_VertexBufferData;
+            uint32_t vertex_offset = *vb_where - vb_base;
 
             for (uint32_t* i = begin; i != end; ++i)
             {
@@ -424,7 +690,7 @@ namespace dmGameSystem
 
                 const dmGameSystemDDF::SpriteGeometry* geometry = &geometries[frame_index];
 
-                const Matrix4& w = component->m_World;
+                const float* w = (const float*) &component->m_World;
 
                 uint32_t num_points = geometry->m_Vertices.m_Count / 2;
 
@@ -448,20 +714,18 @@ namespace dmGameSystem
                 {
                     float x = points[0] * scaleX; // range -0.5,+0.5
                     float y = points[1] * scaleY;
-                    float u = uvs[0];
-                    float v = uvs[1];
-
-                    Vector4 p0 = w * Point3(x, y, 0.0f);
-                    vertices[0].x = ((float*)&p0)[0];
-                    vertices[0].y = ((float*)&p0)[1];
-                    vertices[0].z = ((float*)&p0)[2];
-                    vertices[0].u = u;
-                    vertices[0].v = v;
+
+                    // The points are in the z=0 plane, the third column of the world matrix doesn't contribute
+                    float p[3];
+                    p[0] = w[12] + w[0] * x + w[4] * y;
+                    p[1] = w[13] + w[1] * x + w[5] * y;
+                    p[2] = w[14] + w[2] * x + w[6] * y;
+                    SetVertex(vertices, p, uvs[0], uvs[1]);
                 }
 
                 uint32_t index_count = geometry->m_Indices.m_Count;
                 uint32_t* geom_indices = geometry->m_Indices.m_Data;
-                if (sprite_world->m_Is16BitIndex)
+                if (is_16bit_index)
                 {
                     for (uint32_t index = 0; index < index_count; ++index)
                     {
@@ -481,13 +745,6 @@ namespace dmGameSystem
         }
         else // original path using quads
         {
-            static int tex_coord_order[] = {
-                0,1,2,2,3,0,
-                3,2,1,1,0,3,    //h
-                1,0,3,3,2,1,    //v
-                2,3,0,0,1,2     //hv
-            };
-
             const float* tex_coords = (const float*) texture_set->m_TextureSet->m_TexCoords.m_Data;
 
             for (uint32_t *i = begin;i != end; ++i)
@@ -511,37 +768,15 @@ namespace dmGameSystem
                     flip_flag |= 2;
                 }
 
-                const int* tex_lookup = &tex_coord_order[flip_flag * 6];
-
-                const Matrix4& w = component->m_World;
-
-                Vector4 p0 = w * Point3(-0.5f, -0.5f, 0.0f);
-                vertices[0].x = p0.getX();
-                vertices[0].y = p0.getY();
-                vertices[0].z = p0.getZ();
-                vertices[0].u = tc[tex_lookup[0] * 2];
-                vertices[0].v = tc[tex_lookup[0] * 2 + 1];
-
-                Vector4 p1 = w * Point3(-0.5f, 0.5f, 0.0f);
-                vertices[1].x = p1.getX();
-                vertices[1].y = p1.getY();
-                vertices[1].z = p1.getZ();
-                vertices[1].u = tc[tex_lookup[1] * 2];
-                vertices[1].v = tc[tex_lookup[1] * 2 + 1];
-
-                Vector4 p2 = w * Point3(0.5f, 0.5f, 0.0f);
-                vertices[2].x = p2.getX();
-                vertices[2].y = p2.getY();
-                vertices[2].z = p2.getZ();
-                vertices[2].u = tc[tex_lookup[2] * 2];
-                vertices[2].v = tc[tex_lookup[2] * 2 + 1];
-
-                Vector4 p3 = w * Point3(0.5f, -0.5f, 0.0f);
-                vertices[3].x = p3.getX();
-                vertices[3].y = p3.getY();
-                vertices[3].z = p3.getZ();
-                vertices[3].u = tc[tex_lookup[4] * 2];
-                vertices[3].v = tc[tex_lookup[4] * 2 + 1];
+                const int* tex_lookup = &g_TexCoordOrder[flip_flag * 6];
+
+                float p[16];
+                TransformQuadCorners(component->m_World, p);
+
+                SetVertex(&vertices[0], p,      tc[tex_lookup[0] * 2], tc[tex_lookup[0] * 2 + 1]);
+                SetVertex(&vertices[1], p + 4,  tc[tex_lookup[1] * 2], tc[tex_lookup[1] * 2 + 1]);
+                SetVertex(&vertices[2], p + 8,  tc[tex_lookup[2] * 2], tc[tex_lookup[2] * 2 + 1]);
+                SetVertex(&vertices[3], p + 12, tc[tex_lookup[4] * 2], tc[tex_lookup[4] * 2 + 1]);
 
                 // for (int f = 0; f < 4; ++f)
                 //     printf("  %u: %.2f, %.2f\t%.2f, %.2f\n", f, vertices[f].x, vertices[f].y, vertices[f].u, vertices[f].v );
@@ -555,76 +790,83 @@ namespace dmGameSystem
         *ib_where = indices;
     }
 
-    static void RenderBatch(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    static void CreateInstanceData(SpriteWorld* sprite_world, SpriteInstance** where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
     {
-        DM_PROFILE(Sprite, "RenderBatch");
-
-        const SpriteComponent* first = (SpriteComponent*) buf[*begin].m_UserData;
-        assert(first->m_Enabled);
+        DM_PROFILE(Sprite, "CreateInstanceData");
 
-        SpriteResource* resource = first->m_Resource;
-        TextureSetResource* texture_set = GetTextureSet(first, resource);
-
-        // Ninja in-place writing of render object.
-        dmRender::RenderObject& ro = *sprite_world->m_RenderObjects.End();
-        sprite_world->m_RenderObjects.SetSize(sprite_world->m_RenderObjects.Size()+1);
-
-        // Fill in vertex buffer
-        SpriteVertex* vb_begin = sprite_world->m_VertexBufferWritePtr;
-        uint8_t* ib_begin = (uint8_t*)sprite_world->m_IndexBufferWritePtr;
-        SpriteVertex* vb_iter = vb_begin;
-        uint8_t* ib_iter = ib_begin;
-        CreateVertexData(sprite_world, &vb_iter, &ib_iter, texture_set, buf, begin, end);
-
-        sprite_world->m_VertexBufferWritePtr = vb_iter;
-        sprite_world->m_IndexBufferWritePtr = ib_iter;
-
-        ro.Init();
-        ro.m_VertexDeclaration = sprite_world->m_VertexDeclaration;
-        ro.m_VertexBuffer = sprite_world->m_VertexBuffer;
-        ro.m_IndexBuffer = sprite_world->m_IndexBuffer;
-        ro.m_Material = GetMaterial(first, resource);
-        ro.m_Textures[0] = texture_set->m_Texture;
-        ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
-        ro.m_IndexType = sprite_world->m_Is16BitIndex ? dmGraphics::TYPE_UNSIGNED_SHORT : dmGraphics::TYPE_UNSIGNED_INT;
+        dmGameSystemDDF::TextureSetAnimation* animations = texture_set->m_TextureSet->m_Animations.m_Data;
+        const float* tex_coords = (const float*) texture_set->m_TextureSet->m_TexCoords.m_Data;
 
-        // offset in bytes into element buffer
-        uint32_t index_offset = ib_begin - sprite_world->m_IndexBufferData;
+        SpriteInstance* instance = *where;
+        for (uint32_t *i = begin;i != end; ++i, ++instance)
+        {
+            const SpriteComponent* component = (SpriteComponent*) buf[*i].m_UserData;
 
-        // num elements = Number of bytes / sizeof(index_type)
-        uint32_t index_type_size = sprite_world->m_Is16BitIndex ? sizeof(uint16_t) : sizeof(uint32_t);
-        uint32_t num_elements = ((uint8_t*)sprite_world->m_IndexBufferWritePtr - (uint8_t*)ib_begin) / index_type_size;
+            dmGameSystemDDF::TextureSetAnimation* animation_ddf = &animations[component->m_AnimationID];
 
-        // // These should be named "element" or "index" (as opposed to vertex)
-        ro.m_VertexStart = index_offset;
-        ro.m_VertexCount = num_elements;
+            uint32_t frame_index = animation_ddf->m_Start + component->m_CurrentAnimationFrame;
+            const float* tc = &tex_coords[frame_index * 4 * 2];
+            uint32_t flip_flag = 0;
+            if (animation_ddf->m_FlipHorizontal ^ component->m_FlipHorizontal)
+            {
+                flip_flag = 1;
+            }
+            if (animation_ddf->m_FlipVertical ^ component->m_FlipVertical)
+            {
+                flip_flag |= 2;
+            }
 
-        if (first->m_RenderConstants) {
-            dmGameSystem::EnableRenderObjectConstants(&ro, first->m_RenderConstants);
+            const int* tex_lookup = &g_TexCoordOrder[flip_flag * 6];
+
+            const Matrix4& w = component->m_World;
+            const Vector4 axis_x = w.getCol0();
+            const Vector4 axis_y = w.getCol1();
+            const Vector4 position = w.getCol3();
+            instance->position[0] = position.getX();
+            instance->position[1] = position.getY();
+            instance->position[2] = position.getZ();
+            instance->axis_x[0] = axis_x.getX();
+            instance->axis_x[1] = axis_x.getY();
+            instance->axis_x[2] = axis_x.getZ();
+            instance->axis_y[0] = axis_y.getX();
+            instance->axis_y[1] = axis_y.getY();
+            instance->axis_y[2] = axis_y.getZ();
+
+            // Same lookup as the four vertices in CreateVertexData
+            const int corners[4] = { tex_lookup[0], tex_lookup[1], tex_lookup[2], tex_lookup[4] };
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                instance->uv[c][0] = tc[corners[c] * 2];
+                instance->uv[c][1] = tc[corners[c] * 2 + 1];
+            }
         }
 
-        dmGameSystemDDF::SpriteDesc::BlendMode blend_mode = resource->m_DDF->m_BlendMode;
+        *where = instance;
+    }
+
+    static void SetBlendFactors(dmRender::RenderObject* ro, dmGameSystemDDF::SpriteDesc::BlendMode blend_mode)
+    {
         switch (blend_mode)
         {
             case dmGameSystemDDF::SpriteDesc::BLEND_MODE_ALPHA:
-                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
-                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                ro->m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                ro->m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
             break;
 
             case dmGameSystemDDF::SpriteDesc::BLEND_MODE_ADD:
             case dmGameSystemDDF::SpriteDesc::BLEND_MODE_ADD_ALPHA:
-                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
-                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                ro->m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                ro->m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
             break;
 
             case dmGameSystemDDF::SpriteDesc::BLEND_MODE_MULT:
-                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_DST_COLOR;
-                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                ro->m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_DST_COLOR;
+                ro->m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
             break;
 
             case dmGameSystemDDF::SpriteDesc::BLEND_MODE_SCREEN:
-                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_DST_COLOR;
-                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                ro->m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_DST_COLOR;
+                ro->m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
             break;
 
             default:
@@ -633,7 +875,85 @@ namespace dmGameSystem
             break;
         }
 
-        ro.m_SetBlendFactors = 1;
+        ro->m_SetBlendFactors = 1;
+    }
+
+    static void RenderBatch(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(Sprite, "RenderBatch");
+
+        const SpriteComponent* first = (SpriteComponent*) buf[*begin].m_UserData;
+        assert(first->m_Enabled);
+
+        SpriteResource* resource = first->m_Resource;
+        TextureSetResource* texture_set = GetTextureSet(first, resource);
+
+        // Ninja in-place writing of render object.
+        dmRender::RenderObject& ro = *sprite_world->m_RenderObjects.End();
+        sprite_world->m_RenderObjects.SetSize(sprite_world->m_RenderObjects.Size()+1);
+
+        ro.Init();
+        ro.m_Material = GetMaterial(first, resource);
+        ro.m_Textures[0] = texture_set->m_Texture;
+        ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
+
+        if (sprite_world->m_UseInstancing && !sprite_world->m_UseGeometries)
+        {
+            SpriteInstance* instance_begin = sprite_world->m_InstanceWritePtr;
+            CreateInstanceData(sprite_world, &sprite_world->m_InstanceWritePtr, texture_set, buf, begin, end);
+
+            ro.m_VertexDeclaration = sprite_world->m_QuadVertexDeclaration;
+            ro.m_VertexBuffer = sprite_world->m_QuadVertexBuffer;
+            ro.m_IndexBuffer = sprite_world->m_QuadIndexBuffer;
+            ro.m_IndexType = dmGraphics::TYPE_UNSIGNED_SHORT;
+            ro.m_VertexStart = 0;
+            ro.m_VertexCount = 6;
+            ro.m_InstanceVertexDeclaration = sprite_world->m_InstanceVertexDeclaration;
+            ro.m_InstanceVertexBuffer = sprite_world->m_InstanceBuffer;
+            ro.m_InstanceStart = instance_begin - sprite_world->m_InstanceData;
+            ro.m_InstanceCount = sprite_world->m_InstanceWritePtr - instance_begin;
+        }
+        else
+        {
+            // Fill in vertex buffer
+            uint8_t* ib_begin = (uint8_t*)sprite_world->m_IndexBufferWritePtr;
+            uint8_t* ib_iter = ib_begin;
+            if (sprite_world->m_UseCompactVertices)
+            {
+                SpriteVertexCompact* vb_iter = (SpriteVertexCompact*) sprite_world->m_VertexBufferWritePtr;
+                CreateVertexData(sprite_world, (SpriteVertexCompact*) sprite_world->m_VertexBufferData, &vb_iter, &ib_iter, sprite_world->m_Is16BitIndex, texture_set, buf, begin, end);
+                sprite_world->m_VertexBufferWritePtr = (uint8_t*) vb_iter;
+            }
+            else
+            {
+                SpriteVertex* vb_iter = (SpriteVertex*) sprite_world->m_VertexBufferWritePtr;
+                CreateVertexData(sprite_world, (SpriteVertex*) sprite_world->m_VertexBufferData, &vb_iter, &ib_iter, sprite_world->m_Is16BitIndex, texture_set, buf, begin, end);
+                sprite_world->m_VertexBufferWritePtr = (uint8_t*) vb_iter;
+            }
+            sprite_world->m_IndexBufferWritePtr = ib_iter;
+
+            ro.m_VertexDeclaration = sprite_world->m_VertexDeclaration;
+            ro.m_VertexBuffer = sprite_world->m_VertexBuffer;
+            ro.m_IndexBuffer = sprite_world->m_IndexBuffer;
+            ro.m_IndexType = sprite_world->m_Is16BitIndex ? dmGraphics::TYPE_UNSIGNED_SHORT : dmGraphics::TYPE_UNSIGNED_INT;
+
+            // offset in bytes into element buffer
+            uint32_t index_offset = ib_begin - sprite_world->m_IndexBufferData;
+
+            // num elements = Number of bytes / sizeof(index_type)
+            uint32_t index_type_size = sprite_world->m_Is16BitIndex ? sizeof(uint16_t) : sizeof(uint32_t);
+            uint32_t num_elements = ((uint8_t*)sprite_world->m_IndexBufferWritePtr - (uint8_t*)ib_begin) / index_type_size;
+
+            // // These should be named "element" or "index" (as opposed to vertex)
+            ro.m_VertexStart = index_offset;
+            ro.m_VertexCount = num_elements;
+        }
+
+        if (first->m_RenderConstants) {
+            dmGameSystem::EnableRenderObjectConstants(&ro, first->m_RenderConstants);
+        }
+
+        SetBlendFactors(&ro, resource->m_DDF->m_BlendMode);
 
         dmRender::AddToRender(render_context, &ro);
     }
@@ -642,21 +962,29 @@ namespace dmGameSystem
     {
         DM_PROFILE(Sprite, "UpdateTransforms");
 
-        dmArray<SpriteComponent>& components = sprite_world->m_Components.m_Objects;
+        dmPagedObjectPool<SpriteComponent>& components = sprite_world->m_Components;
         uint32_t n = components.Size();
 
         bool scale_along_z = false;
         if (n > 0) {
-            SpriteComponent* c = &components[0];
+            SpriteComponent* c = &components.GetPhysical(0);
             scale_along_z = dmGameObject::ScaleAlongZ(dmGameObject::GetCollection(c->m_Instance));
         }
 
         // Note: We update all sprites, even though they might be disabled, or not added to update
+        // Sprites whose instance world transform and own size/scale are unchanged since the
+        // last update keep their world matrix (the sub pixel rounding below is idempotent)
 
         if (scale_along_z) {
             for (uint32_t i = 0; i < n; ++i)
             {
-                SpriteComponent* c = &components[i];
+                SpriteComponent* c = &components.GetPhysical(i);
+                uint32_t version = dmGameObject::GetWorldTransformVersion(c->m_Instance);
+                if (!c->m_DirtyTransform && c->m_WorldVersion == version)
+                    continue;
+                c->m_WorldVersion = version;
+                c->m_DirtyTransform = 0;
+                MakeDynamic(sprite_world, c);
                 Matrix4 local = dmTransform::ToMatrix4(dmTransform::Transform(c->m_Position, c->m_Rotation, 1.0f));
                 Matrix4 world = dmGameObject::GetWorldMatrix(c->m_Instance);
                 Vector3 size( c->m_Size.getX() * c->m_Scale.getX(), c->m_Size.getY() * c->m_Scale.getY(), 1);
@@ -666,7 +994,13 @@ namespace dmGameSystem
         {
             for (uint32_t i = 0; i < n; ++i)
             {
-                SpriteComponent* c = &components[i];
+                SpriteComponent* c = &components.GetPhysical(i);
+                uint32_t version = dmGameObject::GetWorldTransformVersion(c->m_Instance);
+                if (!c->m_DirtyTransform && c->m_WorldVersion == version)
+                    continue;
+                c->m_WorldVersion = version;
+                c->m_DirtyTransform = 0;
+                MakeDynamic(sprite_world, c);
                 Matrix4 local = dmTransform::ToMatrix4(dmTransform::Transform(c->m_Position, c->m_Rotation, 1.0f));
                 Matrix4 world = dmGameObject::GetWorldMatrix(c->m_Instance);
                 Matrix4 w = dmTransform::MulNoScaleZ(world, local);
@@ -678,7 +1012,7 @@ namespace dmGameSystem
         // The "sub_pixels" is set by default
         if (!sub_pixels) {
             for (uint32_t i = 0; i < n; ++i) {
-                SpriteComponent* c = &components[i];
+                SpriteComponent* c = &components.GetPhysical(i);
                 Vector4 position = c->m_World.getCol3();
                 position.setX((int) position.getX());
                 position.setY((int) position.getY());
@@ -708,123 +1042,116 @@ namespace dmGameSystem
     {
         DM_PROFILE(Sprite, "PostMessages");
 
-        dmArray<SpriteComponent>& components = sprite_world->m_Components.m_Objects;
-        uint32_t n = components.Size();
+        // Only the components whose once-animation completed, see Animate
+        dmPagedObjectPool<SpriteComponent>& components = sprite_world->m_Components;
+        dmArray<uint32_t>& done = sprite_world->m_AnimationsDone;
+        uint32_t n = done.Size();
         for (uint32_t i = 0; i < n; ++i)
         {
-            SpriteComponent* component = &components[i];
-            // NOTE: texture_set = c->m_Resource might be NULL so it's essential to "continue" here
-            if (!component->m_Enabled || !component->m_Playing)
-                continue;
-
-            TextureSetResource* texture_set = GetTextureSet(component, component->m_Resource);
-            dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
-            dmGameSystemDDF::TextureSetAnimation* animation_ddf = &texture_set_ddf->m_Animations[component->m_AnimationID];
-
-            bool once = animation_ddf->m_Playback == dmGameSystemDDF::PLAYBACK_ONCE_FORWARD
-                    || animation_ddf->m_Playback == dmGameSystemDDF::PLAYBACK_ONCE_BACKWARD
-                    || animation_ddf->m_Playback == dmGameSystemDDF::PLAYBACK_ONCE_PINGPONG;
+            SpriteComponent* component = &components.GetPhysical(done[i]);
             // Stop once-animation and broadcast animation_done
-            if (once && component->m_AnimTimer >= 1.0f)
+            component->m_Playing = 0;
+            if (component->m_Listener.m_Fragment != 0x0)
             {
-                component->m_Playing = 0;
-                if (component->m_Listener.m_Fragment != 0x0)
+                dmMessage::URL sender;
+                if (!GetSender(component, &sender))
                 {
-                    dmMessage::URL sender;
-                    if (!GetSender(component, &sender))
-                    {
-                        dmLogError("Could not send animation_done to listener.");
-                        return;
-                    }
+                    dmLogError("Could not send animation_done to listener.");
+                    return;
+                }
 
-                    dmhash_t message_id = dmGameSystemDDF::AnimationDone::m_DDFDescriptor->m_NameHash;
-                    dmGameSystemDDF::AnimationDone message;
-                    // Engine has 0-based indices, scripts use 1-based
-                    message.m_CurrentTile = component->m_CurrentAnimationFrame + 1;
-                    message.m_Id = component->m_CurrentAnimation;
+                dmhash_t message_id = dmGameSystemDDF::AnimationDone::m_DDFDescriptor->m_NameHash;
+                dmGameSystemDDF::AnimationDone message;
+                // Engine has 0-based indices, scripts use 1-based
+                message.m_CurrentTile = component->m_CurrentAnimationFrame + 1;
+                message.m_Id = component->m_CurrentAnimation;
 
-                    dmGameObject::HInstance listener_instance = dmGameObject::GetInstanceFromIdentifier(dmGameObject::GetCollection(component->m_Instance), component->m_Listener.m_Path);
-                    if (!listener_instance)
-                    {
-                        dmLogError("Could not send animation_done to instance: %s#%s", dmHashReverseSafe64(component->m_Listener.m_Path), dmHashReverseSafe64(component->m_Listener.m_Fragment));
-                        return;
-                    }
+                dmGameObject::HInstance listener_instance = dmGameObject::GetInstanceFromIdentifier(dmGameObject::GetCollection(component->m_Instance), component->m_Listener.m_Path);
+                if (!listener_instance)
+                {
+                    dmLogError("Could not send animation_done to instance: %s#%s", dmHashReverseSafe64(component->m_Listener.m_Path), dmHashReverseSafe64(component->m_Listener.m_Fragment));
+                    return;
+                }
 
-                    dmMessage::URL receiver = component->m_Listener;
-                    sender.m_Socket = dmGameObject::GetMessageSocket(dmGameObject::GetCollection(component->m_Instance));
-                    if (dmMessage::IsSocketValid(receiver.m_Socket) && dmMessage::IsSocketValid(sender.m_Socket))
+                dmMessage::URL receiver = component->m_Listener;
+                sender.m_Socket = dmGameObject::GetMessageSocket(dmGameObject::GetCollection(component->m_Instance));
+                if (dmMessage::IsSocketValid(receiver.m_Socket) && dmMessage::IsSocketValid(sender.m_Socket))
+                {
+                    dmGameObject::Result go_result = dmGameObject::GetComponentId(component->m_Instance, component->m_ComponentIndex, &sender.m_Fragment);
+                    if (go_result == dmGameObject::RESULT_OK)
                     {
-                        dmGameObject::Result go_result = dmGameObject::GetComponentId(component->m_Instance, component->m_ComponentIndex, &sender.m_Fragment);
-                        if (go_result == dmGameObject::RESULT_OK)
-                        {
-                            sender.m_Path = dmGameObject::GetIdentifier(component->m_Instance);
-                            uintptr_t descriptor = (uintptr_t)dmGameSystemDDF::AnimationDone::m_DDFDescriptor;
-                            uint32_t data_size = sizeof(dmGameSystemDDF::AnimationDone);
-                            dmMessage::Result result = dmMessage::Post(&sender, &receiver, message_id, 0, component->m_FunctionRef, descriptor, &message, data_size, 0);
-                            dmMessage::ResetURL(&component->m_Listener);
-                            if (result != dmMessage::RESULT_OK)
-                            {
-                                dmLogError("Could not send animation_done to listener.");
-                            }
-                        }
-                        else
+                        sender.m_Path = dmGameObject::GetIdentifier(component->m_Instance);
+                        uintptr_t descriptor = (uintptr_t)dmGameSystemDDF::AnimationDone::m_DDFDescriptor;
+                        uint32_t data_size = sizeof(dmGameSystemDDF::AnimationDone);
+                        dmMessage::Result result = dmMessage::Post(&sender, &receiver, message_id, 0, component->m_FunctionRef, descriptor, &message, data_size, 0);
+                        dmMessage::ResetURL(&component->m_Listener);
+                        if (result != dmMessage::RESULT_OK)
                         {
-                            dmLogError("Could not send animation_done to listener because of incomplete component.");
+                            dmLogError("Could not send animation_done to listener.");
                         }
                     }
                     else
                     {
-                        dmMessage::ResetURL(&component->m_Listener);
+                        dmLogError("Could not send animation_done to listener because of incomplete component.");
                     }
                 }
+                else
+                {
+                    dmMessage::ResetURL(&component->m_Listener);
+                }
             }
         }
     }
 
 
-    static void Animate(SpriteWorld* sprite_world, float dt)
+    // Returns true if any sprite changed frame
+    static bool Animate(SpriteWorld* sprite_world, float dt)
     {
         DM_PROFILE(Sprite, "Animate");
 
-        dmArray<SpriteComponent>& components = sprite_world->m_Components.m_Objects;
+        bool changed = false;
+        dmPagedObjectPool<SpriteComponent>& components = sprite_world->m_Components;
+        dmArray<uint32_t>& done = sprite_world->m_AnimationsDone;
+        done.SetSize(0);
         uint32_t n = components.Size();
+        if (done.Capacity() < n)
+        {
+            done.SetCapacity(components.AllocatedCapacity());
+        }
         for (uint32_t i = 0; i < n; ++i)
         {
-            SpriteComponent* component = &components[i];
+            SpriteComponent* component = &components.GetPhysical(i);
             // NOTE: texture_set = c->m_Resource might be NULL so it's essential to "continue" here
-            if (!component->m_Enabled)
+            if (!component->m_Enabled || component->m_InStaticBatch)
                 continue;
 
-            if (component->m_Playing && component->m_AddedToUpdate)
+            // The playback state is cached on the component, the texture set is only read when the frame changes
+            if (component->m_Playing)
             {
-                TextureSetResource* texture_set = GetTextureSet(component, component->m_Resource);
-                dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
-                dmGameSystemDDF::TextureSetAnimation* animation_ddf = &texture_set_ddf->m_Animations[component->m_AnimationID];
-
-                // Animate
-                component->m_AnimTimer += dt * component->m_AnimInvDuration * component->m_PlaybackRate;
-                if (component->m_AnimTimer >= 1.0f)
+                if (component->m_AddedToUpdate)
                 {
-                    switch (animation_ddf->m_Playback)
+                    component->m_AnimTimer += dt * component->m_AnimInvDuration * component->m_PlaybackRate;
+                    if (component->m_AnimTimer >= 1.0f)
                     {
-                        case dmGameSystemDDF::PLAYBACK_ONCE_FORWARD:
-                        case dmGameSystemDDF::PLAYBACK_ONCE_BACKWARD:
-                        case dmGameSystemDDF::PLAYBACK_ONCE_PINGPONG:
+                        if (component->m_AnimOnce)
                             component->m_AnimTimer = 1.0f;
-                            break;
-                        default:
+                        else
                             component->m_AnimTimer -= floorf(component->m_AnimTimer);
-                            break;
                     }
+                    component->m_DoTick = 1;
                 }
-                component->m_DoTick = 1;
+
+                if (component->m_AnimOnce && component->m_AnimTimer >= 1.0f)
+                    done.Push(i);
             }
 
             if (component->m_DoTick) {
                 component->m_DoTick = 0;
                 UpdateCurrentAnimationFrame(component);
+                changed = true;
             }
         }
+        return changed;
     }
 
     dmGameObject::CreateResult CompSpriteAddToUpdate(const dmGameObject::ComponentAddToUpdateParams& params) {
@@ -832,6 +1159,7 @@ namespace dmGameSystem
         uint32_t index = (uint32_t)*params.m_UserData;
         SpriteComponent* component = &sprite_world->m_Components.Get(index);
         component->m_AddedToUpdate = true;
+        sprite_world->m_StaticBatchesDirty |= component->m_Static;
         return dmGameObject::CREATE_RESULT_OK;
     }
 
@@ -844,7 +1172,7 @@ namespace dmGameSystem
          */
 
         SpriteWorld* world = (SpriteWorld*)params.m_World;
-        Animate(world, params.m_UpdateContext->m_DT);
+        update_result.m_Changed = Animate(world, params.m_UpdateContext->m_DT);
 
         PostMessages(world);
         return dmGameObject::UPDATE_RESULT_OK;
@@ -859,20 +1187,36 @@ namespace dmGameSystem
             case dmRender::RENDER_LIST_OPERATION_BEGIN:
                 world->m_VertexBufferWritePtr = world->m_VertexBufferData;
                 world->m_IndexBufferWritePtr = world->m_IndexBufferData;
+                world->m_InstanceWritePtr = world->m_InstanceData;
                 world->m_RenderObjects.SetSize(0);
+                world->m_VertexBuffer = dmGraphics::AcquireDynamicVertexBuffer(world->m_DynamicVertexBuffer);
+                if (world->m_UseInstancing)
+                {
+                    world->m_InstanceBuffer = dmGraphics::AcquireDynamicVertexBuffer(world->m_DynamicInstanceBuffer);
+                }
                 break;
             case dmRender::RENDER_LIST_OPERATION_END:
                 {
-                    uint32_t vertex_size = sizeof(SpriteVertex) * (world->m_VertexBufferWritePtr - world->m_VertexBufferData);
+                    uint32_t vertex_size = world->m_VertexBufferWritePtr - world->m_VertexBufferData;
                     if (vertex_size)
                     {
-                        dmGraphics::SetVertexBufferData(world->m_VertexBuffer, vertex_size,
-                                                        world->m_VertexBufferData, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+                        dmGraphics::SetDynamicVertexBufferData(world->m_DynamicVertexBuffer, vertex_size, world->m_VertexBufferData);
 
                         DM_COUNTER("SpriteVertexBuffer", vertex_size);
                     }
                 }
 
+                if (world->m_UseInstancing)
+                {
+                    uint32_t instance_size = sizeof(SpriteInstance) * (world->m_InstanceWritePtr - world->m_InstanceData);
+                    if (instance_size)
+                    {
+                        dmGraphics::SetDynamicVertexBufferData(world->m_DynamicInstanceBuffer, instance_size, world->m_InstanceData);
+
+                        DM_COUNTER("SpriteInstanceBuffer", instance_size);
+                    }
+                }
+
                 if (world->m_UseGeometries)
                 {
                     uint32_t index_size = (world->m_IndexBufferWritePtr - world->m_IndexBufferData);
@@ -889,6 +1233,204 @@ namespace dmGameSystem
         }
     }
 
+    static void RenderListVisibility(dmRender::RenderListVisibilityParams const &params)
+    {
+        DM_PROFILE(Sprite, "RenderListVisibility");
+        for (uint32_t i = 0; i < params.m_NumEntries; ++i)
+        {
+            const SpriteComponent* component = (const SpriteComponent*) params.m_Entries[params.m_Indices[i]].m_UserData;
+            // The size is part of the world transform, so the quad spans [-0.5, 0.5] along x and y
+            const Matrix4& w = component->m_World;
+            params.m_Bounds[i].m_Center = Point3(w.getCol3().getXYZ());
+            params.m_Bounds[i].m_Extents = 0.5f * (absPerElem(w.getCol0().getXYZ()) + absPerElem(w.getCol1().getXYZ()));
+        }
+    }
+
+    static bool StaticEntryLess(const dmRender::RenderListEntry& a, const dmRender::RenderListEntry& b)
+    {
+        if (a.m_Layer != b.m_Layer)
+            return a.m_Layer < b.m_Layer;
+        if (a.m_BatchKey != b.m_BatchKey)
+            return a.m_BatchKey < b.m_BatchKey;
+        return a.m_WorldPosition.getZ() < b.m_WorldPosition.getZ();
+    }
+
+    static inline bool IsSameStaticBatch(const dmRender::RenderListEntry& a, const dmRender::RenderListEntry& b)
+    {
+        return a.m_Layer == b.m_Layer && a.m_BatchKey == b.m_BatchKey && a.m_WorldPosition.getZ() == b.m_WorldPosition.getZ();
+    }
+
+    // Bakes the vertices of the static sprites into vertex and index buffers that are only updated when a static sprite changes.
+    // Sprites that animate or have render constants are drawn dynamically even if they are flagged as static.
+    static void BakeStaticBatches(SpriteWorld* sprite_world, dmRender::HRenderContext render_context)
+    {
+        DM_PROFILE(Sprite, "BakeStaticBatches");
+
+        sprite_world->m_StaticBatchesDirty = 0;
+        sprite_world->m_StaticBatches.SetSize(0);
+        DeleteStaticBuffers(sprite_world);
+
+        dmPagedObjectPool<SpriteComponent>& components = sprite_world->m_Components;
+        uint32_t n = components.Size();
+
+        dmArray<dmRender::RenderListEntry> entries;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            SpriteComponent* component = &components.GetPhysical(i);
+            component->m_InStaticBatch = 0;
+            if (!component->m_Static || !component->m_Enabled || !component->m_AddedToUpdate || component->m_Playing || component->m_RenderConstants)
+                continue;
+
+            if (component->m_ReHash)
+            {
+                ReHash(component);
+            }
+
+            if (entries.Full())
+            {
+                entries.OffsetCapacity(dmMath::Max(64U, entries.Capacity()));
+            }
+            dmRender::RenderListEntry entry;
+            const Vector4 trans = component->m_World.getCol(3);
+            entry.m_WorldPosition = Point3(trans.getX(), trans.getY(), trans.getZ());
+            entry.m_UserData = (uintptr_t) component;
+            entry.m_BatchKey = component->m_MixedHash;
+            entry.m_Layer = component->m_RenderLayer;
+            entries.Push(entry);
+            component->m_InStaticBatch = 1;
+        }
+
+        uint32_t sprite_count = entries.Size();
+        if (sprite_count == 0)
+            return;
+
+        std::sort(entries.Begin(), entries.End(), StaticEntryLess);
+
+        uint32_t num_vertices_per_sprite = sprite_world->m_UseGeometries ? 8 : 4;
+        uint32_t num_indices_per_sprite = (num_vertices_per_sprite - 2) * 3;
+        bool is_16bit_index = num_vertices_per_sprite * sprite_count <= 65536;
+        uint32_t index_type_size = is_16bit_index ? sizeof(uint16_t) : sizeof(uint32_t);
+
+        uint8_t* vertex_data = (uint8_t*) malloc(sprite_world->m_VertexSize * num_vertices_per_sprite * sprite_count);
+        uint8_t* index_data = (uint8_t*) malloc(index_type_size * num_indices_per_sprite * sprite_count);
+        if (!sprite_world->m_UseGeometries)
+        {
+            if (is_16bit_index)
+                fillIndices<uint16_t>((uint16_t*) index_data, num_indices_per_sprite * sprite_count);
+            else
+                fillIndices<uint32_t>((uint32_t*) index_data, num_indices_per_sprite * sprite_count);
+        }
+
+        dmArray<uint32_t> order;
+        order.SetCapacity(sprite_count);
+        order.SetSize(sprite_count);
+        for (uint32_t i = 0; i < sprite_count; ++i)
+        {
+            order[i] = i;
+        }
+
+        uint8_t* vb_iter = vertex_data;
+        uint8_t* ib_iter = index_data;
+        dmArray<SpriteStaticBatch>& batches = sprite_world->m_StaticBatches;
+        for (uint32_t batch_begin = 0; batch_begin < sprite_count; )
+        {
+            uint32_t batch_end = batch_begin + 1;
+            while (batch_end < sprite_count && IsSameStaticBatch(entries[batch_begin], entries[batch_end]))
+                ++batch_end;
+
+            const SpriteComponent* first = (const SpriteComponent*) entries[batch_begin].m_UserData;
+            SpriteResource* resource = first->m_Resource;
+            TextureSetResource* texture_set = GetTextureSet(first, resource);
+
+            uint8_t* ib_begin = ib_iter;
+            if (sprite_world->m_UseCompactVertices)
+            {
+                SpriteVertexCompact* vertices = (SpriteVertexCompact*) vb_iter;
+                CreateVertexData(sprite_world, (SpriteVertexCompact*) vertex_data, &vertices, &ib_iter, is_16bit_index, texture_set, entries.Begin(), order.Begin() + batch_begin, order.Begin() + batch_end);
+                vb_iter = (uint8_t*) vertices;
+            }
+            else
+            {
+                SpriteVertex* vertices = (SpriteVertex*) vb_iter;
+                CreateVertexData(sprite_world, (SpriteVertex*) vertex_data, &vertices, &ib_iter, is_16bit_index, texture_set, entries.Begin(), order.Begin() + batch_begin, order.Begin() + batch_end);
+                vb_iter = (uint8_t*) vertices;
+            }
+
+            Vector3 min_p(FLT_MAX);
+            Vector3 max_p(-FLT_MAX);
+            for (uint32_t i = batch_begin; i < batch_end; ++i)
+            {
+                const Matrix4& w = ((const SpriteComponent*) entries[i].m_UserData)->m_World;
+                Vector3 center = w.getCol3().getXYZ();
+                Vector3 extents = 0.5f * (absPerElem(w.getCol0().getXYZ()) + absPerElem(w.getCol1().getXYZ()));
+                min_p = minPerElem(min_p, center - extents);
+                max_p = maxPerElem(max_p, center + extents);
+            }
+
+            if (batches.Full())
+            {
+                batches.OffsetCapacity(16);
+            }
+            batches.SetSize(batches.Size() + 1);
+            SpriteStaticBatch& batch = batches.Back();
+            batch.m_Center = Point3(0.5f * (min_p + max_p));
+            batch.m_Extents = 0.5f * (max_p - min_p);
+            batch.m_BatchKey = first->m_MixedHash;
+            batch.m_TagListKey = dmRender::GetMaterialTagListKey(GetMaterial(first, resource));
+            batch.m_RenderLayer = first->m_RenderLayer;
+
+            dmRender::RenderObject& ro = batch.m_RenderObject;
+            ro.Init();
+            ro.m_Material = GetMaterial(first, resource);
+            ro.m_Textures[0] = texture_set->m_Texture;
+            ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
+            ro.m_VertexDeclaration = sprite_world->m_VertexDeclaration;
+            ro.m_IndexType = is_16bit_index ? dmGraphics::TYPE_UNSIGNED_SHORT : dmGraphics::TYPE_UNSIGNED_INT;
+            // offset in bytes into element buffer and the number of elements, see RenderBatch
+            ro.m_VertexStart = ib_begin - index_data;
+            ro.m_VertexCount = (ib_iter - ib_begin) / index_type_size;
+            SetBlendFactors(&ro, resource->m_DDF->m_BlendMode);
+
+            batch_begin = batch_end;
+        }
+
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        sprite_world->m_StaticVertexBuffer = dmGraphics::NewVertexBuffer(graphics_context, vb_iter - vertex_data, vertex_data, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+        sprite_world->m_StaticIndexBuffer = dmGraphics::NewIndexBuffer(graphics_context, ib_iter - index_data, index_data, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+        for (uint32_t i = 0; i < batches.Size(); ++i)
+        {
+            batches[i].m_RenderObject.m_VertexBuffer = sprite_world->m_StaticVertexBuffer;
+            batches[i].m_RenderObject.m_IndexBuffer = sprite_world->m_StaticIndexBuffer;
+        }
+
+        free(vertex_data);
+        free(index_data);
+    }
+
+    static void StaticRenderListDispatch(dmRender::RenderListDispatchParams const &params)
+    {
+        if (params.m_Operation != dmRender::RENDER_LIST_OPERATION_BATCH)
+            return;
+
+        SpriteWorld* world = (SpriteWorld*) params.m_UserData;
+        for (uint32_t* i = params.m_Begin; i != params.m_End; ++i)
+        {
+            SpriteStaticBatch& batch = world->m_StaticBatches[params.m_Buf[*i].m_UserData];
+            dmRender::AddToRender(params.m_Context, &batch.m_RenderObject);
+        }
+    }
+
+    static void StaticRenderListVisibility(dmRender::RenderListVisibilityParams const &params)
+    {
+        SpriteWorld* world = (SpriteWorld*) params.m_UserData;
+        for (uint32_t i = 0; i < params.m_NumEntries; ++i)
+        {
+            const SpriteStaticBatch& batch = world->m_StaticBatches[params.m_Entries[params.m_Indices[i]].m_UserData];
+            params.m_Bounds[i].m_Center = batch.m_Center;
+            params.m_Bounds[i].m_Extents = batch.m_Extents;
+        }
+    }
+
     dmGameObject::UpdateResult CompSpriteRender(const dmGameObject::ComponentsRenderParams& params)
     {
         SpriteContext* sprite_context = (SpriteContext*)params.m_Context;
@@ -898,30 +1440,43 @@ namespace dmGameSystem
 
         dmRender::HRenderContext render_context = sprite_context->m_RenderContext;
 
-        dmArray<SpriteComponent>& components = sprite_world->m_Components.m_Objects;
+        dmPagedObjectPool<SpriteComponent>& components = sprite_world->m_Components;
         uint32_t sprite_count = components.Size();
 
         if (!sprite_count)
             return dmGameObject::UPDATE_RESULT_OK;
 
-        if (sprite_world->m_ReallocBuffers)
+        // The buffers are either allocated for the max sprite count up front, or grow with the allocated components
+        uint32_t buffer_capacity = sprite_context->m_MaxSpriteCount;
+        if (sprite_context->m_GrowOnDemand)
+        {
+            buffer_capacity = dmMath::Min(components.AllocatedCapacity(), sprite_context->m_MaxSpriteCount);
+        }
+
+        if (sprite_world->m_ReallocBuffers || sprite_world->m_BufferCapacity < buffer_capacity)
         {
             // Old version has always 4 vertices. New version has up to 8 vertices.
             // We will allocate for this upper bound
             uint32_t num_vertices_per_sprite = sprite_world->m_UseGeometries ? 8 : 4;
             uint32_t num_indices_per_sprite = (num_vertices_per_sprite - 2) * 3;
-            ReAllocateBuffers(sprite_world, render_context, sprite_context->m_MaxSpriteCount, num_vertices_per_sprite, num_indices_per_sprite);
+            ReAllocateBuffers(sprite_world, render_context, buffer_capacity, num_vertices_per_sprite, num_indices_per_sprite);
         }
 
+        if (sprite_world->m_StaticBatchesDirty)
+        {
+            BakeStaticBatches(sprite_world, render_context);
+        }
+        uint32_t static_batch_count = sprite_world->m_StaticBatches.Size();
+
         // Submit all sprites as entries in the render list for sorting.
-        dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(render_context, sprite_count);
-        dmRender::HRenderListDispatch sprite_dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, sprite_world);
+        dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(render_context, sprite_count + static_batch_count);
+        dmRender::HRenderListDispatch sprite_dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, &RenderListVisibility, sprite_world);
         dmRender::RenderListEntry* write_ptr = render_list;
 
         for (uint32_t i = 0; i < sprite_count; ++i)
         {
-            SpriteComponent& component = components[i];
-            if (!component.m_Enabled || !component.m_AddedToUpdate)
+            SpriteComponent& component = components.GetPhysical(i);
+            if (!component.m_Enabled || !component.m_AddedToUpdate || component.m_InStaticBatch)
                 continue;
 
             if (component.m_ReHash || (component.m_RenderConstants && dmGameSystem::AreRenderConstantsUpdated(component.m_RenderConstants)))
@@ -936,10 +1491,29 @@ namespace dmGameSystem
             write_ptr->m_TagListKey = dmRender::GetMaterialTagListKey(GetMaterial(&component, component.m_Resource));
             write_ptr->m_Dispatch = sprite_dispatch;
             write_ptr->m_MinorOrder = 0;
+            write_ptr->m_Layer = component.m_RenderLayer;
             write_ptr->m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
             ++write_ptr;
         }
 
+        if (static_batch_count)
+        {
+            dmRender::HRenderListDispatch static_dispatch = dmRender::RenderListMakeDispatch(render_context, &StaticRenderListDispatch, &StaticRenderListVisibility, sprite_world);
+            for (uint32_t i = 0; i < static_batch_count; ++i)
+            {
+                const SpriteStaticBatch& batch = sprite_world->m_StaticBatches[i];
+                write_ptr->m_WorldPosition = batch.m_Center;
+                write_ptr->m_UserData = i;
+                write_ptr->m_BatchKey = batch.m_BatchKey;
+                write_ptr->m_TagListKey = batch.m_TagListKey;
+                write_ptr->m_Dispatch = static_dispatch;
+                write_ptr->m_MinorOrder = 0;
+                write_ptr->m_Layer = batch.m_RenderLayer;
+                write_ptr->m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+                ++write_ptr;
+            }
+        }
+
         dmRender::RenderListSubmit(render_context, render_list, write_ptr);
         return dmGameObject::UPDATE_RESULT_OK;
     }
@@ -1006,6 +1580,7 @@ namespace dmGameSystem
     {
         SpriteWorld* sprite_world = (SpriteWorld*)params.m_World;
         SpriteComponent* component = &sprite_world->m_Components.Get(*params.m_UserData);
+        MakeDynamic(sprite_world, component);
         if (params.m_Message->m_Id == dmGameObjectDDF::Enable::m_DDFDescriptor->m_NameHash)
         {
             component->m_Enabled = 1;
@@ -1062,6 +1637,7 @@ namespace dmGameSystem
             {
                 dmGameSystemDDF::SetScale* ddf = (dmGameSystemDDF::SetScale*)params.m_Message->m_Data;
                 component->m_Scale = ddf->m_Scale;
+                component->m_DirtyTransform = 1;
             }
         }
 
@@ -1072,6 +1648,7 @@ namespace dmGameSystem
     {
         SpriteWorld* sprite_world = (SpriteWorld*)params.m_World;
         SpriteComponent* component = &sprite_world->m_Components.Get(*params.m_UserData);
+        MakeDynamic(sprite_world, component);
         if (component->m_Playing)
             PlayAnimation(component, component->m_CurrentAnimation, component->m_AnimTimer, component->m_PlaybackRate);
     }
@@ -1100,6 +1677,11 @@ namespace dmGameSystem
             out_value.m_Variant = dmGameObject::PropertyVar(GetPlaybackRate(component));
             return dmGameObject::PROPERTY_RESULT_OK;
         }
+        else if (get_property == PROP_LAYER)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar((float)component->m_RenderLayer);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
         else if (get_property == PROP_MATERIAL)
         {
             return GetResourceProperty(dmGameObject::GetFactory(params.m_Instance), GetMaterial(component, component->m_Resource), out_value);
@@ -1120,13 +1702,16 @@ namespace dmGameSystem
         SpriteWorld* sprite_world = (SpriteWorld*)params.m_World;
         SpriteComponent* component = &sprite_world->m_Components.Get(*params.m_UserData);
         dmhash_t set_property = params.m_PropertyId;
+        MakeDynamic(sprite_world, component);
 
         if (IsReferencingProperty(SPRITE_PROP_SCALE, set_property))
         {
+            component->m_DirtyTransform = 1;
             return SetProperty(set_property, params.m_Value, component->m_Scale, SPRITE_PROP_SCALE);
         }
         else if (IsReferencingProperty(SPRITE_PROP_SIZE, set_property))
         {
+            component->m_DirtyTransform = 1;
             return SetProperty(set_property, params.m_Value, component->m_Size, SPRITE_PROP_SIZE);
         }
         else if (params.m_PropertyId == SPRITE_PROP_CURSOR)
@@ -1145,6 +1730,10 @@ namespace dmGameSystem
             SetPlaybackRate(component, params.m_Value.m_Number);
             return dmGameObject::PROPERTY_RESULT_OK;
         }
+        else if (set_property == PROP_LAYER)
+        {
+            return SetLayerProperty(params.m_Value, &component->m_RenderLayer);
+        }
         else if (set_property == PROP_MATERIAL)
         {
             dmGameObject::PropertyResult res = SetResourceProperty(dmGameObject::GetFactory(params.m_Instance), params.m_Value, MATERIAL_EXT_HASH, (void**)&component->m_Material);
@@ -1260,4 +1849,68 @@ namespace dmGameSystem
         pit->m_Next = 0;
         pit->m_FnIterateNext = CompSpriteIterPropertiesGetNext;
     }
+
+    bool GetSpriteHandle(dmGameObject::HInstance instance, dmhash_t component_id, SpriteHandle* out_handle)
+    {
+        void* world;
+        uintptr_t user_data;
+        if (dmGameObject::GetComponent(instance, component_id, "spritec", &world, &user_data) != dmGameObject::RESULT_OK)
+        {
+            return false;
+        }
+        out_handle->m_World = world;
+        out_handle->m_Index = (uint32_t) user_data;
+        return true;
+    }
+
+    static inline SpriteComponent* GetSpriteComponent(const SpriteHandle& handle)
+    {
+        return &((SpriteWorld*) handle.m_World)->m_Components.Get(handle.m_Index);
+    }
+
+    void SetSpriteTints(const SpriteHandle* handles, const dmVMath::Vector4* tints, uint32_t count)
+    {
+        DM_PROFILE(Sprite, "SetTints");
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            SpriteComponent* component = GetSpriteComponent(handles[i]);
+            MakeDynamic((SpriteWorld*) handles[i].m_World, component);
+            SetMaterialConstant(GetMaterial(component, component->m_Resource), SPRITE_PROP_TINT, dmGameObject::PropertyVar(tints[i]), CompSpriteSetConstantCallback, component);
+        }
+    }
+
+    void SetSpriteScales(const SpriteHandle* handles, const dmVMath::Vector3* scales, uint32_t count)
+    {
+        DM_PROFILE(Sprite, "SetScales");
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            SpriteComponent* component = GetSpriteComponent(handles[i]);
+            MakeDynamic((SpriteWorld*) handles[i].m_World, component);
+            component->m_Scale = scales[i];
+            component->m_DirtyTransform = 1;
+        }
+    }
+
+    void SetSpriteCursors(const SpriteHandle* handles, const float* cursors, uint32_t count)
+    {
+        DM_PROFILE(Sprite, "SetCursors");
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            SpriteComponent* component = GetSpriteComponent(handles[i]);
+            MakeDynamic((SpriteWorld*) handles[i].m_World, component);
+            SetCursor(component, cursors[i]);
+        }
+    }
+
+    void SetSpritesStatic(const SpriteHandle* handles, uint32_t count, bool enable)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            SpriteWorld* sprite_world = (SpriteWorld*) handles[i].m_World;
+            SpriteComponent* component = GetSpriteComponent(handles[i]);
+            MakeDynamic(sprite_world, component);
+            component->m_Static = enable;
+            sprite_world->m_StaticBatchesDirty = 1;
+        }
+    }
 }
@@ -0,0 +1,37 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "comp_stub.h"
+
+namespace dmGameSystem
+{
+    dmGameObject::CreateResult CompStubCreate(const dmGameObject::ComponentCreateParams& params)
+    {
+        *params.m_UserData = 0;
+        return dmGameObject::CREATE_RESULT_OK;
+    }
+
+    dmGameObject::CreateResult CompStubDestroy(const dmGameObject::ComponentDestroyParams& params)
+    {
+        return dmGameObject::CREATE_RESULT_OK;
+    }
+
+    dmGameObject::UpdateResult CompStubOnMessage(const dmGameObject::ComponentOnMessageParams& params)
+    {
+        return dmGameObject::UPDATE_RESULT_OK;
+    }
+
+    dmGameObject::PropertyResult CompStubSetProperty(const dmGameObject::ComponentSetPropertyParams& params)
+    {
+        return dmGameObject::PROPERTY_RESULT_OK;
+    }
+}
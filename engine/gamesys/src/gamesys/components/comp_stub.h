@@ -0,0 +1,31 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_GAMESYS_COMP_STUB_H
+#define DM_GAMESYS_COMP_STUB_H
+
+#include <gameobject/component.h>
+
+namespace dmGameSystem
+{
+    // Stand-in for a component type that is not used by a headless server, e.g. a sprite or a sound.
+    // Messages and property changes are ignored, so that scripts shared with the game client keep running
+    dmGameObject::CreateResult CompStubCreate(const dmGameObject::ComponentCreateParams& params);
+
+    dmGameObject::CreateResult CompStubDestroy(const dmGameObject::ComponentDestroyParams& params);
+
+    dmGameObject::UpdateResult CompStubOnMessage(const dmGameObject::ComponentOnMessageParams& params);
+
+    dmGameObject::PropertyResult CompStubSetProperty(const dmGameObject::ComponentSetPropertyParams& params);
+}
+
+#endif // DM_GAMESYS_COMP_STUB_H
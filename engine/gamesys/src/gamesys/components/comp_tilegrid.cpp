@@ -38,16 +38,33 @@
 namespace dmGameSystem
 {
     const uint32_t TILEGRID_REGION_SIZE = 32;
+    const uint32_t TILEGRID_REGION_CELL_COUNT = TILEGRID_REGION_SIZE * TILEGRID_REGION_SIZE;
+    const uint16_t TILEGRID_EMPTY_TILE = 0xffff;
 
     using namespace Vectormath::Aos;
 
+    struct TileGridCell
+    {
+        uint16_t    m_Tile;
+        uint16_t    m_FlipHorizontal : 1;
+        uint16_t    m_FlipVertical : 1;
+        uint16_t    : 14;
+    };
+
     // A "region" spans all layers (in Z) for a bounding box [(x1,y1), (x2,y2)]
     // where the the box spans TILEGRID_REGION_SIZE tiles in each direction
     struct TileGridRegion
     {
+        // The cells of all layers, layer by layer. Only allocated once the region has a tile,
+        // so that empty parts of large tile maps take no memory.
+        TileGridCell* m_Cells;
+        // Tiles of all layers in tile grid space, only used with local vertex space materials
+        dmGraphics::HVertexBuffer m_VertexBuffer;
         uint8_t m_Dirty:1;
         uint8_t m_Occupied:1;
-        uint8_t :6;
+        // The tiles changed since m_VertexBuffer was built
+        uint8_t m_VertexDirty:1;
+        uint8_t :5;
     };
 
     struct TileGridLayer
@@ -58,21 +75,13 @@ namespace dmGameSystem
 
     struct TileGridComponent
     {
-        struct Flags
-        {
-            uint16_t    m_FlipHorizontal : 1;
-            uint16_t    m_FlipVertical : 1;
-            uint16_t    : 14;
-        };
-
         TileGridComponent()
         : m_Instance(0)
-        , m_Cells(0)
-        , m_CellFlags(0)
         , m_RenderConstants(0)
         , m_Material(0)
         , m_TextureSet(0)
         , m_Resource(0)
+        , m_RenderLayer(0)
         {
         }
 
@@ -80,9 +89,9 @@ namespace dmGameSystem
         Vectormath::Aos::Quat       m_Rotation;
         Vectormath::Aos::Matrix4    m_World;
         dmGameObject::HInstance     m_Instance;
-        uint16_t*                   m_Cells;
-        Flags*                      m_CellFlags;
         dmArray<TileGridRegion>     m_Regions;
+        // Vertex range of each layer in the region vertex buffers, (layer count + 1) offsets per region
+        dmArray<uint32_t>           m_RegionLayerOffsets;
         dmArray<TileGridLayer>      m_Layers;
         uint32_t                    m_MixedHash;
         HComponentRenderConstants   m_RenderConstants;
@@ -95,6 +104,8 @@ namespace dmGameSystem
         uint8_t                     m_Enabled : 1;
         uint8_t                     m_AddedToUpdate : 1;
         uint8_t                     : 6;
+        /// Render layer, see dmRender::SetLayerMask. Not to be confused with the tile layers
+        uint8_t                     m_RenderLayer;
     };
 
     struct TileGridVertex
@@ -114,10 +125,13 @@ namespace dmGameSystem
         dmArray<dmRender::RenderObject> m_RenderObjects;
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
 
+        dmGraphics::HDynamicVertexBuffer m_DynamicVertexBuffer;
         dmGraphics::HVertexBuffer       m_VertexBuffer;
         TileGridVertex*                 m_VertexBufferData;
         TileGridVertex*                 m_VertexBufferDataEnd;
         TileGridVertex*                 m_VertexBufferWritePtr;
+        // Scratch data when building region vertex buffers
+        dmArray<TileGridVertex>         m_RegionVertexData;
 
         uint32_t                        m_MaxTilemapCount;
         uint32_t                        m_MaxTileCount;
@@ -136,7 +150,8 @@ namespace dmGameSystem
                 {"texcoord0", 1, 2, dmGraphics::TYPE_FLOAT, false},
         };
         world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, ve, sizeof(ve) / sizeof(ve[0]));
-        world->m_VertexBuffer = dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(world->m_RenderContext), 0, 0x0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+        world->m_DynamicVertexBuffer = dmGraphics::NewDynamicVertexBuffer(graphics_context);
+        world->m_VertexBuffer = 0;
         uint32_t vcount = 6 * world->m_MaxTileCount;
         world->m_VertexBufferData = (TileGridVertex*) malloc(sizeof(TileGridVertex) * vcount);
         world->m_VertexBufferDataEnd = world->m_VertexBufferData + vcount;
@@ -165,7 +180,7 @@ namespace dmGameSystem
         if (world->m_VertexDeclaration)
         {
             dmGraphics::DeleteVertexDeclaration(world->m_VertexDeclaration);
-            dmGraphics::DeleteVertexBuffer(world->m_VertexBuffer);
+            dmGraphics::DeleteDynamicVertexBuffer(world->m_DynamicVertexBuffer);
             free(world->m_VertexBufferData);
         }
         delete world;
@@ -200,12 +215,45 @@ namespace dmGameSystem
         cell_y = y - component->m_Resource->m_MinCellY;
     }
 
+    static inline TileGridRegion* GetCellRegion(const TileGridComponent* component, int32_t cell_x, int32_t cell_y)
+    {
+        uint32_t region_x = cell_x / TILEGRID_REGION_SIZE;
+        uint32_t region_y = cell_y / TILEGRID_REGION_SIZE;
+        return (TileGridRegion*) &component->m_Regions[region_y * component->m_RegionsX + region_x];
+    }
+
+    static inline uint32_t CalculateRegionCellIndex(uint32_t layer, int32_t cell_x, int32_t cell_y)
+    {
+        return layer * TILEGRID_REGION_CELL_COUNT + (cell_y % TILEGRID_REGION_SIZE) * TILEGRID_REGION_SIZE + (cell_x % TILEGRID_REGION_SIZE);
+    }
+
+    // Returns the cell, or 0 if its region has no tiles
+    static inline const TileGridCell* GetCell(const TileGridComponent* component, uint32_t layer, int32_t cell_x, int32_t cell_y)
+    {
+        const TileGridRegion* region = GetCellRegion(component, cell_x, cell_y);
+        return region->m_Cells ? &region->m_Cells[CalculateRegionCellIndex(layer, cell_x, cell_y)] : 0;
+    }
+
+    static TileGridCell* GetOrAllocCell(TileGridComponent* component, uint32_t layer, int32_t cell_x, int32_t cell_y)
+    {
+        TileGridRegion* region = GetCellRegion(component, cell_x, cell_y);
+        if (!region->m_Cells)
+        {
+            uint32_t cell_count = component->m_Layers.Size() * TILEGRID_REGION_CELL_COUNT;
+            region->m_Cells = new TileGridCell[cell_count];
+            memset(region->m_Cells, 0, cell_count * sizeof(TileGridCell));
+            for (uint32_t i = 0; i < cell_count; ++i)
+            {
+                region->m_Cells[i].m_Tile = TILEGRID_EMPTY_TILE;
+            }
+        }
+        return &region->m_Cells[CalculateRegionCellIndex(layer, cell_x, cell_y)];
+    }
+
     uint16_t GetTileGridTile(const TileGridComponent* component, uint32_t layer, int32_t cell_x, int32_t cell_y)
     {
-        TileGridResource* resource = component->m_Resource;
-        uint32_t cell_index = CalculateCellIndex(layer, cell_x, cell_y, resource->m_ColumnCount, resource->m_RowCount);
-        uint16_t cell = (component->m_Cells[cell_index] + 1);
-        return cell;
+        const TileGridCell* cell = GetCell(component, layer, cell_x, cell_y);
+        return cell ? cell->m_Tile + 1 : 0;
     }
 
     void SetLayerVisible(TileGridComponent* component, uint32_t layer_index, bool visible)
@@ -221,17 +269,19 @@ namespace dmGameSystem
         uint32_t region_index = region_y * component->m_RegionsX + region_x;
         TileGridRegion* region = &component->m_Regions[region_index];
         region->m_Dirty = 1;
+        region->m_VertexDirty = 1;
     }
 
     void SetTileGridTile(TileGridComponent* component, uint32_t layer, int32_t cell_x, int32_t cell_y, uint32_t tile, bool flip_h, bool flip_v)
     {
-        TileGridResource* resource = component->m_Resource;
-        uint32_t cell_index = CalculateCellIndex(layer, cell_x, cell_y, resource->m_ColumnCount, resource->m_RowCount);
-        component->m_Cells[cell_index] = tile;
+        // Clearing a cell of a region without tiles is a no-op
+        if ((uint16_t)tile == TILEGRID_EMPTY_TILE && !GetCell(component, layer, cell_x, cell_y))
+            return;
 
-        TileGridComponent::Flags* flags = &component->m_CellFlags[cell_index];
-        flags->m_FlipHorizontal = flip_h;
-        flags->m_FlipVertical = flip_v;
+        TileGridCell* cell = GetOrAllocCell(component, layer, cell_x, cell_y);
+        cell->m_Tile = tile;
+        cell->m_FlipHorizontal = flip_h;
+        cell->m_FlipVertical = flip_v;
 
         SetRegionDirty(component, cell_x, cell_y);
     }
@@ -257,8 +307,41 @@ namespace dmGameSystem
         component->m_MixedHash = dmHashFinal32(&state);
     }
 
+    static void DeleteRegionVertexBuffers(TileGridComponent* component)
+    {
+        for (uint32_t i = 0; i < component->m_Regions.Size(); ++i)
+        {
+            TileGridRegion* region = &component->m_Regions[i];
+            if (region->m_VertexBuffer)
+            {
+                dmGraphics::DeleteVertexBuffer(region->m_VertexBuffer);
+                region->m_VertexBuffer = 0;
+            }
+        }
+    }
+
+    static void SetRegionsVertexDirty(TileGridComponent* component)
+    {
+        for (uint32_t i = 0; i < component->m_Regions.Size(); ++i)
+        {
+            component->m_Regions[i].m_VertexDirty = 1;
+        }
+    }
+
+    static void DeleteRegionCells(TileGridComponent* component)
+    {
+        for (uint32_t i = 0; i < component->m_Regions.Size(); ++i)
+        {
+            delete [] component->m_Regions[i].m_Cells;
+            component->m_Regions[i].m_Cells = 0;
+        }
+    }
+
     static void CreateRegions(TileGridComponent* component, TileGridResource* resource)
     {
+        DeleteRegionVertexBuffers(component);
+        DeleteRegionCells(component);
+
         // Round up to closest multiple
         component->m_RegionsX = ((resource->m_ColumnCount + TILEGRID_REGION_SIZE - 1) / TILEGRID_REGION_SIZE);
         component->m_RegionsY = ((resource->m_RowCount + TILEGRID_REGION_SIZE - 1) / TILEGRID_REGION_SIZE);
@@ -266,7 +349,19 @@ namespace dmGameSystem
 
         component->m_Regions.SetCapacity(region_count);
         component->m_Regions.SetSize(region_count);
-        memset(&component->m_Regions[0], 0xFF, region_count * sizeof(TileGridRegion)); // mark them all dirty
+        memset(&component->m_Regions[0], 0, region_count * sizeof(TileGridRegion));
+        for (uint32_t i = 0; i < region_count; ++i)
+        {
+            // mark them all dirty
+            component->m_Regions[i].m_Dirty = 1;
+            component->m_Regions[i].m_Occupied = 1;
+            component->m_Regions[i].m_VertexDirty = 1;
+        }
+
+        uint32_t offset_count = region_count * (resource->m_TileGrid->m_Layers.m_Count + 1);
+        component->m_RegionLayerOffsets.SetCapacity(offset_count);
+        component->m_RegionLayerOffsets.SetSize(offset_count);
+        memset(component->m_RegionLayerOffsets.Begin(), 0, offset_count * sizeof(uint32_t));
     }
 
     static uint32_t UpdateRegion(TileGridComponent* component, uint32_t region_x, uint32_t region_y)
@@ -278,43 +373,35 @@ namespace dmGameSystem
         }
         region->m_Dirty = 0;
 
-        TileGridResource* resource = component->m_Resource;
-        dmGameSystemDDF::TileGrid* tile_grid_ddf = resource->m_TileGrid;
-
-        uint32_t n_layers = tile_grid_ddf->m_Layers.m_Count;
-
-        uint32_t column_count = resource->m_ColumnCount;
-        uint32_t row_count = resource->m_RowCount;
-        int32_t min_x = resource->m_MinCellX + region_x * TILEGRID_REGION_SIZE;
-        int32_t min_y = resource->m_MinCellY + region_y * TILEGRID_REGION_SIZE;
-        int32_t max_x = dmMath::Min(min_x + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellX + (int32_t)column_count);
-        int32_t max_y = dmMath::Min(min_y + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellY + (int32_t)row_count);
-
         region->m_Occupied = 0;
+        if (!region->m_Cells) {
+            return region->m_Occupied;
+        }
 
-        uint32_t visible_tiles = 0;
-        for (uint32_t j = 0; j < n_layers; ++j)
+        // Cells outside the grid in the last row and column of regions are never set, so the whole region can be scanned
+        bool has_tiles = false;
+        uint32_t n_layers = component->m_Layers.Size();
+        for (uint32_t j = 0; j < n_layers && !region->m_Occupied; ++j)
         {
-            TileGridLayer* layer = &component->m_Layers[j];
-            if (!layer->m_IsVisible)
-                continue;
-
-            for (int32_t y = min_y; y < max_y; ++y)
+            const TileGridCell* cells = &region->m_Cells[j * TILEGRID_REGION_CELL_COUNT];
+            for (uint32_t i = 0; i < TILEGRID_REGION_CELL_COUNT; ++i)
             {
-                for (int32_t x = min_x; x < max_x; ++x)
+                if (cells[i].m_Tile != TILEGRID_EMPTY_TILE)
                 {
-                    uint32_t cell = CalculateCellIndex(j, x - resource->m_MinCellX, y - resource->m_MinCellY, column_count, row_count);
-                    uint16_t tile = component->m_Cells[cell];
-                    if (tile != 0xffff)
-                    {
-                        ++visible_tiles;
-                        region->m_Occupied = 1;
-                        return region->m_Occupied;
-                    }
+                    has_tiles = true;
+                    region->m_Occupied = component->m_Layers[j].m_IsVisible;
+                    break;
                 }
             }
         }
 
+        // Give the memory back when all tiles of the region have been cleared
+        if (!has_tiles)
+        {
+            delete [] region->m_Cells;
+            region->m_Cells = 0;
+        }
+
         return region->m_Occupied;
     }
 
@@ -334,26 +421,13 @@ namespace dmGameSystem
         TileGridResource* resource = component->m_Resource;
         dmGameSystemDDF::TileGrid* tile_grid_ddf = resource->m_TileGrid;
         uint32_t n_layers = tile_grid_ddf->m_Layers.m_Count;
-        uint32_t cell_count = resource->m_ColumnCount * resource->m_RowCount * n_layers;
-        if (component->m_Cells != 0x0)
-        {
-            delete [] component->m_Cells;
-        }
-        component->m_Cells = new uint16_t[cell_count];
-        memset(component->m_Cells, 0xff, cell_count * sizeof(uint16_t));
-        if (component->m_CellFlags != 0x0)
-        {
-            delete [] component->m_CellFlags;
-        }
-        component->m_CellFlags = new TileGridComponent::Flags[cell_count];
-        memset(component->m_CellFlags, 0, cell_count * sizeof(TileGridComponent::Flags));
         int32_t min_x = resource->m_MinCellX;
         int32_t min_y = resource->m_MinCellY;
-        uint32_t column_count = resource->m_ColumnCount;
-        uint32_t row_count = resource->m_RowCount;
 
+        // The region cells are sized by the layer count
         component->m_Layers.SetCapacity(n_layers);
         component->m_Layers.SetSize(n_layers);
+        CreateRegions(component, resource);
 
         for (uint32_t i = 0; i < n_layers; ++i)
         {
@@ -364,17 +438,14 @@ namespace dmGameSystem
             uint32_t n_cells = layer_ddf->m_Cell.m_Count;
             for (uint32_t j = 0; j < n_cells; ++j)
             {
-                dmGameSystemDDF::TileCell* cell = &layer_ddf->m_Cell[j];
-                uint32_t cell_index = CalculateCellIndex(i, cell->m_X - min_x, cell->m_Y - min_y, column_count, row_count);
-                component->m_Cells[cell_index] = (uint16_t)cell->m_Tile;
-
-                TileGridComponent::Flags* flags = &component->m_CellFlags[cell_index];
-                flags->m_FlipHorizontal = cell->m_HFlip;
-                flags->m_FlipVertical = cell->m_VFlip;
+                dmGameSystemDDF::TileCell* ddf_cell = &layer_ddf->m_Cell[j];
+                TileGridCell* cell = GetOrAllocCell(component, i, ddf_cell->m_X - min_x, ddf_cell->m_Y - min_y);
+                cell->m_Tile = (uint16_t)ddf_cell->m_Tile;
+                cell->m_FlipHorizontal = ddf_cell->m_HFlip;
+                cell->m_FlipVertical = ddf_cell->m_VFlip;
             }
         }
 
-        CreateRegions(component, resource);
         component->m_Occupied = UpdateRegions(component);
         return n_layers;
     }
@@ -428,8 +499,8 @@ namespace dmGameSystem
                     dmResource::Release(dmGameObject::GetFactory(params.m_Instance), tile_grid->m_TextureSet);
                 }
 
-                delete [] tile_grid->m_Cells;
-                delete [] tile_grid->m_CellFlags;
+                DeleteRegionCells(tile_grid);
+                DeleteRegionVertexBuffers(tile_grid);
 
                 if (tile_grid->m_RenderConstants)
                 {
@@ -504,135 +575,177 @@ namespace dmGameSystem
         region_y = (ptr >> 48) & 0xFFFF;
     }
 
-    TileGridVertex* CreateVertexData(TileGridWorld* world, TileGridVertex* where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
-    {
-        DM_PROFILE(TileGrid, "CreateVertexData");
-        static int tex_coord_order[] = {
-            0,1,2,2,3,0,
-            3,2,1,1,0,3,    //h
-            1,0,3,3,2,1,    //v
-            2,3,0,0,1,2     //hv
-        };
+    static const int TEX_COORD_ORDER[] = {
+        0,1,2,2,3,0,
+        3,2,1,1,0,3,    //h
+        1,0,3,3,2,1,    //v
+        2,3,0,0,1,2     //hv
+    };
 
-        dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
+    // Writes the tiles of one layer of a region transformed by w. Returns 0 if they don't fit before where_end.
+    static TileGridVertex* CreateRegionVertexData(const TileGridComponent* component, const Matrix4& w, const dmGameSystemDDF::TextureSet* texture_set_ddf,
+                                                  uint32_t layer, uint32_t region_x, uint32_t region_y, TileGridVertex* where, TileGridVertex* where_end)
+    {
         const float* tex_coords = (const float*) texture_set_ddf->m_TexCoords.m_Data;
 
         uint32_t tile_width = texture_set_ddf->m_TileWidth;
         uint32_t tile_height = texture_set_ddf->m_TileHeight;
 
-        for (uint32_t* i = begin; i != end; ++i)
-        {
-            uint32_t index, layer, region_x, region_y;
-            DecodeGridAndLayer(buf[*i].m_UserData, index, layer, region_x, region_y);
+        const TileGridResource* resource = component->m_Resource;
+        dmGameSystemDDF::TileGrid* tile_grid_ddf = resource->m_TileGrid;
+        dmGameSystemDDF::TileLayer* layer_ddf = &tile_grid_ddf->m_Layers[layer];
 
-            const TileGridComponent* component = world->m_Components[index];
-            const TileGridResource* resource = component->m_Resource;
-            dmGameSystemDDF::TileGrid* tile_grid_ddf = resource->m_TileGrid;
-            dmGameSystemDDF::TileLayer* layer_ddf = &tile_grid_ddf->m_Layers[layer];
+        const float z = layer_ddf->m_Z;
 
-            const Matrix4& w = component->m_World;
-            const float z = layer_ddf->m_Z;
+        const TileGridRegion* region = &component->m_Regions[region_y * component->m_RegionsX + region_x];
+        if (!region->m_Cells)
+        {
+            return where;
+        }
+        const TileGridCell* cells = &region->m_Cells[layer * TILEGRID_REGION_CELL_COUNT];
 
-            uint32_t column_count = resource->m_ColumnCount;
-            uint32_t row_count = resource->m_RowCount;
+        uint32_t column_count = resource->m_ColumnCount;
+        uint32_t row_count = resource->m_RowCount;
 
-            int32_t min_x = resource->m_MinCellX + region_x * TILEGRID_REGION_SIZE;
-            int32_t min_y = resource->m_MinCellY + region_y * TILEGRID_REGION_SIZE;
-            int32_t max_x = dmMath::Min(min_x + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellX + (int32_t)column_count);
-            int32_t max_y = dmMath::Min(min_y + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellY + (int32_t)row_count);
+        int32_t min_x = resource->m_MinCellX + region_x * TILEGRID_REGION_SIZE;
+        int32_t min_y = resource->m_MinCellY + region_y * TILEGRID_REGION_SIZE;
+        int32_t max_x = dmMath::Min(min_x + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellX + (int32_t)column_count);
+        int32_t max_y = dmMath::Min(min_y + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellY + (int32_t)row_count);
 
-            for (int32_t y = min_y; y < max_y; ++y)
+        for (int32_t y = min_y; y < max_y; ++y)
+        {
+            for (int32_t x = min_x; x < max_x; ++x)
             {
-                for (int32_t x = min_x; x < max_x; ++x)
+                const TileGridCell* cell = &cells[(y - min_y) * TILEGRID_REGION_SIZE + (x - min_x)];
+                uint16_t tile = cell->m_Tile;
+                if (tile == TILEGRID_EMPTY_TILE)
                 {
-                    uint32_t cell = CalculateCellIndex(layer, x - resource->m_MinCellX, y - resource->m_MinCellY, column_count, row_count);
-                    uint16_t tile = component->m_Cells[cell];
-                    if (tile == 0xffff)
-                    {
-                        continue;
-                    }
+                    continue;
+                }
 
-                    if( where >= world->m_VertexBufferDataEnd )
-                    {
-                        dmLogError("Out of tiles to render (%zu). You can change this with the game.project setting tilemap.max_tile_count", (size_t)((world->m_VertexBufferDataEnd - world->m_VertexBufferData) / 6));
-                        return world->m_VertexBufferDataEnd;
-                    }
+                if( where >= where_end )
+                {
+                    return 0;
+                }
 
-                    float p[4];
-                    CalculateCellBounds(x, y, 1, 1, p);
-                    const float* puv = &tex_coords[tile * 8];
-                    uint32_t flip_flag = 0;
+                float p[4];
+                CalculateCellBounds(x, y, 1, 1, p);
+                const float* puv = &tex_coords[tile * 8];
+                uint32_t flip_flag = 0;
 
-                    TileGridComponent::Flags flags = component->m_CellFlags[cell];
-                    if (flags.m_FlipHorizontal)
-                    {
-                        flip_flag = 1;
-                    }
-                    if (flags.m_FlipVertical)
-                    {
-                        flip_flag |= 2;
+                if (cell->m_FlipHorizontal)
+                {
+                    flip_flag = 1;
+                }
+                if (cell->m_FlipVertical)
+                {
+                    flip_flag |= 2;
+                }
+                const int* tex_lookup = &TEX_COORD_ORDER[flip_flag * 6];
+
+                #define SET_VERTEX(_I, _X, _Y, _Z, _U, _V) \
+                    { \
+                        const Vector4 v = w * Point3(_X * tile_width, _Y * tile_height, _Z); \
+                        where[_I].x = v.getX(); \
+                        where[_I].y = v.getY(); \
+                        where[_I].z = v.getZ(); \
+                        where[_I].u = _U; \
+                        where[_I].v = _V; \
                     }
-                    const int* tex_lookup = &tex_coord_order[flip_flag * 6];
-
-                    #define SET_VERTEX(_I, _X, _Y, _Z, _U, _V) \
-                        { \
-                            const Vector4 v = w * Point3(_X * tile_width, _Y * tile_height, _Z); \
-                            where[_I].x = v.getX(); \
-                            where[_I].y = v.getY(); \
-                            where[_I].z = v.getZ(); \
-                            where[_I].u = _U; \
-                            where[_I].v = _V; \
-                        }
 
-                    SET_VERTEX(0, p[0], p[1], z, puv[tex_lookup[0] * 2], puv[tex_lookup[0] * 2 + 1]);
-                    SET_VERTEX(1, p[0], p[3], z, puv[tex_lookup[1] * 2], puv[tex_lookup[1] * 2 + 1]);
-                    SET_VERTEX(2, p[2], p[3], z, puv[tex_lookup[2] * 2], puv[tex_lookup[2] * 2 + 1]);
-                    SET_VERTEX(3, p[2], p[3], z, puv[tex_lookup[3] * 2], puv[tex_lookup[3] * 2 + 1]);
-                    SET_VERTEX(4, p[2], p[1], z, puv[tex_lookup[4] * 2], puv[tex_lookup[4] * 2 + 1]);
-                    SET_VERTEX(5, p[0], p[1], z, puv[tex_lookup[5] * 2], puv[tex_lookup[5] * 2 + 1]);
+                SET_VERTEX(0, p[0], p[1], z, puv[tex_lookup[0] * 2], puv[tex_lookup[0] * 2 + 1]);
+                SET_VERTEX(1, p[0], p[3], z, puv[tex_lookup[1] * 2], puv[tex_lookup[1] * 2 + 1]);
+                SET_VERTEX(2, p[2], p[3], z, puv[tex_lookup[2] * 2], puv[tex_lookup[2] * 2 + 1]);
+                SET_VERTEX(3, p[2], p[3], z, puv[tex_lookup[3] * 2], puv[tex_lookup[3] * 2 + 1]);
+                SET_VERTEX(4, p[2], p[1], z, puv[tex_lookup[4] * 2], puv[tex_lookup[4] * 2 + 1]);
+                SET_VERTEX(5, p[0], p[1], z, puv[tex_lookup[5] * 2], puv[tex_lookup[5] * 2 + 1]);
 
-                    where += 6;
+                where += 6;
 
-                    #undef SET_VERTEX
-                }
+                #undef SET_VERTEX
             }
         }
         return where;
     }
 
-    static void RenderBatch(TileGridWorld* world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    TileGridVertex* CreateVertexData(TileGridWorld* world, TileGridVertex* where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
     {
-        DM_PROFILE(TileGrid, "RenderBatch");
+        DM_PROFILE(TileGrid, "CreateVertexData");
 
-        uint32_t index, layer, region_x, region_y;
-        DecodeGridAndLayer(buf[*begin].m_UserData, index, layer, region_x, region_y);
-        TileGridComponent* first = world->m_Components[index];
-        assert(first->m_Enabled);
+        for (uint32_t* i = begin; i != end; ++i)
+        {
+            uint32_t index, layer, region_x, region_y;
+            DecodeGridAndLayer(buf[*i].m_UserData, index, layer, region_x, region_y);
 
-        TileGridResource* resource = first->m_Resource;
-        TextureSetResource* texture_set = GetTextureSet(first);
+            const TileGridComponent* component = world->m_Components[index];
+            where = CreateRegionVertexData(component, component->m_World, texture_set->m_TextureSet, layer, region_x, region_y, where, world->m_VertexBufferDataEnd);
+            if (!where)
+            {
+                dmLogError("Out of tiles to render (%zu). You can change this with the game.project setting tilemap.max_tile_count", (size_t)((world->m_VertexBufferDataEnd - world->m_VertexBufferData) / 6));
+                return world->m_VertexBufferDataEnd;
+            }
+        }
+        return where;
+    }
 
-        dmRender::RenderObject& ro = *world->m_RenderObjects.End();
-        world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
+    static inline bool IsLocalVertexSpace(const TileGridComponent* component)
+    {
+        return dmRender::GetMaterialVertexSpace(GetMaterial(component)) == dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL;
+    }
 
-        // Fill in vertex buffer
-        TileGridVertex* vb_begin = world->m_VertexBufferWritePtr;
-        world->m_VertexBufferWritePtr = CreateVertexData(world, vb_begin, texture_set, buf, begin, end);
+    static inline uint32_t* GetRegionLayerOffsets(TileGridComponent* component, uint32_t region_index)
+    {
+        return &component->m_RegionLayerOffsets[region_index * (component->m_Layers.Size() + 1)];
+    }
 
-        ro.Init();
-        ro.m_VertexDeclaration = world->m_VertexDeclaration;
-        ro.m_VertexBuffer = world->m_VertexBuffer;
-        ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
-        ro.m_VertexStart = vb_begin - world->m_VertexBufferData;
-        ro.m_VertexCount = (world->m_VertexBufferWritePtr - vb_begin);
-        ro.m_Material = GetMaterial(first);
-        ro.m_Textures[0] = texture_set->m_Texture;
+    // Rebuilds the vertex buffers of the regions whose tiles changed. The vertices are in tile grid space
+    // and the buffers are kept between frames, so static tile maps cost no vertex work per frame.
+    static void UpdateRegionVertexBuffers(TileGridWorld* world, TileGridComponent* component)
+    {
+        DM_PROFILE(TileGrid, "UpdateRegionVertexBuffers");
 
-        if (first->m_RenderConstants) {
-            dmGameSystem::EnableRenderObjectConstants(&ro, first->m_RenderConstants);
+        const dmGameSystemDDF::TextureSet* texture_set_ddf = GetTextureSet(component)->m_TextureSet;
+        uint32_t n_layers = component->m_Layers.Size();
+
+        dmArray<TileGridVertex>& vertices = world->m_RegionVertexData;
+        uint32_t max_vertex_count = n_layers * TILEGRID_REGION_SIZE * TILEGRID_REGION_SIZE * 6;
+        if (vertices.Capacity() < max_vertex_count)
+        {
+            vertices.SetCapacity(max_vertex_count);
+        }
+
+        uint32_t uploaded = 0;
+        for (uint32_t y = 0, region_index = 0; y < component->m_RegionsY; ++y) {
+            for (uint32_t x = 0; x < component->m_RegionsX; ++x, ++region_index) {
+                TileGridRegion* region = &component->m_Regions[region_index];
+                if (!region->m_VertexDirty) {
+                    continue;
+                }
+                region->m_VertexDirty = 0;
+
+                uint32_t* offsets = GetRegionLayerOffsets(component, region_index);
+                TileGridVertex* where = vertices.Begin();
+                for (uint32_t l = 0; l < n_layers; ++l)
+                {
+                    offsets[l] = where - vertices.Begin();
+                    where = CreateRegionVertexData(component, Matrix4::identity(), texture_set_ddf, l, x, y, where, vertices.Begin() + vertices.Capacity());
+                }
+                offsets[n_layers] = where - vertices.Begin();
+
+                uint32_t size = offsets[n_layers] * sizeof(TileGridVertex);
+                if (!region->m_VertexBuffer) {
+                    region->m_VertexBuffer = dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(world->m_RenderContext), size, vertices.Begin(), dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+                } else {
+                    dmGraphics::SetVertexBufferData(region->m_VertexBuffer, size, vertices.Begin(), dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+                }
+                uploaded += size;
+            }
         }
+        DM_COUNTER("TileGridRegionUpload", uploaded);
+    }
 
-        dmGameSystemDDF::TileGrid::BlendMode blend_mode = resource->m_TileGrid->m_BlendMode;
+    static void SetBlendFactors(dmRender::RenderObject& ro, dmGameSystemDDF::TileGrid::BlendMode blend_mode)
+    {
         switch (blend_mode)
         {
             case dmGameSystemDDF::TileGrid::BLEND_MODE_ALPHA:
@@ -663,6 +776,84 @@ namespace dmGameSystem
         }
 
         ro.m_SetBlendFactors = 1;
+    }
+
+    // Each region layer is drawn from the persistent vertex buffer of its region
+    static void RenderBatchLocalVS(TileGridWorld* world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(TileGrid, "RenderBatchLocal");
+
+        for (uint32_t* i = begin; i != end; ++i)
+        {
+            uint32_t index, layer, region_x, region_y;
+            DecodeGridAndLayer(buf[*i].m_UserData, index, layer, region_x, region_y);
+            TileGridComponent* component = world->m_Components[index];
+
+            uint32_t region_index = region_y * component->m_RegionsX + region_x;
+            const uint32_t* offsets = GetRegionLayerOffsets(component, region_index);
+
+            dmRender::RenderObject& ro = *world->m_RenderObjects.End();
+            world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
+
+            ro.Init();
+            ro.m_VertexDeclaration = world->m_VertexDeclaration;
+            ro.m_VertexBuffer = component->m_Regions[region_index].m_VertexBuffer;
+            ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
+            ro.m_VertexStart = offsets[layer];
+            ro.m_VertexCount = offsets[layer + 1] - offsets[layer];
+            ro.m_Material = GetMaterial(component);
+            ro.m_Textures[0] = GetTextureSet(component)->m_Texture;
+            ro.m_WorldTransform = component->m_World;
+
+            if (component->m_RenderConstants) {
+                dmGameSystem::EnableRenderObjectConstants(&ro, component->m_RenderConstants);
+            }
+
+            SetBlendFactors(ro, component->m_Resource->m_TileGrid->m_BlendMode);
+
+            dmRender::AddToRender(render_context, &ro);
+        }
+    }
+
+    static void RenderBatch(TileGridWorld* world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(TileGrid, "RenderBatch");
+
+        uint32_t index, layer, region_x, region_y;
+        DecodeGridAndLayer(buf[*begin].m_UserData, index, layer, region_x, region_y);
+        TileGridComponent* first = world->m_Components[index];
+        assert(first->m_Enabled);
+
+        if (IsLocalVertexSpace(first))
+        {
+            RenderBatchLocalVS(world, render_context, buf, begin, end);
+            return;
+        }
+
+        TileGridResource* resource = first->m_Resource;
+        TextureSetResource* texture_set = GetTextureSet(first);
+
+        dmRender::RenderObject& ro = *world->m_RenderObjects.End();
+        world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
+
+        // Fill in vertex buffer
+        TileGridVertex* vb_begin = world->m_VertexBufferWritePtr;
+        world->m_VertexBufferWritePtr = CreateVertexData(world, vb_begin, texture_set, buf, begin, end);
+
+        ro.Init();
+        ro.m_VertexDeclaration = world->m_VertexDeclaration;
+        ro.m_VertexBuffer = world->m_VertexBuffer;
+        ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
+        ro.m_VertexStart = vb_begin - world->m_VertexBufferData;
+        ro.m_VertexCount = (world->m_VertexBufferWritePtr - vb_begin);
+        ro.m_Material = GetMaterial(first);
+        ro.m_Textures[0] = texture_set->m_Texture;
+
+        if (first->m_RenderConstants) {
+            dmGameSystem::EnableRenderObjectConstants(&ro, first->m_RenderConstants);
+        }
+
+        SetBlendFactors(ro, resource->m_TileGrid->m_BlendMode);
 
         dmRender::AddToRender(render_context, &ro);
     }
@@ -676,12 +867,12 @@ namespace dmGameSystem
         case dmRender::RENDER_LIST_OPERATION_BEGIN:
             world->m_VertexBufferWritePtr = world->m_VertexBufferData;
             world->m_RenderObjects.SetSize(0);
+            world->m_VertexBuffer = dmGraphics::AcquireDynamicVertexBuffer(world->m_DynamicVertexBuffer);
             break;
 
         case dmRender::RENDER_LIST_OPERATION_END:
-            dmGraphics::SetVertexBufferData(world->m_VertexBuffer, 0, 0, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
-            dmGraphics::SetVertexBufferData(world->m_VertexBuffer, sizeof(TileGridVertex) * (world->m_VertexBufferWritePtr - world->m_VertexBufferData),
-                                            world->m_VertexBufferData, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+            dmGraphics::SetDynamicVertexBufferData(world->m_DynamicVertexBuffer, sizeof(TileGridVertex) * (world->m_VertexBufferWritePtr - world->m_VertexBufferData),
+                                                   world->m_VertexBufferData);
             DM_COUNTER("TileGridVertexBuffer", (world->m_VertexBufferWritePtr - world->m_VertexBufferData) * sizeof(TileGridVertex));
             DM_COUNTER("TileGridTileCount", (world->m_VertexBufferWritePtr - world->m_VertexBufferData));
             break;
@@ -753,6 +944,12 @@ namespace dmGameSystem
                 ReHash(component);
             }
 
+            bool local_space = IsLocalVertexSpace(component);
+            if (local_space)
+            {
+                UpdateRegionVertexBuffers(world, component);
+            }
+
             TileGridResource* resource = component->m_Resource;
             dmGameSystemDDF::TextureSet* texture_set_ddf = GetTextureSet(component)->m_TextureSet;
             dmGameSystemDDF::TileGrid* tile_grid_ddf = resource->m_TileGrid;
@@ -775,6 +972,11 @@ namespace dmGameSystem
                         if (!region->m_Occupied) {
                             continue;
                         }
+                        if (local_space) {
+                            const uint32_t* offsets = GetRegionLayerOffsets(component, region_index);
+                            if (offsets[l] == offsets[l + 1])
+                                continue;
+                        }
 
                         Vector4 trans = component->m_World * Point3(x * tile_width, y * tile_height, layer_ddf->m_Z);
 
@@ -784,6 +986,7 @@ namespace dmGameSystem
                         write_ptr->m_BatchKey = component->m_MixedHash;
                         write_ptr->m_Dispatch = dispatch;
                         write_ptr->m_MinorOrder = 0;
+                        write_ptr->m_Layer = component->m_RenderLayer;
                         write_ptr->m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
                         ++write_ptr;
                     }
@@ -941,6 +1144,11 @@ namespace dmGameSystem
         {
             return GetResourceProperty(dmGameObject::GetFactory(params.m_Instance), GetTextureSet(component), out_value);
         }
+        if (params.m_PropertyId == PROP_LAYER)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar((float)component->m_RenderLayer);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
         return GetMaterialConstant(GetMaterial(component), params.m_PropertyId, out_value, true, CompTileGridGetConstantCallback, component);
     }
 
@@ -953,7 +1161,15 @@ namespace dmGameSystem
         }
         if (params.m_PropertyId == PROP_TILE_SOURCE)
         {
-            return SetResourceProperty(dmGameObject::GetFactory(params.m_Instance), params.m_Value, TEXTURE_SET_EXT_HASH, (void**)&component->m_TextureSet);
+            dmGameObject::PropertyResult res = SetResourceProperty(dmGameObject::GetFactory(params.m_Instance), params.m_Value, TEXTURE_SET_EXT_HASH, (void**)&component->m_TextureSet);
+            // The texture coordinates are baked into the region vertex buffers
+            if (res == dmGameObject::PROPERTY_RESULT_OK)
+                SetRegionsVertexDirty(component);
+            return res;
+        }
+        if (params.m_PropertyId == PROP_LAYER)
+        {
+            return SetLayerProperty(params.m_Value, &component->m_RenderLayer);
         }
         return SetMaterialConstant(GetMaterial(component), params.m_PropertyId, params.m_Value, CompTileGridSetConstantCallback, component);
     }
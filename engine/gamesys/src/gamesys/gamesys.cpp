@@ -54,6 +54,7 @@
 #include "resources/res_rig_scene.h"
 #include "resources/res_display_profiles.h"
 #include "resources/res_label.h"
+#include "resources/res_stub.h"
 
 #include "components/comp_private.h"
 #include "components/comp_collection_proxy.h"
@@ -71,6 +72,7 @@
 #include "components/comp_sprite.h"
 #include "components/comp_tilegrid.h"
 #include "components/comp_label.h"
+#include "components/comp_stub.h"
 
 namespace dmGameSystem
 {
@@ -84,7 +86,14 @@ namespace dmGameSystem
         m_Worlds.SetCapacity(128);
     }
 
-    dmResource::Result RegisterResourceTypes(dmResource::HFactory factory, dmRender::HRenderContext render_context, GuiContext* gui_context, dmInput::HContext input_context, PhysicsContext* physics_context)
+    // Nothing is rendered or played by a headless server. These types are replaced with stubs, which
+    // don't load the data or the resources they refer to, e.g. the fonts and sounds
+    static const char* SERVER_STUB_TYPES[] = {
+        "fontc", "meshc", "modelc", "guic", "gui_scriptc", "wavc", "oggc", "soundc", "camerac",
+        "labelc", "lightc", "render_scriptc", "renderc", "spritec", "emitterc", "particlefxc", "display_profilesc"
+    };
+
+    dmResource::Result RegisterResourceTypes(dmResource::HFactory factory, dmRender::HRenderContext render_context, GuiContext* gui_context, dmInput::HContext input_context, PhysicsContext* physics_context, bool headless_server)
     {
         dmResource::Result e;
 
@@ -101,45 +110,97 @@ namespace dmGameSystem
         dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
 
         REGISTER_RESOURCE_TYPE("collectionproxyc", 0, 0, ResCollectionProxyCreate, 0, ResCollectionProxyDestroy, ResCollectionProxyRecreate);
-        REGISTER_RESOURCE_TYPE("collisionobjectc", physics_context, 0, ResCollisionObjectCreate, 0, ResCollisionObjectDestroy, ResCollisionObjectRecreate);
+        REGISTER_RESOURCE_TYPE("collisionobjectc", physics_context, ResCollisionObjectPreload, ResCollisionObjectCreate, 0, ResCollisionObjectDestroy, ResCollisionObjectRecreate);
         REGISTER_RESOURCE_TYPE("convexshapec", physics_context, 0, ResConvexShapeCreate, 0, ResConvexShapeDestroy, ResConvexShapeRecreate);
-        REGISTER_RESOURCE_TYPE("emitterc", 0, 0, ResEmitterCreate, 0,ResEmitterDestroy, ResEmitterRecreate);
-        REGISTER_RESOURCE_TYPE("particlefxc", 0, ResParticleFXPreload, ResParticleFXCreate, 0, ResParticleFXDestroy, ResParticleFXRecreate);
-        REGISTER_RESOURCE_TYPE("texturec", graphics_context, ResTexturePreload, ResTextureCreate, ResTexturePostCreate, ResTextureDestroy, ResTextureRecreate);
         REGISTER_RESOURCE_TYPE("vpc", graphics_context, ResVertexProgramPreload, ResVertexProgramCreate, 0, ResVertexProgramDestroy, ResVertexProgramRecreate);
         REGISTER_RESOURCE_TYPE("fpc", graphics_context, ResFragmentProgramPreload, ResFragmentProgramCreate, 0, ResFragmentProgramDestroy, ResFragmentProgramRecreate);
-        REGISTER_RESOURCE_TYPE("fontc", render_context, ResFontMapPreload, ResFontMapCreate, 0, ResFontMapDestroy, ResFontMapRecreate);
         REGISTER_RESOURCE_TYPE("bufferc", graphics_context, ResBufferPreload, ResBufferCreate, 0, ResBufferDestroy, ResBufferRecreate);
-        REGISTER_RESOURCE_TYPE("meshc", graphics_context, ResMeshPreload, ResMeshCreate, 0, ResMeshDestroy, ResMeshRecreate);
-        REGISTER_RESOURCE_TYPE("modelc", graphics_context, ResModelPreload, ResModelCreate, 0, ResModelDestroy, ResModelRecreate);
         REGISTER_RESOURCE_TYPE("materialc", render_context, ResMaterialPreload, ResMaterialCreate, 0, ResMaterialDestroy, ResMaterialRecreate);
-        REGISTER_RESOURCE_TYPE("guic", gui_context, ResPreloadSceneDesc, ResCreateSceneDesc, 0, ResDestroySceneDesc, ResRecreateSceneDesc);
-        REGISTER_RESOURCE_TYPE("gui_scriptc", gui_context, ResPreloadGuiScript, ResCreateGuiScript, 0, ResDestroyGuiScript, ResRecreateGuiScript);
-        REGISTER_RESOURCE_TYPE("wavc", 0, 0, ResSoundDataCreate, 0, ResSoundDataDestroy, ResSoundDataRecreate);
-        REGISTER_RESOURCE_TYPE("oggc", 0, 0, ResSoundDataCreate, 0, ResSoundDataDestroy, ResSoundDataRecreate);
-        REGISTER_RESOURCE_TYPE("soundc", 0, ResSoundPreload, ResSoundCreate, 0, ResSoundDestroy, ResSoundRecreate);
-        REGISTER_RESOURCE_TYPE("camerac", 0, 0, ResCameraCreate, 0, ResCameraDestroy, ResCameraRecreate);
         REGISTER_RESOURCE_TYPE("input_bindingc", input_context, 0, ResInputBindingCreate, 0, ResInputBindingDestroy, ResInputBindingRecreate);
         REGISTER_RESOURCE_TYPE("gamepadsc", 0, 0, ResGamepadMapCreate, 0, ResGamepadMapDestroy, ResGamepadMapRecreate);
         REGISTER_RESOURCE_TYPE("factoryc", 0, ResFactoryPreload, ResFactoryCreate, 0, ResFactoryDestroy, ResFactoryRecreate);
         REGISTER_RESOURCE_TYPE("collectionfactoryc", 0, ResCollectionFactoryPreload, ResCollectionFactoryCreate, 0, ResCollectionFactoryDestroy, ResCollectionFactoryRecreate);
-        REGISTER_RESOURCE_TYPE("labelc", 0, ResLabelPreload, ResLabelCreate, 0, ResLabelDestroy, ResLabelRecreate);
-        REGISTER_RESOURCE_TYPE("lightc", 0, 0, ResLightCreate, 0, ResLightDestroy, ResLightRecreate);
-        REGISTER_RESOURCE_TYPE("render_scriptc", render_context, 0, ResRenderScriptCreate, 0, ResRenderScriptDestroy, ResRenderScriptRecreate);
-        REGISTER_RESOURCE_TYPE("renderc", render_context, 0, ResRenderPrototypeCreate, 0, ResRenderPrototypeDestroy, ResRenderPrototypeRecreate);
-        REGISTER_RESOURCE_TYPE("spritec", 0, ResSpritePreload, ResSpriteCreate, 0, ResSpriteDestroy, ResSpriteRecreate);
         REGISTER_RESOURCE_TYPE("texturesetc", physics_context, ResTextureSetPreload, ResTextureSetCreate, 0, ResTextureSetDestroy, ResTextureSetRecreate);
         REGISTER_RESOURCE_TYPE(TILE_MAP_EXT, physics_context, ResTileGridPreload, ResTileGridCreate, 0, ResTileGridDestroy, ResTileGridRecreate);
         REGISTER_RESOURCE_TYPE("meshsetc", 0, ResMeshSetPreload, ResMeshSetCreate, 0, ResMeshSetDestroy, ResMeshSetRecreate);
         REGISTER_RESOURCE_TYPE("skeletonc", 0, ResSkeletonPreload, ResSkeletonCreate, 0, ResSkeletonDestroy, ResSkeletonRecreate);
         REGISTER_RESOURCE_TYPE("rigscenec", 0, ResRigScenePreload, ResRigSceneCreate, 0, ResRigSceneDestroy, ResRigSceneRecreate);
-        REGISTER_RESOURCE_TYPE("display_profilesc", render_context, 0, ResDisplayProfilesCreate, 0, ResDisplayProfilesDestroy, ResDisplayProfilesRecreate);
+
+        if (headless_server)
+        {
+            // Texture sets and tile maps need the size of their texture, for the collision shapes
+            REGISTER_RESOURCE_TYPE("texturec", graphics_context, 0, ResTextureBlankCreate, 0, ResTextureDestroy, ResTextureBlankRecreate);
+            for (uint32_t i = 0; i < DM_ARRAY_SIZE(SERVER_STUB_TYPES); ++i)
+            {
+                REGISTER_RESOURCE_TYPE(SERVER_STUB_TYPES[i], 0, 0, ResStubCreate, 0, ResStubDestroy, ResStubRecreate);
+            }
+        }
+        else
+        {
+            REGISTER_RESOURCE_TYPE("emitterc", 0, 0, ResEmitterCreate, 0,ResEmitterDestroy, ResEmitterRecreate);
+            REGISTER_RESOURCE_TYPE("particlefxc", 0, ResParticleFXPreload, ResParticleFXCreate, 0, ResParticleFXDestroy, ResParticleFXRecreate);
+            REGISTER_RESOURCE_TYPE("texturec", graphics_context, ResTexturePreload, ResTextureCreate, ResTexturePostCreate, ResTextureDestroy, ResTextureRecreate);
+            REGISTER_RESOURCE_TYPE("fontc", render_context, ResFontMapPreload, ResFontMapCreate, 0, ResFontMapDestroy, ResFontMapRecreate);
+            REGISTER_RESOURCE_TYPE("meshc", graphics_context, ResMeshPreload, ResMeshCreate, 0, ResMeshDestroy, ResMeshRecreate);
+            REGISTER_RESOURCE_TYPE("modelc", graphics_context, ResModelPreload, ResModelCreate, 0, ResModelDestroy, ResModelRecreate);
+            REGISTER_RESOURCE_TYPE("guic", gui_context, ResPreloadSceneDesc, ResCreateSceneDesc, 0, ResDestroySceneDesc, ResRecreateSceneDesc);
+            REGISTER_RESOURCE_TYPE("gui_scriptc", gui_context, ResPreloadGuiScript, ResCreateGuiScript, 0, ResDestroyGuiScript, ResRecreateGuiScript);
+            REGISTER_RESOURCE_TYPE("wavc", 0, 0, ResSoundDataCreate, 0, ResSoundDataDestroy, ResSoundDataRecreate);
+            REGISTER_RESOURCE_TYPE("oggc", 0, 0, ResSoundDataCreate, 0, ResSoundDataDestroy, ResSoundDataRecreate);
+            REGISTER_RESOURCE_TYPE("soundc", 0, ResSoundPreload, ResSoundCreate, 0, ResSoundDestroy, ResSoundRecreate);
+            REGISTER_RESOURCE_TYPE("camerac", 0, 0, ResCameraCreate, 0, ResCameraDestroy, ResCameraRecreate);
+            REGISTER_RESOURCE_TYPE("labelc", 0, ResLabelPreload, ResLabelCreate, 0, ResLabelDestroy, ResLabelRecreate);
+            REGISTER_RESOURCE_TYPE("lightc", 0, 0, ResLightCreate, 0, ResLightDestroy, ResLightRecreate);
+            REGISTER_RESOURCE_TYPE("render_scriptc", render_context, 0, ResRenderScriptCreate, 0, ResRenderScriptDestroy, ResRenderScriptRecreate);
+            REGISTER_RESOURCE_TYPE("renderc", render_context, 0, ResRenderPrototypeCreate, 0, ResRenderPrototypeDestroy, ResRenderPrototypeRecreate);
+            REGISTER_RESOURCE_TYPE("spritec", 0, ResSpritePreload, ResSpriteCreate, 0, ResSpriteDestroy, ResSpriteRecreate);
+            REGISTER_RESOURCE_TYPE("display_profilesc", render_context, 0, ResDisplayProfilesCreate, 0, ResDisplayProfilesDestroy, ResDisplayProfilesRecreate);
+        }
 
 #undef REGISTER_RESOURCE_TYPE
 
+        // Types whose create function doesn't need the main thread (unless they hint other resources)
+        dmResource::SetTypeFlags(factory, "collisionobjectc", RESOURCE_TYPE_FLAGS_THREAD_SAFE_CREATE);
+        dmResource::SetTypeFlags(factory, "meshsetc", RESOURCE_TYPE_FLAGS_THREAD_SAFE_CREATE);
+
+        // Types that only read the loaded data, or keep it as is, may use it directly from a memory mapped archive
+        dmResource::SetTypeFlags(factory, "texturec", RESOURCE_TYPE_FLAGS_MAPPED_BUFFER);
+        dmResource::SetTypeFlags(factory, "bufferc", RESOURCE_TYPE_FLAGS_MAPPED_BUFFER);
+        dmResource::SetTypeFlags(factory, "wavc", RESOURCE_TYPE_FLAGS_MAPPED_BUFFER);
+        dmResource::SetTypeFlags(factory, "oggc", RESOURCE_TYPE_FLAGS_MAPPED_BUFFER);
+
+        // Types that can apply partial updates in-place, instead of being fully reloaded
+        dmResource::SetPatchFunction(factory, TILE_MAP_EXT, ResTileGridPatch);
+        if (!headless_server)
+        {
+            dmResource::SetPatchFunction(factory, "texturec", ResTexturePatch);
+        }
+
         return e;
     }
 
+    struct StubComponentType
+    {
+        const char* m_Extension;
+        uint16_t    m_Prio;
+    };
+
+    // The component types that are replaced with stubs on a headless server, with their update priorities
+    static const StubComponentType SERVER_STUB_COMPONENT_TYPES[] = {
+        {"guic", 300}, {"camerac", 500}, {"soundc", 600}, {"modelc", 700}, {"meshc", 725},
+        {"emitterc", 750}, {"particlefxc", 800}, {"lightc", 1000}, {"spritec", 1100}, {"labelc", 1400}
+    };
+
+    static void SetUpdateDependencies(dmResource::HFactory factory, dmGameObject::HRegister regist, const char* extension, uint32_t dependencies)
+    {
+        dmResource::ResourceType type;
+        if (dmResource::GetTypeFromExtension(factory, extension, &type) != dmResource::RESULT_OK)
+            return;
+        dmGameObject::ComponentType* component_type = dmGameObject::FindComponentType(regist, type, 0x0);
+        if (component_type)
+            dmGameObject::ComponentTypeSetUpdateDependencies(component_type, dependencies);
+    }
+
     dmGameObject::Result RegisterComponentTypes(dmResource::HFactory factory,
                                                 dmGameObject::HRegister regist,
                                                 dmRender::HRenderContext render_context,
@@ -154,7 +215,8 @@ namespace dmGameSystem
                                                 MeshContext* mesh_context,
                                                 LabelContext* label_context,
                                                 TilemapContext* tilemap_context,
-                                                SoundContext* sound_context)
+                                                SoundContext* sound_context,
+                                                bool headless_server)
     {
         dmResource::ResourceType type;
         dmGameObject::ComponentType component_type;
@@ -219,14 +281,6 @@ namespace dmGameSystem
         // Priority 200 is reserved for scriptc (read+write transforms)
         // Priority 250 is reserved for animc (read+write transforms)
 
-        REGISTER_COMPONENT_TYPE("guic", 300, gui_context,
-                CompGuiNewWorld, CompGuiDeleteWorld,
-                CompGuiCreate, CompGuiDestroy, CompGuiInit, CompGuiFinal, CompGuiAddToUpdate, 0,
-                CompGuiUpdate, CompGuiRender, 0, CompGuiOnMessage, CompGuiOnInput,
-                CompGuiOnReload, CompGuiGetProperty, CompGuiSetProperty,
-                CompGuiIterChildren, CompGuiIterProperties,
-                0);
-
         REGISTER_COMPONENT_TYPE("collisionobjectc", 400, physics_context,
                 &CompCollisionObjectNewWorld, &CompCollisionObjectDeleteWorld,
                 &CompCollisionObjectCreate, &CompCollisionObjectDestroy, 0, &CompCollisionObjectFinal, &CompCollisionObjectAddToUpdate, 0,
@@ -235,54 +289,6 @@ namespace dmGameSystem
                 0, 0,
                 1);
 
-        REGISTER_COMPONENT_TYPE("camerac", 500, render_context,
-                &CompCameraNewWorld, &CompCameraDeleteWorld,
-                &CompCameraCreate, &CompCameraDestroy, 0, 0, &CompCameraAddToUpdate, 0,
-                &CompCameraUpdate, 0, 0, &CompCameraOnMessage, 0,
-                &CompCameraOnReload, 0, 0,
-                0, 0,
-                1);
-
-        REGISTER_COMPONENT_TYPE("soundc", 600, sound_context,
-                CompSoundNewWorld, CompSoundDeleteWorld,
-                CompSoundCreate, CompSoundDestroy, 0, 0, CompSoundAddToUpdate, 0,
-                CompSoundUpdate, 0, 0, CompSoundOnMessage, 0,
-                0, CompSoundGetProperty, CompSoundSetProperty,
-                0, 0,
-                0);
-
-        REGISTER_COMPONENT_TYPE("modelc", 700, model_context,
-                CompModelNewWorld, CompModelDeleteWorld,
-                CompModelCreate, CompModelDestroy, 0, 0, CompModelAddToUpdate, 0,
-                CompModelUpdate, CompModelRender, 0, CompModelOnMessage, 0,
-                0, CompModelGetProperty, CompModelSetProperty,
-                0, 0,
-                0);
-
-        REGISTER_COMPONENT_TYPE("meshc", 725, mesh_context,
-                CompMeshNewWorld, CompMeshDeleteWorld,
-                CompMeshCreate, CompMeshDestroy, 0, 0, CompMeshAddToUpdate, 0,
-                CompMeshUpdate, CompMeshRender, 0, CompMeshOnMessage, 0,
-                0, CompMeshGetProperty, CompMeshSetProperty,
-                0, 0,
-                0);
-
-        REGISTER_COMPONENT_TYPE("emitterc", 750, 0x0,
-                &CompEmitterNewWorld, &CompEmitterDeleteWorld,
-                &CompEmitterCreate, &CompEmitterDestroy, 0, 0, 0, 0,
-                0, 0, 0, CompEmitterOnMessage, 0,
-                0, 0, 0,
-                0, 0,
-                0);
-
-        REGISTER_COMPONENT_TYPE("particlefxc", 800, particlefx_context,
-                &CompParticleFXNewWorld, &CompParticleFXDeleteWorld,
-                &CompParticleFXCreate, &CompParticleFXDestroy, 0, 0, &CompParticleFXAddToUpdate, 0,
-                &CompParticleFXUpdate, &CompParticleFXRender, 0, &CompParticleFXOnMessage, 0,
-                &CompParticleFXOnReload, 0, 0,
-                0, 0,
-                1);
-
         REGISTER_COMPONENT_TYPE("factoryc", 900, factory_context,
                 CompFactoryNewWorld, CompFactoryDeleteWorld,
                 CompFactoryCreate, CompFactoryDestroy, 0, 0, CompFactoryAddToUpdate, 0,
@@ -299,22 +305,6 @@ namespace dmGameSystem
                 0, 0,
                 0);
 
-        REGISTER_COMPONENT_TYPE("lightc", 1000, render_context,
-                CompLightNewWorld, CompLightDeleteWorld,
-                CompLightCreate, CompLightDestroy, 0, 0, CompLightAddToUpdate, 0,
-                CompLightUpdate, 0, 0, CompLightOnMessage, 0,
-                0, 0, 0,
-                0, 0,
-                1);
-
-        REGISTER_COMPONENT_TYPE("spritec", 1100, sprite_context,
-                CompSpriteNewWorld, CompSpriteDeleteWorld,
-                CompSpriteCreate, CompSpriteDestroy, 0, 0, CompSpriteAddToUpdate, 0,
-                CompSpriteUpdate, CompSpriteRender, 0, CompSpriteOnMessage, 0,
-                CompSpriteOnReload, CompSpriteGetProperty, CompSpriteSetProperty,
-                0, CompSpriteIterProperties,
-                1);
-
         REGISTER_COMPONENT_TYPE(TILE_MAP_EXT, 1200, tilemap_context,
                 CompTileGridNewWorld, CompTileGridDeleteWorld,
                 CompTileGridCreate, CompTileGridDestroy, 0, 0, CompTileGridAddToUpdate, 0,
@@ -322,14 +312,113 @@ namespace dmGameSystem
                 CompTileGridOnReload, CompTileGridGetProperty, CompTileGridSetProperty,
                 0, 0,
                 1);
-
-        REGISTER_COMPONENT_TYPE("labelc", 1400, label_context,
-                CompLabelNewWorld, CompLabelDeleteWorld,
-                CompLabelCreate, CompLabelDestroy, 0, 0, CompLabelAddToUpdate, CompLabelGetComponent,
-                CompLabelUpdate, CompLabelRender, 0, CompLabelOnMessage, 0,
-                CompLabelOnReload, CompLabelGetProperty, CompLabelSetProperty,
-                0, 0,
-                1);
+        SetUpdateDependencies(factory, regist, TILE_MAP_EXT, dmGameObject::COMPONENT_UPDATE_DEPENDENCY_READS_TRANSFORMS);
+
+        if (headless_server)
+        {
+            for (uint32_t i = 0; i < DM_ARRAY_SIZE(SERVER_STUB_COMPONENT_TYPES); ++i)
+            {
+                REGISTER_COMPONENT_TYPE(SERVER_STUB_COMPONENT_TYPES[i].m_Extension, SERVER_STUB_COMPONENT_TYPES[i].m_Prio, 0x0,
+                        0, 0,
+                        CompStubCreate, CompStubDestroy, 0, 0, 0, 0,
+                        0, 0, 0, CompStubOnMessage, 0,
+                        0, 0, CompStubSetProperty,
+                        0, 0,
+                        0);
+            }
+        }
+        else
+        {
+            REGISTER_COMPONENT_TYPE("guic", 300, gui_context,
+                    CompGuiNewWorld, CompGuiDeleteWorld,
+                    CompGuiCreate, CompGuiDestroy, CompGuiInit, CompGuiFinal, CompGuiAddToUpdate, 0,
+                    CompGuiUpdate, CompGuiRender, 0, CompGuiOnMessage, CompGuiOnInput,
+                    CompGuiOnReload, CompGuiGetProperty, CompGuiSetProperty,
+                    CompGuiIterChildren, CompGuiIterProperties,
+                    0);
+
+            REGISTER_COMPONENT_TYPE("camerac", 500, render_context,
+                    &CompCameraNewWorld, &CompCameraDeleteWorld,
+                    &CompCameraCreate, &CompCameraDestroy, 0, 0, &CompCameraAddToUpdate, 0,
+                    &CompCameraUpdate, 0, 0, &CompCameraOnMessage, 0,
+                    &CompCameraOnReload, &CompCameraGetProperty, &CompCameraSetProperty,
+                    0, 0,
+                    1);
+
+            REGISTER_COMPONENT_TYPE("soundc", 600, sound_context,
+                    CompSoundNewWorld, CompSoundDeleteWorld,
+                    CompSoundCreate, CompSoundDestroy, 0, 0, CompSoundAddToUpdate, 0,
+                    CompSoundUpdate, 0, 0, CompSoundOnMessage, 0,
+                    0, CompSoundGetProperty, CompSoundSetProperty,
+                    0, 0,
+                    0);
+
+            REGISTER_COMPONENT_TYPE("modelc", 700, model_context,
+                    CompModelNewWorld, CompModelDeleteWorld,
+                    CompModelCreate, CompModelDestroy, 0, 0, CompModelAddToUpdate, 0,
+                    CompModelUpdate, CompModelRender, 0, CompModelOnMessage, 0,
+                    0, CompModelGetProperty, CompModelSetProperty,
+                    0, 0,
+                    0);
+
+            REGISTER_COMPONENT_TYPE("meshc", 725, mesh_context,
+                    CompMeshNewWorld, CompMeshDeleteWorld,
+                    CompMeshCreate, CompMeshDestroy, 0, 0, CompMeshAddToUpdate, 0,
+                    CompMeshUpdate, CompMeshRender, 0, CompMeshOnMessage, 0,
+                    0, CompMeshGetProperty, CompMeshSetProperty,
+                    0, 0,
+                    0);
+
+            REGISTER_COMPONENT_TYPE("emitterc", 750, 0x0,
+                    &CompEmitterNewWorld, &CompEmitterDeleteWorld,
+                    &CompEmitterCreate, &CompEmitterDestroy, 0, 0, 0, 0,
+                    0, 0, 0, CompEmitterOnMessage, 0,
+                    0, 0, 0,
+                    0, 0,
+                    0);
+
+            REGISTER_COMPONENT_TYPE("particlefxc", 800, particlefx_context,
+                    &CompParticleFXNewWorld, &CompParticleFXDeleteWorld,
+                    &CompParticleFXCreate, &CompParticleFXDestroy, 0, 0, &CompParticleFXAddToUpdate, 0,
+                    &CompParticleFXUpdate, &CompParticleFXRender, 0, &CompParticleFXOnMessage, 0,
+                    &CompParticleFXOnReload, 0, 0,
+                    0, 0,
+                    1);
+
+            REGISTER_COMPONENT_TYPE("lightc", 1000, render_context,
+                    CompLightNewWorld, CompLightDeleteWorld,
+                    CompLightCreate, CompLightDestroy, 0, 0, CompLightAddToUpdate, 0,
+                    CompLightUpdate, CompLightRender, 0, CompLightOnMessage, 0,
+                    0, 0, 0,
+                    0, 0,
+                    1);
+
+            REGISTER_COMPONENT_TYPE("spritec", 1100, sprite_context,
+                    CompSpriteNewWorld, CompSpriteDeleteWorld,
+                    CompSpriteCreate, CompSpriteDestroy, 0, 0, CompSpriteAddToUpdate, 0,
+                    CompSpriteUpdate, CompSpriteRender, 0, CompSpriteOnMessage, 0,
+                    CompSpriteOnReload, CompSpriteGetProperty, CompSpriteSetProperty,
+                    0, CompSpriteIterProperties,
+                    1);
+
+            REGISTER_COMPONENT_TYPE("labelc", 1400, label_context,
+                    CompLabelNewWorld, CompLabelDeleteWorld,
+                    CompLabelCreate, CompLabelDestroy, 0, 0, CompLabelAddToUpdate, CompLabelGetComponent,
+                    CompLabelUpdate, CompLabelRender, 0, CompLabelOnMessage, 0,
+                    CompLabelOnReload, CompLabelGetProperty, CompLabelSetProperty,
+                    0, 0,
+                    1);
+
+            // Types whose update may run on a job thread, concurrently with the neighbouring types in update order.
+            // Messages to the render socket aren't dispatched between component updates, and don't count as posted messages.
+            SetUpdateDependencies(factory, regist, "camerac", dmGameObject::COMPONENT_UPDATE_DEPENDENCY_READS_TRANSFORMS);
+            SetUpdateDependencies(factory, regist, "soundc", dmGameObject::COMPONENT_UPDATE_DEPENDENCY_POSTS_MESSAGES | dmGameObject::COMPONENT_UPDATE_DEPENDENCY_RESOURCES);
+            SetUpdateDependencies(factory, regist, "modelc", dmGameObject::COMPONENT_UPDATE_DEPENDENCY_WRITES_TRANSFORMS | dmGameObject::COMPONENT_UPDATE_DEPENDENCY_POSTS_MESSAGES);
+            SetUpdateDependencies(factory, regist, "particlefxc", dmGameObject::COMPONENT_UPDATE_DEPENDENCY_READS_TRANSFORMS | dmGameObject::COMPONENT_UPDATE_DEPENDENCY_RESOURCES | dmGameObject::COMPONENT_UPDATE_DEPENDENCY_LUA);
+            SetUpdateDependencies(factory, regist, "lightc", dmGameObject::COMPONENT_UPDATE_DEPENDENCY_READS_TRANSFORMS);
+            SetUpdateDependencies(factory, regist, "spritec", dmGameObject::COMPONENT_UPDATE_DEPENDENCY_POSTS_MESSAGES);
+            SetUpdateDependencies(factory, regist, "labelc", dmGameObject::COMPONENT_UPDATE_DEPENDENCY_NONE);
+        }
 
         #undef REGISTER_COMPONENT_TYPE
 
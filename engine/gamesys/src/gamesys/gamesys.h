@@ -37,12 +37,21 @@ namespace dmGameSystem
     extern const char* PHYSICS_MAX_COLLISIONS_KEY;
     /// Config key to use for tweaking maximum number of contacts reported
     extern const char* PHYSICS_MAX_CONTACTS_KEY;
+    /// Config key for the frequency of fixed physics steps
+    extern const char* PHYSICS_FIXED_UPDATE_FREQUENCY_KEY;
+    /// Config key for the maximum number of fixed physics steps per frame
+    extern const char* PHYSICS_MAX_FIXED_TIMESTEPS_KEY;
+    /// Config key to interpolate dynamic objects between fixed physics steps
+    extern const char* PHYSICS_INTERPOLATE_KEY;
     /// Config key to use for tweaking maximum number of collection proxies
     extern const char* COLLECTION_PROXY_MAX_COUNT_KEY;
+    extern const char* COLLECTION_PROXY_TIME_BUDGET_KEY;
     /// Config key to use for tweaking maximum number of factories
     extern const char* FACTORY_MAX_COUNT_KEY;
     /// Config key to use for tweaking maximum number of collection factories
     extern const char* COLLECTION_FACTORY_MAX_COUNT_KEY;
+    /// Config key to use for tweaking the time spent initializing deferred collection spawns each frame, in milliseconds
+    extern const char* COLLECTION_FACTORY_INIT_TIME_BUDGET_KEY;
 
     struct TilemapContext
     {
@@ -64,6 +73,8 @@ namespace dmGameSystem
         dmRender::HRenderContext    m_RenderContext;
         uint32_t                    m_MaxLabelCount;
         uint32_t                    m_Subpixels : 1;
+        /// Draw the glyphs instanced if supported by the graphics adapter (requires an instancing label material, see dmRender::GlyphInstance)
+        uint32_t                    m_Instancing : 1;
     };
 
     struct PhysicsContext
@@ -75,8 +86,13 @@ namespace dmGameSystem
         };
         uint32_t m_MaxCollisionCount;
         uint32_t m_MaxContactPointCount;
+        // Steps per second when stepping with a fixed time step, 0 steps once per frame
+        uint32_t m_FixedUpdateFrequency;
+        uint32_t m_MaxFixedTimesteps;
         bool m_Debug;
         bool m_3D;
+        // Interpolate dynamic objects between the fixed steps
+        bool m_Interpolate;
     };
 
     struct ParticleFXContext
@@ -89,7 +105,11 @@ namespace dmGameSystem
         dmRender::HRenderContext m_RenderContext;
         uint32_t m_MaxParticleFXCount;
         uint32_t m_MaxParticleCount;
+        /// How off-screen looping emitters are simulated, see dmParticle::OffscreenUpdate
+        uint32_t m_OffscreenUpdate;
         bool m_Debug;
+        /// Draw the particles instanced if supported by the graphics adapter (requires an instancing particle material)
+        bool m_Instancing;
     };
 
     struct RenderScriptPrototype
@@ -123,6 +143,12 @@ namespace dmGameSystem
         dmRender::HRenderContext    m_RenderContext;
         uint32_t                    m_MaxSpriteCount;
         uint32_t                    m_Subpixels : 1;
+        /// Draw quad sprites instanced if supported by the graphics adapter (requires an instancing sprite material)
+        uint32_t                    m_Instancing : 1;
+        /// Grow the sprite buffers with the number of created sprites, up to m_MaxSpriteCount, instead of allocating them up front
+        uint32_t                    m_GrowOnDemand : 1;
+        /// Write the texture coordinates of the sprite vertices as normalized 16 bit integers instead of floats
+        uint32_t                    m_CompactVertices : 1;
     };
 
     struct ModelContext
@@ -134,6 +160,14 @@ namespace dmGameSystem
         dmRender::HRenderContext    m_RenderContext;
         dmResource::HFactory        m_Factory;
         uint32_t                    m_MaxModelCount;
+        /// Draw models sharing a mesh with one instanced call, requires a material using the instance_* attributes
+        uint32_t                    m_Instancing : 1;
+        /// Distance to the camera beyond which the pose is evaluated less often, 0 disables animation LOD
+        float                       m_AnimationLodDistance;
+        /// Updates per pose evaluation beyond the LOD distance
+        uint32_t                    m_AnimationLodInterval;
+        /// Sample the bone tracks from quantized animations baked once per rig scene, see dmRig::BakeAnimationSet
+        uint32_t                    m_BakedAnimations : 1;
     };
 
     struct SoundContext
@@ -154,6 +188,8 @@ namespace dmGameSystem
         dmRender::HRenderContext    m_RenderContext;
         dmResource::HFactory        m_Factory;
         uint32_t                    m_MaxMeshCount;
+        /// Draw meshes sharing a buffer with one instanced call, requires a material using the instance_* attributes
+        uint32_t                    m_Instancing : 1;
     };
 
     struct ScriptLibContext
@@ -174,6 +210,8 @@ namespace dmGameSystem
         }
         dmResource::HFactory m_Factory;
         uint32_t m_MaxCollectionProxyCount;
+        // Max time spent on async_init, async_final and async_unload each frame, in microseconds
+        uint32_t m_TimeBudget;
     };
 
     struct FactoryContext
@@ -194,17 +232,30 @@ namespace dmGameSystem
         }
         dmScript::HContext m_ScriptContext;
         uint32_t m_MaxCollectionFactoryCount;
+        /// Time spent initializing game objects from collectionfactory.create_deferred each frame, in microseconds
+        uint32_t m_InitTimeBudget;
     };
 
     bool InitializeScriptLibs(const ScriptLibContext& context);
     void FinalizeScriptLibs(const ScriptLibContext& context);
 
+    /**
+     * Register the resource types of the game systems.
+     * A headless server replaces the types that are only used to render or play sound with stubs, which
+     * don't load their data or the resources they refer to. Textures are blank, and only keep their size.
+     */
     dmResource::Result RegisterResourceTypes(dmResource::HFactory factory,
         dmRender::HRenderContext render_context,
         GuiContext* gui_context,
         dmInput::HContext input_context,
-        PhysicsContext* physics_context);
+        PhysicsContext* physics_context,
+        bool headless_server);
 
+    /**
+     * Register the component types of the game systems.
+     * A headless server replaces the types that only render or play sound, e.g. sprites and sounds, with
+     * stubs that ignore their messages and property changes.
+     */
     dmGameObject::Result RegisterComponentTypes(dmResource::HFactory factory,
                                                   dmGameObject::HRegister regist,
                                                   dmRender::HRenderContext render_context,
@@ -219,13 +270,55 @@ namespace dmGameSystem
                                                   MeshContext* Mesh_context,
                                                   LabelContext* label_context,
                                                   TilemapContext* tilemap_context,
-                                                  SoundContext* sound_context);
+                                                  SoundContext* sound_context,
+                                                  bool headless_server);
 
     void GuiGetURLCallback(dmGui::HScene scene, dmMessage::URL* url);
     uintptr_t GuiGetUserDataCallback(dmGui::HScene scene);
     dmhash_t GuiResolvePathCallback(dmGui::HScene scene, const char* path, uint32_t path_size);
     void GuiGetTextMetricsCallback(const void* font, const char* text, float width, bool line_break, float leading, float tracking, dmGui::TextMetrics* out_metrics);
 
+    struct TextureStreamingParams
+    {
+        TextureStreamingParams()
+        {
+            memset(this, 0, sizeof(*this));
+            m_InitialMaxSize = 256;
+            m_EvictFrames = 120;
+        }
+        dmResource::HFactory        m_Factory;
+        dmRender::HRenderContext    m_RenderContext;
+        /// Max bytes of texture data of the streamed textures
+        uint32_t                    m_MemoryBudget;
+        /// Streamed textures are loaded with their mips up to this size in pixels, the larger mips are streamed in when they are drawn
+        uint32_t                    m_InitialMaxSize;
+        /// Frames a texture must go without being drawn before its streamed mips may be dropped
+        uint32_t                    m_EvictFrames;
+    };
+
+    /**
+     * Stream the large mips of 2D textures loaded after this call. Textures are loaded with their
+     * small mips only, and the full mip chain is loaded on a separate thread once the texture is
+     * drawn, within the memory budget. Textures that haven't been drawn for a while lose their
+     * large mips again when the budget is needed for other textures.
+     * @param params streaming parameters
+     */
+    void InitializeTextureStreaming(const TextureStreamingParams& params);
+
+    /// Stop streaming textures. The streamed textures keep their current mips
+    void FinalizeTextureStreaming();
+
+    /// Upload the streamed mips and issue new stream requests. Called once per frame, after rendering
+    void UpdateTextureStreaming();
+
+    /**
+     * Keep the output of the texture transcoder in a directory, so that transcoded textures, e.g. Basis Universal,
+     * are read back on later launches instead of being transcoded again. Files are keyed by the source data and
+     * the target format. Must be set before any texture is loaded.
+     * @param directory cache directory, created if missing. 0 disables the cache
+     */
+    void SetTranscodeCacheDirectory(const char* directory);
+
     void OnWindowFocus(bool focus);
     void OnWindowIconify(bool iconfiy);
     void OnWindowResized(int width, int height);
@@ -46,6 +46,7 @@ namespace dmGameSystem
 
     static const dmhash_t PROP_FONT = dmHashString64("font");
     static const dmhash_t PROP_IMAGE = dmHashString64("image");
+    static const dmhash_t PROP_LAYER = dmHashString64("layer");
     static const dmhash_t PROP_MATERIAL = dmHashString64("material");
     static const dmhash_t PROP_TEXTURE[dmRender::RenderObject::MAX_TEXTURE_COUNT] = {
         dmHashString64("texture0"),
@@ -142,14 +142,11 @@ range_error:
         return 0;
     }
 
-    bool AcquireResources(PhysicsContext* physics_context, dmResource::HFactory factory, const void* buffer, uint32_t buffer_size,
+    // Takes ownership of the ddf
+    bool AcquireResources(PhysicsContext* physics_context, dmResource::HFactory factory, dmPhysicsDDF::CollisionObjectDesc* ddf,
         CollisionObjectResource* resource, const char* filename)
     {
-        dmDDF::Result e = dmDDF::LoadMessage<dmPhysicsDDF::CollisionObjectDesc>(buffer, buffer_size, &resource->m_DDF);
-        if ( e != dmDDF::RESULT_OK )
-        {
-            return false;
-        }
+        resource->m_DDF = ddf;
         resource->m_Group = dmHashString64(resource->m_DDF->m_Group);
         uint32_t mask_count = resource->m_DDF->m_Mask.m_Count;
         if (mask_count > 16)
@@ -302,12 +299,33 @@ range_error:
             dmDDF::FreeMessage(resource->m_DDF);
     }
 
+    dmResource::Result ResCollisionObjectPreload(const dmResource::ResourcePreloadParams& params)
+    {
+        dmPhysicsDDF::CollisionObjectDesc* ddf;
+        dmDDF::Result e = dmDDF::LoadMessage<dmPhysicsDDF::CollisionObjectDesc>(params.m_Buffer, params.m_BufferSize, &ddf);
+        if ( e != dmDDF::RESULT_OK )
+        {
+            return dmResource::RESULT_DDF_ERROR;
+        }
+
+        if (ddf->m_CollisionShape && ddf->m_CollisionShape[0] != '\0')
+        {
+            dmResource::PreloadHint(params.m_HintInfo, ddf->m_CollisionShape);
+        }
+
+        *params.m_PreloadData = ddf;
+        return dmResource::RESULT_OK;
+    }
+
+    // Registered with RESOURCE_TYPE_FLAGS_THREAD_SAFE_CREATE. Collision objects with only embedded shapes
+    // have no hints, and are then created on the loader thread.
     dmResource::Result ResCollisionObjectCreate(const dmResource::ResourceCreateParams& params)
     {
         CollisionObjectResource* collision_object = new CollisionObjectResource();
         memset(collision_object, 0, sizeof(CollisionObjectResource));
         PhysicsContext* physics_context = (PhysicsContext*) params.m_Context;
-        if (AcquireResources(physics_context, params.m_Factory, params.m_Buffer, params.m_BufferSize, collision_object, params.m_Filename))
+        dmPhysicsDDF::CollisionObjectDesc* ddf = (dmPhysicsDDF::CollisionObjectDesc*) params.m_PreloadData;
+        if (AcquireResources(physics_context, params.m_Factory, ddf, collision_object, params.m_Filename))
         {
             params.m_Resource->m_Resource = collision_object;
             return dmResource::RESULT_OK;
@@ -335,7 +353,13 @@ range_error:
         CollisionObjectResource tmp_collision_object;
         memset(&tmp_collision_object, 0, sizeof(CollisionObjectResource));
         PhysicsContext* physics_context = (PhysicsContext*) params.m_Context;
-        if (AcquireResources(physics_context, params.m_Factory, params.m_Buffer, params.m_BufferSize, &tmp_collision_object, params.m_Filename))
+        dmPhysicsDDF::CollisionObjectDesc* ddf;
+        dmDDF::Result e = dmDDF::LoadMessage<dmPhysicsDDF::CollisionObjectDesc>(params.m_Buffer, params.m_BufferSize, &ddf);
+        if ( e != dmDDF::RESULT_OK )
+        {
+            return dmResource::RESULT_FORMAT_ERROR;
+        }
+        if (AcquireResources(physics_context, params.m_Factory, ddf, &tmp_collision_object, params.m_Filename))
         {
             ReleaseResources(physics_context, params.m_Factory, collision_object);
             *collision_object = tmp_collision_object;
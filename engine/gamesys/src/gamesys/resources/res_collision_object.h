@@ -18,6 +18,8 @@
 
 namespace dmGameSystem
 {
+    dmResource::Result ResCollisionObjectPreload(const dmResource::ResourcePreloadParams& params);
+
     dmResource::Result ResCollisionObjectCreate(const dmResource::ResourceCreateParams& params);
 
     dmResource::Result ResCollisionObjectDestroy(const dmResource::ResourceDestroyParams& params);
@@ -110,6 +110,8 @@ namespace dmGameSystem
             {
                 dmLogWarning("Reloading the material failed, some shaders might not have been correctly linked.");
             }
+            // Relinking resets the constant values of the program
+            dmRender::DirtyMaterialConstants(material);
         }
     }
 
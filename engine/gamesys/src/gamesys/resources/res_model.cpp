@@ -13,7 +13,9 @@
 #include "res_model.h"
 #include "res_meshset.h"
 
+#include <float.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
 #include <dlib/path.h>
 #include <dlib/dstrings.h>
 #include <dlib/memory.h>
@@ -22,7 +24,8 @@
 
 namespace dmGameSystem
 {
-    static inline void GetModelVertex(const dmRigDDF::Mesh& mesh, const dmRigDDF::MeshVertexIndices *in, dmRig::RigModelVertex* out)
+    template <typename V>
+    static inline void GetModelVertex(const dmRigDDF::Mesh& mesh, const dmRigDDF::MeshVertexIndices *in, V* out)
     {
         const float* v = &mesh.m_Positions[in->m_Position*3];
         out->x = v[0];
@@ -37,6 +40,40 @@ namespace dmGameSystem
         out->nz = v[2];
     }
 
+    static inline void GetModelVertex(const dmRigDDF::Mesh& mesh, const dmRigDDF::MeshVertexIndices *in, dmRig::RigSkinnedModelVertex* out)
+    {
+        GetModelVertex<dmRig::RigSkinnedModelVertex>(mesh, in, out);
+        // Bone influences are stored per position, four per vertex
+        const uint32_t bi_offset = in->m_Position * 4;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            out->bone_weights[i] = mesh.m_Weights[bi_offset + i];
+            out->bone_indices[i] = (float) mesh.m_BoneIndices[bi_offset + i];
+        }
+    }
+
+    // Creates a static vertex buffer from the mesh vertices, or from the vertices the indices point at
+    template <typename V>
+    static dmGraphics::HVertexBuffer NewModelVertexBuffer(dmGraphics::HContext context, const dmRigDDF::Mesh& mesh, const uint32_t* indices, uint32_t vertex_count)
+    {
+        V* buffer = new V[vertex_count];
+        const dmRigDDF::MeshVertexIndices* mvi = mesh.m_Vertices.m_Data;
+        for (uint32_t i = 0; i < vertex_count; ++i)
+        {
+            GetModelVertex(mesh, &mvi[indices ? indices[i] : i], &buffer[i]);
+        }
+        dmGraphics::HVertexBuffer vertex_buffer = dmGraphics::NewVertexBuffer(context, vertex_count*sizeof(V), buffer, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+        delete [] buffer;
+        return vertex_buffer;
+    }
+
+    static dmGraphics::HVertexBuffer NewModelVertexBuffer(dmGraphics::HContext context, const ModelResource* resource, const dmRigDDF::Mesh& mesh, const uint32_t* indices, uint32_t vertex_count)
+    {
+        if (resource->m_SkinnedVertices)
+            return NewModelVertexBuffer<dmRig::RigSkinnedModelVertex>(context, mesh, indices, vertex_count);
+        return NewModelVertexBuffer<dmRig::RigModelVertex>(context, mesh, indices, vertex_count);
+    }
+
     static void CreateGPUBuffers(dmGraphics::HContext context, ModelResource* resource, dmRigDDF::Mesh& mesh)
     {
         if(mesh.m_IndicesFormat == dmRig::INDEXBUFFER_FORMAT_32)
@@ -51,16 +88,7 @@ namespace dmGameSystem
             else
             {
                 // If not supporting 32-bit indices, create triangle list as a fallback
-                dmRig::RigModelVertex* rmv_buffer = new dmRig::RigModelVertex[index_count];
-                dmRig::RigModelVertex* rmv = rmv_buffer;
-                dmRigDDF::MeshVertexIndices* mvi =  mesh.m_Vertices.m_Data;
-                uint32_t *mi = (uint32_t*) mesh.m_Indices.m_Data;
-                for(uint32_t i = 0; i < index_count; ++i, ++rmv, ++mi)
-                {
-                    GetModelVertex(mesh, &mvi[*mi], rmv);
-                }
-                resource->m_VertexBuffer = dmGraphics::NewVertexBuffer(context, index_count*sizeof(dmRig::RigModelVertex), rmv_buffer, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
-                delete []rmv_buffer;
+                resource->m_VertexBuffer = NewModelVertexBuffer(context, resource, mesh, (uint32_t*) mesh.m_Indices.m_Data, index_count);
                 resource->m_ElementCount = index_count;
                 return;
             }
@@ -71,15 +99,30 @@ namespace dmGameSystem
             resource->m_IndexBufferElementType = dmGraphics::TYPE_UNSIGNED_SHORT;
             resource->m_ElementCount = mesh.m_Indices.m_Count>>1;;
         }
-        dmRig::RigModelVertex* rmv_buffer = new dmRig::RigModelVertex[mesh.m_Vertices.m_Count];
-        dmRig::RigModelVertex* rmv = rmv_buffer;
-        dmRigDDF::MeshVertexIndices* mvi =  mesh.m_Vertices.m_Data;
-        for(uint32_t i = 0; i < mesh.m_Vertices.m_Count; ++i, ++mvi, ++rmv)
+        resource->m_VertexBuffer = NewModelVertexBuffer(context, resource, mesh, 0x0, mesh.m_Vertices.m_Count);
+    }
+
+    static void CalculateAabb(ModelResource* resource, const dmRigDDF::MeshSet* mesh_set)
+    {
+        float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (uint32_t i = 0; i < mesh_set->m_MeshAttachments.m_Count; ++i)
         {
-            GetModelVertex(mesh, mvi, rmv);
+            const dmRigDDF::Mesh& mesh = mesh_set->m_MeshAttachments[i];
+            for (uint32_t j = 0; j + 2 < mesh.m_Positions.m_Count; j += 3)
+            {
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    min[c] = dmMath::Min(min[c], mesh.m_Positions[j + c]);
+                    max[c] = dmMath::Max(max[c], mesh.m_Positions[j + c]);
+                }
+            }
         }
-        resource->m_VertexBuffer = dmGraphics::NewVertexBuffer(context, mesh.m_Vertices.m_Count*sizeof(dmRig::RigModelVertex), rmv_buffer, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
-        delete []rmv_buffer;
+        if (min[0] > max[0])
+            return;
+        resource->m_AabbCenter = dmVMath::Point3(0.5f * (min[0] + max[0]), 0.5f * (min[1] + max[1]), 0.5f * (min[2] + max[2]));
+        resource->m_AabbExtents = dmVMath::Vector3(0.5f * (max[0] - min[0]), 0.5f * (max[1] - min[1]), 0.5f * (max[2] - min[2]));
+        resource->m_HasAabb = 1;
     }
 
     dmResource::Result AcquireResources(dmGraphics::HContext context, dmResource::HFactory factory, ModelResource* resource, const char* filename)
@@ -121,20 +164,29 @@ namespace dmGameSystem
         }
         memcpy(resource->m_Textures, textures, sizeof(dmGraphics::HTexture) * dmRender::RenderObject::MAX_TEXTURE_COUNT);
 
+        dmRigDDF::MeshSet* bounds_mesh_set = resource->m_RigScene->m_MeshSetRes->m_MeshSet;
+        if (bounds_mesh_set && !resource->m_RigScene->m_AnimationSetRes && !resource->m_RigScene->m_SkeletonRes)
+        {
+            CalculateAabb(resource, bounds_mesh_set);
+        }
+
         if(dmRender::GetMaterialVertexSpace(resource->m_Material) ==  dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL)
         {
-            if(resource->m_RigScene->m_AnimationSetRes || resource->m_RigScene->m_SkeletonRes)
-            {
-                dmLogError("Failed to create Model component. Material vertex space option VERTEX_SPACE_LOCAL does not support skinning.");
-                return dmResource::RESULT_NOT_SUPPORTED;
-            }
             dmRigDDF::MeshSet* mesh_set = resource->m_RigScene->m_MeshSetRes->m_MeshSet;
-            if(mesh_set)
+            bool has_mesh = mesh_set && mesh_set->m_MeshEntries.m_Count && mesh_set->m_MeshAttachments.m_Count;
+            if(resource->m_RigScene->m_AnimationSetRes || resource->m_RigScene->m_SkeletonRes)
             {
-                if(mesh_set->m_MeshEntries.m_Count && mesh_set->m_MeshAttachments.m_Count)
+                // Skinned in the vertex shader, with the bone matrices in a float texture
+                if (!dmGraphics::IsTextureFormatSupported(context, dmGraphics::TEXTURE_FORMAT_RGBA32F))
                 {
-                    CreateGPUBuffers(context, resource, mesh_set->m_MeshAttachments[0]);
+                    dmLogError("Failed to create Model component. Material vertex space option VERTEX_SPACE_LOCAL requires float texture support for skinning.");
+                    return dmResource::RESULT_NOT_SUPPORTED;
                 }
+                resource->m_SkinnedVertices = has_mesh && mesh_set->m_MeshAttachments[0].m_BoneIndices.m_Count > 0;
+            }
+            if(has_mesh)
+            {
+                CreateGPUBuffers(context, resource, mesh_set->m_MeshAttachments[0]);
             }
         }
 
@@ -154,6 +206,8 @@ namespace dmGameSystem
             resource->m_IndexBuffer = 0x0;
             resource->m_ElementCount = 0;
         }
+        resource->m_SkinnedVertices = 0;
+        resource->m_HasAabb = 0;
         if (resource->m_Model != 0x0)
             dmDDF::FreeMessage(resource->m_Model);
         resource->m_Model = 0x0;
@@ -82,6 +82,8 @@ namespace dmGameSystem
                 return result;
         }
 
+        // Rebaked on the next use
+        resource->m_BakedAnimationSet.m_AnimationSet = 0x0;
         if (result == dmResource::RESULT_OK && resource->m_SkeletonRes)
         {
             dmRig::CreateBindPose(*resource->m_SkeletonRes->m_Skeleton, resource->m_BindPose);
@@ -120,6 +122,9 @@ namespace dmGameSystem
         size += res->m_BindPose.Capacity()*sizeof(dmRig::RigBone);
         size += res->m_PoseIdxToInfluence.Capacity()*sizeof(uint32_t);
         size += res->m_TrackIdxToPose.Capacity()*sizeof(uint32_t);
+        size += res->m_BakedAnimationSet.m_Animations.Capacity()*sizeof(dmRig::BakedAnimation);
+        size += res->m_BakedAnimationSet.m_Tracks.Capacity()*sizeof(dmRig::BakedTrack);
+        size += res->m_BakedAnimationSet.m_Samples.Capacity()*sizeof(dmRig::BakedBoneSample);
         return size;
     }
 
@@ -191,4 +196,16 @@ namespace dmGameSystem
         params.m_Resource->m_ResourceSize = GetResourceSize(ss_resource, params.m_BufferSize);
         return dmResource::RESULT_OK;
     }
+
+    const dmRig::BakedAnimationSet* GetBakedAnimationSet(RigSceneResource* resource)
+    {
+        if (resource->m_AnimationSetRes == 0x0 || resource->m_SkeletonRes == 0x0)
+            return 0x0;
+        const dmRigDDF::AnimationSet* animation_set = resource->m_AnimationSetRes->m_AnimationSet;
+        if (resource->m_BakedAnimationSet.m_AnimationSet != animation_set)
+        {
+            dmRig::BakeAnimationSet(*animation_set, resource->m_TrackIdxToPose, resource->m_BakedAnimationSet);
+        }
+        return &resource->m_BakedAnimationSet;
+    }
 }
@@ -25,6 +25,9 @@ namespace dmGameSystem
     dmResource::Result ResRigSceneDestroy(const dmResource::ResourceDestroyParams& params);
 
     dmResource::Result ResRigSceneRecreate(const dmResource::ResourceRecreateParams& params);
+
+    // Returns the baked animations of the rig scene, baking them the first time, or 0 if it has no skeletal animations
+    const dmRig::BakedAnimationSet* GetBakedAnimationSet(RigSceneResource* resource);
 }
 
 #endif // DM_GAMESYS_RES_SPINE_SCENE_H
@@ -10,12 +10,64 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <stdlib.h>
 #include <string.h>
 #include <sound/sound.h>
 #include "res_sound_data.h"
 
 namespace dmGameSystem
 {
+    // Read context of streamed sound data
+    struct SoundDataStream
+    {
+        dmResource::HFactory m_Factory;
+        char*                m_Filename;
+    };
+
+    static dmSound::Result SoundDataStreamRead(void* context, uint32_t offset, void* buffer, uint32_t buffer_size, uint32_t* nread)
+    {
+        SoundDataStream* stream = (SoundDataStream*) context;
+        dmResource::Result r = dmResource::ReadResourcePartial(stream->m_Factory, stream->m_Filename, offset, buffer_size, buffer, nread);
+        return r == dmResource::RESULT_OK ? dmSound::RESULT_OK : dmSound::RESULT_UNKNOWN_ERROR;
+    }
+
+    static void DeleteSoundDataStream(void* context)
+    {
+        SoundDataStream* stream = (SoundDataStream*) context;
+        if (stream)
+        {
+            free(stream->m_Filename);
+            delete stream;
+        }
+    }
+
+    // Large sounds (ogg, or uncompressed wav) are read from the resource while playing, instead of
+    // keeping the whole file in memory. Returns false if the sound should be kept in memory
+    static bool NewStreamingSoundData(const dmResource::ResourceCreateParams& params, dmSound::SoundDataType type, dmSound::HSoundData* sound_data)
+    {
+        uint32_t threshold = dmSound::GetStreamingThreshold();
+        if (threshold == 0 || params.m_BufferSize < threshold)
+        {
+            return false;
+        }
+
+        SoundDataStream* stream = new SoundDataStream;
+        stream->m_Factory = params.m_Factory;
+        stream->m_Filename = strdup(params.m_Filename);
+
+        // Make sure the resource can be read in parts (e.g. it isn't compressed in the archive)
+        uint8_t probe;
+        uint32_t nread = 0;
+        if (SoundDataStreamRead(stream, 0, &probe, 1, &nread) == dmSound::RESULT_OK && nread == 1 &&
+            dmSound::NewSoundDataStreaming(SoundDataStreamRead, stream, params.m_BufferSize, type, sound_data, params.m_Resource->m_NameHash) == dmSound::RESULT_OK)
+        {
+            return true;
+        }
+
+        DeleteSoundDataStream(stream);
+        return false;
+    }
+
     dmResource::Result ResSoundDataCreate(const dmResource::ResourceCreateParams& params)
     {
         dmSound::HSoundData sound_data;
@@ -28,10 +80,22 @@ namespace dmGameSystem
             type = dmSound::SOUND_DATA_TYPE_OGG_VORBIS;
         }
 
-        dmSound::Result r = dmSound::NewSoundData(params.m_Buffer, params.m_BufferSize, type, &sound_data, params.m_Resource->m_NameHash);
-        if (r != dmSound::RESULT_OK)
+        if (params.m_IsBufferMapped)
+        {
+            // The data is used in place from the memory mapped archive
+            dmSound::Result r = dmSound::NewSoundDataExternal(params.m_Buffer, params.m_BufferSize, type, &sound_data, params.m_Resource->m_NameHash);
+            if (r != dmSound::RESULT_OK)
+            {
+                return dmResource::RESULT_OUT_OF_RESOURCES;
+            }
+        }
+        else if (!NewStreamingSoundData(params, type, &sound_data))
         {
-            return dmResource::RESULT_OUT_OF_RESOURCES;
+            dmSound::Result r = dmSound::NewSoundData(params.m_Buffer, params.m_BufferSize, type, &sound_data, params.m_Resource->m_NameHash);
+            if (r != dmSound::RESULT_OK)
+            {
+                return dmResource::RESULT_OUT_OF_RESOURCES;
+            }
         }
 
         params.m_Resource->m_Resource = (void*) sound_data;
@@ -42,7 +106,9 @@ namespace dmGameSystem
     dmResource::Result ResSoundDataDestroy(const dmResource::ResourceDestroyParams& params)
     {
         dmSound::HSoundData sound_data = (dmSound::HSoundData) params.m_Resource->m_Resource;
+        void* stream = dmSound::GetSoundDataReadContext(sound_data);
         dmSound::Result r = dmSound::DeleteSoundData(sound_data);
+        DeleteSoundDataStream(stream);
         if (r != dmSound::RESULT_OK)
         {
             return dmResource::RESULT_INVAL;
@@ -53,7 +119,10 @@ namespace dmGameSystem
     dmResource::Result ResSoundDataRecreate(const dmResource::ResourceRecreateParams& params)
     {
         dmSound::HSoundData sound_data = (dmSound::HSoundData) params.m_Resource->m_Resource;
+        // The reloaded sound is kept in memory
+        void* stream = dmSound::GetSoundDataReadContext(sound_data);
         dmSound::Result r = dmSound::SetSoundData(sound_data, params.m_Buffer, params.m_BufferSize);
+        DeleteSoundDataStream(stream);
         if (r != dmSound::RESULT_OK)
         {
             return dmResource::RESULT_INVAL;
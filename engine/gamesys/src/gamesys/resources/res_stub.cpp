@@ -0,0 +1,40 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "res_stub.h"
+
+namespace dmGameSystem
+{
+    // Every resource needs a unique pointer
+    struct StubResource
+    {
+        uint8_t m_Unused;
+    };
+
+    dmResource::Result ResStubCreate(const dmResource::ResourceCreateParams& params)
+    {
+        params.m_Resource->m_Resource = (void*) new StubResource;
+        params.m_Resource->m_ResourceSize = 0;
+        return dmResource::RESULT_OK;
+    }
+
+    dmResource::Result ResStubDestroy(const dmResource::ResourceDestroyParams& params)
+    {
+        delete (StubResource*) params.m_Resource->m_Resource;
+        return dmResource::RESULT_OK;
+    }
+
+    dmResource::Result ResStubRecreate(const dmResource::ResourceRecreateParams& params)
+    {
+        return dmResource::RESULT_OK;
+    }
+}
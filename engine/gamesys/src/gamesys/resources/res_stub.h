@@ -0,0 +1,29 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_GAMESYS_RES_STUB_H
+#define DM_GAMESYS_RES_STUB_H
+
+#include <resource/resource.h>
+
+namespace dmGameSystem
+{
+    // Stand-in for a resource type that is not used by a headless server, e.g. a sprite or a sound.
+    // The data is ignored and no other resources are loaded
+    dmResource::Result ResStubCreate(const dmResource::ResourceCreateParams& params);
+
+    dmResource::Result ResStubDestroy(const dmResource::ResourceDestroyParams& params);
+
+    dmResource::Result ResStubRecreate(const dmResource::ResourceRecreateParams& params);
+}
+
+#endif // DM_GAMESYS_RES_STUB_H
@@ -12,12 +12,26 @@
 
 #include "res_texture.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <dlib/array.h>
+#include <dlib/condition_variable.h>
+#include <dlib/dstrings.h>
+#include <dlib/hash.h>
+#include <dlib/hashtable.h>
 #include <dlib/log.h>
+#include <dlib/mutex.h>
+#include <dlib/path.h>
+#include <dlib/platform.h>
 #include <dlib/profile.h>
+#include <dlib/sys.h>
+#include <dlib/thread.h>
 #include <dlib/time.h>
 #include <dlib/math.h>
 #include <graphics/graphics.h>
 
+#include "../gamesys.h"
+
 namespace dmGameSystem
 {
     static const uint32_t s_MaxMipCount = 32;
@@ -26,6 +40,11 @@ namespace dmGameSystem
         dmGraphics::TextureImage* m_DDFImage;
         uint8_t* m_DecompressedData[s_MaxMipCount];
         uint32_t m_DecompressedDataSize[s_MaxMipCount];
+        // The alternative selected by SelectImage, 0 if none is supported
+        dmGraphics::TextureImage::Image* m_Image;
+        dmGraphics::TextureFormat m_Format;
+        uint32_t m_MipCount;
+        bool m_Selected;
         bool m_UseBlankTexture;
     };
 
@@ -70,7 +89,15 @@ namespace dmGameSystem
         return true;
     }
 
-    void SetBlankTexture(dmGraphics::HTexture texture, dmGraphics::TextureParams& params)
+    static void SetTextureData(dmGraphics::HTexture texture, const dmGraphics::TextureParams& params, bool async)
+    {
+        if (async)
+            dmGraphics::SetTextureAsync(texture, params);
+        else
+            dmGraphics::SetTexture(texture, params);
+    }
+
+    void SetBlankTexture(dmGraphics::HTexture texture, dmGraphics::TextureParams& params, bool async)
     {
         const static uint8_t blank[6*4] = {0};
         params.m_Width = 1;
@@ -79,17 +106,154 @@ namespace dmGameSystem
         params.m_Data = blank;
         params.m_DataSize = 4;
         params.m_MipMap = 0;
-        dmGraphics::SetTextureAsync(texture, params);
+        SetTextureData(texture, params, async);
     }
 
-    dmResource::Result AcquireResources(const char* path, dmResource::SResourceDescriptor* resource_desc, dmGraphics::HContext context, ImageDesc* image_desc, dmGraphics::HTexture texture, dmGraphics::HTexture* texture_out)
+    // Transcode cache, see SetTranscodeCacheDirectory
+
+    static const uint32_t TRANSCODE_CACHE_MAGIC   = 0x54434331; // 'TCC1'
+    // Bump when the transcoder or the file layout changes, so that stale files are transcoded again
+    static const uint32_t TRANSCODE_CACHE_VERSION = 1;
+
+    struct TranscodeCacheHeader
     {
-        dmResource::Result result = dmResource::RESULT_FORMAT_ERROR;
+        uint32_t m_Magic;
+        uint32_t m_Version;
+        uint64_t m_Key;
+        uint32_t m_Format;
+        uint32_t m_MipCount;
+        // Followed by m_MipCount sizes and then the data of each mip
+    };
+
+    // Only written before any texture is loaded, then read by the load threads
+    static char g_TranscodeCacheDirectory[DMPATH_MAX_PATH] = {0};
+
+    void SetTranscodeCacheDirectory(const char* directory)
+    {
+        g_TranscodeCacheDirectory[0] = 0;
+        if (!directory)
+        {
+            return;
+        }
+        dmSys::Result r = dmSys::Mkdir(directory, 0755);
+        if (r != dmSys::RESULT_OK && r != dmSys::RESULT_EXIST)
+        {
+            dmLogWarning("Unable to create the transcode cache directory '%s'", directory);
+            return;
+        }
+        dmStrlCpy(g_TranscodeCacheDirectory, directory, sizeof(g_TranscodeCacheDirectory));
+    }
+
+    // The transcoder output only depends on the source data and the target format
+    static uint64_t GetTranscodeCacheKey(dmGraphics::TextureImage::Image* image, dmGraphics::TextureFormat format)
+    {
+        HashState64 state;
+        dmHashInit64(&state, false);
+        dmHashUpdateBuffer64(&state, image->m_Data.m_Data, image->m_Data.m_Count);
+        uint32_t format_u32 = (uint32_t) format;
+        dmHashUpdateBuffer64(&state, &format_u32, sizeof(format_u32));
+        return dmHashFinal64(&state);
+    }
+
+    static void GetTranscodeCachePath(uint64_t key, char* path, uint32_t path_len)
+    {
+        dmSnPrintf(path, path_len, "%s/%016llx.transcoded", g_TranscodeCacheDirectory, (unsigned long long) key);
+    }
+
+    static bool LoadTranscodedImage(uint64_t key, dmGraphics::TextureFormat format, ImageDesc* image_desc, uint32_t* num_mips)
+    {
+        DM_PROFILE(Resource, "LoadTranscodedImage");
+        char path[DMPATH_MAX_PATH];
+        GetTranscodeCachePath(key, path, sizeof(path));
+        FILE* file = fopen(path, "rb");
+        if (!file)
+        {
+            return false;
+        }
+
+        uint32_t sizes[s_MaxMipCount];
+        TranscodeCacheHeader header;
+        bool ok = fread(&header, 1, sizeof(header), file) == sizeof(header) &&
+                  header.m_Magic == TRANSCODE_CACHE_MAGIC &&
+                  header.m_Version == TRANSCODE_CACHE_VERSION &&
+                  header.m_Key == key &&
+                  header.m_Format == (uint32_t) format &&
+                  header.m_MipCount > 0 && header.m_MipCount <= s_MaxMipCount &&
+                  fread(sizes, sizeof(uint32_t), header.m_MipCount, file) == header.m_MipCount;
+
+        uint32_t mip_count = 0;
+        for (; ok && mip_count < header.m_MipCount; ++mip_count)
+        {
+            uint8_t* data = new uint8_t[sizes[mip_count]];
+            image_desc->m_DecompressedData[mip_count] = data;
+            image_desc->m_DecompressedDataSize[mip_count] = sizes[mip_count];
+            ok = fread(data, 1, sizes[mip_count], file) == sizes[mip_count];
+        }
+        fclose(file);
+
+        if (!ok)
+        {
+            // Truncated or written by another version. The image is transcoded and the file replaced
+            for (uint32_t i = 0; i < mip_count; ++i)
+            {
+                delete[] image_desc->m_DecompressedData[i];
+                image_desc->m_DecompressedData[i] = 0;
+                image_desc->m_DecompressedDataSize[i] = 0;
+            }
+            return false;
+        }
+
+        *num_mips = header.m_MipCount;
+        return true;
+    }
+
+    static void SaveTranscodedImage(uint64_t key, dmGraphics::TextureFormat format, ImageDesc* image_desc, uint32_t num_mips)
+    {
+        DM_PROFILE(Resource, "SaveTranscodedImage");
+        char path[DMPATH_MAX_PATH];
+        char tmp_path[DMPATH_MAX_PATH];
+        GetTranscodeCachePath(key, path, sizeof(path));
+        dmSnPrintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+        // Written to a temporary file first, so that a crash while writing never leaves a truncated file behind
+        FILE* file = fopen(tmp_path, "wb");
+        if (!file)
+        {
+            return;
+        }
+
+        TranscodeCacheHeader header;
+        header.m_Magic    = TRANSCODE_CACHE_MAGIC;
+        header.m_Version  = TRANSCODE_CACHE_VERSION;
+        header.m_Key      = key;
+        header.m_Format   = (uint32_t) format;
+        header.m_MipCount = dmMath::Min(num_mips, s_MaxMipCount);
+
+        bool ok = fwrite(&header, 1, sizeof(header), file) == sizeof(header) &&
+                  fwrite(image_desc->m_DecompressedDataSize, sizeof(uint32_t), header.m_MipCount, file) == header.m_MipCount;
+        for (uint32_t i = 0; ok && i < header.m_MipCount; ++i)
+        {
+            ok = fwrite(image_desc->m_DecompressedData[i], 1, image_desc->m_DecompressedDataSize[i], file) == image_desc->m_DecompressedDataSize[i];
+        }
+        ok = fclose(file) == 0 && ok;
+
+        if (!ok || dmSys::RenameFile(path, tmp_path) != dmSys::RESULT_OK)
+        {
+            dmLogWarning("Unable to write transcoded texture to '%s'", path);
+            dmSys::Unlink(tmp_path);
+        }
+    }
+
+    // Picks the first alternative the context supports, transcoding it if needed. This is the expensive
+    // part of loading a texture, and is done on the load thread by the preload function.
+    static void SelectImage(const char* path, dmGraphics::HContext context, ImageDesc* image_desc)
+    {
+        DM_PROFILE(Resource, "SelectTextureImage");
+        image_desc->m_Selected = true;
         for (uint32_t i = 0; i < image_desc->m_DDFImage->m_Alternatives.m_Count; ++i)
         {
             dmGraphics::TextureImage::Image* image = &image_desc->m_DDFImage->m_Alternatives[i];
 
-
             dmGraphics::TextureFormat original_format = TextureImageToTextureFormat(image->m_Format);
             dmGraphics::TextureFormat output_format = original_format;
 
@@ -98,11 +262,20 @@ namespace dmGameSystem
             {
                 num_mips = s_MaxMipCount;
                 output_format = dmGraphics::GetSupportedCompressionFormat(context, output_format, image->m_Width, image->m_Height);
-                bool result = dmGraphics::Transcode(path, image, output_format, image_desc->m_DecompressedData, image_desc->m_DecompressedDataSize, &num_mips);
-                if (!result)
+
+                uint64_t cache_key = g_TranscodeCacheDirectory[0] ? GetTranscodeCacheKey(image, output_format) : 0;
+                if (!cache_key || !LoadTranscodedImage(cache_key, output_format, image_desc, &num_mips))
                 {
-                    dmLogError("Failed to transcode %s", path);
-                    continue;
+                    bool result = dmGraphics::Transcode(path, image, output_format, image_desc->m_DecompressedData, image_desc->m_DecompressedDataSize, &num_mips);
+                    if (!result)
+                    {
+                        dmLogError("Failed to transcode %s", path);
+                        continue;
+                    }
+                    if (cache_key)
+                    {
+                        SaveTranscodedImage(cache_key, output_format, image_desc, num_mips);
+                    }
                 }
             }
             else if (!dmGraphics::IsTextureFormatSupported(context, original_format))
@@ -110,14 +283,33 @@ namespace dmGameSystem
                 continue;
             }
 
+            image_desc->m_Image = image;
+            image_desc->m_Format = output_format;
+            image_desc->m_MipCount = num_mips;
+            return;
+        }
+    }
+
+    // Uploads the selected image, from base_mip and down. The texture is created if it is 0
+    dmResource::Result AcquireResources(const char* path, dmResource::SResourceDescriptor* resource_desc, dmGraphics::HContext context, ImageDesc* image_desc, dmGraphics::HTexture texture, uint32_t base_mip, bool async, dmGraphics::HTexture* texture_out)
+    {
+        if (!image_desc->m_Selected)
+        {
+            SelectImage(path, context, image_desc);
+        }
+
+        dmResource::Result result = dmResource::RESULT_FORMAT_ERROR;
+        dmGraphics::TextureImage::Image* image = image_desc->m_Image;
+        if (image)
+        {
             result = dmResource::RESULT_OK;
 
             dmGraphics::TextureCreationParams creation_params;
             dmGraphics::TextureParams params;
             dmGraphics::GetDefaultTextureFilters(context, params.m_MinFilter, params.m_MagFilter);
-            params.m_Format = output_format;
-            params.m_Width = image->m_Width;
-            params.m_Height = image->m_Height;
+            params.m_Format = image_desc->m_Format;
+            params.m_Width = dmMath::Max(image->m_Width >> base_mip, 1U);
+            params.m_Height = dmMath::Max(image->m_Height >> base_mip, 1U);
 
             assert(image->m_MipMapOffset.m_Count <= s_MaxMipCount);
 
@@ -128,11 +320,11 @@ namespace dmGameSystem
             } else {
                 assert(0);
             }
-            creation_params.m_Width = image->m_Width;
-            creation_params.m_Height = image->m_Height;
+            creation_params.m_Width = params.m_Width;
+            creation_params.m_Height = params.m_Height;
             creation_params.m_OriginalWidth = image->m_OriginalWidth;
             creation_params.m_OriginalHeight = image->m_OriginalHeight;
-            creation_params.m_MipMapCount = image->m_MipMapOffset.m_Count;
+            creation_params.m_MipMapCount = image->m_MipMapOffset.m_Count > base_mip ? image->m_MipMapOffset.m_Count - base_mip : 1;
 
             if (!texture)
                 texture = dmGraphics::NewTexture(context, creation_params);
@@ -150,29 +342,27 @@ namespace dmGameSystem
             if (params.m_Width > max_size || params.m_Height > max_size) {
                 // dmGraphics::SetTextureAsync will fail if texture is too big; fall back to 1x1 texture.
                 dmLogError("Texture size %ux%u exceeds maximum supported texture size (%ux%u). Using blank texture.", params.m_Width, params.m_Height, max_size, max_size);
-                SetBlankTexture(texture, params);
-                break;
+                SetBlankTexture(texture, params, async);
             }
-
-            if(image_desc->m_UseBlankTexture)
+            else if(image_desc->m_UseBlankTexture)
             {
-                SetBlankTexture(texture, params);
-                break;
+                SetBlankTexture(texture, params, async);
             }
-
-            for (uint32_t i = 0; i < num_mips; ++i)
+            else
             {
-                params.m_MipMap = i;
-                params.m_Data = image_desc->m_DecompressedData[i] == 0 ? &image->m_Data[image->m_MipMapOffset[i]] : image_desc->m_DecompressedData[i];
-                params.m_DataSize = image_desc->m_DecompressedData[i] == 0 ? image->m_MipMapSize[i] : image_desc->m_DecompressedDataSize[i];
-                dmGraphics::SetTextureAsync(texture, params);
-
-                params.m_Width >>= 1;
-                params.m_Height >>= 1;
-                if (params.m_Width == 0) params.m_Width = 1;
-                if (params.m_Height == 0) params.m_Height = 1;
+                for (uint32_t i = base_mip; i < image_desc->m_MipCount; ++i)
+                {
+                    params.m_MipMap = i - base_mip;
+                    params.m_Data = image_desc->m_DecompressedData[i] == 0 ? &image->m_Data[image->m_MipMapOffset[i]] : image_desc->m_DecompressedData[i];
+                    params.m_DataSize = image_desc->m_DecompressedData[i] == 0 ? image->m_MipMapSize[i] : image_desc->m_DecompressedDataSize[i];
+                    SetTextureData(texture, params, async);
+
+                    params.m_Width >>= 1;
+                    params.m_Height >>= 1;
+                    if (params.m_Width == 0) params.m_Width = 1;
+                    if (params.m_Height == 0) params.m_Height = 1;
+                }
             }
-            break;
         }
 
         if (result == dmResource::RESULT_FORMAT_ERROR)
@@ -195,7 +385,7 @@ namespace dmGameSystem
             {
                 dmGraphics::TextureParams params;
                 dmGraphics::GetDefaultTextureFilters(context, params.m_MinFilter, params.m_MagFilter);
-                SetBlankTexture(texture, params);
+                SetBlankTexture(texture, params, async);
                 result = dmResource::RESULT_OK;
             }
         }
@@ -226,6 +416,440 @@ namespace dmGameSystem
         delete image_desc;
     }
 
+    // Total size of the mip data from base_mip and down
+    static uint32_t GetImageSize(ImageDesc* image_desc, uint32_t base_mip)
+    {
+        uint32_t size = 0;
+        for (uint32_t i = base_mip; i < image_desc->m_MipCount; ++i)
+        {
+            size += image_desc->m_DecompressedData[i] == 0 ? image_desc->m_Image->m_MipMapSize[i] : image_desc->m_DecompressedDataSize[i];
+        }
+        return size;
+    }
+
+    // Texture streaming, see InitializeTextureStreaming
+
+    struct StreamingTexture
+    {
+        char*       m_Path;
+        // Changes when the texture is registered again, so that stale requests for a reused handle are ignored
+        uint32_t    m_Id;
+        uint32_t    m_FullSize;
+        uint32_t    m_InitialSize;
+        uint32_t    m_LastUsedFrame;
+        uint8_t     m_BaseMip;
+        uint8_t     m_InitialBaseMip;
+        uint8_t     m_RequestedBaseMip;
+        uint8_t     m_Loading : 1;
+        uint8_t     m_Failed : 1;
+        uint8_t     m_Wanted : 1;
+    };
+
+    struct StreamingRequest
+    {
+        dmGraphics::HTexture m_Texture;
+        char*                m_Path;
+        ImageDesc*           m_Image; // Set by the streaming thread, 0 if the load failed
+        uint32_t             m_Id;
+    };
+
+    struct TextureStreaming
+    {
+        TextureStreamingParams                  m_Params;
+        dmGraphics::HContext                    m_GraphicsContext;
+        dmHashTable64<StreamingTexture>         m_Textures;
+        dmArray<dmGraphics::HTexture>           m_WantedTextures;
+        // Size of the streamed textures with the mips they have or are loading
+        uint64_t                                m_CommittedSize;
+        uint32_t                                m_Frame;
+        uint32_t                                m_NextId;
+
+        // Guards m_Requests, m_Loaded and m_Shutdown
+        dmMutex::HMutex                         m_Mutex;
+        dmConditionVariable::HConditionVariable m_Condition;
+        dmThread::Thread                        m_Thread;
+        dmArray<StreamingRequest>               m_Requests;
+        dmArray<StreamingRequest>               m_Loaded;
+        bool                                    m_Shutdown;
+    };
+
+    static TextureStreaming* g_TextureStreaming = 0;
+
+    static uint32_t GetStreamingSize(StreamingTexture* texture, uint32_t base_mip)
+    {
+        return base_mip == 0 ? texture->m_FullSize : texture->m_InitialSize;
+    }
+
+    // The first mip that fits within the initial size, or 0 if the texture isn't streamed
+    static uint32_t GetStreamingBaseMip(ImageDesc* image_desc)
+    {
+        dmGraphics::TextureImage::Image* image = image_desc->m_Image;
+        if (!g_TextureStreaming || !image || image_desc->m_UseBlankTexture || image_desc->m_DDFImage->m_Type != dmGraphics::TextureImage::TYPE_2D)
+        {
+            return 0;
+        }
+
+        uint32_t mip_count = dmMath::Min(image_desc->m_MipCount, image->m_MipMapOffset.m_Count);
+        uint32_t base_mip = 0;
+        uint32_t size = dmMath::Max(image->m_Width, image->m_Height);
+        while (size > g_TextureStreaming->m_Params.m_InitialMaxSize && base_mip + 1 < mip_count)
+        {
+            size >>= 1;
+            ++base_mip;
+        }
+        return base_mip;
+    }
+
+    static void RegisterStreamingTexture(const char* path, dmGraphics::HTexture texture, ImageDesc* image_desc, uint32_t base_mip)
+    {
+        TextureStreaming* streaming = g_TextureStreaming;
+        StreamingTexture entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.m_Path = strdup(path);
+        entry.m_Id = ++streaming->m_NextId;
+        entry.m_FullSize = GetImageSize(image_desc, 0);
+        entry.m_InitialSize = GetImageSize(image_desc, base_mip);
+        entry.m_LastUsedFrame = streaming->m_Frame;
+        entry.m_BaseMip = base_mip;
+        entry.m_InitialBaseMip = base_mip;
+        entry.m_RequestedBaseMip = base_mip;
+
+        if (streaming->m_Textures.Full())
+        {
+            uint32_t capacity = streaming->m_Textures.Capacity() + 256;
+            streaming->m_Textures.SetCapacity(capacity / 2 + 1, capacity);
+        }
+        streaming->m_Textures.Put((uintptr_t) texture, entry);
+        streaming->m_CommittedSize += entry.m_InitialSize;
+    }
+
+    static void UnregisterStreamingTexture(dmGraphics::HTexture texture)
+    {
+        TextureStreaming* streaming = g_TextureStreaming;
+        StreamingTexture* entry = streaming ? streaming->m_Textures.Get((uintptr_t) texture) : 0;
+        if (entry)
+        {
+            // A request in flight is discarded when it can't find the texture
+            streaming->m_CommittedSize -= GetStreamingSize(entry, entry->m_RequestedBaseMip);
+            free(entry->m_Path);
+            streaming->m_Textures.Erase((uintptr_t) texture);
+        }
+    }
+
+    static void OnTextureUsed(void* user_data, dmGraphics::HTexture texture)
+    {
+        TextureStreaming* streaming = (TextureStreaming*) user_data;
+        StreamingTexture* entry = streaming->m_Textures.Get((uintptr_t) texture);
+        if (entry)
+        {
+            entry->m_LastUsedFrame = streaming->m_Frame;
+            if (entry->m_RequestedBaseMip > 0 && !entry->m_Wanted && !entry->m_Failed)
+            {
+                entry->m_Wanted = 1;
+                if (streaming->m_WantedTextures.Full())
+                {
+                    streaming->m_WantedTextures.OffsetCapacity(64);
+                }
+                streaming->m_WantedTextures.Push(texture);
+            }
+        }
+    }
+
+    static ImageDesc* LoadStreamingImage(TextureStreaming* streaming, const char* path)
+    {
+        DM_PROFILE(Resource, "LoadStreamingTexture");
+        void* buffer;
+        uint32_t buffer_size;
+        if (dmResource::GetRaw(streaming->m_Params.m_Factory, path, &buffer, &buffer_size) != dmResource::RESULT_OK)
+        {
+            return 0;
+        }
+
+        dmGraphics::TextureImage* texture_image;
+        dmDDF::Result e = dmDDF::LoadMessage<dmGraphics::TextureImage>(buffer, buffer_size, (&texture_image));
+        free(buffer);
+        if (e != dmDDF::RESULT_OK)
+        {
+            return 0;
+        }
+
+        ImageDesc* image_desc = CreateImage(path, streaming->m_GraphicsContext, texture_image);
+        SelectImage(path, streaming->m_GraphicsContext, image_desc);
+        return image_desc;
+    }
+
+    static void FreeStreamingRequest(StreamingRequest& request)
+    {
+        if (request.m_Image)
+        {
+            dmDDF::FreeMessage(request.m_Image->m_DDFImage);
+            DestroyImage(request.m_Image);
+        }
+        free(request.m_Path);
+    }
+
+    static void PushRequest(dmArray<StreamingRequest>& requests, const StreamingRequest& request)
+    {
+        if (requests.Full())
+        {
+            requests.OffsetCapacity(16);
+        }
+        requests.Push(request);
+    }
+
+    static void ProcessStreamingRequest(TextureStreaming* streaming, StreamingRequest& request)
+    {
+        request.m_Image = LoadStreamingImage(streaming, request.m_Path);
+        if (request.m_Image == 0)
+        {
+            dmLogWarning("Failed to stream texture %s", request.m_Path);
+        }
+    }
+
+#if !defined(DM_NO_THREAD_SUPPORT)
+    static void TextureStreamingThread(void* arg)
+    {
+        TextureStreaming* streaming = (TextureStreaming*) arg;
+        while (true)
+        {
+            StreamingRequest request;
+            {
+                dmMutex::ScopedLock lk(streaming->m_Mutex);
+                while (streaming->m_Requests.Empty() && !streaming->m_Shutdown)
+                {
+                    dmConditionVariable::Wait(streaming->m_Condition, streaming->m_Mutex);
+                }
+                if (streaming->m_Shutdown)
+                {
+                    return;
+                }
+                request = streaming->m_Requests[0];
+                streaming->m_Requests.EraseSwap(0);
+            }
+
+            ProcessStreamingRequest(streaming, request);
+
+            dmMutex::ScopedLock lk(streaming->m_Mutex);
+            PushRequest(streaming->m_Loaded, request);
+        }
+    }
+#endif
+
+    static void RequestBaseMip(TextureStreaming* streaming, dmGraphics::HTexture texture, StreamingTexture* entry, uint32_t base_mip)
+    {
+        streaming->m_CommittedSize -= GetStreamingSize(entry, entry->m_RequestedBaseMip);
+        streaming->m_CommittedSize += GetStreamingSize(entry, base_mip);
+        entry->m_RequestedBaseMip = base_mip;
+        entry->m_Loading = 1;
+
+        StreamingRequest request;
+        request.m_Texture = texture;
+        request.m_Path = strdup(entry->m_Path);
+        request.m_Image = 0;
+        request.m_Id = entry->m_Id;
+
+        dmMutex::ScopedLock lk(streaming->m_Mutex);
+        PushRequest(streaming->m_Requests, request);
+        dmConditionVariable::Signal(streaming->m_Condition);
+    }
+
+    struct EvictCandidate
+    {
+        dmGraphics::HTexture m_Texture;
+        uint32_t             m_LastUsedFrame;
+    };
+
+    static void CollectEvictCandidate(dmArray<EvictCandidate>* candidates, const uint64_t* key, StreamingTexture* entry)
+    {
+        uint32_t unused_frames = g_TextureStreaming->m_Frame - entry->m_LastUsedFrame;
+        if (entry->m_RequestedBaseMip == 0 && entry->m_InitialBaseMip > 0 && !entry->m_Loading && unused_frames > g_TextureStreaming->m_Params.m_EvictFrames)
+        {
+            if (candidates->Full())
+            {
+                candidates->OffsetCapacity(64);
+            }
+            EvictCandidate candidate = { (dmGraphics::HTexture) (uintptr_t) *key, entry->m_LastUsedFrame };
+            candidates->Push(candidate);
+        }
+    }
+
+    static int CompareEvictCandidates(const void* a, const void* b)
+    {
+        return (int) (((const EvictCandidate*) a)->m_LastUsedFrame - ((const EvictCandidate*) b)->m_LastUsedFrame);
+    }
+
+    // Drops the large mips of the textures that have been unused the longest, until the committed size is within the budget
+    static void EvictTextures(TextureStreaming* streaming, uint64_t required_size)
+    {
+        dmArray<EvictCandidate> candidates;
+        streaming->m_Textures.Iterate(CollectEvictCandidate, &candidates);
+        if (candidates.Empty())
+        {
+            return;
+        }
+        qsort(candidates.Begin(), candidates.Size(), sizeof(EvictCandidate), CompareEvictCandidates);
+
+        for (uint32_t i = 0; i < candidates.Size() && streaming->m_CommittedSize + required_size > streaming->m_Params.m_MemoryBudget; ++i)
+        {
+            StreamingTexture* entry = streaming->m_Textures.Get((uintptr_t) candidates[i].m_Texture);
+            RequestBaseMip(streaming, candidates[i].m_Texture, entry, entry->m_InitialBaseMip);
+        }
+    }
+
+    // Uploads a loaded request, if the texture still exists
+    static void UploadStreamingRequest(TextureStreaming* streaming, StreamingRequest& request)
+    {
+        DM_PROFILE(Resource, "UploadStreamingTexture");
+        StreamingTexture* entry = streaming->m_Textures.Get((uintptr_t) request.m_Texture);
+        if (!entry || entry->m_Id != request.m_Id)
+        {
+            return;
+        }
+
+        entry->m_Loading = 0;
+        if (!request.m_Image || !request.m_Image->m_Image)
+        {
+            // Keep the mips it has, and don't try again
+            streaming->m_CommittedSize -= GetStreamingSize(entry, entry->m_RequestedBaseMip);
+            streaming->m_CommittedSize += GetStreamingSize(entry, entry->m_BaseMip);
+            entry->m_RequestedBaseMip = entry->m_BaseMip;
+            entry->m_Failed = 1;
+            return;
+        }
+
+        dmGraphics::HTexture texture = request.m_Texture;
+        AcquireResources(request.m_Path, 0, streaming->m_GraphicsContext, request.m_Image, texture, entry->m_RequestedBaseMip, false, &texture);
+        entry->m_BaseMip = entry->m_RequestedBaseMip;
+    }
+
+    void InitializeTextureStreaming(const TextureStreamingParams& params)
+    {
+        assert(g_TextureStreaming == 0);
+        TextureStreaming* streaming = new TextureStreaming;
+        streaming->m_Params = params;
+        streaming->m_GraphicsContext = dmRender::GetGraphicsContext(params.m_RenderContext);
+        streaming->m_CommittedSize = 0;
+        streaming->m_Frame = 0;
+        streaming->m_NextId = 0;
+        streaming->m_Mutex = dmMutex::New();
+        streaming->m_Condition = dmConditionVariable::New();
+        streaming->m_Shutdown = false;
+        streaming->m_Thread = 0;
+#if !defined(DM_NO_THREAD_SUPPORT)
+        streaming->m_Thread = dmThread::New(TextureStreamingThread, 0x80000, streaming, "texture_stream");
+#endif
+        dmRender::SetTextureUsedCallback(params.m_RenderContext, OnTextureUsed, streaming);
+        g_TextureStreaming = streaming;
+    }
+
+    static void FreeStreamingTexture(void*, const uint64_t*, StreamingTexture* entry)
+    {
+        free(entry->m_Path);
+    }
+
+    void FinalizeTextureStreaming()
+    {
+        TextureStreaming* streaming = g_TextureStreaming;
+        if (!streaming)
+        {
+            return;
+        }
+        dmRender::SetTextureUsedCallback(streaming->m_Params.m_RenderContext, 0, 0);
+
+        if (streaming->m_Thread)
+        {
+            {
+                dmMutex::ScopedLock lk(streaming->m_Mutex);
+                streaming->m_Shutdown = true;
+                dmConditionVariable::Signal(streaming->m_Condition);
+            }
+            dmThread::Join(streaming->m_Thread);
+        }
+
+        for (uint32_t i = 0; i < streaming->m_Requests.Size(); ++i)
+        {
+            FreeStreamingRequest(streaming->m_Requests[i]);
+        }
+        for (uint32_t i = 0; i < streaming->m_Loaded.Size(); ++i)
+        {
+            FreeStreamingRequest(streaming->m_Loaded[i]);
+        }
+        streaming->m_Textures.Iterate(FreeStreamingTexture, (void*) 0);
+
+        dmConditionVariable::Delete(streaming->m_Condition);
+        dmMutex::Delete(streaming->m_Mutex);
+        delete streaming;
+        g_TextureStreaming = 0;
+    }
+
+    void UpdateTextureStreaming()
+    {
+        TextureStreaming* streaming = g_TextureStreaming;
+        if (!streaming)
+        {
+            return;
+        }
+        DM_PROFILE(Resource, "UpdateTextureStreaming");
+
+        // Upload one texture per frame, as the upload is made on the main thread
+        StreamingRequest request;
+        bool loaded = false;
+        {
+            dmMutex::ScopedLock lk(streaming->m_Mutex);
+#if defined(DM_NO_THREAD_SUPPORT)
+            if (!streaming->m_Requests.Empty())
+            {
+                request = streaming->m_Requests[0];
+                streaming->m_Requests.EraseSwap(0);
+                ProcessStreamingRequest(streaming, request);
+                PushRequest(streaming->m_Loaded, request);
+            }
+#endif
+            if (!streaming->m_Loaded.Empty())
+            {
+                request = streaming->m_Loaded[0];
+                streaming->m_Loaded.EraseSwap(0);
+                loaded = true;
+            }
+        }
+        if (loaded)
+        {
+            UploadStreamingRequest(streaming, request);
+            FreeStreamingRequest(request);
+        }
+
+        // Stream in the textures that were drawn, as long as they fit in the budget
+        uint64_t budget = streaming->m_Params.m_MemoryBudget;
+        for (uint32_t i = 0; i < streaming->m_WantedTextures.Size(); ++i)
+        {
+            dmGraphics::HTexture texture = streaming->m_WantedTextures[i];
+            StreamingTexture* entry = streaming->m_Textures.Get((uintptr_t) texture);
+            if (!entry)
+            {
+                continue;
+            }
+            entry->m_Wanted = 0;
+            if (entry->m_RequestedBaseMip == 0 || entry->m_Loading)
+            {
+                continue;
+            }
+
+            uint64_t required_size = entry->m_FullSize - GetStreamingSize(entry, entry->m_RequestedBaseMip);
+            if (streaming->m_CommittedSize + required_size > budget)
+            {
+                EvictTextures(streaming, required_size);
+            }
+            if (streaming->m_CommittedSize + required_size <= budget)
+            {
+                RequestBaseMip(streaming, texture, entry, 0);
+            }
+        }
+        streaming->m_WantedTextures.SetSize(0);
+
+        DM_COUNTER("TextureStreamingKb", (uint32_t) (streaming->m_CommittedSize / 1024));
+        ++streaming->m_Frame;
+    }
+
     dmResource::Result ResTexturePreload(const dmResource::ResourcePreloadParams& params)
     {
         dmGraphics::TextureImage* texture_image;
@@ -236,6 +860,7 @@ namespace dmGameSystem
         }
 
         ImageDesc* image_desc = CreateImage(params.m_Filename, (dmGraphics::HContext) params.m_Context, texture_image);
+        SelectImage(params.m_Filename, (dmGraphics::HContext) params.m_Context, image_desc);
         *params.m_PreloadData = image_desc;
         return dmResource::RESULT_OK;
     }
@@ -259,17 +884,24 @@ namespace dmGameSystem
     dmResource::Result ResTextureCreate(const dmResource::ResourceCreateParams& params)
     {
         dmGraphics::HContext graphics_context = (dmGraphics::HContext) params.m_Context;
+        ImageDesc* image_desc = (ImageDesc*) params.m_PreloadData;
+        uint32_t base_mip = GetStreamingBaseMip(image_desc);
         dmGraphics::HTexture texture;
-        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, (ImageDesc*) params.m_PreloadData, 0, &texture);
+        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, image_desc, 0, base_mip, true, &texture);
         if (r == dmResource::RESULT_OK)
         {
             params.m_Resource->m_Resource = (void*) texture;
+            if (base_mip > 0)
+            {
+                RegisterStreamingTexture(params.m_Filename, texture, image_desc, base_mip);
+            }
         }
         return r;
     }
 
     dmResource::Result ResTextureDestroy(const dmResource::ResourceDestroyParams& params)
     {
+        UnregisterStreamingTexture((dmGraphics::HTexture) params.m_Resource->m_Resource);
         dmGraphics::DeleteTexture((dmGraphics::HTexture) params.m_Resource->m_Resource);
         return dmResource::RESULT_OK;
     }
@@ -292,12 +924,12 @@ namespace dmGameSystem
         // Note that the image desc for performance reasons keeps references to the DDF image, meaning they're invalid after the DDF message has been free'd!
         ImageDesc* image_desc = CreateImage(params.m_Filename, (dmGraphics::HContext) params.m_Context, texture_image);
 
-        // Set up the new texture (version), wait for it to finish before issuing new requests
-        SynchronizeTexture(texture, true);
-        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, image_desc, texture, &texture);
-
-        // Wait for any async texture uploads
+        // Set up the new texture (version), wait for it to finish before issuing new requests.
+        // The data is uploaded synchronously, as queued uploads are only made between frames.
+        // The new data is uploaded with all its mips and is no longer streamed
         SynchronizeTexture(texture, true);
+        UnregisterStreamingTexture(texture);
+        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, image_desc, texture, 0, false, &texture);
 
         DestroyImage(image_desc);
 
@@ -311,4 +943,189 @@ namespace dmGameSystem
         }
         return r;
     }
+
+    // Header of a changed region in a texture patch, followed by the tightly packed pixels of the region
+    struct TexturePatchRegion
+    {
+        uint16_t m_X;
+        uint16_t m_Y;
+        uint16_t m_Width;
+        uint16_t m_Height;
+        uint8_t  m_MipMap;
+        uint8_t  m_Format; // dmGraphics::TextureImage::TextureFormat
+        uint16_t m_Reserved;
+    };
+
+    static uint32_t GetPatchBytesPerPixel(uint8_t format)
+    {
+        switch (format)
+        {
+            case dmGraphics::TextureImage::TEXTURE_FORMAT_LUMINANCE:        return 1;
+            case dmGraphics::TextureImage::TEXTURE_FORMAT_LUMINANCE_ALPHA:  return 2;
+            case dmGraphics::TextureImage::TEXTURE_FORMAT_RGB:              return 3;
+            case dmGraphics::TextureImage::TEXTURE_FORMAT_RGBA:             return 4;
+            default:                                                        return 0; // Compressed formats are reloaded fully
+        }
+    }
+
+    // Reads the region at *offset and advances it, false if the region is malformed or not supported
+    static bool NextPatchRegion(const uint8_t* patch, uint32_t patch_size, uint32_t* offset, TexturePatchRegion* region, const uint8_t** pixels, uint32_t* pixels_size)
+    {
+        if (patch_size - *offset < sizeof(TexturePatchRegion))
+        {
+            return false;
+        }
+        memcpy(region, patch + *offset, sizeof(TexturePatchRegion));
+        *offset += sizeof(TexturePatchRegion);
+
+        uint32_t bpp = GetPatchBytesPerPixel(region->m_Format);
+        uint32_t size = (uint32_t) region->m_Width * region->m_Height * bpp;
+        if (bpp == 0 || size == 0 || patch_size - *offset < size)
+        {
+            return false;
+        }
+        *pixels = patch + *offset;
+        *pixels_size = size;
+        *offset += size;
+        return true;
+    }
+
+    // Uploads the changed regions of an uncompressed 2D texture in-place. The whole patch is validated first,
+    // so that a patch that can't be applied leaves the texture untouched for the full reload.
+    dmResource::Result ResTexturePatch(const dmResource::ResourcePatchParams& params)
+    {
+        dmGraphics::HTexture texture = (dmGraphics::HTexture) params.m_Resource->m_Resource;
+        const uint8_t* patch = (const uint8_t*) params.m_Patch;
+
+        SynchronizeTexture(texture, true);
+
+        // Mips above the streamed base mip aren't resident, they are loaded from the changed file when requested
+        StreamingTexture* entry = g_TextureStreaming ? g_TextureStreaming->m_Textures.Get((uintptr_t) texture) : 0;
+        uint32_t base_mip = entry ? entry->m_BaseMip : 0;
+        uint32_t width = dmGraphics::GetTextureWidth(texture);
+        uint32_t height = dmGraphics::GetTextureHeight(texture);
+
+        TexturePatchRegion region;
+        const uint8_t* pixels;
+        uint32_t pixels_size;
+        uint32_t offset = 0;
+        while (offset < params.m_PatchSize)
+        {
+            if (!NextPatchRegion(patch, params.m_PatchSize, &offset, &region, &pixels, &pixels_size))
+            {
+                return dmResource::RESULT_NOT_SUPPORTED;
+            }
+            if (region.m_MipMap < base_mip)
+            {
+                continue;
+            }
+            uint32_t mip = region.m_MipMap - base_mip;
+            if (mip >= 16 || region.m_X + region.m_Width > dmMath::Max(1u, width >> mip) || region.m_Y + region.m_Height > dmMath::Max(1u, height >> mip))
+            {
+                return dmResource::RESULT_NOT_SUPPORTED;
+            }
+        }
+
+        offset = 0;
+        while (offset < params.m_PatchSize)
+        {
+            NextPatchRegion(patch, params.m_PatchSize, &offset, &region, &pixels, &pixels_size);
+            if (region.m_MipMap < base_mip)
+            {
+                continue;
+            }
+
+            dmGraphics::TextureParams texture_params;
+            texture_params.m_SubUpdate = true;
+            texture_params.m_X = region.m_X;
+            texture_params.m_Y = region.m_Y;
+            texture_params.m_Width = region.m_Width;
+            texture_params.m_Height = region.m_Height;
+            texture_params.m_MipMap = region.m_MipMap - base_mip;
+            texture_params.m_Format = TextureImageToTextureFormat((dmGraphics::TextureImage::TextureFormat) region.m_Format);
+            texture_params.m_Data = pixels;
+            texture_params.m_DataSize = pixels_size;
+            dmGraphics::SetTexture(texture, texture_params);
+        }
+        return dmResource::RESULT_OK;
+    }
+
+    dmResource::Result SetTextureRegion(dmResource::HFactory factory, dmhash_t path_hash, const dmGraphics::TextureParams& params, bool generate_mipmaps)
+    {
+        DM_PROFILE(Resource, "SetTextureRegion");
+        dmMutex::ScopedLock lk(dmResource::GetLoadMutex(factory));
+
+        static const uint64_t texture_ext = dmHashString64("texturec");
+        dmResource::SResourceDescriptor descriptor;
+        dmResource::Result r = dmResource::GetDescriptorWithExt(factory, path_hash, &texture_ext, 1, &descriptor);
+        if (r != dmResource::RESULT_OK)
+        {
+            return r == dmResource::RESULT_INVALID_FILE_EXTENSION ? dmResource::RESULT_NOT_SUPPORTED : dmResource::RESULT_RESOURCE_NOT_FOUND;
+        }
+
+        dmGraphics::HTexture texture = (dmGraphics::HTexture) descriptor.m_Resource;
+        SynchronizeTexture(texture, true);
+
+        // The mip 0 of a streamed texture may not be resident
+        StreamingTexture* entry = g_TextureStreaming ? g_TextureStreaming->m_Textures.Get((uintptr_t) texture) : 0;
+        if ((entry && entry->m_BaseMip > 0) ||
+            params.m_X + params.m_Width > dmGraphics::GetTextureWidth(texture) ||
+            params.m_Y + params.m_Height > dmGraphics::GetTextureHeight(texture))
+        {
+            return dmResource::RESULT_NOT_SUPPORTED;
+        }
+
+        dmGraphics::TextureParams texture_params = params;
+        texture_params.m_SubUpdate = true;
+        texture_params.m_MipMap = 0;
+        dmGraphics::SetTexture(texture, texture_params);
+
+        // Without GPU support the texture keeps its earlier mips, which is preferred over stalling on a CPU rebuild each update
+        if (generate_mipmaps)
+        {
+            dmGraphics::GenerateMipMaps(texture);
+        }
+        return dmResource::RESULT_OK;
+    }
+
+    // Only the original size of the image is kept, it is neither transcoded nor uploaded
+    dmResource::Result ResTextureBlankCreate(const dmResource::ResourceCreateParams& params)
+    {
+        dmGraphics::TextureImage* texture_image;
+        dmDDF::Result e = dmDDF::LoadMessage<dmGraphics::TextureImage>(params.m_Buffer, params.m_BufferSize, (&texture_image));
+        if ( e != dmDDF::RESULT_OK )
+        {
+            return dmResource::RESULT_FORMAT_ERROR;
+        }
+
+        dmGraphics::HContext context = (dmGraphics::HContext) params.m_Context;
+        dmGraphics::TextureCreationParams creation_params;
+        creation_params.m_Type = texture_image->m_Type == dmGraphics::TextureImage::TYPE_CUBEMAP ? dmGraphics::TEXTURE_TYPE_CUBE_MAP : dmGraphics::TEXTURE_TYPE_2D;
+        creation_params.m_Width = 1;
+        creation_params.m_Height = 1;
+        creation_params.m_OriginalWidth = 1;
+        creation_params.m_OriginalHeight = 1;
+        creation_params.m_MipMapCount = 1;
+        if (texture_image->m_Alternatives.m_Count > 0)
+        {
+            creation_params.m_OriginalWidth = texture_image->m_Alternatives[0].m_OriginalWidth;
+            creation_params.m_OriginalHeight = texture_image->m_Alternatives[0].m_OriginalHeight;
+        }
+        dmDDF::FreeMessage(texture_image);
+
+        dmGraphics::HTexture texture = dmGraphics::NewTexture(context, creation_params);
+        dmGraphics::TextureParams texture_params;
+        dmGraphics::GetDefaultTextureFilters(context, texture_params.m_MinFilter, texture_params.m_MagFilter);
+        SetBlankTexture(texture, texture_params, false);
+
+        params.m_Resource->m_Resource = (void*) texture;
+        params.m_Resource->m_ResourceSize = dmGraphics::GetTextureResourceSize(texture);
+        return dmResource::RESULT_OK;
+    }
+
+    dmResource::Result ResTextureBlankRecreate(const dmResource::ResourceRecreateParams& params)
+    {
+        // The texture stays blank, whatever the new data is
+        return dmResource::RESULT_OK;
+    }
 }
@@ -14,6 +14,7 @@
 #define DM_GAMESYS_RES_TEXTURE_H
 
 #include <resource/resource.h>
+#include <graphics/graphics.h>
 #include <dmsdk/gamesys/resources/res_texture.h>
 
 namespace dmGameSystem
@@ -27,6 +28,18 @@ namespace dmGameSystem
     dmResource::Result ResTextureDestroy(const dmResource::ResourceDestroyParams& params);
 
     dmResource::Result ResTextureRecreate(const dmResource::ResourceRecreateParams& params);
+
+    // Patches changed regions of uncompressed 2D textures, e.g. an edited part of a large atlas image
+    dmResource::Result ResTexturePatch(const dmResource::ResourcePatchParams& params);
+
+    // Writes a region of mip 0 of a loaded texture in place, without recreating it, and regenerates the
+    // other mips on the GPU if generate_mipmaps is set. Used for textures that are updated every few frames
+    dmResource::Result SetTextureRegion(dmResource::HFactory factory, dmhash_t path_hash, const dmGraphics::TextureParams& params, bool generate_mipmaps);
+
+    // Blank 1x1 textures with the original size of the image, used by headless servers
+    dmResource::Result ResTextureBlankCreate(const dmResource::ResourceCreateParams& params);
+
+    dmResource::Result ResTextureBlankRecreate(const dmResource::ResourceRecreateParams& params);
 }
 
 #endif
@@ -45,12 +45,6 @@ namespace dmGameSystem
         {
             return r;
         }
-        if(dmRender::GetMaterialVertexSpace(tile_grid->m_Material) != dmRenderDDF::MaterialDesc::VERTEX_SPACE_WORLD)
-        {
-            dmLogError("Failed to create Tile Grid component. This component only supports materials with the Vertex Space property set to 'vertex-space-world'");
-            return dmResource::RESULT_NOT_SUPPORTED;
-        }
-
         // Add-alpha is deprecated because of premultiplied alpha and replaced by Add
         if (tile_grid_ddf->m_BlendMode == dmGameSystemDDF::TileGrid::BLEND_MODE_ADD_ALPHA)
             tile_grid_ddf->m_BlendMode = dmGameSystemDDF::TileGrid::BLEND_MODE_ADD;
@@ -237,4 +231,67 @@ namespace dmGameSystem
         }
         return r;
     }
+
+    // A changed cell in a tile grid patch
+    struct TileGridPatchCell
+    {
+        uint16_t m_Layer;
+        uint8_t  m_HFlip;
+        uint8_t  m_VFlip;
+        int32_t  m_X;
+        int32_t  m_Y;
+        uint32_t m_Tile;
+    };
+
+    static dmGameSystemDDF::TileCell* FindCell(dmGameSystemDDF::TileGrid* tile_grid_ddf, const TileGridPatchCell& patch_cell)
+    {
+        if (patch_cell.m_Layer >= tile_grid_ddf->m_Layers.m_Count)
+        {
+            return 0;
+        }
+        dmGameSystemDDF::TileLayer* layer = &tile_grid_ddf->m_Layers[patch_cell.m_Layer];
+        for (uint32_t i = 0; i < layer->m_Cell.m_Count; ++i)
+        {
+            dmGameSystemDDF::TileCell* cell = &layer->m_Cell[i];
+            if (cell->m_X == patch_cell.m_X && cell->m_Y == patch_cell.m_Y)
+            {
+                return cell;
+            }
+        }
+        return 0;
+    }
+
+    dmResource::Result ResTileGridPatch(const dmResource::ResourcePatchParams& params)
+    {
+        TileGridResource* tile_grid = (TileGridResource*) params.m_Resource->m_Resource;
+        if (params.m_PatchSize % sizeof(TileGridPatchCell) != 0)
+        {
+            return dmResource::RESULT_NOT_SUPPORTED;
+        }
+
+        // Cells can only be changed in-place, added or removed cells change the grid bounds and need a full reload.
+        // Everything is validated first so that the resource is left untouched for the reload.
+        uint32_t cell_count = params.m_PatchSize / sizeof(TileGridPatchCell);
+        const uint8_t* patch = (const uint8_t*) params.m_Patch;
+        for (uint32_t i = 0; i < cell_count; ++i)
+        {
+            TileGridPatchCell patch_cell;
+            memcpy(&patch_cell, patch + i * sizeof(TileGridPatchCell), sizeof(TileGridPatchCell));
+            if (FindCell(tile_grid->m_TileGrid, patch_cell) == 0)
+            {
+                return dmResource::RESULT_NOT_SUPPORTED;
+            }
+        }
+
+        for (uint32_t i = 0; i < cell_count; ++i)
+        {
+            TileGridPatchCell patch_cell;
+            memcpy(&patch_cell, patch + i * sizeof(TileGridPatchCell), sizeof(TileGridPatchCell));
+            dmGameSystemDDF::TileCell* cell = FindCell(tile_grid->m_TileGrid, patch_cell);
+            cell->m_Tile = patch_cell.m_Tile;
+            cell->m_HFlip = patch_cell.m_HFlip;
+            cell->m_VFlip = patch_cell.m_VFlip;
+        }
+        return dmResource::RESULT_OK;
+    }
 }
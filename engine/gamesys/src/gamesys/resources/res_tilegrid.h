@@ -25,6 +25,9 @@ namespace dmGameSystem
     dmResource::Result ResTileGridDestroy(const dmResource::ResourceDestroyParams& params);
 
     dmResource::Result ResTileGridRecreate(const dmResource::ResourceRecreateParams& params);
+
+    // Patches changed cells in-place, the components using the tile grid rebuild their cells when notified
+    dmResource::Result ResTileGridPatch(const dmResource::ResourcePatchParams& params);
 }
 
 #endif // DM_GAMESYS_RES_TILEGRID_H
@@ -17,6 +17,7 @@
 #include <dlib/buffer.h>
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
+#include <dmsdk/vectormath/cpp/vectormath_aos.h>
 
 #include "script_buffer.h"
 #include "../resources/res_buffer.h"
@@ -100,6 +101,12 @@ namespace dmGameSystem
      * @name buffer.VALUE_TYPE_FLOAT32
      * @variable
     */
+    /*# struct of arrays
+     * Store each stream as a separate, tightly packed array, starting on a 16 byte boundary.
+     * Such buffers can't be used as vertex data for meshes.
+     * @name buffer.CREATE_FLAG_STRUCT_OF_ARRAYS
+     * @variable
+    */
 
 #define SCRIPT_LIB_NAME "buffer"
 #define SCRIPT_TYPE_NAME_BUFFER "buffer"
@@ -334,6 +341,7 @@ namespace dmGameSystem
      * - [type:constant] `type`: The data type of the stream
      * - [type:number] `count`: The number of values each element should hold
      *
+     * @param [flags] [type:number] creation flags. Currently `buffer.CREATE_FLAG_STRUCT_OF_ARRAYS` or 0 (default)
      * @return buffer [type:buffer] the new buffer
      *
      * @examples
@@ -394,8 +402,10 @@ namespace dmGameSystem
         }
         lua_pop(L, 1);
 
+        uint32_t flags = (uint32_t)luaL_optinteger(L, 3, 0);
+
         dmBuffer::HBuffer buffer = 0;
-        dmBuffer::Result r = dmBuffer::Create((uint32_t)num_elements, decl, num_decl, &buffer);
+        dmBuffer::Result r = dmBuffer::Create((uint32_t)num_elements, decl, num_decl, flags, &buffer);
 
         if( r != dmBuffer::RESULT_OK )
         {
@@ -463,6 +473,14 @@ namespace dmGameSystem
                                     const BufferStream* srcstream, uint32_t srcoffset,
                                     uint32_t count)
     {
+        // Tightly packed streams can be copied as one block
+        if (dststream->m_Stride == dststream->m_TypeCount && srcstream->m_Stride == srcstream->m_TypeCount)
+        {
+            uint32_t value_size = dmBuffer::GetSizeForValueType(dststream->m_Type);
+            memmove((uint8_t*)dststream->m_Data + dstoffset * value_size, (const uint8_t*)srcstream->m_Data + srcoffset * value_size, count * value_size);
+            return true;
+        }
+
         #define DM_COPY_STREAM(_T_) CopyStreamInternalT<_T_>((_T_*)dststream->m_Data, dstoffset, dststream->m_Stride, \
                                                             (_T_*)srcstream->m_Data, srcoffset, srcstream->m_Stride, \
                                                             count, dststream->m_TypeCount)
@@ -553,7 +571,131 @@ namespace dmGameSystem
             {
                 return DM_LUA_ERROR("Unknown stream value type: %d", dststream->m_Type);
             }
+            if (count > 0)
+            {
+                uint32_t first = dstoffset / dststream->m_TypeCount;
+                uint32_t last = (dstoffset + count - 1) / dststream->m_TypeCount;
+                dmBuffer::AddDirtyRange(dststream->m_Buffer, first, last - first + 1);
+            }
+        }
+        return 0;
+    }
+
+    // Gets the optional element range arguments of the bulk stream functions
+    static void CheckElementRange(lua_State* L, int index, BufferStream* stream, uint32_t* offset, uint32_t* count)
+    {
+        int _offset = luaL_optinteger(L, index, 0);
+        int _count = luaL_optinteger(L, index + 1, (int)stream->m_Count - _offset);
+        if (_offset < 0 || _count < 0 || (uint32_t)(_offset + _count) > stream->m_Count)
+        {
+            luaL_error(L, "Element range out of bounds: Stream length: %d, Offset: %d, Count: %d", stream->m_Count, _offset, _count);
+        }
+        *offset = (uint32_t)_offset;
+        *count = (uint32_t)_count;
+    }
+
+    /*# sets a range of elements in a stream to a value
+     *
+     * Set each element in a range of a stream to the same value, without indexing the stream
+     * from Lua for each value.
+     *
+     * @name buffer.fill_stream
+     * @param stream [type:bufferstream] the stream to fill
+     * @param value [type:number|table] a number used for every component, or a table with one number per component
+     * @param [offset] [type:number] the first element to set (measured in elements). Defaults to 0
+     * @param [count] [type:number] the number of elements to set. Defaults to the rest of the stream
+     *
+     * @examples
+     * How to set all colors of a mesh to white
+     *
+     * ```lua
+     * local colors = buffer.get_stream(self.buffer, hash("color"))
+     * buffer.fill_stream(colors, {1, 1, 1, 1})
+     * ```
+    */
+    static int FillStream(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        BufferStream* stream = CheckStream(L, 1);
+        uint32_t offset, count;
+        CheckElementRange(L, 3, stream, &offset, &count);
+
+        // Convert the value into one element of the stream type
+        uint8_t value[256 * sizeof(uint64_t)];
+        if (lua_istable(L, 2))
+        {
+            if (lua_objlen(L, 2) != stream->m_TypeCount)
+            {
+                return DM_LUA_ERROR("Expected a table with %u values, got %d", stream->m_TypeCount, (int)lua_objlen(L, 2));
+            }
+            for (uint32_t i = 0; i < stream->m_TypeCount; ++i)
+            {
+                lua_rawgeti(L, 2, i + 1);
+                stream->m_Set(value, i, luaL_checknumber(L, -1));
+                lua_pop(L, 1);
+            }
+        }
+        else
+        {
+            lua_Number v = luaL_checknumber(L, 2);
+            for (uint32_t i = 0; i < stream->m_TypeCount; ++i)
+            {
+                stream->m_Set(value, i, v);
+            }
+        }
+
+        dmBuffer::Result r = dmBuffer::FillStream(stream->m_Buffer, stream->m_Name, value, offset, count);
+        if (r != dmBuffer::RESULT_OK)
+        {
+            return DM_LUA_ERROR("Failed to fill stream: %s", dmBuffer::GetResultString(r));
+        }
+        dmBuffer::AddDirtyRange(stream->m_Buffer, offset, count);
+        return 0;
+    }
+
+    /*# transforms the positions in a stream by a matrix
+     *
+     * Transform a range of positions in place. The stream must be a `buffer.VALUE_TYPE_FLOAT32`
+     * stream with 3 or 4 components. Positions with 3 components are transformed as points (w = 1).
+     *
+     * @name buffer.transform_positions
+     * @param stream [type:bufferstream] the stream to transform
+     * @param matrix [type:matrix4] the transform
+     * @param [offset] [type:number] the first element to transform (measured in elements). Defaults to 0
+     * @param [count] [type:number] the number of elements to transform. Defaults to the rest of the stream
+     *
+     * @examples
+     * How to rotate the vertices of a procedural mesh
+     *
+     * ```lua
+     * local positions = buffer.get_stream(self.buffer, hash("position"))
+     * buffer.transform_positions(positions, vmath.matrix4_rotation_z(math.pi * 0.5))
+     * ```
+    */
+    static int TransformPositions(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        BufferStream* stream = CheckStream(L, 1);
+        Vectormath::Aos::Matrix4* m = dmScript::CheckMatrix4(L, 2);
+        uint32_t offset, count;
+        CheckElementRange(L, 3, stream, &offset, &count);
+
+        float matrix[16];
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            Vectormath::Aos::Vector4 col = m->getCol(c);
+            for (uint32_t r = 0; r < 4; ++r)
+            {
+                matrix[c * 4 + r] = col.getElem(r);
+            }
+        }
+
+        dmBuffer::Result r = dmBuffer::TransformPositions(stream->m_Buffer, stream->m_Name, matrix, offset, count);
+        if (r != dmBuffer::RESULT_OK)
+        {
+            return DM_LUA_ERROR("Failed to transform stream: %s", dmBuffer::GetResultString(r));
         }
+        dmBuffer::AddDirtyRange(stream->m_Buffer, offset, count);
         return 0;
     }
 
@@ -668,6 +810,7 @@ namespace dmGameSystem
                 return DM_LUA_ERROR("Unknown stream value type: %d", dststream->m_Type);
             }
         }
+        dmBuffer::AddDirtyRange(dstbuffer, dstoffset, count);
 
         return 0;
     }
@@ -873,7 +1016,7 @@ namespace dmGameSystem
         uint32_t count = index / stream->m_TypeCount;
         uint32_t component = index % stream->m_TypeCount;
         stream->m_Set(stream->m_Data, count * stream->m_Stride + component, luaL_checknumber(L, 3));
-        dmBuffer::UpdateContentVersion(stream->m_Buffer);
+        dmBuffer::AddDirtyRange(stream->m_Buffer, count, 1);
         return 0;
     }
 
@@ -900,6 +1043,8 @@ namespace dmGameSystem
         {"get_bytes", GetBytes},
         {"copy_stream", CopyStream},
         {"copy_buffer", CopyBuffer},
+        {"fill_stream", FillStream},
+        {"transform_positions", TransformPositions},
         {0, 0}
     };
 
@@ -942,6 +1087,7 @@ namespace dmGameSystem
         SETCONSTANT(VALUE_TYPE_INT32);
         SETCONSTANT(VALUE_TYPE_INT64);
         SETCONSTANT(VALUE_TYPE_FLOAT32);
+        SETCONSTANT(CREATE_FLAG_STRUCT_OF_ARRAYS);
 
 #undef SETCONSTANT
 
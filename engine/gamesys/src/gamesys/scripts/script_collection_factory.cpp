@@ -293,7 +293,7 @@ namespace dmGameSystem
      * ```
      */
 
-    int CollectionFactoryComp_Create(lua_State* L)
+    static int Create(lua_State* L, bool deferred_init)
     {
         int top = lua_gettop(L);
         dmGameObject::HInstance sender_instance = CheckGoInstance(L);
@@ -301,9 +301,15 @@ namespace dmGameSystem
 
         uintptr_t user_data;
         dmMessage::URL receiver;
-        dmGameObject::GetComponentUserDataFromLua(L, 1, collection, COLLECTION_FACTORY_EXT, &user_data, &receiver, 0);
+        void* world = 0;
+        dmGameObject::GetComponentUserDataFromLua(L, 1, collection, COLLECTION_FACTORY_EXT, &user_data, &receiver, &world);
         CollectionFactoryComponent* component = (CollectionFactoryComponent*) user_data;
 
+        if (deferred_init && top >= 6 && !lua_isnil(L, 6))
+        {
+            luaL_checktype(L, 6, LUA_TFUNCTION);
+        }
+
         Vectormath::Aos::Point3 position;
         if (top >= 2 && !lua_isnil(L, 2))
         {
@@ -389,8 +395,18 @@ namespace dmGameSystem
         int ref = dmScript::Ref(L, LUA_REGISTRYINDEX);
 
         dmGameObject::InstanceIdMap instances;
-        bool success = dmGameObject::SpawnFromCollection(collection, component->m_Resource->m_CollectionDesc, &prop_bufs,
-                                                         position, rotation, scale, &instances);
+        bool success;
+        uint32_t spawn_id = 0;
+        if (deferred_init)
+        {
+            success = dmGameObject::SpawnFromCollectionDeferredInit(collection, component->m_Resource->m_CollectionDesc, &prop_bufs,
+                                                                    position, rotation, scale, CompCollectionFactoryGetInitTimeBudget(world), &instances, &spawn_id);
+        }
+        else
+        {
+            success = dmGameObject::SpawnFromCollection(collection, component->m_Resource->m_CollectionDesc, &prop_bufs,
+                                                        position, rotation, scale, &instances);
+        }
 
         lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
         dmScript::SetInstance(L);
@@ -405,6 +421,19 @@ namespace dmGameSystem
             lua_setfield(L, -2, "__index");
             lua_setmetatable(L, -2);
             instances.Iterate(&InsertInstanceEntry, L);
+
+            if (deferred_init && top >= 6 && !lua_isnil(L, 6))
+            {
+                lua_pushvalue(L, 6);
+                int callback_ref = dmScript::Ref(L, LUA_REGISTRYINDEX);
+                dmScript::GetInstance(L);
+                int self_ref = dmScript::Ref(L, LUA_REGISTRYINDEX);
+                dmScript::PushURL(L, receiver);
+                int url_ref = dmScript::Ref(L, LUA_REGISTRYINDEX);
+                lua_pushvalue(L, -1);
+                int ids_ref = dmScript::Ref(L, LUA_REGISTRYINDEX);
+                CompCollectionFactoryAddDeferredSpawn(world, component, spawn_id, callback_ref, self_ref, url_ref, ids_ref);
+            }
         }
         else
         {
@@ -416,9 +445,59 @@ namespace dmGameSystem
         return 1;
     }
 
+    int CollectionFactoryComp_Create(lua_State* L)
+    {
+        return Create(L, false);
+    }
+
+    /*# Spawn a new instance of a collection, and initialize it over several frames
+     * Works like [ref:collectionfactory.create], but the `init()` functions of the spawned game objects
+     * are called over the following frames instead of immediately, to avoid a long frame when
+     * spawning large collections. The game objects exist, with their components and hierarchy, when the
+     * function returns, but they aren't initialized or updated until their `init()` has been called.
+     *
+     * The time spent initializing game objects each frame is set with `collectionfactory.init_time_budget`
+     * in game.project, in milliseconds (4 by default). At least one game object is initialized each frame.
+     *
+     * @name collectionfactory.create_deferred
+     * @param url [type:string|hash|url] the collection factory component to be used
+     * @param [position] [type:vector3] position to assign to the newly spawned collection
+     * @param [rotation] [type:quaternion] rotation to assign to the newly spawned collection
+     * @param [properties] [type:table] table of script properties to propagate to any new game object instances
+     * @param [scale] [type:number] uniform scaling to apply to the newly spawned collection (must be greater than 0).
+     * @param [complete_function] [type:function(self, url, ids))] function to call when all the game objects have been initialized.
+     *
+     * `self`
+     * : [type:object] The current object.
+     *
+     * `url`
+     * : [type:url] url of the collection factory component
+     *
+     * `ids`
+     * : [type:table] the table returned by the function
+     *
+     * @return ids [type:table] a table mapping the id:s from the collection to the new instance id:s
+     * @examples
+     *
+     * How to spawn a large level without a frame spike:
+     *
+     * ```lua
+     * function init(self)
+     *     collectionfactory.create_deferred("#roomfactory", nil, nil, nil, nil, function(self, url, ids)
+     *         msg.post(ids[hash("/door")], "open")
+     *     end)
+     * end
+     * ```
+     */
+    int CollectionFactoryComp_CreateDeferred(lua_State* L)
+    {
+        return Create(L, true);
+    }
+
     static const luaL_reg COLLECTION_FACTORY_COMP_FUNCTIONS[] =
     {
         {"create",            CollectionFactoryComp_Create},
+        {"create_deferred",   CollectionFactoryComp_CreateDeferred},
         {"load",              CollectionFactoryComp_Load},
         {"unload",            CollectionFactoryComp_Unload},
         {"get_status",        CollectionFactoryComp_GetStatus},
@@ -372,12 +372,65 @@ namespace dmGameSystem
         return 1;
     }
 
+    /*# preallocate game objects of a factory
+     *
+     * Preallocates the memory of `count` game objects of the factory prototype in the collection of the factory,
+     * so that spawning them with [ref:factory.create] doesn't allocate. The memory of deleted game objects
+     * is reused the same way, so this is mostly useful before a burst of spawns, e.g. when a level starts.
+     *
+     * The count is limited by the max instance count of the collection.
+     *
+     * [icon:attention] A factory that is marked as dynamic must be loaded using [ref:factory.load] first.
+     *
+     * @name factory.prewarm
+     * @param [url] [type:string|hash|url] the factory component to prewarm
+     * @param count [type:number] number of game objects to preallocate
+     * @examples
+     *
+     * Prewarm the bullets of a weapon:
+     *
+     * ```lua
+     * function init(self)
+     *     factory.prewarm("#bullet_factory", 100)
+     * end
+     * ```
+     */
+    int FactoryComp_Prewarm(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        dmGameObject::HInstance sender_instance = CheckGoInstance(L);
+        dmGameObject::HCollection collection = dmGameObject::GetCollection(sender_instance);
+
+        uintptr_t user_data;
+        dmMessage::URL receiver;
+        dmGameObject::GetComponentUserDataFromLua(L, 1, collection, FACTORY_EXT, &user_data, &receiver, 0);
+        FactoryComponent* component = (FactoryComponent*) user_data;
+        int count = luaL_checkinteger(L, 2);
+        if (count < 0)
+        {
+            return luaL_error(L, "The count must not be negative.");
+        }
+
+        if (dmGameSystem::CompFactoryGetStatus(component) != COMP_FACTORY_STATUS_LOADED && component->m_Resource->m_FactoryDesc->m_LoadDynamically)
+        {
+            return luaL_error(L, "The factory must be loaded before it can be prewarmed.");
+        }
+        dmGameObject::HPrototype prototype = dmGameSystem::CompFactoryGetPrototype(collection, component);
+        if (!prototype)
+        {
+            return luaL_error(L, "Error loading the factory prototype");
+        }
+        dmGameObject::PrewarmInstances(collection, prototype, (uint32_t)count);
+        return 0;
+    }
+
     static const luaL_reg FACTORY_COMP_FUNCTIONS[] =
     {
         {"create",            FactoryComp_Create},
         {"load",              FactoryComp_Load},
         {"unload",            FactoryComp_Unload},
         {"get_status",        FactoryComp_GetStatus},
+        {"prewarm",           FactoryComp_Prewarm},
         {0, 0}
     };
 
@@ -96,6 +96,27 @@ namespace dmGameSystem
      * The playback_rate is a non-negative number, a negative value will be clamped to 0.
      */
 
+    /*# [type:number] model layer
+     *
+     * The render layer of the model, a number between 0 and 31. The layer is tested against the
+     * layer mask of the camera with focus, or the mask set with [ref:render.set_layer_mask], before the
+     * model is drawn. Layer 0 is the default. The type of the property is number.
+     *
+     * @name layer
+     * @property
+     *
+     * @examples
+     *
+     * How to hide component "model" from the camera by moving it to a layer the camera doesn't draw:
+     *
+     * ```lua
+     * function init(self)
+     *   go.set("#model", "layer", 1)
+     *   go.set("camera#camera", "layer_mask", 1) -- only layer 0
+     * end
+     * ```
+     */
+
      /*# [type:hash] model animation
      *
      * The current animation set on the component. The type of the property is hash.
@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <assert.h>
 
+#include <dlib/buffer.h>
 #include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
@@ -27,6 +28,7 @@
 #include "components/comp_collision_object.h"
 
 #include "script_physics.h"
+#include <dmsdk/gamesys/script.h>
 #include <physics/physics.h>
 
 extern "C"
@@ -121,12 +123,92 @@ namespace dmGameSystem
      * @variable
      */
 
+    /*# collision_response contact event
+     *
+     * Report contacts with `collision_response` messages.
+     *
+     * @name physics.CONTACT_EVENTS_COLLISION
+     * @variable
+     */
+
+    /*# contact_point_response contact event
+     *
+     * Report contacts with `contact_point_response` messages.
+     *
+     * @name physics.CONTACT_EVENTS_CONTACT_POINT
+     * @variable
+     */
+
+    /*# first contact event mode
+     *
+     * Only report the contacts of the first frame two collision objects touch.
+     *
+     * @name physics.CONTACT_EVENTS_FIRST_CONTACT
+     * @variable
+     */
+
+    /*# aggregated contact event mode
+     *
+     * Merge all contacts between two collision objects during a physics step into one
+     * `collision_response` and one `contact_point_response`, with the average position and
+     * normal, the largest distance and the total applied impulse of the contact points.
+     *
+     * @name physics.CONTACT_EVENTS_AGGREGATE
+     * @variable
+     */
+
+    /*# default contact events
+     *
+     * The contact events of new collision objects, `physics.CONTACT_EVENTS_COLLISION` and
+     * `physics.CONTACT_EVENTS_CONTACT_POINT`.
+     *
+     * @name physics.CONTACT_EVENTS_DEFAULT
+     * @variable
+     */
+
+    /*# axis aligned box query shape
+     *
+     * A box aligned with the world axes, the `size` field of the query is the full size of the box.
+     *
+     * @name physics.QUERY_SHAPE_TYPE_AABB
+     * @variable
+     */
+
+    /*# sphere query shape
+     *
+     * A sphere in 3D and a circle in 2D, the `radius` field of the query is the radius of the shape.
+     *
+     * @name physics.QUERY_SHAPE_TYPE_SPHERE
+     * @variable
+     */
+
+    /*# box query shape
+     *
+     * A box rotated by the `rotation` field of the query, the `size` field of the query is the full size of the box.
+     * Only the rotation around the z axis is used in 2D.
+     *
+     * @name physics.QUERY_SHAPE_TYPE_BOX
+     * @variable
+     */
+
     struct PhysicsScriptContext
     {
         dmMessage::HSocket m_Socket;
         uint32_t m_ComponentIndex;
+        // Scratch arrays for physics.raycast_batch
+        dmArray<dmPhysics::RayCastRequest>  m_RayCastBatchRequests;
+        dmArray<dmPhysics::RayCastResponse> m_RayCastBatchResponses;
+        // Scratch arrays for physics.overlap and physics.shape_cast
+        dmArray<dmPhysics::ShapeQueryRequest> m_ShapeQueryRequests;
+        dmArray<dmPhysics::OverlapResponse>   m_OverlapResponses;
+        dmArray<uint32_t>                     m_OverlapCounts;
     };
 
+    static const dmhash_t RAYCAST_STREAM_HIT      = dmHashString64("hit");
+    static const dmhash_t RAYCAST_STREAM_FRACTION = dmHashString64("fraction");
+    static const dmhash_t RAYCAST_STREAM_POSITION = dmHashString64("position");
+    static const dmhash_t RAYCAST_STREAM_NORMAL   = dmHashString64("normal");
+
     /*# [type:number] collision object mass
      *
      * [mark:READ ONLY] Returns the defined physical mass of the collision object component as a number.
@@ -481,6 +563,442 @@ namespace dmGameSystem
         return 1;
     }
 
+    /*# performs a batch of ray casts
+     *
+     * Performs many ray casts synchronously in one call, which is much cheaper than calling
+     * [ref:physics.raycast] once per ray. Only the closest hit of each ray is returned.
+     * In 2D worlds the rays are spread over the job worker threads.
+     *
+     * The results are returned in a buffer with one element per ray, in the same order as the rays:
+     *
+     * `hit`
+     * : [type:uint8] 1 if the ray hit something, 0 otherwise. The other streams are only valid for hits.
+     *
+     * `fraction`
+     * : [type:float32] the fraction of the hit along the ray
+     *
+     * `position`
+     * : [type:float32] 3 components, the world position of the hit
+     *
+     * `normal`
+     * : [type:float32] 3 components, the normal of the surface that was hit
+     *
+     * @name physics.raycast_batch
+     * @param from [type:table] a list of vector3 start positions of the rays
+     * @param to [type:table] a list of vector3 end positions of the rays, the same length as `from`
+     * @param groups [type:table] a lua table containing the hashed groups for which to test collisions against
+     * @return result [type:buffer] the results, see above
+     * @return ids [type:table] the id of the instance hit by each ray, indexed by ray
+     * @examples
+     *
+     * ```lua
+     * local result, ids = physics.raycast_batch(eyes, targets, {hash("world")})
+     * local hits = buffer.get_stream(result, "hit")
+     * for i = 1, #eyes do
+     *     if hits[i] == 0 or ids[i] == targets_id[i] then
+     *         -- line of sight
+     *     end
+     * end
+     * ```
+     */
+    int Physics_RayCastBatch(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 2);
+
+        dmMessage::URL sender;
+        if (!dmScript::GetURL(L, &sender)) {
+            return luaL_error(L, "could not find a requesting instance for physics.raycast_batch");
+        }
+
+        dmScript::GetGlobal(L, PHYSICS_CONTEXT_HASH);
+        PhysicsScriptContext* context = (PhysicsScriptContext*)lua_touserdata(L, -1);
+        lua_pop(L, 1);
+
+        dmGameObject::HInstance sender_instance = CheckGoInstance(L);
+        dmGameObject::HCollection collection = dmGameObject::GetCollection(sender_instance);
+        void* world = dmGameObject::GetWorld(collection, context->m_ComponentIndex);
+
+        luaL_checktype(L, 1, LUA_TTABLE);
+        luaL_checktype(L, 2, LUA_TTABLE);
+        uint32_t count = (uint32_t)lua_objlen(L, 1);
+        if (count != (uint32_t)lua_objlen(L, 2))
+        {
+            return luaL_error(L, "physics.raycast_batch: the from and to lists must have the same length (%d and %d)", count, (int)lua_objlen(L, 2));
+        }
+
+        uint32_t mask = 0;
+        luaL_checktype(L, 3, LUA_TTABLE);
+        lua_pushnil(L);
+        while (lua_next(L, 3) != 0)
+        {
+            mask |= CompCollisionGetGroupBitIndex(world, dmScript::CheckHash(L, -1));
+            lua_pop(L, 1);
+        }
+
+        dmArray<dmPhysics::RayCastRequest>& requests = context->m_RayCastBatchRequests;
+        dmArray<dmPhysics::RayCastResponse>& responses = context->m_RayCastBatchResponses;
+        if (requests.Capacity() < count)
+        {
+            requests.SetCapacity(count);
+            responses.SetCapacity(count);
+        }
+        requests.SetSize(count);
+        responses.SetSize(count);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            dmPhysics::RayCastRequest& request = requests[i];
+            request = dmPhysics::RayCastRequest();
+            lua_rawgeti(L, 1, i + 1);
+            request.m_From = Vectormath::Aos::Point3(*dmScript::CheckVector3(L, -1));
+            lua_pop(L, 1);
+            lua_rawgeti(L, 2, i + 1);
+            request.m_To = Vectormath::Aos::Point3(*dmScript::CheckVector3(L, -1));
+            lua_pop(L, 1);
+            request.m_Mask = mask;
+        }
+
+        dmGameSystem::RayCastBatch(world, requests.Begin(), responses.Begin(), count, dmGameObject::GetJobContext(dmGameObject::GetRegister(collection)));
+
+        const dmBuffer::StreamDeclaration streams_decl[] = {
+            {RAYCAST_STREAM_HIT, dmBuffer::VALUE_TYPE_UINT8, 1},
+            {RAYCAST_STREAM_FRACTION, dmBuffer::VALUE_TYPE_FLOAT32, 1},
+            {RAYCAST_STREAM_POSITION, dmBuffer::VALUE_TYPE_FLOAT32, 3},
+            {RAYCAST_STREAM_NORMAL, dmBuffer::VALUE_TYPE_FLOAT32, 3},
+        };
+        dmBuffer::HBuffer buffer = 0;
+        dmBuffer::Result r = dmBuffer::Create(count, streams_decl, DM_ARRAY_SIZE(streams_decl), &buffer);
+        if (r != dmBuffer::RESULT_OK)
+        {
+            return luaL_error(L, "physics.raycast_batch: Failed creating buffer: %s", dmBuffer::GetResultString(r));
+        }
+
+        uint8_t* hit = 0;
+        float* fraction = 0;
+        float* position = 0;
+        float* normal = 0;
+        uint32_t hit_stride, fraction_stride, position_stride, normal_stride, components, stream_count;
+        dmBuffer::GetStream(buffer, RAYCAST_STREAM_HIT, (void**)&hit, &stream_count, &components, &hit_stride);
+        dmBuffer::GetStream(buffer, RAYCAST_STREAM_FRACTION, (void**)&fraction, &stream_count, &components, &fraction_stride);
+        dmBuffer::GetStream(buffer, RAYCAST_STREAM_POSITION, (void**)&position, &stream_count, &components, &position_stride);
+        dmBuffer::GetStream(buffer, RAYCAST_STREAM_NORMAL, (void**)&normal, &stream_count, &components, &normal_stride);
+
+        lua_newtable(L);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const dmPhysics::RayCastResponse& response = responses[i];
+            hit[i * hit_stride] = response.m_Hit;
+            if (!response.m_Hit)
+            {
+                fraction[i * fraction_stride] = 1.0f;
+                continue;
+            }
+            fraction[i * fraction_stride] = response.m_Fraction;
+            float* p = &position[i * position_stride];
+            p[0] = response.m_Position.getX(); p[1] = response.m_Position.getY(); p[2] = response.m_Position.getZ();
+            float* n = &normal[i * normal_stride];
+            n[0] = response.m_Normal.getX(); n[1] = response.m_Normal.getY(); n[2] = response.m_Normal.getZ();
+
+            dmScript::PushHash(L, dmGameSystem::CompCollisionObjectGetIdentifier(response.m_CollisionObjectUserData));
+            lua_rawseti(L, -2, i + 1);
+        }
+
+        dmScript::LuaHBuffer luabuf = { {buffer}, dmScript::OWNER_LUA };
+        dmScript::PushBuffer(L, luabuf);
+        lua_insert(L, -2);
+        return 2;
+    }
+
+    static uint16_t CheckGroups(lua_State* L, int index, void* world)
+    {
+        uint32_t mask = 0;
+        luaL_checktype(L, index, LUA_TTABLE);
+        lua_pushnil(L);
+        while (lua_next(L, index) != 0)
+        {
+            mask |= CompCollisionGetGroupBitIndex(world, dmScript::CheckHash(L, -1));
+            lua_pop(L, 1);
+        }
+        return (uint16_t)mask;
+    }
+
+    // Reads the query table at the top of the stack, the positions are read from the fields from_field and to_field
+    static void CheckShapeQuery(lua_State* L, const char* fn_name, const char* from_field, const char* to_field, dmPhysics::ShapeQueryRequest& request)
+    {
+        if (!lua_istable(L, -1))
+        {
+            luaL_error(L, "%s: the queries must be tables", fn_name);
+            return;
+        }
+
+        lua_getfield(L, -1, "type");
+        int type = luaL_checkinteger(L, -1);
+        lua_pop(L, 1);
+        if (type < dmPhysics::QUERY_SHAPE_TYPE_AABB || type > dmPhysics::QUERY_SHAPE_TYPE_BOX)
+        {
+            luaL_error(L, "%s: unknown query shape type %d", fn_name, type);
+            return;
+        }
+        request.m_ShapeType = type;
+
+        lua_getfield(L, -1, from_field);
+        request.m_From = Vectormath::Aos::Point3(*dmScript::CheckVector3(L, -1));
+        lua_pop(L, 1);
+        if (to_field)
+        {
+            lua_getfield(L, -1, to_field);
+            request.m_To = Vectormath::Aos::Point3(*dmScript::CheckVector3(L, -1));
+            lua_pop(L, 1);
+        }
+
+        if (type == dmPhysics::QUERY_SHAPE_TYPE_SPHERE)
+        {
+            lua_getfield(L, -1, "radius");
+            request.m_Extents = Vectormath::Aos::Vector3((float)luaL_checknumber(L, -1), 0.0f, 0.0f);
+            lua_pop(L, 1);
+            return;
+        }
+
+        lua_getfield(L, -1, "size");
+        request.m_Extents = *dmScript::CheckVector3(L, -1) * 0.5f;
+        lua_pop(L, 1);
+        if (type == dmPhysics::QUERY_SHAPE_TYPE_BOX)
+        {
+            lua_getfield(L, -1, "rotation");
+            if (!lua_isnil(L, -1))
+            {
+                request.m_Rotation = *dmScript::CheckQuat(L, -1);
+            }
+            lua_pop(L, 1);
+        }
+    }
+
+    /*# finds the collision objects overlapping a batch of shapes
+     *
+     * Tests a list of shapes against the collision objects in the physics world synchronously.
+     * Collision objects of types kinematic, dynamic and static are tested against, trigger objects
+     * are never found. Which collision objects to find is filtered by their collision groups and
+     * can be configured through `groups`.
+     *
+     * Each query is a table with the following fields:
+     *
+     * `type`
+     * : [type:number] the shape of the query, `physics.QUERY_SHAPE_TYPE_AABB`, `physics.QUERY_SHAPE_TYPE_SPHERE` or `physics.QUERY_SHAPE_TYPE_BOX`
+     *
+     * `position`
+     * : [type:vector3] the world position of the center of the shape
+     *
+     * `radius`
+     * : [type:number] the radius of spheres
+     *
+     * `size`
+     * : [type:vector3] the full size of boxes
+     *
+     * `rotation`
+     * : [type:quaternion] the rotation of `physics.QUERY_SHAPE_TYPE_BOX` shapes, optional
+     *
+     * @name physics.overlap
+     * @param queries [type:table] a list of query tables, see above
+     * @param groups [type:table] a lua table containing the hashed groups for which to test collisions against
+     * @return result [type:table] a list per query, in the same order as the queries, of tables with the `id` and `group` of each overlapping instance
+     * @examples
+     *
+     * ```lua
+     * local result = physics.overlap({{type = physics.QUERY_SHAPE_TYPE_SPHERE, position = go.get_position(), radius = 100}}, {hash("enemy")})
+     * for _, hit in ipairs(result[1]) do
+     *     msg.post(hit.id, "explosion")
+     * end
+     * ```
+     */
+    int Physics_Overlap(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 1);
+
+        dmMessage::URL sender;
+        if (!dmScript::GetURL(L, &sender)) {
+            return luaL_error(L, "could not find a requesting instance for physics.overlap");
+        }
+
+        dmScript::GetGlobal(L, PHYSICS_CONTEXT_HASH);
+        PhysicsScriptContext* context = (PhysicsScriptContext*)lua_touserdata(L, -1);
+        lua_pop(L, 1);
+
+        dmGameObject::HInstance sender_instance = CheckGoInstance(L);
+        dmGameObject::HCollection collection = dmGameObject::GetCollection(sender_instance);
+        void* world = dmGameObject::GetWorld(collection, context->m_ComponentIndex);
+
+        luaL_checktype(L, 1, LUA_TTABLE);
+        uint32_t count = (uint32_t)lua_objlen(L, 1);
+        uint16_t mask = CheckGroups(L, 2, world);
+
+        dmArray<dmPhysics::ShapeQueryRequest>& requests = context->m_ShapeQueryRequests;
+        dmArray<uint32_t>& counts = context->m_OverlapCounts;
+        if (requests.Capacity() < count)
+            requests.SetCapacity(count);
+        if (counts.Capacity() < count)
+            counts.SetCapacity(count);
+        requests.SetSize(count);
+        counts.SetSize(count);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            dmPhysics::ShapeQueryRequest& request = requests[i];
+            request = dmPhysics::ShapeQueryRequest();
+            lua_rawgeti(L, 1, i + 1);
+            CheckShapeQuery(L, "physics.overlap", "position", 0x0, request);
+            lua_pop(L, 1);
+            request.m_Mask = mask;
+        }
+
+        dmArray<dmPhysics::OverlapResponse>& results = context->m_OverlapResponses;
+        results.SetSize(0);
+        dmGameSystem::OverlapBatch(world, requests.Begin(), count, results, counts.Begin());
+
+        lua_createtable(L, count, 0);
+        uint32_t result_index = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            lua_createtable(L, counts[i], 0);
+            for (uint32_t j = 0; j < counts[i]; ++j, ++result_index)
+            {
+                const dmPhysics::OverlapResponse& result = results[result_index];
+                lua_createtable(L, 0, 2);
+                dmScript::PushHash(L, dmGameSystem::CompCollisionObjectGetIdentifier(result.m_CollisionObjectUserData));
+                lua_setfield(L, -2, "id");
+                dmScript::PushHash(L, dmGameSystem::GetLSBGroupHash(world, result.m_CollisionObjectGroup));
+                lua_setfield(L, -2, "group");
+                lua_rawseti(L, -2, j + 1);
+            }
+            lua_rawseti(L, -2, i + 1);
+        }
+        return 1;
+    }
+
+    /*# performs a batch of shape casts
+     *
+     * Sweeps a list of shapes through the physics world synchronously, only the first hit of each shape is
+     * returned. Collision objects of types kinematic, dynamic and static are tested against, trigger objects
+     * are never hit. Objects the shape overlaps at the start of the cast are not hit.
+     *
+     * The queries are tables with the same fields as the queries of [ref:physics.overlap], except that
+     * `position` is replaced by:
+     *
+     * `from`
+     * : [type:vector3] the world position of the center of the shape at the start of the cast
+     *
+     * `to`
+     * : [type:vector3] the world position of the center of the shape at the end of the cast
+     *
+     * The results are returned in a buffer with the same streams as the result of [ref:physics.raycast_batch],
+     * where `fraction` is how far along the cast the shape touches the object and `position` is the point of contact.
+     *
+     * @name physics.shape_cast
+     * @param queries [type:table] a list of query tables, see above
+     * @param groups [type:table] a lua table containing the hashed groups for which to test collisions against
+     * @return result [type:buffer] the results, one element per query
+     * @return ids [type:table] the id of the instance hit by each shape, indexed by query
+     * @examples
+     *
+     * ```lua
+     * local query = {type = physics.QUERY_SHAPE_TYPE_SPHERE, from = pos, to = pos + vmath.vector3(0, -100, 0), radius = 16}
+     * local result, ids = physics.shape_cast({query}, {hash("ground")})
+     * if buffer.get_stream(result, "hit")[1] == 1 then
+     *     local fraction = buffer.get_stream(result, "fraction")[1]
+     *     pos = vmath.lerp(fraction, query.from, query.to)
+     * end
+     * ```
+     */
+    int Physics_ShapeCast(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 2);
+
+        dmMessage::URL sender;
+        if (!dmScript::GetURL(L, &sender)) {
+            return luaL_error(L, "could not find a requesting instance for physics.shape_cast");
+        }
+
+        dmScript::GetGlobal(L, PHYSICS_CONTEXT_HASH);
+        PhysicsScriptContext* context = (PhysicsScriptContext*)lua_touserdata(L, -1);
+        lua_pop(L, 1);
+
+        dmGameObject::HInstance sender_instance = CheckGoInstance(L);
+        dmGameObject::HCollection collection = dmGameObject::GetCollection(sender_instance);
+        void* world = dmGameObject::GetWorld(collection, context->m_ComponentIndex);
+
+        luaL_checktype(L, 1, LUA_TTABLE);
+        uint32_t count = (uint32_t)lua_objlen(L, 1);
+        uint16_t mask = CheckGroups(L, 2, world);
+
+        dmArray<dmPhysics::ShapeQueryRequest>& requests = context->m_ShapeQueryRequests;
+        dmArray<dmPhysics::RayCastResponse>& responses = context->m_RayCastBatchResponses;
+        if (requests.Capacity() < count)
+            requests.SetCapacity(count);
+        if (responses.Capacity() < count)
+            responses.SetCapacity(count);
+        requests.SetSize(count);
+        responses.SetSize(count);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            dmPhysics::ShapeQueryRequest& request = requests[i];
+            request = dmPhysics::ShapeQueryRequest();
+            lua_rawgeti(L, 1, i + 1);
+            CheckShapeQuery(L, "physics.shape_cast", "from", "to", request);
+            lua_pop(L, 1);
+            request.m_Mask = mask;
+        }
+
+        dmGameSystem::ShapeCastBatch(world, requests.Begin(), responses.Begin(), count);
+
+        const dmBuffer::StreamDeclaration streams_decl[] = {
+            {RAYCAST_STREAM_HIT, dmBuffer::VALUE_TYPE_UINT8, 1},
+            {RAYCAST_STREAM_FRACTION, dmBuffer::VALUE_TYPE_FLOAT32, 1},
+            {RAYCAST_STREAM_POSITION, dmBuffer::VALUE_TYPE_FLOAT32, 3},
+            {RAYCAST_STREAM_NORMAL, dmBuffer::VALUE_TYPE_FLOAT32, 3},
+        };
+        dmBuffer::HBuffer buffer = 0;
+        dmBuffer::Result r = dmBuffer::Create(count, streams_decl, DM_ARRAY_SIZE(streams_decl), &buffer);
+        if (r != dmBuffer::RESULT_OK)
+        {
+            return luaL_error(L, "physics.shape_cast: Failed creating buffer: %s", dmBuffer::GetResultString(r));
+        }
+
+        uint8_t* hit = 0;
+        float* fraction = 0;
+        float* position = 0;
+        float* normal = 0;
+        uint32_t hit_stride, fraction_stride, position_stride, normal_stride, components, stream_count;
+        dmBuffer::GetStream(buffer, RAYCAST_STREAM_HIT, (void**)&hit, &stream_count, &components, &hit_stride);
+        dmBuffer::GetStream(buffer, RAYCAST_STREAM_FRACTION, (void**)&fraction, &stream_count, &components, &fraction_stride);
+        dmBuffer::GetStream(buffer, RAYCAST_STREAM_POSITION, (void**)&position, &stream_count, &components, &position_stride);
+        dmBuffer::GetStream(buffer, RAYCAST_STREAM_NORMAL, (void**)&normal, &stream_count, &components, &normal_stride);
+
+        lua_newtable(L);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const dmPhysics::RayCastResponse& response = responses[i];
+            hit[i * hit_stride] = response.m_Hit;
+            if (!response.m_Hit)
+            {
+                fraction[i * fraction_stride] = 1.0f;
+                continue;
+            }
+            fraction[i * fraction_stride] = response.m_Fraction;
+            float* p = &position[i * position_stride];
+            p[0] = response.m_Position.getX(); p[1] = response.m_Position.getY(); p[2] = response.m_Position.getZ();
+            float* n = &normal[i * normal_stride];
+            n[0] = response.m_Normal.getX(); n[1] = response.m_Normal.getY(); n[2] = response.m_Normal.getZ();
+
+            dmScript::PushHash(L, dmGameSystem::CompCollisionObjectGetIdentifier(response.m_CollisionObjectUserData));
+            lua_rawseti(L, -2, i + 1);
+        }
+
+        dmScript::LuaHBuffer luabuf = { {buffer}, dmScript::OWNER_LUA };
+        dmScript::PushBuffer(L, luabuf);
+        lua_insert(L, -2);
+        return 2;
+    }
+
     // Matches JointResult in physics.h
     static const char* PhysicsResultString[] = {
         "result ok",
@@ -1116,11 +1634,79 @@ namespace dmGameSystem
         return 0;
     }
 
+    /*# set the contact events of a collision object
+     *
+     * Selects which contact messages the collision object receives. Contacts are filtered in the
+     * physics engine, before any message is created, so unsubscribing from events that are never
+     * handled saves time in worlds with many contacts.
+     *
+     * A contact is reported if either of the two collision objects subscribes to the message,
+     * but it is only sent to the objects that do. The first contact and aggregate modes apply
+     * to a contact if either of the two objects uses them.
+     *
+     * @name physics.set_contact_events
+     * @param url [type:string|hash|url] the collision object
+     * @param events [type:number] a combination of `physics.CONTACT_EVENTS_COLLISION`,
+     * `physics.CONTACT_EVENTS_CONTACT_POINT`, `physics.CONTACT_EVENTS_FIRST_CONTACT` and
+     * `physics.CONTACT_EVENTS_AGGREGATE`, added together. Use 0 to not receive any contact messages.
+     * @examples
+     *
+     * Only receive one collision_response when a bullet hits something:
+     *
+     * ```lua
+     * function init(self)
+     *     physics.set_contact_events("#collisionobject", physics.CONTACT_EVENTS_COLLISION + physics.CONTACT_EVENTS_FIRST_CONTACT)
+     * end
+     * ```
+     */
+    static int Physics_SetContactEvents(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+
+        dmGameObject::HCollection collection = dmGameObject::GetCollection(CheckGoInstance(L));
+        void* comp = 0x0;
+        void* comp_world = 0x0;
+        GetCollisionObject(L, 1, collection, &comp, &comp_world);
+
+        int events = luaL_checkinteger(L, 2);
+        const int all_events = dmPhysics::CONTACT_EVENTS_COLLISION | dmPhysics::CONTACT_EVENTS_CONTACT_POINT |
+                               dmPhysics::CONTACT_EVENTS_FIRST_CONTACT | dmPhysics::CONTACT_EVENTS_AGGREGATE;
+        if (events < 0 || (events & ~all_events) != 0)
+        {
+            return DM_LUA_ERROR("invalid contact events %d", events);
+        }
+
+        dmGameSystem::SetContactEvents(comp_world, comp, (uint16_t) events);
+        return 0;
+    }
+
+    /*# get the contact events of a collision object
+     *
+     * @name physics.get_contact_events
+     * @param url [type:string|hash|url] the collision object
+     * @return events [type:number] the contact events, see `physics.set_contact_events`
+     */
+    static int Physics_GetContactEvents(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 1);
+
+        dmGameObject::HCollection collection = dmGameObject::GetCollection(CheckGoInstance(L));
+        void* comp = 0x0;
+        void* comp_world = 0x0;
+        GetCollisionObject(L, 1, collection, &comp, &comp_world);
+
+        lua_pushinteger(L, dmGameSystem::GetContactEvents(comp));
+        return 1;
+    }
+
     static const luaL_reg PHYSICS_FUNCTIONS[] =
     {
         {"ray_cast",        Physics_RayCastAsync}, // Deprecated
         {"raycast_async",   Physics_RayCastAsync},
         {"raycast",         Physics_RayCast},
+        {"raycast_batch",   Physics_RayCastBatch},
+        {"overlap",         Physics_Overlap},
+        {"shape_cast",      Physics_ShapeCast},
 
         {"create_joint",    Physics_CreateJoint},
         {"destroy_joint",   Physics_DestroyJoint},
@@ -1135,6 +1721,9 @@ namespace dmGameSystem
         {"set_hflip",       Physics_SetFlipH},
         {"set_vflip",       Physics_SetFlipV},
         {"wakeup",          Physics_Wakeup},
+
+        {"set_contact_events", Physics_SetContactEvents},
+        {"get_contact_events", Physics_GetContactEvents},
         {0, 0}
     };
 
@@ -1153,6 +1742,16 @@ namespace dmGameSystem
         SETCONSTANT(JOINT_TYPE_SLIDER)
         SETCONSTANT(JOINT_TYPE_WELD)
 
+        SETCONSTANT(CONTACT_EVENTS_COLLISION)
+        SETCONSTANT(CONTACT_EVENTS_CONTACT_POINT)
+        SETCONSTANT(CONTACT_EVENTS_FIRST_CONTACT)
+        SETCONSTANT(CONTACT_EVENTS_AGGREGATE)
+        SETCONSTANT(CONTACT_EVENTS_DEFAULT)
+
+        SETCONSTANT(QUERY_SHAPE_TYPE_AABB)
+        SETCONSTANT(QUERY_SHAPE_TYPE_SPHERE)
+        SETCONSTANT(QUERY_SHAPE_TYPE_BOX)
+
  #undef SETCONSTANT
 
         lua_pop(L, 1);
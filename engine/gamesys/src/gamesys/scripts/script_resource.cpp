@@ -13,6 +13,7 @@
 #include "script_resource.h"
 #include <dlib/buffer.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
 #include <dlib/dstrings.h>
 #include <resource/resource.h>
 #include <graphics/graphics_ddf.h>
@@ -21,6 +22,7 @@
 #include "../gamesys.h"
 #include "script_resource_liveupdate.h"
 #include "../resources/res_buffer.h"
+#include "../resources/res_texture.h"
 
 #include <dmsdk/script/script.h>
 #include <dmsdk/gamesys/script.h>
@@ -315,6 +317,29 @@ static int CheckTableNumber(lua_State* L, int index, const char* name)
     return result;
 }
 
+// Returns -1 if the table attribute isn't set
+static int GetTableNumber(lua_State* L, int index, const char* name)
+{
+    int result = -1;
+    lua_pushstring(L, name);
+    lua_gettable(L, index);
+    if (!lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        return CheckTableNumber(L, index, name);
+    }
+    lua_pop(L, 1);
+    return result;
+}
+
+static bool GetTableBoolean(lua_State* L, int index, const char* name)
+{
+    lua_pushstring(L, name);
+    lua_gettable(L, index);
+    bool result = lua_toboolean(L, -1) != 0;
+    lua_pop(L, 1);
+    return result;
+}
+
 static int GraphicsTextureFormatToImageFormat(int textureformat)
 {
     switch(textureformat)
@@ -373,9 +398,22 @@ static int GraphicsTextureTypeToImageType(int texturetype)
  * - `resource.TEXTURE_FORMAT_RGB`
  * - `resource.TEXTURE_FORMAT_RGBA`
  *
+ * `x`
+ * : [type:number] optional x offset of the pixel data in the texture. When `x` or `y` is set, the buffer only
+ *   holds a `width` x `height` region, which is written in place into the current texture
+ *
+ * `y`
+ * : [type:number] optional y offset of the pixel data in the texture
+ *
+ * `generate_mipmaps`
+ * : [type:boolean] optional, regenerate the mipmaps of the texture on the GPU after the update, where supported
+ *
  * @param buffer [type:buffer] The buffer of precreated pixel data
  *
- * [icon:attention] Currently, only 1 mipmap is generated.
+ * [icon:attention] Unless `generate_mipmaps` is set, only 1 mipmap is generated.
+ *
+ * [icon:attention] Updates with `x`, `y` or `generate_mipmaps` keep the texture object and skip the copy into a
+ * texture resource, which makes them suitable for textures that are updated every few frames, e.g. a minimap.
  *
  * @examples
  * How to set all pixels of an atlas
@@ -401,6 +439,16 @@ static int GraphicsTextureTypeToImageType(int texturetype)
  *   resource.set_texture( resource_path, header, self.buffer )
  * end
  * ```
+ *
+ * How to update a region of a texture and regenerate its mipmaps
+ *
+ * ```lua
+ * function update(self, dt)
+ *   local header = { x=self.dirty_x, y=self.dirty_y, width=self.dirty_width, height=self.dirty_height,
+ *                    type=resource.TEXTURE_TYPE_2D, format=resource.TEXTURE_FORMAT_RGBA, generate_mipmaps=true }
+ *   resource.set_texture(self.resource_path, header, self.dirty_buffer)
+ * end
+ * ```
  */
 static int SetTexture(lua_State* L)
 {
@@ -414,6 +462,10 @@ static int SetTexture(lua_State* L)
     uint32_t height = (uint32_t)CheckTableNumber(L, 2, "height");
     uint32_t format = (uint32_t)CheckTableNumber(L, 2, "format");
 
+    int x = GetTableNumber(L, 2, "x");
+    int y = GetTableNumber(L, 2, "y");
+    bool generate_mipmaps = GetTableBoolean(L, 2, "generate_mipmaps");
+
     uint32_t num_mip_maps = 1;
 
     dmScript::LuaHBuffer* buffer = dmScript::CheckBuffer(L, 3);
@@ -422,6 +474,38 @@ static int SetTexture(lua_State* L)
     uint32_t datasize = 0;
     dmBuffer::GetBytes(buffer->m_Buffer, (void**)&data, &datasize);
 
+    bool region = x >= 0 || y >= 0;
+    if ((region || generate_mipmaps) && type == dmGraphics::TEXTURE_TYPE_2D)
+    {
+        uint32_t bytes_per_pixel = format == dmGraphics::TEXTURE_FORMAT_LUMINANCE ? 1 : format == dmGraphics::TEXTURE_FORMAT_RGB ? 3 : format == dmGraphics::TEXTURE_FORMAT_RGBA ? 4 : 0;
+        if (bytes_per_pixel == 0 || datasize < width * height * bytes_per_pixel)
+        {
+            return luaL_error(L, "Texture region updates need %ux%u pixels of an uncompressed format", width, height);
+        }
+
+        dmGraphics::TextureParams params;
+        params.m_Format = (dmGraphics::TextureFormat) format;
+        params.m_X = dmMath::Max(x, 0);
+        params.m_Y = dmMath::Max(y, 0);
+        params.m_Width = width;
+        params.m_Height = height;
+        params.m_Data = data;
+        params.m_DataSize = datasize;
+
+        dmResource::Result r = dmGameSystem::SetTextureRegion(g_ResourceModule.m_Factory, path_hash, params, generate_mipmaps);
+        // A full update of a texture of another size falls back to recreating it
+        if (r == dmResource::RESULT_OK || region)
+        {
+            if( r != dmResource::RESULT_OK )
+            {
+                assert(top == lua_gettop(L));
+                return ReportPathError(L, r, path_hash);
+            }
+            assert(top == lua_gettop(L));
+            return 0;
+        }
+    }
+
     dmGraphics::TextureImage* texture_image = new dmGraphics::TextureImage;
     texture_image->m_Alternatives.m_Data = new dmGraphics::TextureImage::Image[1];
     texture_image->m_Alternatives.m_Count = 1;
@@ -696,10 +780,74 @@ static int SetBuffer(lua_State* L)
     return 0;
 }
 
+/*# prefetch resources
+ * Starts loading resources in the background ahead of their use, e.g. the collection of the
+ * next level. Prefetched resources that aren't claimed by a spawned object are released again
+ * when the resource cache needs the memory.
+ *
+ * Prefetching requires the `resource.cold_cache_size` setting in "game.project" to be
+ * larger than zero.
+ *
+ * @name resource.prefetch
+ *
+ * @param paths [type:string|table] The path to the resource, or a table of paths
+ * @return success [type:boolean] Returns true if the prefetch was started
+ *
+ * @examples
+ *
+ * ```lua
+ * -- warm up the next level while the current one is played
+ * resource.prefetch("/levels/level2.collectionc")
+ * ```
+ */
+static int Prefetch(lua_State* L)
+{
+    int top = lua_gettop(L);
+
+    dmArray<const char*> names;
+    if (lua_istable(L, 1))
+    {
+        names.SetCapacity(lua_objlen(L, 1));
+        lua_pushnil(L);
+        while (lua_next(L, 1) != 0)
+        {
+            // A number key would be converted in place by luaL_checkstring and break lua_next
+            luaL_checktype(L, -1, LUA_TSTRING);
+            const char* name = lua_tostring(L, -1);
+            if (names.Full())
+            {
+                names.OffsetCapacity(8);
+            }
+            names.Push(name);
+            lua_pop(L, 1);
+        }
+    }
+    else
+    {
+        names.SetCapacity(1);
+        names.Push(luaL_checkstring(L, 1));
+    }
+
+    dmResource::Result r = dmResource::RESULT_INVAL;
+    if (!names.Empty())
+    {
+        r = dmResource::Prefetch(g_ResourceModule.m_Factory, names);
+    }
+    if (r != dmResource::RESULT_OK)
+    {
+        dmLogWarning("Unable to prefetch resources: %s (%d)", dmResource::ResultToString(r), r);
+    }
+
+    lua_pushboolean(L, r == dmResource::RESULT_OK);
+    assert(top + 1 == lua_gettop(L));
+    return 1;
+}
+
 static const luaL_reg Module_methods[] =
 {
     {"set", Set},
     {"load", Load},
+    {"prefetch", Prefetch},
     {"set_texture", SetTexture},
     {"set_sound", SetSound},
     {"get_buffer", GetBuffer},
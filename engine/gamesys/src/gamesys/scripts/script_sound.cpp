@@ -12,6 +12,7 @@
 
 #include <float.h>
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
 #include <dlib/hash.h>
@@ -99,6 +100,26 @@ namespace dmGameSystem
      * ```
      */
 
+    /*# [type:number] sound priority
+     *
+     * The voice priority of the sound-component, between 0 and 255. Only a limited number
+     * of voices are mixed, set with `sound.max_real_voices` in game.project. When more
+     * sounds than that are playing, the voices with the highest priority are mixed first,
+     * and then the loudest ones. The other voices keep playing silently. The default is 0.
+     *
+     * @name priority
+     * @property
+     *
+     * @examples
+     *
+     * ```lua
+     * function init(self)
+     *   -- make sure the dialogue is always heard over the explosions
+     *   go.set("#dialogue", "priority", 200)
+     * end
+     * ```
+     */
+
     /*# [type:hash] sound data
      *
      * The sound data used when playing the sound. The type of the property is hash.
@@ -254,6 +275,56 @@ namespace dmGameSystem
         return 2;
     }
 
+    /*# get frequency spectrum from mixer group
+     * Get the peak magnitude of logarithmically spaced frequency bands from a mixer group,
+     * from the lowest frequencies up to half the mix rate.
+     *
+     * [icon:attention] The spectrum is only analyzed while it is being requested, so the first call for a group
+     * returns silence. Request it every frame while it is displayed.
+     *
+     * @param group [type:string|hash] group name
+     * @param [bands] [type:number] number of bands, between 1 and 255. Default is 16
+     * @name sound.get_spectrum
+     * @return spectrum [type:table] band magnitudes in linear scale, from the lowest to the highest frequency
+     * @examples
+     *
+     * Draw a simple spectrum of the "music" group:
+     *
+     * ```lua
+     * function update(self, dt)
+     *     local spectrum = sound.get_spectrum("music", 16)
+     *     for i, magnitude in ipairs(spectrum) do
+     *         local height = 200 * magnitude
+     *         msg.post("@render:", "draw_line", { start_point = vmath.vector3(20 * i, 0, 0), end_point = vmath.vector3(20 * i, height, 0), color = vmath.vector4(1, 1, 1, 1) } )
+     *     end
+     * end
+     * ```
+     */
+    static int Sound_GetSpectrum(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 1);
+
+        dmhash_t group_hash = CheckGroupName(L, 1);
+        int band_count = luaL_optinteger(L, 2, 16);
+        if (band_count < 1 || band_count > 255) {
+            return DM_LUA_ERROR("Number of bands must be between 1 and 255, got %d", band_count);
+        }
+
+        float bands[255];
+        dmSound::Result r = dmSound::GetGroupSpectrum(group_hash, bands, (uint32_t) band_count);
+        if (r != dmSound::RESULT_OK) {
+            dmLogWarning("Failed to get spectrum (%d)", r);
+            memset(bands, 0, sizeof(bands));
+        }
+
+        lua_createtable(L, band_count, 0);
+        for (int i = 0; i < band_count; i++) {
+            lua_pushnumber(L, bands[i]);
+            lua_rawseti(L, -2, i + 1);
+        }
+        return 1;
+    }
+
     /*# set mixer group gain
      * Set mixer group gain
      *
@@ -706,6 +777,7 @@ namespace dmGameSystem
         {"is_music_playing", Sound_IsMusicPlaying},
         {"get_rms", Sound_GetRMS},
         {"get_peak", Sound_GetPeak},
+        {"get_spectrum", Sound_GetSpectrum},
         {"set_group_gain", Sound_SetGroupGain},
         {"get_group_gain", Sound_GetGroupGain},
         {"get_groups", Sound_GetGroups},
@@ -18,12 +18,14 @@
 #include <dlib/log.h>
 #include <dlib/math.h>
 #include <script/script.h>
+#include <dmsdk/gameobject/script.h>
 
 #include "gamesys.h"
 #include <gamesys/gamesys_ddf.h>
 #include "../gamesys_private.h"
 
 #include "script_sprite.h"
+#include <dmsdk/gamesys/sprite.h>
 
 extern "C"
 {
@@ -179,6 +181,27 @@ namespace dmGameSystem
     * ```
     */
 
+    /*# [type:number] sprite layer
+    *
+    * The render layer of the sprite, a number between 0 and 31. The layer is tested against the
+    * layer mask of the camera with focus, or the mask set with [ref:render.set_layer_mask], before the
+    * sprite is drawn. Layer 0 is the default. The type of the property is number.
+    *
+    * @name layer
+    * @property
+    *
+    * @examples
+    *
+    * How to hide component "sprite" from the camera by moving it to a layer the camera doesn't draw:
+    *
+    * ```lua
+    * function init(self)
+    *   go.set("#sprite", "layer", 1)
+    *   go.set("camera#camera", "layer_mask", 1) -- only layer 0
+    * end
+    * ```
+    */
+
     /*# set horizontal flipping on a sprite's animations
      * Sets horizontal flipping of the provided sprite's animations.
      * The sprite is identified by its URL.
@@ -474,6 +497,47 @@ namespace dmGameSystem
         return 0;
     }
 
+    /*# flag a sprite as static
+     * Flags the sprite as static, or makes it dynamic again. The vertices of static sprites are baked once into buffers
+     * that are shared by all static sprites with the same material, image, blend mode, render layer and z, and the sprites
+     * are no longer animated or updated each frame.
+     *
+     * Changing a property, the transform or sending a message to a static sprite makes it dynamic again.
+     * Sprites that play an animation or have a render constant (e.g. tint) set are drawn dynamically even if they are flagged as static.
+     *
+     * @name sprite.set_static
+     * @param url [type:string|hash|url] the sprite that should be static
+     * @param static [type:boolean] `true` to flag the sprite as static, `false` to make it dynamic
+     * @examples
+     *
+     * Bake the background sprites of a level:
+     *
+     * ```lua
+     * function init(self)
+     *   for _, id in ipairs(self.background) do
+     *     sprite.set_static(msg.url(nil, id, "sprite"), true)
+     *   end
+     * end
+     * ```
+     */
+    static int SpriteComp_SetStatic(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+
+        CheckGoInstance(L);
+        luaL_checktype(L, 2, LUA_TBOOLEAN);
+
+        void* world = 0;
+        uintptr_t user_data = 0;
+        dmGameObject::GetComponentFromLua(L, 1, "spritec", &world, (void**)&user_data, 0);
+
+        SpriteHandle handle;
+        handle.m_World = world;
+        handle.m_Index = (uint32_t) user_data;
+        SetSpritesStatic(&handle, 1, lua_toboolean(L, 2));
+        return 0;
+    }
+
     static const luaL_reg SPRITE_COMP_FUNCTIONS[] =
     {
             {"set_hflip",       SpriteComp_SetHFlip},
@@ -482,6 +546,7 @@ namespace dmGameSystem
             {"reset_constant",  SpriteComp_ResetConstant},
             {"set_scale",       SpriteComp_SetScale},
             {"play_flipbook",   SpriteComp_PlayFlipBook},
+            {"set_static",      SpriteComp_SetStatic},
             {0, 0}
     };
 
@@ -62,6 +62,28 @@ namespace dmGameSystem
      * ```
      */
 
+    /*# [type:number] tile map layer
+     *
+     * The render layer of the tile map, a number between 0 and 31. The layer is tested against the
+     * layer mask of the camera with focus, or the mask set with [ref:render.set_layer_mask], before the
+     * tile map is drawn. Layer 0 is the default. The render layer is not related to the tile layers
+     * of the tile map. The type of the property is number.
+     *
+     * @name layer
+     * @property
+     *
+     * @examples
+     *
+     * How to hide component "tilemap" from the camera by moving it to a layer the camera doesn't draw:
+     *
+     * ```lua
+     * function init(self)
+     *   go.set("#tilemap", "layer", 1)
+     *   go.set("camera#camera", "layer_mask", 1) -- only layer 0
+     * end
+     * ```
+     */
+
     /*# [type:hash] tile map material
      *
      * The material used when rendering the tile map. The type of the property is hash.
@@ -31,6 +31,7 @@
 #include "../components/comp_label.h"
 
 #include <dmsdk/gamesys/render_constants.h>
+#include <dmsdk/gamesys/sprite.h>
 
 namespace dmGameSystem
 {
@@ -305,9 +306,9 @@ TEST_P(InvalidVertexSpaceTest, InvalidVertexSpace)
     void* resource;
     ASSERT_NE(dmResource::RESULT_OK, dmResource::Get(m_Factory, resource_name, &resource));
 }
-
-
-
+
+
+
 
 // Test for input consuming in collection proxy
 TEST_F(ComponentTest, ConsumeInputInCollectionProxy)
@@ -857,6 +858,65 @@ TEST_P(CursorTest, Cursor)
     ASSERT_TRUE(dmGameObject::Final(m_Collection));
 }
 
+TEST_F(SpriteAnimTest, NativeSetters)
+{
+    dmhash_t sprite_comp_id = dmHashString64("sprite");
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/sprite/cursor.goc", dmHashString64("/go"), 0, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0x0, go);
+
+    dmGameSystem::SpriteHandle handle;
+    ASSERT_FALSE(dmGameSystem::GetSpriteHandle(go, dmHashString64("does_not_exist"), &handle));
+    ASSERT_TRUE(dmGameSystem::GetSpriteHandle(go, sprite_comp_id, &handle));
+
+    Vector3 scale(2.0f, 3.0f, 1.0f);
+    dmGameSystem::SetSpriteScales(&handle, &scale, 1);
+
+    dmGameObject::PropertyDesc desc;
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::GetProperty(go, sprite_comp_id, dmHashString64("scale"), desc));
+    ASSERT_EQ(dmGameObject::PROPERTY_TYPE_VECTOR3, desc.m_Variant.m_Type);
+    ASSERT_EQ(2.0f, desc.m_Variant.m_V4[0]);
+    ASSERT_EQ(3.0f, desc.m_Variant.m_V4[1]);
+
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
+TEST_F(SpriteAnimTest, StaticSprites)
+{
+    dmhash_t sprite_comp_id = dmHashString64("sprite");
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/sprite/cursor.goc", dmHashString64("/go"), 0, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0x0, go);
+
+    dmGameSystem::SpriteHandle handle;
+    ASSERT_TRUE(dmGameSystem::GetSpriteHandle(go, sprite_comp_id, &handle));
+    dmGameSystem::SetSpritesStatic(&handle, 1, true);
+
+    // The sprite is drawn once per frame, whether it's baked into a static batch or made dynamic again by the scale change
+    for (uint32_t frame = 0; frame < 3; ++frame)
+    {
+        if (frame == 2)
+        {
+            Vector3 scale(2.0f, 2.0f, 1.0f);
+            dmGameSystem::SetSpriteScales(&handle, &scale, 1);
+        }
+
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+        dmRender::RenderListBegin(m_RenderContext);
+        dmGameObject::Render(m_Collection);
+        dmRender::RenderListEnd(m_RenderContext);
+        dmRender::DrawRenderList(m_RenderContext, 0x0, 0x0);
+
+        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+
+        ASSERT_EQ(1u, dmGraphics::GetDrawCount());
+        dmGraphics::Flip(m_GraphicsContext);
+    }
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
 TEST_F(WindowEventTest, Test)
 {
     dmGameSystem::ScriptLibContext scriptlibcontext;
@@ -1437,23 +1497,23 @@ TEST_F(GamepadConnectedTest, TestGamepadConnectedInputEvent)
 
     dmGameSystem::FinalizeScriptLibs(scriptlibcontext);
 }
-
-TEST_F(CollisionObject2DTest, WakingCollisionObjectTest)
-{
-    dmHashEnableReverseHash(true);
-    lua_State* L = dmScript::GetLuaState(m_ScriptContext);
-
-    dmGameSystem::ScriptLibContext scriptlibcontext;
-    scriptlibcontext.m_Factory = m_Factory;
-    scriptlibcontext.m_Register = m_Register;
-    scriptlibcontext.m_LuaState = L;
+
+TEST_F(CollisionObject2DTest, WakingCollisionObjectTest)
+{
+    dmHashEnableReverseHash(true);
+    lua_State* L = dmScript::GetLuaState(m_ScriptContext);
+
+    dmGameSystem::ScriptLibContext scriptlibcontext;
+    scriptlibcontext.m_Factory = m_Factory;
+    scriptlibcontext.m_Register = m_Register;
+    scriptlibcontext.m_LuaState = L;
     dmGameSystem::InitializeScriptLibs(scriptlibcontext);
 
     // a 'base' gameobject works as the base for other dynamic objects to stand on
     const char* path_sleepy_go = "/collision_object/sleepy_base.goc";
     dmhash_t hash_base_go = dmHashString64("/base-go");
-    // place the base object so that the upper level of base is at Y = 0
-    dmGameObject::HInstance base_go = Spawn(m_Factory, m_Collection, path_sleepy_go, hash_base_go, 0, 0, Point3(50, -10, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    // place the base object so that the upper level of base is at Y = 0
+    dmGameObject::HInstance base_go = Spawn(m_Factory, m_Collection, path_sleepy_go, hash_base_go, 0, 0, Point3(50, -10, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
     ASSERT_NE((void*)0, base_go);
 
     // two dynamic 'body' objects will get spawned and placed apart
@@ -1468,23 +1528,23 @@ TEST_F(CollisionObject2DTest, WakingCollisionObjectTest)
     ASSERT_NE((void*)0, body2_go);
 
 
-    // iterate until the lua env signals the end of the test of error occurs
-    bool tests_done = false;
-    while (!tests_done)
-    {
-        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
-        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    // iterate until the lua env signals the end of the test of error occurs
+    bool tests_done = false;
+    while (!tests_done)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
 
         ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
-        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
-        // check if tests are done
-        lua_getglobal(L, "tests_done");
-        tests_done = lua_toboolean(L, -1);
-        lua_pop(L, 1);
-    }
-
-    ASSERT_TRUE(dmGameObject::Final(m_Collection));
-}
+        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+        // check if tests are done
+        lua_getglobal(L, "tests_done");
+        tests_done = lua_toboolean(L, -1);
+        lua_pop(L, 1);
+    }
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
 
 // Test case for collision-object properties
 TEST_F(CollisionObject2DTest, PropertiesTest)
@@ -2065,7 +2125,6 @@ const char* invalid_vertexspace_resources[] =
     "/sprite/invalid_vertexspace.spritec",
     "/model/invalid_vertexspace.modelc",
     "/spine/invalid_vertexspace.spinemodelc",
-    "/tile/invalid_vertexspace.tilegridc",
     "/particlefx/invalid_vertexspace.particlefxc",
     "/gui/invalid_vertexspace.guic",
     "/label/invalid_vertexspace.labelc",
@@ -2891,6 +2950,32 @@ const CopyBufferTestParams buffer_copy_setups[] = {
 INSTANTIATE_TEST_CASE_P(ScriptBufferCopySequence, ScriptBufferCopyTest, jc_test_values_in(buffer_copy_setups));
 
 
+TEST_F(ScriptBufferTest, FillAndTransformStream)
+{
+    int top = lua_gettop(L);
+
+    ASSERT_TRUE(RunString(L, "local buf = buffer.create(8, { {name=hash(\"position\"), type=buffer.VALUE_TYPE_FLOAT32, count=3 }, \
+                                                               {name=hash(\"color\"), type=buffer.VALUE_TYPE_UINT8, count=4 } }, \
+                                                          buffer.CREATE_FLAG_STRUCT_OF_ARRAYS) \
+                              local positions = buffer.get_stream(buf, \"position\") \
+                              local colors = buffer.get_stream(buf, \"color\") \
+                              buffer.fill_stream(colors, 255) \
+                              buffer.fill_stream(positions, {1, 2, 3}) \
+                              buffer.fill_stream(positions, 0, 0, 2) \
+                              buffer.transform_positions(positions, vmath.matrix4_translation(vmath.vector3(10, 20, 30)), 1) \
+                              assert(colors[1] == 255 and colors[#colors] == 255) \
+                              assert(positions[1] == 0 and positions[4] == 10 and positions[5] == 20 and positions[6] == 30) \
+                              assert(positions[7] == 11 and positions[8] == 22 and positions[9] == 33) \
+                              assert(positions[#positions] == 33) \
+                             "));
+
+    ASSERT_FALSE(RunString(L, "local buf = buffer.create(8, { {name=hash(\"position\"), type=buffer.VALUE_TYPE_FLOAT32, count=3 } }) \
+                               buffer.fill_stream(buffer.get_stream(buf, \"position\"), 1, 4, 5) \
+                              "));
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
 TEST_F(ScriptBufferTest, RefCount)
 {
     bool run;
@@ -235,6 +235,7 @@ namespace dmGraphics
      * @member TYPE_FLOAT_MAT4
      * @member TYPE_SAMPLER_2D
      * @member TYPE_SAMPLER_CUBE
+     * @member TYPE_SAMPLER_2D_ARRAY
      */
     enum Type
     {
@@ -249,6 +250,7 @@ namespace dmGraphics
         TYPE_FLOAT_MAT4     = 8,
         TYPE_SAMPLER_2D     = 9,
         TYPE_SAMPLER_CUBE   = 10,
+        TYPE_SAMPLER_2D_ARRAY = 11,
     };
 
 
@@ -18,12 +18,50 @@
 #endif
 #include <string.h>
 #include <assert.h>
+#include <dlib/array.h>
+#include <dlib/hashtable.h>
+#include <dlib/log.h>
+#include <dlib/profile.h>
 
 namespace dmGraphics
 {
     static bool                         g_adapter_selected = false;
     static GraphicsAdapter*             g_adapter_list = 0;
     static GraphicsAdapterFunctionTable g_functions;
+    static uint32_t                     g_flip_count = 0;
+
+    // Counted here, rather than in each adapter, so that all adapters report the same thing
+    static FrameStats                   g_frame_stats;          // The frame being recorded
+    static FrameStats                   g_last_frame_stats;
+    static uint32_t                     g_frames_over_budget = 0;
+    static uint32_t                     g_draw_call_budget = 0;
+    static uint32_t                     g_upload_budget = 0;
+    static dmHashTable64<uint32_t>      g_texture_memory;       // Accounted size per texture
+    static dmArray<HTexture>            g_pending_texture_memory; // Asynchronously uploaded textures, accounted again when done
+    static uint32_t                     g_texture_upload_depth = 0; // Adapters may implement SetTextureAsync with SetTexture
+
+    // Number of flips before the GPU is assumed to be done with a dynamic vertex buffer.
+    // Covers triple buffered swap chains and the Vulkan adapter's frames in flight.
+    static const uint32_t DYNAMIC_VERTEX_BUFFER_FRAME_LATENCY = 3;
+    // Upper bound of buffers per dynamic vertex buffer. When all are in use the oldest one is
+    // re-specified instead, which lets the driver orphan its storage as a regular upload would.
+    static const uint32_t MAX_DYNAMIC_VERTEX_BUFFER_SLOTS = 16;
+
+    struct DynamicVertexBuffer
+    {
+        struct Slot
+        {
+            HVertexBuffer m_Buffer;
+            uint32_t      m_Capacity;
+            uint32_t      m_Frame;
+            uint32_t      m_Orphan : 1;
+        };
+
+        HContext m_Context;
+        Slot     m_Slots[MAX_DYNAMIC_VERTEX_BUFFER_SLOTS];
+        uint32_t m_SlotCount;
+        uint32_t m_Current;
+    };
 
     void RegisterGraphicsAdapter(GraphicsAdapter* adapter, GraphicsAdapterIsSupportedCb is_supported_cb, GraphicsAdapterRegisterFunctionsCb register_functions_cb, int8_t priority)
     {
@@ -79,9 +117,15 @@ namespace dmGraphics
     : m_DefaultTextureMinFilter(TEXTURE_FILTER_LINEAR_MIPMAP_NEAREST)
     , m_DefaultTextureMagFilter(TEXTURE_FILTER_LINEAR)
     , m_GraphicsMemorySize(0)
+    , m_PipelineCacheDirectory(0)
+    , m_TextureUploadBudget(0)
+    , m_DrawCallBudget(0)
+    , m_UploadBudget(0)
     , m_VerifyGraphicsCalls(false)
     , m_RenderDocSupport(0)
     , m_UseValidationLayers(0)
+    , m_PipelineWarmup(0)
+    , m_PipelinedPresent(0)
     {
 
     }
@@ -96,9 +140,140 @@ namespace dmGraphics
 
     HContext NewContext(const ContextParams& params)
     {
+        memset(&g_frame_stats, 0, sizeof(g_frame_stats));
+        memset(&g_last_frame_stats, 0, sizeof(g_last_frame_stats));
+        g_frames_over_budget = 0;
+        g_draw_call_budget = params.m_DrawCallBudget;
+        g_upload_budget = params.m_UploadBudget;
+        if (g_texture_memory.Size() > 0)
+        {
+            g_texture_memory.Clear();
+        }
+        g_pending_texture_memory.SetSize(0);
         return g_functions.m_NewContext(params);
     }
 
+    static inline uint32_t GetPrimitiveCount(PrimitiveType prim_type, uint32_t count)
+    {
+        switch (prim_type)
+        {
+            case PRIMITIVE_LINES:           return count / 2;
+            case PRIMITIVE_TRIANGLES:       return count / 3;
+            case PRIMITIVE_TRIANGLE_STRIP:  return count > 2 ? count - 2 : 0;
+        }
+        return 0;
+    }
+
+    static void UpdateTextureMemory(HTexture texture)
+    {
+        if (!texture)
+            return;
+
+        uint32_t size = g_functions.m_GetTextureResourceSize(texture);
+        uint64_t key = (uint64_t) (uintptr_t) texture;
+        uint32_t* accounted = g_texture_memory.Get(key);
+        if (accounted)
+        {
+            g_frame_stats.m_TextureMemory -= *accounted;
+            *accounted = size;
+        }
+        else
+        {
+            if (g_texture_memory.Full())
+            {
+                uint32_t capacity = g_texture_memory.Capacity() + 256;
+                g_texture_memory.SetCapacity(capacity / 2 + 1, capacity);
+            }
+            g_texture_memory.Put(key, size);
+        }
+        g_frame_stats.m_TextureMemory += size;
+    }
+
+    static void ForgetTextureMemory(HTexture texture)
+    {
+        uint64_t key = (uint64_t) (uintptr_t) texture;
+        uint32_t* accounted = g_texture_memory.Get(key);
+        if (accounted)
+        {
+            g_frame_stats.m_TextureMemory -= *accounted;
+            g_texture_memory.Erase(key);
+        }
+        for (uint32_t i = 0; i < g_pending_texture_memory.Size(); ++i)
+        {
+            if (g_pending_texture_memory[i] == texture)
+            {
+                g_pending_texture_memory.EraseSwap(i);
+                break;
+            }
+        }
+    }
+
+    static void UpdatePendingTextureMemory()
+    {
+        uint32_t i = 0;
+        while (i < g_pending_texture_memory.Size())
+        {
+            HTexture texture = g_pending_texture_memory[i];
+            UpdateTextureMemory(texture);
+            if (g_functions.m_GetTextureStatusFlags(texture) & TEXTURE_STATUS_DATA_PENDING)
+            {
+                ++i;
+            }
+            else
+            {
+                g_pending_texture_memory.EraseSwap(i);
+            }
+        }
+    }
+
+    // Called at Flip()
+    static void EndFrameStats()
+    {
+        UpdatePendingTextureMemory();
+
+        const FrameStats& stats = g_frame_stats;
+        DM_COUNTER("Primitives", stats.m_Primitives);
+        DM_COUNTER("StateChanges", stats.m_StateChanges);
+        DM_COUNTER("RenderTargetChanges", stats.m_RenderTargetChanges);
+        DM_COUNTER("BufferUploadBytes", stats.m_BufferUploadBytes);
+        DM_COUNTER("TextureUploadBytes", stats.m_TextureUploadBytes);
+        DM_COUNTER("TextureMemory", stats.m_TextureMemory);
+
+        uint32_t upload_bytes = stats.m_BufferUploadBytes + stats.m_TextureUploadBytes;
+        bool over_budget = (g_draw_call_budget && stats.m_DrawCalls > g_draw_call_budget) ||
+                           (g_upload_budget && upload_bytes > g_upload_budget);
+        if (over_budget)
+        {
+            // Only the first frame of a run of frames over budget is logged
+            bool was_over_budget = (g_draw_call_budget && g_last_frame_stats.m_DrawCalls > g_draw_call_budget) ||
+                                   (g_upload_budget && g_last_frame_stats.m_BufferUploadBytes + g_last_frame_stats.m_TextureUploadBytes > g_upload_budget);
+            if (!was_over_budget)
+            {
+                dmLogWarning("Frame over budget: %u draw calls (budget %u), %u bytes uploaded (budget %u)", stats.m_DrawCalls, g_draw_call_budget, upload_bytes, g_upload_budget);
+            }
+            g_frames_over_budget++;
+        }
+
+        g_last_frame_stats = stats;
+        uint32_t texture_memory = stats.m_TextureMemory;
+        memset(&g_frame_stats, 0, sizeof(g_frame_stats));
+        g_frame_stats.m_TextureMemory = texture_memory;
+    }
+
+    void GetFrameStats(HContext context, FrameStats* stats, uint32_t* frames_over_budget)
+    {
+        *stats = g_last_frame_stats;
+        if (frames_over_budget)
+        {
+            *frames_over_budget = g_frames_over_budget;
+        }
+    }
+
+    void GetCurrentFrameStats(HContext context, FrameStats* stats)
+    {
+        *stats = g_frame_stats;
+    }
+
     static inline BufferType GetAttachmentBufferType(RenderTargetAttachment attachment)
     {
         static AttachmentToBufferType g_AttachmentToBufferType;
@@ -363,6 +538,20 @@ namespace dmGraphics
     void Flip(HContext context)
     {
         g_functions.m_Flip(context);
+        g_flip_count++;
+        EndFrameStats();
+    }
+    void SetJobContext(HContext context, dmJob::HContext job_context)
+    {
+        g_functions.m_SetJobContext(context, job_context);
+    }
+    void BeginGpuTimer(HContext context, const char* name, uint32_t name_hash)
+    {
+        g_functions.m_BeginGpuTimer(context, name, name_hash);
+    }
+    void EndGpuTimer(HContext context)
+    {
+        g_functions.m_EndGpuTimer(context);
     }
     void SetSwapInterval(HContext context, uint32_t swap_interval)
     {
@@ -374,6 +563,10 @@ namespace dmGraphics
     }
     HVertexBuffer NewVertexBuffer(HContext context, uint32_t size, const void* data, BufferUsage buffer_usage)
     {
+        if (data)
+        {
+            g_frame_stats.m_BufferUploadBytes += size;
+        }
         return g_functions.m_NewVertexBuffer(context, size, data, buffer_usage);
     }
     void DeleteVertexBuffer(HVertexBuffer buffer)
@@ -382,12 +575,99 @@ namespace dmGraphics
     }
     void SetVertexBufferData(HVertexBuffer buffer, uint32_t size, const void* data, BufferUsage buffer_usage)
     {
+        if (data)
+        {
+            g_frame_stats.m_BufferUploadBytes += size;
+        }
         g_functions.m_SetVertexBufferData(buffer, size, data, buffer_usage);
     }
     void SetVertexBufferSubData(HVertexBuffer buffer, uint32_t offset, uint32_t size, const void* data)
     {
+        g_frame_stats.m_BufferUploadBytes += size;
         g_functions.m_SetVertexBufferSubData(buffer, offset, size, data);
     }
+
+    HDynamicVertexBuffer NewDynamicVertexBuffer(HContext context)
+    {
+        DynamicVertexBuffer* buffer = new DynamicVertexBuffer;
+        memset(buffer, 0, sizeof(*buffer));
+        buffer->m_Context = context;
+        return buffer;
+    }
+
+    void DeleteDynamicVertexBuffer(HDynamicVertexBuffer buffer)
+    {
+        if (!buffer)
+            return;
+        for (uint32_t i = 0; i < buffer->m_SlotCount; ++i)
+        {
+            DeleteVertexBuffer(buffer->m_Slots[i].m_Buffer);
+        }
+        delete buffer;
+    }
+
+    HVertexBuffer AcquireDynamicVertexBuffer(HDynamicVertexBuffer buffer)
+    {
+        uint32_t oldest = 0;
+        uint32_t oldest_age = 0;
+        for (uint32_t i = 0; i < buffer->m_SlotCount; ++i)
+        {
+            uint32_t age = g_flip_count - buffer->m_Slots[i].m_Frame;
+            if (age > oldest_age || i == 0)
+            {
+                oldest = i;
+                oldest_age = age;
+            }
+        }
+
+        DynamicVertexBuffer::Slot* slot;
+        if (buffer->m_SlotCount > 0 && oldest_age >= DYNAMIC_VERTEX_BUFFER_FRAME_LATENCY)
+        {
+            slot = &buffer->m_Slots[oldest];
+            slot->m_Orphan = 0;
+        }
+        else if (buffer->m_SlotCount < MAX_DYNAMIC_VERTEX_BUFFER_SLOTS)
+        {
+            oldest = buffer->m_SlotCount++;
+            slot = &buffer->m_Slots[oldest];
+            slot->m_Buffer = NewVertexBuffer(buffer->m_Context, 0, 0x0, BUFFER_USAGE_DYNAMIC_DRAW);
+            slot->m_Capacity = 0;
+            slot->m_Orphan = 0;
+        }
+        else
+        {
+            // The GPU might still be reading from it
+            slot = &buffer->m_Slots[oldest];
+            slot->m_Orphan = 1;
+        }
+
+        slot->m_Frame = g_flip_count;
+        buffer->m_Current = oldest;
+        return slot->m_Buffer;
+    }
+
+    void SetDynamicVertexBufferData(HDynamicVertexBuffer buffer, uint32_t size, const void* data)
+    {
+        assert(buffer->m_Current < buffer->m_SlotCount);
+        if (size == 0)
+            return;
+
+        DynamicVertexBuffer::Slot& slot = buffer->m_Slots[buffer->m_Current];
+        if (size > slot.m_Capacity)
+        {
+            // Grow with some headroom to avoid re-specifying the storage while the data size settles
+            slot.m_Capacity = size + size / 2;
+            slot.m_Orphan = 1;
+        }
+
+        if (slot.m_Orphan)
+        {
+            SetVertexBufferData(slot.m_Buffer, slot.m_Capacity, 0x0, BUFFER_USAGE_DYNAMIC_DRAW);
+            slot.m_Orphan = 0;
+        }
+        SetVertexBufferSubData(slot.m_Buffer, 0, size, data);
+    }
+
     void* MapVertexBuffer(HVertexBuffer buffer, BufferAccess access)
     {
         return g_functions.m_MapVertexBuffer(buffer, access);
@@ -402,6 +682,10 @@ namespace dmGraphics
     }
     HIndexBuffer NewIndexBuffer(HContext context, uint32_t size, const void* data, BufferUsage buffer_usage)
     {
+        if (data)
+        {
+            g_frame_stats.m_BufferUploadBytes += size;
+        }
         return g_functions.m_NewIndexBuffer(context, size, data, buffer_usage);
     }
     void DeleteIndexBuffer(HIndexBuffer buffer)
@@ -410,10 +694,15 @@ namespace dmGraphics
     }
     void SetIndexBufferData(HIndexBuffer buffer, uint32_t size, const void* data, BufferUsage buffer_usage)
     {
+        if (data)
+        {
+            g_frame_stats.m_BufferUploadBytes += size;
+        }
         g_functions.m_SetIndexBufferData(buffer, size, data, buffer_usage);
     }
     void SetIndexBufferSubData(HIndexBuffer buffer, uint32_t offset, uint32_t size, const void* data)
     {
+        g_frame_stats.m_BufferUploadBytes += size;
         g_functions.m_SetIndexBufferSubData(buffer, offset, size, data);
     }
     void* MapIndexBuffer(HIndexBuffer buffer, BufferAccess access)
@@ -466,12 +755,40 @@ namespace dmGraphics
     }
     void DrawElements(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer)
     {
+        g_frame_stats.m_DrawCalls++;
+        g_frame_stats.m_Primitives += GetPrimitiveCount(prim_type, count);
         g_functions.m_DrawElements(context, prim_type, first, count, type, index_buffer);
     }
     void Draw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count)
     {
+        g_frame_stats.m_DrawCalls++;
+        g_frame_stats.m_Primitives += GetPrimitiveCount(prim_type, count);
         g_functions.m_Draw(context, prim_type, first, count);
     }
+    bool IsInstancingSupported(HContext context)
+    {
+        return g_functions.m_IsInstancingSupported(context);
+    }
+    void EnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t first_instance, HProgram program)
+    {
+        g_functions.m_EnableInstanceVertexDeclaration(context, vertex_declaration, vertex_buffer, first_instance, program);
+    }
+    void DisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    {
+        g_functions.m_DisableInstanceVertexDeclaration(context, vertex_declaration);
+    }
+    void DrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        g_frame_stats.m_DrawCalls++;
+        g_frame_stats.m_Primitives += GetPrimitiveCount(prim_type, count) * instance_count;
+        g_functions.m_DrawElementsInstanced(context, prim_type, first, count, instance_count, type, index_buffer);
+    }
+    void DrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        g_frame_stats.m_DrawCalls++;
+        g_frame_stats.m_Primitives += GetPrimitiveCount(prim_type, count) * instance_count;
+        g_functions.m_DrawInstanced(context, prim_type, first, count, instance_count);
+    }
     HVertexProgram NewVertexProgram(HContext context, ShaderDesc::Shader* ddf)
     {
         return g_functions.m_NewVertexProgram(context, ddf);
@@ -510,10 +827,12 @@ namespace dmGraphics
     }
     void EnableProgram(HContext context, HProgram program)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_EnableProgram(context, program);
     }
     void DisableProgram(HContext context)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_DisableProgram(context);
     }
     bool ReloadProgram(HContext context, HProgram program, HVertexProgram vert_program, HFragmentProgram frag_program)
@@ -550,26 +869,32 @@ namespace dmGraphics
     }
     void EnableState(HContext context, State state)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_EnableState(context, state);
     }
     void DisableState(HContext context, State state)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_DisableState(context, state);
     }
     void SetBlendFunc(HContext context, BlendFactor source_factor, BlendFactor destinaton_factor)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetBlendFunc(context, source_factor, destinaton_factor);
     }
     void SetColorMask(HContext context, bool red, bool green, bool blue, bool alpha)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetColorMask(context, red, green, blue, alpha);
     }
     void SetDepthMask(HContext context, bool mask)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetDepthMask(context, mask);
     }
     void SetDepthFunc(HContext context, CompareFunc func)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetDepthFunc(context, func);
     }
     void SetScissor(HContext context, int32_t x, int32_t y, int32_t width, int32_t height)
@@ -578,46 +903,62 @@ namespace dmGraphics
     }
     void SetStencilMask(HContext context, uint32_t mask)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetStencilMask(context, mask);
     }
     void SetStencilFunc(HContext context, CompareFunc func, uint32_t ref, uint32_t mask)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetStencilFunc(context, func, ref, mask);
     }
     void SetStencilFuncSeparate(HContext context, FaceType face_type, CompareFunc func, uint32_t ref, uint32_t mask)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetStencilFuncSeparate(context, face_type, func, ref, mask);
     }
     void SetStencilOp(HContext context, StencilOp sfail, StencilOp dpfail, StencilOp dppass)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetStencilOp(context, sfail, dpfail, dppass);
     }
     void SetStencilOpSeparate(HContext context, FaceType face_type, StencilOp sfail, StencilOp dpfail, StencilOp dppass)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetStencilOpSeparate(context, face_type, sfail, dpfail, dppass);
     }
     void SetCullFace(HContext context, FaceType face_type)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetCullFace(context, face_type);
     }
     void SetFaceWinding(HContext context, FaceWinding face_winding)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetFaceWinding(context, face_winding);
     }
     void SetPolygonOffset(HContext context, float factor, float units)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_SetPolygonOffset(context, factor, units);
     }
     HRenderTarget NewRenderTarget(HContext context, uint32_t buffer_type_flags, const TextureCreationParams creation_params[MAX_BUFFER_TYPE_COUNT], const TextureParams params[MAX_BUFFER_TYPE_COUNT])
     {
-        return g_functions.m_NewRenderTarget(context, buffer_type_flags, creation_params, params);
+        HRenderTarget render_target = g_functions.m_NewRenderTarget(context, buffer_type_flags, creation_params, params);
+        UpdateTextureMemory(g_functions.m_GetRenderTargetTexture(render_target, BUFFER_TYPE_COLOR_BIT));
+        return render_target;
     }
     void DeleteRenderTarget(HRenderTarget render_target)
     {
+        HTexture texture = g_functions.m_GetRenderTargetTexture(render_target, BUFFER_TYPE_COLOR_BIT);
+        if (texture)
+        {
+            ForgetTextureMemory(texture);
+        }
         g_functions.m_DeleteRenderTarget(render_target);
     }
     void SetRenderTarget(HContext context, HRenderTarget render_target, uint32_t transient_buffer_types)
     {
+        g_frame_stats.m_RenderTargetChanges++;
         g_functions.m_SetRenderTarget(context, render_target, transient_buffer_types);
     }
     HTexture GetRenderTargetTexture(HRenderTarget render_target, BufferType buffer_type)
@@ -631,26 +972,61 @@ namespace dmGraphics
     void SetRenderTargetSize(HRenderTarget render_target, uint32_t width, uint32_t height)
     {
         g_functions.m_SetRenderTargetSize(render_target, width, height);
+        UpdateTextureMemory(g_functions.m_GetRenderTargetTexture(render_target, BUFFER_TYPE_COLOR_BIT));
     }
     bool IsTextureFormatSupported(HContext context, TextureFormat format)
     {
         return g_functions.m_IsTextureFormatSupported(context, format);
     }
+    bool IsTextureTypeSupported(HContext context, TextureType type)
+    {
+        return g_functions.m_IsTextureTypeSupported(context, type);
+    }
     HTexture NewTexture(HContext context, const TextureCreationParams& params)
     {
-        return g_functions.m_NewTexture(context, params);
+        HTexture texture = g_functions.m_NewTexture(context, params);
+        UpdateTextureMemory(texture);
+        return texture;
     }
     void DeleteTexture(HTexture t)
     {
+        ForgetTextureMemory(t);
         g_functions.m_DeleteTexture(t);
     }
     void SetTexture(HTexture texture, const TextureParams& params)
     {
+        if (g_texture_upload_depth++ == 0 && params.m_Data)
+        {
+            g_frame_stats.m_TextureUploadBytes += params.m_DataSize;
+        }
         g_functions.m_SetTexture(texture, params);
+        g_texture_upload_depth--;
+        UpdateTextureMemory(texture);
     }
     void SetTextureAsync(HTexture texture, const TextureParams& paramsa)
     {
+        if (g_texture_upload_depth++ == 0 && paramsa.m_Data)
+        {
+            g_frame_stats.m_TextureUploadBytes += paramsa.m_DataSize;
+        }
         g_functions.m_SetTextureAsync(texture, paramsa);
+        g_texture_upload_depth--;
+        UpdateTextureMemory(texture);
+        // The size isn't necessarily known until the upload is done
+        for (uint32_t i = 0; i < g_pending_texture_memory.Size(); ++i)
+        {
+            if (g_pending_texture_memory[i] == texture)
+                return;
+        }
+        if (g_pending_texture_memory.Full())
+        {
+            g_pending_texture_memory.OffsetCapacity(64);
+        }
+        g_pending_texture_memory.Push(texture);
+    }
+    bool GenerateMipMaps(HTexture texture)
+    {
+        return g_functions.m_GenerateMipMaps(texture);
     }
     void SetTextureParams(HTexture texture, TextureFilter minfilter, TextureFilter magfilter, TextureWrap uwrap, TextureWrap vwrap)
     {
@@ -668,6 +1044,10 @@ namespace dmGraphics
     {
         return g_functions.m_GetTextureHeight(texture);
     }
+    uint16_t GetTextureDepth(HTexture texture)
+    {
+        return g_functions.m_GetTextureDepth(texture);
+    }
     uint16_t GetOriginalTextureWidth(HTexture texture)
     {
         return g_functions.m_GetOriginalTextureWidth(texture);
@@ -678,10 +1058,12 @@ namespace dmGraphics
     }
     void EnableTexture(HContext context, uint32_t unit, HTexture texture)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_EnableTexture(context, unit, texture);
     }
     void DisableTexture(HContext context, uint32_t unit, HTexture texture)
     {
+        g_frame_stats.m_StateChanges++;
         g_functions.m_DisableTexture(context, unit, texture);
     }
     uint32_t GetMaxTextureSize(HContext context)
@@ -18,11 +18,13 @@
 
 #include <dmsdk/graphics/graphics.h>
 #include <dlib/hash.h>
+#include <dlib/job.h>
 #include <ddf/ddf.h>
 #include <graphics/graphics_ddf.h>
 
 namespace dmGraphics
 {
+    typedef struct DynamicVertexBuffer* HDynamicVertexBuffer;
 
     typedef void (*WindowResizeCallback)(void* user_data, uint32_t width, uint32_t height);
 
@@ -137,6 +139,7 @@ namespace dmGraphics
     {
         TEXTURE_TYPE_2D       = 0,
         TEXTURE_TYPE_CUBE_MAP = 1,
+        TEXTURE_TYPE_2D_ARRAY = 2,
     };
 
     // Texture filter
@@ -219,7 +222,9 @@ namespace dmGraphics
             m_Height(0),
             m_OriginalWidth(0),
             m_OriginalHeight(0),
-            m_MipMapCount(1)
+            m_Depth(1),
+            m_MipMapCount(1),
+            m_Transient(0)
         {}
 
         TextureType m_Type;
@@ -227,7 +232,10 @@ namespace dmGraphics
         uint16_t    m_Height;
         uint16_t    m_OriginalWidth;
         uint16_t    m_OriginalHeight;
+        uint16_t    m_Depth;        // Number of layers of a TEXTURE_TYPE_2D_ARRAY texture
         uint8_t     m_MipMapCount;
+        // Render target buffer that is never sampled, and whose contents can be discarded after rendering
+        uint8_t     m_Transient : 1;
     };
 
     struct TextureParams
@@ -243,9 +251,11 @@ namespace dmGraphics
         , m_MipMap(0)
         , m_Width(0)
         , m_Height(0)
+        , m_Depth(1)
         , m_SubUpdate(false)
         , m_X(0)
         , m_Y(0)
+        , m_Z(0)
         {}
 
         TextureFormat m_Format;
@@ -258,11 +268,13 @@ namespace dmGraphics
         uint16_t m_MipMap;
         uint16_t m_Width;
         uint16_t m_Height;
+        uint16_t m_Depth; // Number of layers in m_Data, for TEXTURE_TYPE_2D_ARRAY textures
 
         // For sub texture updates
         bool m_SubUpdate;
         uint32_t m_X;
         uint32_t m_Y;
+        uint32_t m_Z; // First layer to update, for TEXTURE_TYPE_2D_ARRAY textures
     };
 
     // Parameters structure for OpenWindow
@@ -310,10 +322,16 @@ namespace dmGraphics
         TextureFilter m_DefaultTextureMinFilter;
         TextureFilter m_DefaultTextureMagFilter;
         uint32_t      m_GraphicsMemorySize;             // The max allowed Gfx memory (default 0)
+        const char*   m_PipelineCacheDirectory;         // Where pipeline caches and program binaries are stored between runs (default 0, disabled)
+        uint32_t      m_TextureUploadBudget;            // Max bytes of SetTextureAsync data uploaded on the main thread per frame (default 0, no limit)
+        uint32_t      m_DrawCallBudget;                 // Max draw calls per frame before the frame counts as over budget, see FrameStats (default 0, no limit)
+        uint32_t      m_UploadBudget;                   // Max bytes of buffer and texture data uploaded per frame before the frame counts as over budget (default 0, no limit)
         uint8_t       m_VerifyGraphicsCalls : 1;
         uint8_t       m_RenderDocSupport : 1;           // Vulkan only
         uint8_t       m_UseValidationLayers : 1;        // Vulkan only
-        uint8_t       : 5;
+        uint8_t       m_PipelineWarmup : 1;             // Vulkan only. Record created pipelines and create them again at startup
+        uint8_t       m_PipelinedPresent : 1;           // Vulkan only. Submit and present a frame on a separate thread while the next frame is simulated
+        uint8_t       : 3;
     };
 
     /** Creates a graphics context
@@ -466,6 +484,63 @@ namespace dmGraphics
      */
     void SetSwapInterval(HContext context, uint32_t swap_interval);
 
+    /**
+     * Set the job context the graphics backend may use to record draw calls on worker threads.
+     * Backends that record on the calling thread ignore it. Must not be called between
+     * BeginFrame() and Flip().
+     * @param context Graphics context
+     * @param job_context Job context, may be 0
+     */
+    void SetJobContext(HContext context, dmJob::HContext job_context);
+
+    /**
+     * Start measuring the time the GPU spends on the commands issued until #EndGpuTimer.
+     * The timers are read back a few frames later and added to the profiler as GPU samples,
+     * see dmProfile::AddGpuSample(). Timers can't be nested, and are ignored if the adapter
+     * has no timer query support.
+     * @param context Graphics context
+     * @param name Timer name, must be valid for the life-time of the profile. See dmProfile::Internalize()
+     * @param name_hash Timer name hash
+     */
+    void BeginGpuTimer(HContext context, const char* name, uint32_t name_hash);
+
+    /**
+     * Stop the timer started with #BeginGpuTimer
+     * @param context Graphics context
+     */
+    void EndGpuTimer(HContext context);
+
+    /**
+     * Per frame counters, gathered for all adapters by the functions in this API
+     */
+    struct FrameStats
+    {
+        uint32_t m_DrawCalls;
+        uint32_t m_Primitives;          // Triangles, or lines, drawn. Instanced draws count all instances
+        uint32_t m_StateChanges;        // Program, texture and fixed function state changes requested
+        uint32_t m_RenderTargetChanges;
+        uint32_t m_BufferUploadBytes;   // Vertex and index data
+        uint32_t m_TextureUploadBytes;
+        uint32_t m_TextureMemory;       // Memory of the textures and render target color buffers in use
+    };
+
+    /**
+     * Get the counters of the last completed frame, i.e. up until the last Flip()
+     * @param context Graphics context
+     * @param stats [out] Frame counters
+     * @param frames_over_budget [out] Number of frames since the context was created that exceeded
+     *        ContextParams::m_DrawCallBudget or ContextParams::m_UploadBudget. May be 0
+     */
+    void GetFrameStats(HContext context, FrameStats* stats, uint32_t* frames_over_budget);
+
+    /**
+     * Get the counters of the frame currently being recorded. Taking the difference of two calls
+     * gives the cost of the calls made in between, e.g. a single render pass.
+     * @param context Graphics context
+     * @param stats [out] Frame counters so far
+     */
+    void GetCurrentFrameStats(HContext context, FrameStats* stats);
+
     /**
      * Clear render target
      * @param context Graphics context
@@ -479,6 +554,34 @@ namespace dmGraphics
      */
     void Clear(HContext context, uint32_t flags, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, float depth, uint32_t stencil);
 
+    /**
+     * Create a vertex buffer for data that is rewritten every frame.
+     * Instead of re-specifying the storage of a single buffer each upload, which forces the driver
+     * to orphan (or wait for) the storage still in use by the GPU, it cycles through a small pool
+     * of buffers and only reuses a buffer when the frames that drew from it have been flipped.
+     * @param context Graphics context
+     * @return Dynamic vertex buffer handle
+     */
+    HDynamicVertexBuffer NewDynamicVertexBuffer(HContext context);
+    void DeleteDynamicVertexBuffer(HDynamicVertexBuffer buffer);
+
+    /**
+     * Get the vertex buffer to use for the next upload. Call once per upload, before
+     * the vertex buffer is given to any render objects.
+     * @param buffer Dynamic vertex buffer handle
+     * @return Vertex buffer to bind when drawing the data of the next upload
+     */
+    HVertexBuffer AcquireDynamicVertexBuffer(HDynamicVertexBuffer buffer);
+
+    /**
+     * Upload data to the vertex buffer returned by the last call to AcquireDynamicVertexBuffer().
+     * The storage is only grown if needed, otherwise the data is written in place.
+     * @param buffer Dynamic vertex buffer handle
+     * @param size Size of the data in bytes
+     * @param data Data to upload
+     */
+    void SetDynamicVertexBufferData(HDynamicVertexBuffer buffer, uint32_t size, const void* data);
+
     // Test functions:
     void* MapVertexBuffer(HVertexBuffer buffer, BufferAccess access);
     bool UnmapVertexBuffer(HVertexBuffer buffer);
@@ -495,6 +598,47 @@ namespace dmGraphics
     void DrawElements(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer);
     void Draw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count);
 
+    /**
+     * Check if the context can draw instanced geometry, see DrawElementsInstanced().
+     * @param context Graphics context
+     * @return true if instanced drawing is supported
+     */
+    bool IsInstancingSupported(HContext context);
+
+    /**
+     * Enable a vertex declaration whose streams advance once per instance instead of once per vertex.
+     * It is used together with a regular vertex declaration for the per vertex data.
+     * @param context Graphics context
+     * @param vertex_declaration Vertex declaration of the per instance data
+     * @param vertex_buffer Vertex buffer holding one element per instance
+     * @param first_instance Index of the element used by the first instance
+     * @param program The program used to bind the streams by name
+     */
+    void EnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t first_instance, HProgram program);
+    void DisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration);
+
+    /**
+     * Draw several instances of the indexed geometry with a single call.
+     * @param context Graphics context
+     * @param prim_type Primitive type
+     * @param first Byte offset into the index buffer
+     * @param count Number of indices per instance
+     * @param instance_count Number of instances
+     * @param type Index type
+     * @param index_buffer Index buffer
+     */
+    void DrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer);
+
+    /**
+     * Draw several instances of the non-indexed geometry with a single call.
+     * @param context Graphics context
+     * @param prim_type Primitive type
+     * @param first First vertex
+     * @param count Number of vertices per instance
+     * @param instance_count Number of instances
+     */
+    void DrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count);
+
     HVertexProgram NewVertexProgram(HContext context, ShaderDesc::Shader* ddf);
     HFragmentProgram NewFragmentProgram(HContext context, ShaderDesc::Shader* ddf);
     HProgram NewProgram(HContext context, HVertexProgram vertex_program, HFragmentProgram fragment_program);
@@ -547,13 +691,22 @@ namespace dmGraphics
     inline const char* GetBufferTypeLiteral(BufferType buffer_type);
 
     bool IsTextureFormatSupported(HContext context, TextureFormat format);
+
+    /**
+     * Check if textures of a type can be created, e.g. TEXTURE_TYPE_2D_ARRAY needs GL ES 3.0 or OpenGL 3.0.
+     * @param context Graphics context
+     * @param type Texture type
+     * @return true if the texture type is supported
+     */
+    bool IsTextureTypeSupported(HContext context, TextureType type);
     TextureFormat GetSupportedCompressionFormat(HContext context, TextureFormat format, uint32_t width, uint32_t height);
     HTexture NewTexture(HContext context, const TextureCreationParams& params);
     void DeleteTexture(HTexture t);
 
     /**
      * Set texture data. For textures of type TEXTURE_TYPE_CUBE_MAP it's assumed that
-     * 6 mip-maps are present contiguously in memory with stride m_DataSize
+     * 6 mip-maps are present contiguously in memory with stride m_DataSize. For textures of
+     * type TEXTURE_TYPE_2D_ARRAY, m_Depth layers are present in the same way, starting at layer m_Z
      *
      * @param texture HTexture
      * @param params TextureParams
@@ -564,15 +717,30 @@ namespace dmGraphics
      * Set texture data asynchronously. For textures of type TEXTURE_TYPE_CUBE_MAP it's assumed that
      * 6 mip-maps are present contiguously in memory with stride m_DataSize
      *
+     * The data must stay valid until GetTextureStatusFlags no longer reports TEXTURE_STATUS_DATA_PENDING.
+     * Uploads that can't be made on a worker thread are spread over the following frames, at most
+     * ContextParams::m_TextureUploadBudget bytes per frame.
+     *
      * @param texture HTexture
      * @param params TextureParams
      */
     void SetTextureAsync(HTexture texture, const TextureParams& paramsa);
 
+    /**
+     * Generate the mipmaps of a 2D texture on the GPU by downsampling mip 0. The data of mip 0 must have been
+     * set with SetTexture. Compressed formats are not supported, and the Vulkan adapter only fills the mip
+     * levels the texture was created with.
+     *
+     * @param texture HTexture
+     * @return true if the mipmaps were generated
+     */
+    bool GenerateMipMaps(HTexture texture);
+
     void SetTextureParams(HTexture texture, TextureFilter minfilter, TextureFilter magfilter, TextureWrap uwrap, TextureWrap vwrap);
     uint32_t GetTextureResourceSize(HTexture texture);
     uint16_t GetTextureWidth(HTexture texture);
     uint16_t GetTextureHeight(HTexture texture);
+    uint16_t GetTextureDepth(HTexture texture);
     uint16_t GetOriginalTextureWidth(HTexture texture);
     uint16_t GetOriginalTextureHeight(HTexture texture);
     void EnableTexture(HContext context, uint32_t unit, HTexture texture);
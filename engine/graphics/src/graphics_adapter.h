@@ -14,6 +14,7 @@
 #define DM_GRAPHICS_ADAPTER_H
 
 #include <dlib/hash.h>
+#include <dlib/job.h>
 #include <dmsdk/graphics/graphics.h>
 
 namespace dmGraphics
@@ -67,6 +68,9 @@ namespace dmGraphics
     typedef void (*BeginFrameFn)(HContext context);
     typedef void (*FlipFn)(HContext context);
     typedef void (*SetSwapIntervalFn)(HContext context, uint32_t swap_interval);
+    typedef void (*SetJobContextFn)(HContext context, dmJob::HContext job_context);
+    typedef void (*BeginGpuTimerFn)(HContext context, const char* name, uint32_t name_hash);
+    typedef void (*EndGpuTimerFn)(HContext context);
     typedef void (*ClearFn)(HContext context, uint32_t flags, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, float depth, uint32_t stencil);
     typedef HVertexBuffer (*NewVertexBufferFn)(HContext context, uint32_t size, const void* data, BufferUsage buffer_usage);
     typedef void (*DeleteVertexBufferFn)(HVertexBuffer buffer);
@@ -93,6 +97,11 @@ namespace dmGraphics
     typedef void (*HashVertexDeclarationFn)(HashState32* state, HVertexDeclaration vertex_declaration);
     typedef void (*DrawElementsFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer);
     typedef void (*DrawFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count);
+    typedef bool (*IsInstancingSupportedFn)(HContext context);
+    typedef void (*EnableInstanceVertexDeclarationFn)(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t first_instance, HProgram program);
+    typedef void (*DisableInstanceVertexDeclarationFn)(HContext context, HVertexDeclaration vertex_declaration);
+    typedef void (*DrawElementsInstancedFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer);
+    typedef void (*DrawInstancedFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count);
     typedef HVertexProgram (*NewVertexProgramFn)(HContext context, ShaderDesc::Shader* ddf);
     typedef HFragmentProgram (*NewFragmentProgramFn)(HContext context, ShaderDesc::Shader* ddf);
     typedef HProgram (*NewProgramFn)(HContext context, HVertexProgram vertex_program, HFragmentProgram fragment_program);
@@ -134,14 +143,17 @@ namespace dmGraphics
     typedef void (*GetRenderTargetSizeFn)(HRenderTarget render_target, BufferType buffer_type, uint32_t& width, uint32_t& height);
     typedef void (*SetRenderTargetSizeFn)(HRenderTarget render_target, uint32_t width, uint32_t height);
     typedef bool (*IsTextureFormatSupportedFn)(HContext context, TextureFormat format);
+    typedef bool (*IsTextureTypeSupportedFn)(HContext context, TextureType type);
     typedef HTexture (*NewTextureFn)(HContext context, const TextureCreationParams& params);
     typedef void (*DeleteTextureFn)(HTexture t);
     typedef void (*SetTextureFn)(HTexture texture, const TextureParams& params);
     typedef void (*SetTextureAsyncFn)(HTexture texture, const TextureParams& paramsa);
+    typedef bool (*GenerateMipMapsFn)(HTexture texture);
     typedef void (*SetTextureParamsFn)(HTexture texture, TextureFilter minfilter, TextureFilter magfilter, TextureWrap uwrap, TextureWrap vwrap);
     typedef uint32_t (*GetTextureResourceSizeFn)(HTexture texture);
     typedef uint16_t (*GetTextureWidthFn)(HTexture texture);
     typedef uint16_t (*GetTextureHeightFn)(HTexture texture);
+    typedef uint16_t (*GetTextureDepthFn)(HTexture texture);
     typedef uint16_t (*GetOriginalTextureWidthFn)(HTexture texture);
     typedef uint16_t (*GetOriginalTextureHeightFn)(HTexture texture);
     typedef void (*EnableTextureFn)(HContext context, uint32_t unit, HTexture texture);
@@ -174,6 +186,9 @@ namespace dmGraphics
         BeginFrameFn m_BeginFrame;
         FlipFn m_Flip;
         SetSwapIntervalFn m_SetSwapInterval;
+        SetJobContextFn m_SetJobContext;
+        BeginGpuTimerFn m_BeginGpuTimer;
+        EndGpuTimerFn m_EndGpuTimer;
         ClearFn m_Clear;
         NewVertexBufferFn m_NewVertexBuffer;
         DeleteVertexBufferFn m_DeleteVertexBuffer;
@@ -200,6 +215,11 @@ namespace dmGraphics
         HashVertexDeclarationFn m_HashVertexDeclaration;
         DrawElementsFn m_DrawElements;
         DrawFn m_Draw;
+        IsInstancingSupportedFn m_IsInstancingSupported;
+        EnableInstanceVertexDeclarationFn m_EnableInstanceVertexDeclaration;
+        DisableInstanceVertexDeclarationFn m_DisableInstanceVertexDeclaration;
+        DrawElementsInstancedFn m_DrawElementsInstanced;
+        DrawInstancedFn m_DrawInstanced;
         NewVertexProgramFn m_NewVertexProgram;
         NewFragmentProgramFn m_NewFragmentProgram;
         NewProgramFn m_NewProgram;
@@ -241,14 +261,17 @@ namespace dmGraphics
         GetRenderTargetSizeFn m_GetRenderTargetSize;
         SetRenderTargetSizeFn m_SetRenderTargetSize;
         IsTextureFormatSupportedFn m_IsTextureFormatSupported;
+        IsTextureTypeSupportedFn m_IsTextureTypeSupported;
         NewTextureFn m_NewTexture;
         DeleteTextureFn m_DeleteTexture;
         SetTextureFn m_SetTexture;
         SetTextureAsyncFn m_SetTextureAsync;
+        GenerateMipMapsFn m_GenerateMipMaps;
         SetTextureParamsFn m_SetTextureParams;
         GetTextureResourceSizeFn m_GetTextureResourceSize;
         GetTextureWidthFn m_GetTextureWidth;
         GetTextureHeightFn m_GetTextureHeight;
+        GetTextureDepthFn m_GetTextureDepth;
         GetOriginalTextureWidthFn m_GetOriginalTextureWidth;
         GetOriginalTextureHeightFn m_GetOriginalTextureHeight;
         EnableTextureFn m_EnableTexture;
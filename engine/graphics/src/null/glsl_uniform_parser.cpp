@@ -78,6 +78,12 @@ namespace dmGraphics
             *out_type = TYPE_FLOAT_MAT4;
             return true;
         }
+        // Before sampler2D, which is a prefix of it
+        else if (STRNCMP("sampler2DArray", string, count))
+        {
+            *out_type = TYPE_SAMPLER_2D_ARRAY;
+            return true;
+        }
         else if (STRNCMP("sampler2D", string, count))
         {
             *out_type = TYPE_SAMPLER_2D;
@@ -308,6 +308,21 @@ namespace dmGraphics
         // NOP
     }
 
+    static void NullSetJobContext(HContext /*context*/, dmJob::HContext /*job_context*/)
+    {
+        // NOP
+    }
+
+    static void NullBeginGpuTimer(HContext /*context*/, const char* /*name*/, uint32_t /*name_hash*/)
+    {
+        // NOP
+    }
+
+    static void NullEndGpuTimer(HContext /*context*/)
+    {
+        // NOP
+    }
+
     #define NATIVE_HANDLE_IMPL(return_type, func_name) return_type GetNative##func_name() { return NULL; }
 
     NATIVE_HANDLE_IMPL(id, iOSUIWindow);
@@ -640,6 +655,55 @@ namespace dmGraphics
         g_DrawCount++;
     }
 
+    static bool NullIsInstancingSupported(HContext context)
+    {
+        return true;
+    }
+
+    static void NullEnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t first_instance, HProgram program)
+    {
+        assert(context);
+        assert(vertex_declaration);
+        assert(vertex_buffer);
+        assert(context->m_InstanceData == 0x0);
+        VertexBuffer* vb = (VertexBuffer*)vertex_buffer;
+        uint32_t stride = 0;
+        for (uint32_t i = 0; i < vertex_declaration->m_Count; ++i)
+            stride += vertex_declaration->m_Elements[i].m_Size * TYPE_SIZE[vertex_declaration->m_Elements[i].m_Type - dmGraphics::TYPE_BYTE];
+        uint32_t offset = first_instance * stride;
+        assert(offset <= vb->m_Size);
+        context->m_InstanceData = &vb->m_Buffer[offset];
+        context->m_InstanceDataSize = vb->m_Size - offset;
+        context->m_InstanceStride = stride;
+    }
+
+    static void NullDisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    {
+        assert(context);
+        assert(vertex_declaration);
+        context->m_InstanceData = 0x0;
+        context->m_InstanceDataSize = 0;
+        context->m_InstanceStride = 0;
+    }
+
+    static void NullDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        assert(context);
+        assert(context->m_InstanceData != 0x0);
+        // All instances must be backed by the instance buffer
+        assert(instance_count * context->m_InstanceStride <= context->m_InstanceDataSize);
+        // The per vertex streams are shared by all instances
+        NullDrawElements(context, prim_type, first, count, type, index_buffer);
+    }
+
+    static void NullDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        assert(context);
+        assert(context->m_InstanceData != 0x0);
+        assert(instance_count * context->m_InstanceStride <= context->m_InstanceDataSize);
+        NullDraw(context, prim_type, first, count);
+    }
+
     // For tests
     uint64_t GetDrawCount()
     {
@@ -671,6 +735,7 @@ namespace dmGraphics
         Program(VertexProgram* vp, FragmentProgram* fp)
         {
             m_Uniforms.SetCapacity(16);
+            memset(m_Registers, 0, sizeof(m_Registers));
             m_VP = vp;
             m_FP = fp;
             if (m_VP != 0x0)
@@ -688,6 +753,8 @@ namespace dmGraphics
         VertexProgram* m_VP;
         FragmentProgram* m_FP;
         dmArray<Uniform> m_Uniforms;
+        // Like GL uniforms, the constant values are part of the program state
+        Vector4          m_Registers[MAX_REGISTER_COUNT];
     };
 
     static void NullUniformCallback(const char* name, uint32_t name_length, dmGraphics::Type type, uintptr_t userdata)
@@ -844,21 +911,21 @@ namespace dmGraphics
     {
         assert(context);
         assert(context->m_Program != 0x0);
-        return context->m_ProgramRegisters[base_register];
+        return ((Program*) context->m_Program)->m_Registers[base_register];
     }
 
     static void NullSetConstantV4(HContext context, const Vector4* data, int base_register)
     {
         assert(context);
         assert(context->m_Program != 0x0);
-        memcpy(&context->m_ProgramRegisters[base_register], data, sizeof(Vector4));
+        memcpy(&((Program*) context->m_Program)->m_Registers[base_register], data, sizeof(Vector4));
     }
 
     static void NullSetConstantM4(HContext context, const Vector4* data, int base_register)
     {
         assert(context);
         assert(context->m_Program != 0x0);
-        memcpy(&context->m_ProgramRegisters[base_register], data, sizeof(Vector4) * 4);
+        memcpy(&((Program*) context->m_Program)->m_Registers[base_register], data, sizeof(Vector4) * 4);
     }
 
     static void NullSetSampler(HContext context, int32_t location, int32_t unit)
@@ -962,6 +1029,11 @@ namespace dmGraphics
         return (context->m_TextureFormatSupport & (1 << format)) != 0;
     }
 
+    static bool NullIsTextureTypeSupported(HContext context, TextureType type)
+    {
+        return true;
+    }
+
     static uint32_t NullGetMaxTextureSize(HContext context)
     {
         return 1024;
@@ -974,6 +1046,7 @@ namespace dmGraphics
         tex->m_Type = params.m_Type;
         tex->m_Width = params.m_Width;
         tex->m_Height = params.m_Height;
+        tex->m_Depth = params.m_Type == TEXTURE_TYPE_2D_ARRAY ? dmMath::Max((uint16_t)1, params.m_Depth) : 1;
         tex->m_MipMapCount = 0;
         tex->m_Data = 0;
 
@@ -1019,17 +1092,35 @@ namespace dmGraphics
         assert(texture);
         assert(!params.m_SubUpdate || (params.m_X + params.m_Width <= texture->m_Width));
         assert(!params.m_SubUpdate || (params.m_Y + params.m_Height <= texture->m_Height));
+        assert(texture->m_Type != TEXTURE_TYPE_2D_ARRAY || (params.m_Z + params.m_Depth <= texture->m_Depth));
 
         if (texture->m_Data != 0x0)
             delete [] (char*)texture->m_Data;
         texture->m_Format = params.m_Format;
+        uint32_t data_size = texture->m_Type == TEXTURE_TYPE_2D_ARRAY ? params.m_DataSize * params.m_Depth : params.m_DataSize;
         // Allocate even for 0x0 size so that the rendertarget dummies will work.
-        texture->m_Data = new char[params.m_DataSize];
+        texture->m_Data = new char[data_size];
         if (params.m_Data != 0x0)
-            memcpy(texture->m_Data, params.m_Data, params.m_DataSize);
+            memcpy(texture->m_Data, params.m_Data, data_size);
         texture->m_MipMapCount = dmMath::Max(texture->m_MipMapCount, (uint16_t)(params.m_MipMap+1));
     }
 
+    static bool NullGenerateMipMaps(HTexture texture)
+    {
+        assert(texture);
+        if (texture->m_Type != TEXTURE_TYPE_2D || IsTextureFormatCompressed(texture->m_Format))
+        {
+            return false;
+        }
+        uint16_t mipmap_count = 1;
+        for (uint32_t size = dmMath::Max(texture->m_Width, texture->m_Height); size > 1; size >>= 1)
+        {
+            ++mipmap_count;
+        }
+        texture->m_MipMapCount = mipmap_count;
+        return true;
+    }
+
     // Not used?
     uint8_t* GetTextureData(HTexture texture)
     {
@@ -1049,7 +1140,7 @@ namespace dmGraphics
         {
             size_total *= 6;
         }
-        return size_total + sizeof(Texture);
+        return size_total * texture->m_Depth + sizeof(Texture);
     }
 
     static uint16_t NullGetTextureWidth(HTexture texture)
@@ -1062,6 +1153,11 @@ namespace dmGraphics
         return texture->m_Height;
     }
 
+    static uint16_t NullGetTextureDepth(HTexture texture)
+    {
+        return texture->m_Depth;
+    }
+
     static uint16_t NullGetOriginalTextureWidth(HTexture texture)
     {
         return texture->m_OriginalWidth;
@@ -1231,6 +1327,9 @@ namespace dmGraphics
         fn_table.m_BeginFrame = NullBeginFrame;
         fn_table.m_Flip = NullFlip;
         fn_table.m_SetSwapInterval = NullSetSwapInterval;
+        fn_table.m_SetJobContext = NullSetJobContext;
+        fn_table.m_BeginGpuTimer = NullBeginGpuTimer;
+        fn_table.m_EndGpuTimer = NullEndGpuTimer;
         fn_table.m_Clear = NullClear;
         fn_table.m_NewVertexBuffer = NullNewVertexBuffer;
         fn_table.m_DeleteVertexBuffer = NullDeleteVertexBuffer;
@@ -1256,6 +1355,11 @@ namespace dmGraphics
         fn_table.m_HashVertexDeclaration = NullHashVertexDeclaration;
         fn_table.m_DrawElements = NullDrawElements;
         fn_table.m_Draw = NullDraw;
+        fn_table.m_IsInstancingSupported = NullIsInstancingSupported;
+        fn_table.m_EnableInstanceVertexDeclaration = NullEnableInstanceVertexDeclaration;
+        fn_table.m_DisableInstanceVertexDeclaration = NullDisableInstanceVertexDeclaration;
+        fn_table.m_DrawElementsInstanced = NullDrawElementsInstanced;
+        fn_table.m_DrawInstanced = NullDrawInstanced;
         fn_table.m_NewVertexProgram = NullNewVertexProgram;
         fn_table.m_NewFragmentProgram = NullNewFragmentProgram;
         fn_table.m_NewProgram = NullNewProgram;
@@ -1294,14 +1398,17 @@ namespace dmGraphics
         fn_table.m_GetRenderTargetSize = NullGetRenderTargetSize;
         fn_table.m_SetRenderTargetSize = NullSetRenderTargetSize;
         fn_table.m_IsTextureFormatSupported = NullIsTextureFormatSupported;
+        fn_table.m_IsTextureTypeSupported = NullIsTextureTypeSupported;
         fn_table.m_NewTexture = NullNewTexture;
         fn_table.m_DeleteTexture = NullDeleteTexture;
         fn_table.m_SetTexture = NullSetTexture;
         fn_table.m_SetTextureAsync = NullSetTextureAsync;
+        fn_table.m_GenerateMipMaps = NullGenerateMipMaps;
         fn_table.m_SetTextureParams = NullSetTextureParams;
         fn_table.m_GetTextureResourceSize = NullGetTextureResourceSize;
         fn_table.m_GetTextureWidth = NullGetTextureWidth;
         fn_table.m_GetTextureHeight = NullGetTextureHeight;
+        fn_table.m_GetTextureDepth = NullGetTextureDepth;
         fn_table.m_GetOriginalTextureWidth = NullGetOriginalTextureWidth;
         fn_table.m_GetOriginalTextureHeight = NullGetOriginalTextureHeight;
         fn_table.m_EnableTexture = NullEnableTexture;
@@ -24,6 +24,7 @@ namespace dmGraphics
         uint32_t m_Height;
         uint32_t m_OriginalWidth;
         uint32_t m_OriginalHeight;
+        uint16_t m_Depth;
         uint16_t m_MipMapCount;
     };
 
@@ -81,11 +82,14 @@ namespace dmGraphics
         Context(const ContextParams& params);
 
         VertexStream                m_VertexStreams[MAX_VERTEX_STREAM_COUNT];
-        Vectormath::Aos::Vector4    m_ProgramRegisters[MAX_REGISTER_COUNT];
         HTexture                    m_Textures[MAX_TEXTURE_COUNT];
         FrameBuffer                 m_MainFrameBuffer;
         FrameBuffer*                m_CurrentFrameBuffer;
         void*                       m_Program;
+        /// Per instance data enabled with EnableInstanceVertexDeclaration()
+        const char*                 m_InstanceData;
+        uint32_t                    m_InstanceDataSize;
+        uint32_t                    m_InstanceStride;
         WindowResizeCallback        m_WindowResizeCallback;
         void*                       m_WindowResizeCallbackUserData;
         WindowCloseCallback         m_WindowCloseCallback;
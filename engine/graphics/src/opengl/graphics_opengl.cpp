@@ -23,6 +23,7 @@
 #include <dlib/index_pool.h>
 #include <dlib/time.h>
 #include <dlib/dstrings.h>
+#include <dlib/sys.h>
 
 #ifdef __EMSCRIPTEN__
     #include <emscripten/emscripten.h>
@@ -338,8 +339,11 @@ static void LogFrameBufferError(GLenum status)
     };
     dmArray<TextureParamsAsync> g_TextureParamsAsyncArray;
     dmIndexPool16 g_TextureParamsAsyncArrayIndices;
+    // Uploads waiting for the main thread when there is no worker thread, in submission order
+    dmArray<TextureParamsAsync> g_PendingTextureUploads;
     dmArray<HTexture> g_PostDeleteTexturesArray;
     static void PostDeleteTextures(bool);
+    static void DoSetTexture(HTexture texture, const TextureParams& params);
 
     extern BufferType BUFFER_TYPES[MAX_BUFFER_TYPE_COUNT];
     extern GLenum TEXTURE_UNIT_NAMES[32];
@@ -348,9 +352,136 @@ static void LogFrameBufferError(GLenum status)
     // The alternative is a matrix of conditional typedefs, linked statically/dynamically or core. OpenGL function prototypes does not change, so this is safe.
     typedef void (* DM_PFNGLINVALIDATEFRAMEBUFFERPROC) (GLenum target, GLsizei numAttachments, const GLenum *attachments);
     DM_PFNGLINVALIDATEFRAMEBUFFERPROC PFN_glInvalidateFramebuffer = NULL;
+    typedef void (* DM_PFNGLVERTEXATTRIBDIVISORPROC) (GLuint index, GLuint divisor);
+    DM_PFNGLVERTEXATTRIBDIVISORPROC PFN_glVertexAttribDivisor = NULL;
+    typedef void (* DM_PFNGLDRAWELEMENTSINSTANCEDPROC) (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instance_count);
+    DM_PFNGLDRAWELEMENTSINSTANCEDPROC PFN_glDrawElementsInstanced = NULL;
+    typedef void (* DM_PFNGLDRAWARRAYSINSTANCEDPROC) (GLenum mode, GLint first, GLsizei count, GLsizei instance_count);
+    DM_PFNGLDRAWARRAYSINSTANCEDPROC PFN_glDrawArraysInstanced = NULL;
+    typedef void (* DM_PFNGLTEXIMAGE3DPROC) (GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels);
+    DM_PFNGLTEXIMAGE3DPROC PFN_glTexImage3D = NULL;
+    typedef void (* DM_PFNGLTEXSUBIMAGE3DPROC) (GLenum target, GLint level, GLint x, GLint y, GLint z, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels);
+    DM_PFNGLTEXSUBIMAGE3DPROC PFN_glTexSubImage3D = NULL;
+    typedef void (* DM_PFNGLCOMPRESSEDTEXIMAGE3DPROC) (GLenum target, GLint level, GLenum internal_format, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLsizei image_size, const void* data);
+    DM_PFNGLCOMPRESSEDTEXIMAGE3DPROC PFN_glCompressedTexImage3D = NULL;
+    typedef void (* DM_PFNGLCOMPRESSEDTEXSUBIMAGE3DPROC) (GLenum target, GLint level, GLint x, GLint y, GLint z, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLsizei image_size, const void* data);
+    DM_PFNGLCOMPRESSEDTEXSUBIMAGE3DPROC PFN_glCompressedTexSubImage3D = NULL;
+    typedef void (* DM_PFNGLGETPROGRAMBINARYPROC) (GLuint program, GLsizei buf_size, GLsizei* length, GLenum* binary_format, void* binary);
+    DM_PFNGLGETPROGRAMBINARYPROC PFN_glGetProgramBinary = NULL;
+    typedef void (* DM_PFNGLPROGRAMBINARYPROC) (GLuint program, GLenum binary_format, const void* binary, GLsizei length);
+    DM_PFNGLPROGRAMBINARYPROC PFN_glProgramBinary = NULL;
+    typedef void (* DM_PFNGLGENQUERIESPROC) (GLsizei n, GLuint* ids);
+    DM_PFNGLGENQUERIESPROC PFN_glGenQueries = NULL;
+    typedef void (* DM_PFNGLDELETEQUERIESPROC) (GLsizei n, const GLuint* ids);
+    DM_PFNGLDELETEQUERIESPROC PFN_glDeleteQueries = NULL;
+    typedef void (* DM_PFNGLQUERYCOUNTERPROC) (GLuint id, GLenum target);
+    DM_PFNGLQUERYCOUNTERPROC PFN_glQueryCounter = NULL;
+    typedef void (* DM_PFNGLGETQUERYOBJECTIVPROC) (GLuint id, GLenum pname, GLint* params);
+    DM_PFNGLGETQUERYOBJECTIVPROC PFN_glGetQueryObjectiv = NULL;
+    typedef void (* DM_PFNGLGETQUERYOBJECTUI64VPROC) (GLuint id, GLenum pname, uint64_t* params);
+    DM_PFNGLGETQUERYOBJECTUI64VPROC PFN_glGetQueryObjectui64v = NULL;
+    typedef void (* DM_PFNGLGENVERTEXARRAYSPROC) (GLsizei n, GLuint* arrays);
+    DM_PFNGLGENVERTEXARRAYSPROC PFN_glGenVertexArrays = NULL;
+    typedef void (* DM_PFNGLBINDVERTEXARRAYPROC) (GLuint array);
+    DM_PFNGLBINDVERTEXARRAYPROC PFN_glBindVertexArray = NULL;
+    typedef void (* DM_PFNGLDELETEVERTEXARRAYSPROC) (GLsizei n, const GLuint* arrays);
+    DM_PFNGLDELETEVERTEXARRAYSPROC PFN_glDeleteVertexArrays = NULL;
+    typedef void (* DM_PFNGLGENERATEMIPMAPPROC) (GLenum target);
+    DM_PFNGLGENERATEMIPMAPPROC PFN_glGenerateMipmap = NULL;
 
     Context* g_Context = 0x0;
 
+    // Returns true if the value differs from the cached one, i.e. the GL call needs to be issued
+    static inline bool UpdateStateCache(uint32_t& cached, uint32_t value)
+    {
+        if (cached == value)
+        {
+            DM_COUNTER("SkippedStateChanges", 1);
+            return false;
+        }
+        cached = value;
+        DM_COUNTER("StateChanges", 1);
+        return true;
+    }
+
+    // Must be called on the main thread when a texture has been bound to the active unit outside of EnableTexture
+    static void InvalidateActiveTextureUnit(Context* context)
+    {
+        StateCache& cache = context->m_StateCache;
+        if (cache.m_ActiveTextureUnit < STATE_CACHE_MAX_TEXTURE_UNITS)
+        {
+            cache.m_Textures[cache.m_ActiveTextureUnit] = STATE_CACHE_UNKNOWN;
+        }
+        else
+        {
+            memset(cache.m_Textures, 0xFF, sizeof(cache.m_Textures));
+        }
+    }
+
+    static inline void BindVertexArray(Context* context, GLuint vertex_array)
+    {
+        if (context->m_BoundVertexArray != vertex_array)
+        {
+            PFN_glBindVertexArray(vertex_array);
+            CHECK_GL_ERROR;
+            context->m_BoundVertexArray = vertex_array;
+        }
+    }
+
+    static void DeleteVertexArrayCb(Context* context, const uint64_t* key, VertexArray* vertex_array)
+    {
+        PFN_glDeleteVertexArrays(1, &vertex_array->m_VertexArray);
+    }
+
+    // Deletes all cached vertex arrays and makes the default vertex array current
+    static void FlushVertexArrays(Context* context)
+    {
+        if (!context->m_VertexArraySupport)
+        {
+            return;
+        }
+        BindVertexArray(context, context->m_DefaultVertexArray);
+        context->m_VertexArrays.Iterate(DeleteVertexArrayCb, context);
+        context->m_VertexArrays.Clear();
+        CHECK_GL_ERROR;
+    }
+
+    struct EvictVertexArraysContext
+    {
+        uint64_t m_Keys[MAX_VERTEX_ARRAYS];
+        uint32_t m_Count;
+        GLuint   m_VertexBuffer;
+    };
+
+    static void EvictVertexArrayCb(EvictVertexArraysContext* ctx, const uint64_t* key, VertexArray* vertex_array)
+    {
+        if (vertex_array->m_VertexBuffer == ctx->m_VertexBuffer)
+        {
+            PFN_glDeleteVertexArrays(1, &vertex_array->m_VertexArray);
+            ctx->m_Keys[ctx->m_Count++] = *key;
+        }
+    }
+
+    // Must be called before a vertex buffer is deleted, since the buffer name may be reused
+    // while the cached vertex arrays still reference the old buffer
+    static void EvictVertexArrays(Context* context, GLuint vertex_buffer)
+    {
+        if (!context->m_VertexArraySupport || context->m_VertexArrays.Empty())
+        {
+            return;
+        }
+        BindVertexArray(context, context->m_DefaultVertexArray);
+        EvictVertexArraysContext ctx;
+        ctx.m_Count = 0;
+        ctx.m_VertexBuffer = vertex_buffer;
+        context->m_VertexArrays.Iterate(EvictVertexArrayCb, &ctx);
+        for (uint32_t i = 0; i < ctx.m_Count; ++i)
+        {
+            context->m_VertexArrays.Erase(ctx.m_Keys[i]);
+        }
+        CHECK_GL_ERROR;
+    }
+
     Context::Context(const ContextParams& params)
     {
         memset(this, 0, sizeof(*this));
@@ -359,6 +490,12 @@ static void LogFrameBufferError(GLenum status)
         m_RenderDocSupport        = params.m_RenderDocSupport;
         m_DefaultTextureMinFilter = params.m_DefaultTextureMinFilter;
         m_DefaultTextureMagFilter = params.m_DefaultTextureMagFilter;
+        m_TextureUploadBudget     = params.m_TextureUploadBudget;
+        if (params.m_PipelineCacheDirectory)
+        {
+            dmStrlCpy(m_ProgramCacheDirectory, params.m_PipelineCacheDirectory, sizeof(m_ProgramCacheDirectory));
+        }
+        InvalidateStateCache(m_StateCache);
         // Formats supported on all platforms
         m_TextureFormatSupport |= 1 << TEXTURE_FORMAT_LUMINANCE;
         m_TextureFormatSupport |= 1 << TEXTURE_FORMAT_LUMINANCE_ALPHA;
@@ -420,6 +557,7 @@ static void LogFrameBufferError(GLenum status)
             GL_FLOAT_MAT4,
             GL_SAMPLER_2D,
             GL_SAMPLER_CUBE,
+            DMGRAPHICS_SAMPLER_2D_ARRAY,
         };
         return type_lut[type];
     }
@@ -450,6 +588,8 @@ static void LogFrameBufferError(GLenum status)
                 return TYPE_SAMPLER_2D;
             case GL_SAMPLER_CUBE:
                 return TYPE_SAMPLER_CUBE;
+            case DMGRAPHICS_SAMPLER_2D_ARRAY:
+                return TYPE_SAMPLER_2D_ARRAY;
             default:break;
         }
 
@@ -466,6 +606,10 @@ static void LogFrameBufferError(GLenum status)
         {
             return GL_TEXTURE_CUBE_MAP;
         }
+        else if (type == TEXTURE_TYPE_2D_ARRAY)
+        {
+            return DMGRAPHICS_TEXTURE_2D_ARRAY;
+        }
 
         return GL_FALSE;
     }
@@ -622,6 +766,224 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
     if (function == 0x0)\
         function = (type) GetExtProcAddress(name, extension_name, core_name, extensions);
 
+    // The program binary cache file starts with a ProgramBinaryCacheHeader, followed by
+    // m_Count ProgramBinaryCacheEntry headers, each directly followed by the binary data.
+    static const char*    PROGRAM_BINARY_CACHE_FILE_NAME    = "gl_program_cache.bin";
+    static const uint32_t PROGRAM_BINARY_CACHE_MAGIC        = 0x43504c47; // "GLPC"
+    static const uint32_t PROGRAM_BINARY_CACHE_VERSION      = 1;
+    // Frames to wait after the last new program before the cache is written, so that
+    // a level load writes the file once instead of once per material
+    static const uint32_t PROGRAM_BINARY_CACHE_SAVE_FRAMES  = 120;
+
+    struct ProgramBinaryCacheHeader
+    {
+        uint32_t m_Magic;
+        uint32_t m_Version;
+        uint64_t m_DriverHash;
+        uint32_t m_Count;
+        uint32_t m_Reserved;
+    };
+
+    struct ProgramBinaryCacheEntry
+    {
+        uint64_t m_Key;
+        uint64_t m_VertexSourceHash;
+        uint64_t m_FragmentSourceHash;
+        uint32_t m_Format;
+        uint32_t m_Size;
+    };
+
+    static uint64_t GetDriverHash()
+    {
+        // A binary is only guaranteed to load on the exact driver that created it
+        const char* strings[] = { (const char*) glGetString(GL_VENDOR), (const char*) glGetString(GL_RENDERER), (const char*) glGetString(GL_VERSION) };
+        HashState64 hash_state;
+        dmHashInit64(&hash_state, false);
+        for (uint32_t i = 0; i < sizeof(strings) / sizeof(strings[0]); ++i)
+        {
+            if (strings[i])
+            {
+                dmHashUpdateBuffer64(&hash_state, strings[i], strlen(strings[i]));
+            }
+        }
+        return dmHashFinal64(&hash_state);
+    }
+
+    static void AddProgramBinary(HContext context, uint64_t key, const ProgramBinary& binary)
+    {
+        if (context->m_ProgramBinaries.Full())
+        {
+            uint32_t capacity = context->m_ProgramBinaries.Capacity() + 32;
+            context->m_ProgramBinaries.SetCapacity(dmMath::Max(capacity / 2, 16U), capacity);
+        }
+        context->m_ProgramBinaries.Put(key, binary);
+
+        uint64_t source_hashes[] = { binary.m_VertexSourceHash, binary.m_FragmentSourceHash };
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            uint32_t* count = context->m_CachedShaderSourceHashes.Get(source_hashes[i]);
+            if (count)
+            {
+                ++*count;
+                continue;
+            }
+            if (context->m_CachedShaderSourceHashes.Full())
+            {
+                uint32_t capacity = context->m_CachedShaderSourceHashes.Capacity() + 64;
+                context->m_CachedShaderSourceHashes.SetCapacity(dmMath::Max(capacity / 2, 16U), capacity);
+            }
+            context->m_CachedShaderSourceHashes.Put(source_hashes[i], 1);
+        }
+    }
+
+    static void EraseProgramBinary(HContext context, uint64_t key)
+    {
+        ProgramBinary* binary = context->m_ProgramBinaries.Get(key);
+        uint64_t source_hashes[] = { binary->m_VertexSourceHash, binary->m_FragmentSourceHash };
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            uint32_t* count = context->m_CachedShaderSourceHashes.Get(source_hashes[i]);
+            if (count && --*count == 0)
+            {
+                context->m_CachedShaderSourceHashes.Erase(source_hashes[i]);
+            }
+        }
+        free(binary->m_Data);
+        context->m_ProgramBinaries.Erase(key);
+    }
+
+    static void FreeProgramBinaryCb(HContext context, const uint64_t* key, ProgramBinary* binary)
+    {
+        free(binary->m_Data);
+    }
+
+    static void DeleteProgramBinaries(HContext context)
+    {
+        context->m_ProgramBinaries.Iterate(FreeProgramBinaryCb, context);
+        context->m_ProgramBinaries.Clear();
+        context->m_CachedShaderSourceHashes.Clear();
+        context->m_Shaders.Clear();
+    }
+
+    static void MarkProgramBinariesChanged(HContext context)
+    {
+        context->m_ProgramBinariesChanged       = 1;
+        context->m_ProgramBinaryCacheSaveFrames = PROGRAM_BINARY_CACHE_SAVE_FRAMES;
+    }
+
+    static void LoadProgramBinaryCache(HContext context)
+    {
+        context->m_DriverHash = GetDriverHash();
+
+        char path[DMPATH_MAX_PATH];
+        dmSnPrintf(path, sizeof(path), "%s/%s", context->m_ProgramCacheDirectory, PROGRAM_BINARY_CACHE_FILE_NAME);
+        FILE* file = fopen(path, "rb");
+        if (!file)
+        {
+            return;
+        }
+
+        ProgramBinaryCacheHeader header;
+        if (fread(&header, 1, sizeof(header), file) != sizeof(header) ||
+            header.m_Magic != PROGRAM_BINARY_CACHE_MAGIC ||
+            header.m_Version != PROGRAM_BINARY_CACHE_VERSION ||
+            header.m_DriverHash != context->m_DriverHash)
+        {
+            // Written by another driver or engine version. Programs are linked from source
+            // and the file is replaced the next time the cache is saved.
+            dmLogInfo("Discarding program binary cache '%s'", path);
+            fclose(file);
+            return;
+        }
+
+        for (uint32_t i = 0; i < header.m_Count; ++i)
+        {
+            ProgramBinaryCacheEntry entry;
+            if (fread(&entry, 1, sizeof(entry), file) != sizeof(entry))
+            {
+                break;
+            }
+
+            ProgramBinary binary;
+            binary.m_VertexSourceHash   = entry.m_VertexSourceHash;
+            binary.m_FragmentSourceHash = entry.m_FragmentSourceHash;
+            binary.m_Format             = entry.m_Format;
+            binary.m_Size               = entry.m_Size;
+            binary.m_Data               = (uint8_t*) malloc(entry.m_Size);
+            if (fread(binary.m_Data, 1, entry.m_Size, file) != entry.m_Size)
+            {
+                free(binary.m_Data);
+                break;
+            }
+
+            if (context->m_ProgramBinaries.Get(entry.m_Key))
+            {
+                free(binary.m_Data);
+                continue;
+            }
+            AddProgramBinary(context, entry.m_Key, binary);
+        }
+
+        fclose(file);
+    }
+
+    struct SaveProgramBinaryContext
+    {
+        FILE* m_File;
+        bool  m_Ok;
+    };
+
+    static void SaveProgramBinaryCb(SaveProgramBinaryContext* ctx, const uint64_t* key, ProgramBinary* binary)
+    {
+        ProgramBinaryCacheEntry entry;
+        entry.m_Key                = *key;
+        entry.m_VertexSourceHash   = binary->m_VertexSourceHash;
+        entry.m_FragmentSourceHash = binary->m_FragmentSourceHash;
+        entry.m_Format             = binary->m_Format;
+        entry.m_Size               = binary->m_Size;
+        ctx->m_Ok = ctx->m_Ok &&
+                    fwrite(&entry, 1, sizeof(entry), ctx->m_File) == sizeof(entry) &&
+                    fwrite(binary->m_Data, 1, binary->m_Size, ctx->m_File) == binary->m_Size;
+    }
+
+    static void SaveProgramBinaryCache(HContext context)
+    {
+        DM_PROFILE(Graphics, "SaveProgramBinaryCache");
+        context->m_ProgramBinariesChanged = 0;
+
+        char path[DMPATH_MAX_PATH];
+        char tmp_path[DMPATH_MAX_PATH];
+        dmSnPrintf(path, sizeof(path), "%s/%s", context->m_ProgramCacheDirectory, PROGRAM_BINARY_CACHE_FILE_NAME);
+        dmSnPrintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+        // Written to a temporary file first, so that a crash while writing never leaves a truncated cache behind
+        FILE* file = fopen(tmp_path, "wb");
+        if (!file)
+        {
+            dmLogWarning("Unable to write program binary cache to '%s'", path);
+            return;
+        }
+
+        ProgramBinaryCacheHeader header;
+        header.m_Magic      = PROGRAM_BINARY_CACHE_MAGIC;
+        header.m_Version    = PROGRAM_BINARY_CACHE_VERSION;
+        header.m_DriverHash = context->m_DriverHash;
+        header.m_Count      = context->m_ProgramBinaries.Size();
+        header.m_Reserved   = 0;
+
+        SaveProgramBinaryContext ctx;
+        ctx.m_File = file;
+        ctx.m_Ok   = fwrite(&header, 1, sizeof(header), file) == sizeof(header);
+        context->m_ProgramBinaries.Iterate(SaveProgramBinaryCb, &ctx);
+        ctx.m_Ok = fclose(file) == 0 && ctx.m_Ok;
+
+        if (!ctx.m_Ok || dmSys::RenameFile(path, tmp_path) != dmSys::RESULT_OK)
+        {
+            dmLogWarning("Unable to write program binary cache to '%s'", path);
+            dmSys::Unlink(tmp_path);
+        }
+    }
+
     static bool ValidateAsyncJobProcessing(HContext context)
     {
         // Test async texture access
@@ -940,6 +1302,81 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         }
 
         DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glInvalidateFramebuffer, "glDiscardFramebuffer", "discard_framebuffer", "glInvalidateFramebuffer", DM_PFNGLINVALIDATEFRAMEBUFFERPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glVertexAttribDivisor, "glVertexAttribDivisor", "instanced_arrays", "glVertexAttribDivisor", DM_PFNGLVERTEXATTRIBDIVISORPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawElementsInstanced, "glDrawElementsInstanced", "draw_instanced", "glDrawElementsInstanced", DM_PFNGLDRAWELEMENTSINSTANCEDPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawArraysInstanced, "glDrawArraysInstanced", "draw_instanced", "glDrawArraysInstanced", DM_PFNGLDRAWARRAYSINSTANCEDPROC, extensions);
+        context->m_InstancingSupport = PFN_glVertexAttribDivisor != 0x0 && PFN_glDrawElementsInstanced != 0x0 && PFN_glDrawArraysInstanced != 0x0;
+
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGenVertexArrays, "glGenVertexArrays", "vertex_array_object", "glGenVertexArrays", DM_PFNGLGENVERTEXARRAYSPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glBindVertexArray, "glBindVertexArray", "vertex_array_object", "glBindVertexArray", DM_PFNGLBINDVERTEXARRAYPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDeleteVertexArrays, "glDeleteVertexArrays", "vertex_array_object", "glDeleteVertexArrays", DM_PFNGLDELETEVERTEXARRAYSPROC, extensions);
+#if defined(GL_ES_VERSION_2_0)
+        // Vertex arrays are core in GLES 3, which isn't covered by the extension lookup above
+        if (context->m_IsGles3Version && PFN_glGenVertexArrays == 0x0)
+        {
+            PFN_glGenVertexArrays = (DM_PFNGLGENVERTEXARRAYSPROC) glfwGetProcAddress("glGenVertexArrays");
+            PFN_glBindVertexArray = (DM_PFNGLBINDVERTEXARRAYPROC) glfwGetProcAddress("glBindVertexArray");
+            PFN_glDeleteVertexArrays = (DM_PFNGLDELETEVERTEXARRAYSPROC) glfwGetProcAddress("glDeleteVertexArrays");
+        }
+#endif
+        // GLES 2 keeps setting up the attributes for each draw
+        context->m_VertexArraySupport = context->m_IsGles3Version && PFN_glGenVertexArrays != 0x0 && PFN_glBindVertexArray != 0x0 && PFN_glDeleteVertexArrays != 0x0;
+        if (context->m_VertexArraySupport && context->m_VertexArrays.Capacity() == 0)
+        {
+            context->m_VertexArrays.SetCapacity(MAX_VERTEX_ARRAYS / 2, MAX_VERTEX_ARRAYS);
+        }
+
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glTexImage3D, "glTexImage3D", "texture_3D", "glTexImage3D", DM_PFNGLTEXIMAGE3DPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glTexSubImage3D, "glTexSubImage3D", "texture_3D", "glTexSubImage3D", DM_PFNGLTEXSUBIMAGE3DPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glCompressedTexImage3D, "glCompressedTexImage3D", "texture_3D", "glCompressedTexImage3D", DM_PFNGLCOMPRESSEDTEXIMAGE3DPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glCompressedTexSubImage3D, "glCompressedTexSubImage3D", "texture_3D", "glCompressedTexSubImage3D", DM_PFNGLCOMPRESSEDTEXSUBIMAGE3DPROC, extensions);
+        // 2D array textures have no entry points of their own, they are uploaded with the 3D texture functions
+        context->m_TextureArraySupport = PFN_glTexImage3D != 0x0 && PFN_glTexSubImage3D != 0x0 && PFN_glCompressedTexImage3D != 0x0 && PFN_glCompressedTexSubImage3D != 0x0;
+
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGenerateMipmap, "glGenerateMipmap", "framebuffer_object", "glGenerateMipmap", DM_PFNGLGENERATEMIPMAPPROC, extensions);
+#if defined(GL_ES_VERSION_2_0)
+        // Core in GLES 2, which isn't covered by the extension lookup above
+        if (PFN_glGenerateMipmap == 0x0)
+        {
+            PFN_glGenerateMipmap = (DM_PFNGLGENERATEMIPMAPPROC) glfwGetProcAddress("glGenerateMipmap");
+        }
+#endif
+
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGetProgramBinary, "glGetProgramBinary", "get_program_binary", "glGetProgramBinary", DM_PFNGLGETPROGRAMBINARYPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glProgramBinary, "glProgramBinary", "get_program_binary", "glProgramBinary", DM_PFNGLPROGRAMBINARYPROC, extensions);
+        if (context->m_ProgramCacheDirectory[0] && PFN_glGetProgramBinary != 0x0 && PFN_glProgramBinary != 0x0)
+        {
+            // Some drivers expose the extension without supporting a single binary format
+            GLint num_binary_formats = 0;
+            glGetIntegerv(DMGRAPHICS_NUM_PROGRAM_BINARY_FORMATS, &num_binary_formats);
+            context->m_ProgramBinarySupport = num_binary_formats > 0;
+            if (context->m_ProgramBinarySupport)
+            {
+                LoadProgramBinaryCache(context);
+            }
+        }
+
+        // Timestamp queries are core in GL 3.3, and an extension on GLES
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGenQueries, "glGenQueries", "disjoint_timer_query", "glGenQueries", DM_PFNGLGENQUERIESPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDeleteQueries, "glDeleteQueries", "disjoint_timer_query", "glDeleteQueries", DM_PFNGLDELETEQUERIESPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glQueryCounter, "glQueryCounter", "disjoint_timer_query", "glQueryCounter", DM_PFNGLQUERYCOUNTERPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGetQueryObjectiv, "glGetQueryObjectiv", "disjoint_timer_query", "glGetQueryObjectiv", DM_PFNGLGETQUERYOBJECTIVPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGetQueryObjectui64v, "glGetQueryObjectui64v", "disjoint_timer_query", "glGetQueryObjectui64v", DM_PFNGLGETQUERYOBJECTUI64VPROC, extensions);
+        context->m_GpuTimerDisjointCheck = IsExtensionSupported("GL_EXT_disjoint_timer_query", extensions);
+        // The core function names resolve on drivers without the feature, so the extension must be listed as well
+        context->m_GpuTimerSupport = (context->m_GpuTimerDisjointCheck || IsExtensionSupported("GL_ARB_timer_query", extensions)) &&
+                                     PFN_glGenQueries != 0x0 && PFN_glDeleteQueries != 0x0 && PFN_glQueryCounter != 0x0 &&
+                                     PFN_glGetQueryObjectiv != 0x0 && PFN_glGetQueryObjectui64v != 0x0;
+        if (context->m_GpuTimerSupport)
+        {
+            context->m_GpuTimerFrames = new GpuTimerFrame[GPU_TIMER_FRAME_COUNT];
+            for (uint32_t i = 0; i < GPU_TIMER_FRAME_COUNT; ++i)
+            {
+                PFN_glGenQueries(MAX_GPU_TIMERS * 2, context->m_GpuTimerFrames[i].m_Queries);
+                context->m_GpuTimerFrames[i].m_Count = 0;
+            }
+            CHECK_GL_ERROR;
+        }
 
         if (IsExtensionSupported("GL_IMG_texture_compression_pvrtc", extensions) ||
             IsExtensionSupported("WEBGL_compressed_texture_pvrtc", extensions))
@@ -1109,9 +1546,14 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             GLuint vao;
             glGenVertexArrays(1, &vao);
             glBindVertexArray(vao);
+            context->m_DefaultVertexArray = vao;
+            context->m_BoundVertexArray = vao;
         }
 #endif
 
+        // The async validation above binds textures on the main context
+        InvalidateStateCache(context->m_StateCache);
+
         return WINDOW_RESULT_OK;
     }
 
@@ -1121,7 +1563,24 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         if (context->m_WindowOpened)
         {
             JobQueueFinalize();
+            g_PendingTextureUploads.SetSize(0);
             PostDeleteTextures(true);
+            if (context->m_ProgramBinariesChanged)
+            {
+                SaveProgramBinaryCache(context);
+            }
+            DeleteProgramBinaries(context);
+            FlushVertexArrays(context);
+            if (context->m_GpuTimerFrames)
+            {
+                for (uint32_t i = 0; i < GPU_TIMER_FRAME_COUNT; ++i)
+                {
+                    PFN_glDeleteQueries(MAX_GPU_TIMERS * 2, context->m_GpuTimerFrames[i].m_Queries);
+                }
+                delete [] context->m_GpuTimerFrames;
+                context->m_GpuTimerFrames = 0x0;
+                context->m_GpuTimerSupport = 0;
+            }
             glfwCloseWindow();
             context->m_WindowResizeCallback = 0x0;
             context->m_Width = 0;
@@ -1266,15 +1725,86 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         CHECK_GL_ERROR
     }
 
+    static void UploadPendingTextures(HContext context);
+
     static void OpenGLBeginFrame(HContext context)
     {
 #if defined(ANDROID)
         glfwAndroidBeginFrame();
 #endif
+        // Start each frame from a clean slate, in case the GL state was changed behind our back,
+        // e.g. by a native extension or a lost and recreated context
+        InvalidateStateCache(context->m_StateCache);
+        if (context->m_VertexArraySupport)
+        {
+            context->m_BoundVertexArray = STATE_CACHE_UNKNOWN;
+        }
+
+        if (g_PendingTextureUploads.Size() > 0)
+        {
+            UploadPendingTextures(context);
+        }
+    }
+
+    // Reads back the timers of the oldest frame slot, which is reused for the next frame
+    static void ReadGpuTimers(HContext context)
+    {
+        context->m_GpuTimerStarted = 0;
+        context->m_GpuTimerFrame = (context->m_GpuTimerFrame + 1) % GPU_TIMER_FRAME_COUNT;
+        GpuTimerFrame* frame = &context->m_GpuTimerFrames[context->m_GpuTimerFrame];
+        uint32_t count = frame->m_Count;
+        frame->m_Count = 0;
+        if (count == 0)
+        {
+            return;
+        }
+
+        // The queries complete in order, drop the frame rather than waiting for it
+        GLint available = 0;
+        PFN_glGetQueryObjectiv(frame->m_Queries[count * 2 - 1], DMGRAPHICS_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            return;
+        }
+
+        if (context->m_GpuTimerDisjointCheck)
+        {
+            GLint disjoint = 0;
+            glGetIntegerv(DMGRAPHICS_GPU_DISJOINT, &disjoint);
+            if (disjoint)
+            {
+                return;
+            }
+        }
+
+        uint64_t frame_start = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint64_t start = 0;
+            uint64_t end = 0;
+            PFN_glGetQueryObjectui64v(frame->m_Queries[i * 2], DMGRAPHICS_QUERY_RESULT, &start);
+            PFN_glGetQueryObjectui64v(frame->m_Queries[i * 2 + 1], DMGRAPHICS_QUERY_RESULT, &end);
+            if (i == 0)
+            {
+                frame_start = start;
+            }
+            dmProfile::AddGpuSample(frame->m_Names[i], frame->m_NameHashes[i], start - frame_start, end - start);
+        }
+        CHECK_GL_ERROR;
     }
 
     static void OpenGLFlip(HContext context)
     {
+        if (context->m_ProgramBinariesChanged && --context->m_ProgramBinaryCacheSaveFrames == 0)
+        {
+            SaveProgramBinaryCache(context);
+        }
+
+        if (context->m_GpuTimerSupport)
+        {
+            ReadGpuTimers(context);
+        }
+
         DM_PROFILE(VSync, "Wait");
         PostDeleteTextures(false);
         glfwSwapBuffers();
@@ -1286,6 +1816,45 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         glfwSwapInterval(swap_interval);
     }
 
+    static void OpenGLSetJobContext(HContext context, dmJob::HContext job_context)
+    {
+        // The GL context is only current on the main thread
+    }
+
+    static void OpenGLBeginGpuTimer(HContext context, const char* name, uint32_t name_hash)
+    {
+        if (!context->m_GpuTimerSupport || context->m_GpuTimerStarted)
+        {
+            return;
+        }
+
+        GpuTimerFrame* frame = &context->m_GpuTimerFrames[context->m_GpuTimerFrame];
+        if (frame->m_Count == MAX_GPU_TIMERS)
+        {
+            return;
+        }
+
+        PFN_glQueryCounter(frame->m_Queries[frame->m_Count * 2], DMGRAPHICS_TIMESTAMP);
+        CHECK_GL_ERROR;
+        frame->m_Names[frame->m_Count] = name;
+        frame->m_NameHashes[frame->m_Count] = name_hash;
+        context->m_GpuTimerStarted = 1;
+    }
+
+    static void OpenGLEndGpuTimer(HContext context)
+    {
+        if (!context->m_GpuTimerStarted)
+        {
+            return;
+        }
+
+        GpuTimerFrame* frame = &context->m_GpuTimerFrames[context->m_GpuTimerFrame];
+        PFN_glQueryCounter(frame->m_Queries[frame->m_Count * 2 + 1], DMGRAPHICS_TIMESTAMP);
+        CHECK_GL_ERROR;
+        frame->m_Count++;
+        context->m_GpuTimerStarted = 0;
+    }
+
     static GLenum GetOpenGLBufferUsage(BufferUsage buffer_usage)
     {
         const GLenum buffer_usage_lut[] = {
@@ -1317,6 +1886,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         if (!buffer)
             return;
         GLuint b = (GLuint) buffer;
+        EvictVertexArrays(g_Context, b);
         glDeleteBuffersARB(1, &b);
         CHECK_GL_ERROR;
     }
@@ -1421,10 +1991,27 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         return 0;
     }
 
+    static void UpdateLayoutHash(VertexDeclaration* vertex_declaration)
+    {
+        HashState32 state;
+        dmHashInit32(&state, false);
+        dmHashUpdateBuffer32(&state, &vertex_declaration->m_Stride, sizeof(vertex_declaration->m_Stride));
+        for (uint32_t i = 0; i < vertex_declaration->m_StreamCount; ++i)
+        {
+            VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
+            dmHashUpdateBuffer32(&state, &stream.m_Size, sizeof(stream.m_Size));
+            dmHashUpdateBuffer32(&state, &stream.m_Offset, sizeof(stream.m_Offset));
+            dmHashUpdateBuffer32(&state, &stream.m_Type, sizeof(stream.m_Type));
+            dmHashUpdateBuffer32(&state, &stream.m_Normalize, sizeof(stream.m_Normalize));
+        }
+        vertex_declaration->m_LayoutHash = dmHashFinal32(&state);
+    }
+
     static HVertexDeclaration OpenGLNewVertexDeclarationStride(HContext context, VertexElement* element, uint32_t count, uint32_t stride)
     {
         HVertexDeclaration vd = NewVertexDeclaration(context, element, count);
         vd->m_Stride = stride;
+        UpdateLayoutHash(vd);
         return vd;
     }
 
@@ -1449,6 +2036,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             vd->m_Stride += element[i].m_Size * GetTypeSize(element[i].m_Type);
         }
         vd->m_StreamCount = count;
+        UpdateLayoutHash(vd);
         return vd;
     }
 
@@ -1458,6 +2046,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             return false;
         }
         vertex_declaration->m_Streams[stream_index].m_Offset = offset;
+        UpdateLayoutHash(vertex_declaration);
         return true;
     }
 
@@ -1473,6 +2062,12 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         assert(vertex_declaration);
         #define BUFFER_OFFSET(i) ((char*)0x0 + (i))
 
+        // Logical indices aren't cached, the attributes are set up on the default vertex array
+        if (context->m_VertexArraySupport)
+        {
+            BindVertexArray(context, context->m_DefaultVertexArray);
+        }
+
         glBindBufferARB(GL_ARRAY_BUFFER, vertex_buffer);
         CHECK_GL_ERROR;
 
@@ -1517,6 +2112,69 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
 
         vertex_declaration->m_BoundForProgram = program;
         vertex_declaration->m_ModificationVersion = context->m_ModificationVersion;
+
+        HashState32 state;
+        dmHashInit32(&state, false);
+        for (uint32_t i=0; i < n; i++)
+        {
+            dmHashUpdateBuffer32(&state, &streams[i].m_PhysicalIndex, sizeof(streams[i].m_PhysicalIndex));
+        }
+        vertex_declaration->m_LocationHash = dmHashFinal32(&state);
+    }
+
+    static void EnableVertexStreams(VertexDeclaration* vertex_declaration)
+    {
+        #define BUFFER_OFFSET(i) ((char*)0x0 + (i))
+
+        for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
+        {
+            if (vertex_declaration->m_Streams[i].m_PhysicalIndex != -1)
+            {
+                glEnableVertexAttribArray(vertex_declaration->m_Streams[i].m_PhysicalIndex);
+                CHECK_GL_ERROR;
+                glVertexAttribPointer(
+                        vertex_declaration->m_Streams[i].m_PhysicalIndex,
+                        vertex_declaration->m_Streams[i].m_Size,
+                        GetOpenGLType(vertex_declaration->m_Streams[i].m_Type),
+                        vertex_declaration->m_Streams[i].m_Normalize,
+                        vertex_declaration->m_Stride,
+                BUFFER_OFFSET(vertex_declaration->m_Streams[i].m_Offset) );   //The starting point of the VBO, for the vertices
+
+                CHECK_GL_ERROR;
+            }
+        }
+
+        #undef BUFFER_OFFSET
+    }
+
+    // Binds the vertex array with the attribute setup for the declaration, bound program and buffer.
+    // The program itself isn't part of the key, programs with the same attribute locations share vertex arrays.
+    static void BindCachedVertexArray(Context* context, VertexDeclaration* vertex_declaration, GLuint vertex_buffer)
+    {
+        uint32_t key_data[] = { vertex_declaration->m_LayoutHash, vertex_declaration->m_LocationHash, vertex_buffer };
+        uint64_t key = dmHashBuffer64(key_data, sizeof(key_data));
+        VertexArray* vertex_array = context->m_VertexArrays.Get(key);
+        if (vertex_array)
+        {
+            BindVertexArray(context, vertex_array->m_VertexArray);
+            return;
+        }
+
+        if (context->m_VertexArrays.Full())
+        {
+            FlushVertexArrays(context);
+        }
+
+        VertexArray new_vertex_array;
+        new_vertex_array.m_VertexBuffer = vertex_buffer;
+        PFN_glGenVertexArrays(1, &new_vertex_array.m_VertexArray);
+        CHECK_GL_ERROR;
+        BindVertexArray(context, new_vertex_array.m_VertexArray);
+
+        glBindBufferARB(GL_ARRAY_BUFFER, vertex_buffer);
+        CHECK_GL_ERROR;
+        EnableVertexStreams(vertex_declaration);
+        context->m_VertexArrays.Put(key, new_vertex_array);
     }
 
     static void OpenGLEnableVertexDeclarationProgram(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program)
@@ -1530,25 +2188,130 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             BindVertexDeclarationProgram(context, vertex_declaration, program);
         }
 
+        if (context->m_VertexArraySupport)
+        {
+            BindCachedVertexArray(context, vertex_declaration, vertex_buffer);
+            return;
+        }
+
+        glBindBufferARB(GL_ARRAY_BUFFER, vertex_buffer);
+        CHECK_GL_ERROR;
+
+        EnableVertexStreams(vertex_declaration);
+    }
+
+    static void OpenGLDisableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    {
+        assert(context);
+        assert(vertex_declaration);
+
+        if (context->m_BoundVertexArray != context->m_DefaultVertexArray)
+        {
+            // A cached vertex array keeps its attributes. The index buffer binding is part of the
+            // vertex array as well, and is cleared so that the vertex array doesn't keep the buffer alive.
+            glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+            CHECK_GL_ERROR;
+            BindVertexArray(context, context->m_DefaultVertexArray);
+            glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+            CHECK_GL_ERROR;
+            return;
+        }
+
+        for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
+        {
+            glDisableVertexAttribArray(i);
+            CHECK_GL_ERROR;
+        }
+
+        glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+        CHECK_GL_ERROR;
+
+        glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+        CHECK_GL_ERROR;
+    }
+
+    void OpenGLHashVertexDeclaration(HashState32 *state, HVertexDeclaration vertex_declaration)
+    {
+        uint16_t stream_count = vertex_declaration->m_StreamCount;
+        for (int i = 0; i < stream_count; ++i)
+        {
+            VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
+            // TODO: We might want to store a hash of the name already in the vertexdecl,
+            //       but currently the OpenGL implementation uses the string to find
+            //       correct uniform location (if I recall correctly).
+            dmHashUpdateBuffer32(state, stream.m_Name, strlen(stream.m_Name));
+            dmHashUpdateBuffer32(state, &stream.m_LogicalIndex, sizeof(stream.m_LogicalIndex));
+            dmHashUpdateBuffer32(state, &stream.m_Size, sizeof(stream.m_Size));
+            dmHashUpdateBuffer32(state, &stream.m_Offset, sizeof(stream.m_Offset));
+            dmHashUpdateBuffer32(state, &stream.m_Type, sizeof(stream.m_Type));
+            dmHashUpdateBuffer32(state, &stream.m_Normalize, sizeof(stream.m_Normalize));
+        }
+    }
+
+
+    static void OpenGLDrawElements(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer)
+    {
+        assert(context);
+        assert(index_buffer);
+        DM_PROFILE(Graphics, "DrawElements");
+        DM_COUNTER("DrawCalls", 1);
+
+        glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+        CHECK_GL_ERROR;
+
+        glDrawElements(GetOpenGLPrimitiveType(prim_type), count, GetOpenGLType(type), (GLvoid*)(uintptr_t) first);
+        CHECK_GL_ERROR
+    }
+
+    static void OpenGLDraw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count)
+    {
+        assert(context);
+        DM_PROFILE(Graphics, "Draw");
+        DM_COUNTER("DrawCalls", 1);
+        glDrawArrays(GetOpenGLPrimitiveType(prim_type), first, count);
+        CHECK_GL_ERROR
+    }
+
+    static bool OpenGLIsInstancingSupported(HContext context)
+    {
+        return context->m_InstancingSupport;
+    }
+
+    static void OpenGLEnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t first_instance, HProgram program)
+    {
+        assert(context);
+        assert(context->m_InstancingSupport);
+        assert(vertex_buffer);
+        assert(vertex_declaration);
+
+        if (!(context->m_ModificationVersion == vertex_declaration->m_ModificationVersion && vertex_declaration->m_BoundForProgram == program))
+        {
+            BindVertexDeclarationProgram(context, vertex_declaration, program);
+        }
+
         #define BUFFER_OFFSET(i) ((char*)0x0 + (i))
 
         glBindBufferARB(GL_ARRAY_BUFFER, vertex_buffer);
         CHECK_GL_ERROR;
 
+        // There is no base instance in GL(ES), so the streams start at the first instance instead
+        uint32_t base_offset = first_instance * vertex_declaration->m_Stride;
         for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
         {
-            if (vertex_declaration->m_Streams[i].m_PhysicalIndex != -1)
+            int16_t location = vertex_declaration->m_Streams[i].m_PhysicalIndex;
+            if (location != -1)
             {
-                glEnableVertexAttribArray(vertex_declaration->m_Streams[i].m_PhysicalIndex);
+                glEnableVertexAttribArray(location);
                 CHECK_GL_ERROR;
                 glVertexAttribPointer(
-                        vertex_declaration->m_Streams[i].m_PhysicalIndex,
+                        location,
                         vertex_declaration->m_Streams[i].m_Size,
                         GetOpenGLType(vertex_declaration->m_Streams[i].m_Type),
                         vertex_declaration->m_Streams[i].m_Normalize,
                         vertex_declaration->m_Stride,
-                BUFFER_OFFSET(vertex_declaration->m_Streams[i].m_Offset) );   //The starting point of the VBO, for the vertices
-
+                BUFFER_OFFSET(base_offset + vertex_declaration->m_Streams[i].m_Offset) );
+                CHECK_GL_ERROR;
+                PFN_glVertexAttribDivisor(location, 1);
                 CHECK_GL_ERROR;
             }
         }
@@ -1556,73 +2319,55 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         #undef BUFFER_OFFSET
     }
 
-    static void OpenGLDisableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    static void OpenGLDisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
     {
         assert(context);
         assert(vertex_declaration);
 
         for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
         {
-            glDisableVertexAttribArray(i);
-            CHECK_GL_ERROR;
+            int16_t location = vertex_declaration->m_Streams[i].m_PhysicalIndex;
+            if (location != -1)
+            {
+                PFN_glVertexAttribDivisor(location, 0);
+                CHECK_GL_ERROR;
+                glDisableVertexAttribArray(location);
+                CHECK_GL_ERROR;
+            }
         }
 
         glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
         CHECK_GL_ERROR;
-
-        glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
-        CHECK_GL_ERROR;
-    }
-
-    void OpenGLHashVertexDeclaration(HashState32 *state, HVertexDeclaration vertex_declaration)
-    {
-        uint16_t stream_count = vertex_declaration->m_StreamCount;
-        for (int i = 0; i < stream_count; ++i)
-        {
-            VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
-            // TODO: We might want to store a hash of the name already in the vertexdecl,
-            //       but currently the OpenGL implementation uses the string to find
-            //       correct uniform location (if I recall correctly).
-            dmHashUpdateBuffer32(state, stream.m_Name, strlen(stream.m_Name));
-            dmHashUpdateBuffer32(state, &stream.m_LogicalIndex, sizeof(stream.m_LogicalIndex));
-            dmHashUpdateBuffer32(state, &stream.m_Size, sizeof(stream.m_Size));
-            dmHashUpdateBuffer32(state, &stream.m_Offset, sizeof(stream.m_Offset));
-            dmHashUpdateBuffer32(state, &stream.m_Type, sizeof(stream.m_Type));
-            dmHashUpdateBuffer32(state, &stream.m_Normalize, sizeof(stream.m_Normalize));
-        }
     }
 
-
-    static void OpenGLDrawElements(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer)
+    static void OpenGLDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
     {
         assert(context);
+        assert(context->m_InstancingSupport);
         assert(index_buffer);
-        DM_PROFILE(Graphics, "DrawElements");
+        DM_PROFILE(Graphics, "DrawElementsInstanced");
         DM_COUNTER("DrawCalls", 1);
 
         glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
         CHECK_GL_ERROR;
 
-        glDrawElements(GetOpenGLPrimitiveType(prim_type), count, GetOpenGLType(type), (GLvoid*)(uintptr_t) first);
+        PFN_glDrawElementsInstanced(GetOpenGLPrimitiveType(prim_type), count, GetOpenGLType(type), (GLvoid*)(uintptr_t) first, instance_count);
         CHECK_GL_ERROR
     }
 
-    static void OpenGLDraw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count)
+    static void OpenGLDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
     {
         assert(context);
-        DM_PROFILE(Graphics, "Draw");
+        assert(context->m_InstancingSupport);
+        DM_PROFILE(Graphics, "DrawInstanced");
         DM_COUNTER("DrawCalls", 1);
-        glDrawArrays(GetOpenGLPrimitiveType(prim_type), first, count);
+
+        PFN_glDrawArraysInstanced(GetOpenGLPrimitiveType(prim_type), first, count, instance_count);
         CHECK_GL_ERROR
     }
 
-    static uint32_t CreateShader(GLenum type, const void* program, uint32_t program_size)
+    static bool CompileShader(GLuint s)
     {
-        GLuint s = glCreateShader(type);
-        CHECK_GL_ERROR;
-        GLint size = program_size;
-        glShaderSource(s, 1, (const GLchar**) &program, &size);
-        CHECK_GL_ERROR;
         glCompileShader(s);
         CHECK_GL_ERROR;
 
@@ -1641,36 +2386,187 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
                 free(log);
             }
 #endif
+            return false;
+        }
+
+        return true;
+    }
+
+    static uint32_t CreateShader(HContext context, GLenum type, const void* program, uint32_t program_size)
+    {
+        GLuint s = glCreateShader(type);
+        CHECK_GL_ERROR;
+        GLint size = program_size;
+        glShaderSource(s, 1, (const GLchar**) &program, &size);
+        CHECK_GL_ERROR;
+
+        if (!context->m_ProgramBinarySupport)
+        {
+            if (!CompileShader(s))
+            {
+                glDeleteShader(s);
+                return 0;
+            }
+            return s;
+        }
+
+        // A shader that is part of a cached program compiled with this driver before,
+        // so the compile is skipped unless a program has to be linked from source
+        ShaderInfo info;
+        info.m_SourceHash = dmHashBuffer64(program, program_size);
+        info.m_Compiled   = context->m_CachedShaderSourceHashes.Get(info.m_SourceHash) == 0;
+        if (info.m_Compiled && !CompileShader(s))
+        {
             glDeleteShader(s);
             return 0;
         }
 
+        if (context->m_Shaders.Full())
+        {
+            uint32_t capacity = context->m_Shaders.Capacity() + 64;
+            context->m_Shaders.SetCapacity(dmMath::Max(capacity / 2, 16U), capacity);
+        }
+        context->m_Shaders.Put(s, info);
         return s;
     }
 
+    static bool EnsureShaderCompiled(HContext context, GLuint s)
+    {
+        ShaderInfo* info = context->m_Shaders.Get(s);
+        if (info && !info->m_Compiled)
+        {
+            info->m_Compiled = 1;
+            return CompileShader(s);
+        }
+        return true;
+    }
+
+    static void SetShaderSourceHash(HContext context, GLuint s, const void* program, uint32_t program_size)
+    {
+        ShaderInfo* info = context->m_Shaders.Get(s);
+        if (info)
+        {
+            info->m_SourceHash = dmHashBuffer64(program, program_size);
+            info->m_Compiled   = 1;
+        }
+    }
+
+    static uint64_t GetProgramBinaryKey(HContext context, GLuint vertex_shader, GLuint fragment_shader, uint64_t* vertex_source_hash, uint64_t* fragment_source_hash)
+    {
+        ShaderInfo* vertex_info   = context->m_Shaders.Get(vertex_shader);
+        ShaderInfo* fragment_info = context->m_Shaders.Get(fragment_shader);
+        if (!vertex_info || !fragment_info)
+        {
+            return 0;
+        }
+
+        *vertex_source_hash   = vertex_info->m_SourceHash;
+        *fragment_source_hash = fragment_info->m_SourceHash;
+
+        HashState64 hash_state;
+        dmHashInit64(&hash_state, false);
+        dmHashUpdateBuffer64(&hash_state, vertex_source_hash, sizeof(*vertex_source_hash));
+        dmHashUpdateBuffer64(&hash_state, fragment_source_hash, sizeof(*fragment_source_hash));
+        return dmHashFinal64(&hash_state);
+    }
+
+    static bool LoadProgramBinary(HContext context, GLuint program, uint64_t key)
+    {
+        ProgramBinary* binary = context->m_ProgramBinaries.Get(key);
+        if (!binary)
+        {
+            return false;
+        }
+
+        PFN_glProgramBinary(program, binary->m_Format, binary->m_Data, binary->m_Size);
+        // The driver may reject binaries even when its version string is unchanged, which
+        // sets an error but leaves the program unlinked. That is handled below.
+        glGetError();
+
+        GLint status;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status != 0)
+        {
+            return true;
+        }
+
+        dmLogInfo("Program binary %llx was rejected by the driver, linking from source", (unsigned long long) key);
+        EraseProgramBinary(context, key);
+        MarkProgramBinariesChanged(context);
+        return false;
+    }
+
+    static void StoreProgramBinary(HContext context, GLuint program, uint64_t key, uint64_t vertex_source_hash, uint64_t fragment_source_hash)
+    {
+        GLint size = 0;
+        glGetProgramiv(program, DMGRAPHICS_PROGRAM_BINARY_LENGTH, &size);
+        CHECK_GL_ERROR;
+        if (size <= 0)
+        {
+            return;
+        }
+
+        ProgramBinary binary;
+        binary.m_VertexSourceHash   = vertex_source_hash;
+        binary.m_FragmentSourceHash = fragment_source_hash;
+        binary.m_Data               = (uint8_t*) malloc(size);
+
+        GLsizei written = 0;
+        PFN_glGetProgramBinary(program, size, &written, &binary.m_Format, binary.m_Data);
+        if (glGetError() != GL_NO_ERROR || written <= 0)
+        {
+            free(binary.m_Data);
+            return;
+        }
+        binary.m_Size = (uint32_t) written;
+
+        AddProgramBinary(context, key, binary);
+        MarkProgramBinariesChanged(context);
+    }
+
     static HVertexProgram OpenGLNewVertexProgram(HContext context, ShaderDesc::Shader* ddf)
     {
         assert(ddf);
-        return CreateShader(GL_VERTEX_SHADER, ddf->m_Source.m_Data, ddf->m_Source.m_Count);
+        return CreateShader(context, GL_VERTEX_SHADER, ddf->m_Source.m_Data, ddf->m_Source.m_Count);
     }
 
     static HFragmentProgram OpenGLNewFragmentProgram(HContext context, ShaderDesc::Shader* ddf)
     {
         assert(ddf);
-        return CreateShader(GL_FRAGMENT_SHADER, ddf->m_Source.m_Data, ddf->m_Source.m_Count);
+        return CreateShader(context, GL_FRAGMENT_SHADER, ddf->m_Source.m_Data, ddf->m_Source.m_Count);
     }
 
     static HProgram OpenGLNewProgram(HContext context, HVertexProgram vertex_program, HFragmentProgram fragment_program)
     {
         IncreaseModificationVersion(context);
 
-        (void) context;
         GLuint p = glCreateProgram();
         CHECK_GL_ERROR;
+        // The shaders are attached even when the program is loaded from a binary, ReloadProgram relinks them
         glAttachShader(p, vertex_program);
         CHECK_GL_ERROR;
         glAttachShader(p, fragment_program);
         CHECK_GL_ERROR;
+
+        uint64_t binary_key = 0;
+        uint64_t vertex_source_hash = 0;
+        uint64_t fragment_source_hash = 0;
+        if (context->m_ProgramBinarySupport)
+        {
+            binary_key = GetProgramBinaryKey(context, vertex_program, fragment_program, &vertex_source_hash, &fragment_source_hash);
+            if (binary_key && LoadProgramBinary(context, p, binary_key))
+            {
+                return p;
+            }
+
+            if (!EnsureShaderCompiled(context, vertex_program) || !EnsureShaderCompiled(context, fragment_program))
+            {
+                glDeleteProgram(p);
+                CHECK_GL_ERROR;
+                return 0;
+            }
+        }
+
         glLinkProgram(p);
 
         GLint status;
@@ -1694,12 +2590,21 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         }
 
         CHECK_GL_ERROR;
+
+        if (binary_key)
+        {
+            StoreProgramBinary(context, p, binary_key, vertex_source_hash, fragment_source_hash);
+        }
         return p;
     }
 
     static void OpenGLDeleteProgram(HContext context, HProgram program)
     {
-        (void) context;
+        // The name may be handed out again by glCreateProgram
+        if (context->m_StateCache.m_Program == program)
+        {
+            context->m_StateCache.m_Program = STATE_CACHE_UNKNOWN;
+        }
         glDeleteProgram(program);
     }
 
@@ -1751,6 +2656,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             CHECK_GL_ERROR;
             glCompileShader(prog);
             CHECK_GL_ERROR;
+            SetShaderSourceHash(g_Context, prog, ddf->m_Source.m_Data, ddf->m_Source.m_Count);
         }
 
         return success;
@@ -1772,6 +2678,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             CHECK_GL_ERROR;
             glCompileShader(prog);
             CHECK_GL_ERROR;
+            SetShaderSourceHash(g_Context, prog, ddf->m_Source.m_Data, ddf->m_Source.m_Count);
         }
 
         return success;
@@ -1782,6 +2689,10 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         assert(program);
         glDeleteShader(program);
         CHECK_GL_ERROR;
+        if (g_Context->m_Shaders.Get(program))
+        {
+            g_Context->m_Shaders.Erase(program);
+        }
     }
 
     static void OpenGLDeleteFragmentProgram(HFragmentProgram program)
@@ -1789,6 +2700,10 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         assert(program);
         glDeleteShader(program);
         CHECK_GL_ERROR;
+        if (g_Context->m_Shaders.Get(program))
+        {
+            g_Context->m_Shaders.Erase(program);
+        }
     }
 
     static ShaderDesc::Language OpenGLGetShaderProgramLanguage(HContext context)
@@ -1801,15 +2716,19 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
 
     static void OpenGLEnableProgram(HContext context, HProgram program)
     {
-        (void) context;
-        glUseProgram(program);
-        CHECK_GL_ERROR;
+        if (UpdateStateCache(context->m_StateCache.m_Program, (uint32_t) program))
+        {
+            glUseProgram(program);
+            CHECK_GL_ERROR;
+        }
     }
 
     static void OpenGLDisableProgram(HContext context)
     {
-        (void) context;
-        glUseProgram(0);
+        if (UpdateStateCache(context->m_StateCache.m_Program, 0))
+        {
+            glUseProgram(0);
+        }
     }
 
     static bool TryLinkProgram(HVertexProgram vert_program, HFragmentProgram frag_program)
@@ -1845,6 +2764,11 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
 
     static bool OpenGLReloadProgram(HContext context, HProgram program, HVertexProgram vert_program, HFragmentProgram frag_program)
     {
+        if (!EnsureShaderCompiled(context, vert_program) || !EnsureShaderCompiled(context, frag_program))
+        {
+            return false;
+        }
+
         if (!TryLinkProgram(vert_program, frag_program))
         {
             return false;
@@ -2147,6 +3071,11 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         return (context->m_TextureFormatSupport & (1 << format)) != 0;
     }
 
+    static bool OpenGLIsTextureTypeSupported(HContext context, TextureType type)
+    {
+        return type != TEXTURE_TYPE_2D_ARRAY || context->m_TextureArraySupport;
+    }
+
     static uint32_t OpenGLGetMaxTextureSize(HContext context)
     {
         return context->m_MaxTextureSize;
@@ -2158,12 +3087,26 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         glGenTextures( 1, &t );
         CHECK_GL_ERROR;
 
+        // A deleted texture may still be cached as bound, and its name handed out again
+        StateCache& cache = context->m_StateCache;
+        for (uint32_t i = 0; i < STATE_CACHE_MAX_TEXTURE_UNITS; ++i)
+        {
+            if (cache.m_Textures[i] == t)
+            {
+                cache.m_Textures[i] = STATE_CACHE_UNKNOWN;
+            }
+        }
+
+        assert(OpenGLIsTextureTypeSupported(context, params.m_Type));
+
         Texture* tex = new Texture;
         tex->m_Type = params.m_Type;
         tex->m_Texture = t;
+        tex->m_AppliedSamplerParams = STATE_CACHE_UNKNOWN;
 
         tex->m_Width = params.m_Width;
         tex->m_Height = params.m_Height;
+        tex->m_Depth = params.m_Type == TEXTURE_TYPE_2D_ARRAY ? dmMath::Max((uint16_t)1, params.m_Depth) : 1;
 
         if (params.m_OriginalWidth == 0){
             tex->m_OriginalWidth = params.m_Width;
@@ -2277,6 +3220,15 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
 
     static void OpenGLSetTextureParams(HTexture texture, TextureFilter minfilter, TextureFilter magfilter, TextureWrap uwrap, TextureWrap vwrap)
     {
+        // The sampler state lives in the texture object, so it only needs to be set when it changes
+        uint32_t sampler_params = (uint32_t) minfilter | (uint32_t) magfilter << 8 | (uint32_t) uwrap << 16 | (uint32_t) vwrap << 24;
+        if (texture->m_AppliedSamplerParams == sampler_params)
+        {
+            DM_COUNTER("SkippedStateChanges", 1);
+            return;
+        }
+        texture->m_AppliedSamplerParams = sampler_params;
+
         GLenum type = GetOpenGLTextureType(texture->m_Type);
 
         glTexParameteri(type, GL_TEXTURE_MIN_FILTER, GetOpenGLTextureFilter(minfilter));
@@ -2309,14 +3261,60 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             ap = g_TextureParamsAsyncArray[param_array_index];
             g_TextureParamsAsyncArrayIndices.Push(param_array_index);
         }
-        SetTexture(ap.m_Texture, ap.m_Params);
+        DoSetTexture(ap.m_Texture, ap.m_Params);
+        if (!JobQueueIsAsync())
+        {
+            InvalidateActiveTextureUnit(g_Context);
+        }
         glFlush();
         ap.m_Texture->m_DataState &= ~(1<<ap.m_Params.m_MipMap);
     }
 
+    // Makes the queued uploads in order until the budget is used up. At least one upload is made
+    // each frame, so that textures larger than the budget still get through.
+    static void UploadPendingTextures(HContext context)
+    {
+        DM_PROFILE(Graphics, "UploadPendingTextures");
+        uint32_t count = g_PendingTextureUploads.Size();
+        uint32_t uploaded_size = 0;
+        uint32_t i = 0;
+        for (; i < count; ++i)
+        {
+            TextureParamsAsync& ap = g_PendingTextureUploads[i];
+            if (i > 0 && uploaded_size + ap.m_Params.m_DataSize > context->m_TextureUploadBudget)
+            {
+                break;
+            }
+            DoSetTexture(ap.m_Texture, ap.m_Params);
+            ap.m_Texture->m_DataState &= ~(1<<ap.m_Params.m_MipMap);
+            uploaded_size += ap.m_Params.m_DataSize;
+        }
+        InvalidateActiveTextureUnit(context);
+
+        memmove(g_PendingTextureUploads.Begin(), g_PendingTextureUploads.Begin() + i, (count - i) * sizeof(TextureParamsAsync));
+        g_PendingTextureUploads.SetSize(count - i);
+        DM_COUNTER("TextureUploadBytes", uploaded_size);
+    }
+
     static void OpenGLSetTextureAsync(HTexture texture, const TextureParams& params)
     {
         texture->m_DataState |= 1<<params.m_MipMap;
+
+        // Without a worker thread the upload would stall the main thread, so it is
+        // queued and made at the start of a later frame instead
+        if (g_Context->m_TextureUploadBudget > 0 && !JobQueueIsAsync())
+        {
+            TextureParamsAsync ap;
+            ap.m_Texture = texture;
+            ap.m_Params = params;
+            if (g_PendingTextureUploads.Full())
+            {
+                g_PendingTextureUploads.OffsetCapacity(64);
+            }
+            g_PendingTextureUploads.Push(ap);
+            return;
+        }
+
         uint16_t param_array_index;
         {
             dmMutex::ScopedLock lk(g_Context->m_AsyncMutex);
@@ -2352,7 +3350,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         return HANDLE_RESULT_OK;
     }
 
-    static void OpenGLSetTexture(HTexture texture, const TextureParams& params)
+    static void DoSetTexture(HTexture texture, const TextureParams& params)
     {
         DM_PROFILE(Graphics, "SetTexture");
 
@@ -2394,8 +3392,15 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
             CHECK_GL_ERROR;
         }
+        if (!params.m_SubUpdate && params.m_MipMap == 0 && (texture->m_Width != params.m_Width || texture->m_Height != params.m_Height))
+        {
+            // A resized texture gets a new mip chain
+            texture->m_MipMapCount = 0;
+        }
         texture->m_MipMapCount = dmMath::Max(texture->m_MipMapCount, (uint16_t)(params.m_MipMap+1));
 
+        assert(texture->m_Type != TEXTURE_TYPE_2D_ARRAY || (params.m_Z + params.m_Depth <= texture->m_Depth));
+
         GLenum type = GetOpenGLTextureType(texture->m_Type);
         glBindTexture(type, texture->m_Texture);
         CHECK_GL_ERROR;
@@ -2562,6 +3567,17 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
                     CHECK_GL_ERROR;
                 }
 
+            } else if (texture->m_Type == TEXTURE_TYPE_2D_ARRAY) {
+                // Layers are present contiguously in memory with stride m_DataSize, starting at layer m_Z
+                if (!params.m_SubUpdate) {
+                    const void* data = params.m_Depth == texture->m_Depth ? params.m_Data : 0x0;
+                    PFN_glTexImage3D(DMGRAPHICS_TEXTURE_2D_ARRAY, params.m_MipMap, internal_format, params.m_Width, params.m_Height, texture->m_Depth, 0, gl_format, gl_type, data);
+                    CHECK_GL_ERROR;
+                }
+                if (params.m_SubUpdate || params.m_Depth != texture->m_Depth) {
+                    PFN_glTexSubImage3D(DMGRAPHICS_TEXTURE_2D_ARRAY, params.m_MipMap, params.m_X, params.m_Y, params.m_Z, params.m_Width, params.m_Height, params.m_Depth, gl_format, gl_type, params.m_Data);
+                    CHECK_GL_ERROR;
+                }
             } else {
                 assert(0);
             }
@@ -2618,6 +3634,16 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
                         glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, params.m_MipMap, gl_format, params.m_Width, params.m_Height, 0, params.m_DataSize, p + params.m_DataSize * 5);
                         CHECK_GL_ERROR;
                     }
+                } else if (texture->m_Type == TEXTURE_TYPE_2D_ARRAY) {
+                    if (!params.m_SubUpdate) {
+                        const void* data = params.m_Depth == texture->m_Depth ? params.m_Data : 0x0;
+                        PFN_glCompressedTexImage3D(DMGRAPHICS_TEXTURE_2D_ARRAY, params.m_MipMap, gl_format, params.m_Width, params.m_Height, texture->m_Depth, 0, params.m_DataSize * texture->m_Depth, data);
+                        CHECK_GL_ERROR;
+                    }
+                    if (params.m_SubUpdate || params.m_Depth != texture->m_Depth) {
+                        PFN_glCompressedTexSubImage3D(DMGRAPHICS_TEXTURE_2D_ARRAY, params.m_MipMap, params.m_X, params.m_Y, params.m_Z, params.m_Width, params.m_Height, params.m_Depth, gl_format, params.m_DataSize * params.m_Depth, params.m_Data);
+                        CHECK_GL_ERROR;
+                    }
                 } else {
                     assert(0);
                 }
@@ -2639,6 +3665,40 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         }
     }
 
+    static void OpenGLSetTexture(HTexture texture, const TextureParams& params)
+    {
+        DoSetTexture(texture, params);
+        InvalidateActiveTextureUnit(g_Context);
+    }
+
+    static bool OpenGLGenerateMipMaps(HTexture texture)
+    {
+        DM_PROFILE(Graphics, "GenerateMipMaps");
+        if (PFN_glGenerateMipmap == 0x0 || texture->m_Type != TEXTURE_TYPE_2D || texture->m_DataState || IsTextureFormatCompressed(texture->m_Params.m_Format))
+        {
+            return false;
+        }
+        // GLES 2 only generates mipmaps for power of two sizes
+        if (!g_Context->m_IsGles3Version && ((texture->m_Width & (texture->m_Width - 1)) != 0 || (texture->m_Height & (texture->m_Height - 1)) != 0))
+        {
+            return false;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, texture->m_Texture);
+        CHECK_GL_ERROR;
+        PFN_glGenerateMipmap(GL_TEXTURE_2D);
+        CHECK_GL_ERROR;
+        InvalidateActiveTextureUnit(g_Context);
+
+        uint16_t mipmap_count = 1;
+        for (uint32_t size = dmMath::Max(texture->m_Width, texture->m_Height); size > 1; size >>= 1)
+        {
+            ++mipmap_count;
+        }
+        texture->m_MipMapCount = mipmap_count;
+        return true;
+    }
+
     // NOTE: This is an approximation
     static uint32_t OpenGLGetTextureResourceSize(HTexture texture)
     {
@@ -2653,7 +3713,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         {
             size_total *= 6;
         }
-        return size_total + sizeof(Texture);
+        return size_total * texture->m_Depth + sizeof(Texture);
     }
 
     static uint16_t OpenGLGetTextureWidth(HTexture texture)
@@ -2666,6 +3726,11 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         return texture->m_Height;
     }
 
+    static uint16_t OpenGLGetTextureDepth(HTexture texture)
+    {
+        return texture->m_Depth;
+    }
+
     static uint16_t OpenGLGetOriginalTextureWidth(HTexture texture)
     {
         return texture->m_OriginalWidth;
@@ -2686,10 +3751,18 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         CHECK_GL_ERROR;
 #endif
 
-        glActiveTexture(TEXTURE_UNIT_NAMES[unit]);
-        CHECK_GL_ERROR;
-        glBindTexture(GetOpenGLTextureType(texture->m_Type), texture->m_Texture);
-        CHECK_GL_ERROR;
+        assert(unit < STATE_CACHE_MAX_TEXTURE_UNITS);
+        StateCache& cache = context->m_StateCache;
+        if (UpdateStateCache(cache.m_ActiveTextureUnit, unit))
+        {
+            glActiveTexture(TEXTURE_UNIT_NAMES[unit]);
+            CHECK_GL_ERROR;
+        }
+        if (UpdateStateCache(cache.m_Textures[unit], texture->m_Texture))
+        {
+            glBindTexture(GetOpenGLTextureType(texture->m_Type), texture->m_Texture);
+            CHECK_GL_ERROR;
+        }
 
         SetTextureParams(texture, texture->m_Params.m_MinFilter, texture->m_Params.m_MagFilter, texture->m_Params.m_UWrap, texture->m_Params.m_VWrap);
     }
@@ -2703,10 +3776,18 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         CHECK_GL_ERROR;
 #endif
 
-        glActiveTexture(TEXTURE_UNIT_NAMES[unit]);
-        CHECK_GL_ERROR;
-        glBindTexture(GetOpenGLTextureType(texture->m_Type), 0);
-        CHECK_GL_ERROR;
+        assert(unit < STATE_CACHE_MAX_TEXTURE_UNITS);
+        StateCache& cache = context->m_StateCache;
+        if (UpdateStateCache(cache.m_ActiveTextureUnit, unit))
+        {
+            glActiveTexture(TEXTURE_UNIT_NAMES[unit]);
+            CHECK_GL_ERROR;
+        }
+        if (UpdateStateCache(cache.m_Textures[unit], 0))
+        {
+            glBindTexture(GetOpenGLTextureType(texture->m_Type), 0);
+            CHECK_GL_ERROR;
+        }
     }
 
     static void OpenGLReadPixels(HContext context, void* buffer, uint32_t buffer_size)
@@ -2730,6 +3811,17 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             return;
         }
     #endif
+        StateCache& cache = context->m_StateCache;
+        uint32_t bit = 1 << state;
+        if ((cache.m_KnownStates & bit) && (cache.m_EnabledStates & bit))
+        {
+            DM_COUNTER("SkippedStateChanges", 1);
+            return;
+        }
+        cache.m_KnownStates   |= bit;
+        cache.m_EnabledStates |= bit;
+        DM_COUNTER("StateChanges", 1);
+
         glEnable(GetOpenGLState(state));
         CHECK_GL_ERROR
     }
@@ -2744,6 +3836,17 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             return;
         }
     #endif
+        StateCache& cache = context->m_StateCache;
+        uint32_t bit = 1 << state;
+        if ((cache.m_KnownStates & bit) && !(cache.m_EnabledStates & bit))
+        {
+            DM_COUNTER("SkippedStateChanges", 1);
+            return;
+        }
+        cache.m_KnownStates   |= bit;
+        cache.m_EnabledStates &= ~bit;
+        DM_COUNTER("StateChanges", 1);
+
         glDisable(GetOpenGLState(state));
         CHECK_GL_ERROR
     }
@@ -2776,22 +3879,32 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         #endif
         };
 
-        glBlendFunc(blend_factor_lut[source_factor], blend_factor_lut[destinaton_factor]);
-        CHECK_GL_ERROR
+        if (UpdateStateCache(context->m_StateCache.m_BlendFunc, (uint32_t) source_factor | (uint32_t) destinaton_factor << 16))
+        {
+            glBlendFunc(blend_factor_lut[source_factor], blend_factor_lut[destinaton_factor]);
+            CHECK_GL_ERROR
+        }
     }
 
     static void OpenGLSetColorMask(HContext context, bool red, bool green, bool blue, bool alpha)
     {
         assert(context);
-        glColorMask(red, green, blue, alpha);
-        CHECK_GL_ERROR;
+        uint32_t color_mask = (uint32_t) red | (uint32_t) green << 1 | (uint32_t) blue << 2 | (uint32_t) alpha << 3;
+        if (UpdateStateCache(context->m_StateCache.m_ColorMask, color_mask))
+        {
+            glColorMask(red, green, blue, alpha);
+            CHECK_GL_ERROR;
+        }
     }
 
     static void OpenGLSetDepthMask(HContext context, bool mask)
     {
         assert(context);
-        glDepthMask(mask);
-        CHECK_GL_ERROR;
+        if (UpdateStateCache(context->m_StateCache.m_DepthMask, (uint32_t) mask))
+        {
+            glDepthMask(mask);
+            CHECK_GL_ERROR;
+        }
     }
 
     static GLenum GetOpenGLCompareFunc(CompareFunc func)
@@ -2824,8 +3937,11 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
     static void OpenGLSetDepthFunc(HContext context, CompareFunc func)
     {
         assert(context);
-        glDepthFunc(GetOpenGLCompareFunc(func));
-        CHECK_GL_ERROR
+        if (UpdateStateCache(context->m_StateCache.m_DepthFunc, (uint32_t) func))
+        {
+            glDepthFunc(GetOpenGLCompareFunc(func));
+            CHECK_GL_ERROR
+        }
     }
 
     static void OpenGLSetScissor(HContext context, int32_t x, int32_t y, int32_t width, int32_t height)
@@ -2838,13 +3954,27 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
     static void OpenGLSetStencilMask(HContext context, uint32_t mask)
     {
         assert(context);
-        glStencilMask(mask);
-        CHECK_GL_ERROR;
+        if (UpdateStateCache(context->m_StateCache.m_StencilMask, mask))
+        {
+            glStencilMask(mask);
+            CHECK_GL_ERROR;
+        }
     }
 
     static void OpenGLSetStencilFunc(HContext context, CompareFunc func, uint32_t ref, uint32_t mask)
     {
         assert(context);
+        StateCache& cache = context->m_StateCache;
+        if (cache.m_StencilFunc == (uint32_t) func && cache.m_StencilRef == ref && cache.m_StencilFuncMask == mask)
+        {
+            DM_COUNTER("SkippedStateChanges", 1);
+            return;
+        }
+        cache.m_StencilFunc     = func;
+        cache.m_StencilRef      = ref;
+        cache.m_StencilFuncMask = mask;
+        DM_COUNTER("StateChanges", 1);
+
         glStencilFunc(GetOpenGLCompareFunc(func), ref, mask);
         CHECK_GL_ERROR
     }
@@ -2852,6 +3982,8 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
     static void OpenGLSetStencilFuncSeparate(HContext context, FaceType face_type, CompareFunc func, uint32_t ref, uint32_t mask)
     {
         assert(context);
+        // The cache only tracks the state shared by both faces
+        context->m_StateCache.m_StencilFunc = STATE_CACHE_UNKNOWN;
         glStencilFuncSeparate(GetOpenGLFaceTypeFunc(face_type), GetOpenGLCompareFunc(func), ref, mask);
         CHECK_GL_ERROR
     }
@@ -2870,8 +4002,11 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             GL_INVERT,
         };
 
-        glStencilOp(stencil_op_lut[sfail], stencil_op_lut[dpfail], stencil_op_lut[dppass]);
-        CHECK_GL_ERROR;
+        if (UpdateStateCache(context->m_StateCache.m_StencilOp, (uint32_t) sfail | (uint32_t) dpfail << 8 | (uint32_t) dppass << 16))
+        {
+            glStencilOp(stencil_op_lut[sfail], stencil_op_lut[dpfail], stencil_op_lut[dppass]);
+            CHECK_GL_ERROR;
+        }
     }
 
     static void OpenGLSetStencilOpSeparate(HContext context, FaceType face_type, StencilOp sfail, StencilOp dpfail, StencilOp dppass)
@@ -2888,6 +4023,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             GL_INVERT,
         };
 
+        context->m_StateCache.m_StencilOp = STATE_CACHE_UNKNOWN;
         glStencilOpSeparate(GetOpenGLFaceTypeFunc(face_type), stencil_op_lut[sfail], stencil_op_lut[dpfail], stencil_op_lut[dppass]);
         CHECK_GL_ERROR;
     }
@@ -2895,8 +4031,11 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
     static void OpenGLSetCullFace(HContext context, FaceType face_type)
     {
         assert(context);
-        glCullFace(GetOpenGLFaceTypeFunc(face_type));
-        CHECK_GL_ERROR
+        if (UpdateStateCache(context->m_StateCache.m_CullFace, (uint32_t) face_type))
+        {
+            glCullFace(GetOpenGLFaceTypeFunc(face_type));
+            CHECK_GL_ERROR
+        }
     }
 
     static void OpenGLSetFaceWinding(HContext context, FaceWinding face_winding)
@@ -2908,7 +4047,10 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             GL_CW,
         };
 
-        glFrontFace(face_winding_lut[face_winding]);
+        if (UpdateStateCache(context->m_StateCache.m_FaceWinding, (uint32_t) face_winding))
+        {
+            glFrontFace(face_winding_lut[face_winding]);
+        }
     }
 
     static void OpenGLSetPolygonOffset(HContext context, float factor, float units)
@@ -2979,6 +4121,9 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         fn_table.m_BeginFrame = OpenGLBeginFrame;
         fn_table.m_Flip = OpenGLFlip;
         fn_table.m_SetSwapInterval = OpenGLSetSwapInterval;
+        fn_table.m_SetJobContext = OpenGLSetJobContext;
+        fn_table.m_BeginGpuTimer = OpenGLBeginGpuTimer;
+        fn_table.m_EndGpuTimer = OpenGLEndGpuTimer;
         fn_table.m_Clear = OpenGLClear;
         fn_table.m_NewVertexBuffer = OpenGLNewVertexBuffer;
         fn_table.m_DeleteVertexBuffer = OpenGLDeleteVertexBuffer;
@@ -3000,6 +4145,11 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         fn_table.m_HashVertexDeclaration = OpenGLHashVertexDeclaration;
         fn_table.m_DrawElements = OpenGLDrawElements;
         fn_table.m_Draw = OpenGLDraw;
+        fn_table.m_IsInstancingSupported = OpenGLIsInstancingSupported;
+        fn_table.m_EnableInstanceVertexDeclaration = OpenGLEnableInstanceVertexDeclaration;
+        fn_table.m_DisableInstanceVertexDeclaration = OpenGLDisableInstanceVertexDeclaration;
+        fn_table.m_DrawElementsInstanced = OpenGLDrawElementsInstanced;
+        fn_table.m_DrawInstanced = OpenGLDrawInstanced;
         fn_table.m_NewVertexProgram = OpenGLNewVertexProgram;
         fn_table.m_NewFragmentProgram = OpenGLNewFragmentProgram;
         fn_table.m_NewProgram = OpenGLNewProgram;
@@ -3041,14 +4191,17 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         fn_table.m_GetRenderTargetSize = OpenGLGetRenderTargetSize;
         fn_table.m_SetRenderTargetSize = OpenGLSetRenderTargetSize;
         fn_table.m_IsTextureFormatSupported = OpenGLIsTextureFormatSupported;
+        fn_table.m_IsTextureTypeSupported = OpenGLIsTextureTypeSupported;
         fn_table.m_NewTexture = OpenGLNewTexture;
         fn_table.m_DeleteTexture = OpenGLDeleteTexture;
         fn_table.m_SetTexture = OpenGLSetTexture;
         fn_table.m_SetTextureAsync = OpenGLSetTextureAsync;
+        fn_table.m_GenerateMipMaps = OpenGLGenerateMipMaps;
         fn_table.m_SetTextureParams = OpenGLSetTextureParams;
         fn_table.m_GetTextureResourceSize = OpenGLGetTextureResourceSize;
         fn_table.m_GetTextureWidth = OpenGLGetTextureWidth;
         fn_table.m_GetTextureHeight = OpenGLGetTextureHeight;
+        fn_table.m_GetTextureDepth = OpenGLGetTextureDepth;
         fn_table.m_GetOriginalTextureWidth = OpenGLGetOriginalTextureWidth;
         fn_table.m_GetOriginalTextureHeight = OpenGLGetOriginalTextureHeight;
         fn_table.m_EnableTexture = OpenGLEnableTexture;
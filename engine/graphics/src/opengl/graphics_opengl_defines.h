@@ -351,6 +351,20 @@
 #define DMGRAPHICS_TEXTURE_FORMAT_SRGB8_ALPHA8_ASTC_4x4_KHR 0x93D0
 #endif
 
+// Same values for GL_EXT_texture_array and core GL 3.0/ES 3.0
+#define DMGRAPHICS_TEXTURE_2D_ARRAY                         0x8C1A
+#define DMGRAPHICS_SAMPLER_2D_ARRAY                         0x8DC1
+
+// Same values for GL_ARB_get_program_binary, GL_OES_get_program_binary and core GL 4.1/ES 3.0
+#define DMGRAPHICS_PROGRAM_BINARY_LENGTH                    0x8741
+#define DMGRAPHICS_NUM_PROGRAM_BINARY_FORMATS               0x87FE
+
+// Same values for GL_ARB_timer_query, GL_EXT_disjoint_timer_query and core GL 3.3
+#define DMGRAPHICS_TIMESTAMP                                0x8E28
+#define DMGRAPHICS_QUERY_RESULT                             0x8866
+#define DMGRAPHICS_QUERY_RESULT_AVAILABLE                   0x8867
+#define DMGRAPHICS_GPU_DISJOINT                             0x8FBB
+
 
 
 
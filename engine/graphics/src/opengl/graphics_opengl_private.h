@@ -13,12 +13,92 @@
 #ifndef __GRAPHICS_DEVICE_OPENGL__
 #define __GRAPHICS_DEVICE_OPENGL__
 
+#include <string.h>
+
+#include <dlib/hashtable.h>
 #include <dlib/math.h>
 #include <dlib/mutex.h>
+#include <dlib/path.h>
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
 
 namespace dmGraphics
 {
+    // A linked program as returned by glGetProgramBinary. The binary is only valid
+    // for the driver that produced it, see Context::m_DriverHash
+    struct ProgramBinary
+    {
+        uint64_t m_VertexSourceHash;
+        uint64_t m_FragmentSourceHash;
+        uint8_t* m_Data;
+        uint32_t m_Size;
+        GLenum   m_Format;
+    };
+
+    // Tracks the source of a shader so that its programs can be looked up in the program
+    // binary cache. Shaders that only appear in cached programs aren't compiled until
+    // a program actually needs to be linked from source.
+    struct ShaderInfo
+    {
+        uint64_t m_SourceHash;
+        uint8_t  m_Compiled : 1;
+    };
+
+    const static uint32_t STATE_CACHE_UNKNOWN          = 0xFFFFFFFF;
+    const static uint32_t STATE_CACHE_MAX_TEXTURE_UNITS = 32;
+
+    // Shadow copy of the GL state set through the adapter, used to skip calls that wouldn't
+    // change anything. STATE_CACHE_UNKNOWN means the GL value isn't known and the next call
+    // is always issued. Only the main context is tracked, the auxiliary context used by the
+    // job thread for uploads has its own GL state.
+    struct StateCache
+    {
+        uint32_t m_Program;
+        uint32_t m_ActiveTextureUnit;
+        uint32_t m_Textures[STATE_CACHE_MAX_TEXTURE_UNITS]; // Texture object bound per unit
+        uint32_t m_EnabledStates;   // One bit per State
+        uint32_t m_KnownStates;     // One bit per State, set when the bit in m_EnabledStates is valid
+        uint32_t m_BlendFunc;       // source | destination << 16
+        uint32_t m_ColorMask;
+        uint32_t m_DepthMask;
+        uint32_t m_DepthFunc;
+        uint32_t m_StencilMask;
+        uint32_t m_StencilFunc;     // Both faces
+        uint32_t m_StencilRef;
+        uint32_t m_StencilFuncMask;
+        uint32_t m_StencilOp;       // sfail | dpfail << 8 | dppass << 16, both faces
+        uint32_t m_CullFace;
+        uint32_t m_FaceWinding;
+    };
+
+    static inline void InvalidateStateCache(StateCache& cache)
+    {
+        memset(&cache, 0xFF, sizeof(cache));
+        cache.m_KnownStates = 0;
+    }
+
+    // Vertex array object with the attribute setup of a vertex declaration for one vertex buffer,
+    // see Context::m_VertexArrays
+    struct VertexArray
+    {
+        GLuint m_VertexArray;
+        GLuint m_VertexBuffer;
+    };
+
+    const uint32_t MAX_VERTEX_ARRAYS = 256;
+
+    // GPU timers are read back when their frame slot is reused, so that reading them never stalls
+    const uint32_t GPU_TIMER_FRAME_COUNT = 4;
+    const uint32_t MAX_GPU_TIMERS        = 64; // Per frame
+
+    struct GpuTimerFrame
+    {
+        // Begin and end timestamp query of each timer
+        GLuint      m_Queries[MAX_GPU_TIMERS * 2];
+        const char* m_Names[MAX_GPU_TIMERS];
+        uint32_t    m_NameHashes[MAX_GPU_TIMERS];
+        uint32_t    m_Count;
+    };
+
     struct Context
     {
         Context(const ContextParams& params);
@@ -51,6 +131,21 @@ namespace dmGraphics
         uint64_t                m_TextureFormatSupport;
         uint32_t                m_DepthBufferBits;
         uint32_t                m_FrameBufferInvalidateBits;
+        StateCache              m_StateCache;
+        // Program binary cache, keyed by the hash of the vertex and fragment source hashes
+        dmHashTable64<ProgramBinary> m_ProgramBinaries;
+        dmHashTable64<uint32_t> m_CachedShaderSourceHashes;
+        dmHashTable32<ShaderInfo> m_Shaders;
+        uint64_t                m_DriverHash;
+        uint32_t                m_ProgramBinaryCacheSaveFrames; // Frames left until a changed cache is written
+        uint32_t                m_TextureUploadBudget; // Bytes of queued texture uploads made per frame, 0 uploads immediately
+        char                    m_ProgramCacheDirectory[DMPATH_MAX_PATH];
+        // Cached vertex array objects, keyed by the vertex layout, attribute locations and vertex buffer
+        dmHashTable64<VertexArray> m_VertexArrays;
+        GLuint                  m_DefaultVertexArray; // Used when drawing without a cached vertex array
+        GLuint                  m_BoundVertexArray;
+        GpuTimerFrame*          m_GpuTimerFrames;
+        uint32_t                m_GpuTimerFrame; // Frame slot the timers are issued into
         uint8_t                 m_FrameBufferInvalidateAttachments : 1;
         uint8_t                 m_PackedDepthStencil : 1;
         uint8_t                 m_WindowOpened : 1;
@@ -58,6 +153,15 @@ namespace dmGraphics
         uint8_t                 m_RenderDocSupport : 1;
         uint8_t                 m_IsGles3Version : 1; // 0 == gles 2, 1 == gles 3
         uint8_t                 m_IsShaderLanguageGles : 1; // 0 == glsl, 1 == gles
+        uint8_t                 m_InstancingSupport : 1;
+        uint8_t                 m_ProgramBinarySupport : 1;
+        uint8_t                 m_ProgramBinariesChanged : 1;
+        uint8_t                 m_GpuTimerSupport : 1;
+        uint8_t                 m_GpuTimerDisjointCheck : 1; // EXT_disjoint_timer_query results are invalid after a disjoint event
+        uint8_t                 m_GpuTimerStarted : 1;
+        uint8_t                 m_TextureArraySupport : 1;
+        uint8_t                 m_VertexArraySupport : 1;
+        uint8_t                 : 1;
     };
 
     static inline void IncreaseModificationVersion(Context* context)
@@ -75,12 +179,16 @@ namespace dmGraphics
         uint16_t    m_Height;
         uint16_t    m_OriginalWidth;
         uint16_t    m_OriginalHeight;
+        uint16_t    m_Depth; // Number of layers, 1 unless TEXTURE_TYPE_2D_ARRAY
         uint16_t    m_MipMapCount;
 
         // data state per mip-map (mipX = bitX). 0=ok, 1=pending
         volatile uint16_t    m_DataState;
 
         TextureParams m_Params;
+
+        // Sampler state last set on the texture object, STATE_CACHE_UNKNOWN if never set
+        uint32_t      m_AppliedSamplerParams;
     };
 
     struct VertexDeclaration
@@ -101,6 +209,8 @@ namespace dmGraphics
         uint16_t    m_Stride;
         HProgram    m_BoundForProgram;
         uint32_t    m_ModificationVersion;
+        uint32_t    m_LayoutHash;   // Stride and stream formats
+        uint32_t    m_LocationHash; // Physical indices for m_BoundForProgram
 
     };
     // TODO: Why this one here!? Not used?
@@ -226,6 +226,53 @@ TEST_F(dmGraphicsTest, VertexBuffer)
     dmGraphics::DeleteVertexBuffer(vertex_buffer);
 }
 
+TEST_F(dmGraphicsTest, DynamicVertexBuffer)
+{
+    char data[16];
+    memset(data, 1, sizeof(data));
+    dmGraphics::HDynamicVertexBuffer dynamic_buffer = dmGraphics::NewDynamicVertexBuffer(m_Context);
+
+    dmGraphics::HVertexBuffer vertex_buffer = dmGraphics::AcquireDynamicVertexBuffer(dynamic_buffer);
+    dmGraphics::SetDynamicVertexBufferData(dynamic_buffer, sizeof(data), data);
+    dmGraphics::VertexBuffer* vb = (dmGraphics::VertexBuffer*)vertex_buffer;
+    ASSERT_LE(sizeof(data), vb->m_Size);
+    ASSERT_EQ(0, memcmp(data, vb->m_Buffer, sizeof(data)));
+
+    // A second upload in the same frame must not overwrite the first one
+    memset(data, 2, sizeof(data));
+    dmGraphics::HVertexBuffer vertex_buffer2 = dmGraphics::AcquireDynamicVertexBuffer(dynamic_buffer);
+    ASSERT_NE(vertex_buffer, vertex_buffer2);
+    dmGraphics::SetDynamicVertexBufferData(dynamic_buffer, sizeof(data), data);
+    ASSERT_EQ(0, memcmp(data, ((dmGraphics::VertexBuffer*)vertex_buffer2)->m_Buffer, sizeof(data)));
+    ASSERT_EQ(1, vb->m_Buffer[0]);
+
+    // Buffers still in flight are not reused
+    dmGraphics::Flip(m_Context);
+    dmGraphics::HVertexBuffer vertex_buffer3 = dmGraphics::AcquireDynamicVertexBuffer(dynamic_buffer);
+    ASSERT_NE(vertex_buffer, vertex_buffer3);
+    ASSERT_NE(vertex_buffer2, vertex_buffer3);
+
+    // The oldest buffer is reused once enough frames have been flipped, and its storage is kept
+    dmGraphics::Flip(m_Context);
+    dmGraphics::Flip(m_Context);
+    char* storage = vb->m_Buffer;
+    ASSERT_EQ(vertex_buffer, dmGraphics::AcquireDynamicVertexBuffer(dynamic_buffer));
+    memset(data, 3, sizeof(data));
+    dmGraphics::SetDynamicVertexBufferData(dynamic_buffer, 8, data);
+    ASSERT_EQ(storage, vb->m_Buffer);
+    ASSERT_EQ(0, memcmp(data, vb->m_Buffer, 8));
+
+    // Bigger size grows the storage
+    char big_data[64];
+    memset(big_data, 4, sizeof(big_data));
+    dmGraphics::AcquireDynamicVertexBuffer(dynamic_buffer);
+    dmGraphics::SetDynamicVertexBufferData(dynamic_buffer, sizeof(big_data), big_data);
+    ASSERT_LE(sizeof(big_data), ((dmGraphics::VertexBuffer*)vertex_buffer2)->m_Size);
+    ASSERT_EQ(0, memcmp(big_data, ((dmGraphics::VertexBuffer*)vertex_buffer2)->m_Buffer, sizeof(big_data)));
+
+    dmGraphics::DeleteDynamicVertexBuffer(dynamic_buffer);
+}
+
 TEST_F(dmGraphicsTest, IndexBuffer)
 {
     char data[16];
@@ -327,6 +374,104 @@ TEST_F(dmGraphicsTest, Drawing)
     dmGraphics::DeleteVertexDeclaration(vd);
 }
 
+TEST_F(dmGraphicsTest, FrameStats)
+{
+    float v[20] = { 0.0f };
+    uint32_t i[] = { 0, 1, 2, 2, 1, 3 };
+
+    dmGraphics::Flip(m_Context);
+
+    dmGraphics::VertexElement ve[] =
+    {
+        {"position", 0, 3, dmGraphics::TYPE_FLOAT, false },
+        {"uv", 1, 2, dmGraphics::TYPE_FLOAT, false }
+    };
+    dmGraphics::HVertexDeclaration vd = dmGraphics::NewVertexDeclaration(m_Context, ve, 2);
+    dmGraphics::HVertexBuffer vb = dmGraphics::NewVertexBuffer(m_Context, sizeof(v), v, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+    dmGraphics::HIndexBuffer ib = dmGraphics::NewIndexBuffer(m_Context, sizeof(i), i, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+
+    dmGraphics::EnableState(m_Context, dmGraphics::STATE_BLEND);
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::DrawElements(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 6, dmGraphics::TYPE_UNSIGNED_INT, ib);
+    dmGraphics::Draw(m_Context, dmGraphics::PRIMITIVE_TRIANGLE_STRIP, 0, 4);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+
+    dmGraphics::FrameStats stats;
+    dmGraphics::GetCurrentFrameStats(m_Context, &stats);
+    ASSERT_EQ(2u, stats.m_DrawCalls);
+    ASSERT_EQ(4u, stats.m_Primitives);
+    ASSERT_EQ(1u, stats.m_StateChanges);
+    ASSERT_EQ((uint32_t) (sizeof(v) + sizeof(i)), stats.m_BufferUploadBytes);
+
+    uint32_t frames_over_budget = 0;
+    dmGraphics::Flip(m_Context);
+    dmGraphics::GetFrameStats(m_Context, &stats, &frames_over_budget);
+    ASSERT_EQ(2u, stats.m_DrawCalls);
+    ASSERT_EQ(0u, frames_over_budget);
+
+    dmGraphics::GetCurrentFrameStats(m_Context, &stats);
+    ASSERT_EQ(0u, stats.m_DrawCalls);
+    ASSERT_EQ(0u, stats.m_BufferUploadBytes);
+
+    dmGraphics::DeleteIndexBuffer(ib);
+    dmGraphics::DeleteVertexBuffer(vb);
+    dmGraphics::DeleteVertexDeclaration(vd);
+}
+
+TEST_F(dmGraphicsTest, DrawingInstanced)
+{
+    float v[] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+    uint32_t i[] = { 0, 1, 2, 0, 2, 3 };
+    float inst[] = { 0.0f, 0.0f, 0.0f, 10.0f, 0.0f, 0.0f, 20.0f, 0.0f, 0.0f };
+
+    dmGraphics::VertexElement ve[] =
+    {
+        {"position", 0, 2, dmGraphics::TYPE_FLOAT, false },
+    };
+    dmGraphics::VertexElement ive[] =
+    {
+        {"instance_position", 1, 3, dmGraphics::TYPE_FLOAT, false },
+    };
+    dmGraphics::HVertexDeclaration vd = dmGraphics::NewVertexDeclaration(m_Context, ve, 1);
+    dmGraphics::HVertexDeclaration ivd = dmGraphics::NewVertexDeclaration(m_Context, ive, 1);
+    dmGraphics::HVertexBuffer vb = dmGraphics::NewVertexBuffer(m_Context, sizeof(v), v, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+    dmGraphics::HVertexBuffer ivb = dmGraphics::NewVertexBuffer(m_Context, sizeof(inst), inst, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+    dmGraphics::HIndexBuffer ib = dmGraphics::NewIndexBuffer(m_Context, sizeof(i), i, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+
+    ASSERT_TRUE(dmGraphics::IsInstancingSupported(m_Context));
+
+    uint64_t draw_count = dmGraphics::GetDrawCount();
+
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::EnableInstanceVertexDeclaration(m_Context, ivd, ivb, 0, 0);
+    dmGraphics::DrawElementsInstanced(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 6, 3, dmGraphics::TYPE_UNSIGNED_INT, ib);
+    dmGraphics::DisableInstanceVertexDeclaration(m_Context, ivd);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+
+    // Start at the second instance
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::EnableInstanceVertexDeclaration(m_Context, ivd, ivb, 1, 0);
+    dmGraphics::DrawElementsInstanced(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 6, 2, dmGraphics::TYPE_UNSIGNED_INT, ib);
+    dmGraphics::DisableInstanceVertexDeclaration(m_Context, ivd);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+
+    // Non-indexed
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::EnableInstanceVertexDeclaration(m_Context, ivd, ivb, 0, 0);
+    dmGraphics::DrawInstanced(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3, 3);
+    dmGraphics::DisableInstanceVertexDeclaration(m_Context, ivd);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+
+    // One draw call per batch, regardless of the instance count
+    ASSERT_EQ(draw_count + 3, dmGraphics::GetDrawCount());
+
+    dmGraphics::DeleteIndexBuffer(ib);
+    dmGraphics::DeleteVertexBuffer(ivb);
+    dmGraphics::DeleteVertexBuffer(vb);
+    dmGraphics::DeleteVertexDeclaration(ivd);
+    dmGraphics::DeleteVertexDeclaration(vd);
+}
+
 static inline dmGraphics::ShaderDesc::Shader MakeDDFShader(const char* data, uint32_t count)
 {
     dmGraphics::ShaderDesc::Shader ddf;
@@ -451,6 +596,80 @@ TEST_F(dmGraphicsTest, TestTexture)
     dmGraphics::DeleteTexture(texture);
 }
 
+TEST_F(dmGraphicsTest, TestGenerateMipMaps)
+{
+    dmGraphics::TextureCreationParams creation_params;
+    creation_params.m_Width = 64;
+    creation_params.m_Height = 32;
+    creation_params.m_OriginalWidth = 64;
+    creation_params.m_OriginalHeight = 32;
+    dmGraphics::HTexture texture = dmGraphics::NewTexture(m_Context, creation_params);
+
+    dmGraphics::TextureParams params;
+    params.m_DataSize = 64 * 32 * 4;
+    params.m_Data = new char[params.m_DataSize];
+    params.m_Width = 64;
+    params.m_Height = 32;
+    params.m_Format = dmGraphics::TEXTURE_FORMAT_RGBA;
+    dmGraphics::SetTexture(texture, params);
+    delete [] (char*)params.m_Data;
+
+    uint32_t size = dmGraphics::GetTextureResourceSize(texture);
+    ASSERT_TRUE(dmGraphics::GenerateMipMaps(texture));
+    // 64x32 down to 1x1
+    ASSERT_LT(size, dmGraphics::GetTextureResourceSize(texture));
+    dmGraphics::DeleteTexture(texture);
+
+    // Compressed data can't be downsampled
+    texture = dmGraphics::NewTexture(m_Context, creation_params);
+    params.m_DataSize = 64 * 32 / 2;
+    params.m_Data = new char[params.m_DataSize];
+    params.m_Format = dmGraphics::TEXTURE_FORMAT_RGB_ETC1;
+    dmGraphics::SetTexture(texture, params);
+    delete [] (char*)params.m_Data;
+    ASSERT_FALSE(dmGraphics::GenerateMipMaps(texture));
+    dmGraphics::DeleteTexture(texture);
+}
+
+TEST_F(dmGraphicsTest, TestTextureArray)
+{
+    ASSERT_TRUE(dmGraphics::IsTextureTypeSupported(m_Context, dmGraphics::TEXTURE_TYPE_2D_ARRAY));
+
+    dmGraphics::TextureCreationParams creation_params;
+    dmGraphics::TextureParams params;
+
+    creation_params.m_Type = dmGraphics::TEXTURE_TYPE_2D_ARRAY;
+    creation_params.m_Width = WIDTH;
+    creation_params.m_Height = HEIGHT;
+    creation_params.m_Depth = 3;
+
+    // Layers are stored back to back, m_DataSize is the size of one layer
+    params.m_DataSize = WIDTH * HEIGHT;
+    params.m_Data = new char[params.m_DataSize * 3];
+    params.m_Width = WIDTH;
+    params.m_Height = HEIGHT;
+    params.m_Depth = 3;
+    params.m_Format = dmGraphics::TEXTURE_FORMAT_LUMINANCE;
+    dmGraphics::HTexture texture = dmGraphics::NewTexture(m_Context, creation_params);
+    dmGraphics::SetTexture(texture, params);
+
+    ASSERT_EQ(WIDTH, dmGraphics::GetTextureWidth(texture));
+    ASSERT_EQ(HEIGHT, dmGraphics::GetTextureHeight(texture));
+    ASSERT_EQ(3, dmGraphics::GetTextureDepth(texture));
+    ASSERT_LE(3u * WIDTH * HEIGHT, dmGraphics::GetTextureResourceSize(texture));
+
+    // Update the last layer only
+    params.m_SubUpdate = true;
+    params.m_Depth = 1;
+    params.m_Z = 2;
+    dmGraphics::SetTexture(texture, params);
+
+    delete [] (char*)params.m_Data;
+    dmGraphics::EnableTexture(m_Context, 0, texture);
+    dmGraphics::DisableTexture(m_Context, 0, texture);
+    dmGraphics::DeleteTexture(texture);
+}
+
 TEST_F(dmGraphicsTest, TestSetTextureBounds)
 {
     dmGraphics::TextureCreationParams creation_params;
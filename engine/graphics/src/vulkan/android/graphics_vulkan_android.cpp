@@ -69,6 +69,7 @@ PFN_vkWaitForFences vkWaitForFences;
 PFN_vkResetFences vkResetFences;
 PFN_vkCreateCommandPool vkCreateCommandPool;
 PFN_vkDestroyCommandPool vkDestroyCommandPool;
+PFN_vkResetCommandPool vkResetCommandPool;
 PFN_vkAllocateCommandBuffers vkAllocateCommandBuffers;
 PFN_vkBeginCommandBuffer vkBeginCommandBuffer;
 PFN_vkEndCommandBuffer vkEndCommandBuffer;
@@ -78,6 +79,7 @@ PFN_vkQueueWaitIdle vkQueueWaitIdle;
 PFN_vkDeviceWaitIdle vkDeviceWaitIdle;
 PFN_vkCreateFramebuffer vkCreateFramebuffer;
 PFN_vkCreatePipelineCache vkCreatePipelineCache;
+PFN_vkGetPipelineCacheData vkGetPipelineCacheData;
 PFN_vkCreatePipelineLayout vkCreatePipelineLayout;
 PFN_vkCreateGraphicsPipelines vkCreateGraphicsPipelines;
 PFN_vkCreateComputePipelines vkCreateComputePipelines;
@@ -118,6 +120,7 @@ PFN_vkCmdBeginQuery vkCmdBeginQuery;
 PFN_vkCmdEndQuery vkCmdEndQuery;
 PFN_vkCmdResetQueryPool vkCmdResetQueryPool;
 PFN_vkCmdCopyQueryPoolResults vkCmdCopyQueryPoolResults;
+PFN_vkCmdWriteTimestamp vkCmdWriteTimestamp;
 PFN_vkCreateAndroidSurfaceKHR vkCreateAndroidSurfaceKHR;
 PFN_vkDestroySurfaceKHR vkDestroySurfaceKHR;
 PFN_vkGetPhysicalDeviceSurfaceSupportKHR vkGetPhysicalDeviceSurfaceSupportKHR;
@@ -215,6 +218,7 @@ namespace dmGraphics
         vkResetFences = (PFN_vkResetFences) vkGetInstanceProcAddr(vk_instance, "vkResetFences");
         vkCreateCommandPool = (PFN_vkCreateCommandPool) vkGetInstanceProcAddr(vk_instance, "vkCreateCommandPool");
         vkDestroyCommandPool = (PFN_vkDestroyCommandPool) vkGetInstanceProcAddr(vk_instance, "vkDestroyCommandPool");
+        vkResetCommandPool = (PFN_vkResetCommandPool) vkGetInstanceProcAddr(vk_instance, "vkResetCommandPool");
         vkAllocateCommandBuffers = (PFN_vkAllocateCommandBuffers) vkGetInstanceProcAddr(vk_instance, "vkAllocateCommandBuffers");
         vkBeginCommandBuffer = (PFN_vkBeginCommandBuffer) vkGetInstanceProcAddr(vk_instance, "vkBeginCommandBuffer");
         vkEndCommandBuffer = (PFN_vkEndCommandBuffer) vkGetInstanceProcAddr(vk_instance, "vkEndCommandBuffer");
@@ -224,6 +228,7 @@ namespace dmGraphics
         vkDeviceWaitIdle = (PFN_vkDeviceWaitIdle) vkGetInstanceProcAddr(vk_instance, "vkDeviceWaitIdle");
         vkCreateFramebuffer = (PFN_vkCreateFramebuffer) vkGetInstanceProcAddr(vk_instance, "vkCreateFramebuffer");
         vkCreatePipelineCache = (PFN_vkCreatePipelineCache) vkGetInstanceProcAddr(vk_instance, "vkCreatePipelineCache");
+        vkGetPipelineCacheData = (PFN_vkGetPipelineCacheData) vkGetInstanceProcAddr(vk_instance, "vkGetPipelineCacheData");
         vkCreatePipelineLayout = (PFN_vkCreatePipelineLayout) vkGetInstanceProcAddr(vk_instance, "vkCreatePipelineLayout");
         vkCreateGraphicsPipelines = (PFN_vkCreateGraphicsPipelines) vkGetInstanceProcAddr(vk_instance, "vkCreateGraphicsPipelines");
         vkCreateComputePipelines = (PFN_vkCreateComputePipelines) vkGetInstanceProcAddr(vk_instance, "vkCreateComputePipelines");
@@ -264,6 +269,7 @@ namespace dmGraphics
         vkCmdEndQuery = (PFN_vkCmdEndQuery) vkGetInstanceProcAddr(vk_instance, "vkCmdEndQuery");
         vkCmdResetQueryPool = (PFN_vkCmdResetQueryPool) vkGetInstanceProcAddr(vk_instance, "vkCmdResetQueryPool");
         vkCmdCopyQueryPoolResults = (PFN_vkCmdCopyQueryPoolResults) vkGetInstanceProcAddr(vk_instance, "vkCmdCopyQueryPoolResults");
+        vkCmdWriteTimestamp = (PFN_vkCmdWriteTimestamp) vkGetInstanceProcAddr(vk_instance, "vkCmdWriteTimestamp");
         vkCreateAndroidSurfaceKHR = (PFN_vkCreateAndroidSurfaceKHR) vkGetInstanceProcAddr(vk_instance, "vkCreateAndroidSurfaceKHR");
         vkDestroySurfaceKHR = (PFN_vkDestroySurfaceKHR) vkGetInstanceProcAddr(vk_instance, "vkDestroySurfaceKHR");
         vkGetPhysicalDeviceSurfaceSupportKHR = (PFN_vkGetPhysicalDeviceSurfaceSupportKHR) vkGetInstanceProcAddr(vk_instance, "vkGetPhysicalDeviceSurfaceSupportKHR");
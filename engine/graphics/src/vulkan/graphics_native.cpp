@@ -176,11 +176,15 @@ namespace dmGraphics
         {
             VkDevice vk_device = context->m_LogicalDevice.m_Device;
 
+            WaitForPresent(context);
+            DestroyPresentThread(context);
             SynchronizeDevice(vk_device);
 
             glfwCloseWindow();
 
             context->m_PipelineCache.Iterate(DestroyPipelineCacheCb, context);
+            SavePipelineCache(context);
+            DestroyPipelineCache(context);
 
             DestroyDeviceBuffer(vk_device, &context->m_MainTextureDepthStencil.m_DeviceBuffer.m_Handle);
             DestroyTexture(vk_device, &context->m_MainTextureDepthStencil.m_Handle);
@@ -211,6 +215,10 @@ namespace dmGraphics
                 DestroyDescriptorAllocator(vk_device, &context->m_MainDescriptorAllocators[i].m_Handle);
             }
 
+            DestroyThreadResources(context);
+            DestroyTextureTransfers(context);
+            DestroyGpuTimers(context);
+
             for (uint8_t i=0; i < context->m_MainCommandBuffers.Size(); i++)
             {
                 FlushResourcesToDestroy(vk_device, context->m_MainResourcesToDestroy[i]);
@@ -224,6 +232,7 @@ namespace dmGraphics
             }
 
             DestroySwapChain(vk_device, context->m_SwapChain);
+            DestroyMemoryAllocator(vk_device);
             DestroyLogicalDevice(&context->m_LogicalDevice);
             DestroyPhysicalDevice(&context->m_PhysicalDevice);
 
@@ -14,6 +14,7 @@
 #include <dlib/array.h>
 #include <dlib/profile.h>
 #include <dlib/log.h>
+#include <dlib/dstrings.h>
 
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
 
@@ -141,6 +142,13 @@ namespace dmGraphics
         m_VerifyGraphicsCalls     = params.m_VerifyGraphicsCalls;
         m_UseValidationLayers     = params.m_UseValidationLayers;
         m_RenderDocSupport        = params.m_RenderDocSupport;
+        m_PipelineWarmup          = params.m_PipelineWarmup;
+        m_TextureUploadBudget     = params.m_TextureUploadBudget;
+        m_PipelinedPresent        = params.m_PipelinedPresent;
+        if (params.m_PipelineCacheDirectory)
+        {
+            dmStrlCpy(m_PipelineCacheDirectory, params.m_PipelineCacheDirectory, sizeof(m_PipelineCacheDirectory));
+        }
         m_TextureFormatSupport   |= 1 << TEXTURE_FORMAT_LUMINANCE;
         m_TextureFormatSupport   |= 1 << TEXTURE_FORMAT_LUMINANCE_ALPHA;
         m_TextureFormatSupport   |= 1 << TEXTURE_FORMAT_RGB;
@@ -226,6 +234,158 @@ namespace dmGraphics
         return VK_SUCCESS;
     }
 
+    // Creates one set of recording resources per job thread and swap chain image,
+    // the scratch buffers start small and grow to fit the render passes they record.
+    static VkResult CreateThreadResources(HContext context)
+    {
+        VkDevice vk_device                   = context->m_LogicalDevice.m_Device;
+        const uint32_t num_swap_chain_images = context->m_MainCommandBuffers.Size();
+        const uint32_t thread_count          = dmJob::GetWorkerCount(context->m_JobContext) + 1;
+        const uint16_t descriptor_count      = 64;
+        const uint32_t buffer_size           = 256 * descriptor_count;
+
+        context->m_ThreadCount     = thread_count;
+        context->m_ThreadResources = new ThreadResource[thread_count * num_swap_chain_images];
+        memset(&context->m_DynamicState, 0, sizeof(context->m_DynamicState));
+
+        VkCommandPoolCreateInfo vk_create_pool_info;
+        memset(&vk_create_pool_info, 0, sizeof(vk_create_pool_info));
+        vk_create_pool_info.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        vk_create_pool_info.queueFamilyIndex = (uint32_t) context->m_SwapChain->m_QueueFamily.m_GraphicsQueueIx;
+        vk_create_pool_info.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        for (uint32_t i = 0; i < thread_count * num_swap_chain_images; ++i)
+        {
+            ThreadResource& thread_resource = context->m_ThreadResources[i];
+            thread_resource.m_CommandPool        = VK_NULL_HANDLE;
+            thread_resource.m_CommandBufferIndex = 0;
+
+            VkResult res = vkCreateCommandPool(vk_device, &vk_create_pool_info, 0, &thread_resource.m_CommandPool);
+            if (res != VK_SUCCESS)
+            {
+                return res;
+            }
+
+            res = CreateDescriptorAllocator(vk_device, descriptor_count, &thread_resource.m_DescriptorAllocator);
+            if (res != VK_SUCCESS)
+            {
+                return res;
+            }
+
+            res = CreateScratchBuffer(context->m_PhysicalDevice.m_Device, vk_device, buffer_size, true,
+                &thread_resource.m_DescriptorAllocator, &thread_resource.m_ScratchBuffer);
+            if (res != VK_SUCCESS)
+            {
+                return res;
+            }
+        }
+
+        return VK_SUCCESS;
+    }
+
+    void DestroyThreadResources(HContext context)
+    {
+        if (!context->m_ThreadResources)
+        {
+            return;
+        }
+
+        VkDevice vk_device                   = context->m_LogicalDevice.m_Device;
+        const uint32_t num_swap_chain_images = context->m_MainCommandBuffers.Size();
+        for (uint32_t i = 0; i < context->m_ThreadCount * num_swap_chain_images; ++i)
+        {
+            ThreadResource& thread_resource = context->m_ThreadResources[i];
+            if (thread_resource.m_CommandPool != VK_NULL_HANDLE)
+            {
+                // Destroying the pool frees the command buffers allocated from it
+                vkDestroyCommandPool(vk_device, thread_resource.m_CommandPool, 0);
+            }
+            DestroyDeviceBuffer(vk_device, &thread_resource.m_ScratchBuffer.m_DeviceBuffer.m_Handle);
+            DestroyDescriptorAllocator(vk_device, &thread_resource.m_DescriptorAllocator.m_Handle);
+        }
+
+        delete[] context->m_ThreadResources;
+        context->m_ThreadResources = 0;
+        context->m_ThreadCount     = 0;
+    }
+
+    // Creates one timestamp query pool per swap chain image, holding a begin and end query per timer
+    static VkResult CreateGpuTimers(HContext context)
+    {
+        VkDevice vk_device                   = context->m_LogicalDevice.m_Device;
+        const uint32_t num_swap_chain_images = context->m_MainCommandBuffers.Size();
+
+        VkQueryPoolCreateInfo vk_query_pool_info;
+        memset(&vk_query_pool_info, 0, sizeof(vk_query_pool_info));
+        vk_query_pool_info.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        vk_query_pool_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+        vk_query_pool_info.queryCount = MAX_GPU_TIMERS * 2;
+
+        context->m_GpuTimerFrames.SetCapacity(num_swap_chain_images);
+        context->m_GpuTimerFrames.SetSize(num_swap_chain_images);
+        for (uint32_t i = 0; i < num_swap_chain_images; ++i)
+        {
+            context->m_GpuTimerFrames[i].m_QueryPool = VK_NULL_HANDLE;
+            context->m_GpuTimerFrames[i].m_Count     = 0;
+        }
+
+        for (uint32_t i = 0; i < num_swap_chain_images; ++i)
+        {
+            VkResult res = vkCreateQueryPool(vk_device, &vk_query_pool_info, 0, &context->m_GpuTimerFrames[i].m_QueryPool);
+            if (res != VK_SUCCESS)
+            {
+                return res;
+            }
+        }
+
+        return VK_SUCCESS;
+    }
+
+    void DestroyGpuTimers(HContext context)
+    {
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+        for (uint32_t i = 0; i < context->m_GpuTimerFrames.Size(); ++i)
+        {
+            if (context->m_GpuTimerFrames[i].m_QueryPool != VK_NULL_HANDLE)
+            {
+                vkDestroyQueryPool(vk_device, context->m_GpuTimerFrames[i].m_QueryPool, 0);
+            }
+        }
+        context->m_GpuTimerFrames.SetSize(0);
+        context->m_GpuTimerSupport = 0;
+        context->m_GpuTimerStarted = 0;
+    }
+
+    // Reads back the timers recorded the last time this swap chain image was used.
+    // The fence of the frame has been waited on, so results that are not ready are dropped.
+    static void ReadGpuTimers(HContext context, uint32_t frame_ix)
+    {
+        GpuTimerFrame& frame = context->m_GpuTimerFrames[frame_ix];
+        uint32_t count       = frame.m_Count;
+        frame.m_Count        = 0;
+        if (count == 0)
+        {
+            return;
+        }
+
+        uint64_t timestamps[MAX_GPU_TIMERS * 2];
+        VkResult res = vkGetQueryPoolResults(context->m_LogicalDevice.m_Device, frame.m_QueryPool, 0, count * 2,
+            sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (res != VK_SUCCESS)
+        {
+            return;
+        }
+
+        // The timestamp period is the number of nanoseconds per tick
+        double period = (double) context->m_PhysicalDevice.m_Properties.limits.timestampPeriod;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint64_t start = (uint64_t) ((timestamps[i * 2] - timestamps[0]) * period);
+            uint64_t end   = (uint64_t) ((timestamps[i * 2 + 1] - timestamps[0]) * period);
+            dmProfile::AddGpuSample(frame.m_Names[i], frame.m_NameHashes[i], start, end - start);
+        }
+    }
+
     static VkSamplerAddressMode GetVulkanSamplerAddressMode(TextureWrap wrap)
     {
         const VkSamplerAddressMode address_mode_lut[] = {
@@ -338,35 +498,49 @@ namespace dmGraphics
         return -1;
     }
 
-    static bool EndRenderPass(HContext context)
+    static void FlushRenderPass(HContext context, RenderTarget* rt);
+
+    // With thread resources, the commands of a render pass are collected and
+    // recorded when the render pass ends, see FlushRenderPass.
+    static inline bool IsRecordingDeferred(HContext context)
     {
-        assert(context->m_CurrentRenderTarget);
-        if (!context->m_CurrentRenderTarget->m_IsBound)
+        return context->m_ThreadResources != 0;
+    }
+
+    static DrawCommand& PushDrawCommand(HContext context, DrawCommand::Type type)
+    {
+        if (context->m_DrawCommands.Full())
         {
-            return false;
+            context->m_DrawCommands.OffsetCapacity(256);
         }
-
-        vkCmdEndRenderPass(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex]);
-        context->m_CurrentRenderTarget->m_IsBound = 0;
-        return true;
+        context->m_DrawCommands.SetSize(context->m_DrawCommands.Size() + 1);
+        DrawCommand& cmd = context->m_DrawCommands.Back();
+        cmd.m_Type       = type;
+        return cmd;
     }
 
-    static void BeginRenderPass(HContext context, RenderTarget* rt)
+    static bool EndRenderPass(HContext context)
     {
         assert(context->m_CurrentRenderTarget);
-        if (context->m_CurrentRenderTarget->m_Id == rt->m_Id &&
-            context->m_CurrentRenderTarget->m_IsBound)
+        if (!context->m_CurrentRenderTarget->m_IsBound)
         {
-            return;
+            return false;
         }
 
-        // If we bind a render pass without explicitly unbinding
-        // the current render pass, we must first unbind it.
-        if (context->m_CurrentRenderTarget->m_IsBound)
+        if (IsRecordingDeferred(context))
         {
-            EndRenderPass(context);
+            FlushRenderPass(context, context->m_CurrentRenderTarget);
+        }
+        else
+        {
+            vkCmdEndRenderPass(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex]);
         }
+        context->m_CurrentRenderTarget->m_IsBound = 0;
+        return true;
+    }
 
+    static void CmdBeginRenderPass(VkCommandBuffer vk_command_buffer, RenderTarget* rt, VkSubpassContents vk_contents)
+    {
         VkClearValue vk_clear_values[2];
         memset(vk_clear_values, 0, sizeof(vk_clear_values));
 
@@ -389,7 +563,31 @@ namespace dmGraphics
         vk_render_pass_begin_info.clearValueCount = 2;
         vk_render_pass_begin_info.pClearValues    = vk_clear_values;
 
-        vkCmdBeginRenderPass(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex], &vk_render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(vk_command_buffer, &vk_render_pass_begin_info, vk_contents);
+    }
+
+    static void BeginRenderPass(HContext context, RenderTarget* rt)
+    {
+        assert(context->m_CurrentRenderTarget);
+        if (context->m_CurrentRenderTarget->m_Id == rt->m_Id &&
+            context->m_CurrentRenderTarget->m_IsBound)
+        {
+            return;
+        }
+
+        // If we bind a render pass without explicitly unbinding
+        // the current render pass, we must first unbind it.
+        if (context->m_CurrentRenderTarget->m_IsBound)
+        {
+            EndRenderPass(context);
+        }
+
+        // The deferred render pass is begun when it is flushed, once we know
+        // if the commands are recorded inline or into secondary command buffers.
+        if (!IsRecordingDeferred(context))
+        {
+            CmdBeginRenderPass(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex], rt, VK_SUBPASS_CONTENTS_INLINE);
+        }
 
         context->m_CurrentRenderTarget = rt;
         context->m_CurrentRenderTarget->m_IsBound = 1;
@@ -427,8 +625,10 @@ namespace dmGraphics
         *vk_tiling_out = vk_image_tiling;
     }
 
+    // A transient depth/stencil buffer is only used within a render pass, so on tiled GPUs
+    // it can live in tile memory without any device memory committed to it.
     static VkResult CreateDepthStencilTexture(HContext context, VkFormat vk_depth_format, VkImageTiling vk_depth_tiling,
-        uint32_t width, uint32_t height, VkSampleCountFlagBits vk_sample_count, Texture* depth_stencil_texture_out)
+        uint32_t width, uint32_t height, VkSampleCountFlagBits vk_sample_count, bool transient, Texture* depth_stencil_texture_out)
     {
         const VkPhysicalDevice vk_physical_device = context->m_PhysicalDevice.m_Device;
         const VkDevice vk_device                  = context->m_LogicalDevice.m_Device;
@@ -443,13 +643,22 @@ namespace dmGraphics
             vk_aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
         }
 
+        VkImageUsageFlags vk_usage_flags     = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        VkMemoryPropertyFlags vk_memory_type = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        if (transient)
+        {
+            vk_usage_flags |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+            vk_memory_type |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+        }
+
         VkResult res = CreateTexture2D(vk_physical_device, vk_device, width, height, 1,
-            vk_sample_count, vk_depth_format, vk_depth_tiling, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vk_aspect, VK_IMAGE_LAYOUT_UNDEFINED, depth_stencil_texture_out);
+            vk_sample_count, vk_depth_format, vk_depth_tiling, vk_usage_flags,
+            vk_memory_type, vk_aspect, VK_IMAGE_LAYOUT_UNDEFINED, depth_stencil_texture_out);
         CHECK_VK_ERROR(res);
 
         if (res == VK_SUCCESS)
         {
+            WaitForPresent(context);
             res = TransitionImageLayout(vk_device, context->m_LogicalDevice.m_CommandPool, context->m_LogicalDevice.m_GraphicsQueue, depth_stencil_texture_out->m_Handle.m_Image, vk_aspect,
                 VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
             CHECK_VK_ERROR(res);
@@ -542,13 +751,14 @@ namespace dmGraphics
             vk_depth_format, vk_depth_tiling,
             context->m_SwapChain->m_ImageExtent.width,
             context->m_SwapChain->m_ImageExtent.height,
-            context->m_SwapChain->m_SampleCountFlag,
+            context->m_SwapChain->m_SampleCountFlag, false,
             &context->m_MainTextureDepthStencil);
         CHECK_VK_ERROR(res);
 
         // Create main render pass with two attachments
         RenderPassAttachment  attachments[3];
         RenderPassAttachment* attachment_resolve = 0;
+        memset(attachments, 0, sizeof(attachments));
         attachments[0].m_Format      = context->m_SwapChain->m_SurfaceFormat.format;
         attachments[0].m_ImageLayout = context->m_SwapChain->HasMultiSampling() ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
         attachments[1].m_Format      = context->m_MainTextureDepthStencil.m_Format;
@@ -615,6 +825,18 @@ namespace dmGraphics
             context->m_MainDescriptorAllocators.Begin(), context->m_MainScratchBuffers.Begin());
         CHECK_VK_ERROR(res);
 
+        // GPU timers are optional, the profiler simply shows no GPU samples without them
+        if (context->m_PhysicalDevice.m_Properties.limits.timestampComputeAndGraphics)
+        {
+            res = CreateGpuTimers(context);
+            context->m_GpuTimerSupport = res == VK_SUCCESS;
+            if (res != VK_SUCCESS)
+            {
+                dmLogWarning("Could not create GPU timer queries, reason: %s.", VkResultToStr(res));
+                DestroyGpuTimers(context);
+            }
+        }
+
         // Create default pipeline state
         PipelineState vk_default_pipeline;
         vk_default_pipeline.m_WriteColorMask           = DMGRAPHICS_STATE_WRITE_R | DMGRAPHICS_STATE_WRITE_G | DMGRAPHICS_STATE_WRITE_B | DMGRAPHICS_STATE_WRITE_A;
@@ -671,6 +893,7 @@ namespace dmGraphics
     {
         VkDevice vk_device = context->m_LogicalDevice.m_Device;
         // Flush all current commands
+        WaitForPresent(context);
         SynchronizeDevice(vk_device);
 
         DestroyMainFrameBuffers(context);
@@ -707,7 +930,7 @@ namespace dmGraphics
             vk_depth_format, vk_depth_tiling,
             context->m_SwapChain->m_ImageExtent.width,
             context->m_SwapChain->m_ImageExtent.height,
-            context->m_SwapChain->m_SampleCountFlag,
+            context->m_SwapChain->m_SampleCountFlag, false,
             &context->m_MainTextureDepthStencil);
         CHECK_VK_ERROR(res);
 
@@ -756,16 +979,14 @@ namespace dmGraphics
         }
     }
 
-    static inline void SetViewportHelper(VkCommandBuffer vk_command_buffer, int32_t x, int32_t y, int32_t width, int32_t height)
+    static inline void FillViewportHelper(VkViewport* vk_viewport, int32_t x, int32_t y, int32_t width, int32_t height)
     {
-        VkViewport vk_viewport;
-        vk_viewport.x        = (float) x;
-        vk_viewport.y        = (float) y;
-        vk_viewport.width    = (float) width;
-        vk_viewport.height   = (float) height;
-        vk_viewport.minDepth = 0.0f;
-        vk_viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(vk_command_buffer, 0, 1, &vk_viewport);
+        vk_viewport->x        = (float) x;
+        vk_viewport->y        = (float) y;
+        vk_viewport->width    = (float) width;
+        vk_viewport->height   = (float) height;
+        vk_viewport->minDepth = 0.0f;
+        vk_viewport->maxDepth = 1.0f;
     }
 
     static bool IsExtensionSupported(PhysicalDevice* device, const char* ext_name)
@@ -927,6 +1148,7 @@ namespace dmGraphics
 
         context->m_PhysicalDevice   = *selected_device;
         context->m_LogicalDevice    = logical_device;
+        InitializeMemoryAllocator(selected_device->m_Device);
         vk_closest_multisample_flag = GetClosestSampleCountFlag(selected_device, BUFFER_TYPE_COLOR_BIT | BUFFER_TYPE_DEPTH_BIT, params->m_Samples);
 
         // Create swap chain
@@ -946,6 +1168,13 @@ namespace dmGraphics
         context->m_PipelineCache.SetCapacity(32,64);
         context->m_TextureSamplers.SetCapacity(4);
 
+        res = LoadPipelineCache(context);
+        if (res != VK_SUCCESS)
+        {
+            dmLogError("Could not create a pipeline cache for Vulkan, reason: %s", VkResultToStr(res));
+            goto bail;
+        }
+
         // Create framebuffers, default renderpass etc.
         res = CreateMainRenderingResources(context);
         if (res != VK_SUCCESS)
@@ -1049,8 +1278,13 @@ bail:
         out_mag_filter = context->m_DefaultTextureMagFilter;
     }
 
+    static void UploadPendingTextures(HContext context);
+    static void UpdateTextureTransfers(HContext context, VkCommandBuffer vk_command_buffer);
+    static void FlushTextureTransfers(HContext context, Texture* texture, bool acquire);
+
     static void VulkanBeginFrame(HContext context)
     {
+        WaitForPresent(context);
         NativeBeginFrame(context);
 
         FrameResource& current_frame_resource = context->m_FrameResources[context->m_CurrentFrameInFlight];
@@ -1101,6 +1335,39 @@ bail:
         res = scratchBuffer->m_DeviceBuffer.MapMemory(vk_device);
         CHECK_VK_ERROR(res);
 
+        if (context->m_JobContext && !context->m_ThreadResources && dmJob::GetWorkerCount(context->m_JobContext) > 0)
+        {
+            res = CreateThreadResources(context);
+            if (res != VK_SUCCESS)
+            {
+                dmLogError("Could not create resources for recording command buffers on the job threads, reason: %s.", VkResultToStr(res));
+                DestroyThreadResources(context);
+            }
+        }
+
+        // The secondary command buffers recorded with this swap chain image are done,
+        // so the per-thread pools and scratch buffers can be reused.
+        for (uint32_t i = 0; context->m_ThreadResources && i < context->m_ThreadCount; ++i)
+        {
+            ThreadResource& thread_resource = context->m_ThreadResources[frame_ix * context->m_ThreadCount + i];
+            vkResetCommandPool(vk_device, thread_resource.m_CommandPool, 0);
+            thread_resource.m_CommandBufferIndex = 0;
+
+            ResetScratchBuffer(vk_device, &thread_resource.m_ScratchBuffer);
+            res = thread_resource.m_ScratchBuffer.m_DeviceBuffer.MapMemory(vk_device);
+            CHECK_VK_ERROR(res);
+        }
+
+        if (context->m_GpuTimerSupport)
+        {
+            ReadGpuTimers(context, frame_ix);
+        }
+
+        if (context->m_PendingTextureUploads.Size() > 0)
+        {
+            UploadPendingTextures(context);
+        }
+
         VkCommandBufferBeginInfo vk_command_buffer_begin_info;
 
         vk_command_buffer_begin_info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -1109,28 +1376,27 @@ bail:
         vk_command_buffer_begin_info.pNext            = 0;
 
         vkBeginCommandBuffer(context->m_MainCommandBuffers[frame_ix], &vk_command_buffer_begin_info);
+
+        if (context->m_TextureTransfers.Size() > 0)
+        {
+            UpdateTextureTransfers(context, context->m_MainCommandBuffers[frame_ix]);
+        }
+
+        // Queries must be reset outside of a render pass before they are written
+        if (context->m_GpuTimerSupport)
+        {
+            vkCmdResetQueryPool(context->m_MainCommandBuffers[frame_ix], context->m_GpuTimerFrames[frame_ix].m_QueryPool, 0, MAX_GPU_TIMERS * 2);
+        }
+
         context->m_FrameBegun                     = 1;
         context->m_MainRenderTarget.m_Framebuffer = context->m_MainFrameBuffers[frame_ix];
 
         BeginRenderPass(context, context->m_CurrentRenderTarget);
     }
 
-    static void VulkanFlip(HContext context)
+    static void SubmitFrame(HContext context, uint32_t frame_ix, uint8_t frame_in_flight)
     {
-        DM_PROFILE(VSync, "Wait");
-        uint32_t frame_ix = context->m_SwapChain->m_ImageIndex;
-        FrameResource& current_frame_resource = context->m_FrameResources[context->m_CurrentFrameInFlight];
-
-        if (!EndRenderPass(context))
-        {
-            assert(0);
-            return;
-        }
-
-        context->m_MainScratchBuffers[frame_ix].m_DeviceBuffer.UnmapMemory(context->m_LogicalDevice.m_Device);
-
-        VkResult res = vkEndCommandBuffer(context->m_MainCommandBuffers[frame_ix]);
-        CHECK_VK_ERROR(res);
+        FrameResource& frame_resource = context->m_FrameResources[frame_in_flight];
 
         VkPipelineStageFlags vk_pipeline_stage_flags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
@@ -1138,21 +1404,21 @@ bail:
         vk_submit_info.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         vk_submit_info.pNext                = 0;
         vk_submit_info.waitSemaphoreCount   = 1;
-        vk_submit_info.pWaitSemaphores      = &current_frame_resource.m_ImageAvailable;
+        vk_submit_info.pWaitSemaphores      = &frame_resource.m_ImageAvailable;
         vk_submit_info.pWaitDstStageMask    = &vk_pipeline_stage_flags;
         vk_submit_info.commandBufferCount   = 1;
         vk_submit_info.pCommandBuffers      = &context->m_MainCommandBuffers[frame_ix];
         vk_submit_info.signalSemaphoreCount = 1;
-        vk_submit_info.pSignalSemaphores    = &current_frame_resource.m_RenderFinished;
+        vk_submit_info.pSignalSemaphores    = &frame_resource.m_RenderFinished;
 
-        res = vkQueueSubmit(context->m_LogicalDevice.m_GraphicsQueue, 1, &vk_submit_info, current_frame_resource.m_SubmitFence);
+        VkResult res = vkQueueSubmit(context->m_LogicalDevice.m_GraphicsQueue, 1, &vk_submit_info, frame_resource.m_SubmitFence);
         CHECK_VK_ERROR(res);
 
         VkPresentInfoKHR vk_present_info;
         vk_present_info.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
         vk_present_info.pNext              = 0;
         vk_present_info.waitSemaphoreCount = 1;
-        vk_present_info.pWaitSemaphores    = &current_frame_resource.m_RenderFinished;
+        vk_present_info.pWaitSemaphores    = &frame_resource.m_RenderFinished;
         vk_present_info.swapchainCount     = 1;
         vk_present_info.pSwapchains        = &context->m_SwapChain->m_SwapChain;
         vk_present_info.pImageIndices      = &frame_ix;
@@ -1160,90 +1426,285 @@ bail:
 
         res = vkQueuePresentKHR(context->m_LogicalDevice.m_PresentQueue, &vk_present_info);
         CHECK_VK_ERROR(res);
-
-        // Advance frame index
-        context->m_CurrentFrameInFlight = (context->m_CurrentFrameInFlight + 1) % g_max_frames_in_flight;
-        context->m_FrameBegun           = 0;
-
-        NativeSwapBuffers(context);
     }
 
-    static void VulkanSetSwapInterval(HContext context, uint32_t swap_interval)
-    {}
-
-    static void VulkanClear(HContext context, uint32_t flags, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, float depth, uint32_t stencil)
+    // With pipelined presentation, the submit and present of a frame happen on this thread, so that
+    // the time spent in the driver overlaps with the simulation of the next frame on the main thread.
+    // The command buffer and frame resources of the frame are not touched by the main thread until
+    // the next BeginFrame, which waits for the present to finish.
+    static void PresentThread(void* ctx)
     {
-        assert(context->m_CurrentRenderTarget);
-        DM_PROFILE(Graphics, "Clear");
-
-        uint32_t attachment_count = 0;
-        VkClearAttachment vk_clear_attachments[2];
-        memset(vk_clear_attachments, 0, sizeof(vk_clear_attachments));
-
-        VkClearRect vk_clear_rect;
-        vk_clear_rect.rect.offset.x      = 0;
-        vk_clear_rect.rect.offset.y      = 0;
-        vk_clear_rect.rect.extent.width  = context->m_CurrentRenderTarget->m_Extent.width;
-        vk_clear_rect.rect.extent.height = context->m_CurrentRenderTarget->m_Extent.height;
-        vk_clear_rect.baseArrayLayer     = 0;
-        vk_clear_rect.layerCount         = 1;
-
-        bool has_color_texture         = context->m_CurrentRenderTarget->m_Id == DM_RENDERTARGET_BACKBUFFER_ID || context->m_CurrentRenderTarget->m_TextureColor;
-        bool has_depth_stencil_texture = context->m_CurrentRenderTarget->m_Id == DM_RENDERTARGET_BACKBUFFER_ID || context->m_CurrentRenderTarget->m_TextureDepthStencil;
-
-        // Clear color
-        if (has_color_texture && (flags & BUFFER_TYPE_COLOR_BIT))
+        Context* context = (Context*) ctx;
+        dmMutex::Lock(context->m_PresentMutex);
+        while (true)
         {
-            float r = ((float)red)/255.0f;
-            float g = ((float)green)/255.0f;
-            float b = ((float)blue)/255.0f;
-            float a = ((float)alpha)/255.0f;
-
-            VkClearAttachment& vk_color_attachment          = vk_clear_attachments[attachment_count++];
-            vk_color_attachment.aspectMask                  = VK_IMAGE_ASPECT_COLOR_BIT;
-            vk_color_attachment.clearValue.color.float32[0] = r;
-            vk_color_attachment.clearValue.color.float32[1] = g;
-            vk_color_attachment.clearValue.color.float32[2] = b;
-            vk_color_attachment.clearValue.color.float32[3] = a;
-        }
+            while (!context->m_PresentPending && !context->m_PresentThreadExit)
+            {
+                dmConditionVariable::Wait(context->m_PresentCondition, context->m_PresentMutex);
+            }
 
-        // Clear depth / stencil
-        if (has_depth_stencil_texture && (flags & (BUFFER_TYPE_DEPTH_BIT | BUFFER_TYPE_STENCIL_BIT)))
-        {
-            VkImageAspectFlags vk_aspect = 0;
-            if (flags & BUFFER_TYPE_DEPTH_BIT)
+            if (!context->m_PresentPending)
             {
-                vk_aspect |= BUFFER_TYPE_DEPTH_BIT;
+                break;
             }
 
-            if (flags & BUFFER_TYPE_STENCIL_BIT)
+            uint32_t frame_ix      = context->m_PresentImageIndex;
+            uint8_t frame_in_flight = context->m_PresentFrameInFlight;
+            dmMutex::Unlock(context->m_PresentMutex);
+
             {
-                vk_aspect |= BUFFER_TYPE_STENCIL_BIT;
+                DM_PROFILE(Graphics, "Present");
+                SubmitFrame(context, frame_ix, frame_in_flight);
             }
 
-            VkClearAttachment& vk_depth_attachment              = vk_clear_attachments[attachment_count++];
-            vk_depth_attachment.aspectMask                      = vk_aspect;
-            vk_depth_attachment.clearValue.depthStencil.stencil = stencil;
-            vk_depth_attachment.clearValue.depthStencil.depth   = depth;
+            dmMutex::Lock(context->m_PresentMutex);
+            context->m_PresentPending = 0;
+            dmConditionVariable::Broadcast(context->m_PresentCondition);
         }
-
-        vkCmdClearAttachments(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
-            attachment_count, vk_clear_attachments, 1, &vk_clear_rect);
+        dmMutex::Unlock(context->m_PresentMutex);
     }
 
-    static void DeviceBufferUploadHelper(HContext context, const void* data, uint32_t size, uint32_t offset, DeviceBuffer* bufferOut)
+    void WaitForPresent(HContext context)
     {
-        VkResult res;
-
-        if (bufferOut->m_Destroyed || bufferOut->m_Handle.m_Buffer == VK_NULL_HANDLE)
+        if (!context->m_PresentMutex)
         {
-            res = CreateDeviceBuffer(context->m_PhysicalDevice.m_Device, context->m_LogicalDevice.m_Device,
-                size, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, bufferOut);
-            CHECK_VK_ERROR(res);
+            return;
         }
 
-        VkCommandBuffer vk_command_buffer;
-        if (context->m_FrameBegun)
+        DM_PROFILE(VSync, "Wait");
+        DM_MUTEX_SCOPED_LOCK(context->m_PresentMutex);
+        while (context->m_PresentPending)
+        {
+            dmConditionVariable::Wait(context->m_PresentCondition, context->m_PresentMutex);
+        }
+    }
+
+    void DestroyPresentThread(HContext context)
+    {
+        if (!context->m_PresentThread)
+        {
+            return;
+        }
+
+        dmMutex::Lock(context->m_PresentMutex);
+        context->m_PresentThreadExit = 1;
+        dmConditionVariable::Broadcast(context->m_PresentCondition);
+        dmMutex::Unlock(context->m_PresentMutex);
+        dmThread::Join(context->m_PresentThread);
+
+        dmConditionVariable::Delete(context->m_PresentCondition);
+        dmMutex::Delete(context->m_PresentMutex);
+        context->m_PresentThread     = 0;
+        context->m_PresentCondition  = 0;
+        context->m_PresentMutex      = 0;
+        context->m_PresentThreadExit = 0;
+    }
+
+    static void QueuePresent(HContext context, uint32_t frame_ix, uint8_t frame_in_flight)
+    {
+        if (!context->m_PresentThread)
+        {
+            context->m_PresentMutex     = dmMutex::New();
+            context->m_PresentCondition = dmConditionVariable::New();
+            context->m_PresentThread    = dmThread::New(PresentThread, 0x80000, context, "vkpresent");
+        }
+
+        DM_MUTEX_SCOPED_LOCK(context->m_PresentMutex);
+        assert(!context->m_PresentPending);
+        context->m_PresentImageIndex    = frame_ix;
+        context->m_PresentFrameInFlight = frame_in_flight;
+        context->m_PresentPending       = 1;
+        dmConditionVariable::Signal(context->m_PresentCondition);
+    }
+
+    static void VulkanFlip(HContext context)
+    {
+        DM_PROFILE(VSync, "Wait");
+        uint32_t frame_ix = context->m_SwapChain->m_ImageIndex;
+
+        if (!EndRenderPass(context))
+        {
+            assert(0);
+            return;
+        }
+
+        context->m_MainScratchBuffers[frame_ix].m_DeviceBuffer.UnmapMemory(context->m_LogicalDevice.m_Device);
+
+        for (uint32_t i = 0; context->m_ThreadResources && i < context->m_ThreadCount; ++i)
+        {
+            context->m_ThreadResources[frame_ix * context->m_ThreadCount + i].m_ScratchBuffer.m_DeviceBuffer.UnmapMemory(context->m_LogicalDevice.m_Device);
+        }
+
+        VkResult res = vkEndCommandBuffer(context->m_MainCommandBuffers[frame_ix]);
+        CHECK_VK_ERROR(res);
+
+        if (context->m_PipelinedPresent)
+        {
+            QueuePresent(context, frame_ix, context->m_CurrentFrameInFlight);
+        }
+        else
+        {
+            SubmitFrame(context, frame_ix, context->m_CurrentFrameInFlight);
+        }
+
+        // Advance frame index
+        context->m_CurrentFrameInFlight = (context->m_CurrentFrameInFlight + 1) % g_max_frames_in_flight;
+        context->m_FrameBegun           = 0;
+
+        NativeSwapBuffers(context);
+    }
+
+    static void VulkanSetSwapInterval(HContext context, uint32_t swap_interval)
+    {}
+
+    // The thread resources are created at the start of the next frame
+    static void VulkanSetJobContext(HContext context, dmJob::HContext job_context)
+    {
+        assert(!context->m_FrameBegun);
+        if (context->m_JobContext == job_context)
+        {
+            return;
+        }
+
+        if (context->m_ThreadResources)
+        {
+            WaitForPresent(context);
+            SynchronizeDevice(context->m_LogicalDevice.m_Device);
+            DestroyThreadResources(context);
+        }
+        context->m_JobContext = job_context;
+    }
+
+    static void WriteTimestamp(HContext context, uint32_t query, VkPipelineStageFlagBits vk_stage)
+    {
+        VkQueryPool vk_query_pool = context->m_GpuTimerFrames[context->m_SwapChain->m_ImageIndex].m_QueryPool;
+        if (IsRecordingDeferred(context))
+        {
+            DrawCommand& cmd             = PushDrawCommand(context, DrawCommand::TYPE_TIMESTAMP);
+            cmd.m_Timestamp.m_QueryPool  = vk_query_pool;
+            cmd.m_Timestamp.m_Query      = query;
+            cmd.m_Timestamp.m_Stage      = vk_stage;
+            return;
+        }
+
+        vkCmdWriteTimestamp(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex], vk_stage, vk_query_pool, query);
+    }
+
+    static void VulkanBeginGpuTimer(HContext context, const char* name, uint32_t name_hash)
+    {
+        if (!context->m_GpuTimerSupport || !context->m_FrameBegun || context->m_GpuTimerStarted)
+        {
+            return;
+        }
+
+        GpuTimerFrame& frame = context->m_GpuTimerFrames[context->m_SwapChain->m_ImageIndex];
+        if (frame.m_Count == MAX_GPU_TIMERS)
+        {
+            return;
+        }
+
+        WriteTimestamp(context, frame.m_Count * 2, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        frame.m_Names[frame.m_Count]      = name;
+        frame.m_NameHashes[frame.m_Count] = name_hash;
+        context->m_GpuTimerStarted        = 1;
+    }
+
+    static void VulkanEndGpuTimer(HContext context)
+    {
+        if (!context->m_GpuTimerStarted)
+        {
+            return;
+        }
+
+        GpuTimerFrame& frame = context->m_GpuTimerFrames[context->m_SwapChain->m_ImageIndex];
+        WriteTimestamp(context, frame.m_Count * 2 + 1, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+        frame.m_Count++;
+        context->m_GpuTimerStarted = 0;
+    }
+
+    static void VulkanClear(HContext context, uint32_t flags, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, float depth, uint32_t stencil)
+    {
+        assert(context->m_CurrentRenderTarget);
+        DM_PROFILE(Graphics, "Clear");
+
+        uint32_t attachment_count = 0;
+        VkClearAttachment vk_clear_attachments[2];
+        memset(vk_clear_attachments, 0, sizeof(vk_clear_attachments));
+
+        VkClearRect vk_clear_rect;
+        vk_clear_rect.rect.offset.x      = 0;
+        vk_clear_rect.rect.offset.y      = 0;
+        vk_clear_rect.rect.extent.width  = context->m_CurrentRenderTarget->m_Extent.width;
+        vk_clear_rect.rect.extent.height = context->m_CurrentRenderTarget->m_Extent.height;
+        vk_clear_rect.baseArrayLayer     = 0;
+        vk_clear_rect.layerCount         = 1;
+
+        bool has_color_texture         = context->m_CurrentRenderTarget->m_Id == DM_RENDERTARGET_BACKBUFFER_ID || context->m_CurrentRenderTarget->m_TextureColor;
+        bool has_depth_stencil_texture = context->m_CurrentRenderTarget->m_Id == DM_RENDERTARGET_BACKBUFFER_ID || context->m_CurrentRenderTarget->m_TextureDepthStencil;
+
+        // Clear color
+        if (has_color_texture && (flags & BUFFER_TYPE_COLOR_BIT))
+        {
+            float r = ((float)red)/255.0f;
+            float g = ((float)green)/255.0f;
+            float b = ((float)blue)/255.0f;
+            float a = ((float)alpha)/255.0f;
+
+            VkClearAttachment& vk_color_attachment          = vk_clear_attachments[attachment_count++];
+            vk_color_attachment.aspectMask                  = VK_IMAGE_ASPECT_COLOR_BIT;
+            vk_color_attachment.clearValue.color.float32[0] = r;
+            vk_color_attachment.clearValue.color.float32[1] = g;
+            vk_color_attachment.clearValue.color.float32[2] = b;
+            vk_color_attachment.clearValue.color.float32[3] = a;
+        }
+
+        // Clear depth / stencil
+        if (has_depth_stencil_texture && (flags & (BUFFER_TYPE_DEPTH_BIT | BUFFER_TYPE_STENCIL_BIT)))
+        {
+            VkImageAspectFlags vk_aspect = 0;
+            if (flags & BUFFER_TYPE_DEPTH_BIT)
+            {
+                vk_aspect |= BUFFER_TYPE_DEPTH_BIT;
+            }
+
+            if (flags & BUFFER_TYPE_STENCIL_BIT)
+            {
+                vk_aspect |= BUFFER_TYPE_STENCIL_BIT;
+            }
+
+            VkClearAttachment& vk_depth_attachment              = vk_clear_attachments[attachment_count++];
+            vk_depth_attachment.aspectMask                      = vk_aspect;
+            vk_depth_attachment.clearValue.depthStencil.stencil = stencil;
+            vk_depth_attachment.clearValue.depthStencil.depth   = depth;
+        }
+
+        if (IsRecordingDeferred(context))
+        {
+            DrawCommand& cmd              = PushDrawCommand(context, DrawCommand::TYPE_CLEAR);
+            cmd.m_Clear.m_Attachments[0]  = vk_clear_attachments[0];
+            cmd.m_Clear.m_Attachments[1]  = vk_clear_attachments[1];
+            cmd.m_Clear.m_Rect            = vk_clear_rect;
+            cmd.m_Clear.m_AttachmentCount = attachment_count;
+            return;
+        }
+
+        vkCmdClearAttachments(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
+            attachment_count, vk_clear_attachments, 1, &vk_clear_rect);
+    }
+
+    static void DeviceBufferUploadHelper(HContext context, const void* data, uint32_t size, uint32_t offset, DeviceBuffer* bufferOut)
+    {
+        VkResult res;
+
+        if (bufferOut->m_Destroyed || bufferOut->m_Handle.m_Buffer == VK_NULL_HANDLE)
+        {
+            res = CreateDeviceBuffer(context->m_PhysicalDevice.m_Device, context->m_LogicalDevice.m_Device,
+                size, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, bufferOut);
+            CHECK_VK_ERROR(res);
+        }
+
+        VkCommandBuffer vk_command_buffer;
+        if (context->m_FrameBegun)
         {
             vk_command_buffer = context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex];
         }
@@ -1309,10 +1770,12 @@ bail:
         resource->m_Destroyed = 1;
     }
 
-    static Pipeline* GetOrCreatePipeline(VkDevice vk_device, VkSampleCountFlagBits vk_sample_count,
-        const PipelineState pipelineState, PipelineCache& pipelineCache,
-        Program* program, RenderTarget* rt, DeviceBuffer* vertexBuffer, HVertexDeclaration vertexDeclaration)
+    static Pipeline* GetOrCreatePipeline(HContext context, VkSampleCountFlagBits vk_sample_count,
+        const PipelineState pipelineState, Program* program, RenderTarget* rt,
+        DeviceBuffer* vertexBuffer, HVertexDeclaration vertexDeclaration)
     {
+        PipelineCache& pipelineCache = context->m_PipelineCache;
+
         HashState64 pipeline_hash_state;
         dmHashInit64(&pipeline_hash_state, false);
         dmHashUpdateBuffer64(&pipeline_hash_state, &program->m_Hash, sizeof(program->m_Hash));
@@ -1334,9 +1797,17 @@ bail:
             vk_scissor.offset.x = 0;
             vk_scissor.offset.y = 0;
 
-            VkResult res = CreatePipeline(vk_device, vk_scissor, vk_sample_count, pipelineState, program, vertexBuffer, vertexDeclaration, rt->m_RenderPass, &new_pipeline);
+            VkResult res = CreatePipeline(context->m_LogicalDevice.m_Device, context->m_DevicePipelineCache, vk_scissor, vk_sample_count,
+                pipelineState, program, vertexBuffer, vertexDeclaration, rt->m_RenderPass, &new_pipeline);
             CHECK_VK_ERROR(res);
 
+            // Render target ids are handed out at runtime, so only pipelines for
+            // the main render target can be matched again on the next launch
+            if (context->m_PipelineWarmup && rt->m_Id == DM_RENDERTARGET_BACKBUFFER_ID)
+            {
+                AddPipelineWarmupEntry(context, pipeline_hash, program->m_Hash, pipelineState, vk_sample_count, vertexDeclaration);
+            }
+
             if (pipelineCache.Full())
             {
                 pipelineCache.SetCapacity(32, pipelineCache.Capacity() + 4);
@@ -1352,6 +1823,22 @@ bail:
         return cached_pipeline;
     }
 
+    static void WarmupPipelines(HContext context, Program* program)
+    {
+        // Create the pipelines this program used during earlier runs, so that
+        // the driver compiles them now instead of during the first draw call
+        const VkSampleCountFlagBits vk_sample_count = context->m_SwapChain->m_SampleCountFlag;
+        for (uint32_t i = 0; i < context->m_PipelineWarmupEntries.Size(); ++i)
+        {
+            PipelineWarmupEntry& entry = context->m_PipelineWarmupEntries[i];
+            if (entry.m_ProgramHash == program->m_Hash && entry.m_SampleCount == vk_sample_count)
+            {
+                GetOrCreatePipeline(context, vk_sample_count, entry.m_PipelineState, program,
+                    &context->m_MainRenderTarget, 0, &entry.m_VertexDeclaration);
+            }
+        }
+    }
+
     static HVertexBuffer VulkanNewVertexBuffer(HContext context, uint32_t size, const void* data, BufferUsage buffer_usage)
     {
         DeviceBuffer* buffer = new DeviceBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
@@ -1515,7 +2002,7 @@ bail:
         return 0;
     }
 
-    static inline VkFormat GetVulkanFormatFromTypeAndSize(Type type, uint16_t size)
+    static inline VkFormat GetVulkanFormatFromTypeAndSize(Type type, uint16_t size, bool normalize)
     {
         if (type == TYPE_FLOAT)
         {
@@ -1524,6 +2011,13 @@ bail:
             else if(size == 3) return VK_FORMAT_R32G32B32_SFLOAT;
             else if(size == 4) return VK_FORMAT_R32G32B32A32_SFLOAT;
         }
+        else if (type == TYPE_UNSIGNED_BYTE && normalize)
+        {
+            if (size == 1)     return VK_FORMAT_R8_UNORM;
+            else if(size == 2) return VK_FORMAT_R8G8_UNORM;
+            else if(size == 3) return VK_FORMAT_R8G8B8_UNORM;
+            else if(size == 4) return VK_FORMAT_R8G8B8A8_UNORM;
+        }
         else if (type == TYPE_UNSIGNED_BYTE)
         {
             if (size == 1)     return VK_FORMAT_R8_UINT;
@@ -1531,6 +2025,13 @@ bail:
             else if(size == 3) return VK_FORMAT_R8G8B8_UINT;
             else if(size == 4) return VK_FORMAT_R8G8B8A8_UINT;
         }
+        else if (type == TYPE_UNSIGNED_SHORT && normalize)
+        {
+            if (size == 1)     return VK_FORMAT_R16_UNORM;
+            else if(size == 2) return VK_FORMAT_R16G16_UNORM;
+            else if(size == 3) return VK_FORMAT_R16G16B16_UNORM;
+            else if(size == 4) return VK_FORMAT_R16G16B16A16_UNORM;
+        }
         else if (type == TYPE_UNSIGNED_SHORT)
         {
             if (size == 1)     return VK_FORMAT_R16_UINT;
@@ -1565,7 +2066,7 @@ bail:
         {
             VertexElement& el           = element[i];
             vd->m_Streams[i].m_NameHash = dmHashString64(el.m_Name);
-            vd->m_Streams[i].m_Format   = GetVulkanFormatFromTypeAndSize(el.m_Type, el.m_Size);
+            vd->m_Streams[i].m_Format   = GetVulkanFormatFromTypeAndSize(el.m_Type, el.m_Size, el.m_Normalize);
             vd->m_Streams[i].m_Offset   = vd->m_Stride;
             vd->m_Streams[i].m_Location = 0;
             vd->m_Stride               += el.m_Size * GetGraphicsTypeSize(el.m_Type);
@@ -1655,14 +2156,32 @@ bail:
                uniform.m_Type == ShaderDesc::SHADER_TYPE_SAMPLER_CUBE;
     }
 
-    static void UpdateDescriptorSets(
-        VkDevice            vk_device,
-        VkDescriptorSet     vk_descriptor_set,
-        Program*            program,
-        Program::ModuleType module_type,
-        ScratchBuffer*      scratch_buffer,
-        uint32_t            dynamic_alignment,
-        uint32_t*           dynamic_offsets_out)
+    static inline void GetTextureImageInfo(HContext context, const ShaderResourceBinding& res, VkDescriptorImageInfo* vk_image_info)
+    {
+        Texture* texture           = context->m_TextureUnits[res.m_TextureUnit];
+        // Textures are not available until their uploads on the transfer queue are done
+        if (texture->m_TransferState)
+        {
+            texture = context->m_DefaultTexture;
+        }
+        vk_image_info->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vk_image_info->imageView   = texture->m_Handle.m_ImageView;
+        vk_image_info->sampler     = context->m_TextureSamplers[texture->m_TextureSamplerIndex].m_Sampler;
+    }
+
+    // Copies the uniform data of a module to the scratch buffer and returns the descriptor set to bind for it.
+    // The uniform data and image infos are read from the program and the bound texture units,
+    // unless a snapshot taken when the draw call was issued is passed in.
+    static VkResult UpdateDescriptorSet(
+        VkDevice                     vk_device,
+        Program*                     program,
+        Program::ModuleType          module_type,
+        ScratchBuffer*               scratch_buffer,
+        const uint8_t*               uniform_data,
+        const VkDescriptorImageInfo* image_infos,
+        uint32_t                     dynamic_alignment,
+        uint32_t*                    dynamic_offsets_out,
+        VkDescriptorSet*             vk_descriptor_set_out)
     {
         ShaderModule* shader_module;
         uint32_t*     uniform_data_offsets;
@@ -1684,28 +2203,81 @@ bail:
             assert(0);
         }
 
-        if (shader_module->m_UniformCount == 0)
+        VkDescriptorSetLayout vk_descriptor_set_layout = program->m_Handle.m_DescriptorSetLayout[module_type];
+        VkDescriptorImageInfo vk_image_infos[DM_MAX_TEXTURE_UNITS];
+        uint32_t image_count = 0;
+
+        // The uniform buffer descriptors only depend on the layout and the scratch buffer,
+        // the uniform data itself is selected with the dynamic offsets
+        HashState64 key_state;
+        dmHashInit64(&key_state, false);
+        dmHashUpdateBuffer64(&key_state, &vk_descriptor_set_layout, sizeof(vk_descriptor_set_layout));
+        dmHashUpdateBuffer64(&key_state, &scratch_buffer->m_DeviceBuffer.m_Handle.m_Buffer, sizeof(VkBuffer));
+
+        for (uint32_t i = 0; i < shader_module->m_UniformCount; ++i)
         {
-            return;
+            ShaderResourceBinding& res = shader_module->m_Uniforms[i];
+            if (IsUniformTextureSampler(res))
+            {
+                assert(image_count < DM_MAX_TEXTURE_UNITS);
+                VkDescriptorImageInfo& vk_image_info = vk_image_infos[image_count++];
+                if (image_infos)
+                {
+                    vk_image_info = *image_infos++;
+                }
+                else
+                {
+                    GetTextureImageInfo(g_VulkanContext, res, &vk_image_info);
+                }
+                dmHashUpdateBuffer64(&key_state, &vk_image_info.imageView, sizeof(vk_image_info.imageView));
+                dmHashUpdateBuffer64(&key_state, &vk_image_info.sampler, sizeof(vk_image_info.sampler));
+            }
+            else
+            {
+                dynamic_offsets[res.m_UniformDataIndex] = (uint32_t) scratch_buffer->m_MappedDataCursor;
+                const uint32_t uniform_size_nonalign    = GetShaderTypeSize(res.m_Type);
+                const uint32_t uniform_size             = DM_ALIGN(uniform_size_nonalign, dynamic_alignment);
+
+                // Copy client data to aligned host memory
+                // The data_offset here is the offset into the programs uniform data,
+                // i.e the source buffer.
+                const uint32_t data_offset = uniform_data_offsets[res.m_UniformDataIndex];
+                memcpy(&((uint8_t*)scratch_buffer->m_DeviceBuffer.m_MappedDataPtr)[scratch_buffer->m_MappedDataCursor],
+                    &uniform_data[data_offset], uniform_size_nonalign);
+
+                scratch_buffer->m_MappedDataCursor += uniform_size;
+            }
+        }
+
+        const uint64_t key = dmHashFinal64(&key_state);
+        DescriptorSetCacheEntry& cache_entry = scratch_buffer->m_DescriptorSetCache[key % DM_DESCRIPTOR_SET_CACHE_SIZE];
+        if (cache_entry.m_Key == key && cache_entry.m_DescriptorSet != VK_NULL_HANDLE)
+        {
+            *vk_descriptor_set_out = cache_entry.m_DescriptorSet;
+            return VK_SUCCESS;
+        }
+
+        VkDescriptorSet* vk_descriptor_set = 0x0;
+        VkResult result = scratch_buffer->m_DescriptorAllocator->Allocate(vk_device, &vk_descriptor_set_layout, 1, &vk_descriptor_set);
+        if (result != VK_SUCCESS)
+        {
+            return result;
         }
 
         const uint8_t max_write_descriptors = 16;
-        uint16_t uniforms_to_write          = shader_module->m_UniformCount;
         uint16_t uniform_to_write_index     = 0;
-        uint16_t uniform_index              = 0;
-        uint16_t image_to_write_index       = 0;
         uint16_t buffer_to_write_index      = 0;
+        uint32_t image_index                = 0;
         VkWriteDescriptorSet vk_write_descriptors[max_write_descriptors];
-        VkDescriptorImageInfo vk_write_image_descriptors[max_write_descriptors];
         VkDescriptorBufferInfo vk_write_buffer_descriptors[max_write_descriptors];
 
-        while(uniforms_to_write > 0)
+        for (uint32_t i = 0; i < shader_module->m_UniformCount; ++i)
         {
-            ShaderResourceBinding& res = shader_module->m_Uniforms[uniform_index++];
+            ShaderResourceBinding& res = shader_module->m_Uniforms[i];
             VkWriteDescriptorSet& vk_write_desc_info = vk_write_descriptors[uniform_to_write_index++];
             vk_write_desc_info.sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
             vk_write_desc_info.pNext            = 0;
-            vk_write_desc_info.dstSet           = vk_descriptor_set;
+            vk_write_desc_info.dstSet           = *vk_descriptor_set;
             vk_write_desc_info.dstBinding       = res.m_Binding;
             vk_write_desc_info.dstArrayElement  = 0;
             vk_write_desc_info.descriptorCount  = 1;
@@ -1715,27 +2287,11 @@ bail:
 
             if (IsUniformTextureSampler(res))
             {
-                Texture* texture = g_VulkanContext->m_TextureUnits[res.m_TextureUnit];
-                VkDescriptorImageInfo& vk_image_info = vk_write_image_descriptors[image_to_write_index++];
-                vk_image_info.imageLayout         = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                vk_image_info.imageView           = texture->m_Handle.m_ImageView;
-                vk_image_info.sampler             = g_VulkanContext->m_TextureSamplers[texture->m_TextureSamplerIndex].m_Sampler;
                 vk_write_desc_info.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                vk_write_desc_info.pImageInfo     = &vk_image_info;
+                vk_write_desc_info.pImageInfo     = &vk_image_infos[image_index++];
             }
             else
             {
-                dynamic_offsets[res.m_UniformDataIndex] = (uint32_t) scratch_buffer->m_MappedDataCursor;
-                const uint32_t uniform_size_nonalign    = GetShaderTypeSize(res.m_Type);
-                const uint32_t uniform_size             = DM_ALIGN(uniform_size_nonalign, dynamic_alignment);
-
-                // Copy client data to aligned host memory
-                // The data_offset here is the offset into the programs uniform data,
-                // i.e the source buffer.
-                const uint32_t data_offset = uniform_data_offsets[res.m_UniformDataIndex];
-                memcpy(&((uint8_t*)scratch_buffer->m_DeviceBuffer.m_MappedDataPtr)[scratch_buffer->m_MappedDataCursor],
-                    &program->m_UniformData[data_offset], uniform_size_nonalign);
-
                 // Note in the spec about the offset being zero:
                 //   "For VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC and VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC descriptor types,
                 //    offset is the base offset from which the dynamic offset is applied and range is the static size
@@ -1743,21 +2299,16 @@ bail:
                 VkDescriptorBufferInfo& vk_buffer_info = vk_write_buffer_descriptors[buffer_to_write_index++];
                 vk_buffer_info.buffer = scratch_buffer->m_DeviceBuffer.m_Handle.m_Buffer;
                 vk_buffer_info.offset = 0;
-                vk_buffer_info.range  = uniform_size;
+                vk_buffer_info.range  = DM_ALIGN(GetShaderTypeSize(res.m_Type), dynamic_alignment);
                 vk_write_desc_info.descriptorType   = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
                 vk_write_desc_info.pBufferInfo      = &vk_buffer_info;
-
-                scratch_buffer->m_MappedDataCursor += uniform_size;
             }
 
-            uniforms_to_write--;
-
             // Commit and restart if we reached max descriptors per batch
             if (uniform_to_write_index == max_write_descriptors)
             {
                 vkUpdateDescriptorSets(vk_device, max_write_descriptors, vk_write_descriptors, 0, 0);
                 uniform_to_write_index = 0;
-                image_to_write_index = 0;
                 buffer_to_write_index = 0;
             }
         }
@@ -1766,30 +2317,45 @@ bail:
         {
             vkUpdateDescriptorSets(vk_device, uniform_to_write_index, vk_write_descriptors, 0, 0);
         }
+
+        cache_entry.m_Key           = key;
+        cache_entry.m_DescriptorSet = *vk_descriptor_set;
+        *vk_descriptor_set_out      = *vk_descriptor_set;
+        return VK_SUCCESS;
     }
 
     static VkResult CommitUniforms(VkCommandBuffer vk_command_buffer, VkDevice vk_device,
         Program* program_ptr, ScratchBuffer* scratch_buffer,
+        const uint8_t* uniform_data, const VkDescriptorImageInfo* image_infos,
         uint32_t* dynamic_offsets, const uint32_t alignment)
     {
-        VkDescriptorSet* vk_descriptor_set_list = 0x0;
-        VkResult res = scratch_buffer->m_DescriptorAllocator->Allocate(vk_device, program_ptr->m_Handle.m_DescriptorSetLayout, DM_MAX_SET_COUNT, &vk_descriptor_set_list);
+        // The image info snapshot holds the vertex samplers followed by the fragment samplers
+        const VkDescriptorImageInfo* fs_image_infos = 0;
+        if (image_infos)
+        {
+            fs_image_infos = image_infos + (program_ptr->m_VertexModule->m_UniformCount - program_ptr->m_VertexModule->m_UniformBufferCount);
+        }
+
+        VkDescriptorSet vk_descriptor_set_list[Program::MODULE_TYPE_COUNT];
+        VkResult res = UpdateDescriptorSet(vk_device, program_ptr,
+            Program::MODULE_TYPE_VERTEX, scratch_buffer,
+            uniform_data, image_infos, alignment, dynamic_offsets,
+            &vk_descriptor_set_list[Program::MODULE_TYPE_VERTEX]);
         if (res != VK_SUCCESS)
         {
             return res;
         }
 
-        const uint32_t num_uniform_buffers = program_ptr->m_VertexModule->m_UniformBufferCount + program_ptr->m_FragmentModule->m_UniformBufferCount;
-        VkDescriptorSet vs_set = vk_descriptor_set_list[Program::MODULE_TYPE_VERTEX];
-        VkDescriptorSet fs_set = vk_descriptor_set_list[Program::MODULE_TYPE_FRAGMENT];
-
-        UpdateDescriptorSets(vk_device, vs_set, program_ptr,
-            Program::MODULE_TYPE_VERTEX, scratch_buffer,
-            alignment, dynamic_offsets);
-        UpdateDescriptorSets(vk_device, fs_set, program_ptr,
+        res = UpdateDescriptorSet(vk_device, program_ptr,
             Program::MODULE_TYPE_FRAGMENT, scratch_buffer,
-            alignment, dynamic_offsets);
+            uniform_data, fs_image_infos, alignment, dynamic_offsets,
+            &vk_descriptor_set_list[Program::MODULE_TYPE_FRAGMENT]);
+        if (res != VK_SUCCESS)
+        {
+            return res;
+        }
 
+        const uint32_t num_uniform_buffers = program_ptr->m_VertexModule->m_UniformBufferCount + program_ptr->m_FragmentModule->m_UniformBufferCount;
         vkCmdBindDescriptorSets(vk_command_buffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS, program_ptr->m_Handle.m_PipelineLayout,
             0, Program::MODULE_TYPE_COUNT, vk_descriptor_set_list,
@@ -1816,36 +2382,9 @@ bail:
         return res;
     }
 
-    static void DrawSetup(HContext context, VkCommandBuffer vk_command_buffer, ScratchBuffer* scratchBuffer, DeviceBuffer* indexBuffer, Type indexBufferType)
+    static void EnsureDynamicOffsetBuffer(HContext context, uint32_t num_uniform_buffers)
     {
-        DeviceBuffer* vertex_buffer = context->m_CurrentVertexBuffer;
-        Program* program_ptr        = context->m_CurrentProgram;
-        VkDevice vk_device          = context->m_LogicalDevice.m_Device;
-
-        // Ensure there is room in the descriptor allocator to support this draw call
-        bool resize_desc_allocator = (scratchBuffer->m_DescriptorAllocator->m_DescriptorIndex + DM_MAX_SET_COUNT) >
-            scratchBuffer->m_DescriptorAllocator->m_DescriptorMax;
-        bool resize_scratch_buffer = (program_ptr->m_VertexModule->m_UniformDataSizeAligned +
-            program_ptr->m_FragmentModule->m_UniformDataSizeAligned) > (scratchBuffer->m_DeviceBuffer.m_MemorySize - scratchBuffer->m_MappedDataCursor);
-
-        const uint8_t descriptor_increase = 32;
-        if (resize_desc_allocator)
-        {
-            VkResult res = ResizeDescriptorAllocator(context, scratchBuffer->m_DescriptorAllocator, scratchBuffer->m_DescriptorAllocator->m_DescriptorMax + descriptor_increase);
-            CHECK_VK_ERROR(res);
-        }
-
-        if (resize_scratch_buffer)
-        {
-            const uint32_t bytes_increase = 256 * descriptor_increase;
-            VkResult res = ResizeScratchBuffer(context, scratchBuffer->m_DeviceBuffer.m_MemorySize + bytes_increase, scratchBuffer);
-            CHECK_VK_ERROR(res);
-        }
-
-        // Ensure we have enough room in the dynamic offset buffer to support the uniforms for this draw call
-        const uint32_t num_uniform_buffers = program_ptr->m_VertexModule->m_UniformBufferCount + program_ptr->m_FragmentModule->m_UniformBufferCount;
-
-        if (context->m_DynamicOffsetBufferSize < num_uniform_buffers)
+        if (context->m_DynamicOffsetBufferSize < num_uniform_buffers)
         {
             if (context->m_DynamicOffsetBuffer == 0x0)
             {
@@ -1858,13 +2397,11 @@ bail:
 
             context->m_DynamicOffsetBufferSize = num_uniform_buffers;
         }
+    }
 
-        // Write the uniform data to the descriptors
-        uint32_t dynamic_alignment = (uint32_t) context->m_PhysicalDevice.m_Properties.limits.minUniformBufferOffsetAlignment;
-        VkResult res = CommitUniforms(vk_command_buffer, vk_device,
-            program_ptr, scratchBuffer, context->m_DynamicOffsetBuffer, dynamic_alignment);
-        CHECK_VK_ERROR(res);
-
+    // Returns true if the viewport and scissor needs to be set before the next draw call
+    static bool UpdateViewportState(HContext context, VkViewport* vk_viewport_out, VkRect2D* vk_scissor_out)
+    {
         // If the culling, or viewport has changed, make sure to flip the
         // culling flag if we are rendering to the backbuffer.
         // This is needed because we are rendering with a negative viewport
@@ -1884,35 +2421,36 @@ bail:
             }
             context->m_CullFaceChanged = 0;
         }
-        // Update the viewport
-        if (context->m_ViewportChanged)
+
+        if (!context->m_ViewportChanged)
         {
-            Viewport& vp = context->m_MainViewport;
+            return false;
+        }
 
-            // If we are rendering to the backbuffer, we must invert the viewport on
-            // the y axis. Otherwise we just use the values as-is.
-            // If we don't, all FBO rendering will be upside down.
-            if (context->m_CurrentRenderTarget->m_Id == DM_RENDERTARGET_BACKBUFFER_ID)
-            {
-                SetViewportHelper(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
-                    vp.m_X, (context->m_WindowHeight - vp.m_Y), vp.m_W, -vp.m_H);
-            }
-            else
-            {
-                SetViewportHelper(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
-                    vp.m_X, vp.m_Y, vp.m_W, vp.m_H);
-            }
+        Viewport& vp = context->m_MainViewport;
 
-            VkRect2D vk_scissor;
-            vk_scissor.extent   = context->m_CurrentRenderTarget->m_Extent;
-            vk_scissor.offset.x = 0;
-            vk_scissor.offset.y = 0;
+        // If we are rendering to the backbuffer, we must invert the viewport on
+        // the y axis. Otherwise we just use the values as-is.
+        // If we don't, all FBO rendering will be upside down.
+        if (context->m_CurrentRenderTarget->m_Id == DM_RENDERTARGET_BACKBUFFER_ID)
+        {
+            FillViewportHelper(vk_viewport_out, vp.m_X, (context->m_WindowHeight - vp.m_Y), vp.m_W, -vp.m_H);
+        }
+        else
+        {
+            FillViewportHelper(vk_viewport_out, vp.m_X, vp.m_Y, vp.m_W, vp.m_H);
+        }
 
-            vkCmdSetScissor(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex], 0, 1, &vk_scissor);
+        vk_scissor_out->extent   = context->m_CurrentRenderTarget->m_Extent;
+        vk_scissor_out->offset.x = 0;
+        vk_scissor_out->offset.y = 0;
 
-            context->m_ViewportChanged = 0;
-        }
+        context->m_ViewportChanged = 0;
+        return true;
+    }
 
+    static Pipeline* GetDrawPipeline(HContext context)
+    {
         // Get the pipeline for the active draw state
         VkSampleCountFlagBits vk_sample_count = VK_SAMPLE_COUNT_1_BIT;
         if (context->m_CurrentRenderTarget->m_Id == DM_RENDERTARGET_BACKBUFFER_ID)
@@ -1920,10 +2458,58 @@ bail:
             vk_sample_count = context->m_SwapChain->m_SampleCountFlag;
         }
 
-        Pipeline* pipeline = GetOrCreatePipeline(vk_device, vk_sample_count,
-            context->m_PipelineState, context->m_PipelineCache,
-            program_ptr, context->m_CurrentRenderTarget,
-            vertex_buffer, context->m_CurrentVertexDeclaration);
+        return GetOrCreatePipeline(context, vk_sample_count, context->m_PipelineState,
+            context->m_CurrentProgram, context->m_CurrentRenderTarget,
+            context->m_CurrentVertexBuffer, context->m_CurrentVertexDeclaration);
+    }
+
+    static void DrawSetup(HContext context, VkCommandBuffer vk_command_buffer, ScratchBuffer* scratchBuffer, DeviceBuffer* indexBuffer, Type indexBufferType)
+    {
+        DeviceBuffer* vertex_buffer = context->m_CurrentVertexBuffer;
+        Program* program_ptr        = context->m_CurrentProgram;
+        VkDevice vk_device          = context->m_LogicalDevice.m_Device;
+
+        // Ensure there is room in the descriptor allocator to support this draw call
+        bool resize_desc_allocator = (scratchBuffer->m_DescriptorAllocator->m_DescriptorIndex + DM_MAX_SET_COUNT) >
+            scratchBuffer->m_DescriptorAllocator->m_DescriptorMax;
+        bool resize_scratch_buffer = (program_ptr->m_VertexModule->m_UniformDataSizeAligned +
+            program_ptr->m_FragmentModule->m_UniformDataSizeAligned) > (scratchBuffer->m_DeviceBuffer.m_MemorySize - scratchBuffer->m_MappedDataCursor);
+
+        const uint8_t descriptor_increase = 32;
+        if (resize_desc_allocator)
+        {
+            VkResult res = ResizeDescriptorAllocator(context, scratchBuffer->m_DescriptorAllocator, scratchBuffer->m_DescriptorAllocator->m_DescriptorMax + descriptor_increase);
+            CHECK_VK_ERROR(res);
+        }
+
+        if (resize_scratch_buffer)
+        {
+            const uint32_t bytes_increase = 256 * descriptor_increase;
+            VkResult res = ResizeScratchBuffer(context, scratchBuffer->m_DeviceBuffer.m_MemorySize + bytes_increase, scratchBuffer);
+            CHECK_VK_ERROR(res);
+        }
+
+        // Ensure we have enough room in the dynamic offset buffer to support the uniforms for this draw call
+        const uint32_t num_uniform_buffers = program_ptr->m_VertexModule->m_UniformBufferCount + program_ptr->m_FragmentModule->m_UniformBufferCount;
+        EnsureDynamicOffsetBuffer(context, num_uniform_buffers);
+
+        // Write the uniform data to the descriptors
+        uint32_t dynamic_alignment = (uint32_t) context->m_PhysicalDevice.m_Properties.limits.minUniformBufferOffsetAlignment;
+        VkResult res = CommitUniforms(vk_command_buffer, vk_device,
+            program_ptr, scratchBuffer, program_ptr->m_UniformData, 0,
+            context->m_DynamicOffsetBuffer, dynamic_alignment);
+        CHECK_VK_ERROR(res);
+
+        // Update the viewport
+        VkViewport vk_viewport;
+        VkRect2D vk_scissor;
+        if (UpdateViewportState(context, &vk_viewport, &vk_scissor))
+        {
+            vkCmdSetViewport(vk_command_buffer, 0, 1, &vk_viewport);
+            vkCmdSetScissor(vk_command_buffer, 0, 1, &vk_scissor);
+        }
+
+        Pipeline* pipeline = GetDrawPipeline(context);
         vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *pipeline);
 
 
@@ -1947,6 +2533,365 @@ bail:
         vkCmdBindVertexBuffers(vk_command_buffer, 0, 1, &vk_vertex_buffer, &vk_vertex_buffer_offsets);
     }
 
+    static void PushTextureImageInfos(HContext context, ShaderModule* shader_module)
+    {
+        dmArray<VkDescriptorImageInfo>& image_infos = context->m_DrawImageInfos;
+        for (uint32_t i = 0; i < shader_module->m_UniformCount; ++i)
+        {
+            ShaderResourceBinding& res = shader_module->m_Uniforms[i];
+            if (IsUniformTextureSampler(res))
+            {
+                if (image_infos.Full())
+                {
+                    image_infos.OffsetCapacity(256);
+                }
+                image_infos.SetSize(image_infos.Size() + 1);
+                GetTextureImageInfo(context, res, &image_infos.Back());
+            }
+        }
+    }
+
+    // Resolves the pipeline and takes a snapshot of the uniforms and textures of a draw call,
+    // the descriptors are written when the render pass is flushed.
+    static void DeferDraw(HContext context, DrawCommand::Type type, DeviceBuffer* indexBuffer, Type indexBufferType, uint32_t first, uint32_t count)
+    {
+        Program* program_ptr = context->m_CurrentProgram;
+
+        const uint32_t num_uniform_buffers = program_ptr->m_VertexModule->m_UniformBufferCount + program_ptr->m_FragmentModule->m_UniformBufferCount;
+        EnsureDynamicOffsetBuffer(context, num_uniform_buffers);
+
+        VkViewport vk_viewport;
+        VkRect2D vk_scissor;
+        if (UpdateViewportState(context, &vk_viewport, &vk_scissor))
+        {
+            DrawCommand& viewport_cmd = PushDrawCommand(context, DrawCommand::TYPE_VIEWPORT);
+            viewport_cmd.m_Viewport.m_Viewport = vk_viewport;
+            viewport_cmd.m_Viewport.m_Scissor  = vk_scissor;
+        }
+
+        Pipeline* pipeline = GetDrawPipeline(context);
+
+        dmArray<uint8_t>& uniform_data     = context->m_DrawUniformData;
+        const uint32_t uniform_data_offset = uniform_data.Size();
+        if (program_ptr->m_UniformDataSize > 0)
+        {
+            if (uniform_data.Remaining() < program_ptr->m_UniformDataSize)
+            {
+                uniform_data.OffsetCapacity(dmMath::Max(program_ptr->m_UniformDataSize, (uint32_t) 4096));
+            }
+            uniform_data.SetSize(uniform_data_offset + program_ptr->m_UniformDataSize);
+            memcpy(uniform_data.Begin() + uniform_data_offset, program_ptr->m_UniformData, program_ptr->m_UniformDataSize);
+        }
+
+        const uint32_t image_info_offset = context->m_DrawImageInfos.Size();
+        PushTextureImageInfos(context, program_ptr->m_VertexModule);
+        PushTextureImageInfos(context, program_ptr->m_FragmentModule);
+
+        DrawCommand& cmd               = PushDrawCommand(context, type);
+        cmd.m_Draw.m_Program           = program_ptr;
+        cmd.m_Draw.m_Pipeline          = *pipeline;
+        cmd.m_Draw.m_VertexBuffer      = context->m_CurrentVertexBuffer->m_Handle.m_Buffer;
+        cmd.m_Draw.m_IndexBuffer       = VK_NULL_HANDLE;
+        cmd.m_Draw.m_IndexType         = VK_INDEX_TYPE_UINT16;
+        cmd.m_Draw.m_UniformDataOffset = uniform_data_offset;
+        cmd.m_Draw.m_ImageInfoOffset   = image_info_offset;
+        cmd.m_Draw.m_First             = first;
+        cmd.m_Draw.m_Count             = count;
+
+        if (indexBuffer)
+        {
+            assert(indexBufferType == TYPE_UNSIGNED_SHORT || indexBufferType == TYPE_UNSIGNED_INT);
+            cmd.m_Draw.m_IndexBuffer = indexBuffer->m_Handle.m_Buffer;
+            cmd.m_Draw.m_IndexType   = indexBufferType == TYPE_UNSIGNED_INT ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+        }
+
+        context->m_DrawUniformSize += program_ptr->m_VertexModule->m_UniformDataSizeAligned + program_ptr->m_FragmentModule->m_UniformDataSizeAligned;
+        context->m_DrawCount++;
+    }
+
+    static void SetDynamicState(VkCommandBuffer vk_command_buffer, const DynamicState& state)
+    {
+        if (state.m_HasViewport)
+        {
+            vkCmdSetViewport(vk_command_buffer, 0, 1, &state.m_Viewport);
+            vkCmdSetScissor(vk_command_buffer, 0, 1, &state.m_Scissor);
+        }
+
+        if (state.m_HasDepthBias)
+        {
+            vkCmdSetDepthBias(vk_command_buffer, state.m_DepthBiasFactor, 0.0, state.m_DepthBiasUnits);
+        }
+    }
+
+    // Records a range of deferred commands. This is called from the job threads,
+    // so it must only touch the command buffer and scratch buffer passed in.
+    static void RecordDrawCommands(HContext context, VkCommandBuffer vk_command_buffer, ScratchBuffer* scratchBuffer,
+        uint32_t* dynamic_offsets, const DynamicState& state, uint32_t start, uint32_t end)
+    {
+        VkDevice vk_device         = context->m_LogicalDevice.m_Device;
+        uint32_t dynamic_alignment = (uint32_t) context->m_PhysicalDevice.m_Properties.limits.minUniformBufferOffsetAlignment;
+
+        SetDynamicState(vk_command_buffer, state);
+
+        for (uint32_t i = start; i < end; ++i)
+        {
+            const DrawCommand& cmd = context->m_DrawCommands[i];
+            switch(cmd.m_Type)
+            {
+                case DrawCommand::TYPE_VIEWPORT:
+                    vkCmdSetViewport(vk_command_buffer, 0, 1, &cmd.m_Viewport.m_Viewport);
+                    vkCmdSetScissor(vk_command_buffer, 0, 1, &cmd.m_Viewport.m_Scissor);
+                    break;
+                case DrawCommand::TYPE_DEPTH_BIAS:
+                    vkCmdSetDepthBias(vk_command_buffer, cmd.m_DepthBias.m_Factor, 0.0, cmd.m_DepthBias.m_Units);
+                    break;
+                case DrawCommand::TYPE_CLEAR:
+                    vkCmdClearAttachments(vk_command_buffer, cmd.m_Clear.m_AttachmentCount, cmd.m_Clear.m_Attachments, 1, &cmd.m_Clear.m_Rect);
+                    break;
+                case DrawCommand::TYPE_TIMESTAMP:
+                    vkCmdWriteTimestamp(vk_command_buffer, cmd.m_Timestamp.m_Stage, cmd.m_Timestamp.m_QueryPool, cmd.m_Timestamp.m_Query);
+                    break;
+                case DrawCommand::TYPE_DRAW:
+                case DrawCommand::TYPE_DRAW_INDEXED:
+                {
+                    VkResult res = CommitUniforms(vk_command_buffer, vk_device,
+                        cmd.m_Draw.m_Program, scratchBuffer,
+                        context->m_DrawUniformData.Begin() + cmd.m_Draw.m_UniformDataOffset,
+                        context->m_DrawImageInfos.Begin() + cmd.m_Draw.m_ImageInfoOffset,
+                        dynamic_offsets, dynamic_alignment);
+                    CHECK_VK_ERROR(res);
+
+                    vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, cmd.m_Draw.m_Pipeline);
+
+                    VkDeviceSize vk_vertex_buffer_offsets = 0;
+                    vkCmdBindVertexBuffers(vk_command_buffer, 0, 1, &cmd.m_Draw.m_VertexBuffer, &vk_vertex_buffer_offsets);
+
+                    if (cmd.m_Type == DrawCommand::TYPE_DRAW_INDEXED)
+                    {
+                        vkCmdBindIndexBuffer(vk_command_buffer, cmd.m_Draw.m_IndexBuffer, 0, cmd.m_Draw.m_IndexType);
+                        vkCmdDrawIndexed(vk_command_buffer, cmd.m_Draw.m_Count, 1, cmd.m_Draw.m_First, 0, 0);
+                    }
+                    else
+                    {
+                        vkCmdDraw(vk_command_buffer, cmd.m_Draw.m_Count, 1, cmd.m_Draw.m_First, 0);
+                    }
+                } break;
+                default:
+                    assert(0);
+            }
+        }
+    }
+
+    static VkResult ReserveScratchBuffer(HContext context, ScratchBuffer* scratchBuffer, uint32_t data_size, uint32_t descriptor_count)
+    {
+        DescriptorAllocator* descriptor_allocator = scratchBuffer->m_DescriptorAllocator;
+        if ((descriptor_allocator->m_DescriptorIndex + descriptor_count) > descriptor_allocator->m_DescriptorMax)
+        {
+            // Should match the bit count of DescriptorAllocator::m_DescriptorMax
+            const uint32_t max_descriptor_count = 0x7fff;
+            VkResult res = ResizeDescriptorAllocator(context, descriptor_allocator,
+                dmMath::Min(max_descriptor_count, descriptor_allocator->m_DescriptorMax + descriptor_count));
+            if (res != VK_SUCCESS)
+            {
+                return res;
+            }
+        }
+
+        if (data_size > (scratchBuffer->m_DeviceBuffer.m_MemorySize - scratchBuffer->m_MappedDataCursor))
+        {
+            return ResizeScratchBuffer(context, scratchBuffer->m_DeviceBuffer.m_MemorySize + data_size, scratchBuffer);
+        }
+
+        return VK_SUCCESS;
+    }
+
+    static VkCommandBuffer GetSecondaryCommandBuffer(VkDevice vk_device, ThreadResource* thread_resource)
+    {
+        if (thread_resource->m_CommandBufferIndex == thread_resource->m_CommandBuffers.Size())
+        {
+            VkCommandBuffer vk_command_buffer;
+            VkResult res = CreateCommandBuffers(vk_device, thread_resource->m_CommandPool, 1, &vk_command_buffer, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+            CHECK_VK_ERROR(res);
+
+            if (thread_resource->m_CommandBuffers.Full())
+            {
+                thread_resource->m_CommandBuffers.OffsetCapacity(4);
+            }
+            thread_resource->m_CommandBuffers.Push(vk_command_buffer);
+        }
+        return thread_resource->m_CommandBuffers[thread_resource->m_CommandBufferIndex++];
+    }
+
+    struct RecordCommandRangesContext
+    {
+        HContext      m_Context;
+        RenderTarget* m_RenderTarget;
+        uint32_t      m_ImageIndex;
+    };
+
+    static void RecordCommandRanges(void* _ctx, uint32_t start, uint32_t end)
+    {
+        DM_PROFILE(Graphics, "RecordCommandRanges");
+        RecordCommandRangesContext* ctx = (RecordCommandRangesContext*) _ctx;
+        HContext context                = ctx->m_Context;
+        VkDevice vk_device              = context->m_LogicalDevice.m_Device;
+
+        uint32_t thread_index           = dmJob::GetThreadIndex(context->m_JobContext);
+        ThreadResource* thread_resource = &context->m_ThreadResources[ctx->m_ImageIndex * context->m_ThreadCount + thread_index];
+
+        VkCommandBufferInheritanceInfo vk_inheritance_info;
+        memset(&vk_inheritance_info, 0, sizeof(vk_inheritance_info));
+        vk_inheritance_info.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        vk_inheritance_info.renderPass  = ctx->m_RenderTarget->m_RenderPass;
+        vk_inheritance_info.subpass     = 0;
+        vk_inheritance_info.framebuffer = ctx->m_RenderTarget->m_Framebuffer;
+
+        VkCommandBufferBeginInfo vk_command_buffer_begin_info;
+        vk_command_buffer_begin_info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        vk_command_buffer_begin_info.flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vk_command_buffer_begin_info.pInheritanceInfo = &vk_inheritance_info;
+        vk_command_buffer_begin_info.pNext            = 0;
+
+        for (uint32_t i = start; i < end; ++i)
+        {
+            CommandRange& range = context->m_CommandRanges[i];
+            VkCommandBuffer vk_command_buffer = GetSecondaryCommandBuffer(vk_device, thread_resource);
+
+            vkBeginCommandBuffer(vk_command_buffer, &vk_command_buffer_begin_info);
+            RecordDrawCommands(context, vk_command_buffer, &thread_resource->m_ScratchBuffer,
+                thread_resource->m_DynamicOffsets.Begin(), range.m_State, range.m_Start, range.m_End);
+            VkResult res = vkEndCommandBuffer(vk_command_buffer);
+            CHECK_VK_ERROR(res);
+
+            range.m_CommandBuffer = vk_command_buffer;
+        }
+    }
+
+    // Render passes with fewer draw calls per job thread than this are recorded inline on the main thread
+    static const uint32_t MIN_DRAW_COMMANDS_PER_RANGE = 64;
+
+    static void FlushRenderPass(HContext context, RenderTarget* rt)
+    {
+        DM_PROFILE(Graphics, "FlushRenderPass");
+        const uint32_t image_ix           = context->m_SwapChain->m_ImageIndex;
+        const uint32_t command_count      = context->m_DrawCommands.Size();
+        const uint32_t descriptor_count   = context->m_DrawCount * DM_MAX_SET_COUNT;
+        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
+
+        uint32_t range_count = (context->m_DrawCount + MIN_DRAW_COMMANDS_PER_RANGE - 1) / MIN_DRAW_COMMANDS_PER_RANGE;
+        range_count = dmMath::Max((uint32_t) 1, dmMath::Min(context->m_ThreadCount, range_count));
+        const uint32_t draws_per_range = (context->m_DrawCount + range_count - 1) / range_count;
+
+        // Split the commands into ranges with the same number of draw calls, and keep
+        // track of the dynamic state that is active at the start of each range.
+        dmArray<CommandRange>& ranges = context->m_CommandRanges;
+        if (ranges.Capacity() < range_count)
+        {
+            ranges.SetCapacity(range_count);
+        }
+        ranges.SetSize(1);
+        ranges[0].m_State         = context->m_DynamicState;
+        ranges[0].m_CommandBuffer = VK_NULL_HANDLE;
+        ranges[0].m_Start         = 0;
+
+        DynamicState& state       = context->m_DynamicState;
+        uint32_t range_draw_count = 0;
+        for (uint32_t i = 0; i < command_count; ++i)
+        {
+            if (draws_per_range > 0 && range_draw_count == draws_per_range)
+            {
+                ranges.Back().m_End = i;
+
+                CommandRange range;
+                range.m_State         = state;
+                range.m_CommandBuffer = VK_NULL_HANDLE;
+                range.m_Start         = i;
+                ranges.Push(range);
+                range_draw_count = 0;
+            }
+
+            const DrawCommand& cmd = context->m_DrawCommands[i];
+            if (cmd.m_Type == DrawCommand::TYPE_VIEWPORT)
+            {
+                state.m_Viewport    = cmd.m_Viewport.m_Viewport;
+                state.m_Scissor     = cmd.m_Viewport.m_Scissor;
+                state.m_HasViewport = 1;
+            }
+            else if (cmd.m_Type == DrawCommand::TYPE_DEPTH_BIAS)
+            {
+                state.m_DepthBiasFactor = cmd.m_DepthBias.m_Factor;
+                state.m_DepthBiasUnits  = cmd.m_DepthBias.m_Units;
+                state.m_HasDepthBias    = 1;
+            }
+            else if (cmd.m_Type == DrawCommand::TYPE_DRAW || cmd.m_Type == DrawCommand::TYPE_DRAW_INDEXED)
+            {
+                range_draw_count++;
+            }
+        }
+        ranges.Back().m_End = command_count;
+
+        if (ranges.Size() == 1)
+        {
+            ScratchBuffer* scratch_buffer = &context->m_MainScratchBuffers[image_ix];
+            VkResult res = ReserveScratchBuffer(context, scratch_buffer, context->m_DrawUniformSize, descriptor_count);
+            CHECK_VK_ERROR(res);
+
+            CmdBeginRenderPass(vk_command_buffer, rt, VK_SUBPASS_CONTENTS_INLINE);
+            RecordDrawCommands(context, vk_command_buffer, scratch_buffer,
+                context->m_DynamicOffsetBuffer, ranges[0].m_State, 0, command_count);
+        }
+        else
+        {
+            // We don't know which thread records which range, so every thread
+            // needs room for all the uniforms and descriptors of the render pass.
+            for (uint32_t i = 0; i < context->m_ThreadCount; ++i)
+            {
+                ThreadResource& thread_resource = context->m_ThreadResources[image_ix * context->m_ThreadCount + i];
+                VkResult res = ReserveScratchBuffer(context, &thread_resource.m_ScratchBuffer, context->m_DrawUniformSize, descriptor_count);
+                CHECK_VK_ERROR(res);
+
+                if (thread_resource.m_DynamicOffsets.Size() < context->m_DynamicOffsetBufferSize)
+                {
+                    thread_resource.m_DynamicOffsets.SetCapacity(context->m_DynamicOffsetBufferSize);
+                    thread_resource.m_DynamicOffsets.SetSize(context->m_DynamicOffsetBufferSize);
+                }
+            }
+
+            CmdBeginRenderPass(vk_command_buffer, rt, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+            RecordCommandRangesContext ctx;
+            ctx.m_Context      = context;
+            ctx.m_RenderTarget = rt;
+            ctx.m_ImageIndex   = image_ix;
+            dmJob::HJob job = dmJob::ParallelFor(context->m_JobContext, RecordCommandRanges, &ctx, ranges.Size(), 1, dmJob::INVALID_JOB);
+            if (job != dmJob::INVALID_JOB)
+            {
+                dmJob::Wait(context->m_JobContext, job);
+            }
+
+            dmArray<VkCommandBuffer>& secondary_command_buffers = context->m_SecondaryCommandBuffers;
+            if (secondary_command_buffers.Capacity() < ranges.Size())
+            {
+                secondary_command_buffers.SetCapacity(ranges.Size());
+            }
+            secondary_command_buffers.SetSize(ranges.Size());
+            for (uint32_t i = 0; i < ranges.Size(); ++i)
+            {
+                secondary_command_buffers[i] = ranges[i].m_CommandBuffer;
+            }
+
+            vkCmdExecuteCommands(vk_command_buffer, secondary_command_buffers.Size(), secondary_command_buffers.Begin());
+        }
+
+        vkCmdEndRenderPass(vk_command_buffer);
+
+        context->m_DrawCommands.SetSize(0);
+        context->m_DrawUniformData.SetSize(0);
+        context->m_DrawImageInfos.SetSize(0);
+        context->m_DrawUniformSize = 0;
+        context->m_DrawCount       = 0;
+    }
+
     void VulkanHashVertexDeclaration(HashState32 *state, HVertexDeclaration vertex_declaration)
     {
         uint16_t stream_count = vertex_declaration->m_StreamCount;
@@ -1968,24 +2913,64 @@ bail:
         const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
         VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
         context->m_PipelineState.m_PrimtiveType = prim_type;
+
+        // The 'first' value that comes in is intended to be a byte offset,
+        // but vkCmdDrawIndexed only operates with actual offset values into the index buffer
+        uint32_t index_offset = first / (type == TYPE_UNSIGNED_SHORT ? 2 : 4);
+
+        if (IsRecordingDeferred(context))
+        {
+            DeferDraw(context, DrawCommand::TYPE_DRAW_INDEXED, (DeviceBuffer*) index_buffer, type, index_offset, count);
+            return;
+        }
+
         DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], (DeviceBuffer*) index_buffer, type);
+        vkCmdDrawIndexed(vk_command_buffer, count, 1, index_offset, 0, 0);
+    }
+
+    static void VulkanDraw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count)
+    {
+        assert(context->m_FrameBegun);
+        DM_PROFILE(Graphics, "Draw");
+        DM_COUNTER("DrawCalls", 1);
+        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
+        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
+        context->m_PipelineState.m_PrimtiveType = prim_type;
+
+        if (IsRecordingDeferred(context))
+        {
+            DeferDraw(context, DrawCommand::TYPE_DRAW, 0, TYPE_BYTE, first, count);
+            return;
+        }
+
+        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], 0, TYPE_BYTE);
+        vkCmdDraw(vk_command_buffer, count, 1, first, 0);
+    }
+
+    // Pipelines are created with a single vertex binding, so per-instance streams are not
+    // supported yet. Callers check IsInstancingSupported and fall back to non-instanced draws.
+    static bool VulkanIsInstancingSupported(HContext context)
+    {
+        return false;
+    }
+
+    static void VulkanEnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t first_instance, HProgram program)
+    {
+        assert(0 && "Instancing is not supported by the Vulkan adapter");
+    }
 
-        // The 'first' value that comes in is intended to be a byte offset,
-        // but vkCmdDrawIndexed only operates with actual offset values into the index buffer
-        uint32_t index_offset = first / (type == TYPE_UNSIGNED_SHORT ? 2 : 4);
-        vkCmdDrawIndexed(vk_command_buffer, count, 1, index_offset, 0, 0);
+    static void VulkanDisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    {
     }
 
-    static void VulkanDraw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count)
+    static void VulkanDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
     {
-        assert(context->m_FrameBegun);
-        DM_PROFILE(Graphics, "Draw");
-        DM_COUNTER("DrawCalls", 1);
-        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
-        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
-        context->m_PipelineState.m_PrimtiveType = prim_type;
-        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], 0, TYPE_BYTE);
-        vkCmdDraw(vk_command_buffer, count, 1, first, 0);
+        assert(0 && "Instancing is not supported by the Vulkan adapter");
+    }
+
+    static void VulkanDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        assert(0 && "Instancing is not supported by the Vulkan adapter");
     }
 
     static void CreateShaderResourceBindings(ShaderModule* shader, ShaderDesc::Shader* ddf, uint32_t dynamicAlignment)
@@ -2135,6 +3120,7 @@ bail:
         program->m_Hash               = 0;
         program->m_UniformDataOffsets = 0;
         program->m_UniformData        = 0;
+        program->m_UniformDataSize    = 0;
         program->m_VertexModule       = vertex_module;
         program->m_FragmentModule     = fragment_module;
 
@@ -2174,8 +3160,9 @@ bail:
                 vs_last_offset, &program->m_UniformDataOffsets[vertex_module->m_UniformBufferCount], num_buffers,
                 &fs_last_offset, &vk_descriptor_set_bindings[vertex_module->m_UniformCount]);
 
-            program->m_UniformData = new uint8_t[vs_last_offset + fs_last_offset];
-            memset(program->m_UniformData, 0, vs_last_offset + fs_last_offset);
+            program->m_UniformDataSize = vs_last_offset + fs_last_offset;
+            program->m_UniformData     = new uint8_t[program->m_UniformDataSize];
+            memset(program->m_UniformData, 0, program->m_UniformDataSize);
 
             VkDescriptorSetLayoutCreateInfo vk_set_create_info[Program::MODULE_TYPE_COUNT];
             memset(&vk_set_create_info, 0, sizeof(vk_set_create_info));
@@ -2209,6 +3196,7 @@ bail:
     {
         Program* program = new Program;
         CreateProgram(context, program, (ShaderModule*) vertex_program, (ShaderModule*) fragment_program);
+        WarmupPipelines(context, program);
         return (HProgram) program;
     }
 
@@ -2664,6 +3652,14 @@ bail:
     static void VulkanSetPolygonOffset(HContext context, float factor, float units)
     {
         assert(context);
+        if (IsRecordingDeferred(context))
+        {
+            DrawCommand& cmd         = PushDrawCommand(context, DrawCommand::TYPE_DEPTH_BIAS);
+            cmd.m_DepthBias.m_Factor = factor;
+            cmd.m_DepthBias.m_Units  = units;
+            return;
+        }
+
         vkCmdSetDepthBias(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
             factor, 0.0, units);
     }
@@ -2728,6 +3724,7 @@ bail:
             rp_attachment_color = &rp_attachments[0];
             rp_attachment_color->m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
             rp_attachment_color->m_Format      = colorTexture->m_Format;
+            rp_attachment_color->m_Transient   = false;
 
             fb_attachments[fb_attachment_count++] = colorTexture->m_Handle.m_ImageView;
         }
@@ -2747,6 +3744,7 @@ bail:
             rp_attachment_depth_stencil                = &rp_attachments[1];
             rp_attachment_depth_stencil->m_ImageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
             rp_attachment_depth_stencil->m_Format      = depthStencilTexture->m_Format;
+            rp_attachment_depth_stencil->m_Transient   = rtOut->m_TransientDepthStencil;
 
             fb_attachments[fb_attachment_count++] = depthStencilTexture->m_Handle.m_ImageView;
         }
@@ -2860,11 +3858,16 @@ bail:
                 GetDepthFormatAndTiling(context->m_PhysicalDevice.m_Device, 0, 0, &vk_depth_stencil_format, &vk_depth_tiling);
             }
 
+            // The depth and stencil buffers share a texture, which can only be transient if both buffers are
+            uint8_t stencil_buffer_index = GetBufferTypeIndex(BUFFER_TYPE_STENCIL_BIT);
+            rt->m_TransientDepthStencil  = (!has_depth   || creation_params[depth_buffer_index].m_Transient) &&
+                                           (!has_stencil || creation_params[stencil_buffer_index].m_Transient);
+
             texture_depth_stencil = NewTexture(context, creation_params[depth_buffer_index]);
             VkResult res = CreateDepthStencilTexture(context,
                 vk_depth_stencil_format, vk_depth_tiling,
                 fb_width, fb_height, VK_SAMPLE_COUNT_1_BIT, // No support for multisampled FBOs
-                texture_depth_stencil);
+                rt->m_TransientDepthStencil, texture_depth_stencil);
             CHECK_VK_ERROR(res);
         }
 
@@ -2950,7 +3953,7 @@ bail:
 
             VkResult res = CreateDepthStencilTexture(g_VulkanContext,
                 vk_depth_stencil_format, vk_image_tiling,
-                width, height, VK_SAMPLE_COUNT_1_BIT,
+                width, height, VK_SAMPLE_COUNT_1_BIT, render_target->m_TransientDepthStencil,
                 render_target->m_TextureDepthStencil);
             CHECK_VK_ERROR(res);
         }
@@ -2965,8 +3968,16 @@ bail:
         return (context->m_TextureFormatSupport & (1 << format)) != 0;
     }
 
+    // Textures are created as single layer images, and the shader descriptions have no sampler type
+    // for arrays yet. Callers check IsTextureTypeSupported and fall back to one texture per layer.
+    static bool VulkanIsTextureTypeSupported(HContext context, TextureType type)
+    {
+        return type != TEXTURE_TYPE_2D_ARRAY;
+    }
+
     static HTexture VulkanNewTexture(HContext context, const TextureCreationParams& params)
     {
+        assert(VulkanIsTextureTypeSupported(context, params.m_Type) && "Texture arrays are not supported by the Vulkan adapter");
         Texture* tex = new Texture;
         InitializeVulkanTexture(tex);
 
@@ -2991,6 +4002,20 @@ bail:
 
     static void VulkanDeleteTexture(HTexture t)
     {
+        if (t->m_DataState)
+        {
+            dmArray<PendingTextureUpload>& uploads = g_VulkanContext->m_PendingTextureUploads;
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < uploads.Size(); ++i)
+            {
+                if (uploads[i].m_Texture != t)
+                {
+                    uploads[count++] = uploads[i];
+                }
+            }
+            uploads.SetSize(count);
+        }
+        FlushTextureTransfers(g_VulkanContext, t, false);
         DestroyResourceDeferred(g_VulkanContext->m_MainResourcesToDestroy[g_VulkanContext->m_SwapChain->m_ImageIndex], t);
         delete t;
     }
@@ -3024,6 +4049,9 @@ bail:
         VkDevice vk_device = context->m_LogicalDevice.m_Device;
         uint8_t layer_count = GetLayerCount(textureOut);
 
+        // The upload is submitted to the graphics queue, which the present thread may be using
+        WaitForPresent(context);
+
         // TODO There is potentially a bunch of redundancy here.
         //      * Can we use a single command buffer for these updates,
         //        and not create a new one in every transition?
@@ -3118,6 +4146,382 @@ bail:
         }
     }
 
+    // Staging memory for the uploads on the transfer queue
+    static const uint32_t TRANSFER_RING_SIZE      = 8 * 1024 * 1024;
+    // A multiple of 4 and of every texel block size we upload (1 to 16 bytes, including 3 and 12),
+    // as required for the buffer offset of a buffer to image copy
+    static const uint32_t TRANSFER_RING_ALIGNMENT = 48;
+
+    static inline bool IsTransferQueueDedicated(HContext context)
+    {
+        return context->m_LogicalDevice.m_TransferQueue != context->m_LogicalDevice.m_GraphicsQueue;
+    }
+
+    // The ring is empty when head and tail are equal, so an allocation never fills it up completely
+    static bool AllocateTransferRing(HContext context, uint32_t size, uint32_t* offset_out)
+    {
+        uint32_t head = ((context->m_TransferRingHead + TRANSFER_RING_ALIGNMENT - 1) / TRANSFER_RING_ALIGNMENT) * TRANSFER_RING_ALIGNMENT;
+        uint32_t tail = context->m_TransferRingTail;
+
+        if (context->m_TransferRingHead >= tail)
+        {
+            if (head + size <= TRANSFER_RING_SIZE)
+            {
+                *offset_out = head;
+            }
+            else if (size < tail)
+            {
+                *offset_out = 0;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (head + size < tail)
+        {
+            *offset_out = head;
+        }
+        else
+        {
+            return false;
+        }
+
+        context->m_TransferRingHead = *offset_out + size;
+        return true;
+    }
+
+    static void GetTextureTransferBarrier(Texture* texture, uint16_t mipmap, uint16_t layer_count,
+        VkImageLayout vk_from_layout, VkImageLayout vk_to_layout, VkImageMemoryBarrier* vk_barrier)
+    {
+        memset(vk_barrier, 0, sizeof(*vk_barrier));
+        vk_barrier->sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        vk_barrier->oldLayout                       = vk_from_layout;
+        vk_barrier->newLayout                       = vk_to_layout;
+        vk_barrier->srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        vk_barrier->dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        vk_barrier->image                           = texture->m_Handle.m_Image;
+        vk_barrier->subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        vk_barrier->subresourceRange.baseMipLevel   = mipmap;
+        vk_barrier->subresourceRange.levelCount     = 1;
+        vk_barrier->subresourceRange.baseArrayLayer = 0;
+        vk_barrier->subresourceRange.layerCount     = layer_count;
+    }
+
+    // With a dedicated transfer queue, the image is released by the transfer queue when the upload
+    // is done and must be acquired by the graphics queue before it can be sampled.
+    static void AcquireTextureTransfer(HContext context, VkCommandBuffer vk_command_buffer, const TextureTransfer& transfer)
+    {
+        VkImageMemoryBarrier vk_barrier;
+        GetTextureTransferBarrier(transfer.m_Texture, transfer.m_MipMap, transfer.m_LayerCount,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &vk_barrier);
+        vk_barrier.srcQueueFamilyIndex = context->m_SwapChain->m_QueueFamily.m_TransferQueueIx;
+        vk_barrier.dstQueueFamilyIndex = context->m_SwapChain->m_QueueFamily.m_GraphicsQueueIx;
+        vk_barrier.srcAccessMask       = 0;
+        vk_barrier.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 0, 0, 0, 0, 1, &vk_barrier);
+    }
+
+    static void FreeTextureTransfer(HContext context, const TextureTransfer& transfer)
+    {
+        if (transfer.m_StageBuffer.m_Buffer != VK_NULL_HANDLE)
+        {
+            DeviceBuffer::VulkanHandle stage_buffer = transfer.m_StageBuffer;
+            DestroyDeviceBuffer(context->m_LogicalDevice.m_Device, &stage_buffer);
+        }
+
+        context->m_TransferRingTail = transfer.m_RingEnd;
+
+        if (context->m_FreeTextureTransfers.Full())
+        {
+            context->m_FreeTextureTransfers.OffsetCapacity(8);
+        }
+        context->m_FreeTextureTransfers.Push(transfer);
+    }
+
+    // Makes the textures with finished uploads available for sampling. The acquire barriers
+    // are recorded to the command buffer of the frame, before the first render pass.
+    static void UpdateTextureTransfers(HContext context, VkCommandBuffer vk_command_buffer)
+    {
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+        dmArray<TextureTransfer>& transfers = context->m_TextureTransfers;
+        uint32_t count = transfers.Size();
+        uint32_t i = 0;
+
+        // Uploads are submitted to the same queue, so they finish in order
+        for (; i < count; ++i)
+        {
+            TextureTransfer& transfer = transfers[i];
+            if (vkWaitForFences(vk_device, 1, &transfer.m_Fence, VK_TRUE, 0) != VK_SUCCESS)
+            {
+                break;
+            }
+
+            if (transfer.m_Texture)
+            {
+                if (IsTransferQueueDedicated(context))
+                {
+                    AcquireTextureTransfer(context, vk_command_buffer, transfer);
+                }
+                transfer.m_Texture->m_TransferState &= ~(1<<transfer.m_MipMap);
+            }
+
+            FreeTextureTransfer(context, transfer);
+        }
+
+        memmove(transfers.Begin(), transfers.Begin() + i, (count - i) * sizeof(TextureTransfer));
+        transfers.SetSize(count - i);
+
+        if (transfers.Size() == 0)
+        {
+            context->m_TransferRingHead = 0;
+            context->m_TransferRingTail = 0;
+        }
+    }
+
+    // Waits for the uploads of a texture that are in flight. If the texture is going to be used,
+    // it is acquired by the graphics queue right away, otherwise the uploads are discarded.
+    static void FlushTextureTransfers(HContext context, Texture* texture, bool acquire)
+    {
+        if (texture->m_TransferState == 0)
+        {
+            return;
+        }
+
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+        VkCommandBuffer vk_command_buffer = VK_NULL_HANDLE;
+        acquire = acquire && IsTransferQueueDedicated(context);
+
+        if (acquire)
+        {
+            CreateCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, 1, &vk_command_buffer);
+
+            VkCommandBufferBeginInfo vk_command_buffer_begin_info;
+            memset(&vk_command_buffer_begin_info, 0, sizeof(VkCommandBufferBeginInfo));
+            vk_command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            vk_command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            VkResult res = vkBeginCommandBuffer(vk_command_buffer, &vk_command_buffer_begin_info);
+            CHECK_VK_ERROR(res);
+        }
+
+        dmArray<TextureTransfer>& transfers = context->m_TextureTransfers;
+        for (uint32_t i = 0; i < transfers.Size(); ++i)
+        {
+            TextureTransfer& transfer = transfers[i];
+            if (transfer.m_Texture != texture)
+            {
+                continue;
+            }
+
+            vkWaitForFences(vk_device, 1, &transfer.m_Fence, VK_TRUE, UINT64_MAX);
+            if (acquire)
+            {
+                AcquireTextureTransfer(context, vk_command_buffer, transfer);
+            }
+            transfer.m_Texture = 0;
+        }
+        texture->m_TransferState = 0;
+
+        if (acquire)
+        {
+            VkResult res = vkEndCommandBuffer(vk_command_buffer);
+            CHECK_VK_ERROR(res);
+
+            VkSubmitInfo vk_submit_info;
+            memset(&vk_submit_info, 0, sizeof(vk_submit_info));
+            vk_submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            vk_submit_info.commandBufferCount = 1;
+            vk_submit_info.pCommandBuffers    = &vk_command_buffer;
+
+            WaitForPresent(context);
+            res = vkQueueSubmit(context->m_LogicalDevice.m_GraphicsQueue, 1, &vk_submit_info, VK_NULL_HANDLE);
+            CHECK_VK_ERROR(res);
+            vkQueueWaitIdle(context->m_LogicalDevice.m_GraphicsQueue);
+            vkFreeCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, 1, &vk_command_buffer);
+        }
+    }
+
+    // Uploads a mipmap of a texture that hasn't been sampled yet on the transfer queue, without waiting
+    // for it to finish. The texture is made available at the start of the first frame after the upload.
+    static void CopyToTextureAsync(HContext context, const TextureParams& params,
+        uint32_t texDataSize, void* texDataPtr, Texture* textureOut)
+    {
+        VkDevice vk_device  = context->m_LogicalDevice.m_Device;
+        uint8_t layer_count = GetLayerCount(textureOut);
+        VkResult res;
+
+        if (context->m_TransferRingBuffer.m_Handle.m_Buffer == VK_NULL_HANDLE)
+        {
+            context->m_TransferRingBuffer = DeviceBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+            res = CreateDeviceBuffer(context->m_PhysicalDevice.m_Device, vk_device, TRANSFER_RING_SIZE,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &context->m_TransferRingBuffer);
+            CHECK_VK_ERROR(res);
+            res = context->m_TransferRingBuffer.MapMemory(vk_device);
+            CHECK_VK_ERROR(res);
+        }
+
+        TextureTransfer transfer;
+        if (context->m_FreeTextureTransfers.Size() > 0)
+        {
+            transfer = context->m_FreeTextureTransfers.Back();
+            context->m_FreeTextureTransfers.Pop();
+            vkResetFences(vk_device, 1, &transfer.m_Fence);
+        }
+        else
+        {
+            res = CreateCommandBuffers(vk_device, context->m_LogicalDevice.m_TransferCommandPool, 1, &transfer.m_CommandBuffer);
+            CHECK_VK_ERROR(res);
+
+            VkFenceCreateInfo vk_create_fence_info;
+            memset(&vk_create_fence_info, 0, sizeof(vk_create_fence_info));
+            vk_create_fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            res = vkCreateFence(vk_device, &vk_create_fence_info, 0, &transfer.m_Fence);
+            CHECK_VK_ERROR(res);
+        }
+
+        transfer.m_Texture    = textureOut;
+        transfer.m_MipMap     = params.m_MipMap;
+        transfer.m_LayerCount = layer_count;
+        memset(&transfer.m_StageBuffer, 0, sizeof(transfer.m_StageBuffer));
+
+        // Uploads that don't fit in the ring get a staging buffer of their own, instead of waiting for space
+        VkBuffer vk_stage_buffer;
+        uint32_t stage_offset = 0;
+        if (AllocateTransferRing(context, texDataSize, &stage_offset))
+        {
+            memcpy((uint8_t*) context->m_TransferRingBuffer.m_MappedDataPtr + stage_offset, texDataPtr, texDataSize);
+            vk_stage_buffer = context->m_TransferRingBuffer.m_Handle.m_Buffer;
+        }
+        else
+        {
+            DeviceBuffer stage_buffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+            res = CreateDeviceBuffer(context->m_PhysicalDevice.m_Device, vk_device, texDataSize,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stage_buffer);
+            CHECK_VK_ERROR(res);
+
+            res = WriteToDeviceBuffer(vk_device, texDataSize, 0, texDataPtr, &stage_buffer);
+            CHECK_VK_ERROR(res);
+
+            transfer.m_StageBuffer = stage_buffer.m_Handle;
+            vk_stage_buffer        = stage_buffer.m_Handle.m_Buffer;
+        }
+        transfer.m_RingEnd = context->m_TransferRingHead;
+
+        VkCommandBufferBeginInfo vk_command_buffer_begin_info;
+        memset(&vk_command_buffer_begin_info, 0, sizeof(VkCommandBufferBeginInfo));
+        vk_command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        vk_command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        res = vkBeginCommandBuffer(transfer.m_CommandBuffer, &vk_command_buffer_begin_info);
+        CHECK_VK_ERROR(res);
+
+        VkImageMemoryBarrier vk_barrier;
+        GetTextureTransferBarrier(textureOut, params.m_MipMap, layer_count,
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &vk_barrier);
+        vk_barrier.srcAccessMask = 0;
+        vk_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(transfer.m_CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, 0, 0, 0, 1, &vk_barrier);
+
+        uint32_t slice_size = texDataSize / layer_count;
+
+        VkBufferImageCopy vk_copy_regions[6];
+        for (int i = 0; i < layer_count; ++i)
+        {
+            VkBufferImageCopy& vk_copy_region = vk_copy_regions[i];
+            vk_copy_region.bufferOffset                    = stage_offset + i * slice_size;
+            vk_copy_region.bufferRowLength                 = 0;
+            vk_copy_region.bufferImageHeight               = 0;
+            vk_copy_region.imageOffset.x                   = params.m_X;
+            vk_copy_region.imageOffset.y                   = params.m_Y;
+            vk_copy_region.imageOffset.z                   = 0;
+            vk_copy_region.imageExtent.width               = params.m_Width;
+            vk_copy_region.imageExtent.height              = params.m_Height;
+            vk_copy_region.imageExtent.depth               = 1;
+            vk_copy_region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+            vk_copy_region.imageSubresource.mipLevel       = params.m_MipMap;
+            vk_copy_region.imageSubresource.baseArrayLayer = i;
+            vk_copy_region.imageSubresource.layerCount     = 1;
+        }
+
+        vkCmdCopyBufferToImage(transfer.m_CommandBuffer, vk_stage_buffer,
+            textureOut->m_Handle.m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            layer_count, vk_copy_regions);
+
+        // A dedicated transfer queue can't wait for the fragment shader stage, so the transition
+        // is completed by the acquire on the graphics queue, see AcquireTextureTransfer
+        GetTextureTransferBarrier(textureOut, params.m_MipMap, layer_count,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &vk_barrier);
+        vk_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        VkPipelineStageFlags vk_destination_stage;
+        if (IsTransferQueueDedicated(context))
+        {
+            vk_barrier.srcQueueFamilyIndex = context->m_SwapChain->m_QueueFamily.m_TransferQueueIx;
+            vk_barrier.dstQueueFamilyIndex = context->m_SwapChain->m_QueueFamily.m_GraphicsQueueIx;
+            vk_barrier.dstAccessMask       = 0;
+            vk_destination_stage           = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        }
+        else
+        {
+            vk_barrier.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+            vk_destination_stage           = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        }
+        vkCmdPipelineBarrier(transfer.m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, vk_destination_stage,
+            0, 0, 0, 0, 0, 1, &vk_barrier);
+
+        res = vkEndCommandBuffer(transfer.m_CommandBuffer);
+        CHECK_VK_ERROR(res);
+
+        VkSubmitInfo vk_submit_info;
+        memset(&vk_submit_info, 0, sizeof(vk_submit_info));
+        vk_submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        vk_submit_info.commandBufferCount = 1;
+        vk_submit_info.pCommandBuffers    = &transfer.m_CommandBuffer;
+
+        // Without a dedicated transfer queue, the upload is submitted to the graphics queue
+        if (!IsTransferQueueDedicated(context))
+        {
+            WaitForPresent(context);
+        }
+        res = vkQueueSubmit(context->m_LogicalDevice.m_TransferQueue, 1, &vk_submit_info, transfer.m_Fence);
+        CHECK_VK_ERROR(res);
+
+        textureOut->m_TransferState |= 1<<params.m_MipMap;
+        if (context->m_TextureTransfers.Full())
+        {
+            context->m_TextureTransfers.OffsetCapacity(16);
+        }
+        context->m_TextureTransfers.Push(transfer);
+    }
+
+    void DestroyTextureTransfers(HContext context)
+    {
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+        for (uint32_t i = 0; i < context->m_TextureTransfers.Size(); ++i)
+        {
+            vkWaitForFences(vk_device, 1, &context->m_TextureTransfers[i].m_Fence, VK_TRUE, UINT64_MAX);
+            FreeTextureTransfer(context, context->m_TextureTransfers[i]);
+        }
+        context->m_TextureTransfers.SetSize(0);
+
+        for (uint32_t i = 0; i < context->m_FreeTextureTransfers.Size(); ++i)
+        {
+            TextureTransfer& transfer = context->m_FreeTextureTransfers[i];
+            vkFreeCommandBuffers(vk_device, context->m_LogicalDevice.m_TransferCommandPool, 1, &transfer.m_CommandBuffer);
+            vkDestroyFence(vk_device, transfer.m_Fence, 0);
+        }
+        context->m_FreeTextureTransfers.SetSize(0);
+
+        if (context->m_TransferRingBuffer.m_Handle.m_Buffer != VK_NULL_HANDLE)
+        {
+            context->m_TransferRingBuffer.UnmapMemory(vk_device);
+            DestroyDeviceBuffer(vk_device, &context->m_TransferRingBuffer.m_Handle);
+        }
+        context->m_TransferRingHead = 0;
+        context->m_TransferRingTail = 0;
+    }
+
     static void RepackRGBToRGBA(uint32_t num_pixels, uint8_t* rgb, uint8_t* rgba)
     {
         for(uint32_t px=0; px < num_pixels; px++)
@@ -3185,8 +4589,6 @@ bail:
         texture->m_GraphicsFormat = params.m_Format;
         texture->m_MipMapCount    = dmMath::Max(texture->m_MipMapCount, (uint16_t)(params.m_MipMap+1));
 
-        SetTextureParams(texture, params.m_MinFilter, params.m_MagFilter, params.m_UWrap, params.m_VWrap);
-
         if (params.m_SubUpdate)
         {
             // data size might be different if we have generated a new image
@@ -3196,11 +4598,30 @@ bail:
         {
             if (texture->m_Format != vk_format || texture->m_Width != params.m_Width || texture->m_Height != params.m_Height)
             {
+                FlushTextureTransfers(g_VulkanContext, texture, false);
                 DestroyResourceDeferred(g_VulkanContext->m_MainResourcesToDestroy[g_VulkanContext->m_SwapChain->m_ImageIndex], texture);
                 texture->m_Format = vk_format;
+
+                // The image is created with all its mip levels, so a resized texture gets the full mip chain of the new size
+                if (texture->m_Width != params.m_Width || texture->m_Height != params.m_Height)
+                {
+                    texture->m_Width  = params.m_Width;
+                    texture->m_Height = params.m_Height;
+                    if (texture->m_MipMapCount > 1)
+                    {
+                        uint16_t mipmap_count = 1;
+                        for (uint32_t size = dmMath::Max(params.m_Width, params.m_Height); size > 1; size >>= 1)
+                        {
+                            ++mipmap_count;
+                        }
+                        texture->m_MipMapCount = mipmap_count;
+                    }
+                }
             }
         }
 
+        SetTextureParams(texture, params.m_MinFilter, params.m_MagFilter, params.m_UWrap, params.m_VWrap);
+
         bool use_stage_buffer = true;
 #if defined(__MACH__) && (defined(__arm__) || defined(__arm64__) || defined(IOS_SIMULATOR))
         // Can't use a staging buffer for MoltenVK when we upload
@@ -3213,11 +4634,13 @@ bail:
 #endif
 
         // If texture hasn't been used yet or if it has been changed
+        bool image_created = false;
         if (texture->m_Destroyed || texture->m_Handle.m_Image == VK_NULL_HANDLE)
         {
+            image_created = true;
             assert(!params.m_SubUpdate);
             VkImageTiling vk_image_tiling           = VK_IMAGE_TILING_OPTIMAL;
-            VkImageUsageFlags vk_usage_flags        = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+            VkImageUsageFlags vk_usage_flags        = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
             VkFormatFeatureFlags vk_format_features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
             VkImageLayout vk_initial_layout         = VK_IMAGE_LAYOUT_UNDEFINED;
             VkMemoryPropertyFlags vk_memory_type    = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
@@ -3236,6 +4659,7 @@ bail:
                 vk_image_tiling        = VK_IMAGE_TILING_LINEAR;
                 texture->m_MipMapCount = 1;
             }
+            texture->m_Blittable = use_stage_buffer && vk_image_tiling == VK_IMAGE_TILING_OPTIMAL;
 
             VkResult res = CreateTexture2D(vk_physical_device, logical_device.m_Device,
                 texture->m_Width, texture->m_Height, texture->m_MipMapCount, VK_SAMPLE_COUNT_1_BIT,
@@ -3246,7 +4670,18 @@ bail:
 
         tex_data_size = (int) ceil((float) tex_data_size / 8.0f);
 
-        CopyToTexture(g_VulkanContext, params, use_stage_buffer, tex_data_size, tex_data_ptr, texture);
+        // The transfer queue is only used for textures that haven't been sampled yet. Other uploads are
+        // made on the graphics queue, after the earlier uploads of the texture are done.
+        bool transfer_pending = texture->m_TransferState != 0 && !(texture->m_TransferState & (1<<params.m_MipMap));
+        if (use_stage_buffer && !params.m_SubUpdate && (image_created || transfer_pending))
+        {
+            CopyToTextureAsync(g_VulkanContext, params, tex_data_size, tex_data_ptr, texture);
+        }
+        else
+        {
+            FlushTextureTransfers(g_VulkanContext, texture, true);
+            CopyToTexture(g_VulkanContext, params, use_stage_buffer, tex_data_size, tex_data_ptr, texture);
+        }
 
         if (format_orig == TEXTURE_FORMAT_RGB)
         {
@@ -3254,10 +4689,51 @@ bail:
         }
     }
 
+    // Makes the queued uploads in order until the budget is used up. At least one upload is made
+    // each frame, so that textures larger than the budget still get through.
+    static void UploadPendingTextures(HContext context)
+    {
+        DM_PROFILE(Graphics, "UploadPendingTextures");
+        dmArray<PendingTextureUpload>& uploads = context->m_PendingTextureUploads;
+        uint32_t count = uploads.Size();
+        uint32_t uploaded_size = 0;
+        uint32_t i = 0;
+        for (; i < count; ++i)
+        {
+            PendingTextureUpload& upload = uploads[i];
+            if (i > 0 && uploaded_size + upload.m_Params.m_DataSize > context->m_TextureUploadBudget)
+            {
+                break;
+            }
+            VulkanSetTexture(upload.m_Texture, upload.m_Params);
+            upload.m_Texture->m_DataState &= ~(1<<upload.m_Params.m_MipMap);
+            uploaded_size += upload.m_Params.m_DataSize;
+        }
+
+        memmove(uploads.Begin(), uploads.Begin() + i, (count - i) * sizeof(PendingTextureUpload));
+        uploads.SetSize(count - i);
+        DM_COUNTER("TextureUploadBytes", uploaded_size);
+    }
+
     static void VulkanSetTextureAsync(HTexture texture, const TextureParams& params)
     {
-        // Async texture loading is not supported in Vulkan, defaulting to syncronous loading until then
-        SetTexture(texture, params);
+        // Uploads are made on the main thread. With a budget they are queued and spread over
+        // the following frames, instead of stalling the current one.
+        if (g_VulkanContext->m_TextureUploadBudget == 0)
+        {
+            SetTexture(texture, params);
+            return;
+        }
+
+        texture->m_DataState |= 1<<params.m_MipMap;
+        PendingTextureUpload upload;
+        upload.m_Texture = texture;
+        upload.m_Params  = params;
+        if (g_VulkanContext->m_PendingTextureUploads.Full())
+        {
+            g_VulkanContext->m_PendingTextureUploads.OffsetCapacity(64);
+        }
+        g_VulkanContext->m_PendingTextureUploads.Push(upload);
     }
 
     static void VulkanSetTextureParams(HTexture texture, TextureFilter minfilter, TextureFilter magfilter, TextureWrap uwrap, TextureWrap vwrap)
@@ -3307,6 +4783,11 @@ bail:
         return texture->m_Height;
     }
 
+    static uint16_t VulkanGetTextureDepth(HTexture texture)
+    {
+        return 1;
+    }
+
     static uint16_t VulkanGetOriginalTextureWidth(HTexture texture)
     {
         return texture->m_OriginalWidth;
@@ -3334,9 +4815,133 @@ bail:
         return context->m_PhysicalDevice.m_Properties.limits.maxImageDimension2D;
     }
 
+    static void AddMipMapBarrier(VkCommandBuffer vk_command_buffer, VkImage vk_image, uint32_t mip,
+        VkImageLayout vk_from_layout, VkImageLayout vk_to_layout, VkAccessFlags vk_src_access, VkAccessFlags vk_dst_access,
+        VkPipelineStageFlags vk_src_stage, VkPipelineStageFlags vk_dst_stage)
+    {
+        VkImageMemoryBarrier vk_memory_barrier;
+        memset(&vk_memory_barrier, 0, sizeof(vk_memory_barrier));
+        vk_memory_barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        vk_memory_barrier.oldLayout                       = vk_from_layout;
+        vk_memory_barrier.newLayout                       = vk_to_layout;
+        vk_memory_barrier.srcAccessMask                   = vk_src_access;
+        vk_memory_barrier.dstAccessMask                   = vk_dst_access;
+        vk_memory_barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        vk_memory_barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        vk_memory_barrier.image                           = vk_image;
+        vk_memory_barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        vk_memory_barrier.subresourceRange.baseMipLevel   = mip;
+        vk_memory_barrier.subresourceRange.levelCount     = 1;
+        vk_memory_barrier.subresourceRange.baseArrayLayer = 0;
+        vk_memory_barrier.subresourceRange.layerCount     = 1;
+        vkCmdPipelineBarrier(vk_command_buffer, vk_src_stage, vk_dst_stage, 0, 0, 0, 0, 0, 1, &vk_memory_barrier);
+    }
+
+    // Each mip is blitted from the one above it, in a single command buffer
+    static bool VulkanGenerateMipMaps(HTexture texture)
+    {
+        DM_PROFILE(Graphics, "GenerateMipMaps");
+        HContext context = g_VulkanContext;
+        if (texture->m_Type != TEXTURE_TYPE_2D || texture->m_MipMapCount <= 1 || !texture->m_Blittable ||
+            texture->m_Destroyed || texture->m_Handle.m_Image == VK_NULL_HANDLE || texture->m_DataState)
+        {
+            return false;
+        }
+
+        const VkFormatFeatureFlags vk_required_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        VkFormatProperties vk_format_properties;
+        vkGetPhysicalDeviceFormatProperties(context->m_PhysicalDevice.m_Device, texture->m_Format, &vk_format_properties);
+        if ((vk_format_properties.optimalTilingFeatures & vk_required_features) != vk_required_features)
+        {
+            return false;
+        }
+
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+        WaitForPresent(context);
+        FlushTextureTransfers(context, texture, true);
+
+        VkCommandBuffer vk_command_buffer;
+        CreateCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, 1, &vk_command_buffer);
+        VkCommandBufferBeginInfo vk_command_buffer_begin_info;
+        memset(&vk_command_buffer_begin_info, 0, sizeof(VkCommandBufferBeginInfo));
+        vk_command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        vk_command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        VkResult res = vkBeginCommandBuffer(vk_command_buffer, &vk_command_buffer_begin_info);
+        CHECK_VK_ERROR(res);
+
+        VkImage vk_image = texture->m_Handle.m_Image;
+        int32_t width    = texture->m_Width;
+        int32_t height   = texture->m_Height;
+        for (uint32_t mip = 1; mip < texture->m_MipMapCount; ++mip)
+        {
+            // Mip 0 holds the uploaded data, the others were written by the previous blit
+            AddMipMapBarrier(vk_command_buffer, vk_image, mip - 1,
+                mip == 1 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                mip == 1 ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+            AddMipMapBarrier(vk_command_buffer, vk_image, mip,
+                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+            int32_t mip_width  = dmMath::Max(width >> 1, 1);
+            int32_t mip_height = dmMath::Max(height >> 1, 1);
+
+            VkImageBlit vk_blit;
+            memset(&vk_blit, 0, sizeof(vk_blit));
+            vk_blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            vk_blit.srcSubresource.mipLevel   = mip - 1;
+            vk_blit.srcSubresource.layerCount = 1;
+            vk_blit.srcOffsets[1].x           = width;
+            vk_blit.srcOffsets[1].y           = height;
+            vk_blit.srcOffsets[1].z           = 1;
+            vk_blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            vk_blit.dstSubresource.mipLevel   = mip;
+            vk_blit.dstSubresource.layerCount = 1;
+            vk_blit.dstOffsets[1].x           = mip_width;
+            vk_blit.dstOffsets[1].y           = mip_height;
+            vk_blit.dstOffsets[1].z           = 1;
+            vkCmdBlitImage(vk_command_buffer,
+                vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                vk_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1, &vk_blit, VK_FILTER_LINEAR);
+
+            AddMipMapBarrier(vk_command_buffer, vk_image, mip - 1,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+            width  = mip_width;
+            height = mip_height;
+        }
+
+        AddMipMapBarrier(vk_command_buffer, vk_image, texture->m_MipMapCount - 1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+        res = vkEndCommandBuffer(vk_command_buffer);
+        CHECK_VK_ERROR(res);
+
+        VkSubmitInfo vk_submit_info;
+        memset(&vk_submit_info, 0, sizeof(vk_submit_info));
+        vk_submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        vk_submit_info.commandBufferCount = 1;
+        vk_submit_info.pCommandBuffers    = &vk_command_buffer;
+        res = vkQueueSubmit(context->m_LogicalDevice.m_GraphicsQueue, 1, &vk_submit_info, VK_NULL_HANDLE);
+        CHECK_VK_ERROR(res);
+        vkQueueWaitIdle(context->m_LogicalDevice.m_GraphicsQueue);
+
+        vkFreeCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, 1, &vk_command_buffer);
+        return true;
+    }
+
     static uint32_t VulkanGetTextureStatusFlags(HTexture texture)
     {
-        return 0;
+        uint32_t flags = TEXTURE_STATUS_OK;
+        if (texture->m_DataState || texture->m_TransferState)
+            flags |= TEXTURE_STATUS_DATA_PENDING;
+        return flags;
     }
 
     static void VulkanReadPixels(HContext context, void* buffer, uint32_t buffer_size)
@@ -3379,6 +4984,9 @@ bail:
         fn_table.m_BeginFrame = VulkanBeginFrame;
         fn_table.m_Flip = VulkanFlip;
         fn_table.m_SetSwapInterval = VulkanSetSwapInterval;
+        fn_table.m_SetJobContext = VulkanSetJobContext;
+        fn_table.m_BeginGpuTimer = VulkanBeginGpuTimer;
+        fn_table.m_EndGpuTimer = VulkanEndGpuTimer;
         fn_table.m_Clear = VulkanClear;
         fn_table.m_NewVertexBuffer = VulkanNewVertexBuffer;
         fn_table.m_DeleteVertexBuffer = VulkanDeleteVertexBuffer;
@@ -3400,6 +5008,11 @@ bail:
         fn_table.m_HashVertexDeclaration = VulkanHashVertexDeclaration;
         fn_table.m_DrawElements = VulkanDrawElements;
         fn_table.m_Draw = VulkanDraw;
+        fn_table.m_IsInstancingSupported = VulkanIsInstancingSupported;
+        fn_table.m_EnableInstanceVertexDeclaration = VulkanEnableInstanceVertexDeclaration;
+        fn_table.m_DisableInstanceVertexDeclaration = VulkanDisableInstanceVertexDeclaration;
+        fn_table.m_DrawElementsInstanced = VulkanDrawElementsInstanced;
+        fn_table.m_DrawInstanced = VulkanDrawInstanced;
         fn_table.m_NewVertexProgram = VulkanNewVertexProgram;
         fn_table.m_NewFragmentProgram = VulkanNewFragmentProgram;
         fn_table.m_NewProgram = VulkanNewProgram;
@@ -3441,14 +5054,17 @@ bail:
         fn_table.m_GetRenderTargetSize = VulkanGetRenderTargetSize;
         fn_table.m_SetRenderTargetSize = VulkanSetRenderTargetSize;
         fn_table.m_IsTextureFormatSupported = VulkanIsTextureFormatSupported;
+        fn_table.m_IsTextureTypeSupported = VulkanIsTextureTypeSupported;
         fn_table.m_NewTexture = VulkanNewTexture;
         fn_table.m_DeleteTexture = VulkanDeleteTexture;
         fn_table.m_SetTexture = VulkanSetTexture;
         fn_table.m_SetTextureAsync = VulkanSetTextureAsync;
+        fn_table.m_GenerateMipMaps = VulkanGenerateMipMaps;
         fn_table.m_SetTextureParams = VulkanSetTextureParams;
         fn_table.m_GetTextureResourceSize = VulkanGetTextureResourceSize;
         fn_table.m_GetTextureWidth = VulkanGetTextureWidth;
         fn_table.m_GetTextureHeight = VulkanGetTextureHeight;
+        fn_table.m_GetTextureDepth = VulkanGetTextureDepth;
         fn_table.m_GetOriginalTextureWidth = VulkanGetOriginalTextureWidth;
         fn_table.m_GetOriginalTextureHeight = VulkanGetOriginalTextureHeight;
         fn_table.m_EnableTexture = VulkanEnableTexture;
@@ -10,6 +10,8 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <dlib/array.h>
+#include <dlib/log.h>
 #include <dlib/math.h>
 
 #include "graphics_vulkan_defines.h"
@@ -18,6 +20,320 @@
 
 namespace dmGraphics
 {
+    // Drivers limit the number of live device memory allocations (maxMemoryAllocationCount is often 4096),
+    // so buffers and images are placed in large blocks that are split with a buddy allocator. Every node
+    // is aligned to its own size, which covers any alignment requirement up to the node size. Buffers and
+    // linear images never share a block with optimal images, so bufferImageGranularity needs no padding.
+    // Allocations larger than MEMORY_DEDICATED_SIZE get memory of their own.
+    static const uint32_t MEMORY_MIN_NODE_SIZE  = 256;
+    static const uint32_t MEMORY_ORDER_COUNT    = 18; // Node sizes from 256 bytes to the block size
+    static const uint32_t MEMORY_BLOCK_SIZE     = MEMORY_MIN_NODE_SIZE << (MEMORY_ORDER_COUNT - 1); // 32Mb
+    static const uint32_t MEMORY_DEDICATED_SIZE = MEMORY_BLOCK_SIZE / 4;
+
+    struct MemoryBlock
+    {
+        VkDeviceMemory    m_Memory;
+        uint8_t*          m_MappedDataPtr; // Host visible blocks stay mapped, memory can't be mapped twice
+        dmArray<uint32_t> m_FreeNodes[MEMORY_ORDER_COUNT]; // Offsets of the free nodes of each size
+        uint32_t          m_MemoryTypeIndex;
+        uint32_t          m_UsedSize;
+        uint32_t          m_AllocationCount;
+        bool              m_OptimalImages;
+    };
+
+    struct MemoryAllocator
+    {
+        VkPhysicalDeviceMemoryProperties m_MemoryProperties;
+        dmArray<MemoryBlock*>            m_Blocks;
+        dmMutex::HMutex                  m_Mutex;
+        uint32_t                         m_DedicatedCount;
+        uint64_t                         m_DedicatedBytes;
+    };
+
+    static MemoryAllocator g_MemoryAllocator;
+
+    static uint32_t GetMemoryNodeOrder(uint32_t size)
+    {
+        uint32_t order = 0;
+        while ((MEMORY_MIN_NODE_SIZE << order) < size)
+        {
+            ++order;
+        }
+        return order;
+    }
+
+    static void PushFreeMemoryNode(MemoryBlock* block, uint32_t order, uint32_t offset)
+    {
+        dmArray<uint32_t>& free_nodes = block->m_FreeNodes[order];
+        if (free_nodes.Full())
+        {
+            free_nodes.OffsetCapacity(16);
+        }
+        free_nodes.Push(offset);
+    }
+
+    static bool AllocateFromMemoryBlock(MemoryBlock* block, uint32_t order, uint32_t* offset_out)
+    {
+        uint32_t free_order = order;
+        while (free_order < MEMORY_ORDER_COUNT && block->m_FreeNodes[free_order].Empty())
+        {
+            ++free_order;
+        }
+        if (free_order == MEMORY_ORDER_COUNT)
+        {
+            return false;
+        }
+
+        uint32_t offset = block->m_FreeNodes[free_order].Back();
+        block->m_FreeNodes[free_order].Pop();
+
+        // Split the node down to the requested size, the upper halves stay free
+        while (free_order > order)
+        {
+            --free_order;
+            PushFreeMemoryNode(block, free_order, offset + (MEMORY_MIN_NODE_SIZE << free_order));
+        }
+
+        block->m_UsedSize += MEMORY_MIN_NODE_SIZE << order;
+        block->m_AllocationCount++;
+        *offset_out = offset;
+        return true;
+    }
+
+    static void FreeToMemoryBlock(MemoryBlock* block, uint32_t offset, uint32_t order)
+    {
+        block->m_UsedSize -= MEMORY_MIN_NODE_SIZE << order;
+        block->m_AllocationCount--;
+
+        // Merge with the buddy node for as long as it is free
+        while (order < MEMORY_ORDER_COUNT - 1)
+        {
+            uint32_t buddy = offset ^ (MEMORY_MIN_NODE_SIZE << order);
+            dmArray<uint32_t>& free_nodes = block->m_FreeNodes[order];
+            uint32_t i = 0;
+            while (i < free_nodes.Size() && free_nodes[i] != buddy)
+            {
+                ++i;
+            }
+            if (i == free_nodes.Size())
+            {
+                break;
+            }
+            free_nodes.EraseSwap(i);
+            offset = dmMath::Min(offset, buddy);
+            ++order;
+        }
+
+        PushFreeMemoryNode(block, order, offset);
+    }
+
+    static MemoryBlock* NewMemoryBlock(VkDevice vk_device, uint32_t memory_type_index, bool optimal_images)
+    {
+        VkMemoryAllocateInfo vk_memory_alloc_info;
+        memset(&vk_memory_alloc_info, 0, sizeof(vk_memory_alloc_info));
+
+        vk_memory_alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        vk_memory_alloc_info.allocationSize  = MEMORY_BLOCK_SIZE;
+        vk_memory_alloc_info.memoryTypeIndex = memory_type_index;
+
+        VkDeviceMemory vk_memory;
+        if (vkAllocateMemory(vk_device, &vk_memory_alloc_info, 0, &vk_memory) != VK_SUCCESS)
+        {
+            return 0;
+        }
+
+        void* mapped_data_ptr = 0;
+        if (g_MemoryAllocator.m_MemoryProperties.memoryTypes[memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (vkMapMemory(vk_device, vk_memory, 0, VK_WHOLE_SIZE, 0, &mapped_data_ptr) != VK_SUCCESS)
+            {
+                vkFreeMemory(vk_device, vk_memory, 0);
+                return 0;
+            }
+        }
+
+        MemoryBlock* block       = new MemoryBlock;
+        block->m_Memory          = vk_memory;
+        block->m_MappedDataPtr   = (uint8_t*) mapped_data_ptr;
+        block->m_MemoryTypeIndex = memory_type_index;
+        block->m_UsedSize        = 0;
+        block->m_AllocationCount = 0;
+        block->m_OptimalImages   = optimal_images;
+        PushFreeMemoryNode(block, MEMORY_ORDER_COUNT - 1, 0);
+
+        dmArray<MemoryBlock*>& blocks = g_MemoryAllocator.m_Blocks;
+        if (blocks.Full())
+        {
+            blocks.OffsetCapacity(8);
+        }
+        blocks.Push(block);
+        return block;
+    }
+
+    static void DeleteMemoryBlock(VkDevice vk_device, MemoryBlock* block)
+    {
+        vkFreeMemory(vk_device, block->m_Memory, 0);
+        delete block;
+    }
+
+    void InitializeMemoryAllocator(VkPhysicalDevice vk_physical_device)
+    {
+        vkGetPhysicalDeviceMemoryProperties(vk_physical_device, &g_MemoryAllocator.m_MemoryProperties);
+        g_MemoryAllocator.m_Mutex          = dmMutex::New();
+        g_MemoryAllocator.m_DedicatedCount = 0;
+        g_MemoryAllocator.m_DedicatedBytes = 0;
+    }
+
+    void DestroyMemoryAllocator(VkDevice vk_device)
+    {
+        MemoryAllocatorStats stats;
+        GetMemoryAllocatorStats(&stats);
+        dmLogDebug("Vulkan device memory: %u blocks (%llu bytes) with %u allocations (%llu bytes), %u dedicated allocations (%llu bytes)",
+            stats.m_BlockCount, (unsigned long long) stats.m_BlockBytes, stats.m_AllocationCount, (unsigned long long) stats.m_UsedBytes,
+            stats.m_DedicatedCount, (unsigned long long) stats.m_DedicatedBytes);
+
+        dmArray<MemoryBlock*>& blocks = g_MemoryAllocator.m_Blocks;
+        for (uint32_t i = 0; i < blocks.Size(); ++i)
+        {
+            DeleteMemoryBlock(vk_device, blocks[i]);
+        }
+        blocks.SetCapacity(0);
+
+        dmMutex::Delete(g_MemoryAllocator.m_Mutex);
+        g_MemoryAllocator.m_Mutex = 0;
+    }
+
+    VkResult AllocateDeviceMemory(VkDevice vk_device, const VkMemoryRequirements& vk_memory_req, uint32_t memory_type_index, bool optimal_image, MemoryAllocation* allocation_out)
+    {
+        DM_MUTEX_SCOPED_LOCK(g_MemoryAllocator.m_Mutex);
+
+        // A node as large as the alignment is always aligned. Lazily allocated memory is only
+        // committed when it's needed, which doesn't happen for memory in a shared block.
+        VkDeviceSize node_size = dmMath::Max(vk_memory_req.size, vk_memory_req.alignment);
+        bool lazily_allocated  = (g_MemoryAllocator.m_MemoryProperties.memoryTypes[memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+        if (node_size <= MEMORY_DEDICATED_SIZE && !lazily_allocated)
+        {
+            uint32_t order  = GetMemoryNodeOrder((uint32_t) node_size);
+            uint32_t offset = 0;
+            MemoryBlock* block = 0;
+
+            dmArray<MemoryBlock*>& blocks = g_MemoryAllocator.m_Blocks;
+            for (uint32_t i = 0; i < blocks.Size(); ++i)
+            {
+                if (blocks[i]->m_MemoryTypeIndex == memory_type_index && blocks[i]->m_OptimalImages == optimal_image &&
+                    AllocateFromMemoryBlock(blocks[i], order, &offset))
+                {
+                    block = blocks[i];
+                    break;
+                }
+            }
+
+            if (block == 0)
+            {
+                block = NewMemoryBlock(vk_device, memory_type_index, optimal_image);
+                if (block && !AllocateFromMemoryBlock(block, order, &offset))
+                {
+                    block = 0;
+                }
+            }
+
+            // Without room for another block, the allocation still gets a chance as a dedicated one
+            if (block)
+            {
+                allocation_out->m_Memory = block->m_Memory;
+                allocation_out->m_Block  = block;
+                allocation_out->m_Offset = offset;
+                allocation_out->m_Size   = MEMORY_MIN_NODE_SIZE << order;
+                return VK_SUCCESS;
+            }
+        }
+
+        VkMemoryAllocateInfo vk_memory_alloc_info;
+        memset(&vk_memory_alloc_info, 0, sizeof(vk_memory_alloc_info));
+
+        vk_memory_alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        vk_memory_alloc_info.allocationSize  = vk_memory_req.size;
+        vk_memory_alloc_info.memoryTypeIndex = memory_type_index;
+
+        VkResult res = vkAllocateMemory(vk_device, &vk_memory_alloc_info, 0, &allocation_out->m_Memory);
+        if (res != VK_SUCCESS)
+        {
+            return res;
+        }
+
+        allocation_out->m_Block  = 0;
+        allocation_out->m_Offset = 0;
+        allocation_out->m_Size   = (uint32_t) vk_memory_req.size;
+        g_MemoryAllocator.m_DedicatedCount++;
+        g_MemoryAllocator.m_DedicatedBytes += vk_memory_req.size;
+        return VK_SUCCESS;
+    }
+
+    void FreeDeviceMemory(VkDevice vk_device, MemoryAllocation* allocation)
+    {
+        if (allocation->m_Memory == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        DM_MUTEX_SCOPED_LOCK(g_MemoryAllocator.m_Mutex);
+
+        MemoryBlock* block = allocation->m_Block;
+        if (block)
+        {
+            FreeToMemoryBlock(block, allocation->m_Offset, GetMemoryNodeOrder(allocation->m_Size));
+
+            // Empty blocks are released, except the last one of each kind which is kept for the next allocation
+            if (block->m_AllocationCount == 0)
+            {
+                dmArray<MemoryBlock*>& blocks = g_MemoryAllocator.m_Blocks;
+                uint32_t block_index = 0;
+                uint32_t same_kind_count = 0;
+                for (uint32_t i = 0; i < blocks.Size(); ++i)
+                {
+                    if (blocks[i] == block)
+                    {
+                        block_index = i;
+                    }
+                    if (blocks[i]->m_MemoryTypeIndex == block->m_MemoryTypeIndex && blocks[i]->m_OptimalImages == block->m_OptimalImages)
+                    {
+                        ++same_kind_count;
+                    }
+                }
+                if (same_kind_count > 1)
+                {
+                    blocks.EraseSwap(block_index);
+                    DeleteMemoryBlock(vk_device, block);
+                }
+            }
+        }
+        else
+        {
+            vkFreeMemory(vk_device, allocation->m_Memory, 0);
+            g_MemoryAllocator.m_DedicatedCount--;
+            g_MemoryAllocator.m_DedicatedBytes -= allocation->m_Size;
+        }
+
+        memset(allocation, 0, sizeof(*allocation));
+    }
+
+    void GetMemoryAllocatorStats(MemoryAllocatorStats* stats)
+    {
+        DM_MUTEX_SCOPED_LOCK(g_MemoryAllocator.m_Mutex);
+
+        memset(stats, 0, sizeof(*stats));
+        dmArray<MemoryBlock*>& blocks = g_MemoryAllocator.m_Blocks;
+        for (uint32_t i = 0; i < blocks.Size(); ++i)
+        {
+            stats->m_BlockCount++;
+            stats->m_BlockBytes      += MEMORY_BLOCK_SIZE;
+            stats->m_AllocationCount += blocks[i]->m_AllocationCount;
+            stats->m_UsedBytes       += blocks[i]->m_UsedSize;
+        }
+        stats->m_DedicatedCount = g_MemoryAllocator.m_DedicatedCount;
+        stats->m_DedicatedBytes = g_MemoryAllocator.m_DedicatedBytes;
+    }
+
     void InitializeVulkanTexture(Texture* t)
     {
         t->m_Type                = TEXTURE_TYPE_2D;
@@ -28,9 +344,12 @@ namespace dmGraphics
         t->m_Height              = 0;
         t->m_OriginalWidth       = 0;
         t->m_OriginalHeight      = 0;
+        t->m_DataState           = 0;
+        t->m_TransferState       = 0;
         t->m_MipMapCount         = 0;
         t->m_TextureSamplerIndex = 0;
         t->m_Destroyed           = 0;
+        t->m_Blittable           = 0;
         memset(&t->m_Handle, 0, sizeof(t->m_Handle));
     }
 
@@ -41,6 +360,7 @@ namespace dmGraphics
         , m_Framebuffer(VK_NULL_HANDLE)
         , m_Id(rtId)
         , m_IsBound(0)
+        , m_TransientDepthStencil(0)
     {
         m_Extent.width  = 0;
         m_Extent.height = 0;
@@ -80,7 +400,7 @@ namespace dmGraphics
 
         VkDescriptorSetAllocateInfo vk_descriptor_set_alloc;
         vk_descriptor_set_alloc.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        vk_descriptor_set_alloc.descriptorSetCount = DM_MAX_SET_COUNT;
+        vk_descriptor_set_alloc.descriptorSetCount = setCount;
         vk_descriptor_set_alloc.pSetLayouts        = vk_descriptor_set_layout;
         vk_descriptor_set_alloc.descriptorPool     = m_Handle.m_DescriptorPool;
         vk_descriptor_set_alloc.pNext              = 0;
@@ -104,13 +424,23 @@ namespace dmGraphics
 
     VkResult DeviceBuffer::MapMemory(VkDevice vk_device, uint32_t offset, uint32_t size)
     {
-        return vkMapMemory(vk_device, m_Handle.m_Memory, offset, size > 0 ? size : m_MemorySize, 0, &m_MappedDataPtr);
+        MemoryBlock* block = m_Handle.m_Allocation.m_Block;
+        if (block)
+        {
+            assert(block->m_MappedDataPtr);
+            m_MappedDataPtr = block->m_MappedDataPtr + m_Handle.m_Allocation.m_Offset + offset;
+            return VK_SUCCESS;
+        }
+        return vkMapMemory(vk_device, m_Handle.m_Allocation.m_Memory, offset, size > 0 ? size : m_MemorySize, 0, &m_MappedDataPtr);
     }
 
     void DeviceBuffer::UnmapMemory(VkDevice vk_device)
     {
         assert(m_MappedDataPtr);
-        vkUnmapMemory(vk_device, m_Handle.m_Memory);
+        if (m_Handle.m_Allocation.m_Block == 0)
+        {
+            vkUnmapMemory(vk_device, m_Handle.m_Allocation.m_Memory);
+        }
     }
 
     const VulkanResourceType DeviceBuffer::GetType()
@@ -431,14 +761,14 @@ namespace dmGraphics
         return VK_SUCCESS;
     }
 
-    VkResult CreateCommandBuffers(VkDevice vk_device, VkCommandPool vk_command_pool, uint32_t numBuffersToCreate, VkCommandBuffer* vk_command_buffers_out)
+    VkResult CreateCommandBuffers(VkDevice vk_device, VkCommandPool vk_command_pool, uint32_t numBuffersToCreate, VkCommandBuffer* vk_command_buffers_out, VkCommandBufferLevel vk_level)
     {
         VkCommandBufferAllocateInfo vk_buffers_allocate_info;
         memset(&vk_buffers_allocate_info, 0, sizeof(vk_buffers_allocate_info));
 
         vk_buffers_allocate_info.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         vk_buffers_allocate_info.commandPool        = vk_command_pool;
-        vk_buffers_allocate_info.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        vk_buffers_allocate_info.level              = vk_level;
         vk_buffers_allocate_info.commandBufferCount = numBuffersToCreate;
 
         return vkAllocateCommandBuffers(vk_device, &vk_buffers_allocate_info, vk_command_buffers_out);
@@ -486,13 +816,6 @@ namespace dmGraphics
         VkMemoryRequirements vk_buffer_memory_req;
         vkGetBufferMemoryRequirements(vk_device, bufferOut->m_Handle.m_Buffer, &vk_buffer_memory_req);
 
-        VkMemoryAllocateInfo vk_memory_alloc_info;
-        memset(&vk_memory_alloc_info, 0, sizeof(vk_memory_alloc_info));
-
-        vk_memory_alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        vk_memory_alloc_info.allocationSize  = vk_buffer_memory_req.size;
-        vk_memory_alloc_info.memoryTypeIndex = 0;
-
         uint32_t memory_type_index = 0;
         if (!GetMemoryTypeIndex(vk_physical_device, vk_buffer_memory_req.memoryTypeBits, vk_memory_flags, &memory_type_index))
         {
@@ -500,15 +823,13 @@ namespace dmGraphics
             goto bail;
         }
 
-        vk_memory_alloc_info.memoryTypeIndex = memory_type_index;
-
-        res = vkAllocateMemory(vk_device, &vk_memory_alloc_info, 0, &bufferOut->m_Handle.m_Memory);
+        res = AllocateDeviceMemory(vk_device, vk_buffer_memory_req, memory_type_index, false, &bufferOut->m_Handle.m_Allocation);
         if (res != VK_SUCCESS)
         {
             goto bail;
         }
 
-        res = vkBindBufferMemory(vk_device, bufferOut->m_Handle.m_Buffer, bufferOut->m_Handle.m_Memory, 0);
+        res = vkBindBufferMemory(vk_device, bufferOut->m_Handle.m_Buffer, bufferOut->m_Handle.m_Allocation.m_Memory, bufferOut->m_Handle.m_Allocation.m_Offset);
         if (res != VK_SUCCESS)
         {
             return res;
@@ -573,6 +894,8 @@ bail:
         }
 
         scratchBufferOut->m_DescriptorAllocator = descriptorAllocator;
+        // The cached descriptor sets refer to the previous buffer, if any
+        memset(scratchBufferOut->m_DescriptorSetCache, 0, sizeof(scratchBufferOut->m_DescriptorSetCache));
 
         return VK_SUCCESS;
     }
@@ -638,29 +961,23 @@ bail:
         VkMemoryRequirements vk_memory_req;
         vkGetImageMemoryRequirements(vk_device, textureOut->m_Handle.m_Image, &vk_memory_req);
 
-        VkMemoryAllocateInfo vk_memory_alloc_info;
-        memset(&vk_memory_alloc_info, 0, sizeof(vk_memory_alloc_info));
-
-        vk_memory_alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        vk_memory_alloc_info.allocationSize  = vk_memory_req.size;
-        vk_memory_alloc_info.memoryTypeIndex = 0;
-
+        // Lazily allocated memory is only available on some (mostly tiled) GPUs
         uint32_t memory_type_index = 0;
-        if (!GetMemoryTypeIndex(vk_physical_device, vk_memory_req.memoryTypeBits, vk_memory_flags, &memory_type_index))
+        if (!GetMemoryTypeIndex(vk_physical_device, vk_memory_req.memoryTypeBits, vk_memory_flags, &memory_type_index) &&
+            !((vk_memory_flags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) &&
+              GetMemoryTypeIndex(vk_physical_device, vk_memory_req.memoryTypeBits, vk_memory_flags & ~VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, &memory_type_index)))
         {
             res = VK_ERROR_INITIALIZATION_FAILED;
             goto bail;
         }
 
-        vk_memory_alloc_info.memoryTypeIndex = memory_type_index;
-
-        res = vkAllocateMemory(vk_device, &vk_memory_alloc_info, 0, &device_buffer.m_Handle.m_Memory);
+        res = AllocateDeviceMemory(vk_device, vk_memory_req, memory_type_index, vk_tiling == VK_IMAGE_TILING_OPTIMAL, &device_buffer.m_Handle.m_Allocation);
         if (res != VK_SUCCESS)
         {
             goto bail;
         }
 
-        res = vkBindImageMemory(vk_device, textureOut->m_Handle.m_Image, device_buffer.m_Handle.m_Memory, 0);
+        res = vkBindImageMemory(vk_device, textureOut->m_Handle.m_Image, device_buffer.m_Handle.m_Allocation.m_Memory, device_buffer.m_Handle.m_Allocation.m_Offset);
         if (res != VK_SUCCESS)
         {
             goto bail;
@@ -765,7 +1082,7 @@ bail:
             attachment_depth.format         = depthStencilAttachment->m_Format;
             attachment_depth.samples        = vk_sample_flags;
             attachment_depth.loadOp         = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-            attachment_depth.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+            attachment_depth.storeOp        = depthStencilAttachment->m_Transient ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
             attachment_depth.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             attachment_depth.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
             attachment_depth.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -896,7 +1213,7 @@ bail:
         VK_COMPARE_OP_ALWAYS
     };
 
-    VkResult CreatePipeline(VkDevice vk_device, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count,
+    VkResult CreatePipeline(VkDevice vk_device, VkPipelineCache vk_pipeline_cache, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count,
         PipelineState pipelineState, Program* program, DeviceBuffer* vertexBuffer,
         HVertexDeclaration vertexDeclaration, const VkRenderPass vk_render_pass, Pipeline* pipelineOut)
     {
@@ -1062,7 +1379,7 @@ bail:
         vk_pipeline_info.basePipelineHandle  = VK_NULL_HANDLE;
         vk_pipeline_info.basePipelineIndex   = -1;
 
-        return vkCreateGraphicsPipelines(vk_device, VK_NULL_HANDLE, 1, &vk_pipeline_info, 0, pipelineOut);
+        return vkCreateGraphicsPipelines(vk_device, vk_pipeline_cache, 1, &vk_pipeline_info, 0, pipelineOut);
     }
 
     void ResetScratchBuffer(VkDevice vk_device, ScratchBuffer* scratchBuffer)
@@ -1070,6 +1387,7 @@ bail:
         assert(scratchBuffer);
         scratchBuffer->m_DescriptorAllocator->Release(vk_device);
         scratchBuffer->m_MappedDataCursor = 0;
+        memset(scratchBuffer->m_DescriptorSetCache, 0, sizeof(scratchBuffer->m_DescriptorSetCache));
     }
 
     void DestroyProgram(VkDevice vk_device, Program::VulkanHandle* handle)
@@ -1160,11 +1478,7 @@ bail:
             handle->m_Buffer = VK_NULL_HANDLE;
         }
 
-        if (handle->m_Memory != VK_NULL_HANDLE)
-        {
-            vkFreeMemory(vk_device, handle->m_Memory, 0);
-            handle->m_Memory = VK_NULL_HANDLE;
-        }
+        FreeDeviceMemory(vk_device, &handle->m_Allocation);
     }
 
     void DestroyShaderModule(VkDevice vk_device, ShaderModule* shaderModule)
@@ -1181,6 +1495,7 @@ bail:
     void DestroyLogicalDevice(LogicalDevice* device)
     {
         vkDestroyCommandPool(device->m_Device, device->m_CommandPool, 0);
+        vkDestroyCommandPool(device->m_Device, device->m_TransferCommandPool, 0);
         vkDestroyDevice(device->m_Device, 0);
         memset(device, 0, sizeof(*device));
     }
@@ -1252,6 +1567,28 @@ bail:
         }
 
         delete[] vk_present_queues;
+
+        // Texture uploads are submitted to a queue without graphics support if there is one, those
+        // are usually backed by the DMA engines and can run next to the rendering. Queues with only
+        // transfer support are preferred over compute queues.
+        qf.m_TransferQueueIx = qf.m_GraphicsQueueIx;
+        for (uint32_t i = 0; i < device->m_QueueFamilyCount; ++i)
+        {
+            VkQueueFamilyProperties vk_properties = device->m_QueueFamilyProperties[i];
+            if (vk_properties.queueCount == 0 || vk_properties.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+            {
+                continue;
+            }
+
+            if (vk_properties.queueFlags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT))
+            {
+                if (qf.m_TransferQueueIx == qf.m_GraphicsQueueIx ||
+                    !(vk_properties.queueFlags & VK_QUEUE_COMPUTE_BIT))
+                {
+                    qf.m_TransferQueueIx = i;
+                }
+            }
+        }
         return qf;
     }
 
@@ -1265,15 +1602,22 @@ bail:
         // NOTE: Different queues can have different priority from [0..1], but
         //       we only have a single queue right now so set to 1.0f
         float queue_priority        = 1.0f;
-        int32_t queue_family_set[2] = { queueFamily.m_PresentQueueIx, QUEUE_FAMILY_INVALID };
+        int32_t queue_family_set[4] = { queueFamily.m_PresentQueueIx, QUEUE_FAMILY_INVALID, QUEUE_FAMILY_INVALID, QUEUE_FAMILY_INVALID };
         int32_t queue_family_c      = 0;
+        int32_t queue_family_set_c  = 1;
 
-        VkDeviceQueueCreateInfo vk_device_queue_create_info[2];
+        VkDeviceQueueCreateInfo vk_device_queue_create_info[3];
         memset(vk_device_queue_create_info, 0, sizeof(vk_device_queue_create_info));
 
         if (queueFamily.m_PresentQueueIx != queueFamily.m_GraphicsQueueIx)
         {
-            queue_family_set[1] = queueFamily.m_GraphicsQueueIx;
+            queue_family_set[queue_family_set_c++] = queueFamily.m_GraphicsQueueIx;
+        }
+
+        if (queueFamily.m_TransferQueueIx != queueFamily.m_GraphicsQueueIx &&
+            queueFamily.m_TransferQueueIx != queueFamily.m_PresentQueueIx)
+        {
+            queue_family_set[queue_family_set_c++] = queueFamily.m_TransferQueueIx;
         }
 
         while(queue_family_set[queue_family_c] != QUEUE_FAMILY_INVALID)
@@ -1307,6 +1651,7 @@ bail:
         {
             vkGetDeviceQueue(logicalDeviceOut->m_Device, queueFamily.m_GraphicsQueueIx, 0, &logicalDeviceOut->m_GraphicsQueue);
             vkGetDeviceQueue(logicalDeviceOut->m_Device, queueFamily.m_PresentQueueIx, 0, &logicalDeviceOut->m_PresentQueue);
+            vkGetDeviceQueue(logicalDeviceOut->m_Device, queueFamily.m_TransferQueueIx, 0, &logicalDeviceOut->m_TransferQueue);
 
             // Create command pool
             VkCommandPoolCreateInfo vk_create_pool_info;
@@ -1317,6 +1662,16 @@ bail:
             res = vkCreateCommandPool(logicalDeviceOut->m_Device, &vk_create_pool_info, 0, &logicalDeviceOut->m_CommandPool);
         }
 
+        if (res == VK_SUCCESS)
+        {
+            VkCommandPoolCreateInfo vk_create_pool_info;
+            memset(&vk_create_pool_info, 0, sizeof(vk_create_pool_info));
+            vk_create_pool_info.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            vk_create_pool_info.queueFamilyIndex = (uint32_t) queueFamily.m_TransferQueueIx;
+            vk_create_pool_info.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+            res = vkCreateCommandPool(logicalDeviceOut->m_Device, &vk_create_pool_info, 0, &logicalDeviceOut->m_TransferCommandPool);
+        }
+
         return res;
     }
 
@@ -0,0 +1,288 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dlib/dstrings.h>
+#include <dlib/log.h>
+#include <dlib/sys.h>
+
+#include "graphics_vulkan_defines.h"
+#include "../graphics.h"
+#include "graphics_vulkan_private.h"
+
+namespace dmGraphics
+{
+    // The pipeline cache is stored as two files in the cache directory, both named after
+    // the pipelineCacheUUID of the device so that a driver update or a different GPU
+    // never picks up data it can't use:
+    //   vk_pipeline_cache_<uuid>.bin - The data returned from vkGetPipelineCacheData
+    //   vk_pipelines_<uuid>.bin      - The pipeline warmup list, see PipelineWarmupEntry
+    static const uint32_t PIPELINE_WARMUP_MAGIC       = 0x57504b56; // "VKPW"
+    static const uint32_t PIPELINE_WARMUP_VERSION     = 1;
+    // Size of the VkPipelineCacheHeaderVersionOne header that starts the cache data
+    static const uint32_t PIPELINE_CACHE_HEADER_SIZE  = 16 + VK_UUID_SIZE;
+
+    struct PipelineWarmupHeader
+    {
+        uint32_t m_Magic;
+        uint32_t m_Version;
+        uint32_t m_EntrySize;
+        uint32_t m_EntryCount;
+    };
+
+    static void GetPipelineCacheFilePath(HContext context, const char* name, char* path, uint32_t path_len)
+    {
+        const uint8_t* uuid = context->m_PhysicalDevice.m_Properties.pipelineCacheUUID;
+        char uuid_str[VK_UUID_SIZE * 2 + 1];
+        for (uint32_t i = 0; i < VK_UUID_SIZE; ++i)
+        {
+            dmSnPrintf(&uuid_str[i * 2], 3, "%02x", uuid[i]);
+        }
+        dmSnPrintf(path, path_len, "%s/%s_%s.bin", context->m_PipelineCacheDirectory, name, uuid_str);
+    }
+
+    static uint8_t* ReadPipelineCacheFile(const char* path, uint32_t* size_out)
+    {
+        *size_out = 0;
+        FILE* file = fopen(path, "rb");
+        if (!file)
+        {
+            return 0;
+        }
+
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        uint8_t* data = 0;
+        if (size > 0)
+        {
+            data = (uint8_t*) malloc(size);
+            if (fread(data, 1, size, file) != (size_t) size)
+            {
+                free(data);
+                data = 0;
+            }
+            else
+            {
+                *size_out = (uint32_t) size;
+            }
+        }
+        fclose(file);
+        return data;
+    }
+
+    // Writes to a temporary file first, so that a crash while writing never leaves a truncated cache behind
+    static bool WritePipelineCacheFile(const char* path, const void* header, uint32_t header_size, const void* data, uint32_t data_size)
+    {
+        char tmp_path[DMPATH_MAX_PATH];
+        dmSnPrintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+        FILE* file = fopen(tmp_path, "wb");
+        if (!file)
+        {
+            return false;
+        }
+
+        bool ok = fwrite(header, 1, header_size, file) == header_size;
+        if (ok && data_size > 0)
+        {
+            ok = fwrite(data, 1, data_size, file) == data_size;
+        }
+        ok = fclose(file) == 0 && ok;
+
+        if (!ok || dmSys::RenameFile(path, tmp_path) != dmSys::RESULT_OK)
+        {
+            dmSys::Unlink(tmp_path);
+            return false;
+        }
+        return true;
+    }
+
+    static bool IsPipelineCacheDataValid(HContext context, const uint8_t* data, uint32_t size)
+    {
+        if (size < PIPELINE_CACHE_HEADER_SIZE)
+        {
+            return false;
+        }
+
+        uint32_t header[4];
+        memcpy(header, data, sizeof(header));
+
+        const VkPhysicalDeviceProperties& properties = context->m_PhysicalDevice.m_Properties;
+        return header[0] >= PIPELINE_CACHE_HEADER_SIZE &&
+               header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+               header[2] == properties.vendorID &&
+               header[3] == properties.deviceID &&
+               memcmp(data + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    static void LoadPipelineWarmupEntries(HContext context)
+    {
+        char path[DMPATH_MAX_PATH];
+        GetPipelineCacheFilePath(context, "vk_pipelines", path, sizeof(path));
+
+        uint32_t size;
+        uint8_t* data = ReadPipelineCacheFile(path, &size);
+        if (!data)
+        {
+            return;
+        }
+
+        PipelineWarmupHeader header;
+        if (size >= sizeof(header))
+        {
+            memcpy(&header, data, sizeof(header));
+            if (header.m_Magic == PIPELINE_WARMUP_MAGIC &&
+                header.m_Version == PIPELINE_WARMUP_VERSION &&
+                header.m_EntrySize == sizeof(PipelineWarmupEntry) &&
+                (uint64_t) size == sizeof(header) + (uint64_t) header.m_EntryCount * sizeof(PipelineWarmupEntry))
+            {
+                context->m_PipelineWarmupEntries.SetCapacity(header.m_EntryCount);
+                context->m_PipelineWarmupEntries.SetSize(header.m_EntryCount);
+                memcpy(context->m_PipelineWarmupEntries.Begin(), data + sizeof(header), header.m_EntryCount * sizeof(PipelineWarmupEntry));
+            }
+            else
+            {
+                dmLogWarning("Ignoring pipeline warmup list '%s', it was written by a different version", path);
+            }
+        }
+
+        free(data);
+    }
+
+    VkResult LoadPipelineCache(HContext context)
+    {
+        uint8_t* data = 0;
+        uint32_t data_size = 0;
+
+        if (context->m_PipelineCacheDirectory[0])
+        {
+            char path[DMPATH_MAX_PATH];
+            GetPipelineCacheFilePath(context, "vk_pipeline_cache", path, sizeof(path));
+            data = ReadPipelineCacheFile(path, &data_size);
+
+            if (data && !IsPipelineCacheDataValid(context, data, data_size))
+            {
+                dmLogWarning("Ignoring pipeline cache '%s', it was created for a different device or driver", path);
+                free(data);
+                data      = 0;
+                data_size = 0;
+            }
+
+            if (context->m_PipelineWarmup)
+            {
+                LoadPipelineWarmupEntries(context);
+            }
+        }
+
+        VkPipelineCacheCreateInfo vk_pipeline_cache_info;
+        memset(&vk_pipeline_cache_info, 0, sizeof(vk_pipeline_cache_info));
+        vk_pipeline_cache_info.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        vk_pipeline_cache_info.initialDataSize = data_size;
+        vk_pipeline_cache_info.pInitialData    = data;
+
+        VkResult res = vkCreatePipelineCache(context->m_LogicalDevice.m_Device, &vk_pipeline_cache_info, 0, &context->m_DevicePipelineCache);
+        if (res != VK_SUCCESS && data)
+        {
+            // The driver is allowed to reject the data, start over with an empty cache
+            vk_pipeline_cache_info.initialDataSize = 0;
+            vk_pipeline_cache_info.pInitialData    = 0;
+            res = vkCreatePipelineCache(context->m_LogicalDevice.m_Device, &vk_pipeline_cache_info, 0, &context->m_DevicePipelineCache);
+        }
+
+        free(data);
+        return res;
+    }
+
+    void SavePipelineCache(HContext context)
+    {
+        if (!context->m_PipelineCacheDirectory[0] || context->m_DevicePipelineCache == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+        size_t data_size = 0;
+        if (vkGetPipelineCacheData(vk_device, context->m_DevicePipelineCache, &data_size, 0) == VK_SUCCESS && data_size > 0)
+        {
+            uint8_t* data = (uint8_t*) malloc(data_size);
+            if (vkGetPipelineCacheData(vk_device, context->m_DevicePipelineCache, &data_size, data) == VK_SUCCESS)
+            {
+                char path[DMPATH_MAX_PATH];
+                GetPipelineCacheFilePath(context, "vk_pipeline_cache", path, sizeof(path));
+                if (!WritePipelineCacheFile(path, data, (uint32_t) data_size, 0, 0))
+                {
+                    dmLogWarning("Unable to write pipeline cache to '%s'", path);
+                }
+            }
+            free(data);
+        }
+
+        if (context->m_PipelineWarmup)
+        {
+            PipelineWarmupHeader header;
+            header.m_Magic      = PIPELINE_WARMUP_MAGIC;
+            header.m_Version    = PIPELINE_WARMUP_VERSION;
+            header.m_EntrySize  = sizeof(PipelineWarmupEntry);
+            header.m_EntryCount = context->m_PipelineWarmupEntries.Size();
+
+            char path[DMPATH_MAX_PATH];
+            GetPipelineCacheFilePath(context, "vk_pipelines", path, sizeof(path));
+            if (!WritePipelineCacheFile(path, &header, sizeof(header),
+                context->m_PipelineWarmupEntries.Begin(), header.m_EntryCount * sizeof(PipelineWarmupEntry)))
+            {
+                dmLogWarning("Unable to write pipeline warmup list to '%s'", path);
+            }
+        }
+    }
+
+    void DestroyPipelineCache(HContext context)
+    {
+        if (context->m_DevicePipelineCache != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineCache(context->m_LogicalDevice.m_Device, context->m_DevicePipelineCache, 0);
+            context->m_DevicePipelineCache = VK_NULL_HANDLE;
+        }
+        context->m_PipelineWarmupEntries.SetCapacity(0);
+    }
+
+    void AddPipelineWarmupEntry(HContext context, uint64_t pipeline_hash, uint64_t program_hash,
+        PipelineState pipeline_state, VkSampleCountFlagBits vk_sample_count, const VertexDeclaration* vertex_declaration)
+    {
+        dmArray<PipelineWarmupEntry>& entries = context->m_PipelineWarmupEntries;
+        for (uint32_t i = 0; i < entries.Size(); ++i)
+        {
+            if (entries[i].m_PipelineHash == pipeline_hash)
+            {
+                return;
+            }
+        }
+
+        if (entries.Full())
+        {
+            entries.OffsetCapacity(16);
+        }
+
+        PipelineWarmupEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.m_PipelineHash      = pipeline_hash;
+        entry.m_ProgramHash       = program_hash;
+        entry.m_PipelineState     = pipeline_state;
+        entry.m_VertexDeclaration = *vertex_declaration;
+        entry.m_SampleCount       = vk_sample_count;
+        entries.Push(entry);
+    }
+}
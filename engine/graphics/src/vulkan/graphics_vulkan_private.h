@@ -14,7 +14,12 @@
 #define __GRAPHICS_DEVICE_VULKAN__
 
 #include <stdint.h>
+#include <dlib/condition_variable.h>
 #include <dlib/hashtable.h>
+#include <dlib/job.h>
+#include <dlib/mutex.h>
+#include <dlib/path.h>
+#include <dlib/thread.h>
 
 namespace dmGraphics
 {
@@ -31,6 +36,28 @@ namespace dmGraphics
         RESOURCE_TYPE_PROGRAM              = 3,
     };
 
+    struct MemoryBlock;
+
+    // A range of device memory, either a node in a shared MemoryBlock or a dedicated allocation.
+    // Resources only refer to their memory through this record, so it can be moved by rebinding.
+    struct MemoryAllocation
+    {
+        VkDeviceMemory m_Memory;
+        MemoryBlock*   m_Block; // 0x0 for dedicated allocations
+        uint32_t       m_Offset;
+        uint32_t       m_Size;
+    };
+
+    struct MemoryAllocatorStats
+    {
+        uint32_t m_BlockCount;
+        uint32_t m_AllocationCount;    // Live allocations in the blocks
+        uint32_t m_DedicatedCount;
+        uint64_t m_BlockBytes;
+        uint64_t m_UsedBytes;          // Bytes of the blocks taken by allocations, including padding
+        uint64_t m_DedicatedBytes;
+    };
+
     struct DeviceBuffer
     {
         DeviceBuffer(){}
@@ -45,8 +72,8 @@ namespace dmGraphics
 
         struct VulkanHandle
         {
-            VkBuffer       m_Buffer;
-            VkDeviceMemory m_Memory;
+            VkBuffer         m_Buffer;
+            MemoryAllocation m_Allocation;
         };
 
         void*              m_MappedDataPtr;
@@ -78,9 +105,13 @@ namespace dmGraphics
         uint16_t       m_Height;
         uint16_t       m_OriginalWidth;
         uint16_t       m_OriginalHeight;
+        uint16_t       m_DataState;          // One bit per mipmap with a queued upload
+        uint16_t       m_TransferState;      // One bit per mipmap with an upload in flight on the transfer queue
         uint16_t       m_MipMapCount         : 5;
         uint16_t       m_TextureSamplerIndex : 10;
         uint32_t       m_Destroyed           : 1;
+        // The image is optimally tiled and can be a blit source, see VulkanGenerateMipMaps
+        uint32_t       m_Blittable           : 1;
 
         const VulkanResourceType GetType();
     };
@@ -143,16 +174,29 @@ namespace dmGraphics
         uint16_t    m_Stride;
     };
 
+    // Descriptor sets written since the scratch buffer was reset, direct mapped on a hash of the set layout,
+    // the scratch buffer and the bound images. Draws that hit the cache only differ in their dynamic offsets.
+    const static uint32_t DM_DESCRIPTOR_SET_CACHE_SIZE = 128;
+
+    struct DescriptorSetCacheEntry
+    {
+        uint64_t        m_Key;
+        VkDescriptorSet m_DescriptorSet;
+    };
+
     struct ScratchBuffer
     {
         ScratchBuffer()
         : m_DeviceBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
         , m_MappedDataCursor(0)
-        {}
+        {
+            memset(m_DescriptorSetCache, 0, sizeof(m_DescriptorSetCache));
+        }
 
-        DescriptorAllocator* m_DescriptorAllocator;
-        DeviceBuffer         m_DeviceBuffer;
-        uint32_t             m_MappedDataCursor;
+        DescriptorAllocator*    m_DescriptorAllocator;
+        DeviceBuffer            m_DeviceBuffer;
+        uint32_t                m_MappedDataCursor;
+        DescriptorSetCacheEntry m_DescriptorSetCache[DM_DESCRIPTOR_SET_CACHE_SIZE];
     };
 
     struct RenderTarget
@@ -165,8 +209,9 @@ namespace dmGraphics
         VkFramebuffer  m_Framebuffer;
         VkExtent2D     m_Extent;
         const uint16_t m_Id;
-        uint8_t        m_IsBound : 1;
-        uint8_t                  : 7; // unused
+        uint8_t        m_IsBound              : 1;
+        uint8_t        m_TransientDepthStencil : 1;
+        uint8_t                               : 6; // unused
     };
 
     struct Viewport
@@ -188,6 +233,7 @@ namespace dmGraphics
     {
         VkFormat      m_Format;
         VkImageLayout m_ImageLayout;
+        bool          m_Transient; // The contents are not stored at the end of the render pass
     };
 
     struct QueueFamily
@@ -195,10 +241,12 @@ namespace dmGraphics
         QueueFamily()
         : m_GraphicsQueueIx(0xffff)
         , m_PresentQueueIx(0xffff)
+        , m_TransferQueueIx(0xffff)
         {}
 
         uint16_t m_GraphicsQueueIx;
         uint16_t m_PresentQueueIx;
+        uint16_t m_TransferQueueIx; // Same as the graphics queue if there is no dedicated transfer queue
 
         bool IsValid() { return m_GraphicsQueueIx != 0xffff && m_PresentQueueIx != 0xffff; }
     };
@@ -220,7 +268,9 @@ namespace dmGraphics
         VkDevice      m_Device;
         VkQueue       m_GraphicsQueue;
         VkQueue       m_PresentQueue;
+        VkQueue       m_TransferQueue;
         VkCommandPool m_CommandPool;
+        VkCommandPool m_TransferCommandPool;
     };
 
     union PipelineState
@@ -305,6 +355,7 @@ namespace dmGraphics
         uint64_t                        m_Hash;
         uint32_t*                       m_UniformDataOffsets;
         uint8_t*                        m_UniformData;
+        uint32_t                        m_UniformDataSize;
         VulkanHandle                    m_Handle;
         ShaderModule*                   m_VertexModule;
         ShaderModule*                   m_FragmentModule;
@@ -363,6 +414,147 @@ namespace dmGraphics
         bool     HasMultiSampling();
     };
 
+    // A draw call or state change recorded while a render pass is open. When the
+    // context has a job context, commands are collected until the render pass ends
+    // and are then recorded into secondary command buffers on the job threads.
+    struct DrawCommand
+    {
+        enum Type
+        {
+            TYPE_DRAW         = 0,
+            TYPE_DRAW_INDEXED = 1,
+            TYPE_CLEAR        = 2,
+            TYPE_VIEWPORT     = 3,
+            TYPE_DEPTH_BIAS   = 4,
+            TYPE_TIMESTAMP    = 5,
+        };
+
+        union
+        {
+            struct
+            {
+                Program*    m_Program;
+                VkPipeline  m_Pipeline;
+                VkBuffer    m_VertexBuffer;
+                VkBuffer    m_IndexBuffer;
+                VkIndexType m_IndexType;
+                // Offsets into the uniform data and image info snapshots of the context
+                uint32_t    m_UniformDataOffset;
+                uint32_t    m_ImageInfoOffset;
+                uint32_t    m_First;
+                uint32_t    m_Count;
+            } m_Draw;
+
+            struct
+            {
+                VkClearAttachment m_Attachments[2];
+                VkClearRect       m_Rect;
+                uint32_t          m_AttachmentCount;
+            } m_Clear;
+
+            struct
+            {
+                VkViewport m_Viewport;
+                VkRect2D   m_Scissor;
+            } m_Viewport;
+
+            struct
+            {
+                float m_Factor;
+                float m_Units;
+            } m_DepthBias;
+
+            struct
+            {
+                VkQueryPool             m_QueryPool;
+                uint32_t                m_Query;
+                VkPipelineStageFlagBits m_Stage;
+            } m_Timestamp;
+        };
+
+        uint8_t m_Type;
+    };
+
+    const uint32_t MAX_GPU_TIMERS = 64; // Per swap chain image
+
+    // Timestamp queries of the frame recorded with a swap chain image. They are
+    // read back when the image is used again, after waiting for its fence.
+    struct GpuTimerFrame
+    {
+        // Begin and end timestamp query of each timer
+        VkQueryPool m_QueryPool;
+        const char* m_Names[MAX_GPU_TIMERS];
+        uint32_t    m_NameHashes[MAX_GPU_TIMERS];
+        uint32_t    m_Count;
+    };
+
+    // A SetTextureAsync call waiting to be uploaded at the start of a frame
+    struct PendingTextureUpload
+    {
+        Texture*      m_Texture;
+        TextureParams m_Params;
+    };
+
+    // A texture upload submitted to the transfer queue. The texture can't be sampled until
+    // the fence has signaled, see UpdateTextureTransfers.
+    struct TextureTransfer
+    {
+        Texture*                   m_Texture;
+        VkCommandBuffer            m_CommandBuffer;
+        VkFence                    m_Fence;
+        // Staging buffer of uploads that don't fit in the transfer ring buffer
+        DeviceBuffer::VulkanHandle m_StageBuffer;
+        uint32_t                   m_RingEnd;
+        uint16_t                   m_MipMap;
+        uint16_t                   m_LayerCount;
+    };
+
+    // Dynamic state is not inherited by secondary command buffers,
+    // so each recorded range starts by setting the state that was active
+    // at its first command.
+    struct DynamicState
+    {
+        VkViewport m_Viewport;
+        VkRect2D   m_Scissor;
+        float      m_DepthBiasFactor;
+        float      m_DepthBiasUnits;
+        uint8_t    m_HasViewport  : 1;
+        uint8_t    m_HasDepthBias : 1;
+        uint8_t                   : 6; // unused
+    };
+
+    struct CommandRange
+    {
+        DynamicState    m_State;
+        VkCommandBuffer m_CommandBuffer;
+        uint32_t        m_Start;
+        uint32_t        m_End;
+    };
+
+    // Resources owned by one job thread for one swap chain image. Command pools and
+    // descriptor pools must be externally synchronized, so each thread records with its own.
+    struct ThreadResource
+    {
+        VkCommandPool            m_CommandPool;
+        dmArray<VkCommandBuffer> m_CommandBuffers;
+        dmArray<uint32_t>        m_DynamicOffsets;
+        ScratchBuffer            m_ScratchBuffer;
+        DescriptorAllocator      m_DescriptorAllocator;
+        uint32_t                 m_CommandBufferIndex;
+    };
+
+    // A pipeline created for the main render target during an earlier run. The
+    // list is stored next to the pipeline cache and the pipelines are created
+    // again as soon as a program with a matching hash is loaded.
+    struct PipelineWarmupEntry
+    {
+        uint64_t              m_PipelineHash;
+        uint64_t              m_ProgramHash;
+        PipelineState         m_PipelineState;
+        VertexDeclaration     m_VertexDeclaration;
+        VkSampleCountFlagBits m_SampleCount;
+    };
+
     typedef dmHashTable64<Pipeline>    PipelineCache;
     typedef dmArray<ResourceToDestroy> ResourcesToDestroyList;
 
@@ -377,6 +569,9 @@ namespace dmGraphics
         Texture*                        m_TextureUnits[DM_MAX_TEXTURE_UNITS];
         PipelineCache                   m_PipelineCache;
         PipelineState                   m_PipelineState;
+        VkPipelineCache                 m_DevicePipelineCache;
+        dmArray<PipelineWarmupEntry>    m_PipelineWarmupEntries;
+        char                            m_PipelineCacheDirectory[DMPATH_MAX_PATH];
         SwapChain*                      m_SwapChain;
         SwapChainCapabilities           m_SwapChainCapabilities;
         PhysicalDevice                  m_PhysicalDevice;
@@ -403,6 +598,34 @@ namespace dmGraphics
         ResourcesToDestroyList*         m_MainResourcesToDestroy[3];
         dmArray<ScratchBuffer>          m_MainScratchBuffers;
         dmArray<DescriptorAllocator>    m_MainDescriptorAllocators;
+        dmArray<GpuTimerFrame>          m_GpuTimerFrames;
+        dmArray<PendingTextureUpload>   m_PendingTextureUploads;
+        // Uploads on the transfer queue, oldest first. Their staging data is allocated from the ring buffer
+        dmArray<TextureTransfer>        m_TextureTransfers;
+        dmArray<TextureTransfer>        m_FreeTextureTransfers;
+        DeviceBuffer                    m_TransferRingBuffer;
+        uint32_t                        m_TransferRingHead;
+        uint32_t                        m_TransferRingTail;
+        // Deferred render pass recording, see DrawCommand
+        dmJob::HContext                 m_JobContext;
+        ThreadResource*                 m_ThreadResources;
+        dmArray<DrawCommand>            m_DrawCommands;
+        dmArray<CommandRange>           m_CommandRanges;
+        dmArray<VkCommandBuffer>        m_SecondaryCommandBuffers;
+        dmArray<uint8_t>                m_DrawUniformData;
+        dmArray<VkDescriptorImageInfo>  m_DrawImageInfos;
+        DynamicState                    m_DynamicState;
+        uint32_t                        m_DrawUniformSize;
+        uint32_t                        m_DrawCount;
+        uint32_t                        m_ThreadCount;
+        // Pipelined presentation, see VulkanFlip. The pending state is guarded by m_PresentMutex
+        dmThread::Thread                m_PresentThread;
+        dmMutex::HMutex                 m_PresentMutex;
+        dmConditionVariable::HConditionVariable m_PresentCondition;
+        uint32_t                        m_PresentImageIndex;
+        uint8_t                         m_PresentFrameInFlight;
+        uint8_t                         m_PresentPending;
+        uint8_t                         m_PresentThreadExit;
         VkRenderPass                    m_MainRenderPass;
         Texture                         m_MainTextureDepthStencil;
         RenderTarget                    m_MainRenderTarget;
@@ -421,6 +644,7 @@ namespace dmGraphics
         uint32_t                        m_Height;
         uint32_t                        m_WindowWidth;
         uint32_t                        m_WindowHeight;
+        uint32_t                        m_TextureUploadBudget;
         uint32_t                        m_FrameBegun           : 1;
         uint32_t                        m_CurrentFrameInFlight : 1;
         uint32_t                        m_WindowOpened         : 1;
@@ -429,7 +653,11 @@ namespace dmGraphics
         uint32_t                        m_CullFaceChanged      : 1;
         uint32_t                        m_UseValidationLayers  : 1;
         uint32_t                        m_RenderDocSupport     : 1;
-        uint32_t                                               : 24;
+        uint32_t                        m_PipelineWarmup       : 1;
+        uint32_t                        m_GpuTimerSupport      : 1;
+        uint32_t                        m_GpuTimerStarted      : 1;
+        uint32_t                        m_PipelinedPresent     : 1;
+        uint32_t                                               : 20;
     };
 
     // Implemented in graphics_vulkan_context.cpp
@@ -446,6 +674,20 @@ namespace dmGraphics
     VkResult CreateMainFrameBuffers(HContext context);
     VkResult DestroyMainFrameBuffers(HContext context);
     void SwapChainChanged(HContext context, uint32_t* width, uint32_t* height, VkResult (*cb)(void* ctx), void* cb_ctx);
+    // Waits until the previous frame has been submitted and presented, must be called before the queues are used
+    void WaitForPresent(HContext context);
+    void DestroyPresentThread(HContext context);
+    void DestroyThreadResources(HContext context);
+    void DestroyTextureTransfers(HContext context);
+    void DestroyGpuTimers(HContext context);
+
+    // Implemented in graphics_vulkan_pipeline_cache.cpp
+    //   The cache is read from and written to m_PipelineCacheDirectory, if set.
+    VkResult LoadPipelineCache(HContext context);
+    void     SavePipelineCache(HContext context);
+    void     DestroyPipelineCache(HContext context);
+    void     AddPipelineWarmupEntry(HContext context, uint64_t pipeline_hash, uint64_t program_hash,
+        PipelineState pipeline_state, VkSampleCountFlagBits vk_sample_count, const VertexDeclaration* vertex_declaration);
 
     // Implemented in graphics_vulkan_device.cpp
     // Create functions
@@ -455,7 +697,8 @@ namespace dmGraphics
         VkFramebuffer* vk_framebuffer_out);
     VkResult DestroyFrameBuffer(VkDevice vk_device, VkFramebuffer vk_framebuffer);
     VkResult CreateCommandBuffers(VkDevice vk_device, VkCommandPool vk_command_pool,
-        uint32_t numBuffersToCreate, VkCommandBuffer* vk_command_buffers_out);
+        uint32_t numBuffersToCreate, VkCommandBuffer* vk_command_buffers_out,
+        VkCommandBufferLevel vk_level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
     VkResult CreateDescriptorPool(VkDevice vk_device, VkDescriptorPoolSize* vk_pool_sizes, uint8_t numPoolSizes,
         uint16_t maxDescriptors, VkDescriptorPool* vk_descriptor_pool_out);
     VkResult CreateLogicalDevice(PhysicalDevice* device, const VkSurfaceKHR surface, const QueueFamily queueFamily,
@@ -483,7 +726,7 @@ namespace dmGraphics
         VkDeviceSize vk_size, VkMemoryPropertyFlags vk_memory_flags, DeviceBuffer* bufferOut);
     VkResult CreateShaderModule(VkDevice vk_device,
         const void* source, uint32_t sourceSize, ShaderModule* shaderModuleOut);
-    VkResult CreatePipeline(VkDevice vk_device, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count,
+    VkResult CreatePipeline(VkDevice vk_device, VkPipelineCache vk_pipeline_cache, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count,
         const PipelineState pipelineState, Program* program, DeviceBuffer* vertexBuffer,
         HVertexDeclaration vertexDeclaration, const VkRenderPass vk_render_pass, Pipeline* pipelineOut);
     // Reset functions
@@ -512,6 +755,12 @@ namespace dmGraphics
         VkImageAspectFlags vk_image_aspect, VkImageLayout vk_from_layout, VkImageLayout vk_to_layout,
         uint32_t baseMipLevel = 0, uint32_t layer_count = 1);
     VkResult WriteToDeviceBuffer(VkDevice vk_device, VkDeviceSize size, VkDeviceSize offset, const void* data, DeviceBuffer* buffer);
+    // Device memory
+    void     InitializeMemoryAllocator(VkPhysicalDevice vk_physical_device);
+    void     DestroyMemoryAllocator(VkDevice vk_device);
+    VkResult AllocateDeviceMemory(VkDevice vk_device, const VkMemoryRequirements& vk_memory_req, uint32_t memory_type_index, bool optimal_image, MemoryAllocation* allocation_out);
+    void     FreeDeviceMemory(VkDevice vk_device, MemoryAllocation* allocation);
+    void     GetMemoryAllocatorStats(MemoryAllocatorStats* stats);
 
     void DestroyPipelineCacheCb(HContext context, const uint64_t* key, Pipeline* value);
     void FlushResourcesToDestroy(VkDevice vk_device, ResourcesToDestroyList* resource_list);
@@ -26,6 +26,7 @@
 #include <dlib/vmath.h>
 #include <dlib/transform.h>
 #include <dlib/message.h>
+#include <dlib/memprofile.h>
 #include <dlib/profile.h>
 #include <dlib/trig_lookup.h>
 
@@ -60,6 +61,13 @@ namespace dmGui
     const uint64_t INDEX_SHIFT = CLIPPER_SHIFT + CLIPPER_RANGE;
     const uint64_t LAYER_SHIFT = INDEX_SHIFT + INDEX_RANGE;
 
+    // RGBA dynamic textures up to DYNAMIC_TEXTURE_MAX_PACKED_SIZE are packed into shared pages
+    // when the renderer supports sub updates (see RenderSceneParams::m_SetTextureSubData)
+    const uint32_t DYNAMIC_TEXTURE_PAGE_SIZE = 1024;
+    const uint32_t DYNAMIC_TEXTURE_MAX_PACKED_SIZE = 256;
+    // Border around each region, filled with the edge pixels of the image to avoid bleeding when filtering
+    const uint32_t DYNAMIC_TEXTURE_REGION_PADDING = 1;
+
 
     static inline void UpdateTextureSetAnimData(HScene scene, InternalNode* n);
     static inline Animation* GetComponentAnimation(HScene scene, HNode node, float* value);
@@ -385,6 +393,7 @@ namespace dmGui
         scene->m_Nodes.SetCapacity(params->m_MaxNodes);
         scene->m_NodePool.SetCapacity(params->m_MaxNodes);
         scene->m_Animations.SetCapacity(params->m_MaxAnimations);
+        scene->m_CompletedAnimations.SetCapacity(params->m_MaxAnimations);
         scene->m_SpineAnimations.SetCapacity(params->m_MaxAnimations);
         scene->m_Textures.SetCapacity(params->m_MaxTextures*2, params->m_MaxTextures);
         scene->m_DynamicTextures.SetCapacity(params->m_MaxTextures*2, params->m_MaxTextures);
@@ -401,6 +410,7 @@ namespace dmGui
         scene->m_RenderTail = INVALID_INDEX;
         scene->m_NextVersionNumber = 0;
         scene->m_RenderOrder = 0;
+        scene->m_RenderEntriesDirty = 1;
         scene->m_Width = context->m_DefaultProjectWidth;
         scene->m_Height = context->m_DefaultProjectHeight;
         scene->m_FetchTextureSetAnimCallback = params->m_FetchTextureSetAnimCallback;
@@ -467,6 +477,11 @@ namespace dmGui
             }
         }
 
+        for (uint32_t i = 0; i < scene->m_DynamicTexturePages.Size(); ++i)
+        {
+            delete scene->m_DynamicTexturePages[i];
+        }
+
         scene->~Scene();
 
         ResetScene(scene);
@@ -804,6 +819,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         uint64_t layer_hash = dmHashString64(layer_name);
         uint16_t index = scene->m_NextLayerIndex++;
         scene->m_Layers.Put(layer_hash, index);
+        scene->m_RenderEntriesDirty = 1;
         uint32_t n = scene->m_Nodes.Size();
         InternalNode* nodes = scene->m_Nodes.Begin();
         for (uint32_t i = 0; i < n; ++i)
@@ -898,6 +914,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
 
     Result SetLayout(const HScene scene, dmhash_t layout_id, SetNodeCallback set_node_callback)
     {
+        uint16_t prev_index = GetLayoutIndex(scene, scene->m_LayoutId);
         scene->m_LayoutId = layout_id;
         uint16_t index = GetLayoutIndex(scene, layout_id);
         uint32_t n = scene->m_Nodes.Size();
@@ -907,7 +924,11 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             InternalNode *n = &nodes[i];
             if(!n->m_Node.m_NodeDescTable)
                 continue;
-            set_node_callback(scene, GetNodeHandle(n), n->m_Node.m_NodeDescTable[index]);
+            const void* node_desc = n->m_Node.m_NodeDescTable[index];
+            // Nodes that aren't overridden by either layout are left as they are, unless the same layout is set again
+            if(prev_index != index && n->m_Node.m_NodeDescTable[prev_index] == node_desc)
+                continue;
+            set_node_callback(scene, GetNodeHandle(n), node_desc);
             n->m_Node.m_DirtyLocal = 1;
         }
         return RESULT_OK;
@@ -957,7 +978,14 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
 
     const float* GetNodeFlipbookAnimUV(HScene scene, HNode node)
     {
-        return GetNodeFlipbookAnimUVInternal(GetNode(scene, node));
+        InternalNode* n = GetNode(scene, node);
+        if (n->m_Node.m_TextureType == NODE_TEXTURE_TYPE_DYNAMIC)
+        {
+            // Packed dynamic textures are rendered like an atlas image, with the region of the page
+            DynamicTexture* texture = scene->m_DynamicTextures.Get(n->m_Node.m_TextureHash);
+            return texture && texture->m_Packed ? texture->m_TexCoords : 0;
+        }
+        return GetNodeFlipbookAnimUVInternal(n);
     }
 
     Vector4 CalculateReferenceScale(HScene scene, InternalNode* node)
@@ -1019,31 +1047,208 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         int    m_NewCount;
     };
 
+    static bool AllocateDynamicTextureRegion(DynamicTexturePage* page, uint32_t width, uint32_t height, uint16_t* out_x, uint16_t* out_y)
+    {
+        // Best fit, the shortest shelf with room for the region
+        DynamicTexturePageShelf* best = 0;
+        uint32_t used_height = 0;
+        for (uint32_t i = 0; i < page->m_Shelves.Size(); ++i)
+        {
+            DynamicTexturePageShelf* shelf = &page->m_Shelves[i];
+            used_height = dmMath::Max(used_height, (uint32_t) (shelf->m_Y + shelf->m_Height));
+            if (shelf->m_Height >= height && shelf->m_X + width <= DYNAMIC_TEXTURE_PAGE_SIZE && (!best || shelf->m_Height < best->m_Height))
+            {
+                best = shelf;
+            }
+        }
+
+        // Open a new shelf rather than wasting more than half of a taller one
+        if (used_height + height <= DYNAMIC_TEXTURE_PAGE_SIZE && (!best || best->m_Height > height * 2))
+        {
+            if (page->m_Shelves.Full())
+            {
+                page->m_Shelves.OffsetCapacity(8);
+            }
+            DynamicTexturePageShelf shelf;
+            shelf.m_Y = (uint16_t) used_height;
+            shelf.m_Height = (uint16_t) height;
+            shelf.m_X = 0;
+            page->m_Shelves.Push(shelf);
+            best = &page->m_Shelves.Back();
+        }
+
+        if (!best)
+        {
+            return false;
+        }
+
+        *out_x = best->m_X;
+        *out_y = best->m_Y;
+        best->m_X += (uint16_t) width;
+        return true;
+    }
+
+    static void PackDynamicTexture(HScene scene, const RenderSceneParams& params, void* context, DynamicTexture* texture)
+    {
+        const uint32_t width = texture->m_Width + DYNAMIC_TEXTURE_REGION_PADDING * 2;
+        const uint32_t height = texture->m_Height + DYNAMIC_TEXTURE_REGION_PADDING * 2;
+
+        dmArray<DynamicTexturePage*>& pages = scene->m_DynamicTexturePages;
+        uint32_t page_count = pages.Size();
+        uint32_t page_index = page_count;
+        uint32_t free_slot = page_count;
+        uint16_t x = 0, y = 0;
+        for (uint32_t i = 0; i < page_count; ++i)
+        {
+            if (!pages[i])
+            {
+                free_slot = dmMath::Min(free_slot, i);
+            }
+            else if (AllocateDynamicTextureRegion(pages[i], width, height, &x, &y))
+            {
+                page_index = i;
+                break;
+            }
+        }
+
+        if (page_index == page_count)
+        {
+            if (free_slot == page_count)
+            {
+                if (pages.Full())
+                {
+                    pages.OffsetCapacity(4);
+                }
+                pages.Push(0);
+            }
+            page_index = free_slot;
+
+            DynamicTexturePage* page = new DynamicTexturePage;
+            void* blank = calloc(DYNAMIC_TEXTURE_PAGE_SIZE * DYNAMIC_TEXTURE_PAGE_SIZE, 4);
+            page->m_Handle = params.m_NewTexture(scene, DYNAMIC_TEXTURE_PAGE_SIZE, DYNAMIC_TEXTURE_PAGE_SIZE, dmImage::TYPE_RGBA, blank, context);
+            free(blank);
+            pages[page_index] = page;
+
+            // Always fits in an empty page
+            AllocateDynamicTextureRegion(page, width, height, &x, &y);
+        }
+
+        DynamicTexturePage* page = pages[page_index];
+        page->m_RefCount++;
+
+        texture->m_Packed = 1;
+        texture->m_Handle = page->m_Handle;
+        texture->m_Page = (uint16_t) page_index;
+        texture->m_RegionX = x;
+        texture->m_RegionY = y;
+        texture->m_RegionWidth = (uint16_t) width;
+        texture->m_RegionHeight = (uint16_t) height;
+
+        const float s = 1.0f / (float) DYNAMIC_TEXTURE_PAGE_SIZE;
+        float u0 = (x + DYNAMIC_TEXTURE_REGION_PADDING) * s;
+        float v0 = (y + DYNAMIC_TEXTURE_REGION_PADDING) * s;
+        float u1 = u0 + texture->m_Width * s;
+        float v1 = v0 + texture->m_Height * s;
+        float* tc = texture->m_TexCoords;
+        tc[0] = u0; tc[1] = v0;
+        tc[2] = u0; tc[3] = v1;
+        tc[4] = u1; tc[5] = v1;
+        tc[6] = u1; tc[7] = v0;
+    }
+
+    static void ReleaseDynamicTextureRegion(HScene scene, DynamicTexture* texture)
+    {
+        // Empty pages are deleted in DeleteEmptyDynamicTexturePages
+        scene->m_DynamicTexturePages[texture->m_Page]->m_RefCount--;
+        texture->m_Packed = 0;
+        texture->m_Handle = 0;
+    }
+
+    static void UploadDynamicTextureRegion(HScene scene, const RenderSceneParams& params, void* context, DynamicTexture* texture)
+    {
+        const uint32_t width = texture->m_RegionWidth;
+        const uint32_t height = texture->m_RegionHeight;
+        const int32_t pad = (int32_t) DYNAMIC_TEXTURE_REGION_PADDING;
+        const uint32_t* src = (const uint32_t*) texture->m_Buffer;
+        uint32_t* region = (uint32_t*) malloc(width * height * sizeof(uint32_t));
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            int32_t sy = dmMath::Clamp((int32_t) y - pad, 0, (int32_t) texture->m_Height - 1);
+            const uint32_t* src_row = src + sy * texture->m_Width;
+            uint32_t* dst_row = region + y * width;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                dst_row[x] = src_row[dmMath::Clamp((int32_t) x - pad, 0, (int32_t) texture->m_Width - 1)];
+            }
+        }
+        params.m_SetTextureSubData(scene, texture->m_Handle, texture->m_RegionX, texture->m_RegionY, width, height, texture->m_Type, region, context);
+        free(region);
+    }
+
+    static void DeleteEmptyDynamicTexturePages(HScene scene, const RenderSceneParams& params, void* context)
+    {
+        dmArray<DynamicTexturePage*>& pages = scene->m_DynamicTexturePages;
+        for (uint32_t i = 0; i < pages.Size(); ++i)
+        {
+            DynamicTexturePage* page = pages[i];
+            if (page && page->m_RefCount == 0)
+            {
+                params.m_DeleteTexture(scene, page->m_Handle, context);
+                delete page;
+                pages[i] = 0;
+            }
+        }
+    }
+
     static void UpdateDynamicTextures(UpdateDynamicTexturesParams* params, const dmhash_t* key, DynamicTexture* texture)
     {
         dmGui::Scene* const scene = params->m_Scene;
         void* const context = params->m_Context;
+        const RenderSceneParams& render_params = *params->m_Params;
 
         if (texture->m_Deleted) {
-            if (texture->m_Handle) {
+            if (texture->m_Packed) {
+                ReleaseDynamicTextureRegion(scene, texture);
+            } else if (texture->m_Handle) {
                 // handle might be null if the texture is created/destroyed in the same frame
-                params->m_Params->m_DeleteTexture(scene, texture->m_Handle, context);
+                render_params.m_DeleteTexture(scene, texture->m_Handle, context);
             }
             if (scene->m_DeletedDynamicTextures.Full()) {
                 scene->m_DeletedDynamicTextures.OffsetCapacity(16);
             }
             scene->m_DeletedDynamicTextures.Push(*key);
-        } else {
-            if (!texture->m_Handle && texture->m_Buffer) {
-                texture->m_Handle = params->m_Params->m_NewTexture(scene, texture->m_Width, texture->m_Height, texture->m_Type, texture->m_Buffer, context);
+        } else if (texture->m_Buffer) {
+            bool pack = render_params.m_SetTextureSubData != 0 && texture->m_Type == dmImage::TYPE_RGBA &&
+                        texture->m_Width <= DYNAMIC_TEXTURE_MAX_PACKED_SIZE && texture->m_Height <= DYNAMIC_TEXTURE_MAX_PACKED_SIZE;
+
+            // Move the texture if its size or type no longer matches where it is stored
+            if (texture->m_Packed) {
+                bool same_size = texture->m_RegionWidth == texture->m_Width + DYNAMIC_TEXTURE_REGION_PADDING * 2 &&
+                                 texture->m_RegionHeight == texture->m_Height + DYNAMIC_TEXTURE_REGION_PADDING * 2;
+                if (!pack || !same_size) {
+                    ReleaseDynamicTextureRegion(scene, texture);
+                }
+            } else if (texture->m_Handle && pack) {
+                render_params.m_DeleteTexture(scene, texture->m_Handle, context);
+                texture->m_Handle = 0;
+            }
+
+            if (!texture->m_Handle) {
+                if (pack) {
+                    PackDynamicTexture(scene, render_params, context, texture);
+                } else {
+                    texture->m_Handle = render_params.m_NewTexture(scene, texture->m_Width, texture->m_Height, texture->m_Type, texture->m_Buffer, context);
+                }
                 params->m_NewCount++;
-                free(texture->m_Buffer);
-                texture->m_Buffer = 0;
-            } else if (texture->m_Handle && texture->m_Buffer) {
-                params->m_Params->m_SetTextureData(scene, texture->m_Handle, texture->m_Width, texture->m_Height, texture->m_Type, texture->m_Buffer, context);
-                free(texture->m_Buffer);
-                texture->m_Buffer = 0;
+            } else if (!texture->m_Packed) {
+                render_params.m_SetTextureData(scene, texture->m_Handle, texture->m_Width, texture->m_Height, texture->m_Type, texture->m_Buffer, context);
             }
+
+            if (texture->m_Packed) {
+                UploadDynamicTextureRegion(scene, render_params, context, texture);
+            }
+            free(texture->m_Buffer);
+            texture->m_Buffer = 0;
         }
     }
 
@@ -1055,6 +1260,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         p.m_Params = &params;
         scene->m_DeletedDynamicTextures.SetSize(0);
         scene->m_DynamicTextures.Iterate(UpdateDynamicTextures, &p);
+        DeleteEmptyDynamicTexturePages(scene, params, context);
 
         if (p.m_NewCount > 0) {
             uint32_t n = scene->m_Nodes.Size();
@@ -1146,6 +1352,8 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     static void UpdateScope(InternalNode* node, StencilScope& scope, StencilScope& child_scope, const StencilScope* parent_scope, uint16_t index, uint16_t non_inv_clipper_count, uint16_t inv_clipper_count, uint16_t bit_field_offset) {
         int bit_range = CalcBitRange(non_inv_clipper_count);
         // state used for drawing the clipper
+        scope.m_Scissor = 0;
+        child_scope.m_Scissor = 0;
         scope.m_WriteMask = 0xff;
         scope.m_TestMask = 0;
         if (parent_scope != 0x0) {
@@ -1216,6 +1424,10 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
                         clipper.m_ParentIndex = parent_index;
                         clipper.m_NextNonInvIndex = INVALID_INDEX;
                         clipper.m_VisibleRenderKey = ~0ULL;
+                        clipper.m_HasChildClippers = 0;
+                        if (parent_index != INVALID_INDEX) {
+                            clippers[parent_index].m_HasChildClippers = 1;
+                        }
                         n->m_ClipperIndex = clipper_index;
                         if (n->m_Node.m_ClippingInverted) {
                             StencilScope* parent_scope = 0x0;
@@ -1391,8 +1603,46 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         CollectRenderEntries(scene, scene->m_RenderHead, 0, 0x0, clippers, render_entries);
     }
 
+    // A clipper can use a scissor rectangle when the stencil would clip to the same axis-aligned rectangle,
+    // i.e. it's a box without rotation and no other clipper affects it or its children
+    static bool UpdateScissorScope(InternalNode* n, InternalClippingNode* clipper, const Matrix4& transform)
+    {
+        const float epsilon = 0.0001f;
+        if (n->m_Node.m_NodeType != NODE_TYPE_BOX || n->m_Node.m_ClippingInverted
+            || clipper->m_ParentIndex != INVALID_INDEX || clipper->m_HasChildClippers
+            || fabsf(transform.getElem(0, 1)) > epsilon || fabsf(transform.getElem(1, 0)) > epsilon)
+        {
+            return false;
+        }
+        // The transform includes the node size, so the node covers the unit square
+        Vector4 p0 = transform * Point3(0.0f, 0.0f, 0.0f);
+        Vector4 p1 = transform * Point3(1.0f, 1.0f, 0.0f);
+        StencilScope& scope = clipper->m_ChildScope;
+        scope.m_Scissor = 1;
+        scope.m_ScissorRect[0] = dmMath::Min(p0.getX(), p1.getX());
+        scope.m_ScissorRect[1] = dmMath::Min(p0.getY(), p1.getY());
+        scope.m_ScissorRect[2] = dmMath::Max(p0.getX(), p1.getX());
+        scope.m_ScissorRect[3] = dmMath::Max(p0.getY(), p1.getY());
+        return true;
+    }
+
+    template <typename T>
+    static void CopyArray(dmArray<T>& dst, const dmArray<T>& src)
+    {
+        if (dst.Capacity() < src.Size())
+        {
+            dst.SetCapacity(src.Size());
+        }
+        dst.SetSize(src.Size());
+        if (src.Size() > 0)
+        {
+            memcpy(dst.Begin(), src.Begin(), src.Size() * sizeof(T));
+        }
+    }
+
     void RenderScene(HScene scene, const RenderSceneParams& params, void* context)
     {
+        DM_MEM_SCOPE(Gui);
         Context* c = scene->m_Context;
 
         UpdateDynamicTextures(scene, params, context);
@@ -1423,10 +1673,25 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             c->m_SceneTraversalCache.m_Version = 0;
         }
 
-        Matrix4 node_transform;
-        CollectNodes(scene, c->m_StencilClippingNodes, c->m_RenderNodes);
+        // The render entries only depend on the node tree, so the sorted entries of the last frame are reused
+        // until it changes. Alive particlefx add entries for their emitters, which change every frame.
+        if (scene->m_RenderEntriesDirty || !scene->m_AliveParticlefxs.Empty())
+        {
+            CollectNodes(scene, c->m_StencilClippingNodes, c->m_RenderNodes);
+            std::sort(c->m_RenderNodes.Begin(), c->m_RenderNodes.End(), RenderEntrySortPred(scene));
+            if (scene->m_AliveParticlefxs.Empty())
+            {
+                CopyArray(scene->m_CachedRenderEntries, c->m_RenderNodes);
+                CopyArray(scene->m_CachedClippers, c->m_StencilClippingNodes);
+                scene->m_RenderEntriesDirty = 0;
+            }
+        }
+        else
+        {
+            CopyArray(c->m_RenderNodes, scene->m_CachedRenderEntries);
+            CopyArray(c->m_StencilClippingNodes, scene->m_CachedClippers);
+        }
         uint32_t node_count = c->m_RenderNodes.Size();
-        std::sort(c->m_RenderNodes.Begin(), c->m_RenderNodes.End(), RenderEntrySortPred(scene));
         Matrix4 transform;
 
         if (c->m_RenderNodes.Capacity() > c->m_RenderTransforms.Capacity())
@@ -1441,14 +1706,23 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             c->m_StencilScopeIndices.SetCapacity(new_capacity);
         }
 
+        uint32_t render_count = 0;
         for (uint32_t i = 0; i < node_count; ++i)
         {
-            const RenderEntry& entry = c->m_RenderNodes[i];
+            const RenderEntry entry = c->m_RenderNodes[i];
             uint16_t index = entry.m_Node & 0xffff;
             InternalNode* n = &scene->m_Nodes[index];
             float opacity = 1.0f;
             CalculateNodeSize(n);
             CalculateNodeTransformAndAlphaCached(scene, n, CalculateNodeTransformFlags(CALCULATE_NODE_INCLUDE_SIZE | CALCULATE_NODE_RESET_PIVOT), transform, opacity);
+            if (params.m_ScissorClipping && n->m_ClipperIndex != INVALID_INDEX) {
+                InternalClippingNode* clipper = &c->m_StencilClippingNodes[n->m_ClipperIndex];
+                // The entry that writes the clipper to the stencil buffer isn't needed when clipping with a scissor rectangle
+                if (clipper->m_NodeIndex == index && clipper->m_VisibleRenderKey != entry.m_RenderKey && UpdateScissorScope(n, clipper, transform)) {
+                    continue;
+                }
+            }
+            c->m_RenderNodes[render_count++] = entry;
             c->m_RenderTransforms.Push(transform);
             c->m_RenderOpacities.Push(opacity);
             if (n->m_ClipperIndex != INVALID_INDEX) {
@@ -1471,6 +1745,8 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             }
         }
 
+        c->m_RenderNodes.SetSize(render_count);
+
         scene->m_ResChanged = 0;
         params.m_RenderNodes(scene, c->m_RenderNodes.Begin(), c->m_RenderTransforms.Begin(), c->m_RenderOpacities.Begin(), (const StencilScope**)c->m_StencilScopes.Begin(), c->m_RenderNodes.Size(), context);
     }
@@ -1565,15 +1841,69 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         }
     }
 
+    // Like CompleteAnimation(), but the callbacks are invoked later by DispatchCompletedAnimations()
+    static inline void QueueCompletedAnimation(HScene scene, Animation* anim)
+    {
+        if (anim->m_AnimationCompleteCalled)
+        {
+            return;
+        }
+        anim->m_AnimationCompleteCalled = 1;
+        if (!anim->m_Easing.release_callback && !anim->m_AnimationComplete)
+        {
+            return;
+        }
+
+        dmArray<CompletedAnimation>& completed = scene->m_CompletedAnimations;
+        if (completed.Full())
+        {
+            completed.OffsetCapacity(64);
+        }
+        CompletedAnimation c;
+        c.m_Node = anim->m_Node;
+        c.m_AnimationComplete = anim->m_AnimationComplete;
+        c.m_Easing = anim->m_Easing;
+        c.m_Userdata1 = anim->m_Userdata1;
+        c.m_Userdata2 = anim->m_Userdata2;
+        completed.Push(c);
+    }
+
+    static void DispatchCompletedAnimations(HScene scene)
+    {
+        dmArray<CompletedAnimation>& completed = scene->m_CompletedAnimations;
+        for (uint32_t i = 0; i < completed.Size(); ++i)
+        {
+            CompletedAnimation c = completed[i];
+            // Release the easing curve first, see CompleteAnimation()
+            if (c.m_Easing.release_callback)
+            {
+                c.m_Easing.release_callback(&c.m_Easing);
+            }
+            if (c.m_AnimationComplete)
+            {
+                // An earlier callback might have deleted the node, which would have cancelled the animation
+                bool finished = IsNodeValid(scene, c.m_Node);
+                c.m_AnimationComplete(scene, c.m_Node, finished, c.m_Userdata1, c.m_Userdata2);
+            }
+        }
+        completed.SetSize(0);
+    }
+
     void UpdateAnimations(HScene scene, float dt)
     {
         dmArray<Animation>* animations = &scene->m_Animations;
 
         uint32_t active_animations = 0;
 
+        // The animations are sorted on the property address, so the animations of a node are next
+        // to each other and the enabled state is only looked up once per node
+        uint16_t enabled_index = INVALID_INDEX;
+        bool enabled = false;
+
         for (uint32_t i = 0; i < animations->Size(); ++i)
         {
             Animation* anim = &(*animations)[i];
+            uint16_t node_index = anim->m_Node & 0xffff;
 
             dmGui::Playback playback = anim->m_Playback;
             bool looping = playback == PLAYBACK_LOOP_FORWARD || playback == PLAYBACK_LOOP_BACKWARD || playback == PLAYBACK_LOOP_PINGPONG;
@@ -1584,7 +1914,12 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             {
                 continue;
             }
-            if (!IsNodeEnabledRecursive(scene, anim->m_Node & 0xffff))
+            if (node_index != enabled_index)
+            {
+                enabled_index = node_index;
+                enabled = IsNodeEnabledRecursive(scene, node_index);
+            }
+            if (!enabled)
             {
                 continue;
             }
@@ -1626,9 +1961,13 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
 
                 float x = dmEasing::GetValue(anim->m_Easing, t2);
 
-                *anim->m_Value = anim->m_From + (anim->m_To - anim->m_From) * x;
-                // Flag local transform as dirty for the node
-                scene->m_Nodes[anim->m_Node & 0xffff].m_Node.m_DirtyLocal = 1;
+                float value = anim->m_From + (anim->m_To - anim->m_From) * x;
+                // Flag local transform as dirty for the node, unless the value is unchanged (e.g. during a delay or at the end of the curve)
+                if (*anim->m_Value != value)
+                {
+                    *anim->m_Value = value;
+                    scene->m_Nodes[node_index].m_Node.m_DirtyLocal = 1;
+                }
 
                 // Animation complete, see above
                 if (t >= 1.0f)
@@ -1639,7 +1978,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
                             anim->m_Backwards ^= 1;
                         }
                     } else {
-                        CompleteAnimation(scene, anim, true);
+                        QueueCompletedAnimation(scene, anim);
                     }
                 }
             }
@@ -1649,6 +1988,8 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             }
         }
 
+        DispatchCompletedAnimations(scene);
+
         uint32_t n = animations->Size();
         for (uint32_t i = 0; i < n; ++i)
         {
@@ -1817,6 +2158,13 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
                         lua_rawset(L, -3);
                     }
 
+                    if (ia->m_Timestamp != 0)
+                    {
+                        lua_pushstring(L, "timestamp");
+                        lua_pushnumber(L, ia->m_Timestamp / 1000000.0);
+                        lua_rawset(L, -3);
+                    }
+
                     if (ia->m_PositionSet)
                     {
                         lua_pushstring(L, "x");
@@ -2044,8 +2392,16 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         return result;
     }
 
+    bool IsAnimating(HScene scene)
+    {
+        return !scene->m_Animations.Empty()
+            || !scene->m_AliveParticlefxs.Empty()
+            || (scene->m_Script != 0x0 && scene->m_Script->m_FunctionReferences[SCRIPT_FUNCTION_UPDATE] != LUA_NOREF);
+    }
+
     Result UpdateScene(HScene scene, float dt)
     {
+        DM_MEM_SCOPE(Gui);
         Result result = RunScript(scene, SCRIPT_FUNCTION_UPDATE, LUA_NOREF, (void*)&dt);
 
         uint32_t node_count = scene->m_Nodes.Size();
@@ -2208,8 +2564,14 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     {
         InputArgs args;
         args.m_Consumed = false;
+        const dmArray<dmhash_t>& filter = scene->m_InputFilter;
         for (uint32_t i = 0; i < input_action_count; ++i)
         {
+            if (!filter.Empty() && !std::binary_search(filter.Begin(), filter.End(), input_actions[i].m_ActionId))
+            {
+                input_consumed[i] = false;
+                continue;
+            }
             args.m_Action = &input_actions[i];
             Result result = RunScript(scene, SCRIPT_FUNCTION_ONINPUT, LUA_NOREF, (void*)&args);
             if (result != RESULT_OK)
@@ -2418,6 +2780,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             tail = &parent_n->m_ChildTail;
         }
         n->m_ParentIndex = parent_index;
+        scene->m_RenderEntriesDirty = 1;
         if (prev_n != 0x0)
         {
             if (*tail == prev_n->m_Index)
@@ -2453,6 +2816,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
 
     static void RemoveFromNodeList(HScene scene, InternalNode* n)
     {
+        scene->m_RenderEntriesDirty = 1;
         // Remove from list
         if (n->m_PrevIndex != INVALID_INDEX)
             scene->m_Nodes[n->m_PrevIndex].m_NextIndex = n->m_NextIndex;
@@ -2569,6 +2933,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         scene->m_Nodes.SetSize(0);
         scene->m_RenderHead = INVALID_INDEX;
         scene->m_RenderTail = INVALID_INDEX;
+        scene->m_RenderEntriesDirty = 1;
         scene->m_NodePool.Clear();
         scene->m_Animations.SetSize(0);
     }
@@ -2688,6 +3053,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             }
         }
         scene->m_Animations.SetSize(0);
+        scene->m_RenderEntriesDirty = 1;
     }
 
     uint16_t GetRenderOrder(HScene scene)
@@ -3253,6 +3619,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             InternalNode* n = GetNode(scene, node);
             n->m_Node.m_LayerHash = layer_id;
             n->m_Node.m_LayerIndex = *layer_index;
+            scene->m_RenderEntriesDirty = 1;
             return RESULT_OK;
         }
         else
@@ -3556,6 +3923,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     {
         InternalNode* n = GetNode(scene, node);
         n->m_Node.m_ClippingMode = mode;
+        scene->m_RenderEntriesDirty = 1;
     }
 
     ClippingMode GetNodeClippingMode(HScene scene, HNode node)
@@ -3568,6 +3936,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     {
         InternalNode* n = GetNode(scene, node);
         n->m_Node.m_ClippingVisible = (uint32_t) visible;
+        scene->m_RenderEntriesDirty = 1;
     }
 
     bool GetNodeClippingVisible(HScene scene, HNode node)
@@ -3580,6 +3949,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     {
         InternalNode* n = GetNode(scene, node);
         n->m_Node.m_ClippingInverted = (uint32_t) inverted;
+        scene->m_RenderEntriesDirty = 1;
     }
 
     bool GetNodeClippingInverted(HScene scene, HNode node)
@@ -4106,6 +4476,12 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     void GetNodeFlipbookAnimUVFlip(HScene scene, HNode node, bool& flip_horizontal, bool& flip_vertical)
     {
         InternalNode* n = GetNode(scene, node);
+        if (n->m_Node.m_TextureType == NODE_TEXTURE_TYPE_DYNAMIC)
+        {
+            // Left over from a previous flipbook animation
+            flip_horizontal = flip_vertical = false;
+            return;
+        }
         flip_horizontal = n->m_Node.m_TextureSetAnimDesc.m_FlipHorizontal;
         flip_vertical = n->m_Node.m_TextureSetAnimDesc.m_FlipVertical;
     }
@@ -4171,6 +4547,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     {
         InternalNode* n = GetNode(scene, node);
         n->m_Node.m_Enabled = enabled;
+        scene->m_RenderEntriesDirty = 1;
         if(enabled)
         {
             SetDirtyLocalRecursive(scene, node);
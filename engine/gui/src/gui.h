@@ -245,7 +245,11 @@ namespace dmGui
         uint8_t     m_WriteMask;
         /// Color mask (R,G,B,A)
         uint8_t     m_ColorMask : 4;
-        uint8_t     m_Padding : 4;
+        /// Clip with m_ScissorRect instead of the stencil buffer
+        uint8_t     m_Scissor : 1;
+        uint8_t     m_Padding : 3;
+        /// Scissor rectangle in gui space (min x, min y, max x, max y), valid when m_Scissor is set
+        float       m_ScissorRect[4];
     };
 
     struct Scope {
@@ -450,6 +454,8 @@ namespace dmGui
         char     m_Text[dmHID::MAX_CHAR_COUNT];
         uint32_t m_TextCount;
         uint32_t m_GamepadIndex;
+        /// Time when the input was sampled, in microseconds
+        uint64_t m_Timestamp;
         uint16_t m_IsGamepad : 1;
         uint16_t m_GamepadDisconnected : 1;
         uint16_t m_GamepadConnected : 1;
@@ -525,6 +531,20 @@ namespace dmGui
      */
     typedef void (*SetTextureData)(HScene scene, void* texture, uint32_t width, uint32_t height, dmImage::Type type, const void* buffer, void* context);
 
+    /**
+     * Set texture sub region (update) callback
+     * @param scene
+     * @param texture
+     * @param x
+     * @param y
+     * @param width
+     * @param height
+     * @param type
+     * @param buffer
+     * @param context
+     */
+    typedef void (*SetTextureSubData)(HScene scene, void* texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, dmImage::Type type, const void* buffer, void* context);
+
     typedef void (*AnimationComplete)(HScene scene,
                                       HNode node,
                                       bool finished,
@@ -786,6 +806,8 @@ namespace dmGui
 
     /**
      * Set a layout with id.
+     * The callback is invoked for the nodes that have a different desc in the new layout than in the current one.
+     * Setting the current layout again invokes it for all nodes with a desc.
      * @param scene Scene of which to set layout
      * @param layout_id id of the layout.
      * @param set_node_callback Callback function that will set node from node descriptor
@@ -813,6 +835,12 @@ namespace dmGui
         NewTexture                  m_NewTexture;
         DeleteTexture               m_DeleteTexture;
         SetTextureData              m_SetTextureData;
+        /// Optional. When set, small RGBA dynamic textures are packed into shared atlas pages
+        /// so that nodes using different dynamic textures can be rendered in the same batch.
+        SetTextureSubData           m_SetTextureSubData;
+        /// Clip with a scissor rectangle (see StencilScope::m_Scissor) for box clippers that are axis-aligned,
+        /// not inverted and have no clipping ancestors or descendants. The stencil buffer is used otherwise.
+        bool                        m_ScissorClipping;
     };
 
     void RenderScene(HScene scene, const RenderSceneParams& params, void* context);
@@ -839,6 +867,14 @@ namespace dmGui
      */
     Result UpdateScene(HScene scene, float dt);
 
+    /**
+     * Check if the scene changes by itself, i.e. if it has running animations, live particle effects
+     * or a script update-function that might change the nodes.
+     * @param scene Scene to check
+     * @return True if the scene needs to be redrawn even if nothing else changed
+     */
+    bool IsAnimating(HScene scene);
+
     /** Get first child node
      * @param node Gets the first child node. If 0, gets the first top level node.
      * @return child The first child node
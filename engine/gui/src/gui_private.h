@@ -73,6 +73,7 @@ namespace dmGui
         uint16_t                m_ParentIndex;
         uint16_t                m_NextNonInvIndex;
         uint16_t                m_NodeIndex;
+        uint16_t                m_HasChildClippers : 1;
     };
 
     struct Context
@@ -210,6 +211,17 @@ namespace dmGui
         uint16_t m_Backwards : 1;
     };
 
+    // An animation that finished during UpdateAnimations(). The callbacks are invoked after all
+    // animations have been updated, so that they can't move the animations being updated.
+    struct CompletedAnimation
+    {
+        HNode             m_Node;
+        AnimationComplete m_AnimationComplete;
+        dmEasing::Curve   m_Easing;
+        void*             m_Userdata1;
+        void*             m_Userdata2;
+    };
+
     struct SpineAnimation
     {
         HNode    m_Node;
@@ -252,10 +264,42 @@ namespace dmGui
         void*           m_Handle;
         uint32_t        m_Created : 1;
         uint32_t        m_Deleted : 1;
+        // Stored in a region of a shared page (m_Handle is then the page texture)
+        uint32_t        m_Packed : 1;
         uint32_t        m_Width;
         uint32_t        m_Height;
         void*           m_Buffer;
         dmImage::Type   m_Type;
+        // Region of the page when packed, same layout as a flipbook frame (see GetNodeFlipbookAnimUV)
+        float           m_TexCoords[8];
+        uint16_t        m_Page;
+        uint16_t        m_RegionX;
+        uint16_t        m_RegionY;
+        uint16_t        m_RegionWidth;
+        uint16_t        m_RegionHeight;
+    };
+
+    struct DynamicTexturePageShelf
+    {
+        uint16_t m_Y;
+        uint16_t m_Height;
+        // Next free column
+        uint16_t m_X;
+    };
+
+    /// Shared texture that small dynamic textures are shelf packed into.
+    /// Space is only reclaimed when every region in the page has been released.
+    struct DynamicTexturePage
+    {
+        DynamicTexturePage()
+        : m_Handle(0)
+        , m_RefCount(0)
+        {
+        }
+
+        void*                               m_Handle;
+        dmArray<DynamicTexturePageShelf>    m_Shelves;
+        uint32_t                            m_RefCount;
     };
 
     struct ParticlefxComponent
@@ -279,6 +323,7 @@ namespace dmGui
         dmIndexPool16           m_NodePool;
         dmArray<InternalNode>   m_Nodes;
         dmArray<Animation>      m_Animations;
+        dmArray<CompletedAnimation> m_CompletedAnimations;
         dmArray<SpineAnimation> m_SpineAnimations;
         dmHashTable64<void*>    m_Fonts;
         dmHashTable64<TextureInfo>    m_Textures;
@@ -288,12 +333,19 @@ namespace dmGui
         dmParticle::HParticleContext m_ParticlefxContext;
         dmHashTable64<dmParticle::HPrototype>    m_Particlefxs;
         dmArray<ParticlefxComponent> m_AliveParticlefxs;
+        // Sorted render entries and clippers from the last RenderScene, reused until the node tree changes
+        dmArray<RenderEntry>    m_CachedRenderEntries;
+        dmArray<InternalClippingNode> m_CachedClippers;
         dmHashTable64<uint16_t> m_Layers;
         dmArray<dmhash_t>       m_Layouts;
         dmArray<void*>          m_LayoutsNodeDescs;
         dmhash_t                m_LayoutId;
         AdjustReference         m_AdjustReference;
         dmArray<dmhash_t>       m_DeletedDynamicTextures;
+        // Indexed by DynamicTexture::m_Page, slots of released pages are null
+        dmArray<DynamicTexturePage*> m_DynamicTexturePages;
+        // Sorted ids of the actions passed to on_input, all actions if empty (see gui.set_input_filter)
+        dmArray<dmhash_t>       m_InputFilter;
         void*                   m_DefaultFont;
         void*                   m_UserData;
         uint16_t                m_RenderHead;
@@ -302,6 +354,8 @@ namespace dmGui
         uint16_t                m_RenderOrder; // For the render-key
         uint16_t                m_NextLayerIndex;
         uint16_t                m_ResChanged : 1;
+        // Set when nodes are added, removed, moved, enabled/disabled or change layer or clipping
+        uint16_t                m_RenderEntriesDirty : 1;
         uint32_t                m_Width;
         uint32_t                m_Height;
         dmScript::ScriptWorld*  m_ScriptWorld;
@@ -12,6 +12,7 @@
 
 #include "gui_script.h"
 #include <float.h>
+#include <algorithm>
 
 #include <dlib/hash.h>
 #include <dlib/log.h>
@@ -488,7 +489,7 @@ namespace dmGui
         dmhash_t id = 0;
         if (lua_isstring(L, 2))
         {
-            id = dmHashString64(lua_tostring(L, 2));
+            id = dmScript::HashString(L, 2);
         }
         else
         {
@@ -1002,7 +1003,7 @@ namespace dmGui
         if (dmScript::IsHash(L, 2)) {
            property_hash = dmScript::CheckHash(L, 2);
         } else {
-           property_hash = dmHashString64(luaL_checkstring(L, 2));
+           property_hash = dmScript::HashString(L, 2);
         }
 
         if (!dmGui::HasPropertyHash(scene, hnode, property_hash)) {
@@ -1135,7 +1136,7 @@ namespace dmGui
         if (dmScript::IsHash(L, 2)) {
            property_hash = dmScript::CheckHash(L, 2);
         } else {
-           property_hash = dmHashString64(luaL_checkstring(L, 2));
+           property_hash = dmScript::HashString(L, 2);
         }
 
         if (!dmGui::HasPropertyHash(scene, hnode, property_hash)) {
@@ -2034,9 +2035,9 @@ namespace dmGui
     static int LuaSetClippingMode(lua_State* L)
     {
         HNode hnode;
-        InternalNode* n = LuaCheckNode(L, 1, &hnode);
+        LuaCheckNode(L, 1, &hnode);
         int clipping_mode = (int) luaL_checknumber(L, 2);
-        n->m_Node.m_ClippingMode = (ClippingMode) clipping_mode;
+        SetNodeClippingMode(GuiScriptInstance_Check(L), hnode, (ClippingMode) clipping_mode);
         return 0;
     }
 
@@ -2065,9 +2066,9 @@ namespace dmGui
     static int LuaSetClippingVisible(lua_State* L)
     {
         HNode hnode;
-        InternalNode* n = LuaCheckNode(L, 1, &hnode);
+        LuaCheckNode(L, 1, &hnode);
         int visible = lua_toboolean(L, 2);
-        n->m_Node.m_ClippingVisible = visible;
+        SetNodeClippingVisible(GuiScriptInstance_Check(L), hnode, visible != 0);
         return 0;
     }
 
@@ -2096,9 +2097,9 @@ namespace dmGui
     static int LuaSetClippingInverted(lua_State* L)
     {
         HNode hnode;
-        InternalNode* n = LuaCheckNode(L, 1, &hnode);
+        LuaCheckNode(L, 1, &hnode);
         int inverted = lua_toboolean(L, 2);
-        n->m_Node.m_ClippingInverted = inverted;
+        SetNodeClippingInverted(GuiScriptInstance_Check(L), hnode, inverted != 0);
         return 0;
     }
 
@@ -3274,6 +3275,55 @@ namespace dmGui
         return 0;
     }
 
+    /*# limits the input actions passed to on_input
+     * Only the listed actions are passed to the `on_input` function of the current GUI scene.
+     * Other actions skip the scene script entirely, which saves a call into Lua for every action
+     * the scene would ignore anyway. This is useful when many GUI scenes have input focus.
+     *
+     * While a filter is set, cursor movement that is not bound to an action (`action_id` is `nil`)
+     * is not passed to the scene either.
+     *
+     * Call the function without arguments to pass all actions to the scene again.
+     *
+     * @name gui.set_input_filter
+     * @param [actions] [type:table] list of action ids, as hashes or strings
+     * @examples
+     *
+     * Only receive touch actions:
+     *
+     * ```lua
+     * function init(self)
+     *     msg.post(".", "acquire_input_focus")
+     *     gui.set_input_filter({ hash("touch") })
+     * end
+     * ```
+     */
+    static int LuaSetInputFilter(lua_State* L)
+    {
+        Scene* scene = GuiScriptInstance_Check(L);
+        dmArray<dmhash_t>& filter = scene->m_InputFilter;
+        filter.SetSize(0);
+        if (lua_isnoneornil(L, 1))
+        {
+            return 0;
+        }
+
+        luaL_checktype(L, 1, LUA_TTABLE);
+        uint32_t count = (uint32_t) lua_objlen(L, 1);
+        if (filter.Capacity() < count)
+        {
+            filter.SetCapacity(count);
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            lua_rawgeti(L, 1, (int) i + 1);
+            filter.Push(dmScript::CheckHashOrString(L, -1));
+            lua_pop(L, 1);
+        }
+        std::sort(filter.Begin(), filter.End());
+        return 0;
+    }
+
     /*# default keyboard
      *
      * @name gui.KEYBOARD_TYPE_DEFAULT
@@ -4594,6 +4644,7 @@ namespace dmGui
         {"get_screen_position", LuaGetScreenPosition},
         {"reset_nodes",     LuaResetNodes},
         {"set_render_order",LuaSetRenderOrder},
+        {"set_input_filter",LuaSetInputFilter},
         {"set_fill_angle", LuaSetPieFillAngle},
         {"get_fill_angle", LuaGetPieFillAngle},
         {"set_perimeter_vertices", LuaSetPerimeterVertices},
@@ -5231,6 +5282,7 @@ namespace dmGui
      * `screen_dx` | The change in screen space x value of a pointer device, if present.
      * `screen_dy` | The change in screen space y value of a pointer device, if present.
      * `gamepad`   | The index of the gamepad device that provided the input.
+     * `timestamp` | The time, in seconds, when the input was sampled. Use it to measure the time between inputs, e.g. for gestures.
      * `touch`     | List of touch input, one element per finger, if present. See table below about touch input
      *
      * Touch input table:
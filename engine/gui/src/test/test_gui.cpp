@@ -848,6 +848,37 @@ TEST_F(dmGuiTest, Layouts)
     ASSERT_EQ(dmGui::RESULT_OK, r);
 }
 
+TEST_F(dmGuiTest, LayoutsOnlySetChangedNodes)
+{
+    dmGui::AllocateLayouts(m_Scene, 2, 1);
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::AddLayout(m_Scene, "layout1"));
+    dmhash_t l1_hash = dmHashString64("layout1");
+
+    Point3 p0(0,0,0);
+    Point3 p1(1,0,0);
+    dmGui::HNode node1 = dmGui::NewNode(m_Scene, Point3(3,0,0), Vector3(1,1,1), dmGui::NODE_TYPE_BOX);
+    dmGui::HNode node2 = dmGui::NewNode(m_Scene, Point3(3,0,0), Vector3(1,1,1), dmGui::NODE_TYPE_BOX);
+    // node1 has the same desc in both layouts, node2 is overridden in layout1
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::SetNodeLayoutDesc(m_Scene, node1, &p0, 0, 1));
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::SetNodeLayoutDesc(m_Scene, node2, &p0, 0, 0));
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::SetNodeLayoutDesc(m_Scene, node2, &p1, 1, 1));
+
+    // Setting the current layout sets all nodes
+    dmGui::SetLayout(m_Scene, dmGui::DEFAULT_LAYOUT, SetNodeCallback);
+    ASSERT_EQ(0, dmGui::GetNodePosition(m_Scene, node1).getX());
+    ASSERT_EQ(0, dmGui::GetNodePosition(m_Scene, node2).getX());
+
+    dmGui::SetNodePosition(m_Scene, node1, Point3(5,0,0));
+    dmGui::SetNodePosition(m_Scene, node2, Point3(5,0,0));
+    dmGui::SetLayout(m_Scene, l1_hash, SetNodeCallback);
+    ASSERT_EQ(5, dmGui::GetNodePosition(m_Scene, node1).getX());
+    ASSERT_EQ(1, dmGui::GetNodePosition(m_Scene, node2).getX());
+
+    dmGui::SetLayout(m_Scene, dmGui::DEFAULT_LAYOUT, SetNodeCallback);
+    ASSERT_EQ(5, dmGui::GetNodePosition(m_Scene, node1).getX());
+    ASSERT_EQ(0, dmGui::GetNodePosition(m_Scene, node2).getX());
+}
+
 TEST_F(dmGuiTest, NodeTextureType)
 {
     int t1, t2;
@@ -1157,6 +1188,103 @@ TEST_F(dmGuiTest, DynamicTexture)
 }
 
 
+struct DynamicTexturePackingContext
+{
+    int m_LiveTextures;
+    int m_SubUpdates;
+};
+
+static void* PackingNewTexture(dmGui::HScene scene, uint32_t width, uint32_t height, dmImage::Type type, const void* buffer, void* context)
+{
+    ((DynamicTexturePackingContext*) context)->m_LiveTextures++;
+    return malloc(16);
+}
+
+static void PackingDeleteTexture(dmGui::HScene scene, void* texture, void* context)
+{
+    ((DynamicTexturePackingContext*) context)->m_LiveTextures--;
+    free(texture);
+}
+
+static void PackingSetTextureSubData(dmGui::HScene scene, void* texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, dmImage::Type type, const void* buffer, void* context)
+{
+    ((DynamicTexturePackingContext*) context)->m_SubUpdates++;
+}
+
+static void PackingRenderNodes(dmGui::HScene scene, const dmGui::RenderEntry* nodes, const Vectormath::Aos::Matrix4* node_transforms, const float* node_opacities,
+        const dmGui::StencilScope** stencil_scopes, uint32_t node_count, void* context)
+{
+}
+
+TEST_F(dmGuiTest, DynamicTexturePacking)
+{
+    DynamicTexturePackingContext context = {0, 0};
+    dmGui::RenderSceneParams rp;
+    rp.m_RenderNodes = PackingRenderNodes;
+    rp.m_NewTexture = PackingNewTexture;
+    rp.m_DeleteTexture = PackingDeleteTexture;
+    rp.m_SetTextureData = DynamicSetTextureData;
+    rp.m_SetTextureSubData = PackingSetTextureSubData;
+
+    const int width = 2;
+    const int height = 2;
+    char data[width * height * 4] = { 0 };
+    char data_rgb[width * height * 3] = { 0 };
+
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::NewDynamicTexture(m_Scene, dmHashString64("t1"), width, height, dmImage::TYPE_RGBA, false, data, sizeof(data)));
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::NewDynamicTexture(m_Scene, dmHashString64("t2"), width, height, dmImage::TYPE_RGBA, false, data, sizeof(data)));
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::NewDynamicTexture(m_Scene, dmHashString64("t3"), width, height, dmImage::TYPE_RGB, false, data_rgb, sizeof(data_rgb)));
+
+    dmGui::HNode n1 = dmGui::NewNode(m_Scene, Point3(5,5,0), Vector3(10,10,0), dmGui::NODE_TYPE_BOX);
+    dmGui::HNode n2 = dmGui::NewNode(m_Scene, Point3(5,5,0), Vector3(10,10,0), dmGui::NODE_TYPE_BOX);
+    dmGui::HNode n3 = dmGui::NewNode(m_Scene, Point3(5,5,0), Vector3(10,10,0), dmGui::NODE_TYPE_BOX);
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::SetNodeTexture(m_Scene, n1, "t1"));
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::SetNodeTexture(m_Scene, n2, "t2"));
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::SetNodeTexture(m_Scene, n3, "t3"));
+
+    dmGui::RenderScene(m_Scene, rp, &context);
+
+    // One shared page for the RGBA textures, and a texture of its own for the RGB one
+    ASSERT_EQ(2, context.m_LiveTextures);
+    ASSERT_EQ(2, context.m_SubUpdates);
+
+    dmGui::NodeTextureType texture_type;
+    void* t1 = dmGui::GetNodeTexture(m_Scene, n1, &texture_type);
+    ASSERT_EQ(dmGui::NODE_TEXTURE_TYPE_DYNAMIC, texture_type);
+    ASSERT_NE((void*) 0, t1);
+    ASSERT_EQ(t1, dmGui::GetNodeTexture(m_Scene, n2, &texture_type));
+    ASSERT_NE(t1, dmGui::GetNodeTexture(m_Scene, n3, &texture_type));
+
+    const float* uv1 = dmGui::GetNodeFlipbookAnimUV(m_Scene, n1);
+    const float* uv2 = dmGui::GetNodeFlipbookAnimUV(m_Scene, n2);
+    ASSERT_NE((const float*) 0, uv1);
+    ASSERT_NE((const float*) 0, uv2);
+    ASSERT_EQ((const float*) 0, dmGui::GetNodeFlipbookAnimUV(m_Scene, n3));
+    ASSERT_LT(uv1[0], uv1[4]);
+    ASSERT_LT(uv1[1], uv1[3]);
+    ASSERT_NE(uv1[0], uv2[0]);
+
+    // Updating with the same size reuses the region
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::SetDynamicTextureData(m_Scene, dmHashString64("t1"), width, height, dmImage::TYPE_RGBA, false, data, sizeof(data)));
+    dmGui::RenderScene(m_Scene, rp, &context);
+    ASSERT_EQ(3, context.m_SubUpdates);
+    ASSERT_EQ(t1, dmGui::GetNodeTexture(m_Scene, n1, &texture_type));
+
+    // The page is released with its last region
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::DeleteDynamicTexture(m_Scene, dmHashString64("t1")));
+    dmGui::RenderScene(m_Scene, rp, &context);
+    ASSERT_EQ(2, context.m_LiveTextures);
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::DeleteDynamicTexture(m_Scene, dmHashString64("t2")));
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::DeleteDynamicTexture(m_Scene, dmHashString64("t3")));
+    dmGui::RenderScene(m_Scene, rp, &context);
+    ASSERT_EQ(0, context.m_LiveTextures);
+
+    dmGui::DeleteNode(m_Scene, n1, true);
+    dmGui::DeleteNode(m_Scene, n2, true);
+    dmGui::DeleteNode(m_Scene, n3, true);
+}
+
+
 #define ASSERT_BUFFER(exp, act, count)\
     for (uint32_t i = 0; i < count; ++i) {\
         ASSERT_EQ((exp)[i], (act)[i]);\
@@ -1671,6 +1799,46 @@ TEST_F(dmGuiTest, AnimateComplete)
     dmGui::DeleteNode(m_Scene, node, true);
 }
 
+static uint32_t g_DeleteOtherCompleteCount = 0;
+static uint32_t g_DeleteOtherFinishedCount = 0;
+static void DeleteOtherComplete(dmGui::HScene scene,
+                         dmGui::HNode node,
+                         bool finished,
+                         void* userdata1,
+                         void* userdata2)
+{
+    g_DeleteOtherCompleteCount++;
+    if (finished)
+        g_DeleteOtherFinishedCount++;
+    dmGui::HNode other = (dmGui::HNode) (uintptr_t) userdata1;
+    if (other && dmGui::IsNodeValid(scene, other))
+        dmGui::DeleteNode(scene, other, true);
+}
+
+TEST_F(dmGuiTest, AnimateCompleteDeletesNode)
+{
+    g_DeleteOtherCompleteCount = 0;
+    g_DeleteOtherFinishedCount = 0;
+    dmGui::HNode node1 = dmGui::NewNode(m_Scene, Point3(0,0,0), Vector3(10,10,0), dmGui::NODE_TYPE_BOX);
+    dmGui::HNode node2 = dmGui::NewNode(m_Scene, Point3(0,0,0), Vector3(10,10,0), dmGui::NODE_TYPE_BOX);
+    dmhash_t property = dmGui::GetPropertyHash(dmGui::PROPERTY_POSITION);
+    // Both animations finish in the same update, the first callback deletes the second node
+    dmGui::AnimateNodeHash(m_Scene, node1, property, Vector4(1,0,0,0), dmEasing::Curve(dmEasing::TYPE_LINEAR), dmGui::PLAYBACK_ONCE_FORWARD, 1.0f, 0, &DeleteOtherComplete, (void*)(uintptr_t) node2, 0);
+    dmGui::AnimateNodeHash(m_Scene, node2, property, Vector4(1,0,0,0), dmEasing::Curve(dmEasing::TYPE_LINEAR), dmGui::PLAYBACK_ONCE_FORWARD, 1.0f, 0, &DeleteOtherComplete, 0, 0);
+
+    for (int i = 0; i < 60; ++i)
+    {
+        dmGui::UpdateScene(m_Scene, 1.0f / 60.0f);
+    }
+
+    ASSERT_EQ(2U, g_DeleteOtherCompleteCount);
+    ASSERT_EQ(1U, g_DeleteOtherFinishedCount);
+    ASSERT_FALSE(dmGui::IsNodeValid(m_Scene, node2));
+    ASSERT_NEAR(dmGui::GetNodePosition(m_Scene, node1).getX(), 1.0f, EPSILON);
+
+    dmGui::DeleteNode(m_Scene, node1, true);
+}
+
 void MyPingPongComplete2(dmGui::HScene scene,
                          dmGui::HNode node,
                          bool finished,
@@ -2317,6 +2485,43 @@ TEST_F(dmGuiTest, ScriptInputMouseMovement)
     ASSERT_EQ(dmGui::RESULT_OK, r);
 }
 
+TEST_F(dmGuiTest, ScriptInputFilter)
+{
+    const char* s = "function init(self)\n"
+                    "   gui.set_input_filter({hash(\"SPACE\"), \"ENTER\"})\n"
+                    "end\n"
+                    "function on_input(self, action_id, action)\n"
+                    "   assert(action_id == hash(\"SPACE\") or action_id == hash(\"ENTER\"))\n"
+                    "   g_count = (g_count or 0) + 1\n"
+                    "   return true\n"
+                    "end\n"
+                    "function update(self)\n"
+                    "   assert(g_count == 2)\n"
+                    "end\n";
+
+    dmGui::Result r;
+    r = dmGui::SetScript(m_Script, LuaSourceFromStr(s));
+    ASSERT_EQ(dmGui::RESULT_OK, r);
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::InitScene(m_Scene));
+
+    dmGui::InputAction input_actions[4];
+    input_actions[0].m_ActionId = dmHashString64("SPACE");
+    input_actions[1].m_ActionId = dmHashString64("LEFT");
+    input_actions[2].m_ActionId = dmHashString64("ENTER");
+    input_actions[3].m_ActionId = 0;
+    input_actions[3].m_PositionSet = 1;
+    bool consumed[4];
+    r = dmGui::DispatchInput(m_Scene, input_actions, 4, consumed);
+    ASSERT_EQ(dmGui::RESULT_OK, r);
+    ASSERT_TRUE(consumed[0]);
+    ASSERT_FALSE(consumed[1]);
+    ASSERT_TRUE(consumed[2]);
+    ASSERT_FALSE(consumed[3]);
+
+    r = dmGui::UpdateScene(m_Scene, 1.0f / 60.0f);
+    ASSERT_EQ(dmGui::RESULT_OK, r);
+}
+
 struct TestMessage
 {
     dmhash_t m_ComponentId;
@@ -4210,6 +4415,40 @@ TEST_F(dmGuiTest, MoveNodesLoad)
 //   - initial order
 //   - parent second to third
 
+// Verify that the render entries are reused until the node tree changes
+TEST_F(dmGuiTest, RenderEntriesCache)
+{
+    Vector3 size(10, 10, 0);
+    Point3 pos(size * 0.5f);
+
+    std::map<dmGui::HNode, uint16_t> order;
+    dmGui::HNode n1 = dmGui::NewNode(m_Scene, pos, size, dmGui::NODE_TYPE_BOX);
+    dmGui::HNode n2 = dmGui::NewNode(m_Scene, pos, size, dmGui::NODE_TYPE_BOX);
+    ASSERT_TRUE(m_Scene->m_RenderEntriesDirty);
+    dmGui::RenderScene(m_Scene, RenderNodesOrder, &order);
+    ASSERT_FALSE(m_Scene->m_RenderEntriesDirty);
+    ASSERT_EQ(2u, order.size());
+
+    // Property changes don't affect the render entries
+    dmGui::SetNodePosition(m_Scene, n1, Point3(1, 2, 0));
+    ASSERT_FALSE(m_Scene->m_RenderEntriesDirty);
+    dmGui::RenderScene(m_Scene, RenderNodesOrder, &order);
+    ASSERT_EQ(0u, order[n1]);
+    ASSERT_EQ(1u, order[n2]);
+
+    dmGui::MoveNodeAbove(m_Scene, n1, n2);
+    ASSERT_TRUE(m_Scene->m_RenderEntriesDirty);
+    dmGui::RenderScene(m_Scene, RenderNodesOrder, &order);
+    ASSERT_EQ(1u, order[n1]);
+    ASSERT_EQ(0u, order[n2]);
+
+    dmGui::SetNodeEnabled(m_Scene, n2, false);
+    ASSERT_TRUE(m_Scene->m_RenderEntriesDirty);
+    dmGui::RenderScene(m_Scene, RenderNodesOrder, &order);
+    ASSERT_EQ(1u, order.size());
+    ASSERT_EQ(0u, order[n1]);
+}
+
 TEST_F(dmGuiTest, Parenting)
 {
     // Setup
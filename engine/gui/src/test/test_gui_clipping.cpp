@@ -132,8 +132,10 @@ public:
     std::map<dmGui::HNode, dmGui::StencilScope> m_NodeToClipping;
     std::map<dmGui::HNode, uint64_t> m_NodeToRenderOrder;
     std::map<dmGui::HNode, uint64_t> m_NodeToClippingOrder;
+    std::map<dmGui::HNode, Vectormath::Aos::Matrix4> m_NodeToTransform;
 
     void Clear() {
+        m_NodeToTransform.clear();
         m_NodeToClipping.clear();
         m_NodeToRenderOrder.clear();
         m_NodeToClippingOrder.clear();
@@ -173,6 +175,7 @@ public:
         {
             dmGui::HNode node = entries[i].m_Node;
             const dmGui::StencilScope* scope = stencil_scopes[i];
+            self->m_NodeToTransform[node] = node_transforms[i];
             if (scope != 0x0) {
                 if (self->m_NodeToClipping.find(node) == self->m_NodeToClipping.end()) {
                     self->m_NodeToClipping[node] = *scope;
@@ -215,12 +218,15 @@ public:
         return node;
     }
 
-    void Render() {
+    void Render(bool scissor_clipping = false) {
+        m_NodeToTransform.clear();
         m_NodeToClipping.clear();
         m_NodeToRenderOrder.clear();
+        m_NodeToClippingOrder.clear();
         m_Renderer.ClearBuffer();
         dmGui::RenderSceneParams params;
         params.m_RenderNodes = RenderNodes;
+        params.m_ScissorClipping = scissor_clipping;
         dmGui::RenderScene(m_Scene, params, this);
     }
 
@@ -1146,6 +1152,66 @@ TEST_F(dmGuiClippingTest, TestOverflowClearEnd) {
     Render();
 }
 
+/* SCISSOR TESTS */
+
+/**
+ * Test that only the axis-aligned clipper without other clippers above or below it uses a scissor rectangle:
+ * - a
+ * - b (rotated)
+ * - c
+ *   - d
+ * - e (inv)
+ */
+TEST_F(dmGuiClippingTest, TestScissor) {
+    dmGui::SetSceneResolution(m_Scene, 640, 480);
+    dmGui::SetPhysicalResolution(m_Context, 640, 480);
+
+    dmGui::HNode a = AddClipperBox("a");
+    dmGui::HNode a_child = AddBox("a_child", a);
+    dmGui::HNode b = AddClipperBox("b");
+    dmGui::HNode b_child = AddBox("b_child", b);
+    dmGui::HNode c = AddClipperBox("c");
+    dmGui::HNode c_child = AddBox("c_child", c);
+    dmGui::HNode d = AddClipperBox("d", c);
+    dmGui::HNode d_child = AddBox("d_child", d);
+    dmGui::HNode e = AddInvClipperBox("e");
+    dmGui::HNode e_child = AddBox("e_child", e);
+
+    dmGui::SetNodePosition(m_Scene, a, Point3(10.0f, 20.0f, 0.0f));
+    dmGui::SetNodeProperty(m_Scene, a, dmGui::PROPERTY_SIZE, Vector4(100.0f, 50.0f, 0.0f, 0.0f));
+    dmGui::SetNodeClippingVisible(m_Scene, a, true);
+    dmGui::SetNodeProperty(m_Scene, b, dmGui::PROPERTY_SIZE, Vector4(100.0f, 50.0f, 0.0f, 0.0f));
+    dmGui::SetNodeProperty(m_Scene, b, dmGui::PROPERTY_ROTATION, Vector4(0.0f, 0.0f, 45.0f, 0.0f));
+
+    Render(true);
+
+    dmGui::StencilScope state;
+    GetStencilScope(a_child, state);
+    ASSERT_TRUE(state.m_Scissor);
+    ASSERT_TRUE(m_NodeToClippingOrder.find(a) == m_NodeToClippingOrder.end());
+
+    const Vectormath::Aos::Matrix4& transform = m_NodeToTransform[a];
+    Vectormath::Aos::Vector4 p0 = transform * Point3(0.0f, 0.0f, 0.0f);
+    Vectormath::Aos::Vector4 p1 = transform * Point3(1.0f, 1.0f, 0.0f);
+    ASSERT_NEAR(p0.getX(), state.m_ScissorRect[0], 0.001f);
+    ASSERT_NEAR(p0.getY(), state.m_ScissorRect[1], 0.001f);
+    ASSERT_NEAR(p1.getX(), state.m_ScissorRect[2], 0.001f);
+    ASSERT_NEAR(p1.getY(), state.m_ScissorRect[3], 0.001f);
+
+    dmGui::HNode stencil_children[] = {b_child, c_child, d_child, e_child};
+    for (uint32_t i = 0; i < sizeof(stencil_children) / sizeof(stencil_children[0]); ++i) {
+        GetStencilScope(stencil_children[i], state);
+        ASSERT_FALSE(state.m_Scissor);
+    }
+
+    // Without scissor clipping, the same scene is clipped with the stencil buffer only
+    Render();
+    GetStencilScope(a_child, state);
+    ASSERT_FALSE(state.m_Scissor);
+    GetStencilScope(a, state);
+    ASSERT_EQ((int)BITS(11111111), (int)GetWriteMask(state));
+}
+
 #undef BITS
 
 int main(int argc, char **argv)
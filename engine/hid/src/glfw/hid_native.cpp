@@ -15,11 +15,14 @@
 #include <assert.h>
 #include <string.h>
 
+#include <dlib/atomic.h>
 #include <dlib/log.h>
 #include <dlib/utf8.h>
 #include <dlib/dstrings.h>
 #include <dlib/math.h>
 #include <dlib/static_assert.h>
+#include <dlib/thread.h>
+#include <dlib/time.h>
 
 #include <dmsdk/graphics/glfw/glfw.h>
 
@@ -73,6 +76,156 @@ namespace dmHID
         SetGamepadConnectivity(g_Context, gamepad_id, connected);
     }
 
+    /// Gamepad state as read from glfw
+    struct GamepadState
+    {
+        float       m_Axis[MAX_GAMEPAD_AXIS_COUNT];
+        uint32_t    m_Buttons[MAX_GAMEPAD_BUTTON_COUNT / 32 + 1];
+        uint8_t     m_Hat[MAX_GAMEPAD_HAT_COUNT];
+        uint32_t    m_AxisCount;
+        uint32_t    m_ButtonCount;
+        uint8_t     m_HatCount;
+        bool        m_Connected;
+    };
+
+    struct GamepadPollState
+    {
+        GamepadState m_Gamepads[MAX_GAMEPAD_COUNT];
+    };
+
+    /*
+     * Polls the gamepads on a background thread. The states are passed to the main thread
+     * through a lock-free triple buffer: the poll thread writes to its own buffer and swaps it
+     * with the shared one, Update() swaps its buffer with the shared one when a new state has
+     * been published. Neither side ever waits for the other.
+     */
+    struct GamepadPoller
+    {
+        GamepadPollState    m_States[3];
+        /// Index of the shared buffer, with GAMEPAD_POLL_NEW_STATE set when it hasn't been read
+        int32_atomic_t      m_SharedIndex;
+        uint32_t            m_WriteIndex;
+        uint32_t            m_ReadIndex;
+        /// Microseconds between polls
+        uint32_t            m_Interval;
+        int32_atomic_t      m_Run;
+        dmThread::Thread    m_Thread;
+    };
+
+    static const int32_t GAMEPAD_POLL_NEW_STATE = 4;
+    static const uint32_t GAMEPAD_POLL_MAX_RATE = 1000;
+
+    static void PollGamepad(uint32_t index, GamepadState* state)
+    {
+        int glfw_joystick = GLFW_JOYSTICKS[index];
+        state->m_Connected = glfwGetJoystickParam(glfw_joystick, GLFW_PRESENT) == GL_TRUE;
+        if (!state->m_Connected)
+        {
+            return;
+        }
+
+        state->m_AxisCount = glfwGetJoystickParam(glfw_joystick, GLFW_AXES);
+        glfwGetJoystickPos(glfw_joystick, state->m_Axis, state->m_AxisCount);
+
+        state->m_HatCount = dmMath::Min(MAX_GAMEPAD_HAT_COUNT, (uint32_t) glfwGetJoystickParam(glfw_joystick, GLFW_HATS));
+        glfwGetJoystickHats(glfw_joystick, state->m_Hat, state->m_HatCount);
+
+        state->m_ButtonCount = dmMath::Min(MAX_GAMEPAD_BUTTON_COUNT, (uint32_t) glfwGetJoystickParam(glfw_joystick, GLFW_BUTTONS));
+        unsigned char buttons[MAX_GAMEPAD_BUTTON_COUNT];
+        glfwGetJoystickButtons(glfw_joystick, buttons, state->m_ButtonCount);
+        memset(state->m_Buttons, 0, sizeof(state->m_Buttons));
+        for (uint32_t j = 0; j < state->m_ButtonCount; ++j)
+        {
+            if (buttons[j] == GLFW_PRESS)
+                state->m_Buttons[j / 32] |= 1 << (j % 32);
+        }
+    }
+
+    static void ApplyGamepadState(Gamepad* pad, const GamepadState* state)
+    {
+        bool prev_connected = pad->m_Connected;
+        pad->m_Connected = state->m_Connected;
+        if (!pad->m_Connected)
+        {
+            return;
+        }
+
+        GamepadPacket& packet = pad->m_Packet;
+
+        // Workaround to get connectivity packet even if callback
+        // wasn't been set before the gamepad was connected.
+        if (!prev_connected)
+        {
+            packet.m_GamepadConnected = true;
+        }
+
+        pad->m_AxisCount = state->m_AxisCount;
+        memcpy(packet.m_Axis, state->m_Axis, sizeof(float) * state->m_AxisCount);
+        pad->m_HatCount = state->m_HatCount;
+        memcpy(packet.m_Hat, state->m_Hat, state->m_HatCount);
+        pad->m_ButtonCount = state->m_ButtonCount;
+        memcpy(packet.m_Buttons, state->m_Buttons, sizeof(packet.m_Buttons));
+    }
+
+    static int32_t SwapSharedIndex(GamepadPoller* poller, int32_t index)
+    {
+        // Compare-and-swap for the full memory barrier, the buffer contents must be visible before the index
+        int32_t prev;
+        do
+        {
+            prev = poller->m_SharedIndex;
+        } while (dmAtomicCompareStore32(&poller->m_SharedIndex, index, prev) != prev);
+        return prev;
+    }
+
+    static void GamepadPollThread(void* ctx)
+    {
+        GamepadPoller* poller = (GamepadPoller*)ctx;
+        while (dmAtomicAdd32(&poller->m_Run, 0))
+        {
+            uint64_t start = dmTime::GetTime();
+
+            GamepadPollState* state = &poller->m_States[poller->m_WriteIndex];
+            for (uint32_t i = 0; i < MAX_GAMEPAD_COUNT; ++i)
+            {
+                PollGamepad(i, &state->m_Gamepads[i]);
+            }
+            poller->m_WriteIndex = SwapSharedIndex(poller, poller->m_WriteIndex | GAMEPAD_POLL_NEW_STATE) & ~GAMEPAD_POLL_NEW_STATE;
+
+            uint64_t elapsed = dmTime::GetTime() - start;
+            if (elapsed < poller->m_Interval)
+            {
+                dmTime::Sleep((uint32_t)(poller->m_Interval - elapsed));
+            }
+        }
+    }
+
+    static GamepadPoller* NewGamepadPoller(uint32_t rate)
+    {
+        GamepadPoller* poller = new GamepadPoller;
+        memset(poller, 0, sizeof(GamepadPoller));
+        poller->m_WriteIndex = 0;
+        poller->m_SharedIndex = 1;
+        poller->m_ReadIndex = 2;
+        poller->m_Interval = 1000000 / dmMath::Min(rate, GAMEPAD_POLL_MAX_RATE);
+        poller->m_Run = 1;
+        poller->m_Thread = dmThread::New(GamepadPollThread, 0x10000, poller, "gamepad_poll");
+        if (!poller->m_Thread)
+        {
+            dmLogWarning("Could not start the gamepad poll thread, polling gamepads on the main thread.");
+            delete poller;
+            return 0;
+        }
+        return poller;
+    }
+
+    static void DeleteGamepadPoller(GamepadPoller* poller)
+    {
+        dmAtomicStore32(&poller->m_Run, 0);
+        dmThread::Join(poller->m_Thread);
+        delete poller;
+    }
+
     bool Init(HContext context)
     {
         if (context != 0x0)
@@ -103,6 +256,10 @@ namespace dmHID
                 gamepad.m_HatCount = 0;
                 memset(&gamepad.m_Packet, 0, sizeof(GamepadPacket));
             }
+            if (context->m_GamepadPollRate > 0 && !context->m_IgnoreGamepads)
+            {
+                context->m_GamepadPoller = NewGamepadPoller(context->m_GamepadPollRate);
+            }
             return true;
         }
         return false;
@@ -110,6 +267,11 @@ namespace dmHID
 
     void Final(HContext context)
     {
+        if (context->m_GamepadPoller)
+        {
+            DeleteGamepadPoller(context->m_GamepadPoller);
+            context->m_GamepadPoller = 0;
+        }
         g_Context = 0;
     }
 
@@ -119,6 +281,7 @@ namespace dmHID
         // running glfwSwapBuffers for event queue polling
         // Accessing OpenGL isn't permitted on iOS when the application is transitioning to resumed mode either
         glfwPollEvents();
+        context->m_UpdateTime = dmTime::GetTime();
 
         // Update keyboard
         if (!context->m_IgnoreKeyboard)
@@ -175,39 +338,27 @@ namespace dmHID
         // Update gamepads
         if (!context->m_IgnoreGamepads)
         {
-            for (uint32_t i = 0; i < MAX_GAMEPAD_COUNT; ++i)
+            GamepadPoller* poller = context->m_GamepadPoller;
+            if (poller)
             {
-                Gamepad* pad = &context->m_Gamepads[i];
-                int glfw_joystick = GLFW_JOYSTICKS[i];
-                bool prev_connected = pad->m_Connected;
-                pad->m_Connected = glfwGetJoystickParam(glfw_joystick, GLFW_PRESENT) == GL_TRUE;
-                if (pad->m_Connected)
+                // Pick up the latest state from the poll thread, if there is a new one
+                if (poller->m_SharedIndex & GAMEPAD_POLL_NEW_STATE)
                 {
-                    GamepadPacket& packet = pad->m_Packet;
-
-                    // Workaround to get connectivity packet even if callback
-                    // wasn't been set before the gamepad was connected.
-                    if (!prev_connected)
-                    {
-                        packet.m_GamepadConnected = true;
-                    }
-
-                    pad->m_AxisCount = glfwGetJoystickParam(glfw_joystick, GLFW_AXES);
-                    glfwGetJoystickPos(glfw_joystick, packet.m_Axis, pad->m_AxisCount);
-
-                    pad->m_HatCount = dmMath::Min(MAX_GAMEPAD_HAT_COUNT, (uint32_t) glfwGetJoystickParam(glfw_joystick, GLFW_HATS));
-                    glfwGetJoystickHats(glfw_joystick, packet.m_Hat, pad->m_HatCount);
-
-                    pad->m_ButtonCount = dmMath::Min(MAX_GAMEPAD_BUTTON_COUNT, (uint32_t) glfwGetJoystickParam(glfw_joystick, GLFW_BUTTONS));
-                    unsigned char buttons[MAX_GAMEPAD_BUTTON_COUNT];
-                    glfwGetJoystickButtons(glfw_joystick, buttons, pad->m_ButtonCount);
-                    for (uint32_t j = 0; j < pad->m_ButtonCount; ++j)
-                    {
-                        if (buttons[j] == GLFW_PRESS)
-                            packet.m_Buttons[j / 32] |= 1 << (j % 32);
-                        else
-                            packet.m_Buttons[j / 32] &= ~(1 << (j % 32));
-                    }
+                    poller->m_ReadIndex = SwapSharedIndex(poller, poller->m_ReadIndex) & ~GAMEPAD_POLL_NEW_STATE;
+                }
+                const GamepadPollState* state = &poller->m_States[poller->m_ReadIndex];
+                for (uint32_t i = 0; i < MAX_GAMEPAD_COUNT; ++i)
+                {
+                    ApplyGamepadState(&context->m_Gamepads[i], &state->m_Gamepads[i]);
+                }
+            }
+            else
+            {
+                for (uint32_t i = 0; i < MAX_GAMEPAD_COUNT; ++i)
+                {
+                    GamepadState state;
+                    PollGamepad(i, &state);
+                    ApplyGamepadState(&context->m_Gamepads[i], &state);
                 }
             }
         }
@@ -41,6 +41,7 @@ namespace dmHID
         context->m_IgnoreTouchDevice = params.m_IgnoreTouchDevice;
         context->m_IgnoreAcceleration = params.m_IgnoreAcceleration;
         context->m_FlipScrollDirection = params.m_FlipScrollDirection;
+        context->m_GamepadPollRate = params.m_GamepadPollRate;
 
         context->m_GamepadConnectivityCallback = params.m_GamepadConnectivityCallback;
         return context;
@@ -126,6 +127,11 @@ namespace dmHID
         return device->m_Connected;
     }
 
+    uint64_t GetUpdateTime(HContext context)
+    {
+        return context->m_UpdateTime;
+    }
+
     bool IsAccelerometerConnected(HContext context)
     {
         return context->m_AccelerometerConnected;
@@ -82,6 +82,8 @@ namespace dmHID
         uint32_t m_IgnoreAcceleration : 1;
         /// if mouse wheel scroll direction should be flipped (see DEF-2450)
         uint32_t m_FlipScrollDirection : 1;
+        /// rate (Hz) to poll gamepads at on a background thread, 0 polls them in Update()
+        uint32_t m_GamepadPollRate;
 
         DMHIDGamepadFunc m_GamepadConnectivityCallback;
 
@@ -132,6 +134,14 @@ namespace dmHID
      */
     void Update(HContext context);
 
+    /**
+     * Get the time of the latest Update, i.e. when the current device state was sampled.
+     *
+     * @param context context handle
+     * @return time in microseconds, as given by dmTime::GetTime(). 0 if the context was never updated
+     */
+    uint64_t GetUpdateTime(HContext context);
+
     /**
      * Retrieves the number of buttons on a given gamepad.
      *
@@ -15,6 +15,7 @@
 #include <string.h>
 
 #include <dlib/hashtable.h>
+#include <dlib/time.h>
 
 #include "hid_private.h"
 
@@ -65,6 +66,7 @@ namespace dmHID
 
     void Update(HContext context)
     {
+        context->m_UpdateTime = dmTime::GetTime();
         context->m_Keyboards[0].m_Connected = !context->m_IgnoreKeyboard;
         context->m_Mice[0].m_Connected = !context->m_IgnoreMouse;
         context->m_TouchDevices[0].m_Connected = !context->m_IgnoreTouchDevice;
@@ -62,6 +62,11 @@ namespace dmHID
         DMHIDGamepadFunc    m_GamepadConnectivityCallback;
         void*               m_GamepadConnectivityUserdata;
         void*               m_NativeContext;
+        /// Background gamepad polling, only used by platforms that support it
+        struct GamepadPoller* m_GamepadPoller;
+        uint32_t            m_GamepadPollRate;
+        /// Time of the latest Update
+        uint64_t            m_UpdateTime;
 
         uint32_t m_AccelerometerConnected : 1;
         uint32_t m_IgnoreMouse : 1;
@@ -484,6 +484,7 @@ namespace dmInput
         float m_AccX;
         float m_AccY;
         float m_AccZ;
+        uint64_t m_Timestamp;
         uint32_t m_PositionSet : 1;
         uint32_t m_AccelerationSet : 1;
     };
@@ -496,6 +497,7 @@ namespace dmInput
         action->m_Pressed = (action->m_PrevValue < pressed_threshold && action->m_Value >= pressed_threshold) ? 1 : 0;
         action->m_Released = (action->m_PrevValue >= pressed_threshold && action->m_Value < pressed_threshold) ? 1 : 0;
         action->m_Repeated = false;
+        action->m_Timestamp = update_context->m_Timestamp;
         if (action->m_Value > 0.0f)
         {
             if (action->m_Pressed)
@@ -848,6 +850,7 @@ namespace dmInput
         }
         context.m_DT = dt;
         context.m_Context = binding->m_Context;
+        context.m_Timestamp = dmHID::GetUpdateTime(hid_context);
         binding->m_Actions.Iterate<void>(UpdateAction, &context);
         if (binding->m_GamepadBindings.Size() > 0)
         {
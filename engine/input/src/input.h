@@ -41,6 +41,8 @@ namespace dmInput
         uint32_t     m_HasText;
         uint32_t m_GamepadIndex;
         dmHID::GamepadPacket m_GamepadPacket;
+        /// Time when the input was sampled, in microseconds (see dmHID::GetUpdateTime)
+        uint64_t m_Timestamp;
 
         uint32_t m_IsGamepad : 1;
         uint32_t m_GamepadDisconnected : 1;
@@ -42,6 +42,8 @@ namespace dmLiveUpdate
     const char* LIVEUPDATE_DATA_TMP_FILENAME        = "liveupdate.arcd.tmp";
     const char* LIVEUPDATE_ARCHIVE_FILENAME         = "liveupdate.ref";
     const char* LIVEUPDATE_ARCHIVE_TMP_FILENAME     = "liveupdate.ref.tmp";
+    const char* LIVEUPDATE_ZIP_INDEX_FILENAME       = "liveupdate.zipi";
+    const char* LIVEUPDATE_ZIP_INDEX_TMP_FILENAME   = "liveupdate.zipi.tmp";
     const char* LIVEUPDATE_BUNDLE_VER_FILENAME      = "bundle.ver";
 
     static dmResource::Manifest* CreateLUManifest(const dmResource::Manifest* base_manifest);
@@ -93,6 +95,8 @@ namespace dmLiveUpdate
         dmResource::Manifest*       m_LUManifest;         // the new manifest from StoreManifest
         dmResource::HFactory        m_ResourceFactory;    // Resource system factory
         int                         m_ArchiveType;        // 0: original format, 1: .ref archive, -1: no format used
+        dmJob::HContext             m_VerifyJobContext;   // Verifies bundled resources in parallel if set
+        bool                        m_VerifyLazy;         // Skip verifying bundled resources at startup
     };
 
     LiveUpdate g_LiveUpdate;
@@ -141,7 +145,8 @@ namespace dmLiveUpdate
         return uniqueCount;
     }
 
-    Result VerifyResource(const dmResource::Manifest* manifest, const char* expected, uint32_t expected_length, const char* data, uint32_t data_length)
+    // Verifies the resource and returns its digest, so that it only has to be hashed once
+    static Result VerifyResourceDigest(const dmResource::Manifest* manifest, const char* expected, uint32_t expected_length, const char* data, uint32_t data_length, uint8_t* digest)
     {
         if (manifest == 0x0 || data == 0x0)
         {
@@ -150,7 +155,6 @@ namespace dmLiveUpdate
 
         dmLiveUpdateDDF::HashAlgorithm algorithm = manifest->m_DDFData->m_Header.m_ResourceHashAlgorithm;
         uint32_t digestLength = dmResource::HashLength(algorithm);
-        uint8_t* digest = (uint8_t*) alloca(digestLength * sizeof(uint8_t));
 
         CreateResourceHash(algorithm, data, data_length, digest);
 
@@ -163,6 +167,12 @@ namespace dmLiveUpdate
         return comp ? RESULT_OK : RESULT_INVALID_RESOURCE;
     }
 
+    Result VerifyResource(const dmResource::Manifest* manifest, const char* expected, uint32_t expected_length, const char* data, uint32_t data_length)
+    {
+        uint8_t digest[dmResourceArchive::MAX_HASH];
+        return VerifyResourceDigest(manifest, expected, expected_length, data, data_length, digest);
+    }
+
     static bool VerifyManifestSupportedEngineVersion(const dmResource::Manifest* manifest)
     {
         // Calculate running dmengine version SHA1 hash
@@ -215,14 +225,14 @@ namespace dmLiveUpdate
             {
                 dmTime::Sleep(100);
             }
-            res = dmResource::VerifyResourcesBundled(archive, manifest);
+            res = dmResource::VerifyResourcesBundled(archive, manifest, g_LiveUpdate.m_VerifyJobContext);
             dmMutex::Unlock(mutex);
         }
         else
         {
             // If we're being called during factory startup,
             // we don't need to protect the archive for new downloaded content at the same time
-            res = dmResource::VerifyResourcesBundled(archive, manifest);
+            res = dmResource::VerifyResourcesBundled(archive, manifest, g_LiveUpdate.m_VerifyJobContext);
         }
 
         return ResourceResultToLiveupdateResult(res);
@@ -392,15 +402,33 @@ namespace dmLiveUpdate
         }
     }
 
-    Result NewArchiveIndexWithResource(const dmResource::Manifest* manifest, const char* expected_digest, const uint32_t expected_digest_length, const dmResourceArchive::LiveUpdateResource* resource, dmResourceArchive::HArchiveIndex& out_new_index)
+    // Minimum number of resources verified per job
+    static const uint32_t STORE_VERIFY_BATCH_SIZE = 4;
+
+    struct StoreVerifyContext
     {
-        out_new_index = 0x0;
-        Result result = VerifyResource(manifest, expected_digest, expected_digest_length, (const char*)resource->m_Data, resource->m_Count);
-        if(RESULT_OK != result)
+        const dmResource::Manifest* m_Manifest;
+        const AsyncResourceRequest* m_Requests;
+        Result*                     m_Results;
+        uint8_t*                    m_Digests;
+    };
+
+    static void StoreVerifyRange(void* _ctx, uint32_t start, uint32_t end)
+    {
+        StoreVerifyContext* ctx = (StoreVerifyContext*) _ctx;
+        for (uint32_t i = start; i < end; ++i)
         {
-            dmLogError("Verification failure for Liveupdate archive for resource: %s", expected_digest);
-            return result;
+            if (ctx->m_Results[i] != RESULT_OK)
+                continue;
+            const AsyncResourceRequest* request = &ctx->m_Requests[i];
+            ctx->m_Results[i] = VerifyResourceDigest(ctx->m_Manifest, request->m_ExpectedResourceDigest, request->m_ExpectedResourceDigestLength,
+                                                     (const char*)request->m_Resource.m_Data, request->m_Resource.m_Count, &ctx->m_Digests[i * dmResourceArchive::MAX_HASH]);
         }
+    }
+
+    Result NewArchiveIndexWithResources(const dmResource::Manifest* manifest, const AsyncResourceRequest* requests, uint32_t count, Result* results, dmResourceArchive::HArchiveIndex& out_new_index)
+    {
+        out_new_index = 0x0;
 
         char app_support_path[DMPATH_MAX_PATH];
         if (dmResource::RESULT_OK != dmResource::GetApplicationSupportPath(manifest, app_support_path, (uint32_t)sizeof(app_support_path)))
@@ -408,21 +436,56 @@ namespace dmLiveUpdate
             return RESULT_IO_ERROR;
         }
 
+        // The resources are hashed and verified in parallel, the archive is then written once for the whole batch
+        StoreVerifyContext ctx;
+        ctx.m_Manifest = manifest;
+        ctx.m_Requests = requests;
+        ctx.m_Results = results;
+        ctx.m_Digests = (uint8_t*) malloc(count * dmResourceArchive::MAX_HASH);
+
+        dmJob::HContext job_context = GetVerifyJobContext();
+        dmJob::HJob job = dmJob::ParallelFor(job_context, StoreVerifyRange, &ctx, count, STORE_VERIFY_BATCH_SIZE, dmJob::INVALID_JOB);
+        if (job != dmJob::INVALID_JOB)
+        {
+            dmJob::Wait(job_context, job);
+        }
+
+        const uint8_t** digests = (const uint8_t**) malloc(count * sizeof(uint8_t*));
+        const dmResourceArchive::LiveUpdateResource** resources = (const dmResourceArchive::LiveUpdateResource**) malloc(count * sizeof(dmResourceArchive::LiveUpdateResource*));
+        dmResourceArchive::Result* archive_results = (dmResourceArchive::Result*) malloc(count * sizeof(dmResourceArchive::Result));
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (results[i] == RESULT_INVALID_RESOURCE)
+            {
+                dmLogError("Verification failure for Liveupdate archive for resource: %s", requests[i].m_ExpectedResourceDigest);
+            }
+            digests[i] = &ctx.m_Digests[i * dmResourceArchive::MAX_HASH];
+            resources[i] = &requests[i].m_Resource;
+            archive_results[i] = results[i] == RESULT_OK ? dmResourceArchive::RESULT_OK : dmResourceArchive::RESULT_UNKNOWN;
+        }
+
         // Create empty files if they don't already exist
         // this call might occur before StoreManifest
         CreateFilesIfNotExists(manifest->m_ArchiveIndex, app_support_path, LIVEUPDATE_INDEX_FILENAME, LIVEUPDATE_DATA_FILENAME);
 
-        dmLiveUpdateDDF::HashAlgorithm algorithm = manifest->m_DDFData->m_Header.m_ResourceHashAlgorithm;
-        uint32_t digestLength = dmResource::HashLength(algorithm);
-        uint8_t* digest = (uint8_t*) alloca(digestLength);
-
-        CreateResourceHash(algorithm, (const char*)resource->m_Data, resource->m_Count, digest);
-
         char index_tmp_path[DMPATH_MAX_PATH];
         dmPath::Concat(app_support_path, LIVEUPDATE_INDEX_TMP_FILENAME, index_tmp_path, DMPATH_MAX_PATH);
 
-        dmResourceArchive::Result res = dmResourceArchive::NewArchiveIndexWithResource(manifest->m_ArchiveIndex, index_tmp_path, digest, digestLength, resource, app_support_path, out_new_index);
+        uint32_t digest_length = dmResource::HashLength(manifest->m_DDFData->m_Header.m_ResourceHashAlgorithm);
+        dmResourceArchive::Result res = dmResourceArchive::NewArchiveIndexWithResources(manifest->m_ArchiveIndex, index_tmp_path, digests, digest_length, resources, count, archive_results, out_new_index);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (results[i] == RESULT_OK && archive_results[i] != dmResourceArchive::RESULT_OK)
+            {
+                results[i] = RESULT_INVALID_RESOURCE;
+            }
+        }
 
+        free(archive_results);
+        free(resources);
+        free(digests);
+        free(ctx.m_Digests);
         return (res == dmResourceArchive::RESULT_OK) ? RESULT_OK : RESULT_INVALID_RESOURCE;
     }
 
@@ -641,6 +704,22 @@ namespace dmLiveUpdate
         return manifest;
     }
 
+    void SetVerifyParams(dmJob::HContext job_context, bool lazy)
+    {
+        g_LiveUpdate.m_VerifyJobContext = job_context;
+        g_LiveUpdate.m_VerifyLazy = lazy;
+    }
+
+    dmJob::HContext GetVerifyJobContext()
+    {
+        return g_LiveUpdate.m_VerifyJobContext;
+    }
+
+    bool IsVerifyLazy()
+    {
+        return g_LiveUpdate.m_VerifyLazy;
+    }
+
     void RegisterArchiveLoaders()
     {
         dmResourceArchive::ArchiveLoader loader;
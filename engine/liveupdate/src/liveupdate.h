@@ -14,6 +14,7 @@
 #define DM_LIVEUPDATE_H
 
 #include <dlib/hash.h>
+#include <dlib/job.h>
 
 namespace dmResource
 {
@@ -56,6 +57,13 @@ namespace dmLiveUpdate
 
     void RegisterArchiveLoaders();
 
+    /*
+     * Sets how the resources a liveupdate manifest expects to be bundled are verified. Call before the archives are loaded.
+     * @param job_context job context used to verify the entries in parallel, may be 0
+     * @param lazy skip the verification when loading the archives at startup. A missing resource is reported when it is first loaded instead
+     */
+    void SetVerifyParams(dmJob::HContext job_context, bool lazy);
+
     uint32_t GetMissingResources(const dmhash_t urlHash, char*** buffer);
 
     /*
@@ -38,46 +38,113 @@ namespace dmLiveUpdate
     /// job input and output queues
     static dmArray<AsyncResourceRequest> m_JobQueue;
     static dmArray<AsyncResourceRequest> m_ThreadJobQueue;
-    static AsyncResourceRequest m_TreadJob;
-    static ResourceRequestCallbackData m_JobCompleteData;
+    /// Requests processed together, and their results
+    static dmArray<AsyncResourceRequest> m_Batch;
+    static dmArray<Result> m_BatchResults;
+    static dmArray<ResourceRequestCallbackData> m_JobCompleteData;
 
 
-    static void ProcessRequest(AsyncResourceRequest &request)
+    // Moves the requests at the back of the queue that can be processed together to the batch: a single
+    // archive request, or consecutive resource requests for the same manifest
+    static void TakeBatch(dmArray<AsyncResourceRequest>& queue)
     {
-        m_JobCompleteData.m_CallbackData = request.m_CallbackData;
-        m_JobCompleteData.m_Callback = request.m_Callback;
-        m_JobCompleteData.m_Status = false;
-        Result res = dmLiveUpdate::RESULT_OK;
-        if (request.m_IsArchive)
+        uint32_t end = queue.Size();
+        uint32_t start = end - 1;
+        if (!queue[start].m_IsArchive)
+        {
+            while (start > 0 && !queue[start - 1].m_IsArchive && queue[start - 1].m_Manifest == queue[end - 1].m_Manifest)
+            {
+                --start;
+            }
+        }
+        m_Batch.SetSize(0);
+        if (m_Batch.Capacity() < end - start)
+        {
+            m_Batch.SetCapacity(end - start);
+        }
+        m_Batch.PushArray(&queue[start], end - start);
+        queue.SetSize(start);
+    }
+
+    static void ProcessBatch()
+    {
+        uint32_t count = m_Batch.Size();
+        if (m_JobCompleteData.Capacity() < count)
+        {
+            m_JobCompleteData.SetCapacity(count);
+        }
+        m_JobCompleteData.SetSize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ResourceRequestCallbackData& data = m_JobCompleteData[i];
+            memset(&data, 0, sizeof(data));
+            data.m_CallbackData = m_Batch[i].m_CallbackData;
+            data.m_Callback = m_Batch[i].m_Callback;
+        }
+
+        if (m_Batch[0].m_IsArchive)
         {
             // Stores/stages a zip archive for loading after next reboot
-            res = dmLiveUpdate::StoreZipArchive(request.m_Path);
-            m_JobCompleteData.m_Manifest = 0;
+            Result res = dmLiveUpdate::StoreZipArchive(m_Batch[0].m_Path);
+            m_JobCompleteData[0].m_Status = res == dmLiveUpdate::RESULT_OK;
+            return;
         }
-        else if (request.m_Resource.m_Header != 0x0)
+
+        // Add the resources to the currently created live update archive
+        if (m_BatchResults.Capacity() < count)
         {
-            // Add a resource to the currently created live update archive
-            res = dmLiveUpdate::NewArchiveIndexWithResource(request.m_Manifest, request.m_ExpectedResourceDigest, request.m_ExpectedResourceDigestLength, &request.m_Resource, m_JobCompleteData.m_NewArchiveIndex);
-            m_JobCompleteData.m_Manifest = request.m_Manifest;
+            m_BatchResults.SetCapacity(count);
         }
-        else
+        m_BatchResults.SetSize(count);
+        uint32_t valid_count = 0;
+        for (uint32_t i = 0; i < count; ++i)
         {
-            res = dmLiveUpdate::RESULT_INVALID_HEADER;
+            m_BatchResults[i] = m_Batch[i].m_Resource.m_Header != 0x0 ? dmLiveUpdate::RESULT_OK : dmLiveUpdate::RESULT_INVALID_HEADER;
+            valid_count += m_BatchResults[i] == dmLiveUpdate::RESULT_OK ? 1 : 0;
+        }
+
+        dmResourceArchive::HArchiveIndex new_index = 0x0;
+        if (valid_count > 0)
+        {
+            Result res = dmLiveUpdate::NewArchiveIndexWithResources(m_Batch[0].m_Manifest, m_Batch.Begin(), count, m_BatchResults.Begin(), new_index);
+            if (res != dmLiveUpdate::RESULT_OK)
+            {
+                new_index = 0x0;
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    m_BatchResults[i] = m_BatchResults[i] == dmLiveUpdate::RESULT_OK ? res : m_BatchResults[i];
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            m_JobCompleteData[i].m_Status = m_BatchResults[i] == dmLiveUpdate::RESULT_OK;
+        }
+        if (new_index)
+        {
+            // The new index holds all stored resources of the batch, and is set once
+            m_JobCompleteData[0].m_Manifest = m_Batch[0].m_Manifest;
+            m_JobCompleteData[0].m_NewArchiveIndex = new_index;
         }
-        m_JobCompleteData.m_Status = res == dmLiveUpdate::RESULT_OK ? true : false;
     }
 
     // Must be called on the Lua main thread
-    static void ProcessRequestComplete()
+    static void ProcessBatchComplete()
     {
-        if(m_JobCompleteData.m_Manifest && m_JobCompleteData.m_Status)
+        ResourceRequestCallbackData& data = m_JobCompleteData[0];
+        if(data.m_Manifest && data.m_NewArchiveIndex)
         {
             // If we have a new archive, then we've also created a new manifest, so let's use it
-            dmLiveUpdate::SetNewManifest(m_JobCompleteData.m_Manifest);
+            dmLiveUpdate::SetNewManifest(data.m_Manifest);
 
-            dmLiveUpdate::SetNewArchiveIndex(m_JobCompleteData.m_Manifest->m_ArchiveIndex, m_JobCompleteData.m_NewArchiveIndex, true);
+            dmLiveUpdate::SetNewArchiveIndex(data.m_Manifest->m_ArchiveIndex, data.m_NewArchiveIndex, true);
+        }
+        for (uint32_t i = 0; i < m_JobCompleteData.Size(); ++i)
+        {
+            m_JobCompleteData[i].m_Callback(m_JobCompleteData[i].m_Status, m_JobCompleteData[i].m_CallbackData);
         }
-        m_JobCompleteData.m_Callback(m_JobCompleteData.m_Status, m_JobCompleteData.m_CallbackData);
+        m_JobCompleteData.SetSize(0);
     }
 
 
@@ -87,20 +154,18 @@ namespace dmLiveUpdate
         (void)args;
 
         // Liveupdate async thread batch processing requested liveupdate tasks
-        AsyncResourceRequest request;
         while (m_Active)
         {
-            // Lock and sleep until signaled there is requests queued up
+            // Lock and sleep until signaled there is requests queued up, and the previous batch is completed
             {
                 dmMutex::ScopedLock lk(m_ConsumerThreadMutex);
-                while(m_ThreadJobQueue.Empty())
+                while(m_Active && (m_ThreadJobQueue.Empty() || m_ThreadJobComplete))
                     dmConditionVariable::Wait(m_ConsumerThreadCondition, m_ConsumerThreadMutex);
-                if((m_ThreadJobComplete) || (!m_Active))
-                    continue;
-                request = m_ThreadJobQueue.Back();
-                m_ThreadJobQueue.Pop();
+                if(!m_Active)
+                    break;
+                TakeBatch(m_ThreadJobQueue);
             }
-            ProcessRequest(request);
+            ProcessBatch();
             m_ThreadJobComplete = true;
         }
     }
@@ -116,7 +181,7 @@ namespace dmLiveUpdate
                 dmMutex::HMutex mutex = dmResource::GetLoadMutex(m_ResourceFactory);
                 if(!dmMutex::TryLock(mutex))
                     return;
-                ProcessRequestComplete();
+                ProcessBatchComplete();
                 dmMutex::Unlock(mutex);
                 m_ThreadJobComplete = false;
             }
@@ -170,7 +235,7 @@ namespace dmLiveUpdate
             m_Active = false;
             dmMutex::Lock(m_ConsumerThreadMutex);
             m_JobQueue.SetSize(0);
-            m_ThreadJobQueue.SetSize(1);
+            m_ThreadJobQueue.SetSize(0);
             dmConditionVariable::Signal(m_ConsumerThreadCondition);
             dmMutex::Unlock(m_ConsumerThreadMutex);
             dmThread::Join(m_AsyncThread);
@@ -186,9 +251,9 @@ namespace dmLiveUpdate
     {
         if(!m_JobQueue.Empty())
         {
-            ProcessRequest(m_JobQueue.Back());
-            m_JobQueue.Pop();
-            ProcessRequestComplete();
+            TakeBatch(m_JobQueue);
+            ProcessBatch();
+            ProcessBatchComplete();
         }
     }
 
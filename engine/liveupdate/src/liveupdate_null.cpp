@@ -36,6 +36,10 @@ void RegisterArchiveLoaders()
 {
 }
 
+void SetVerifyParams(dmJob::HContext job_context, bool lazy)
+{
+}
+
 uint32_t GetMissingResources(const dmhash_t urlHash, char*** buffer)
 {
     return 0;
@@ -35,6 +35,8 @@ namespace dmLiveUpdate
     extern const char* LIVEUPDATE_DATA_TMP_FILENAME;
     extern const char* LIVEUPDATE_ARCHIVE_FILENAME;
     extern const char* LIVEUPDATE_ARCHIVE_TMP_FILENAME;
+    extern const char* LIVEUPDATE_ZIP_INDEX_FILENAME;
+    extern const char* LIVEUPDATE_ZIP_INDEX_TMP_FILENAME;
     extern const char* LIVEUPDATE_BUNDLE_VER_FILENAME;
 
     struct AsyncResourceRequest
@@ -74,7 +76,8 @@ namespace dmLiveUpdate
     void CreateResourceHash(dmLiveUpdateDDF::HashAlgorithm algorithm, const char* buf, size_t buflen, uint8_t* digest);
     void CreateManifestHash(dmLiveUpdateDDF::HashAlgorithm algorithm, const uint8_t* buf, size_t buflen, uint8_t* digest);
 
-    Result NewArchiveIndexWithResource(const dmResource::Manifest* manifest, const char* expected_digest, const uint32_t expected_digest_length, const dmResourceArchive::LiveUpdateResource* resource, dmResourceArchive::HArchiveIndex& out_new_index);
+    // Verifies and stores a batch of resources with a single index write. Requests that are not RESULT_OK in results on input are skipped.
+    Result NewArchiveIndexWithResources(const dmResource::Manifest* manifest, const AsyncResourceRequest* requests, uint32_t count, Result* results, dmResourceArchive::HArchiveIndex& out_new_index);
     void SetNewArchiveIndex(dmResourceArchive::HArchiveIndexContainer archive_container, dmResourceArchive::HArchiveIndex new_index, bool mem_mapped);
     void SetNewManifest(dmResource::Manifest* manifest);
 
@@ -86,6 +89,10 @@ namespace dmLiveUpdate
 
     bool FileExists(const char* path);
 
+    // Set with SetVerifyParams()
+    dmJob::HContext GetVerifyJobContext();
+    bool IsVerifyLazy();
+
     // regular implementation
     Result BundleVersionValid(const dmResource::Manifest* manifest, const char* bundle_ver_path);
     dmResourceArchive::Result LULoadManifest_Regular(const char* archive_name, const char* app_path, const char* app_support_path, const dmResource::Manifest* previous, dmResource::Manifest** out);
@@ -17,10 +17,13 @@
 #include <resource/resource.h>
 #include <resource/resource_archive.h>
 
+#include <dlib/array.h>
 #include <dlib/dstrings.h>
 #include <dlib/endian.h>
+#include <dlib/hashtable.h>
 #include <dlib/path.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
 #include <dlib/sys.h>
 #include <dlib/zip.h>
 #include <dlib/memory.h>
@@ -29,6 +32,42 @@ namespace dmLiveUpdate
 {
     const char* LIVEUPDATE_ARCHIVE_MANIFEST_FILENAME = "liveupdate.game.dmanifest";
 
+    const uint32_t ZIP_INDEX_MAGIC   = 0x445A4958; // "DZIX"
+    const uint32_t ZIP_INDEX_VERSION = 1;
+
+    /*
+     * The entry data of all resources in a zip archive, so that finding a resource doesn't have to
+     * inflate it to read its header. The index is built the first time the archive is loaded and
+     * stored in the application support path, together with the size and modification time of the
+     * zip archive it was built from.
+     */
+    struct ZipIndexHeader
+    {
+        uint32_t m_Magic;
+        uint32_t m_Version;
+        uint64_t m_ZipSize;
+        uint64_t m_ZipModified;
+        uint32_t m_EntryCount;
+        uint32_t m_Padding;
+        char     m_ZipPath[DMPATH_MAX_PATH];
+    };
+
+    struct ZipIndexEntry
+    {
+        // Hash of the entry name, which is the hex string of the resource hash
+        dmhash_t m_NameHash;
+        uint32_t m_ZipIndex;
+        uint32_t m_ResourceSize;
+        uint32_t m_ResourceCompressedSize;
+        uint32_t m_Flags;
+    };
+
+    struct ZipArchive
+    {
+        dmZip::HZip                     m_Zip;
+        dmHashTable64<ZipIndexEntry>    m_Index;
+    };
+
     static uint8_t* GetZipResource(dmZip::HZip zip, const char* path, uint32_t* size)
     {
         uint32_t data_len = 0;
@@ -296,15 +335,162 @@ namespace dmLiveUpdate
         return result;
     }
 
+    struct ZipHeaderReader
+    {
+        dmResourceArchive::LiveUpdateResourceHeader m_Header;
+        uint32_t                                    m_Offset;
+    };
+
+    static bool ZipHeaderWriter(void* context, const void* data, uint32_t data_len)
+    {
+        ZipHeaderReader* reader = (ZipHeaderReader*)context;
+        uint32_t n = dmMath::Min(data_len, (uint32_t)sizeof(reader->m_Header) - reader->m_Offset);
+        memcpy((uint8_t*)&reader->m_Header + reader->m_Offset, data, n);
+        reader->m_Offset += n;
+        // Stop the extraction once we have the header
+        return reader->m_Offset < sizeof(reader->m_Header);
+    }
+
+    // Reads the resource header of each entry, which only inflates the start of the entries
+    static void BuildZipIndex(dmZip::HZip zip, dmArray<ZipIndexEntry>& entries)
+    {
+        uint32_t num_entries = dmZip::GetNumEntries(zip);
+        entries.SetCapacity(num_entries);
+        entries.SetSize(0);
+        for (uint32_t i = 0; i < num_entries; ++i)
+        {
+            if (dmZip::RESULT_OK != dmZip::OpenEntry(zip, i))
+                continue;
+
+            const char* entry_name = dmZip::GetEntryName(zip);
+            uint32_t entry_size = 0;
+            if (!dmZip::IsEntryDir(zip) && strcmp(LIVEUPDATE_ARCHIVE_MANIFEST_FILENAME, entry_name) != 0
+                && dmZip::RESULT_OK == dmZip::GetEntrySize(zip, &entry_size))
+            {
+                ZipHeaderReader reader;
+                memset(&reader, 0, sizeof(reader));
+                dmZip::GetEntryDataStreamed(zip, &reader, ZipHeaderWriter);
+                if (entry_size >= sizeof(reader.m_Header) && reader.m_Offset == sizeof(reader.m_Header))
+                {
+                    uint32_t count = entry_size - sizeof(reader.m_Header);
+                    bool is_compressed = reader.m_Header.m_Flags & dmResourceArchive::ENTRY_FLAG_COMPRESSED;
+
+                    ZipIndexEntry entry;
+                    entry.m_NameHash = dmHashString64(entry_name);
+                    entry.m_ZipIndex = i;
+                    entry.m_ResourceSize = is_compressed ? dmEndian::ToNetwork(reader.m_Header.m_Size) : count;
+                    entry.m_ResourceCompressedSize = is_compressed ? count : 0xFFFFFFFF;
+                    entry.m_Flags = reader.m_Header.m_Flags | dmResourceArchive::ENTRY_FLAG_LIVEUPDATE_DATA;
+                    entries.Push(entry);
+                }
+                else
+                {
+                    dmLogError("Skipping resource %s from archive", entry_name);
+                }
+            }
+            dmZip::CloseEntry(zip);
+        }
+    }
+
+    static bool ReadZipIndex(const char* index_path, const ZipIndexHeader& expected, uint32_t max_entries, dmArray<ZipIndexEntry>& entries)
+    {
+        FILE* f = fopen(index_path, "rb");
+        if (!f)
+            return false;
+
+        bool result = false;
+        ZipIndexHeader header;
+        if (fread(&header, 1, sizeof(header), f) == sizeof(header)
+            && header.m_Magic == expected.m_Magic
+            && header.m_Version == expected.m_Version
+            && header.m_ZipSize == expected.m_ZipSize
+            && header.m_ZipModified == expected.m_ZipModified
+            && header.m_EntryCount <= max_entries
+            && strncmp(header.m_ZipPath, expected.m_ZipPath, sizeof(header.m_ZipPath)) == 0)
+        {
+            entries.SetCapacity(header.m_EntryCount);
+            entries.SetSize(header.m_EntryCount);
+            size_t size = sizeof(ZipIndexEntry) * header.m_EntryCount;
+            result = fread(entries.Begin(), 1, size, f) == size;
+        }
+        fclose(f);
+        return result;
+    }
+
+    static void WriteZipIndex(const char* app_support_path, ZipIndexHeader& header, const dmArray<ZipIndexEntry>& entries)
+    {
+        char index_path[DMPATH_MAX_PATH];
+        char index_tmp_path[DMPATH_MAX_PATH];
+        dmPath::Concat(app_support_path, LIVEUPDATE_ZIP_INDEX_FILENAME, index_path, DMPATH_MAX_PATH);
+        dmPath::Concat(app_support_path, LIVEUPDATE_ZIP_INDEX_TMP_FILENAME, index_tmp_path, DMPATH_MAX_PATH);
+
+        FILE* f = fopen(index_tmp_path, "wb");
+        if (!f)
+        {
+            dmLogWarning("Couldn't open %s for writing", index_tmp_path);
+            return;
+        }
+
+        header.m_EntryCount = entries.Size();
+        size_t size = sizeof(ZipIndexEntry) * entries.Size();
+        bool ok = fwrite(&header, 1, sizeof(header), f) == sizeof(header)
+               && fwrite(entries.Begin(), 1, size, f) == size;
+        fclose(f);
+
+        if (!ok || dmSys::RESULT_OK != dmSys::RenameFile(index_path, index_tmp_path))
+        {
+            dmLogWarning("Couldn't write zip archive index to %s", index_path);
+            dmSys::Unlink(index_tmp_path);
+        }
+    }
+
+    static void LoadZipIndex(ZipArchive* zip_archive, const char* zip_path, const char* app_support_path)
+    {
+        ZipIndexHeader header;
+        memset(&header, 0, sizeof(header));
+        header.m_Magic = ZIP_INDEX_MAGIC;
+        header.m_Version = ZIP_INDEX_VERSION;
+        dmStrlCpy(header.m_ZipPath, zip_path, sizeof(header.m_ZipPath));
+
+        struct stat file_stat;
+        if (stat(zip_path, &file_stat) == 0)
+        {
+            header.m_ZipSize = (uint64_t)file_stat.st_size;
+            header.m_ZipModified = (uint64_t)file_stat.st_mtime;
+        }
+
+        char index_path[DMPATH_MAX_PATH];
+        dmPath::Concat(app_support_path, LIVEUPDATE_ZIP_INDEX_FILENAME, index_path, DMPATH_MAX_PATH);
+
+        dmArray<ZipIndexEntry> entries;
+        if (!ReadZipIndex(index_path, header, dmZip::GetNumEntries(zip_archive->m_Zip), entries))
+        {
+            BuildZipIndex(zip_archive->m_Zip, entries);
+            WriteZipIndex(app_support_path, header, entries);
+            dmLogInfo("Built index of zip archive '%s' with %u entries", zip_path, entries.Size());
+        }
+
+        uint32_t count = entries.Size();
+        zip_archive->m_Index.SetCapacity(dmMath::Max(1U, (count * 2) / 3), dmMath::Max(1U, count));
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            zip_archive->m_Index.Put(entries[i].m_NameHash, entries[i]);
+        }
+    }
+
     dmResourceArchive::Result LULoadArchive_Zip(const dmResource::Manifest* manifest, const char* archive_name, const char* app_path, const char* app_support_path,
                                                 dmResourceArchive::HArchiveIndexContainer previous, dmResourceArchive::HArchiveIndexContainer* out)
     {
-        // At this point, the base archive has been loaded, and we can verify out manifest's references
-        dmResource::Result result = dmResource::VerifyResourcesBundled(previous, manifest);
-        if (dmResource::RESULT_OK != result)
+        // At this point, the base archive has been loaded, and we can verify out manifest's references.
+        // In lazy mode a missing resource is reported when it is loaded instead
+        if (!dmLiveUpdate::IsVerifyLazy())
         {
-            dmLogError("Manifest references non existing resources.");
-            return dmResourceArchive::RESULT_VERSION_MISMATCH;
+            dmResource::Result result = dmResource::VerifyResourcesBundled(previous, manifest, dmLiveUpdate::GetVerifyJobContext());
+            if (dmResource::RESULT_OK != result)
+            {
+                dmLogError("Manifest references non existing resources.");
+                return dmResourceArchive::RESULT_VERSION_MISMATCH;
+            }
         }
 
         char archive_path[DMPATH_MAX_PATH];
@@ -330,7 +516,11 @@ namespace dmLiveUpdate
         archive->m_ArchiveFileIndex = new dmResourceArchive::ArchiveFileIndex;
         dmStrlCpy(archive->m_ArchiveFileIndex->m_Path, zip_path, DMPATH_MAX_PATH);
 
-        archive->m_UserData = (void*)zip;
+        ZipArchive* zip_archive = new ZipArchive;
+        zip_archive->m_Zip = zip;
+        LoadZipIndex(zip_archive, zip_path, app_support_path);
+
+        archive->m_UserData = (void*)zip_archive;
 
         *out = archive;
 
@@ -339,74 +529,128 @@ namespace dmLiveUpdate
 
     dmResourceArchive::Result LUUnloadArchive_Zip(dmResourceArchive::HArchiveIndexContainer archive)
     {
-        dmZip::HZip zip = (dmZip::HZip)archive->m_UserData;
-        if (zip)
-            dmZip::Close(zip);
+        ZipArchive* zip_archive = (ZipArchive*)archive->m_UserData;
+        if (zip_archive)
+        {
+            dmZip::Close(zip_archive->m_Zip);
+            delete zip_archive;
+        }
         return dmResourceArchive::RESULT_OK;
     }
 
+    static const ZipIndexEntry* FindZipIndexEntry(ZipArchive* zip_archive, const uint8_t* hash, uint32_t hash_len, char* hash_buffer, uint32_t hash_buffer_len)
+    {
+        dmResource::BytesToHexString(hash, hash_len, hash_buffer, hash_buffer_len);
+        return zip_archive->m_Index.Get(dmHashString64(hash_buffer));
+    }
+
     dmResourceArchive::Result LUFindEntryInArchive_Zip(dmResourceArchive::HArchiveIndexContainer archive, const uint8_t* hash, uint32_t hash_len, dmResourceArchive::EntryData* entry)
     {
-        dmZip::HZip zip = (dmZip::HZip)archive->m_UserData;
+        ZipArchive* zip_archive = (ZipArchive*)archive->m_UserData;
 
         char hash_buffer[dmResourceArchive::MAX_HASH*2+1];
-        dmResource::BytesToHexString(hash, hash_len, hash_buffer, sizeof(hash_buffer));
-
-        dmZip::Result zr = dmZip::OpenEntry(zip, hash_buffer);
-        if (dmZip::RESULT_OK != zr)
+        const ZipIndexEntry* index_entry = FindZipIndexEntry(zip_archive, hash, hash_len, hash_buffer, sizeof(hash_buffer));
+        if (!index_entry)
             return dmResourceArchive::RESULT_NOT_FOUND;
 
-        dmZip::CloseEntry(zip);
-
         if (entry != 0)
         {
-            // TODO: Read from a cached index!
-
-            uint32_t raw_resource_size;
-            uint8_t* raw_resource = GetZipResource(zip, hash_buffer, &raw_resource_size);
-            if (raw_resource == 0)
-                return dmResourceArchive::RESULT_NOT_FOUND;
-
-            dmResourceArchive::LiveUpdateResource resource(raw_resource, raw_resource_size);
-
-            bool is_compressed = (resource.m_Header->m_Flags & dmResourceArchive::ENTRY_FLAG_COMPRESSED);
-
             entry->m_ResourceDataOffset = 0;
-            entry->m_ResourceSize = is_compressed ? dmEndian::ToNetwork(resource.m_Header->m_Size) : resource.m_Count;
-            entry->m_ResourceCompressedSize = is_compressed ? resource.m_Count : 0xFFFFFFFF;
-            entry->m_Flags = resource.m_Header->m_Flags | dmResourceArchive::ENTRY_FLAG_LIVEUPDATE_DATA;
+            entry->m_ResourceSize = index_entry->m_ResourceSize;
+            entry->m_ResourceCompressedSize = index_entry->m_ResourceCompressedSize;
+            entry->m_Flags = index_entry->m_Flags;
+        }
 
-            dmMemory::AlignedFree(raw_resource);
+        return dmResourceArchive::RESULT_OK;
+    }
 
+    struct ZipEntryReader
+    {
+        dmResourceArchive::LiveUpdateResourceHeader m_Header;
+        const dmResourceArchive::EntryData*         m_Entry;
+        // The final resource buffer, or a temporary buffer when the payload is compressed
+        uint8_t*                                    m_Data;
+        uint32_t                                    m_DataSize;
+        uint8_t*                                    m_Output;
+        uint32_t                                    m_Offset;
+    };
+
+    static bool ZipEntryWriter(void* context, const void* data, uint32_t data_len)
+    {
+        ZipEntryReader* reader = (ZipEntryReader*)context;
+        const uint8_t* src = (const uint8_t*)data;
+
+        const uint32_t header_size = sizeof(dmResourceArchive::LiveUpdateResourceHeader);
+        if (reader->m_Offset < header_size)
+        {
+            uint32_t n = dmMath::Min(data_len, header_size - reader->m_Offset);
+            memcpy((uint8_t*)&reader->m_Header + reader->m_Offset, src, n);
+            reader->m_Offset += n;
+            src += n;
+            data_len -= n;
+            if (reader->m_Offset < header_size)
+                return true;
+
+            // The header is complete, so we know where the payload goes
+            if (reader->m_Header.m_Flags & dmResourceArchive::ENTRY_FLAG_COMPRESSED)
+            {
+                reader->m_DataSize = reader->m_Entry->m_ResourceCompressedSize;
+                dmMemory::AlignedMalloc((void**)&reader->m_Data, 16, reader->m_DataSize);
+            }
+            else
+            {
+                reader->m_DataSize = reader->m_Entry->m_ResourceSize;
+                reader->m_Data = reader->m_Output;
+            }
         }
 
-        return dmResourceArchive::RESULT_OK;
+        uint32_t payload_offset = reader->m_Offset - header_size;
+        if (payload_offset + data_len > reader->m_DataSize)
+            return false;
+        memcpy(reader->m_Data + payload_offset, src, data_len);
+        reader->m_Offset += data_len;
+        return true;
     }
 
     dmResourceArchive::Result LUReadEntryFromArchive_Zip(dmResourceArchive::HArchiveIndexContainer archive, const uint8_t* hash, uint32_t hash_len, const dmResourceArchive::EntryData* entry, void* buffer)
     {
-        dmZip::HZip zip = (dmZip::HZip)archive->m_UserData;
+        ZipArchive* zip_archive = (ZipArchive*)archive->m_UserData;
+        dmZip::HZip zip = zip_archive->m_Zip;
 
         char hash_buffer[dmResourceArchive::MAX_HASH*2+1];
-        dmResource::BytesToHexString(hash, hash_len, hash_buffer, sizeof(hash_buffer));
+        const ZipIndexEntry* index_entry = FindZipIndexEntry(zip_archive, hash, hash_len, hash_buffer, sizeof(hash_buffer));
+        if (!index_entry)
+            return dmResourceArchive::RESULT_NOT_FOUND;
 
-        uint32_t raw_resource_size;
-        uint8_t* raw_resource = GetZipResource(zip, hash_buffer, &raw_resource_size);
-        if (raw_resource == 0)
+        dmZip::Result zr = dmZip::OpenEntry(zip, index_entry->m_ZipIndex);
+        if (dmZip::RESULT_OK != zr)
             return dmResourceArchive::RESULT_NOT_FOUND;
 
-        dmResourceArchive::LiveUpdateResource resource(raw_resource, raw_resource_size);
+        // Stream the entry straight into the resource buffer, only compressed payloads need a temporary buffer
+        ZipEntryReader reader;
+        memset(&reader, 0, sizeof(reader));
+        reader.m_Entry = entry;
+        reader.m_Output = (uint8_t*)buffer;
+        zr = dmZip::GetEntryDataStreamed(zip, &reader, ZipEntryWriter);
+        dmZip::CloseEntry(zip);
 
-        uint32_t flags = resource.m_Header->m_Flags;
+        uint32_t flags = reader.m_Header.m_Flags;
         bool encrypted = flags & dmResourceArchive::ENTRY_FLAG_ENCRYPTED;
         bool compressed = flags & dmResourceArchive::ENTRY_FLAG_COMPRESSED;
         uint32_t compressed_size = entry->m_ResourceCompressedSize;
         uint32_t resource_size = entry->m_ResourceSize;
 
         dmResourceArchive::Result result = dmResourceArchive::RESULT_OK;
+        if (dmZip::RESULT_OK != zr || reader.m_Offset != sizeof(reader.m_Header) + reader.m_DataSize)
+        {
+            dmLogError("Could not read entry '%s'", hash_buffer);
+            result = dmResourceArchive::RESULT_IO_ERROR;
+            goto bail;
+        }
+
         if (encrypted)
         {
-            result = dmResourceArchive::DecryptBuffer((uint8_t*)resource.m_Data, resource.m_Count);
+            result = dmResourceArchive::DecryptBuffer(reader.m_Data, reader.m_DataSize);
             if (dmResourceArchive::RESULT_OK != result)
             {
                 dmLogError("Failed to decrypt resource: '%s", hash_buffer);
@@ -416,26 +660,23 @@ namespace dmLiveUpdate
 
         if (compressed)
         {
-            result = dmResourceArchive::DecompressBuffer((const uint8_t*)resource.m_Data, compressed_size, (uint8_t*)buffer, resource_size);
+            result = dmResourceArchive::DecompressBuffer(reader.m_Data, compressed_size, (uint8_t*)buffer, resource_size);
             if (dmResourceArchive::RESULT_OK != result)
             {
                 dmLogError("Failed to decompress resource: '%s", hash_buffer);
                 goto bail;
             }
         }
-        else
-        {
-            memcpy(buffer, resource.m_Data, resource.m_Count);
-        }
 
 bail:
-        dmMemory::AlignedFree(raw_resource);
+        if (reader.m_Data != reader.m_Output)
+            dmMemory::AlignedFree(reader.m_Data);
         return result;
     }
 
     dmResourceArchive::Result LUCleanup_Zip(const char* archive_name, const char* app_path, const char* app_support_path)
     {
-        const char* names[] = {LIVEUPDATE_ARCHIVE_FILENAME,LIVEUPDATE_ARCHIVE_TMP_FILENAME};
+        const char* names[] = {LIVEUPDATE_ARCHIVE_FILENAME,LIVEUPDATE_ARCHIVE_TMP_FILENAME,LIVEUPDATE_ZIP_INDEX_FILENAME};
         for (int i = 0; i < sizeof(names)/sizeof(names[0]); ++i)
         {
             char path[DMPATH_MAX_PATH];
@@ -60,13 +60,15 @@ namespace dmLiveUpdate
         return dmLiveUpdate::RESULT_OK;
     }
 
-    dmLiveUpdate::Result NewArchiveIndexWithResource(const dmResource::Manifest* manifest, const char* expected_digest, const uint32_t expected_digest_length, const dmResourceArchive::LiveUpdateResource* resource, dmResourceArchive::HArchiveIndex& out_new_index)
+    dmLiveUpdate::Result NewArchiveIndexWithResources(const dmResource::Manifest* manifest, const AsyncResourceRequest* requests, uint32_t count, Result* results, dmResourceArchive::HArchiveIndex& out_new_index)
     {
         out_new_index = (dmResourceArchive::HArchiveIndex) 0x5678;
         assert(manifest->m_ArchiveIndex == (dmResourceArchive::HArchiveIndexContainer) 0x1234);
-        assert(strcmp("DUMMY2", expected_digest)==0);
-        assert(expected_digest_length == 6);
-        assert(*((uint32_t*)resource->m_Data) == 0xdeadbeef);
+        assert(count == 1);
+        assert(results[0] == dmLiveUpdate::RESULT_OK);
+        assert(strcmp("DUMMY2", requests[0].m_ExpectedResourceDigest)==0);
+        assert(requests[0].m_ExpectedResourceDigestLength == 6);
+        assert(*((uint32_t*)requests[0].m_Resource.m_Data) == 0xdeadbeef);
         return dmLiveUpdate::RESULT_OK;
     }
 
@@ -41,6 +41,8 @@ namespace dmParticle
     const char* MAX_INSTANCE_COUNT_KEY          = "particle_fx.max_count";
     /// Config key to use for tweaking the total maximum number of particles in a context.
     const char* MAX_PARTICLE_COUNT_KEY          = "particle_fx.max_particle_count";
+    /// Config key to use for selecting how off-screen looping emitters are updated.
+    const char* OFFSCREEN_UPDATE_KEY            = "particle_fx.offscreen_update";
 
     /// Used for degree to radian conversion
     const float DEG_RAD = (float) (M_PI / 180.0);
@@ -48,6 +50,9 @@ namespace dmParticle
     /// Simulate motion blur at 60 fps with a 180 deg shutter
     const static float STRETCH_SCALING = (1.0f/60.0f) * 0.5f;
 
+    /// Time between the simulations of an off-screen emitter in OFFSCREEN_UPDATE_REDUCED mode
+    const static float OFFSCREEN_UPDATE_INTERVAL = 0.25f;
+
     AnimationData::AnimationData()
     {
         memset(this, 0, sizeof(*this));
@@ -97,6 +102,24 @@ namespace dmParticle
         context->m_MaxParticleCount = max_particle_count;
     }
 
+    void SetJobContext(HParticleContext context, dmJob::HContext job_context)
+    {
+        context->m_JobContext = job_context;
+        // One set of scratch streams for each thread that can run a simulation job
+        uint32_t stream_count = job_context ? dmJob::GetWorkerCount(job_context) + 1 : 1;
+        if (stream_count != context->m_StreamCount)
+        {
+            delete [] context->m_Streams;
+            context->m_Streams = new ParticleStreams[stream_count];
+            context->m_StreamCount = stream_count;
+        }
+    }
+
+    void SetOffscreenUpdate(HParticleContext context, OffscreenUpdate mode)
+    {
+        context->m_OffscreenUpdate = mode;
+    }
+
     static Instance* GetInstance(HParticleContext context, HInstance instance)
     {
         if (instance == INVALID_INSTANCE)
@@ -284,7 +307,7 @@ namespace dmParticle
     }
 
     static bool IsSleeping(Emitter* emitter);
-    static void UpdateEmitter(Prototype* prototype, Instance* instance, EmitterPrototype* emitter_prototype, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float dt);
+    static void UpdateEmitter(Context* context, Prototype* prototype, Instance* instance, EmitterPrototype* emitter_prototype, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float dt);
 
     static void StartEmitter(Instance* instance, Emitter* emitter)
     {
@@ -312,19 +335,48 @@ namespace dmParticle
         return emitter->m_Retiring == 0 && emitter_ddf->m_Mode == PLAY_MODE_LOOP;
     }
 
-    static void FastForwardEmitter(Prototype* prototype, Instance* instance, EmitterPrototype* emitter_prototype, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float time)
+    static void StepEmitter(Context* context, Prototype* prototype, Instance* instance, EmitterPrototype* emitter_prototype, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float time)
     {
-        StartEmitter(instance, emitter);
         float timer = 0.0f;
         // Hard coded for now
         float dt = 1.0f / 60.0f;
         while (timer < time)
         {
-            UpdateEmitter(prototype, instance, emitter_prototype, emitter, emitter_ddf, dt);
+            UpdateEmitter(context, prototype, instance, emitter_prototype, emitter, emitter_ddf, dt);
             timer += dt;
         }
     }
 
+    static void FastForwardEmitter(Context* context, Prototype* prototype, Instance* instance, EmitterPrototype* emitter_prototype, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float time)
+    {
+        StartEmitter(instance, emitter);
+        StepEmitter(context, prototype, instance, emitter_prototype, emitter, emitter_ddf, time);
+    }
+
+    // Returns the time step to simulate a looping emitter with this update, 0 to skip it
+    static float GetOffscreenTimeStep(Context* context, Prototype* prototype, Instance* instance, EmitterPrototype* emitter_prototype, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float dt)
+    {
+        if (!emitter->m_Rendered)
+        {
+            emitter->m_OffscreenTime += dt;
+            if (context->m_OffscreenUpdate == OFFSCREEN_UPDATE_REDUCED && emitter->m_OffscreenTime >= OFFSCREEN_UPDATE_INTERVAL)
+            {
+                float time = emitter->m_OffscreenTime;
+                emitter->m_OffscreenTime = 0.0f;
+                return time;
+            }
+            return 0.0f;
+        }
+        if (emitter->m_OffscreenTime > 0.0f)
+        {
+            // Back on screen, particles older than the max life time would have died anyway
+            float time = dmMath::Min(emitter->m_OffscreenTime, emitter_prototype->m_MaxParticleLifeTime);
+            emitter->m_OffscreenTime = 0.0f;
+            StepEmitter(context, prototype, instance, emitter_prototype, emitter, emitter_ddf, time);
+        }
+        return dt;
+    }
+
     static float CalculateReplayTime(float duration, float start_delay, float max_particle_life_time, float play_time)
     {
         float time = play_time;
@@ -404,7 +456,7 @@ namespace dmParticle
                 EmitterPrototype* emitter_prototype = &prototype->m_Emitters[emitter_i];
                 dmParticleDDF::Emitter* emitter_ddf = &prototype->m_DDF->m_Emitters[emitter_i];
                 ResetEmitter(emitter);
-                FastForwardEmitter(prototype, i, emitter_prototype, emitter, emitter_ddf, i->m_PlayTime);
+                FastForwardEmitter(context, prototype, i, emitter_prototype, emitter, emitter_ddf, i->m_PlayTime);
             }
         }
 
@@ -432,7 +484,7 @@ namespace dmParticle
                 EmitterPrototype* emitter_prototype = &prototype->m_Emitters[emitter_i];
 
                 float playtime = dmMath::Max(0.0f, dmMath::Min(emitter_ddf->m_StartOffset, emitter_prototype->m_MaxParticleLifeTime));
-                FastForwardEmitter(prototype, i, emitter_prototype, emitter, emitter_ddf, playtime);
+                FastForwardEmitter(context, prototype, i, emitter_prototype, emitter, emitter_ddf, playtime);
             }
         }
     }
@@ -576,26 +628,78 @@ namespace dmParticle
     static void UpdateParticles(Instance* instance, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float dt);
     static void UpdateEmitterState(Instance* instance, Emitter* emitter, EmitterPrototype* emitter_prototype, dmParticleDDF::Emitter* emitter_ddf, float dt);
     static void EvaluateEmitterProperties(Emitter* emitter, Property* emitter_properties, float duration, float properties[EMITTER_KEY_COUNT]);
-    static void EvaluateParticleProperties(Emitter* emitter, Property* particle_properties, dmParticleDDF::Emitter* emitter_ddf, float dt);
+    static void EvaluateParticleProperties(Emitter* emitter, ParticleStreams* streams, Property* particle_properties, dmParticleDDF::Emitter* emitter_ddf, float dt);
     static uint32_t UpdateRenderData(HParticleContext context, Instance* instance, Emitter* emitter, dmParticleDDF::Emitter* ddf, const Vector4& color, uint32_t vertex_index, void* vertex_buffer, uint32_t vertex_buffer_size, float dt, ParticleVertexFormat format);
     static void GenerateKeys(Emitter* emitter, float max_particle_life_time);
-    static void SortParticles(Emitter* emitter);
-    static void Simulate(Instance* instance, Emitter* emitter, EmitterPrototype* prototype, dmParticleDDF::Emitter* ddf, float dt);
+    static void SortParticles(ParticleStreams* streams, Emitter* emitter);
+    static void Simulate(ParticleStreams* streams, Instance* instance, Emitter* emitter, EmitterPrototype* prototype, dmParticleDDF::Emitter* ddf, float dt);
+    static void UpdateEmitterBounds(Instance* instance, Emitter* emitter, dmParticleDDF::Emitter* ddf);
+
+    static uint32_t GetVertexSize(ParticleVertexFormat format)
+    {
+        if (format == PARTICLE_GUI)
+            return sizeof(ParticleGuiVertex);
+        if (format == PARTICLE_GO_INSTANCE)
+            return sizeof(ParticleInstance);
+        return sizeof(Vertex);
+    }
 
-    static void UpdateEmitter(Prototype* prototype, Instance* instance, EmitterPrototype* emitter_prototype, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float dt)
+    // The instanced format writes a single record per particle, the others a quad as two triangles
+    static uint32_t GetVerticesPerParticle(ParticleVertexFormat format)
+    {
+        return format == PARTICLE_GO_INSTANCE ? 1 : 6;
+    }
+
+    // Ages and spawns particles, which might invoke the emitter state callback. Returns true if the emitter should be simulated.
+    static bool BeginUpdateEmitter(Instance* instance, EmitterPrototype* emitter_prototype, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float dt)
     {
         // Don't update emitter if time is standing still
         if (IsSleeping(emitter) || dt <= 0.0f)
-            return;
+            return false;
 
         UpdateParticles(instance, emitter, emitter_ddf, dt);
 
         UpdateEmitterState(instance, emitter, emitter_prototype, emitter_ddf, dt);
+        return true;
+    }
 
-        GenerateKeys(emitter, emitter_prototype->m_MaxParticleLifeTime);
-        SortParticles(emitter);
+    // Only touches the emitter itself and the streams, so emitters can be simulated in parallel
+    static void SimulateEmitter(ParticleStreams* streams, Instance* instance, EmitterPrototype* emitter_prototype, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float dt)
+    {
+        // Additive, multiplicative and screen blending give the same result in any draw order
+        if (emitter_prototype->m_BlendMode == dmParticleDDF::BLEND_MODE_ALPHA)
+        {
+            GenerateKeys(emitter, emitter_prototype->m_MaxParticleLifeTime);
+            SortParticles(streams, emitter);
+        }
 
-        Simulate(instance, emitter, emitter_prototype, emitter_ddf, dt);
+        Simulate(streams, instance, emitter, emitter_prototype, emitter_ddf, dt);
+        UpdateEmitterBounds(instance, emitter, emitter_ddf);
+    }
+
+    static void UpdateEmitter(Context* context, Prototype* prototype, Instance* instance, EmitterPrototype* emitter_prototype, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float dt)
+    {
+        if (BeginUpdateEmitter(instance, emitter_prototype, emitter, emitter_ddf, dt))
+            SimulateEmitter(&context->m_Streams[0], instance, emitter_prototype, emitter, emitter_ddf, dt);
+    }
+
+    static ParticleStreams* GetThreadStreams(Context* context)
+    {
+        uint32_t index = context->m_JobContext ? dmJob::GetThreadIndex(context->m_JobContext) : 0;
+        assert(index < context->m_StreamCount);
+        return &context->m_Streams[index];
+    }
+
+    static void SimulateEmitterRange(void* ctx, uint32_t start, uint32_t end)
+    {
+        DM_PROFILE(Particle, "SimulateEmitters");
+        Context* context = (Context*) ctx;
+        ParticleStreams* streams = GetThreadStreams(context);
+        for (uint32_t i = start; i < end; ++i)
+        {
+            SimulateEmitterJob& job = context->m_SimulateJobs[i];
+            SimulateEmitter(streams, job.m_Instance, job.m_Prototype, job.m_Emitter, job.m_DDF, job.m_DT);
+        }
     }
 
     static void UpdateEmitterVelocity(Instance* instance, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float dt)
@@ -629,12 +733,7 @@ namespace dmParticle
         if (IsSleeping(inst))
             return;
 
-        uint32_t vertex_size = sizeof(Vertex);
-
-        if (vertex_format == PARTICLE_GUI)
-        {
-            vertex_size = sizeof(ParticleGuiVertex);
-        }
+        uint32_t vertex_size = GetVertexSize(vertex_format);
 
         // vertex buffer index for each emitter
         uint32_t vertex_index = 0;
@@ -651,7 +750,72 @@ namespace dmParticle
         *out_vertex_buffer_size = vertex_index * vertex_size;
 
 
-        context->m_Stats.m_Particles = vertex_index / 6; // Debug data for editor playback
+        context->m_Stats.m_Particles = vertex_index / GetVerticesPerParticle(vertex_format); // Debug data for editor playback
+    }
+
+    static void GenerateVertexDataRange(void* ctx, uint32_t start, uint32_t end)
+    {
+        DM_PROFILE(Particle, "GenerateVertexDataRange");
+        Context* context = (Context*) ctx;
+        const VertexBatch& batch = context->m_VertexBatch;
+        for (uint32_t i = start; i < end; ++i)
+        {
+            VertexEmitterJob& job = context->m_VertexJobs[i];
+            UpdateRenderData(context, job.m_Instance, job.m_Emitter, job.m_DDF, batch.m_Color, job.m_VertexIndex, batch.m_VertexBuffer, batch.m_VertexBufferSize, batch.m_DT, batch.m_Format);
+        }
+    }
+
+    void GenerateVertexDataBatch(HParticleContext context, float dt, const EmitterRenderData* const* emitters, uint32_t emitter_count, const Vector4& color, void* vertex_buffer, uint32_t vertex_buffer_size, uint32_t* out_vertex_buffer_size, ParticleVertexFormat vertex_format)
+    {
+        DM_PROFILE(Particle, "GenerateVertexDataBatch");
+
+        uint32_t vertex_size = GetVertexSize(vertex_format);
+        uint32_t vertices_per_particle = GetVerticesPerParticle(vertex_format);
+
+        uint32_t vertex_index = *out_vertex_buffer_size / vertex_size;
+        if (vertex_buffer == 0x0 || vertex_buffer_size == 0)
+        {
+            return;
+        }
+        uint32_t max_vertex_count = vertex_buffer_size / vertex_size;
+
+        // Reserve the range of each emitter, the emitters write their vertices per particle until the buffer is full
+        dmArray<VertexEmitterJob>& jobs = context->m_VertexJobs;
+        jobs.SetSize(0);
+        if (jobs.Capacity() < emitter_count)
+            jobs.SetCapacity(emitter_count);
+        for (uint32_t i = 0; i < emitter_count; ++i)
+        {
+            const EmitterRenderData* render_data = emitters[i];
+            Instance* inst = GetInstance(context, render_data->m_Instance);
+            if (inst == 0x0 || IsSleeping(inst))
+                continue;
+
+            VertexEmitterJob job;
+            job.m_Instance = inst;
+            job.m_Emitter = &inst->m_Emitters[render_data->m_EmitterIndex];
+            job.m_DDF = &inst->m_Prototype->m_DDF->m_Emitters[render_data->m_EmitterIndex];
+            job.m_VertexIndex = vertex_index;
+            jobs.Push(job);
+
+            uint32_t room = vertex_index < max_vertex_count ? (max_vertex_count - vertex_index) / vertices_per_particle : 0;
+            vertex_index += dmMath::Min(job.m_Emitter->m_Particles.Size(), room) * vertices_per_particle;
+        }
+
+        VertexBatch& batch = context->m_VertexBatch;
+        batch.m_Color = color;
+        batch.m_VertexBuffer = vertex_buffer;
+        batch.m_VertexBufferSize = vertex_buffer_size;
+        batch.m_DT = dt;
+        batch.m_Format = vertex_format;
+
+        dmJob::HJob job = dmJob::ParallelFor(context->m_JobContext, GenerateVertexDataRange, context, jobs.Size(), 1, dmJob::INVALID_JOB);
+        if (job != dmJob::INVALID_JOB)
+            dmJob::Wait(context->m_JobContext, job);
+
+        *out_vertex_buffer_size = vertex_index * vertex_size;
+
+        context->m_Stats.m_Particles = vertex_index / vertices_per_particle; // Debug data for editor playback
     }
 
     void Update(HParticleContext context, float dt, FetchAnimationCallback fetch_animation_callback)
@@ -660,6 +824,8 @@ namespace dmParticle
 
         uint32_t size = context->m_Instances.Size();
         uint32_t TotalAliveParticles = 0;
+        dmArray<SimulateEmitterJob>& jobs = context->m_SimulateJobs;
+        jobs.SetSize(0);
         for (uint32_t i = 0; i < size; i++)
         {
             Instance* instance = context->m_Instances[i];
@@ -691,7 +857,24 @@ namespace dmParticle
                 dmParticleDDF::Emitter* emitter_ddf = &prototype->m_DDF->m_Emitters[emitter_i];
 
                 UpdateEmitterVelocity(instance, emitter, emitter_ddf, dt);
-                UpdateEmitter(prototype, instance, emitter_prototype, emitter, emitter_ddf, dt);
+                float emitter_dt = dt;
+                if (context->m_OffscreenUpdate != OFFSCREEN_UPDATE_ALWAYS && IsEmitterLooping(emitter, emitter_ddf))
+                    emitter_dt = GetOffscreenTimeStep(context, prototype, instance, emitter_prototype, emitter, emitter_ddf, dt);
+                emitter->m_Rendered = 0;
+
+                if (BeginUpdateEmitter(instance, emitter_prototype, emitter, emitter_ddf, emitter_dt))
+                {
+                    SimulateEmitterJob job;
+                    job.m_Instance = instance;
+                    job.m_Emitter = emitter;
+                    job.m_Prototype = emitter_prototype;
+                    job.m_DDF = emitter_ddf;
+                    job.m_DT = emitter_dt;
+                    if (jobs.Full())
+                        jobs.OffsetCapacity(32);
+                    jobs.Push(job);
+                }
+                // The simulation doesn't change the number of particles
                 TotalAliveParticles += (uint32_t)emitter->m_Particles.Size();
                 FetchAnimation(emitter, emitter_prototype, fetch_animation_callback);
                 UpdateEmitterRenderData(instance_handle, emitter_i, instance, emitter, emitter_ddf);
@@ -701,6 +884,11 @@ namespace dmParticle
             }
         }
 
+        // The simulation of an emitter only touches its own particles, simulate them in parallel
+        dmJob::HJob job = dmJob::ParallelFor(context->m_JobContext, SimulateEmitterRange, context, jobs.Size(), 1, dmJob::INVALID_JOB);
+        if (job != dmJob::INVALID_JOB)
+            dmJob::Wait(context->m_JobContext, job);
+
         DM_COUNTER("Particles alive", TotalAliveParticles);
     }
 
@@ -1015,13 +1203,12 @@ namespace dmParticle
             2,3,0,0,1,2		//hv
         };
 
-        uint32_t vertex_size = sizeof(Vertex);
-
-        if (format == PARTICLE_GUI)
-            vertex_size = sizeof(ParticleGuiVertex);
+        uint32_t vertex_size = GetVertexSize(format);
+        uint32_t vertices_per_particle = GetVerticesPerParticle(format);
 
         emitter->m_VertexIndex = vertex_index;
         emitter->m_VertexCount = 0;
+        emitter->m_Rendered = 1;
 
         const AnimationData& anim_data = emitter->m_AnimationData;
         // texture animation
@@ -1084,7 +1271,7 @@ namespace dmParticle
             height_factor *= 0.5f;
         }
 
-        for (j = 0; j < particle_count && vertex_index + 6 <= max_vertex_count; j++)
+        for (j = 0; j < particle_count && vertex_index + vertices_per_particle <= max_vertex_count; j++)
         {
             Particle* particle = &emitter->m_Particles[j];
             // Evaluate anim frame
@@ -1215,8 +1402,34 @@ namespace dmParticle
                 SET_VERTEX_GUI(vertex, p0, c, tex_coord[tex_lookup[5] * 2], tex_coord[tex_lookup[5] * 2 + 1])
 #undef SET_VERTEX_GUI
             }
+            else if (format == PARTICLE_GO_INSTANCE)
+            {
+                ParticleInstance* particle_instance = &((ParticleInstance*)vertex_buffer)[vertex_index];
+                Vector3 p = particle_transform.GetTranslation();
+                particle_instance->m_Position[0] = p.getX();
+                particle_instance->m_Position[1] = p.getY();
+                particle_instance->m_Position[2] = p.getZ();
+                particle_instance->m_AxisX[0] = x.getX();
+                particle_instance->m_AxisX[1] = x.getY();
+                particle_instance->m_AxisX[2] = x.getZ();
+                particle_instance->m_AxisY[0] = y.getX();
+                particle_instance->m_AxisY[1] = y.getY();
+                particle_instance->m_AxisY[2] = y.getZ();
+                particle_instance->m_Color[0] = c.getX();
+                particle_instance->m_Color[1] = c.getY();
+                particle_instance->m_Color[2] = c.getZ();
+                particle_instance->m_Color[3] = c.getW();
+
+                // Same lookup as the corners p0, p1, p3 and p2 of the two triangles above
+                const int corners[4] = { tex_lookup[0], tex_lookup[1], tex_lookup[2], tex_lookup[4] };
+                for (uint32_t corner = 0; corner < 4; ++corner)
+                {
+                    particle_instance->m_UV[corner][0] = tex_coord[corners[corner] * 2];
+                    particle_instance->m_UV[corner][1] = tex_coord[corners[corner] * 2 + 1];
+                }
+            }
 
-            vertex_index += 6;
+            vertex_index += vertices_per_particle;
         }
         if (j < particle_count)
         {
@@ -1235,15 +1448,6 @@ namespace dmParticle
         return emitter->m_VertexCount;
     }
 
-    struct SortPred
-    {
-        inline bool operator () (const Particle& p1, const Particle& p2)
-        {
-            return p1.GetSortKey().m_Key < p2.GetSortKey().m_Key;
-        }
-
-    };
-
     void GenerateKeys(Emitter* emitter, float max_particle_life_time)
     {
         dmArray<Particle>& particles = emitter->m_Particles;
@@ -1267,11 +1471,156 @@ namespace dmParticle
         }
     }
 
-    void SortParticles(Emitter* emitter)
+    // Insertion sort, gives up when it has moved more keys than there are particles
+    static bool InsertionSortKeys(uint32_t* keys, uint32_t n)
+    {
+        uint32_t moves = 0;
+        for (uint32_t i = 1; i < n; ++i)
+        {
+            uint32_t key = keys[i];
+            uint32_t j = i;
+            while (j > 0 && keys[j - 1] > key)
+            {
+                keys[j] = keys[j - 1];
+                --j;
+            }
+            keys[j] = key;
+            moves += i - j;
+            if (moves > n)
+                return false;
+        }
+        return true;
+    }
+
+    // Stable LSD radix sort on the life time bits of the keys. The keys must be in index order.
+    static void RadixSortKeys(uint32_t* keys, uint32_t* temp, uint32_t n)
+    {
+        uint32_t* src = keys;
+        uint32_t* dst = temp;
+        for (uint32_t shift = 16; shift < 32; shift += 8)
+        {
+            uint32_t offsets[256];
+            memset(offsets, 0, sizeof(offsets));
+            for (uint32_t i = 0; i < n; ++i)
+                ++offsets[(src[i] >> shift) & 0xff];
+
+            uint32_t sum = 0;
+            for (uint32_t b = 0; b < 256; ++b)
+            {
+                uint32_t count = offsets[b];
+                offsets[b] = sum;
+                sum += count;
+            }
+
+            for (uint32_t i = 0; i < n; ++i)
+                dst[offsets[(src[i] >> shift) & 0xff]++] = src[i];
+
+            uint32_t* t = src;
+            src = dst;
+            dst = t;
+        }
+        // An even number of passes leaves the result in keys
+    }
+
+    void SortParticles(ParticleStreams* streams, Emitter* emitter)
     {
         DM_PROFILE(Particle, "Sort");
 
-        std::sort(emitter->m_Particles.Begin(), emitter->m_Particles.End(), SortPred());
+        dmArray<Particle>& particles = emitter->m_Particles;
+        uint32_t n = particles.Size();
+        if (n < 2)
+            return;
+
+        if (streams->m_SortKeys.Capacity() < n)
+        {
+            // Grow to the emitter capacity to avoid reallocating every time an emitter spawns more particles
+            uint32_t capacity = dmMath::Max(n, particles.Capacity());
+            streams->m_SortKeys.SetCapacity(capacity);
+            streams->m_SortKeysTemp.SetCapacity(capacity);
+            streams->m_SortParticles.SetCapacity(capacity);
+        }
+        streams->m_SortKeys.SetSize(n);
+        streams->m_SortKeysTemp.SetSize(n);
+
+        uint32_t* keys = streams->m_SortKeys.Begin();
+        for (uint32_t i = 0; i < n; ++i)
+            keys[i] = particles[i].GetSortKey().m_Key;
+
+        // The order rarely changes between frames, except when particles are spawned or die
+        if (!InsertionSortKeys(keys, n))
+        {
+            for (uint32_t i = 0; i < n; ++i)
+                keys[i] = particles[i].GetSortKey().m_Key;
+            RadixSortKeys(keys, streams->m_SortKeysTemp.Begin(), n);
+        }
+
+        uint32_t first = 0;
+        while (first < n && (keys[first] & 0xffff) == first)
+            ++first;
+        if (first == n)
+            return;
+
+        streams->m_SortParticles.SetSize(n - first);
+        Particle* sorted = streams->m_SortParticles.Begin();
+        for (uint32_t i = first; i < n; ++i)
+            sorted[i - first] = particles[keys[i] & 0xffff];
+        memcpy(&particles[first], sorted, (n - first) * sizeof(Particle));
+    }
+
+    static void UpdateEmitterBounds(Instance* instance, Emitter* emitter, dmParticleDDF::Emitter* ddf)
+    {
+        DM_PROFILE(Particle, "Bounds");
+
+        dmArray<Particle>& particles = emitter->m_Particles;
+        uint32_t count = particles.Size();
+        EmitterRenderData& render_data = emitter->m_RenderData;
+        if (count == 0)
+        {
+            render_data.m_AabbMin = Point3(render_data.m_Transform.getCol3().getXYZ());
+            render_data.m_AabbMax = render_data.m_AabbMin;
+            return;
+        }
+
+        // Half size of the quads relative to the particle scale, see UpdateRenderData().
+        // Auto sized animations are sized by the largest frame, the others by the particle size.
+        const AnimationData& anim_data = emitter->m_AnimationData;
+        float auto_half_size = 0.0f;
+        if (ddf->m_SizeMode == SIZE_MODE_AUTO && anim_data.m_TexDims != 0x0)
+        {
+            for (uint32_t tile = anim_data.m_StartTile; tile < anim_data.m_EndTile; ++tile)
+            {
+                const float* td = &anim_data.m_TexDims[tile << 1];
+                auto_half_size = dmMath::Max(auto_half_size, 0.5f * dmMath::Max(td[0], td[1]));
+            }
+        }
+
+        // The quad corners are within sqrt(2) of the half size from the center
+        Vector3 min_p(FLT_MAX);
+        Vector3 max_p(-FLT_MAX);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const Particle& p = particles[i];
+            float half_size = dmMath::Max(0.5f * p.GetSourceSize(), auto_half_size);
+            Vector3 extents(maxElem(absPerElem(p.GetScale())) * half_size * 1.4142136f);
+            Vector3 position(p.GetPosition());
+            min_p = minPerElem(min_p, position - extents);
+            max_p = maxPerElem(max_p, position + extents);
+        }
+
+        if (ddf->m_Space == EMISSION_SPACE_EMITTER)
+        {
+            // Bound the box with a sphere, since the emitter might be rotated
+            const dmTransform::TransformS1& transform = instance->m_WorldTransform;
+            Point3 center = dmTransform::Apply(transform, Point3((min_p + max_p) * 0.5f));
+            Vector3 extents(length(max_p - min_p) * 0.5f * transform.GetScale());
+            render_data.m_AabbMin = center - extents;
+            render_data.m_AabbMax = center + extents;
+        }
+        else
+        {
+            render_data.m_AabbMin = Point3(min_p);
+            render_data.m_AabbMax = Point3(max_p);
+        }
     }
 
 #define SAMPLE_PROP(segment, x, target)\
@@ -1290,43 +1639,100 @@ namespace dmParticle
         }
     }
 
-    void EvaluateParticleProperties(Emitter* emitter, Property* particle_properties, dmParticleDDF::Emitter* emitter_ddf, float dt)
+    static void GatherParticleStreams(ParticleStreams* streams, dmArray<Particle>& particles)
+    {
+        uint32_t count = particles.Size();
+        uint32_t stride = (count + 3) & ~3u;
+        if (streams->m_Stride < stride)
+        {
+            // Grow to the emitter capacity to avoid reallocating every time an emitter spawns more particles
+            stride = (particles.Capacity() + 3) & ~3u;
+            streams->m_Data.SetCapacity(stride * PARTICLE_STREAM_COUNT);
+            streams->m_Data.SetSize(stride * PARTICLE_STREAM_COUNT);
+            streams->m_Segments.SetCapacity(stride);
+            streams->m_Segments.SetSize(stride);
+            streams->m_Stride = stride;
+        }
+
+        float* px = streams->Get(PARTICLE_STREAM_POSITION_X);
+        float* py = streams->Get(PARTICLE_STREAM_POSITION_Y);
+        float* pz = streams->Get(PARTICLE_STREAM_POSITION_Z);
+        float* vx = streams->Get(PARTICLE_STREAM_VELOCITY_X);
+        float* vy = streams->Get(PARTICLE_STREAM_VELOCITY_Y);
+        float* vz = streams->Get(PARTICLE_STREAM_VELOCITY_Z);
+        float* spread = streams->Get(PARTICLE_STREAM_SPREAD_FACTOR);
+        float* life_t = streams->Get(PARTICLE_STREAM_LIFE_T);
+        uint32_t* segments = streams->m_Segments.Begin();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const Particle* particle = &particles[i];
+            const Point3& position = particle->m_Position;
+            const Vector3& velocity = particle->m_Velocity;
+            px[i] = position.getX();
+            py[i] = position.getY();
+            pz[i] = position.getZ();
+            vx[i] = velocity.getX();
+            vy[i] = velocity.getY();
+            vz[i] = velocity.getZ();
+            spread[i] = particle->m_SpreadFactor;
+            float x = dmMath::Select(-particle->m_MaxLifeTime, 0.0f, 1.0f - particle->m_TimeLeft * particle->m_ooMaxLifeTime);
+            life_t[i] = x;
+            segments[i] = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
+        }
+    }
+
+    static void SampleParticleProperty(const Property& property, const float* life_t, const uint32_t* segments, float* out, uint32_t count)
+    {
+        const LinearSegment* property_segments = property.m_Segments;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            SAMPLE_PROP(property_segments[segments[i]], life_t[i], out[i])
+        }
+    }
+
+    void EvaluateParticleProperties(Emitter* emitter, ParticleStreams* streams, Property* particle_properties, dmParticleDDF::Emitter* emitter_ddf, float dt)
     {
-        float properties[PARTICLE_KEY_COUNT];
-        // TODO Optimize this
         dmArray<Particle>& particles = emitter->m_Particles;
         uint32_t count = particles.Size();
+        const float* life_t = streams->Get(PARTICLE_STREAM_LIFE_T);
+        const uint32_t* segments = streams->m_Segments.Begin();
+
+        float* scale = streams->Get(PARTICLE_STREAM_SCALE);
+        float* red = streams->Get(PARTICLE_STREAM_RED);
+        float* green = streams->Get(PARTICLE_STREAM_GREEN);
+        float* blue = streams->Get(PARTICLE_STREAM_BLUE);
+        float* alpha = streams->Get(PARTICLE_STREAM_ALPHA);
+        float* stretch_x = streams->Get(PARTICLE_STREAM_STRETCH_FACTOR_X);
+        float* stretch_y = streams->Get(PARTICLE_STREAM_STRETCH_FACTOR_Y);
+        SampleParticleProperty(particle_properties[PARTICLE_KEY_SCALE], life_t, segments, scale, count);
+        SampleParticleProperty(particle_properties[PARTICLE_KEY_RED], life_t, segments, red, count);
+        SampleParticleProperty(particle_properties[PARTICLE_KEY_GREEN], life_t, segments, green, count);
+        SampleParticleProperty(particle_properties[PARTICLE_KEY_BLUE], life_t, segments, blue, count);
+        SampleParticleProperty(particle_properties[PARTICLE_KEY_ALPHA], life_t, segments, alpha, count);
+        SampleParticleProperty(particle_properties[PARTICLE_KEY_STRETCH_FACTOR_X], life_t, segments, stretch_x, count);
+        SampleParticleProperty(particle_properties[PARTICLE_KEY_STRETCH_FACTOR_Y], life_t, segments, stretch_y, count);
+
         for (uint32_t i = 0; i < count; ++i)
         {
             Particle* particle = &particles[i];
-            float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
-            uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_SCALE].m_Segments[segment_index], x, properties[PARTICLE_KEY_SCALE])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_RED].m_Segments[segment_index], x, properties[PARTICLE_KEY_RED])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_GREEN].m_Segments[segment_index], x, properties[PARTICLE_KEY_GREEN])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_BLUE].m_Segments[segment_index], x, properties[PARTICLE_KEY_BLUE])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_ALPHA].m_Segments[segment_index], x, properties[PARTICLE_KEY_ALPHA])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_STRETCH_FACTOR_X].m_Segments[segment_index], x, properties[PARTICLE_KEY_STRETCH_FACTOR_X])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_STRETCH_FACTOR_Y].m_Segments[segment_index], x, properties[PARTICLE_KEY_STRETCH_FACTOR_Y])
             Vector4 c = particle->GetSourceColor();
-            particle->SetScale(Vector3(properties[PARTICLE_KEY_SCALE]));
-            particle->SetColor(Vector4(dmMath::Clamp(c.getX() * properties[PARTICLE_KEY_RED], 0.0f, 1.0f),
-                    dmMath::Clamp(c.getY() * properties[PARTICLE_KEY_GREEN], 0.0f, 1.0f),
-                    dmMath::Clamp(c.getZ() * properties[PARTICLE_KEY_BLUE], 0.0f, 1.0f),
-                    dmMath::Clamp(c.getW() * properties[PARTICLE_KEY_ALPHA], 0.0f, 1.0f)));
-            particle->m_StretchFactorX = particle->m_SourceStretchFactorX + (properties[PARTICLE_KEY_STRETCH_FACTOR_X]);
-            particle->m_StretchFactorY = particle->m_SourceStretchFactorY + (properties[PARTICLE_KEY_STRETCH_FACTOR_Y]);
+            particle->SetScale(Vector3(scale[i]));
+            particle->SetColor(Vector4(dmMath::Clamp(c.getX() * red[i], 0.0f, 1.0f),
+                    dmMath::Clamp(c.getY() * green[i], 0.0f, 1.0f),
+                    dmMath::Clamp(c.getZ() * blue[i], 0.0f, 1.0f),
+                    dmMath::Clamp(c.getW() * alpha[i], 0.0f, 1.0f)));
+            particle->m_StretchFactorX = particle->m_SourceStretchFactorX + stretch_x[i];
+            particle->m_StretchFactorY = particle->m_SourceStretchFactorY + stretch_y[i];
         }
 
+        // The color streams are free to reuse for the rotation properties
+        float* rotation = red;
         if (emitter_ddf->m_ParticleOrientation == PARTICLE_ORIENTATION_MOVEMENT_DIRECTION) {
+            SampleParticleProperty(particle_properties[PARTICLE_KEY_ROTATION], life_t, segments, rotation, count);
             for (uint32_t i = 0; i < count; ++i)
             {
                 Particle* particle = &particles[i];
-                float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
-                uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-                SAMPLE_PROP(particle_properties[PARTICLE_KEY_ROTATION].m_Segments[segment_index], x, properties[PARTICLE_KEY_ROTATION])
-                particle->SetRotation(particle->GetSourceRotation() * dmVMath::QuatFromAngle(2, DEG_RAD * properties[PARTICLE_KEY_ROTATION]));
+                particle->SetRotation(particle->GetSourceRotation() * dmVMath::QuatFromAngle(2, DEG_RAD * rotation[i]));
                 if (lengthSqr(particle->m_Velocity) > EPSILON)
                 {
                     Vector3 vel_norm = normalize(particle->m_Velocity);
@@ -1339,81 +1745,98 @@ namespace dmParticle
             }
 
         } else if (emitter_ddf->m_ParticleOrientation == PARTICLE_ORIENTATION_ANGULAR_VELOCITY) {
+            float* angular_velocity = rotation;
+            SampleParticleProperty(particle_properties[PARTICLE_KEY_ANGULAR_VELOCITY], life_t, segments, angular_velocity, count);
             for (uint32_t i = 0; i < count; ++i)
             {
                 Particle* particle = &particles[i];
-                float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
-                uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-                SAMPLE_PROP(particle_properties[PARTICLE_KEY_ANGULAR_VELOCITY].m_Segments[segment_index], x, properties[PARTICLE_KEY_ANGULAR_VELOCITY])
-                particle->SetRotation(particle->GetRotation() * Quat::rotationZ(DEG_RAD * (particle->m_SourceAngularVelocity * (properties[PARTICLE_KEY_ANGULAR_VELOCITY])) * dt));
+                particle->SetRotation(particle->GetRotation() * Quat::rotationZ(DEG_RAD * (particle->m_SourceAngularVelocity * angular_velocity[i]) * dt));
             }
 
         } else {
+            SampleParticleProperty(particle_properties[PARTICLE_KEY_ROTATION], life_t, segments, rotation, count);
             for (uint32_t i = 0; i < count; ++i)
             {
                 Particle* particle = &particles[i];
-                float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
-                uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-                SAMPLE_PROP(particle_properties[PARTICLE_KEY_ROTATION].m_Segments[segment_index], x, properties[PARTICLE_KEY_ROTATION])
-                particle->SetRotation(particle->GetSourceRotation() * dmVMath::QuatFromAngle(2, DEG_RAD * properties[PARTICLE_KEY_ROTATION]));
+                particle->SetRotation(particle->GetSourceRotation() * dmVMath::QuatFromAngle(2, DEG_RAD * rotation[i]));
             }
         }
 
     }
 
-    void ApplyAcceleration(dmArray<Particle>& particles, Property* modifier_properties, const Quat& rotation, float scale, float emitter_t, float dt)
+    // The modifier kernels operate on the position and velocity streams, see GatherParticleStreams
+    // They are kept branch free over plain float arrays so that the compiler can vectorize them.
+
+    void ApplyAcceleration(ParticleStreams* streams, uint32_t particle_count, Property* modifier_properties, const Quat& rotation, float scale, float emitter_t, float dt)
     {
-        uint32_t particle_count = particles.Size();
         Vector3 acc_step = rotate(rotation, ACCELERATION_LOCAL_DIR) * dt * scale;
         const Property& magnitude_property = modifier_properties[MODIFIER_KEY_MAGNITUDE];
         uint32_t segment_index = dmMath::Min((uint32_t)(emitter_t * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
         float magnitude;
         SAMPLE_PROP(magnitude_property.m_Segments[segment_index], emitter_t, magnitude)
         float mag_spread = magnitude_property.m_Spread;
+        const float ax = acc_step.getX();
+        const float ay = acc_step.getY();
+        const float az = acc_step.getZ();
+        const float* spread = streams->Get(PARTICLE_STREAM_SPREAD_FACTOR);
+        float* vx = streams->Get(PARTICLE_STREAM_VELOCITY_X);
+        float* vy = streams->Get(PARTICLE_STREAM_VELOCITY_Y);
+        float* vz = streams->Get(PARTICLE_STREAM_VELOCITY_Z);
         for (uint32_t i = 0; i < particle_count; ++i)
         {
-            Particle* particle = &particles[i];
-            particle->SetVelocity(particle->GetVelocity() + acc_step * (magnitude + mag_spread * particle->GetSpreadFactor()));
+            float m = magnitude + mag_spread * spread[i];
+            vx[i] += ax * m;
+            vy[i] += ay * m;
+            vz[i] += az * m;
         }
     }
 
-    void ApplyDrag(dmArray<Particle>& particles, Property* modifier_properties, dmParticleDDF::Modifier* modifier_ddf, const Quat& rotation, float emitter_t, float dt)
+    void ApplyDrag(ParticleStreams* streams, uint32_t particle_count, Property* modifier_properties, dmParticleDDF::Modifier* modifier_ddf, const Quat& rotation, float emitter_t, float dt)
     {
-        uint32_t particle_count = particles.Size();
         Vector3 direction = rotate(rotation, DRAG_LOCAL_DIR);
         const Property& magnitude_property = modifier_properties[MODIFIER_KEY_MAGNITUDE];
         uint32_t segment_index = dmMath::Min((uint32_t)(emitter_t * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
         float magnitude;
         SAMPLE_PROP(magnitude_property.m_Segments[segment_index], emitter_t, magnitude)
         float mag_spread = magnitude_property.m_Spread;
-        for (uint32_t i = 0; i < particle_count; ++i)
+        const float* spread = streams->Get(PARTICLE_STREAM_SPREAD_FACTOR);
+        float* vx = streams->Get(PARTICLE_STREAM_VELOCITY_X);
+        float* vy = streams->Get(PARTICLE_STREAM_VELOCITY_Y);
+        float* vz = streams->Get(PARTICLE_STREAM_VELOCITY_Z);
+        if (modifier_ddf->m_UseDirection)
+        {
+            const float dx = direction.getX();
+            const float dy = direction.getY();
+            const float dz = direction.getZ();
+            for (uint32_t i = 0; i < particle_count; ++i)
+            {
+                // Applied drag > 1 means the particle would travel in the reverse direction
+                float applied_drag = dmMath::Min((magnitude + mag_spread * spread[i]) * dt, 1.0f);
+                // Projection of the velocity onto the drag direction
+                float p = (vx[i] * dx + vy[i] * dy + vz[i] * dz) * applied_drag;
+                vx[i] -= dx * p;
+                vy[i] -= dy * p;
+                vz[i] -= dz * p;
+            }
+        }
+        else
         {
-            Particle* particle = &particles[i];
-            Vector3 v = particle->GetVelocity();
-            if (modifier_ddf->m_UseDirection)
-                v = projection(Point3(particle->GetVelocity()), direction) * direction;
-            // Applied drag > 1 means the particle would travel in the reverse direction
-            float applied_drag = dmMath::Min((magnitude + mag_spread * particle->GetSpreadFactor()) * dt, 1.0f);
-            particle->SetVelocity(particle->GetVelocity() - v * applied_drag);
+            for (uint32_t i = 0; i < particle_count; ++i)
+            {
+                float applied_drag = dmMath::Min((magnitude + mag_spread * spread[i]) * dt, 1.0f);
+                vx[i] -= vx[i] * applied_drag;
+                vy[i] -= vy[i] * applied_drag;
+                vz[i] -= vz[i] * applied_drag;
+            }
         }
     }
 
-    static Vector3 GetParticleDir(Particle* particle)
+    static Vector3 GetParticleDir(const Particle* particle)
     {
         return rotate(particle->GetRotation(), PARTICLE_LOCAL_BASE_DIR);
     }
 
-    static Vector3 NonZeroVector3(Vector3 v, float sq_length, Vector3 fallback)
-    {
-        Vector3 result;
-        float neg_sq_length = -sq_length;
-        result.setX(dmMath::Select(neg_sq_length, fallback.getX(), v.getX()));
-        result.setY(dmMath::Select(neg_sq_length, fallback.getY(), v.getY()));
-        result.setZ(dmMath::Select(neg_sq_length, fallback.getZ(), v.getZ()));
-        return result;
-    }
-
-    void ApplyRadial(dmArray<Particle>& particles, Property* modifier_properties, const Point3& position, float scale, float emitter_t, float dt)
+    void ApplyRadial(ParticleStreams* streams, const dmArray<Particle>& particles, Property* modifier_properties, const Point3& position, float scale, float emitter_t, float dt)
     {
         uint32_t particle_count = particles.Size();
         const Property& magnitude_property = modifier_properties[MODIFIER_KEY_MAGNITUDE];
@@ -1426,22 +1849,44 @@ namespace dmParticle
         float max_distance = max_distance_property.m_Segments[0].m_Y * scale;
         float max_sq_distance = max_distance * max_distance;
         float applied_factor = dt * scale;
+        const float cx = position.getX();
+        const float cy = position.getY();
+        const float cz = position.getZ();
+        const float* spread = streams->Get(PARTICLE_STREAM_SPREAD_FACTOR);
+        const float* px = streams->Get(PARTICLE_STREAM_POSITION_X);
+        const float* py = streams->Get(PARTICLE_STREAM_POSITION_Y);
+        const float* pz = streams->Get(PARTICLE_STREAM_POSITION_Z);
+        float* vx = streams->Get(PARTICLE_STREAM_VELOCITY_X);
+        float* vy = streams->Get(PARTICLE_STREAM_VELOCITY_Y);
+        float* vz = streams->Get(PARTICLE_STREAM_VELOCITY_Z);
         for (uint32_t i = 0; i < particle_count; ++i)
         {
-            Particle* particle = &particles[i];
-            Vector3 delta = particle->GetPosition() - position;
-            float delta_sq_len = lengthSqr(delta);
-            float applied_magnitude = magnitude + mag_spread * particle->GetSpreadFactor();
+            float dx = px[i] - cx;
+            float dy = py[i] - cy;
+            float dz = pz[i] - cz;
+            float delta_sq_len = dx * dx + dy * dy + dz * dz;
+            float dir_sq_len = delta_sq_len;
+            if (delta_sq_len <= 0.0f)
+            {
+                // Particle at the modifier position, use the particle direction instead
+                Vector3 dir = GetParticleDir(&particles[i]);
+                dx = dir.getX();
+                dy = dir.getY();
+                dz = dir.getZ();
+                dir_sq_len = dx * dx + dy * dy + dz * dz;
+            }
+            float applied_magnitude = magnitude + mag_spread * spread[i];
             // 0 acc delta lies outside max dist
             float a = dmMath::Select(max_sq_distance - delta_sq_len, applied_magnitude, 0.0f);
-            Vector3 dir = normalize(NonZeroVector3(delta, delta_sq_len, GetParticleDir(particle)));
-            particle->SetVelocity(particle->GetVelocity() + dir * a * applied_factor);
+            float f = a * applied_factor / sqrtf(dir_sq_len);
+            vx[i] += dx * f;
+            vy[i] += dy * f;
+            vz[i] += dz * f;
         }
     }
 
-    void ApplyVortex(dmArray<Particle>& particles, Property* modifier_properties, const Point3& position, const Quat& rotation, float scale, float emitter_t, float dt)
+    void ApplyVortex(ParticleStreams* streams, uint32_t particle_count, Property* modifier_properties, const Point3& position, const Quat& rotation, float scale, float emitter_t, float dt)
     {
-        uint32_t particle_count = particles.Size();
         const Property& magnitude_property = modifier_properties[MODIFIER_KEY_MAGNITUDE];
         const Property& max_distance_property = modifier_properties[MODIFIER_KEY_MAX_DISTANCE];
         uint32_t segment_index = dmMath::Min((uint32_t)(emitter_t * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
@@ -1454,23 +1899,51 @@ namespace dmParticle
         Vector3 axis = rotate(rotation, VORTEX_LOCAL_AXIS);
         Vector3 start = rotate(rotation, VORTEX_LOCAL_START_DIR);
         float applied_factor = dt * scale;
+        const float cx = position.getX();
+        const float cy = position.getY();
+        const float cz = position.getZ();
+        const float ax = axis.getX();
+        const float ay = axis.getY();
+        const float az = axis.getZ();
+        const float sx = start.getX();
+        const float sy = start.getY();
+        const float sz = start.getZ();
+        const float* spread = streams->Get(PARTICLE_STREAM_SPREAD_FACTOR);
+        const float* px = streams->Get(PARTICLE_STREAM_POSITION_X);
+        const float* py = streams->Get(PARTICLE_STREAM_POSITION_Y);
+        const float* pz = streams->Get(PARTICLE_STREAM_POSITION_Z);
+        float* vx = streams->Get(PARTICLE_STREAM_VELOCITY_X);
+        float* vy = streams->Get(PARTICLE_STREAM_VELOCITY_Y);
+        float* vz = streams->Get(PARTICLE_STREAM_VELOCITY_Z);
         for (uint32_t i = 0; i < particle_count; ++i)
         {
-            Particle* particle = &particles[i];
             // delta from vortex position
-            Vector3 delta = particle->GetPosition() - position;
+            float dx = px[i] - cx;
+            float dy = py[i] - cy;
+            float dz = pz[i] - cz;
             // normal from vortex axis (non-unit)
-            Vector3 normal = delta - projection(Point3(delta), axis) * axis;
+            float d = dx * ax + dy * ay + dz * az;
+            float nx = dx - d * ax;
+            float ny = dy - d * ay;
+            float nz = dz - d * az;
             // tangent is the direction of the vortex acceleration
-            Vector3 tangent = cross(axis, normal);
+            float tx = ay * nz - az * ny;
+            float ty = az * nx - ax * nz;
+            float tz = ax * ny - ay * nx;
             // In case the particle is directed along the axis, give it a guaranteed orthogonal start
-            tangent = NonZeroVector3(tangent, lengthSqr(tangent), start);
+            float neg_tangent_sq_len = -(tx * tx + ty * ty + tz * tz);
+            tx = dmMath::Select(neg_tangent_sq_len, sx, tx);
+            ty = dmMath::Select(neg_tangent_sq_len, sy, ty);
+            tz = dmMath::Select(neg_tangent_sq_len, sz, tz);
             // tangent is now guaranteed to be non-zero
-            tangent = normalize(tangent);
+            float inv_tangent_len = 1.0f / sqrtf(tx * tx + ty * ty + tz * tz);
             // use normal for max distance test
-            float normal_sq_len = lengthSqr(normal);
-            float acceleration = dmMath::Select(max_sq_distance - normal_sq_len, magnitude + mag_spread * particle->GetSpreadFactor(), 0.0f);
-            particle->SetVelocity(particle->GetVelocity() + tangent * acceleration * applied_factor);
+            float normal_sq_len = nx * nx + ny * ny + nz * nz;
+            float acceleration = dmMath::Select(max_sq_distance - normal_sq_len, magnitude + mag_spread * spread[i], 0.0f);
+            float f = acceleration * applied_factor * inv_tangent_len;
+            vx[i] += tx * f;
+            vy[i] += ty * f;
+            vz[i] += tz * f;
         }
     }
 
@@ -1495,12 +1968,17 @@ namespace dmParticle
         return emitter_ddf->m_Rotation * modifier_ddf->m_Rotation;
     }
 
-    void Simulate(Instance* instance, Emitter* emitter, EmitterPrototype* prototype, dmParticleDDF::Emitter* ddf, float dt)
+    void Simulate(ParticleStreams* streams, Instance* instance, Emitter* emitter, EmitterPrototype* prototype, dmParticleDDF::Emitter* ddf, float dt)
     {
         DM_PROFILE(Particle, "Simulate");
 
         dmArray<Particle>& particles = emitter->m_Particles;
-        EvaluateParticleProperties(emitter, prototype->m_ParticleProperties, ddf, dt);
+        uint32_t particle_count = particles.Size();
+        if (particle_count == 0)
+            return;
+
+        GatherParticleStreams(streams, particles);
+        EvaluateParticleProperties(emitter, streams, prototype->m_ParticleProperties, ddf, dt);
         float emitter_t = dmMath::Select(-ddf->m_Duration, 0.0f, emitter->m_Timer / ddf->m_Duration);
         float scale = 1.0f;
         if (ddf->m_Space == EMISSION_SPACE_WORLD)
@@ -1516,37 +1994,52 @@ namespace dmParticle
             case dmParticleDDF::MODIFIER_TYPE_ACCELERATION:
                 {
                     Quat rotation = CalculateModifierRotation(instance, ddf, modifier_ddf);
-                    ApplyAcceleration(particles, modifier->m_Properties, rotation, scale, emitter_t, dt);
+                    ApplyAcceleration(streams, particle_count, modifier->m_Properties, rotation, scale, emitter_t, dt);
                 }
                 break;
             case dmParticleDDF::MODIFIER_TYPE_DRAG:
                 {
                     Quat rotation = CalculateModifierRotation(instance, ddf, modifier_ddf);
-                    ApplyDrag(particles, modifier->m_Properties, modifier_ddf, rotation, emitter_t, dt);
+                    ApplyDrag(streams, particle_count, modifier->m_Properties, modifier_ddf, rotation, emitter_t, dt);
                 }
                 break;
             case dmParticleDDF::MODIFIER_TYPE_RADIAL:
                 {
                     Point3 position = CalculateModifierPosition(instance, ddf, modifier_ddf);
-                    ApplyRadial(particles, modifier->m_Properties, position, scale, emitter_t, dt);
+                    ApplyRadial(streams, particles, modifier->m_Properties, position, scale, emitter_t, dt);
                 }
                 break;
             case dmParticleDDF::MODIFIER_TYPE_VORTEX:
                 {
                     Point3 position = CalculateModifierPosition(instance, ddf, modifier_ddf);
                     Quat rotation = CalculateModifierRotation(instance, ddf, modifier_ddf);
-                    ApplyVortex(particles, modifier->m_Properties, position, rotation, scale, emitter_t, dt);
+                    ApplyVortex(streams, particle_count, modifier->m_Properties, position, rotation, scale, emitter_t, dt);
                 }
                 break;
             }
         }
-        uint32_t particle_count = particles.Size();
+
+        float* px = streams->Get(PARTICLE_STREAM_POSITION_X);
+        float* py = streams->Get(PARTICLE_STREAM_POSITION_Y);
+        float* pz = streams->Get(PARTICLE_STREAM_POSITION_Z);
+        const float* vx = streams->Get(PARTICLE_STREAM_VELOCITY_X);
+        const float* vy = streams->Get(PARTICLE_STREAM_VELOCITY_Y);
+        const float* vz = streams->Get(PARTICLE_STREAM_VELOCITY_Z);
+        // NOTE This velocity integration has a larger error than normal since we don't use the velocity at the
+        // beginning of the frame, but it's ok since particle movement does not need to be very exact
+        for (uint32_t i = 0; i < particle_count; ++i)
+        {
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            pz[i] += vz[i] * dt;
+        }
+
+        // Scatter the simulated state back to the particles
         for (uint32_t i = 0; i < particle_count; ++i)
         {
             Particle* p = &particles[i];
-            // NOTE This velocity integration has a larger error than normal since we don't use the velocity at the
-            // beginning of the frame, but it's ok since particle movement does not need to be very exact
-            p->SetPosition(p->GetPosition() + p->m_Velocity * dt);
+            p->m_Position = Point3(px[i], py[i], pz[i]);
+            p->m_Velocity = Vector3(vx[i], vy[i], vz[i]);
 
             p->m_Scale[0] += p->m_Scale[0] * p->m_StretchFactorX;
             if (!ddf->m_StretchWithVelocity)
@@ -1865,6 +2358,13 @@ namespace dmParticle
         render_data.m_RenderConstantsSize = emitter->m_RenderConstants.Size();
         render_data.m_Instance = instance;
         render_data.m_EmitterIndex = emitter_index;
+
+        // Emitters without particles are bounded by their position, see UpdateEmitterBounds()
+        if (emitter->m_Particles.Empty())
+        {
+            render_data.m_AabbMin = Point3(world.getCol3().getXYZ());
+            render_data.m_AabbMax = render_data.m_AabbMin;
+        }
     }
 
     // Update render data for all emitters on an instance
@@ -2010,12 +2510,7 @@ namespace dmParticle
 
     uint32_t GetVertexBufferSize(uint32_t particle_count, ParticleVertexFormat vertex_format)
     {
-        uint32_t vertex_size = sizeof(Vertex);
-
-        if (vertex_format == PARTICLE_GUI)
-            vertex_size = sizeof(ParticleGuiVertex);
-
-        return particle_count * 6 * vertex_size;
+        return particle_count * GetVerticesPerParticle(vertex_format) * GetVertexSize(vertex_format);
     }
 
     uint32_t GetMaxVertexBufferSize(HParticleContext context, ParticleVertexFormat vertex_format)
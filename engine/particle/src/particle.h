@@ -16,6 +16,7 @@
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
 #include <dlib/configfile.h>
 #include <dlib/hash.h>
+#include <dlib/job.h>
 #include <ddf/ddf.h>
 #include "particle/particle_ddf.h"
 
@@ -62,6 +63,8 @@ namespace dmParticle
     extern const char* MAX_INSTANCE_COUNT_KEY;
     /// Config key to use for tweaking the total maximum number of particles in a context.
     extern const char* MAX_PARTICLE_COUNT_KEY;
+    /// Config key to use for selecting how off-screen looping emitters are updated, see OffscreenUpdate.
+    extern const char* OFFSCREEN_UPDATE_KEY;
 
     /**
      * Render constants supplied to the render callback.
@@ -130,6 +133,23 @@ namespace dmParticle
     {
         PARTICLE_GO = 0,
         PARTICLE_GUI = 1,
+        /// One ParticleInstance per particle, expanded to a quad by the vertex shader when drawing instanced
+        PARTICLE_GO_INSTANCE = 2,
+    };
+
+    /**
+     * How looping emitters that were not rendered since the previous update are simulated.
+     * An emitter counts as rendered when its vertex data is generated, so this requires the client to
+     * cull the emitters, e.g. against the bounds in EmitterRenderData.
+     */
+    enum OffscreenUpdate
+    {
+        /// Simulate every update
+        OFFSCREEN_UPDATE_ALWAYS = 0,
+        /// Simulate a few times per second, with the accumulated time step
+        OFFSCREEN_UPDATE_REDUCED = 1,
+        /// Don't simulate, fast forward when rendered again
+        OFFSCREEN_UPDATE_PAUSE = 2,
     };
 
     struct EmitterRenderData
@@ -149,6 +169,9 @@ namespace dmParticle
         uint32_t                    m_EmitterIndex;
         uint32_t                    m_MixedHash;
         uint32_t                    m_MixedHashNoMaterial;
+        /// Conservative world space bounds of the particles, updated when the emitter is simulated
+        Point3                      m_AabbMin;
+        Point3                      m_AabbMax;
     };
 
     /**
@@ -232,6 +255,27 @@ namespace dmParticle
         // Offset 36
     };
 
+    /**
+     * Per particle data of the PARTICLE_GO_INSTANCE format.
+     * The vertex shader calculates the world position of a quad corner (x and y in [-1, 1]) as
+     *     m_Position + m_AxisX * x + m_AxisY * y
+     * The texture coordinates are stored in the corner order (-1,-1), (-1,1), (1,1), (1,-1), with flipping already applied.
+     */
+    struct ParticleInstance
+    {
+        // Offset 0
+        float    m_Position[3];
+        // Offset 12
+        float    m_AxisX[3];
+        // Offset 24
+        float    m_AxisY[3];
+        // Offset 36
+        float    m_Color[4];
+        // Offset 52
+        float    m_UV[4][2];
+        // Offset 84
+    };
+
     // For tests
     Vector3 GetPosition(HParticleContext context, HInstance instance);
 
@@ -266,6 +310,21 @@ namespace dmParticle
      */
     DM_PARTICLE_PROTO(void, SetContextMaxParticleCount, HParticleContext context, uint32_t max_particle_count);
 
+    /**
+     * Set the job context used to simulate emitters and generate their vertex data in parallel.
+     * Emitter state callbacks and animation fetching are still called from the thread calling Update().
+     * @param context Context to update.
+     * @param job_context Job context, or 0 to update all emitters on the calling thread
+     */
+    void SetJobContext(HParticleContext context, dmJob::HContext job_context);
+
+    /**
+     * Set how looping emitters are simulated while they are not rendered.
+     * @param context Context to update.
+     * @param mode Update mode, OFFSCREEN_UPDATE_ALWAYS by default
+     */
+    void SetOffscreenUpdate(HParticleContext context, OffscreenUpdate mode);
+
     /**
      * Create an instance from the supplied path and fetch resources using the supplied factory.
      * @param context Context in which to create the instance, must be valid.
@@ -380,6 +439,21 @@ namespace dmParticle
      */
     DM_PARTICLE_PROTO(void, GenerateVertexData, HParticleContext context, float dt, HInstance instance, uint32_t emitter_index, const Vector4& color, void* vertex_buffer, uint32_t vertex_buffer_size, uint32_t* out_vertex_buffer_size, ParticleVertexFormat vertex_format);
 
+    /**
+     * Generates vertex data for a batch of emitters, in the same order as calling GenerateVertexData() for each emitter.
+     * Every emitter is given its own range of the vertex buffer up front, which lets the emitters be written in
+     * parallel when the context has a job context, see SetJobContext().
+     * @param context Particle context
+     * @param dt Time step.
+     * @param emitters Render data of the emitters to generate vertex data for
+     * @param emitter_count Number of emitters
+     * @param vertex_buffer Vertex buffer into which to store the particle vertex data. If this is 0x0, no data will be generated.
+     * @param vertex_buffer_size Size in bytes of the supplied vertex buffer.
+     * @param out_vertex_buffer_size Size in bytes of the total data written to vertex buffer.
+     * @param vertex_format Which vertex format to use
+     */
+    void GenerateVertexDataBatch(HParticleContext context, float dt, const EmitterRenderData* const* emitters, uint32_t emitter_count, const Vector4& color, void* vertex_buffer, uint32_t vertex_buffer_size, uint32_t* out_vertex_buffer_size, ParticleVertexFormat vertex_format);
+
     /**
      * Debug render the status of the instances within the specified context.
      * @param context Context of the instances to render.
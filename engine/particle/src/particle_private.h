@@ -16,6 +16,7 @@
 
 #include <dlib/configfile.h>
 #include <dlib/index_pool.h>
+#include <dlib/job.h>
 #include <dlib/transform.h>
 
 #include "particle/particle_ddf.h"
@@ -147,6 +148,10 @@ namespace dmParticle
         uint16_t                m_Retiring : 1;
         /// If this emitter needs to be rehashed
         uint16_t                m_ReHash : 1;
+        /// If the vertex data of this emitter has been generated since the last update
+        uint16_t                m_Rendered : 1;
+        /// Time the emitter has not been simulated while off-screen, see OffscreenUpdate
+        float                   m_OffscreenTime;
     };
 
     struct Instance
@@ -181,6 +186,96 @@ namespace dmParticle
         uint16_t                m_ScaleAlongZ : 1;
     };
 
+    /**
+     * Streams of ParticleStreams, each holding one float per particle.
+     */
+    enum ParticleStream
+    {
+        PARTICLE_STREAM_POSITION_X,
+        PARTICLE_STREAM_POSITION_Y,
+        PARTICLE_STREAM_POSITION_Z,
+        PARTICLE_STREAM_VELOCITY_X,
+        PARTICLE_STREAM_VELOCITY_Y,
+        PARTICLE_STREAM_VELOCITY_Z,
+        PARTICLE_STREAM_SPREAD_FACTOR,
+        /// Relative life time [0,1] used when sampling the particle properties
+        PARTICLE_STREAM_LIFE_T,
+        PARTICLE_STREAM_SCALE,
+        PARTICLE_STREAM_RED,
+        PARTICLE_STREAM_GREEN,
+        PARTICLE_STREAM_BLUE,
+        PARTICLE_STREAM_ALPHA,
+        PARTICLE_STREAM_STRETCH_FACTOR_X,
+        PARTICLE_STREAM_STRETCH_FACTOR_Y,
+        PARTICLE_STREAM_COUNT
+    };
+
+    /**
+     * Particle state in structure-of-arrays layout, used as scratch memory when simulating an emitter.
+     * The state needed by the simulation is gathered from the particles into the streams, the property
+     * sampling, modifiers and integration run over the streams and the result is scattered back.
+     * Particles are kept as an array of structs for spawning, sorting and rendering.
+     */
+    struct ParticleStreams
+    {
+        ParticleStreams()
+        : m_Stride(0)
+        {
+        }
+
+        inline float* Get(ParticleStream stream)
+        {
+            return m_Data.Begin() + stream * m_Stride;
+        }
+
+        /// All streams in one allocation, m_Stride floats apart
+        dmArray<float>      m_Data;
+        /// Property segment index per particle, derived from PARTICLE_STREAM_LIFE_T
+        dmArray<uint32_t>   m_Segments;
+        /// Sort keys of the emitter being sorted and the radix sort ping-pong buffer, see SortParticles()
+        dmArray<uint32_t>   m_SortKeys;
+        dmArray<uint32_t>   m_SortKeysTemp;
+        /// Particles gathered in sorted order before being copied back to the emitter
+        dmArray<Particle>   m_SortParticles;
+        uint32_t            m_Stride;
+    };
+
+    /**
+     * Emitter simulated by a job, see Update()
+     */
+    struct SimulateEmitterJob
+    {
+        Instance*               m_Instance;
+        Emitter*                m_Emitter;
+        EmitterPrototype*       m_Prototype;
+        dmParticleDDF::Emitter* m_DDF;
+        float                   m_DT;
+    };
+
+    /**
+     * Emitter written by a vertex job, see GenerateVertexDataBatch()
+     */
+    struct VertexEmitterJob
+    {
+        Instance*               m_Instance;
+        Emitter*                m_Emitter;
+        dmParticleDDF::Emitter* m_DDF;
+        /// First vertex of the range reserved for the emitter
+        uint32_t                m_VertexIndex;
+    };
+
+    /**
+     * Arguments shared by the vertex jobs of a batch
+     */
+    struct VertexBatch
+    {
+        Vector4                 m_Color;
+        void*                   m_VertexBuffer;
+        uint32_t                m_VertexBufferSize;
+        float                   m_DT;
+        ParticleVertexFormat    m_Format;
+    };
+
     /**
      * Representation of a context to hold a set of emitters.
      */
@@ -190,7 +285,11 @@ namespace dmParticle
         : m_MaxParticleCount(max_particle_count)
         , m_NextVersionNumber(1)
         , m_InstanceSeeding(0)
+        , m_JobContext(0)
+        , m_StreamCount(1)
+        , m_OffscreenUpdate(OFFSCREEN_UPDATE_ALWAYS)
         {
+            m_Streams = new ParticleStreams[m_StreamCount];
             memset(&m_Stats, 0, sizeof(m_Stats));
             m_Instances.SetCapacity(max_instance_count);
             m_Instances.SetSize(max_instance_count);
@@ -203,7 +302,7 @@ namespace dmParticle
 
         ~Context()
         {
-
+            delete [] m_Streams;
         }
 
         /// Instance buffer.
@@ -218,6 +317,15 @@ namespace dmParticle
         uint16_t            m_InstanceSeeding;
         /// Stats
         Stats               m_Stats;
+        /// Job context used to update emitters in parallel, may be 0
+        dmJob::HContext     m_JobContext;
+        /// Scratch memory used when simulating emitters, one per job thread
+        ParticleStreams*    m_Streams;
+        uint32_t            m_StreamCount;
+        dmArray<SimulateEmitterJob> m_SimulateJobs;
+        OffscreenUpdate             m_OffscreenUpdate;
+        dmArray<VertexEmitterJob>   m_VertexJobs;
+        VertexBatch                 m_VertexBatch;
     };
 
     struct LinearSegment
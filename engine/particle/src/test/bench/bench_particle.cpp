@@ -0,0 +1,94 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <dlib/benchmark.h>
+#include <dlib/dstrings.h>
+#include <dlib/log.h>
+#include "../../particle.h"
+
+// Benchmarks of the particle simulation. Run with --benchmark_out=<path> to get the results as JSON.
+
+#if defined(__NX__)
+    #define MOUNTFS "host:/"
+#else
+    #define MOUNTFS ""
+#endif
+
+static const float DT = 1.0f / 60.0f;
+// Each instance of bench.particlefx keeps 1000 particles alive
+static const uint32_t PARTICLES_PER_INSTANCE = 1000;
+
+static dmParticle::HPrototype LoadPrototype(const char* filename)
+{
+    char path[128];
+    dmSnPrintf(path, sizeof(path), MOUNTFS "build/default/src/test/bench/%s", filename);
+    const uint32_t MAX_FILE_SIZE = 4 * 1024;
+    unsigned char buffer[MAX_FILE_SIZE];
+
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        dmLogError("Particle FX could not be loaded: %s.", path);
+        return 0;
+    }
+    uint32_t file_size = fread(buffer, 1, MAX_FILE_SIZE, f);
+    fclose(f);
+    return dmParticle::NewPrototype(buffer, file_size);
+}
+
+static void BenchUpdate(void* context, uint32_t iterations)
+{
+    dmParticle::HParticleContext particle_context = (dmParticle::HParticleContext)context;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        dmParticle::Update(particle_context, DT, 0x0);
+    }
+}
+
+static void RunUpdate(dmParticle::HPrototype prototype, uint32_t instance_count)
+{
+    dmParticle::HParticleContext context = dmParticle::CreateContext(instance_count, instance_count * PARTICLES_PER_INSTANCE);
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        dmParticle::HInstance instance = dmParticle::CreateInstance(context, prototype, 0x0);
+        dmParticle::SetPosition(context, instance, Vectormath::Aos::Point3((float)i, 0.0f, 0.0f));
+        dmParticle::StartInstance(context, instance);
+    }
+    // Simulate until the emitters are saturated
+    for (uint32_t i = 0; i < 180; ++i)
+    {
+        dmParticle::Update(context, DT, 0x0);
+    }
+
+    char name[64];
+    dmSnPrintf(name, sizeof(name), "ParticleUpdate/%u", instance_count * PARTICLES_PER_INSTANCE);
+    dmBenchmark::Run(name, BenchUpdate, context, instance_count * PARTICLES_PER_INSTANCE);
+
+    dmParticle::DestroyContext(context);
+}
+
+int main(int argc, char **argv)
+{
+    dmBenchmark::Init(argc, argv);
+
+    dmParticle::HPrototype prototype = LoadPrototype("bench.particlefxc");
+    if (!prototype)
+        return 1;
+
+    RunUpdate(prototype, 1);
+    RunUpdate(prototype, 10);
+    RunUpdate(prototype, 50);
+
+    dmParticle::Particle_DeletePrototype(prototype);
+    return dmBenchmark::Finalize();
+}
@@ -256,6 +256,7 @@ void EmitterStateChangedCallback(uint32_t num_awake_emitters, dmhash_t emitter_i
 TEST_F(ParticleTest, VertexBufferSize)
 {
     ASSERT_EQ(6 * sizeof(dmParticle::Vertex), dmParticle::GetVertexBufferSize(1, dmParticle::PARTICLE_GO));
+    ASSERT_EQ(sizeof(dmParticle::ParticleInstance), dmParticle::GetVertexBufferSize(1, dmParticle::PARTICLE_GO_INSTANCE));
 }
 
 /**
@@ -586,6 +587,44 @@ TEST_F(ParticleTest, Loop)
     dmParticle::DestroyInstance(m_Context, instance);
 }
 
+/**
+ * Verify that looping emitters are paused while not rendered, and catch up when rendered again
+ */
+TEST_F(ParticleTest, OffscreenPause)
+{
+    float dt = 1.0f;
+
+    ASSERT_TRUE(LoadPrototype("loop.particlefxc", &m_Prototype));
+    dmParticle::SetOffscreenUpdate(m_Context, dmParticle::OFFSCREEN_UPDATE_PAUSE);
+    dmParticle::HInstance instance = dmParticle::CreateInstance(m_Context, m_Prototype, 0x0);
+    dmParticle::Emitter* e = GetEmitter(m_Context, instance, 0);
+
+    dmParticle::StartInstance(m_Context, instance);
+
+    dmParticle::Update(m_Context, dt, 0x0);
+    ASSERT_EQ(0u, ParticleCount(e));
+    dmParticle::Update(m_Context, dt, 0x0);
+    ASSERT_EQ(0u, ParticleCount(e));
+
+    uint32_t out_vertex_buffer_size = 0;
+    dmParticle::GenerateVertexData(m_Context, dt, instance, 0, Vector4(1,1,1,1), (void*)m_VertexBuffer, m_VertexBufferSize, &out_vertex_buffer_size, dmParticle::PARTICLE_GO);
+    dmParticle::Update(m_Context, dt, 0x0);
+    ASSERT_EQ(1u, ParticleCount(e));
+
+    // The bounds contain the particle
+    dmParticle::EmitterRenderData* render_data;
+    dmParticle::GetEmitterRenderData(m_Context, instance, 0, &render_data);
+    Point3 p = e->m_Particles[0].GetPosition();
+    ASSERT_LE(render_data->m_AabbMin.getX(), p.getX());
+    ASSERT_LE(render_data->m_AabbMin.getY(), p.getY());
+    ASSERT_LE(render_data->m_AabbMin.getZ(), p.getZ());
+    ASSERT_GE(render_data->m_AabbMax.getX(), p.getX());
+    ASSERT_GE(render_data->m_AabbMax.getY(), p.getY());
+    ASSERT_GE(render_data->m_AabbMax.getZ(), p.getZ());
+
+    dmParticle::DestroyInstance(m_Context, instance);
+}
+
 /**
  * Verify loop emitters respect delay
  */
@@ -1508,6 +1547,47 @@ TEST_F(ParticleTest, StableSort)
     dmParticle::DestroyInstance(m_Context, instance);
 }
 
+/**
+ * Verify that emitters with order independent blending are not sorted
+ */
+TEST_F(ParticleTest, UnsortedAdditive)
+{
+    float dt = 1.0f / 60.0f;
+
+    ASSERT_TRUE(LoadPrototype("sort_add.particlefxc", &m_Prototype));
+    dmParticle::HInstance instance = dmParticle::CreateInstance(m_Context, m_Prototype, 0x0);
+    uint16_t index = instance & 0xffff;
+
+    dmParticle::Instance* i = m_Context->m_Instances[index];
+
+    dmParticle::StartInstance(m_Context, instance);
+
+    dmParticle::Update(m_Context, dt, 0x0);
+
+    const uint32_t particle_count = 20;
+    ASSERT_EQ(particle_count, i->m_Emitters[0].m_Particles.Size());
+
+    dmParticle::Particle* p = &i->m_Emitters[0].m_Particles[0];
+    for (uint32_t pi = 0; pi < particle_count; ++pi)
+    {
+        Point3 pos = p[pi].GetPosition();
+        pos.setX((float)pi);
+        p[pi].SetPosition(pos);
+    }
+    // Would move the first half last if sorted
+    for (uint32_t d = 0; d < particle_count / 2; ++d)
+    {
+        p[d].SetTimeLeft(p[d].GetTimeLeft() - dt);
+    }
+    dmParticle::Update(m_Context, dt, 0x0);
+    for (uint32_t pi = 0; pi < particle_count; ++pi)
+    {
+        ASSERT_EQ((float)pi, p[pi].GetPosition().getX());
+    }
+
+    dmParticle::DestroyInstance(m_Context, instance);
+}
+
 TEST_F(ParticleTest, ReloadPrototype)
 {
     ASSERT_TRUE(LoadPrototype("reload1.particlefxc", &m_Prototype));
@@ -2092,6 +2172,125 @@ TEST_F(ParticleTest, Stats)
     dmParticle::DestroyInstance(m_Context, instance);
 }
 
+/**
+ * Verify that emitters simulated and written by jobs generate the same vertex data as when generated one by one,
+ * also when the vertex buffer can't hold all the particles
+ */
+TEST_F(ParticleTest, JobContext)
+{
+    const uint32_t instance_count = 8;
+    const uint32_t emitter_count = 3;
+    const uint32_t max_particle_count = 20;
+    float dt = 1.0f / 60.0f;
+
+    dmJob::NewContextParams job_params;
+    job_params.m_WorkerCount = 4;
+    job_params.m_MaxJobs = 64;
+    job_params.m_QueueCapacity = 64;
+    dmJob::HContext job_context = dmJob::NewContext(job_params);
+    ASSERT_NE((dmJob::HContext) 0, job_context);
+    dmParticle::SetJobContext(m_Context, job_context);
+    ASSERT_EQ(5U, m_Context->m_StreamCount);
+
+    ASSERT_TRUE(LoadPrototype("once_three_emitters.particlefxc", &m_Prototype));
+    dmParticle::HInstance instances[instance_count];
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        instances[i] = dmParticle::CreateInstance(m_Context, m_Prototype, 0x0);
+        dmParticle::StartInstance(m_Context, instances[i]);
+    }
+    dmParticle::Update(m_Context, dt, 0x0);
+    dmParticle::Update(m_Context, dt, 0x0);
+
+    const dmParticle::EmitterRenderData* emitters[instance_count * emitter_count];
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        for (uint32_t e = 0; e < emitter_count; ++e)
+        {
+            dmParticle::EmitterRenderData* render_data;
+            dmParticle::GetEmitterRenderData(m_Context, instances[i], e, &render_data);
+            ASSERT_EQ(1U, ParticleCount(GetEmitter(m_Context, instances[i], e)));
+            emitters[i * emitter_count + e] = render_data;
+        }
+    }
+
+    uint32_t vertex_buffer_size = dmParticle::GetVertexBufferSize(max_particle_count, dmParticle::PARTICLE_GO);
+    dmParticle::Vertex expected[6 * max_particle_count];
+    dmParticle::Vertex actual[6 * max_particle_count];
+    memset(expected, 0, sizeof(expected));
+    memset(actual, 0, sizeof(actual));
+
+    uint32_t expected_size = 0;
+    for (uint32_t i = 0; i < instance_count * emitter_count; ++i)
+    {
+        dmParticle::GenerateVertexData(m_Context, dt, emitters[i]->m_Instance, emitters[i]->m_EmitterIndex, Vector4(1,1,1,1), (void*)expected, vertex_buffer_size, &expected_size, dmParticle::PARTICLE_GO);
+    }
+    uint32_t actual_size = 0;
+    dmParticle::GenerateVertexDataBatch(m_Context, dt, emitters, instance_count * emitter_count, Vector4(1,1,1,1), (void*)actual, vertex_buffer_size, &actual_size, dmParticle::PARTICLE_GO);
+
+    ASSERT_EQ(vertex_buffer_size, expected_size);
+    ASSERT_EQ(expected_size, actual_size);
+    ASSERT_EQ(0, memcmp(expected, actual, actual_size));
+
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        dmParticle::DestroyInstance(m_Context, instances[i]);
+    }
+    dmParticle::SetJobContext(m_Context, 0);
+    dmJob::DeleteContext(job_context);
+}
+
+/**
+ * Verify that the instance data describes the same quads as the vertex data
+ */
+TEST_F(ParticleTest, InstanceData)
+{
+    const uint32_t emitter_count = 3;
+    float dt = 1.0f / 60.0f;
+
+    ASSERT_TRUE(LoadPrototype("once_three_emitters.particlefxc", &m_Prototype));
+    dmParticle::HInstance instance = dmParticle::CreateInstance(m_Context, m_Prototype, 0x0);
+    dmParticle::StartInstance(m_Context, instance);
+    dmParticle::Update(m_Context, dt, 0x0);
+    dmParticle::Update(m_Context, dt, 0x0);
+
+    dmParticle::Vertex vertices[6 * emitter_count];
+    dmParticle::ParticleInstance instances[emitter_count];
+    uint32_t vertex_buffer_size = 0;
+    uint32_t instance_buffer_size = 0;
+    for (uint32_t e = 0; e < emitter_count; ++e)
+    {
+        dmParticle::GenerateVertexData(m_Context, dt, instance, e, Vector4(1,1,1,1), (void*)vertices, sizeof(vertices), &vertex_buffer_size, dmParticle::PARTICLE_GO);
+        dmParticle::GenerateVertexData(m_Context, dt, instance, e, Vector4(1,1,1,1), (void*)instances, sizeof(instances), &instance_buffer_size, dmParticle::PARTICLE_GO_INSTANCE);
+    }
+    ASSERT_EQ(sizeof(vertices), vertex_buffer_size);
+    ASSERT_EQ(sizeof(instances), instance_buffer_size);
+
+    for (uint32_t e = 0; e < emitter_count; ++e)
+    {
+        const dmParticle::Vertex* v = &vertices[e * 6];
+        const dmParticle::ParticleInstance& inst = instances[e];
+        // The corners (-1,-1), (-1,1), (1,1) and (1,-1) are the vertices 0, 1, 2 and 4
+        const dmParticle::Vertex* corners[4] = { &v[0], &v[1], &v[2], &v[4] };
+        const float corner_x[4] = { -1.0f, -1.0f, 1.0f, 1.0f };
+        const float corner_y[4] = { -1.0f, 1.0f, 1.0f, -1.0f };
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            ASSERT_NEAR(corners[c]->m_X, inst.m_Position[0] + inst.m_AxisX[0] * corner_x[c] + inst.m_AxisY[0] * corner_y[c], 0.0001f);
+            ASSERT_NEAR(corners[c]->m_Y, inst.m_Position[1] + inst.m_AxisX[1] * corner_x[c] + inst.m_AxisY[1] * corner_y[c], 0.0001f);
+            ASSERT_NEAR(corners[c]->m_Z, inst.m_Position[2] + inst.m_AxisX[2] * corner_x[c] + inst.m_AxisY[2] * corner_y[c], 0.0001f);
+            ASSERT_EQ(corners[c]->m_U, inst.m_UV[c][0]);
+            ASSERT_EQ(corners[c]->m_V, inst.m_UV[c][1]);
+        }
+        ASSERT_EQ(v[0].m_Red, inst.m_Color[0]);
+        ASSERT_EQ(v[0].m_Green, inst.m_Color[1]);
+        ASSERT_EQ(v[0].m_Blue, inst.m_Color[2]);
+        ASSERT_EQ(v[0].m_Alpha, inst.m_Color[3]);
+    }
+
+    dmParticle::DestroyInstance(m_Context, instance);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -384,16 +384,23 @@ void b2GridShape::SetCellHull(b2Body* body, uint32 row, uint32 column, uint32 hu
 
     uint32 index = row * m_columnCount + column;
     b2Assert(index < m_rowCount * m_columnCount);
-    b2GridShape::Cell* cell = &m_cells[index];
-    cell->m_Index = hull;
-    m_cellFlags[index] = flags;
     // treat cells with an empty hull as an empty cell
     if (hull != B2GRIDSHAPE_EMPTY_CELL)
     {
         b2HullSet::Hull& h = m_hullSet->m_hulls[hull];
         if (h.m_Count == 0)
-            cell->m_Index = B2GRIDSHAPE_EMPTY_CELL;
+            hull = B2GRIDSHAPE_EMPTY_CELL;
+    }
+
+    b2GridShape::Cell* cell = &m_cells[index];
+    b2GridShape::CellFlags old_flags = m_cellFlags[index];
+    if (cell->m_Index == hull && old_flags.m_FlipHorizontal == flags.m_FlipHorizontal && old_flags.m_FlipVertical == flags.m_FlipVertical)
+    {
+        // Unchanged, leave the broad-phase alone
+        return;
     }
+    cell->m_Index = hull;
+    m_cellFlags[index] = flags;
 
     body->SynchronizeSingle(this, index);
 }
@@ -63,6 +63,11 @@ struct b2ContactSolverDef
 	b2Position* positions;
 	b2Velocity* velocities;
 	b2StackAllocator* allocator;
+	// Defold modification
+	// Optional island indices of the two bodies of each contact, stored as pairs.
+	// Used when islands are solved in parallel, where the m_islandIndex of a static
+	// body shared by several islands can't be trusted. NULL to use m_islandIndex.
+	const int32* indices;
 };
 
 class b2ContactSolver
@@ -449,6 +449,34 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 	m_world->m_contactManager.FindNewContacts();
 }
 
+// Defold modification
+void b2Body::SetTransformDeferred(const b2Vec2& position, float32 angle)
+{
+	b2Assert(m_world->IsLocked() == false);
+	if (m_world->IsLocked() == true)
+	{
+		return;
+	}
+
+	m_xf.q.Set(angle);
+	m_xf.p = position;
+
+	m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	m_sweep.a = angle;
+
+	m_sweep.c0 = m_sweep.c;
+	m_sweep.a0 = angle;
+
+	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+	{
+		f->Synchronize(broadPhase, m_xf, m_xf);
+	}
+
+	// The moved proxies are buffered by the broad-phase, and paired at the start of the next step
+	m_world->m_flags |= b2World::e_newFixture;
+}
+
 void b2Body::SynchronizeFixtures()
 {
 	b2Transform xf1;
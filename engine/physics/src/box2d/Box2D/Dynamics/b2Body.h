@@ -164,6 +164,11 @@ public:
 	/// @param angle the world rotation in radians.
 	void SetTransform(const b2Vec2& position, float32 angle);
 
+	/// Defold modification
+	/// Same as SetTransform, but the new contacts are found in the next step. Moving many bodies
+	/// this way costs a single broad-phase update instead of one per body.
+	void SetTransformDeferred(const b2Vec2& position, float32 angle);
+
 	/// Get the body transform for the body's origin.
 	/// @return the world transform of the body's origin.
 	const b2Transform& GetTransform() const;
@@ -387,6 +392,10 @@ public:
     /// Get the total force
     const b2Vec2& GetForce() const;
 
+    /// Has the body been moved by the last step, i.e. was it solved in an island.
+    /// Sleeping bodies and bodies that were not touched by the step did not move.
+    bool HasMoved() const;
+
 private:
 
 	friend class b2World;
@@ -407,6 +416,8 @@ private:
 	friend class b2RopeJoint;
 
     friend class b2GridShape;
+    // Defold modification
+    friend class b2Fixture;
 
 	// m_flags
 	enum
@@ -417,7 +428,11 @@ private:
 		e_bulletFlag		= 0x0008,
 		e_fixedRotationFlag	= 0x0010,
 		e_activeFlag		= 0x0020,
-		e_toiFlag			= 0x0040
+		e_toiFlag			= 0x0040,
+		// Defold modification
+		e_movedFlag			= 0x0080,
+		// Defold modification. Contacts of the grid fixtures need filtering, see b2Fixture::SetFilterData
+		e_refilterFlag		= 0x0100
 	};
 
 	b2Body(const b2BodyDef* bd, b2World* world);
@@ -863,4 +878,9 @@ inline const b2Vec2& b2Body::GetForce() const
     return m_force;
 }
 
+inline bool b2Body::HasMoved() const
+{
+    return (m_flags & e_movedFlag) == e_movedFlag;
+}
+
 #endif
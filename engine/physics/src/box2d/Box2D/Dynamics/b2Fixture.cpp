@@ -198,11 +198,18 @@ void b2Fixture::SynchronizeSingle(b2BroadPhase* broadPhase, int32 index, const b
 
     b2FixtureProxy* proxy = m_proxies + index;
 
-    b2AABB aabb1, aabb2;
-    m_shape->ComputeAABB(&aabb1, transform1, proxy->childIndex);
-    m_shape->ComputeAABB(&aabb2, transform2, proxy->childIndex);
-
-    proxy->aabb.Combine(aabb1, aabb2);
+    // Defold modification. Grid cells of static bodies are changed without the body moving
+    if (transform1.p == transform2.p && transform1.q.s == transform2.q.s && transform1.q.c == transform2.q.c)
+    {
+        m_shape->ComputeAABB(&proxy->aabb, transform2, proxy->childIndex);
+    }
+    else
+    {
+        b2AABB aabb1, aabb2;
+        m_shape->ComputeAABB(&aabb1, transform1, proxy->childIndex);
+        m_shape->ComputeAABB(&aabb2, transform2, proxy->childIndex);
+        proxy->aabb.Combine(aabb1, aabb2);
+    }
 
     b2Vec2 displacement = transform2.p - transform1.p;
 
@@ -218,9 +225,15 @@ void b2Fixture::SetFilterData(const b2Filter& filter, int32 index)
     // we skip updating the proxy list since that will
     // potentially expand the movement buffer.
     // Instead, we just flag the entire body for
-    // filtering, which is what the argument passed into
-    // the function is for.
-    Refilter(GetType() != b2Shape::e_grid);
+    // filtering, which is deferred to the next step
+    // so that many cells can be changed at once.
+    if (GetType() == b2Shape::e_grid && m_body != NULL)
+    {
+        m_body->m_flags |= b2Body::e_refilterFlag;
+        m_body->GetWorld()->m_flags |= b2World::e_refilter;
+        return;
+    }
+    Refilter(true);
 }
 
 void b2Fixture::Refilter(bool touchProxies)
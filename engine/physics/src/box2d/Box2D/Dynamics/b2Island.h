@@ -28,6 +28,7 @@ class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
 struct b2ContactVelocityConstraint;
+struct b2ContactImpulse;
 struct b2Profile;
 
 /// This is an internal class.
@@ -36,6 +37,16 @@ class b2Island
 public:
 	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
 			b2StackAllocator* allocator, b2ContactListener* listener);
+
+	/// Defold modification
+	/// Create an island that solves a slice of already built body, contact and joint arrays.
+	/// The island does not own the arrays and never writes m_islandIndex, which makes it
+	/// possible to solve several islands sharing static bodies at the same time.
+	b2Island(b2Body** bodies, int32 bodyCount,
+			b2Contact** contacts, const int32* contactIndices, int32 contactCount,
+			b2Joint** joints, int32 jointCount,
+			b2Position* positions, b2Velocity* velocities,
+			b2StackAllocator* allocator, b2ContactImpulse* impulses);
 	~b2Island();
 
 	void Clear()
@@ -88,6 +99,14 @@ public:
 	int32 m_bodyCapacity;
 	int32 m_contactCapacity;
 	int32 m_jointCapacity;
+
+	// Defold modification
+	// Set for islands created from array slices, see the constructor above.
+	// m_contactIndices holds the island indices of the bodies of each contact and the
+	// contact impulses are written to m_impulses instead of being reported to a listener.
+	const int32* m_contactIndices;
+	b2ContactImpulse* m_impulses;
+	bool m_ownsArrays;
 };
 
 #endif
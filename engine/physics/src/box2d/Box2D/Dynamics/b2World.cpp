@@ -62,6 +62,9 @@ b2World::b2World(const b2Vec2& gravity)
 	m_contactManager.m_allocator = &m_blockAllocator;
 
 	memset(&m_profile, 0, sizeof(b2Profile));
+
+	m_parallelFor = NULL;
+	m_parallelForUserData = NULL;
 }
 
 b2World::~b2World()
@@ -100,6 +103,12 @@ void b2World::SetContactListener(b2ContactListener* listener)
 	m_contactManager.m_contactListener = listener;
 }
 
+void b2World::SetParallelFor(b2ParallelForCallback callback, void* userData)
+{
+	m_parallelFor = callback;
+	m_parallelForUserData = userData;
+}
+
 void b2World::SetDebugDraw(b2Draw* debugDraw)
 {
 	m_debugDraw = debugDraw;
@@ -384,12 +393,108 @@ void b2World::SetAllowSleeping(bool flag)
 }
 
 // Find islands, integrate and solve constraints, solve position constraints
-void b2World::Solve(const b2TimeStep& step)
+// Defold modification
+// Depth first search on the constraint graph, adding the bodies, contacts and joints
+// connected to the seed to the island.
+void b2World::BuildIsland(b2Island* island, b2Body* seed, b2Body** stack, int32 stackSize)
 {
-	m_profile.solveInit = 0.0f;
-	m_profile.solveVelocity = 0.0f;
-	m_profile.solvePosition = 0.0f;
+	int32 stackCount = 0;
+	stack[stackCount++] = seed;
+	seed->m_flags |= b2Body::e_islandFlag;
+
+	// Perform a depth first search (DFS) on the constraint graph.
+	while (stackCount > 0)
+	{
+		// Grab the next body off the stack and add it to the island.
+		b2Body* b = stack[--stackCount];
+		b2Assert(b->IsActive() == true);
+		island->Add(b);
+
+		// Make sure the body is awake.
+		b->SetAwake(true);
+
+		// To keep islands as small as possible, we don't
+		// propagate islands across static bodies.
+		if (b->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		// Search all contacts connected to this body.
+		for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+		{
+			b2Contact* contact = ce->contact;
+
+			// Has this contact already been added to an island?
+			if (contact->m_flags & b2Contact::e_islandFlag)
+			{
+				continue;
+			}
+
+			// Is this contact solid and touching?
+			if (contact->IsEnabled() == false ||
+				contact->IsTouching() == false)
+			{
+				continue;
+			}
+
+			// Skip sensors.
+			bool sensorA = contact->m_fixtureA->m_isSensor;
+			bool sensorB = contact->m_fixtureB->m_isSensor;
+			if (sensorA || sensorB)
+			{
+				continue;
+			}
 
+			island->Add(contact);
+			contact->m_flags |= b2Contact::e_islandFlag;
+
+			b2Body* other = ce->other;
+
+			// Was the other body already added to this island?
+			if (other->m_flags & b2Body::e_islandFlag)
+			{
+				continue;
+			}
+
+			b2Assert(stackCount < stackSize);
+			stack[stackCount++] = other;
+			other->m_flags |= b2Body::e_islandFlag;
+		}
+
+		// Search all joints connect to this body.
+		for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+		{
+			if (je->joint->m_islandFlag == true)
+			{
+				continue;
+			}
+
+			b2Body* other = je->other;
+
+			// Don't simulate joints connected to inactive bodies.
+			if (other->IsActive() == false)
+			{
+				continue;
+			}
+
+			island->Add(je->joint);
+			je->joint->m_islandFlag = true;
+
+			if (other->m_flags & b2Body::e_islandFlag)
+			{
+				continue;
+			}
+
+			b2Assert(stackCount < stackSize);
+			stack[stackCount++] = other;
+			other->m_flags |= b2Body::e_islandFlag;
+		}
+	}
+}
+
+void b2World::SolveIslands(const b2TimeStep& step)
+{
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
 					m_contactManager.m_contactCount,
@@ -397,20 +502,6 @@ void b2World::Solve(const b2TimeStep& step)
 					&m_stackAllocator,
 					m_contactManager.m_contactListener);
 
-	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
-	{
-		b->m_flags &= ~b2Body::e_islandFlag;
-	}
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
-	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
-	}
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
-	{
-		j->m_islandFlag = false;
-	}
-
 	// Build and simulate all awake islands.
 	int32 stackSize = m_bodyCount;
 	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
@@ -434,110 +525,157 @@ void b2World::Solve(const b2TimeStep& step)
 
 		// Reset island and stack.
 		island.Clear();
-		int32 stackCount = 0;
-		stack[stackCount++] = seed;
-		seed->m_flags |= b2Body::e_islandFlag;
+		BuildIsland(&island, seed, stack, stackSize);
 
-		// Perform a depth first search (DFS) on the constraint graph.
-		while (stackCount > 0)
-		{
-			// Grab the next body off the stack and add it to the island.
-			b2Body* b = stack[--stackCount];
-			b2Assert(b->IsActive() == true);
-			island.Add(b);
-
-			// Make sure the body is awake.
-			b->SetAwake(true);
+		b2Profile profile;
+		island.Solve(&profile, step, m_gravity, m_allowSleep);
+		m_profile.solveInit += profile.solveInit;
+		m_profile.solveVelocity += profile.solveVelocity;
+		m_profile.solvePosition += profile.solvePosition;
 
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
+		// Post solve cleanup.
+		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		{
+			// Allow static bodies to participate in other islands.
+			b2Body* b = island.m_bodies[i];
 			if (b->GetType() == b2_staticBody)
 			{
-				continue;
+				b->m_flags &= ~b2Body::e_islandFlag;
 			}
+		}
+	}
 
-			// Search all contacts connected to this body.
-			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
-			{
-				b2Contact* contact = ce->contact;
+	m_stackAllocator.Free(stack);
+}
 
-				// Has this contact already been added to an island?
-				if (contact->m_flags & b2Contact::e_islandFlag)
-				{
-					continue;
-				}
+// Defold modification
+// One island stored as a slice of the arrays of a larger island holding all islands of the step
+struct b2IslandSlice
+{
+	int32 bodyStart;
+	int32 bodyCount;
+	int32 contactStart;
+	int32 contactCount;
+	int32 jointStart;
+	int32 jointCount;
+	b2Profile profile;
+};
 
-				// Is this contact solid and touching?
-				if (contact->IsEnabled() == false ||
-					contact->IsTouching() == false)
-				{
-					continue;
-				}
+struct b2ParallelIslands
+{
+	b2Island* island;
+	b2IslandSlice* slices;
+	const int32* parallelSlices;
+	const int32* contactIndices;
+	b2ContactImpulse* impulses;
+	const b2TimeStep* step;
+	b2Vec2 gravity;
+	bool allowSleep;
+};
 
-				// Skip sensors.
-				bool sensorA = contact->m_fixtureA->m_isSensor;
-				bool sensorB = contact->m_fixtureB->m_isSensor;
-				if (sensorA || sensorB)
-				{
-					continue;
-				}
+static void SolveIslandSlice(const b2ParallelIslands* islands, b2IslandSlice* slice, b2StackAllocator* allocator)
+{
+	b2Island* all = islands->island;
+	b2Island island(all->m_bodies + slice->bodyStart, slice->bodyCount,
+					all->m_contacts + slice->contactStart, islands->contactIndices + 2 * slice->contactStart, slice->contactCount,
+					all->m_joints + slice->jointStart, slice->jointCount,
+					all->m_positions + slice->bodyStart, all->m_velocities + slice->bodyStart,
+					allocator, islands->impulses + slice->contactStart);
+	island.Solve(&slice->profile, *islands->step, islands->gravity, islands->allowSleep);
+}
 
-				island.Add(contact);
-				contact->m_flags |= b2Contact::e_islandFlag;
+static void SolveIslandsTask(void* taskData, int32 start, int32 end)
+{
+	const b2ParallelIslands* islands = (const b2ParallelIslands*)taskData;
 
-				b2Body* other = ce->other;
+	// The stack allocator of the world isn't thread safe, each task gets its own
+	void* mem = b2Alloc(sizeof(b2StackAllocator));
+	b2StackAllocator* allocator = new (mem) b2StackAllocator();
 
-				// Was the other body already added to this island?
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+	for (int32 i = start; i < end; ++i)
+	{
+		SolveIslandSlice(islands, islands->slices + islands->parallelSlices[i], allocator);
+	}
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
+	allocator->~b2StackAllocator();
+	b2Free(mem);
+}
 
-			// Search all joints connect to this body.
-			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
-			{
-				if (je->joint->m_islandFlag == true)
-				{
-					continue;
-				}
+// Defold modification
+// All islands are first built serially into one large island, in the same order as SolveIslands.
+// The islands without joints are then solved through the parallel for callback. Joints read
+// m_islandIndex, which is overwritten for static bodies shared by several islands, so islands
+// with joints are solved afterwards on this thread. Finally the contact impulses are reported
+// in island order, which gives the same callbacks in the same order as SolveIslands.
+void b2World::SolveIslandsParallel(const b2TimeStep& step)
+{
+	int32 contactCount = m_contactManager.m_contactCount;
 
-				b2Body* other = je->other;
+	// Static bodies are added once to every island they are connected to, and every such
+	// connection is made through a contact or a joint.
+	b2Island island(m_bodyCount + contactCount + m_jointCount,
+					contactCount,
+					m_jointCount,
+					&m_stackAllocator,
+					NULL);
 
-				// Don't simulate joints connected to inactive bodies.
-				if (other->IsActive() == false)
-				{
-					continue;
-				}
+	// There is at most one island per body
+	b2IslandSlice* slices = (b2IslandSlice*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandSlice));
+	int32* parallelSlices = (int32*)m_stackAllocator.Allocate(m_bodyCount * sizeof(int32));
+	int32* contactIndices = (int32*)m_stackAllocator.Allocate(2 * contactCount * sizeof(int32));
+	b2ContactImpulse* impulses = (b2ContactImpulse*)m_stackAllocator.Allocate(contactCount * sizeof(b2ContactImpulse));
+	int32 sliceCount = 0;
+	int32 parallelCount = 0;
 
-				island.Add(je->joint);
-				je->joint->m_islandFlag = true;
+	int32 stackSize = m_bodyCount;
+	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	{
+		if (seed->m_flags & b2Body::e_islandFlag)
+		{
+			continue;
+		}
 
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+		if (seed->IsAwake() == false || seed->IsActive() == false)
+		{
+			continue;
+		}
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
+		// The seed can be dynamic or kinematic.
+		if (seed->GetType() == b2_staticBody)
+		{
+			continue;
 		}
 
-		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
-		m_profile.solveInit += profile.solveInit;
-		m_profile.solveVelocity += profile.solveVelocity;
-		m_profile.solvePosition += profile.solvePosition;
+		b2IslandSlice* slice = slices + sliceCount;
+		slice->bodyStart = island.m_bodyCount;
+		slice->contactStart = island.m_contactCount;
+		slice->jointStart = island.m_jointCount;
 
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		BuildIsland(&island, seed, stack, stackSize);
+
+		slice->bodyCount = island.m_bodyCount - slice->bodyStart;
+		slice->contactCount = island.m_contactCount - slice->contactStart;
+		slice->jointCount = island.m_jointCount - slice->jointStart;
+		memset(&slice->profile, 0, sizeof(b2Profile));
+
+		// All bodies of the contacts were added to this island, so m_islandIndex is valid until the next island is built
+		for (int32 i = slice->contactStart; i < island.m_contactCount; ++i)
+		{
+			b2Contact* contact = island.m_contacts[i];
+			contactIndices[2 * i + 0] = contact->m_fixtureA->m_body->m_islandIndex - slice->bodyStart;
+			contactIndices[2 * i + 1] = contact->m_fixtureB->m_body->m_islandIndex - slice->bodyStart;
+		}
+
+		if (slice->jointCount == 0)
+		{
+			parallelSlices[parallelCount++] = sliceCount;
+		}
+		++sliceCount;
+
+		// Allow static bodies to participate in other islands.
+		for (int32 i = slice->bodyStart; i < island.m_bodyCount; ++i)
 		{
-			// Allow static bodies to participate in other islands.
 			b2Body* b = island.m_bodies[i];
 			if (b->GetType() == b2_staticBody)
 			{
@@ -546,7 +684,108 @@ void b2World::Solve(const b2TimeStep& step)
 		}
 	}
 
+	b2ParallelIslands islands;
+	islands.island = &island;
+	islands.slices = slices;
+	islands.parallelSlices = parallelSlices;
+	islands.contactIndices = contactIndices;
+	islands.impulses = impulses;
+	islands.step = &step;
+	islands.gravity = m_gravity;
+	islands.allowSleep = m_allowSleep;
+
+	if (parallelCount > 1)
+	{
+		m_parallelFor(m_parallelForUserData, SolveIslandsTask, &islands, parallelCount);
+	}
+	else if (parallelCount == 1)
+	{
+		SolveIslandSlice(&islands, slices + parallelSlices[0], &m_stackAllocator);
+	}
+
+	for (int32 i = 0; i < sliceCount; ++i)
+	{
+		b2IslandSlice* slice = slices + i;
+		if (slice->jointCount == 0)
+		{
+			continue;
+		}
+
+		// Restore the island indices the joints use
+		for (int32 j = 0; j < slice->bodyCount; ++j)
+		{
+			island.m_bodies[slice->bodyStart + j]->m_islandIndex = j;
+		}
+		SolveIslandSlice(&islands, slice, &m_stackAllocator);
+	}
+
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+	for (int32 i = 0; i < sliceCount; ++i)
+	{
+		const b2IslandSlice* slice = slices + i;
+		m_profile.solveInit += slice->profile.solveInit;
+		m_profile.solveVelocity += slice->profile.solveVelocity;
+		m_profile.solvePosition += slice->profile.solvePosition;
+
+		if (listener)
+		{
+			for (int32 j = slice->contactStart; j < slice->contactStart + slice->contactCount; ++j)
+			{
+				listener->PostSolve(island.m_contacts[j], impulses + j);
+			}
+		}
+
+		// The islands leave static bodies untouched. When solved serially, a static body is
+		// put to sleep with the last island it belongs to, do the same here. The seed is
+		// the first body of the island and is only put to sleep with the whole island.
+		bool asleep = island.m_bodies[slice->bodyStart]->IsAwake() == false;
+		for (int32 j = slice->bodyStart; j < slice->bodyStart + slice->bodyCount; ++j)
+		{
+			b2Body* b = island.m_bodies[j];
+			if (b->GetType() == b2_staticBody)
+			{
+				b->SetAwake(!asleep);
+			}
+		}
+	}
+
 	m_stackAllocator.Free(stack);
+	m_stackAllocator.Free(impulses);
+	m_stackAllocator.Free(contactIndices);
+	m_stackAllocator.Free(parallelSlices);
+	m_stackAllocator.Free(slices);
+}
+
+void b2World::Solve(const b2TimeStep& step)
+{
+	m_profile.solveInit = 0.0f;
+	m_profile.solveVelocity = 0.0f;
+	m_profile.solvePosition = 0.0f;
+
+	// Clear all the island flags.
+	// Defold modification: also clear the moved flags, set again for the bodies solved below
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b->m_flags &= ~(b2Body::e_islandFlag | b2Body::e_movedFlag);
+	}
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		c->m_flags &= ~b2Contact::e_islandFlag;
+	}
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->m_islandFlag = false;
+	}
+
+	// Defold modification
+	if (m_parallelFor)
+	{
+		SolveIslandsParallel(step);
+	}
+	else
+	{
+		SolveIslands(step);
+	}
 
 	{
 		b2Timer timer;
@@ -564,6 +803,9 @@ void b2World::Solve(const b2TimeStep& step)
 				continue;
 			}
 
+			// Defold modification
+			b->m_flags |= b2Body::e_movedFlag;
+
 			// Update fixtures (for broad-phase).
 			b->SynchronizeFixtures();
 		}
@@ -874,6 +1116,9 @@ void b2World::SolveTOI(const b2TimeStep& step)
 				continue;
 			}
 
+			// Defold modification
+			body->m_flags |= b2Body::e_movedFlag;
+
 			body->SynchronizeFixtures();
 
 			// Invalidate all contact TOIs on this displaced body.
@@ -895,6 +1140,30 @@ void b2World::SolveTOI(const b2TimeStep& step)
 	}
 }
 
+// Defold modification
+// Grid cells can be changed many at a time (e.g. destructible tile maps), so the contacts of a grid
+// fixture are flagged for filtering once per step, instead of once per changed cell
+void b2World::RefilterGrids()
+{
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		if ((b->m_flags & b2Body::e_refilterFlag) == 0)
+		{
+			continue;
+		}
+		b->m_flags &= ~b2Body::e_refilterFlag;
+
+		for (b2ContactEdge* edge = b->m_contactList; edge; edge = edge->next)
+		{
+			b2Contact* contact = edge->contact;
+			if (contact->GetFixtureA()->GetType() == b2Shape::e_grid || contact->GetFixtureB()->GetType() == b2Shape::e_grid)
+			{
+				contact->FlagForFiltering();
+			}
+		}
+	}
+}
+
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
 {
 	b2Timer stepTimer;
@@ -906,6 +1175,13 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 		m_flags &= ~e_newFixture;
 	}
 
+	// Defold modification
+	if (m_flags & e_refilter)
+	{
+		RefilterGrids();
+		m_flags &= ~e_refilter;
+	}
+
 	m_flags |= e_locked;
 
 	b2TimeStep step;
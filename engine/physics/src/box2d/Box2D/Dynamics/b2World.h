@@ -34,6 +34,16 @@ class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+class b2Island;
+
+/// Defold modification
+/// A task solving the items [start, end) of a range.
+typedef void (*b2ParallelForTask)(void* taskData, int32 start, int32 end);
+
+/// Defold modification
+/// Runs task over the range [0, count), possibly split over several threads,
+/// and returns when the whole range is done.
+typedef void (*b2ParallelForCallback)(void* userData, b2ParallelForTask task, void* taskData, int32 count);
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -157,6 +167,13 @@ public:
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Defold modification
+	/// Solve independent islands in parallel using the callback. Islands with joints,
+	/// continuous collision and the contact listener callbacks still run on the calling
+	/// thread, and contacts are reported in the same order as when solving serially.
+	/// Pass NULL to solve all islands on the calling thread.
+	void SetParallelFor(b2ParallelForCallback callback, void* userData);
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -211,7 +228,9 @@ private:
 	{
 		e_newFixture	= 0x0001,
 		e_locked		= 0x0002,
-		e_clearForces	= 0x0004
+		e_clearForces	= 0x0004,
+		// Defold modification. Some body has e_refilterFlag set
+		e_refilter		= 0x0008
 	};
 
 	friend class b2Body;
@@ -220,8 +239,15 @@ private:
 	friend class b2Controller;
 
 	void Solve(const b2TimeStep& step);
+	// Defold modification
+	void RefilterGrids();
 	void SolveTOI(const b2TimeStep& step);
 
+	// Defold modification
+	void BuildIsland(b2Island* island, b2Body* seed, b2Body** stack, int32 stackSize);
+	void SolveIslands(const b2TimeStep& step);
+	void SolveIslandsParallel(const b2TimeStep& step);
+
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 	void DrawPolygon(const b2Transform& xf, const b2PolygonShape& poly, const b2Color& color);
@@ -257,6 +283,10 @@ private:
 	bool m_stepComplete;
 
 	b2Profile m_profile;
+
+	// Defold modification
+	b2ParallelForCallback m_parallelFor;
+	void* m_parallelForUserData;
 };
 
 inline b2Body* b2World::GetBodyList()
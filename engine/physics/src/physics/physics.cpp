@@ -17,7 +17,9 @@
 #include <string.h>
 
 #include <dlib/array.h>
+#include <dlib/hash.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
 #include <dlib/profile.h>
 
 namespace dmPhysics
@@ -246,4 +248,161 @@ namespace dmPhysics
         context.m_Cache = cache;
         cache->m_OverlapCache.Iterate(PruneOverlap, &context);
     }
+
+    static const uint32_t INVALID_AGGREGATE = 0xffffffff;
+
+    /**
+     * Make room for one more entry. The pair tables are refilled every step, so they grow by doubling.
+     */
+    template <typename KEY, typename T>
+    static void ExpandTable(dmHashTable<KEY, T>& table)
+    {
+        uint32_t capacity = table.Capacity();
+        // Expand when 75% full
+        if (table.Size() >= 3 * capacity / 4)
+        {
+            capacity = dmMath::Max(CACHE_INITIAL_CAPACITY, 2 * capacity);
+            table.SetCapacity(3 * capacity / 4, capacity);
+        }
+    }
+
+    static uint64_t ContactPairKey(void* object_a, void* object_b)
+    {
+        uintptr_t pair[2];
+        pair[0] = dmMath::Min((uintptr_t)object_a, (uintptr_t)object_b);
+        pair[1] = dmMath::Max((uintptr_t)object_a, (uintptr_t)object_b);
+        return dmHashBuffer64(pair, sizeof(pair));
+    }
+
+    void ContactEventCacheSetEvents(ContactEventCache* cache, void* object, uint16_t events)
+    {
+        uint16_t* current = cache->m_Events.Get((uintptr_t)object);
+        if (events == CONTACT_EVENTS_DEFAULT)
+        {
+            if (current != 0x0)
+                cache->m_Events.Erase((uintptr_t)object);
+        }
+        else if (current != 0x0)
+        {
+            *current = events;
+        }
+        else
+        {
+            ExpandTable(cache->m_Events);
+            cache->m_Events.Put((uintptr_t)object, events);
+        }
+    }
+
+    uint16_t ContactEventCacheGetEvents(ContactEventCache* cache, void* object)
+    {
+        uint16_t* events = cache->m_Events.Get((uintptr_t)object);
+        return events != 0x0 ? *events : (uint16_t)CONTACT_EVENTS_DEFAULT;
+    }
+
+    void ContactEventCacheRemove(ContactEventCache* cache, void* object)
+    {
+        ContactEventCacheSetEvents(cache, object, CONTACT_EVENTS_DEFAULT);
+    }
+
+    bool ContactEventCacheAddContact(ContactEventCache* cache, void* object_a, void* object_b, uint16_t events,
+                                     void* user_data_a, uint16_t group_a, void* user_data_b, uint16_t group_b, ContactAggregate** out_aggregate)
+    {
+        *out_aggregate = 0x0;
+        if ((events & (CONTACT_EVENTS_FIRST_CONTACT | CONTACT_EVENTS_AGGREGATE)) == 0)
+            return true;
+
+        uint64_t key = ContactPairKey(object_a, object_b);
+        uint32_t* index = cache->m_Pairs.Get(key);
+        if (index == 0x0)
+        {
+            ExpandTable(cache->m_Pairs);
+            cache->m_Pairs.Put(key, INVALID_AGGREGATE);
+            index = cache->m_Pairs.Get(key);
+        }
+
+        // The pair is tracked also when it isn't reported, to know it was touching in the next step
+        if ((events & CONTACT_EVENTS_FIRST_CONTACT) && cache->m_PrevPairs.Get(key) != 0x0)
+            return false;
+
+        if ((events & CONTACT_EVENTS_AGGREGATE) == 0)
+            return true;
+
+        if (*index == INVALID_AGGREGATE)
+        {
+            dmArray<ContactAggregate>& aggregates = cache->m_Aggregates;
+            if (aggregates.Full())
+                aggregates.OffsetCapacity(dmMath::Max(16u, aggregates.Size()));
+            *index = aggregates.Size();
+            aggregates.SetSize(aggregates.Size() + 1);
+            ContactAggregate& aggregate = aggregates.Back();
+            memset(&aggregate, 0, sizeof(aggregate));
+            aggregate.m_Point.m_UserDataA = user_data_a;
+            aggregate.m_Point.m_UserDataB = user_data_b;
+            aggregate.m_Point.m_GroupA = group_a;
+            aggregate.m_Point.m_GroupB = group_b;
+        }
+        ContactAggregate* aggregate = &cache->m_Aggregates[*index];
+        aggregate->m_Events |= events;
+        *out_aggregate = aggregate;
+        return true;
+    }
+
+    void ContactAggregateAddPoint(ContactAggregate* aggregate, const ContactPoint& point)
+    {
+        ContactPoint& sum = aggregate->m_Point;
+        // Contacts of a pair don't necessarily list the objects in the same order
+        bool swapped = point.m_UserDataA != sum.m_UserDataA;
+        float sign = swapped ? -1.0f : 1.0f;
+        if (aggregate->m_PointCount == 0)
+        {
+            sum.m_MassA = swapped ? point.m_MassB : point.m_MassA;
+            sum.m_MassB = swapped ? point.m_MassA : point.m_MassB;
+            sum.m_Distance = point.m_Distance;
+        }
+        sum.m_PositionA += Vector3(swapped ? point.m_PositionB : point.m_PositionA);
+        sum.m_PositionB += Vector3(swapped ? point.m_PositionA : point.m_PositionB);
+        sum.m_Normal += sign * point.m_Normal;
+        sum.m_RelativeVelocity += sign * point.m_RelativeVelocity;
+        sum.m_Distance = dmMath::Max(sum.m_Distance, point.m_Distance);
+        sum.m_AppliedImpulse += point.m_AppliedImpulse;
+        ++aggregate->m_PointCount;
+    }
+
+    void ContactEventCacheFlush(ContactEventCache* cache, const StepWorldContext& step_context)
+    {
+        CollisionCallback collision_callback = step_context.m_CollisionCallback;
+        ContactPointCallback contact_point_callback = step_context.m_ContactPointCallback;
+        bool requests_collision_callbacks = true;
+        bool requests_contact_callbacks = true;
+
+        uint32_t count = cache->m_Aggregates.Size();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const ContactAggregate& aggregate = cache->m_Aggregates[i];
+            const ContactPoint& sum = aggregate.m_Point;
+            if (collision_callback != 0x0 && requests_collision_callbacks && (aggregate.m_Events & CONTACT_EVENTS_COLLISION))
+            {
+                requests_collision_callbacks = collision_callback(sum.m_UserDataA, sum.m_GroupA, sum.m_UserDataB, sum.m_GroupB, step_context.m_CollisionUserData);
+            }
+            if (contact_point_callback != 0x0 && requests_contact_callbacks && (aggregate.m_Events & CONTACT_EVENTS_CONTACT_POINT) && aggregate.m_PointCount > 0)
+            {
+                float inv_count = 1.0f / aggregate.m_PointCount;
+                ContactPoint point = sum;
+                point.m_PositionA = Point3(Vector3(sum.m_PositionA) * inv_count);
+                point.m_PositionB = Point3(Vector3(sum.m_PositionB) * inv_count);
+                float normal_length = length(sum.m_Normal);
+                if (normal_length > 0.0f)
+                    point.m_Normal = sum.m_Normal / normal_length;
+                point.m_RelativeVelocity = sum.m_RelativeVelocity * inv_count;
+                requests_contact_callbacks = contact_point_callback(point, step_context.m_ContactPointUserData);
+            }
+        }
+        cache->m_Aggregates.SetSize(0);
+
+        if (!cache->m_Pairs.Empty() || !cache->m_PrevPairs.Empty())
+        {
+            cache->m_PrevPairs.Swap(cache->m_Pairs);
+            cache->m_Pairs.Clear();
+        }
+    }
 }
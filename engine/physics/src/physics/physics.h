@@ -18,6 +18,7 @@
 #include <dmsdk/vectormath/cpp/vectormath_aos.h> // TODO: Use dmsdk/dlib/vmath.h
 
 #include <dlib/hash.h>
+#include <dlib/job.h>
 #include <dlib/message.h>
 #include <dlib/transform.h>
 
@@ -176,6 +177,28 @@ namespace dmPhysics
      */
     typedef bool (*ContactPointCallback)(const ContactPoint& contact_point, void* user_data);
 
+    /**
+     * Contact events a collision object subscribes to.
+     *
+     * The events of the two objects of a contact are combined: a contact is reported if either object
+     * subscribes to the event, and the first contact and aggregate modes apply if either object uses them.
+     * Contacts are dropped before any callback is made.
+     */
+    enum ContactEvents
+    {
+        /// Report contacts through the collision callback
+        CONTACT_EVENTS_COLLISION        = 1 << 0,
+        /// Report contacts through the contact point callback
+        CONTACT_EVENTS_CONTACT_POINT    = 1 << 1,
+        /// Only report contacts the first step two objects touch
+        CONTACT_EVENTS_FIRST_CONTACT    = 1 << 2,
+        /// Merge the contacts between two objects into one collision and one contact point per step
+        CONTACT_EVENTS_AGGREGATE        = 1 << 3,
+
+        /// Events of new collision objects
+        CONTACT_EVENTS_DEFAULT          = CONTACT_EVENTS_COLLISION | CONTACT_EVENTS_CONTACT_POINT,
+    };
+
     struct TriggerEnter
     {
         /// User data of the first object
@@ -237,6 +260,8 @@ namespace dmPhysics
         uint32_t m_RayCastLimit3D;
         /// Maximum number of overlapping triggers
         uint32_t m_TriggerOverlapCapacity;
+        /// If set, the islands of the 2D worlds are solved in parallel, and the 3D narrowphase is split into tasks, using the job system
+        dmJob::HContext m_JobContext;
         /// If true, the collision objects will retrieve the position of its game object
         uint8_t m_AllowDynamicTransforms:1;
         uint8_t :7;
@@ -572,7 +597,9 @@ namespace dmPhysics
         uint16_t m_Bullet : 1;
         /// Whether the object is enabled from the start or not, default is 1
         uint16_t m_Enabled : 1;
-        uint16_t :14;
+        /// Contact events to report, see ContactEvents. Default is CONTACT_EVENTS_DEFAULT
+        uint16_t m_ContactEvents : 4;
+        uint16_t :9;
     };
 
     /**
@@ -926,6 +953,42 @@ namespace dmPhysics
      */
     void Wakeup2D(HCollisionObject2D collision_object);
 
+    /**
+     * Set the contact events reported for a 3D collision object
+     *
+     * @param world Physics world
+     * @param collision_object Collision object
+     * @param events Combination of ContactEvents
+     */
+    void SetContactEvents3D(HWorld3D world, HCollisionObject3D collision_object, uint16_t events);
+
+    /**
+     * Get the contact events reported for a 3D collision object
+     *
+     * @param world Physics world
+     * @param collision_object Collision object
+     * @return Combination of ContactEvents
+     */
+    uint16_t GetContactEvents3D(HWorld3D world, HCollisionObject3D collision_object);
+
+    /**
+     * Set the contact events reported for a 2D collision object
+     *
+     * @param world Physics world
+     * @param collision_object Collision object
+     * @param events Combination of ContactEvents
+     */
+    void SetContactEvents2D(HWorld2D world, HCollisionObject2D collision_object, uint16_t events);
+
+    /**
+     * Get the contact events reported for a 2D collision object
+     *
+     * @param world Physics world
+     * @param collision_object Collision object
+     * @return Combination of ContactEvents
+     */
+    uint16_t GetContactEvents2D(HWorld2D world, HCollisionObject2D collision_object);
+
     /**
      * Set whether the 3D collision object has locked rotation or not, which means that the angular velocity will always be 0.
      *
@@ -1146,6 +1209,136 @@ namespace dmPhysics
      */
     void RayCast2D(HWorld2D world, const RayCastRequest& request, dmArray<RayCastResponse>& results);
 
+    /**
+     * Perform synchronous ray casts for a batch of rays, only the closest hit of each ray is returned
+     * and m_ReturnAllResults is ignored.
+     * Rays that miss, or have zero length, get a response with m_Hit set to 0.
+     *
+     * @param world Physics world in which to perform the ray casts
+     * @param requests Array of count requests
+     * @param responses Array receiving count responses, in the same order as the requests
+     * @param count Number of rays
+     * @param job_context Optional job context, the 3D world ignores it since Bullet ray tests must not run concurrently
+     */
+    void RayCastBatch3D(HWorld3D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count, dmJob::HContext job_context);
+
+    /**
+     * Perform synchronous ray casts for a batch of rays, only the closest hit of each ray is returned
+     * and m_ReturnAllResults is ignored.
+     * Rays that miss, or have zero length, get a response with m_Hit set to 0.
+     * The world is only read, so the rays are spread over the job workers when a job context is supplied.
+     *
+     * @param world Physics world in which to perform the ray casts
+     * @param requests Array of count requests
+     * @param responses Array receiving count responses, in the same order as the requests
+     * @param count Number of rays
+     * @param job_context Optional job context
+     */
+    void RayCastBatch2D(HWorld2D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count, dmJob::HContext job_context);
+
+    /**
+     * Shape of an overlap or shape cast query
+     */
+    enum QueryShapeType
+    {
+        /// Axis aligned box, the rotation of the request is ignored
+        QUERY_SHAPE_TYPE_AABB   = 0,
+        /// Sphere in 3D and circle in 2D
+        QUERY_SHAPE_TYPE_SPHERE = 1,
+        /// Rotated box
+        QUERY_SHAPE_TYPE_BOX    = 2,
+    };
+
+    /**
+     * Container of data for overlap and shape cast queries.
+     * The queries are tested against the kinematic, dynamic and static collision objects, never against triggers.
+     */
+    struct ShapeQueryRequest
+    {
+        ShapeQueryRequest();
+
+        /// Center of the shape, where the shape cast starts
+        Vectormath::Aos::Point3 m_From;
+        /// Where the shape cast ends, ignored by overlap queries
+        Vectormath::Aos::Point3 m_To;
+        /// Rotation of boxes, only the rotation around z is used in 2D
+        Vectormath::Aos::Quat m_Rotation;
+        /// Half extents of boxes, the x component is the radius of spheres. The z component is ignored in 2D.
+        Vectormath::Aos::Vector3 m_Extents;
+        /// All collision objects with this user data will be ignored
+        void* m_IgnoredUserData;
+        /// Bit field to filter out collision objects of the corresponding groups
+        uint16_t m_Mask;
+        /// QueryShapeType of the shape
+        uint16_t m_ShapeType:2;
+        uint16_t :14;
+    };
+
+    /**
+     * A collision object overlapping the shape of an overlap query.
+     */
+    struct OverlapResponse
+    {
+        /// User specified data for the overlapping object
+        void* m_CollisionObjectUserData;
+        /// Group of the overlapping object
+        uint16_t m_CollisionObjectGroup;
+    };
+
+    /**
+     * Find the collision objects overlapping the shapes of a batch of queries.
+     * Each object is reported once per query. The objects of the queries are appended to results in query order,
+     * and result_counts receives the number of objects found by each query.
+     *
+     * @param world Physics world to query
+     * @param requests Array of count requests
+     * @param count Number of queries
+     * @param results Array receiving the overlapping objects
+     * @param result_counts Array receiving count object counts
+     * @note The result array may grow during the call
+     */
+    void OverlapBatch3D(HWorld3D world, const ShapeQueryRequest* requests, uint32_t count, dmArray<OverlapResponse>& results, uint32_t* result_counts);
+
+    /**
+     * Find the collision objects overlapping the shapes of a batch of queries.
+     * Each object is reported once per query. The objects of the queries are appended to results in query order,
+     * and result_counts receives the number of objects found by each query.
+     *
+     * @param world Physics world to query
+     * @param requests Array of count requests
+     * @param count Number of queries
+     * @param results Array receiving the overlapping objects
+     * @param result_counts Array receiving count object counts
+     * @note The result array may grow during the call
+     */
+    void OverlapBatch2D(HWorld2D world, const ShapeQueryRequest* requests, uint32_t count, dmArray<OverlapResponse>& results, uint32_t* result_counts);
+
+    /**
+     * Sweep the shapes of a batch of queries from m_From to m_To, only the first hit of each shape is returned.
+     * The fraction of a response is where along the sweep the shape touches the object, and the position and
+     * normal are the point and surface normal of the contact. Objects the shape overlaps at the start are not hit.
+     * Shapes that miss, or are swept a zero distance, get a response with m_Hit set to 0.
+     *
+     * @param world Physics world in which to perform the shape casts
+     * @param requests Array of count requests
+     * @param responses Array receiving count responses, in the same order as the requests
+     * @param count Number of shape casts
+     */
+    void ShapeCastBatch3D(HWorld3D world, const ShapeQueryRequest* requests, RayCastResponse* responses, uint32_t count);
+
+    /**
+     * Sweep the shapes of a batch of queries from m_From to m_To, only the first hit of each shape is returned.
+     * The fraction of a response is where along the sweep the shape touches the object, and the position and
+     * normal are the point and surface normal of the contact. Objects the shape overlaps at the start are not hit.
+     * Shapes that miss, or are swept a zero distance, get a response with m_Hit set to 0.
+     *
+     * @param world Physics world in which to perform the shape casts
+     * @param requests Array of count requests
+     * @param responses Array receiving count responses, in the same order as the requests
+     * @param count Number of shape casts
+     */
+    void ShapeCastBatch2D(HWorld2D world, const ShapeQueryRequest* requests, RayCastResponse* responses, uint32_t count);
+
     /**
      * Set the gravity for a 2D physics world.
      *
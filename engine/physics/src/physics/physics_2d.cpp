@@ -18,6 +18,7 @@
 #include <dlib/array.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/memprofile.h>
 #include <dlib/profile.h>
 
 #include "Box2D/Box2D.h"
@@ -38,6 +39,7 @@ namespace dmPhysics
     , m_TriggerEnterLimit(0.0f)
     , m_RayCastLimit(0)
     , m_TriggerOverlapCapacity(0)
+    , m_JobContext(0)
     , m_AllowDynamicTransforms(0)
     {
 
@@ -45,6 +47,7 @@ namespace dmPhysics
 
     World2D::World2D(HContext2D context, const NewWorldParams& params)
     : m_TriggerOverlaps(context->m_TriggerOverlapCapacity)
+    , m_ContactEvents()
     , m_Context(context)
     , m_World(context->m_Gravity)
     , m_RayCastRequests()
@@ -156,16 +159,28 @@ namespace dmPhysics
                 b2Fixture* fixture_b = contact->GetFixtureB();
                 int32_t index_a = contact->GetChildIndexA();
                 int32_t index_b = contact->GetChildIndexB();
+                uint16_t group_a = fixture_a->GetFilterData(index_a).categoryBits;
+                uint16_t group_b = fixture_b->GetFilterData(index_b).categoryBits;
 
-                if (collision_callback)
+                // Drop the contact before anything is built if neither object subscribes to it
+                ContactEventCache* event_cache = &m_World->m_ContactEvents;
+                uint16_t events = ContactEventCacheGetEvents(event_cache, fixture_a->GetBody(), fixture_b->GetBody());
+                if ((events & (CONTACT_EVENTS_COLLISION | CONTACT_EVENTS_CONTACT_POINT)) == 0)
+                    return;
+                ContactAggregate* aggregate;
+                if (!ContactEventCacheAddContact(event_cache, fixture_a->GetBody(), fixture_b->GetBody(), events,
+                                                 fixture_a->GetUserData(), group_a, fixture_b->GetUserData(), group_b, &aggregate))
+                    return;
+
+                if (collision_callback && aggregate == 0x0 && (events & CONTACT_EVENTS_COLLISION))
                 {
                     collision_callback(fixture_a->GetUserData(),
-                                       fixture_a->GetFilterData(index_a).categoryBits,
+                                       group_a,
                                        fixture_b->GetUserData(),
-                                       fixture_b->GetFilterData(index_b).categoryBits,
+                                       group_b,
                                        m_TempStepWorldContext->m_CollisionUserData);
                 }
-                if (contact_point_callback)
+                if (contact_point_callback && (events & CONTACT_EVENTS_CONTACT_POINT))
                 {
                     b2WorldManifold world_manifold;
                     contact->GetWorldManifold(&world_manifold);
@@ -185,9 +200,12 @@ namespace dmPhysics
                         cp.m_AppliedImpulse = impulse->normalImpulses[i] * inv_scale;
                         cp.m_MassA = fixture_a->GetBody()->GetMass();
                         cp.m_MassB = fixture_b->GetBody()->GetMass();
-                        cp.m_GroupA = fixture_a->GetFilterData(index_a).categoryBits;
-                        cp.m_GroupB = fixture_b->GetFilterData(index_b).categoryBits;
-                        contact_point_callback(cp, m_TempStepWorldContext->m_ContactPointUserData);
+                        cp.m_GroupA = group_a;
+                        cp.m_GroupB = group_b;
+                        if (aggregate)
+                            ContactAggregateAddPoint(aggregate, cp);
+                        else
+                            contact_point_callback(cp, m_TempStepWorldContext->m_ContactPointUserData);
                     }
                 }
             }
@@ -215,6 +233,7 @@ namespace dmPhysics
         context->m_TriggerEnterLimit = params.m_TriggerEnterLimit * params.m_Scale;
         context->m_RayCastLimit = params.m_RayCastLimit2D;
         context->m_TriggerOverlapCapacity = params.m_TriggerOverlapCapacity;
+        context->m_JobContext = params.m_JobContext;
         context->m_AllowDynamicTransforms = params.m_AllowDynamicTransforms;
         dmMessage::Result result = dmMessage::NewSocket(PHYSICS_SOCKET_NAME, &context->m_Socket);
         if (result != dmMessage::RESULT_OK)
@@ -244,6 +263,40 @@ namespace dmPhysics
         return context->m_Socket;
     }
 
+    // Islands per job when the islands of a world are solved in parallel
+    static const uint32_t ISLAND_JOB_BATCH_SIZE = 8;
+
+    struct SolveIslandsContext2D
+    {
+        b2ParallelForTask   m_Task;
+        void*               m_TaskData;
+    };
+
+    static void SolveIslandsRange2D(void* _ctx, uint32_t start, uint32_t end)
+    {
+        SolveIslandsContext2D* ctx = (SolveIslandsContext2D*) _ctx;
+        ctx->m_Task(ctx->m_TaskData, (int32) start, (int32) end);
+    }
+
+    static void SolveIslandsParallelFor2D(void* user_data, b2ParallelForTask task, void* task_data, int32 count)
+    {
+        DM_PROFILE(Physics, "SolveIslands");
+        dmJob::HContext job_context = (dmJob::HContext) user_data;
+
+        SolveIslandsContext2D ctx;
+        ctx.m_Task = task;
+        ctx.m_TaskData = task_data;
+
+        if ((uint32_t) count < ISLAND_JOB_BATCH_SIZE * 2)
+        {
+            task(task_data, 0, count);
+            return;
+        }
+
+        dmJob::HJob job = dmJob::ParallelFor(job_context, SolveIslandsRange2D, &ctx, (uint32_t) count, ISLAND_JOB_BATCH_SIZE, dmJob::INVALID_JOB);
+        dmJob::Wait(job_context, job);
+    }
+
     HWorld2D NewWorld2D(HContext2D context, const NewWorldParams& params)
     {
         if (context->m_Worlds.Full())
@@ -255,6 +308,10 @@ namespace dmPhysics
         world->m_World.SetDebugDraw(&world->m_DebugDraw);
         world->m_World.SetContactListener(&world->m_ContactListener);
         world->m_World.SetContinuousPhysics(false);
+        if (context->m_JobContext)
+        {
+            world->m_World.SetParallelFor(SolveIslandsParallelFor2D, context->m_JobContext);
+        }
         context->m_Worlds.Push(world);
         return world;
     }
@@ -397,6 +454,7 @@ namespace dmPhysics
 
     void StepWorld2D(HWorld2D world, const StepWorldContext& step_context)
     {
+        DM_MEM_SCOPE(Physics);
         float dt = step_context.m_DT;
         HContext2D context = world->m_Context;
         float scale = context->m_Scale;
@@ -427,11 +485,12 @@ namespace dmPhysics
                     float old_angle = body->GetAngle();
                     float da = old_angle - angle;
 
+                    // Unchanged bodies are skipped, the moved ones are paired in one broad-phase update at the start of the step
                     if (dp > POS_EPSILON || fabsf(da) > ROT_EPSILON)
                     {
                         b2Vec2 b2_position;
                         ToB2(position, b2_position, scale);
-                        body->SetTransform(b2_position, angle);
+                        body->SetTransformDeferred(b2_position, angle);
                         body->SetSleepingAllowed(false);
                     }
                     else
@@ -452,12 +511,12 @@ namespace dmPhysics
             world->m_ContactListener.SetStepWorldContext(&step_context);
             world->m_World.Step(dt, 10, 10);
             float inv_scale = world->m_Context->m_InvScale;
-            // Update transforms of dynamic bodies
+            // Update transforms of dynamic bodies, sleeping bodies and bodies outside the solved islands did not move
             if (world->m_SetWorldTransformCallback)
             {
                 for (b2Body* body = world->m_World.GetBodyList(); body; body = body->GetNext())
                 {
-                    if (body->GetType() == b2_dynamicBody && body->IsActive())
+                    if (body->GetType() == b2_dynamicBody && body->HasMoved())
                     {
                         Vectormath::Aos::Point3 position;
                         FromB2(body->GetPosition(), position, inv_scale);
@@ -499,16 +558,30 @@ namespace dmPhysics
                 b2Fixture* fixture_b = contact->GetFixtureB();
                 if (contact->IsTouching() && (fixture_a->IsSensor() || fixture_b->IsSensor()))
                 {
+                    uint16_t events = ContactEventCacheGetEvents(&world->m_ContactEvents, fixture_a->GetBody(), fixture_b->GetBody());
+                    if ((events & CONTACT_EVENTS_COLLISION) == 0)
+                        continue;
+
                     int32_t index_a = contact->GetChildIndexA();
                     int32_t index_b = contact->GetChildIndexB();
-                    step_context.m_CollisionCallback(fixture_a->GetUserData(),
-                                                fixture_a->GetFilterData(index_a).categoryBits,
-                                                fixture_b->GetUserData(),
-                                                fixture_b->GetFilterData(index_b).categoryBits,
-                                                step_context.m_CollisionUserData);
+                    uint16_t group_a = fixture_a->GetFilterData(index_a).categoryBits;
+                    uint16_t group_b = fixture_b->GetFilterData(index_b).categoryBits;
+                    ContactAggregate* aggregate;
+                    if (!ContactEventCacheAddContact(&world->m_ContactEvents, fixture_a->GetBody(), fixture_b->GetBody(), events,
+                                                     fixture_a->GetUserData(), group_a, fixture_b->GetUserData(), group_b, &aggregate))
+                        continue;
+                    if (aggregate == 0x0)
+                    {
+                        step_context.m_CollisionCallback(fixture_a->GetUserData(),
+                                                    group_a,
+                                                    fixture_b->GetUserData(),
+                                                    group_b,
+                                                    step_context.m_CollisionUserData);
+                    }
                 }
             }
         }
+        ContactEventCacheFlush(&world->m_ContactEvents, step_context);
         UpdateOverlapCache(&world->m_TriggerOverlaps, context, world->m_World.GetContactList(), step_context);
 
         world->m_World.DrawDebugData();
@@ -954,6 +1027,7 @@ namespace dmPhysics
             b2Fixture* fixture = body->CreateFixture(&f_def);
             (void)fixture;
         }
+        ContactEventCacheSetEvents(&world->m_ContactEvents, body, data.m_ContactEvents);
         return body;
     }
 
@@ -965,6 +1039,7 @@ namespace dmPhysics
         // See comment above about shapes and transforms
 
         OverlapCacheRemove(&world->m_TriggerOverlaps, collision_object);
+        ContactEventCacheRemove(&world->m_ContactEvents, collision_object);
         b2Body* body = (b2Body*)collision_object;
         b2Fixture* fixture = body->GetFixtureList();
         while (fixture)
@@ -1108,6 +1183,16 @@ namespace dmPhysics
         body->SetAwake(true);
     }
 
+    void SetContactEvents2D(HWorld2D world, HCollisionObject2D collision_object, uint16_t events)
+    {
+        ContactEventCacheSetEvents(&world->m_ContactEvents, collision_object, events);
+    }
+
+    uint16_t GetContactEvents2D(HWorld2D world, HCollisionObject2D collision_object)
+    {
+        return ContactEventCacheGetEvents(&world->m_ContactEvents, collision_object);
+    }
+
     void SetLockedRotation2D(HCollisionObject2D collision_object, bool locked_rotation) {
         b2Body* body = ((b2Body*)collision_object);
         body->SetFixedRotation(locked_rotation);
@@ -1224,6 +1309,316 @@ namespace dmPhysics
         }
     }
 
+    // Rays per job when a batch is spread over the job workers
+    static const uint32_t RAYCAST_JOB_BATCH_SIZE = 32;
+
+    struct RayCastBatchContext2D
+    {
+        HWorld2D                m_World;
+        const RayCastRequest*   m_Requests;
+        RayCastResponse*        m_Responses;
+    };
+
+    static void RayCastBatchRange2D(void* _ctx, uint32_t start, uint32_t end)
+    {
+        RayCastBatchContext2D* ctx = (RayCastBatchContext2D*) _ctx;
+        HWorld2D world = ctx->m_World;
+        float scale = world->m_Context->m_Scale;
+        for (uint32_t i = start; i < end; ++i)
+        {
+            const RayCastRequest& request = ctx->m_Requests[i];
+            RayCastResponse& response = ctx->m_Responses[i];
+            response.m_Hit = 0;
+
+            b2Vec2 from;
+            ToB2(Vectormath::Aos::Point3(request.m_From.getX(), request.m_From.getY(), 0.0f), from, scale);
+            b2Vec2 to;
+            ToB2(Vectormath::Aos::Point3(request.m_To.getX(), request.m_To.getY(), 0.0f), to, scale);
+            if ((to - from).LengthSquared() <= 0.0f)
+                continue;
+
+            ProcessRayCastResultCallback2D query;
+            query.m_Request = &request;
+            query.m_ReturnAllResults = 0;
+            query.m_Context = world->m_Context;
+            query.m_Results = 0;
+            query.m_IgnoredUserData = request.m_IgnoredUserData;
+            query.m_CollisionMask = request.m_Mask;
+            query.m_Response.m_Hit = 0;
+            world->m_World.RayCast(&query, from, to);
+            if (query.m_Response.m_Hit)
+                response = query.m_Response;
+        }
+    }
+
+    void RayCastBatch2D(HWorld2D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count, dmJob::HContext job_context)
+    {
+        DM_PROFILE(Physics, "RayCastBatch");
+
+        RayCastBatchContext2D ctx;
+        ctx.m_World = world;
+        ctx.m_Requests = requests;
+        ctx.m_Responses = responses;
+
+        // Box2D ray casts only read the world, so they can run concurrently as long as the world isn't stepped
+        if (job_context == 0 || count < RAYCAST_JOB_BATCH_SIZE * 2)
+        {
+            RayCastBatchRange2D(&ctx, 0, count);
+            return;
+        }
+
+        dmJob::HJob job = dmJob::ParallelFor(job_context, RayCastBatchRange2D, &ctx, count, RAYCAST_JOB_BATCH_SIZE, dmJob::INVALID_JOB);
+        dmJob::Wait(job_context, job);
+    }
+
+    // The shape of a query, in physics units
+    struct QueryShape2D
+    {
+        b2CircleShape   m_Circle;
+        b2PolygonShape  m_Box;
+        b2Shape*        m_Shape;
+        float32         m_Angle;
+    };
+
+    static void InitQueryShape2D(const ShapeQueryRequest& request, float scale, QueryShape2D& shape)
+    {
+        shape.m_Angle = 0.0f;
+        if (request.m_ShapeType == QUERY_SHAPE_TYPE_SPHERE)
+        {
+            shape.m_Circle.m_p.SetZero();
+            shape.m_Circle.m_radius = request.m_Extents.getX() * scale;
+            shape.m_Shape = &shape.m_Circle;
+            return;
+        }
+        shape.m_Box.SetAsBox(request.m_Extents.getX() * scale, request.m_Extents.getY() * scale);
+        shape.m_Shape = &shape.m_Box;
+        if (request.m_ShapeType == QUERY_SHAPE_TYPE_BOX)
+        {
+            const Vectormath::Aos::Quat& r = request.m_Rotation;
+            shape.m_Angle = atan2(2.0f * (r.getW() * r.getZ() + r.getX() * r.getY()), 1.0f - 2.0f * (r.getY() * r.getY() + r.getZ() * r.getZ()));
+        }
+    }
+
+    // The shape to test a query against for a fixture child, grid cells are expanded into polygons.
+    // Returns 0 for empty grid cells.
+    static const b2Shape* GetQueryChildShape2D(b2Fixture* fixture, int32 child_index, b2PolygonShape& cell_shape, int32* shape_index)
+    {
+        const b2Shape* shape = fixture->GetShape();
+        if (shape->GetType() != b2Shape::e_grid)
+        {
+            *shape_index = child_index;
+            return shape;
+        }
+        const b2GridShape* grid_shape = (const b2GridShape*)shape;
+        if (grid_shape->m_cells[child_index].m_Index == B2GRIDSHAPE_EMPTY_CELL)
+            return 0x0;
+        grid_shape->GetPolygonShapeForCell(child_index, cell_shape);
+        *shape_index = 0;
+        return &cell_shape;
+    }
+
+    static bool IsQueryCandidate2D(const b2FixtureProxy* proxy, const ShapeQueryRequest& request)
+    {
+        b2Fixture* fixture = proxy->fixture;
+        // Never hit triggers
+        if (fixture->IsSensor())
+            return false;
+        if (fixture->GetBody()->GetUserData() == request.m_IgnoredUserData)
+            return false;
+        return (fixture->GetFilterData(proxy->childIndex).categoryBits & request.m_Mask) != 0;
+    }
+
+    struct OverlapQuery2D
+    {
+        bool QueryCallback(int32 proxy_id)
+        {
+            const b2FixtureProxy* proxy = (const b2FixtureProxy*)m_BroadPhase->GetUserData(proxy_id);
+            if (!IsQueryCandidate2D(proxy, *m_Request))
+                return true;
+            b2Fixture* fixture = proxy->fixture;
+            b2Body* body = fixture->GetBody();
+            void* user_data = body->GetUserData();
+            // Each object is only reported once
+            for (uint32_t i = m_First; i < m_Results->Size(); ++i)
+            {
+                if ((*m_Results)[i].m_CollisionObjectUserData == user_data)
+                    return true;
+            }
+
+            b2PolygonShape cell_shape;
+            int32 shape_index;
+            const b2Shape* shape = GetQueryChildShape2D(fixture, proxy->childIndex, cell_shape, &shape_index);
+            if (shape == 0x0 || !b2TestOverlap(m_Shape, 0, shape, shape_index, m_Transform, body->GetTransform()))
+                return true;
+
+            if (m_Results->Full())
+                m_Results->OffsetCapacity(32);
+            OverlapResponse response;
+            response.m_CollisionObjectUserData = user_data;
+            response.m_CollisionObjectGroup = fixture->GetFilterData(proxy->childIndex).categoryBits;
+            m_Results->Push(response);
+            return true;
+        }
+
+        const b2BroadPhase*         m_BroadPhase;
+        const ShapeQueryRequest*    m_Request;
+        const b2Shape*              m_Shape;
+        b2Transform                 m_Transform;
+        dmArray<OverlapResponse>*   m_Results;
+        uint32_t                    m_First;
+    };
+
+    void OverlapBatch2D(HWorld2D world, const ShapeQueryRequest* requests, uint32_t count, dmArray<OverlapResponse>& results, uint32_t* result_counts)
+    {
+        DM_PROFILE(Physics, "OverlapBatch");
+
+        float scale = world->m_Context->m_Scale;
+        OverlapQuery2D query;
+        query.m_BroadPhase = &world->m_World.GetContactManager().m_broadPhase;
+        query.m_Results = &results;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const ShapeQueryRequest& request = requests[i];
+            QueryShape2D shape;
+            InitQueryShape2D(request, scale, shape);
+            b2Vec2 position;
+            ToB2(request.m_From, position, scale);
+
+            query.m_Request = &request;
+            query.m_Shape = shape.m_Shape;
+            query.m_Transform.Set(position, shape.m_Angle);
+            query.m_First = results.Size();
+            b2AABB aabb;
+            shape.m_Shape->ComputeAABB(&aabb, query.m_Transform, 0);
+            query.m_BroadPhase->Query(&query, aabb);
+            result_counts[i] = results.Size() - query.m_First;
+        }
+    }
+
+    struct ShapeCastQuery2D
+    {
+        bool QueryCallback(int32 proxy_id)
+        {
+            const b2FixtureProxy* proxy = (const b2FixtureProxy*)m_BroadPhase->GetUserData(proxy_id);
+            if (!IsQueryCandidate2D(proxy, *m_Request))
+                return true;
+            b2Fixture* fixture = proxy->fixture;
+            b2Body* body = fixture->GetBody();
+
+            b2PolygonShape cell_shape;
+            int32 shape_index;
+            const b2Shape* shape = GetQueryChildShape2D(fixture, proxy->childIndex, cell_shape, &shape_index);
+            if (shape == 0x0)
+                return true;
+
+            b2TOIInput input;
+            input.proxyA.Set(m_Shape, 0);
+            input.proxyB.Set(shape, shape_index);
+            input.sweepA = m_Sweep;
+            input.sweepB.localCenter = body->GetLocalCenter();
+            input.sweepB.c0 = body->GetWorldCenter();
+            input.sweepB.c = input.sweepB.c0;
+            input.sweepB.a0 = body->GetAngle();
+            input.sweepB.a = input.sweepB.a0;
+            input.sweepB.alpha0 = 0.0f;
+            input.tMax = m_Fraction;
+
+            b2TOIOutput output;
+            b2TimeOfImpact(&output, &input);
+            // Objects overlapped at the start are not hit
+            if (output.state != b2TOIOutput::e_touching || output.t <= 0.0f)
+                return true;
+            if (m_Response.m_Hit && output.t >= m_Fraction)
+                return true;
+
+            // The contact point and normal at the time of impact
+            b2DistanceInput distance_input;
+            distance_input.proxyA = input.proxyA;
+            distance_input.proxyB = input.proxyB;
+            m_Sweep.GetTransform(&distance_input.transformA, output.t);
+            distance_input.transformB = body->GetTransform();
+            distance_input.useRadii = false;
+            b2SimplexCache cache;
+            cache.count = 0;
+            b2DistanceOutput distance_output;
+            b2Distance(&distance_output, &cache, &distance_input);
+
+            b2Vec2 normal = distance_output.pointA - distance_output.pointB;
+            if (normal.Normalize() < b2_epsilon)
+            {
+                // The core shapes touch, face the direction of the sweep
+                normal = m_Sweep.c0 - m_Sweep.c;
+                normal.Normalize();
+            }
+
+            m_Fraction = output.t;
+            m_Response.m_Hit = 1;
+            m_Response.m_Fraction = output.t;
+            m_Response.m_CollisionObjectGroup = fixture->GetFilterData(proxy->childIndex).categoryBits;
+            m_Response.m_CollisionObjectUserData = body->GetUserData();
+            FromB2(normal, m_Response.m_Normal, 1.0f); // Don't scale normal
+            // The witness point is on the core shape, move it out onto the skin
+            FromB2(distance_output.pointB + shape->m_radius * normal, m_Response.m_Position, m_InvScale);
+            return true;
+        }
+
+        const b2BroadPhase*         m_BroadPhase;
+        const ShapeQueryRequest*    m_Request;
+        const b2Shape*              m_Shape;
+        b2Sweep                     m_Sweep;
+        RayCastResponse             m_Response;
+        float32                     m_Fraction;
+        float                       m_InvScale;
+    };
+
+    void ShapeCastBatch2D(HWorld2D world, const ShapeQueryRequest* requests, RayCastResponse* responses, uint32_t count)
+    {
+        DM_PROFILE(Physics, "ShapeCastBatch");
+
+        float scale = world->m_Context->m_Scale;
+        ShapeCastQuery2D query;
+        query.m_BroadPhase = &world->m_World.GetContactManager().m_broadPhase;
+        query.m_InvScale = world->m_Context->m_InvScale;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const ShapeQueryRequest& request = requests[i];
+            RayCastResponse& response = responses[i];
+            response.m_Hit = 0;
+
+            b2Vec2 from;
+            ToB2(request.m_From, from, scale);
+            b2Vec2 to;
+            ToB2(request.m_To, to, scale);
+            if ((to - from).LengthSquared() <= 0.0f)
+                continue;
+
+            QueryShape2D shape;
+            InitQueryShape2D(request, scale, shape);
+            query.m_Request = &request;
+            query.m_Shape = shape.m_Shape;
+            query.m_Sweep.localCenter.SetZero();
+            query.m_Sweep.c0 = from;
+            query.m_Sweep.c = to;
+            query.m_Sweep.a0 = shape.m_Angle;
+            query.m_Sweep.a = shape.m_Angle;
+            query.m_Sweep.alpha0 = 0.0f;
+            query.m_Fraction = 1.0f;
+            query.m_Response = RayCastResponse();
+
+            // Candidates are found within the bounds of the whole sweep
+            b2Transform xf;
+            b2AABB aabb_from, aabb_to, aabb;
+            xf.Set(from, shape.m_Angle);
+            shape.m_Shape->ComputeAABB(&aabb_from, xf, 0);
+            xf.Set(to, shape.m_Angle);
+            shape.m_Shape->ComputeAABB(&aabb_to, xf, 0);
+            aabb.Combine(aabb_from, aabb_to);
+            query.m_BroadPhase->Query(&query, aabb);
+            if (query.m_Response.m_Hit)
+                response = query.m_Response;
+        }
+    }
+
     void SetGravity2D(HWorld2D world, const Vectormath::Aos::Vector3& gravity)
     {
         b2Vec2 gravity_b;
@@ -42,6 +42,7 @@ namespace dmPhysics
         World2D(HContext2D context, const NewWorldParams& params);
 
         OverlapCache                m_TriggerOverlaps;
+        ContactEventCache           m_ContactEvents;
         HContext2D                  m_Context;
         b2World                     m_World;
         dmArray<RayCastRequest>     m_RayCastRequests;
@@ -67,6 +68,7 @@ namespace dmPhysics
         float                       m_TriggerEnterLimit;
         int                         m_RayCastLimit;
         int                         m_TriggerOverlapCapacity;
+        dmJob::HContext             m_JobContext;
         uint8_t                     m_AllowDynamicTransforms:1;
         uint8_t                     :7;
     };
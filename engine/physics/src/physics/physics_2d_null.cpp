@@ -195,6 +195,15 @@ namespace dmPhysics
     {
     }
 
+    void SetContactEvents2D(HWorld2D world, HCollisionObject2D collision_object, uint16_t events)
+    {
+    }
+
+    uint16_t GetContactEvents2D(HWorld2D world, HCollisionObject2D collision_object)
+    {
+        return CONTACT_EVENTS_DEFAULT;
+    }
+
     void SetLockedRotation2D(HCollisionObject2D collision_object, bool locked_rotation)
     {
     }
@@ -238,6 +247,24 @@ namespace dmPhysics
     {
     }
 
+    void RayCastBatch2D(HWorld2D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count, dmJob::HContext job_context)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            responses[i].m_Hit = 0;
+    }
+
+    void OverlapBatch2D(HWorld2D world, const ShapeQueryRequest* requests, uint32_t count, dmArray<OverlapResponse>& results, uint32_t* result_counts)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            result_counts[i] = 0;
+    }
+
+    void ShapeCastBatch2D(HWorld2D world, const ShapeQueryRequest* requests, RayCastResponse* responses, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            responses[i].m_Hit = 0;
+    }
+
     void SetGravity2D(HWorld2D world, const Vectormath::Aos::Vector3& gravity)
     {
     }
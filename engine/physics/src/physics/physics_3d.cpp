@@ -12,14 +12,23 @@
 
 #include <stdint.h>
 #include <stdlib.h> // qsort
+#include <string.h> // memset
 
 #include <dlib/array.h>
+#include <dlib/job.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/memprofile.h>
+#include <dlib/mutex.h>
 #include <dlib/profile.h>
 
 #include "btBulletDynamicsCommon.h"
 #include "BulletCollision/CollisionDispatch/btGhostObject.h"
+#include "BulletMultiThreaded/btThreadSupportInterface.h"
+#include "BulletMultiThreaded/SpuCollisionTaskProcess.h"
+#include "BulletMultiThreaded/SpuGatheringCollisionDispatcher.h"
+#include "BulletMultiThreaded/SpuContactManifoldCollisionAlgorithm.h"
+#include "BulletMultiThreaded/SpuNarrowPhaseCollisionTask/SpuGatheringCollisionTask.h"
 
 #include "physics_3d.h"
 
@@ -120,19 +129,203 @@ namespace dmPhysics
     , m_TriggerEnterLimit(0.0f)
     , m_RayCastLimit(0)
     , m_TriggerOverlapCapacity(0)
+    , m_JobContext(0)
     , m_AllowDynamicTransforms(0)
     {
 
     }
 
+    class CriticalSection3D : public btCriticalSection
+    {
+    public:
+        CriticalSection3D()
+        {
+            m_Mutex = dmMutex::New();
+            memset(mCommonBuff, 0, sizeof(mCommonBuff));
+        }
+
+        virtual ~CriticalSection3D()
+        {
+            dmMutex::Delete(m_Mutex);
+        }
+
+        virtual unsigned int getSharedParam(int i)
+        {
+            btAssert(i >= 0 && i < 31);
+            return mCommonBuff[i+1];
+        }
+
+        virtual void setSharedParam(int i, unsigned int p)
+        {
+            btAssert(i >= 0 && i < 31);
+            mCommonBuff[i+1] = p;
+        }
+
+        virtual void lock()
+        {
+            dmMutex::Lock(m_Mutex);
+        }
+
+        virtual void unlock()
+        {
+            dmMutex::Unlock(m_Mutex);
+        }
+
+    private:
+        dmMutex::HMutex m_Mutex;
+    };
+
+    /*
+     * Runs the narrowphase tasks of the SpuGatheringCollisionDispatcher as jobs, instead of on the
+     * threads of BulletMultiThreaded. Each task has its own local store memory, which the
+     * collision pairs are copied to, so the tasks don't touch the collision objects of the world.
+     */
+    class JobThreadSupport3D : public btThreadSupportInterface
+    {
+    public:
+        JobThreadSupport3D(dmJob::HContext job_context, uint32_t task_count)
+        : m_JobContext(job_context)
+        {
+            m_Tasks.SetCapacity(task_count);
+            m_Tasks.SetSize(task_count);
+            for (uint32_t i = 0; i < task_count; ++i)
+            {
+                Task& task = m_Tasks[i];
+                task.m_Job = dmJob::INVALID_JOB;
+                task.m_TaskDesc = 0;
+                task.m_LocalStore = createCollisionLocalStoreMemory();
+                task.m_Busy = 0;
+            }
+        }
+
+        virtual ~JobThreadSupport3D()
+        {
+            for (uint32_t i = 0; i < m_Tasks.Size(); ++i)
+            {
+                Task& task = m_Tasks[i];
+                if (task.m_Busy)
+                    dmJob::Wait(m_JobContext, task.m_Job);
+                delete (CollisionTask_LocalStoreMemory*) task.m_LocalStore;
+            }
+        }
+
+        virtual void sendRequest(uint32_t command, ppu_address_t argument0, uint32_t task_id)
+        {
+            btAssert(command == CMD_GATHER_AND_PROCESS_PAIRLIST);
+            btAssert(task_id < m_Tasks.Size());
+            Task& task = m_Tasks[task_id];
+            task.m_TaskDesc = (void*) argument0;
+            task.m_Busy = 1;
+            task.m_Job = dmJob::CreateJob(m_JobContext, ProcessTask, this, &task, dmJob::INVALID_JOB);
+            if (task.m_Job == dmJob::INVALID_JOB)
+            {
+                // Out of jobs, process the pairs right away instead
+                processCollisionTask(task.m_TaskDesc, task.m_LocalStore);
+                return;
+            }
+            dmJob::Run(m_JobContext, task.m_Job);
+        }
+
+        virtual void waitForResponse(unsigned int* task_id, unsigned int* status)
+        {
+            // Any finished task will do, otherwise help out with the jobs until the first busy task is done
+            uint32_t first_busy = m_Tasks.Size();
+            for (uint32_t i = 0; i < m_Tasks.Size(); ++i)
+            {
+                Task& task = m_Tasks[i];
+                if (!task.m_Busy)
+                    continue;
+                if (task.m_Job == dmJob::INVALID_JOB || dmJob::IsFinished(m_JobContext, task.m_Job))
+                {
+                    first_busy = i;
+                    break;
+                }
+                if (first_busy == m_Tasks.Size())
+                    first_busy = i;
+            }
+            btAssert(first_busy < m_Tasks.Size());
+
+            Task& task = m_Tasks[first_busy];
+            if (task.m_Job != dmJob::INVALID_JOB)
+                dmJob::Wait(m_JobContext, task.m_Job);
+            task.m_Job = dmJob::INVALID_JOB;
+            task.m_Busy = 0;
+            *task_id = first_busy;
+            *status = 1;
+        }
+
+        virtual void startSPU()
+        {
+        }
+
+        virtual void stopSPU()
+        {
+        }
+
+        virtual void setNumTasks(int task_count)
+        {
+            // Fixed at creation, the local stores are allocated per task
+        }
+
+        virtual int getNumTasks() const
+        {
+            return (int) m_Tasks.Size();
+        }
+
+        virtual btBarrier* createBarrier()
+        {
+            // Only used by the parallel constraint solver, which needs all tasks to run at the same time
+            return 0x0;
+        }
+
+        virtual btCriticalSection* createCriticalSection()
+        {
+            return new CriticalSection3D();
+        }
+
+    private:
+        struct Task
+        {
+            dmJob::HJob m_Job;
+            void*       m_TaskDesc;
+            void*       m_LocalStore;
+            uint8_t     m_Busy:1;
+        };
+
+        static void ProcessTask(void* context, void* data)
+        {
+            DM_PROFILE(Physics, "Narrowphase");
+            Task* task = (Task*) data;
+            processCollisionTask(task->m_TaskDesc, task->m_LocalStore);
+        }
+
+        dmJob::HContext m_JobContext;
+        dmArray<Task>   m_Tasks;
+    };
+
     World3D::World3D(HContext3D context, const NewWorldParams& params)
     : m_TriggerOverlaps(context->m_TriggerOverlapCapacity)
+    , m_ContactEvents()
     , m_DebugDraw(&context->m_DebugCallbacks)
     , m_Context(context)
     , m_AllowDynamicTransforms(context->m_AllowDynamicTransforms)
     {
-        m_CollisionConfiguration = new btDefaultCollisionConfiguration();
-        m_Dispatcher = new btCollisionDispatcher(m_CollisionConfiguration);
+        m_ThreadSupport = 0x0;
+        if (context->m_JobContext)
+        {
+            // The narrowphase is split into one task per thread, the calling thread included
+            uint32_t task_count = dmJob::GetWorkerCount(context->m_JobContext) + 1;
+            btDefaultCollisionConstructionInfo construction_info;
+            construction_info.m_customCollisionAlgorithmMaxElementSize = sizeof(SpuContactManifoldCollisionAlgorithm);
+            m_CollisionConfiguration = new btDefaultCollisionConfiguration(construction_info);
+            m_ThreadSupport = new JobThreadSupport3D(context->m_JobContext, task_count);
+            m_Dispatcher = new SpuGatheringCollisionDispatcher(m_ThreadSupport, task_count, m_CollisionConfiguration);
+        }
+        else
+        {
+            m_CollisionConfiguration = new btDefaultCollisionConfiguration();
+            m_Dispatcher = new btCollisionDispatcher(m_CollisionConfiguration);
+        }
 
         ///the maximum size of the collision world. Make sure objects stay within these boundaries
         ///Don't make the world AABB size too large, it will harm simulation quality and performance
@@ -146,6 +339,9 @@ namespace dmPhysics
         m_Solver = new btSequentialImpulseConstraintSolver;
 
         m_DynamicsWorld = new btDiscreteDynamicsWorld(m_Dispatcher, m_OverlappingPairCache, m_Solver, m_CollisionConfiguration);
+        // Only the bounds of active objects are updated each step. Objects are activated when moved,
+        // so the static and sleeping objects stay untouched in the broadphase.
+        m_DynamicsWorld->setForceUpdateAllAabbs(false);
         m_DynamicsWorld->setGravity(btVector3(context->m_Gravity.getX(), context->m_Gravity.getY(), context->m_Gravity.getZ()));
         m_DynamicsWorld->setDebugDrawer(&m_DebugDraw);
 
@@ -162,6 +358,7 @@ namespace dmPhysics
         delete m_Solver;
         delete m_OverlappingPairCache;
         delete m_Dispatcher;
+        delete m_ThreadSupport;
         delete m_CollisionConfiguration;
     }
 
@@ -284,6 +481,10 @@ namespace dmPhysics
         context->m_RayCastLimit = params.m_RayCastLimit3D;
         context->m_TriggerOverlapCapacity = params.m_TriggerOverlapCapacity;
         context->m_AllowDynamicTransforms = params.m_AllowDynamicTransforms;
+        if (params.m_JobContext && dmJob::GetWorkerCount(params.m_JobContext) > 0)
+        {
+            context->m_JobContext = params.m_JobContext;
+        }
         dmMessage::Result result = dmMessage::NewSocket(PHYSICS_SOCKET_NAME, &context->m_Socket);
         if (result != dmMessage::RESULT_OK)
         {
@@ -357,6 +558,7 @@ namespace dmPhysics
 
     void StepWorld3D(HWorld3D world, const StepWorldContext& step_context)
     {
+        DM_MEM_SCOPE(Physics);
         float dt = step_context.m_DT;
         HContext3D context = world->m_Context;
         float scale = context->m_Scale;
@@ -422,6 +624,8 @@ namespace dmPhysics
             DM_PROFILE(Physics, "StepSimulation");
             // Step simulation
             // TODO: Max substeps = 1 for now...
+            // The transforms are written back through the motion states, which Bullet only synchronizes
+            // for active bodies. Bodies are deactivated before they are integrated, so sleeping bodies never moved.
             world->m_DynamicsWorld->stepSimulation(dt, 1);
         }
 
@@ -494,14 +698,25 @@ namespace dmPhysics
                 if (max_impulse < contact_impulse_limit)
                     continue;
 
-                if (collision_callback != 0x0 && requests_collision_callbacks && num_contacts > 0)
+                // Drop the contact before anything is built if neither object subscribes to it
+                uint16_t events = ContactEventCacheGetEvents(&world->m_ContactEvents, object_a, object_b);
+                if ((events & (CONTACT_EVENTS_COLLISION | CONTACT_EVENTS_CONTACT_POINT)) == 0 || num_contacts == 0)
+                    continue;
+                uint16_t group_a = object_a->getBroadphaseHandle()->m_collisionFilterGroup;
+                uint16_t group_b = object_b->getBroadphaseHandle()->m_collisionFilterGroup;
+                ContactAggregate* aggregate;
+                if (!ContactEventCacheAddContact(&world->m_ContactEvents, object_a, object_b, events,
+                                                 object_a->getUserPointer(), group_a, object_b->getUserPointer(), group_b, &aggregate))
+                    continue;
+
+                if (collision_callback != 0x0 && requests_collision_callbacks && aggregate == 0x0 && (events & CONTACT_EVENTS_COLLISION))
                 {
-                    requests_collision_callbacks = collision_callback(object_a->getUserPointer(), object_a->getBroadphaseHandle()->m_collisionFilterGroup, object_b->getUserPointer(), object_b->getBroadphaseHandle()->m_collisionFilterGroup, step_context.m_CollisionUserData);
+                    requests_collision_callbacks = collision_callback(object_a->getUserPointer(), group_a, object_b->getUserPointer(), group_b, step_context.m_CollisionUserData);
                 }
 
                 bool is_trigger_contact = object_a->getInternalType() == btCollisionObject::CO_GHOST_OBJECT || object_b->getInternalType() == btCollisionObject::CO_GHOST_OBJECT;
 
-                if (contact_point_callback != 0x0 && !is_trigger_contact)
+                if (contact_point_callback != 0x0 && !is_trigger_contact && (events & CONTACT_EVENTS_CONTACT_POINT))
                 {
                     for (int j = 0; j < num_contacts && requests_contact_callbacks; ++j)
                     {
@@ -513,13 +728,13 @@ namespace dmPhysics
                         const btVector3& pt_a = pt.getPositionWorldOnA();
                         FromBt(pt_a, point.m_PositionA, inv_scale);
                         point.m_UserDataA = object_a->getUserPointer();
-                        point.m_GroupA = object_a->getBroadphaseHandle()->m_collisionFilterGroup;
+                        point.m_GroupA = group_a;
                         if (body_a)
                             point.m_MassA = 1.0f / body_a->getInvMass();
                         const btVector3& pt_b = pt.getPositionWorldOnB();
                         FromBt(pt_b, point.m_PositionB, inv_scale);
                         point.m_UserDataB = object_b->getUserPointer();
-                        point.m_GroupB = object_b->getBroadphaseHandle()->m_collisionFilterGroup;
+                        point.m_GroupB = group_b;
                         if (body_b)
                             point.m_MassB = 1.0f / body_b->getInvMass();
                         const btVector3& normal = pt.m_normalWorldOnB;
@@ -539,11 +754,15 @@ namespace dmPhysics
                             FromBt(v, vel_b, inv_scale);
                         }
                         point.m_RelativeVelocity = vel_a - vel_b;
-                        requests_contact_callbacks = contact_point_callback(point, step_context.m_ContactPointUserData);
+                        if (aggregate != 0x0)
+                            ContactAggregateAddPoint(aggregate, point);
+                        else
+                            requests_contact_callbacks = contact_point_callback(point, step_context.m_ContactPointUserData);
                     }
                 }
             }
         }
+        ContactEventCacheFlush(&world->m_ContactEvents, step_context);
         UpdateOverlapCache(&world->m_TriggerOverlaps, context, dispatcher, step_context);
         world->m_DynamicsWorld->debugDrawWorld();
     }
@@ -785,6 +1004,7 @@ namespace dmPhysics
             }
         }
         collision_object->setUserPointer(data.m_UserData);
+        ContactEventCacheSetEvents(&world->m_ContactEvents, collision_object, data.m_ContactEvents);
         CollisionObject3D* co = new CollisionObject3D();
         co->m_CollisionObject = collision_object;
         co->m_CollisionGroup = data.m_Group;
@@ -796,6 +1016,7 @@ namespace dmPhysics
     {
         CollisionObject3D* co = (CollisionObject3D*)collision_object;
         OverlapCacheRemove(&world->m_TriggerOverlaps, co->m_CollisionObject);
+        ContactEventCacheRemove(&world->m_ContactEvents, co->m_CollisionObject);
         btCollisionObject* bt_co = co->m_CollisionObject;
         if (bt_co == 0x0)
             return;
@@ -1014,6 +1235,16 @@ namespace dmPhysics
         co->activate();
     }
 
+    void SetContactEvents3D(HWorld3D world, HCollisionObject3D collision_object, uint16_t events)
+    {
+        ContactEventCacheSetEvents(&world->m_ContactEvents, GetCollisionObject(collision_object), events);
+    }
+
+    uint16_t GetContactEvents3D(HWorld3D world, HCollisionObject3D collision_object)
+    {
+        return ContactEventCacheGetEvents(&world->m_ContactEvents, GetCollisionObject(collision_object));
+    }
+
     void SetLockedRotation3D(HCollisionObject3D collision_object, bool locked_rotation) {
         btCollisionObject* co = GetCollisionObject(collision_object);
         btRigidBody* body = btRigidBody::upcast(co);
@@ -1162,6 +1393,186 @@ namespace dmPhysics
         }
     }
 
+    void RayCastBatch3D(HWorld3D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count, dmJob::HContext job_context)
+    {
+        DM_PROFILE(Physics, "RayCastBatch");
+
+        // The rays are cast serially, Bullet's rayTest records into its global profiler and isn't safe to call concurrently
+        (void)job_context;
+
+        float scale = world->m_Context->m_Scale;
+        float inv_scale = world->m_Context->m_InvScale;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const RayCastRequest& request = requests[i];
+            RayCastResponse& response = responses[i];
+            response.m_Hit = 0;
+            if (Vectormath::Aos::lengthSqr(request.m_To - request.m_From) <= 0.0f)
+                continue;
+
+            btVector3 from;
+            ToBt(request.m_From, from, scale);
+            btVector3 to;
+            ToBt(request.m_To, to, scale);
+
+            RayCastResultClosestCallback3D result_callback(from, to, request.m_Mask, request.m_IgnoredUserData);
+            world->m_DynamicsWorld->rayTest(from, to, result_callback);
+            if (result_callback.hasHit())
+            {
+                ResponseFromRayCastResult(response, inv_scale, result_callback.m_closestHitFraction, result_callback.m_hitPointWorld, result_callback.m_hitNormalWorld, result_callback.m_collisionObject);
+            }
+        }
+    }
+
+    // The shape and transform of a query, in physics units
+    struct QueryShape3D
+    {
+        QueryShape3D(const ShapeQueryRequest& request, const Vectormath::Aos::Point3& position, float scale)
+        : m_Sphere(request.m_Extents.getX() * scale)
+        , m_Box(btVector3(request.m_Extents.getX(), request.m_Extents.getY(), request.m_Extents.getZ()) * scale)
+        {
+            m_Shape = request.m_ShapeType == QUERY_SHAPE_TYPE_SPHERE ? (btConvexShape*)&m_Sphere : (btConvexShape*)&m_Box;
+            m_Transform.setIdentity();
+            if (request.m_ShapeType == QUERY_SHAPE_TYPE_BOX)
+            {
+                const Vectormath::Aos::Quat& r = request.m_Rotation;
+                m_Transform.setRotation(btQuaternion(r.getX(), r.getY(), r.getZ(), r.getW()));
+            }
+            btVector3 bt_position;
+            ToBt(position, bt_position, scale);
+            m_Transform.setOrigin(bt_position);
+        }
+
+        btSphereShape   m_Sphere;
+        btBoxShape      m_Box;
+        btConvexShape*  m_Shape;
+        btTransform     m_Transform;
+    };
+
+    static bool IsQueryCandidate3D(const btCollisionObject* co, void* ignored_user_data)
+    {
+        // Never hit triggers
+        return co->getUserPointer() != ignored_user_data && co->hasContactResponse();
+    }
+
+    struct OverlapResultCallback3D : public btCollisionWorld::ContactResultCallback
+    {
+        OverlapResultCallback3D(const btCollisionObject* query_object, const ShapeQueryRequest& request, dmArray<OverlapResponse>& results)
+        : m_QueryObject(query_object)
+        , m_IgnoredUserData(request.m_IgnoredUserData)
+        , m_Results(results)
+        , m_First(results.Size())
+        {
+            // *all* groups for now, bullet will test this against the colliding object's mask
+            m_collisionFilterGroup = ~0;
+            m_collisionFilterMask = request.m_Mask;
+        }
+
+        virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+        {
+            if (!btCollisionWorld::ContactResultCallback::needsCollision(proxy0))
+                return false;
+            return IsQueryCandidate3D((const btCollisionObject*)proxy0->m_clientObject, m_IgnoredUserData);
+        }
+
+        virtual btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObject* colObj0, int partId0, int index0, const btCollisionObject* colObj1, int partId1, int index1)
+        {
+            // Points within the contact threshold are reported too
+            if (cp.getDistance() > 0.0f)
+                return 0.0f;
+            const btCollisionObject* co = colObj0 == m_QueryObject ? colObj1 : colObj0;
+            void* user_data = co->getUserPointer();
+            // Each object is only reported once
+            for (uint32_t i = m_First; i < m_Results.Size(); ++i)
+            {
+                if (m_Results[i].m_CollisionObjectUserData == user_data)
+                    return 0.0f;
+            }
+            if (m_Results.Full())
+                m_Results.OffsetCapacity(32);
+            OverlapResponse response;
+            response.m_CollisionObjectUserData = user_data;
+            response.m_CollisionObjectGroup = co->getBroadphaseHandle()->m_collisionFilterGroup;
+            m_Results.Push(response);
+            return 0.0f;
+        }
+
+        const btCollisionObject*    m_QueryObject;
+        void*                       m_IgnoredUserData;
+        dmArray<OverlapResponse>&   m_Results;
+        uint32_t                    m_First;
+    };
+
+    void OverlapBatch3D(HWorld3D world, const ShapeQueryRequest* requests, uint32_t count, dmArray<OverlapResponse>& results, uint32_t* result_counts)
+    {
+        DM_PROFILE(Physics, "OverlapBatch");
+
+        float scale = world->m_Context->m_Scale;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const ShapeQueryRequest& request = requests[i];
+            QueryShape3D shape(request, request.m_From, scale);
+            btCollisionObject query_object;
+            query_object.setCollisionShape(shape.m_Shape);
+            query_object.setWorldTransform(shape.m_Transform);
+
+            uint32_t first = results.Size();
+            OverlapResultCallback3D result_callback(&query_object, request, results);
+            world->m_DynamicsWorld->contactTest(&query_object, result_callback);
+            result_counts[i] = results.Size() - first;
+        }
+    }
+
+    struct ShapeCastResultCallback3D : public btCollisionWorld::ClosestConvexResultCallback
+    {
+        ShapeCastResultCallback3D(const btVector3& from, const btVector3& to, uint16_t mask, void* ignored_user_data)
+        : btCollisionWorld::ClosestConvexResultCallback(from, to)
+        , m_IgnoredUserData(ignored_user_data)
+        {
+            // *all* groups for now, bullet will test this against the colliding object's mask
+            m_collisionFilterGroup = ~0;
+            m_collisionFilterMask = mask;
+        }
+
+        virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+        {
+            if (!btCollisionWorld::ClosestConvexResultCallback::needsCollision(proxy0))
+                return false;
+            return IsQueryCandidate3D((const btCollisionObject*)proxy0->m_clientObject, m_IgnoredUserData);
+        }
+
+        void* m_IgnoredUserData;
+    };
+
+    void ShapeCastBatch3D(HWorld3D world, const ShapeQueryRequest* requests, RayCastResponse* responses, uint32_t count)
+    {
+        DM_PROFILE(Physics, "ShapeCastBatch");
+
+        float scale = world->m_Context->m_Scale;
+        float inv_scale = world->m_Context->m_InvScale;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const ShapeQueryRequest& request = requests[i];
+            RayCastResponse& response = responses[i];
+            response.m_Hit = 0;
+            if (Vectormath::Aos::lengthSqr(request.m_To - request.m_From) <= 0.0f)
+                continue;
+
+            QueryShape3D shape(request, request.m_From, scale);
+            btTransform to = shape.m_Transform;
+            btVector3 bt_to;
+            ToBt(request.m_To, bt_to, scale);
+            to.setOrigin(bt_to);
+
+            ShapeCastResultCallback3D result_callback(shape.m_Transform.getOrigin(), bt_to, request.m_Mask, request.m_IgnoredUserData);
+            world->m_DynamicsWorld->convexSweepTest(shape.m_Shape, shape.m_Transform, to, result_callback);
+            if (result_callback.hasHit())
+            {
+                ResponseFromRayCastResult(response, inv_scale, result_callback.m_closestHitFraction, result_callback.m_hitPointWorld, result_callback.m_hitNormalWorld, result_callback.m_hitCollisionObject);
+            }
+        }
+    }
+
     void SetGravity3D(HWorld3D world, const Vectormath::Aos::Vector3& gravity)
     {
         HContext3D context = world->m_Context;
@@ -1202,6 +1613,8 @@ namespace dmPhysics
                             btTransform t = compound_shape->getChildTransform(k);
                             compound_shape->removeChildShape(child);
                             compound_shape->addChildShape(t, (btConvexShape*)new_shape);
+                            // Inactive objects, e.g. static ones, don't get their bounds updated by the step
+                            context->m_Worlds[i]->m_DynamicsWorld->updateSingleAabb(objects[j]);
                             break;
                         }
                     }
@@ -19,6 +19,8 @@
 #include "physics_private.h"
 #include "debug_draw_3d.h"
 
+class btThreadSupportInterface;
+
 namespace dmPhysics
 {
     struct World3D
@@ -27,6 +29,7 @@ namespace dmPhysics
         ~World3D();
 
         OverlapCache                            m_TriggerOverlaps;
+        ContactEventCache                       m_ContactEvents;
         dmArray<RayCastRequest>                 m_RayCastRequests;
         DebugDraw3D                             m_DebugDraw;
         HContext3D                              m_Context;
@@ -35,6 +38,8 @@ namespace dmPhysics
         btAxisSweep3*                           m_OverlappingPairCache;
         btSequentialImpulseConstraintSolver*    m_Solver;
         btDiscreteDynamicsWorld*                m_DynamicsWorld;
+        /// Runs the narrowphase tasks on the job system, null if the narrowphase is single threaded
+        btThreadSupportInterface*               m_ThreadSupport;
         GetWorldTransformCallback               m_GetWorldTransform;
         SetWorldTransformCallback               m_SetWorldTransform;
         uint8_t                                 m_AllowDynamicTransforms:1;
@@ -55,6 +60,7 @@ namespace dmPhysics
         float                       m_TriggerEnterLimit;
         int                         m_RayCastLimit;
         int                         m_TriggerOverlapCapacity;
+        dmJob::HContext             m_JobContext;
         uint8_t                     m_AllowDynamicTransforms:1;
         uint8_t                     :7;
     };
@@ -163,6 +163,15 @@ namespace dmPhysics
     {
     }
 
+    void SetContactEvents3D(HWorld3D world, HCollisionObject3D collision_object, uint16_t events)
+    {
+    }
+
+    uint16_t GetContactEvents3D(HWorld3D world, HCollisionObject3D collision_object)
+    {
+        return CONTACT_EVENTS_DEFAULT;
+    }
+
     void SetLockedRotation3D(HCollisionObject3D collision_object, bool locked_rotation)
     {
     }
@@ -198,6 +207,24 @@ namespace dmPhysics
     {
     }
 
+    void RayCastBatch3D(HWorld3D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count, dmJob::HContext job_context)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            responses[i].m_Hit = 0;
+    }
+
+    void OverlapBatch3D(HWorld3D world, const ShapeQueryRequest* requests, uint32_t count, dmArray<OverlapResponse>& results, uint32_t* result_counts)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            result_counts[i] = 0;
+    }
+
+    void ShapeCastBatch3D(HWorld3D world, const ShapeQueryRequest* requests, RayCastResponse* responses, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            responses[i].m_Hit = 0;
+    }
+
     void SetGravity3D(HWorld3D world, const Vectormath::Aos::Vector3& gravity)
     {
     }
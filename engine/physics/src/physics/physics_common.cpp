@@ -30,6 +30,7 @@ namespace dmPhysics
     , m_RayCastLimit2D(0)
     , m_RayCastLimit3D(0)
     , m_TriggerOverlapCapacity(0)
+    , m_JobContext(0)
     , m_AllowDynamicTransforms(0)
     {
 
@@ -59,6 +60,7 @@ namespace dmPhysics
     , m_LockedRotation(0)
     , m_Bullet(0)
     , m_Enabled(1)
+    , m_ContactEvents(CONTACT_EVENTS_DEFAULT)
     {
 
     }
@@ -79,6 +81,18 @@ namespace dmPhysics
 
     }
 
+    ShapeQueryRequest::ShapeQueryRequest()
+    : m_From(0.0f, 0.0f, 0.0f)
+    , m_To(0.0f, 0.0f, 0.0f)
+    , m_Rotation(Vectormath::Aos::Quat::identity())
+    , m_Extents(0.0f, 0.0f, 0.0f)
+    , m_IgnoredUserData((void*)~0) // unlikely user data to ignore
+    , m_Mask(~0)
+    , m_ShapeType(QUERY_SHAPE_TYPE_AABB)
+    {
+
+    }
+
     RayCastResponse::RayCastResponse()
     : m_Fraction(1.0f)
     , m_Position(0.0f, 0.0f, 0.0f)
@@ -108,6 +122,15 @@ namespace dmPhysics
 
     }
 
+    ContactEventCache::ContactEventCache()
+    : m_Events()
+    , m_PrevPairs()
+    , m_Pairs()
+    , m_Aggregates()
+    {
+
+    }
+
     OverlapCacheAddData::OverlapCacheAddData()
     {
         memset(this, 0, sizeof(*this));
@@ -13,6 +13,7 @@
 #ifndef PHYSICS_PRIVATE_H
 #define PHYSICS_PRIVATE_H
 
+#include <dlib/array.h>
 #include <dlib/hashtable.h>
 
 namespace dmPhysics
@@ -123,6 +124,83 @@ namespace dmPhysics
      * if it is the last known occurrence of overlap.
      */
     void OverlapCachePrune(OverlapCache* cache, const OverlapCachePruneData& data);
+
+    /**
+     * The contacts between two objects merged during a step, see CONTACT_EVENTS_AGGREGATE.
+     * The sums are turned into averages when the aggregate is reported.
+     */
+    struct ContactAggregate
+    {
+        /// Point with summed positions, normals and velocities, summed impulses and max distance
+        ContactPoint m_Point;
+        uint32_t m_PointCount;
+        /// Union of the events of the contacts
+        uint16_t m_Events;
+    };
+
+    /**
+     * Contact events of the objects in a world, and the pairs tracked for the first contact
+     * and aggregate modes. Objects using CONTACT_EVENTS_DEFAULT are not stored, so a world
+     * without any other events only pays for an empty table lookup per contact.
+     */
+    struct ContactEventCache
+    {
+        ContactEventCache();
+
+        /// Events of the objects not using CONTACT_EVENTS_DEFAULT
+        dmHashTable<uintptr_t, uint16_t>    m_Events;
+        /// Pairs touching during the previous step
+        dmHashTable64<uint32_t>             m_PrevPairs;
+        /// Pairs touching during this step, mapped to their index in m_Aggregates or INVALID_AGGREGATE
+        dmHashTable64<uint32_t>             m_Pairs;
+        /// Aggregates of this step, in the order the pairs were first reported
+        dmArray<ContactAggregate>           m_Aggregates;
+    };
+
+    /**
+     * Set the events of an object, and stop tracking it when set to CONTACT_EVENTS_DEFAULT.
+     */
+    void ContactEventCacheSetEvents(ContactEventCache* cache, void* object, uint16_t events);
+
+    /**
+     * The events of an object.
+     */
+    uint16_t ContactEventCacheGetEvents(ContactEventCache* cache, void* object);
+
+    /**
+     * Remove an object from the cache.
+     */
+    void ContactEventCacheRemove(ContactEventCache* cache, void* object);
+
+    /**
+     * The combined events of a contact between two objects.
+     */
+    inline uint16_t ContactEventCacheGetEvents(ContactEventCache* cache, void* object_a, void* object_b)
+    {
+        if (cache->m_Events.Empty())
+        {
+            return CONTACT_EVENTS_DEFAULT;
+        }
+        return ContactEventCacheGetEvents(cache, object_a) | ContactEventCacheGetEvents(cache, object_b);
+    }
+
+    /**
+     * Applies the first contact and aggregate modes to a contact between two objects.
+     * Returns false if the contact should not be reported. Otherwise, if the contact should be
+     * merged with the other contacts of the pair, out_aggregate is set to the aggregate to add
+     * the contact to, and to 0 if the contact should be reported directly.
+     */
+    bool ContactEventCacheAddContact(ContactEventCache* cache, void* object_a, void* object_b, uint16_t events, void* user_data_a, uint16_t group_a, void* user_data_b, uint16_t group_b, ContactAggregate** out_aggregate);
+
+    /**
+     * Add a contact point to an aggregate. The point may have the objects in either order.
+     */
+    void ContactAggregateAddPoint(ContactAggregate* aggregate, const ContactPoint& point);
+
+    /**
+     * Report the aggregates of the step through the callbacks of the step context and start tracking the next step.
+     */
+    void ContactEventCacheFlush(ContactEventCache* cache, const StepWorldContext& step_context);
 }
 
 #endif // PHYSICS_PRIVATE_H
@@ -118,6 +118,7 @@ Test3D::Test3D()
 , m_SetEnabledFunc(dmPhysics::SetEnabled3D)
 , m_IsSleepingFunc(dmPhysics::IsSleeping3D)
 , m_WakeupFunc(dmPhysics::Wakeup3D)
+, m_SetContactEventsFunc(dmPhysics::SetContactEvents3D)
 , m_SetLockedRotationFunc(dmPhysics::SetLockedRotation3D)
 , m_GetLinearDampingFunc(dmPhysics::GetLinearDamping3D)
 , m_SetLinearDampingFunc(dmPhysics::SetLinearDamping3D)
@@ -126,6 +127,9 @@ Test3D::Test3D()
 , m_GetMassFunc(dmPhysics::GetMass3D)
 , m_RequestRayCastFunc(dmPhysics::RequestRayCast3D)
 , m_RayCastFunc(dmPhysics::RayCast3D)
+, m_RayCastBatchFunc(dmPhysics::RayCastBatch3D)
+, m_OverlapBatchFunc(dmPhysics::OverlapBatch3D)
+, m_ShapeCastBatchFunc(dmPhysics::ShapeCastBatch3D)
 , m_SetDebugCallbacksFunc(dmPhysics::SetDebugCallbacks3D)
 , m_ReplaceShapeFunc(dmPhysics::ReplaceShape3D)
 , m_SetGravityFunc(dmPhysics::SetGravity3D)
@@ -176,6 +180,7 @@ Test2D::Test2D()
 , m_SetEnabledFunc(dmPhysics::SetEnabled2D)
 , m_IsSleepingFunc(dmPhysics::IsSleeping2D)
 , m_WakeupFunc(dmPhysics::Wakeup2D)
+, m_SetContactEventsFunc(dmPhysics::SetContactEvents2D)
 , m_SetLockedRotationFunc(dmPhysics::SetLockedRotation2D)
 , m_GetLinearDampingFunc(dmPhysics::GetLinearDamping2D)
 , m_SetLinearDampingFunc(dmPhysics::SetLinearDamping2D)
@@ -184,6 +189,9 @@ Test2D::Test2D()
 , m_GetMassFunc(dmPhysics::GetMass2D)
 , m_RequestRayCastFunc(dmPhysics::RequestRayCast2D)
 , m_RayCastFunc(dmPhysics::RayCast2D)
+, m_RayCastBatchFunc(dmPhysics::RayCastBatch2D)
+, m_OverlapBatchFunc(dmPhysics::OverlapBatch2D)
+, m_ShapeCastBatchFunc(dmPhysics::ShapeCastBatch2D)
 , m_SetDebugCallbacksFunc(dmPhysics::SetDebugCallbacks2D)
 , m_ReplaceShapeFunc(dmPhysics::ReplaceShape2D)
 , m_SetGravityFunc(dmPhysics::SetGravity2D)
@@ -595,6 +603,71 @@ TYPED_TEST(PhysicsTest, CollisionCallbacks)
     (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(box_shape);
 }
 
+TYPED_TEST(PhysicsTest, ContactEvents)
+{
+    float ground_height_half_ext = 1.0f;
+    float box_half_ext = 0.5f;
+
+    VisualObject ground_visual_object;
+    dmPhysics::CollisionObjectData ground_data;
+    typename TypeParam::CollisionShapeType ground_shape = (*TestFixture::m_Test.m_NewBoxShapeFunc)(TestFixture::m_Context, Vector3(100, ground_height_half_ext, 100));
+    ground_data.m_Mass = 0.0f;
+    ground_data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_STATIC;
+    ground_data.m_UserData = &ground_visual_object;
+    typename TypeParam::CollisionObjectType ground_co = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, ground_data, &ground_shape, 1u);
+
+    VisualObject box_visual_object;
+    box_visual_object.m_Position = Point3(0, 10, 0);
+    dmPhysics::CollisionObjectData box_data;
+    typename TypeParam::CollisionShapeType box_shape = (*TestFixture::m_Test.m_NewBoxShapeFunc)(TestFixture::m_Context, Vector3(box_half_ext, box_half_ext, box_half_ext));
+    box_data.m_UserData = &box_visual_object;
+    typename TypeParam::CollisionObjectType box_co = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, box_data, &box_shape, 1u);
+
+    // Only collision responses of the first contact
+    (*TestFixture::m_Test.m_SetContactEventsFunc)(TestFixture::m_World, ground_co, 0);
+    (*TestFixture::m_Test.m_SetContactEventsFunc)(TestFixture::m_World, box_co, dmPhysics::CONTACT_EVENTS_COLLISION | dmPhysics::CONTACT_EVENTS_FIRST_CONTACT);
+
+    TestFixture::m_CollisionCount = 0;
+    TestFixture::m_ContactPointCount = 0;
+    float last_y = 0.0f;
+    for (int i = 0; i < 200 && box_visual_object.m_Position.getY() != last_y; ++i)
+    {
+        last_y = box_visual_object.m_Position.getY();
+        (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+    }
+    ASSERT_EQ(1, TestFixture::m_CollisionCount);
+    ASSERT_EQ(0, TestFixture::m_ContactPointCount);
+
+    // One aggregated collision response and contact point per step while resting on the ground
+    (*TestFixture::m_Test.m_SetContactEventsFunc)(TestFixture::m_World, box_co, dmPhysics::CONTACT_EVENTS_DEFAULT | dmPhysics::CONTACT_EVENTS_AGGREGATE);
+    (*TestFixture::m_Test.m_WakeupFunc)(box_co);
+    TestFixture::m_CollisionCount = 0;
+    TestFixture::m_ContactPointCount = 0;
+    for (int i = 0; i < 5; ++i)
+    {
+        (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+    }
+    ASSERT_EQ(5, TestFixture::m_CollisionCount);
+    ASSERT_EQ(5, TestFixture::m_ContactPointCount);
+
+    // No contact events at all
+    (*TestFixture::m_Test.m_SetContactEventsFunc)(TestFixture::m_World, box_co, 0);
+    (*TestFixture::m_Test.m_WakeupFunc)(box_co);
+    TestFixture::m_CollisionCount = 0;
+    TestFixture::m_ContactPointCount = 0;
+    for (int i = 0; i < 5; ++i)
+    {
+        (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+    }
+    ASSERT_EQ(0, TestFixture::m_CollisionCount);
+    ASSERT_EQ(0, TestFixture::m_ContactPointCount);
+
+    (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, ground_co);
+    (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, box_co);
+    (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(ground_shape);
+    (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(box_shape);
+}
+
 bool TriggerCollisionCallback(void* user_data_a, uint16_t group_a, void* user_data_b, uint16_t group_b, void* user_data)
 {
     VisualObject* vo = (VisualObject*)user_data_a;
@@ -1044,6 +1117,139 @@ TYPED_TEST(PhysicsTest, RayCasting)
     (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(shape);
 }
 
+TYPED_TEST(PhysicsTest, RayCastBatch)
+{
+    float box_half_ext = 0.5f;
+    VisualObject vo;
+    dmPhysics::CollisionObjectData data;
+    typename TypeParam::CollisionShapeType shape = (*TestFixture::m_Test.m_NewBoxShapeFunc)(TestFixture::m_Context, Vector3(box_half_ext, box_half_ext, box_half_ext));
+    data.m_Mass = 0.0f;
+    data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_KINEMATIC;
+    data.m_UserData = &vo;
+    typename TypeParam::CollisionObjectType box_co = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, data, &shape, 1u);
+
+    (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+
+    dmJob::NewContextParams job_params;
+    job_params.m_WorkerCount = 2;
+    dmJob::HContext job_context = dmJob::NewContext(job_params);
+
+    // Every other ray misses the box, enough rays to be spread over the workers
+    const uint32_t count = 256;
+    dmPhysics::RayCastRequest requests[count];
+    dmPhysics::RayCastResponse responses[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        float x = (i & 1) ? 2.0f : 0.0f;
+        requests[i].m_From = Vectormath::Aos::Point3(x, 1.0f, 0.0f);
+        requests[i].m_To = Vectormath::Aos::Point3(x, 0.0f, 0.0f);
+    }
+    // Zero length rays are reported as misses
+    requests[2].m_To = requests[2].m_From;
+
+    (*TestFixture::m_Test.m_RayCastBatchFunc)(TestFixture::m_World, requests, responses, count, job_context);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if ((i & 1) || i == 2)
+        {
+            ASSERT_FALSE(responses[i].m_Hit);
+            continue;
+        }
+        ASSERT_TRUE(responses[i].m_Hit);
+        ASSERT_NEAR(0.5f, responses[i].m_Position.getY(), 0.00001f);
+        ASSERT_NEAR(1.0f, responses[i].m_Normal.getY(), 0.00001f);
+        ASSERT_EQ((void*)&vo, (void*)responses[i].m_CollisionObjectUserData);
+    }
+
+    dmJob::DeleteContext(job_context);
+
+    (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, box_co);
+    (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(shape);
+}
+
+TYPED_TEST(PhysicsTest, ShapeQueries)
+{
+    float box_half_ext = 0.5f;
+    VisualObject vo;
+    dmPhysics::CollisionObjectData data;
+    typename TypeParam::CollisionShapeType shape = (*TestFixture::m_Test.m_NewBoxShapeFunc)(TestFixture::m_Context, Vector3(box_half_ext, box_half_ext, box_half_ext));
+    data.m_Mass = 0.0f;
+    data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_KINEMATIC;
+    data.m_UserData = &vo;
+    typename TypeParam::CollisionObjectType box_co = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, data, &shape, 1u);
+
+    // Triggers are never found by the queries
+    VisualObject trigger_vo;
+    trigger_vo.m_Position = Vectormath::Aos::Point3(2.0f, 0.0f, 0.0f);
+    data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_TRIGGER;
+    data.m_UserData = &trigger_vo;
+    typename TypeParam::CollisionObjectType trigger_co = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, data, &shape, 1u);
+
+    (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+
+    dmPhysics::ShapeQueryRequest requests[4];
+    requests[0].m_From = Vectormath::Aos::Point3(0.9f, 0.0f, 0.0f);
+    requests[0].m_ShapeType = dmPhysics::QUERY_SHAPE_TYPE_SPHERE;
+    requests[0].m_Extents = Vector3(0.5f, 0.0f, 0.0f);
+    requests[1] = requests[0];
+    requests[1].m_From = Vectormath::Aos::Point3(2.0f, 0.0f, 0.0f);
+    requests[2].m_From = Vectormath::Aos::Point3(0.0f, 0.7f, 0.0f);
+    requests[2].m_ShapeType = dmPhysics::QUERY_SHAPE_TYPE_AABB;
+    requests[2].m_Extents = Vector3(0.5f, 0.1f, 0.5f);
+    // Rotated 45 degrees, the corner reaches down into the box
+    requests[3] = requests[2];
+    requests[3].m_ShapeType = dmPhysics::QUERY_SHAPE_TYPE_BOX;
+    requests[3].m_Rotation = Vectormath::Aos::Quat::rotationZ((float) (0.25 * M_PI));
+
+    dmArray<dmPhysics::OverlapResponse> results;
+    uint32_t result_counts[4];
+    (*TestFixture::m_Test.m_OverlapBatchFunc)(TestFixture::m_World, requests, 4, results, result_counts);
+
+    ASSERT_EQ(1u, result_counts[0]);
+    ASSERT_EQ(0u, result_counts[1]);
+    ASSERT_EQ(0u, result_counts[2]);
+    ASSERT_EQ(1u, result_counts[3]);
+    ASSERT_EQ(2u, results.Size());
+    ASSERT_EQ((void*)&vo, results[0].m_CollisionObjectUserData);
+    ASSERT_EQ(1, results[0].m_CollisionObjectGroup);
+    ASSERT_EQ((void*)&vo, results[1].m_CollisionObjectUserData);
+
+    // The mask filters out the box
+    requests[0].m_Mask = 2;
+    (*TestFixture::m_Test.m_OverlapBatchFunc)(TestFixture::m_World, requests, 1, results, result_counts);
+    ASSERT_EQ(0u, result_counts[0]);
+
+    dmPhysics::ShapeQueryRequest casts[3];
+    casts[0].m_From = Vectormath::Aos::Point3(0.0f, 2.0f, 0.0f);
+    casts[0].m_To = Vectormath::Aos::Point3(0.0f, 0.0f, 0.0f);
+    casts[0].m_ShapeType = dmPhysics::QUERY_SHAPE_TYPE_SPHERE;
+    casts[0].m_Extents = Vector3(0.25f, 0.0f, 0.0f);
+    casts[1] = casts[0];
+    casts[1].m_From = Vectormath::Aos::Point3(2.0f, 2.0f, 0.0f);
+    casts[1].m_To = Vectormath::Aos::Point3(2.0f, 0.0f, 0.0f);
+    // Zero length casts are reported as misses
+    casts[2] = casts[0];
+    casts[2].m_To = casts[2].m_From;
+
+    dmPhysics::RayCastResponse responses[3];
+    (*TestFixture::m_Test.m_ShapeCastBatchFunc)(TestFixture::m_World, casts, responses, 3);
+
+    float tolerance = 2.0f * TestFixture::m_Test.m_PolygonRadius / PHYSICS_SCALE + 0.001f;
+    ASSERT_TRUE(responses[0].m_Hit);
+    ASSERT_NEAR(0.625f, responses[0].m_Fraction, tolerance);
+    ASSERT_NEAR(0.0f, responses[0].m_Position.getX(), tolerance);
+    ASSERT_NEAR(0.5f, responses[0].m_Position.getY(), tolerance);
+    ASSERT_NEAR(1.0f, responses[0].m_Normal.getY(), 0.001f);
+    ASSERT_EQ((void*)&vo, (void*)responses[0].m_CollisionObjectUserData);
+    ASSERT_FALSE(responses[1].m_Hit);
+    ASSERT_FALSE(responses[2].m_Hit);
+
+    (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, trigger_co);
+    (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, box_co);
+    (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(shape);
+}
+
 TYPED_TEST(PhysicsTest, InsideRayCasting)
 {
     float box_half_ext = 0.5f;
@@ -1691,6 +1897,50 @@ TYPED_TEST(PhysicsTest, KinematicSleep)
     (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(box0_shape);
 }
 
+TYPED_TEST(PhysicsTest, SleepingWorldTransform)
+{
+    float ground_height_half_ext = 1.0f;
+    float box_half_ext = 0.5f;
+
+    VisualObject ground_visual_object;
+    dmPhysics::CollisionObjectData ground_data;
+    typename TypeParam::CollisionShapeType ground_shape = (*TestFixture::m_Test.m_NewBoxShapeFunc)(TestFixture::m_Context, Vector3(100, ground_height_half_ext, 100));
+    ground_data.m_Mass = 0.0f;
+    ground_data.m_Restitution = 0.0f;
+    ground_data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_STATIC;
+    ground_data.m_UserData = &ground_visual_object;
+    typename TypeParam::CollisionObjectType ground_co = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, ground_data, &ground_shape, 1u);
+
+    VisualObject box_visual_object;
+    box_visual_object.m_Position = Point3(0.0f, ground_height_half_ext + box_half_ext, 0.0f);
+    dmPhysics::CollisionObjectData box_data;
+    box_data.m_Restitution = 0.0f;
+    typename TypeParam::CollisionShapeType box_shape = (*TestFixture::m_Test.m_NewBoxShapeFunc)(TestFixture::m_Context, Vector3(box_half_ext, box_half_ext, box_half_ext));
+    box_data.m_UserData = &box_visual_object;
+    typename TypeParam::CollisionObjectType box_co = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, box_data, &box_shape, 1u);
+
+    const float sleep_time = 3.0f; // 2 in bullet, 0.5 in box
+    int steps = (int)(sleep_time / TestFixture::m_StepWorldContext.m_DT);
+    for (int i = 0; i < steps; ++i)
+    {
+        (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+    }
+
+    ASSERT_TRUE((*TestFixture::m_Test.m_IsSleepingFunc)(box_co));
+
+    // Sleeping bodies don't move, so their transforms aren't written back
+    Point3 sentinel(10.0f, 20.0f, 0.0f);
+    box_visual_object.m_Position = sentinel;
+    (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+    ASSERT_EQ(sentinel.getX(), box_visual_object.m_Position.getX());
+    ASSERT_EQ(sentinel.getY(), box_visual_object.m_Position.getY());
+
+    (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, ground_co);
+    (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, box_co);
+    (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(ground_shape);
+    (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(box_shape);
+}
+
 // Although we don't have a good way of testing the functionality here (we do it in an integration test instead),
 // we need to make sure the linking will work as expected
 TYPED_TEST(PhysicsTest, Wakeup)
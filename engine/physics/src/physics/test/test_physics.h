@@ -113,6 +113,7 @@ struct Funcs
     typedef void (*SetEnabledFunc)(typename T::WorldType world, typename T::CollisionObjectType collision_object, bool enabled);
     typedef bool (*IsSleepingFunc)(typename T::CollisionObjectType collision_object);
     typedef void (*WakeupFunc)(typename T::CollisionObjectType collision_object);
+    typedef void (*SetContactEventsFunc)(typename T::WorldType world, typename T::CollisionObjectType collision_object, uint16_t events);
     typedef void (*SetLockedRotationFunc)(typename T::CollisionObjectType collision_object, bool locked_rotation);
     typedef float (*GetLinearDampingFunc)(typename T::CollisionObjectType collision_object);
     typedef void (*SetLinearDampingFunc)(typename T::CollisionObjectType collision_object, float linear_damping);
@@ -121,6 +122,9 @@ struct Funcs
     typedef float (*GetMassFunc)(typename T::CollisionObjectType collision_object);
     typedef void (*RequestRayCastFunc)(typename T::WorldType world, const dmPhysics::RayCastRequest& request);
     typedef void (*RayCastFunc)(typename T::WorldType world, const dmPhysics::RayCastRequest& request, dmArray<dmPhysics::RayCastResponse>& results);
+    typedef void (*RayCastBatchFunc)(typename T::WorldType world, const dmPhysics::RayCastRequest* requests, dmPhysics::RayCastResponse* responses, uint32_t count, dmJob::HContext job_context);
+    typedef void (*OverlapBatchFunc)(typename T::WorldType world, const dmPhysics::ShapeQueryRequest* requests, uint32_t count, dmArray<dmPhysics::OverlapResponse>& results, uint32_t* result_counts);
+    typedef void (*ShapeCastBatchFunc)(typename T::WorldType world, const dmPhysics::ShapeQueryRequest* requests, dmPhysics::RayCastResponse* responses, uint32_t count);
     typedef void (*SetDebugCallbacks)(typename T::ContextType context, const dmPhysics::DebugCallbacks& callbacks);
     typedef void (*ReplaceShapeFunc)(typename T::ContextType context, typename T::CollisionShapeType old_shape, typename T::CollisionShapeType new_shape);
     typedef void (*SetGravityFunc)(typename T::WorldType world, const Vectormath::Aos::Vector3& gravity);
@@ -170,6 +174,7 @@ struct Test3D
     Funcs<Test3D>::SetEnabledFunc                   m_SetEnabledFunc;
     Funcs<Test3D>::IsSleepingFunc                   m_IsSleepingFunc;
     Funcs<Test3D>::WakeupFunc                       m_WakeupFunc;
+    Funcs<Test3D>::SetContactEventsFunc             m_SetContactEventsFunc;
     Funcs<Test3D>::SetLockedRotationFunc            m_SetLockedRotationFunc;
     Funcs<Test3D>::GetLinearDampingFunc             m_GetLinearDampingFunc;
     Funcs<Test3D>::SetLinearDampingFunc             m_SetLinearDampingFunc;
@@ -178,6 +183,9 @@ struct Test3D
     Funcs<Test3D>::GetMassFunc                      m_GetMassFunc;
     Funcs<Test3D>::RequestRayCastFunc               m_RequestRayCastFunc;
     Funcs<Test3D>::RayCastFunc                      m_RayCastFunc;
+    Funcs<Test3D>::RayCastBatchFunc                 m_RayCastBatchFunc;
+    Funcs<Test3D>::OverlapBatchFunc                 m_OverlapBatchFunc;
+    Funcs<Test3D>::ShapeCastBatchFunc               m_ShapeCastBatchFunc;
     Funcs<Test3D>::SetDebugCallbacks                m_SetDebugCallbacksFunc;
     Funcs<Test3D>::ReplaceShapeFunc                 m_ReplaceShapeFunc;
     Funcs<Test3D>::SetGravityFunc                   m_SetGravityFunc;
@@ -228,6 +236,7 @@ struct Test2D
     Funcs<Test2D>::SetEnabledFunc                   m_SetEnabledFunc;
     Funcs<Test2D>::IsSleepingFunc                   m_IsSleepingFunc;
     Funcs<Test2D>::WakeupFunc                       m_WakeupFunc;
+    Funcs<Test2D>::SetContactEventsFunc             m_SetContactEventsFunc;
     Funcs<Test2D>::SetLockedRotationFunc            m_SetLockedRotationFunc;
     Funcs<Test2D>::GetLinearDampingFunc             m_GetLinearDampingFunc;
     Funcs<Test2D>::SetLinearDampingFunc             m_SetLinearDampingFunc;
@@ -236,6 +245,9 @@ struct Test2D
     Funcs<Test2D>::GetMassFunc                      m_GetMassFunc;
     Funcs<Test2D>::RequestRayCastFunc               m_RequestRayCastFunc;
     Funcs<Test2D>::RayCastFunc                      m_RayCastFunc;
+    Funcs<Test2D>::RayCastBatchFunc                 m_RayCastBatchFunc;
+    Funcs<Test2D>::OverlapBatchFunc                 m_OverlapBatchFunc;
+    Funcs<Test2D>::ShapeCastBatchFunc               m_ShapeCastBatchFunc;
     Funcs<Test2D>::SetDebugCallbacks                m_SetDebugCallbacksFunc;
     Funcs<Test2D>::ReplaceShapeFunc                 m_ReplaceShapeFunc;
     Funcs<Test2D>::SetGravityFunc                   m_SetGravityFunc;
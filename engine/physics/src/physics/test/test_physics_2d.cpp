@@ -1662,6 +1662,94 @@ TYPED_TEST(PhysicsTest, GridShapeFlipped)
     dmPhysics::DeleteHullSet2D(hull_set);
 }
 
+// Steps the same scene of separate stacks of boxes on a static ground with and without the job system
+TYPED_TEST(PhysicsTest, ParallelIslands)
+{
+    const uint32_t columns = 64;
+    const uint32_t rows = 3;
+    const uint32_t count = columns * rows;
+
+    dmJob::NewContextParams job_params;
+    job_params.m_WorkerCount = 2;
+    dmJob::HContext job_context = dmJob::NewContext(job_params);
+
+    dmPhysics::NewContextParams context_params;
+    context_params.m_Scale = PHYSICS_SCALE;
+    context_params.m_TriggerOverlapCapacity = 16;
+    context_params.m_JobContext = job_context;
+    dmPhysics::HContext2D context = dmPhysics::NewContext2D(context_params);
+    dmPhysics::NewWorldParams world_params;
+    world_params.m_GetWorldTransformCallback = GetWorldTransform;
+    world_params.m_SetWorldTransformCallback = SetWorldTransform;
+    dmPhysics::HWorld2D world = dmPhysics::NewWorld2D(context, world_params);
+
+    dmPhysics::HContext2D contexts[] = { TestFixture::m_Context, context };
+    dmPhysics::HWorld2D worlds[] = { TestFixture::m_World, world };
+    dmPhysics::HCollisionShape2D ground_shapes[2];
+    dmPhysics::HCollisionShape2D box_shapes[2];
+    dmPhysics::HCollisionObject2D grounds[2];
+    std::vector<dmPhysics::HCollisionObject2D> boxes[2];
+    std::vector<VisualObject> objects[2];
+    VisualObject ground_objects[2];
+    int contact_point_counts[2] = { 0, 0 };
+
+    for (uint32_t w = 0; w < 2; ++w)
+    {
+        dmPhysics::CollisionObjectData data;
+        data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_STATIC;
+        data.m_Mass = 0.0f;
+        data.m_UserData = &ground_objects[w];
+        ground_shapes[w] = dmPhysics::NewBoxShape2D(contexts[w], Vector3(columns * 4.0f, 1.0f, 0.0f));
+        grounds[w] = dmPhysics::NewCollisionObject2D(worlds[w], data, &ground_shapes[w], 1u);
+
+        objects[w].resize(count);
+        box_shapes[w] = dmPhysics::NewBoxShape2D(contexts[w], Vector3(1.0f, 1.0f, 0.0f));
+        data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_DYNAMIC;
+        data.m_Mass = 1.0f;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            VisualObject& vo = objects[w][i];
+            vo.m_Position = Point3((i / rows) * 4.0f, 2.0f + (i % rows) * 2.2f, 0.0f);
+            data.m_UserData = &vo;
+            boxes[w].push_back(dmPhysics::NewCollisionObject2D(worlds[w], data, &box_shapes[w], 1u));
+        }
+    }
+
+    dmPhysics::StepWorldContext step_context = TestFixture::m_StepWorldContext;
+    for (uint32_t i = 0; i < 60; ++i)
+    {
+        for (uint32_t w = 0; w < 2; ++w)
+        {
+            step_context.m_ContactPointUserData = &contact_point_counts[w];
+            dmPhysics::StepWorld2D(worlds[w], step_context);
+        }
+    }
+
+    ASSERT_LT(0, contact_point_counts[0]);
+    ASSERT_EQ(contact_point_counts[0], contact_point_counts[1]);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(objects[0][i].m_Position.getX(), objects[1][i].m_Position.getX());
+        ASSERT_EQ(objects[0][i].m_Position.getY(), objects[1][i].m_Position.getY());
+        ASSERT_EQ(objects[0][i].m_Rotation.getZ(), objects[1][i].m_Rotation.getZ());
+    }
+
+    for (uint32_t w = 0; w < 2; ++w)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            dmPhysics::DeleteCollisionObject2D(worlds[w], boxes[w][i]);
+        }
+        dmPhysics::DeleteCollisionObject2D(worlds[w], grounds[w]);
+        dmPhysics::DeleteCollisionShape2D(box_shapes[w]);
+        dmPhysics::DeleteCollisionShape2D(ground_shapes[w]);
+    }
+
+    dmPhysics::DeleteWorld2D(context, world);
+    dmPhysics::DeleteContext2D(context);
+    dmJob::DeleteContext(job_context);
+}
+
 // Linker checks
 TYPED_TEST(PhysicsTest, SetGridShapeEnable)
 {
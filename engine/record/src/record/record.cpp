@@ -22,9 +22,15 @@
 #include <vpx/vpx_encoder.h>
 #include <vpx/vp8cx.h>
 #include <dlib/log.h>
+#include <dlib/mutex.h>
+#include <dlib/condition_variable.h>
+#include <dlib/thread.h>
 
 namespace dmRecord
 {
+    // Number of frames that can be queued for encoding before RecordFrame blocks
+    const uint32_t FRAME_QUEUE_SIZE = 3;
+
     struct Recorder
     {
         Recorder(const NewParams* params)
@@ -34,6 +40,12 @@ namespace dmRecord
             m_Height = params->m_Height;
             m_Fps = params->m_Fps;
             m_Filename = strdup(params->m_Filename);
+            for (uint32_t i = 0; i < FRAME_QUEUE_SIZE; ++i)
+            {
+                m_Frames[i] = (uint8_t*) malloc(m_Width * m_Height * 4);
+            }
+            m_Mutex = dmMutex::New();
+            m_Condition = dmConditionVariable::New();
         }
 
         ~Recorder()
@@ -43,6 +55,12 @@ namespace dmRecord
             {
                 fclose(m_File);
             }
+            for (uint32_t i = 0; i < FRAME_QUEUE_SIZE; ++i)
+            {
+                free(m_Frames[i]);
+            }
+            dmConditionVariable::Delete(m_Condition);
+            dmMutex::Delete(m_Mutex);
         }
 
         uint32_t            m_Width;
@@ -53,6 +71,16 @@ namespace dmRecord
         vpx_codec_ctx_t     m_Codec;
         vpx_image_t         m_VpxImage;
         uint32_t            m_FrameCount;
+
+        // Frames are converted and encoded on m_Thread. The members below are protected by m_Mutex.
+        uint8_t*                                m_Frames[FRAME_QUEUE_SIZE];
+        uint32_t                                m_FrameQueueHead;
+        uint32_t                                m_FrameQueueCount;
+        Result                                  m_Result; // The first error of the encoding thread
+        bool                                    m_Quit;
+        dmMutex::HMutex                         m_Mutex;
+        dmConditionVariable::HConditionVariable m_Condition;
+        dmThread::Thread                        m_Thread;
     };
 
     static void MemPutLE16(char *mem, unsigned int val)
@@ -109,6 +137,8 @@ namespace dmRecord
         return fwrite(header, 1, sizeof(header), recorder->m_File) == sizeof(header);
     }
 
+    static void EncodeThread(void* arg);
+
     Result New(const NewParams* params, HRecorder* recorder)
     {
         *recorder = 0;
@@ -178,13 +208,14 @@ namespace dmRecord
         r->m_Codec = codec;
         r->m_VpxImage = vpx_image;
         r->m_File = f;
+        r->m_Thread = dmThread::New(EncodeThread, 0x80000, r, "record");
         *recorder = r;
         return RESULT_OK;
     }
 
     /*
-     * TODO: This code needs to be optimized.
-     * RGBA to YV12 with flipped y
+     * BGRA to YV12 with flipped y, with the chroma sampled from the top left pixel of each 2x2 block.
+     * Fixed point, giving the same result as the BT.601 float formulas, so that the compiler can vectorize the rows.
      * Links:
      * http://groups.google.com/a/chromium.org/group/chromium-reviews/browse_thread/thread/720aafe35a78942a?pli=1
      */
@@ -192,17 +223,14 @@ namespace dmRecord
     {
         for (uint32_t iy = 0; iy < height; ++iy)
         {
-            char* y_plane_row = (char*) y_plane;
-            y_plane_row += (height - 1 - iy) * width;
+            const uint8_t* src = rgba + iy * width * 4;
+            uint8_t* y_plane_row = (uint8_t*) y_plane + (height - 1 - iy) * width;
             for (uint32_t ix = 0; ix < width; ++ix)
             {
-                int i = (iy * width + ix) * 4;
-                uint8_t B = rgba[i+0];
-                uint8_t G = rgba[i+1];
-                uint8_t R = rgba[i+2];
-                float y = (float)( R*66 + G*129 + B*25 + 128 ) / 256 + 16;
-                *y_plane_row = (char) y;
-                ++y_plane_row;
+                int32_t B = src[ix * 4 + 0];
+                int32_t G = src[ix * 4 + 1];
+                int32_t R = src[ix * 4 + 2];
+                y_plane_row[ix] = (uint8_t) (((R*66 + G*129 + B*25 + 128) >> 8) + 16);
             }
         }
 
@@ -211,35 +239,31 @@ namespace dmRecord
 
         for (uint32_t iy = 0; iy < half_height; iy++)
         {
-            uint32_t base_src = (iy*2) * width * 4;
-
-            uint8_t *v_plane_row = (uint8_t*)v_plane;
-            uint8_t *u_plane_row = (uint8_t*)u_plane;
-            v_plane_row += (half_height - 1 - iy) * half_width;
-            u_plane_row += (half_height - 1 - iy) * half_width;
+            const uint8_t* src = rgba + (iy*2) * width * 4;
+            uint8_t* v_plane_row = (uint8_t*) v_plane + (half_height - 1 - iy) * half_width;
+            uint8_t* u_plane_row = (uint8_t*) u_plane + (half_height - 1 - iy) * half_width;
 
-            for (uint32_t xPixel = 0; xPixel < half_width; xPixel++ )
+            for (uint32_t ix = 0; ix < half_width; ix++)
             {
-                uint8_t B = rgba[base_src+0];
-                uint8_t G = rgba[base_src+1];
-                uint8_t R = rgba[base_src+2];
-
-                float u = (float)( R*-38 + G*-74 + B*112 + 128 ) / 256 + 128;
-                float v = (float)( R*112 + G*-94 + B*-18 + 128 ) / 256 + 128;
-
-                *v_plane_row = (uint8_t) v;
-                *u_plane_row = (uint8_t) u;
-                ++u_plane_row;
-                ++v_plane_row;
-
-                base_src += 8;
+                int32_t B = src[ix * 8 + 0];
+                int32_t G = src[ix * 8 + 1];
+                int32_t R = src[ix * 8 + 2];
+                // Arithmetic shift, i.e. rounds towards negative infinity like the float version
+                u_plane_row[ix] = (uint8_t) (((R*-38 + G*-74 + B*112 + 128) >> 8) + 128);
+                v_plane_row[ix] = (uint8_t) (((R*112 + G*-94 + B*-18 + 128) >> 8) + 128);
             }
         }
     }
 
     Result Delete(HRecorder recorder)
     {
-        Result result = RESULT_OK;
+        dmMutex::Lock(recorder->m_Mutex);
+        recorder->m_Quit = true;
+        dmConditionVariable::Broadcast(recorder->m_Condition);
+        dmMutex::Unlock(recorder->m_Mutex);
+        dmThread::Join(recorder->m_Thread);
+
+        Result result = recorder->m_Result;
 
         fseek(recorder->m_File, 0, SEEK_SET);
         if (!WriteIvfFileHeader(recorder))
@@ -254,15 +278,14 @@ namespace dmRecord
         return result;
     }
 
-    Result RecordFrame(HRecorder recorder, const void* frame_buffer,
-            uint32_t frame_buffer_size, BufferFormat format)
+    static Result EncodeFrame(HRecorder recorder, const uint8_t* frame_buffer)
     {
         vpx_codec_iter_t iter = NULL;
         const vpx_codec_cx_pkt_t *pkt;
         vpx_codec_err_t res;
         int flags = 0;
 
-        RGBAToYV12FlipY((const uint8_t*) frame_buffer, recorder->m_Width, recorder->m_Height, recorder->m_VpxImage.planes[0], recorder->m_VpxImage.planes[1], recorder->m_VpxImage.planes[2]);
+        RGBAToYV12FlipY(frame_buffer, recorder->m_Width, recorder->m_Height, recorder->m_VpxImage.planes[0], recorder->m_VpxImage.planes[1], recorder->m_VpxImage.planes[2]);
         res = vpx_codec_encode(&recorder->m_Codec, &recorder->m_VpxImage, recorder->m_FrameCount, 1, flags, VPX_DL_REALTIME);
         if (res)
         {
@@ -294,4 +317,71 @@ namespace dmRecord
 
         return RESULT_OK;
     }
+
+    static void EncodeThread(void* arg)
+    {
+        Recorder* recorder = (Recorder*) arg;
+
+        dmMutex::Lock(recorder->m_Mutex);
+        while (true)
+        {
+            while (recorder->m_FrameQueueCount == 0 && !recorder->m_Quit)
+            {
+                dmConditionVariable::Wait(recorder->m_Condition, recorder->m_Mutex);
+            }
+            // Encode the queued frames before quitting
+            if (recorder->m_FrameQueueCount == 0)
+            {
+                break;
+            }
+
+            // The frame isn't written to by RecordFrame until it's removed from the queue
+            const uint8_t* frame = recorder->m_Frames[recorder->m_FrameQueueHead];
+            dmMutex::Unlock(recorder->m_Mutex);
+
+            Result r = EncodeFrame(recorder, frame);
+
+            dmMutex::Lock(recorder->m_Mutex);
+            if (r != RESULT_OK && recorder->m_Result == RESULT_OK)
+            {
+                recorder->m_Result = r;
+            }
+            recorder->m_FrameQueueHead = (recorder->m_FrameQueueHead + 1) % FRAME_QUEUE_SIZE;
+            recorder->m_FrameQueueCount--;
+            dmConditionVariable::Broadcast(recorder->m_Condition);
+        }
+        dmMutex::Unlock(recorder->m_Mutex);
+    }
+
+    Result RecordFrame(HRecorder recorder, const void* frame_buffer,
+            uint32_t frame_buffer_size, BufferFormat format)
+    {
+        const uint32_t size = recorder->m_Width * recorder->m_Height * 4;
+        if (frame_buffer_size < size)
+        {
+            return RESULT_INVAL_ERROR;
+        }
+
+        uint32_t index;
+        {
+            DM_MUTEX_SCOPED_LOCK(recorder->m_Mutex);
+            // Errors of the previous frames are reported here, since the frames are encoded asynchronously
+            if (recorder->m_Result != RESULT_OK)
+            {
+                return recorder->m_Result;
+            }
+            while (recorder->m_FrameQueueCount == FRAME_QUEUE_SIZE)
+            {
+                dmConditionVariable::Wait(recorder->m_Condition, recorder->m_Mutex);
+            }
+            index = (recorder->m_FrameQueueHead + recorder->m_FrameQueueCount) % FRAME_QUEUE_SIZE;
+        }
+
+        memcpy(recorder->m_Frames[index], frame_buffer, size);
+
+        DM_MUTEX_SCOPED_LOCK(recorder->m_Mutex);
+        recorder->m_FrameQueueCount++;
+        dmConditionVariable::Broadcast(recorder->m_Condition);
+        return RESULT_OK;
+    }
 }
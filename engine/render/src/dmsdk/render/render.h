@@ -171,9 +171,15 @@ namespace dmRender
      * @member m_DestinationBlendFactor [type: dmGraphics::BlendFactor] the destination blend factor
      * @member m_StencilTestParams [type: dmRender::StencilTestParams] the stencil test params
      * @member m_VertexStart [type: uint32_t] the vertex start
-     * @member m_VertexCount [type: uint32_t] the vertex count
+     * @member m_VertexCount [type: uint32_t] the vertex count (per instance if m_InstanceCount > 0)
+     * @member m_InstanceVertexBuffer [type: dmGraphics::HVertexBuffer] the per instance vertex buffer
+     * @member m_InstanceVertexDeclaration [type: dmGraphics::HVertexDeclaration] the per instance vertex declaration
+     * @member m_InstanceStart [type: uint32_t] the first instance in the instance vertex buffer
+     * @member m_InstanceCount [type: uint32_t] the number of instances to draw (0 for a regular draw call)
+     * @member m_ScissorRect [type: float[4]] the scissor rectangle (min x, min y, max x, max y) in world space
      * @member m_SetBlendFactors [type: uint8_t:1] use the blend factors
      * @member m_SetStencilTest [type: uint8_t:1] use the stencil test
+     * @member m_SetScissor [type: uint8_t:1] clip to the scissor rectangle
      */
     struct RenderObject
     {
@@ -199,9 +205,15 @@ namespace dmRender
         StencilTestParams               m_StencilTestParams;
         uint32_t                        m_VertexStart;
         uint32_t                        m_VertexCount;
+        dmGraphics::HVertexBuffer       m_InstanceVertexBuffer;
+        dmGraphics::HVertexDeclaration  m_InstanceVertexDeclaration;
+        uint32_t                        m_InstanceStart;
+        uint32_t                        m_InstanceCount;
+        float                           m_ScissorRect[4];
         uint8_t                         m_SetBlendFactors : 1;
         uint8_t                         m_SetStencilTest : 1;
         uint8_t                         m_SetFaceWinding : 1;
+        uint8_t                         m_SetScissor : 1;
     };
 
     /*#
@@ -220,6 +232,8 @@ namespace dmRender
      * @param m_MajorOrder [type: uint32_t:2] If RENDER_ORDER_WORLD, then sorting is done based on the world position.
                                               Otherwise the sorting uses the m_Order value directly.
      * @param m_Dispatch [type: uint32_t:8] The dispatch function callback (dmRender::HRenderListDispatch)
+     * @param m_Layer [type: uint32_t:5] The render layer [0, 31], tested against the layer mask of the draw call.
+                                         Cleared by RenderListAlloc() and RenderListSegmentAlloc()
      */
     struct RenderListEntry
     {
@@ -231,6 +245,7 @@ namespace dmRender
         uint32_t m_MinorOrder:4;
         uint32_t m_MajorOrder:2;
         uint32_t m_Dispatch:8;
+        uint32_t m_Layer:5;
     };
 
     /*#
@@ -308,6 +323,62 @@ namespace dmRender
      */
     HRenderListDispatch RenderListMakeDispatch(HRenderContext context, RenderListDispatchFn fn, void* user_data);
 
+    /*#
+     * World space bounds of a render list entry, as an axis aligned box
+     * @struct
+     * @name RenderListEntryBounds
+     * @member m_Center [type: dmVMath::Point3] the center of the box
+     * @member m_Extents [type: dmVMath::Vector3] the half size of the box along each axis
+     */
+    struct RenderListEntryBounds
+    {
+        dmVMath::Point3  m_Center;
+        dmVMath::Vector3 m_Extents;
+    };
+
+    /*#
+     * Render visibility callback parameters.
+     * The callback is only called when the render script has set a frustum (see render.set_frustum), before the
+     * render list is sorted. It fills in the world space bounds of the entries, and the entries outside of the
+     * frustum are then not dispatched. Entries without known bounds should be given very large extents.
+     * @struct
+     * @name RenderListVisibilityParams
+     * @member m_Context [type: dmRender::HRenderContext] the context
+     * @member m_UserData [type: void*] the callback user data (registered with RenderListMakeDispatch())
+     * @member m_Entries [type: dmRender::RenderListEntry*] the render entry array
+     * @member m_Indices [type: const uint32_t*] the entries of the dispatch, as indices into the m_Entries array
+     * @member m_Bounds [type: dmRender::RenderListEntryBounds*] the bounds to fill in, one per index
+     * @member m_NumEntries [type: uint32_t] the number of indices
+     */
+    struct RenderListVisibilityParams
+    {
+        HRenderContext          m_Context;
+        void*                   m_UserData;
+        RenderListEntry*        m_Entries;
+        const uint32_t*         m_Indices;
+        RenderListEntryBounds*  m_Bounds;
+        uint32_t                m_NumEntries;
+    };
+
+    /*#
+     * Render visibility function callback.
+     * @typedef
+     * @name RenderListVisibilityFn
+     * @param params [type: dmRender::RenderListVisibilityParams] the params
+     */
+    typedef void (*RenderListVisibilityFn)(RenderListVisibilityParams const &params);
+
+    /*#
+     * Register a render dispatch function, with a callback that provides the bounds used for frustum culling
+     * @name RenderListMakeDispatch
+     * @param context [type: dmRender::HRenderContext] the context
+     * @param dispatch_fn [type: dmRender::RenderListDispatchFn] the render batch callback function
+     * @param visibility_fn [type: dmRender::RenderListVisibilityFn] the bounds callback function, 0 if the entries are never culled
+     * @param user_data [type: void*] userdata to the callbacks
+     * @return dispatch [type: dmRender::HRenderListDispatch] the render dispatch function handle
+     */
+    HRenderListDispatch RenderListMakeDispatch(HRenderContext context, RenderListDispatchFn dispatch_fn, RenderListVisibilityFn visibility_fn, void* user_data);
+
     /*#
      * Allocates an array of render entries
      * @note Do not store a pointer into this array, as they're reused next frame
@@ -327,6 +398,49 @@ namespace dmRender
      */
     void RenderListSubmit(HRenderContext context, RenderListEntry* begin, RenderListEntry* end);
 
+    /*#
+     * Adds occluder triangles to the current render frame. The triangles are rasterized into a low resolution
+     * depth buffer when the render list is culled against a frustum, and entries whose bounds are hidden behind
+     * them aren't dispatched. The vertices are copied, the occluder is valid until the next frame.
+     * @name AddOccluder
+     * @param context [type: dmRender::HRenderContext] the context
+     * @param world_transform [type: dmVMath::Matrix4] the transform of the vertices into world space
+     * @param positions [type: const float*] the x, y and z position of the first vertex
+     * @param stride [type: uint32_t] the number of floats from one vertex to the next
+     * @param vertex_count [type: uint32_t] the number of vertices, three per triangle
+     */
+    void AddOccluder(HRenderContext context, const dmVMath::Matrix4& world_transform, const float* positions, uint32_t stride, uint32_t vertex_count);
+
+    /*#
+     * Local light of the current render frame, see [ref:AddLight]
+     * @struct
+     * @name Light
+     * @member m_Position [type: dmVMath::Point3] the world position
+     * @member m_Direction [type: dmVMath::Vector3] the normalized world direction of a spot light
+     * @member m_Color [type: dmVMath::Vector3] the color, multiplied by the intensity
+     * @member m_Range [type: float] the distance at which the light no longer contributes
+     * @member m_ConeCos [type: float] the cosine of half the cone angle of a spot light, -1 for a point light
+     */
+    struct Light
+    {
+        dmVMath::Point3  m_Position;
+        dmVMath::Vector3 m_Direction;
+        dmVMath::Vector3 m_Color;
+        float            m_Range;
+        float            m_ConeCos;
+    };
+
+    /*#
+     * Adds a local light to the current render frame. When a material with a "light_clusters" sampler is drawn,
+     * the lights are assigned to the clusters of the view frustum they reach, and the clusters, the light indices
+     * and the light data are bound to the sampler as a single data texture. The sampler should use nearest filtering.
+     * The light is valid until the next frame.
+     * @name AddLight
+     * @param context [type: dmRender::HRenderContext] the context
+     * @param light [type: const dmRender::Light&] the light, copied
+     */
+    void AddLight(HRenderContext context, const Light& light);
+
     /*#
      * Adds a render object to the current render frame
      * @name AddToRender
@@ -17,6 +17,7 @@
 #include <dlib/array.h>
 #include <dlib/hash.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
 
 #include <graphics/graphics.h>
 
@@ -27,21 +28,14 @@ using namespace Vectormath::Aos;
 
 namespace dmRender
 {
-    struct DebugVertex
-    {
-        Vector4 m_Position;
-        Vector4 m_Color;
-    };
-
     void InitializeDebugRenderer(dmRender::HRenderContext render_context, uint32_t max_vertex_count, const void* vp_desc, uint32_t vp_desc_size, const void* fp_desc, uint32_t fp_desc_size)
     {
         DebugRenderer& debug_renderer = render_context->m_DebugRenderer;
         debug_renderer.m_MaxVertexCount = max_vertex_count;
 
         debug_renderer.m_RenderContext = render_context;
-        const uint32_t buffer_size = max_vertex_count * sizeof(DebugVertex);
-        const uint32_t total_buffer_size = MAX_DEBUG_RENDER_TYPE_COUNT * buffer_size;
-        debug_renderer.m_VertexBuffer = dmGraphics::NewVertexBuffer(render_context->m_GraphicsContext, total_buffer_size, 0x0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+        debug_renderer.m_VertexBufferCapacity = MAX_DEBUG_RENDER_TYPE_COUNT * max_vertex_count;
+        debug_renderer.m_VertexBuffer = dmGraphics::NewVertexBuffer(render_context->m_GraphicsContext, debug_renderer.m_VertexBufferCapacity * sizeof(DebugVertex), 0x0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
         dmGraphics::VertexElement ve[] =
         {
             {"position", 0, 4, dmGraphics::TYPE_FLOAT, false },
@@ -104,7 +98,7 @@ namespace dmRender
             ro.m_VertexCount = 0;
             DebugRenderTypeData& type_data = debug_renderer.m_TypeData[i];
             type_data.m_RenderObject = ro;
-            type_data.m_ClientBuffer = new char[buffer_size];
+            type_data.m_ClientBuffer.SetCapacity(max_vertex_count);
         }
 
         debug_renderer.m_3dPredicate.m_Tags[0] = dmHashString64(DEBUG_3D_NAME);
@@ -134,7 +128,7 @@ namespace dmRender
 
         for (uint32_t i = 0; i < MAX_DEBUG_RENDER_TYPE_COUNT; ++i)
         {
-            delete [] (char*)debug_renderer.m_TypeData[i].m_ClientBuffer;
+            debug_renderer.m_TypeData[i].m_ClientBuffer.SetCapacity(0);
         }
         dmGraphics::DeleteVertexBuffer(debug_renderer.m_VertexBuffer);
         dmGraphics::DeleteVertexDeclaration(debug_renderer.m_VertexDeclaration);
@@ -147,70 +141,57 @@ namespace dmRender
         for (uint32_t i = 0; i < MAX_DEBUG_RENDER_TYPE_COUNT; ++i)
         {
             context->m_DebugRenderer.m_TypeData[i].m_RenderObject.m_VertexCount = 0;
+            context->m_DebugRenderer.m_TypeData[i].m_ClientBuffer.SetSize(0);
         }
         context->m_DebugRenderer.m_RenderBatchVersion = 0;
     }
 
-    static void LogVertexWarning(HRenderContext context)
+    // Returns room for vertex_count more vertices of the type. The buffer grows instead of dropping
+    // vertices, so that large scenes (e.g. with physics debug enabled) are drawn completely.
+    static DebugVertex* AllocDebugVertices(HRenderContext context, DebugRenderType type, uint32_t vertex_count)
     {
-        static bool has_warned = false;
-        if (!has_warned)
+        dmArray<DebugVertex>& buffer = context->m_DebugRenderer.m_TypeData[type].m_ClientBuffer;
+        uint32_t size = buffer.Size();
+        if (buffer.Remaining() < vertex_count)
         {
-            dmLogWarning("Out of debug vertex data (%u). Increase graphics.max_debug_vertices to avoid this warning.", context->m_DebugRenderer.m_MaxVertexCount);
-            has_warned = true;
+            buffer.OffsetCapacity(dmMath::Max(vertex_count, buffer.Capacity()));
         }
+        buffer.SetSize(size + vertex_count);
+        context->m_DebugRenderer.m_TypeData[type].m_RenderObject.m_VertexCount = size + vertex_count;
+        return buffer.Begin() + size;
     }
 
     void Square2d(HRenderContext context, float x0, float y0, float x1, float y1, Vector4 color)
     {
         if (!context->m_DebugRenderer.m_RenderContext)
             return;
-        DebugRenderTypeData& type_data = context->m_DebugRenderer.m_TypeData[DEBUG_RENDER_TYPE_FACE_2D];
-        RenderObject& ro = type_data.m_RenderObject;
         const uint32_t vertex_count = 6;
-        if (ro.m_VertexCount + vertex_count < context->m_DebugRenderer.m_MaxVertexCount)
-        {
-            DebugVertex v[vertex_count];
-            v[0].m_Position = Vector4(x0, y0, 0.0f, 0.0f);
-            v[1].m_Position = Vector4(x0, y1, 0.0f, 0.0f);
-            v[2].m_Position = Vector4(x1, y0, 0.0f, 0.0f);
-            v[5].m_Position = Vector4(x1, y1, 0.0f, 0.0f);
-            v[3].m_Position = v[2].m_Position;
-            v[4].m_Position = v[1].m_Position;
-            for (uint32_t i = 0; i < vertex_count; ++i)
-                v[i].m_Color = color;
-            char* buffer = (char*)type_data.m_ClientBuffer;
-            memcpy(&buffer[ro.m_VertexCount * sizeof(DebugVertex)], (const void*)v, vertex_count * sizeof(DebugVertex));
-            ro.m_VertexCount += vertex_count;
-        }
-        else
-        {
-            LogVertexWarning(context);
-        }
+        DebugVertex* v = AllocDebugVertices(context, DEBUG_RENDER_TYPE_FACE_2D, vertex_count);
+        v[0].m_Position = Vector4(x0, y0, 0.0f, 0.0f);
+        v[1].m_Position = Vector4(x0, y1, 0.0f, 0.0f);
+        v[2].m_Position = Vector4(x1, y0, 0.0f, 0.0f);
+        v[5].m_Position = Vector4(x1, y1, 0.0f, 0.0f);
+        v[3].m_Position = v[2].m_Position;
+        v[4].m_Position = v[1].m_Position;
+        for (uint32_t i = 0; i < vertex_count; ++i)
+            v[i].m_Color = color;
     }
 
     void Triangle3d(HRenderContext context, Point3 vertices[3], Vector4 color)
+    {
+        Triangles3D(context, vertices, 3, color);
+    }
+
+    void Triangles3D(HRenderContext context, const Point3* points, uint32_t point_count, Vector4 color)
     {
         if (!context->m_DebugRenderer.m_RenderContext)
             return;
-        DebugRenderTypeData& type_data = context->m_DebugRenderer.m_TypeData[DEBUG_RENDER_TYPE_FACE_3D];
-        RenderObject& ro = type_data.m_RenderObject;
-        const uint32_t vertex_count = 3;
-        if (ro.m_VertexCount + vertex_count < context->m_DebugRenderer.m_MaxVertexCount)
+        const uint32_t vertex_count = point_count - point_count % 3;
+        DebugVertex* v = AllocDebugVertices(context, DEBUG_RENDER_TYPE_FACE_3D, vertex_count);
+        for (uint32_t i = 0; i < vertex_count; ++i)
         {
-            DebugVertex v[vertex_count];
-            for (uint32_t i = 0; i < vertex_count; ++i)
-            {
-                v[i].m_Position = Vector4(vertices[i]);
-                v[i].m_Color = color;
-            }
-            char* buffer = (char*)type_data.m_ClientBuffer;
-            memcpy(&buffer[ro.m_VertexCount * sizeof(DebugVertex)], (const void*)v, vertex_count * sizeof(DebugVertex));
-            ro.m_VertexCount += vertex_count;
-        }
-        else
-        {
-            LogVertexWarning(context);
+            v[i].m_Position = Vector4(points[i]);
+            v[i].m_Color = color;
         }
     }
 
@@ -218,47 +199,34 @@ namespace dmRender
     {
         if (!context->m_DebugRenderer.m_RenderContext)
             return;
-        DebugRenderTypeData& type_data = context->m_DebugRenderer.m_TypeData[DEBUG_RENDER_TYPE_LINE_2D];
-        RenderObject& ro = type_data.m_RenderObject;
-        const uint32_t vertex_count = 2;
-        if (ro.m_VertexCount + vertex_count < context->m_DebugRenderer.m_MaxVertexCount)
-        {
-            DebugVertex v[vertex_count];
-            v[0].m_Position = Vector4(x0, y0, 0.0f, 0.0f);
-            v[0].m_Color = color0;
-            v[1].m_Position = Vector4(x1, y1, 0.0f, 0.0f);
-            v[1].m_Color = color1;
-            char* buffer = (char*)type_data.m_ClientBuffer;
-            memcpy(&buffer[ro.m_VertexCount * sizeof(DebugVertex)], (const void*)v, vertex_count * sizeof(DebugVertex));
-            ro.m_VertexCount += vertex_count;
-        }
-        else
-        {
-            LogVertexWarning(context);
-        }
+        DebugVertex* v = AllocDebugVertices(context, DEBUG_RENDER_TYPE_LINE_2D, 2);
+        v[0].m_Position = Vector4(x0, y0, 0.0f, 0.0f);
+        v[0].m_Color = color0;
+        v[1].m_Position = Vector4(x1, y1, 0.0f, 0.0f);
+        v[1].m_Color = color1;
     }
 
     void Line3D(HRenderContext context, Point3 start, Point3 end, Vector4 start_color, Vector4 end_color)
     {
         if (!context->m_DebugRenderer.m_RenderContext)
             return;
-        DebugRenderTypeData& type_data = context->m_DebugRenderer.m_TypeData[DEBUG_RENDER_TYPE_LINE_3D];
-        RenderObject& ro = type_data.m_RenderObject;
-        const uint32_t vertex_count = 2;
-        if (ro.m_VertexCount + vertex_count < context->m_DebugRenderer.m_MaxVertexCount)
-        {
-            DebugVertex v[vertex_count];
-            v[0].m_Position = Vector4(start);
-            v[0].m_Color = start_color;
-            v[1].m_Position = Vector4(end);
-            v[1].m_Color = end_color;
-            char* buffer = (char*)type_data.m_ClientBuffer;
-            memcpy(&buffer[ro.m_VertexCount * sizeof(DebugVertex)], (const void*)v, vertex_count * sizeof(DebugVertex));
-            ro.m_VertexCount += vertex_count;
-        }
-        else
+        DebugVertex* v = AllocDebugVertices(context, DEBUG_RENDER_TYPE_LINE_3D, 2);
+        v[0].m_Position = Vector4(start);
+        v[0].m_Color = start_color;
+        v[1].m_Position = Vector4(end);
+        v[1].m_Color = end_color;
+    }
+
+    void Lines3D(HRenderContext context, const Point3* points, uint32_t point_count, Vector4 color)
+    {
+        if (!context->m_DebugRenderer.m_RenderContext)
+            return;
+        const uint32_t vertex_count = point_count & ~1u;
+        DebugVertex* v = AllocDebugVertices(context, DEBUG_RENDER_TYPE_LINE_3D, vertex_count);
+        for (uint32_t i = 0; i < vertex_count; ++i)
         {
-            LogVertexWarning(context);
+            v[i].m_Position = Vector4(points[i]);
+            v[i].m_Color = color;
         }
     }
 
@@ -286,7 +254,6 @@ namespace dmRender
         DebugRenderer& debug_renderer = render_context->m_DebugRenderer;
         uint32_t total_vertex_count = 0;
         uint32_t total_render_objects = 0;
-        dmGraphics::SetVertexBufferData(debug_renderer.m_VertexBuffer, 0, 0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
         for (uint32_t i = 0; i < MAX_DEBUG_RENDER_TYPE_COUNT; ++i)
         {
             DebugRenderTypeData& type_data = debug_renderer.m_TypeData[i];
@@ -300,7 +267,16 @@ namespace dmRender
             }
         }
 
-        dmGraphics::SetVertexBufferData(debug_renderer.m_VertexBuffer, total_vertex_count * sizeof(DebugVertex), 0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+        // The vertex buffer keeps its size and only grows when needed. Re-specifying the data still orphans
+        // the previous storage, since the buffer may be flushed several times per frame.
+        if (total_vertex_count > 0)
+        {
+            if (total_vertex_count > debug_renderer.m_VertexBufferCapacity)
+            {
+                debug_renderer.m_VertexBufferCapacity = dmMath::Max(total_vertex_count, debug_renderer.m_VertexBufferCapacity * 2);
+            }
+            dmGraphics::SetVertexBufferData(debug_renderer.m_VertexBuffer, debug_renderer.m_VertexBufferCapacity * sizeof(DebugVertex), 0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+        }
 
         dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(render_context, total_render_objects);
         dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(render_context, &DebugRenderListDispatch, &debug_renderer);
@@ -321,7 +297,7 @@ namespace dmRender
             uint32_t vertex_count = ro.m_VertexCount;
             if (vertex_count > 0)
             {
-                dmGraphics::SetVertexBufferSubData(debug_renderer.m_VertexBuffer, ro.m_VertexStart * sizeof(DebugVertex), vertex_count * sizeof(DebugVertex), type_data.m_ClientBuffer);
+                dmGraphics::SetVertexBufferSubData(debug_renderer.m_VertexBuffer, ro.m_VertexStart * sizeof(DebugVertex), vertex_count * sizeof(DebugVertex), type_data.m_ClientBuffer.Begin());
                 write_ptr->m_MinorOrder = 0;
                 write_ptr->m_MajorOrder = RENDER_ORDER_AFTER_WORLD;
                 write_ptr->m_Order = render_order;
@@ -47,6 +47,8 @@ namespace dmRender
         int32_t     m_Y;
 
         bool        m_InCache;
+        /// Index of the glyph cache page holding the glyph, valid while m_InCache is set
+        uint16_t    m_CachePage;
         uint64_t    m_GlyphDataOffset;
         uint64_t    m_GlyphDataSize;
         uint32_t    m_Frame;
@@ -64,6 +66,31 @@ namespace dmRender
         float m_LayerMasks[3];
     };
 
+    /**
+     * Per glyph data when drawing text instanced. A static quad with a "position" attribute in [0,1]
+     * is expanded in the vertex shader:
+     *     local    = mix(instance_rect.xy, instance_rect.zw, position)
+     *     world    = instance_position + instance_axis_x * local.x + instance_axis_y * local.y
+     *     texcoord = mix(instance_uv.xy, instance_uv.zw, position)
+     * The colors, sdf params and layer mask use the same attribute names as GlyphVertex.
+     */
+    struct GlyphInstance
+    {
+        /// Translation and x/y axes of the text transform
+        float m_Position[3];
+        float m_AxisX[3];
+        float m_AxisY[3];
+        /// Glyph rectangle in font space (min x, min y, max x, max y)
+        float m_Rect[4];
+        /// Texture coordinates at the min and max corner of the rectangle
+        float m_UV[4];
+        float m_FaceColor[4];
+        float m_OutlineColor[4];
+        float m_ShadowColor[4];
+        float m_SdfParams[4];
+        float m_LayerMasks[3];
+    };
+
     /**
      * Font map parameters supplied to NewFontMap
      */
@@ -168,6 +195,13 @@ namespace dmRender
      */
     HMaterial GetFontMapMaterial(HFontMap font_map);
 
+    /**
+     * Get how far the glyphs of a font map, including outline and shadow, can be drawn outside the text metrics
+     * @param font_map Font map handle
+     * @return margin in font space
+     */
+    float GetFontMapGlyphMargin(HFontMap font_map);
+
     void InitializeTextContext(HRenderContext render_context, uint32_t max_characters);
     void FinalizeTextContext(HRenderContext render_context);
 
@@ -215,8 +249,14 @@ namespace dmRender
         TextVAlign m_VAlign;
         /// Stencil parameters
         StencilTestParams m_StencilTestParams;
+        /// Scissor rectangle in world space (min x, min y, max x, max y)
+        float m_ScissorRect[4];
         /// Stencil parameters set or not
         uint8_t m_StencilTestParamsSet : 1;
+        /// Scissor rectangle set or not
+        uint8_t m_ScissorSet : 1;
+        /// Draw the glyphs instanced if supported by the graphics adapter, see GlyphInstance (requires an instancing font material)
+        uint8_t m_Instancing : 1;
     };
 
     /**
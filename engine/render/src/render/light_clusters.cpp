@@ -0,0 +1,398 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include <dlib/hash.h>
+#include <dlib/log.h>
+#include <dlib/math.h>
+#include <dlib/profile.h>
+
+#include "render_private.h"
+
+// Clustered light assignment
+//
+// The view frustum is split into LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y tiles on screen, and each tile into
+// LIGHT_CLUSTERS_Z slices of view depth. The slices are logarithmic in depth for perspective projections
+// and linear for orthographic ones. Each light is assigned to the clusters its range reaches, so a
+// fragment only has to shade the lights of its own cluster.
+//
+// The result is uploaded to a single RGBA32F texture, bound to the "light_clusters" sampler of the
+// materials that declare it. Texel t is at (t % width, t / width), where the width is light_cluster_params.w:
+//
+//   [0, LIGHT_CLUSTER_COUNT)   cluster x + y * X + z * X * Y: the texel of its first light index, the light count
+//   light indices              the texel of the first light data texel of the light
+//   light data                 view position and range, color and cone cosine, view direction
+//
+// The constants of the materials:
+//
+//   light_cluster_params       number of clusters along x, y and z, texture width
+//   light_cluster_depth        slice = (w > 0 ? log(depth) : depth) * x - y, where depth is the positive view depth.
+//                              z is 1 for logarithmic slices, w is the number of lights
+//
+// The cluster x and y of a fragment are given by its normalized device coordinates, floor((ndc * 0.5 + 0.5) * count)
+
+namespace dmRender
+{
+    using namespace Vectormath::Aos;
+
+    static const dmhash_t LIGHT_CLUSTERS_HASH       = dmHashString64("light_clusters");
+    static const dmhash_t LIGHT_CLUSTER_PARAMS_HASH = dmHashString64("light_cluster_params");
+    static const dmhash_t LIGHT_CLUSTER_DEPTH_HASH  = dmHashString64("light_cluster_depth");
+
+    struct LightClusterContext
+    {
+        Matrix4                 m_View;
+        Matrix4                 m_Projection;
+        const Light*            m_Lights;
+        LightClusterBounds*     m_Bounds;
+        dmArray<uint16_t>*      m_Indices;
+        uint16_t*               m_Counts;
+        uint32_t                m_LightCount;
+        float                   m_Near;
+        float                   m_Far;
+        float                   m_DepthScale;
+        float                   m_DepthBias;
+        bool                    m_Perspective;
+    };
+
+    void InitializeLightClusters(HRenderContext render_context)
+    {
+        render_context->m_LightTexture = 0;
+        render_context->m_LightClusterParams = Vector4((float) LIGHT_CLUSTERS_X, (float) LIGHT_CLUSTERS_Y, (float) LIGHT_CLUSTERS_Z, (float) LIGHT_TEXTURE_WIDTH);
+        render_context->m_LightClusterDepth = Vector4(0.0f);
+        render_context->m_LightClustersFrameVersion = 0;
+        render_context->m_LightClustersVersion = 0;
+        memset(render_context->m_LightClusterCounts, 0, sizeof(render_context->m_LightClusterCounts));
+    }
+
+    void FinalizeLightClusters(HRenderContext render_context)
+    {
+        if (render_context->m_LightTexture)
+        {
+            dmGraphics::DeleteTexture(render_context->m_LightTexture);
+            render_context->m_LightTexture = 0;
+        }
+    }
+
+    void AddLight(HRenderContext context, const Light& light)
+    {
+        if (context->m_Lights.Size() == MAX_LIGHT_COUNT)
+        {
+            dmLogOnceWarning("Too many lights in the frame, only the first %u are used", MAX_LIGHT_COUNT);
+            return;
+        }
+        if (context->m_Lights.Full())
+        {
+            context->m_Lights.OffsetCapacity(dmMath::Max(16U, context->m_Lights.Capacity() / 2));
+        }
+        context->m_Lights.Push(light);
+        context->m_LightClustersFrameVersion = 0;
+    }
+
+    static inline uint8_t GetLightClusterSlice(const LightClusterContext* ctx, float depth)
+    {
+        float d = ctx->m_Perspective ? logf(dmMath::Max(depth, ctx->m_Near)) : depth;
+        float slice = d * ctx->m_DepthScale - ctx->m_DepthBias;
+        return (uint8_t) dmMath::Clamp(slice, 0.0f, (float) (LIGHT_CLUSTERS_Z - 1));
+    }
+
+    static inline uint8_t GetLightClusterTile(float ndc, uint32_t tile_count)
+    {
+        float tile = (ndc * 0.5f + 0.5f) * tile_count;
+        return (uint8_t) dmMath::Clamp(tile, 0.0f, (float) (tile_count - 1));
+    }
+
+    // Finds the clusters reached by the bounding box of the light range
+    static void CalcLightClusterBounds(void* _ctx, uint32_t start, uint32_t end)
+    {
+        LightClusterContext* ctx = (LightClusterContext*) _ctx;
+        for (uint32_t i = start; i < end; ++i)
+        {
+            const Light& light = ctx->m_Lights[i];
+            LightClusterBounds& bounds = ctx->m_Bounds[i];
+            bounds.m_Visible = 0;
+
+            const Vector4 p = ctx->m_View * light.m_Position;
+            const float r = light.m_Range;
+            const float depth = -p.getZ();
+            if (!(r > 0.0f) || depth + r < ctx->m_Near || depth - r > ctx->m_Far)
+                continue;
+
+            // The part of the box behind the near plane is flattened onto it, which keeps the projected rect conservative
+            float min_z = p.getZ() - r;
+            float max_z = p.getZ() + r;
+            if (ctx->m_Perspective)
+                max_z = dmMath::Min(max_z, -ctx->m_Near);
+
+            float min_x = FLT_MAX, min_y = FLT_MAX;
+            float max_x = -FLT_MAX, max_y = -FLT_MAX;
+            for (uint32_t c = 0; c < 8; ++c)
+            {
+                Point3 corner(p.getX() + ((c & 1) ? r : -r), p.getY() + ((c & 2) ? r : -r), (c & 4) ? max_z : min_z);
+                Vector4 v = ctx->m_Projection * corner;
+                float x = v.getX() / v.getW();
+                float y = v.getY() / v.getW();
+                min_x = dmMath::Min(min_x, x);
+                max_x = dmMath::Max(max_x, x);
+                min_y = dmMath::Min(min_y, y);
+                max_y = dmMath::Max(max_y, y);
+            }
+            if (min_x > 1.0f || max_x < -1.0f || min_y > 1.0f || max_y < -1.0f)
+                continue;
+
+            bounds.m_MinX = GetLightClusterTile(min_x, LIGHT_CLUSTERS_X);
+            bounds.m_MaxX = GetLightClusterTile(max_x, LIGHT_CLUSTERS_X);
+            bounds.m_MinY = GetLightClusterTile(min_y, LIGHT_CLUSTERS_Y);
+            bounds.m_MaxY = GetLightClusterTile(max_y, LIGHT_CLUSTERS_Y);
+            bounds.m_MinZ = GetLightClusterSlice(ctx, depth - r);
+            bounds.m_MaxZ = GetLightClusterSlice(ctx, depth + r);
+            bounds.m_Visible = 1;
+        }
+    }
+
+    // Lists the lights of the clusters of each depth slice, in cluster order
+    static void AssignLightClusterSlices(void* _ctx, uint32_t start, uint32_t end)
+    {
+        LightClusterContext* ctx = (LightClusterContext*) _ctx;
+        const uint32_t slice_size = LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y;
+        uint16_t offsets[slice_size];
+        uint16_t ends[slice_size];
+
+        for (uint32_t z = start; z < end; ++z)
+        {
+            uint16_t* counts = ctx->m_Counts + z * slice_size;
+            memset(counts, 0, sizeof(uint16_t) * slice_size);
+
+            for (uint32_t i = 0; i < ctx->m_LightCount; ++i)
+            {
+                const LightClusterBounds& b = ctx->m_Bounds[i];
+                if (!b.m_Visible || z < b.m_MinZ || z > b.m_MaxZ)
+                    continue;
+                for (uint32_t y = b.m_MinY; y <= b.m_MaxY; ++y)
+                {
+                    for (uint32_t x = b.m_MinX; x <= b.m_MaxX; ++x)
+                    {
+                        uint16_t& count = counts[x + y * LIGHT_CLUSTERS_X];
+                        if (count < LIGHT_CLUSTER_MAX_LIGHTS)
+                            ++count;
+                    }
+                }
+            }
+
+            uint32_t total = 0;
+            for (uint32_t c = 0; c < slice_size; ++c)
+            {
+                offsets[c] = (uint16_t) total;
+                total += counts[c];
+                ends[c] = (uint16_t) total;
+            }
+
+            dmArray<uint16_t>& indices = ctx->m_Indices[z];
+            if (indices.Capacity() < total)
+                indices.SetCapacity(total);
+            indices.SetSize(total);
+            if (total == 0)
+                continue;
+
+            // The lights are added in the same order as they were counted, so the first ones are kept when a cluster is full
+            for (uint32_t i = 0; i < ctx->m_LightCount; ++i)
+            {
+                const LightClusterBounds& b = ctx->m_Bounds[i];
+                if (!b.m_Visible || z < b.m_MinZ || z > b.m_MaxZ)
+                    continue;
+                for (uint32_t y = b.m_MinY; y <= b.m_MaxY; ++y)
+                {
+                    for (uint32_t x = b.m_MinX; x <= b.m_MaxX; ++x)
+                    {
+                        uint32_t c = x + y * LIGHT_CLUSTERS_X;
+                        if (offsets[c] < ends[c])
+                            indices[offsets[c]++] = (uint16_t) i;
+                    }
+                }
+            }
+        }
+    }
+
+    // Gets the near and far distance of the projection, and whether it's a perspective projection
+    static void GetProjectionDepthRange(const Matrix4& projection, float* near, float* far, bool* perspective)
+    {
+        const float a = projection.getElem(2, 2);
+        const float b = projection.getElem(3, 2);
+        *perspective = projection.getElem(2, 3) != 0.0f;
+        if (*perspective)
+        {
+            *near = b / (a - 1.0f);
+            *far = b / (a + 1.0f);
+            if (!(*near > 0.0f))
+                *near = 0.01f;
+        }
+        else
+        {
+            *near = (b + 1.0f) / a;
+            *far = (b - 1.0f) / a;
+        }
+        if (!(*far > *near))
+            *far = *near + 1.0f;
+    }
+
+    void UpdateLightClusters(HRenderContext render_context)
+    {
+        DM_PROFILE(Render, "UpdateLightClusters");
+
+        LightClusterContext ctx;
+        ctx.m_View = render_context->m_View;
+        ctx.m_Projection = render_context->m_Projection;
+        ctx.m_LightCount = render_context->m_Lights.Size();
+        GetProjectionDepthRange(ctx.m_Projection, &ctx.m_Near, &ctx.m_Far, &ctx.m_Perspective);
+        if (ctx.m_Perspective)
+        {
+            ctx.m_DepthScale = LIGHT_CLUSTERS_Z / logf(ctx.m_Far / ctx.m_Near);
+            ctx.m_DepthBias = logf(ctx.m_Near) * ctx.m_DepthScale;
+        }
+        else
+        {
+            ctx.m_DepthScale = LIGHT_CLUSTERS_Z / (ctx.m_Far - ctx.m_Near);
+            ctx.m_DepthBias = ctx.m_Near * ctx.m_DepthScale;
+        }
+
+        dmArray<LightClusterBounds>& bounds = render_context->m_LightClusterBounds;
+        if (bounds.Capacity() < ctx.m_LightCount)
+            bounds.SetCapacity(ctx.m_LightCount);
+        bounds.SetSize(ctx.m_LightCount);
+        ctx.m_Lights = render_context->m_Lights.Begin();
+        ctx.m_Bounds = bounds.Begin();
+        ctx.m_Indices = render_context->m_LightClusterIndices;
+        ctx.m_Counts = render_context->m_LightClusterCounts;
+
+        if (render_context->m_JobContext == 0)
+        {
+            CalcLightClusterBounds(&ctx, 0, ctx.m_LightCount);
+            AssignLightClusterSlices(&ctx, 0, LIGHT_CLUSTERS_Z);
+        }
+        else
+        {
+            dmJob::HJob job = dmJob::ParallelFor(render_context->m_JobContext, CalcLightClusterBounds, &ctx, ctx.m_LightCount, 64, dmJob::INVALID_JOB);
+            dmJob::Wait(render_context->m_JobContext, job);
+            job = dmJob::ParallelFor(render_context->m_JobContext, AssignLightClusterSlices, &ctx, LIGHT_CLUSTERS_Z, 1, dmJob::INVALID_JOB);
+            dmJob::Wait(render_context->m_JobContext, job);
+        }
+
+        uint32_t index_count = 0;
+        for (uint32_t z = 0; z < LIGHT_CLUSTERS_Z; ++z)
+            index_count += render_context->m_LightClusterIndices[z].Size();
+
+        const uint32_t index_start = LIGHT_CLUSTER_COUNT;
+        const uint32_t data_start = index_start + index_count;
+        const uint32_t texel_count = data_start + ctx.m_LightCount * LIGHT_DATA_TEXEL_COUNT;
+        const uint32_t height = (texel_count + LIGHT_TEXTURE_WIDTH - 1) / LIGHT_TEXTURE_WIDTH;
+        dmArray<float>& data = render_context->m_LightTextureData;
+        const uint32_t float_count = LIGHT_TEXTURE_WIDTH * height * 4;
+        if (data.Capacity() < float_count)
+            data.SetCapacity(float_count);
+        data.SetSize(float_count);
+        memset(data.Begin(), 0, sizeof(float) * float_count);
+
+        float* grid = data.Begin();
+        uint32_t offset = index_start;
+        for (uint32_t c = 0; c < LIGHT_CLUSTER_COUNT; ++c)
+        {
+            grid[c * 4 + 0] = (float) offset;
+            grid[c * 4 + 1] = (float) render_context->m_LightClusterCounts[c];
+            offset += render_context->m_LightClusterCounts[c];
+        }
+
+        float* index = data.Begin() + index_start * 4;
+        for (uint32_t z = 0; z < LIGHT_CLUSTERS_Z; ++z)
+        {
+            const dmArray<uint16_t>& indices = render_context->m_LightClusterIndices[z];
+            for (uint32_t i = 0; i < indices.Size(); ++i, index += 4)
+            {
+                index[0] = (float) (data_start + indices[i] * LIGHT_DATA_TEXEL_COUNT);
+            }
+        }
+
+        float* light_data = data.Begin() + data_start * 4;
+        for (uint32_t i = 0; i < ctx.m_LightCount; ++i, light_data += LIGHT_DATA_TEXEL_COUNT * 4)
+        {
+            const Light& light = ctx.m_Lights[i];
+            const Vector4 position = ctx.m_View * light.m_Position;
+            const Vector4 direction = ctx.m_View * light.m_Direction;
+            light_data[0] = position.getX();
+            light_data[1] = position.getY();
+            light_data[2] = position.getZ();
+            light_data[3] = light.m_Range;
+            light_data[4] = light.m_Color.getX();
+            light_data[5] = light.m_Color.getY();
+            light_data[6] = light.m_Color.getZ();
+            light_data[7] = light.m_ConeCos;
+            light_data[8] = direction.getX();
+            light_data[9] = direction.getY();
+            light_data[10] = direction.getZ();
+        }
+
+        if (!render_context->m_LightTexture)
+        {
+            dmGraphics::TextureCreationParams create_params;
+            create_params.m_Width = LIGHT_TEXTURE_WIDTH;
+            create_params.m_Height = height;
+            create_params.m_OriginalWidth = LIGHT_TEXTURE_WIDTH;
+            create_params.m_OriginalHeight = height;
+            render_context->m_LightTexture = dmGraphics::NewTexture(render_context->m_GraphicsContext, create_params);
+        }
+
+        dmGraphics::TextureParams params;
+        params.m_Format = dmGraphics::TEXTURE_FORMAT_RGBA32F;
+        params.m_Data = data.Begin();
+        params.m_DataSize = float_count * sizeof(float);
+        params.m_Width = LIGHT_TEXTURE_WIDTH;
+        params.m_Height = height;
+        params.m_MinFilter = dmGraphics::TEXTURE_FILTER_NEAREST;
+        params.m_MagFilter = dmGraphics::TEXTURE_FILTER_NEAREST;
+        dmGraphics::SetTexture(render_context->m_LightTexture, params);
+
+        render_context->m_LightClusterDepth = Vector4(ctx.m_DepthScale, ctx.m_DepthBias, ctx.m_Perspective ? 1.0f : 0.0f, (float) ctx.m_LightCount);
+        render_context->m_LightClustersFrameVersion = render_context->m_FrameConstantsVersion;
+        if (++render_context->m_LightClustersVersion == 0)
+        {
+            render_context->m_LightClustersVersion = 1;
+        }
+    }
+
+    int32_t ApplyLightClusters(HRenderContext render_context, HMaterial material)
+    {
+        int32_t unit = GetMaterialSamplerUnit(material, LIGHT_CLUSTERS_HASH);
+        if (unit < 0)
+            return -1;
+
+        if (!dmGraphics::IsTextureFormatSupported(render_context->m_GraphicsContext, dmGraphics::TEXTURE_FORMAT_RGBA32F))
+        {
+            dmLogOnceWarning("The light clusters can't be sampled, floating point textures aren't supported");
+            return -1;
+        }
+
+        if (render_context->m_LightClustersFrameVersion != render_context->m_FrameConstantsVersion)
+        {
+            UpdateLightClusters(render_context);
+        }
+
+        if (material->m_LightClustersVersion != render_context->m_LightClustersVersion)
+        {
+            material->m_LightClustersVersion = render_context->m_LightClustersVersion;
+            SetMaterialProgramConstant(material, LIGHT_CLUSTER_PARAMS_HASH, render_context->m_LightClusterParams);
+            SetMaterialProgramConstant(material, LIGHT_CLUSTER_DEPTH_HASH, render_context->m_LightClusterDepth);
+        }
+        return unit;
+    }
+}
@@ -49,7 +49,7 @@ namespace dmRender
             {
                 constants_count++;
             }
-            else if (type == dmGraphics::TYPE_SAMPLER_2D || type == dmGraphics::TYPE_SAMPLER_CUBE)
+            else if (type == dmGraphics::TYPE_SAMPLER_2D || type == dmGraphics::TYPE_SAMPLER_CUBE || type == dmGraphics::TYPE_SAMPLER_2D_ARRAY)
             {
                 samplers_count++;
             }
@@ -123,7 +123,7 @@ namespace dmRender
                 }
                 m->m_Constants.Push(constant);
             }
-            else if (type == dmGraphics::TYPE_SAMPLER_2D || type == dmGraphics::TYPE_SAMPLER_CUBE)
+            else if (type == dmGraphics::TYPE_SAMPLER_2D || type == dmGraphics::TYPE_SAMPLER_CUBE || type == dmGraphics::TYPE_SAMPLER_2D_ARRAY)
             {
                 m->m_NameHashToLocation.Put(name_hash, location);
             }
@@ -141,6 +141,13 @@ namespace dmRender
 
     void ApplyMaterialConstants(dmRender::HRenderContext render_context, HMaterial material, const RenderObject* ro)
     {
+        // The program keeps its constant values between draw calls, so only the constants
+        // that depend on the render object are uploaded for every draw
+        const bool apply_frame_constants = material->m_FrameConstantsVersion != render_context->m_FrameConstantsVersion;
+        const bool apply_user_constants  = material->m_UserConstantsDirty;
+        material->m_FrameConstantsVersion = render_context->m_FrameConstantsVersion;
+        material->m_UserConstantsDirty    = 0;
+
         const dmArray<MaterialConstant>& constants = material->m_Constants;
         dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
         uint32_t n = constants.Size();
@@ -153,22 +160,17 @@ namespace dmRender
             {
                 case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_USER:
                 {
-                    dmGraphics::SetConstantV4(graphics_context, &constant.m_Value, location);
+                    if (apply_user_constants)
+                    {
+                        dmGraphics::SetConstantV4(graphics_context, &constant.m_Value, location);
+                    }
                     break;
                 }
                 case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_VIEWPROJ:
                 {
-                    if (dmGraphics::GetShaderProgramLanguage(graphics_context) == dmGraphics::ShaderDesc::LANGUAGE_SPIRV)
+                    if (apply_frame_constants)
                     {
-                        Matrix4 ndc_matrix = Matrix4::identity();
-                        ndc_matrix.setElem(2, 2, 0.5f );
-                        ndc_matrix.setElem(3, 2, 0.5f );
-                        const Matrix4 view_projection = ndc_matrix * render_context->m_ViewProj;
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&view_projection, location);
-                    }
-                    else
-                    {
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_ViewProj, location);
+                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_ClipViewProj, location);
                     }
                     break;
                 }
@@ -184,24 +186,17 @@ namespace dmRender
                 }
                 case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_VIEW:
                 {
-                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_View, location);
+                    if (apply_frame_constants)
+                    {
+                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_View, location);
+                    }
                     break;
                 }
                 case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_PROJECTION:
                 {
-                    // Vulkan NDC is [0..1] for z, so we must transform
-                    // the projection before setting the constant.
-                    if (dmGraphics::GetShaderProgramLanguage(graphics_context) == dmGraphics::ShaderDesc::LANGUAGE_SPIRV)
-                    {
-                        Matrix4 ndc_matrix = Matrix4::identity();
-                        ndc_matrix.setElem(2, 2, 0.5f );
-                        ndc_matrix.setElem(3, 2, 0.5f );
-                        const Matrix4 proj = ndc_matrix * render_context->m_Projection;
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&proj, location);
-                    }
-                    else
+                    if (apply_frame_constants)
                     {
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_Projection, location);
+                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_ClipProjection, location);
                     }
                     break;
                 }
@@ -228,25 +223,20 @@ namespace dmRender
                 }
                 case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_WORLDVIEWPROJ:
                 {
-                    if (dmGraphics::GetShaderProgramLanguage(graphics_context) == dmGraphics::ShaderDesc::LANGUAGE_SPIRV)
-                    {
-                        Matrix4 ndc_matrix = Matrix4::identity();
-                        ndc_matrix.setElem(2, 2, 0.5f );
-                        ndc_matrix.setElem(3, 2, 0.5f );
-                        const Matrix4 world_view_projection = ndc_matrix * render_context->m_ViewProj * ro->m_WorldTransform;
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&world_view_projection, location);
-                    }
-                    else
-                    {
-                        const Matrix4 world_view_projection = render_context->m_ViewProj * ro->m_WorldTransform;
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&world_view_projection, location);
-                    }
+                    const Matrix4 world_view_projection = render_context->m_ClipViewProj * ro->m_WorldTransform;
+                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&world_view_projection, location);
                     break;
                 }
             }
         }
     }
 
+    void DirtyMaterialConstants(HMaterial material)
+    {
+        material->m_FrameConstantsVersion = 0;
+        material->m_UserConstantsDirty    = 1;
+    }
+
     void ApplyMaterialSampler(dmRender::HRenderContext render_context, HMaterial material, uint32_t unit, dmGraphics::HTexture texture)
     {
         dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
@@ -371,6 +361,7 @@ namespace dmRender
             if (c.m_Constant.m_NameHash == name_hash)
             {
                 c.m_Constant.m_Value = value;
+                material->m_UserConstantsDirty = 1;
             }
         }
     }
@@ -404,6 +395,18 @@ namespace dmRender
         }
     }
 
+    int32_t GetMaterialSamplerUnit(HMaterial material, dmhash_t name_hash)
+    {
+        const dmArray<Sampler>& samplers = material->m_Samplers;
+        uint32_t n = samplers.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            if (samplers[i].m_NameHash == name_hash && samplers[i].m_Location != -1)
+                return samplers[i].m_Unit;
+        }
+        return -1;
+    }
+
     HRenderContext GetMaterialRenderContext(HMaterial material)
     {
         return material->m_RenderContext;
@@ -15,8 +15,10 @@
 #include <float.h>
 #include <algorithm>
 
+#include <dlib/atomic.h>
 #include <dlib/hash.h>
 #include <dlib/hashtable.h>
+#include <dlib/memprofile.h>
 #include <dlib/profile.h>
 #include <dlib/math.h>
 
@@ -102,6 +104,7 @@ namespace dmRender
     , m_MaxCharacters(0)
     , m_CommandBufferSize(1024)
     , m_MaxDebugVertexCount(0)
+    , m_JobContext(0)
     {
 
     }
@@ -113,6 +116,28 @@ namespace dmRender
 
     }
 
+    static void UpdateFrameConstants(HRenderContext render_context)
+    {
+        render_context->m_ViewProj       = render_context->m_Projection * render_context->m_View;
+        render_context->m_ClipProjection = render_context->m_Projection;
+
+        // Vulkan NDC is [0..1] for z, so the projection is transformed
+        // once here rather than for every draw call
+        if (dmGraphics::GetShaderProgramLanguage(render_context->m_GraphicsContext) == dmGraphics::ShaderDesc::LANGUAGE_SPIRV)
+        {
+            Matrix4 ndc_matrix = Matrix4::identity();
+            ndc_matrix.setElem(2, 2, 0.5f );
+            ndc_matrix.setElem(3, 2, 0.5f );
+            render_context->m_ClipProjection = ndc_matrix * render_context->m_Projection;
+        }
+        render_context->m_ClipViewProj = render_context->m_ClipProjection * render_context->m_View;
+
+        if (++render_context->m_FrameConstantsVersion == 0)
+        {
+            render_context->m_FrameConstantsVersion = 1;
+        }
+    }
+
     HRenderContext NewRenderContext(dmGraphics::HContext graphics_context, const RenderContextParams& params)
     {
         RenderContext* context = new RenderContext;
@@ -121,14 +146,19 @@ namespace dmRender
         context->m_RenderObjects.SetSize(0);
 
         context->m_GraphicsContext = graphics_context;
+        context->m_JobContext = params.m_JobContext;
+        context->m_RenderListDrawCount = 0;
 
         context->m_SystemFontMap = params.m_SystemFontMap;
+        context->m_TextureUsedCallback = 0;
+        context->m_TextureUsedCallbackUserData = 0;
 
         context->m_Material = 0;
 
         context->m_View = Matrix4::identity();
         context->m_Projection = Matrix4::identity();
-        context->m_ViewProj = context->m_Projection * context->m_View;
+        context->m_FrameConstantsVersion = 0;
+        UpdateFrameConstants(context);
 
         context->m_ScriptContext = params.m_ScriptContext;
         InitializeRenderScriptContext(context->m_RenderScriptContext, params.m_ScriptContext, params.m_CommandBufferSize);
@@ -148,7 +178,31 @@ namespace dmRender
 
         context->m_StencilBufferCleared = 0;
 
+        context->m_FrustumMatrix = Matrix4::identity();
+        context->m_FrustumCulling = 0;
+        context->m_LayerMask = 0xffffffff;
+        for (uint32_t i = 0; i < RENDER_LIST_VIEW_CACHE_SIZE; ++i)
+        {
+            context->m_RenderListViews[i].m_FrustumMatrix = Matrix4::identity();
+            context->m_RenderListViews[i].m_BoundsCount = 0;
+            context->m_RenderListViews[i].m_LastUsed = 0;
+            context->m_RenderListViews[i].m_OcclusionDepth = 0;
+            context->m_RenderListViews[i].m_OcclusionTiles = 0;
+            context->m_RenderListViews[i].m_OccluderVertexCount = 0;
+        }
+        context->m_RenderListView = &context->m_RenderListViews[0];
+        context->m_RenderListViewUseCount = 0;
+        context->m_RenderListBoundsCount = 0;
+        InitializeLightClusters(context);
+
+        memset(context->m_Viewport, 0, sizeof(context->m_Viewport));
+        context->m_ViewportSet = 0;
+        context->m_RenderTarget = 0;
+
         context->m_RenderListDispatch.SetCapacity(255);
+        dmSpinlock::Init(&context->m_RenderListDispatchLock);
+        context->m_RenderListSegmentCount = params.m_JobContext ? dmJob::GetWorkerCount(params.m_JobContext) + 1 : 1;
+        context->m_RenderListSegments = new RenderListSegment[context->m_RenderListSegmentCount];
 
         dmMessage::Result r = dmMessage::NewSocket(RENDER_SOCKET_NAME, &context->m_Socket);
         assert(r == dmMessage::RESULT_OK);
@@ -163,7 +217,18 @@ namespace dmRender
         dmScript::DeleteScriptWorld(render_context->m_ScriptWorld);
         FinalizeDebugRenderer(render_context);
         FinalizeTextContext(render_context);
+        FinalizeLightClusters(render_context);
+        for (uint32_t i = 0; i < render_context->m_TransientRenderTargets.Size(); ++i)
+        {
+            dmGraphics::DeleteRenderTarget(render_context->m_TransientRenderTargets[i].m_RenderTarget);
+        }
         dmMessage::DeleteSocket(render_context->m_Socket);
+        for (uint32_t i = 0; i < RENDER_LIST_VIEW_CACHE_SIZE; ++i)
+        {
+            delete [] render_context->m_RenderListViews[i].m_OcclusionDepth;
+            delete [] render_context->m_RenderListViews[i].m_OcclusionTiles;
+        }
+        delete [] render_context->m_RenderListSegments;
         delete render_context;
 
         return RESULT_OK;
@@ -173,16 +238,50 @@ namespace dmRender
         return render_context->m_ScriptContext;
     }
 
+    dmJob::HContext GetJobContext(HRenderContext render_context) {
+        return render_context->m_JobContext;
+    }
+
     void RenderListBegin(HRenderContext render_context)
     {
         render_context->m_RenderList.SetSize(0);
         render_context->m_RenderListSortIndices.SetSize(0);
         render_context->m_RenderListDispatch.SetSize(0);
         render_context->m_RenderListRanges.SetSize(0);
+        render_context->m_RenderListDrawCount = 0;
+
+        render_context->m_RenderPassStats.Swap(render_context->m_LastRenderPassStats);
+        render_context->m_RenderPassStats.SetSize(0);
+
+        for (uint32_t i = 0; i < RENDER_LIST_VIEW_CACHE_SIZE; ++i)
+        {
+            render_context->m_RenderListViews[i].m_Visibility.SetSize(0);
+            render_context->m_RenderListViews[i].m_BoundsCount = 0;
+            render_context->m_RenderListViews[i].m_OccluderVertexCount = 0;
+        }
+        render_context->m_RenderListBoundsCount = 0;
+        render_context->m_OccluderVertices.SetSize(0);
+        render_context->m_Lights.SetSize(0);
+        render_context->m_LightClustersFrameVersion = 0;
+        render_context->m_RenderListCullIndices.SetSize(0);
+        render_context->m_RenderListCullBounds.SetSize(0);
+
+        for (uint32_t i = 0; i < render_context->m_RenderListSegmentCount; ++i)
+        {
+            render_context->m_RenderListSegments[i].m_Entries.SetSize(0);
+            render_context->m_RenderListSegments[i].m_Indices.SetSize(0);
+        }
     }
 
     HRenderListDispatch RenderListMakeDispatch(HRenderContext render_context, RenderListDispatchFn fn, void *user_data)
     {
+        return RenderListMakeDispatch(render_context, fn, 0, user_data);
+    }
+
+    HRenderListDispatch RenderListMakeDispatch(HRenderContext render_context, RenderListDispatchFn fn, RenderListVisibilityFn visibility_fn, void *user_data)
+    {
+        // Locked since the dispatches may be created while populating render list segments in parallel
+        DM_SPINLOCK_SCOPED_LOCK(render_context->m_RenderListDispatchLock);
         if (render_context->m_RenderListDispatch.Size() == render_context->m_RenderListDispatch.Capacity())
         {
             dmLogError("Exhausted number of render dispatches. Too many collections?");
@@ -192,6 +291,7 @@ namespace dmRender
         // store & return index
         RenderListDispatch d;
         d.m_Fn = fn;
+        d.m_VisibilityFn = visibility_fn;
         d.m_UserData = user_data;
         render_context->m_RenderListDispatch.Push(d);
 
@@ -215,6 +315,8 @@ namespace dmRender
 
         uint32_t size = render_list.Size();
         render_list.SetSize(size + entries);
+        // Components that don't know about layers leave the entries on layer 0
+        memset(render_list.Begin() + size, 0, entries * sizeof(RenderListEntry));
         return (render_list.Begin() + size);
     }
 
@@ -241,19 +343,247 @@ namespace dmRender
         render_context->m_RenderListRanges.SetSize(0);
     }
 
-    struct RenderListSorter
+    static RenderListSegment* GetRenderListSegment(HRenderContext render_context)
+    {
+        uint32_t index = render_context->m_JobContext ? dmJob::GetThreadIndex(render_context->m_JobContext) : 0;
+        assert(index < render_context->m_RenderListSegmentCount);
+        return &render_context->m_RenderListSegments[index];
+    }
+
+    RenderListEntry* RenderListSegmentAlloc(HRenderContext render_context, uint32_t entries)
+    {
+        dmArray<RenderListEntry>& segment_entries = GetRenderListSegment(render_context)->m_Entries;
+        if (segment_entries.Remaining() < entries)
+        {
+            const uint32_t needed = entries - segment_entries.Remaining();
+            segment_entries.OffsetCapacity(dmMath::Max<uint32_t>(256, needed));
+        }
+
+        uint32_t size = segment_entries.Size();
+        segment_entries.SetSize(size + entries);
+        memset(segment_entries.Begin() + size, 0, entries * sizeof(RenderListEntry));
+        return segment_entries.Begin() + size;
+    }
+
+    void RenderListSegmentSubmit(HRenderContext render_context, RenderListEntry* begin, RenderListEntry* end)
     {
-        bool operator()(uint32_t a, uint32_t b) const
+        if (end == begin) {
+            return;
+        }
+        RenderListSegment* segment = GetRenderListSegment(render_context);
+        assert(begin >= segment->m_Entries.Begin() && end <= segment->m_Entries.End());
+
+        dmArray<uint32_t>& indices = segment->m_Indices;
+        if (indices.Remaining() < (uint32_t) (end - begin))
         {
-            const RenderListSortValue& u = values[a];
-            const RenderListSortValue& v = values[b];
-            return u.m_SortKey < v.m_SortKey;
+            indices.SetCapacity(segment->m_Entries.Capacity());
         }
-        RenderListSortValue* values;
+
+        RenderListEntry* base = segment->m_Entries.Begin();
+        for (RenderListEntry* i = begin; i != end; ++i)
+            indices.Push(i - base);
+    }
+
+    void RenderListMergeSegments(HRenderContext render_context)
+    {
+        for (uint32_t s = 0; s < render_context->m_RenderListSegmentCount; ++s)
+        {
+            RenderListSegment& segment = render_context->m_RenderListSegments[s];
+            uint32_t count = segment.m_Indices.Size();
+            if (count > 0)
+            {
+                DM_PROFILE(Render, "RenderListMergeSegments");
+                RenderListEntry* entries = RenderListAlloc(render_context, segment.m_Entries.Size());
+                memcpy(entries, segment.m_Entries.Begin(), sizeof(RenderListEntry) * segment.m_Entries.Size());
+
+                uint32_t base = entries - render_context->m_RenderList.Begin();
+                uint32_t* insert = render_context->m_RenderListSortIndices.End();
+                const uint32_t* indices = segment.m_Indices.Begin();
+                for (uint32_t i = 0; i < count; ++i)
+                    *insert++ = base + indices[i];
+                render_context->m_RenderListSortIndices.SetSize(render_context->m_RenderListSortIndices.Size() + count);
+
+                // the merged entries need to be sorted on tags again
+                render_context->m_RenderListRanges.SetSize(0);
+            }
+            segment.m_Entries.SetSize(0);
+            segment.m_Indices.SetSize(0);
+        }
+    }
+
+    // Below this many entries per chunk, it's not worth splitting the sort over the workers
+    static const uint32_t RENDER_LIST_RADIX_MIN_CHUNK_SIZE = 4096;
+    static const uint32_t RENDER_LIST_RADIX_BITS = 8;
+    static const uint32_t RENDER_LIST_RADIX_PASSES = 64 / RENDER_LIST_RADIX_BITS;
+
+    struct RadixSortContext
+    {
+        RenderListSortScratch*      m_Scratch;
+        const RenderListSortPair*   m_Src;
+        RenderListSortPair*         m_Dst;
+        uint32_t                    m_Count;
+        uint32_t                    m_ChunkSize;
+        uint32_t                    m_Shift;
     };
 
+    static void RadixSortHistogram(void* _ctx, uint32_t chunk_start, uint32_t chunk_end)
+    {
+        RadixSortContext* ctx = (RadixSortContext*) _ctx;
+        const uint32_t shift = ctx->m_Shift;
+        for (uint32_t c = chunk_start; c < chunk_end; ++c)
+        {
+            uint32_t* histogram = ctx->m_Scratch->m_Histograms[c];
+            memset(histogram, 0, sizeof(uint32_t) * RENDER_LIST_RADIX_BUCKETS);
+            const RenderListSortPair* src = ctx->m_Src + c * ctx->m_ChunkSize;
+            const RenderListSortPair* end = ctx->m_Src + dmMath::Min(ctx->m_Count, (c + 1) * ctx->m_ChunkSize);
+            for (; src < end; ++src)
+            {
+                ++histogram[(src->m_Key >> shift) & (RENDER_LIST_RADIX_BUCKETS - 1)];
+            }
+        }
+    }
+
+    // Expects the histograms to be converted into output offsets
+    static void RadixSortScatter(void* _ctx, uint32_t chunk_start, uint32_t chunk_end)
+    {
+        RadixSortContext* ctx = (RadixSortContext*) _ctx;
+        const uint32_t shift = ctx->m_Shift;
+        RenderListSortPair* dst = ctx->m_Dst;
+        for (uint32_t c = chunk_start; c < chunk_end; ++c)
+        {
+            uint32_t* offsets = ctx->m_Scratch->m_Histograms[c];
+            const RenderListSortPair* src = ctx->m_Src + c * ctx->m_ChunkSize;
+            const RenderListSortPair* end = ctx->m_Src + dmMath::Min(ctx->m_Count, (c + 1) * ctx->m_ChunkSize);
+            for (; src < end; ++src)
+            {
+                dst[offsets[(src->m_Key >> shift) & (RENDER_LIST_RADIX_BUCKETS - 1)]++] = *src;
+            }
+        }
+    }
+
+    static void RadixSortRun(dmJob::HContext job_context, RadixSortContext* ctx, dmJob::RangeFunc func, uint32_t chunk_count)
+    {
+        if (job_context == 0 || chunk_count == 1)
+        {
+            func(ctx, 0, chunk_count);
+            return;
+        }
+        dmJob::HJob job = dmJob::ParallelFor(job_context, func, ctx, chunk_count, 1, dmJob::INVALID_JOB);
+        dmJob::Wait(job_context, job);
+    }
+
+    // Checks if the previous order is a stable sort of the current keys
+    static bool IsOrderValid(const RenderListSortPair* pairs, uint32_t count, const uint32_t* order)
+    {
+        for (uint32_t i = 1; i < count; ++i)
+        {
+            uint32_t a = order[i-1];
+            uint32_t b = order[i];
+            if (pairs[a].m_Key > pairs[b].m_Key || (pairs[a].m_Key == pairs[b].m_Key && a > b))
+                return false;
+        }
+        return true;
+    }
+
+    bool RadixSortRenderList(dmJob::HContext job_context, const RenderListSortValue* values, uint32_t* indices, uint32_t count, RenderListSortScratch& scratch, dmArray<uint32_t>& previous_order)
+    {
+        if (count == 0)
+        {
+            previous_order.SetSize(0);
+            return false;
+        }
+
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            if (scratch.m_Pairs[i].Capacity() < count)
+                scratch.m_Pairs[i].SetCapacity(count);
+            scratch.m_Pairs[i].SetSize(count);
+        }
+        if (scratch.m_Indices.Capacity() < count)
+            scratch.m_Indices.SetCapacity(count);
+        scratch.m_Indices.SetSize(count);
+
+        // Gather the keys, and find which bytes actually differ between the keys
+        RenderListSortPair* pairs = scratch.m_Pairs[0].Begin();
+        const uint64_t first_key = values[indices[0]].m_SortKey;
+        uint64_t diff = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint64_t key = values[indices[i]].m_SortKey;
+            pairs[i].m_Key = key;
+            pairs[i].m_Position = i;
+            diff |= key ^ first_key;
+        }
+
+        bool reused = previous_order.Size() == count && IsOrderValid(pairs, count, previous_order.Begin());
+        if (!reused)
+        {
+            if (previous_order.Capacity() < count)
+                previous_order.SetCapacity(count);
+            previous_order.SetSize(count);
+
+            uint32_t chunk_count = 1;
+            if (job_context)
+            {
+                chunk_count = dmMath::Min(dmJob::GetWorkerCount(job_context) + 1, RENDER_LIST_RADIX_MAX_CHUNKS);
+                chunk_count = dmMath::Max(1U, dmMath::Min(chunk_count, count / RENDER_LIST_RADIX_MIN_CHUNK_SIZE));
+            }
+
+            RadixSortContext ctx;
+            ctx.m_Scratch = &scratch;
+            ctx.m_Src = scratch.m_Pairs[0].Begin();
+            ctx.m_Dst = scratch.m_Pairs[1].Begin();
+            ctx.m_Count = count;
+            ctx.m_ChunkSize = (count + chunk_count - 1) / chunk_count;
+
+            for (uint32_t pass = 0; pass < RENDER_LIST_RADIX_PASSES; ++pass)
+            {
+                ctx.m_Shift = pass * RENDER_LIST_RADIX_BITS;
+                // All keys have the same digit, the pass wouldn't change the order
+                if (((diff >> ctx.m_Shift) & (RENDER_LIST_RADIX_BUCKETS - 1)) == 0)
+                    continue;
+
+                RadixSortRun(job_context, &ctx, RadixSortHistogram, chunk_count);
+
+                // Each chunk writes its part of a bucket after the previous chunks, which keeps the sort stable
+                uint32_t offset = 0;
+                for (uint32_t b = 0; b < RENDER_LIST_RADIX_BUCKETS; ++b)
+                {
+                    for (uint32_t c = 0; c < chunk_count; ++c)
+                    {
+                        uint32_t n = scratch.m_Histograms[c][b];
+                        scratch.m_Histograms[c][b] = offset;
+                        offset += n;
+                    }
+                }
+
+                RadixSortRun(job_context, &ctx, RadixSortScatter, chunk_count);
+
+                RenderListSortPair* tmp = ctx.m_Dst;
+                ctx.m_Dst = (RenderListSortPair*) ctx.m_Src;
+                ctx.m_Src = tmp;
+            }
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                previous_order[i] = ctx.m_Src[i].m_Position;
+            }
+        }
+
+        const uint32_t* order = previous_order.Begin();
+        uint32_t* sorted = scratch.m_Indices.Begin();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            sorted[i] = indices[order[i]];
+        }
+        memcpy(indices, sorted, sizeof(uint32_t) * count);
+        return reused;
+    }
+
     void RenderListEnd(HRenderContext render_context)
     {
+        RenderListMergeSegments(render_context);
+
         // Unflushed leftovers are assumed to be the debug rendering
         // and we give them render orders statically here
         FlushTexts(render_context, RENDER_ORDER_AFTER_WORLD, 0xffffff, true);
@@ -265,6 +595,12 @@ namespace dmRender
         render_context->m_SystemFontMap = font_map;
     }
 
+    void SetTextureUsedCallback(HRenderContext render_context, TextureUsedCallback callback, void* user_data)
+    {
+        render_context->m_TextureUsedCallback = callback;
+        render_context->m_TextureUsedCallbackUserData = user_data;
+    }
+
     dmGraphics::HContext GetGraphicsContext(HRenderContext render_context)
     {
         return render_context->m_GraphicsContext;
@@ -278,13 +614,534 @@ namespace dmRender
     void SetViewMatrix(HRenderContext render_context, const Matrix4& view)
     {
         render_context->m_View = view;
-        render_context->m_ViewProj = render_context->m_Projection * view;
+        UpdateFrameConstants(render_context);
+    }
+
+    const Matrix4& GetViewMatrix(HRenderContext render_context)
+    {
+        return render_context->m_View;
     }
 
     void SetProjectionMatrix(HRenderContext render_context, const Matrix4& projection)
     {
         render_context->m_Projection = projection;
-        render_context->m_ViewProj = projection * render_context->m_View;
+        UpdateFrameConstants(render_context);
+    }
+
+    void SetFrustum(HRenderContext render_context, const Matrix4* frustum_matrix)
+    {
+        render_context->m_FrustumCulling = frustum_matrix != 0;
+        if (frustum_matrix)
+        {
+            render_context->m_FrustumMatrix = *frustum_matrix;
+        }
+    }
+
+    void SetLayerMask(HRenderContext render_context, uint32_t layer_mask)
+    {
+        render_context->m_LayerMask = layer_mask;
+    }
+
+    uint32_t GetLayerMask(HRenderContext render_context)
+    {
+        return render_context->m_LayerMask;
+    }
+
+    // Number of boxes tested at a time. The plane tests are written over a batch so that the compiler can vectorize them
+    static const uint32_t CULL_BATCH_SIZE = 4;
+
+    struct FrustumPlanes
+    {
+        // Points with a*x + b*y + c*z + d >= 0 are on the inside of a plane
+        float m_A[6];
+        float m_B[6];
+        float m_C[6];
+        float m_D[6];
+    };
+
+    static void GetFrustumPlanes(const Matrix4& m, FrustumPlanes& planes)
+    {
+        // Gribb/Hartmann: the planes are the sums and differences of the last row with the other rows
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            uint32_t row = i / 2;
+            float sign = (i & 1) ? -1.0f : 1.0f;
+            planes.m_A[i] = m.getElem(0, 3) + sign * m.getElem(0, row);
+            planes.m_B[i] = m.getElem(1, 3) + sign * m.getElem(1, row);
+            planes.m_C[i] = m.getElem(2, 3) + sign * m.getElem(2, row);
+            planes.m_D[i] = m.getElem(3, 3) + sign * m.getElem(3, row);
+        }
+    }
+
+    // Writes 1 for the boxes that intersect the frustum, 0 for the ones fully outside of any plane
+    static uint32_t CullBounds(const FrustumPlanes& planes, const RenderListEntryBounds* bounds, const uint32_t* indices, uint32_t count, uint8_t* visibility)
+    {
+        uint32_t culled = 0;
+        for (uint32_t i = 0; i < count; i += CULL_BATCH_SIZE)
+        {
+            float cx[CULL_BATCH_SIZE], cy[CULL_BATCH_SIZE], cz[CULL_BATCH_SIZE];
+            float ex[CULL_BATCH_SIZE], ey[CULL_BATCH_SIZE], ez[CULL_BATCH_SIZE];
+            uint32_t n = dmMath::Min(CULL_BATCH_SIZE, count - i);
+            for (uint32_t l = 0; l < CULL_BATCH_SIZE; ++l)
+            {
+                const RenderListEntryBounds& b = bounds[i + (l < n ? l : 0)];
+                cx[l] = b.m_Center.getX();
+                cy[l] = b.m_Center.getY();
+                cz[l] = b.m_Center.getZ();
+                ex[l] = b.m_Extents.getX();
+                ey[l] = b.m_Extents.getY();
+                ez[l] = b.m_Extents.getZ();
+            }
+
+            uint32_t inside[CULL_BATCH_SIZE] = {1, 1, 1, 1};
+            for (uint32_t p = 0; p < 6; ++p)
+            {
+                const float a = planes.m_A[p], b = planes.m_B[p], c = planes.m_C[p], d = planes.m_D[p];
+                const float abs_a = dmMath::Abs(a), abs_b = dmMath::Abs(b), abs_c = dmMath::Abs(c);
+                for (uint32_t l = 0; l < CULL_BATCH_SIZE; ++l)
+                {
+                    // Distance of the box corner furthest along the plane normal
+                    float distance = a * cx[l] + b * cy[l] + c * cz[l] + d + abs_a * ex[l] + abs_b * ey[l] + abs_c * ez[l];
+                    inside[l] &= distance >= 0.0f;
+                }
+            }
+
+            for (uint32_t l = 0; l < n; ++l)
+            {
+                visibility[indices[i + l]] = (uint8_t) inside[l];
+                culled += 1 - inside[l];
+            }
+        }
+        return culled;
+    }
+
+    // Gathers the bounds of the entries added since the last call
+    static void UpdateRenderListBounds(HRenderContext context)
+    {
+        const uint32_t count = context->m_RenderList.Size();
+        const uint32_t start = context->m_RenderListBoundsCount;
+        if (start == count)
+            return;
+        context->m_RenderListBoundsCount = count;
+
+        DM_PROFILE(Render, "UpdateRenderListBounds");
+
+        // Group the new entries per dispatch, so that each visibility callback gets all of its entries at once
+        const RenderListEntry* entries = context->m_RenderList.Begin();
+        const dmArray<RenderListDispatch>& dispatches = context->m_RenderListDispatch;
+        uint32_t offsets[256 + 1];
+        memset(offsets, 0, sizeof(offsets));
+        for (uint32_t i = start; i < count; ++i)
+        {
+            uint8_t d = entries[i].m_Dispatch;
+            if (d < dispatches.Size() && dispatches[d].m_VisibilityFn)
+                ++offsets[d + 1];
+        }
+        for (uint32_t d = 1; d <= 256; ++d)
+            offsets[d] += offsets[d - 1];
+        if (offsets[256] == 0)
+            return;
+
+        // The bounds of the previous calls are kept, since they are tested again when switching frustum
+        const uint32_t base = context->m_RenderListCullIndices.Size();
+        context->m_RenderListCullIndices.SetCapacity(context->m_RenderList.Capacity());
+        context->m_RenderListCullIndices.SetSize(base + offsets[256]);
+        context->m_RenderListCullBounds.SetCapacity(context->m_RenderList.Capacity());
+        context->m_RenderListCullBounds.SetSize(base + offsets[256]);
+        uint32_t* indices = context->m_RenderListCullIndices.Begin() + base;
+        uint32_t write[256];
+        memcpy(write, offsets, sizeof(write));
+        for (uint32_t i = start; i < count; ++i)
+        {
+            uint8_t d = entries[i].m_Dispatch;
+            if (d < dispatches.Size() && dispatches[d].m_VisibilityFn)
+                indices[write[d]++] = i;
+        }
+
+        RenderListVisibilityParams params;
+        params.m_Context = context;
+        params.m_Entries = context->m_RenderList.Begin();
+
+        for (uint32_t d = 0; d < dispatches.Size(); ++d)
+        {
+            const RenderListDispatch& dispatch = dispatches[d];
+            uint32_t num_entries = offsets[d + 1] - offsets[d];
+            if (num_entries == 0)
+                continue;
+
+            params.m_UserData = dispatch.m_UserData;
+            params.m_Indices = indices + offsets[d];
+            params.m_Bounds = context->m_RenderListCullBounds.Begin() + base + offsets[d];
+            params.m_NumEntries = num_entries;
+            dispatch.m_VisibilityFn(params);
+        }
+    }
+
+    // Returns the view of the frustum, or reuses the least recently used view
+    static RenderListView* GetRenderListView(HRenderContext context, const Matrix4& frustum_matrix)
+    {
+        RenderListView* view = 0;
+        RenderListView* lru = &context->m_RenderListViews[0];
+        for (uint32_t i = 0; i < RENDER_LIST_VIEW_CACHE_SIZE; ++i)
+        {
+            RenderListView* v = &context->m_RenderListViews[i];
+            if (memcmp(&v->m_FrustumMatrix, &frustum_matrix, sizeof(Matrix4)) == 0)
+            {
+                view = v;
+                break;
+            }
+            if (v->m_LastUsed < lru->m_LastUsed)
+                lru = v;
+        }
+
+        if (!view)
+        {
+            view = lru;
+            view->m_FrustumMatrix = frustum_matrix;
+            view->m_Visibility.SetSize(0);
+            view->m_BoundsCount = 0;
+            view->m_OccluderVertexCount = 0;
+        }
+        view->m_LastUsed = ++context->m_RenderListViewUseCount;
+        return view;
+    }
+
+    void AddOccluder(HRenderContext context, const Matrix4& world_transform, const float* positions, uint32_t stride, uint32_t vertex_count)
+    {
+        vertex_count -= vertex_count % 3;
+        dmArray<Point3>& vertices = context->m_OccluderVertices;
+        if (vertices.Remaining() < vertex_count)
+        {
+            vertices.OffsetCapacity(dmMath::Max(vertex_count - vertices.Remaining(), vertices.Capacity() / 2));
+        }
+        for (uint32_t i = 0; i < vertex_count; ++i)
+        {
+            const float* p = positions + i * stride;
+            Vector4 v = world_transform * Point3(p[0], p[1], p[2]);
+            vertices.Push(Point3(v.getXYZ()));
+        }
+    }
+
+    // Vertices closer to the camera plane than this aren't projected. Triangles crossing the plane are skipped
+    // rather than clipped, and bounds crossing it are always visible
+    static const float OCCLUSION_MIN_W = 1e-4f;
+
+    // Projects the occluder triangles into the occlusion buffer of the view
+    static uint32_t SetupOccluderTriangles(HRenderContext context, const Matrix4& frustum_matrix)
+    {
+        const dmArray<Point3>& vertices = context->m_OccluderVertices;
+        dmArray<OccluderTriangle>& triangles = context->m_OccluderTriangles;
+        triangles.SetSize(0);
+        triangles.SetCapacity(vertices.Size() / 3);
+
+        for (uint32_t i = 0; i < vertices.Size(); i += 3)
+        {
+            OccluderTriangle t;
+            float depth = -FLT_MAX;
+            uint32_t v = 0;
+            for (; v < 3; ++v)
+            {
+                Vector4 clip = frustum_matrix * vertices[i + v];
+                float w = clip.getW();
+                if (w < OCCLUSION_MIN_W)
+                    break;
+                float inv_w = 1.0f / w;
+                t.m_X[v] = (clip.getX() * inv_w * 0.5f + 0.5f) * OCCLUSION_BUFFER_WIDTH;
+                t.m_Y[v] = (clip.getY() * inv_w * 0.5f + 0.5f) * OCCLUSION_BUFFER_HEIGHT;
+                depth = dmMath::Max(depth, clip.getZ() * inv_w);
+            }
+            if (v < 3 || depth > 1.0f)
+                continue;
+
+            // The edge functions are positive on the inside of counter clockwise triangles
+            float area = (t.m_X[1] - t.m_X[0]) * (t.m_Y[2] - t.m_Y[0]) - (t.m_Y[1] - t.m_Y[0]) * (t.m_X[2] - t.m_X[0]);
+            if (area == 0.0f)
+                continue;
+            if (area < 0.0f)
+            {
+                float x = t.m_X[1]; t.m_X[1] = t.m_X[2]; t.m_X[2] = x;
+                float y = t.m_Y[1]; t.m_Y[1] = t.m_Y[2]; t.m_Y[2] = y;
+            }
+
+            float min_x = dmMath::Min(t.m_X[0], dmMath::Min(t.m_X[1], t.m_X[2]));
+            float max_x = dmMath::Max(t.m_X[0], dmMath::Max(t.m_X[1], t.m_X[2]));
+            float min_y = dmMath::Min(t.m_Y[0], dmMath::Min(t.m_Y[1], t.m_Y[2]));
+            float max_y = dmMath::Max(t.m_Y[0], dmMath::Max(t.m_Y[1], t.m_Y[2]));
+            if (max_x < 0.0f || max_y < 0.0f || min_x >= OCCLUSION_BUFFER_WIDTH || min_y >= OCCLUSION_BUFFER_HEIGHT)
+                continue;
+
+            t.m_Depth = depth;
+            t.m_MinX = (int32_t) dmMath::Max(min_x, 0.0f);
+            t.m_MaxX = (int32_t) dmMath::Min(max_x, (float) (OCCLUSION_BUFFER_WIDTH - 1));
+            t.m_MinY = (int32_t) dmMath::Max(min_y, 0.0f);
+            t.m_MaxY = (int32_t) dmMath::Min(max_y, (float) (OCCLUSION_BUFFER_HEIGHT - 1));
+            triangles.Push(t);
+        }
+        return triangles.Size();
+    }
+
+    // Number of pixels rasterized at a time. Like CULL_BATCH_SIZE, the loops are written over a batch so that the compiler can vectorize them
+    static const uint32_t OCCLUSION_BATCH_SIZE = 4;
+
+    struct OcclusionRasterContext
+    {
+        const OccluderTriangle* m_Triangles;
+        uint32_t                m_TriangleCount;
+        float*                  m_Depth;
+        float*                  m_Tiles;
+    };
+
+    // Rasterizes the occluders into rows of tiles, each job owns its rows of the depth buffer
+    static void RasterizeOccluderRows(void* _ctx, uint32_t row_start, uint32_t row_end)
+    {
+        OcclusionRasterContext* ctx = (OcclusionRasterContext*) _ctx;
+        for (uint32_t tile_row = row_start; tile_row < row_end; ++tile_row)
+        {
+            const int32_t y_start = tile_row * OCCLUSION_TILE_SIZE;
+            const int32_t y_end = y_start + OCCLUSION_TILE_SIZE;
+            float* rows = ctx->m_Depth + y_start * OCCLUSION_BUFFER_WIDTH;
+            for (uint32_t i = 0; i < OCCLUSION_TILE_SIZE * OCCLUSION_BUFFER_WIDTH; ++i)
+            {
+                rows[i] = FLT_MAX;
+            }
+
+            for (uint32_t i = 0; i < ctx->m_TriangleCount; ++i)
+            {
+                const OccluderTriangle& t = ctx->m_Triangles[i];
+                if (t.m_MaxY < y_start || t.m_MinY >= y_end)
+                    continue;
+
+                // Edge function e(x, y) = a * x + b * y + c, for the edge from vertex e to the next one
+                float a[3], b[3], c[3];
+                for (uint32_t e = 0; e < 3; ++e)
+                {
+                    uint32_t n = e == 2 ? 0 : e + 1;
+                    a[e] = t.m_Y[e] - t.m_Y[n];
+                    b[e] = t.m_X[n] - t.m_X[e];
+                    c[e] = t.m_X[e] * t.m_Y[n] - t.m_X[n] * t.m_Y[e];
+                }
+
+                const float depth = t.m_Depth;
+                const int32_t x_start = t.m_MinX & ~(int32_t) (OCCLUSION_BATCH_SIZE - 1);
+                const int32_t y0 = dmMath::Max(t.m_MinY, y_start);
+                const int32_t y1 = dmMath::Min(t.m_MaxY, y_end - 1);
+                for (int32_t y = y0; y <= y1; ++y)
+                {
+                    // Sampled at the pixel centers
+                    const float py = y + 0.5f;
+                    const float r0 = b[0] * py + c[0], r1 = b[1] * py + c[1], r2 = b[2] * py + c[2];
+                    float* row = ctx->m_Depth + y * OCCLUSION_BUFFER_WIDTH;
+                    for (int32_t x = x_start; x <= t.m_MaxX; x += OCCLUSION_BATCH_SIZE)
+                    {
+                        for (uint32_t l = 0; l < OCCLUSION_BATCH_SIZE; ++l)
+                        {
+                            const float px = x + l + 0.5f;
+                            const bool inside = (a[0] * px + r0 >= 0.0f) & (a[1] * px + r1 >= 0.0f) & (a[2] * px + r2 >= 0.0f);
+                            const float d = row[x + l];
+                            row[x + l] = inside && depth < d ? depth : d;
+                        }
+                    }
+                }
+            }
+
+            // The tiles keep the farthest depth, a box behind it is behind all of the occluders in the tile
+            float* tiles = ctx->m_Tiles + tile_row * OCCLUSION_TILES_X;
+            for (uint32_t tx = 0; tx < OCCLUSION_TILES_X; ++tx)
+            {
+                float max_depth = -FLT_MAX;
+                for (uint32_t y = 0; y < OCCLUSION_TILE_SIZE; ++y)
+                {
+                    const float* p = rows + y * OCCLUSION_BUFFER_WIDTH + tx * OCCLUSION_TILE_SIZE;
+                    for (uint32_t x = 0; x < OCCLUSION_TILE_SIZE; ++x)
+                    {
+                        max_depth = dmMath::Max(max_depth, p[x]);
+                    }
+                }
+                tiles[tx] = max_depth;
+            }
+        }
+    }
+
+    static void RasterizeOccluders(HRenderContext context, RenderListView* view)
+    {
+        DM_PROFILE(Render, "RasterizeOccluders");
+
+        view->m_OccluderVertexCount = context->m_OccluderVertices.Size();
+        if (!view->m_OcclusionDepth)
+        {
+            view->m_OcclusionDepth = new float[OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT];
+            view->m_OcclusionTiles = new float[OCCLUSION_TILES_X * OCCLUSION_TILES_Y];
+        }
+
+        OcclusionRasterContext ctx;
+        ctx.m_TriangleCount = SetupOccluderTriangles(context, view->m_FrustumMatrix);
+        ctx.m_Triangles = context->m_OccluderTriangles.Begin();
+        ctx.m_Depth = view->m_OcclusionDepth;
+        ctx.m_Tiles = view->m_OcclusionTiles;
+
+        if (context->m_JobContext == 0)
+        {
+            RasterizeOccluderRows(&ctx, 0, OCCLUSION_TILES_Y);
+        }
+        else
+        {
+            dmJob::HJob job = dmJob::ParallelFor(context->m_JobContext, RasterizeOccluderRows, &ctx, OCCLUSION_TILES_Y, 1, dmJob::INVALID_JOB);
+            dmJob::Wait(context->m_JobContext, job);
+        }
+    }
+
+    static inline int32_t GetOcclusionTile(float ndc, uint32_t tile_count)
+    {
+        return (int32_t) dmMath::Clamp((ndc * 0.5f + 0.5f) * tile_count, 0.0f, (float) (tile_count - 1));
+    }
+
+    // Clears the visibility of the visible boxes that are behind the occluders in all the tiles they cover
+    static uint32_t OcclusionCullBounds(const Matrix4& m, const float* tiles, const RenderListEntryBounds* bounds, const uint32_t* indices, uint32_t count, uint8_t* visibility)
+    {
+        uint32_t culled = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint32_t index = indices[i];
+            if (!visibility[index])
+                continue;
+
+            const RenderListEntryBounds& b = bounds[i];
+            const Vector4 center = m * b.m_Center;
+            const Vector4 ax = m.getCol0() * b.m_Extents.getX();
+            const Vector4 ay = m.getCol1() * b.m_Extents.getY();
+            const Vector4 az = m.getCol2() * b.m_Extents.getZ();
+
+            float min_x = FLT_MAX, min_y = FLT_MAX, min_depth = FLT_MAX;
+            float max_x = -FLT_MAX, max_y = -FLT_MAX;
+            uint32_t corner = 0;
+            for (; corner < 8; ++corner)
+            {
+                const Vector4 p = center + ((corner & 1) ? ax : -ax) + ((corner & 2) ? ay : -ay) + ((corner & 4) ? az : -az);
+                // Written so that the NaNs of boxes with infinite extents fail the tests, those are always visible
+                const float w = p.getW();
+                if (!(w >= OCCLUSION_MIN_W))
+                    break;
+                const float inv_w = 1.0f / w;
+                const float x = p.getX() * inv_w, y = p.getY() * inv_w;
+                if (!(dmMath::Abs(x) < FLT_MAX && dmMath::Abs(y) < FLT_MAX))
+                    break;
+                min_x = dmMath::Min(min_x, x);
+                max_x = dmMath::Max(max_x, x);
+                min_y = dmMath::Min(min_y, y);
+                max_y = dmMath::Max(max_y, y);
+                min_depth = dmMath::Min(min_depth, p.getZ() * inv_w);
+            }
+            if (corner < 8)
+                continue;
+
+            const int32_t tx0 = GetOcclusionTile(min_x, OCCLUSION_TILES_X), tx1 = GetOcclusionTile(max_x, OCCLUSION_TILES_X);
+            const int32_t ty0 = GetOcclusionTile(min_y, OCCLUSION_TILES_Y), ty1 = GetOcclusionTile(max_y, OCCLUSION_TILES_Y);
+            bool occluded = true;
+            for (int32_t ty = ty0; ty <= ty1 && occluded; ++ty)
+            {
+                const float* row = tiles + ty * OCCLUSION_TILES_X;
+                for (int32_t tx = tx0; tx <= tx1; ++tx)
+                {
+                    if (!(row[tx] < min_depth))
+                    {
+                        occluded = false;
+                        break;
+                    }
+                }
+            }
+            if (occluded)
+            {
+                visibility[index] = 0;
+                ++culled;
+            }
+        }
+        return culled;
+    }
+
+    // Below this many bounds per chunk, it's not worth splitting the culling over the workers
+    static const uint32_t RENDER_LIST_CULL_CHUNK_SIZE = 4096;
+
+    struct CullContext
+    {
+        FrustumPlanes                   m_Planes;
+        Matrix4                         m_FrustumMatrix;
+        const float*                    m_OcclusionTiles;   // 0 if there are no occluders
+        const RenderListEntryBounds*    m_Bounds;
+        const uint32_t*                 m_Indices;
+        uint8_t*                        m_Visibility;
+        uint32_t                        m_Count;
+        int32_atomic_t                  m_Culled;
+        int32_atomic_t                  m_OcclusionCulled;
+    };
+
+    static void CullRenderListChunks(void* _ctx, uint32_t chunk_start, uint32_t chunk_end)
+    {
+        CullContext* ctx = (CullContext*) _ctx;
+        // The chunks write to different entries, since each entry has its bounds gathered once
+        uint32_t start = chunk_start * RENDER_LIST_CULL_CHUNK_SIZE;
+        uint32_t end = dmMath::Min(ctx->m_Count, chunk_end * RENDER_LIST_CULL_CHUNK_SIZE);
+        uint32_t culled = CullBounds(ctx->m_Planes, ctx->m_Bounds + start, ctx->m_Indices + start, end - start, ctx->m_Visibility);
+        dmAtomicAdd32(&ctx->m_Culled, (int32_t) culled);
+        if (ctx->m_OcclusionTiles)
+        {
+            culled = OcclusionCullBounds(ctx->m_FrustumMatrix, ctx->m_OcclusionTiles, ctx->m_Bounds + start, ctx->m_Indices + start, end - start, ctx->m_Visibility);
+            dmAtomicAdd32(&ctx->m_OcclusionCulled, (int32_t) culled);
+        }
+    }
+
+    void CullRenderList(HRenderContext context)
+    {
+        UpdateRenderListBounds(context);
+
+        RenderListView* view = GetRenderListView(context, context->m_FrustumMatrix);
+        context->m_RenderListView = view;
+
+        // Entries without bounds are always visible
+        const uint32_t count = context->m_RenderList.Size();
+        dmArray<uint8_t>& visibility = view->m_Visibility;
+        const uint32_t start = visibility.Size();
+        visibility.SetCapacity(context->m_RenderList.Capacity());
+        visibility.SetSize(count);
+        memset(visibility.Begin() + start, 1, count - start);
+
+        // Entries are only appended during a frame, so only the new bounds need to be tested
+        const uint32_t bounds_start = view->m_BoundsCount;
+        const uint32_t bounds_count = context->m_RenderListCullIndices.Size() - bounds_start;
+        view->m_BoundsCount = context->m_RenderListCullIndices.Size();
+        if (bounds_count == 0)
+            return;
+
+        DM_PROFILE(Render, "CullRenderList");
+
+        // The occluders are all added before the render script draws, the check is for views already used this frame
+        if (!context->m_OccluderVertices.Empty() && view->m_OccluderVertexCount != context->m_OccluderVertices.Size())
+        {
+            RasterizeOccluders(context, view);
+        }
+
+        CullContext ctx;
+        GetFrustumPlanes(view->m_FrustumMatrix, ctx.m_Planes);
+        ctx.m_FrustumMatrix = view->m_FrustumMatrix;
+        ctx.m_OcclusionTiles = context->m_OccluderVertices.Empty() ? 0 : view->m_OcclusionTiles;
+        ctx.m_Bounds = context->m_RenderListCullBounds.Begin() + bounds_start;
+        ctx.m_Indices = context->m_RenderListCullIndices.Begin() + bounds_start;
+        ctx.m_Visibility = visibility.Begin();
+        ctx.m_Count = bounds_count;
+        ctx.m_Culled = 0;
+        ctx.m_OcclusionCulled = 0;
+
+        uint32_t chunk_count = (bounds_count + RENDER_LIST_CULL_CHUNK_SIZE - 1) / RENDER_LIST_CULL_CHUNK_SIZE;
+        if (context->m_JobContext == 0 || chunk_count == 1)
+        {
+            CullRenderListChunks(&ctx, 0, chunk_count);
+        }
+        else
+        {
+            dmJob::HJob job = dmJob::ParallelFor(context->m_JobContext, CullRenderListChunks, &ctx, chunk_count, 1, dmJob::INVALID_JOB);
+            dmJob::Wait(context->m_JobContext, job);
+        }
+        DM_COUNTER("CulledRenderListEntries", ctx.m_Culled);
+        DM_COUNTER("OcclusionCulledRenderListEntries", ctx.m_OcclusionCulled);
     }
 
     Result AddToRender(HRenderContext context, RenderObject* ro)
@@ -304,6 +1161,89 @@ namespace dmRender
         return RESULT_OK;
     }
 
+    // Render targets of the pool that haven't been acquired for this many frames are deleted
+    static const uint32_t TRANSIENT_RENDER_TARGET_MAX_RELEASE_COUNT = 60;
+
+    static uint64_t GetTransientRenderTargetKey(uint32_t buffer_type_flags,
+        const dmGraphics::TextureCreationParams creation_params[dmGraphics::MAX_BUFFER_TYPE_COUNT],
+        const dmGraphics::TextureParams params[dmGraphics::MAX_BUFFER_TYPE_COUNT])
+    {
+        HashState64 key_state;
+        dmHashInit64(&key_state, false);
+        dmHashUpdateBuffer64(&key_state, &buffer_type_flags, sizeof(buffer_type_flags));
+        const dmGraphics::BufferType buffer_types[] = { dmGraphics::BUFFER_TYPE_COLOR_BIT, dmGraphics::BUFFER_TYPE_DEPTH_BIT, dmGraphics::BUFFER_TYPE_STENCIL_BIT };
+        for (uint32_t i = 0; i < sizeof(buffer_types) / sizeof(buffer_types[0]); ++i)
+        {
+            if (!(buffer_type_flags & buffer_types[i]))
+            {
+                continue;
+            }
+
+            uint32_t index = dmGraphics::GetBufferTypeIndex(buffer_types[i]);
+            const dmGraphics::TextureParams& p = params[index];
+            uint32_t values[] = { creation_params[index].m_Width, creation_params[index].m_Height,
+                (uint32_t) p.m_Format, (uint32_t) p.m_MinFilter, (uint32_t) p.m_MagFilter, (uint32_t) p.m_UWrap, (uint32_t) p.m_VWrap };
+            dmHashUpdateBuffer64(&key_state, values, sizeof(values));
+        }
+        return dmHashFinal64(&key_state);
+    }
+
+    dmGraphics::HRenderTarget AcquireTransientRenderTarget(HRenderContext render_context, uint32_t buffer_type_flags,
+        const dmGraphics::TextureCreationParams creation_params[dmGraphics::MAX_BUFFER_TYPE_COUNT],
+        const dmGraphics::TextureParams params[dmGraphics::MAX_BUFFER_TYPE_COUNT])
+    {
+        uint64_t key = GetTransientRenderTargetKey(buffer_type_flags, creation_params, params);
+
+        dmArray<TransientRenderTarget>& pool = render_context->m_TransientRenderTargets;
+        for (uint32_t i = 0; i < pool.Size(); ++i)
+        {
+            TransientRenderTarget& entry = pool[i];
+            if (!entry.m_Acquired && entry.m_Key == key)
+            {
+                entry.m_Acquired     = 1;
+                entry.m_ReleaseCount = 0;
+                return entry.m_RenderTarget;
+            }
+        }
+
+        dmGraphics::TextureCreationParams transient_creation_params[dmGraphics::MAX_BUFFER_TYPE_COUNT];
+        memcpy(transient_creation_params, creation_params, sizeof(transient_creation_params));
+        transient_creation_params[dmGraphics::GetBufferTypeIndex(dmGraphics::BUFFER_TYPE_DEPTH_BIT)].m_Transient   = 1;
+        transient_creation_params[dmGraphics::GetBufferTypeIndex(dmGraphics::BUFFER_TYPE_STENCIL_BIT)].m_Transient = 1;
+
+        TransientRenderTarget entry;
+        entry.m_RenderTarget = dmGraphics::NewRenderTarget(render_context->m_GraphicsContext, buffer_type_flags, transient_creation_params, params);
+        entry.m_Key          = key;
+        entry.m_ReleaseCount = 0;
+        entry.m_Acquired     = 1;
+
+        if (pool.Full())
+        {
+            pool.OffsetCapacity(8);
+        }
+        pool.Push(entry);
+        return entry.m_RenderTarget;
+    }
+
+    void ReleaseTransientRenderTargets(HRenderContext render_context)
+    {
+        dmArray<TransientRenderTarget>& pool = render_context->m_TransientRenderTargets;
+        for (uint32_t i = 0; i < pool.Size();)
+        {
+            TransientRenderTarget& entry = pool[i];
+            entry.m_Acquired = 0;
+            if (++entry.m_ReleaseCount > TRANSIENT_RENDER_TARGET_MAX_RELEASE_COUNT)
+            {
+                dmGraphics::DeleteRenderTarget(entry.m_RenderTarget);
+                pool.EraseSwap(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
     Result ClearRenderObjects(HRenderContext context)
     {
         context->m_RenderObjects.SetSize(0);
@@ -355,6 +1295,43 @@ namespace dmRender
         }
     }
 
+    // Projects the world space scissor rectangle of the render object into window pixels
+    static void ApplyScissor(HRenderContext render_context, const RenderObject* ro)
+    {
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        int32_t vx = 0, vy = 0;
+        int32_t vw = (int32_t) dmGraphics::GetWindowWidth(graphics_context);
+        int32_t vh = (int32_t) dmGraphics::GetWindowHeight(graphics_context);
+        if (render_context->m_ViewportSet)
+        {
+            vx = render_context->m_Viewport[0];
+            vy = render_context->m_Viewport[1];
+            vw = render_context->m_Viewport[2];
+            vh = render_context->m_Viewport[3];
+        }
+
+        const float* r = ro->m_ScissorRect;
+        const Matrix4& view_proj = render_context->m_ViewProj;
+        float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            Vector4 p = view_proj * Point3(r[(i & 1) ? 2 : 0], r[(i & 2) ? 3 : 1], 0.0f);
+            float w = p.getW();
+            float x = w != 0.0f ? p.getX() / w : p.getX();
+            float y = w != 0.0f ? p.getY() / w : p.getY();
+            min_x = dmMath::Min(min_x, x);
+            min_y = dmMath::Min(min_y, y);
+            max_x = dmMath::Max(max_x, x);
+            max_y = dmMath::Max(max_y, y);
+        }
+
+        int32_t x0 = vx + (int32_t) floorf((min_x * 0.5f + 0.5f) * vw);
+        int32_t y0 = vy + (int32_t) floorf((min_y * 0.5f + 0.5f) * vh);
+        int32_t x1 = vx + (int32_t) ceilf((max_x * 0.5f + 0.5f) * vw);
+        int32_t y1 = vy + (int32_t) ceilf((max_y * 0.5f + 0.5f) * vh);
+        dmGraphics::SetScissor(graphics_context, x0, y0, dmMath::Max(0, x1 - x0), dmMath::Max(0, y1 - y0));
+    }
+
     void ApplyRenderObjectConstants(HRenderContext render_context, HMaterial material, const RenderObject* ro)
     {
         dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
@@ -366,6 +1343,11 @@ namespace dmRender
                 if (c->m_Location != -1)
                 {
                     dmGraphics::SetConstantV4(graphics_context, &c->m_Value, c->m_Location);
+                    // The override replaced the material value in the program
+                    if (ro->m_Material)
+                    {
+                        DirtyMaterialConstants(ro->m_Material);
+                    }
                 }
             }
             return;
@@ -379,6 +1361,7 @@ namespace dmRender
                 if (location)
                 {
                     dmGraphics::SetConstantV4(graphics_context, &c->m_Value, *location);
+                    DirtyMaterialConstants(material);
                 }
             }
         }
@@ -412,6 +1395,9 @@ namespace dmRender
 
         RenderListSortValue* sort_values = context->m_RenderListSortValues.Begin();
         RenderListEntry* entries = context->m_RenderList.Begin();
+        const uint8_t* visibility = context->m_FrustumCulling ? context->m_RenderListView->m_Visibility.Begin() : 0;
+        const uint32_t layer_mask = context->m_LayerMask;
+        uint32_t layer_culled = 0;
 
         const Matrix4& transform = context->m_ViewProj;
 
@@ -439,7 +1425,7 @@ namespace dmRender
             {
                 uint32_t idx = context->m_RenderListSortIndices[i];
                 RenderListEntry* entry = &entries[idx];
-                if (entry->m_MajorOrder != RENDER_ORDER_WORLD)
+                if (entry->m_MajorOrder != RENDER_ORDER_WORLD || (visibility && !visibility[idx]) || !(layer_mask & (1u << entry->m_Layer)))
                     continue; // Could perhaps break here, if we also sorted on the major order (cost more when I tested it /MAWE)
 
                 const Vector4 res = transform * entry->m_WorldPosition;
@@ -464,7 +1450,14 @@ namespace dmRender
             for (uint32_t i = range.m_Start; i < range.m_Start+range.m_Count; ++i)
             {
                 uint32_t idx = context->m_RenderListSortIndices[i];
+                if (visibility && !visibility[idx])
+                    continue;
                 RenderListEntry* entry = &entries[idx];
+                if (!(layer_mask & (1u << entry->m_Layer)))
+                {
+                    ++layer_culled;
+                    continue;
+                }
 
                 sort_values[idx].m_MajorOrder = entry->m_MajorOrder;
                 if (entry->m_MajorOrder == RENDER_ORDER_WORLD)
@@ -483,6 +1476,7 @@ namespace dmRender
                 context->m_RenderListSortBuffer.Push(idx);
             }
         }
+        DM_COUNTER("LayerCulledRenderListEntries", layer_culled);
     }
 
     static void CollectRenderEntryRange(void* _ctx, uint32_t tag_list_key, size_t start, size_t count)
@@ -545,18 +1539,27 @@ namespace dmRender
     Result DrawRenderList(HRenderContext context, HPredicate predicate, HNamedConstantBuffer constant_buffer)
     {
         DM_PROFILE(Render, "DrawRenderList");
+        DM_MEM_SCOPE(Render);
 
         // This will add new entries for the most recent debug draw render objects.
         // The internal dispatch functions knows to only actually use the latest ones.
         // The sort order is also one below the Texts flush which is only also debug stuff.
         FlushDebug(context, 0xfffffe);
 
+        // Entries submitted to the segments after RenderListEnd
+        RenderListMergeSegments(context);
+
         // Cleared once per frame
         if (context->m_RenderListRanges.Empty())
         {
             SortRenderList(context);
         }
 
+        if (context->m_FrustumCulling)
+        {
+            CullRenderList(context);
+        }
+
         MakeSortBuffer(context, predicate?predicate->m_TagCount:0, predicate?predicate->m_Tags:0);
 
         if (context->m_RenderListSortBuffer.Empty())
@@ -564,9 +1567,11 @@ namespace dmRender
 
         {
             DM_PROFILE(Render, "DrawRenderList_SORT");
-            RenderListSorter sort;
-            sort.values = context->m_RenderListSortValues.Begin();
-            std::stable_sort(context->m_RenderListSortBuffer.Begin(), context->m_RenderListSortBuffer.End(), sort);
+            // The render scripts usually issue the same draw calls in the same order each frame
+            dmArray<uint32_t>& previous_order = context->m_RenderListSortOrders[context->m_RenderListDrawCount++ % RENDER_LIST_SORT_ORDER_CACHE_SIZE];
+            RadixSortRenderList(context->m_JobContext, context->m_RenderListSortValues.Begin(),
+                                context->m_RenderListSortBuffer.Begin(), context->m_RenderListSortBuffer.Size(),
+                                context->m_RenderListSortScratch, previous_order);
         }
 
         // Construct render objects
@@ -643,11 +1648,19 @@ namespace dmRender
 
         HMaterial material = render_context->m_Material;
         HMaterial context_material = render_context->m_Material;
+        // Texture unit of the light clusters sampled by the material, see AddLight
+        int32_t light_clusters_unit = -1;
         if(context_material)
         {
             dmGraphics::EnableProgram(context, GetMaterialProgram(context_material));
+            light_clusters_unit = ApplyLightClusters(render_context, context_material);
         }
 
+        // Textures are left bound between render objects, so that consecutive objects
+        // sharing a texture (adjacent in the sorted list) don't unbind and rebind it
+        dmGraphics::HTexture bound_textures[RenderObject::MAX_TEXTURE_COUNT] = {};
+        bool scissor_enabled = false;
+
         for (uint32_t i = 0; i < render_context->m_RenderObjects.Size(); ++i)
         {
             RenderObject* ro = render_context->m_RenderObjects[i];
@@ -669,6 +1682,7 @@ namespace dmRender
                 {
                     material = ro->m_Material;
                     dmGraphics::EnableProgram(context, GetMaterialProgram(material));
+                    light_clusters_unit = ApplyLightClusters(render_context, material);
                 }
             }
 
@@ -687,38 +1701,121 @@ namespace dmRender
             if (ro->m_SetFaceWinding)
                 dmGraphics::SetFaceWinding(context, ro->m_FaceWinding);
 
+            if (ro->m_SetScissor)
+            {
+                if (!scissor_enabled)
+                    dmGraphics::EnableState(context, dmGraphics::STATE_SCISSOR_TEST);
+                scissor_enabled = true;
+                ApplyScissor(render_context, ro);
+            }
+            else if (scissor_enabled)
+            {
+                dmGraphics::DisableState(context, dmGraphics::STATE_SCISSOR_TEST);
+                scissor_enabled = false;
+            }
+
             for (uint32_t i = 0; i < RenderObject::MAX_TEXTURE_COUNT; ++i)
             {
                 dmGraphics::HTexture texture = ro->m_Textures[i];
                 if (render_context->m_Textures[i])
                     texture = render_context->m_Textures[i];
+                if ((int32_t) i == light_clusters_unit)
+                    texture = render_context->m_LightTexture;
                 if (texture)
                 {
                     dmGraphics::EnableTexture(context, i, texture);
                     ApplyMaterialSampler(render_context, material, i, texture);
+                    if (texture != bound_textures[i] && render_context->m_TextureUsedCallback)
+                    {
+                        render_context->m_TextureUsedCallback(render_context->m_TextureUsedCallbackUserData, texture);
+                    }
                 }
-
+                else if (bound_textures[i])
+                {
+                    dmGraphics::DisableTexture(context, i, bound_textures[i]);
+                }
+                bound_textures[i] = texture;
             }
 
             dmGraphics::EnableVertexDeclaration(context, ro->m_VertexDeclaration, ro->m_VertexBuffer, GetMaterialProgram(material));
 
-            if (ro->m_IndexBuffer)
+            if (ro->m_InstanceCount > 0)
+            {
+                dmGraphics::EnableInstanceVertexDeclaration(context, ro->m_InstanceVertexDeclaration, ro->m_InstanceVertexBuffer, ro->m_InstanceStart, GetMaterialProgram(material));
+                if (ro->m_IndexBuffer)
+                    dmGraphics::DrawElementsInstanced(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_InstanceCount, ro->m_IndexType, ro->m_IndexBuffer);
+                else
+                    dmGraphics::DrawInstanced(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_InstanceCount);
+                dmGraphics::DisableInstanceVertexDeclaration(context, ro->m_InstanceVertexDeclaration);
+            }
+            else if (ro->m_IndexBuffer)
                 dmGraphics::DrawElements(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_IndexType, ro->m_IndexBuffer);
             else
                 dmGraphics::Draw(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount);
 
             dmGraphics::DisableVertexDeclaration(context, ro->m_VertexDeclaration);
+        }
 
-            for (uint32_t i = 0; i < RenderObject::MAX_TEXTURE_COUNT; ++i)
+        if (scissor_enabled)
+            dmGraphics::DisableState(context, dmGraphics::STATE_SCISSOR_TEST);
+
+        for (uint32_t i = 0; i < RenderObject::MAX_TEXTURE_COUNT; ++i)
+        {
+            if (bound_textures[i])
+                dmGraphics::DisableTexture(context, i, bound_textures[i]);
+        }
+        return RESULT_OK;
+    }
+
+    void AddRenderPassStats(HRenderContext render_context, HPredicate predicate, const dmGraphics::FrameStats& before)
+    {
+        dmGraphics::FrameStats after;
+        dmGraphics::GetCurrentFrameStats(render_context->m_GraphicsContext, &after);
+
+        uint32_t tag_count = predicate ? predicate->m_TagCount : 0;
+        dmArray<RenderPassStats>& passes = render_context->m_RenderPassStats;
+        RenderPassStats* pass = 0;
+        for (uint32_t i = 0; i < passes.Size(); ++i)
+        {
+            RenderPassStats& p = passes[i];
+            if (p.m_RenderTarget == render_context->m_RenderTarget && p.m_Predicate.m_TagCount == tag_count &&
+                (tag_count == 0 || memcmp(p.m_Predicate.m_Tags, predicate->m_Tags, sizeof(dmhash_t) * tag_count) == 0))
             {
-                dmGraphics::HTexture texture = ro->m_Textures[i];
-                if (render_context->m_Textures[i])
-                    texture = render_context->m_Textures[i];
-                if (texture)
-                    dmGraphics::DisableTexture(context, i, texture);
+                pass = &p;
+                break;
             }
         }
-        return RESULT_OK;
+
+        if (!pass)
+        {
+            if (passes.Full())
+            {
+                passes.OffsetCapacity(16);
+            }
+            passes.SetSize(passes.Size() + 1);
+            pass = &passes.Back();
+            memset(pass, 0, sizeof(*pass));
+            pass->m_Predicate.m_TagCount = tag_count;
+            if (tag_count)
+            {
+                memcpy(pass->m_Predicate.m_Tags, predicate->m_Tags, sizeof(dmhash_t) * tag_count);
+            }
+            pass->m_RenderTarget = render_context->m_RenderTarget;
+        }
+
+        dmGraphics::FrameStats& stats = pass->m_Stats;
+        stats.m_DrawCalls           += after.m_DrawCalls - before.m_DrawCalls;
+        stats.m_Primitives          += after.m_Primitives - before.m_Primitives;
+        stats.m_StateChanges        += after.m_StateChanges - before.m_StateChanges;
+        stats.m_RenderTargetChanges += after.m_RenderTargetChanges - before.m_RenderTargetChanges;
+        stats.m_BufferUploadBytes   += after.m_BufferUploadBytes - before.m_BufferUploadBytes;
+        stats.m_TextureUploadBytes  += after.m_TextureUploadBytes - before.m_TextureUploadBytes;
+    }
+
+    const RenderPassStats* GetRenderPassStats(HRenderContext context, uint32_t* count)
+    {
+        *count = context->m_LastRenderPassStats.Size();
+        return context->m_LastRenderPassStats.Begin();
     }
 
     Result DrawDebug3d(HRenderContext context)
@@ -873,6 +1970,10 @@ namespace dmRender
         dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
         ApplyContext context(graphics_context, material);
         constants.Iterate(ApplyConstant, &context);
+        if (constants.Size() > 0)
+        {
+            DirtyMaterialConstants(material);
+        }
     }
 
 }
@@ -19,6 +19,7 @@
 #include <dmsdk/render/render.h>
 
 #include <dlib/hash.h>
+#include <dlib/job.h>
 #include <script/script.h>
 #include <script/lua_source_ddf.h>
 #include <graphics/graphics.h>
@@ -31,6 +32,7 @@ namespace dmRender
     extern const char* RENDER_SOCKET_NAME;
 
     static const uint32_t MAX_MATERIAL_TAG_COUNT = 32; // Max tag count per material
+    static const uint32_t MAX_LAYER_COUNT = 32; // Number of render layers, see RenderListEntry::m_Layer
 
     typedef struct RenderTargetSetup*       HRenderTargetSetup;
     typedef uint64_t                        HRenderType;
@@ -93,9 +95,11 @@ namespace dmRender
         uint32_t                        m_FragmentShaderDescSize;
         uint32_t                        m_MaxCharacters;
         uint32_t                        m_CommandBufferSize;
-        /// Max debug vertex count
+        /// Initial debug vertex count, the debug buffers grow when more vertices are drawn
         /// NOTE: This is per debug-type and not the total sum
         uint32_t                        m_MaxDebugVertexCount;
+        /// Job context used to sort the render list in parallel. May be 0
+        dmJob::HContext                 m_JobContext;
     };
 
     static const uint8_t RENDERLIST_INVALID_DISPATCH = 0xff;
@@ -110,14 +114,94 @@ namespace dmRender
     void RenderListBegin(HRenderContext render_context);
     void RenderListEnd(HRenderContext render_context);
 
+    /**
+     * Allocate render entries from the render list segment of the calling thread.
+     * Unlike RenderListAlloc(), this may be called concurrently from the threads of the job context
+     * given in RenderContextParams (the thread that created it and its workers).
+     * The submitted entries are merged into the render list in RenderListEnd(), or before the list is sorted.
+     * The order of entries from different threads is the order of the thread indices.
+     * @note The returned pointer is only valid until the next call to RenderListSegmentAlloc() on the same thread
+     * @param render_context render context
+     * @param entries number of entries
+     * @return the render list entry array
+     */
+    RenderListEntry* RenderListSegmentAlloc(HRenderContext render_context, uint32_t entries);
+
+    /**
+     * Submit entries allocated with RenderListSegmentAlloc(), from the same thread
+     * @param render_context render context
+     * @param begin the start of the array
+     * @param end the end of the array
+     */
+    void RenderListSegmentSubmit(HRenderContext render_context, RenderListEntry* begin, RenderListEntry* end);
+
+    /**
+     * Get the job context used by the render context
+     * @param render_context render context
+     * @return the job context, may be 0
+     */
+    dmJob::HContext GetJobContext(HRenderContext render_context);
+
     void SetSystemFontMap(HRenderContext render_context, HFontMap font_map);
 
+    /// Called during render dispatch with the textures that are bound for drawing
+    typedef void (*TextureUsedCallback)(void* user_data, dmGraphics::HTexture texture);
+
+    /**
+     * Set the callback that is called when a texture is bound for drawing. Consecutive draws with the
+     * same texture only report it once. Used to find out which textures are visible, e.g. for texture streaming.
+     * @param render_context render context
+     * @param callback callback, or 0 to remove it
+     * @param user_data user data passed to the callback
+     */
+    void SetTextureUsedCallback(HRenderContext render_context, TextureUsedCallback callback, void* user_data);
+
     dmGraphics::HContext GetGraphicsContext(HRenderContext render_context);
 
     const Matrix4& GetViewProjectionMatrix(HRenderContext render_context);
     void SetViewMatrix(HRenderContext render_context, const Matrix4& view);
+    const Matrix4& GetViewMatrix(HRenderContext render_context);
     void SetProjectionMatrix(HRenderContext render_context, const Matrix4& projection);
 
+    /**
+     * Set the frustum that render list entries are culled against in the following draw calls.
+     * Only entries of dispatches registered with a visibility callback are culled.
+     * @param render_context Render context
+     * @param frustum_matrix The view projection matrix of the frustum, or 0 to disable culling
+     */
+    void SetFrustum(HRenderContext render_context, const Matrix4* frustum_matrix);
+
+    /**
+     * Set the render layers drawn by the following draw calls. Entries whose layer bit isn't set are skipped
+     * before they are sorted and batched.
+     * @param render_context Render context
+     * @param layer_mask One bit per layer, see RenderListEntry::m_Layer. All layers are drawn by default
+     */
+    void SetLayerMask(HRenderContext render_context, uint32_t layer_mask);
+    uint32_t GetLayerMask(HRenderContext render_context);
+
+    /**
+     * Get a render target from the pool of transient render targets. A free render target created with the
+     * same buffers and parameters is reused, otherwise a new one is created. The depth and stencil buffers
+     * of the pooled render targets are transient, their contents are discarded after rendering.
+     * @param render_context Render context
+     * @param buffer_type_flags Buffer types of the render target
+     * @param creation_params Creation parameters of each buffer type
+     * @param params Texture parameters of each buffer type
+     * @return The render target, valid until ReleaseTransientRenderTargets() is called
+     */
+    dmGraphics::HRenderTarget AcquireTransientRenderTarget(HRenderContext render_context, uint32_t buffer_type_flags,
+        const dmGraphics::TextureCreationParams creation_params[dmGraphics::MAX_BUFFER_TYPE_COUNT],
+        const dmGraphics::TextureParams params[dmGraphics::MAX_BUFFER_TYPE_COUNT]);
+
+    /**
+     * Return the acquired transient render targets to the pool. Called at the end of each frame, after
+     * the render commands using the render targets have been executed. Render targets that haven't been
+     * acquired for a number of frames are deleted.
+     * @param render_context Render context
+     */
+    void ReleaseTransientRenderTargets(HRenderContext render_context);
+
     Result ClearRenderObjects(HRenderContext context);
 
     // Takes the contents of the render list, sorts by view and inserts all the objects in the
@@ -125,6 +209,25 @@ namespace dmRender
     Result DrawRenderList(HRenderContext context, HPredicate predicate, HNamedConstantBuffer constant_buffer);
 
     Result Draw(HRenderContext context, HPredicate predicate, HNamedConstantBuffer constant_buffer);
+
+    /**
+     * Graphics counters of the render script draw calls with one predicate to one render target
+     * during a frame, see dmGraphics::FrameStats. m_TextureMemory is not used.
+     */
+    struct RenderPassStats
+    {
+        Predicate                   m_Predicate;
+        dmGraphics::HRenderTarget   m_RenderTarget;     // 0 for the default framebuffer
+        dmGraphics::FrameStats      m_Stats;
+    };
+
+    /**
+     * Get the render pass counters of the last frame. Passes are in the order they were first drawn.
+     * @param context Render context
+     * @param count [out] Number of passes
+     * @return The passes, valid until the next RenderListBegin
+     */
+    const RenderPassStats* GetRenderPassStats(HRenderContext context, uint32_t* count);
     Result DrawDebug3d(HRenderContext context);
     Result DrawDebug2d(HRenderContext context);
 
@@ -150,6 +253,15 @@ namespace dmRender
      */
     void Triangle3d(HRenderContext context, Point3 vertices[3], Vector4 color);
 
+    /**
+     * Render debug triangles in world space.
+     * @param context Render context handle
+     * @param points Vertices of the triangles, three per triangle, CW winding
+     * @param point_count Number of points
+     * @param color Color
+     */
+    void Triangles3D(HRenderContext context, const Point3* points, uint32_t point_count, Vector4 color);
+
     /**
      * Render debug line. The upper left corner of the screen is (-1,-1) and the bottom right is (1,1).
      * @param context Render context handle
@@ -171,6 +283,15 @@ namespace dmRender
      */
     void Line3D(HRenderContext context, Point3 start, Point3 end, Vector4 start_color, Vector4 end_color);
 
+    /**
+     * Render debug lines in world space.
+     * @param context Render context handle
+     * @param points Start and end points of the lines, two per line
+     * @param point_count Number of points
+     * @param color Color
+     */
+    void Lines3D(HRenderContext context, const Point3* points, uint32_t point_count, Vector4 color);
+
     HRenderScript   NewRenderScript(HRenderContext render_context, dmLuaDDF::LuaSource *source);
 
     bool            ReloadRenderScript(HRenderContext render_context, HRenderScript render_script, dmLuaDDF::LuaSource *source);
@@ -221,8 +342,21 @@ namespace dmRender
      */
     bool                            GetMaterialProgramConstantElement(HMaterial material, dmhash_t name_hash, uint32_t element_index, float& out_value);
     void                            SetMaterialProgramConstant(HMaterial material, dmhash_t name_hash, Vectormath::Aos::Vector4 constant);
+
+    /** Make the next ApplyMaterialConstants upload all constants of the material
+     * Needed when the program has lost its constant values, e.g. after it was relinked, or
+     * when other constants were written to the same locations
+     * @param material Material
+     */
+    void                            DirtyMaterialConstants(HMaterial material);
     int32_t                         GetMaterialConstantLocation(HMaterial material, dmhash_t name_hash);
     void                            SetMaterialSampler(HMaterial material, dmhash_t name_hash, uint32_t unit, dmGraphics::TextureWrap u_wrap, dmGraphics::TextureWrap v_wrap, dmGraphics::TextureFilter min_filter, dmGraphics::TextureFilter mag_filter);
+    /** Get the texture unit of a named sampler
+     * @param material Material
+     * @param name_hash Hashed sampler name
+     * @return Texture unit of the sampler, -1 if the material has no such sampler
+     */
+    int32_t                         GetMaterialSamplerUnit(HMaterial material, dmhash_t name_hash);
     HRenderContext                  GetMaterialRenderContext(HMaterial material);
     void                            SetMaterialVertexSpace(HMaterial material, dmRenderDDF::MaterialDesc::VertexSpace vertex_space);
 
@@ -11,7 +11,11 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdio.h>
+#include <string.h>
+#include <dlib/dstrings.h>
+#include <dlib/hash.h>
 #include <dlib/log.h>
+#include <dlib/profile.h>
 #include "render_command.h"
 #include "render_private.h"
 
@@ -52,6 +56,32 @@ namespace dmRender
         m_Operands[3] = op3;
     }
 
+    // Names the GPU timer of a draw after the predicate tags, e.g. "tile,gui".
+    // Returns 0 when the profiler isn't running.
+    static const char* GetGpuTimerName(const Predicate* predicate)
+    {
+        if (!dmProfile::g_IsInitialized)
+        {
+            return 0;
+        }
+
+        char name[128];
+        name[0] = 0;
+        for (uint32_t i = 0; predicate && i < predicate->m_TagCount; ++i)
+        {
+            if (i > 0)
+            {
+                dmStrlCat(name, ",", sizeof(name));
+            }
+            dmStrlCat(name, dmHashReverseSafe64(predicate->m_Tags[i]), sizeof(name));
+        }
+        if (name[0] == 0)
+        {
+            dmStrlCpy(name, "draw", sizeof(name));
+        }
+        return DM_INTERNALIZE(name);
+    }
+
     void ParseCommands(dmRender::HRenderContext render_context, Command* commands, uint32_t command_count)
     {
         dmGraphics::HContext context = dmRender::GetGraphicsContext(render_context);
@@ -74,6 +104,7 @@ namespace dmRender
                 case COMMAND_TYPE_SET_RENDER_TARGET:
                 {
                     dmGraphics::SetRenderTarget(context, (dmGraphics::HRenderTarget)c->m_Operands[0], c->m_Operands[1] );
+                    render_context->m_RenderTarget = (dmGraphics::HRenderTarget)c->m_Operands[0];
                     break;
                 }
                 case COMMAND_TYPE_ENABLE_TEXTURE:
@@ -102,6 +133,9 @@ namespace dmRender
                 case COMMAND_TYPE_SET_VIEWPORT:
                 {
                     dmGraphics::SetViewport(context, c->m_Operands[0], c->m_Operands[1], c->m_Operands[2], c->m_Operands[3]);
+                    for (uint32_t v = 0; v < 4; ++v)
+                        render_context->m_Viewport[v] = (int32_t) c->m_Operands[v];
+                    render_context->m_ViewportSet = 1;
                     break;
                 }
                 case COMMAND_TYPE_SET_VIEW:
@@ -118,6 +152,18 @@ namespace dmRender
                     delete matrix;
                     break;
                 }
+                case COMMAND_TYPE_SET_FRUSTUM:
+                {
+                    Vectormath::Aos::Matrix4* matrix = (Vectormath::Aos::Matrix4*)c->m_Operands[0];
+                    dmRender::SetFrustum(render_context, matrix);
+                    delete matrix;
+                    break;
+                }
+                case COMMAND_TYPE_SET_LAYER_MASK:
+                {
+                    dmRender::SetLayerMask(render_context, (uint32_t)c->m_Operands[0]);
+                    break;
+                }
                 case COMMAND_TYPE_SET_BLEND_FUNC:
                 {
                     dmGraphics::SetBlendFunc(context, (dmGraphics::BlendFactor)c->m_Operands[0], (dmGraphics::BlendFactor)c->m_Operands[1]);
@@ -165,7 +211,19 @@ namespace dmRender
                 }
                 case COMMAND_TYPE_DRAW:
                 {
+                    const char* timer_name = GetGpuTimerName((dmRender::Predicate*)c->m_Operands[0]);
+                    if (timer_name)
+                    {
+                        dmGraphics::BeginGpuTimer(context, timer_name, dmProfile::GetNameHash(timer_name, (uint32_t)strlen(timer_name)));
+                    }
+                    dmGraphics::FrameStats before;
+                    dmGraphics::GetCurrentFrameStats(context, &before);
                     dmRender::DrawRenderList(render_context, (dmRender::Predicate*)c->m_Operands[0], (dmRender::HNamedConstantBuffer)c->m_Operands[1]);
+                    AddRenderPassStats(render_context, (dmRender::Predicate*)c->m_Operands[0], before);
+                    if (timer_name)
+                    {
+                        dmGraphics::EndGpuTimer(context);
+                    }
                     break;
                 }
                 case COMMAND_TYPE_DRAW_DEBUG3D:
@@ -30,6 +30,8 @@ namespace dmRender
         COMMAND_TYPE_SET_VIEWPORT,
         COMMAND_TYPE_SET_VIEW,
         COMMAND_TYPE_SET_PROJECTION,
+        COMMAND_TYPE_SET_FRUSTUM,
+        COMMAND_TYPE_SET_LAYER_MASK,
         COMMAND_TYPE_SET_BLEND_FUNC,
         COMMAND_TYPE_SET_COLOR_MASK,
         COMMAND_TYPE_SET_DEPTH_MASK,
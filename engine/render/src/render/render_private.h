@@ -18,6 +18,7 @@
 #include <dlib/array.h>
 #include <dlib/message.h>
 #include <dlib/hashtable.h>
+#include <dlib/spinlock.h>
 
 #include "render.h"
 
@@ -69,6 +70,9 @@ namespace dmRender
         , m_UserData1(0)
         , m_UserData2(0)
         , m_VertexSpace(dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL)
+        , m_FrameConstantsVersion(0)
+        , m_LightClustersVersion(0)
+        , m_UserConstantsDirty(1)
         {
         }
 
@@ -83,6 +87,11 @@ namespace dmRender
         uint64_t                                m_UserData1;
         uint64_t                                m_UserData2;
         dmRenderDDF::MaterialDesc::VertexSpace  m_VertexSpace;
+        // Constant values are kept by the program between draw calls, so constants that don't
+        // depend on the render object are only uploaded when they change. See ApplyMaterialConstants
+        uint32_t                                m_FrameConstantsVersion; // RenderContext::m_FrameConstantsVersion last uploaded
+        uint32_t                                m_LightClustersVersion;  // RenderContext::m_LightClustersVersion of the light cluster constants
+        uint8_t                                 m_UserConstantsDirty : 1;
     };
 
     // The order of this enum also defines the order in which the corresponding ROs should be rendered
@@ -95,10 +104,17 @@ namespace dmRender
         MAX_DEBUG_RENDER_TYPE_COUNT
     };
 
+    struct DebugVertex
+    {
+        Vectormath::Aos::Vector4 m_Position;
+        Vectormath::Aos::Vector4 m_Color;
+    };
+
     struct DebugRenderTypeData
     {
         dmRender::RenderObject  m_RenderObject;
-        void*                   m_ClientBuffer;
+        // Grows on demand, the render object vertex count is the number of used vertices
+        dmArray<DebugVertex>    m_ClientBuffer;
     };
 
     struct DebugRenderer
@@ -110,6 +126,7 @@ namespace dmRender
         dmGraphics::HVertexBuffer       m_VertexBuffer;
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
         uint32_t                        m_MaxVertexCount;
+        uint32_t                        m_VertexBufferCapacity;
         uint32_t                        m_RenderBatchVersion;
     };
 
@@ -136,20 +153,43 @@ namespace dmRender
         float               m_Height;
         float               m_Leading;
         float               m_Tracking;
+        float               m_ScissorRect[4];
         int32_t             m_Next;
         int32_t             m_Tail;
         uint32_t            m_Align : 2;
         uint32_t            m_VAlign : 2;
         uint32_t            m_StencilTestParamsSet : 1;
+        uint32_t            m_ScissorSet : 1;
+        uint32_t            m_Instancing : 1;
+    };
+
+    struct Glyph;
+
+    // A glyph of a laid out text, at its pen position relative to the text origin
+    struct TextLayoutGlyph
+    {
+        Glyph*              m_Glyph;
+        int16_t             m_X;
+        int16_t             m_Y;
+    };
+
+    // The renderable glyphs of a laid out text, cached in TextContext::m_TextLayouts
+    struct TextLayout
+    {
+        TextLayoutGlyph*    m_Glyphs;
+        uint32_t            m_GlyphCount;
+        // Last frame the layout was used, unused layouts are eventually evicted
+        uint32_t            m_Frame;
     };
 
     struct TextContext
     {
         dmArray<dmRender::RenderObject>     m_RenderObjects;
-        dmGraphics::HVertexBuffer           m_VertexBuffer;
+        dmGraphics::HDynamicVertexBuffer    m_DynamicVertexBuffer;
         void*                               m_ClientBuffer;
         dmGraphics::HVertexDeclaration      m_VertexDecl;
         uint32_t                            m_RenderObjectIndex;
+        uint32_t                            m_RenderObjectsFlushed;
         uint32_t                            m_VertexIndex;
         uint32_t                            m_MaxVertexCount;
         uint32_t                            m_VerticesFlushed;
@@ -159,6 +199,25 @@ namespace dmRender
         uint32_t                            m_TextEntriesFlushed;
         uint32_t                            m_Frame;
         uint32_t                            m_PreviousFrame;
+        // Map from hash of text and layout parameters to the laid out glyphs, see GetTextLayout
+        dmHashTable64<TextLayout>           m_TextLayouts;
+        dmArray<TextLayoutGlyph>            m_TextLayoutScratch;
+        dmArray<uint64_t>                   m_TextLayoutEvictKeys;
+        uint32_t                            m_TextLayoutHits;
+        // Glyphs of the current batch missing from the glyph cache and their inflated data, see AddGlyphsToCache
+        dmArray<Glyph*>                     m_PendingGlyphs;
+        dmArray<uint8_t>                    m_GlyphInflateBuffer;
+        dmArray<uint32_t>                   m_GlyphInflateSizes;
+        // Instanced glyph rendering, see GlyphInstance. The buffers are created when first used
+        dmGraphics::HVertexDeclaration      m_QuadVertexDecl;
+        dmGraphics::HVertexBuffer           m_QuadVertexBuffer;
+        dmGraphics::HIndexBuffer            m_QuadIndexBuffer;
+        dmGraphics::HVertexDeclaration      m_InstanceDecl;
+        dmGraphics::HDynamicVertexBuffer    m_DynamicInstanceBuffer;
+        void*                               m_InstanceClientBuffer;
+        uint32_t                            m_InstanceIndex;
+        uint32_t                            m_MaxInstanceCount;
+        uint32_t                            m_InstancesFlushed;
     };
 
     struct RenderScriptContext
@@ -172,6 +231,7 @@ namespace dmRender
     struct RenderListDispatch
     {
         RenderListDispatchFn m_Fn;
+        RenderListVisibilityFn m_VisibilityFn;
         void *m_UserData;
     };
 
@@ -194,6 +254,96 @@ namespace dmRender
         };
     };
 
+    // Temporary key/position pair used while radix sorting the render list
+    struct RenderListSortPair
+    {
+        uint64_t m_Key;
+        uint32_t m_Position;    // Position in the unsorted buffer
+        uint32_t m_Pad;
+    };
+
+    static const uint32_t RENDER_LIST_RADIX_BUCKETS = 256;
+    static const uint32_t RENDER_LIST_RADIX_MAX_CHUNKS = 16;
+
+    struct RenderListSortScratch
+    {
+        dmArray<RenderListSortPair> m_Pairs[2];
+        dmArray<uint32_t>           m_Indices;
+        uint32_t                    m_Histograms[RENDER_LIST_RADIX_MAX_CHUNKS][RENDER_LIST_RADIX_BUCKETS];
+    };
+
+    // Number of draw calls per frame that remember their previous sort order
+    static const uint32_t RENDER_LIST_SORT_ORDER_CACHE_SIZE = 8;
+
+    // Number of frustums per frame that remember the visibility of the render list
+    static const uint32_t RENDER_LIST_VIEW_CACHE_SIZE = 4;
+
+    // Size of the depth buffer the occluders are rasterized into, see AddOccluder
+    static const uint32_t OCCLUSION_BUFFER_WIDTH = 256;
+    static const uint32_t OCCLUSION_BUFFER_HEIGHT = 128;
+    // Width and height of the tiles of the hierarchical depth buffer, in pixels. Also the height of the rows rasterized by each job
+    static const uint32_t OCCLUSION_TILE_SIZE = 8;
+    static const uint32_t OCCLUSION_TILES_X = OCCLUSION_BUFFER_WIDTH / OCCLUSION_TILE_SIZE;
+    static const uint32_t OCCLUSION_TILES_Y = OCCLUSION_BUFFER_HEIGHT / OCCLUSION_TILE_SIZE;
+
+    // Occluder triangle in the pixel space of the occlusion buffer, see RasterizeOccluders
+    struct OccluderTriangle
+    {
+        float   m_X[3];
+        float   m_Y[3];
+        float   m_Depth;    // The farthest depth of the vertices, which keeps the occluder conservative
+        int32_t m_MinX;     // Pixel bounds, clamped to the buffer
+        int32_t m_MaxX;
+        int32_t m_MinY;
+        int32_t m_MaxY;
+    };
+
+    // Number of light clusters along the x and y axis of the screen, and the depth of the view frustum, see AddLight
+    static const uint32_t LIGHT_CLUSTERS_X = 16;
+    static const uint32_t LIGHT_CLUSTERS_Y = 8;
+    static const uint32_t LIGHT_CLUSTERS_Z = 24;
+    static const uint32_t LIGHT_CLUSTER_COUNT = LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z;
+    // Lights beyond these are ignored, which bounds the per pixel cost of a cluster
+    static const uint32_t LIGHT_CLUSTER_MAX_LIGHTS = 128;
+    static const uint32_t MAX_LIGHT_COUNT = 4096;
+    // Width in texels of the light cluster texture. The texture holds the clusters, then the light indices and
+    // then the light data, three texels per light. See UpdateLightClusters
+    static const uint32_t LIGHT_TEXTURE_WIDTH = 512;
+    static const uint32_t LIGHT_DATA_TEXEL_COUNT = 3;
+
+    // Range of clusters reached by a light, inclusive
+    struct LightClusterBounds
+    {
+        uint8_t m_MinX;
+        uint8_t m_MaxX;
+        uint8_t m_MinY;
+        uint8_t m_MaxY;
+        uint8_t m_MinZ;
+        uint8_t m_MaxZ;
+        uint8_t m_Visible;
+    };
+
+    // Visibility of the render list against one frustum. Lets a render script switch between views,
+    // e.g. a main camera, a minimap and a shadow pass, without culling the render list again.
+    struct RenderListView
+    {
+        Matrix4                     m_FrustumMatrix;
+        dmArray<uint8_t>            m_Visibility;               // Per entry, for the first Size() entries of the render list
+        uint32_t                    m_BoundsCount;              // Number of m_RenderListCullBounds tested against the frustum
+        uint32_t                    m_LastUsed;
+        // Occlusion culling, only allocated once the view has been used with occluders
+        float*                      m_OcclusionDepth;           // Per pixel, the normalized device depth of the nearest occluder
+        float*                      m_OcclusionTiles;           // Per tile, the depth of the farthest pixel in m_OcclusionDepth
+        uint32_t                    m_OccluderVertexCount;      // Number of m_OccluderVertices rasterized into m_OcclusionDepth
+    };
+
+    // Render entries added by one thread with RenderListSegmentAlloc(), merged into the render list before sorting
+    struct RenderListSegment
+    {
+        dmArray<RenderListEntry>    m_Entries;
+        dmArray<uint32_t>           m_Indices;      // Submitted entries, index into m_Entries
+    };
+
     struct RenderListRange
     {
         uint32_t m_TagListKey;
@@ -208,6 +358,15 @@ namespace dmRender
         dmhash_t m_Tags[MAX_MATERIAL_TAG_COUNT];
     };
 
+    // A render target of the pool used by AcquireTransientRenderTarget
+    struct TransientRenderTarget
+    {
+        dmGraphics::HRenderTarget   m_RenderTarget;
+        uint64_t                    m_Key;          // Hash of the buffer types and their parameters
+        uint32_t                    m_ReleaseCount; // Number of ReleaseTransientRenderTargets calls since it was last acquired
+        uint32_t                    m_Acquired : 1;
+    };
+
     struct RenderContext
     {
         dmGraphics::HTexture        m_Textures[RenderObject::MAX_TEXTURE_COUNT];
@@ -220,20 +379,70 @@ namespace dmRender
 
         dmArray<RenderListEntry>    m_RenderList;
         dmArray<RenderListDispatch> m_RenderListDispatch;
+        dmSpinlock::lock_t          m_RenderListDispatchLock;
+        RenderListSegment*          m_RenderListSegments;       // One per job context thread
+        uint32_t                    m_RenderListSegmentCount;
         dmArray<RenderListSortValue>m_RenderListSortValues;
         dmArray<uint32_t>           m_RenderListSortBuffer;
         dmArray<uint32_t>           m_RenderListSortIndices;
         dmArray<RenderListRange>    m_RenderListRanges;         // Maps tagmask to a range in the (sorted) render list
+        RenderListSortScratch       m_RenderListSortScratch;
+        dmArray<uint32_t>           m_RenderListSortOrders[RENDER_LIST_SORT_ORDER_CACHE_SIZE]; // Sort order of the previous frame, per draw call
+        uint32_t                    m_RenderListDrawCount;      // Number of DrawRenderList calls this frame
+
+        // Layers drawn by the draw calls, see SetLayerMask
+        uint32_t                    m_LayerMask;
+
+        // Frustum culling, see SetFrustum
+        Matrix4                     m_FrustumMatrix;
+        RenderListView              m_RenderListViews[RENDER_LIST_VIEW_CACHE_SIZE];
+        RenderListView*             m_RenderListView;           // The view of the current frustum, see CullRenderList
+        uint32_t                    m_RenderListViewUseCount;
+        // The bounds don't depend on the frustum, so they are gathered once per entry and shared by all views
+        uint32_t                    m_RenderListBoundsCount;    // Number of render list entries that have had their bounds gathered
+        dmArray<uint32_t>           m_RenderListCullIndices;    // Entries with bounds, grouped per dispatch
+        dmArray<RenderListEntryBounds> m_RenderListCullBounds;  // The bounds of the m_RenderListCullIndices entries
+        // Occluder triangles of the frame in world space, see AddOccluder
+        dmArray<Point3>             m_OccluderVertices;
+        dmArray<OccluderTriangle>   m_OccluderTriangles;        // Scratch array of the rasterized view
+        // Local lights of the frame, see AddLight
+        dmArray<Light>              m_Lights;
+        dmArray<LightClusterBounds> m_LightClusterBounds;       // Per light
+        dmArray<uint16_t>           m_LightClusterIndices[LIGHT_CLUSTERS_Z]; // Per depth slice, the lights of each cluster in cluster order
+        uint16_t                    m_LightClusterCounts[LIGHT_CLUSTER_COUNT];
+        dmArray<float>              m_LightTextureData;
+        dmGraphics::HTexture        m_LightTexture;
+        Vector4                     m_LightClusterParams;       // Number of clusters along x, y and z, and the texture width
+        Vector4                     m_LightClusterDepth;        // Scale and bias from view depth to depth slice, whether the slices are logarithmic, and the light count
+        uint32_t                    m_LightClustersFrameVersion; // m_FrameConstantsVersion the clusters were built for, 0 if the lights have changed
+        uint32_t                    m_LightClustersVersion;     // Increased when the clusters are built, never zero
 
         dmHashTable32<MaterialTagList>  m_MaterialTagLists;
 
         HFontMap                    m_SystemFontMap;
 
+        dmArray<TransientRenderTarget> m_TransientRenderTargets;
+
+        TextureUsedCallback         m_TextureUsedCallback;
+        void*                       m_TextureUsedCallbackUserData;
+
         Matrix4                     m_View;
         Matrix4                     m_Projection;
         Matrix4                     m_ViewProj;
+        // m_Projection and m_ViewProj in the clip space of the graphics adapter
+        Matrix4                     m_ClipProjection;
+        Matrix4                     m_ClipViewProj;
+        // Increased when any of the matrices above change, never zero
+        uint32_t                    m_FrameConstantsVersion;
+        // Last viewport set by a render command (x, y, width, height), see m_ViewportSet
+        int32_t                     m_Viewport[4];
+        // Render target set by the last render command, and the render passes of the current and last frame
+        dmGraphics::HRenderTarget   m_RenderTarget;
+        dmArray<RenderPassStats>    m_RenderPassStats;
+        dmArray<RenderPassStats>    m_LastRenderPassStats;
 
         dmGraphics::HContext        m_GraphicsContext;
+        dmJob::HContext             m_JobContext;
 
         HMaterial                   m_Material;
 
@@ -241,8 +450,18 @@ namespace dmRender
 
         uint32_t                    m_OutOfResources : 1;
         uint32_t                    m_StencilBufferCleared : 1;
+        uint32_t                    m_FrustumCulling : 1;
+        uint32_t                    m_ViewportSet : 1;
     };
 
+    void InitializeLightClusters(HRenderContext render_context);
+    void FinalizeLightClusters(HRenderContext render_context);
+    // Assigns the lights of the frame to the clusters of the current view and projection, and uploads the light cluster texture
+    void UpdateLightClusters(HRenderContext render_context);
+    // Returns the sampler unit the light clusters are bound to, or -1 if the material doesn't sample them.
+    // Builds the clusters if needed, and sets the light cluster constants of the material
+    int32_t ApplyLightClusters(HRenderContext render_context, HMaterial material);
+
     void RenderTypeTextBegin(HRenderContext rendercontext, void* user_context);
     void RenderTypeTextDraw(HRenderContext rendercontext, void* user_context, RenderObject* ro_, uint32_t count);
 
@@ -251,6 +470,9 @@ namespace dmRender
 
     Result GenerateKey(HRenderContext render_context, const Matrix4& view_matrix);
 
+    // Adds the graphics counters since 'before' to the pass of the predicate and the current render target
+    void AddRenderPassStats(HRenderContext render_context, HPredicate predicate, const dmGraphics::FrameStats& before);
+
     void ApplyRenderObjectConstants(HRenderContext render_context, HMaterial material, const struct RenderObject* ro);
 
     // Return true if the predicate tags all exist in the material tag list
@@ -260,6 +482,10 @@ namespace dmRender
     // Gets the list associated with a hash of all the tags (see RegisterMaterialTagList)
     void                            GetMaterialTagList(HRenderContext context, uint32_t list_hash, MaterialTagList* list);
 
+    // Computes the visibility of the render list entries against the current frustum, and the occluders if
+    // there are any. Only the entries added since the frustum was last culled against are tested.
+    void CullRenderList(HRenderContext context);
+
     // Exposed here for unit testing
     struct RenderListEntrySorter
     {
@@ -281,6 +507,14 @@ namespace dmRender
         }
     };
 
+    // Stable sort of the indices on values[index].m_SortKey, using a LSD radix sort that is split over the job context workers (if any).
+    // If previous_order still orders the keys the same way, it's reused instead of sorting. On return, it holds the new order.
+    // Returns true if the previous order was reused
+    bool RadixSortRenderList(dmJob::HContext job_context, const RenderListSortValue* values, uint32_t* indices, uint32_t count, RenderListSortScratch& scratch, dmArray<uint32_t>& previous_order);
+
+    // Move the entries of all segments into the render list
+    void RenderListMergeSegments(HRenderContext render_context);
+
     typedef void (*RangeCallback)(void* ctx, uint32_t val, size_t start, size_t count);
 
     // Invokes the callback for each range. Two ranges are not guaranteed to preceed/succeed one another.
@@ -12,6 +12,7 @@
 
 #include "render_script.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <new>
 
@@ -53,6 +54,8 @@ namespace dmRender
 
     #define RENDER_SCRIPT_PREDICATE "RenderScriptPredicate"
 
+    #define RENDER_SCRIPT_COMMANDLIST "RenderScriptCommandList"
+
     #define RENDER_SCRIPT_LIB_NAME "render"
     #define RENDER_SCRIPT_FORMAT_NAME "format"
     #define RENDER_SCRIPT_WIDTH_NAME "width"
@@ -66,6 +69,10 @@ namespace dmRender
     static uint32_t RENDER_SCRIPT_INSTANCE_TYPE_HASH = 0;
     static uint32_t RENDER_SCRIPT_CONSTANTBUFFER_TYPE_HASH = 0;
     static uint32_t RENDER_SCRIPT_PREDICATE_TYPE_HASH = 0;
+    static uint32_t RENDER_SCRIPT_COMMANDLIST_TYPE_HASH = 0;
+
+    // Recorded matrix operand of render.set_frustum(nil)
+    static const uintptr_t INVALID_MATRIX_INDEX = ~(uintptr_t)0;
 
     const char* RENDER_SCRIPT_FUNCTION_NAMES[MAX_RENDER_SCRIPT_FUNCTION_COUNT] =
     {
@@ -172,6 +179,50 @@ namespace dmRender
         {0, 0}
     };
 
+    static void DeleteCommandList(lua_State* L, RenderCommandList* list)
+    {
+        for (uint32_t i = 0; i < list->m_References.Size(); ++i)
+        {
+            dmScript::Unref(L, LUA_REGISTRYINDEX, list->m_References[i]);
+        }
+        for (uint32_t i = 0; i < list->m_Params.Size(); ++i)
+        {
+            free((void*)list->m_Params[i].m_Name);
+        }
+        delete list;
+    }
+
+    static RenderCommandList** RenderScriptCommandList_Check(lua_State *L, int index)
+    {
+        return (RenderCommandList**)dmScript::CheckUserType(L, index, RENDER_SCRIPT_COMMANDLIST_TYPE_HASH, "Expected a command list (acquired from the render.end_record function)");
+    }
+
+    static int RenderScriptCommandList_gc (lua_State *L)
+    {
+        RenderCommandList** list = (RenderCommandList**)lua_touserdata(L, 1);
+        DeleteCommandList(L, *list);
+        *list = 0;
+        return 0;
+    }
+
+    static int RenderScriptCommandList_tostring (lua_State *L)
+    {
+        lua_pushfstring(L, "CommandList: %p", lua_touserdata(L, 1));
+        return 1;
+    }
+
+    static const luaL_reg RenderScriptCommandList_methods[] =
+    {
+        {0,0}
+    };
+
+    static const luaL_reg RenderScriptCommandList_meta[] =
+    {
+        {"__gc",        RenderScriptCommandList_gc},
+        {"__tostring",  RenderScriptCommandList_tostring},
+        {0, 0}
+    };
+
     /*# create a new constant buffer.
      *
      * Constant buffers are used to set shader program variables and are optionally passed to the `render.draw()` function. The buffer's constant elements can be indexed like an ordinary Lua table, but you can't iterate over them with pairs() or ipairs().
@@ -357,9 +408,65 @@ namespace dmRender
         {0, 0}
     };
 
+    static void RecordCommand(RenderCommandList* list, const Command& command)
+    {
+        Command recorded = command;
+        switch (command.m_Type)
+        {
+            case COMMAND_TYPE_SET_VIEW:
+            case COMMAND_TYPE_SET_PROJECTION:
+            case COMMAND_TYPE_SET_FRUSTUM:
+            {
+                // The list owns its matrices, since it is executed more than once
+                Vectormath::Aos::Matrix4* matrix = (Vectormath::Aos::Matrix4*)command.m_Operands[0];
+                recorded.m_Operands[0] = INVALID_MATRIX_INDEX;
+                if (matrix)
+                {
+                    if (list->m_Matrices.Full())
+                        list->m_Matrices.OffsetCapacity(8);
+                    recorded.m_Operands[0] = list->m_Matrices.Size();
+                    list->m_Matrices.Push(*matrix);
+                    delete matrix;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        if (list->m_Commands.Full())
+            list->m_Commands.OffsetCapacity(32);
+        list->m_Commands.Push(recorded);
+    }
+
+    // Records a command whose matrix or constant buffer operand is bound by name in render.execute()
+    static void RecordCommandParam(RenderCommandList* list, const Command& command, const char* name)
+    {
+        RenderCommandParam param;
+        param.m_Name = strdup(name);
+        param.m_CommandIndex = list->m_Commands.Size();
+        if (list->m_Params.Full())
+            list->m_Params.OffsetCapacity(8);
+        list->m_Params.Push(param);
+
+        if (list->m_Commands.Full())
+            list->m_Commands.OffsetCapacity(32);
+        list->m_Commands.Push(command);
+    }
+
+    static void RecordReference(lua_State* L, RenderCommandList* list, int index)
+    {
+        lua_pushvalue(L, index);
+        if (list->m_References.Full())
+            list->m_References.OffsetCapacity(8);
+        list->m_References.Push(dmScript::Ref(L, LUA_REGISTRYINDEX));
+    }
+
     bool InsertCommand(RenderScriptInstance* i, const Command& command)
     {
-        if (i->m_CommandBuffer.Full())
+        if (i->m_CommandList)
+            RecordCommand(i->m_CommandList, command);
+        else if (i->m_CommandBuffer.Full())
             return false;
         else
             i->m_CommandBuffer.Push(command);
@@ -590,80 +697,17 @@ namespace dmRender
      * @variable
      */
 
-    /*# creates a new render target
-     * Creates a new render target according to the supplied
-     * specification table.
-     *
-     * The table should contain keys specifying which buffers should be created
-     * with what parameters. Each buffer key should have a table value consisting
-     * of parameters. The following parameter keys are available:
-     *
-     * Key          | Values
-     * ------------ | ----------------------------
-     * `format`     |  `render.FORMAT_LUMINANCE`<br/>`render.FORMAT_RGB`<br/>`render.FORMAT_RGBA`<br/> `render.FORMAT_RGB_DXT1`<br/>`render.FORMAT_RGBA_DXT1`<br/>`render.FORMAT_RGBA_DXT3`<br/> `render.FORMAT_RGBA_DXT5`<br/>`render.FORMAT_DEPTH`<br/>`render.FORMAT_STENCIL`<br/>
-     * `width`      | number
-     * `height`     | number
-     * `min_filter` | `render.FILTER_LINEAR`<br/>`render.FILTER_NEAREST`
-     * `mag_filter` | `render.FILTER_LINEAR`<br/>`render.FILTER_NEAREST`
-     * `u_wrap`     | `render.WRAP_CLAMP_TO_BORDER`<br/>`render.WRAP_CLAMP_TO_EDGE`<br/>`render.WRAP_MIRRORED_REPEAT`<br/>`render.WRAP_REPEAT`<br/>
-     * `v_wrap`     | `render.WRAP_CLAMP_TO_BORDER`<br/>`render.WRAP_CLAMP_TO_EDGE`<br/>`render.WRAP_MIRRORED_REPEAT`<br/>`render.WRAP_REPEAT`
-     *
-     * @name render.render_target
-     * @param name [type:string] render target name
-     * @param parameters [type:table] table of buffer parameters, see the description for available keys and values
-     * @return render_target [type:render_target] new render target
-     * @examples
-     *
-     * How to create a new render target and draw to it:
-     *
-     * ```lua
-     * function init(self)
-     *     -- render target buffer parameters
-     *     local color_params = { format = render.FORMAT_RGBA,
-     *                            width = render.get_window_width(),
-     *                            height = render.get_window_height(),
-     *                            min_filter = render.FILTER_LINEAR,
-     *                            mag_filter = render.FILTER_LINEAR,
-     *                            u_wrap = render.WRAP_CLAMP_TO_EDGE,
-     *                            v_wrap = render.WRAP_CLAMP_TO_EDGE }
-     *     local depth_params = { format = render.FORMAT_DEPTH,
-     *                            width = render.get_window_width(),
-     *                            height = render.get_window_height(),
-     *                            u_wrap = render.WRAP_CLAMP_TO_EDGE,
-     *                            v_wrap = render.WRAP_CLAMP_TO_EDGE }
-     *     self.my_render_target = render.render_target({[render.BUFFER_COLOR_BIT] = color_params, [render.BUFFER_DEPTH_BIT] = depth_params })
-     * end
-     *
-     * function update(self, dt)
-     *     -- enable target so all drawing is done to it
-     *     render.enable_render_target(self.my_render_target)
-     *
-     *     -- draw a predicate to the render target
-     *     render.draw(self.my_pred)
-     * end
-     * ```
-     *
-     */
-    int RenderScript_RenderTarget(lua_State* L)
+    // Reads the buffer parameters of render.render_target and render.acquire_render_target
+    static int CheckRenderTargetParams(lua_State* L, int table_index, dmGraphics::HContext graphics_context, uint32_t* buffer_type_flags_out,
+        dmGraphics::TextureCreationParams creation_params[dmGraphics::MAX_BUFFER_TYPE_COUNT], dmGraphics::TextureParams params[dmGraphics::MAX_BUFFER_TYPE_COUNT])
     {
         int top = lua_gettop(L);
         (void)top;
 
-        RenderScriptInstance* i = RenderScriptInstance_Check(L);
-
-        // Legacy support
-        int table_index = 2;
-        if (lua_istable(L, 1))
-        {
-            table_index = 1;
-        }
-
         const char* required_keys[] = { "format", "width", "height" };
         uint32_t buffer_type_flags = 0;
-        uint32_t max_tex_size = dmGraphics::GetMaxTextureSize(i->m_RenderContext->m_GraphicsContext);
+        uint32_t max_tex_size = dmGraphics::GetMaxTextureSize(graphics_context);
         luaL_checktype(L, table_index, LUA_TTABLE);
-        dmGraphics::TextureCreationParams creation_params[dmGraphics::MAX_BUFFER_TYPE_COUNT];
-        dmGraphics::TextureParams params[dmGraphics::MAX_BUFFER_TYPE_COUNT];
         lua_pushnil(L);
         while (lua_next(L, table_index))
         {
@@ -777,6 +821,84 @@ namespace dmRender
             }
         }
 
+        *buffer_type_flags_out = buffer_type_flags;
+        assert(top == lua_gettop(L));
+        return 0;
+    }
+
+    /*# creates a new render target
+     * Creates a new render target according to the supplied
+     * specification table.
+     *
+     * The table should contain keys specifying which buffers should be created
+     * with what parameters. Each buffer key should have a table value consisting
+     * of parameters. The following parameter keys are available:
+     *
+     * Key          | Values
+     * ------------ | ----------------------------
+     * `format`     |  `render.FORMAT_LUMINANCE`<br/>`render.FORMAT_RGB`<br/>`render.FORMAT_RGBA`<br/> `render.FORMAT_RGB_DXT1`<br/>`render.FORMAT_RGBA_DXT1`<br/>`render.FORMAT_RGBA_DXT3`<br/> `render.FORMAT_RGBA_DXT5`<br/>`render.FORMAT_DEPTH`<br/>`render.FORMAT_STENCIL`<br/>
+     * `width`      | number
+     * `height`     | number
+     * `min_filter` | `render.FILTER_LINEAR`<br/>`render.FILTER_NEAREST`
+     * `mag_filter` | `render.FILTER_LINEAR`<br/>`render.FILTER_NEAREST`
+     * `u_wrap`     | `render.WRAP_CLAMP_TO_BORDER`<br/>`render.WRAP_CLAMP_TO_EDGE`<br/>`render.WRAP_MIRRORED_REPEAT`<br/>`render.WRAP_REPEAT`<br/>
+     * `v_wrap`     | `render.WRAP_CLAMP_TO_BORDER`<br/>`render.WRAP_CLAMP_TO_EDGE`<br/>`render.WRAP_MIRRORED_REPEAT`<br/>`render.WRAP_REPEAT`
+     *
+     * @name render.render_target
+     * @param name [type:string] render target name
+     * @param parameters [type:table] table of buffer parameters, see the description for available keys and values
+     * @return render_target [type:render_target] new render target
+     * @examples
+     *
+     * How to create a new render target and draw to it:
+     *
+     * ```lua
+     * function init(self)
+     *     -- render target buffer parameters
+     *     local color_params = { format = render.FORMAT_RGBA,
+     *                            width = render.get_window_width(),
+     *                            height = render.get_window_height(),
+     *                            min_filter = render.FILTER_LINEAR,
+     *                            mag_filter = render.FILTER_LINEAR,
+     *                            u_wrap = render.WRAP_CLAMP_TO_EDGE,
+     *                            v_wrap = render.WRAP_CLAMP_TO_EDGE }
+     *     local depth_params = { format = render.FORMAT_DEPTH,
+     *                            width = render.get_window_width(),
+     *                            height = render.get_window_height(),
+     *                            u_wrap = render.WRAP_CLAMP_TO_EDGE,
+     *                            v_wrap = render.WRAP_CLAMP_TO_EDGE }
+     *     self.my_render_target = render.render_target({[render.BUFFER_COLOR_BIT] = color_params, [render.BUFFER_DEPTH_BIT] = depth_params })
+     * end
+     *
+     * function update(self, dt)
+     *     -- enable target so all drawing is done to it
+     *     render.enable_render_target(self.my_render_target)
+     *
+     *     -- draw a predicate to the render target
+     *     render.draw(self.my_pred)
+     * end
+     * ```
+     *
+     */
+    int RenderScript_RenderTarget(lua_State* L)
+    {
+        int top = lua_gettop(L);
+        (void)top;
+
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+
+        // Legacy support
+        int table_index = 2;
+        if (lua_istable(L, 1))
+        {
+            table_index = 1;
+        }
+
+        uint32_t buffer_type_flags = 0;
+        dmGraphics::TextureCreationParams creation_params[dmGraphics::MAX_BUFFER_TYPE_COUNT];
+        dmGraphics::TextureParams params[dmGraphics::MAX_BUFFER_TYPE_COUNT];
+        CheckRenderTargetParams(L, table_index, i->m_RenderContext->m_GraphicsContext, &buffer_type_flags, creation_params, params);
+
         dmGraphics::HRenderTarget render_target = dmGraphics::NewRenderTarget(i->m_RenderContext->m_GraphicsContext, buffer_type_flags, creation_params, params);
 
         lua_pushlightuserdata(L, (void*)render_target);
@@ -785,6 +907,71 @@ namespace dmRender
         return 1;
     }
 
+    /*# gets a render target for the current frame
+     * Gets a render target from a pool of render targets, according to the supplied
+     * specification table. The table has the same format as for [ref:render.render_target].
+     *
+     * The render target is only valid during the current frame and must not be deleted.
+     * It is returned to the pool at the end of the frame, and the same render target may
+     * be returned again in a later frame, or to another call with the same specification.
+     * Use this for intermediate buffers, e.g. in a post processing chain, that are drawn to
+     * and sampled within a frame.
+     *
+     * The contents of the depth and stencil buffers are discarded after rendering, which saves
+     * memory bandwidth on tile based GPUs.
+     *
+     * @name render.acquire_render_target
+     * @param parameters [type:table] table of buffer parameters, see [ref:render.render_target]
+     * @return render_target [type:render_target] render target for the current frame
+     * @examples
+     *
+     * How to blur the scene with two intermediate render targets:
+     *
+     * ```lua
+     * function update(self, dt)
+     *     local params = { format = render.FORMAT_RGBA,
+     *                      width = render.get_window_width() / 2,
+     *                      height = render.get_window_height() / 2,
+     *                      min_filter = render.FILTER_LINEAR,
+     *                      mag_filter = render.FILTER_LINEAR }
+     *     local scene = render.acquire_render_target({[render.BUFFER_COLOR_BIT] = params })
+     *     local blur = render.acquire_render_target({[render.BUFFER_COLOR_BIT] = params })
+     *
+     *     render.set_render_target(scene)
+     *     render.draw(self.model_pred)
+     *
+     *     render.set_render_target(blur)
+     *     render.enable_texture(0, scene, render.BUFFER_COLOR_BIT)
+     *     render.draw(self.blur_pred)
+     *     render.disable_texture(0)
+     *
+     *     render.set_render_target(render.RENDER_TARGET_DEFAULT)
+     *     render.enable_texture(0, blur, render.BUFFER_COLOR_BIT)
+     *     render.draw(self.composite_pred)
+     *     render.disable_texture(0)
+     * end
+     * ```
+     */
+    int RenderScript_AcquireRenderTarget(lua_State* L)
+    {
+        int top = lua_gettop(L);
+        (void)top;
+
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+
+        uint32_t buffer_type_flags = 0;
+        dmGraphics::TextureCreationParams creation_params[dmGraphics::MAX_BUFFER_TYPE_COUNT];
+        dmGraphics::TextureParams params[dmGraphics::MAX_BUFFER_TYPE_COUNT];
+        CheckRenderTargetParams(L, 1, i->m_RenderContext->m_GraphicsContext, &buffer_type_flags, creation_params, params);
+
+        dmGraphics::HRenderTarget render_target = AcquireTransientRenderTarget(i->m_RenderContext, buffer_type_flags, creation_params, params);
+
+        lua_pushlightuserdata(L, (void*)render_target);
+
+        assert(top + 1 == lua_gettop(L));
+        return 1;
+    }
+
     /*# deletes a render target
      *
      * Deletes a previously created render target.
@@ -1315,7 +1502,8 @@ namespace dmRender
      *
      * @name render.draw
      * @param predicate [type:predicate] predicate to draw for
-     * @param [constants] [type:constant_buffer] optional constants to use while rendering
+     * @param [constants] [type:constant_buffer|string] optional constants to use while rendering.
+     * While recording, a string names a constant buffer passed to `render.execute()`
      * @examples
      *
      * ```lua
@@ -1354,12 +1542,25 @@ namespace dmRender
         }
 
         HNamedConstantBuffer constant_buffer = 0;
-        if (lua_isuserdata(L, 2))
+        if (i->m_CommandList && lua_type(L, 2) == LUA_TSTRING)
+        {
+            RecordReference(L, i->m_CommandList, 1);
+            RecordCommandParam(i->m_CommandList, Command(COMMAND_TYPE_DRAW, (uintptr_t)predicate, 0), lua_tostring(L, 2));
+            return 0;
+        }
+        else if (lua_isuserdata(L, 2))
         {
             HNamedConstantBuffer* tmp = RenderScriptConstantBuffer_Check(L, 2);
             constant_buffer = *tmp;
         }
 
+        if (i->m_CommandList)
+        {
+            RecordReference(L, i->m_CommandList, 1);
+            if (constant_buffer)
+                RecordReference(L, i->m_CommandList, 2);
+        }
+
         if (InsertCommand(i, Command(COMMAND_TYPE_DRAW, (uintptr_t)predicate, (uintptr_t) constant_buffer)))
             return 0;
         else
@@ -1406,7 +1607,8 @@ namespace dmRender
      * Sets the view matrix to use when rendering.
      *
      * @name render.set_view
-     * @param matrix [type:matrix4] view matrix to set
+     * @param matrix [type:matrix4|string] view matrix to set.
+     * While recording, a string names a matrix passed to `render.execute()`
      * @examples
      *
      * How to set the view and projection matrices according to
@@ -1436,6 +1638,11 @@ namespace dmRender
     int RenderScript_SetView(lua_State* L)
     {
         RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        if (i->m_CommandList && lua_type(L, 1) == LUA_TSTRING)
+        {
+            RecordCommandParam(i->m_CommandList, Command(COMMAND_TYPE_SET_VIEW, 0), lua_tostring(L, 1));
+            return 0;
+        }
         Vectormath::Aos::Matrix4 view = *dmScript::CheckMatrix4(L, 1);
 
         Vectormath::Aos::Matrix4* matrix = new Vectormath::Aos::Matrix4;
@@ -1450,7 +1657,8 @@ namespace dmRender
      * Sets the projection matrix to use when rendering.
      *
      * @name render.set_projection
-     * @param matrix [type:matrix4] projection matrix
+     * @param matrix [type:matrix4|string] projection matrix.
+     * While recording, a string names a matrix passed to `render.execute()`
      * @examples
      *
      * How to set the projection to orthographic with world origo at lower left,
@@ -1463,6 +1671,11 @@ namespace dmRender
     int RenderScript_SetProjection(lua_State* L)
     {
         RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        if (i->m_CommandList && lua_type(L, 1) == LUA_TSTRING)
+        {
+            RecordCommandParam(i->m_CommandList, Command(COMMAND_TYPE_SET_PROJECTION, 0), lua_tostring(L, 1));
+            return 0;
+        }
         Vectormath::Aos::Matrix4 projection = *dmScript::CheckMatrix4(L, 1);
         Vectormath::Aos::Matrix4* matrix = new Vectormath::Aos::Matrix4;
         *matrix = projection;
@@ -1472,6 +1685,92 @@ namespace dmRender
             return luaL_error(L, "Command buffer is full (%d).", i->m_CommandBuffer.Capacity());
     }
 
+    /*# sets the frustum to cull against
+     * Sets the frustum that the following draw calls cull their render objects against.
+     * Objects whose bounds are completely outside of the frustum are skipped before they are
+     * sorted and batched. Only components that can provide their bounds are culled (currently sprites).
+     * Culling is disabled by default.
+     *
+     * @name render.set_frustum
+     * @param frustum [type:matrix4|nil|string] view projection matrix of the frustum, or nil to disable culling.
+     * While recording, a string names a matrix passed to `render.execute()`
+     * @examples
+     *
+     * Cull against the current camera:
+     *
+     * ```lua
+     * render.set_view(self.view)
+     * render.set_projection(self.projection)
+     * render.set_frustum(self.projection * self.view)
+     * render.draw(self.tile_pred)
+     * ```
+     */
+    int RenderScript_SetFrustum(lua_State* L)
+    {
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        if (i->m_CommandList && lua_type(L, 1) == LUA_TSTRING)
+        {
+            RecordCommandParam(i->m_CommandList, Command(COMMAND_TYPE_SET_FRUSTUM, 0), lua_tostring(L, 1));
+            return 0;
+        }
+        Vectormath::Aos::Matrix4* matrix = 0;
+        if (!lua_isnoneornil(L, 1))
+        {
+            matrix = new Vectormath::Aos::Matrix4;
+            *matrix = *dmScript::CheckMatrix4(L, 1);
+        }
+        if (InsertCommand(i, Command(COMMAND_TYPE_SET_FRUSTUM, (uintptr_t)matrix)))
+            return 0;
+        else
+        {
+            delete matrix;
+            return luaL_error(L, "Command buffer is full (%d).", i->m_CommandBuffer.Capacity());
+        }
+    }
+
+    /*# sets the render layers drawn by the following draw calls
+     * Objects are put on one of 32 render layers, numbered 0 to 31, with the `layer` property of their
+     * component. Layer 0 is the default. The following draw calls only draw objects on the layers whose
+     * bits are set in the mask, which is tested before the objects are sorted and batched.
+     * All layers are drawn by default.
+     *
+     * A camera sets the mask from its `layer_mask` property when it has focus. A render script that draws
+     * several cameras sets the mask of each camera before drawing its view.
+     *
+     * @name render.set_layer_mask
+     * @param mask [type:number] one bit per layer, or nil to draw all layers
+     * @examples
+     *
+     * Draw the world without the layer of the minimap markers, then the minimap with only the markers:
+     *
+     * ```lua
+     * local WORLD = 1 -- bit 0
+     * local MINIMAP = 2 -- bit 1
+     *
+     * render.set_layer_mask(WORLD)
+     * render.set_frustum(self.projection * self.view)
+     * render.draw(self.tile_pred)
+     *
+     * render.set_layer_mask(MINIMAP)
+     * render.set_frustum(self.minimap_projection * self.minimap_view)
+     * render.draw(self.tile_pred)
+     * render.set_layer_mask(nil)
+     * ```
+     */
+    int RenderScript_SetLayerMask(lua_State* L)
+    {
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        uint32_t mask = 0xffffffff;
+        if (!lua_isnoneornil(L, 1))
+        {
+            mask = (uint32_t) (int64_t) luaL_checknumber(L, 1);
+        }
+        if (InsertCommand(i, Command(COMMAND_TYPE_SET_LAYER_MASK, (uintptr_t)mask)))
+            return 0;
+        else
+            return luaL_error(L, "Command buffer is full (%d).", i->m_CommandBuffer.Capacity());
+    }
+
     /*#
      * @name render.BLEND_ZERO
      * @variable
@@ -2220,6 +2519,121 @@ namespace dmRender
         return 1;
     }
 
+    static void PushFrameStats(lua_State* L, const dmGraphics::FrameStats& stats)
+    {
+#define SET_STAT(name, member)\
+        lua_pushnumber(L, (lua_Number) stats.member); \
+        lua_setfield(L, -2, name);
+
+        SET_STAT("draw_calls", m_DrawCalls);
+        SET_STAT("primitives", m_Primitives);
+        SET_STAT("state_changes", m_StateChanges);
+        SET_STAT("render_target_changes", m_RenderTargetChanges);
+        SET_STAT("buffer_upload_bytes", m_BufferUploadBytes);
+        SET_STAT("texture_upload_bytes", m_TextureUploadBytes);
+
+#undef SET_STAT
+    }
+
+    /*# gets the graphics statistics of the last frame
+     *
+     * Returns the counters of the last rendered frame, both in total and per render pass.
+     * A render pass is all the `render.draw()` calls with the same predicate tags to the
+     * same render target.
+     *
+     * The engine can also count the frames over a draw call and an upload budget, set with
+     * "graphics.draw_call_budget" and "graphics.upload_budget" (KB) in the "game.project" settings.
+     *
+     * @name render.get_stats
+     * @return stats [type:table] table with the following fields:
+     *
+     * `draw_calls`
+     * : [type:number] number of draw calls
+     *
+     * `primitives`
+     * : [type:number] number of triangles, or lines, drawn
+     *
+     * `state_changes`
+     * : [type:number] number of program, texture and render state changes
+     *
+     * `render_target_changes`
+     * : [type:number] number of render target changes
+     *
+     * `buffer_upload_bytes`
+     * : [type:number] bytes of vertex and index data uploaded
+     *
+     * `texture_upload_bytes`
+     * : [type:number] bytes of texture data uploaded
+     *
+     * `texture_memory`
+     * : [type:number] bytes of texture and render target memory in use
+     *
+     * `frames_over_budget`
+     * : [type:number] number of frames that exceeded the budgets, since the engine started
+     *
+     * `passes`
+     * : [type:table] list of render passes, in drawing order. Each pass has the counters above,
+     *   except `texture_memory` and `frames_over_budget`, as well as `tags` [type:table], the hashed
+     *   predicate tags, and `render_target` [type:render_target], or `nil` for the default framebuffer.
+     *
+     * @examples
+     *
+     * Fail an automated performance test when the frame draws too much
+     *
+     * ```lua
+     * local stats = render.get_stats()
+     * if stats.draw_calls > 200 then
+     *     print("too many draw calls", stats.draw_calls)
+     * end
+     * for _, pass in ipairs(stats.passes) do
+     *     print(pass.tags[1], pass.draw_calls, pass.primitives)
+     * end
+     * ```
+     */
+    int RenderScript_GetStats(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 1);
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+
+        dmGraphics::FrameStats stats;
+        uint32_t frames_over_budget = 0;
+        dmGraphics::GetFrameStats(i->m_RenderContext->m_GraphicsContext, &stats, &frames_over_budget);
+
+        lua_newtable(L);
+        PushFrameStats(L, stats);
+        lua_pushnumber(L, (lua_Number) stats.m_TextureMemory);
+        lua_setfield(L, -2, "texture_memory");
+        lua_pushnumber(L, (lua_Number) frames_over_budget);
+        lua_setfield(L, -2, "frames_over_budget");
+
+        uint32_t pass_count = 0;
+        const RenderPassStats* passes = GetRenderPassStats(i->m_RenderContext, &pass_count);
+        lua_createtable(L, pass_count, 0);
+        for (uint32_t p = 0; p < pass_count; ++p)
+        {
+            const RenderPassStats& pass = passes[p];
+            lua_newtable(L);
+            PushFrameStats(L, pass.m_Stats);
+
+            lua_createtable(L, pass.m_Predicate.m_TagCount, 0);
+            for (uint32_t t = 0; t < pass.m_Predicate.m_TagCount; ++t)
+            {
+                dmScript::PushHash(L, pass.m_Predicate.m_Tags[t]);
+                lua_rawseti(L, -2, t + 1);
+            }
+            lua_setfield(L, -2, "tags");
+
+            if (pass.m_RenderTarget)
+            {
+                lua_pushlightuserdata(L, (void*)pass.m_RenderTarget);
+                lua_setfield(L, -2, "render_target");
+            }
+            lua_rawseti(L, -2, p + 1);
+        }
+        lua_setfield(L, -2, "passes");
+        return 1;
+    }
+
     /*# creates a new render predicate
      *
      * This function returns a new render predicate for objects with materials matching
@@ -2355,12 +2769,175 @@ namespace dmRender
             return luaL_error(L, "Command buffer is full (%d).", i->m_CommandBuffer.Capacity());
     }
 
+    /*# starts recording render commands
+     * Starts recording render commands into a command list instead of issuing them.
+     * The recording is ended with `render.end_record()`, which returns the command list.
+     * A command list is replayed with `render.execute()` without calling into Lua for
+     * each of its commands.
+     *
+     * While recording, `render.set_view()`, `render.set_projection()` and `render.set_frustum()`
+     * accept the name of a matrix, and `render.draw()` the name of a constant buffer,
+     * that is bound when the command list is executed.
+     *
+     * @name render.begin_record
+     * @examples
+     *
+     * Record the drawing of the world once and replay it every frame:
+     *
+     * ```lua
+     * function init(self)
+     *     self.tile_pred = render.predicate({"tile"})
+     *     render.begin_record()
+     *     render.set_view("view")
+     *     render.set_projection("projection")
+     *     render.enable_state(render.STATE_BLEND)
+     *     render.draw(self.tile_pred)
+     *     render.disable_state(render.STATE_BLEND)
+     *     self.draw_world = render.end_record()
+     * end
+     *
+     * function update(self)
+     *     render.execute(self.draw_world, { view = self.view, projection = self.projection })
+     * end
+     * ```
+     */
+    int RenderScript_BeginRecord(lua_State* L)
+    {
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        if (i->m_CommandList)
+            return luaL_error(L, "render.begin_record() called while already recording.");
+        i->m_CommandList = new RenderCommandList;
+        return 0;
+    }
+
+    /*# stops recording render commands
+     * Stops recording render commands and returns the recorded command list.
+     *
+     * @name render.end_record
+     * @return list [type:command_list] the recorded command list
+     */
+    int RenderScript_EndRecord(lua_State* L)
+    {
+        int top = lua_gettop(L);
+        (void) top;
+
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        RenderCommandList* list = i->m_CommandList;
+        if (!list)
+            return luaL_error(L, "render.end_record() called without render.begin_record().");
+        i->m_CommandList = 0;
+
+        RenderCommandList** p_list = (RenderCommandList**) lua_newuserdata(L, sizeof(RenderCommandList*));
+        *p_list = list;
+
+        luaL_getmetatable(L, RENDER_SCRIPT_COMMANDLIST);
+        lua_setmetatable(L, -2);
+
+        assert(top + 1 == lua_gettop(L));
+        return 1;
+    }
+
+    static void PushCommandParam(lua_State* L, int params_index, const char* name)
+    {
+        if (lua_isnoneornil(L, params_index))
+        {
+            luaL_error(L, "Command list parameter '%s' not provided.", name);
+        }
+        lua_getfield(L, params_index, name);
+    }
+
+    /*# executes a command list
+     * Issues the render commands of a command list recorded with `render.begin_record()`
+     * and `render.end_record()`. Parameters named while recording are looked up in the
+     * `params` table.
+     *
+     * @name render.execute
+     * @param list [type:command_list] command list to execute
+     * @param [params] [type:table] table of matrices and constant buffers, keyed by the names used while recording
+     * @examples
+     *
+     * ```lua
+     * local constants = render.constant_buffer()
+     * constants.tint = vmath.vector4(1, 0, 0, 1)
+     * render.execute(self.draw_world, { view = self.view, projection = self.projection, tint = constants })
+     * ```
+     */
+    int RenderScript_Execute(lua_State* L)
+    {
+        int top = lua_gettop(L);
+        (void) top;
+
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        RenderCommandList* list = *RenderScriptCommandList_Check(L, 1);
+        if (!lua_isnoneornil(L, 2))
+            luaL_checktype(L, 2, LUA_TTABLE);
+        if (i->m_CommandList)
+            return luaL_error(L, "Command lists can't be executed while recording.");
+        if (i->m_CommandBuffer.Remaining() < list->m_Commands.Size())
+            return luaL_error(L, "Command buffer is full (%d).", i->m_CommandBuffer.Capacity());
+
+        uint32_t param_index = 0;
+        for (uint32_t c = 0; c < list->m_Commands.Size(); ++c)
+        {
+            Command command = list->m_Commands[c];
+            const char* param_name = 0;
+            if (param_index < list->m_Params.Size() && list->m_Params[param_index].m_CommandIndex == c)
+            {
+                param_name = list->m_Params[param_index++].m_Name;
+            }
+
+            switch (command.m_Type)
+            {
+                case COMMAND_TYPE_SET_VIEW:
+                case COMMAND_TYPE_SET_PROJECTION:
+                case COMMAND_TYPE_SET_FRUSTUM:
+                {
+                    // The commands are parsed like any other, which deletes their matrices
+                    Vectormath::Aos::Matrix4* matrix = 0;
+                    if (param_name)
+                    {
+                        PushCommandParam(L, 2, param_name);
+                        if (command.m_Type != COMMAND_TYPE_SET_FRUSTUM || !lua_isnil(L, -1))
+                        {
+                            Vectormath::Aos::Matrix4* value = dmScript::CheckMatrix4(L, -1);
+                            matrix = new Vectormath::Aos::Matrix4(*value);
+                        }
+                        lua_pop(L, 1);
+                    }
+                    else if (command.m_Operands[0] != INVALID_MATRIX_INDEX)
+                    {
+                        matrix = new Vectormath::Aos::Matrix4(list->m_Matrices[command.m_Operands[0]]);
+                    }
+                    command.m_Operands[0] = (uintptr_t) matrix;
+                    break;
+                }
+                case COMMAND_TYPE_DRAW:
+                {
+                    if (param_name)
+                    {
+                        PushCommandParam(L, 2, param_name);
+                        command.m_Operands[1] = lua_isnil(L, -1) ? 0 : (uintptr_t) *RenderScriptConstantBuffer_Check(L, -1);
+                        lua_pop(L, 1);
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            i->m_CommandBuffer.Push(command);
+        }
+
+        assert(top == lua_gettop(L));
+        return 0;
+    }
+
     static const luaL_reg Render_methods[] =
     {
         {"enable_state",                    RenderScript_EnableState},
         {"disable_state",                   RenderScript_DisableState},
         {"render_target",                   RenderScript_RenderTarget},
         {"delete_render_target",            RenderScript_DeleteRenderTarget},
+        {"acquire_render_target",           RenderScript_AcquireRenderTarget},
         {"set_render_target",               RenderScript_SetRenderTarget},
         {"enable_render_target",            RenderScript_EnableRenderTarget},
         {"disable_render_target",           RenderScript_DisableRenderTarget},
@@ -2373,6 +2950,8 @@ namespace dmRender
         {"set_viewport",                    RenderScript_SetViewport},
         {"set_view",                        RenderScript_SetView},
         {"set_projection",                  RenderScript_SetProjection},
+        {"set_frustum",                     RenderScript_SetFrustum},
+        {"set_layer_mask",                  RenderScript_SetLayerMask},
         {"set_blend_func",                  RenderScript_SetBlendFunc},
         {"set_color_mask",                  RenderScript_SetColorMask},
         {"set_depth_mask",                  RenderScript_SetDepthMask},
@@ -2389,10 +2968,14 @@ namespace dmRender
         {"get_height",                      RenderScript_GetHeight},
         {"get_window_width",                RenderScript_GetWindowWidth},
         {"get_window_height",               RenderScript_GetWindowHeight},
+        {"get_stats",                       RenderScript_GetStats},
         {"predicate",                       RenderScript_Predicate},
         {"constant_buffer",                 RenderScript_ConstantBuffer},
         {"enable_material",                 RenderScript_EnableMaterial},
         {"disable_material",                RenderScript_DisableMaterial},
+        {"begin_record",                    RenderScript_BeginRecord},
+        {"end_record",                      RenderScript_EndRecord},
+        {"execute",                         RenderScript_Execute},
         {0, 0}
     };
 
@@ -2414,6 +2997,8 @@ namespace dmRender
 
         RENDER_SCRIPT_PREDICATE_TYPE_HASH = dmScript::RegisterUserType(L, RENDER_SCRIPT_PREDICATE, RenderScriptPredicate_methods, RenderScriptPredicate_meta);
 
+        RENDER_SCRIPT_COMMANDLIST_TYPE_HASH = dmScript::RegisterUserType(L, RENDER_SCRIPT_COMMANDLIST, RenderScriptCommandList_methods, RenderScriptCommandList_meta);
+
         luaL_register(L, RENDER_SCRIPT_LIB_NAME, Render_methods);
 
 #define REGISTER_STATE_CONSTANT(name)\
@@ -2835,6 +3420,13 @@ bail:
                 }
             }
 
+            if (script_instance->m_CommandList)
+            {
+                dmLogError("render.begin_record() was called without a matching render.end_record().");
+                DeleteCommandList(L, script_instance->m_CommandList);
+                script_instance->m_CommandList = 0;
+            }
+
             lua_pushnil(L);
             dmScript::SetInstance(L);
 
@@ -2928,6 +3520,9 @@ bail:
 
         if (instance->m_CommandBuffer.Size() > 0)
             ParseCommands(instance->m_RenderContext, &instance->m_CommandBuffer.Front(), instance->m_CommandBuffer.Size());
+
+        // The render commands of the frame have been executed
+        ReleaseTransientRenderTargets(instance->m_RenderContext);
         return result;
     }
 
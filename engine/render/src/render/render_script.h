@@ -42,10 +42,29 @@ namespace dmRender
         int             m_InstanceReference;
     };
 
+    // Render command whose operand is looked up by name when the command list is executed
+    struct RenderCommandParam
+    {
+        const char*                 m_Name;
+        uint32_t                    m_CommandIndex;
+    };
+
+    // Commands recorded between render.begin_record() and render.end_record().
+    // Matrix operands index m_Matrices instead of pointing to heap allocated matrices.
+    struct RenderCommandList
+    {
+        dmArray<Command>                    m_Commands;
+        dmArray<Vectormath::Aos::Matrix4>   m_Matrices;
+        dmArray<RenderCommandParam>         m_Params;
+        // Lua references keeping the recorded predicates and constant buffers alive
+        dmArray<int>                        m_References;
+    };
+
     static const uint32_t MAX_PREDICATE_COUNT = 64;
     struct RenderScriptInstance
     {
         dmArray<Command>            m_CommandBuffer;
+        RenderCommandList*          m_CommandList;
         dmHashTable64<HMaterial>    m_Materials;
         Predicate*                  m_Predicates[MAX_PREDICATE_COUNT];
         RenderContext*              m_RenderContext;
@@ -0,0 +1,170 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <string.h>
+#include <dmsdk/vectormath/cpp/vectormath_aos.h>
+
+#include <dlib/benchmark.h>
+#include <dlib/dstrings.h>
+
+#include <script/script.h>
+
+#include "render/render.h"
+#include "render/font_renderer.h"
+
+// Benchmarks of the render hot paths. Run with --benchmark_out=<path> to get the results as JSON.
+
+using namespace Vectormath::Aos;
+
+struct RenderListContext
+{
+    dmRender::HRenderContext m_Context;
+    uint32_t                 m_Count;
+    uint32_t                 m_Rendered;
+};
+
+static void BenchDispatch(dmRender::RenderListDispatchParams const & params)
+{
+    if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_BATCH)
+    {
+        RenderListContext* ctx = (RenderListContext*)params.m_UserData;
+        ctx->m_Rendered += params.m_End - params.m_Begin;
+    }
+}
+
+// A frame worth of render list: submit the entries, then sort and dispatch them
+static void BenchRenderList(void* _ctx, uint32_t iterations)
+{
+    RenderListContext* ctx = (RenderListContext*)_ctx;
+    dmRender::HRenderContext context = ctx->m_Context;
+    const dmRender::RenderOrder majors[3] = {
+        dmRender::RENDER_ORDER_BEFORE_WORLD,
+        dmRender::RENDER_ORDER_WORLD,
+        dmRender::RENDER_ORDER_AFTER_WORLD
+    };
+
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        dmRender::RenderListBegin(context);
+        uint8_t dispatch = dmRender::RenderListMakeDispatch(context, BenchDispatch, ctx);
+
+        dmRender::RenderListEntry* entries = dmRender::RenderListAlloc(context, ctx->m_Count);
+        uint32_t seed = 12345;
+        for (uint32_t j = 0; j < ctx->m_Count; ++j)
+        {
+            seed = seed * 1664525 + 1013904223;
+            dmRender::RenderListEntry& entry = entries[j];
+            entry.m_WorldPosition = Point3((float)(seed & 1023), (float)((seed >> 10) & 1023), (float)((seed >> 20) & 255));
+            entry.m_MajorOrder = j % 16 == 0 ? majors[seed % 3] : dmRender::RENDER_ORDER_WORLD;
+            entry.m_MinorOrder = 0;
+            entry.m_TagListKey = 0;
+            entry.m_Order = seed >> 8;
+            entry.m_BatchKey = seed & 31;
+            entry.m_Dispatch = dispatch;
+            entry.m_UserData = j;
+        }
+        dmRender::RenderListSubmit(context, entries, entries + ctx->m_Count);
+        dmRender::RenderListEnd(context);
+
+        dmRender::DrawRenderList(context, 0, 0);
+    }
+    dmBenchmark::DoNotOptimize(&ctx->m_Rendered);
+}
+
+struct TextContext
+{
+    dmRender::HFontMap  m_FontMap;
+    const char*         m_Text;
+    float               m_Width;
+};
+
+static void BenchTextMetrics(void* _ctx, uint32_t iterations)
+{
+    TextContext* ctx = (TextContext*)_ctx;
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        dmRender::TextMetrics metrics;
+        dmRender::GetTextMetrics(ctx->m_FontMap, ctx->m_Text, ctx->m_Width, ctx->m_Width > 0.0f, 1.0f, 0.0f, &metrics);
+        sum += metrics.m_Height;
+    }
+    dmBenchmark::DoNotOptimize(&sum);
+}
+
+static dmRender::HFontMap NewFontMap(dmGraphics::HContext graphics_context)
+{
+    dmRender::FontMapParams font_map_params;
+    font_map_params.m_CacheWidth = 128;
+    font_map_params.m_CacheHeight = 128;
+    font_map_params.m_CacheCellWidth = 8;
+    font_map_params.m_CacheCellHeight = 8;
+    font_map_params.m_MaxAscent = 2;
+    font_map_params.m_MaxDescent = 1;
+    font_map_params.m_Glyphs.SetCapacity(128);
+    font_map_params.m_Glyphs.SetSize(128);
+    memset((void*)&font_map_params.m_Glyphs[0], 0, sizeof(dmRender::Glyph)*128);
+    for (uint32_t i = 0; i < 128; ++i)
+    {
+        font_map_params.m_Glyphs[i].m_Character = i;
+        font_map_params.m_Glyphs[i].m_Width = 1;
+        font_map_params.m_Glyphs[i].m_LeftBearing = 1;
+        font_map_params.m_Glyphs[i].m_Advance = 2;
+        font_map_params.m_Glyphs[i].m_Ascent = 2;
+        font_map_params.m_Glyphs[i].m_Descent = 1;
+    }
+    return dmRender::NewFontMap(graphics_context, font_map_params);
+}
+
+int main(int argc, char **argv)
+{
+    dmBenchmark::Init(argc, argv);
+
+    dmGraphics::Initialize();
+    dmGraphics::HContext graphics_context = dmGraphics::NewContext(dmGraphics::ContextParams());
+    dmScript::HContext script_context = dmScript::NewContext(0, 0, true);
+    dmRender::RenderContextParams params;
+    params.m_MaxRenderTargets = 1;
+    params.m_MaxInstances = 2;
+    params.m_ScriptContext = script_context;
+    params.m_MaxDebugVertexCount = 256;
+    params.m_MaxCharacters = 256;
+    dmRender::HRenderContext context = dmRender::NewRenderContext(graphics_context, params);
+
+    const uint32_t counts[] = {1000, 10000, 50000};
+    for (uint32_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+    {
+        RenderListContext ctx;
+        ctx.m_Context = context;
+        ctx.m_Count = counts[i];
+        ctx.m_Rendered = 0;
+
+        char name[64];
+        dmSnPrintf(name, sizeof(name), "RenderListSortDraw/%u", counts[i]);
+        dmBenchmark::Run(name, BenchRenderList, &ctx, counts[i]);
+    }
+
+    TextContext text;
+    text.m_FontMap = NewFontMap(graphics_context);
+    text.m_Text = "The quick brown fox jumps over the lazy dog, and then it does it again and again until the line wraps.";
+    text.m_Width = 0.0f;
+    dmBenchmark::Run("TextMetrics/SingleLine", BenchTextMetrics, &text, 1);
+    text.m_Width = 40.0f;
+    dmBenchmark::Run("TextMetrics/LineBreak", BenchTextMetrics, &text, 1);
+
+    dmRender::DeleteFontMap(text.m_FontMap);
+    dmRender::DeleteRenderContext(context, 0);
+    dmGraphics::DeleteContext(graphics_context);
+    dmScript::DeleteContext(script_context);
+
+    return dmBenchmark::Finalize();
+}
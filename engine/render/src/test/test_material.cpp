@@ -177,6 +177,72 @@ TEST(dmMaterialTest, TestMaterialConstantsOverride)
     dmScript::DeleteContext(params.m_ScriptContext);
 }
 
+TEST(dmMaterialTest, TestMaterialConstantsUploadedOnChange)
+{
+    dmGraphics::Initialize();
+    dmGraphics::HContext context = dmGraphics::NewContext(dmGraphics::ContextParams());
+    dmRender::RenderContextParams params;
+    params.m_ScriptContext = dmScript::NewContext(0, 0, true);
+    params.m_MaxCharacters = 256;
+    dmRender::HRenderContext render_context = dmRender::NewRenderContext(context, params);
+
+    dmGraphics::ShaderDesc::Shader vp_shader = MakeDDFShader("uniform vec4 tint;\nuniform mat4 view_proj;\n", 43);
+    dmGraphics::HVertexProgram vp = dmGraphics::NewVertexProgram(context, &vp_shader);
+    dmGraphics::ShaderDesc::Shader fp_shader = MakeDDFShader("foo", 3);
+    dmGraphics::HFragmentProgram fp = dmGraphics::NewFragmentProgram(context, &fp_shader);
+    dmRender::HMaterial material = dmRender::NewMaterial(render_context, vp, fp);
+    dmRender::SetMaterialProgramConstantType(material, dmHashString64("view_proj"), dmRenderDDF::MaterialDesc::CONSTANT_TYPE_VIEWPROJ);
+    dmRender::SetMaterialProgramConstant(material, dmHashString64("tint"), Vector4(1.0f, 2.0f, 3.0f, 4.0f));
+
+    dmGraphics::HProgram program = dmRender::GetMaterialProgram(material);
+    dmGraphics::EnableProgram(context, program);
+    int32_t tint_loc = dmGraphics::GetUniformLocation(program, "tint");
+    int32_t view_proj_loc = dmGraphics::GetUniformLocation(program, "view_proj");
+
+    dmRender::RenderObject ro;
+    ro.m_Material = material;
+    dmRender::ApplyMaterialConstants(render_context, material, &ro);
+    ASSERT_EQ(1.0f, dmGraphics::GetConstantV4Ptr(context, tint_loc).getX());
+    ASSERT_EQ(1.0f, dmGraphics::GetConstantV4Ptr(context, view_proj_loc).getX());
+
+    // The program keeps the values, unchanged constants are not uploaded again
+    Vector4 zero(0.0f);
+    dmGraphics::SetConstantV4(context, &zero, tint_loc);
+    dmGraphics::SetConstantV4(context, &zero, view_proj_loc);
+    dmRender::ApplyMaterialConstants(render_context, material, &ro);
+    ASSERT_EQ(0.0f, dmGraphics::GetConstantV4Ptr(context, tint_loc).getX());
+    ASSERT_EQ(0.0f, dmGraphics::GetConstantV4Ptr(context, view_proj_loc).getX());
+
+    // Changing a material constant uploads the user constants
+    dmRender::SetMaterialProgramConstant(material, dmHashString64("tint"), Vector4(5.0f, 6.0f, 7.0f, 8.0f));
+    dmRender::ApplyMaterialConstants(render_context, material, &ro);
+    ASSERT_EQ(5.0f, dmGraphics::GetConstantV4Ptr(context, tint_loc).getX());
+    ASSERT_EQ(0.0f, dmGraphics::GetConstantV4Ptr(context, view_proj_loc).getX());
+
+    // Changing the view uploads the view projection
+    Matrix4 view = Matrix4::identity();
+    view.setElem(0, 0, 2.0f);
+    dmRender::SetViewMatrix(render_context, view);
+    dmRender::ApplyMaterialConstants(render_context, material, &ro);
+    ASSERT_EQ(2.0f, dmGraphics::GetConstantV4Ptr(context, view_proj_loc).getX());
+
+    // Render object overrides replace the material values in the program
+    dmRender::EnableRenderObjectConstant(&ro, dmHashString64("tint"), Vector4(9.0f, 0.0f, 0.0f, 0.0f));
+    dmRender::ApplyRenderObjectConstants(render_context, 0, &ro);
+    ASSERT_EQ(9.0f, dmGraphics::GetConstantV4Ptr(context, tint_loc).getX());
+    dmRender::DisableRenderObjectConstant(&ro, dmHashString64("tint"));
+    dmRender::ApplyMaterialConstants(render_context, material, &ro);
+    ASSERT_EQ(5.0f, dmGraphics::GetConstantV4Ptr(context, tint_loc).getX());
+
+    dmGraphics::DisableProgram(context);
+    dmGraphics::DeleteVertexProgram(vp);
+    dmGraphics::DeleteFragmentProgram(fp);
+    dmRender::DeleteMaterial(render_context, material);
+    dmRender::DeleteRenderContext(render_context, 0);
+    dmGraphics::DeleteContext(context);
+    dmScript::DeleteContext(params.m_ScriptContext);
+}
+
 TEST(dmMaterialTest, MatchMaterialTags)
 {
     dmhash_t material_tags[] = { 1, 2, 3, 4, 5 };
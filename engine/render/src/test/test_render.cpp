@@ -11,6 +11,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <stdlib.h>
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
@@ -138,6 +139,44 @@ TEST_F(dmRenderTest, TestRenderTarget)
     dmGraphics::DeleteRenderTarget(target);
 }
 
+TEST_F(dmRenderTest, TestTransientRenderTarget)
+{
+    dmGraphics::TextureCreationParams creation_params[dmGraphics::MAX_BUFFER_TYPE_COUNT];
+    dmGraphics::TextureParams params[dmGraphics::MAX_BUFFER_TYPE_COUNT];
+
+    creation_params[0].m_Width = WIDTH;
+    creation_params[0].m_Height = HEIGHT;
+    creation_params[1].m_Width = WIDTH;
+    creation_params[1].m_Height = HEIGHT;
+
+    params[0].m_Width = WIDTH;
+    params[0].m_Height = HEIGHT;
+    params[0].m_Format = dmGraphics::TEXTURE_FORMAT_LUMINANCE;
+    params[1].m_Width = WIDTH;
+    params[1].m_Height = HEIGHT;
+    params[1].m_Format = dmGraphics::TEXTURE_FORMAT_DEPTH;
+    uint32_t flags = dmGraphics::BUFFER_TYPE_COLOR_BIT | dmGraphics::BUFFER_TYPE_DEPTH_BIT;
+
+    // Targets acquired within the same frame are never shared
+    dmGraphics::HRenderTarget target_a = dmRender::AcquireTransientRenderTarget(m_Context, flags, creation_params, params);
+    dmGraphics::HRenderTarget target_b = dmRender::AcquireTransientRenderTarget(m_Context, flags, creation_params, params);
+    ASSERT_NE((void*)0x0, target_a);
+    ASSERT_NE(target_a, target_b);
+    ASSERT_EQ(2U, m_Context->m_TransientRenderTargets.Size());
+
+    // Released targets are reused by the next frame
+    dmRender::ReleaseTransientRenderTargets(m_Context);
+    ASSERT_EQ(target_a, dmRender::AcquireTransientRenderTarget(m_Context, flags, creation_params, params));
+    ASSERT_EQ(2U, m_Context->m_TransientRenderTargets.Size());
+
+    // Targets that aren't acquired again are eventually deleted
+    for (uint32_t i = 0; i < 61; ++i)
+    {
+        dmRender::ReleaseTransientRenderTargets(m_Context);
+    }
+    ASSERT_EQ(0U, m_Context->m_TransientRenderTargets.Size());
+}
+
 TEST_F(dmRenderTest, TestGraphicsContext)
 {
     ASSERT_NE((void*)0x0, dmRender::GetGraphicsContext(m_Context));
@@ -184,6 +223,13 @@ TEST_F(dmRenderTest, TestLine3d)
     Line3D(m_Context, Point3(10.0f, 20.0f, 30.0f), Point3(10.0f, 20.0f, 30.0f), Vector4(0.1f, 0.2f, 0.3f, 0.4f), Vector4(0.1f, 0.2f, 0.3f, 0.4f));
 }
 
+TEST_F(dmRenderTest, TestLines3d)
+{
+    Point3 points[] = { Point3(10.0f, 20.0f, 30.0f), Point3(40.0f, 50.0f, 60.0f), Point3(70.0f, 80.0f, 90.0f) };
+    Lines3D(m_Context, points, 3, Vector4(0.1f, 0.2f, 0.3f, 0.4f));
+    Triangles3D(m_Context, points, 3, Vector4(0.1f, 0.2f, 0.3f, 0.4f));
+}
+
 struct TestDrawDispatchCtx
 {
     int m_BeginCalls;
@@ -262,6 +308,91 @@ static void TestDrawDispatch(dmRender::RenderListDispatchParams const & params)
     }
 }
 
+struct SegmentFillCtx
+{
+    dmRender::HRenderContext    m_RenderContext;
+    uint8_t                     m_Dispatch;
+};
+
+static void SegmentFill(void* _ctx, uint32_t start, uint32_t end)
+{
+    SegmentFillCtx* ctx = (SegmentFillCtx*) _ctx;
+    dmRender::RenderListEntry* out = dmRender::RenderListSegmentAlloc(ctx->m_RenderContext, end - start);
+    for (uint32_t i = start; i != end; ++i)
+    {
+        dmRender::RenderListEntry& entry = out[i - start];
+        memset(&entry, 0, sizeof(entry));
+        entry.m_WorldPosition = Point3(0, 0, -(float) i);
+        entry.m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+        entry.m_Dispatch = ctx->m_Dispatch;
+        entry.m_UserData = i;
+    }
+    dmRender::RenderListSegmentSubmit(ctx->m_RenderContext, out, out + (end - start));
+}
+
+static void SegmentDrawDispatch(const dmRender::RenderListDispatchParams& params)
+{
+    if (params.m_Operation != dmRender::RENDER_LIST_OPERATION_BATCH)
+        return;
+    uint32_t* rendered = (uint32_t*) params.m_UserData;
+    for (uint32_t* i = params.m_Begin; i != params.m_End; ++i)
+    {
+        rendered[params.m_Buf[*i].m_UserData]++;
+    }
+}
+
+TEST_F(dmRenderTest, TestRenderListSegments)
+{
+    dmJob::NewContextParams job_params;
+    job_params.m_WorkerCount = 3;
+    dmJob::HContext job_context = dmJob::NewContext(job_params);
+
+    // Only one render context can exist at a time (the render socket)
+    dmRender::DeleteRenderContext(m_Context, 0);
+
+    dmRender::RenderContextParams params;
+    params.m_MaxRenderTargets = 1;
+    params.m_MaxInstances = 2;
+    params.m_ScriptContext = m_ScriptContext;
+    params.m_MaxDebugVertexCount = 256;
+    params.m_MaxCharacters = 256;
+    params.m_JobContext = job_context;
+    dmRender::HRenderContext context = dmRender::NewRenderContext(m_GraphicsContext, params);
+    ASSERT_EQ(job_context, dmRender::GetJobContext(context));
+
+    Matrix4 proj = Matrix4::orthographic(0.0f, WIDTH, HEIGHT, 0.0f, 0.1f, 10000.0f);
+    dmRender::SetViewMatrix(context, Matrix4::identity());
+    dmRender::SetProjectionMatrix(context, proj);
+
+    const uint32_t n = 5000;
+    uint32_t* rendered = new uint32_t[n];
+    memset(rendered, 0, sizeof(uint32_t) * n);
+
+    dmRender::RenderListBegin(context);
+
+    SegmentFillCtx ctx;
+    ctx.m_RenderContext = context;
+    ctx.m_Dispatch = dmRender::RenderListMakeDispatch(context, SegmentDrawDispatch, rendered);
+    dmJob::HJob job = dmJob::ParallelFor(job_context, SegmentFill, &ctx, n, 64, dmJob::INVALID_JOB);
+    dmJob::Wait(job_context, job);
+
+    dmRender::RenderListEnd(context);
+    ASSERT_EQ(n, context->m_RenderListSortIndices.Size());
+
+    dmRender::DrawRenderList(context, 0, 0);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ(1U, rendered[i]);
+    }
+
+    delete [] rendered;
+    dmRender::DeleteRenderContext(context, 0);
+    dmJob::DeleteContext(job_context);
+
+    params.m_JobContext = 0;
+    m_Context = dmRender::NewRenderContext(m_GraphicsContext, params);
+}
+
 TEST_F(dmRenderTest, TestRenderListDraw)
 {
     TestDrawDispatchCtx ctx;
@@ -461,6 +592,309 @@ TEST_F(dmRenderTest, TestRenderListDebug)
     dmRender::DrawDebug3d(m_Context);
 }
 
+static void TestCullVisibility(const dmRender::RenderListVisibilityParams& params)
+{
+    for (uint32_t i = 0; i < params.m_NumEntries; ++i)
+    {
+        params.m_Bounds[i].m_Center = params.m_Entries[params.m_Indices[i]].m_WorldPosition;
+        params.m_Bounds[i].m_Extents = Vector3(10, 10, 0);
+    }
+}
+
+TEST_F(dmRenderTest, TestRenderListFrustumCulling)
+{
+    Matrix4 proj = Matrix4::orthographic(0.0f, WIDTH, 0.0f, HEIGHT, -1.0f, 1.0f);
+    dmRender::SetViewMatrix(m_Context, Matrix4::identity());
+    dmRender::SetProjectionMatrix(m_Context, proj);
+
+    const uint32_t n = 8;
+    // Entries spaced half a screen apart, only the first three (and the one just left of the screen) overlap it
+    const float xs[n] = { 0, WIDTH / 2, WIDTH, -5, -50, WIDTH + 50, WIDTH * 2, WIDTH * 3 };
+    const uint32_t expected[n] = { 1, 1, 1, 1, 0, 0, 0, 0 };
+
+    uint32_t culled_rendered[n];
+    uint32_t rendered[n];
+    memset(culled_rendered, 0, sizeof(culled_rendered));
+    memset(rendered, 0, sizeof(rendered));
+
+    dmRender::RenderListBegin(m_Context);
+    uint8_t culled_dispatch = dmRender::RenderListMakeDispatch(m_Context, SegmentDrawDispatch, TestCullVisibility, culled_rendered);
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(m_Context, SegmentDrawDispatch, rendered);
+
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(m_Context, n * 2);
+    for (uint32_t i = 0; i < n * 2; ++i)
+    {
+        dmRender::RenderListEntry& entry = out[i];
+        entry.m_WorldPosition = Point3(xs[i % n], HEIGHT / 2, 0);
+        entry.m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+        entry.m_MinorOrder = 0;
+        entry.m_TagListKey = 0;
+        entry.m_Order = 0;
+        entry.m_BatchKey = (uint32_t) i;
+        entry.m_Dispatch = i < n ? culled_dispatch : dispatch;
+        entry.m_UserData = i % n;
+    }
+    dmRender::RenderListSubmit(m_Context, out, out + n * 2);
+    dmRender::RenderListEnd(m_Context);
+
+    Matrix4 frustum = proj;
+    dmRender::SetFrustum(m_Context, &frustum);
+    dmRender::DrawRenderList(m_Context, 0, 0);
+
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ(expected[i], culled_rendered[i]);
+        // Dispatches without a visibility callback are never culled
+        ASSERT_EQ(1U, rendered[i]);
+    }
+
+    // Disabling the frustum draws everything again
+    dmRender::SetFrustum(m_Context, 0);
+    dmRender::DrawRenderList(m_Context, 0, 0);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ(expected[i] + 1, culled_rendered[i]);
+        ASSERT_EQ(2U, rendered[i]);
+    }
+}
+
+static uint32_t g_CullVisibilityCount = 0;
+
+static void TestCountCullVisibility(const dmRender::RenderListVisibilityParams& params)
+{
+    g_CullVisibilityCount += params.m_NumEntries;
+    TestCullVisibility(params);
+}
+
+TEST_F(dmRenderTest, TestRenderListFrustumCullingViews)
+{
+    Matrix4 proj = Matrix4::orthographic(0.0f, WIDTH, 0.0f, HEIGHT, -1.0f, 1.0f);
+    dmRender::SetViewMatrix(m_Context, Matrix4::identity());
+    dmRender::SetProjectionMatrix(m_Context, proj);
+
+    const uint32_t n = 2;
+    // One entry on the screen of each view
+    const float xs[n] = { WIDTH / 2, WIDTH * 3 + WIDTH / 2 };
+
+    uint32_t rendered[n];
+    memset(rendered, 0, sizeof(rendered));
+    g_CullVisibilityCount = 0;
+
+    dmRender::RenderListBegin(m_Context);
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(m_Context, SegmentDrawDispatch, TestCountCullVisibility, rendered);
+
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(m_Context, n);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        dmRender::RenderListEntry& entry = out[i];
+        entry.m_WorldPosition = Point3(xs[i], HEIGHT / 2, 0);
+        entry.m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+        entry.m_MinorOrder = 0;
+        entry.m_TagListKey = 0;
+        entry.m_Order = 0;
+        entry.m_BatchKey = (uint32_t) i;
+        entry.m_Dispatch = dispatch;
+        entry.m_UserData = i;
+    }
+    dmRender::RenderListSubmit(m_Context, out, out + n);
+    dmRender::RenderListEnd(m_Context);
+
+    Matrix4 frustums[n] = { proj, proj * Matrix4::translation(Vector3(-WIDTH * 3, 0, 0)) };
+    for (uint32_t pass = 0; pass < 4; ++pass)
+    {
+        dmRender::SetFrustum(m_Context, &frustums[pass % n]);
+        dmRender::DrawRenderList(m_Context, 0, 0);
+        ASSERT_EQ(pass / n + 1, rendered[pass % n]);
+        ASSERT_EQ((pass + 1) / n, rendered[(pass + 1) % n]);
+    }
+
+    // The bounds are gathered once per frame, and shared by the views
+    ASSERT_EQ(n, g_CullVisibilityCount);
+    dmRender::SetFrustum(m_Context, 0);
+}
+
+TEST_F(dmRenderTest, TestRenderListOcclusionCulling)
+{
+    Matrix4 proj = Matrix4::orthographic(0.0f, WIDTH, 0.0f, HEIGHT, -1.0f, 1.0f);
+    dmRender::SetViewMatrix(m_Context, Matrix4::identity());
+    dmRender::SetProjectionMatrix(m_Context, proj);
+
+    const uint32_t n = 3;
+    // Behind the occluder, beside it, and in front of it
+    const Point3 positions[n] = { Point3(WIDTH / 4, HEIGHT / 2, 0), Point3(WIDTH * 3 / 4, HEIGHT / 2, 0), Point3(WIDTH / 4, HEIGHT / 2, 0.8f) };
+    const uint32_t expected[n] = { 0, 1, 1 };
+
+    uint32_t rendered[n];
+    memset(rendered, 0, sizeof(rendered));
+
+    dmRender::RenderListBegin(m_Context);
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(m_Context, SegmentDrawDispatch, TestCullVisibility, rendered);
+
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(m_Context, n);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        dmRender::RenderListEntry& entry = out[i];
+        entry.m_WorldPosition = positions[i];
+        entry.m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+        entry.m_MinorOrder = 0;
+        entry.m_TagListKey = 0;
+        entry.m_Order = 0;
+        entry.m_BatchKey = (uint32_t) i;
+        entry.m_Dispatch = dispatch;
+        entry.m_UserData = i;
+    }
+    dmRender::RenderListSubmit(m_Context, out, out + n);
+
+    // A quad covering the left half of the screen, between the camera and the entries at z = 0
+    const float z = 0.5f;
+    const float quad[] = {
+        0, 0, z,  WIDTH / 2, 0, z,  WIDTH / 2, HEIGHT, z,
+        0, 0, z,  WIDTH / 2, HEIGHT, z,  0, HEIGHT, z,
+    };
+    dmRender::AddOccluder(m_Context, Matrix4::identity(), quad, 3, 6);
+    dmRender::RenderListEnd(m_Context);
+
+    Matrix4 frustum = proj;
+    dmRender::SetFrustum(m_Context, &frustum);
+    dmRender::DrawRenderList(m_Context, 0, 0);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ(expected[i], rendered[i]);
+    }
+
+    // The occluders are cleared with the render list
+    dmRender::RenderListBegin(m_Context);
+    dispatch = dmRender::RenderListMakeDispatch(m_Context, SegmentDrawDispatch, TestCullVisibility, rendered);
+    out = dmRender::RenderListAlloc(m_Context, n);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        dmRender::RenderListEntry& entry = out[i];
+        entry.m_WorldPosition = positions[i];
+        entry.m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+        entry.m_MinorOrder = 0;
+        entry.m_TagListKey = 0;
+        entry.m_Order = 0;
+        entry.m_BatchKey = (uint32_t) i;
+        entry.m_Dispatch = dispatch;
+        entry.m_UserData = i;
+    }
+    dmRender::RenderListSubmit(m_Context, out, out + n);
+    dmRender::RenderListEnd(m_Context);
+    dmRender::DrawRenderList(m_Context, 0, 0);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ(expected[i] + 1, rendered[i]);
+    }
+    dmRender::SetFrustum(m_Context, 0);
+}
+
+static uint32_t GetLightClusterLightCount(dmRender::HRenderContext context, uint32_t x, uint32_t y, uint32_t z)
+{
+    return context->m_LightClusterCounts[x + y * dmRender::LIGHT_CLUSTERS_X + z * dmRender::LIGHT_CLUSTERS_X * dmRender::LIGHT_CLUSTERS_Y];
+}
+
+TEST_F(dmRenderTest, TestLightClusters)
+{
+    dmRender::SetViewMatrix(m_Context, Matrix4::identity());
+    dmRender::SetProjectionMatrix(m_Context, Matrix4::perspective(M_PI / 2.0f, 2.0f, 1.0f, 100.0f));
+
+    dmRender::RenderListBegin(m_Context);
+
+    dmRender::Light light;
+    light.m_Direction = Vector3(0, 0, -1);
+    light.m_Color = Vector3(1, 1, 1);
+    light.m_ConeCos = -1.0f;
+
+    // In the center of the view, a short distance in front of the camera
+    light.m_Position = Point3(0, 0, -10);
+    light.m_Range = 0.5f;
+    dmRender::AddLight(m_Context, light);
+    // Behind the camera
+    light.m_Position = Point3(0, 0, 10);
+    light.m_Range = 5.0f;
+    dmRender::AddLight(m_Context, light);
+    dmRender::RenderListEnd(m_Context);
+
+    dmRender::UpdateLightClusters(m_Context);
+
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < dmRender::LIGHT_CLUSTER_COUNT; ++i)
+        total += m_Context->m_LightClusterCounts[i];
+    // The light reaches two tiles along x and y, and two depth slices
+    ASSERT_EQ(2u * 2u * 2u, total);
+
+    // The depth slices are logarithmic, depth 10 is halfway between the near and far plane
+    const uint32_t z = dmRender::LIGHT_CLUSTERS_Z / 2;
+    ASSERT_EQ(1u, GetLightClusterLightCount(m_Context, dmRender::LIGHT_CLUSTERS_X / 2, dmRender::LIGHT_CLUSTERS_Y / 2, z));
+    ASSERT_EQ(0u, GetLightClusterLightCount(m_Context, 0, 0, z));
+    ASSERT_EQ(0u, GetLightClusterLightCount(m_Context, dmRender::LIGHT_CLUSTERS_X / 2, dmRender::LIGHT_CLUSTERS_Y / 2, 0));
+
+    // The cluster points at its light index, which points at the light data
+    const float* data = m_Context->m_LightTextureData.Begin();
+    uint32_t cluster = dmRender::LIGHT_CLUSTERS_X / 2 + dmRender::LIGHT_CLUSTERS_Y / 2 * dmRender::LIGHT_CLUSTERS_X + z * dmRender::LIGHT_CLUSTERS_X * dmRender::LIGHT_CLUSTERS_Y;
+    uint32_t index_texel = (uint32_t) data[cluster * 4 + 0];
+    ASSERT_EQ(1.0f, data[cluster * 4 + 1]);
+    uint32_t light_texel = (uint32_t) data[index_texel * 4];
+    ASSERT_EQ(dmRender::LIGHT_CLUSTER_COUNT + total, light_texel);
+    ASSERT_NEAR(-10.0f, data[light_texel * 4 + 2], 0.0001f);
+    ASSERT_NEAR(0.5f, data[light_texel * 4 + 3], 0.0001f);
+
+    // The lights are cleared with the render list
+    dmRender::RenderListBegin(m_Context);
+    dmRender::RenderListEnd(m_Context);
+    dmRender::UpdateLightClusters(m_Context);
+    for (uint32_t i = 0; i < dmRender::LIGHT_CLUSTER_COUNT; ++i)
+        ASSERT_EQ(0u, m_Context->m_LightClusterCounts[i]);
+}
+
+TEST_F(dmRenderTest, TestRenderListLayerMask)
+{
+    const uint32_t n = 4;
+    const uint32_t layers[n] = { 0, 1, 5, 31 };
+
+    uint32_t rendered[n];
+    memset(rendered, 0, sizeof(rendered));
+
+    dmRender::RenderListBegin(m_Context);
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(m_Context, SegmentDrawDispatch, rendered);
+
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(m_Context, n);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        dmRender::RenderListEntry& entry = out[i];
+        // Allocated entries are cleared, which puts them on layer 0
+        ASSERT_EQ(0U, entry.m_Layer);
+        entry.m_WorldPosition = Point3(0, 0, 0);
+        entry.m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+        entry.m_BatchKey = (uint32_t) i;
+        entry.m_Dispatch = dispatch;
+        entry.m_UserData = i;
+        entry.m_Layer = layers[i];
+    }
+    dmRender::RenderListSubmit(m_Context, out, out + n);
+    dmRender::RenderListEnd(m_Context);
+
+    ASSERT_EQ(0xffffffff, dmRender::GetLayerMask(m_Context));
+    dmRender::DrawRenderList(m_Context, 0, 0);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ(1U, rendered[i]);
+    }
+
+    dmRender::SetLayerMask(m_Context, (1u << 1) | (1u << 31));
+    dmRender::DrawRenderList(m_Context, 0, 0);
+    ASSERT_EQ(1U, rendered[0]);
+    ASSERT_EQ(2U, rendered[1]);
+    ASSERT_EQ(1U, rendered[2]);
+    ASSERT_EQ(2U, rendered[3]);
+
+    dmRender::SetLayerMask(m_Context, 0);
+    dmRender::DrawRenderList(m_Context, 0, 0);
+    ASSERT_EQ(2U, rendered[1]);
+
+    dmRender::SetLayerMask(m_Context, 0xffffffff);
+}
+
 static float Metric(const char* text, int n, bool measure_trailing_space)
 {
     return n * 4;
@@ -781,6 +1215,80 @@ TEST_F(dmRenderTest, FindRanges)
     ASSERT_EQ(6, range.m_Count);
 }
 
+struct SortValueSorter
+{
+    bool operator()(uint32_t a, uint32_t b) const
+    {
+        return m_Values[a].m_SortKey < m_Values[b].m_SortKey;
+    }
+    dmRender::RenderListSortValue* m_Values;
+};
+
+static void SortRadixAndCompare(dmJob::HContext job_context, uint32_t count)
+{
+    dmArray<dmRender::RenderListSortValue> values;
+    values.SetCapacity(count);
+    values.SetSize(count);
+    dmArray<uint32_t> indices;
+    indices.SetCapacity(count);
+    indices.SetSize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        values[i].m_SortKey = 0;
+        values[i].m_BatchKey = rand() % 3;
+        values[i].m_Order = rand() % 1000;
+        values[i].m_MajorOrder = rand() % 2;
+        indices[i] = count - 1 - i;
+    }
+
+    dmArray<uint32_t> expected;
+    expected.SetCapacity(count);
+    expected.SetSize(count);
+    memcpy(expected.Begin(), indices.Begin(), sizeof(uint32_t) * count);
+    dmArray<uint32_t> unsorted;
+    unsorted.SetCapacity(count);
+    unsorted.SetSize(count);
+    memcpy(unsorted.Begin(), indices.Begin(), sizeof(uint32_t) * count);
+
+    SortValueSorter sort;
+    sort.m_Values = values.Begin();
+    std::stable_sort(expected.Begin(), expected.End(), sort);
+
+    dmRender::RenderListSortScratch* scratch = new dmRender::RenderListSortScratch;
+    dmArray<uint32_t> previous_order;
+    ASSERT_FALSE(dmRender::RadixSortRenderList(job_context, values.Begin(), indices.Begin(), count, *scratch, previous_order));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(expected[i], indices[i]);
+    }
+
+    // Same keys next frame, the previous order is reused
+    ASSERT_TRUE(dmRender::RadixSortRenderList(job_context, values.Begin(), unsorted.Begin(), count, *scratch, previous_order));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(expected[i], unsorted[i]);
+    }
+
+    delete scratch;
+}
+
+TEST_F(dmRenderTest, RadixSortRenderList)
+{
+    SortRadixAndCompare(0, 1);
+    SortRadixAndCompare(0, 1000);
+    SortRadixAndCompare(0, 20000);
+}
+
+TEST_F(dmRenderTest, RadixSortRenderListJobs)
+{
+    dmJob::NewContextParams job_params;
+    job_params.m_WorkerCount = 3;
+    dmJob::HContext job_context = dmJob::NewContext(job_params);
+    SortRadixAndCompare(job_context, 1000);
+    SortRadixAndCompare(job_context, 20000);
+    dmJob::DeleteContext(job_context);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -733,6 +733,51 @@ TEST_F(dmRenderScriptTest, TestLuaTransform)
     dmRender::DeleteRenderScript(m_Context, render_script);
 }
 
+TEST_F(dmRenderScriptTest, TestLuaCommandList)
+{
+    const char* script =
+    "function init(self)\n"
+    "    self.pred = render.predicate({\"one\"})\n"
+    "    render.begin_record()\n"
+    "    render.set_viewport(1, 2, 3, 4)\n"
+    "    render.set_view(vmath.matrix4())\n"
+    "    render.set_projection(\"projection\")\n"
+    "    render.draw(self.pred, \"constants\")\n"
+    "    self.list = render.end_record()\n"
+    "    self.constants = render.constant_buffer()\n"
+    "    self.constants.tint = vmath.vector4(1, 0, 0, 1)\n"
+    "    render.execute(self.list, { projection = vmath.matrix4_translation(vmath.vector3(2, 0, 0)), constants = self.constants })\n"
+    "    render.execute(self.list, { projection = vmath.matrix4_translation(vmath.vector3(3, 0, 0)) })\n"
+    "end\n";
+    dmRender::HRenderScript render_script = dmRender::NewRenderScript(m_Context, LuaSourceFromString(script));
+    dmRender::HRenderScriptInstance render_script_instance = dmRender::NewRenderScriptInstance(m_Context, render_script);
+
+    ASSERT_EQ(dmRender::RENDER_SCRIPT_RESULT_OK, dmRender::InitRenderScriptInstance(render_script_instance));
+
+    dmArray<dmRender::Command>& commands = render_script_instance->m_CommandBuffer;
+    ASSERT_EQ(8u, commands.Size());
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        dmRender::Command* command = &commands[i * 4];
+        ASSERT_EQ(dmRender::COMMAND_TYPE_SET_VIEWPORT, command[0].m_Type);
+        ASSERT_EQ(3u, command[0].m_Operands[2]);
+        ASSERT_EQ(dmRender::COMMAND_TYPE_SET_VIEW, command[1].m_Type);
+        ASSERT_EQ(dmRender::COMMAND_TYPE_SET_PROJECTION, command[2].m_Type);
+        ASSERT_EQ(dmRender::COMMAND_TYPE_DRAW, command[3].m_Type);
+        ASSERT_NE(0u, command[3].m_Operands[0]);
+    }
+    ASSERT_NE(commands[1].m_Operands[0], commands[5].m_Operands[0]);
+    ASSERT_EQ(2.0f, ((Matrix4*)commands[2].m_Operands[0])->getElem(3, 0));
+    ASSERT_EQ(3.0f, ((Matrix4*)commands[6].m_Operands[0])->getElem(3, 0));
+    ASSERT_NE(0u, commands[3].m_Operands[1]);
+    ASSERT_EQ(0u, commands[7].m_Operands[1]);
+
+    dmRender::ParseCommands(m_Context, &commands[0], commands.Size());
+
+    dmRender::DeleteRenderScriptInstance(render_script_instance);
+    dmRender::DeleteRenderScript(m_Context, render_script);
+}
+
 TEST_F(dmRenderScriptTest, TestLuaDraw_StringPredicate)
 {
     const char* script =
@@ -828,6 +873,26 @@ TEST_F(dmRenderScriptTest, TestLuaWindowSize)
     dmRender::DeleteRenderScript(m_Context, render_script);
 }
 
+TEST_F(dmRenderScriptTest, TestLuaGetStats)
+{
+    const char* script =
+    "function update(self)\n"
+    "    local stats = render.get_stats()\n"
+    "    assert(stats.draw_calls == 0)\n"
+    "    assert(stats.texture_memory >= 0)\n"
+    "    assert(stats.frames_over_budget == 0)\n"
+    "    assert(#stats.passes == 0)\n"
+    "end\n";
+    dmRender::HRenderScript render_script = dmRender::NewRenderScript(m_Context, LuaSourceFromString(script));
+    dmRender::HRenderScriptInstance render_script_instance = dmRender::NewRenderScriptInstance(m_Context, render_script);
+
+    ASSERT_EQ(dmRender::RENDER_SCRIPT_RESULT_OK, dmRender::DispatchRenderScriptInstance(render_script_instance));
+    ASSERT_EQ(dmRender::RENDER_SCRIPT_RESULT_OK, dmRender::UpdateRenderScriptInstance(render_script_instance, 0.0f));
+
+    dmRender::DeleteRenderScriptInstance(render_script_instance);
+    dmRender::DeleteRenderScript(m_Context, render_script);
+}
+
 void TestDispatchCallback(dmMessage::Message *message, void* user_ptr)
 {
     if (message->m_Id == dmHashString64("test_message"))
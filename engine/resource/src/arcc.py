@@ -21,6 +21,10 @@ KEY = "aQj8CScgNP4VsfXK"
 VERSION = 4
 HASH_MAX_LENGTH = 64 # 512 bits
 HASH_LENGTH = 18
+ENTRY_FLAG_ENCRYPTED = 1
+ENTRY_FLAG_DICTIONARY = 8
+DICTIONARY_MAX_SIZE = 64 * 1024 # LZ4 only references the last 64k
+DICTIONARY_ENTRY_MAX_SIZE = 4 * 1024 # Entries small enough to compress badly on their own
 
 class Entry(object):
     def __init__(self, root, filename, compress):
@@ -65,7 +69,7 @@ class Entry(object):
 
 
 class EntryData(object):
-    def __init__(self, root, filename, compress, hashpostfix):
+    def __init__(self, root, filename, compress, hashpostfix, dictionary = None):
         rel_name = os.path.relpath(filename, root)
         rel_name = rel_name.replace('\\', '/')
 
@@ -77,10 +81,16 @@ class EntryData(object):
         the_hash_bytes = bytearray(the_hash_str)#b'awesomehash'
         self.hash = the_hash_bytes
         self.hash_size = len(the_hash_bytes)
+        self.flags = 0
         if compress == True:
             tmp_buf = f.read()
             max_compressed_size = dlib.dmLZ4MaxCompressedSize(size)
             self.resource = dlib.dmLZ4CompressBuffer(tmp_buf, size, max_compressed_size)
+            if dictionary and size <= DICTIONARY_ENTRY_MAX_SIZE:
+                dict_resource = dlib.dmLZ4CompressBufferWithDictionary(tmp_buf, size, max_compressed_size, dictionary)
+                if len(dict_resource) < len(self.resource):
+                    self.resource = dict_resource
+                    self.flags = ENTRY_FLAG_DICTIONARY
             self.compressed_size = len(self.resource)
             # Store uncompressed if gain is less than 5%
             # We believe that the shorter load time will compensate in this case.
@@ -92,15 +102,14 @@ class EntryData(object):
             if comp_ratio > 0.95:
                 self.resource = tmp_buf
                 self.compressed_size = 0xFFFFFFFFL
+                self.flags = 0
         else:
             self.resource = f.read()
             self.compressed_size = 0xFFFFFFFFL
 
         if os.path.splitext(filename)[-1] in ENCRYPTED_EXTS:
-            self.flags = 1
+            self.flags |= ENTRY_FLAG_ENCRYPTED
             self.resource = dlib.dmEncryptXTeaCTR(self.resource, KEY)
-        else:
-            self.flags = 0
         self.size = size
         f.close()
 
@@ -126,11 +135,55 @@ def entry_data_hash_cmp(a, b):
 def set_output_path(rel_path, full_path):
     return rel_path + os.path.basename(full_path)
 
+def train_dictionary(input_files):
+    # Samples of the small entries, grouped by type with the most common types last,
+    # since the end of the dictionary is what LZ4 can reference
+    samples = {}
+    for f in input_files:
+        if os.stat(f)[stat.ST_SIZE] > DICTIONARY_ENTRY_MAX_SIZE:
+            continue
+        ext = os.path.splitext(f)[-1]
+        fh = open(f, 'rb')
+        samples.setdefault(ext, []).append(fh.read())
+        fh.close()
+
+    dictionary = ''
+    for ext in sorted(samples.keys(), key=lambda ext: (len(samples[ext]), ext)):
+        # A few samples per type is enough to capture the common field names and values
+        dictionary += ''.join(samples[ext][:8])
+    return dictionary[-DICTIONARY_MAX_SIZE:]
+
+def read_load_order(filename):
+    # One resource path per line, as recorded by the engine (resource.load_order_file)
+    order = {}
+    f = open(filename, 'r')
+    for line in f:
+        path = line.strip()
+        if path and path not in order:
+            order[path] = len(order)
+    f.close()
+    return order
+
+def layout_order(paths, load_order):
+    # Resources in the recorded load order first, the rest in their original order
+    if not load_order:
+        return range(len(paths))
+    unknown = len(load_order)
+    return sorted(range(len(paths)), key=lambda i: (load_order.get(paths[i], unknown), i))
+
 def compile(input_files, options):
     # Sort file-names. Names must be sorted for binary search at run-time and for correct hash assignment for tests.
     input_files.sort()
 
+    load_order = None
+    if options.load_order_file:
+        load_order = read_load_order(options.load_order_file)
+
     if not options.output_file:
+        dictionary = None
+        if options.compress and options.dictionary:
+            dictionary = train_dictionary(input_files)
+
         oifn = set_output_path(options.rel_path, options.output_file_index)
         out_index = open(oifn, 'wb+')
         odfn = set_output_path(options.rel_path, options.output_file_data)
@@ -139,7 +192,7 @@ def compile(input_files, options):
         # TODO magic number
         out_index.seek(0)
         out_index.write(struct.pack('!I', VERSION)) # Version
-        out_index.write(struct.pack('!I', 0)) # Pad
+        out_index.write(struct.pack('!I', 0)) # DictionaryOffset (placeholder, actual value written later)
         out_index.write(struct.pack('!Q', 0)) # Userdata
         out_index.write(struct.pack('!I', 0)) # EntryCount (placeholder, actual value written later)
         out_index.write(struct.pack('!I', 0)) # EntryOffset (placeholder, actual value written later)
@@ -149,16 +202,19 @@ def compile(input_files, options):
         entry_count = 0
         entry_datas = []
 
-        # write resource data to datafile
         num_input_files = len(input_files)
-        out_data.seek(0)
         for i,f in enumerate(input_files):
+            e = EntryData(options.root, f, options.compress, num_input_files - i, dictionary)
+            entry_datas.append(e)
+            entry_count += 1
+
+        # write resource data to datafile, in load order if one was supplied so that loading reads the file sequentially
+        out_data.seek(0)
+        for i in layout_order([e.path for e in entry_datas], load_order):
+            e = entry_datas[i]
             align_file(out_data, 4)
-            e = EntryData(options.root, f, options.compress, num_input_files - i)
             e.resource_offset = out_data.tell()
             out_data.write(e.resource)
-            entry_datas.append(e)
-            entry_count += 1
         out_data.close()
 
         # sort entrydatas on hash for binary search in runtime
@@ -190,9 +246,17 @@ def compile(input_files, options):
             out_index.write(struct.pack('!I', e.flags))
             i += 1
 
+        # write the compression dictionary, size followed by data
+        dictionary_offset = 0
+        if dictionary:
+            align_file(out_index, 4)
+            dictionary_offset = out_index.tell()
+            out_index.write(struct.pack('!I', len(dictionary)))
+            out_index.write(dictionary)
+
         out_index.seek(0)
         out_index.write(struct.pack('!I', VERSION)) # Version
-        out_index.write(struct.pack('!I', 0)) # Pad
+        out_index.write(struct.pack('!I', dictionary_offset)) # DictionaryOffset
         out_index.write(struct.pack('!Q', 0)) # Userdata
         out_index.write(struct.pack('!I', entry_count)) # EntryCount
         out_index.write(struct.pack('!I', entry_offset)) # EntryOffset
@@ -232,11 +296,11 @@ def compile(input_files, options):
 
         string_pool_size = out_file.tell() - string_pool_offset
 
-        resources_offset = []
-        for i,e in enumerate(entries):
+        resources_offset = [0] * len(entries)
+        for i in layout_order([e.filename for e in entries], load_order):
             align_file(out_file, 4)
-            resources_offset.append(out_file.tell())
-            out_file.write(e.resource)
+            resources_offset[i] = out_file.tell()
+            out_file.write(entries[i].resource)
 
         align_file(out_file, 4)
         entry_offset = out_file.tell()
@@ -275,6 +339,8 @@ if __name__ == '__main__':
     parser.add_option('-d', dest='output_file_data', help='Data output file', metavar='OUTPUTDATA')
     parser.add_option('-c', dest='compress', action='store_true', help='Use compression', metavar='COMPRESSION', default=False)
     parser.add_option('-p', dest='rel_path', help='Output relative target path')
+    parser.add_option('-D', dest='dictionary', action='store_true', help='Compress small entries with a dictionary trained on the input files (requires -c)', default=False)
+    parser.add_option('-l', dest='load_order_file', help='Resource load order recorded by the engine, used to lay out the resource data', metavar='LOADORDER')
     (options, args) = parser.parse_args()
     if not options.output_file and not options.output_file_index:
         parser.error('Output file not specified (-o)')
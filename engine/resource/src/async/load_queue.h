@@ -35,6 +35,11 @@ namespace dmLoadQueue
         dmResource::FResourcePreload m_Function;
         dmResource::PreloadHintInfo m_HintInfo;
         void* m_Context;
+        // Set for types with RESOURCE_TYPE_FLAGS_THREAD_SAFE_CREATE. The queue may then create
+        // the resource itself, if the preload function didn't hint any resources.
+        dmResource::FResourceCreate m_CreateFunction;
+        dmResource::SResourceType* m_ResourceType;
+        dmhash_t m_CanonicalPathHash;
     };
 
     struct LoadResult
@@ -42,6 +47,11 @@ namespace dmLoadQueue
         dmResource::Result m_LoadResult;
         dmResource::Result m_PreloadResult;
         void* m_PreloadData;
+        // RESULT_PENDING unless the resource was created by the queue, m_Resource is then filled in
+        dmResource::Result m_CreateResult;
+        dmResource::SResourceDescriptor m_Resource;
+        // The buffer points into a memory mapped archive, see RESOURCE_TYPE_FLAGS_MAPPED_BUFFER
+        bool m_IsBufferMapped;
     };
 
     HQueue CreateQueue(dmResource::HFactory factory);
@@ -16,11 +16,14 @@
 
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
+#include <dlib/platform.h>
+
+#if defined(DM_NO_THREAD_SUPPORT)
 
 namespace dmLoadQueue
 {
     // Implementation of the LoadQueue API where all loads happen during the EndLoad call.
-    // EndLoad thus never returns _PENDING
+    // EndLoad only returns _PENDING while the archive data is being fetched (see dmResource::PrefetchResource)
 
     struct Request
     {
@@ -70,9 +73,18 @@ namespace dmLoadQueue
             return RESULT_INVALID_PARAM;
         }
 
-        load_result->m_LoadResult    = dmResource::LoadResource(queue->m_Factory, request->m_CanonicalPath, request->m_Name, buf, size);
+        if (dmResource::PrefetchResource(queue->m_Factory, request->m_Name) == dmResource::RESULT_PENDING)
+        {
+            return RESULT_PENDING;
+        }
+
+        dmResource::SResourceType* resource_type = request->m_PreloadInfo.m_ResourceType;
+        bool allow_mapped = resource_type && (resource_type->m_Flags & RESOURCE_TYPE_FLAGS_MAPPED_BUFFER);
+        load_result->m_IsBufferMapped = false;
+        load_result->m_LoadResult    = dmResource::LoadResource(queue->m_Factory, request->m_CanonicalPath, request->m_Name, buf, size, allow_mapped ? &load_result->m_IsBufferMapped : 0);
         load_result->m_PreloadResult = dmResource::RESULT_PENDING;
         load_result->m_PreloadData   = 0;
+        load_result->m_CreateResult  = dmResource::RESULT_PENDING;
 
         if (load_result->m_LoadResult == dmResource::RESULT_OK && request->m_PreloadInfo.m_Function)
         {
@@ -81,6 +93,7 @@ namespace dmLoadQueue
             params.m_Context             = request->m_PreloadInfo.m_Context;
             params.m_Buffer              = *buf;
             params.m_BufferSize          = *size;
+            params.m_Filename            = request->m_Name;
             params.m_HintInfo            = &request->m_PreloadInfo.m_HintInfo;
             params.m_PreloadData         = &load_result->m_PreloadData;
             load_result->m_PreloadResult = request->m_PreloadInfo.m_Function(params);
@@ -95,3 +108,5 @@ namespace dmLoadQueue
         request->m_CanonicalPath = 0x0;
     }
 } // namespace dmLoadQueue
+
+#endif // DM_NO_THREAD_SUPPORT
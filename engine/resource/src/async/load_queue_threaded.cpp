@@ -21,10 +21,18 @@
 #include <dlib/mutex.h>
 #include <dlib/time.h>
 #include <dlib/condition_variable.h>
+#include <dlib/job.h>
+#include <dlib/math.h>
+#include <dlib/platform.h>
+#include <dlib/profile.h>
+
+#if !defined(DM_NO_THREAD_SUPPORT)
 
 namespace dmLoadQueue
 {
-    // Implementation of dmLoadQueue with a thread that loads items in the order they are supplied,
+    // Implementation of dmLoadQueue with a number of threads that pick up items in the order they are supplied.
+    // Reading is serialized by the factory load mutex, but decryption and decompression of archive
+    // entries are done by each thread in parallel.
 
     // Default to small buffers since a lot of what is loaded are just small objects anyway.
     // That way we can have more in flight, but throttle when max pending data grows too large anyway
@@ -33,15 +41,42 @@ namespace dmLoadQueue
     // Once the loader has this amount not picked up, it will stop loading more.
     // This sets the bandwidth of the loader.
     const uint64_t MAX_PENDING_DATA = 4 * 1024 * 1024;
-    const uint32_t QUEUE_SLOTS      = 16;
+
+    // The number of slots in use adapts between these limits, see BeginLoad and FinishRequest
+    const uint32_t QUEUE_SLOTS_MIN  = 16;
+    const uint32_t QUEUE_SLOTS_MAX  = 64;
+
+    // Upper limit for the number of threads when the count isn't specified by the factory
+    const uint32_t DEFAULT_MAX_LOADER_THREADS = 4;
+    const uint32_t MAX_LOADER_THREADS = 16;
+
+    enum RequestState
+    {
+        REQUEST_STATE_FREE    = 0,
+        REQUEST_STATE_QUEUED  = 1,
+        REQUEST_STATE_LOADING = 2,
+        REQUEST_STATE_LOADED  = 3,
+    };
 
     struct Request
     {
         const char* m_Name;
         const char* m_CanonicalPath;
         dmResource::LoadBufferType m_Buffer;
+        // Set instead of m_Buffer when the data is used directly from a memory mapped archive
+        const void* m_MappedData;
+        uint32_t m_MappedSize;
         PreloadInfo m_PreloadInfo;
         LoadResult m_Result;
+        RequestState m_State;
+    };
+
+    struct Worker
+    {
+        struct Queue* m_Queue;
+        dmThread::Thread m_Thread;
+        // Stored archive entry data, before decoding
+        dmResource::LoadBufferType m_Data;
     };
 
     struct Queue
@@ -49,16 +84,20 @@ namespace dmLoadQueue
         dmResource::HFactory m_Factory;
         dmMutex::HMutex m_Mutex;
         dmConditionVariable::HConditionVariable m_WakeupCond;
-        dmThread::Thread m_Thread;
-        Request m_Request[QUEUE_SLOTS];
-        uint32_t m_Front, m_Back, m_Loaded;
+        Worker* m_Workers;
+        uint32_t m_WorkerCount;
+        uint32_t m_IdleWorkerCount;
+        Request m_Request[QUEUE_SLOTS_MAX];
+        uint32_t m_Front, m_Back, m_Next;
+        // Number of slots currently allowed to be in use
+        uint32_t m_SlotCount;
         uint64_t m_BytesWaiting;
         bool m_Shutdown;
 
         // Circular queue with indexing as follow (exclusive end)
         //
-        //          m_Back           m_Loaded   m_Front
-        // [N/A]   [loaded] [loaded] [to-load]  [N/A]
+        //          m_Back                         m_Next     m_Front
+        // [N/A]   [loaded/loading/freed] [loading] [queued]   [N/A]
         //
     };
 
@@ -73,17 +112,129 @@ namespace dmLoadQueue
             return 0x0;
         }
 
-        if (queue->m_Loaded == queue->m_Front)
+        if (queue->m_Next == queue->m_Front)
         {
             return 0x0;
         }
 
-        return &queue->m_Request[queue->m_Loaded % QUEUE_SLOTS];
+        Request* request = &queue->m_Request[(queue->m_Next++) % QUEUE_SLOTS_MAX];
+        assert(request->m_State == REQUEST_STATE_QUEUED);
+        request->m_State = REQUEST_STATE_LOADING;
+        return request;
+    }
+
+    // Assumes the queue mutex is held
+    static void FinishRequest(Queue* queue, Request* request, const LoadResult& result)
+    {
+        queue->m_BytesWaiting += request->m_Buffer.Capacity();
+        request->m_Result = result;
+        request->m_State  = REQUEST_STATE_LOADED;
+
+        if (queue->m_BytesWaiting >= MAX_PENDING_DATA)
+        {
+            // Loaded data isn't picked up fast enough, more requests in flight would only cost memory
+            queue->m_SlotCount = dmMath::Max(QUEUE_SLOTS_MIN, queue->m_SlotCount / 2);
+        }
+    }
+
+    static const void* GetRequestData(Request* request)
+    {
+        return request->m_MappedData ? request->m_MappedData : request->m_Buffer.Begin();
+    }
+
+    static uint32_t GetRequestDataSize(Request* request)
+    {
+        return request->m_MappedData ? request->m_MappedSize : request->m_Buffer.Size();
+    }
+
+    static void CreateResource(Queue* queue, Request* request, LoadResult* result)
+    {
+        DM_PROFILE(Resource, "CreateResource");
+        dmResource::SResourceDescriptor* resource = &result->m_Resource;
+        memset(resource, 0, sizeof(*resource));
+        resource->m_NameHash           = request->m_PreloadInfo.m_CanonicalPathHash;
+        resource->m_ReferenceCount     = 1;
+        resource->m_ResourceType       = (void*)request->m_PreloadInfo.m_ResourceType;
+        resource->m_ResourceSizeOnDisc = GetRequestDataSize(request);
+
+        dmResource::ResourceCreateParams params;
+        params.m_Factory        = queue->m_Factory;
+        params.m_Context        = request->m_PreloadInfo.m_Context;
+        params.m_Filename       = request->m_Name;
+        params.m_Buffer         = GetRequestData(request);
+        params.m_BufferSize     = GetRequestDataSize(request);
+        params.m_PreloadData    = result->m_PreloadData;
+        params.m_Resource       = resource;
+        params.m_IsBufferMapped = request->m_MappedData != 0;
+        result->m_CreateResult = request->m_PreloadInfo.m_CreateFunction(params);
+    }
+
+    static void LoadRequest(Worker* worker, Request* request, LoadResult* result)
+    {
+        Queue* queue = worker->m_Queue;
+        uint32_t size;
+
+        assert(request->m_Buffer.Size() == 0);
+        if (request->m_Buffer.Capacity() != DEFAULT_CAPACITY)
+        {
+            request->m_Buffer.SetCapacity(DEFAULT_CAPACITY);
+        }
+
+        dmResource::PendingDecode decode;
+        decode.m_Data = &worker->m_Data;
+        bool allow_mapped = request->m_PreloadInfo.m_ResourceType && (request->m_PreloadInfo.m_ResourceType->m_Flags & RESOURCE_TYPE_FLAGS_MAPPED_BUFFER);
+        request->m_MappedData    = 0;
+        request->m_MappedSize    = 0;
+        result->m_LoadResult     = DoLoadResource(queue->m_Factory, request->m_CanonicalPath, request->m_Name, &size, &request->m_Buffer, &decode, allow_mapped ? &request->m_MappedData : 0);
+        result->m_PreloadResult  = dmResource::RESULT_PENDING;
+        result->m_PreloadData    = 0;
+        result->m_CreateResult   = dmResource::RESULT_PENDING;
+        result->m_IsBufferMapped = false;
+
+        if (result->m_LoadResult == dmResource::RESULT_OK && request->m_MappedData)
+        {
+            request->m_MappedSize    = size;
+            result->m_IsBufferMapped = true;
+        }
+
+        if (result->m_LoadResult == dmResource::RESULT_OK && decode.m_Pending)
+        {
+            result->m_LoadResult = DecodeResource(&decode, &request->m_Buffer);
+        }
+
+        if (result->m_LoadResult == dmResource::RESULT_OK)
+        {
+            assert(GetRequestDataSize(request) == size);
+            if (request->m_PreloadInfo.m_Function)
+            {
+                dmResource::ResourcePreloadParams params;
+                params.m_Factory        = queue->m_Factory;
+                params.m_Context        = request->m_PreloadInfo.m_Context;
+                params.m_Filename       = request->m_Name;
+                params.m_Buffer         = GetRequestData(request);
+                params.m_BufferSize     = size;
+                params.m_HintInfo       = &request->m_PreloadInfo.m_HintInfo;
+                params.m_PreloadData    = &result->m_PreloadData;
+                result->m_PreloadResult = request->m_PreloadInfo.m_Function(params);
+            }
+            else
+            {
+                result->m_PreloadResult = dmResource::RESULT_OK;
+            }
+
+            // Hinted resources are created by the preloader on the main thread and must exist before
+            // the create function is called, leave those to the preloader as well.
+            if (result->m_PreloadResult == dmResource::RESULT_OK && request->m_PreloadInfo.m_CreateFunction && request->m_PreloadInfo.m_HintInfo.m_HintCount == 0)
+            {
+                CreateResource(queue, request, result);
+            }
+        }
     }
 
     static void LoadThread(void* arg)
     {
-        Queue* queue     = (Queue*)arg;
+        Worker* worker   = (Worker*)arg;
+        Queue* queue     = worker->m_Queue;
         Request* current = 0;
         LoadResult result;
         while (true)
@@ -92,11 +243,9 @@ namespace dmLoadQueue
                 dmMutex::ScopedLock lk(queue->m_Mutex);
                 if (current != 0)
                 {
-                    // Just finished one (from previous iteratino)
-                    queue->m_BytesWaiting += current->m_Buffer.Capacity();
-                    queue->m_Loaded++;
-                    current->m_Result = result;
-                    current           = 0;
+                    // Just finished one (from previous iteration)
+                    FinishRequest(queue, current, result);
+                    current = 0;
                 }
                 if (queue->m_Shutdown)
                 {
@@ -104,22 +253,26 @@ namespace dmLoadQueue
                 }
 
                 current = GetNextRequest(queue);
-                if (current == 0x0)
+                while (current == 0x0 && !queue->m_Shutdown)
                 {
                     // Nothing to do, reset any buffers of inactive requests that are not at default capacity
-                    for (uint32_t i = 0; i < QUEUE_SLOTS; ++i)
+                    for (uint32_t i = 0; i < QUEUE_SLOTS_MAX; ++i)
                     {
                         Request* r = &queue->m_Request[i];
-                        if (r->m_Buffer.Size() == 0)
+                        if (r->m_State == REQUEST_STATE_FREE && r->m_Buffer.Capacity() > DEFAULT_CAPACITY)
                         {
-                            if (r->m_Buffer.Capacity() > DEFAULT_CAPACITY)
-                            {
-                                // Just free the memory here, no need to allocate while holding the mutex
-                                r->m_Buffer.SetCapacity(0);
-                            }
+                            // Just free the memory here, no need to allocate while holding the mutex
+                            r->m_Buffer.SetCapacity(0);
                         }
                     }
+                    if (worker->m_Data.Capacity() > DEFAULT_CAPACITY)
+                    {
+                        worker->m_Data.SetCapacity(0);
+                    }
+
+                    queue->m_IdleWorkerCount++;
                     dmConditionVariable::Wait(queue->m_WakeupCond, queue->m_Mutex);
+                    queue->m_IdleWorkerCount--;
                     current = GetNextRequest(queue);
                 }
             }
@@ -127,52 +280,54 @@ namespace dmLoadQueue
             if (current)
             {
                 // We use the temporary result object here to fill in the data so it can be written with the mutex held.
-                uint32_t size;
-
-                assert(current->m_Buffer.Size() == 0);
-                if (current->m_Buffer.Capacity() != DEFAULT_CAPACITY)
-                {
-                    current->m_Buffer.SetCapacity(DEFAULT_CAPACITY);
-                }
-                result.m_LoadResult    = DoLoadResource(queue->m_Factory, current->m_CanonicalPath, current->m_Name, &size, &current->m_Buffer);
-                result.m_PreloadResult = dmResource::RESULT_PENDING;
-                result.m_PreloadData   = 0;
-
-                if (result.m_LoadResult == dmResource::RESULT_OK)
-                {
-                    assert(current->m_Buffer.Size() == size);
-                    if (current->m_PreloadInfo.m_Function)
-                    {
-                        dmResource::ResourcePreloadParams params;
-                        params.m_Factory       = queue->m_Factory;
-                        params.m_Context       = current->m_PreloadInfo.m_Context;
-                        params.m_Buffer        = current->m_Buffer.Begin();
-                        params.m_BufferSize    = current->m_Buffer.Size();
-                        params.m_HintInfo      = &current->m_PreloadInfo.m_HintInfo;
-                        params.m_PreloadData   = &result.m_PreloadData;
-                        result.m_PreloadResult = current->m_PreloadInfo.m_Function(params);
-                    }
-                    else
-                    {
-                        result.m_PreloadResult = dmResource::RESULT_OK;
-                    }
-                }
+                LoadRequest(worker, current, &result);
             }
         }
     }
 
+    static uint32_t GetWorkerCount(dmResource::HFactory factory)
+    {
+        uint32_t count = dmResource::GetLoaderThreadCount(factory);
+        if (count == 0)
+        {
+            // Leave one core for the main thread
+            uint32_t core_count = dmJob::GetCoreCount();
+            count = core_count > 1 ? dmMath::Min(core_count - 1, DEFAULT_MAX_LOADER_THREADS) : 1;
+        }
+        return dmMath::Min(count, MAX_LOADER_THREADS);
+    }
+
     HQueue CreateQueue(dmResource::HFactory factory)
     {
-        Queue* q          = new Queue();
-        q->m_Factory      = factory;
-        q->m_Front        = 0;
-        q->m_Back         = 0;
-        q->m_Loaded       = 0;
-        q->m_Shutdown     = false;
-        q->m_BytesWaiting = 0;
-        q->m_Mutex        = dmMutex::New();
-        q->m_WakeupCond   = dmConditionVariable::New();
-        q->m_Thread       = dmThread::New(&LoadThread, 65536, q, "AsyncLoad");
+        Queue* q             = new Queue();
+        q->m_Factory         = factory;
+        q->m_Front           = 0;
+        q->m_Back            = 0;
+        q->m_Next            = 0;
+        q->m_Shutdown        = false;
+        q->m_BytesWaiting    = 0;
+        q->m_WorkerCount     = GetWorkerCount(factory);
+        q->m_IdleWorkerCount = 0;
+        q->m_SlotCount       = dmMath::Min(QUEUE_SLOTS_MAX, dmMath::Max(QUEUE_SLOTS_MIN, q->m_WorkerCount * 4));
+        q->m_Mutex           = dmMutex::New();
+        q->m_WakeupCond      = dmConditionVariable::New();
+
+        for (uint32_t i = 0; i < QUEUE_SLOTS_MAX; ++i)
+        {
+            q->m_Request[i].m_Name          = 0x0;
+            q->m_Request[i].m_CanonicalPath = 0x0;
+            q->m_Request[i].m_MappedData    = 0x0;
+            q->m_Request[i].m_MappedSize    = 0;
+            q->m_Request[i].m_State         = REQUEST_STATE_FREE;
+        }
+
+        q->m_Workers = new Worker[q->m_WorkerCount];
+        for (uint32_t i = 0; i < q->m_WorkerCount; ++i)
+        {
+            Worker* worker   = &q->m_Workers[i];
+            worker->m_Queue  = q;
+            worker->m_Thread = dmThread::New(&LoadThread, 65536, worker, "AsyncLoad");
+        }
 
         return q;
     }
@@ -182,10 +337,14 @@ namespace dmLoadQueue
         {
             dmMutex::ScopedLock lk(queue->m_Mutex);
             queue->m_Shutdown = true;
-            // Wake up the worker so it can exit and allow us to join
-            dmConditionVariable::Signal(queue->m_WakeupCond);
+            // Wake up the workers so they can exit and allow us to join
+            dmConditionVariable::Broadcast(queue->m_WakeupCond);
+        }
+        for (uint32_t i = 0; i < queue->m_WorkerCount; ++i)
+        {
+            dmThread::Join(queue->m_Workers[i].m_Thread);
         }
-        dmThread::Join(queue->m_Thread);
+        delete[] queue->m_Workers;
         dmConditionVariable::Delete(queue->m_WakeupCond);
         dmMutex::Delete(queue->m_Mutex);
         delete queue;
@@ -201,18 +360,24 @@ namespace dmLoadQueue
         dmMutex::ScopedLock lk(queue->m_Mutex);
 
         // Refuse more if full.
-        if ((queue->m_Front - queue->m_Back) == QUEUE_SLOTS)
-            return 0;
-
-        if (queue->m_Loaded == queue->m_Front)
+        if ((queue->m_Front - queue->m_Back) >= queue->m_SlotCount)
         {
-            // The worker is sleeping waiting for request, wake it up
-            dmConditionVariable::Signal(queue->m_WakeupCond);
+            if (queue->m_IdleWorkerCount > 0 && queue->m_BytesWaiting < MAX_PENDING_DATA / 2)
+            {
+                // The workers keep up with the requests, allow more in flight next time
+                queue->m_SlotCount = dmMath::Min(QUEUE_SLOTS_MAX, queue->m_SlotCount * 2);
+            }
+            return 0;
         }
 
-        Request* req         = &queue->m_Request[(queue->m_Front++) % QUEUE_SLOTS];
+        // Wake up a worker in case they are all sleeping waiting for requests
+        dmConditionVariable::Signal(queue->m_WakeupCond);
+
+        Request* req         = &queue->m_Request[(queue->m_Front++) % QUEUE_SLOTS_MAX];
+        assert(req->m_State == REQUEST_STATE_FREE);
         req->m_Name          = name;
         req->m_CanonicalPath = canonical_path;
+        req->m_State         = REQUEST_STATE_QUEUED;
 
         req->m_PreloadInfo         = *info;
         req->m_Result.m_LoadResult = dmResource::RESULT_PENDING;
@@ -223,11 +388,11 @@ namespace dmLoadQueue
     Result EndLoad(HQueue queue, HRequest request, void** buf, uint32_t* size, LoadResult* load_result)
     {
         dmMutex::ScopedLock lk(queue->m_Mutex);
-        if (request->m_Result.m_LoadResult == dmResource::RESULT_PENDING)
+        if (request->m_State != REQUEST_STATE_LOADED)
             return RESULT_PENDING;
 
-        *buf         = request->m_Buffer.Begin();
-        *size        = request->m_Buffer.Size();
+        *buf         = (void*)GetRequestData(request);
+        *size        = GetRequestDataSize(request);
         *load_result = request->m_Result;
 
         return RESULT_OK;
@@ -237,28 +402,36 @@ namespace dmLoadQueue
     {
         dmMutex::ScopedLock lk(queue->m_Mutex);
 
-        uint32_t old_bytes_waiting = queue->m_BytesWaiting;
+        uint64_t old_bytes_waiting = queue->m_BytesWaiting;
 
         // Make sure we don't copy any data if we reallocate the buffer
         request->m_Buffer.SetSize(0);
 
         uint32_t buffer_capacity = request->m_Buffer.Capacity();
         queue->m_BytesWaiting -= buffer_capacity;
-        // If we either have blocked further processing by exceeding MAX_PENDING_DATA or
-        // the buffer has a non-default capacity, we want to wake up the worker
-        if (buffer_capacity != DEFAULT_CAPACITY || (old_bytes_waiting >= MAX_PENDING_DATA && queue->m_BytesWaiting < MAX_PENDING_DATA))
+        if (old_bytes_waiting >= MAX_PENDING_DATA && queue->m_BytesWaiting < MAX_PENDING_DATA)
         {
-            // Wake up thread, we can now fit a new request
+            // We have blocked further processing by exceeding MAX_PENDING_DATA, wake up all workers
+            dmConditionVariable::Broadcast(queue->m_WakeupCond);
+        }
+        else if (buffer_capacity != DEFAULT_CAPACITY)
+        {
+            // The buffer has a non-default capacity, wake up a worker so it can be reset
             dmConditionVariable::Signal(queue->m_WakeupCond);
         }
 
         // Clean up picked up requests
         request->m_Name          = 0x0;
         request->m_CanonicalPath = 0x0;
+        request->m_MappedData    = 0x0;
+        request->m_MappedSize    = 0;
+        request->m_State         = REQUEST_STATE_FREE;
 
-        while (queue->m_Back != queue->m_Loaded && queue->m_Request[queue->m_Back % QUEUE_SLOTS].m_Name == 0x0)
+        while (queue->m_Back != queue->m_Next && queue->m_Request[queue->m_Back % QUEUE_SLOTS_MAX].m_State == REQUEST_STATE_FREE)
         {
             queue->m_Back++;
         }
     }
 } // namespace dmLoadQueue
+
+#endif // DM_NO_THREAD_SUPPORT
@@ -171,6 +171,9 @@ namespace dmResource
         void* m_PreloadData;
         /// Resource descriptor to fill in
         HResourceDescriptor m_Resource;
+        /// True if m_Buffer points into a memory mapped archive and stays valid after the create function returns.
+        /// Only set for types registered with RESOURCE_TYPE_FLAGS_MAPPED_BUFFER
+        bool m_IsBufferMapped;
     };
 
     /**
@@ -253,6 +256,32 @@ namespace dmResource
      */
     typedef Result (*FResourceRecreate)(const ResourceRecreateParams& params);
 
+    /**
+     * Parameters to ResourcePatch callback.
+     */
+    struct ResourcePatchParams
+    {
+        /// Factory handle
+        HFactory m_Factory;
+        /// Resource context
+        void* m_Context;
+        /// File name of the patched resource
+        const char* m_Filename;
+        /// Patch data, in a format specific to the resource type
+        const void* m_Patch;
+        /// Size of the patch data
+        uint32_t m_PatchSize;
+        /// Resource descriptor of the resource to patch
+        HResourceDescriptor m_Resource;
+    };
+
+    /**
+     * Resource patch function. Applies a partial update to the resource in-place, without loading the whole file.
+     * @params params Parameters for resource patching
+     * @return RESULT_OK on success, RESULT_NOT_SUPPORTED if the patch can't be applied and the resource should be fully reloaded instead
+     */
+    typedef Result (*FResourcePatch)(const ResourcePatchParams& params);
+
 
     /**
      * Register a resource type
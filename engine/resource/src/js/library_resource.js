@@ -0,0 +1,167 @@
+
+/**
+ *  Range request backed archive data, used when the web loader doesn't download the
+ *  whole .arcd before the engine boots. Data is fetched in fixed size chunks, so that
+ *  resources stored next to each other in the archive arrive in the same request.
+ *  Fetched chunks are also stored with the Cache API, so that a reload doesn't
+ *  have to go over the network again.
+ */
+var LibraryDmResourceArchive = {
+        $DMARCHIVE: {
+            CHUNK_SIZE: 256 * 1024,
+            CACHE_NAME: 'defold-archive',
+            _archives: {},
+
+            GetUrl: function(path) {
+                var name = path.substring(path.lastIndexOf('/') + 1);
+                if (typeof Module['archiveLocationFilter'] === 'function')
+                    return Module['archiveLocationFilter']('/' + name);
+                return name;
+            },
+
+            IsStreamingEnabled: function() {
+                return typeof XMLHttpRequest !== 'undefined' && !!Module['streamingArchive'];
+            },
+
+            ChunkKey: function(archive, index) {
+                return archive.url + '?chunk=' + index + '&size=' + DMARCHIVE.CHUNK_SIZE;
+            },
+
+            StoreChunk: function(archive, index, data) {
+                archive.chunks[index] = data;
+                delete archive.pending[index];
+                delete archive.failed[index];
+            },
+
+            // Asynchronously fetches a chunk, first from the Cache API and then over the network
+            FetchChunk: function(archive, index) {
+                archive.pending[index] = true;
+                var key = DMARCHIVE.ChunkKey(archive, index);
+                var start = index * DMARCHIVE.CHUNK_SIZE;
+                var end = start + DMARCHIVE.CHUNK_SIZE - 1;
+
+                var fetchNetwork = function(cache) {
+                    return fetch(archive.url, { headers: { 'Range': 'bytes=' + start + '-' + end } })
+                        .then(function(response) {
+                            if (response.status != 206 && !(response.status == 200 && index == 0))
+                                throw new Error('Range request failed with status ' + response.status);
+                            return response.arrayBuffer();
+                        })
+                        .then(function(buffer) {
+                            var data = new Uint8Array(buffer, 0, Math.min(buffer.byteLength, DMARCHIVE.CHUNK_SIZE));
+                            if (cache)
+                                cache.put(key, new Response(data.slice())).catch(function() {});
+                            DMARCHIVE.StoreChunk(archive, index, data);
+                        });
+                };
+
+                var request;
+                if (typeof caches !== 'undefined') {
+                    request = caches.open(DMARCHIVE.CACHE_NAME).then(function(cache) {
+                        return cache.match(key).then(function(response) {
+                            if (response === undefined)
+                                return fetchNetwork(cache);
+                            return response.arrayBuffer().then(function(buffer) {
+                                DMARCHIVE.StoreChunk(archive, index, new Uint8Array(buffer));
+                            });
+                        });
+                    });
+                } else {
+                    request = fetchNetwork(null);
+                }
+
+                request.catch(function(err) {
+                    console.warn('Failed to fetch archive chunk ' + index + ' of ' + archive.url + ': ' + err);
+                    // The blocking read will retry it, and report the error
+                    archive.failed[index] = true;
+                    delete archive.pending[index];
+                });
+            },
+
+            // Blocking fetch of a chunk, only used when the data wasn't prefetched
+            FetchChunkSync: function(archive, index) {
+                var start = index * DMARCHIVE.CHUNK_SIZE;
+                var end = start + DMARCHIVE.CHUNK_SIZE - 1;
+                var xhr = new XMLHttpRequest();
+                xhr.open('GET', archive.url, false);
+                xhr.setRequestHeader('Range', 'bytes=' + start + '-' + end);
+                // Synchronous requests can't use responseType 'arraybuffer' on the main thread
+                xhr.overrideMimeType('text/plain; charset=x-user-defined');
+                xhr.send(null);
+                if (xhr.status != 206 && !(xhr.status == 200 && index == 0))
+                    return false;
+                var text = xhr.responseText;
+                var length = Math.min(text.length, DMARCHIVE.CHUNK_SIZE);
+                var data = new Uint8Array(length);
+                for (var i = 0; i < length; ++i)
+                    data[i] = text.charCodeAt(i) & 0xff;
+                DMARCHIVE.StoreChunk(archive, index, data);
+                return true;
+            }
+        },
+
+        dmResourceArchiveRemoteOpen: function(path) {
+            var jspath = UTF8ToString(path);
+            if (!DMARCHIVE.IsStreamingEnabled())
+                return 0;
+            DMARCHIVE._archives[jspath] = { url: DMARCHIVE.GetUrl(jspath), chunks: {}, pending: {}, failed: {} };
+            return 1;
+        },
+
+        dmResourceArchiveRemoteClose: function(path) {
+            delete DMARCHIVE._archives[UTF8ToString(path)];
+        },
+
+        /**
+         * Starts fetching the chunks covering the range
+         * @return 1 if all data is available, 0 if it is still being fetched, -1 on error
+         */
+        dmResourceArchiveRemotePrefetch: function(path, offset, size) {
+            var archive = DMARCHIVE._archives[UTF8ToString(path)];
+            if (archive === undefined)
+                return -1;
+            var ready = 1;
+            var first = Math.floor(offset / DMARCHIVE.CHUNK_SIZE);
+            var last = Math.floor((offset + Math.max(size, 1) - 1) / DMARCHIVE.CHUNK_SIZE);
+            for (var i = first; i <= last; ++i) {
+                if (archive.chunks[i] !== undefined)
+                    continue;
+                if (archive.failed[i])
+                    return -1;
+                if (!archive.pending[i])
+                    DMARCHIVE.FetchChunk(archive, i);
+                ready = 0;
+            }
+            return ready;
+        },
+
+        /**
+         * Copies the range into dst, fetching any missing chunks with a blocking request
+         * @return 1 on success, 0 on error
+         */
+        dmResourceArchiveRemoteRead: function(path, offset, size, dst) {
+            var archive = DMARCHIVE._archives[UTF8ToString(path)];
+            if (archive === undefined)
+                return 0;
+            var written = 0;
+            while (written < size) {
+                var pos = offset + written;
+                var index = Math.floor(pos / DMARCHIVE.CHUNK_SIZE);
+                var chunk = archive.chunks[index];
+                if (chunk === undefined) {
+                    if (!DMARCHIVE.FetchChunkSync(archive, index))
+                        return 0;
+                    chunk = archive.chunks[index];
+                }
+                var start = pos - index * DMARCHIVE.CHUNK_SIZE;
+                var count = Math.min(size - written, chunk.length - start);
+                if (count <= 0)
+                    return 0;
+                HEAPU8.set(chunk.subarray(start, start + count), dst + written);
+                written += count;
+            }
+            return 1;
+        }
+};
+autoAddDeps(LibraryDmResourceArchive, '$DMARCHIVE');
+mergeInto(LibraryManager.library, LibraryDmResourceArchive);
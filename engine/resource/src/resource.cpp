@@ -33,6 +33,7 @@
 #include <dlib/dstrings.h>
 #include <dlib/crypt.h>
 #include <dlib/hash.h>
+#include <dlib/hashmap.h>
 #include <dlib/hashtable.h>
 #include <dlib/log.h>
 #include <dlib/http_client.h>
@@ -47,6 +48,8 @@
 #include <dlib/sys.h>
 #include <dlib/time.h>
 #include <dlib/mutex.h>
+#include <dlib/condition_variable.h>
+#include <dlib/atomic.h>
 
 #include "resource.h"
 #include "resource_private.h"
@@ -85,10 +88,25 @@ struct ResourceReloadedCallbackPair
     void*                       m_UserData;
 };
 
+// Max number of concurrent requests to the http server
+static const uint32_t MAX_HTTP_CONNECTIONS = 8;
+
+struct HttpConnection
+{
+    dmHttpClient::HClient   m_Client;
+    LoadBufferType*         m_Buffer;
+    // Total number bytes loaded in current GET-request
+    int32_t                 m_ContentLength;
+    uint32_t                m_TotalBytesStreamed;
+    int                     m_Status;
+    // The content is gzip or deflate encoded and Content-Length is the encoded size
+    bool                    m_ContentEncoded;
+};
+
 struct SResourceFactory
 {
     // TODO: Arg... budget. Two hash-maps. Really necessary?
-    dmHashTable<uint64_t, SResourceDescriptor>*  m_Resources;
+    dmHashMap<uint64_t, SResourceDescriptor>*    m_Resources;
     dmHashTable<uintptr_t, uint64_t>*            m_ResourceToHash;
     // Only valid if RESOURCE_FACTORY_FLAGS_RELOAD_SUPPORT is set
     // Used for reloading of resources
@@ -99,9 +117,12 @@ struct SResourceFactory
     uint32_t                                     m_ResourceTypesCount;
 
     // Guard for anything that touches anything that could be shared
-    // with GetRaw (used for async threaded loading). Liveupdate, HttpClient, m_Buffer
+    // with GetRaw (used for async threaded loading). Liveupdate, m_Buffer
     // m_BuiltinsManifest, m_Manifest
     dmMutex::HMutex                              m_LoadMutex;
+    // Guard for the archive file reads. Taken by ReadResourcePartial instead of m_LoadMutex,
+    // since it is called from other threads that the loading might be waiting for
+    dmMutex::HMutex                              m_ArchiveReadMutex;
 
     // dmResource::Get recursion depth
     uint32_t                                     m_RecursionDepth;
@@ -111,19 +132,16 @@ struct SResourceFactory
     dmMessage::HSocket                           m_Socket;
 
     dmURI::Parts                                 m_UriParts;
-    dmHttpClient::HClient                        m_HttpClient;
     dmHttpCache::HCache                          m_HttpCache;
-    LoadBufferType*                              m_HttpBuffer;
+    // Keep-alive connections to the http server. Loader threads fetch in parallel, each
+    // using a free connection. Guarded by m_HttpMutex
+    dmArray<HttpConnection*>                     m_HttpConnections;
+    dmArray<HttpConnection*>                     m_HttpFreeConnections;
+    dmMutex::HMutex                              m_HttpMutex;
+    dmConditionVariable::HConditionVariable      m_HttpConnectionFree;
 
     dmArray<char>                                m_Buffer;
 
-    // HTTP related state
-    // Total number bytes loaded in current GET-request
-    int32_t                                      m_HttpContentLength;
-    uint32_t                                     m_HttpTotalBytesStreamed;
-    int                                          m_HttpStatus;
-    Result                                       m_HttpFactoryResult;
-
     // Manifest for builtin resources
     Manifest*                                    m_BuiltinsManifest;
 
@@ -131,6 +149,32 @@ struct SResourceFactory
     Manifest*                                    m_Manifest;
     void*                                        m_ArchiveMountInfo;
 
+    // Number of threads used by the async load queue
+    uint32_t                                     m_LoaderThreadCount;
+
+    // Only valid if NewFactoryParams::m_LoadOrderPath is set
+    // Resources are recorded the first time they are loaded, guarded by m_LoadMutex
+    FILE*                                        m_LoadOrderFile;
+    dmHashTable64<bool>*                         m_LoadOrderRecorded;
+
+    // Released resources (reference count 0) that are kept resident, least recently released first.
+    // They are revived by Get and destroyed when m_ColdCacheUsed exceeds m_ColdCacheBudget
+    dmArray<uint64_t>                            m_ColdResources;
+    uint32_t                                     m_ColdCacheBudget;
+    uint32_t                                     m_ColdCacheUsed;
+    // Number of revived resources since the last UpdateFactory, for the profiler
+    uint32_t                                     m_ColdCacheHits;
+
+    // Loads in flight of all the preloaders, limited by m_PreloadBudget unless it is 0
+    uint32_t                                     m_PreloadBudget;
+    uint32_t                                     m_PreloadsInFlight;
+
+    // Preloaders started by Prefetch, advanced one at a time by UpdateFactory
+    dmArray<HPreloader>                          m_Prefetches;
+
+    FResourceLoadedCallback                      m_ResourceLoadedCallback;
+    void*                                        m_ResourceLoadedCallbackUserData;
+
     uint8_t                                      m_UseLiveUpdate : 1;
 };
 
@@ -192,6 +236,10 @@ void SetDefaultNewFactoryParams(struct NewFactoryParams* params)
 {
     params->m_MaxResources = 1024;
     params->m_Flags = RESOURCE_FACTORY_FLAGS_EMPTY;
+    params->m_LoaderThreadCount = 0;
+    params->m_LoadOrderPath = 0;
+    params->m_ColdCacheSize = 0;
+    params->m_PreloadBudget = 0;
 
     params->m_ArchiveManifest.m_Data = 0;
     params->m_ArchiveManifest.m_Size = 0;
@@ -203,45 +251,114 @@ void SetDefaultNewFactoryParams(struct NewFactoryParams* params)
 
 static void HttpHeader(dmHttpClient::HResponse response, void* user_data, int status_code, const char* key, const char* value)
 {
-    SResourceFactory* factory = (SResourceFactory*) user_data;
-    factory->m_HttpStatus = status_code;
+    HttpConnection* connection = (HttpConnection*) user_data;
+    connection->m_Status = status_code;
 
     if (dmStrCaseCmp(key, "Content-Length") == 0)
     {
-        factory->m_HttpContentLength = strtol(value, 0, 10);
-        if (factory->m_HttpContentLength < 0) {
-            dmLogError("Content-Length negative (%d)", factory->m_HttpContentLength);
+        connection->m_ContentLength = strtol(value, 0, 10);
+        if (connection->m_ContentLength < 0) {
+            dmLogError("Content-Length negative (%d)", connection->m_ContentLength);
         } else {
-            if (factory->m_HttpBuffer->Capacity() < (uint32_t)factory->m_HttpContentLength) {
-                factory->m_HttpBuffer->SetCapacity(factory->m_HttpContentLength);
+            if (connection->m_Buffer->Capacity() < (uint32_t)connection->m_ContentLength) {
+                connection->m_Buffer->SetCapacity(connection->m_ContentLength);
             }
-            factory->m_HttpBuffer->SetSize(0);
+            connection->m_Buffer->SetSize(0);
         }
     }
+    else if (dmStrCaseCmp(key, "Content-Encoding") == 0)
+    {
+        connection->m_ContentEncoded = true;
+    }
 }
 
 static void HttpContent(dmHttpClient::HResponse, void* user_data, int status_code, const void* content_data, uint32_t content_data_size)
 {
-    SResourceFactory* factory = (SResourceFactory*) user_data;
+    HttpConnection* connection = (HttpConnection*) user_data;
     (void) status_code;
 
     if (!content_data && content_data_size)
     {
-        factory->m_HttpBuffer->SetSize(0);
+        connection->m_Buffer->SetSize(0);
         return;
     }
 
     // We must set http-status here. For direct cached result HttpHeader is not called.
-    factory->m_HttpStatus = status_code;
+    connection->m_Status = status_code;
 
-    if (factory->m_HttpBuffer->Remaining() < content_data_size) {
-        uint32_t diff = content_data_size - factory->m_HttpBuffer->Remaining();
+    if (connection->m_Buffer->Remaining() < content_data_size) {
+        uint32_t diff = content_data_size - connection->m_Buffer->Remaining();
         // NOTE: Resizing the the array can be inefficient but sometimes we don't know the actual size, i.e. when "Content-Size" isn't set
-        factory->m_HttpBuffer->OffsetCapacity(diff + 1024 * 1024);
+        connection->m_Buffer->OffsetCapacity(diff + 1024 * 1024);
+    }
+
+    connection->m_Buffer->PushArray((const char*) content_data, content_data_size);
+    connection->m_TotalBytesStreamed += content_data_size;
+}
+
+static inline bool IsHttpFactory(HFactory factory)
+{
+    // Set once when the factory is created, unlike the connection arrays
+    return factory->m_HttpMutex != 0;
+}
+
+static HttpConnection* NewHttpConnection(HFactory factory)
+{
+    HttpConnection* connection = new HttpConnection;
+    memset(connection, 0, sizeof(*connection));
+
+    dmHttpClient::NewParams http_params;
+    http_params.m_HttpHeader = &HttpHeader;
+    http_params.m_HttpContent = &HttpContent;
+    http_params.m_Userdata = connection;
+    http_params.m_HttpCache = factory->m_HttpCache;
+    http_params.m_DecodeContent = 1;
+    connection->m_Client = dmHttpClient::New(&http_params, factory->m_UriParts.m_Hostname, factory->m_UriParts.m_Port, strcmp(factory->m_UriParts.m_Scheme, "https") == 0, 0);
+    if (!connection->m_Client)
+    {
+        delete connection;
+        return 0;
+    }
+    return connection;
+}
+
+static void DeleteHttpConnections(HFactory factory)
+{
+    for (uint32_t i = 0; i < factory->m_HttpConnections.Size(); ++i)
+    {
+        dmHttpClient::Delete(factory->m_HttpConnections[i]->m_Client);
+        delete factory->m_HttpConnections[i];
     }
+    factory->m_HttpConnections.SetSize(0);
+    factory->m_HttpFreeConnections.SetSize(0);
+}
 
-    factory->m_HttpBuffer->PushArray((const char*) content_data, content_data_size);
-    factory->m_HttpTotalBytesStreamed += content_data_size;
+// Takes a free connection, creating one if the limit isn't reached, or waits for one to be released
+static HttpConnection* AcquireHttpConnection(HFactory factory)
+{
+    DM_MUTEX_SCOPED_LOCK(factory->m_HttpMutex);
+    while (factory->m_HttpFreeConnections.Empty())
+    {
+        if (factory->m_HttpConnections.Size() < MAX_HTTP_CONNECTIONS)
+        {
+            HttpConnection* connection = NewHttpConnection(factory);
+            if (connection)
+            {
+                factory->m_HttpConnections.Push(connection);
+                return connection;
+            }
+            // The first connection was created with the factory, so there is always one to wait for
+        }
+        dmConditionVariable::Wait(factory->m_HttpConnectionFree, factory->m_HttpMutex);
+    }
+    return factory->m_HttpFreeConnections.Pop();
+}
+
+static void ReleaseHttpConnection(HFactory factory, HttpConnection* connection)
+{
+    DM_MUTEX_SCOPED_LOCK(factory->m_HttpMutex);
+    factory->m_HttpFreeConnections.Push(connection);
+    dmConditionVariable::Signal(factory->m_HttpConnectionFree);
 }
 
 Manifest* GetManifest(HFactory factory)
@@ -456,6 +573,10 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
     memset(factory, 0, sizeof(*factory));
     factory->m_Socket = socket;
     factory->m_UseLiveUpdate = params->m_Flags & RESOURCE_FACTORY_FLAGS_LIVE_UPDATE ? 1 : 0;
+    factory->m_LoaderThreadCount = params->m_LoaderThreadCount;
+    factory->m_ColdCacheBudget = params->m_ColdCacheSize;
+    factory->m_PreloadBudget = params->m_PreloadBudget;
+    factory->m_PreloadsInFlight = 0;
 
     dmURI::Result uri_result = dmURI::Parse(uri, &factory->m_UriParts);
     if (uri_result != dmURI::RESULT_OK)
@@ -466,8 +587,8 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
         return 0;
     }
 
-    factory->m_HttpBuffer = 0;
-    factory->m_HttpClient = 0;
+    factory->m_HttpMutex = 0;
+    factory->m_HttpConnectionFree = 0;
     factory->m_HttpCache = 0;
     if (strcmp(factory->m_UriParts.m_Scheme, "http") == 0 || strcmp(factory->m_UriParts.m_Scheme, "https") == 0)
     {
@@ -489,7 +610,13 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
                 }
                 else
                 {
-                    dmHttpCacheVerify::Result verify_r = dmHttpCacheVerify::VerifyCache(factory->m_HttpCache, &factory->m_UriParts, 60 * 60 * 24 * 5); // 5 days
+                    // A manifest of the content hashes on the server verifies the whole cache with a single request,
+                    // and lets resources with unchanged content be served from disk without any round-trip
+                    dmHttpCacheVerify::Result verify_r = dmHttpCacheVerify::VerifyCacheContent(factory->m_HttpCache, &factory->m_UriParts);
+                    if (verify_r == dmHttpCacheVerify::RESULT_UNSUPPORTED)
+                    {
+                        verify_r = dmHttpCacheVerify::VerifyCache(factory->m_HttpCache, &factory->m_UriParts, 60 * 60 * 24 * 5); // 5 days
+                    }
                     // Http-cache batch verification might be unsupported
                     // We currently does not have support for batch validation in the editor http-server
                     // Batch validation was introduced when we had remote branch and latency problems
@@ -507,19 +634,24 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
             }
         }
 
-        dmHttpClient::NewParams http_params;
-        http_params.m_HttpHeader = &HttpHeader;
-        http_params.m_HttpContent = &HttpContent;
-        http_params.m_Userdata = factory;
-        http_params.m_HttpCache = factory->m_HttpCache;
-        factory->m_HttpClient = dmHttpClient::New(&http_params, factory->m_UriParts.m_Hostname, factory->m_UriParts.m_Port, strcmp(factory->m_UriParts.m_Scheme, "https") == 0, 0);
-        if (!factory->m_HttpClient)
+        HttpConnection* connection = NewHttpConnection(factory);
+        if (!connection)
         {
             dmLogError("Invalid URI: %s", uri);
+            if (factory->m_HttpCache)
+            {
+                dmHttpCache::Close(factory->m_HttpCache);
+            }
             dmMessage::DeleteSocket(socket);
             delete factory;
             return 0;
         }
+        factory->m_HttpConnections.SetCapacity(MAX_HTTP_CONNECTIONS);
+        factory->m_HttpFreeConnections.SetCapacity(MAX_HTTP_CONNECTIONS);
+        factory->m_HttpConnections.Push(connection);
+        factory->m_HttpFreeConnections.Push(connection);
+        factory->m_HttpMutex = dmMutex::New();
+        factory->m_HttpConnectionFree = dmConditionVariable::New();
     }
     else if (strcmp(factory->m_UriParts.m_Scheme, "file") == 0
 #if defined(__NX__)
@@ -613,8 +745,8 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
     factory->m_ResourceTypesCount = 0;
 
     const uint32_t table_size = dmMath::Max(1u, (3 * params->m_MaxResources) / 4);
-    factory->m_Resources = new dmHashTable<uint64_t, SResourceDescriptor>();
-    factory->m_Resources->SetCapacity(table_size, params->m_MaxResources);
+    factory->m_Resources = new dmHashMap<uint64_t, SResourceDescriptor>();
+    factory->m_Resources->SetCapacity(params->m_MaxResources);
 
     factory->m_ResourceToHash = new dmHashTable<uintptr_t, uint64_t>();
     factory->m_ResourceToHash->SetCapacity(table_size, params->m_MaxResources);
@@ -653,7 +785,23 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
         }
     }
 
+    if (params->m_LoadOrderPath)
+    {
+        factory->m_LoadOrderFile = fopen(params->m_LoadOrderPath, "wb");
+        if (factory->m_LoadOrderFile)
+        {
+            factory->m_LoadOrderRecorded = new dmHashTable64<bool>();
+            factory->m_LoadOrderRecorded->SetCapacity(table_size, params->m_MaxResources);
+            dmLogInfo("Recording resource load order to: %s", params->m_LoadOrderPath);
+        }
+        else
+        {
+            dmLogWarning("Unable to open '%s' for recording the resource load order", params->m_LoadOrderPath);
+        }
+    }
+
     factory->m_LoadMutex = dmMutex::New();
+    factory->m_ArchiveReadMutex = dmMutex::New();
     return factory;
 }
 
@@ -664,13 +812,27 @@ static void ResourceIteratorCallback(void*, const dmhash_t* id, SResourceDescrip
 
 void DeleteFactory(HFactory factory)
 {
+    for (uint32_t i = 0; i < factory->m_Prefetches.Size(); ++i)
+    {
+        DeletePreloader(factory->m_Prefetches[i]);
+    }
+    factory->m_Prefetches.SetCapacity(0);
+
+    // Resources released while destroying the cached ones are destroyed directly
+    SetColdCacheSize(factory, 0);
+
     if (factory->m_Socket)
     {
         dmMessage::DeleteSocket(factory->m_Socket);
     }
-    if (factory->m_HttpClient)
+    DeleteHttpConnections(factory);
+    if (factory->m_HttpMutex)
     {
-        dmHttpClient::Delete(factory->m_HttpClient);
+        dmMutex::Delete(factory->m_HttpMutex);
+    }
+    if (factory->m_HttpConnectionFree)
+    {
+        dmConditionVariable::Delete(factory->m_HttpConnectionFree);
     }
     if (factory->m_HttpCache)
     {
@@ -680,6 +842,10 @@ void DeleteFactory(HFactory factory)
     {
         dmMutex::Delete(factory->m_LoadMutex);
     }
+    if (factory->m_ArchiveReadMutex)
+    {
+        dmMutex::Delete(factory->m_ArchiveReadMutex);
+    }
 
     if (factory->m_Manifest)
     {
@@ -694,6 +860,12 @@ void DeleteFactory(HFactory factory)
 
     ReleaseBuiltinsManifest(factory);
 
+    if (factory->m_LoadOrderFile)
+    {
+        fclose(factory->m_LoadOrderFile);
+        delete factory->m_LoadOrderRecorded;
+    }
+
     if (!factory->m_Resources->Empty())
     {
         dmLogError("Leaked resources:");
@@ -741,9 +913,43 @@ static void Dispatch(dmMessage::Message* message, void* user_ptr)
     }
 }
 
+// Kept below a millisecond so that UpdatePreloader never sleeps on the main thread
+static const uint32_t PREFETCH_TIME_SLICE_US = 500;
+
+static void UpdatePrefetches(HFactory factory)
+{
+    if (factory->m_Prefetches.Empty())
+        return;
+
+    DM_PROFILE(Resource, "Prefetch");
+    HPreloader preloader = factory->m_Prefetches[0];
+    if (UpdatePreloader(preloader, 0, 0, PREFETCH_TIME_SLICE_US) != RESULT_PENDING)
+    {
+        // Releases the resources into the cold cache, where Get revives them
+        DeletePreloader(preloader);
+        // Keep the requested order
+        uint32_t count = factory->m_Prefetches.Size();
+        for (uint32_t i = 1; i < count; ++i)
+        {
+            factory->m_Prefetches[i - 1] = factory->m_Prefetches[i];
+        }
+        factory->m_Prefetches.SetSize(count - 1);
+    }
+}
+
 void UpdateFactory(HFactory factory)
 {
     dmMessage::Dispatch(factory->m_Socket, &Dispatch, factory);
+
+    UpdatePrefetches(factory);
+
+    if (factory->m_ColdCacheBudget)
+    {
+        DM_COUNTER("Resource.ColdCount", factory->m_ColdResources.Size());
+        DM_COUNTER("Resource.ColdMem (Kb)", factory->m_ColdCacheUsed / 1024);
+        DM_COUNTER("Resource.ColdHits", factory->m_ColdCacheHits);
+        factory->m_ColdCacheHits = 0;
+    }
 }
 
 Result RegisterType(HFactory factory,
@@ -777,12 +983,33 @@ Result RegisterType(HFactory factory,
     resource_type.m_PostCreateFunction = post_create_function;
     resource_type.m_DestroyFunction = destroy_function;
     resource_type.m_RecreateFunction = recreate_function;
+    resource_type.m_Flags = RESOURCE_TYPE_FLAGS_EMPTY;
 
     factory->m_ResourceTypes[factory->m_ResourceTypesCount++] = resource_type;
 
     return RESULT_OK;
 }
 
+Result SetTypeFlags(HFactory factory, const char* extension, uint32_t flags)
+{
+    SResourceType* resource_type = FindResourceType(factory, extension);
+    if (resource_type == 0)
+        return RESULT_UNKNOWN_RESOURCE_TYPE;
+
+    resource_type->m_Flags = flags;
+    return RESULT_OK;
+}
+
+Result SetPatchFunction(HFactory factory, const char* extension, FResourcePatch patch_function)
+{
+    SResourceType* resource_type = FindResourceType(factory, extension);
+    if (resource_type == 0)
+        return RESULT_UNKNOWN_RESOURCE_TYPE;
+
+    resource_type->m_PatchFunction = patch_function;
+    return RESULT_OK;
+}
+
 // Finds the specific entry in a sorted list of entries
 static int FindEntryIndex(const Manifest* manifest, dmhash_t path_hash)
 {
@@ -813,30 +1040,87 @@ static int FindEntryIndex(const Manifest* manifest, dmhash_t path_hash)
     return -1;
 }
 
-Result VerifyResourcesBundled(dmLiveUpdateDDF::ResourceEntry* entries, uint32_t num_entries, uint32_t hash_len, dmResourceArchive::HArchiveIndexContainer archive)
+static void LogResourceNotBundled(const dmLiveUpdateDDF::ResourceEntry* entry, uint32_t hash_len)
+{
+    char hash_buffer[64*2+1]; // String repr. of project id SHA1 hash
+    BytesToHexString(entry->m_Hash.m_Data.m_Data, hash_len, hash_buffer, sizeof(hash_buffer));
+
+    // Manifest expect the resource to be bundled, but it is not in the archive index.
+    dmLogError("Resource '%s' (%s) is expected to be in the bundle was not found.\nResource was modified between publishing the bundle and publishing the manifest?", entry->m_Url, hash_buffer);
+}
+
+// Entries per verification job
+static const uint32_t VERIFY_BUNDLED_BATCH_SIZE = 256;
+
+struct VerifyBundledContext
+{
+    dmLiveUpdateDDF::ResourceEntry*             m_Entries;
+    uint32_t                                    m_HashLen;
+    dmResourceArchive::HArchiveIndexContainer   m_Archive;
+    // Lowest index of a missing entry, or num_entries if all were found
+    int32_atomic_t                              m_FirstMissing;
+};
+
+static void VerifyBundledRange(void* _ctx, uint32_t start, uint32_t end)
 {
-    for(uint32_t i = 0; i < num_entries; ++i)
+    VerifyBundledContext* ctx = (VerifyBundledContext*) _ctx;
+    for (uint32_t i = start; i < end; ++i)
     {
-        if (entries[i].m_Flags == dmLiveUpdateDDF::BUNDLED)
+        // No need to look further if an earlier entry is already missing
+        int32_t first_missing = dmAtomicAdd32(&ctx->m_FirstMissing, 0);
+        if ((int32_t) i >= first_missing)
+            return;
+
+        if (ctx->m_Entries[i].m_Flags != dmLiveUpdateDDF::BUNDLED)
+            continue;
+
+        uint8_t* hash = ctx->m_Entries[i].m_Hash.m_Data.m_Data;
+        if (dmResourceArchive::FindEntry(ctx->m_Archive, hash, ctx->m_HashLen, 0x0, 0x0) == dmResourceArchive::RESULT_NOT_FOUND)
         {
-            uint8_t* hash = entries[i].m_Hash.m_Data.m_Data;
-            dmResourceArchive::Result res = dmResourceArchive::FindEntry(archive, hash, hash_len, 0x0, 0x0);
-            if (res == dmResourceArchive::RESULT_NOT_FOUND)
+            while ((int32_t) i < first_missing)
             {
-                char hash_buffer[64*2+1]; // String repr. of project id SHA1 hash
-                BytesToHexString(hash, hash_len, hash_buffer, sizeof(hash_buffer));
-
-                // Manifest expect the resource to be bundled, but it is not in the archive index.
-                dmLogError("Resource '%s' (%s) is expected to be in the bundle was not found.\nResource was modified between publishing the bundle and publishing the manifest?", entries[i].m_Url, hash_buffer);
-                return RESULT_INVALID_DATA;
+                int32_t prev = dmAtomicCompareStore32(&ctx->m_FirstMissing, (int32_t) i, first_missing);
+                if (prev == first_missing)
+                    break;
+                first_missing = prev;
             }
+            return;
         }
     }
+}
+
+Result VerifyResourcesBundled(dmLiveUpdateDDF::ResourceEntry* entries, uint32_t num_entries, uint32_t hash_len, dmResourceArchive::HArchiveIndexContainer archive, dmJob::HContext job_context)
+{
+    DM_PROFILE(Resource, "VerifyResourcesBundled");
+    VerifyBundledContext ctx;
+    ctx.m_Entries = entries;
+    ctx.m_HashLen = hash_len;
+    ctx.m_Archive = archive;
+    ctx.m_FirstMissing = (int32_t) num_entries;
+
+    // Runs the whole range on the calling thread if there is no job context
+    dmJob::HJob job = dmJob::ParallelFor(job_context, VerifyBundledRange, &ctx, num_entries, VERIFY_BUNDLED_BATCH_SIZE, dmJob::INVALID_JOB);
+    if (job != dmJob::INVALID_JOB)
+    {
+        dmJob::Wait(job_context, job);
+    }
+
+    uint32_t first_missing = (uint32_t) ctx.m_FirstMissing;
+    if (first_missing < num_entries)
+    {
+        LogResourceNotBundled(&entries[first_missing], hash_len);
+        return RESULT_INVALID_DATA;
+    }
 
     return RESULT_OK;
 }
 
-Result VerifyResourcesBundled(dmResourceArchive::HArchiveIndexContainer base_archive, const Manifest* manifest)
+Result VerifyResourcesBundled(dmLiveUpdateDDF::ResourceEntry* entries, uint32_t num_entries, uint32_t hash_len, dmResourceArchive::HArchiveIndexContainer archive)
+{
+    return VerifyResourcesBundled(entries, num_entries, hash_len, archive, 0);
+}
+
+Result VerifyResourcesBundled(dmResourceArchive::HArchiveIndexContainer base_archive, const Manifest* manifest, dmJob::HContext job_context)
 {
     uint32_t entry_count = manifest->m_DDFData->m_Resources.m_Count;
     dmLiveUpdateDDF::ResourceEntry* entries = manifest->m_DDFData->m_Resources.m_Data;
@@ -844,10 +1128,16 @@ Result VerifyResourcesBundled(dmResourceArchive::HArchiveIndexContainer base_arc
     dmLiveUpdateDDF::HashAlgorithm algorithm = manifest->m_DDFData->m_Header.m_ResourceHashAlgorithm;
     uint32_t hash_len = dmResource::HashLength(algorithm);
 
-    return VerifyResourcesBundled(entries, entry_count, hash_len, base_archive);
+    return VerifyResourcesBundled(entries, entry_count, hash_len, base_archive, job_context);
 }
 
-static Result LoadFromManifest(const Manifest* manifest, const char* path, uint32_t* resource_size, LoadBufferType* buffer)
+Result VerifyResourcesBundled(dmResourceArchive::HArchiveIndexContainer base_archive, const Manifest* manifest)
+{
+    return VerifyResourcesBundled(base_archive, manifest, 0);
+}
+
+// If mapped_data is supplied, entries that can be used directly from a memory mapped archive are returned in it instead of being read into the buffer
+static Result LoadFromManifest(const Manifest* manifest, const char* path, uint32_t* resource_size, LoadBufferType* buffer, PendingDecode* decode, const void** mapped_data)
 {
     dmhash_t path_hash = dmHashString64(path);
 
@@ -866,12 +1156,45 @@ static Result LoadFromManifest(const Manifest* manifest, const char* path, uint3
     if (res == dmResourceArchive::RESULT_OK)
     {
         uint32_t file_size = ed.m_ResourceSize;
+        if (mapped_data)
+        {
+            *mapped_data = dmResourceArchive::GetMappedEntryData(archive, &ed);
+            if (*mapped_data)
+            {
+                buffer->SetSize(0);
+                *resource_size = file_size;
+                return RESULT_OK;
+            }
+        }
+
         if (buffer->Capacity() < file_size)
         {
             buffer->SetCapacity(file_size);
         }
 
         buffer->SetSize(0);
+
+        if (decode && dmResourceArchive::IsEntryEncoded(&ed) && dmResourceArchive::HasDefaultReader(archive))
+        {
+            // Only read the stored data here, the decoding is done by the caller without the load mutex held
+            uint32_t data_size = dmResourceArchive::GetEntryDataSize(&ed);
+            if (decode->m_Data->Capacity() < data_size)
+            {
+                decode->m_Data->SetCapacity(data_size);
+            }
+            decode->m_Data->SetSize(0);
+            if (dmResourceArchive::ReadEntryDataFromArchive(archive, &ed, decode->m_Data->Begin()) != dmResourceArchive::RESULT_OK)
+            {
+                return RESULT_IO_ERROR;
+            }
+            decode->m_Data->SetSize(data_size);
+            decode->m_Entry = ed;
+            decode->m_Archive = archive;
+            decode->m_Pending = true;
+            *resource_size = file_size;
+            return RESULT_OK;
+        }
+
         dmResourceArchive::Result read_result = dmResourceArchive::Read(archive, hash, hash_len, &ed, buffer->Begin());
         if (read_result != dmResourceArchive::RESULT_OK)
         {
@@ -885,74 +1208,117 @@ static Result LoadFromManifest(const Manifest* manifest, const char* path, uint3
     }
     else if (res == dmResourceArchive::RESULT_NOT_FOUND)
     {
-        // Resource was found in manifest, but not in archive
+        // Resource was found in manifest, but not in archive. If the bundled resources weren't verified
+        // at startup, this is where a manifest referencing resources missing from the bundle shows up
+        if (entries[index].m_Flags == dmLiveUpdateDDF::BUNDLED)
+        {
+            LogResourceNotBundled(&entries[index], hash_len);
+        }
         return RESULT_RESOURCE_NOT_FOUND;
     }
 
     return RESULT_IO_ERROR;
 }
 
-// Assumes m_LoadMutex is already held
-static Result DoLoadResourceLocked(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer)
+// Does not need m_LoadMutex, the request is made on a connection of its own
+static Result LoadFromHttp(HFactory factory, const char* factory_path, uint32_t* resource_size, LoadBufferType* buffer)
 {
-    DM_PROFILE(Resource, "LoadResource");
-    if (factory->m_BuiltinsManifest)
-    {
-        if (LoadFromManifest(factory->m_BuiltinsManifest, original_name, resource_size, buffer) == RESULT_OK)
+    *resource_size = 0;
+    HttpConnection* connection = AcquireHttpConnection(factory);
+    connection->m_Buffer = buffer;
+    connection->m_ContentLength = -1;
+    connection->m_TotalBytesStreamed = 0;
+    connection->m_Status = -1;
+    connection->m_ContentEncoded = false;
+
+    char uri[RESOURCE_PATH_MAX*2];
+    dmURI::Encode(factory_path, uri, sizeof(uri), 0);
+
+    dmHttpClient::Result http_result = dmHttpClient::Get(connection->m_Client, uri);
+    int status = connection->m_Status;
+    int32_t content_length = connection->m_ContentLength;
+    uint32_t total_bytes_streamed = connection->m_TotalBytesStreamed;
+    bool content_encoded = connection->m_ContentEncoded;
+    connection->m_Buffer = 0;
+    ReleaseHttpConnection(factory, connection);
+
+    if (http_result != dmHttpClient::RESULT_OK)
+    {
+        if (status == 404)
         {
-            return RESULT_OK;
+            return RESULT_RESOURCE_NOT_FOUND;
+        }
+        else
+        {
+            // 304 (NOT MODIFIED) is OK. 304 is returned when the resource is loaded from cache, ie ETag or similar match
+            if (http_result == dmHttpClient::RESULT_NOT_200_OK && status != 304)
+            {
+                dmLogWarning("Unexpected http status code: %d", status);
+                return RESULT_IO_ERROR;
+            }
         }
     }
 
-    char factory_path[RESOURCE_PATH_MAX];
-    GetCanonicalPathFromBase(factory->m_UriParts.m_Path, path, factory_path);
-    // NOTE: No else if here. Fall through
-    if (factory->m_HttpClient)
+    // Only check content-length if status != 304 (NOT MODIFIED) and the content wasn't decoded
+    if (status != 304 && !content_encoded && content_length != -1 && content_length != (int32_t)total_bytes_streamed)
     {
-        // Load over HTTP
-        *resource_size = 0;
-        factory->m_HttpBuffer = buffer;
-        factory->m_HttpContentLength = -1;
-        factory->m_HttpTotalBytesStreamed = 0;
-        factory->m_HttpFactoryResult = RESULT_OK;
-        factory->m_HttpStatus = -1;
+        dmLogError("Expected content length differs from actually streamed for resource %s (%d != %d)", factory_path, content_length, total_bytes_streamed);
+    }
 
-        char uri[RESOURCE_PATH_MAX*2];
-        dmURI::Encode(factory_path, uri, sizeof(uri), 0);
+    *resource_size = total_bytes_streamed;
+    return RESULT_OK;
+}
 
-        dmHttpClient::Result http_result = dmHttpClient::Get(factory->m_HttpClient, uri);
-        if (http_result != dmHttpClient::RESULT_OK)
-        {
-            if (factory->m_HttpStatus == 404)
-            {
-                return RESULT_RESOURCE_NOT_FOUND;
-            }
-            else
-            {
-                // 304 (NOT MODIFIED) is OK. 304 is returned when the resource is loaded from cache, ie ETag or similar match
-                if (http_result == dmHttpClient::RESULT_NOT_200_OK && factory->m_HttpStatus != 304)
-                {
-                    dmLogWarning("Unexpected http status code: %d", factory->m_HttpStatus);
-                    return RESULT_IO_ERROR;
-                }
-            }
-        }
+// Assumes m_LoadMutex is already held
+static void RecordLoadOrder(HFactory factory, const char* name)
+{
+    dmhash_t name_hash = dmHashString64(name);
+    if (factory->m_LoadOrderRecorded->Get(name_hash))
+    {
+        return;
+    }
+    if (factory->m_LoadOrderRecorded->Full())
+    {
+        uint32_t capacity = factory->m_LoadOrderRecorded->Capacity() + 1024;
+        factory->m_LoadOrderRecorded->SetCapacity((3 * capacity) / 4, capacity);
+    }
+    factory->m_LoadOrderRecorded->Put(name_hash, true);
 
-        if (factory->m_HttpFactoryResult != RESULT_OK)
-            return factory->m_HttpFactoryResult;
+    // Flushed per entry so that the order recorded so far survives the app being killed
+    fprintf(factory->m_LoadOrderFile, "%s\n", name);
+    fflush(factory->m_LoadOrderFile);
+}
 
-        // Only check content-length if status != 304 (NOT MODIFIED)
-        if (factory->m_HttpStatus != 304 && factory->m_HttpContentLength != -1 && factory->m_HttpContentLength != (int32_t)factory->m_HttpTotalBytesStreamed)
+// Assumes m_LoadMutex is already held
+static Result DoLoadResourceLockedInternal(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer, PendingDecode* decode, const void** mapped_data)
+{
+    if (mapped_data)
+    {
+        *mapped_data = 0;
+    }
+    if (factory->m_BuiltinsManifest)
+    {
+        DM_MUTEX_SCOPED_LOCK(factory->m_ArchiveReadMutex);
+        if (LoadFromManifest(factory->m_BuiltinsManifest, original_name, resource_size, buffer, decode, mapped_data) == RESULT_OK)
         {
-            dmLogError("Expected content length differs from actually streamed for resource %s (%d != %d)", factory_path, factory->m_HttpContentLength, factory->m_HttpTotalBytesStreamed);
+            return RESULT_OK;
         }
+    }
 
-        *resource_size = factory->m_HttpTotalBytesStreamed;
-        return RESULT_OK;
+    char factory_path[RESOURCE_PATH_MAX];
+    GetCanonicalPathFromBase(factory->m_UriParts.m_Path, path, factory_path);
+    // NOTE: No else if here. Fall through
+    if (IsHttpFactory(factory))
+    {
+        return LoadFromHttp(factory, factory_path, resource_size, buffer);
     }
     else if (factory->m_Manifest)
     {
-        Result r = LoadFromManifest(factory->m_Manifest, original_name, resource_size, buffer);
+        Result r;
+        {
+            DM_MUTEX_SCOPED_LOCK(factory->m_ArchiveReadMutex);
+            r = LoadFromManifest(factory->m_Manifest, original_name, resource_size, buffer, decode, mapped_data);
+        }
         return r;
     }
     else
@@ -996,24 +1362,98 @@ static Result DoLoadResourceLocked(HFactory factory, const char* path, const cha
     }
 }
 
+// Assumes m_LoadMutex is already held
+static Result DoLoadResourceLocked(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer, PendingDecode* decode, const void** mapped_data)
+{
+    DM_PROFILE(Resource, "LoadResource");
+    Result r = DoLoadResourceLockedInternal(factory, path, original_name, resource_size, buffer, decode, mapped_data);
+    if (r == RESULT_OK && factory->m_LoadOrderFile)
+    {
+        RecordLoadOrder(factory, original_name);
+    }
+    return r;
+}
+
+// Http factories have no liveupdate or archive state to protect, so the loader threads
+// only take the lock for recording the load order and can fetch in parallel
+static Result DoLoadResourceHttp(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer, PendingDecode* decode, const void** mapped_data)
+{
+    DM_PROFILE(Resource, "LoadResource");
+    Result r = DoLoadResourceLockedInternal(factory, path, original_name, resource_size, buffer, decode, mapped_data);
+    if (r == RESULT_OK && factory->m_LoadOrderFile)
+    {
+        dmMutex::ScopedLock lk(factory->m_LoadMutex);
+        RecordLoadOrder(factory, original_name);
+    }
+    return r;
+}
+
 // Takes the lock.
 Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer)
 {
+    if (IsHttpFactory(factory))
+    {
+        return DoLoadResourceHttp(factory, path, original_name, resource_size, buffer, 0, 0);
+    }
     // Called from async queue so we wrap around a lock
     dmMutex::ScopedLock lk(factory->m_LoadMutex);
-    return DoLoadResourceLocked(factory, path, original_name, resource_size, buffer);
+    return DoLoadResourceLocked(factory, path, original_name, resource_size, buffer, 0, 0);
+}
+
+Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer, PendingDecode* decode, const void** mapped_data)
+{
+    decode->m_Pending = false;
+    if (IsHttpFactory(factory))
+    {
+        return DoLoadResourceHttp(factory, path, original_name, resource_size, buffer, decode, mapped_data);
+    }
+    // Called from async queue so we wrap around a lock
+    dmMutex::ScopedLock lk(factory->m_LoadMutex);
+    return DoLoadResourceLocked(factory, path, original_name, resource_size, buffer, decode, mapped_data);
+}
+
+Result DecodeResource(PendingDecode* decode, LoadBufferType* buffer)
+{
+    DM_PROFILE(Resource, "DecodeResource");
+    assert(decode->m_Pending);
+    decode->m_Pending = false;
+
+    uint32_t file_size = decode->m_Entry.m_ResourceSize;
+    if (buffer->Capacity() < file_size)
+    {
+        buffer->SetCapacity(file_size);
+    }
+    buffer->SetSize(0);
+
+    dmResourceArchive::Result r = dmResourceArchive::DecodeEntryData(decode->m_Archive, &decode->m_Entry, decode->m_Data->Begin(), buffer->Begin());
+    decode->m_Data->SetSize(0);
+    if (r != dmResourceArchive::RESULT_OK)
+    {
+        return RESULT_IO_ERROR;
+    }
+    buffer->SetSize(file_size);
+    return RESULT_OK;
 }
 
 // Assumes m_LoadMutex is already held
 Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size)
+{
+    return LoadResource(factory, path, original_name, buffer, resource_size, 0);
+}
+
+// Assumes m_LoadMutex is already held
+Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size, bool* is_mapped)
 {
     if (factory->m_Buffer.Capacity() != DEFAULT_BUFFER_SIZE) {
         factory->m_Buffer.SetCapacity(DEFAULT_BUFFER_SIZE);
     }
     factory->m_Buffer.SetSize(0);
-    Result r = DoLoadResourceLocked(factory, path, original_name, resource_size, &factory->m_Buffer);
+    const void* mapped_data = 0;
+    Result r = DoLoadResourceLocked(factory, path, original_name, resource_size, &factory->m_Buffer, 0, is_mapped ? &mapped_data : 0);
+    if (is_mapped)
+        *is_mapped = r == RESULT_OK && mapped_data != 0;
     if (r == RESULT_OK)
-        *buffer = factory->m_Buffer.Begin();
+        *buffer = mapped_data ? (void*)mapped_data : factory->m_Buffer.Begin();
     else
         *buffer = 0;
     return r;
@@ -1034,6 +1474,66 @@ static const char* GetExtFromPath(const char* name, char* buffer, uint32_t buffe
     return 0;
 }
 
+static void DestroyResource(HFactory factory, uint64_t resource_hash, SResourceDescriptor* rd)
+{
+    SResourceType* resource_type = (SResourceType*) rd->m_ResourceType;
+
+    DM_PROFILE_DYN(ResourceRelease, resource_type->m_Extension, resource_type->m_ExtensionHash);
+
+    ResourceDestroyParams params;
+    params.m_Factory = factory;
+    params.m_Context = resource_type->m_Context;
+    params.m_Resource = rd;
+    resource_type->m_DestroyFunction(params);
+
+    factory->m_ResourceToHash->Erase((uintptr_t) rd->m_Resource);
+    factory->m_Resources->Erase(resource_hash);
+    if (factory->m_ResourceHashToFilename)
+    {
+        const char** s = factory->m_ResourceHashToFilename->Get(resource_hash);
+        factory->m_ResourceHashToFilename->Erase(resource_hash);
+        assert(s);
+        free((void*) *s);
+    }
+}
+
+static void RemoveColdResource(HFactory factory, uint32_t index, SResourceDescriptor* rd)
+{
+    uint64_t* cold = factory->m_ColdResources.Begin();
+    memmove(cold + index, cold + index + 1, (factory->m_ColdResources.Size() - index - 1) * sizeof(uint64_t));
+    factory->m_ColdResources.SetSize(factory->m_ColdResources.Size() - 1);
+    factory->m_ColdCacheUsed -= rd->m_ResourceSize;
+}
+
+static void ReviveColdResource(HFactory factory, uint64_t resource_hash, SResourceDescriptor* rd)
+{
+    uint32_t size = factory->m_ColdResources.Size();
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        if (factory->m_ColdResources[i] == resource_hash)
+        {
+            RemoveColdResource(factory, i, rd);
+            ++factory->m_ColdCacheHits;
+            return;
+        }
+    }
+    assert(false && "Released resource not found in the cold cache");
+}
+
+// Destroys the least recently released resource. Returns false if the cold cache is empty
+static bool EvictOldestColdResource(HFactory factory)
+{
+    if (factory->m_ColdResources.Empty())
+        return false;
+
+    uint64_t resource_hash = factory->m_ColdResources[0];
+    SResourceDescriptor* rd = factory->m_Resources->Get(resource_hash);
+    assert(rd && rd->m_ReferenceCount == 0);
+    RemoveColdResource(factory, 0, rd);
+    DestroyResource(factory, resource_hash, rd);
+    return true;
+}
+
 // Assumes m_LoadMutex is already held
 static Result DoGet(HFactory factory, const char* name, void** resource)
 {
@@ -1050,7 +1550,7 @@ static Result DoGet(HFactory factory, const char* name, void** resource)
     uint64_t canonical_path_hash = dmHashBuffer64(canonical_path, strlen(canonical_path));
 
     // Try to get from already loaded resources
-    SResourceDescriptor* rd = factory->m_Resources->Get(canonical_path_hash);
+    SResourceDescriptor* rd = FindByHash(factory, canonical_path_hash);
     if (rd)
     {
         assert(factory->m_ResourceToHash->Get((uintptr_t) rd->m_Resource));
@@ -1059,7 +1559,7 @@ static Result DoGet(HFactory factory, const char* name, void** resource)
         return RESULT_OK;
     }
 
-    if (factory->m_Resources->Full())
+    if (factory->m_Resources->Full() && !EvictOldestColdResource(factory))
     {
         dmLogError("The max number of resources (%d) has been passed, tweak \"%s\" in the config file.", factory->m_Resources->Capacity(), MAX_RESOURCES_KEY);
         return RESULT_OUT_OF_RESOURCES;
@@ -1080,7 +1580,9 @@ static Result DoGet(HFactory factory, const char* name, void** resource)
 
         void *buffer;
         uint32_t file_size;
-        Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size);
+        bool is_mapped = false;
+        bool allow_mapped = (resource_type->m_Flags & RESOURCE_TYPE_FLAGS_MAPPED_BUFFER) != 0;
+        Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size, allow_mapped ? &is_mapped : 0);
         if (result != RESULT_OK) {
             if (result == RESULT_RESOURCE_NOT_FOUND) {
                 dmLogWarning("Resource not found: %s", name);
@@ -1088,7 +1590,7 @@ static Result DoGet(HFactory factory, const char* name, void** resource)
             return result;
         }
 
-        assert(buffer == factory->m_Buffer.Begin());
+        assert(is_mapped || buffer == factory->m_Buffer.Begin());
 
         // TODO: We should *NOT* allocate SResource dynamically...
         SResourceDescriptor tmp_resource;
@@ -1126,6 +1628,7 @@ static Result DoGet(HFactory factory, const char* name, void** resource)
             params.m_PreloadData = preload_data;
             params.m_Resource = &tmp_resource;
             params.m_Filename = name;
+            params.m_IsBufferMapped = is_mapped;
             create_error = resource_type->m_CreateFunction(params);
         }
 
@@ -1232,12 +1735,18 @@ Result Get(HFactory factory, const char* name, void** resource)
 
 SResourceDescriptor* FindByHash(HFactory factory, uint64_t canonical_path_hash)
 {
-    return factory->m_Resources->Get(canonical_path_hash);
+    SResourceDescriptor* rd = factory->m_Resources->Get(canonical_path_hash);
+    // The caller is about to reference the resource, so a released one is taken out of the cold cache
+    if (rd && rd->m_ReferenceCount == 0)
+    {
+        ReviveColdResource(factory, canonical_path_hash, rd);
+    }
+    return rd;
 }
 
 Result InsertResource(HFactory factory, const char* path, uint64_t canonical_path_hash, SResourceDescriptor* descriptor)
 {
-    if (factory->m_Resources->Full())
+    if (factory->m_Resources->Full() && !EvictOldestColdResource(factory))
     {
         dmLogError("The max number of resources (%d) has been passed, tweak \"%s\" in the config file.", factory->m_Resources->Capacity(), MAX_RESOURCES_KEY);
         return RESULT_OUT_OF_RESOURCES;
@@ -1255,6 +1764,11 @@ Result InsertResource(HFactory factory, const char* path, uint64_t canonical_pat
         factory->m_ResourceHashToFilename->Put(canonical_path_hash, strdup(canonical_path));
     }
 
+    if (factory->m_ResourceLoadedCallback)
+    {
+        factory->m_ResourceLoadedCallback(factory->m_ResourceLoadedCallbackUserData, path, descriptor->m_ResourceSizeOnDisc);
+    }
+
     return RESULT_OK;
 }
 
@@ -1290,6 +1804,157 @@ Result GetRaw(HFactory factory, const char* name, void** resource, uint32_t* res
     return result;
 }
 
+static Result PrefetchFromManifest(const Manifest* manifest, const char* path)
+{
+    int index = FindEntryIndex(manifest, dmHashString64(path));
+    if (index < 0) {
+        return RESULT_OK; // The load reports the error
+    }
+
+    dmLiveUpdateDDF::HashAlgorithm algorithm = manifest->m_DDFData->m_Header.m_ResourceHashAlgorithm;
+    dmLiveUpdateDDF::ResourceEntry* entries = manifest->m_DDFData->m_Resources.m_Data;
+    dmResourceArchive::EntryData ed;
+    dmResourceArchive::HArchiveIndexContainer archive;
+    uint8_t* hash = entries[index].m_Hash.m_Data.m_Data;
+    uint32_t hash_len = dmResource::HashLength(algorithm);
+    if (dmResourceArchive::FindEntry(manifest->m_ArchiveIndex, hash, hash_len, &archive, &ed) != dmResourceArchive::RESULT_OK)
+    {
+        return RESULT_OK;
+    }
+    return dmResourceArchive::PrefetchEntryData(archive, &ed) == dmResourceArchive::RESULT_PENDING ? RESULT_PENDING : RESULT_OK;
+}
+
+Result PrefetchResource(HFactory factory, const char* original_name)
+{
+    if (IsHttpFactory(factory) || !factory->m_Manifest)
+    {
+        return RESULT_OK;
+    }
+    DM_MUTEX_SCOPED_LOCK(factory->m_ArchiveReadMutex);
+    return PrefetchFromManifest(factory->m_Manifest, original_name);
+}
+
+static Result ReadPartialFromManifest(const Manifest* manifest, const char* path, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread)
+{
+    int index = FindEntryIndex(manifest, dmHashString64(path));
+    if (index < 0) {
+        return RESULT_RESOURCE_NOT_FOUND;
+    }
+
+    dmLiveUpdateDDF::HashAlgorithm algorithm = manifest->m_DDFData->m_Header.m_ResourceHashAlgorithm;
+    dmLiveUpdateDDF::ResourceEntry* entries = manifest->m_DDFData->m_Resources.m_Data;
+    dmResourceArchive::EntryData ed;
+    dmResourceArchive::HArchiveIndexContainer archive;
+    uint8_t* hash = entries[index].m_Hash.m_Data.m_Data;
+    uint32_t hash_len = dmResource::HashLength(algorithm);
+    dmResourceArchive::Result res = dmResourceArchive::FindEntry(manifest->m_ArchiveIndex, hash, hash_len, &archive, &ed);
+    if (res == dmResourceArchive::RESULT_NOT_FOUND)
+    {
+        return RESULT_RESOURCE_NOT_FOUND;
+    }
+    else if (res != dmResourceArchive::RESULT_OK)
+    {
+        return RESULT_IO_ERROR;
+    }
+
+    // The stored data is only the resource data if it isn't compressed or encrypted
+    if (dmResourceArchive::IsEntryEncoded(&ed) || !dmResourceArchive::HasDefaultReader(archive))
+    {
+        return RESULT_NOT_SUPPORTED;
+    }
+
+    uint32_t resource_size = ed.m_ResourceSize;
+    offset = dmMath::Min(offset, resource_size);
+    size = dmMath::Min(size, resource_size - offset);
+    if (dmResourceArchive::ReadEntryDataRangeFromArchive(archive, &ed, offset, size, buffer) != dmResourceArchive::RESULT_OK)
+    {
+        return RESULT_IO_ERROR;
+    }
+    *nread = size;
+    return RESULT_OK;
+}
+
+Result ReadResourcePartial(HFactory factory, const char* name, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread)
+{
+    DM_PROFILE(Resource, "ReadResourcePartial");
+
+    assert(name);
+    assert(nread);
+    *nread = 0;
+
+    Result chk = CheckSuppliedResourcePath(name);
+    if (chk != RESULT_OK)
+        return chk;
+
+    // Not m_LoadMutex, see m_ArchiveReadMutex
+    dmMutex::ScopedLock lk(factory->m_ArchiveReadMutex);
+
+    if (factory->m_BuiltinsManifest)
+    {
+        if (ReadPartialFromManifest(factory->m_BuiltinsManifest, name, offset, size, buffer, nread) == RESULT_OK)
+        {
+            return RESULT_OK;
+        }
+    }
+
+    if (IsHttpFactory(factory))
+    {
+        return RESULT_NOT_SUPPORTED;
+    }
+    else if (factory->m_Manifest)
+    {
+        return ReadPartialFromManifest(factory->m_Manifest, name, offset, size, buffer, nread);
+    }
+
+    char canonical_path[RESOURCE_PATH_MAX];
+    GetCanonicalPath(name, canonical_path);
+    char factory_path[RESOURCE_PATH_MAX];
+    GetCanonicalPathFromBase(factory->m_UriParts.m_Path, canonical_path, factory_path);
+    char fs_path[RESOURCE_PATH_MAX];
+    if (dmSys::RESULT_OK != dmSys::ResolveMountFileName(fs_path, sizeof(fs_path), factory_path))
+    {
+        return RESULT_RESOURCE_NOT_FOUND;
+    }
+
+    FILE* file = fopen(fs_path, "rb");
+    if (!file)
+    {
+        return RESULT_RESOURCE_NOT_FOUND;
+    }
+
+    Result result = RESULT_OK;
+    if (fseek(file, offset, SEEK_SET) == 0)
+    {
+        *nread = (uint32_t) fread(buffer, 1, size, file);
+        if (*nread < size && ferror(file))
+        {
+            result = RESULT_IO_ERROR;
+        }
+    }
+    else
+    {
+        result = RESULT_IO_ERROR;
+    }
+    fclose(file);
+    return result;
+}
+
+static void NotifyResourceReloaded(HFactory factory, SResourceDescriptor* rd, const char* name)
+{
+    if (factory->m_ResourceReloadedCallbacks)
+    {
+        for (uint32_t i = 0; i < factory->m_ResourceReloadedCallbacks->Size(); ++i)
+        {
+            ResourceReloadedCallbackPair& pair = (*factory->m_ResourceReloadedCallbacks)[i];
+            ResourceReloadedParams reload_params;
+            reload_params.m_UserData = pair.m_UserData;
+            reload_params.m_Resource = rd;
+            reload_params.m_Name = name;
+            pair.m_Callback(reload_params);
+        }
+    }
+}
+
 static Result DoReloadResource(HFactory factory, const char* name, SResourceDescriptor** out_descriptor)
 {
     char canonical_path[RESOURCE_PATH_MAX];
@@ -1330,18 +1995,7 @@ static Result DoReloadResource(HFactory factory, const char* name, SResourceDesc
     if (create_result == RESULT_OK)
     {
         params.m_Resource->m_ResourceSizeOnDisc = file_size;
-        if (factory->m_ResourceReloadedCallbacks)
-        {
-            for (uint32_t i = 0; i < factory->m_ResourceReloadedCallbacks->Size(); ++i)
-            {
-                ResourceReloadedCallbackPair& pair = (*factory->m_ResourceReloadedCallbacks)[i];
-                ResourceReloadedParams reload_params;
-                reload_params.m_UserData = pair.m_UserData;
-                reload_params.m_Resource = rd;
-                reload_params.m_Name = name;
-                pair.m_Callback(reload_params);
-            }
-        }
+        NotifyResourceReloaded(factory, rd, name);
         if (rd->m_PrevResource) {
             SResourceDescriptor tmp_resource = *rd;
             tmp_resource.m_Resource = rd->m_PrevResource;
@@ -1400,6 +2054,55 @@ Result ReloadResource(HFactory factory, const char* name, SResourceDescriptor**
     return result;
 }
 
+Result PatchResource(HFactory factory, const char* name, const void* patch, uint32_t patch_size, SResourceDescriptor** out_descriptor)
+{
+    dmMutex::ScopedLock lk(factory->m_LoadMutex);
+
+    char canonical_path[RESOURCE_PATH_MAX];
+    GetCanonicalPath(name, canonical_path);
+
+    uint64_t canonical_path_hash = dmHashBuffer64(canonical_path, strlen(canonical_path));
+    SResourceDescriptor* rd = factory->m_Resources->Get(canonical_path_hash);
+
+    if (out_descriptor)
+        *out_descriptor = rd;
+
+    if (rd == 0x0)
+    {
+        dmLogError("%s could not be patched since it was never loaded before.", name);
+        return RESULT_RESOURCE_NOT_FOUND;
+    }
+
+    Result result = RESULT_NOT_SUPPORTED;
+    SResourceType* resource_type = (SResourceType*) rd->m_ResourceType;
+    if (resource_type->m_PatchFunction)
+    {
+        ResourcePatchParams params;
+        params.m_Factory = factory;
+        params.m_Context = resource_type->m_Context;
+        params.m_Filename = name;
+        params.m_Patch = patch;
+        params.m_PatchSize = patch_size;
+        params.m_Resource = rd;
+        result = resource_type->m_PatchFunction(params);
+    }
+
+    if (result == RESULT_OK)
+    {
+        // The resource is updated in-place, there is no previous version to destroy
+        rd->m_PrevResource = 0;
+        NotifyResourceReloaded(factory, rd, name);
+        dmLogInfo("%s was successfully patched.", name);
+        return RESULT_OK;
+    }
+
+    if (result != RESULT_NOT_SUPPORTED)
+    {
+        dmLogWarning("%s could not be patched: %d, reloading it instead.", name, result);
+    }
+    return ReloadResource(factory, name, &rd);
+}
+
 Result SetResource(HFactory factory, uint64_t hashed_name, void* data, uint32_t datasize)
 {
     DM_PROFILE(Resource, "Set");
@@ -1646,26 +2349,45 @@ void Release(HFactory factory, void* resource)
 
     if (rd->m_ReferenceCount == 0)
     {
-        SResourceType* resource_type = (SResourceType*) rd->m_ResourceType;
-
-        DM_PROFILE_DYN(ResourceRelease, resource_type->m_Extension, resource_type->m_ExtensionHash);
-
-        ResourceDestroyParams params;
-        params.m_Factory = factory;
-        params.m_Context = resource_type->m_Context;
-        params.m_Resource = rd;
-        resource_type->m_DestroyFunction(params);
-
-        factory->m_ResourceToHash->Erase((uintptr_t) resource);
-        factory->m_Resources->Erase(*resource_hash);
-        if (factory->m_ResourceHashToFilename)
+        uint64_t hash = *resource_hash;
+        if (factory->m_ColdCacheBudget && rd->m_ResourceSize <= factory->m_ColdCacheBudget)
         {
-            const char** s = factory->m_ResourceHashToFilename->Get(*resource_hash);
-            factory->m_ResourceHashToFilename->Erase(*resource_hash);
-            assert(s);
-            free((void*) *s);
+            if (factory->m_ColdResources.Full())
+            {
+                factory->m_ColdResources.OffsetCapacity(64);
+            }
+            factory->m_ColdResources.Push(hash);
+            factory->m_ColdCacheUsed += rd->m_ResourceSize;
+            EvictColdResources(factory, factory->m_ColdCacheBudget);
         }
+        else
+        {
+            DestroyResource(factory, hash, rd);
+        }
+    }
+}
+
+void SetColdCacheSize(HFactory factory, uint32_t size)
+{
+    factory->m_ColdCacheBudget = size;
+    EvictColdResources(factory, size);
+}
+
+uint32_t EvictColdResources(HFactory factory, uint32_t max_size)
+{
+    uint32_t count = 0;
+    while (!factory->m_ColdResources.Empty() && (factory->m_ColdCacheUsed > max_size || max_size == 0))
+    {
+        EvictOldestColdResource(factory);
+        ++count;
     }
+    return count;
+}
+
+void SetResourceLoadedCallback(HFactory factory, FResourceLoadedCallback callback, void* user_data)
+{
+    factory->m_ResourceLoadedCallback = callback;
+    factory->m_ResourceLoadedCallbackUserData = user_data;
 }
 
 void RegisterResourceReloadedCallback(HFactory factory, ResourceReloadedCallback callback, void* user_data)
@@ -1721,6 +2443,57 @@ dmMutex::HMutex GetLoadMutex(const dmResource::HFactory factory)
     return factory->m_LoadMutex;
 }
 
+uint32_t GetLoaderThreadCount(HFactory factory)
+{
+    return factory->m_LoaderThreadCount;
+}
+
+void SetPreloadBudget(HFactory factory, uint32_t budget)
+{
+    factory->m_PreloadBudget = budget;
+}
+
+Result Prefetch(HFactory factory, const dmArray<const char*>& names)
+{
+    if (factory->m_ColdCacheBudget == 0)
+    {
+        return RESULT_NOT_SUPPORTED;
+    }
+    if (names.Empty())
+    {
+        return RESULT_INVAL;
+    }
+
+    HPreloader preloader = NewPreloader(factory, names);
+    if (factory->m_Prefetches.Full())
+    {
+        factory->m_Prefetches.OffsetCapacity(4);
+    }
+    factory->m_Prefetches.Push(preloader);
+    return RESULT_OK;
+}
+
+uint32_t GetPrefetchCount(HFactory factory)
+{
+    return factory->m_Prefetches.Size();
+}
+
+bool AcquirePreloadBudget(HFactory factory)
+{
+    if (factory->m_PreloadBudget && factory->m_PreloadsInFlight >= factory->m_PreloadBudget)
+    {
+        return false;
+    }
+    ++factory->m_PreloadsInFlight;
+    return true;
+}
+
+void ReleasePreloadBudget(HFactory factory)
+{
+    assert(factory->m_PreloadsInFlight > 0);
+    --factory->m_PreloadsInFlight;
+}
+
 void ReleaseBuiltinsManifest(HFactory factory)
 {
     if (factory->m_BuiltinsManifest)
@@ -18,6 +18,7 @@
 #include <dlib/array.h>
 #include <dlib/hash.h>
 #include <dlib/hashtable.h>
+#include <dlib/job.h>
 #include <dlib/mutex.h>
 #include <resource/liveupdate_ddf.h>
 #include "resource_archive.h"
@@ -59,6 +60,29 @@ namespace dmResource
      */
     #define RESOURCE_FACTORY_FLAGS_LIVE_UPDATE    (1 << 3)
 
+    /**
+     * Empty resource type flags
+     */
+    #define RESOURCE_TYPE_FLAGS_EMPTY               (0)
+
+    /**
+     * The create function of the resource type may be called from a loader thread.
+     * This happens when the resource is loaded by a preloader and the preload function didn't hint any
+     * other resources. The create function must then not call Get() or anything else that is
+     * restricted to the main thread. Work that requires the main thread, such as uploading to the GPU,
+     * should be done in the post create function, which is always called on the main thread.
+     */
+    #define RESOURCE_TYPE_FLAGS_THREAD_SAFE_CREATE  (1 << 0)
+
+    /**
+     * The preload, create and recreate functions of the resource type accept a buffer that points directly
+     * into a memory mapped archive, instead of a copy in a load buffer. This happens for archive entries that
+     * are neither compressed nor encrypted. The buffer is then read only and has no alignment guarantees.
+     * ResourceCreateParams::m_IsBufferMapped is set in that case, and the create function may then keep
+     * the pointer as backing storage for the resource, since the mapping outlives the resources.
+     */
+    #define RESOURCE_TYPE_FLAGS_MAPPED_BUFFER       (1 << 1)
+
     struct Manifest
     {
         Manifest()
@@ -131,7 +155,21 @@ namespace dmResource
         EmbeddedResource m_ArchiveData;
         EmbeddedResource m_ArchiveManifest;
 
-        uint32_t m_Reserved[5];
+        /// Number of threads loading resources asynchronously. Default is 0, which picks a count based on the number of cores
+        uint32_t m_LoaderThreadCount;
+
+        /// Path to a file where the paths of loaded resources are written, one per line, in the order they are first loaded.
+        /// The file can be passed to the archive builder to lay out the archive data in load order. Default is 0 (not recorded)
+        const char* m_LoadOrderPath;
+
+        /// Memory budget in bytes for released resources that are kept resident, so that a later Get can revive them without loading.
+        /// The least recently released resources are destroyed first when the budget is exceeded. Default is 0 (released resources are destroyed immediately)
+        uint32_t m_ColdCacheSize;
+
+        /// Maximum number of resource loads in flight, shared by all the preloaders of the factory. Default is 0 (no limit)
+        uint32_t m_PreloadBudget;
+
+        uint32_t m_Reserved[3];
 
         NewFactoryParams()
         {
@@ -178,6 +216,20 @@ namespace dmResource
      */
     Result GetRaw(HFactory factory, const char* name, void** resource, uint32_t* resource_size);
 
+    /**
+     * Read a part of a resource, without loading the whole resource. Only resources stored
+     * on the local file system, or uncompressed and unencrypted in an archive, can be read in parts.
+     * Thread safe.
+     * @param factory Factory handle
+     * @param name Resource name
+     * @param offset Offset in bytes from the start of the resource
+     * @param size Number of bytes to read
+     * @param buffer Buffer of at least size bytes
+     * @param nread Number of bytes read (out). Less than size if the end of the resource was reached
+     * @return RESULT_OK on success, RESULT_NOT_SUPPORTED if the resource can't be read in parts
+     */
+    Result ReadResourcePartial(HFactory factory, const char* name, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread);
+
     /**
      * Updates a preexisting resource with new data
      * @param factory Factory handle
@@ -206,6 +258,19 @@ namespace dmResource
      */
     Result ReloadResource(HFactory factory, const char* name, SResourceDescriptor** out_descriptor);
 
+    /**
+     * Patch a specific resource in-place with a partial update, e.g. a changed region of a large texture.
+     * The resource is fully reloaded instead if its type has no patch function, or the patch can't be applied.
+     * The resource reloaded callbacks are called in both cases.
+     * @param factory Resource factory
+     * @param name Name that identifies the resource, i.e. the same name used in Get
+     * @param patch Patch data, in a format specific to the resource type
+     * @param patch_size Size of the patch data
+     * @param out_descriptor The resource descriptor as an output argument. It will not be written to if null, otherwise it will always be written to.
+     * @see ReloadResource
+     */
+    Result PatchResource(HFactory factory, const char* name, const void* patch, uint32_t patch_size, SResourceDescriptor** out_descriptor);
+
     /**
      * Get type for resource
      * @param factory Factory handle
@@ -224,6 +289,24 @@ namespace dmResource
      */
     Result GetTypeFromExtension(HFactory factory, const char* extension, ResourceType* type);
 
+    /**
+     * Set flags for a registered resource type
+     * @param factory Factory handle
+     * @param extension File extension of the type
+     * @param flags Resource type flags, see RESOURCE_TYPE_FLAGS_THREAD_SAFE_CREATE and RESOURCE_TYPE_FLAGS_MAPPED_BUFFER
+     * @return RESULT_OK on success
+     */
+    Result SetTypeFlags(HFactory factory, const char* extension, uint32_t flags);
+
+    /**
+     * Set the patch function for a registered resource type, see PatchResource
+     * @param factory Factory handle
+     * @param extension File extension of the type
+     * @param patch_function Patch function, 0 to always fully reload resources of the type
+     * @return RESULT_OK on success
+     */
+    Result SetPatchFunction(HFactory factory, const char* extension, FResourcePatch patch_function);
+
     /**
      * Get extension from type
      * @param factory Factory handle
@@ -295,6 +378,25 @@ namespace dmResource
      */
     void DeletePreloader(HPreloader preloader);
 
+    /**
+     * Set the load priority of a resource type in the preloader. The resources that a resource
+     * depends on are loaded in priority order, highest first, e.g. the textures before the sounds.
+     * Applies to the resources the preloader finds after the call. The default priority is 0.
+     * @param preloader Preloader
+     * @param extension Resource type extension, e.g. "texturec"
+     * @param priority Load priority
+     * @return RESULT_OK on success, RESULT_UNKNOWN_RESOURCE_TYPE if the type isn't registered
+     */
+    Result SetPreloaderPriority(HPreloader preloader, const char* extension, int32_t priority);
+
+    /**
+     * Set the maximum number of resource loads in flight, shared by all the preloaders of the factory.
+     * A budget of 0 removes the limit.
+     * @param factory Factory handle
+     * @param budget Number of loads
+     */
+    void SetPreloadBudget(HFactory factory, uint32_t budget);
+
     Manifest* GetManifest(HFactory factory);
 
     /**
@@ -317,6 +419,13 @@ namespace dmResource
      */
     Result VerifyResourcesBundled(dmResourceArchive::HArchiveIndexContainer base_archive, const Manifest* manifest);
 
+    /**
+     * Verify that all resources the manifest expects to be bundled actually are bundled,
+     * checking the entries in parallel on the job system. The archive is only read.
+     * @param job_context job context, may be 0 to verify on the calling thread
+     */
+    Result VerifyResourcesBundled(dmResourceArchive::HArchiveIndexContainer base_archive, const Manifest* manifest, dmJob::HContext job_context);
+
     /**
      * Loads the public RSA key from the bundle.
      * Uses the public key to decrypt the manifest signature to get the content hash.
@@ -349,6 +458,58 @@ namespace dmResource
     */
     dmMutex::HMutex GetLoadMutex(const dmResource::HFactory factory);
 
+    /**
+     * Set the memory budget of the cache of released resources. Resources above the new budget
+     * are destroyed, least recently released first. A budget of 0 disables the cache.
+     * @param factory Factory handle
+     * @param size Budget in bytes
+     */
+    void SetColdCacheSize(HFactory factory, uint32_t size);
+
+    /**
+     * Destroy released resources until the cache uses at most max_size bytes, least recently released first.
+     * Use a max_size of 0 to empty the cache, e.g. on a low memory warning. The budget is left unchanged.
+     * @param factory Factory handle
+     * @param max_size Size in bytes to keep
+     * @return Number of destroyed resources
+     */
+    uint32_t EvictColdResources(HFactory factory, uint32_t max_size);
+
+    /**
+     * Load resources ahead of use, e.g. the collection of the next level. The resources are loaded
+     * in the background by UpdateFactory, a small time slice per frame, and are then released into
+     * the cache of released resources where a later Get revives them. Resources that are never
+     * claimed are evicted like any other released resource, so the cache budget bounds the memory used.
+     * @param factory Factory handle
+     * @param names Resource names
+     * @return RESULT_OK on success, RESULT_NOT_SUPPORTED if the cache is disabled (see SetColdCacheSize)
+     */
+    Result Prefetch(HFactory factory, const dmArray<const char*>& names);
+
+    /**
+     * Returns the number of prefetches still loading
+     * @param factory Factory handle
+     * @return Number of prefetches
+     */
+    uint32_t GetPrefetchCount(HFactory factory);
+
+    /**
+     * Function called when a resource has been loaded, see SetResourceLoadedCallback
+     * @param user_data User data
+     * @param path Resource path
+     * @param size Size of the resource on disc
+     */
+    typedef void (*FResourceLoadedCallback)(void* user_data, const char* path, uint32_t size);
+
+    /**
+     * Set a function to call every time a resource is loaded and inserted into the factory, including
+     * resources created by the preloader. It is called on the thread creating the resource.
+     * @param factory Factory handle
+     * @param callback Function to call, or 0 to remove it
+     * @param user_data User data passed to the callback
+     */
+    void SetResourceLoadedCallback(HFactory factory, FResourceLoadedCallback callback, void* user_data);
+
     /**
      * Releases the builtins manifest
      * Use when it's no longer needed, e.g. the user project loaded properly
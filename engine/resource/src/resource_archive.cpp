@@ -35,6 +35,13 @@
 #include <dlib/path.h>
 #include <dlib/sys.h>
 
+#if defined(__EMSCRIPTEN__)
+// Implemented in js/library_resource.js
+extern "C" int dmResourceArchiveRemoteOpen(const char* path);
+extern "C" void dmResourceArchiveRemoteClose(const char* path);
+extern "C" int dmResourceArchiveRemotePrefetch(const char* path, uint32_t offset, uint32_t size);
+extern "C" int dmResourceArchiveRemoteRead(const char* path, uint32_t offset, uint32_t size, void* dst);
+#endif
 
 namespace dmResourceArchive
 {
@@ -289,10 +296,44 @@ namespace dmResourceArchive
             return RESULT_IO_ERROR;
         }
 
+        uint32_t dictionary_offset = dmEndian::ToNetwork(ai->m_DictionaryOffset);
+        if (dictionary_offset)
+        {
+            uint32_t dictionary_size = 0;
+            fseek(f_index, dictionary_offset, SEEK_SET);
+            if (fread(&dictionary_size, 1, sizeof(dictionary_size), f_index) != sizeof(dictionary_size))
+            {
+                CleanupResources(f_index, f_data, aic);
+                return RESULT_IO_ERROR;
+            }
+            dictionary_size = dmEndian::ToNetwork(dictionary_size);
+            uint8_t* dictionary = new uint8_t[dictionary_size];
+            aic->m_ArchiveFileIndex->m_Dictionary = dictionary;
+            aic->m_ArchiveFileIndex->m_DictionarySize = dictionary_size;
+            aic->m_ArchiveFileIndex->m_IsDictionaryOwned = true;
+            if (fread(dictionary, 1, dictionary_size, f_index) != dictionary_size)
+            {
+                CleanupResources(f_index, f_data, aic);
+                return RESULT_IO_ERROR;
+            }
+        }
+
         // Mark that this archive was loaded from file, and not memory-mapped
         ai->m_Userdata = FILE_LOADED_INDICATOR;
 
         f_data = fopen(data_file_path, "rb");
+        dmStrlCpy(aic->m_ArchiveFileIndex->m_DataPath, data_file_path, DMPATH_MAX_PATH);
+
+#if defined(__EMSCRIPTEN__)
+        // The web loader may leave the data on the server, and only download the index before boot
+        if (!f_data && dmResourceArchiveRemoteOpen(data_file_path))
+        {
+            aic->m_ArchiveFileIndex->m_IsRemote = true;
+            *archive = aic;
+            fclose(f_index);
+            return RESULT_OK;
+        }
+#endif
 
         if (!f_data)
         {
@@ -419,6 +460,50 @@ namespace dmResourceArchive
         return RESULT_OK;
     }
 
+    Result DecompressBuffer(const void* compressed_buf, uint32_t compressed_size, void* buffer, uint32_t buffer_len, const void* dictionary, uint32_t dictionary_size)
+    {
+        assert(compressed_buf != buffer);
+        dmLZ4::Result r = dmLZ4::DecompressBufferWithDictionary(compressed_buf, compressed_size, buffer, buffer_len, dictionary, dictionary_size);
+        if (dmLZ4::RESULT_OK != r)
+        {
+            return RESULT_OUTBUFFER_TOO_SMALL;
+        }
+        return RESULT_OK;
+    }
+
+    // Reads from the archive data when it isn't memory mapped
+    static Result ReadArchiveData(const ArchiveFileIndex* afi, uint32_t offset, uint32_t size, void* data)
+    {
+#if defined(__EMSCRIPTEN__)
+        if (afi->m_IsRemote)
+        {
+            return dmResourceArchiveRemoteRead(afi->m_DataPath, offset, size, data) ? RESULT_OK : RESULT_IO_ERROR;
+        }
+#endif
+        FILE* resource_file = afi->m_FileResourceData;
+        fseek(resource_file, offset, SEEK_SET);
+        if (fread(data, 1, size, resource_file) != size)
+        {
+            return RESULT_IO_ERROR;
+        }
+        return RESULT_OK;
+    }
+
+    static Result DecompressEntry(HArchiveIndexContainer archive, const EntryData* entry, const void* compressed_buf, uint32_t compressed_size, void* buffer)
+    {
+        if (entry->m_Flags & ENTRY_FLAG_DICTIONARY)
+        {
+            const ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
+            if (afi == 0 || afi->m_Dictionary == 0)
+            {
+                dmLogError("Archive entry is compressed with a dictionary, but the archive has none");
+                return RESULT_UNKNOWN;
+            }
+            return DecompressBuffer(compressed_buf, compressed_size, buffer, entry->m_ResourceSize, afi->m_Dictionary, afi->m_DictionarySize);
+        }
+        return DecompressBuffer(compressed_buf, compressed_size, buffer, entry->m_ResourceSize);
+    }
+
     Result ReadEntryFromArchive(HArchiveIndexContainer archive, const uint8_t* hash, uint32_t hash_len, const EntryData* entry, void* buffer)
     {
         (void)hash;
@@ -464,12 +549,9 @@ namespace dmResourceArchive
 
         if (!resource_memmapped)
         {
-            FILE* resource_file = afi->m_FileResourceData;
-
             assert(temp_buffer || compressed_buf == buffer);
 
-            fseek(resource_file, entry->m_ResourceDataOffset, SEEK_SET);
-            if (fread(compressed_buf, 1, compressed_size, resource_file) != compressed_size)
+            if (ReadArchiveData(afi, entry->m_ResourceDataOffset, compressed_size, compressed_buf) != RESULT_OK)
             {
                 if (temp_buffer)
                     free(compressed_buf);
@@ -509,13 +591,12 @@ namespace dmResourceArchive
 
         if (compressed)
         {
-            assert(compressed_buf != buffer);
-            dmLZ4::Result r = dmLZ4::DecompressBufferFast(compressed_buf, compressed_size, buffer, size);
-            if (dmLZ4::RESULT_OK != r)
+            Result r = DecompressEntry(archive, entry, compressed_buf, compressed_size, buffer);
+            if (RESULT_OK != r)
             {
                 if (temp_buffer)
                     free(compressed_buf);
-                return RESULT_OUTBUFFER_TOO_SMALL;
+                return r;
             }
         } else {
             if (buffer != compressed_buf)
@@ -528,6 +609,98 @@ namespace dmResourceArchive
         return RESULT_OK;
     }
 
+    uint32_t GetEntryDataSize(const EntryData* entry)
+    {
+        bool compressed = entry->m_ResourceCompressedSize != 0xFFFFFFFF;
+        return compressed ? entry->m_ResourceCompressedSize : entry->m_ResourceSize;
+    }
+
+    bool IsEntryEncoded(const EntryData* entry)
+    {
+        return (entry->m_Flags & ENTRY_FLAG_ENCRYPTED) || entry->m_ResourceCompressedSize != 0xFFFFFFFF;
+    }
+
+    bool HasDefaultReader(HArchiveIndexContainer archive)
+    {
+        return archive->m_Loader.m_Read == ReadEntryFromArchive && archive->m_ArchiveFileIndex != 0;
+    }
+
+    const void* GetMappedEntryData(HArchiveIndexContainer archive, const EntryData* entry)
+    {
+        if (!HasDefaultReader(archive) || IsEntryEncoded(entry))
+        {
+            return 0;
+        }
+        // Live update archives may be replaced while the engine is running
+        if (entry->m_Flags & ENTRY_FLAG_LIVEUPDATE_DATA)
+        {
+            return 0;
+        }
+        const ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
+        if (!afi->m_IsMemMapped || afi->m_ResourceData == 0)
+        {
+            return 0;
+        }
+        return (const void*) ((uintptr_t)afi->m_ResourceData + entry->m_ResourceDataOffset);
+    }
+
+    Result ReadEntryDataFromArchive(HArchiveIndexContainer archive, const EntryData* entry, void* data)
+    {
+        return ReadEntryDataRangeFromArchive(archive, entry, 0, GetEntryDataSize(entry), data);
+    }
+
+    Result ReadEntryDataRangeFromArchive(HArchiveIndexContainer archive, const EntryData* entry, uint32_t offset, uint32_t size, void* data)
+    {
+        if (offset + size > GetEntryDataSize(entry))
+        {
+            return RESULT_IO_ERROR;
+        }
+        const ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
+        if (!afi->m_IsMemMapped)
+        {
+            return ReadArchiveData(afi, entry->m_ResourceDataOffset + offset, size, data);
+        }
+        memcpy(data, (void*) (((uintptr_t)afi->m_ResourceData + entry->m_ResourceDataOffset + offset)), size);
+        return RESULT_OK;
+    }
+
+    Result PrefetchEntryData(HArchiveIndexContainer archive, const EntryData* entry)
+    {
+        const ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
+        if (afi == 0 || !afi->m_IsRemote)
+        {
+            return RESULT_OK;
+        }
+#if defined(__EMSCRIPTEN__)
+        int r = dmResourceArchiveRemotePrefetch(afi->m_DataPath, entry->m_ResourceDataOffset, GetEntryDataSize(entry));
+        if (r == 0)
+        {
+            return RESULT_PENDING;
+        }
+        // On error, the blocking read reports the failure
+#endif
+        return RESULT_OK;
+    }
+
+    Result DecodeEntryData(HArchiveIndexContainer archive, const EntryData* entry, void* data, void* buffer)
+    {
+        uint32_t data_size = GetEntryDataSize(entry);
+        if (entry->m_Flags & ENTRY_FLAG_ENCRYPTED)
+        {
+            Result r = DecryptBuffer(data, data_size);
+            if (r != RESULT_OK)
+                return r;
+        }
+
+        if (entry->m_ResourceCompressedSize != 0xFFFFFFFF)
+        {
+            return DecompressEntry(archive, entry, data, data_size, buffer);
+        }
+
+        memcpy(buffer, data, entry->m_ResourceSize);
+        return RESULT_OK;
+    }
+
     void RegisterDefaultArchiveLoader()
     {
         dmResourceArchive::ArchiveLoader loader;
@@ -564,6 +737,18 @@ namespace dmResourceArchive
         (*archive)->m_ArchiveFileIndex->m_ResourceSize = resource_data_size;
         (*archive)->m_ArchiveFileIndex->m_IsMemMapped = mem_mapped_data;
 
+        uint32_t dictionary_offset = dmEndian::ToNetwork(a->m_DictionaryOffset);
+        if (dictionary_offset && dictionary_offset + sizeof(uint32_t) <= index_buffer_size)
+        {
+            const uint8_t* dictionary = (const uint8_t*)index_buffer + dictionary_offset;
+            uint32_t dictionary_size = dmEndian::ToNetwork(*(const uint32_t*)dictionary);
+            if (dictionary_offset + sizeof(uint32_t) + dictionary_size <= index_buffer_size)
+            {
+                (*archive)->m_ArchiveFileIndex->m_Dictionary = dictionary + sizeof(uint32_t);
+                (*archive)->m_ArchiveFileIndex->m_DictionarySize = dictionary_size;
+            }
+        }
+
         (*archive)->m_ArchiveIndex = a;
         (*archive)->m_ArchiveIndexSize = index_buffer_size;
 
@@ -576,11 +761,22 @@ namespace dmResourceArchive
         {
             delete[] afi->m_Entries;
             delete[] afi->m_Hashes;
+            if (afi->m_IsDictionaryOwned)
+            {
+                delete[] afi->m_Dictionary;
+            }
 
             if (afi->m_FileResourceData)
             {
                 fclose(afi->m_FileResourceData);
             }
+
+#if defined(__EMSCRIPTEN__)
+            if (afi->m_IsRemote)
+            {
+                dmResourceArchiveRemoteClose(afi->m_DataPath);
+            }
+#endif
         }
 
         delete afi;
@@ -705,12 +901,13 @@ namespace dmResourceArchive
             bool compressed = compressed_size != 0xFFFFFFFF;
             bool encrypted = flags & ENTRY_FLAG_ENCRYPTED;
             bool liveupdate = flags & ENTRY_FLAG_LIVEUPDATE_DATA;
+            bool dictionary = flags & ENTRY_FLAG_DICTIONARY;
 
-            dmLogInfo("Entry: %3d: '%s'  csz: %6u sz: %8u  offs: %8u  encr: %d lz4: %d lu: %d", i, hash_buffer,
+            dmLogInfo("Entry: %3d: '%s'  csz: %6u sz: %8u  offs: %8u  encr: %d lz4: %d dict: %d lu: %d", i, hash_buffer,
                                     compressed ? compressed_size : 0,
                                     dmEndian::ToNetwork(entry->m_ResourceSize),
                                     dmEndian::ToNetwork(entry->m_ResourceDataOffset),
-                                    encrypted, compressed, liveupdate);
+                                    encrypted, compressed, dictionary, liveupdate);
         }
 
         if (archive->m_Next)
@@ -807,35 +1004,40 @@ namespace dmResourceArchive
             memcpy(cursor, (void*)(((uintptr_t)ai + dmEndian::ToNetwork(ai->m_EntryDataOffset))), entry_datas_size);
         }
 
+        // The dictionary isn't part of the copy, it stays with the archive file index
+        dst->m_DictionaryOffset = 0;
+
         if (extra_entries_alloc > 0)
         {
             dst->m_EntryDataOffset = dmEndian::ToHost(dmEndian::ToNetwork(dst->m_EntryDataOffset) + dmResourceArchive::MAX_HASH * extra_entries_alloc);
         }
     }
 
-    Result WriteResourceToArchive(HArchiveIndexContainer& archive, const uint8_t* buf, size_t buf_len, uint32_t& bytes_written, uint32_t& offset)
+    // Appends to the resource file without flushing it
+    static Result AppendResourceData(ArchiveFileIndex* afi, const uint8_t* buf, size_t buf_len, uint32_t& offset)
     {
-        ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
         FILE* res_file = afi->m_FileResourceData;
 
         fseek(res_file, 0, SEEK_END);
-        uint32_t offs = (uint32_t)ftell(res_file);
+        offset = (uint32_t)ftell(res_file);
         size_t bytes = fwrite(buf, 1, buf_len, res_file);
         if(bytes != buf_len)
         {
             return RESULT_IO_ERROR;
         }
-        bytes_written = bytes;
-        offset = offs;
+        return RESULT_OK;
+    }
 
-        fflush(res_file); // make sure all writes flushed before mem-mapping below
+    // Flushes the resource file and updates the mapping after writes
+    static Result FlushResourceData(ArchiveFileIndex* afi, uint32_t new_size)
+    {
+        fflush(afi->m_FileResourceData); // make sure all writes flushed before mem-mapping below
 
         // We have written to the resource file, need to update mapping
         if (afi->m_IsMemMapped)
         {
             void* temp_map = (void*)afi->m_ResourceData;
-            assert(afi->m_ResourceSize == offset); // I want to use the m_ResourceSize
-            dmResource::UnmapFile(temp_map, offset);
+            dmResource::UnmapFile(temp_map, afi->m_ResourceSize);
 
             temp_map = 0x0;
             uint32_t map_size = 0;
@@ -846,13 +1048,39 @@ namespace dmResourceArchive
                 return RESULT_IO_ERROR;
             }
             afi->m_ResourceData = (uint8_t*)temp_map;
-            afi->m_ResourceSize = offset + bytes_written;
-            assert((offset + bytes_written) == map_size); // I want to use the map_size
+            afi->m_ResourceSize = new_size;
+            assert(new_size == map_size); // I want to use the map_size
         }
 
         return RESULT_OK;
     }
 
+    Result WriteResourceToArchive(HArchiveIndexContainer& archive, const uint8_t* buf, size_t buf_len, uint32_t& bytes_written, uint32_t& offset)
+    {
+        ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
+
+        uint32_t offs = 0;
+        Result r = AppendResourceData(afi, buf, buf_len, offs);
+        if (r != RESULT_OK)
+        {
+            return r;
+        }
+        bytes_written = (uint32_t)buf_len;
+        offset = offs;
+        assert(!afi->m_IsMemMapped || afi->m_ResourceSize == offset); // I want to use the m_ResourceSize
+
+        return FlushResourceData(afi, offset + bytes_written);
+    }
+
+    static void MakeLiveUpdateEntry(const dmResourceArchive::LiveUpdateResource* resource, uint32_t offset, EntryData* entry)
+    {
+        bool is_compressed = (resource->m_Header->m_Flags & ENTRY_FLAG_COMPRESSED);
+        entry->m_ResourceDataOffset = dmEndian::ToHost(offset);
+        entry->m_ResourceSize = is_compressed ? resource->m_Header->m_Size : dmEndian::ToHost((uint32_t)resource->m_Count);
+        entry->m_ResourceCompressedSize = is_compressed ? dmEndian::ToHost((uint32_t)resource->m_Count) : (dmEndian::ToHost(0xffffffff));
+        entry->m_Flags = dmEndian::ToHost((uint32_t)(resource->m_Header->m_Flags | ENTRY_FLAG_LIVEUPDATE_DATA));
+    }
+
     // only used for live update archives
     Result ShiftAndInsert(ArchiveIndexContainer* archive_container, ArchiveIndex* ai, const uint8_t* hash_digest, uint32_t hash_digest_len, int insertion_index,
                             const dmResourceArchive::LiveUpdateResource* resource, const EntryData* entry_data)
@@ -905,12 +1133,7 @@ namespace dmResourceArchive
             }
 
             // Create entrydata instance and insert into index
-            bool is_compressed = (resource->m_Header->m_Flags & ENTRY_FLAG_COMPRESSED);
-            //EntryData entry;
-            entry.m_ResourceDataOffset = dmEndian::ToHost(offs);
-            entry.m_ResourceSize = is_compressed ? resource->m_Header->m_Size : dmEndian::ToHost((uint32_t)resource->m_Count);
-            entry.m_ResourceCompressedSize = is_compressed ? dmEndian::ToHost((uint32_t)resource->m_Count) : (dmEndian::ToHost(0xffffffff));
-            entry.m_Flags = dmEndian::ToHost((uint32_t)(resource->m_Header->m_Flags | ENTRY_FLAG_LIVEUPDATE_DATA));
+            MakeLiveUpdateEntry(resource, offs, &entry);
             /// --- WRITE RESOURCE END
         }
 
@@ -919,6 +1142,28 @@ namespace dmResourceArchive
         return RESULT_OK;
     }
 
+    // Write to temporary index file, filename liveupdate.arci.tmp
+    static Result WriteTempIndex(ArchiveIndex* ai, const char* tmp_index_path)
+    {
+        FILE* f_lu_index = fopen(tmp_index_path, "wb");
+        if (!f_lu_index)
+        {
+            dmLogError("Failed to create liveupdate index file: %s", tmp_index_path);
+            return RESULT_IO_ERROR;
+        }
+        uint32_t entry_count = dmEndian::ToNetwork(ai->m_EntryDataCount);
+        uint32_t total_size = sizeof(ArchiveIndex) + entry_count * dmResourceArchive::MAX_HASH + entry_count * sizeof(EntryData);
+        if (fwrite((void*)ai, 1, total_size, f_lu_index) != total_size)
+        {
+            fclose(f_lu_index);
+            dmLogError("Failed to write %u bytes to liveupdate index file: %s", (uint32_t)total_size, tmp_index_path);
+            return RESULT_IO_ERROR;
+        }
+        fflush(f_lu_index);
+        fclose(f_lu_index);
+        return RESULT_OK;
+    }
+
     Result NewArchiveIndexWithResource(HArchiveIndexContainer archive_container, const char* tmp_index_path, const uint8_t* hash_digest, uint32_t hash_digest_len, const dmResourceArchive::LiveUpdateResource* resource, const char* app_support_path, HArchiveIndex& out_new_index)
     {
         out_new_index = 0x0;
@@ -946,25 +1191,87 @@ namespace dmResourceArchive
             return insert_result;
         }
 
-        // Write to temporary index file, filename liveupdate.arci.tmp
-        FILE* f_lu_index = fopen(tmp_index_path, "wb");
-        if (!f_lu_index)
+        Result write_result = WriteTempIndex(ai_temp, tmp_index_path);
+        if (write_result != RESULT_OK)
         {
-            dmLogError("Failed to create liveupdate index file: %s", tmp_index_path);
-            return RESULT_IO_ERROR;
+            delete ai_temp;
+            return write_result;
         }
-        uint32_t entry_count = dmEndian::ToNetwork(ai_temp->m_EntryDataCount);
-        uint32_t total_size = sizeof(ArchiveIndex) + entry_count * dmResourceArchive::MAX_HASH + entry_count * sizeof(EntryData);
-        if (fwrite((void*)ai_temp, 1, total_size, f_lu_index) != total_size)
+
+        // set result
+        out_new_index = ai_temp;
+        return RESULT_OK;
+    }
+
+    Result NewArchiveIndexWithResources(HArchiveIndexContainer archive_container, const char* tmp_index_path, const uint8_t* const* hash_digests, uint32_t hash_digest_len, const dmResourceArchive::LiveUpdateResource* const* resources, uint32_t count, Result* results, HArchiveIndex& out_new_index)
+    {
+        out_new_index = 0x0;
+
+        // Make deep-copy with room for all resources. Operate on this and only overwrite when done inserting
+        ArchiveIndex* ai_temp = 0x0;
+        NewArchiveIndexFromCopy(ai_temp, archive_container, count);
+        const uint8_t* hashes = (const uint8_t*)((uintptr_t)ai_temp + dmEndian::ToNetwork(ai_temp->m_HashOffset));
+
+        ArchiveFileIndex* afi = archive_container->m_ArchiveFileIndex;
+        uint32_t inserted = 0;
+        uint32_t data_end = afi->m_ResourceSize;
+        for (uint32_t i = 0; i < count; ++i)
         {
-            fclose(f_lu_index);
-            dmLogError("Failed to write %u bytes to liveupdate index file: %s", (uint32_t)total_size, tmp_index_path);
-            return RESULT_IO_ERROR;
+            if (results[i] != RESULT_OK)
+                continue;
+
+            int idx = -1;
+            results[i] = GetInsertionIndex(ai_temp, hash_digests[i], hashes, &idx);
+            if (results[i] != RESULT_OK)
+            {
+                dmLogError("Could not calculate valid resource insertion index, resource probably already stored in index. Result: %d", results[i]);
+                continue;
+            }
+
+            // The data of all resources is written before the mapping is updated
+            uint32_t offset = 0;
+            results[i] = AppendResourceData(afi, resources[i]->m_Data, resources[i]->m_Count, offset);
+            if (results[i] != RESULT_OK)
+            {
+                dmLogError("All bytes not written for resource, resource size: %zu", resources[i]->m_Count);
+                for (uint32_t j = i + 1; j < count; ++j)
+                {
+                    results[j] = RESULT_IO_ERROR;
+                }
+                break;
+            }
+            data_end = offset + (uint32_t)resources[i]->m_Count;
+
+            EntryData entry;
+            MakeLiveUpdateEntry(resources[i], offset, &entry);
+            ShiftAndInsert(archive_container, ai_temp, hash_digests[i], hash_digest_len, idx, 0x0, &entry);
+            ++inserted;
+        }
+
+        if (inserted == 0)
+        {
+            // Nothing to store, the results tell why
+            delete ai_temp;
+            return RESULT_OK;
+        }
+
+        // Single flush, remap and index write for the whole batch
+        Result result = FlushResourceData(afi, data_end);
+        if (result == RESULT_OK)
+        {
+            result = WriteTempIndex(ai_temp, tmp_index_path);
+        }
+        if (result != RESULT_OK)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (results[i] == RESULT_OK)
+                    results[i] = result;
+            }
+            delete ai_temp;
+            return result;
         }
-        fflush(f_lu_index);
-        fclose(f_lu_index);
 
-        // set result
         out_new_index = ai_temp;
         return RESULT_OK;
     }
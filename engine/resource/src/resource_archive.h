@@ -44,6 +44,7 @@ namespace dmResourceArchive
         ENTRY_FLAG_ENCRYPTED        = 1 << 0,
         ENTRY_FLAG_COMPRESSED       = 1 << 1,
         ENTRY_FLAG_LIVEUPDATE_DATA  = 1 << 2,
+        ENTRY_FLAG_DICTIONARY       = 1 << 3, // Compressed using the dictionary stored in the archive index
     };
 
     // part of the .arci file format
@@ -65,6 +66,7 @@ namespace dmResourceArchive
     {
         RESULT_OK = 0,
         RESULT_NOT_FOUND = 1,
+        RESULT_PENDING = 2,
         RESULT_VERSION_MISMATCH = -1,
         RESULT_IO_ERROR = -2,
         RESULT_MEM_ERROR = -3,
@@ -96,7 +98,7 @@ namespace dmResourceArchive
         ArchiveIndex();
 
         uint32_t m_Version;
-        uint32_t :32;
+        uint32_t m_DictionaryOffset; // Offset to the compression dictionary (size followed by data), 0 if there is none
         uint64_t m_Userdata;
         uint32_t m_EntryDataCount;
         uint32_t m_EntryDataOffset;
@@ -118,7 +120,12 @@ namespace dmResourceArchive
         FILE*       m_FileResourceData; // game.arcd file handle
         uint8_t*    m_ResourceData;     // mem-mapped game.arcd
         uint32_t    m_ResourceSize;     // the size of the memory mapped region
+        const uint8_t* m_Dictionary;       // Compression dictionary for ENTRY_FLAG_DICTIONARY entries
+        uint32_t       m_DictionarySize;
+        char        m_DataPath[DMPATH_MAX_PATH]; // game.arcd path, identifies the archive for remote reads
         bool        m_IsMemMapped;      // Is the data memory mapped?
+        bool        m_IsRemote;         // Is the data fetched on demand with range requests (web)?
+        bool        m_IsDictionaryOwned; // Was the dictionary allocated, or does it point into the memory mapped index
     };
 
     struct ArchiveIndexContainer
@@ -210,9 +217,42 @@ namespace dmResourceArchive
     // Decompressed a buffer
     Result DecompressBuffer(const void* compressed_buf, uint32_t compressed_size, void* buffer, uint32_t buffer_len);
 
+    // Decompresses a buffer compressed with a dictionary
+    Result DecompressBuffer(const void* compressed_buf, uint32_t compressed_size, void* buffer, uint32_t buffer_len, const void* dictionary, uint32_t dictionary_size);
+
     // Reads an entry from a single archive
     Result ReadEntryFromArchive(HArchiveIndexContainer archive, const uint8_t* hash, uint32_t hash_len, const EntryData* entry, void* buffer);
 
+    // Size of the entry data as stored in the archive (i.e. encrypted and/or compressed)
+    uint32_t GetEntryDataSize(const EntryData* entry);
+
+    // Is the entry data stored encrypted or compressed, i.e. does it need to be decoded with DecodeEntryData
+    bool IsEntryEncoded(const EntryData* entry);
+
+    // Does the archive use the default reader (ReadEntryFromArchive), making it possible to split reading and decoding of entries
+    bool HasDefaultReader(HArchiveIndexContainer archive);
+
+    // Returns a pointer to the entry data inside the memory mapped archive, or 0 if the archive isn't
+    // memory mapped, doesn't use the default reader, or the entry needs decoding or is live update data.
+    // The data is read only and stays valid for as long as the archive is loaded
+    const void* GetMappedEntryData(HArchiveIndexContainer archive, const EntryData* entry);
+
+    // Reads the stored entry data from a single archive, without decrypting or decompressing it.
+    // The buffer must be at least GetEntryDataSize() bytes
+    Result ReadEntryDataFromArchive(HArchiveIndexContainer archive, const EntryData* entry, void* data);
+
+    // Reads a range of the stored entry data from a single archive, without decrypting or decompressing it.
+    // The range must be within GetEntryDataSize() bytes
+    Result ReadEntryDataRangeFromArchive(HArchiveIndexContainer archive, const EntryData* entry, uint32_t offset, uint32_t size, void* data);
+
+    // Starts fetching the entry data if the archive data is remote (see ArchiveFileIndex::m_IsRemote).
+    // Returns RESULT_PENDING while the data is in flight, and RESULT_OK once it can be read without blocking
+    Result PrefetchEntryData(HArchiveIndexContainer archive, const EntryData* entry);
+
+    // Decrypts (in place) and decompresses entry data read with ReadEntryDataFromArchive into buffer.
+    // Only reads the archive dictionary and is safe to call from multiple threads.
+    Result DecodeEntryData(HArchiveIndexContainer archive, const EntryData* entry, void* data, void* buffer);
+
     // Calls each loader in sequence
 
     /*# Loads the archives, calling each registered loader in sequence
@@ -278,6 +318,21 @@ namespace dmResourceArchive
      */
     Result NewArchiveIndexWithResource(HArchiveIndexContainer archive, const char* tmp_index_path, const uint8_t* hash_digest, uint32_t hash_digest_len, const dmResourceArchive::LiveUpdateResource* resource, const char* proj_id, HArchiveIndex& out_new_index);
 
+    /**
+     * Make a deep-copy of the existing archive index and insert several LiveUpdate resources in it. The resource data
+     * is appended to the archive before the mapping is updated and the index file is written once for the whole batch.
+     * @param archive archive container
+     * @param tmp_index_path path of the temporary index file to write
+     * @param hash_digests hash digest of each resource
+     * @param hash_digest_len size in bytes of each hash digest
+     * @param resources LiveUpdate resources to insert
+     * @param count number of resources
+     * @param results in/out result per resource. Resources that are not RESULT_OK on input are skipped
+     * @param out_new_index reference to HArchiveIndex that will contain the new archive index, 0 if no resource was inserted
+     * @return RESULT_OK unless writing the batch failed
+     */
+    Result NewArchiveIndexWithResources(HArchiveIndexContainer archive, const char* tmp_index_path, const uint8_t* const* hash_digests, uint32_t hash_digest_len, const dmResourceArchive::LiveUpdateResource* const* resources, uint32_t count, Result* results, HArchiveIndex& out_new_index);
+
     /**
      * Set new archive index in archive container. Replace existing archive index if set
      * @param archive archive container
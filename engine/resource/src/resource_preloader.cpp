@@ -11,6 +11,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 #include <time.h>
@@ -71,8 +72,14 @@ namespace dmResource
     // to each request item. The path cache is also syncronized with the same spinlock as the new preloader hints array.
     // The path cache is not touched by the UpdatePreloader code, we keep the internalized pointers in the item.
 
-    // If max number of preload items is reached or the path cache is full new items added to the preloader will
-    // be thrown away and can potentially cause synced loading of those resources.
+    // The request tree and the path cache grow on demand. Both are allocated in blocks that are never moved,
+    // since requests and internalized paths are referenced by pointer while the tree grows.
+    //
+    // The children of a node are kept in priority order, see SetPreloaderPriority, so that the depth first
+    // traversal starts the loads of the higher priority resources first.
+    //
+    // The number of loads in flight is bounded by a budget shared by all the preloaders of a factory,
+    // see SetPreloadBudget.
 
     struct PathDescriptor
     {
@@ -83,7 +90,7 @@ namespace dmResource
         dmhash_t m_CanonicalPathHash;
     };
 
-    typedef int16_t TRequestIndex;
+    typedef int32_t TRequestIndex;
 
     struct PreloadRequest
     {
@@ -92,7 +99,9 @@ namespace dmResource
         TRequestIndex m_Parent;
         TRequestIndex m_FirstChild;
         TRequestIndex m_NextSibling;
-        uint16_t m_PendingChildCount;
+        uint32_t m_PendingChildCount;
+        // Load priority among the siblings, higher first
+        int32_t m_Priority;
 
         // Set once resources have started loading, they have a load request
         dmLoadQueue::HRequest m_LoadRequest;
@@ -100,6 +109,8 @@ namespace dmResource
         // Set for items that are pending and waiting for children to complete
         void* m_Buffer;
         uint32_t m_BufferSize;
+        // m_Buffer points into a memory mapped archive and isn't owned by the block allocator
+        bool m_IsBufferMapped;
 
         // Set once preload function has run
         void* m_PreloadData;
@@ -118,24 +129,17 @@ namespace dmResource
     };
 
 
-    // The preloader will function even down to a value of 1 here (the root object)
-    // and sets the limit of how large a dependencies tree can be stored. Since nodes
-    // are always present with all their children inserted (unless there was not room)
-    // the required size is something the sum of all children on each level down along
-    // the largest branch.
+    // The tables start out at these sizes and grow on demand. Since nodes are always present
+    // with all their children inserted, the required number of requests is something the
+    // sum of all children on each level down along the largest branch.
 
-    typedef dmHashTable<dmhash_t, uint32_t> TPathHashTable;
+    typedef dmHashTable<dmhash_t, const char*> TPathHashTable;
     typedef dmHashTable<dmhash_t, bool> TPathInProgressTable;
 
-    static const uint32_t MAX_PRELOADER_REQUESTS         = 1024;
-    static const uint32_t PATH_IN_PROGRESS_TABLE_SIZE    = MAX_PRELOADER_REQUESTS / 3;
-    static const uint32_t PATH_IN_PROGRESS_CAPACITY      = MAX_PRELOADER_REQUESTS;
-    static const uint32_t PATH_IN_PROGRESS_HASHDATA_SIZE = (PATH_IN_PROGRESS_TABLE_SIZE * sizeof(uint32_t)) + (PATH_IN_PROGRESS_CAPACITY * sizeof(TPathInProgressTable::Entry));
-    static const uint32_t PATH_AVERAGE_LENGTH            = 40;
-    static const uint32_t MAX_PRELOADER_PATHS            = 1536;
-    static const uint32_t PATH_BUFFER_TABLE_SIZE         = 509;
-    static const uint32_t PATH_BUFFER_TABLE_CAPACITY     = MAX_PRELOADER_PATHS;
-    static const uint32_t PATH_BUFFER_HASHDATA_SIZE      = (PATH_BUFFER_TABLE_SIZE * sizeof(uint32_t)) + (PATH_BUFFER_TABLE_CAPACITY * sizeof(TPathHashTable::Entry));
+    static const uint32_t REQUEST_BLOCK_SIZE             = 256;
+    static const uint32_t PATH_IN_PROGRESS_CAPACITY      = 256;
+    static const uint32_t PATH_BLOCK_SIZE                = 16 * 1024;
+    static const uint32_t PATH_TABLE_CAPACITY            = 512;
 
     struct PendingHint
     {
@@ -143,37 +147,44 @@ namespace dmResource
         TRequestIndex m_Parent;
     };
 
+    struct PreloadTypePriority
+    {
+        SResourceType* m_ResourceType;
+        int32_t m_Priority;
+    };
+
     struct ResourcePreloader
     {
         ResourcePreloader()
-            : m_InProgress(&m_PathInProgressData, PATH_IN_PROGRESS_TABLE_SIZE, PATH_IN_PROGRESS_CAPACITY)
         {
+            m_InProgress.SetCapacity(PATH_IN_PROGRESS_CAPACITY / 3, PATH_IN_PROGRESS_CAPACITY);
         }
         struct SyncedData
         {
             SyncedData()
-                : m_PathLookup(m_LookupData, PATH_BUFFER_TABLE_SIZE, PATH_BUFFER_TABLE_CAPACITY)
-                , m_PathDataUsed(0)
+                : m_PathDataUsed(0)
             {
+                m_PathLookup.SetCapacity(PATH_TABLE_CAPACITY / 3, PATH_TABLE_CAPACITY);
             }
             dmArray<PendingHint> m_NewHints;
             TPathHashTable m_PathLookup;
-            uint8_t m_LookupData[PATH_BUFFER_HASHDATA_SIZE];
-            char m_PathData[MAX_PRELOADER_PATHS * PATH_AVERAGE_LENGTH];
+            // Blocks of PATH_BLOCK_SIZE chars, m_PathDataUsed in the last one
+            dmArray<char*> m_PathData;
             uint32_t m_PathDataUsed;
         } m_SyncedData;
 
         dmSpinlock::lock_t m_SyncedDataSpinlock;
 
-        PreloadRequest m_Request[MAX_PRELOADER_REQUESTS];
+        // Blocks of REQUEST_BLOCK_SIZE requests, see GetRequest
+        dmArray<PreloadRequest*> m_RequestBlocks;
 
         // list of free nodes
-        TRequestIndex m_Freelist[MAX_PRELOADER_REQUESTS];
-        uint32_t m_FreelistSize;
+        dmArray<TRequestIndex> m_Freelist;
         dmLoadQueue::HQueue m_LoadQueue;
         HFactory m_Factory;
         TPathInProgressTable m_InProgress;
-        uint8_t m_PathInProgressData[PATH_IN_PROGRESS_HASHDATA_SIZE];
+
+        dmArray<PreloadTypePriority> m_TypePriorities;
 
         // used instead of dynamic allocs as far as it lasts.
         dmBlockAllocator::HContext m_BlockAllocator;
@@ -190,28 +201,79 @@ namespace dmResource
         dmArray<void*> m_PersistedResources;
     };
 
-    const char* InternalizePath(ResourcePreloader::SyncedData* preloader_synced_data, dmhash_t path_hash, const char* path, uint32_t path_len)
+    static PreloadRequest* GetRequest(ResourcePreloader* preloader, TRequestIndex index)
+    {
+        return &preloader->m_RequestBlocks[index / REQUEST_BLOCK_SIZE][index % REQUEST_BLOCK_SIZE];
+    }
+
+    static uint32_t GetRequestCapacity(ResourcePreloader* preloader)
     {
-        uint32_t* path_lookup = preloader_synced_data->m_PathLookup.Get(path_hash);
+        return preloader->m_RequestBlocks.Size() * REQUEST_BLOCK_SIZE;
+    }
+
+    static void AddRequestBlock(ResourcePreloader* preloader)
+    {
+        uint32_t first = GetRequestCapacity(preloader);
+        if (preloader->m_RequestBlocks.Full())
+        {
+            preloader->m_RequestBlocks.OffsetCapacity(8);
+        }
+        preloader->m_RequestBlocks.Push(new PreloadRequest[REQUEST_BLOCK_SIZE]);
+
+        preloader->m_Freelist.SetCapacity(first + REQUEST_BLOCK_SIZE);
+        // Lowest index last, so that it is allocated first.
+        // The root is always allocated so we don't add index zero in the free list
+        for (uint32_t i = first + REQUEST_BLOCK_SIZE - 1; i > first; --i)
+        {
+            preloader->m_Freelist.Push(i);
+        }
+        if (first != 0)
+        {
+            preloader->m_Freelist.Push(first);
+        }
+    }
+
+    static const char* InternalizePath(ResourcePreloader::SyncedData* preloader_synced_data, dmhash_t path_hash, const char* path, uint32_t path_len)
+    {
+        const char** path_lookup = preloader_synced_data->m_PathLookup.Get(path_hash);
         if (path_lookup != 0x0)
         {
-            return &preloader_synced_data->m_PathData[*path_lookup];
+            return *path_lookup;
         }
         if (preloader_synced_data->m_PathLookup.Full())
         {
-            return 0x0;
+            uint32_t capacity = preloader_synced_data->m_PathLookup.Capacity() * 2;
+            preloader_synced_data->m_PathLookup.SetCapacity(capacity / 3, capacity);
         }
-        if (preloader_synced_data->m_PathDataUsed + path_len + 1 > sizeof(preloader_synced_data->m_PathData))
+        dmArray<char*>& path_data = preloader_synced_data->m_PathData;
+        if (path_data.Empty() || preloader_synced_data->m_PathDataUsed + path_len + 1 > PATH_BLOCK_SIZE)
         {
-            return 0x0;
+            if (path_data.Full())
+            {
+                path_data.OffsetCapacity(8);
+            }
+            path_data.Push((char*)malloc(PATH_BLOCK_SIZE));
+            preloader_synced_data->m_PathDataUsed = 0;
         }
-        char* result = &preloader_synced_data->m_PathData[preloader_synced_data->m_PathDataUsed];
+        char* result = &path_data.Back()[preloader_synced_data->m_PathDataUsed];
         dmStrlCpy(result, path, path_len + 1);
-        preloader_synced_data->m_PathLookup.Put(path_hash, preloader_synced_data->m_PathDataUsed);
+        preloader_synced_data->m_PathLookup.Put(path_hash, result);
         preloader_synced_data->m_PathDataUsed += path_len + 1;
         return result;
     }
 
+    static int32_t GetPriority(ResourcePreloader* preloader, SResourceType* resource_type)
+    {
+        for (uint32_t i = 0; i < preloader->m_TypePriorities.Size(); ++i)
+        {
+            if (preloader->m_TypePriorities[i].m_ResourceType == resource_type)
+            {
+                return preloader->m_TypePriorities[i].m_Priority;
+            }
+        }
+        return 0;
+    }
+
     static SResourceType* GetResourceType(HPreloader preloader, const char* path)
     {
         const char* ext = strrchr(path, '.');
@@ -263,17 +325,7 @@ namespace dmResource
         DM_SPINLOCK_SCOPED_LOCK(preloader->m_SyncedDataSpinlock)
         {
             out_path_descriptor.m_InternalizedName = InternalizePath(&preloader->m_SyncedData, out_path_descriptor.m_NameHash, name, name_len);
-            if (out_path_descriptor.m_InternalizedName == 0x0)
-            {
-                dmSpinlock::Unlock(&preloader->m_SyncedDataSpinlock);
-                return RESULT_OUT_OF_MEMORY;
-            }
             out_path_descriptor.m_InternalizedCanonicalPath = InternalizePath(&preloader->m_SyncedData, out_path_descriptor.m_CanonicalPathHash, canonical_path, canonical_path_len);
-            if (out_path_descriptor.m_InternalizedCanonicalPath == 0x0)
-            {
-                dmSpinlock::Unlock(&preloader->m_SyncedDataSpinlock);
-                return RESULT_OUT_OF_MEMORY;
-            }
         }
 
         return RESULT_OK;
@@ -290,6 +342,11 @@ namespace dmResource
     {
         dmhash_t path_hash = path_descriptor->m_CanonicalPathHash;
         assert(preloader->m_InProgress.Get(path_hash) == 0x0);
+        if (preloader->m_InProgress.Full())
+        {
+            uint32_t capacity = preloader->m_InProgress.Capacity() * 2;
+            preloader->m_InProgress.SetCapacity(capacity / 3, capacity);
+        }
         preloader->m_InProgress.Put(path_hash, true);
     }
 
@@ -300,50 +357,57 @@ namespace dmResource
         preloader->m_InProgress.Erase(path_hash);
     }
 
+    // Inserts the request before its siblings of the same or lower priority
     static void PreloaderTreeInsert(ResourcePreloader* preloader, TRequestIndex index, TRequestIndex parent)
     {
-        PreloadRequest* reqs      = &preloader->m_Request[0];
-        reqs[index].m_NextSibling = reqs[parent].m_FirstChild;
-        reqs[index].m_Parent      = parent;
-        reqs[parent].m_FirstChild = index;
-        reqs[parent].m_PendingChildCount += 1;
+        PreloadRequest* req        = GetRequest(preloader, index);
+        PreloadRequest* parent_req = GetRequest(preloader, parent);
+        TRequestIndex* link        = &parent_req->m_FirstChild;
+        while (*link != -1 && GetRequest(preloader, *link)->m_Priority > req->m_Priority)
+        {
+            link = &GetRequest(preloader, *link)->m_NextSibling;
+        }
+        req->m_NextSibling = *link;
+        req->m_Parent      = parent;
+        *link              = index;
+        parent_req->m_PendingChildCount += 1;
     }
 
     static void RemoveFromParentPendingCount(ResourcePreloader* preloader, PreloadRequest* req)
     {
         if (req->m_Parent != -1)
         {
-            assert(preloader->m_Request[req->m_Parent].m_PendingChildCount > 0);
-            preloader->m_Request[req->m_Parent].m_PendingChildCount -= 1;
+            assert(GetRequest(preloader, req->m_Parent)->m_PendingChildCount > 0);
+            GetRequest(preloader, req->m_Parent)->m_PendingChildCount -= 1;
         }
     }
 
     static Result PreloadPathDescriptor(HPreloader preloader, TRequestIndex parent, const PathDescriptor& path_descriptor)
     {
         // Quick deduplication, check if the child is already listed under the current parent
-        TRequestIndex child = preloader->m_Request[parent].m_FirstChild;
+        TRequestIndex child = GetRequest(preloader, parent)->m_FirstChild;
         while (child != -1)
         {
-            if (preloader->m_Request[child].m_PathDescriptor.m_NameHash == path_descriptor.m_NameHash)
+            if (GetRequest(preloader, child)->m_PathDescriptor.m_NameHash == path_descriptor.m_NameHash)
             {
                 return RESULT_ALREADY_REGISTERED;
             }
-            child = preloader->m_Request[child].m_NextSibling;
+            child = GetRequest(preloader, child)->m_NextSibling;
         }
 
-        if (!preloader->m_FreelistSize)
+        if (preloader->m_Freelist.Empty())
         {
-            // Preload queue is exhausted; this is not fatal, it just means the resource will be loaded
-            // inside the main thread which may cause stuttering
-            return RESULT_OUT_OF_MEMORY;
+            AddRequestBlock(preloader);
         }
 
-        TRequestIndex new_req = preloader->m_Freelist[--preloader->m_FreelistSize];
-        PreloadRequest* req   = &preloader->m_Request[new_req];
+        TRequestIndex new_req = preloader->m_Freelist.Back();
+        preloader->m_Freelist.Pop();
+        PreloadRequest* req   = GetRequest(preloader, new_req);
         memset(req, 0, sizeof(PreloadRequest));
         req->m_PathDescriptor    = path_descriptor;
         req->m_FirstChild        = -1;
         req->m_LoadResult        = RESULT_PENDING;
+        req->m_Priority          = GetPriority(preloader, path_descriptor.m_ResourceType);
 
         PreloaderTreeInsert(preloader, new_req, parent);
 
@@ -353,15 +417,15 @@ namespace dmResource
         TRequestIndex go_up = parent;
         while (go_up != -1)
         {
-            if (preloader->m_Request[go_up].m_PathDescriptor.m_CanonicalPathHash == path_descriptor.m_CanonicalPathHash)
+            if (GetRequest(preloader, go_up)->m_PathDescriptor.m_CanonicalPathHash == path_descriptor.m_CanonicalPathHash)
             {
                 req->m_LoadResult = RESULT_RESOURCE_LOOP_ERROR;
                 assert(parent != -1);
-                assert(preloader->m_Request[parent].m_PendingChildCount > 0);
-                preloader->m_Request[parent].m_PendingChildCount -= 1;
+                assert(GetRequest(preloader, parent)->m_PendingChildCount > 0);
+                GetRequest(preloader, parent)->m_PendingChildCount -= 1;
                 break;
             }
-            go_up = preloader->m_Request[go_up].m_Parent;
+            go_up = GetRequest(preloader, go_up)->m_Parent;
         }
         return RESULT_OK;
     }
@@ -404,12 +468,12 @@ namespace dmResource
     // Only supports removing the first child, which is all the preloader uses anyway.
     static void PreloaderRemoveLeaf(ResourcePreloader* preloader, TRequestIndex index)
     {
-        assert(preloader->m_FreelistSize < MAX_PRELOADER_REQUESTS);
+        assert(preloader->m_Freelist.Size() < GetRequestCapacity(preloader));
 
-        PreloadRequest* me = &preloader->m_Request[index];
+        PreloadRequest* me = GetRequest(preloader, index);
         assert(me->m_FirstChild == -1);
         assert(me->m_PendingChildCount == 0);
-        PreloadRequest* parent = &preloader->m_Request[me->m_Parent];
+        PreloadRequest* parent = GetRequest(preloader, me->m_Parent);
         assert(parent->m_FirstChild == index);
 
         if (me->m_Resource)
@@ -431,7 +495,7 @@ namespace dmResource
             RemoveFromParentPendingCount(preloader, me);
         }
 
-        preloader->m_Freelist[preloader->m_FreelistSize++] = index;
+        preloader->m_Freelist.Push(index);
     }
 
     static void RemoveChildren(ResourcePreloader* preloader, PreloadRequest* req)
@@ -446,13 +510,7 @@ namespace dmResource
     HPreloader NewPreloader(HFactory factory, const dmArray<const char*>& names)
     {
         ResourcePreloader* preloader = new ResourcePreloader();
-        // root is always allocated so we don't add index zero in the free list
-        for (uint32_t i = 0; i < MAX_PRELOADER_REQUESTS - 1; i++)
-        {
-            preloader->m_Freelist[i] = MAX_PRELOADER_REQUESTS - i - 1;
-        }
-
-        preloader->m_FreelistSize = MAX_PRELOADER_REQUESTS - 1;
+        AddRequestBlock(preloader);
 
         preloader->m_Factory         = factory;
         preloader->m_LoadQueue       = dmLoadQueue::CreateQueue(factory);
@@ -462,7 +520,7 @@ namespace dmResource
         preloader->m_PersistedResources.SetCapacity(names.Size());
 
         // Insert root.
-        PreloadRequest* root = &preloader->m_Request[0];
+        PreloadRequest* root = GetRequest(preloader, 0);
         memset(root, 0x00, sizeof(PreloadRequest));
 
         root->m_LoadResult        = MakePathDescriptor(preloader, names[0], root->m_PathDescriptor);
@@ -472,7 +530,7 @@ namespace dmResource
         preloader->m_PersistResourceCount++;
 
         // Post create setup
-        preloader->m_PostCreateCallbacks.SetCapacity(MAX_PRELOADER_REQUESTS / 8);
+        preloader->m_PostCreateCallbacks.SetCapacity(REQUEST_BLOCK_SIZE / 2);
         preloader->m_LoadQueueFull           = false;
         preloader->m_CreateComplete          = false;
         preloader->m_PostCreateCallbackIndex = 0;
@@ -511,7 +569,8 @@ namespace dmResource
     //   2) Having failed, (or created and destroyed), leaving => RESULT_SOME_ERROR + everything free:d
     //
     // If buffer is null it means to use the items internal buffer
-    static void CreateResource(HPreloader preloader, PreloadRequest* req, void* buffer, uint32_t buffer_size)
+    // If the resource was already created by the load queue, load_result holds the created resource
+    static void CreateResource(HPreloader preloader, PreloadRequest* req, void* buffer, uint32_t buffer_size, const dmLoadQueue::LoadResult* load_result)
     {
         assert(req->m_LoadResult == RESULT_PENDING);
         assert(req->m_PendingChildCount == 0);
@@ -535,23 +594,35 @@ namespace dmResource
         params.m_Resource    = &tmp_resource;
         params.m_Filename    = req->m_PathDescriptor.m_InternalizedName;
 
-        if (!buffer)
+        if (load_result && load_result->m_CreateResult != RESULT_PENDING)
+        {
+            // Created on a loader thread
+            memcpy(&tmp_resource, &load_result->m_Resource, sizeof(tmp_resource));
+            req->m_LoadResult = load_result->m_CreateResult;
+        }
+        else if (!buffer)
         {
             assert(req->m_Buffer);
             tmp_resource.m_ResourceSizeOnDisc = req->m_BufferSize;
             params.m_Buffer                   = req->m_Buffer;
             params.m_BufferSize               = req->m_BufferSize;
+            params.m_IsBufferMapped           = req->m_IsBufferMapped;
             req->m_LoadResult                 = resource_type->m_CreateFunction(params);
 
-            dmBlockAllocator::Free(preloader->m_BlockAllocator, req->m_Buffer, req->m_BufferSize);
+            if (!req->m_IsBufferMapped)
+            {
+                dmBlockAllocator::Free(preloader->m_BlockAllocator, req->m_Buffer, req->m_BufferSize);
+            }
 
             req->m_Buffer = 0;
+            req->m_IsBufferMapped = false;
         }
         else
         {
             tmp_resource.m_ResourceSizeOnDisc = buffer_size;
             params.m_Buffer                   = buffer;
             params.m_BufferSize               = buffer_size;
+            params.m_IsBufferMapped           = load_result && load_result->m_IsBufferMapped;
             req->m_LoadResult                 = resource_type->m_CreateFunction(params);
         }
 
@@ -561,7 +632,7 @@ namespace dmResource
             {
                 if (preloader->m_PostCreateCallbacks.Full())
                 {
-                    preloader->m_PostCreateCallbacks.OffsetCapacity(MAX_PRELOADER_REQUESTS / 8);
+                    preloader->m_PostCreateCallbacks.OffsetCapacity(REQUEST_BLOCK_SIZE / 2);
                 }
                 preloader->m_PostCreateCallbacks.SetSize(preloader->m_PostCreateCallbacks.Size() + 1);
                 ResourcePostCreateParamsInternal& ip = preloader->m_PostCreateCallbacks.Back();
@@ -675,12 +746,12 @@ namespace dmResource
         {
             return false;
         }
-        PreloadRequest* parent_req = &preloader->m_Request[parent];
+        PreloadRequest* parent_req = GetRequest(preloader, parent);
         if (parent_req->m_PendingChildCount > 0)
         {
             return false;
         }
-        CreateResource(preloader, parent_req, 0, 0);
+        CreateResource(preloader, parent_req, 0, 0, 0);
         UnmarkPathInProgress(preloader, &parent_req->m_PathDescriptor);
         PreloaderTryPruneParent(preloader, parent_req);
         return true;
@@ -723,7 +794,7 @@ namespace dmResource
             if (req->m_LoadResult == RESULT_PENDING)
             {
                 // Create the resource using the loading buffer directly.
-                CreateResource(preloader, req, buffer, buffer_size);
+                CreateResource(preloader, req, buffer, buffer_size, &load_result);
                 created_resource = true;
             }
             UnmarkPathInProgress(preloader, &req->m_PathDescriptor);
@@ -734,10 +805,20 @@ namespace dmResource
         }
         else
         {
-            // Keep the loaded bytes until we have loaded all children
-            req->m_Buffer = dmBlockAllocator::Allocate(preloader->m_BlockAllocator, buffer_size);
-            memcpy(req->m_Buffer, buffer, buffer_size);
+            // Only resources without hints are created by the load queue
+            assert(load_result.m_CreateResult == RESULT_PENDING);
+            // Keep the loaded bytes until we have loaded all children, data in a memory mapped archive is used in place
+            if (load_result.m_IsBufferMapped)
+            {
+                req->m_Buffer = buffer;
+            }
+            else
+            {
+                req->m_Buffer = dmBlockAllocator::Allocate(preloader->m_BlockAllocator, buffer_size);
+                memcpy(req->m_Buffer, buffer, buffer_size);
+            }
             req->m_BufferSize = buffer_size;
+            req->m_IsBufferMapped = load_result.m_IsBufferMapped;
             dmLoadQueue::FreeLoad(preloader->m_LoadQueue, req->m_LoadRequest);
             req->m_LoadRequest = 0;
         }
@@ -753,7 +834,7 @@ namespace dmResource
         DM_PROFILE(Resource, "PreloaderUpdateOneItem");
         while (index >= 0)
         {
-            PreloadRequest* req = &preloader->m_Request[index];
+            PreloadRequest* req = GetRequest(preloader, index);
             switch (req->m_LoadResult)
             {
                 case RESULT_PENDING:
@@ -808,6 +889,7 @@ namespace dmResource
                 return false;
             }
             preloader->m_LoadQueueFull = false;
+            ReleasePreloadBudget(preloader->m_Factory);
 
             if (FinishLoad(preloader, req, res, buffer, buffer_size))
             {
@@ -854,11 +936,25 @@ namespace dmResource
             return false;
         }
 
+        if (!AcquirePreloadBudget(preloader->m_Factory))
+        {
+            // The loads in flight of all preloaders use up the budget, try again once one of them completes
+            return false;
+        }
+
         dmLoadQueue::PreloadInfo info;
         info.m_HintInfo.m_Preloader = preloader;
         info.m_HintInfo.m_Parent    = index;
+        info.m_HintInfo.m_HintCount = 0;
         info.m_Function             = req->m_PathDescriptor.m_ResourceType->m_PreloadFunction;
         info.m_Context              = req->m_PathDescriptor.m_ResourceType->m_Context;
+        info.m_ResourceType         = req->m_PathDescriptor.m_ResourceType;
+        info.m_CanonicalPathHash    = req->m_PathDescriptor.m_CanonicalPathHash;
+        info.m_CreateFunction       = 0;
+        if (req->m_PathDescriptor.m_ResourceType->m_Flags & RESOURCE_TYPE_FLAGS_THREAD_SAFE_CREATE)
+        {
+            info.m_CreateFunction = req->m_PathDescriptor.m_ResourceType->m_CreateFunction;
+        }
 
         // If we can't add the request to the load queue it is because the queue is full
         // We will try again once we completed loading of an item via dmLoadQueue::EndLoad
@@ -868,6 +964,7 @@ namespace dmResource
             return true;
         }
 
+        ReleasePreloadBudget(preloader->m_Factory);
         preloader->m_LoadQueueFull = true;
         return false;
     }
@@ -927,7 +1024,7 @@ namespace dmResource
 
         do
         {
-            Result root_result        = preloader->m_Request[0].m_LoadResult;
+            Result root_result        = GetRequest(preloader, 0)->m_LoadResult;
             Result post_create_result = RESULT_OK;
             if (preloader->m_PostCreateCallbackIndex < preloader->m_PostCreateCallbacks.Size())
             {
@@ -940,7 +1037,7 @@ namespace dmResource
                         // Just waiting for the post-create functions to complete
                         // If main result is RESULT_OK pick up any errors from
                         // post create function
-                        preloader->m_Request[0].m_LoadResult = post_create_result;
+                        GetRequest(preloader, 0)->m_LoadResult = post_create_result;
                     }
                     continue;
                 }
@@ -966,7 +1063,7 @@ namespace dmResource
                     {
                         if (!complete_callback(complete_callback_params))
                         {
-                            preloader->m_Request[0].m_LoadResult = RESULT_NOT_LOADED;
+                            GetRequest(preloader, 0)->m_LoadResult = RESULT_NOT_LOADED;
                         }
                         empty_runs = 0;
                         // We need to continue to do all post create functions
@@ -1030,7 +1127,7 @@ namespace dmResource
         }
 
         // Release root and persisted resources
-        preloader->m_PersistedResources.Push(preloader->m_Request[0].m_Resource);
+        preloader->m_PersistedResources.Push(GetRequest(preloader, 0)->m_Resource);
         for (uint32_t i = 0; i < preloader->m_PersistedResources.Size(); ++i)
         {
             void* resource = preloader->m_PersistedResources[i];
@@ -1039,14 +1136,49 @@ namespace dmResource
             Release(preloader->m_Factory, resource);
         }
 
-        assert(preloader->m_FreelistSize == (MAX_PRELOADER_REQUESTS - 1));
+        assert(preloader->m_Freelist.Size() == (GetRequestCapacity(preloader) - 1));
         dmLoadQueue::DeleteQueue(preloader->m_LoadQueue);
 
         dmBlockAllocator::DeleteContext(preloader->m_BlockAllocator);
 
+        for (uint32_t i = 0; i < preloader->m_RequestBlocks.Size(); ++i)
+        {
+            delete[] preloader->m_RequestBlocks[i];
+        }
+        for (uint32_t i = 0; i < preloader->m_SyncedData.m_PathData.Size(); ++i)
+        {
+            free(preloader->m_SyncedData.m_PathData[i]);
+        }
+
         delete preloader;
     }
 
+    Result SetPreloaderPriority(HPreloader preloader, const char* extension, int32_t priority)
+    {
+        SResourceType* resource_type = FindResourceType(preloader->m_Factory, extension);
+        if (resource_type == 0x0)
+        {
+            return RESULT_UNKNOWN_RESOURCE_TYPE;
+        }
+        for (uint32_t i = 0; i < preloader->m_TypePriorities.Size(); ++i)
+        {
+            if (preloader->m_TypePriorities[i].m_ResourceType == resource_type)
+            {
+                preloader->m_TypePriorities[i].m_Priority = priority;
+                return RESULT_OK;
+            }
+        }
+        if (preloader->m_TypePriorities.Full())
+        {
+            preloader->m_TypePriorities.OffsetCapacity(8);
+        }
+        PreloadTypePriority type_priority;
+        type_priority.m_ResourceType = resource_type;
+        type_priority.m_Priority = priority;
+        preloader->m_TypePriorities.Push(type_priority);
+        return RESULT_OK;
+    }
+
     bool PreloadHint(HPreloadHintInfo info, const char* name)
     {
         if (!info || !name)
@@ -1054,6 +1186,9 @@ namespace dmResource
 
         HPreloader preloader = info->m_Preloader;
 
+        // Counted even if the hint fails, the create function may still depend on the resource
+        info->m_HintCount++;
+
         PathDescriptor path_descriptor;
         Result res = MakePathDescriptor(info->m_Preloader, name, path_descriptor);
         if (res != RESULT_OK)
@@ -40,6 +40,8 @@ namespace dmResource
         FResourcePostCreate m_PostCreateFunction;
         FResourceDestroy    m_DestroyFunction;
         FResourceRecreate   m_RecreateFunction;
+        FResourcePatch      m_PatchFunction;
+        uint32_t            m_Flags;
     };
 
     typedef dmArray<char> LoadBufferType;
@@ -50,8 +52,36 @@ namespace dmResource
 
     // load with default internal buffer and its management, returns buffer ptr in 'buffer'
     Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size);
+    // If is_mapped is supplied, the returned buffer may point directly into a memory mapped archive instead of the internal buffer, which is then flagged in is_mapped
+    Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size, bool* is_mapped);
+    // Archive entry read by DoLoadResource, but not yet decrypted or decompressed
+    struct PendingDecode
+    {
+        // Stored entry data, buffer owned by the caller
+        LoadBufferType*                 m_Data;
+        dmResourceArchive::EntryData    m_Entry;
+        // Archive the entry was read from, for its compression dictionary
+        dmResourceArchive::HArchiveIndexContainer m_Archive;
+        bool                            m_Pending;
+    };
+
     // load with own buffer
     Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer);
+    // load with own buffer, leaving decryption and decompression of archive entries to DecodeResource if decode->m_Pending is set.
+    // Only the reading is done with the load mutex held, decoding can be done in parallel by several threads.
+    // If mapped_data is supplied, entries that can be used directly from a memory mapped archive are returned in it, leaving the buffer empty
+    Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer, PendingDecode* decode, const void** mapped_data);
+    Result DecodeResource(PendingDecode* decode, LoadBufferType* buffer);
+    // Starts fetching the archive data of a resource when the archive data is remote (web).
+    // Returns RESULT_PENDING until the resource can be loaded without blocking
+    Result PrefetchResource(HFactory factory, const char* original_name);
+
+    // Number of loader threads used by the async load queue, 0 picks a default based on the number of cores
+    uint32_t GetLoaderThreadCount(HFactory factory);
+
+    // Reserves one load of the budget shared by the preloaders, see SetPreloadBudget. Called by UpdatePreloader, not thread safe
+    bool AcquirePreloadBudget(HFactory factory);
+    void ReleasePreloadBudget(HFactory factory);
 
     Result InsertResource(HFactory factory, const char* path, uint64_t canonical_path_hash, SResourceDescriptor* descriptor);
     uint32_t GetCanonicalPath(const char* relative_dir, char* buf);
@@ -83,12 +113,15 @@ namespace dmResource
      * Exposed for unit tests
      */
      Result VerifyResourcesBundled(dmLiveUpdateDDF::ResourceEntry* entries, uint32_t num_entries, uint32_t hash_len, dmResourceArchive::HArchiveIndexContainer archive_index);
+     Result VerifyResourcesBundled(dmLiveUpdateDDF::ResourceEntry* entries, uint32_t num_entries, uint32_t hash_len, dmResourceArchive::HArchiveIndexContainer archive_index, dmJob::HContext job_context);
 
     struct PreloadRequest;
     struct PreloadHintInfo
     {
         HPreloader m_Preloader;
         int32_t m_Parent;
+        // Number of PreloadHint calls made during the preload
+        uint32_t m_HintCount;
     };
 
     struct TypeCreatorDesc
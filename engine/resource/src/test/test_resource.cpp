@@ -12,8 +12,10 @@
 
 #include <dlib/log.h>
 
+#include <dlib/atomic.h>
 #include <dlib/dstrings.h>
 #include <dlib/hash.h>
+#include <dlib/job.h>
 #include <dlib/log.h>
 #include <dlib/message.h>
 #include <dlib/socket.h>
@@ -221,11 +223,15 @@ protected:
         m_ResourceContainerCreateCallCount = 0;
         m_ResourceContainerDestroyCallCount = 0;
         m_FooResourceCreateCallCount = 0;
+        m_FooResourceCreateLoaderThreadCount = 0;
+        m_MainThread = dmThread::GetCurrentThread();
         m_FooResourcePostCreateCallCount = 0;
         m_FooResourceDestroyCallCount = 0;
 
         dmResource::NewFactoryParams params;
         params.m_MaxResources = 16;
+        // Load with several threads, regardless of the number of cores
+        params.m_LoaderThreadCount = 4;
 
         dmResourceArchive::ClearArchiveLoaders();
         dmResourceArchive::RegisterDefaultArchiveLoader();
@@ -280,6 +286,8 @@ public:
     uint32_t           m_ResourceContainerCreateCallCount;
     uint32_t           m_ResourceContainerDestroyCallCount;
     uint32_t           m_FooResourceCreateCallCount;
+    int32_atomic_t     m_FooResourceCreateLoaderThreadCount;
+    dmThread::Thread   m_MainThread;
     uint32_t           m_FooResourcePostCreateCallCount;
     uint32_t           m_FooResourceDestroyCallCount;
 
@@ -366,7 +374,12 @@ dmResource::Result ResourceContainerDestroy(const dmResource::ResourceDestroyPar
 dmResource::Result FooResourceCreate(const dmResource::ResourceCreateParams& params)
 {
     GetResourceTest* self = (GetResourceTest*) params.m_Context;
-    self->m_FooResourceCreateCallCount++;
+    // May be called from the loader threads if the type is registered with RESOURCE_TYPE_FLAGS_THREAD_SAFE_CREATE
+    dmAtomicIncrement32((int32_atomic_t*) &self->m_FooResourceCreateCallCount);
+    if (dmThread::GetCurrentThread() != self->m_MainThread)
+    {
+        dmAtomicIncrement32(&self->m_FooResourceCreateLoaderThreadCount);
+    }
 
     TestResource::ResourceFoo* resource_foo;
 
@@ -439,6 +452,33 @@ TEST_P(GetResourceTest, GetRaw)
     ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, e);
 }
 
+TEST_P(GetResourceTest, ReadResourcePartial)
+{
+    void* resource = 0;
+    uint32_t resource_size = 0;
+    dmResource::Result e = dmResource::GetRaw(m_Factory, "/test01.foo", (void**) &resource, &resource_size);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+
+    // Reading past the end stops at the end of the resource
+    uint8_t buffer[16];
+    uint32_t nread = 0;
+    e = dmResource::ReadResourcePartial(m_Factory, "/test01.foo", 1, sizeof(buffer), buffer, &nread);
+    if (e == dmResource::RESULT_OK)
+    {
+        ASSERT_EQ(resource_size - 1, nread);
+        ASSERT_EQ(0, memcmp(buffer, (uint8_t*) resource + 1, nread));
+    }
+    else
+    {
+        // Http and compressed archives
+        ASSERT_EQ(dmResource::RESULT_NOT_SUPPORTED, e);
+    }
+    free(resource);
+
+    e = dmResource::ReadResourcePartial(m_Factory, "/does_not_exists", 0, sizeof(buffer), buffer, &nread);
+    ASSERT_NE(dmResource::RESULT_OK, e);
+}
+
 TEST_P(GetResourceTest, IncRef)
 {
     dmResource::Result e;
@@ -542,7 +582,7 @@ TEST_P(GetResourceTest, GetDescriptorWithExt)
     ASSERT_EQ(dmResource::RESULT_NOT_LOADED, e);
 }
 
-const char* params_resource_paths[] = {"build/default/src/test/", "http://127.0.0.1:6123", "dmanif:build/default/src/test/resources_pb.dmanifest"};
+const char* params_resource_paths[] = {"build/default/src/test/", "http://127.0.0.1:6123", "dmanif:build/default/src/test/resources_pb.dmanifest", "dmanif:build/default/src/test/resources_pb_compressed.dmanifest"};
 INSTANTIATE_TEST_CASE_P(GetResourceTestURI, GetResourceTest, jc_test_values_in(params_resource_paths));
 
 #endif // TEST_HTTP_SUPPORTED
@@ -640,6 +680,81 @@ TEST_P(GetResourceTest, ReferenceCountSimple)
     ASSERT_EQ(dmResource::RESULT_NOT_LOADED, e);
 }
 
+TEST_P(GetResourceTest, ColdCache)
+{
+    dmResource::SetColdCacheSize(m_Factory, 1024);
+
+    TestResourceContainer* resource1 = 0;
+    dmResource::Result e = dmResource::Get(m_Factory, m_ResourceName, (void**) &resource1);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    const uint32_t sub_resource_count = resource1->m_Resources.size();
+
+    // Released resources are kept resident
+    dmResource::Release(m_Factory, resource1);
+    ASSERT_EQ((uint32_t) 0, m_ResourceContainerDestroyCallCount);
+    ASSERT_EQ((uint32_t) 0, m_FooResourceDestroyCallCount);
+
+    dmResource::SResourceDescriptor descriptor;
+    e = dmResource::GetDescriptor(m_Factory, m_ResourceName, &descriptor);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_EQ((uint32_t) 0, descriptor.m_ReferenceCount);
+
+    // ...and revived without being created again
+    TestResourceContainer* resource2 = 0;
+    e = dmResource::Get(m_Factory, m_ResourceName, (void**) &resource2);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_EQ(resource1, resource2);
+    ASSERT_EQ((uint32_t) 1, m_ResourceContainerCreateCallCount);
+    ASSERT_EQ(sub_resource_count, m_FooResourceCreateCallCount);
+    ASSERT_EQ((uint32_t) 1, dmResource::GetRefCount(m_Factory, resource2));
+
+    dmResource::Release(m_Factory, resource2);
+    ASSERT_LT((uint32_t) 0, dmResource::EvictColdResources(m_Factory, 0));
+    ASSERT_EQ((uint32_t) 1, m_ResourceContainerDestroyCallCount);
+    ASSERT_EQ(sub_resource_count, m_FooResourceDestroyCallCount);
+
+    e = dmResource::GetDescriptor(m_Factory, m_ResourceName, &descriptor);
+    ASSERT_EQ(dmResource::RESULT_NOT_LOADED, e);
+}
+
+TEST_P(GetResourceTest, Prefetch)
+{
+    dmArray<const char*> names;
+    names.SetCapacity(1);
+    names.Push(m_ResourceName);
+
+    // Prefetching requires the cache of released resources
+    ASSERT_EQ(dmResource::RESULT_NOT_SUPPORTED, dmResource::Prefetch(m_Factory, names));
+
+    dmResource::SetColdCacheSize(m_Factory, 1024);
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Prefetch(m_Factory, names));
+    ASSERT_EQ(1u, dmResource::GetPrefetchCount(m_Factory));
+
+    for (uint32_t i = 0; i < 100 && dmResource::GetPrefetchCount(m_Factory); ++i)
+    {
+        dmResource::UpdateFactory(m_Factory);
+        dmTime::Sleep(30000);
+    }
+    ASSERT_EQ(0u, dmResource::GetPrefetchCount(m_Factory));
+    ASSERT_EQ((uint32_t) 1, m_ResourceContainerCreateCallCount);
+    ASSERT_EQ((uint32_t) 0, m_ResourceContainerDestroyCallCount);
+
+    dmResource::SResourceDescriptor descriptor;
+    dmResource::Result e = dmResource::GetDescriptor(m_Factory, m_ResourceName, &descriptor);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_EQ((uint32_t) 0, descriptor.m_ReferenceCount);
+
+    // Claimed without being created again
+    TestResourceContainer* resource = 0;
+    e = dmResource::Get(m_Factory, m_ResourceName, (void**) &resource);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_EQ((uint32_t) 1, m_ResourceContainerCreateCallCount);
+
+    dmResource::Release(m_Factory, resource);
+    dmResource::EvictColdResources(m_Factory, 0);
+    ASSERT_EQ((uint32_t) 1, m_ResourceContainerDestroyCallCount);
+}
+
 
 static bool PreloaderCompleteCallback(const dmResource::PreloaderCompleteCallbackParams* params)
 {
@@ -696,6 +811,39 @@ TEST_P(GetResourceTest, PreloadGet)
     dmResource::Release(m_Factory, resource);
 }
 
+TEST_P(GetResourceTest, PreloadGetThreadSafeCreate)
+{
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::SetTypeFlags(m_Factory, "foo", RESOURCE_TYPE_FLAGS_THREAD_SAFE_CREATE));
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::SetTypeFlags(m_Factory, "cont", RESOURCE_TYPE_FLAGS_THREAD_SAFE_CREATE));
+    ASSERT_EQ(dmResource::RESULT_UNKNOWN_RESOURCE_TYPE, dmResource::SetTypeFlags(m_Factory, "bar", RESOURCE_TYPE_FLAGS_THREAD_SAFE_CREATE));
+
+    dmResource::HPreloader pr = dmResource::NewPreloader(m_Factory, m_ResourceName);
+    dmResource::Result r;
+    for (uint32_t i=0;i<33;i++)
+    {
+        r = dmResource::UpdatePreloader(pr, 0, 0, 30*1000);
+        if (r == dmResource::RESULT_PENDING)
+            dmTime::Sleep(30000);
+        else
+            break;
+    }
+    ASSERT_EQ(dmResource::RESULT_OK, r);
+
+    TestResourceContainer* resource = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, m_ResourceName, (void**) &resource));
+    ASSERT_EQ(resource->m_Resources.size(), m_FooResourceCreateCallCount);
+    ASSERT_EQ(1U, m_ResourceContainerCreateCallCount);
+    // The container hints its children and must be created on the main thread, while the children
+    // (without preload function) are created on the loader threads
+#if !defined(__EMSCRIPTEN__)
+    ASSERT_EQ((int32_t) m_FooResourceCreateCallCount, m_FooResourceCreateLoaderThreadCount);
+#endif
+    ASSERT_EQ(m_FooResourceCreateCallCount, m_FooResourcePostCreateCallCount);
+
+    dmResource::DeletePreloader(pr);
+    dmResource::Release(m_Factory, resource);
+}
+
 TEST_P(GetResourceTest, PreloadGetList)
 {
     const char* resource_names_list[] = { m_ResourceName, "/test_ref.cont" };
@@ -824,7 +972,7 @@ TEST_P(GetResourceTest, PreloadGetParallell)
 
 TEST_P(GetResourceTest, PreloadGetManyRefs)
 {
-    // this has more references than the preloader can fit into its tree
+    // this has more references than the initial size of the preloader tree
     dmResource::HPreloader pr = dmResource::NewPreloader(m_Factory, "/many_refs.cont");
 
     dmResource::Result r;
@@ -842,6 +990,48 @@ TEST_P(GetResourceTest, PreloadGetManyRefs)
 }
 
 
+TEST_P(GetResourceTest, PreloadGetParallellBudget)
+{
+    // The preloaders share a budget of one load in flight
+    dmResource::SetPreloadBudget(m_Factory, 1);
+
+    const uint32_t n = 4;
+    dmResource::HPreloader pr[n];
+    for (uint32_t j=0;j<n;j++)
+    {
+        pr[j] = dmResource::NewPreloader(m_Factory, m_ResourceName);
+        ASSERT_EQ(dmResource::RESULT_OK, dmResource::SetPreloaderPriority(pr[j], "foo", 1));
+    }
+    ASSERT_EQ(dmResource::RESULT_UNKNOWN_RESOURCE_TYPE, dmResource::SetPreloaderPriority(pr[0], "bar", 1));
+
+    bool done;
+    for (uint32_t j=0;j<100;j++)
+    {
+        done = true;
+        for (uint32_t k=0;k<n;k++)
+        {
+            dmResource::Result r = dmResource::UpdatePreloader(pr[k], 0, 0, 2000);
+            if (r == dmResource::RESULT_PENDING)
+            {
+                done = false;
+                continue;
+            }
+            ASSERT_EQ(dmResource::RESULT_OK, r);
+        }
+        if (done)
+        {
+            break;
+        }
+    }
+    ASSERT_TRUE(done);
+
+    for (uint32_t j=0;j<n;j++)
+    {
+        dmResource::DeletePreloader(pr[j]);
+    }
+    dmResource::SetPreloadBudget(m_Factory, 0);
+}
+
 TEST_P(GetResourceTest, PreloadGetAbort)
 {
     // Must not leak or crash
@@ -1052,6 +1242,69 @@ TEST(RecreateTest, RecreateTest)
     dmResource::DeleteFactory(factory);
 }
 
+TEST(LoadOrderTest, LoadOrderTest)
+{
+    const char* tmp_dir = 0;
+#if defined(__NX__)
+    tmp_dir = "";
+#else
+    tmp_dir = ".";
+#endif
+
+    const char* resource_names[] = { "/__testloadorder_b__.foo", "/__testloadorder_a__.foo" };
+    char paths[2][512];
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        char file_name[512];
+        dmSnPrintf(file_name, sizeof(file_name), "%s/%s", tmp_dir, resource_names[i]);
+        MakeHostPath(paths[i], sizeof(paths[i]), file_name);
+
+        FILE* f = fopen(paths[i], "wb");
+        ASSERT_NE((FILE*) 0, f);
+        fprintf(f, "%u", i);
+        fclose(f);
+    }
+
+    char load_order_file_name[512];
+    dmSnPrintf(load_order_file_name, sizeof(load_order_file_name), "%s/%s", tmp_dir, "__testloadorder__.txt");
+    char load_order_path[512];
+    MakeHostPath(load_order_path, sizeof(load_order_path), load_order_file_name);
+
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_LoadOrderPath = load_order_path;
+    dmResource::HFactory factory = dmResource::NewFactory(&params, tmp_dir);
+    ASSERT_NE((void*) 0, factory);
+
+    dmResource::Result e = dmResource::RegisterType(factory, "foo", 0, 0, &RecreateResourceCreate, 0, &RecreateResourceDestroy, 0);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+
+    // Resources are recorded once, in the order they are first loaded
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            int* resource;
+            ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(factory, resource_names[i], (void**) &resource));
+            ASSERT_EQ((int) i, *resource);
+            dmResource::Release(factory, resource);
+        }
+    }
+    dmResource::DeleteFactory(factory);
+
+    FILE* f = fopen(load_order_path, "rb");
+    ASSERT_NE((FILE*) 0, f);
+    char buffer[256];
+    size_t n = fread(buffer, 1, sizeof(buffer) - 1, f);
+    buffer[n] = 0;
+    fclose(f);
+    ASSERT_STREQ("/__testloadorder_b__.foo\n/__testloadorder_a__.foo\n", buffer);
+
+    dmSys::Unlink(load_order_path);
+    dmSys::Unlink(paths[0]);
+    dmSys::Unlink(paths[1]);
+}
+
 volatile bool SendReloadDone = false;
 void SendReloadThread(void*)
 {
@@ -1380,6 +1633,84 @@ TEST(RecreateTest, ReloadCallbackTest)
     dmResource::DeleteFactory(factory);
 }
 
+dmResource::Result PatchResourcePatch(const dmResource::ResourcePatchParams& params)
+{
+    if (params.m_PatchSize != sizeof(int))
+        return dmResource::RESULT_NOT_SUPPORTED;
+    memcpy(params.m_Resource->m_Resource, params.m_Patch, sizeof(int));
+    return dmResource::RESULT_OK;
+}
+
+TEST(RecreateTest, PatchTest)
+{
+    const char* tmp_dir = 0;
+#if defined(_MSC_VER)
+    tmp_dir = ".";
+#elif defined(__NX__)
+    tmp_dir = "";
+#else
+    tmp_dir = ".";
+#endif
+
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_Flags = RESOURCE_FACTORY_FLAGS_RELOAD_SUPPORT;
+    dmResource::HFactory factory = dmResource::NewFactory(&params, tmp_dir);
+    ASSERT_NE((void*) 0, factory);
+
+    dmResource::Result e;
+    e = dmResource::RegisterType(factory, "foo", 0, 0, &RecreateResourceCreate, 0, &RecreateResourceDestroy, &RecreateResourceRecreate);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    e = dmResource::SetPatchFunction(factory, "foo", &PatchResourcePatch);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+
+    const char* resource_name = "/__testpatch__.foo";
+    char file_name[512];
+    dmSnPrintf(file_name, sizeof(file_name), "%s/%s", tmp_dir, resource_name);
+
+    char host_name[512];
+    const char* path = MakeHostPath(host_name, sizeof(host_name), file_name);
+
+    FILE* f;
+
+    f = fopen(path, "wb");
+    ASSERT_NE((FILE*) 0, f);
+    fprintf(f, "123");
+    fclose(f);
+
+    int* resource;
+    dmResource::Result fr = dmResource::Get(factory, resource_name, (void**) &resource);
+    ASSERT_EQ(dmResource::RESULT_OK, fr);
+
+    CallbackUserData user_data;
+    dmResource::RegisterResourceReloadedCallback(factory, ReloadCallback, &user_data);
+
+    // Applied in-place, the file isn't read
+    int patch = 456;
+    dmResource::Result rr = dmResource::PatchResource(factory, resource_name, &patch, sizeof(patch), 0);
+    ASSERT_EQ(dmResource::RESULT_OK, rr);
+    ASSERT_EQ(456, *resource);
+    ASSERT_NE((void*)0, user_data.m_Descriptor);
+    ASSERT_EQ(0, strcmp(resource_name, user_data.m_Name));
+
+    // A patch that can't be applied fully reloads the resource
+    user_data = CallbackUserData();
+    rr = dmResource::PatchResource(factory, resource_name, "x", 1, 0);
+    ASSERT_EQ(dmResource::RESULT_OK, rr);
+    ASSERT_EQ(123, *resource);
+    ASSERT_NE((void*)0, user_data.m_Descriptor);
+
+    dmResource::UnregisterResourceReloadedCallback(factory, ReloadCallback, &user_data);
+
+    rr = dmResource::PatchResource(factory, "/__notloaded__.foo", &patch, sizeof(patch), 0);
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, rr);
+
+    dmSys::Unlink(path);
+
+    dmResource::Release(factory, resource);
+    dmResource::DeleteFactory(factory);
+}
+
 TEST(OverflowTest, OverflowTest)
 {
     const char* test_dir = "./build/default/src/test";
@@ -1512,6 +1843,14 @@ TEST_F(ResourceTest, ManifestBundledResourcesVerificationFail)
     result = dmResource::VerifyResourcesBundled(entries, manifest->m_DDFData->m_Resources.m_Count+1, hash_len, archive);
     ASSERT_EQ(dmResource::RESULT_INVALID_DATA, result);
 
+    // Same result when the entries are verified in parallel on the job system
+    dmJob::NewContextParams job_params;
+    job_params.m_WorkerCount = 4;
+    dmJob::HContext job_context = dmJob::NewContext(job_params);
+    result = dmResource::VerifyResourcesBundled(entries, manifest->m_DDFData->m_Resources.m_Count+1, hash_len, archive, job_context);
+    ASSERT_EQ(dmResource::RESULT_INVALID_DATA, result);
+    dmJob::DeleteContext(job_context);
+
     // Clean up deep-copied resource entries
     for (uint32_t i = 0; i < entry_count + 1; ++i)
     {
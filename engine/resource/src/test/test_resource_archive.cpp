@@ -15,6 +15,7 @@
 #include "../resource_archive_private.h"
 #include <dlib/dstrings.h>
 #include <dlib/endian.h>
+#include <dlib/lz4.h>
 
 // TODO: replace with dmEndian
 #if defined(_WIN32)
@@ -386,6 +387,71 @@ TEST(dmResourceArchive, ShiftInsertResource_InsertIssue)
     remove(path);
 }
 
+TEST(dmResourceArchive, NewArchiveIndexWithResources)
+{
+    char host_name[512];
+    const char* path = MakeHostPath(host_name, sizeof(host_name), "test_resource_liveupdate.arcd");
+    char index_host_name[512];
+    const char* index_path = MakeHostPath(index_host_name, sizeof(index_host_name), "test_resource_liveupdate.arci.tmp");
+
+    FILE* resource_file = fopen(path, "wb");
+    ASSERT_NE((FILE*)0, resource_file);
+
+    dmResourceArchive::LiveUpdateResource* resource = (dmResourceArchive::LiveUpdateResource*)malloc(sizeof(dmResourceArchive::LiveUpdateResource));
+    resource->m_Header = (dmResourceArchive::LiveUpdateResourceHeader*)malloc(sizeof(dmResourceArchive::LiveUpdateResourceHeader));
+    PopulateLiveUpdateResource(resource);
+
+    dmResourceArchive::HArchiveIndexContainer archive = new dmResourceArchive::ArchiveIndexContainer;
+    archive->m_ArchiveIndex = new dmResourceArchive::ArchiveIndex;
+    archive->m_ArchiveIndex->m_HashLength = dmEndian::ToHost(20U);
+    archive->m_IsMemMapped = true;
+    archive->m_ArchiveFileIndex = new dmResourceArchive::ArchiveFileIndex;
+    archive->m_ArchiveFileIndex->m_ResourceSize = 0;
+    archive->m_ArchiveFileIndex->m_ResourceData = 0;
+    archive->m_ArchiveFileIndex->m_FileResourceData = resource_file;
+    archive->m_ArchiveFileIndex->m_IsMemMapped = false;
+
+    dmResourceArchive::SetDefaultReader(archive);
+
+    const uint8_t hash1[20] = {0x07, 0xf1, 0x28, 0x4d, 0x53, 0x0d, 0xeb, 0x40, 0x1d, 0xa0, 0xed, 0x14, 0x2d, 0xa5, 0x0d, 0x57, 0x24, 0xcb, 0x04, 0xcd};
+    const uint8_t hash2[20] = {0x91, 0x70, 0xa1, 0x2e, 0x26, 0x6e, 0xc4, 0x1f, 0x55, 0x75, 0xbb, 0x8f, 0x83, 0x7d, 0x0f, 0x4b, 0xb6, 0xca, 0xb0, 0x3f};
+    const uint8_t hash3[20] = {0x3b, 0xe3, 0x2c, 0xfd, 0x80, 0xb4, 0x01, 0x6a, 0x9e, 0xba, 0xf1, 0xc7, 0x24, 0x93, 0x96, 0xef, 0x60, 0x8c, 0x95, 0xbd};
+
+    // The duplicate is rejected and the failed resource is skipped
+    const uint8_t* hashes[] = {hash1, hash2, hash1, hash3, hash2};
+    const dmResourceArchive::LiveUpdateResource* resources[] = {resource, resource, resource, resource, resource};
+    dmResourceArchive::Result results[] = {dmResourceArchive::RESULT_OK, dmResourceArchive::RESULT_OK, dmResourceArchive::RESULT_OK, dmResourceArchive::RESULT_OK, dmResourceArchive::RESULT_UNKNOWN};
+
+    dmResourceArchive::HArchiveIndex new_index = 0;
+    dmResourceArchive::Result result = dmResourceArchive::NewArchiveIndexWithResources(archive, index_path, hashes, 20, resources, 5, results, new_index);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    ASSERT_NE((dmResourceArchive::HArchiveIndex)0, new_index);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, results[0]);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, results[1]);
+    ASSERT_EQ(dmResourceArchive::RESULT_ALREADY_STORED, results[2]);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, results[3]);
+    ASSERT_EQ(dmResourceArchive::RESULT_UNKNOWN, results[4]);
+
+    delete archive->m_ArchiveIndex;
+    dmResourceArchive::SetNewArchiveIndex(archive, new_index, true);
+    ASSERT_EQ(3U, dmResourceArchive::GetEntryCount(archive));
+    ASSERT_EQ(0, VerifyArchiveIndex(archive));
+
+    dmResourceArchive::EntryData entry;
+    dmResourceArchive::HArchiveIndexContainer entryarchive = 0;
+    result = dmResourceArchive::FindEntry(archive, hash3, sizeof(hash3), &entryarchive, &entry);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    ASSERT_EQ(resource->m_Count, entry.m_ResourceSize);
+    ASSERT_EQ(2 * resource->m_Count, entry.m_ResourceDataOffset);
+
+    free(resource->m_Header);
+    free(resource);
+    dmResourceArchive::Delete(archive); // fclose on the FILE*
+    FreeMutableIndexData((void*&)new_index);
+    remove(path);
+    remove(index_path);
+}
+
 TEST(dmResourceArchive, NewArchiveIndexFromCopy)
 {
     uint32_t single_entry_offset = dmResourceArchive::MAX_HASH;
@@ -762,6 +828,109 @@ TEST(dmResourceArchive, Wrap_Compressed)
     dmResourceArchive::Delete(archive);
 }
 
+TEST(dmResourceArchive, Wrap_Dictionary)
+{
+    const char* dictionary = "material: \"/builtins/materials/sprite.material\" blend_mode: BLEND_MODE_ALPHA";
+    const char* data = "tile_set: \"/main/main.atlas\" material: \"/builtins/materials/sprite.material\"";
+    uint32_t dictionary_size = strlen(dictionary);
+    uint32_t data_size = strlen(data) + 1;
+
+    char compressed[256];
+    int compressed_size;
+    ASSERT_EQ(dmLZ4::RESULT_OK, dmLZ4::CompressBufferWithDictionary(data, data_size, compressed, &compressed_size, dictionary, dictionary_size));
+
+    // Index with a single entry, followed by the dictionary
+    uint8_t DM_ALIGNED(16) index[512] = { 0 };
+    uint32_t hash_offset = sizeof(dmResourceArchive::ArchiveIndex);
+    uint32_t entry_offset = hash_offset + dmResourceArchive::MAX_HASH;
+    uint32_t dictionary_offset = entry_offset + sizeof(dmResourceArchive::EntryData);
+    uint32_t index_size = dictionary_offset + sizeof(uint32_t) + dictionary_size;
+    ASSERT_LE(index_size, sizeof(index));
+
+    dmResourceArchive::ArchiveIndex* ai = (dmResourceArchive::ArchiveIndex*) index;
+    ai->m_Version = htonl(dmResourceArchive::VERSION);
+    ai->m_DictionaryOffset = htonl(dictionary_offset);
+    ai->m_EntryDataCount = htonl(1);
+    ai->m_EntryDataOffset = htonl(entry_offset);
+    ai->m_HashOffset = htonl(hash_offset);
+    ai->m_HashLength = htonl(sizeof(content_hash[0]));
+    memcpy(index + hash_offset, content_hash[0], sizeof(content_hash[0]));
+    dmResourceArchive::EntryData* e = (dmResourceArchive::EntryData*) (index + entry_offset);
+    e->m_ResourceDataOffset = 0;
+    e->m_ResourceSize = htonl(data_size);
+    e->m_ResourceCompressedSize = htonl(compressed_size);
+    e->m_Flags = htonl(dmResourceArchive::ENTRY_FLAG_COMPRESSED | dmResourceArchive::ENTRY_FLAG_DICTIONARY);
+    *(uint32_t*)(index + dictionary_offset) = htonl(dictionary_size);
+    memcpy(index + dictionary_offset + sizeof(uint32_t), dictionary, dictionary_size);
+
+    dmResourceArchive::HArchiveIndexContainer archive = 0;
+    dmResourceArchive::Result result = dmResourceArchive::WrapArchiveBuffer(index, index_size, true, compressed, compressed_size, true, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    dmResourceArchive::SetDefaultReader(archive);
+
+    dmResourceArchive::HArchiveIndexContainer entryarchive;
+    dmResourceArchive::EntryData entry;
+    result = dmResourceArchive::FindEntry(archive, content_hash[0], sizeof(content_hash[0]), &entryarchive, &entry);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    ASSERT_TRUE(dmResourceArchive::IsEntryEncoded(&entry));
+
+    char buffer[256] = { 0 };
+    result = dmResourceArchive::Read(entryarchive, content_hash[0], sizeof(content_hash[0]), &entry, buffer);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    ASSERT_STREQ(data, buffer);
+
+    // Split read and decode, as done by the load queue
+    char stored[256];
+    memset(buffer, 0, sizeof(buffer));
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, dmResourceArchive::ReadEntryDataFromArchive(entryarchive, &entry, stored));
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, dmResourceArchive::DecodeEntryData(entryarchive, &entry, stored, buffer));
+    ASSERT_STREQ(data, buffer);
+
+    dmResourceArchive::Delete(archive);
+}
+
+TEST(dmResourceArchive, GetMappedEntryData)
+{
+    dmResourceArchive::HArchiveIndexContainer archive = 0;
+    dmResourceArchive::Result result = dmResourceArchive::WrapArchiveBuffer((void*) RESOURCES_ARCI, RESOURCES_ARCI_SIZE, true, RESOURCES_ARCD, RESOURCES_ARCD_SIZE, true, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    dmResourceArchive::SetDefaultReader(archive);
+
+    dmResourceArchive::HArchiveIndexContainer entryarchive;
+    dmResourceArchive::EntryData entry;
+    for (uint32_t i = 0; i < (sizeof(path_hash) / sizeof(path_hash[0])); ++i)
+    {
+        if (IsLiveUpdateResource(path_hash[i])) continue;
+
+        result = dmResourceArchive::FindEntry(archive, content_hash[i], sizeof(content_hash[i]), &entryarchive, &entry);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+
+        // Uncompressed entries are used in place
+        const char* data = (const char*) dmResourceArchive::GetMappedEntryData(entryarchive, &entry);
+        ASSERT_NE((const char*) 0, data);
+        ASSERT_LE(strlen(content[i]), entry.m_ResourceSize);
+        ASSERT_EQ(0, memcmp(content[i], data, strlen(content[i])));
+    }
+    dmResourceArchive::Delete(archive);
+
+    result = dmResourceArchive::WrapArchiveBuffer((void*) RESOURCES_COMPRESSED_ARCI, RESOURCES_COMPRESSED_ARCI_SIZE, true, (void*) RESOURCES_COMPRESSED_ARCD, RESOURCES_COMPRESSED_ARCD_SIZE, true, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    dmResourceArchive::SetDefaultReader(archive);
+
+    for (uint32_t i = 0; i < (sizeof(path_hash) / sizeof(path_hash[0])); ++i)
+    {
+        if (IsLiveUpdateResource(path_hash[i])) continue;
+
+        result = dmResourceArchive::FindEntry(archive, compressed_content_hash[i], sizeof(compressed_content_hash[i]), &entryarchive, &entry);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+
+        // Entries that need decoding must be read
+        const void* data = dmResourceArchive::GetMappedEntryData(entryarchive, &entry);
+        ASSERT_EQ(dmResourceArchive::IsEntryEncoded(&entry), data == 0);
+    }
+    dmResourceArchive::Delete(archive);
+}
+
 TEST(dmResourceArchive, LoadFromDisk)
 {
     dmResourceArchive::HArchiveIndexContainer archive = 0;
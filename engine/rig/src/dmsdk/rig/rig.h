@@ -34,6 +34,11 @@
 
 using namespace Vectormath::Aos;
 
+namespace dmJob
+{
+    typedef struct Context* HContext;
+}
+
 namespace dmRig
 {
     using namespace dmRigDDF;
@@ -68,9 +73,12 @@ namespace dmRig
         PLAYBACK_COUNT = 7,
     };
 
+    struct BakedAnimation;
+
     struct RigPlayer
     {
         RigPlayer() : m_Animation(0x0),
+                      m_BakedAnimation(0x0),
                       m_AnimationId(0x0),
                       m_Cursor(0.0f),
                       m_Playback(dmRig::PLAYBACK_ONCE_FORWARD),
@@ -79,6 +87,8 @@ namespace dmRig
                       m_Initial(0x1) {};
         /// Currently playing animation
         const dmRigDDF::RigAnimation* m_Animation;
+        /// The baked version of the animation, if the instance has a baked animation set
+        const BakedAnimation*         m_BakedAnimation;
         dmhash_t                      m_AnimationId;
         /// Playback cursor in the interval [0,duration]
         float                         m_Cursor;
@@ -208,14 +218,74 @@ namespace dmRig
         float nz;
     };
 
-    struct RigContext
+    // Static vertex layout for models skinned in the vertex shader
+    struct RigSkinnedModelVertex
+    {
+        float x;
+        float y;
+        float z;
+        float u;
+        float v;
+        float nx;
+        float ny;
+        float nz;
+        float bone_weights[4];
+        float bone_indices[4];
+    };
+
+    // A quantized bone track sample of a baked animation. Translation and scale are stored relative to
+    // the range of the track, the rotation as a signed normalized quaternion.
+    struct BakedBoneSample
+    {
+        uint16_t m_Translation[3];
+        uint16_t m_Scale[3];
+        int16_t  m_Rotation[4];
+    };
+
+    struct BakedTrack
+    {
+        Vector3  m_TranslationMin;
+        Vector3  m_TranslationStep;
+        Vector3  m_ScaleMin;
+        Vector3  m_ScaleStep;
+        uint32_t m_PoseIndex;
+        uint8_t  m_HasTranslation : 1;
+        uint8_t  m_HasRotation : 1;
+        uint8_t  m_HasScale : 1;
+    };
+
+    struct BakedAnimation
+    {
+        /// Range in BakedAnimationSet::m_Tracks
+        uint32_t m_FirstTrack;
+        uint32_t m_TrackCount;
+        /// Start in BakedAnimationSet::m_Samples, the samples of a frame are stored together, one per track
+        uint32_t m_FirstSample;
+        uint32_t m_FrameCount;
+    };
+
+    // The bone tracks of an animation set resampled into one shared buffer of quantized samples, see BakeAnimationSet.
+    // The animations are indexed like the animations of the animation set.
+    struct BakedAnimationSet
+    {
+        const dmRigDDF::AnimationSet* m_AnimationSet;
+        dmArray<BakedAnimation>       m_Animations;
+        dmArray<BakedTrack>           m_Tracks;
+        dmArray<BakedBoneSample>      m_Samples;
+    };
+
+    // Temporary scratch buffers used while animating and skinning an instance.
+    // The calling thread uses the ones in the RigContext, each job worker has its own set.
+    struct RigScratch
     {
-        dmObjectPool<HRigInstance>      m_Instances;
         // Temporary scratch buffers used for store pose as transform and matrices
         // (avoids modifying the real pose transform data during rendering).
         dmArray<dmTransform::Transform> m_ScratchPoseTransformBuffer;
         dmArray<Matrix4>                m_ScratchInfluenceMatrixBuffer;
         dmArray<Matrix4>                m_ScratchPoseMatrixBuffer;
+        // Skinning palettes with the model and normal matrices baked in, see rig_skin.h
+        dmArray<float>                  m_ScratchPositionPalette;
+        dmArray<float>                  m_ScratchNormalPalette;
         // Temporary scratch buffers used when transforming the vertex buffer,
         // used to creating primitives from indices.
         dmArray<Vector3>                m_ScratchPositionBuffer;
@@ -225,9 +295,20 @@ namespace dmRig
         dmArray<int32_t>                m_ScratchDrawOrderUnchanged;
     };
 
+    struct RigContext : RigScratch
+    {
+        dmObjectPool<HRigInstance>      m_Instances;
+        // Optional, when set the instances are animated and skinned on the job workers
+        dmJob::HContext                 m_JobContext;
+        // One set of scratch buffers per job worker
+        RigScratch*                     m_WorkerScratch;
+        uint32_t                        m_WorkerCount;
+    };
+
     struct NewContextParams {
-        HRigContext* m_Context;
-        uint32_t     m_MaxRigInstanceCount;
+        HRigContext*    m_Context;
+        uint32_t        m_MaxRigInstanceCount;
+        dmJob::HContext m_JobContext;
     };
 
     typedef void (*RigEventCallback)(RigEventType, void*, void*, void*);
@@ -244,6 +325,8 @@ namespace dmRig
         const dmRigDDF::AnimationSet* m_AnimationSet;
         const dmArray<uint32_t>*      m_PoseIdxToInfluence;
         const dmArray<uint32_t>*      m_TrackIdxToPose;
+        /// Optional, the bone tracks are read from the baked animations instead
+        const BakedAnimationSet*      m_BakedAnimationSet;
         RigPoseCallback               m_PoseCallback;
         void*                         m_PoseCBUserData1;
         void*                         m_PoseCBUserData2;
@@ -269,12 +352,20 @@ namespace dmRig
         RigMeshType                   m_MeshType;
         // Max bone count used by skeleton (if it is used) and meshset
         uint32_t                      m_MaxBoneCount;
+        /// Number of updates per pose evaluation, 0 or 1 evaluates the pose every update
+        uint8_t                       m_UpdateInterval;
+        /// Updates left until the pose is evaluated again
+        uint8_t                       m_UpdateCountdown;
         /// Current player index
         uint8_t                       m_CurrentPlayer : 1;
         /// Whether we are currently X-fading or not
         uint8_t                       m_Blending : 1;
         uint8_t                       m_Enabled : 1;
         uint8_t                       m_DoRender : 1;
+        /// The pose is kept as is while the players keep running, e.g. while the instance is culled
+        uint8_t                       m_PoseFrozen : 1;
+        /// The pose is not evaluated in the current update
+        uint8_t                       m_SkipPose : 1;
     };
 
     struct InstanceCreateParams
@@ -293,6 +384,8 @@ namespace dmRig
 
         const dmArray<uint32_t>*      m_PoseIdxToInfluence;
         const dmArray<uint32_t>*      m_TrackIdxToPose;
+        /// Optional, shared by the instances using the same animation set, see BakeAnimationSet
+        const BakedAnimationSet*      m_BakedAnimationSet;
 
         RigPoseCallback               m_PoseCallback;
         void*                         m_PoseCBUserData1;
@@ -304,6 +397,17 @@ namespace dmRig
         bool                          m_ForceAnimatePose;
     };
 
+    struct RigVertexDataEntry
+    {
+        Matrix4      m_ModelMatrix;
+        Matrix4      m_NormalMatrix;
+        Vector4      m_Color;
+        HRigInstance m_Instance;
+        void*        m_VertexDataOut;
+        /// Set by GenerateVertexDataBatch to the end of the written vertex data
+        void*        m_VertexDataEnd;
+    };
+
     struct InstanceDestroyParams
     {
         HRigContext  m_Context;
@@ -322,7 +426,13 @@ namespace dmRig
     dmhash_t GetAnimation(HRigInstance instance);
 
     void* GenerateVertexData(HRigContext context, HRigInstance instance, const Matrix4& model_matrix, const Matrix4& normal_matrix, const Vector4 color, RigVertexFormat vertex_format, void* vertex_data_out);
+    // Generates the vertex data of several instances, split across the job workers if the context has any.
+    // Each entry must have room for GetVertexCount() vertices.
+    void GenerateVertexDataBatch(HRigContext context, RigVertexDataEntry* entries, uint32_t entry_count, RigVertexFormat vertex_format);
     uint32_t GetVertexCount(HRigInstance instance);
+    // Writes the skinning matrices of the instance for shader skinning, indexed like the mesh bone indices.
+    // Each bone takes three float4 rows of its model space affine matrix. Returns the number of bones written.
+    uint32_t GenerateSkinPalette(HRigContext context, HRigInstance instance, float* palette_out, uint32_t max_bone_count);
 
     Result SetMesh(HRigInstance instance, dmhash_t mesh_id);
     dmhash_t GetMesh(HRigInstance instance);
@@ -336,6 +446,11 @@ namespace dmRig
     IKTarget* GetIKTarget(HRigInstance instance, dmhash_t constraint_id);
     bool ResetIKTarget(HRigInstance instance, dmhash_t constraint_id);
     void SetEnabled(HRigInstance instance, bool enabled);
+    // Evaluates the pose only every interval:th update, the animations still advance every update.
+    // Used to lower the animation cost of distant instances, 1 evaluates the pose every update.
+    void SetUpdateInterval(HRigInstance instance, uint32_t interval);
+    // Keeps the current pose while the animations advance, e.g. while the instance is not visible
+    void SetPoseFrozen(HRigInstance instance, bool frozen);
     bool GetEnabled(HRigInstance instance);
     bool IsValid(HRigInstance instance);
     uint32_t GetBoneCount(HRigInstance instance);
@@ -345,6 +460,9 @@ namespace dmRig
     // Util function used to fill a bind pose array from skeleton data
     // used in rig tests and loading rig resources.
     void CreateBindPose(dmRigDDF::Skeleton& skeleton, dmArray<RigBone>& bind_pose);
+    // Bakes the bone tracks of the animation set, at the sample rate of each animation, for instances
+    // created with InstanceCreateParams::m_BakedAnimationSet. The IK and mesh tracks are not baked.
+    void BakeAnimationSet(const dmRigDDF::AnimationSet& animation_set, const dmArray<uint32_t>& track_idx_to_pose, BakedAnimationSet& baked_set);
     void FillBoneListArrays(const dmRigDDF::MeshSet& meshset, const dmRigDDF::AnimationSet& animationset, const dmRigDDF::Skeleton& skeleton, dmArray<uint32_t>& track_idx_to_pose, dmArray<uint32_t>& pose_idx_to_influence);
 }
 
@@ -11,7 +11,9 @@
 // specific language governing permissions and limitations under the License.
 
 #include "rig.h"
+#include "rig_skin.h"
 
+#include <dlib/job.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
 #include <dlib/vmath.h>
@@ -30,6 +32,9 @@ namespace dmRig
     static const float white[] = {1.0f, 1.0f, 1.0, 1.0f};
 
     static void DoAnimate(HRigContext context, RigInstance* instance, float dt);
+    static void UpdatePlayers(RigInstance* instance, float dt);
+    static void AnimatePose(RigScratch* scratch, RigInstance* instance);
+    static void ApplyIK(RigInstance* instance);
     static bool DoPostUpdate(RigInstance* instance);
     static void UpdateSlotDrawOrder(dmArray<int32_t>& draw_order, dmArray<int32_t>& deltas, int changed, dmArray<int32_t>& unchanged);
 
@@ -45,16 +50,28 @@ namespace dmRig
         context->m_ScratchPoseTransformBuffer.SetCapacity(0);
         context->m_ScratchPoseMatrixBuffer.SetCapacity(0);
 
+        context->m_JobContext = params.m_JobContext;
+        context->m_WorkerCount = params.m_JobContext ? dmJob::GetWorkerCount(params.m_JobContext) : 0;
+        context->m_WorkerScratch = context->m_WorkerCount ? new RigScratch[context->m_WorkerCount] : 0x0;
+
         return dmRig::RESULT_OK;
     }
 
     void DeleteContext(HRigContext context)
     {
         if (context) {
+            delete [] context->m_WorkerScratch;
             delete context;
         }
     }
 
+    // Returns the scratch buffers of the calling thread
+    static RigScratch* GetScratch(HRigContext context)
+    {
+        uint32_t index = context->m_JobContext ? dmJob::GetThreadIndex(context->m_JobContext) : 0;
+        return index == 0 ? (RigScratch*) context : &context->m_WorkerScratch[index - 1];
+    }
+
     static const dmRigDDF::RigAnimation* FindAnimation(const dmRigDDF::AnimationSet* anim_set, dmhash_t animation_id)
     {
         if(anim_set == 0x0)
@@ -135,6 +152,11 @@ namespace dmRig
         player->m_BlendFinished = blend_duration > 0.0f ? 0 : 1;
         player->m_AnimationId = animation_id;
         player->m_Animation = anim;
+        player->m_BakedAnimation = 0x0;
+        if (instance->m_BakedAnimationSet != 0x0 && instance->m_BakedAnimationSet->m_AnimationSet == instance->m_AnimationSet)
+        {
+            player->m_BakedAnimation = &instance->m_BakedAnimationSet->m_Animations[anim - instance->m_AnimationSet->m_Animations.m_Data];
+        }
         player->m_Playing = 1;
         player->m_Playback = playback;
 
@@ -438,6 +460,52 @@ namespace dmRig
         return slerp(frac, Quat(data[i+0], data[i+1], data[i+2], data[i+3]), Quat(data[i+0+4], data[i+1+4], data[i+2+4], data[i+3+4]));
     }
 
+    static Vector3 DecodeBakedVec3(const uint16_t* data, const Vector3& min, const Vector3& step)
+    {
+        return min + mulPerElem(Vector3(data[0], data[1], data[2]), step);
+    }
+
+    static Quat DecodeBakedQuat(const int16_t* data)
+    {
+        return Quat(data[0], data[1], data[2], data[3]) * (1.0f / 32767.0f);
+    }
+
+    // The baked counterpart of the bone track sampling in ApplyAnimation. The rotations are
+    // baked along the shortest arc, so a normalized lerp is used between the frames.
+    static void ApplyBakedAnimation(const BakedAnimationSet& baked_set, const BakedAnimation* animation, uint32_t sample, float fraction, dmArray<dmTransform::Transform>& pose, float blend_weight)
+    {
+        if (animation->m_FrameCount == 0)
+            return;
+        uint32_t track_count = animation->m_TrackCount;
+        uint32_t frame0 = dmMath::Min(sample, animation->m_FrameCount - 1);
+        uint32_t frame1 = dmMath::Min(sample + 1, animation->m_FrameCount - 1);
+        const BakedTrack* tracks = &baked_set.m_Tracks[animation->m_FirstTrack];
+        const BakedBoneSample* samples0 = &baked_set.m_Samples[animation->m_FirstSample + frame0 * track_count];
+        const BakedBoneSample* samples1 = &baked_set.m_Samples[animation->m_FirstSample + frame1 * track_count];
+        for (uint32_t ti = 0; ti < track_count; ++ti)
+        {
+            const BakedTrack& track = tracks[ti];
+            const BakedBoneSample& s0 = samples0[ti];
+            const BakedBoneSample& s1 = samples1[ti];
+            dmTransform::Transform& transform = pose[track.m_PoseIndex];
+            if (track.m_HasTranslation)
+            {
+                Vector3 t = lerp(fraction, DecodeBakedVec3(s0.m_Translation, track.m_TranslationMin, track.m_TranslationStep), DecodeBakedVec3(s1.m_Translation, track.m_TranslationMin, track.m_TranslationStep));
+                transform.SetTranslation(lerp(blend_weight, transform.GetTranslation(), t));
+            }
+            if (track.m_HasRotation)
+            {
+                Quat r = normalize(lerp(fraction, DecodeBakedQuat(s0.m_Rotation), DecodeBakedQuat(s1.m_Rotation)));
+                transform.SetRotation(slerp(blend_weight, transform.GetRotation(), r));
+            }
+            if (track.m_HasScale)
+            {
+                Vector3 sc = lerp(fraction, DecodeBakedVec3(s0.m_Scale, track.m_ScaleMin, track.m_ScaleStep), DecodeBakedVec3(s1.m_Scale, track.m_ScaleMin, track.m_ScaleStep));
+                transform.SetScale(lerp(blend_weight, transform.GetScale(), sc));
+            }
+        }
+    }
+
     static float CursorToTime(float cursor, float duration, bool backwards, bool once_pingpong)
     {
         float t = cursor;
@@ -514,7 +582,7 @@ namespace dmRig
         child_t.SetRotation( dmVMath::QuatFromAngle(2, childRotation) );
     }
 
-    static void ApplyAnimation(RigPlayer* player, dmArray<dmTransform::Transform>& pose, const dmArray<uint32_t>& track_idx_to_pose, dmArray<IKAnimation>& ik_animation, dmArray<MeshSlotPose>& mesh_slot_pose, bool update_draw_order, dmArray<int32_t>& draw_order, int& slot_changed, float blend_weight)
+    static void ApplyAnimation(RigPlayer* player, const BakedAnimationSet* baked_set, dmArray<dmTransform::Transform>& pose, const dmArray<uint32_t>& track_idx_to_pose, dmArray<IKAnimation>& ik_animation, dmArray<MeshSlotPose>& mesh_slot_pose, bool update_draw_order, dmArray<int32_t>& draw_order, int& slot_changed, float blend_weight)
     {
         const dmRigDDF::RigAnimation* animation = player->m_Animation;
         if (animation == 0x0)
@@ -528,26 +596,33 @@ namespace dmRig
         fraction -= sample;
         // Sample animation tracks
         uint32_t track_count = animation->m_Tracks.m_Count;
-        for (uint32_t ti = 0; ti < track_count; ++ti)
+        if (player->m_BakedAnimation != 0x0)
         {
-            const dmRigDDF::AnimationTrack* track = &animation->m_Tracks[ti];
-            uint32_t bone_index = track->m_BoneIndex;
-            if (bone_index >= track_idx_to_pose.Size()) {
-                continue;
-            }
-            uint32_t pose_index = track_idx_to_pose[bone_index];
-            dmTransform::Transform& transform = pose[pose_index];
-            if (track->m_Positions.m_Count > 0)
-            {
-                transform.SetTranslation(lerp(blend_weight, transform.GetTranslation(), SampleVec3(sample, fraction, track->m_Positions.m_Data)));
-            }
-            if (track->m_Rotations.m_Count > 0)
-            {
-                transform.SetRotation(slerp(blend_weight, transform.GetRotation(), SampleQuat(sample, fraction, track->m_Rotations.m_Data)));
-            }
-            if (track->m_Scale.m_Count > 0)
+            ApplyBakedAnimation(*baked_set, player->m_BakedAnimation, sample, fraction, pose, blend_weight);
+        }
+        else
+        {
+            for (uint32_t ti = 0; ti < track_count; ++ti)
             {
-                transform.SetScale(lerp(blend_weight, transform.GetScale(), SampleVec3(sample, fraction, track->m_Scale.m_Data)));
+                const dmRigDDF::AnimationTrack* track = &animation->m_Tracks[ti];
+                uint32_t bone_index = track->m_BoneIndex;
+                if (bone_index >= track_idx_to_pose.Size()) {
+                    continue;
+                }
+                uint32_t pose_index = track_idx_to_pose[bone_index];
+                dmTransform::Transform& transform = pose[pose_index];
+                if (track->m_Positions.m_Count > 0)
+                {
+                    transform.SetTranslation(lerp(blend_weight, transform.GetTranslation(), SampleVec3(sample, fraction, track->m_Positions.m_Data)));
+                }
+                if (track->m_Rotations.m_Count > 0)
+                {
+                    transform.SetRotation(slerp(blend_weight, transform.GetRotation(), SampleQuat(sample, fraction, track->m_Rotations.m_Data)));
+                }
+                if (track->m_Scale.m_Count > 0)
+                {
+                    transform.SetScale(lerp(blend_weight, transform.GetScale(), SampleVec3(sample, fraction, track->m_Scale.m_Data)));
+                }
             }
         }
 
@@ -601,184 +676,278 @@ namespace dmRig
         }
     }
 
+    struct AnimateContext
+    {
+        HRigContext     m_Context;
+        RigInstance**   m_Instances;
+    };
+
+    static void AnimatePoseRange(void* _ctx, uint32_t start, uint32_t end)
+    {
+        AnimateContext* ctx = (AnimateContext*) _ctx;
+        RigScratch* scratch = GetScratch(ctx->m_Context);
+        for (uint32_t i = start; i < end; ++i)
+        {
+            RigInstance* instance = ctx->m_Instances[i];
+            if (!instance->m_SkipPose) {
+                AnimatePose(scratch, instance);
+            }
+        }
+    }
+
+    // Decides whether the pose is evaluated in this update, see SetUpdateInterval and SetPoseFrozen
+    static bool SkipPose(RigInstance* instance)
+    {
+        if (instance->m_PoseFrozen)
+            return true;
+        if (instance->m_UpdateCountdown > 0) {
+            --instance->m_UpdateCountdown;
+            return true;
+        }
+        instance->m_UpdateCountdown = instance->m_UpdateInterval > 1 ? instance->m_UpdateInterval - 1 : 0;
+        return false;
+    }
+
     static void Animate(HRigContext context, float dt)
     {
         DM_PROFILE(Rig, "Animate");
 
         const dmArray<RigInstance*>& instances = context->m_Instances.m_Objects;
+
+        // The players post events to user callbacks, so they are updated on the calling thread
+        for (uint32_t i = 0; i < instances.Size(); ++i)
+        {
+            RigInstance* instance = instances[i];
+            UpdatePlayers(instance, dt);
+            instance->m_SkipPose = SkipPose(instance);
+        }
+
+        AnimateContext ctx;
+        ctx.m_Context = context;
+        ctx.m_Instances = instances.Begin();
         uint32_t n = instances.Size();
+        if (context->m_JobContext == 0 || n <= 1) {
+            AnimatePoseRange(&ctx, 0, n);
+        } else {
+            dmJob::HJob job = dmJob::ParallelFor(context->m_JobContext, AnimatePoseRange, &ctx, n, 4, dmJob::INVALID_JOB);
+            dmJob::Wait(context->m_JobContext, job);
+        }
+
+        // The IK targets are read through user callbacks as well
         for (uint32_t i = 0; i < n; ++i)
         {
-            RigInstance* instance = instances[i];
-            DoAnimate(context, instance, dt);
+            if (!instances[i]->m_SkipPose) {
+                ApplyIK(instances[i]);
+            }
         }
     }
 
     static void DoAnimate(HRigContext context, RigInstance* instance, float dt)
     {
-            // NOTE we previously checked for (!instance->m_Enabled || !instance->m_AddedToUpdate) here also
-            if (instance->m_Pose.Empty() || !instance->m_Enabled)
-                return;
+        UpdatePlayers(instance, dt);
+        AnimatePose(context, instance);
+        ApplyIK(instance);
+    }
 
-            const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
-            const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
-            const dmArray<uint32_t>& track_idx_to_pose = *instance->m_TrackIdxToPose;
-            dmArray<dmTransform::Transform>& pose = instance->m_Pose;
-            // Reset pose
-            uint32_t bone_count = pose.Size();
-            for (uint32_t bi = 0; bi < bone_count; ++bi)
-            {
-                pose[bi].SetIdentity();
-            }
-            // Reset IK animation
-            dmArray<IKAnimation>& ik_animation = instance->m_IKAnimation;
-            uint32_t ik_animation_count = ik_animation.Size();
-            for (uint32_t ii = 0; ii < ik_animation_count; ++ii)
+    static void UpdatePlayers(RigInstance* instance, float dt)
+    {
+        // NOTE we previously checked for (!instance->m_Enabled || !instance->m_AddedToUpdate) here also
+        if (instance->m_Pose.Empty() || !instance->m_Enabled)
+            return;
+
+        UpdateBlend(instance, dt);
+
+        RigPlayer* player = GetPlayer(instance);
+        if (instance->m_Blending)
+        {
+            float fade_rate = instance->m_BlendTimer / instance->m_BlendDuration;
+            for (uint32_t pi = 0; pi < 2; ++pi)
             {
-                const dmRigDDF::IK* ik = &skeleton->m_Iks[ii];
-                ik_animation[ii].m_Mix = ik->m_Mix;
-                ik_animation[ii].m_Positive = ik->m_Positive;
+                RigPlayer* p = &instance->m_Players[pi];
+                // How much relative blending between the two players
+                float blend_weight = fade_rate;
+                if (player != p) {
+                    blend_weight = 1.0f - fade_rate;
+                }
+                UpdatePlayer(instance, p, dt, blend_weight);
             }
+        }
+        else
+        {
+            UpdatePlayer(instance, player, dt, 1.0f);
+        }
+    }
 
-            UpdateBlend(instance, dt);
+    // Evaluates the animation tracks into the pose. Only touches the instance and the scratch buffers,
+    // so different instances can be animated in parallel.
+    static void AnimatePose(RigScratch* scratch, RigInstance* instance)
+    {
+        if (instance->m_Pose.Empty() || !instance->m_Enabled)
+            return;
 
-            RigPlayer* player = GetPlayer(instance);
+        const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
+        const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
+        const dmArray<uint32_t>& track_idx_to_pose = *instance->m_TrackIdxToPose;
+        dmArray<dmTransform::Transform>& pose = instance->m_Pose;
+        // Reset pose
+        uint32_t bone_count = pose.Size();
+        for (uint32_t bi = 0; bi < bone_count; ++bi)
+        {
+            pose[bi].SetIdentity();
+        }
+        // Reset IK animation
+        dmArray<IKAnimation>& ik_animation = instance->m_IKAnimation;
+        uint32_t ik_animation_count = ik_animation.Size();
+        for (uint32_t ii = 0; ii < ik_animation_count; ++ii)
+        {
+            const dmRigDDF::IK* ik = &skeleton->m_Iks[ii];
+            ik_animation[ii].m_Mix = ik->m_Mix;
+            ik_animation[ii].m_Positive = ik->m_Positive;
+        }
 
-            // If the animation has just started, we reset mesh properties (color, draw order etc)
-            if (player->m_Initial) {
-                ResetMeshSlotPose(instance);
-                player->m_Initial = 0;
-            }
+        RigPlayer* player = GetPlayer(instance);
 
-            // Make sure we have enough space in the draw order deltas scratch buffer.
-            uint32_t slot_count = instance->m_MeshSet->m_SlotCount;
-            int slot_changed = 0;
-            if (context->m_ScratchDrawOrderDeltas.Capacity() < slot_count) {
-                context->m_ScratchDrawOrderDeltas.OffsetCapacity(slot_count - context->m_ScratchDrawOrderDeltas.Capacity());
-            }
-            context->m_ScratchDrawOrderDeltas.SetSize(slot_count);
+        // If the animation has just started, we reset mesh properties (color, draw order etc)
+        if (player->m_Initial) {
+            ResetMeshSlotPose(instance);
+            player->m_Initial = 0;
+        }
 
-            // Reset draw order deltas to "unchanged" constant.
-            for (uint32_t i = 0; i < slot_count; i++) {
-                instance->m_DrawOrder[i] = i;
-                context->m_ScratchDrawOrderDeltas[i] = SIGNAL_DELTA_UNCHANGED;
-            }
+        // Make sure we have enough space in the draw order deltas scratch buffer.
+        uint32_t slot_count = instance->m_MeshSet->m_SlotCount;
+        int slot_changed = 0;
+        dmArray<int32_t>& draw_order_deltas = scratch->m_ScratchDrawOrderDeltas;
+        if (draw_order_deltas.Capacity() < slot_count) {
+            draw_order_deltas.OffsetCapacity(slot_count - draw_order_deltas.Capacity());
+        }
+        draw_order_deltas.SetSize(slot_count);
 
-            if (instance->m_Blending)
+        // Reset draw order deltas to "unchanged" constant.
+        for (uint32_t i = 0; i < slot_count; i++) {
+            instance->m_DrawOrder[i] = i;
+            draw_order_deltas[i] = SIGNAL_DELTA_UNCHANGED;
+        }
+
+        if (instance->m_Blending)
+        {
+            float fade_rate = instance->m_BlendTimer / instance->m_BlendDuration;
+            // How much to blend the pose, 1 first time to overwrite the bind pose, either fade_rate or 1 - fade_rate second depending on which one is the current player
+            float alpha = 1.0f;
+            for (uint32_t pi = 0; pi < 2; ++pi)
             {
-                float fade_rate = instance->m_BlendTimer / instance->m_BlendDuration;
-                // How much to blend the pose, 1 first time to overwrite the bind pose, either fade_rate or 1 - fade_rate second depending on which one is the current player
-                float alpha = 1.0f;
-                for (uint32_t pi = 0; pi < 2; ++pi)
-                {
-                    RigPlayer* p = &instance->m_Players[pi];
-                    // How much relative blending between the two players
-                    float blend_weight = fade_rate;
-                    if (player != p) {
-                        blend_weight = 1.0f - fade_rate;
-                    }
+                RigPlayer* p = &instance->m_Players[pi];
+                // How much relative blending between the two players
+                float blend_weight = fade_rate;
+                if (player != p) {
+                    blend_weight = 1.0f - fade_rate;
+                }
 
-                    // Check if we should reset the mesh slot pose.
-                    // This needs to be done once we are past 0.5 in blending, if the new player/animation
-                    // don't have a mesh animation track it would otherwise be the same from previous animation.
-                    if (p->m_BlendFinished == 0 && blend_weight > 0.5) {
-                        p->m_BlendFinished = 1;
-                        ResetMeshSlotPose(instance);
-                    }
+                // Check if we should reset the mesh slot pose.
+                // This needs to be done once we are past 0.5 in blending, if the new player/animation
+                // don't have a mesh animation track it would otherwise be the same from previous animation.
+                if (p->m_BlendFinished == 0 && blend_weight > 0.5) {
+                    p->m_BlendFinished = 1;
+                    ResetMeshSlotPose(instance);
+                }
 
-                    UpdatePlayer(instance, p, dt, blend_weight);
-                    bool draw_order = player == p ? fade_rate >= 0.5f : fade_rate < 0.5f;
-                    ApplyAnimation(p, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, draw_order, context->m_ScratchDrawOrderDeltas, slot_changed, alpha);
-                    if (player == p)
-                    {
-                        alpha = 1.0f - fade_rate;
-                    }
-                    else
-                    {
-                        alpha = fade_rate;
-                    }
+                bool draw_order = player == p ? fade_rate >= 0.5f : fade_rate < 0.5f;
+                ApplyAnimation(p, instance->m_BakedAnimationSet, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, draw_order, draw_order_deltas, slot_changed, alpha);
+                if (player == p)
+                {
+                    alpha = 1.0f - fade_rate;
+                }
+                else
+                {
+                    alpha = fade_rate;
                 }
             }
-            else
+        }
+        else
+        {
+            ApplyAnimation(player, instance->m_BakedAnimationSet, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, true, draw_order_deltas, slot_changed, 1.0f);
+        }
+
+        // Update draw order after animation
+        if (slot_changed > 0) {
+            UpdateSlotDrawOrder(instance->m_DrawOrder, draw_order_deltas, slot_changed, scratch->m_ScratchDrawOrderUnchanged);
+        }
+
+        for (uint32_t bi = 0; bi < bone_count; ++bi)
+        {
+            dmTransform::Transform& t = pose[bi];
+            // Normalize quaternions while we blend
+            if (instance->m_Blending)
             {
-                UpdatePlayer(instance, player, dt, 1.0f);
-                ApplyAnimation(player, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, true, context->m_ScratchDrawOrderDeltas, slot_changed, 1.0f);
+                Quat rotation = t.GetRotation();
+                if (dot(rotation, rotation) > 0.001f)
+                    rotation = normalize(rotation);
+                t.SetRotation(rotation);
             }
+            const dmTransform::Transform& bind_t = bind_pose[bi].m_LocalToParent;
+            t.SetTranslation(bind_t.GetTranslation() + t.GetTranslation());
+            t.SetRotation(bind_t.GetRotation() * t.GetRotation());
+            t.SetScale(mulPerElem(bind_t.GetScale(), t.GetScale()));
+        }
+    }
 
-            // Update draw order after animation
-            if (slot_changed > 0) {
-                UpdateSlotDrawOrder(instance->m_DrawOrder, context->m_ScratchDrawOrderDeltas, slot_changed, context->m_ScratchDrawOrderUnchanged);
+    static void ApplyIK(RigInstance* instance)
+    {
+        if (instance->m_Pose.Empty() || !instance->m_Enabled || instance->m_Skeleton->m_Iks.m_Count == 0)
+            return;
+
+        DM_PROFILE(Rig, "IK");
+        const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
+        const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
+        dmArray<dmTransform::Transform>& pose = instance->m_Pose;
+        dmArray<IKAnimation>& ik_animation = instance->m_IKAnimation;
+        const uint32_t count = skeleton->m_Iks.m_Count;
+        dmArray<IKTarget>& ik_targets = instance->m_IKTargets;
+
+        for (uint32_t i = 0; i < count; ++i) {
+            const dmRigDDF::IK* ik = &skeleton->m_Iks[i];
+
+            // transform local space hiearchy for pose
+            dmTransform::Transform parent_t = GetPoseTransform(bind_pose, pose, pose[ik->m_Parent], ik->m_Parent);
+            dmTransform::Transform target_t = GetPoseTransform(bind_pose, pose, pose[ik->m_Target], ik->m_Target);
+            const uint32_t parent_parent_index = skeleton->m_Bones[ik->m_Parent].m_Parent;
+            dmTransform::Transform parent_parent_t;
+            if(parent_parent_index != INVALID_BONE_INDEX)
+            {
+                parent_parent_t = dmTransform::Inv(GetPoseTransform(bind_pose, pose, pose[skeleton->m_Bones[ik->m_Parent].m_Parent], skeleton->m_Bones[ik->m_Parent].m_Parent));
+                parent_t = dmTransform::Mul(parent_parent_t, parent_t);
+                target_t = dmTransform::Mul(parent_parent_t, target_t);
             }
+            Vector3 parent_position = parent_t.GetTranslation();
+            Vector3 target_position = target_t.GetTranslation();
 
-            for (uint32_t bi = 0; bi < bone_count; ++bi)
+            if(ik_targets[i].m_Mix != 0.0f)
             {
-                dmTransform::Transform& t = pose[bi];
-                // Normalize quaternions while we blend
-                if (instance->m_Blending)
+                // get custom target position either from go or vector position
+                Vector3 user_target_position = target_position;
+                if(ik_targets[i].m_Callback != 0)
                 {
-                    Quat rotation = t.GetRotation();
-                    if (dot(rotation, rotation) > 0.001f)
-                        rotation = normalize(rotation);
-                    t.SetRotation(rotation);
+                    user_target_position = ik_targets[i].m_Callback(&ik_targets[i]);
+                } else {
+                    // instance have been removed, disable animation
+                    ik_targets[i].m_UserHash = 0;
+                    ik_targets[i].m_Mix = 0.0f;
                 }
-                const dmTransform::Transform& bind_t = bind_pose[bi].m_LocalToParent;
-                t.SetTranslation(bind_t.GetTranslation() + t.GetTranslation());
-                t.SetRotation(bind_t.GetRotation() * t.GetRotation());
-                t.SetScale(mulPerElem(bind_t.GetScale(), t.GetScale()));
-            }
-
-            if (skeleton->m_Iks.m_Count > 0) {
-                DM_PROFILE(Rig, "IK");
-                const uint32_t count = skeleton->m_Iks.m_Count;
-                dmArray<IKTarget>& ik_targets = instance->m_IKTargets;
-
-
-                for (uint32_t i = 0; i < count; ++i) {
-                    const dmRigDDF::IK* ik = &skeleton->m_Iks[i];
-
-                    // transform local space hiearchy for pose
-                    dmTransform::Transform parent_t = GetPoseTransform(bind_pose, pose, pose[ik->m_Parent], ik->m_Parent);
-                    dmTransform::Transform target_t = GetPoseTransform(bind_pose, pose, pose[ik->m_Target], ik->m_Target);
-                    const uint32_t parent_parent_index = skeleton->m_Bones[ik->m_Parent].m_Parent;
-                    dmTransform::Transform parent_parent_t;
-                    if(parent_parent_index != INVALID_BONE_INDEX)
-                    {
-                        parent_parent_t = dmTransform::Inv(GetPoseTransform(bind_pose, pose, pose[skeleton->m_Bones[ik->m_Parent].m_Parent], skeleton->m_Bones[ik->m_Parent].m_Parent));
-                        parent_t = dmTransform::Mul(parent_parent_t, parent_t);
-                        target_t = dmTransform::Mul(parent_parent_t, target_t);
-                    }
-                    Vector3 parent_position = parent_t.GetTranslation();
-                    Vector3 target_position = target_t.GetTranslation();
-
-                    if(ik_targets[i].m_Mix != 0.0f)
-                    {
-                        // get custom target position either from go or vector position
-                        Vector3 user_target_position = target_position;
-                        if(ik_targets[i].m_Callback != 0)
-                        {
-                            user_target_position = ik_targets[i].m_Callback(&ik_targets[i]);
-                        } else {
-                            // instance have been removed, disable animation
-                            ik_targets[i].m_UserHash = 0;
-                            ik_targets[i].m_Mix = 0.0f;
-                        }
-
-                        const float target_mix = ik_targets[i].m_Mix;
-
-                        if (parent_parent_index != INVALID_BONE_INDEX) {
-                            user_target_position = dmTransform::Apply(parent_parent_t, user_target_position);
-                        }
 
-                        // blend default target pose and target pose
-                        target_position = target_mix == 1.0f ? user_target_position : lerp(target_mix, target_position, user_target_position);
-                    }
+                const float target_mix = ik_targets[i].m_Mix;
 
-                    if(ik->m_Child == ik->m_Parent)
-                        ApplyOneBoneIKConstraint(ik, bind_pose, pose, target_position, parent_position, ik_animation[i].m_Mix);
-                    else
-                        ApplyTwoBoneIKConstraint(ik, bind_pose, pose, target_position, parent_position, ik_animation[i].m_Positive, ik_animation[i].m_Mix);
+                if (parent_parent_index != INVALID_BONE_INDEX) {
+                    user_target_position = dmTransform::Apply(parent_parent_t, user_target_position);
                 }
+
+                // blend default target pose and target pose
+                target_position = target_mix == 1.0f ? user_target_position : lerp(target_mix, target_position, user_target_position);
             }
+
+            if(ik->m_Child == ik->m_Parent)
+                ApplyOneBoneIKConstraint(ik, bind_pose, pose, target_position, parent_position, ik_animation[i].m_Mix);
+            else
+                ApplyTwoBoneIKConstraint(ik, bind_pose, pose, target_position, parent_position, ik_animation[i].m_Positive, ik_animation[i].m_Mix);
+        }
     }
 
     static Result PostUpdate(HRigContext context)
@@ -789,7 +958,8 @@ namespace dmRig
         for (uint32_t i = 0; i < count; ++i)
         {
             RigInstance* instance = instances[i];
-            if (DoPostUpdate(instance)) {
+            // The pose is unchanged for instances that skipped it
+            if (!instance->m_SkipPose && DoPostUpdate(instance)) {
                 updated_pose = true;
             }
         }
@@ -1042,14 +1212,14 @@ namespace dmRig
         return vertex_count;
     }
 
-    static float* GenerateNormalData(const dmRigDDF::Mesh* mesh, const Matrix4& normal_matrix, const dmArray<Matrix4>& pose_matrices, float* out_buffer)
+    static float* GenerateNormalData(const dmRigDDF::Mesh* mesh, const Matrix4& normal_matrix, const dmArray<float>& palette, float* out_buffer)
     {
         const float* normals_in = mesh->m_Normals.m_Data;
         const uint32_t* normal_indices = mesh->m_NormalsIndices.m_Data;
         uint32_t index_count = mesh->m_PositionIndices.m_Count;
         Vector4 v;
 
-        if (!mesh->m_BoneIndices.m_Count || pose_matrices.Size() == 0)
+        if (!mesh->m_BoneIndices.m_Count || palette.Size() == 0)
         {
             for (uint32_t ii = 0; ii < index_count; ++ii)
             {
@@ -1066,55 +1236,27 @@ namespace dmRig
             return out_buffer;
         }
 
+        // The normal matrix is baked into the palette
         const uint32_t* indices = mesh->m_BoneIndices.m_Data;
         const float* weights = mesh->m_Weights.m_Data;
         const uint32_t* vertex_indices = mesh->m_PositionIndices.m_Data;
         for (uint32_t ii = 0; ii < index_count; ++ii)
         {
-            const uint32_t ni = normal_indices[ii]*3;
-            const Vector3 normal_in(normals_in[ni+0], normals_in[ni+1], normals_in[ni+2]);
-            Vector4 normal_out(0.0f, 0.0f, 0.0f, 0.0f);
-
             const uint32_t bi_offset = vertex_indices[ii] << 2;
-            const uint32_t* bone_indices = &indices[bi_offset];
-            const float* bone_weights = &weights[bi_offset];
-
-            if (bone_weights[0])
-            {
-                normal_out += (pose_matrices[bone_indices[0]] * normal_in) * bone_weights[0];
-                if (bone_weights[1])
-                {
-                    normal_out += (pose_matrices[bone_indices[1]] * normal_in) * bone_weights[1];
-                    if (bone_weights[2])
-                    {
-                        normal_out += (pose_matrices[bone_indices[2]] * normal_in) * bone_weights[2];
-                        if (bone_weights[3])
-                        {
-                            normal_out += (pose_matrices[bone_indices[3]] * normal_in) * bone_weights[3];
-                        }
-                    }
-                }
-            }
-
-            v = normal_matrix * Vector3(normal_out.getX(), normal_out.getY(), normal_out.getZ());
-            if (lengthSqr(v) > 0.0f) {
-                normalize(v);
-            }
-            *out_buffer++ = v[0];
-            *out_buffer++ = v[1];
-            *out_buffer++ = v[2];
+            SkinDirection(palette.Begin(), &indices[bi_offset], &weights[bi_offset], &normals_in[normal_indices[ii]*3], out_buffer);
+            out_buffer += 3;
         }
 
         return out_buffer;
     }
 
-    static float* GeneratePositionData(const dmRigDDF::Mesh* mesh, const Matrix4& model_matrix, const dmArray<Matrix4>& pose_matrices, float* out_buffer)
+    static float* GeneratePositionData(const dmRigDDF::Mesh* mesh, const Matrix4& model_matrix, const dmArray<float>& palette, float* out_buffer)
     {
         const float *positions = mesh->m_Positions.m_Data;
         const size_t vertex_count = mesh->m_Positions.m_Count / 3;
         Point3 in_p;
         Vector4 v;
-        if(!mesh->m_BoneIndices.m_Count || pose_matrices.Size() == 0)
+        if(!mesh->m_BoneIndices.m_Count || palette.Size() == 0)
         {
             for (uint32_t i = 0; i < vertex_count; ++i)
             {
@@ -1129,42 +1271,17 @@ namespace dmRig
             return out_buffer;
         }
 
+        // The linear part of the model matrix is baked into the palette, its translation is added once per vertex
+        const Vector4 translation = model_matrix.getCol3();
+        const float base[3] = { translation.getX(), translation.getY(), translation.getZ() };
         const uint32_t* indices = mesh->m_BoneIndices.m_Data;
         const float* weights = mesh->m_Weights.m_Data;
         for (uint32_t i = 0; i < vertex_count; ++i)
         {
-            Vector4 in_v;
-            in_v.setX(*positions++);
-            in_v.setY(*positions++);
-            in_v.setZ(*positions++);
-            in_v.setW(1.0f);
-
-            Vector4 out_p(0.0f, 0.0f, 0.0f, 0.0f);
             const uint32_t bi_offset = i << 2;
-            const uint32_t* bone_indices = &indices[bi_offset];
-            const float* bone_weights = &weights[bi_offset];
-
-            if(bone_weights[0])
-            {
-                out_p += pose_matrices[bone_indices[0]] * in_v * bone_weights[0];
-                if(bone_weights[1])
-                {
-                    out_p += pose_matrices[bone_indices[1]] * in_v * bone_weights[1];
-                    if(bone_weights[2])
-                    {
-                        out_p += pose_matrices[bone_indices[2]] * in_v * bone_weights[2];
-                        if(bone_weights[3])
-                        {
-                            out_p += pose_matrices[bone_indices[3]] * in_v * bone_weights[3];
-                        }
-                    }
-                }
-            }
-
-            v = model_matrix * Point3(out_p.getX(), out_p.getY(), out_p.getZ());
-            *out_buffer++ = v[0];
-            *out_buffer++ = v[1];
-            *out_buffer++ = v[2];
+            SkinPosition(palette.Begin(), &indices[bi_offset], &weights[bi_offset], positions, base, out_buffer);
+            positions += 3;
+            out_buffer += 3;
         }
         return out_buffer;
     }
@@ -1316,7 +1433,71 @@ namespace dmRig
         return out_write_ptr;
     }
 
-    void* GenerateVertexData(dmRig::HRigContext context, dmRig::HRigInstance instance, const Matrix4& model_matrix, const Matrix4& normal_matrix, const Vector4 color, RigVertexFormat vertex_format, void* vertex_data_out)
+    // Fills the scratch influence matrices with the model space skinning matrices of the instance,
+    // in the order the mesh bone indices use. Returns the number of influences, 0 if the rig has no bones.
+    static uint32_t UpdateInfluenceMatrices(RigScratch* scratch, HRigInstance instance)
+    {
+        dmArray<Matrix4>& pose_matrices      = scratch->m_ScratchPoseMatrixBuffer;
+        dmArray<Matrix4>& influence_matrices = scratch->m_ScratchInfluenceMatrixBuffer;
+
+        // If the rig has bones, update the pose to be local-to-model
+        uint32_t bone_count = GetBoneCount(instance);
+        influence_matrices.SetSize(0);
+        if (!bone_count || instance->m_PoseIdxToInfluence->Size() == 0) {
+            return 0;
+        }
+
+        // Make sure pose scratch buffers have enough space
+        if (pose_matrices.Capacity() < bone_count) {
+            uint32_t size_offset = bone_count - pose_matrices.Capacity();
+            pose_matrices.OffsetCapacity(size_offset);
+        }
+        pose_matrices.SetSize(bone_count);
+
+        // Make sure influence scratch buffers have enough space sufficient for max bones to be indexed
+        uint32_t max_bone_count = instance->m_MaxBoneCount;
+        if (influence_matrices.Capacity() < max_bone_count) {
+            uint32_t capacity = influence_matrices.Capacity();
+            uint32_t size_offset = max_bone_count - capacity;
+            influence_matrices.OffsetCapacity(size_offset);
+            influence_matrices.SetSize(max_bone_count);
+            for(uint32_t i = capacity; i < capacity+size_offset; ++i)
+                influence_matrices[i] = Matrix4::identity();
+        }
+        influence_matrices.SetSize(max_bone_count);
+
+        const dmArray<dmTransform::Transform>& pose = instance->m_Pose;
+        const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
+        if (skeleton->m_LocalBoneScaling) {
+
+            dmArray<dmTransform::Transform>& pose_transforms = scratch->m_ScratchPoseTransformBuffer;
+            if (pose_transforms.Capacity() < bone_count) {
+                pose_transforms.OffsetCapacity(bone_count - pose_transforms.Capacity());
+            }
+            pose_transforms.SetSize(bone_count);
+
+            PoseToModelSpace(skeleton, pose, pose_transforms);
+            PoseToMatrix(pose_transforms, pose_matrices);
+        } else {
+            PoseToMatrix(pose, pose_matrices);
+            PoseToModelSpace(skeleton, pose_matrices, pose_matrices);
+        }
+
+        // Premultiply pose matrices with the bind pose inverse so they
+        // can be directly be used to transform each vertex.
+        const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
+        for (uint32_t bi = 0; bi < pose_matrices.Size(); ++bi)
+        {
+            Matrix4& pose_matrix = pose_matrices[bi];
+            pose_matrix = pose_matrix * bind_pose[bi].m_ModelToLocal;
+        }
+
+        // Rearrange pose matrices to indices that the mesh vertices understand.
+        PoseToInfluence(*instance->m_PoseIdxToInfluence, pose_matrices, influence_matrices);
+        return max_bone_count;
+    }
+
+    static void* DoGenerateVertexData(RigScratch* scratch, dmRig::HRigInstance instance, const Matrix4& model_matrix, const Matrix4& normal_matrix, const Vector4 color, RigVertexFormat vertex_format, void* vertex_data_out)
     {
         const dmRigDDF::MeshEntry* mesh_entry = instance->m_MeshEntry;
         if (!instance->m_MeshEntry || !instance->m_DoRender) {
@@ -1335,63 +1516,41 @@ namespace dmRig
             }
         }
 
-        dmArray<Matrix4>& pose_matrices      = context->m_ScratchPoseMatrixBuffer;
-        dmArray<Matrix4>& influence_matrices = context->m_ScratchInfluenceMatrixBuffer;
-        dmArray<Vector3>& positions          = context->m_ScratchPositionBuffer;
-        dmArray<Vector3>& normals            = context->m_ScratchNormalBuffer;
+        dmArray<Matrix4>& influence_matrices = scratch->m_ScratchInfluenceMatrixBuffer;
+        dmArray<float>& position_palette     = scratch->m_ScratchPositionPalette;
+        dmArray<float>& normal_palette       = scratch->m_ScratchNormalPalette;
+        dmArray<Vector3>& positions          = scratch->m_ScratchPositionBuffer;
+        dmArray<Vector3>& normals            = scratch->m_ScratchNormalBuffer;
 
         // If the rig has bones, update the pose to be local-to-model
-        uint32_t bone_count = GetBoneCount(instance);
-        influence_matrices.SetSize(0);
-        if (bone_count && instance->m_PoseIdxToInfluence->Size() > 0) {
-
-            // Make sure pose scratch buffers have enough space
-            if (pose_matrices.Capacity() < bone_count) {
-                uint32_t size_offset = bone_count - pose_matrices.Capacity();
-                pose_matrices.OffsetCapacity(size_offset);
+        position_palette.SetSize(0);
+        normal_palette.SetSize(0);
+        uint32_t max_bone_count = UpdateInfluenceMatrices(scratch, instance);
+        if (max_bone_count) {
+            // Bake the model matrix, without its translation, into the position palette and
+            // the normal matrix into the normal palette so the vertices only blend the influences.
+            Matrix4 model_linear = model_matrix;
+            model_linear.setCol3(Vector4(0.0f, 0.0f, 0.0f, 1.0f));
+            uint32_t palette_size = max_bone_count * SKIN_PALETTE_STRIDE;
+            if (position_palette.Capacity() < palette_size) {
+                position_palette.OffsetCapacity(palette_size - position_palette.Capacity());
             }
-            pose_matrices.SetSize(bone_count);
-
-            // Make sure influence scratch buffers have enough space sufficient for max bones to be indexed
-            uint32_t max_bone_count = instance->m_MaxBoneCount;
-            if (influence_matrices.Capacity() < max_bone_count) {
-                uint32_t capacity = influence_matrices.Capacity();
-                uint32_t size_offset = max_bone_count - capacity;
-                influence_matrices.OffsetCapacity(size_offset);
-                influence_matrices.SetSize(max_bone_count);
-                for(uint32_t i = capacity; i < capacity+size_offset; ++i)
-                    influence_matrices[i] = Matrix4::identity();
+            position_palette.SetSize(palette_size);
+            for (uint32_t bi = 0; bi < max_bone_count; ++bi)
+            {
+                SetSkinPaletteMatrix(position_palette.Begin(), bi, model_linear * influence_matrices[bi]);
             }
-            influence_matrices.SetSize(max_bone_count);
 
-            const dmArray<dmTransform::Transform>& pose = instance->m_Pose;
-            const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
-            if (skeleton->m_LocalBoneScaling) {
-
-                dmArray<dmTransform::Transform>& pose_transforms = context->m_ScratchPoseTransformBuffer;
-                if (pose_transforms.Capacity() < bone_count) {
-                    pose_transforms.OffsetCapacity(bone_count - pose_transforms.Capacity());
+            if (vertex_format == RIG_VERTEX_FORMAT_MODEL) {
+                if (normal_palette.Capacity() < palette_size) {
+                    normal_palette.OffsetCapacity(palette_size - normal_palette.Capacity());
+                }
+                normal_palette.SetSize(palette_size);
+                for (uint32_t bi = 0; bi < max_bone_count; ++bi)
+                {
+                    SetSkinPaletteMatrix(normal_palette.Begin(), bi, normal_matrix * influence_matrices[bi]);
                 }
-                pose_transforms.SetSize(bone_count);
-
-                PoseToModelSpace(skeleton, pose, pose_transforms);
-                PoseToMatrix(pose_transforms, pose_matrices);
-            } else {
-                PoseToMatrix(pose, pose_matrices);
-                PoseToModelSpace(skeleton, pose_matrices, pose_matrices);
-            }
-
-            // Premultiply pose matrices with the bind pose inverse so they
-            // can be directly be used to transform each vertex.
-            const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
-            for (uint32_t bi = 0; bi < pose_matrices.Size(); ++bi)
-            {
-                Matrix4& pose_matrix = pose_matrices[bi];
-                pose_matrix = pose_matrix * bind_pose[bi].m_ModelToLocal;
             }
-
-            // Rearrange pose matrices to indices that the mesh vertices understand.
-            PoseToInfluence(*instance->m_PoseIdxToInfluence, pose_matrices, influence_matrices);
         }
 
         // Loop that generates actual vertex data for current mesh entry.
@@ -1435,9 +1594,9 @@ namespace dmRig
                     // Fill scratch buffers for positions, and normals if applicable, using pose matrices.
                     float* positions_buffer = (float*)positions.Begin();
                     float* normals_buffer = (float*)normals.Begin();
-                    dmRig::GeneratePositionData(mesh_attachment, model_matrix, influence_matrices, positions_buffer);
+                    dmRig::GeneratePositionData(mesh_attachment, model_matrix, position_palette, positions_buffer);
                     if (vertex_format == RIG_VERTEX_FORMAT_MODEL && mesh_attachment->m_NormalsIndices.m_Count) {
-                        dmRig::GenerateNormalData(mesh_attachment, normal_matrix, influence_matrices, normals_buffer);
+                        dmRig::GenerateNormalData(mesh_attachment, normal_matrix, normal_palette, normals_buffer);
                     }
 
                     // NOTE: We expose two different vertex format that GenerateVertexData can output.
@@ -1477,6 +1636,65 @@ namespace dmRig
         return vertex_data_out;
     }
 
+    void* GenerateVertexData(dmRig::HRigContext context, dmRig::HRigInstance instance, const Matrix4& model_matrix, const Matrix4& normal_matrix, const Vector4 color, RigVertexFormat vertex_format, void* vertex_data_out)
+    {
+        return DoGenerateVertexData(GetScratch(context), instance, model_matrix, normal_matrix, color, vertex_format, vertex_data_out);
+    }
+
+    uint32_t GenerateSkinPalette(HRigContext context, HRigInstance instance, float* palette_out, uint32_t max_bone_count)
+    {
+        RigScratch* scratch = GetScratch(context);
+        uint32_t bone_count = dmMath::Min(UpdateInfluenceMatrices(scratch, instance), max_bone_count);
+        const dmArray<Matrix4>& influence_matrices = scratch->m_ScratchInfluenceMatrixBuffer;
+        for (uint32_t bi = 0; bi < bone_count; ++bi)
+        {
+            const Matrix4& m = influence_matrices[bi];
+            for (uint32_t r = 0; r < 3; ++r)
+            {
+                Vector4 row = m.getRow(r);
+                *palette_out++ = row.getX();
+                *palette_out++ = row.getY();
+                *palette_out++ = row.getZ();
+                *palette_out++ = row.getW();
+            }
+        }
+        return bone_count;
+    }
+
+    struct GenerateVertexDataContext
+    {
+        HRigContext         m_Context;
+        RigVertexDataEntry* m_Entries;
+        RigVertexFormat     m_VertexFormat;
+    };
+
+    static void GenerateVertexDataRange(void* _ctx, uint32_t start, uint32_t end)
+    {
+        GenerateVertexDataContext* ctx = (GenerateVertexDataContext*) _ctx;
+        RigScratch* scratch = GetScratch(ctx->m_Context);
+        for (uint32_t i = start; i < end; ++i)
+        {
+            RigVertexDataEntry& entry = ctx->m_Entries[i];
+            entry.m_VertexDataEnd = DoGenerateVertexData(scratch, entry.m_Instance, entry.m_ModelMatrix, entry.m_NormalMatrix, entry.m_Color, ctx->m_VertexFormat, entry.m_VertexDataOut);
+        }
+    }
+
+    void GenerateVertexDataBatch(HRigContext context, RigVertexDataEntry* entries, uint32_t entry_count, RigVertexFormat vertex_format)
+    {
+        DM_PROFILE(Rig, "GenerateVertexDataBatch");
+
+        GenerateVertexDataContext ctx;
+        ctx.m_Context = context;
+        ctx.m_Entries = entries;
+        ctx.m_VertexFormat = vertex_format;
+        if (context->m_JobContext == 0 || entry_count <= 1) {
+            GenerateVertexDataRange(&ctx, 0, entry_count);
+        } else {
+            dmJob::HJob job = dmJob::ParallelFor(context->m_JobContext, GenerateVertexDataRange, &ctx, entry_count, 2, dmJob::INVALID_JOB);
+            dmJob::Wait(context->m_JobContext, job);
+        }
+    }
+
     static uint32_t FindIKIndex(HRigInstance instance, dmhash_t ik_constraint_id)
     {
         const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
@@ -1503,6 +1721,21 @@ namespace dmRig
         return instance->m_Enabled;
     }
 
+    void SetUpdateInterval(HRigInstance instance, uint32_t interval)
+    {
+        uint8_t update_interval = (uint8_t) dmMath::Min(interval, 255u);
+        if (update_interval != instance->m_UpdateInterval) {
+            instance->m_UpdateInterval = update_interval;
+            // Spread the evaluations of instances that switch interval in the same update over the interval
+            instance->m_UpdateCountdown = update_interval > 1 ? instance->m_Index % update_interval : 0;
+        }
+    }
+
+    void SetPoseFrozen(HRigInstance instance, bool frozen)
+    {
+        instance->m_PoseFrozen = frozen;
+    }
+
     bool IsValid(HRigInstance instance)
     {
         return (instance->m_MeshEntry != 0x0);
@@ -1617,6 +1850,7 @@ namespace dmRig
         instance->m_AnimationSet       = params.m_AnimationSet;
         instance->m_PoseIdxToInfluence = params.m_PoseIdxToInfluence;
         instance->m_TrackIdxToPose     = params.m_TrackIdxToPose;
+        instance->m_BakedAnimationSet  = params.m_BakedAnimationSet;
 
         instance->m_Enabled = 1;
 
@@ -1745,4 +1979,143 @@ namespace dmRig
         }
     }
 
+    static bool IsBakedTrack(const dmRigDDF::AnimationTrack* track, const dmArray<uint32_t>& track_idx_to_pose)
+    {
+        if (track->m_BoneIndex >= track_idx_to_pose.Size())
+            return false;
+        return track->m_Positions.m_Count > 0 || track->m_Rotations.m_Count > 0 || track->m_Scale.m_Count > 0;
+    }
+
+    static uint32_t GetBakedFrameCount(const dmRigDDF::RigAnimation* animation, const dmArray<uint32_t>& track_idx_to_pose, uint32_t* out_track_count)
+    {
+        uint32_t frame_count = 0;
+        uint32_t track_count = 0;
+        for (uint32_t ti = 0; ti < animation->m_Tracks.m_Count; ++ti)
+        {
+            const dmRigDDF::AnimationTrack* track = &animation->m_Tracks[ti];
+            if (!IsBakedTrack(track, track_idx_to_pose))
+                continue;
+            ++track_count;
+            frame_count = dmMath::Max(frame_count, track->m_Positions.m_Count / 3);
+            frame_count = dmMath::Max(frame_count, track->m_Rotations.m_Count / 4);
+            frame_count = dmMath::Max(frame_count, track->m_Scale.m_Count / 3);
+        }
+        *out_track_count = track_count;
+        return frame_count;
+    }
+
+    // Range of a vec3 track, the step is the size of one quantization level
+    static void GetBakedRange(const float* data, uint32_t count, Vector3& out_min, Vector3& out_step)
+    {
+        Vector3 min(0.0f);
+        Vector3 max(0.0f);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Vector3 v(data[i*3+0], data[i*3+1], data[i*3+2]);
+            min = i == 0 ? v : minPerElem(min, v);
+            max = i == 0 ? v : maxPerElem(max, v);
+        }
+        out_min = min;
+        out_step = (max - min) * (1.0f / 65535.0f);
+    }
+
+    static uint16_t QuantizeBaked(float v, float min, float step)
+    {
+        if (step <= 0.0f)
+            return 0;
+        return (uint16_t)dmMath::Clamp((v - min) / step + 0.5f, 0.0f, 65535.0f);
+    }
+
+    static void QuantizeBakedVec3(const float* data, uint32_t count, uint32_t frame, const Vector3& min, const Vector3& step, uint16_t* out)
+    {
+        const float* v = &data[dmMath::Min(frame, count - 1) * 3];
+        out[0] = QuantizeBaked(v[0], min.getX(), step.getX());
+        out[1] = QuantizeBaked(v[1], min.getY(), step.getY());
+        out[2] = QuantizeBaked(v[2], min.getZ(), step.getZ());
+    }
+
+    void BakeAnimationSet(const dmRigDDF::AnimationSet& animation_set, const dmArray<uint32_t>& track_idx_to_pose, BakedAnimationSet& baked_set)
+    {
+        uint32_t animation_count = animation_set.m_Animations.m_Count;
+        uint32_t total_track_count = 0;
+        uint32_t total_sample_count = 0;
+        for (uint32_t ai = 0; ai < animation_count; ++ai)
+        {
+            uint32_t track_count = 0;
+            uint32_t frame_count = GetBakedFrameCount(&animation_set.m_Animations[ai], track_idx_to_pose, &track_count);
+            total_track_count += track_count;
+            total_sample_count += track_count * frame_count;
+        }
+
+        baked_set.m_AnimationSet = &animation_set;
+        baked_set.m_Animations.SetCapacity(animation_count);
+        baked_set.m_Animations.SetSize(0);
+        baked_set.m_Tracks.SetCapacity(total_track_count);
+        baked_set.m_Tracks.SetSize(0);
+        baked_set.m_Samples.SetCapacity(total_sample_count);
+        baked_set.m_Samples.SetSize(total_sample_count);
+
+        uint32_t sample_offset = 0;
+        for (uint32_t ai = 0; ai < animation_count; ++ai)
+        {
+            const dmRigDDF::RigAnimation* animation = &animation_set.m_Animations[ai];
+            BakedAnimation baked;
+            baked.m_FirstTrack = baked_set.m_Tracks.Size();
+            baked.m_FirstSample = sample_offset;
+            baked.m_FrameCount = GetBakedFrameCount(animation, track_idx_to_pose, &baked.m_TrackCount);
+            sample_offset += baked.m_TrackCount * baked.m_FrameCount;
+
+            uint32_t baked_ti = 0;
+            for (uint32_t ti = 0; ti < animation->m_Tracks.m_Count; ++ti)
+            {
+                const dmRigDDF::AnimationTrack* track = &animation->m_Tracks[ti];
+                if (!IsBakedTrack(track, track_idx_to_pose))
+                    continue;
+
+                BakedTrack baked_track;
+                memset(&baked_track, 0, sizeof(baked_track));
+                baked_track.m_PoseIndex = track_idx_to_pose[track->m_BoneIndex];
+                uint32_t position_count = track->m_Positions.m_Count / 3;
+                uint32_t rotation_count = track->m_Rotations.m_Count / 4;
+                uint32_t scale_count = track->m_Scale.m_Count / 3;
+                baked_track.m_HasTranslation = position_count > 0;
+                baked_track.m_HasRotation = rotation_count > 0;
+                baked_track.m_HasScale = scale_count > 0;
+                GetBakedRange(track->m_Positions.m_Data, position_count, baked_track.m_TranslationMin, baked_track.m_TranslationStep);
+                GetBakedRange(track->m_Scale.m_Data, scale_count, baked_track.m_ScaleMin, baked_track.m_ScaleStep);
+                baked_set.m_Tracks.Push(baked_track);
+
+                Quat prev_rotation = Quat::identity();
+                for (uint32_t fi = 0; fi < baked.m_FrameCount; ++fi)
+                {
+                    BakedBoneSample& sample = baked_set.m_Samples[baked.m_FirstSample + fi * baked.m_TrackCount + baked_ti];
+                    memset(&sample, 0, sizeof(sample));
+                    if (baked_track.m_HasTranslation)
+                    {
+                        QuantizeBakedVec3(track->m_Positions.m_Data, position_count, fi, baked_track.m_TranslationMin, baked_track.m_TranslationStep, sample.m_Translation);
+                    }
+                    if (baked_track.m_HasScale)
+                    {
+                        QuantizeBakedVec3(track->m_Scale.m_Data, scale_count, fi, baked_track.m_ScaleMin, baked_track.m_ScaleStep, sample.m_Scale);
+                    }
+                    if (baked_track.m_HasRotation)
+                    {
+                        const float* r = &track->m_Rotations.m_Data[dmMath::Min(fi, rotation_count - 1) * 4];
+                        Quat rotation(r[0], r[1], r[2], r[3]);
+                        // Keep consecutive frames on the same hemisphere, for the normalized lerp between them
+                        if (dot(prev_rotation, rotation) < 0.0f)
+                            rotation = -rotation;
+                        prev_rotation = rotation;
+                        for (uint32_t i = 0; i < 4; ++i)
+                        {
+                            sample.m_Rotation[i] = (int16_t)(dmMath::Clamp(rotation[i], -1.0f, 1.0f) * 32767.0f + (rotation[i] < 0.0f ? -0.5f : 0.5f));
+                        }
+                    }
+                }
+                ++baked_ti;
+            }
+            baked_set.m_Animations.Push(baked);
+        }
+    }
+
 }
@@ -0,0 +1,164 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_RIG_SKIN_H
+#define DM_RIG_SKIN_H
+
+#include <stdint.h>
+#include <dmsdk/dlib/vmath.h>
+
+// The skinning kernels use SSE2 or NEON when the target always has it (x86-64, arm64 and armv7 builds with neon),
+// otherwise plain C
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_RIG_SKIN_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define DM_RIG_SKIN_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace dmRig
+{
+    /*
+     * A skinning palette holds one affine matrix per bone as four columns of (x, y, z, 0) floats,
+     * so that a kernel can load each column straight into a register.
+     * Like the scalar code, the influences of a vertex end at the first zero weight.
+     */
+
+    /// Number of floats per bone in a skinning palette
+    static const uint32_t SKIN_PALETTE_STRIDE = 16;
+
+    static inline void SetSkinPaletteMatrix(float* palette, uint32_t bone, const Vectormath::Aos::Matrix4& m)
+    {
+        float* p = palette + bone * SKIN_PALETTE_STRIDE;
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            Vectormath::Aos::Vector4 col = m.getCol(c);
+            p[c*4+0] = col.getX();
+            p[c*4+1] = col.getY();
+            p[c*4+2] = col.getZ();
+            p[c*4+3] = 0.0f;
+        }
+    }
+
+    /**
+     * Skins a point and writes base + sum(weight * (palette matrix * (x, y, z, 1))) to out[0..2]
+     */
+    static inline void SkinPosition(const float* palette, const uint32_t* bone_indices, const float* bone_weights, const float* in, const float* base, float* out)
+    {
+#if defined(DM_RIG_SKIN_SSE2)
+        const __m128 x = _mm_set1_ps(in[0]);
+        const __m128 y = _mm_set1_ps(in[1]);
+        const __m128 z = _mm_set1_ps(in[2]);
+        __m128 acc = _mm_setr_ps(base[0], base[1], base[2], 0.0f);
+        for (uint32_t k = 0; k < 4 && bone_weights[k]; ++k)
+        {
+            const float* m = palette + bone_indices[k] * SKIN_PALETTE_STRIDE;
+            __m128 p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m), x), _mm_mul_ps(_mm_loadu_ps(m + 4), y)),
+                                  _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m + 8), z), _mm_loadu_ps(m + 12)));
+            acc = _mm_add_ps(acc, _mm_mul_ps(p, _mm_set1_ps(bone_weights[k])));
+        }
+        float result[4];
+        _mm_storeu_ps(result, acc);
+        out[0] = result[0];
+        out[1] = result[1];
+        out[2] = result[2];
+#elif defined(DM_RIG_SKIN_NEON)
+        const float base_data[4] = { base[0], base[1], base[2], 0.0f };
+        float32x4_t acc = vld1q_f32(base_data);
+        for (uint32_t k = 0; k < 4 && bone_weights[k]; ++k)
+        {
+            const float* m = palette + bone_indices[k] * SKIN_PALETTE_STRIDE;
+            float32x4_t p = vld1q_f32(m + 12);
+            p = vmlaq_n_f32(p, vld1q_f32(m), in[0]);
+            p = vmlaq_n_f32(p, vld1q_f32(m + 4), in[1]);
+            p = vmlaq_n_f32(p, vld1q_f32(m + 8), in[2]);
+            acc = vmlaq_n_f32(acc, p, bone_weights[k]);
+        }
+        float result[4];
+        vst1q_f32(result, acc);
+        out[0] = result[0];
+        out[1] = result[1];
+        out[2] = result[2];
+#else
+        float acc[3] = { base[0], base[1], base[2] };
+        for (uint32_t k = 0; k < 4 && bone_weights[k]; ++k)
+        {
+            const float* m = palette + bone_indices[k] * SKIN_PALETTE_STRIDE;
+            const float w = bone_weights[k];
+            for (uint32_t e = 0; e < 3; ++e)
+            {
+                acc[e] += (m[e] * in[0] + m[4+e] * in[1] + m[8+e] * in[2] + m[12+e]) * w;
+            }
+        }
+        out[0] = acc[0];
+        out[1] = acc[1];
+        out[2] = acc[2];
+#endif
+    }
+
+    /**
+     * Skins a direction and writes sum(weight * (palette matrix * (x, y, z, 0))) to out[0..2]
+     */
+    static inline void SkinDirection(const float* palette, const uint32_t* bone_indices, const float* bone_weights, const float* in, float* out)
+    {
+#if defined(DM_RIG_SKIN_SSE2)
+        const __m128 x = _mm_set1_ps(in[0]);
+        const __m128 y = _mm_set1_ps(in[1]);
+        const __m128 z = _mm_set1_ps(in[2]);
+        __m128 acc = _mm_setzero_ps();
+        for (uint32_t k = 0; k < 4 && bone_weights[k]; ++k)
+        {
+            const float* m = palette + bone_indices[k] * SKIN_PALETTE_STRIDE;
+            __m128 p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m), x), _mm_mul_ps(_mm_loadu_ps(m + 4), y)),
+                                  _mm_mul_ps(_mm_loadu_ps(m + 8), z));
+            acc = _mm_add_ps(acc, _mm_mul_ps(p, _mm_set1_ps(bone_weights[k])));
+        }
+        float result[4];
+        _mm_storeu_ps(result, acc);
+        out[0] = result[0];
+        out[1] = result[1];
+        out[2] = result[2];
+#elif defined(DM_RIG_SKIN_NEON)
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (uint32_t k = 0; k < 4 && bone_weights[k]; ++k)
+        {
+            const float* m = palette + bone_indices[k] * SKIN_PALETTE_STRIDE;
+            float32x4_t p = vmulq_n_f32(vld1q_f32(m), in[0]);
+            p = vmlaq_n_f32(p, vld1q_f32(m + 4), in[1]);
+            p = vmlaq_n_f32(p, vld1q_f32(m + 8), in[2]);
+            acc = vmlaq_n_f32(acc, p, bone_weights[k]);
+        }
+        float result[4];
+        vst1q_f32(result, acc);
+        out[0] = result[0];
+        out[1] = result[1];
+        out[2] = result[2];
+#else
+        float acc[3] = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t k = 0; k < 4 && bone_weights[k]; ++k)
+        {
+            const float* m = palette + bone_indices[k] * SKIN_PALETTE_STRIDE;
+            const float w = bone_weights[k];
+            for (uint32_t e = 0; e < 3; ++e)
+            {
+                acc[e] += (m[e] * in[0] + m[4+e] * in[1] + m[8+e] * in[2]) * w;
+            }
+        }
+        out[0] = acc[0];
+        out[1] = acc[1];
+        out[2] = acc[2];
+#endif
+    }
+}
+
+#endif // DM_RIG_SKIN_H
@@ -1541,6 +1541,71 @@ TEST_F(RigInstanceTest, PoseAnim)
     ASSERT_VEC4(Quat::identity(), pose[1].GetRotation());
 }
 
+TEST_F(RigInstanceTest, PoseFrozen)
+{
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+
+    dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(m_Instance);
+
+    // sample 0 is kept while frozen
+    dmRig::SetPoseFrozen(m_Instance, true);
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0f));
+    ASSERT_VEC4(Quat::identity(), pose[0].GetRotation());
+    ASSERT_VEC4(Quat::identity(), pose[1].GetRotation());
+
+    // the animation kept playing, sample 2
+    dmRig::SetPoseFrozen(m_Instance, false);
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0f));
+    ASSERT_VEC4(Quat::rotationZ((float)M_PI / 2.0f), pose[0].GetRotation());
+    ASSERT_VEC4(Quat::identity(), pose[1].GetRotation());
+}
+
+TEST_F(RigInstanceTest, BakedPoseAnim)
+{
+    dmRig::BakedAnimationSet baked_set;
+    dmRig::BakeAnimationSet(*m_AnimationSet, m_TrackIdxToPose, baked_set);
+    ASSERT_EQ(m_AnimationSet->m_Animations.m_Count, baked_set.m_Animations.Size());
+
+    dmRig::HRigInstance baked_instance = 0x0;
+    dmRig::InstanceCreateParams create_params = {0};
+    create_params.m_Context            = m_Context;
+    create_params.m_Instance           = &baked_instance;
+    create_params.m_BindPose           = &m_BindPose;
+    create_params.m_Skeleton           = m_Skeleton;
+    create_params.m_MeshSet            = m_MeshSet;
+    create_params.m_AnimationSet       = m_AnimationSet;
+    create_params.m_TrackIdxToPose     = &m_TrackIdxToPose;
+    create_params.m_PoseIdxToInfluence = &m_PoseIdxToInfluence;
+    create_params.m_BakedAnimationSet  = &baked_set;
+    create_params.m_MeshId             = dmHashString64((const char*)"test");
+    create_params.m_DefaultAnimation   = dmHashString64((const char*)"");
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::InstanceCreate(create_params));
+
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(baked_instance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+
+    dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(m_Instance);
+    dmArray<dmTransform::Transform>& baked_pose = *dmRig::GetPose(baked_instance);
+
+    // The baked pose follows the sampled pose, between the samples as well
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.5f));
+        for (uint32_t bi = 0; bi < pose.Size(); ++bi)
+        {
+            ASSERT_VEC3(pose[bi].GetTranslation(), baked_pose[bi].GetTranslation());
+            ASSERT_VEC4_NEAR(pose[bi].GetRotation(), baked_pose[bi].GetRotation(), 0.001f);
+            ASSERT_VEC3(pose[bi].GetScale(), baked_pose[bi].GetScale());
+        }
+    }
+
+    dmRig::InstanceDestroyParams destroy_params = {0};
+    destroy_params.m_Context = m_Context;
+    destroy_params.m_Instance = baked_instance;
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::InstanceDestroy(destroy_params));
+}
+
 TEST_F(RigInstanceTest, PoseAnimCancel)
 {
     ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0f));
@@ -21,6 +21,7 @@
 #include <dlib/http_client.h>
 #include <dlib/http_cache.h>
 #include <dlib/log.h>
+#include <dlib/path.h>
 #include <dlib/sys.h>
 #include <dlib/uri.h>
 #include <dlib/math.h>
@@ -51,6 +52,10 @@ namespace dmHttpService
         dmURI::Parts          m_CurrentURL;
         dmHttpDDF::HttpRequest*   m_Request;
         const char*           m_Filepath;
+        // The response is streamed to this file instead of m_Response when the request has a path
+        FILE*                 m_File;
+        char                  m_TmpFilepath[DMPATH_MAX_PATH];
+        bool                  m_FileError;
         int                   m_Status;
         dmArray<char>         m_Response;
         dmArray<char>         m_Headers;
@@ -94,10 +99,34 @@ namespace dmHttpService
         h.Push('\n');
     }
 
+    static void HttpContentToFile(Worker* worker, const void* content_data, uint32_t content_data_size)
+    {
+        if (!content_data && !content_data_size)
+        {
+            // The content is restarted, e.g. when the request is retried
+            if (worker->m_File) {
+                fclose(worker->m_File);
+            }
+            worker->m_File = fopen(worker->m_TmpFilepath, "wb");
+            worker->m_FileError = worker->m_File == 0;
+            return;
+        }
+
+        if (worker->m_File && fwrite(content_data, 1, content_data_size, worker->m_File) != content_data_size) {
+            worker->m_FileError = true;
+        }
+    }
+
     void HttpContent(dmHttpClient::HResponse response, void* user_data, int status_code, const void* content_data, uint32_t content_data_size)
     {
         Worker* worker = (Worker*) user_data;
         worker->m_Status = status_code;
+        if (worker->m_Filepath)
+        {
+            HttpContentToFile(worker, content_data, content_data_size);
+            return;
+        }
+
         dmArray<char>& r = worker->m_Response;
 
         if (!content_data && !content_data_size)
@@ -164,6 +193,39 @@ namespace dmHttpService
         dmHttpDDF::HttpResponse* response = (dmHttpDDF::HttpResponse*)message->m_Data;
         free((void*) response->m_Headers);
         free((void*) response->m_Response);
+        free((void*) response->m_Path);
+    }
+
+    // Closes the file the response was streamed to. The target file is only replaced if the status is 200.
+    // Returns false if the target file should have been replaced but couldn't be written.
+    static bool FinishResponseFile(Worker* worker, int status)
+    {
+        bool result = !worker->m_FileError;
+        if (worker->m_File)
+        {
+            result = (fclose(worker->m_File) == 0) && result;
+            worker->m_File = 0;
+        }
+
+        if (status != 200)
+        {
+            dmSys::Unlink(worker->m_TmpFilepath);
+            return true;
+        }
+
+        if (!result)
+        {
+            dmLogError("Failed to write the response to '%s'", worker->m_TmpFilepath);
+            dmSys::Unlink(worker->m_TmpFilepath);
+            return false;
+        }
+
+        if (dmSys::RenameFile(worker->m_Filepath, worker->m_TmpFilepath) != dmSys::RESULT_OK)
+        {
+            dmLogError("Failed to rename '%s' to '%s'", worker->m_TmpFilepath, worker->m_Filepath);
+            return false;
+        }
+        return true;
     }
 
     static void SendResponse(const dmMessage::URL* requester, uintptr_t userdata1, uintptr_t userdata2, int status,
@@ -180,12 +242,13 @@ namespace dmHttpService
         memcpy((void*) resp.m_Headers, headers, headers_length);
         resp.m_Response = (uint64_t) malloc(response_length);
         memcpy((void*) resp.m_Response, response, response_length);
-        resp.m_Path = filepath;
+        resp.m_Path = filepath ? strdup(filepath) : 0;
 
         if (dmMessage::RESULT_OK != dmMessage::Post(0, requester, dmHttpDDF::HttpResponse::m_DDFHash, userdata1, userdata2, (uintptr_t) dmHttpDDF::HttpResponse::m_DDFDescriptor, &resp, sizeof(resp), MessageDestroyCallback) )
         {
             free((void*) resp.m_Headers);
             free((void*) resp.m_Response);
+            free((void*) resp.m_Path);
             dmLogWarning("Failed to return http-response. Requester deleted?");
         }
     }
@@ -234,7 +297,17 @@ namespace dmHttpService
         worker->m_Headers.SetSize(0);
         worker->m_Headers.SetCapacity(DEFAULT_HEADER_BUFFER_SIZE);
         worker->m_Filepath = request->m_Path;
+        worker->m_File = 0;
+        worker->m_FileError = false;
+        if (worker->m_Filepath) {
+            // Large downloads are written to disc as they arrive, instead of being kept in memory
+            dmStrlCpy(worker->m_TmpFilepath, worker->m_Filepath, sizeof(worker->m_TmpFilepath));
+            dmStrlCat(worker->m_TmpFilepath, "._httptmp", sizeof(worker->m_TmpFilepath));
+            worker->m_File = fopen(worker->m_TmpFilepath, "wb");
+            worker->m_FileError = worker->m_File == 0;
+        }
 
+        int status = 0;
         if (worker->m_Client) {
             worker->m_Request = request;
             dmHttpClient::SetOptionInt(worker->m_Client, dmHttpClient::OPTION_REQUEST_TIMEOUT, request->m_Timeout);
@@ -242,17 +315,25 @@ namespace dmHttpService
 
             dmHttpClient::Result r = dmHttpClient::Request(worker->m_Client, request->m_Method, url.m_Path);
             if (r == dmHttpClient::RESULT_OK || r == dmHttpClient::RESULT_NOT_200_OK) {
-                SendResponse(requester, userdata1, userdata2, worker->m_Status, worker->m_Headers.Begin(), worker->m_Headers.Size(), worker->m_Response.Begin(), worker->m_Response.Size(), worker->m_Filepath);
+                status = worker->m_Status;
             } else {
                 // TODO: Error codes to lua?
                 dmLogError("HTTP request to '%s' failed (http result: %d  socket result: %d)", request->m_Url, r, GetLastSocketResult(worker->m_Client));
-                SendResponse(requester, userdata1, userdata2, 0, worker->m_Headers.Begin(), worker->m_Headers.Size(), worker->m_Response.Begin(), worker->m_Response.Size(), worker->m_Filepath);
             }
         } else {
             // TODO: Error codes to lua?
-            SendResponse(requester, userdata1, userdata2, 0, worker->m_Headers.Begin(), worker->m_Headers.Size(), worker->m_Response.Begin(), worker->m_Response.Size(), worker->m_Filepath);
             dmLogError("Unable to create HTTP connection to '%s'. No route to host?", request->m_Url);
         }
+
+        if (worker->m_Filepath && !FinishResponseFile(worker, status))
+        {
+            // The response data isn't used when it is saved to a file, it carries the error instead
+            const char* error = "Failed to write to temp file";
+            uint32_t error_length = strlen(error);
+            worker->m_Response.SetSize(0);
+            worker->m_Response.PushArray(error, error_length);
+        }
+        SendResponse(requester, userdata1, userdata2, status, worker->m_Headers.Begin(), worker->m_Headers.Size(), worker->m_Response.Begin(), worker->m_Response.Size(), worker->m_Filepath);
     }
 
     void Dispatch(dmMessage::Message *message, void* user_ptr)
@@ -272,6 +353,7 @@ namespace dmHttpService
                 HandleRequest(worker, &message->m_Sender, 0, message->m_UserData2, request);
                 free((void*) request->m_Headers);
                 free((void*) request->m_Request);
+                free((void*) request->m_Path);
             }
             else if (message->m_Descriptor == (uintptr_t) dmHttpDDF::StopHttp::m_DDFDescriptor)
             {
@@ -394,6 +476,9 @@ namespace dmHttpService
             worker->m_Client = 0;
             memset(&worker->m_CurrentURL, 0, sizeof(worker->m_CurrentURL));
             worker->m_Request = 0;
+            worker->m_Filepath = 0;
+            worker->m_File = 0;
+            worker->m_FileError = false;
             worker->m_Status = 0;
             worker->m_Service = service;
             worker->m_CacheFlusher = i == 0 && worker->m_Service->m_HttpCache != 0;
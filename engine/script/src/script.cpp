@@ -17,6 +17,7 @@
 #include <dlib/math.h>
 #include <dlib/pprint.h>
 #include <dlib/profile.h>
+#include <dlib/time.h>
 
 #include "script_private.h"
 #include "script_hash.h"
@@ -68,25 +69,83 @@ namespace dmScript
     // A debug value for profiling lua references
     int g_LuaReferenceCount = 0;
 
+    // Number of contexts with a sampling profiler, to keep PCall() cheap without one
+    static uint32_t g_LuaProfilerCount = 0;
+
+    // Same as the panic function of luaL_newstate
+    static int LuaPanic(lua_State* L)
+    {
+        dmLogFatal("PANIC: unprotected error in call to Lua API (%s)", lua_tostring(L, -1));
+        return 0;
+    }
+
     HContext NewContext(dmConfigFile::HConfig config_file, dmResource::HFactory factory, bool enable_extensions)
     {
         Context* context = new Context();
         context->m_Modules.SetCapacity(127, 256);
         context->m_PathToModule.SetCapacity(127, 256);
         context->m_HashInstances.SetCapacity(443, 256);
+        context->m_StringHashes.SetCapacity(1543, 4096);
         context->m_ScriptExtensions.SetCapacity(8);
         context->m_ConfigFile = config_file;
         context->m_ResourceFactory = factory;
-        context->m_LuaState = lua_open();
+        context->m_LuaAllocator = NewLuaAllocator();
+        context->m_LuaState = lua_newstate(LuaAlloc, context->m_LuaAllocator);
+        if (context->m_LuaState)
+        {
+            lua_atpanic(context->m_LuaState, LuaPanic);
+        }
+        else
+        {
+            // LuaJIT on 64 bit targets only supports its own allocator
+            DeleteLuaAllocator(context->m_LuaAllocator);
+            context->m_LuaAllocator = 0;
+            context->m_LuaState = lua_open();
+        }
         context->m_ContextTableRef = LUA_NOREF;
+        context->m_StringHashAnchorsRef = LUA_NOREF;
         context->m_EnableExtensions = enable_extensions;
+
+        context->m_GCTimeBudget = 0;
+        if (config_file)
+        {
+            float budget = dmConfigFile::GetFloat(config_file, "script.gc_time_budget", 0.0f);
+            context->m_GCTimeBudget = (uint32_t) (dmMath::Max(budget, 0.0f) * 1000.0f);
+        }
+        context->m_LuaProfiler = 0;
+        if (config_file && dmProfile::g_IsInitialized)
+        {
+            int32_t interval = dmConfigFile::GetInt(config_file, "script.profiler_sample_interval", 0);
+            if (interval > 0)
+            {
+                context->m_LuaProfiler = NewLuaProfiler(context->m_LuaState, (uint32_t) interval);
+                ++g_LuaProfilerCount;
+            }
+        }
+        context->m_GCThreshold = 0;
+        context->m_GCInCycle = false;
+        memset(&context->m_MemoryStats, 0, sizeof(context->m_MemoryStats));
+        if (context->m_GCTimeBudget)
+        {
+            // The collector is only stepped from Update()
+            lua_gc(context->m_LuaState, LUA_GCSTOP, 0);
+        }
         return context;
     }
 
     void DeleteContext(HContext context)
     {
         ClearModules(context);
+        if (context->m_LuaProfiler)
+        {
+            DeleteLuaProfiler(context->m_LuaProfiler);
+            --g_LuaProfilerCount;
+        }
         lua_close(context->m_LuaState);
+        if (context->m_LuaAllocator)
+        {
+            DeleteLuaAllocator(context->m_LuaAllocator);
+        }
         delete context;
     }
 
@@ -198,8 +257,13 @@ namespace dmScript
         lua_newtable(L);
         context->m_ContextTableRef = Ref(L, LUA_REGISTRYINDEX);
 
+        lua_newtable(L);
+        context->m_StringHashAnchorsRef = Ref(L, LUA_REGISTRYINDEX);
+
         InitializeHttp(context);
         InitializeTimer(context);
+        InitializeImageRequests(context);
+        InitializeSaveRequests(context);
         if (context->m_EnableExtensions)
         {
             InitializeExtensions(context);
@@ -223,6 +287,50 @@ namespace dmScript
         context->m_ScriptExtensions.Push(script_extension);
     }
 
+    static uint64_t GetLiveBytes(HContext context)
+    {
+        if (context->m_LuaAllocator)
+        {
+            return GetLiveBytes(context->m_LuaAllocator);
+        }
+        lua_State* L = context->m_LuaState;
+        return (uint64_t) lua_gc(L, LUA_GCCOUNT, 0) * 1024 + (uint64_t) lua_gc(L, LUA_GCCOUNTB, 0);
+    }
+
+    // Runs the incremental collector for at most m_GCTimeBudget microseconds. A new cycle starts when the
+    // memory use has doubled since the end of the last cycle, like the default pause of 200%.
+    // The budget is ignored when the memory use keeps growing faster than the collector can keep up.
+    static uint32_t StepGC(HContext context)
+    {
+        DM_PROFILE(Script, "StepGC");
+
+        lua_State* L = context->m_LuaState;
+        uint64_t live_bytes = GetLiveBytes(context);
+        if (!context->m_GCInCycle && live_bytes < context->m_GCThreshold)
+        {
+            return 0;
+        }
+        context->m_GCInCycle = true;
+
+        bool ignore_budget = context->m_GCThreshold > 0 && live_bytes > 2 * context->m_GCThreshold;
+        uint64_t start = dmTime::GetTime();
+        uint64_t elapsed = 0;
+        do
+        {
+            if (lua_gc(L, LUA_GCSTEP, 0))
+            {
+                context->m_GCInCycle = false;
+                context->m_GCThreshold = 2 * GetLiveBytes(context);
+                break;
+            }
+            elapsed = dmTime::GetTime() - start;
+        } while (elapsed < context->m_GCTimeBudget || ignore_budget);
+
+        // Stepping restarts the automatic collection
+        lua_gc(L, LUA_GCSTOP, 0);
+        return (uint32_t) (dmTime::GetTime() - start);
+    }
+
     void Update(HContext context)
     {
         for (HScriptExtension* l = context->m_ScriptExtensions.Begin(); l != context->m_ScriptExtensions.End(); ++l)
@@ -232,6 +340,39 @@ namespace dmScript
                 (*l)->Update(context);
             }
         }
+
+        LuaMemoryStats& stats = context->m_MemoryStats;
+        stats.m_GCTime = context->m_GCTimeBudget ? StepGC(context) : 0;
+        stats.m_Allocations = context->m_LuaAllocator ? ResetAllocationCount(context->m_LuaAllocator) : 0;
+        stats.m_LiveBytes = GetLiveBytes(context);
+
+        DM_COUNTER("Lua.Allocations", stats.m_Allocations);
+        DM_COUNTER("Lua.GCTime (us)", stats.m_GCTime);
+
+        if (context->m_LuaProfiler)
+        {
+            FlushLuaProfiler(context->m_LuaProfiler);
+        }
+    }
+
+    void GetLuaMemoryStats(HContext context, LuaMemoryStats* stats)
+    {
+        *stats = context->m_MemoryStats;
+    }
+
+    void SetJobContext(HContext context, dmJob::HContext job_context)
+    {
+        if (context->m_JobContext != job_context)
+        {
+            WaitImageRequests(context);
+            WaitSaveRequests(context);
+            context->m_JobContext = job_context;
+        }
+    }
+
+    dmJob::HContext GetJobContext(HContext context)
+    {
+        return context->m_JobContext;
     }
 
     void Finalize(HContext context)
@@ -252,6 +393,10 @@ namespace dmScript
         lua_pop(L, 1);
 
         Unref(L, LUA_REGISTRYINDEX, context->m_ContextTableRef);
+        Unref(L, LUA_REGISTRYINDEX, context->m_StringHashAnchorsRef);
+        context->m_StringHashAnchorsRef = LUA_NOREF;
+        // The cached strings were kept alive by the anchor table
+        context->m_StringHashes.Clear();
     }
 
     lua_State* GetLuaState(HContext context)
@@ -1397,7 +1542,15 @@ namespace dmScript
     }
 
     int PCall(lua_State* L, int nargs, int nresult) {
-        return PCallInternal(L, nargs, nresult, 0);
+        if (g_LuaProfilerCount == 0) {
+            return PCallInternal(L, nargs, nresult, 0);
+        }
+        HContext context = GetScriptContext(L);
+        HLuaProfiler profiler = context ? context->m_LuaProfiler : 0;
+        BeginLuaProfilerCall(profiler, L, nargs);
+        int result = PCallInternal(L, nargs, nresult, 0);
+        EndLuaProfilerCall(profiler);
+        return result;
     }
 
     int Ref(lua_State* L, int table)
@@ -21,6 +21,7 @@
 #include <dlib/message.h>
 #include <dlib/configfile.h>
 #include <dlib/log.h>
+#include <dlib/job.h>
 #include <resource/resource.h>
 #include <ddf/ddf.h>
 
@@ -192,6 +193,21 @@ namespace dmScript
      */
     void Update(HContext context);
 
+    /**
+     * Set the job context used for work that scripts start in the background, e.g. image.load_async().
+     * Background work in progress is finished before the job context is replaced.
+     * @param context script context
+     * @param job_context job context, or 0 to do the work on the main thread
+     */
+    void SetJobContext(HContext context, dmJob::HContext job_context);
+
+    /**
+     * Get the job context set with SetJobContext()
+     * @param context script context
+     * @return job context, may be 0
+     */
+    dmJob::HContext GetJobContext(HContext context);
+
     /**
      * Finalize script libraries
      * @param context script context
@@ -640,6 +656,32 @@ namespace dmScript
     */
     uint32_t GetLuaGCCount(lua_State* L);
 
+    /** Lua memory statistics of a script context, updated by Update()
+    */
+    struct LuaMemoryStats
+    {
+        /// Bytes currently used by the Lua state
+        uint64_t m_LiveBytes;
+        /// Allocations during the last update. Always 0 when the Lua state can't use the script allocator (LuaJIT on 64 bit)
+        uint32_t m_Allocations;
+        /// Time spent in GC steps during the last update, in microseconds. Only measured with the script.gc_time_budget setting
+        uint32_t m_GCTime;
+    };
+
+    /** Gets the Lua memory statistics of a script context
+    * @param context script context
+    * @param stats statistics (out)
+    */
+    void GetLuaMemoryStats(HContext context, LuaMemoryStats* stats);
+
+    /** Hashes the string at the index. Short strings are cached per context on Lua's interned string,
+    * so hashing the same literal again is a table lookup. Numbers are converted to strings, as with lua_tostring
+    * @param L lua state
+    * @param index index of the string
+    * @return the hash of the string
+    */
+    dmhash_t HashString(lua_State* L, int index);
+
 // DEPRECATED
 // I really don't like this callback setup (mistake on my part). It's clunky.
 // Perhaps better to have a lambda function? (now that all compilers support C++11) /MAWE
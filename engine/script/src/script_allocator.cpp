@@ -0,0 +1,145 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlib/poolallocator.h>
+
+#include "script_allocator.h"
+
+namespace dmScript
+{
+    // Blocks up to 256 bytes are rounded up to 16 byte steps, which keeps the pool blocks aligned
+    static const uint32_t SIZE_CLASS_STEP = 16;
+    static const uint32_t SIZE_CLASS_COUNT = 16;
+    static const uint32_t MAX_SMALL_SIZE = SIZE_CLASS_STEP * SIZE_CLASS_COUNT;
+    static const uint32_t POOL_PAGE_SIZE = 64 * 1024;
+
+    struct FreeListEntry
+    {
+        FreeListEntry* m_Next;
+    };
+
+    struct LuaAllocator
+    {
+        dmPoolAllocator::HPool m_Pool;
+        FreeListEntry*         m_FreeLists[SIZE_CLASS_COUNT];
+        uint64_t               m_LiveBytes;
+        uint32_t               m_Allocations;
+    };
+
+    static inline uint32_t GetSizeClass(size_t size)
+    {
+        return (uint32_t) ((size + SIZE_CLASS_STEP - 1) / SIZE_CLASS_STEP) - 1;
+    }
+
+    HLuaAllocator NewLuaAllocator()
+    {
+        LuaAllocator* allocator = new LuaAllocator;
+        memset(allocator, 0, sizeof(*allocator));
+        allocator->m_Pool = dmPoolAllocator::New(POOL_PAGE_SIZE);
+        return allocator;
+    }
+
+    void DeleteLuaAllocator(HLuaAllocator allocator)
+    {
+        // The small blocks are freed with the pool
+        dmPoolAllocator::Delete(allocator->m_Pool);
+        delete allocator;
+    }
+
+    static void* AllocBlock(LuaAllocator* allocator, size_t size)
+    {
+        if (size > MAX_SMALL_SIZE) {
+            return malloc(size);
+        }
+        uint32_t size_class = GetSizeClass(size);
+        FreeListEntry* block = allocator->m_FreeLists[size_class];
+        if (block) {
+            allocator->m_FreeLists[size_class] = block->m_Next;
+            return block;
+        }
+        return dmPoolAllocator::Alloc(allocator->m_Pool, (size_class + 1) * SIZE_CLASS_STEP);
+    }
+
+    static void FreeBlock(LuaAllocator* allocator, void* ptr, size_t size)
+    {
+        if (size > MAX_SMALL_SIZE) {
+            free(ptr);
+            return;
+        }
+        uint32_t size_class = GetSizeClass(size);
+        FreeListEntry* block = (FreeListEntry*) ptr;
+        block->m_Next = allocator->m_FreeLists[size_class];
+        allocator->m_FreeLists[size_class] = block;
+    }
+
+    void* LuaAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+    {
+        LuaAllocator* allocator = (LuaAllocator*) ud;
+        if (ptr == 0) {
+            osize = 0;
+        }
+
+        if (nsize == 0)
+        {
+            if (ptr) {
+                FreeBlock(allocator, ptr, osize);
+                allocator->m_LiveBytes -= osize;
+            }
+            return 0;
+        }
+
+        void* new_ptr;
+        if (ptr == 0)
+        {
+            new_ptr = AllocBlock(allocator, nsize);
+        }
+        else if (osize > MAX_SMALL_SIZE && nsize > MAX_SMALL_SIZE)
+        {
+            new_ptr = realloc(ptr, nsize);
+        }
+        else if (osize <= MAX_SMALL_SIZE && nsize <= MAX_SMALL_SIZE && GetSizeClass(osize) == GetSizeClass(nsize))
+        {
+            new_ptr = ptr;
+        }
+        else
+        {
+            new_ptr = AllocBlock(allocator, nsize);
+            if (new_ptr)
+            {
+                memcpy(new_ptr, ptr, osize < nsize ? osize : nsize);
+                FreeBlock(allocator, ptr, osize);
+            }
+        }
+
+        if (new_ptr)
+        {
+            allocator->m_LiveBytes = allocator->m_LiveBytes + nsize - osize;
+            ++allocator->m_Allocations;
+        }
+        return new_ptr;
+    }
+
+    uint64_t GetLiveBytes(HLuaAllocator allocator)
+    {
+        return allocator->m_LiveBytes;
+    }
+
+    uint32_t ResetAllocationCount(HLuaAllocator allocator)
+    {
+        uint32_t count = allocator->m_Allocations;
+        allocator->m_Allocations = 0;
+        return count;
+    }
+}
@@ -0,0 +1,46 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_SCRIPT_ALLOCATOR_H
+#define DM_SCRIPT_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace dmScript
+{
+    /**
+     * Allocator for Lua states. Small blocks are allocated in size classes from pools
+     * and reused through free lists, larger blocks use realloc.
+     */
+    typedef struct LuaAllocator* HLuaAllocator;
+
+    HLuaAllocator NewLuaAllocator();
+    void          DeleteLuaAllocator(HLuaAllocator allocator);
+
+    /**
+     * The lua_Alloc function, with the allocator as user data
+     */
+    void*         LuaAlloc(void* allocator, void* ptr, size_t osize, size_t nsize);
+
+    /**
+     * Bytes currently allocated by Lua
+     */
+    uint64_t      GetLiveBytes(HLuaAllocator allocator);
+
+    /**
+     * Number of allocations since the last call, and resets the count
+     */
+    uint32_t      ResetAllocationCount(HLuaAllocator allocator);
+}
+
+#endif // DM_SCRIPT_ALLOCATOR_H
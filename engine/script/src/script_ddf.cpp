@@ -33,7 +33,156 @@ namespace dmScript
 
     dmHashTable<uintptr_t, MessageDecoder> g_Decoders;
 
-    static void DoLuaTableToDDF(lua_State* L, const dmDDF::Descriptor* descriptor,
+    // How a field is converted, message types with a Lua counterpart are converted to that type
+    enum FieldKind
+    {
+        FIELD_KIND_VALUE,
+        FIELD_KIND_VECTOR3,
+        FIELD_KIND_POINT3,
+        FIELD_KIND_VECTOR4,
+        FIELD_KIND_QUAT,
+        FIELD_KIND_MATRIX4,
+        FIELD_KIND_LUAREF,
+        FIELD_KIND_MESSAGE,
+    };
+
+    struct DDFPlan;
+
+    struct DDFFieldOp
+    {
+        const dmDDF::FieldDescriptor* m_Field;
+        // Plan of the field type when the kind is FIELD_KIND_MESSAGE
+        const DDFPlan*                m_Message;
+        uint32_t                      m_Offset;
+        // Size of the elements of a repeated field, 0 if the type can't be repeated
+        uint32_t                      m_ElementSize;
+        uint8_t                       m_Type;
+        uint8_t                       m_Label;
+        uint8_t                       m_Kind;
+    };
+
+    /*
+     * Conversion plan of a message type, made the first time a message of the type is converted.
+     * The field types are resolved to flat operations up front, and the field names are pushed from
+     * a table of interned strings in the registry instead of from the C strings, see PushFieldNames().
+     * The plans don't depend on the Lua state and are kept until exit, like the decoders.
+     */
+    struct DDFPlan
+    {
+        const dmDDF::Descriptor* m_Descriptor;
+        DDFFieldOp*              m_Ops;
+        uint32_t                 m_OpCount;
+    };
+
+    static dmHashTable<uintptr_t, DDFPlan*> g_Plans;
+
+    static uint8_t GetMessageKind(const dmDDF::Descriptor* d)
+    {
+        if (strncmp(d->m_Name, DDF_TYPE_NAME_VECTOR3, sizeof(DDF_TYPE_NAME_VECTOR3)) == 0)
+            return FIELD_KIND_VECTOR3;
+        if (strncmp(d->m_Name, DDF_TYPE_NAME_POINT3, sizeof(DDF_TYPE_NAME_POINT3)) == 0)
+            return FIELD_KIND_POINT3;
+        if (strncmp(d->m_Name, DDF_TYPE_NAME_VECTOR4, sizeof(DDF_TYPE_NAME_VECTOR4)) == 0)
+            return FIELD_KIND_VECTOR4;
+        if (strncmp(d->m_Name, DDF_TYPE_NAME_QUAT, sizeof(DDF_TYPE_NAME_QUAT)) == 0)
+            return FIELD_KIND_QUAT;
+        if (strncmp(d->m_Name, DDF_TYPE_NAME_MATRIX4, sizeof(DDF_TYPE_NAME_MATRIX4)) == 0)
+            return FIELD_KIND_MATRIX4;
+        if (strncmp(d->m_Name, DDF_TYPE_NAME_LUAREF, sizeof(DDF_TYPE_NAME_LUAREF)) == 0)
+            return FIELD_KIND_LUAREF;
+        return FIELD_KIND_MESSAGE;
+    }
+
+    static uint32_t GetElementSize(const dmDDF::FieldDescriptor* f)
+    {
+        switch (f->m_Type)
+        {
+            case dmDDF::TYPE_INT32:
+            case dmDDF::TYPE_UINT32:
+                return sizeof(int32_t);
+            case dmDDF::TYPE_UINT64:
+                return sizeof(uint64_t);
+            case dmDDF::TYPE_BOOL:
+                return sizeof(bool);
+            case dmDDF::TYPE_FLOAT:
+                return sizeof(float);
+            case dmDDF::TYPE_STRING:
+                return sizeof(const char*);
+            case dmDDF::TYPE_ENUM:
+                return sizeof(int);
+            case dmDDF::TYPE_MESSAGE:
+                return f->m_MessageDescriptor->m_Size;
+            default:
+                return 0;
+        }
+    }
+
+    static const DDFPlan* GetPlan(const dmDDF::Descriptor* descriptor)
+    {
+        DDFPlan** cached = g_Plans.Get((uintptr_t) descriptor);
+        if (cached)
+        {
+            return *cached;
+        }
+
+        DDFPlan* plan = new DDFPlan;
+        plan->m_Descriptor = descriptor;
+        plan->m_OpCount = descriptor->m_FieldCount;
+        plan->m_Ops = new DDFFieldOp[descriptor->m_FieldCount];
+
+        // Added before the fields are resolved, so that recursive message types find it
+        if (g_Plans.Full())
+        {
+            uint32_t capacity = g_Plans.Capacity() + 128;
+            g_Plans.SetCapacity((100 * capacity) / 80, capacity);
+        }
+        g_Plans.Put((uintptr_t) descriptor, plan);
+
+        for (uint32_t i = 0; i < descriptor->m_FieldCount; ++i)
+        {
+            const dmDDF::FieldDescriptor* f = &descriptor->m_Fields[i];
+            DDFFieldOp* op = &plan->m_Ops[i];
+            op->m_Field = f;
+            op->m_Message = 0;
+            op->m_Offset = f->m_Offset;
+            op->m_ElementSize = GetElementSize(f);
+            op->m_Type = (uint8_t) f->m_Type;
+            op->m_Label = (uint8_t) f->m_Label;
+            op->m_Kind = FIELD_KIND_VALUE;
+            if (f->m_Type == dmDDF::TYPE_MESSAGE)
+            {
+                op->m_Kind = GetMessageKind(f->m_MessageDescriptor);
+                if (op->m_Kind == FIELD_KIND_MESSAGE)
+                {
+                    op->m_Message = GetPlan(f->m_MessageDescriptor);
+                }
+            }
+        }
+        return plan;
+    }
+
+    // Pushes the table of field names of the plan, and returns its stack index
+    static int PushFieldNames(lua_State* L, const DDFPlan* plan)
+    {
+        lua_pushlightuserdata(L, (void*) plan);
+        lua_rawget(L, LUA_REGISTRYINDEX);
+        if (lua_isnil(L, -1))
+        {
+            lua_pop(L, 1);
+            lua_createtable(L, plan->m_OpCount, 0);
+            for (uint32_t i = 0; i < plan->m_OpCount; ++i)
+            {
+                lua_pushstring(L, plan->m_Ops[i].m_Field->m_Name);
+                lua_rawseti(L, -2, i + 1);
+            }
+            lua_pushlightuserdata(L, (void*) plan);
+            lua_pushvalue(L, -2);
+            lua_rawset(L, LUA_REGISTRYINDEX);
+        }
+        return lua_gettop(L);
+    }
+
+    static void DoLuaTableToDDF(lua_State* L, const DDFPlan* plan,
                                 char* buffer, char** data_start, char** data_last, int index, char* pointer_base);
 
     static void DefaultLuaValueToDDF(lua_State* L, const dmDDF::FieldDescriptor* f,
@@ -169,49 +318,21 @@ namespace dmScript
         }
     }
 
-    static void LuaValueToDDF(lua_State* L, const dmDDF::FieldDescriptor* f,
+    static void LuaValueToDDF(lua_State* L, const DDFFieldOp* op,
                               char* buffer, char** data_start, char** data_end, char* pointer_base)
     {
-        char* where = &buffer[f->m_Offset];
+        char* where = &buffer[op->m_Offset];
         bool nil_val = lua_isnil(L, -1);
         bool array = false;
         uint32_t n = 1;
         uint32_t sz = 0;
 
-        if (f->m_Label == dmDDF::LABEL_REPEATED)
+        if (op->m_Label == dmDDF::LABEL_REPEATED)
         {
             luaL_checktype(L, -1, LUA_TTABLE);
 
-            switch (f->m_Type)
-            {
-                case dmDDF::TYPE_INT32:
-                case dmDDF::TYPE_UINT32:
-                    sz = sizeof(int32_t);
-                    break;
-                case dmDDF::TYPE_UINT64:
-                    sz = sizeof(uint64_t);
-                    break;
-                case dmDDF::TYPE_BOOL:
-                    sz = sizeof(bool);
-                    break;
-                case dmDDF::TYPE_FLOAT:
-                    sz = sizeof(float);
-                    break;
-                case dmDDF::TYPE_STRING:
-                    sz = sizeof(const char*);
-                    break;
-                case dmDDF::TYPE_ENUM:
-                    sz = sizeof(int);
-                    break;
-                case dmDDF::TYPE_MESSAGE:
-                    {
-                        const dmDDF::Descriptor* d = f->m_MessageDescriptor;
-                        sz = d->m_Size;
-                        break;
-                    }
-                default:
-                    assert(false);
-            }
+            sz = op->m_ElementSize;
+            assert(sz > 0);
 
             n = lua_objlen(L, -1);
             *data_start = (char*)DM_ALIGN(*data_start, 16);
@@ -237,7 +358,7 @@ namespace dmScript
                 lua_rawgeti(L, -1, i + 1);
             }
 
-            switch (f->m_Type)
+            switch (op->m_Type)
             {
                 case dmDDF::TYPE_INT32:
                 {
@@ -287,9 +408,10 @@ namespace dmScript
                 case dmDDF::TYPE_STRING:
                 {
                     const char* s = "";
+                    size_t length = 0;
                     if (!nil_val)
-                        s = luaL_checkstring(L, -1);
-                    int size = strlen(s) + 1;
+                        s = luaL_checklstring(L, -1, &length);
+                    int size = length + 1;
                     if (*data_start + size > *data_end)
                     {
                         luaL_error(L, "Message data doesn't fit");
@@ -317,35 +439,26 @@ namespace dmScript
                 {
                     if (!nil_val)
                     {
-                        const dmDDF::Descriptor* d = f->m_MessageDescriptor;
-                        bool is_vector3 = strncmp(d->m_Name, DDF_TYPE_NAME_VECTOR3, sizeof(DDF_TYPE_NAME_VECTOR3)) == 0;
-                        bool is_point3 = strncmp(d->m_Name, DDF_TYPE_NAME_POINT3, sizeof(DDF_TYPE_NAME_POINT3)) == 0;
-                        if (is_vector3 || is_point3)
+                        switch (op->m_Kind)
                         {
-                            Vectormath::Aos::Vector3* v = dmScript::CheckVector3(L, -1);
-                            if (is_vector3)
-                                *((Vectormath::Aos::Vector3 *) where) = *v;
-                            else
-                                *((Vectormath::Aos::Point3 *) where) = Vectormath::Aos::Point3(*v);
-                        }
-                        else if (strncmp(d->m_Name, DDF_TYPE_NAME_VECTOR4, sizeof(DDF_TYPE_NAME_VECTOR4)) == 0)
-                        {
-                            Vectormath::Aos::Vector4* v = dmScript::CheckVector4(L, -1);
-                            *((Vectormath::Aos::Vector4 *) where) = *v;
-                        }
-                        else if (strncmp(d->m_Name, DDF_TYPE_NAME_QUAT, sizeof(DDF_TYPE_NAME_QUAT)) == 0)
-                        {
-                            Vectormath::Aos::Quat* q = dmScript::CheckQuat(L, -1);
-                            *((Vectormath::Aos::Quat *) where) = *q;
-                        }
-                        else if (strncmp(d->m_Name, DDF_TYPE_NAME_MATRIX4, sizeof(DDF_TYPE_NAME_MATRIX4)) == 0)
-                        {
-                            Vectormath::Aos::Matrix4* m = dmScript::CheckMatrix4(L, -1);
-                            *((Vectormath::Aos::Matrix4*) where) = *m;
-                        }
-                        else
-                        {
-                            DoLuaTableToDDF(L, d, where, data_start, data_end, lua_gettop(L), pointer_base);
+                            case FIELD_KIND_VECTOR3:
+                                *((Vectormath::Aos::Vector3 *) where) = *dmScript::CheckVector3(L, -1);
+                                break;
+                            case FIELD_KIND_POINT3:
+                                *((Vectormath::Aos::Point3 *) where) = Vectormath::Aos::Point3(*dmScript::CheckVector3(L, -1));
+                                break;
+                            case FIELD_KIND_VECTOR4:
+                                *((Vectormath::Aos::Vector4 *) where) = *dmScript::CheckVector4(L, -1);
+                                break;
+                            case FIELD_KIND_QUAT:
+                                *((Vectormath::Aos::Quat *) where) = *dmScript::CheckQuat(L, -1);
+                                break;
+                            case FIELD_KIND_MATRIX4:
+                                *((Vectormath::Aos::Matrix4*) where) = *dmScript::CheckMatrix4(L, -1);
+                                break;
+                            default:
+                                DoLuaTableToDDF(L, GetPlan(op->m_Field->m_MessageDescriptor), where, data_start, data_end, lua_gettop(L), pointer_base);
+                                break;
                         }
                     }
                 }
@@ -353,7 +466,7 @@ namespace dmScript
 
                 default:
                 {
-                    luaL_error(L, "Unsupported type %d in field %s", f->m_Type, f->m_Name);
+                    luaL_error(L, "Unsupported type %d in field %s", op->m_Type, op->m_Field->m_Name);
                 }
                 break;
             }
@@ -380,16 +493,18 @@ namespace dmScript
         }
     }
 
-    static void DoLuaTableToDDF(lua_State* L, const dmDDF::Descriptor* descriptor,
+    static void DoLuaTableToDDF(lua_State* L, const DDFPlan* plan,
                                 char* buffer, char** data_start, char** data_last, int index, char* pointer_base)
     {
         luaL_checktype(L, index, LUA_TTABLE);
 
-        for (uint32_t i = 0; i < descriptor->m_FieldCount; ++i)
+        int names = PushFieldNames(L, plan);
+        for (uint32_t i = 0; i < plan->m_OpCount; ++i)
         {
-            const dmDDF::FieldDescriptor* f = &descriptor->m_Fields[i];
+            const DDFFieldOp* op = &plan->m_Ops[i];
+            const dmDDF::FieldDescriptor* f = op->m_Field;
 
-            lua_pushstring(L, f->m_Name);
+            lua_rawgeti(L, names, i + 1);
             lua_rawget(L, index);
             if (lua_isnil(L, -1))
             {
@@ -417,10 +532,11 @@ namespace dmScript
             }
             else
             {
-                LuaValueToDDF(L, f, buffer, data_start, data_last, pointer_base);
+                LuaValueToDDF(L, op, buffer, data_start, data_last, pointer_base);
             }
             lua_pop(L, 1);
         }
+        lua_pop(L, 1);
     }
 
     uint32_t CheckDDF(lua_State* L, const dmDDF::Descriptor* descriptor, char* buffer, uint32_t buffer_size, int index)
@@ -437,28 +553,30 @@ namespace dmScript
         char* data_start = buffer + size;
         char* data_end = data_start + buffer_size - size;
 
-        DoLuaTableToDDF(L, descriptor, buffer, &data_start, &data_end, index, buffer);
+        DoLuaTableToDDF(L, GetPlan(descriptor), buffer, &data_start, &data_end, index, buffer);
         return data_start - buffer;
     }
 
-    void DDFToLuaValue(lua_State* L, const dmDDF::FieldDescriptor* f, const char* data, uintptr_t pointers_offset)
+    static void PushMessage(lua_State* L, const DDFPlan* plan, const char* data, uintptr_t pointers_offset);
+
+    static void DDFToLuaValue(lua_State* L, const DDFFieldOp* op, const char* data, uintptr_t pointers_offset)
     {
-        const char *where = &data[f->m_Offset];
+        const char *where = &data[op->m_Offset];
         uint32_t count = 1;
         bool array = false;
 
-        if (f->m_Label == dmDDF::LABEL_REPEATED)
+        if (op->m_Label == dmDDF::LABEL_REPEATED)
         {
-            dmDDF::RepeatedField* repeated = (dmDDF::RepeatedField*) &data[f->m_Offset];
+            dmDDF::RepeatedField* repeated = (dmDDF::RepeatedField*) &data[op->m_Offset];
             where = (const char*)(repeated->m_Array + pointers_offset);
             count = repeated->m_ArrayCount;
             array = true;
-            lua_newtable(L);
+            lua_createtable(L, count, 0);
         }
 
         for (uint32_t i=0;i!=count;i++)
         {
-            switch (f->m_Type)
+            switch (op->m_Type)
             {
                 case dmDDF::TYPE_INT32:
                 {
@@ -512,58 +630,48 @@ namespace dmScript
 
                 case dmDDF::TYPE_MESSAGE:
                 {
-                    const dmDDF::Descriptor* d = f->m_MessageDescriptor;
-                    const char *ptr = where + i * d->m_Size;
-                    if (strncmp(d->m_Name, DDF_TYPE_NAME_VECTOR3, sizeof(DDF_TYPE_NAME_VECTOR3)) == 0)
-                    {
-                        dmScript::PushVector3(L, *((Vectormath::Aos::Vector3*) ptr));
-                    }
-                    else if (strncmp(d->m_Name, DDF_TYPE_NAME_POINT3, sizeof(DDF_TYPE_NAME_POINT3)) == 0)
+                    const char *ptr = where + i * op->m_ElementSize;
+                    switch (op->m_Kind)
                     {
-                        dmScript::PushVector3(L, Vectormath::Aos::Vector3(*((Vectormath::Aos::Vector3*) ptr)));
-                    }
-                    else if (strncmp(d->m_Name, DDF_TYPE_NAME_VECTOR4, sizeof(DDF_TYPE_NAME_VECTOR4)) == 0)
-                    {
-                        dmScript::PushVector4(L, *((Vectormath::Aos::Vector4*) ptr));
-                    }
-                    else if (strncmp(d->m_Name, DDF_TYPE_NAME_QUAT, sizeof(DDF_TYPE_NAME_QUAT)) == 0)
-                    {
-                        dmScript::PushQuat(L, *((Vectormath::Aos::Quat*) ptr));
-                    }
-                    else if (strncmp(d->m_Name, DDF_TYPE_NAME_MATRIX4, sizeof(DDF_TYPE_NAME_MATRIX4)) == 0)
-                    {
-                        dmScript::PushMatrix4(L, *((Vectormath::Aos::Matrix4*) ptr));
-                    }
-                    else if (strncmp(d->m_Name, DDF_TYPE_NAME_LUAREF, sizeof(DDF_TYPE_NAME_LUAREF)) == 0)
-                    {
-                        dmScriptDDF::LuaRef* lua_ref = (dmScriptDDF::LuaRef*) ptr;
-                        if (lua_ref->m_Ref)
-                        {
-                            lua_rawgeti(L, LUA_REGISTRYINDEX, lua_ref->m_ContextTableRef);
-                            lua_rawgeti(L, -1, lua_ref->m_Ref);
-                            lua_remove(L, -2);
-                        }
-                        else
+                        case FIELD_KIND_VECTOR3:
+                            dmScript::PushVector3(L, *((Vectormath::Aos::Vector3*) ptr));
+                            break;
+                        case FIELD_KIND_POINT3:
+                            dmScript::PushVector3(L, Vectormath::Aos::Vector3(*((Vectormath::Aos::Vector3*) ptr)));
+                            break;
+                        case FIELD_KIND_VECTOR4:
+                            dmScript::PushVector4(L, *((Vectormath::Aos::Vector4*) ptr));
+                            break;
+                        case FIELD_KIND_QUAT:
+                            dmScript::PushQuat(L, *((Vectormath::Aos::Quat*) ptr));
+                            break;
+                        case FIELD_KIND_MATRIX4:
+                            dmScript::PushMatrix4(L, *((Vectormath::Aos::Matrix4*) ptr));
+                            break;
+                        case FIELD_KIND_LUAREF:
                         {
-                            lua_pushnil(L);
-                        }
-                    }
-                    else
-                    {
-                        lua_newtable(L);
-                        for (uint32_t j = 0; j < d->m_FieldCount; ++j)
-                        {
-                            const dmDDF::FieldDescriptor* f2 = &d->m_Fields[j];
-                            lua_pushstring(L, f2->m_Name);
-                            DDFToLuaValue(L, &d->m_Fields[j], ptr, pointers_offset);
-                            lua_rawset(L, -3);
+                            dmScriptDDF::LuaRef* lua_ref = (dmScriptDDF::LuaRef*) ptr;
+                            if (lua_ref->m_Ref)
+                            {
+                                lua_rawgeti(L, LUA_REGISTRYINDEX, lua_ref->m_ContextTableRef);
+                                lua_rawgeti(L, -1, lua_ref->m_Ref);
+                                lua_remove(L, -2);
+                            }
+                            else
+                            {
+                                lua_pushnil(L);
+                            }
                         }
+                        break;
+                        default:
+                            PushMessage(L, op->m_Message, ptr, pointers_offset);
+                            break;
                     }
                 }
                 break;
                 default:
                 {
-                    luaL_error(L, "Unsupported type %d in field %s", f->m_Type, f->m_Name);
+                    luaL_error(L, "Unsupported type %d in field %s", op->m_Type, op->m_Field->m_Name);
                 }
             }
 
@@ -574,6 +682,19 @@ namespace dmScript
         }
     }
 
+    static void PushMessage(lua_State* L, const DDFPlan* plan, const char* data, uintptr_t pointers_offset)
+    {
+        lua_createtable(L, 0, plan->m_OpCount);
+        int names = PushFieldNames(L, plan);
+        for (uint32_t i = 0; i < plan->m_OpCount; ++i)
+        {
+            lua_rawgeti(L, names, i + 1);
+            DDFToLuaValue(L, &plan->m_Ops[i], data, pointers_offset);
+            lua_rawset(L, names - 1);
+        }
+        lua_pop(L, 1);
+    }
+
     void PushDDF(lua_State*L, const dmDDF::Descriptor* d, const char* data)
     {
         PushDDF(L, d, data, false);
@@ -593,15 +714,7 @@ namespace dmScript
             if (pointers_are_offsets)
                 pointers_offset = (uintptr_t) data;
 
-            lua_newtable(L);
-            for (uint32_t i = 0; i < d->m_FieldCount; ++i)
-            {
-                const dmDDF::FieldDescriptor* f = &d->m_Fields[i];
-
-                lua_pushstring(L, f->m_Name);
-                DDFToLuaValue(L, &d->m_Fields[i], data, pointers_offset);
-                lua_rawset(L, -3);
-            }
+            PushMessage(L, GetPlan(d), data, pointers_offset);
         }
     }
 
@@ -68,6 +68,7 @@ namespace dmScript
             dmExtension::Params p;
             p.m_ConfigFile = GetConfigFile(context);
             p.m_L = L;
+            p.m_JobContext = GetJobContext(context);
             dmExtension::Result r = ed->Initialize(&p);
             if (r == dmExtension::RESULT_OK) {
                 extension_data->m_InitializedExtensions[BIT_INDEX(i)] |= 1 << BIT_OFFSET(i);
@@ -110,6 +111,7 @@ namespace dmScript
                 dmExtension::Params p;
                 p.m_ConfigFile = GetConfigFile(context);
                 p.m_L = L;
+                p.m_JobContext = GetJobContext(context);
                 if (extension_data->m_InitializedExtensions[BIT_INDEX(i)] & (1 << BIT_OFFSET(i))) {
                     dmExtension::Result r = ed->Update(&p);
                     if (r != dmExtension::RESULT_OK) {
@@ -140,6 +142,7 @@ namespace dmScript
                 dmExtension::Params p;
                 p.m_ConfigFile = GetConfigFile(context);
                 p.m_L = L;
+                p.m_JobContext = GetJobContext(context);
                 if (extension_data->m_InitializedExtensions[BIT_INDEX(i)] & (1 << BIT_OFFSET(i))) {
                     dmExtension::Result r = ed->Finalize(&p);
                     if (r != dmExtension::RESULT_OK) {
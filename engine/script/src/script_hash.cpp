@@ -76,8 +76,8 @@ namespace dmScript
         }
         else
         {
-            const char* str = luaL_checkstring(L, 1);
-            hash = dmHashString64(str);
+            luaL_checkstring(L, 1);
+            hash = HashString(L, 1);
         }
         PushHash(L, hash);
 
@@ -132,6 +132,52 @@ namespace dmScript
         return 1;
     }
 
+    // Longer strings are rarely literals, and would make the anchored strings use a lot of memory
+    static const uint32_t MAX_CACHED_STRING_LENGTH = 128;
+
+    dmhash_t HashString(lua_State* L, int index)
+    {
+        size_t len = 0;
+        if (lua_type(L, index) != LUA_TSTRING)
+        {
+            // A converted number isn't kept alive by anything, so it isn't cached
+            const char* s = luaL_checklstring(L, index, &len);
+            return dmHashBuffer64(s, len);
+        }
+
+        const char* s = lua_tolstring(L, index, &len);
+        HContext context = dmScript::GetScriptContext(L);
+        if (len > MAX_CACHED_STRING_LENGTH || context == 0x0 || context->m_StringHashAnchorsRef == LUA_NOREF)
+        {
+            return dmHashBuffer64(s, len);
+        }
+
+        // Lua interns all strings, so equal strings share the same pointer while they're alive
+        dmHashTable64<dmhash_t>* hashes = &context->m_StringHashes;
+        dmhash_t* cached = hashes->Get((uint64_t)(uintptr_t)s);
+        if (cached)
+        {
+            return *cached;
+        }
+
+        dmhash_t hash = dmHashBuffer64(s, len);
+        if (!hashes->Full())
+        {
+            if (index < 0 && index > LUA_REGISTRYINDEX)
+            {
+                index = lua_gettop(L) + index + 1;
+            }
+            // Anchor the string, so that the pointer can't be reused by another string
+            lua_rawgeti(L, LUA_REGISTRYINDEX, context->m_StringHashAnchorsRef);
+            lua_pushvalue(L, index);
+            lua_pushboolean(L, 1);
+            lua_rawset(L, -3);
+            lua_pop(L, 1);
+            hashes->Put((uint64_t)(uintptr_t)s, hash);
+        }
+        return hash;
+    }
+
     void PushHash(lua_State* L, dmhash_t hash)
     {
         int top = lua_gettop(L);
@@ -216,8 +262,7 @@ namespace dmScript
         else if( lua_type(L, index) == LUA_TSTRING )
         {
             size_t len = 0;
-            const char* s = lua_tolstring(L, index, &len);
-            return dmHashBuffer64(s, len);
+            return HashString(L, index);
         }
 
         luaL_typerror(L, index, "hash or string expected");
@@ -82,7 +82,8 @@ namespace dmScript
      * @param [options] [type:table] optional table with request parameters. Supported entries:
      *
      * - [type:number] `timeout`: timeout in seconds
-     * - [type:string] `path`: path on disc where to download the file. Only overwrites the path if status is 200
+     * - [type:string] `path`: path on disc where to download the file. Only overwrites the path if status is 200.
+     * The response is written to the file while it is downloaded, so large files are never held in memory
      * - [type:boolean] `ignore_cache`: don't return cached data if we get a 304
      *
      *
@@ -220,7 +221,8 @@ namespace dmScript
             request->m_Request = (uint64_t) request_data;
             request->m_RequestLength = request_data_length;
             request->m_Timeout = timeout;
-            request->m_Path = path;
+            // The request is handled on a worker thread, the path must outlive the Lua string
+            request->m_Path = path ? strdup(path) : 0;
             request->m_IgnoreCache = ignore_cache;
 
             uint32_t post_len = sizeof(dmHttpDDF::HttpRequest) + method_len + 1 + url_len + 1;
@@ -231,6 +233,9 @@ namespace dmScript
             dmMessage::Result r = dmMessage::Post(&sender, &receiver, dmHttpDDF::HttpRequest::m_DDFHash, 0, (uintptr_t)callback, (uintptr_t) dmHttpDDF::HttpRequest::m_DDFDescriptor, buf, post_len, 0);
             if (r != dmMessage::RESULT_OK) {
                 dmLogError("Failed to create HTTP request");
+                free(headers);
+                free(request_data);
+                free((void*) request->m_Path);
             }
             assert(top == lua_gettop(L));
             return 0;
@@ -76,6 +76,7 @@ namespace dmScript
         resp.m_HeadersLength = headers_length;
         resp.m_Response = (uint64_t) response;
         resp.m_ResponseLength = response_length;
+        resp.m_Path = 0;
 
         resp.m_Headers = (uint64_t) malloc(headers_length);
         memcpy((void*) resp.m_Headers, headers, headers_length);
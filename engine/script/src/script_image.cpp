@@ -16,7 +16,10 @@
 
 #include <dlib/log.h>
 #include <dlib/image.h>
+#include <dlib/job.h>
+#include <dlib/profile.h>
 #include "script.h"
+#include "script_image.h"
 
 extern "C"
 {
@@ -57,6 +60,41 @@ namespace dmScript
      * @variable
      */
 
+    static void PushImage(lua_State* L, const dmImage::Image& image)
+    {
+        int bytes_per_pixel = dmImage::BytesPerPixel(image.m_Type);
+
+        lua_newtable(L);
+
+        lua_pushliteral(L, "width");
+        lua_pushinteger(L, image.m_Width);
+        lua_rawset(L, -3);
+
+        lua_pushliteral(L, "height");
+        lua_pushinteger(L, image.m_Height);
+        lua_rawset(L, -3);
+
+        lua_pushliteral(L, "type");
+        switch (image.m_Type) {
+            case dmImage::TYPE_RGB:
+                lua_pushliteral(L, "rgb");
+                break;
+            case dmImage::TYPE_RGBA:
+                lua_pushliteral(L, "rgba");
+                break;
+            case dmImage::TYPE_LUMINANCE:
+                lua_pushliteral(L, "l");
+                break;
+            default:
+                assert(false);
+        }
+        lua_rawset(L, -3);
+
+        lua_pushliteral(L, "buffer");
+        lua_pushlstring(L, (const char*) image.m_Buffer, bytes_per_pixel * image.m_Width * image.m_Height);
+        lua_rawset(L, -3);
+    }
+
     /*# load image from buffer
     * Load image (PNG or JPEG) from buffer.
     *
@@ -100,45 +138,12 @@ namespace dmScript
         dmImage::Image image;
         dmImage::Result r = dmImage::Load(buffer, buffer_len, premult, &image);
         if (r == dmImage::RESULT_OK) {
-
-            int bytes_per_pixel = dmImage::BytesPerPixel(image.m_Type);
-            if (bytes_per_pixel == 0) {
+            if (dmImage::BytesPerPixel(image.m_Type) == 0) {
                 dmImage::Free(&image);
                 luaL_error(L, "unknown image type %d", image.m_Type);
             }
-
-            lua_newtable(L);
-
-            lua_pushliteral(L, "width");
-            lua_pushinteger(L, image.m_Width);
-            lua_rawset(L, -3);
-
-            lua_pushliteral(L, "height");
-            lua_pushinteger(L, image.m_Height);
-            lua_rawset(L, -3);
-
-            lua_pushliteral(L, "type");
-            switch (image.m_Type) {
-                case dmImage::TYPE_RGB:
-                    lua_pushliteral(L, "rgb");
-                    break;
-                case dmImage::TYPE_RGBA:
-                    lua_pushliteral(L, "rgba");
-                    break;
-                case dmImage::TYPE_LUMINANCE:
-                    lua_pushliteral(L, "l");
-                    break;
-                default:
-                    assert(false);
-            }
-            lua_rawset(L, -3);
-
-            lua_pushliteral(L, "buffer");
-            lua_pushlstring(L, (const char*) image.m_Buffer, bytes_per_pixel * image.m_Width * image.m_Height);
-            lua_rawset(L, -3);
-
+            PushImage(L, image);
             dmImage::Free(&image);
-
         } else {
             dmLogWarning("failed to load image (%d)", r);
             lua_pushnil(L);
@@ -148,9 +153,191 @@ namespace dmScript
         return 1;
     }
 
+    struct ImageRequest
+    {
+        LuaCallbackInfo*    m_Callback;
+        // The encoded data is a Lua string, kept alive by this reference while it is decoded
+        const char*         m_Data;
+        uint32_t            m_DataSize;
+        int                 m_DataReference;
+        dmJob::HJob         m_Job;
+        dmImage::Image      m_Image;
+        dmImage::Result     m_Result;
+        bool                m_Premult;
+    };
+
+    static void DecodeImage(void* context, void* data)
+    {
+        DM_PROFILE(Script, "DecodeImage");
+        ImageRequest* request = (ImageRequest*) data;
+        request->m_Result = dmImage::Load(request->m_Data, request->m_DataSize, request->m_Premult, &request->m_Image);
+    }
+
+    /*# load image from buffer asynchronously
+    * Load image (PNG or JPEG) from buffer without blocking the game. The image is decoded on
+    * a worker thread when the engine runs with job threads, and the callback is called from
+    * the main thread in a later frame.
+    *
+    * @name image.load_async
+    * @param buffer [type:string] image data buffer
+    * @param [premult] [type:boolean] optional flag if alpha should be premultiplied. Defaults to `false`
+    * @param callback [type:function(self, image)] function called when the image is loaded
+    *
+    * `self`
+    * : [type:object] The current object.
+    *
+    * `image`
+    * : [type:table] The image, with the same fields as the result of `image.load`, or `nil` if loading failed.
+    *
+    * @examples
+    *
+    * How to load an image from an URL without stalling the game:
+    *
+    * ```lua
+    * local imgurl = "http://www.site.com/image.png"
+    * http.request(imgurl, "GET", function(self, id, response)
+    *         image.load_async(response.response, function(self, img)
+    *             if img then
+    *                 gui.new_texture("image_node", img.width, img.height, img.type, img.buffer)
+    *             end
+    *         end)
+    *     end)
+    * ```
+    */
+    int Image_LoadAsync(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        luaL_checktype(L, 1, LUA_TSTRING);
+
+        bool premult = false;
+        int callback_index = 2;
+        if (lua_gettop(L) >= 3) {
+            premult = lua_toboolean(L, 2);
+            callback_index = 3;
+        }
+        LuaCallbackInfo* callback = CreateCallback(L, callback_index);
+        if (callback == 0x0) {
+            return DM_LUA_ERROR("image.load_async can only be called from a script instance");
+        }
+
+        size_t buffer_len = 0;
+        ImageRequest* request = new ImageRequest;
+        request->m_Callback = callback;
+        request->m_Data = lua_tolstring(L, 1, &buffer_len);
+        request->m_DataSize = (uint32_t) buffer_len;
+        lua_pushvalue(L, 1);
+        request->m_DataReference = Ref(L, LUA_REGISTRYINDEX);
+        request->m_Job = dmJob::INVALID_JOB;
+        request->m_Result = dmImage::RESULT_IMAGE_ERROR;
+        request->m_Premult = premult;
+
+        HContext context = GetScriptContext(L);
+        if (context->m_JobContext) {
+            request->m_Job = dmJob::CreateJob(context->m_JobContext, DecodeImage, 0, request, dmJob::INVALID_JOB);
+            if (request->m_Job != dmJob::INVALID_JOB) {
+                dmJob::Run(context->m_JobContext, request->m_Job);
+            }
+        }
+        if (request->m_Job == dmJob::INVALID_JOB) {
+            // No job threads, decode now. The callback is still called in the next update.
+            DecodeImage(0, request);
+        }
+
+        dmArray<ImageRequest*>& requests = context->m_ImageRequests;
+        if (requests.Full()) {
+            requests.OffsetCapacity(8);
+        }
+        requests.Push(request);
+        return 0;
+    }
+
+    static void CompleteImageRequest(HContext context, ImageRequest* request, bool invoke_callback)
+    {
+        lua_State* L = context->m_LuaState;
+        DM_LUA_STACK_CHECK(L, 0);
+
+        if (invoke_callback && SetupCallback(request->m_Callback))
+        {
+            if (request->m_Result == dmImage::RESULT_OK && dmImage::BytesPerPixel(request->m_Image.m_Type) != 0) {
+                PushImage(L, request->m_Image);
+            } else {
+                dmLogWarning("failed to load image (%d)", request->m_Result);
+                lua_pushnil(L);
+            }
+            PCall(L, 2, 0);
+            TeardownCallback(request->m_Callback);
+        }
+        DestroyCallback(request->m_Callback);
+        Unref(L, LUA_REGISTRYINDEX, request->m_DataReference);
+        if (request->m_Result == dmImage::RESULT_OK) {
+            dmImage::Free(&request->m_Image);
+        }
+        delete request;
+    }
+
+    void WaitImageRequests(HContext context)
+    {
+        dmArray<ImageRequest*>& requests = context->m_ImageRequests;
+        for (uint32_t i = 0; i < requests.Size(); ++i)
+        {
+            if (requests[i]->m_Job != dmJob::INVALID_JOB) {
+                dmJob::Wait(context->m_JobContext, requests[i]->m_Job);
+                requests[i]->m_Job = dmJob::INVALID_JOB;
+            }
+        }
+    }
+
+    static void ImageRequestsUpdate(HContext context)
+    {
+        dmArray<ImageRequest*>& requests = context->m_ImageRequests;
+        if (requests.Empty()) {
+            return;
+        }
+
+        DM_PROFILE(Script, "ImageRequests");
+        // Callbacks are called in the order the requests were made, unfinished requests are kept
+        uint32_t pending = 0;
+        for (uint32_t i = 0; i < requests.Size(); ++i)
+        {
+            ImageRequest* request = requests[i];
+            if (request->m_Job != dmJob::INVALID_JOB && !dmJob::IsFinished(context->m_JobContext, request->m_Job)) {
+                requests[pending++] = request;
+                continue;
+            }
+            CompleteImageRequest(context, request, true);
+        }
+        requests.SetSize(pending);
+    }
+
+    static void ImageRequestsFinalize(HContext context)
+    {
+        WaitImageRequests(context);
+        dmArray<ImageRequest*>& requests = context->m_ImageRequests;
+        for (uint32_t i = 0; i < requests.Size(); ++i)
+        {
+            CompleteImageRequest(context, requests[i], false);
+        }
+        requests.SetSize(0);
+    }
+
+    void InitializeImageRequests(HContext context)
+    {
+        static ScriptExtension sl;
+        sl.Initialize = 0x0;
+        sl.Update = ImageRequestsUpdate;
+        sl.Finalize = ImageRequestsFinalize;
+        sl.NewScriptWorld = 0x0;
+        sl.DeleteScriptWorld = 0x0;
+        sl.UpdateScriptWorld = 0x0;
+        sl.InitializeScriptInstance = 0x0;
+        sl.FinalizeScriptInstance = 0x0;
+        RegisterScriptExtension(context, &sl);
+    }
+
     static const luaL_reg ScriptImage_methods[] =
     {
         {"load", Image_Load},
+        {"load_async", Image_LoadAsync},
         {0, 0}
     };
 
@@ -20,7 +20,15 @@ extern "C"
 
 namespace dmScript
 {
+    typedef struct Context* HContext;
+
     void InitializeImage(lua_State* L);
+
+    // Registers the script extension that delivers the results of image.load_async()
+    void InitializeImageRequests(HContext context);
+
+    // Waits for the image requests that are decoded on the job threads of the context
+    void WaitImageRequests(HContext context);
 }
 
 #endif // DM_SCRIPT_IMAGE_H
@@ -78,28 +78,18 @@ namespace dmScript
             }
             else
             {
-                char buffer[buffer_len] = { 0 };
-                memcpy(buffer, json + n.m_Start, dmMath::Min(buffer_len - 1, l));
-
-                uint32_t bytes_read = 0;
-                double value = 0.0f;
-                int result = sscanf(buffer, "%lf%n", &value, &bytes_read);
-
-#if defined(__NX__)
-                if (result == 1 && bytes_read == l+1 && value == 0)
-                {
-                    // for some reason, if the value happens to be a 0, or -0 it seems the sscanf code is stepping
-                    // one character too far. However, as long as the result is ok,
-                    // and since the last character is a \0 , we'll let it slide
-                    bytes_read--;
-                }
-#endif
-                if (result == 1 && bytes_read == dmMath::Min(buffer_len - 1, l))
+                // The primitive is always followed by a delimiter or the terminating \0 of the
+                // document, so it can be parsed in place without copying it first.
+                char* end = 0;
+                double value = strtod(json + n.m_Start, &end);
+                if (l > 0 && end == json + n.m_End)
                 {
                     lua_pushnumber(L, value);
                 }
                 else
                 {
+                    char buffer[buffer_len] = { 0 };
+                    memcpy(buffer, json + n.m_Start, dmMath::Min(buffer_len - 1, l));
                     dmSnPrintf(error_str_out, error_str_size, "Invalid JSON primitive: %s", buffer);
                     return -1;
                 }
@@ -41,25 +41,29 @@ namespace dmScript
     // Currently the bytecode is only ever built with LuaJIT which means it cannot be loaded
     // with vanilla lua runtime. The LUA_BYTECODE_ENABLE_(32/62) indicates if we can load bytecode,
     // and in reality, if linking happens against LuaJIT.
-    static void GetLuaSource(dmLuaDDF::LuaSource *source, const char **buf, uint32_t *size)
+    //
+    // Returns false if the source was stripped from the bundle and there is no bytecode this
+    // runtime can load. Loading the empty source would otherwise silently succeed.
+    static bool GetLuaSource(dmLuaDDF::LuaSource *source, const char **buf, uint32_t *size)
     {
 #if defined(LUA_BYTECODE_ENABLE_32)
         if (source->m_Bytecode.m_Count > 0)
         {
             *buf = (const char*)source->m_Bytecode.m_Data;
             *size = source->m_Bytecode.m_Count;
-            return;
+            return true;
         }
 #elif defined(LUA_BYTECODE_ENABLE_64)
         if (source->m_Bytecode64.m_Count > 0)
         {
             *buf = (const char*)source->m_Bytecode64.m_Data;
             *size = source->m_Bytecode64.m_Count;
-            return;
+            return true;
         }
 #endif
         *buf = (const char*)source->m_Script.m_Data;
         *size = source->m_Script.m_Count;
+        return *size > 0 || (source->m_Bytecode.m_Count == 0 && source->m_Bytecode64.m_Count == 0);
     }
 
     // Chunkname (the identifying part of a script/source chunk) in Lua has a maximum length,
@@ -104,7 +108,11 @@ namespace dmScript
     {
         const char *buf;
         uint32_t size;
-        GetLuaSource(source, &buf, &size);
+        if (!GetLuaSource(source, &buf, &size))
+        {
+            lua_pushfstring(L, "%s: the bundle only contains bytecode, which this Lua runtime can't load", source->m_Filename);
+            return LUA_ERRSYNTAX;
+        }
         char tmp[DMPATH_MAX_PATH];
         return luaL_loadbuffer(L, buf, size, PrefixFilename(FindSuitableChunkname(source->m_Filename), '=', tmp, sizeof(tmp)));
     }
@@ -162,14 +170,17 @@ namespace dmScript
     {
         dmhash_t module_hash = dmHashString64(script_name);
 
+        const char *buf;
+        uint32_t size;
+        if (!GetLuaSource(source, &buf, &size))
+        {
+            dmLogError("Module '%s' only contains bytecode, which this Lua runtime can't load", script_name);
+            return RESULT_LUA_ERROR;
+        }
 
         Module module;
         module.m_Name = strdup(script_name);
 
-        const char *buf;
-        uint32_t size;
-        GetLuaSource(source, &buf, &size);
-
         module.m_Script = (char*) malloc(size);
         module.m_ScriptSize = size;
         memcpy(module.m_Script, buf, size);
@@ -204,7 +215,11 @@ namespace dmScript
 
         const char *buf;
         uint32_t size;
-        GetLuaSource(source, &buf, &size);
+        if (!GetLuaSource(source, &buf, &size))
+        {
+            dmLogError("Module '%s' only contains bytecode, which this Lua runtime can't load", module->m_Name);
+            return RESULT_LUA_ERROR;
+        }
 
         module->m_Script = (char*) realloc(module->m_Script, size);
         module->m_ScriptSize = size;
@@ -195,7 +195,7 @@ namespace dmScript
         {
             if (lua_isstring(L, 3))
             {
-                url->m_Path = dmHashString64(lua_tostring(L, 3));
+                url->m_Path = HashString(L, 3);
             }
             else if (lua_isnil(L, 3))
             {
@@ -214,7 +214,7 @@ namespace dmScript
         {
             if (lua_isstring(L, 3))
             {
-                url->m_Fragment = dmHashString64(lua_tostring(L, 3));
+                url->m_Fragment = HashString(L, 3);
             }
             else if (lua_isnil(L, 3))
             {
@@ -415,7 +415,7 @@ namespace dmScript
             {
                 if (lua_isstring(L, 3))
                 {
-                    url.m_Fragment = dmHashString64(lua_tostring(L, 3));
+                    url.m_Fragment = HashString(L, 3);
                 }
                 else
                 {
@@ -490,7 +490,7 @@ namespace dmScript
         dmhash_t message_id;
         if (lua_isstring(L, 2))
         {
-            message_id = dmHashString64(lua_tostring(L, 2));
+            message_id = HashString(L, 2);
         }
         else
         {
@@ -14,6 +14,9 @@
 #define SCRIPT_PRIVATE_H
 
 #include <dlib/hashtable.h>
+#include <dlib/job.h>
+#include "script_allocator.h"
+#include "script_profiler.h"
 
 #define SCRIPT_MAIN_THREAD "__script_main_thread"
 #define SCRIPT_ERROR_HANDLER_VAR "__error_handler"
@@ -71,9 +74,29 @@ namespace dmScript
         dmHashTable64<Module>       m_Modules;
         dmHashTable64<Module*>      m_PathToModule;
         dmHashTable64<int>          m_HashInstances;
+        // Interned Lua string pointer -> hash, see HashString()
+        dmHashTable64<dmhash_t>     m_StringHashes;
         dmArray<HScriptExtension>   m_ScriptExtensions;
         lua_State*                  m_LuaState;
+        // 0 when the Lua state uses the default allocator
+        HLuaAllocator               m_LuaAllocator;
         int                         m_ContextTableRef;
+        // Table keeping the strings in m_StringHashes alive
+        int                         m_StringHashAnchorsRef;
+        // Time spent on incremental GC steps each update, in microseconds. 0 leaves the GC to Lua
+        uint32_t                    m_GCTimeBudget;
+        // Start a new GC cycle when this many bytes are used, see StepGC()
+        uint64_t                    m_GCThreshold;
+        // Used for background work, may be 0. See SetJobContext()
+        dmJob::HContext             m_JobContext;
+        // Sampling profiler, 0 unless script.profiler_sample_interval is set
+        HLuaProfiler                m_LuaProfiler;
+        // Pending image.load_async() requests, in the order they were made
+        dmArray<struct ImageRequest*> m_ImageRequests;
+        // Pending sys.save_async() requests, in the order they were made
+        dmArray<struct SaveRequest*> m_SaveRequests;
+        LuaMemoryStats              m_MemoryStats;
+        bool                        m_GCInCycle;
         bool                        m_EnableExtensions;
     };
 
@@ -0,0 +1,347 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "script_profiler.h"
+
+#include <string.h>
+
+#include <dlib/array.h>
+#include <dlib/dstrings.h>
+#include <dlib/hash.h>
+#include <dlib/math.h>
+#include <dlib/profile.h>
+
+namespace dmScript
+{
+    // VM instructions between the checks of the sample timer
+    static const int PROFILER_HOOK_COUNT = 500;
+    // Deeper frames are attributed to their caller at this depth
+    static const int PROFILER_MAX_DEPTH = 32;
+    // The tree stops growing at this size, new call paths are attributed to their caller
+    static const uint32_t PROFILER_MAX_NODES = 8192;
+    static const uint32_t PROFILER_NO_NODE = 0xffffffffu;
+
+    // A function called along a specific call path, or a line of the function
+    struct ProfilerNode
+    {
+        const char* m_Name;
+        uint32_t    m_NameHash;
+        uint32_t    m_Key;
+        uint32_t    m_Parent;
+        uint32_t    m_FirstChild;
+        uint32_t    m_NextSibling;
+        // Time attributed to the node itself since the last flush, in ticks
+        uint64_t    m_Ticks;
+        // Including the children, only valid while flushing
+        uint64_t    m_TotalTicks;
+        // The name was made before the function name was known, see BeginLuaProfilerCall()
+        bool        m_Unnamed;
+    };
+
+    struct LuaProfiler
+    {
+        lua_State*              m_LuaState;
+        // Node 0 is the root
+        dmArray<ProfilerNode>   m_Nodes;
+        // Node that the time since m_LastSample is attributed to when the call ends
+        uint32_t                m_CurrentNode;
+        uint32_t                m_CallDepth;
+        uint32_t                m_SampleInterval;
+        uint64_t                m_SampleIntervalTicks;
+        uint64_t                m_LastSample;
+        LuaProfiler*            m_PreviousActive;
+    };
+
+    // The profiler of the call that is running, the hook has no other way to find it
+    static LuaProfiler* g_ActiveProfiler = 0;
+
+    // Trees flushed in the same frame are laid out one after the other
+    static uint64_t g_FlushOffset = 0;
+    static uint32_t g_LastFlushTick = 0;
+
+    static uint32_t GetFunctionKey(const lua_Debug* ar)
+    {
+        uint32_t key = dmHashBufferNoReverse32(ar->source, (uint32_t) strlen(ar->source));
+        if (ar->what[0] == 'C' && ar->name)
+        {
+            // All C functions share the same source
+            key ^= dmHashBufferNoReverse32(ar->name, (uint32_t) strlen(ar->name));
+        }
+        return key ^ ((uint32_t) ar->linedefined * 2654435761u);
+    }
+
+    static const char* GetSourceName(const lua_Debug* ar)
+    {
+        // Skip the '@' or '=' prefix
+        const char* source = ar->source;
+        return (source[0] == '@' || source[0] == '=') ? source + 1 : ar->short_src;
+    }
+
+    // Same format as the script callbacks, see GetProfilerString()
+    static void SetFunctionName(ProfilerNode* node, const lua_Debug* ar)
+    {
+        char buffer[128];
+        if (ar->name)
+        {
+            dmSnPrintf(buffer, sizeof(buffer), "%s@%s", ar->name, GetSourceName(ar));
+        }
+        else if (ar->what[0] == 'm')
+        {
+            dmSnPrintf(buffer, sizeof(buffer), "main@%s", GetSourceName(ar));
+        }
+        else
+        {
+            dmSnPrintf(buffer, sizeof(buffer), "l(%d)@%s", ar->linedefined, GetSourceName(ar));
+        }
+        uint32_t length = (uint32_t) strlen(buffer);
+        node->m_NameHash = dmProfile::GetNameHash(buffer, length);
+        node->m_Name = dmProfile::Internalize(buffer, length, node->m_NameHash);
+        node->m_Unnamed = ar->name == 0 && ar->what[0] != 'm';
+    }
+
+    static void SetLineName(ProfilerNode* node, const lua_Debug* ar)
+    {
+        char buffer[128];
+        dmSnPrintf(buffer, sizeof(buffer), "%s:%d", GetSourceName(ar), ar->currentline);
+        uint32_t length = (uint32_t) strlen(buffer);
+        node->m_NameHash = dmProfile::GetNameHash(buffer, length);
+        node->m_Name = dmProfile::Internalize(buffer, length, node->m_NameHash);
+        node->m_Unnamed = false;
+    }
+
+    // Returns the child with the key, creating it if needed. Returns the parent when the tree is full.
+    static uint32_t GetChild(LuaProfiler* profiler, uint32_t parent, uint32_t key, bool* created)
+    {
+        dmArray<ProfilerNode>& nodes = profiler->m_Nodes;
+        *created = false;
+        for (uint32_t i = nodes[parent].m_FirstChild; i != PROFILER_NO_NODE; i = nodes[i].m_NextSibling)
+        {
+            if (nodes[i].m_Key == key)
+            {
+                return i;
+            }
+        }
+        if (nodes.Size() == PROFILER_MAX_NODES)
+        {
+            return parent;
+        }
+        if (nodes.Full())
+        {
+            nodes.OffsetCapacity(dmMath::Min(nodes.Capacity(), PROFILER_MAX_NODES - nodes.Capacity()));
+        }
+        uint32_t index = nodes.Size();
+        ProfilerNode node;
+        memset(&node, 0, sizeof(node));
+        node.m_Key = key;
+        node.m_Parent = parent;
+        node.m_FirstChild = PROFILER_NO_NODE;
+        node.m_NextSibling = nodes[parent].m_FirstChild;
+        nodes.Push(node);
+        nodes[parent].m_FirstChild = index;
+        *created = true;
+        return index;
+    }
+
+    static uint32_t GetFunctionNode(LuaProfiler* profiler, uint32_t parent, const lua_Debug* ar)
+    {
+        bool created;
+        uint32_t index = GetChild(profiler, parent, GetFunctionKey(ar), &created);
+        ProfilerNode* node = &profiler->m_Nodes[index];
+        if (index != parent && (created || (node->m_Unnamed && ar->name)))
+        {
+            SetFunctionName(node, ar);
+        }
+        return index;
+    }
+
+    // Records the call stack and attributes the time since the last sample to the running line
+    static void TakeSample(LuaProfiler* profiler, lua_State* L, uint64_t now)
+    {
+        int depth = 0;
+        lua_Debug ar;
+        while (lua_getstack(L, depth, &ar))
+        {
+            ++depth;
+        }
+
+        uint32_t node = 0;
+        int innermost = dmMath::Max(depth - PROFILER_MAX_DEPTH, 0);
+        for (int level = depth - 1; level >= innermost; --level)
+        {
+            lua_getstack(L, level, &ar);
+            lua_getinfo(L, level == 0 ? "Snl" : "Sn", &ar);
+            node = GetFunctionNode(profiler, node, &ar);
+        }
+
+        if (innermost == 0 && depth > 0 && ar.currentline > 0)
+        {
+            bool created;
+            uint32_t line = GetChild(profiler, node, (uint32_t) ar.currentline, &created);
+            if (created)
+            {
+                SetLineName(&profiler->m_Nodes[line], &ar);
+            }
+            node = line;
+        }
+
+        profiler->m_Nodes[node].m_Ticks += now - profiler->m_LastSample;
+        profiler->m_LastSample = now;
+        profiler->m_CurrentNode = node;
+    }
+
+    static void ProfilerHook(lua_State* L, lua_Debug* ar)
+    {
+        LuaProfiler* profiler = g_ActiveProfiler;
+        if (profiler == 0)
+        {
+            return;
+        }
+        uint64_t now = dmProfile::GetNowTicks();
+        if (now - profiler->m_LastSample >= profiler->m_SampleIntervalTicks)
+        {
+            TakeSample(profiler, L, now);
+        }
+    }
+
+    static void UpdateSampleInterval(LuaProfiler* profiler)
+    {
+        profiler->m_SampleIntervalTicks = profiler->m_SampleInterval * dmProfile::GetTicksPerSecond() / 1000000;
+    }
+
+    HLuaProfiler NewLuaProfiler(lua_State* L, uint32_t sample_interval)
+    {
+        LuaProfiler* profiler = new LuaProfiler;
+        profiler->m_LuaState = L;
+        profiler->m_Nodes.SetCapacity(256);
+        ProfilerNode root;
+        memset(&root, 0, sizeof(root));
+        root.m_Parent = PROFILER_NO_NODE;
+        root.m_FirstChild = PROFILER_NO_NODE;
+        root.m_NextSibling = PROFILER_NO_NODE;
+        profiler->m_Nodes.Push(root);
+        profiler->m_CurrentNode = 0;
+        profiler->m_CallDepth = 0;
+        profiler->m_SampleInterval = sample_interval;
+        profiler->m_LastSample = 0;
+        profiler->m_PreviousActive = 0;
+        UpdateSampleInterval(profiler);
+
+        // Coroutines inherit the hook when they are created
+        lua_sethook(L, ProfilerHook, LUA_MASKCOUNT, PROFILER_HOOK_COUNT);
+        return profiler;
+    }
+
+    void DeleteLuaProfiler(HLuaProfiler profiler)
+    {
+        lua_sethook(profiler->m_LuaState, 0, 0, 0);
+        if (g_ActiveProfiler == profiler)
+        {
+            g_ActiveProfiler = profiler->m_PreviousActive;
+        }
+        delete profiler;
+    }
+
+    void BeginLuaProfilerCall(HLuaProfiler profiler, lua_State* L, int nargs)
+    {
+        if (profiler == 0)
+        {
+            return;
+        }
+        if (profiler->m_CallDepth++ > 0)
+        {
+            // Nested calls are part of the stack of the outer call
+            return;
+        }
+
+        profiler->m_PreviousActive = g_ActiveProfiler;
+        g_ActiveProfiler = profiler;
+        profiler->m_LastSample = dmProfile::GetNowTicks();
+
+        // Calls shorter than the sample interval are attributed to the called function
+        profiler->m_CurrentNode = 0;
+        if (lua_isfunction(L, -(nargs + 1)))
+        {
+            lua_Debug ar;
+            lua_pushvalue(L, -(nargs + 1));
+            lua_getinfo(L, ">S", &ar); // Pops the function
+            ar.name = 0;
+            profiler->m_CurrentNode = GetFunctionNode(profiler, 0, &ar);
+        }
+    }
+
+    void EndLuaProfilerCall(HLuaProfiler profiler)
+    {
+        if (profiler == 0 || --profiler->m_CallDepth > 0)
+        {
+            return;
+        }
+        uint64_t now = dmProfile::GetNowTicks();
+        profiler->m_Nodes[profiler->m_CurrentNode].m_Ticks += now - profiler->m_LastSample;
+        profiler->m_LastSample = now;
+        g_ActiveProfiler = profiler->m_PreviousActive;
+        profiler->m_PreviousActive = 0;
+    }
+
+    static void AddSamples(LuaProfiler* profiler, uint32_t index, uint64_t start)
+    {
+        dmArray<ProfilerNode>& nodes = profiler->m_Nodes;
+        for (uint32_t i = nodes[index].m_FirstChild; i != PROFILER_NO_NODE; i = nodes[i].m_NextSibling)
+        {
+            ProfilerNode& node = nodes[i];
+            if (node.m_TotalTicks == 0)
+            {
+                continue;
+            }
+            dmProfile::AddLuaSample(node.m_Name, node.m_NameHash, start, node.m_TotalTicks);
+            AddSamples(profiler, i, start);
+            start += node.m_TotalTicks;
+        }
+    }
+
+    void FlushLuaProfiler(HLuaProfiler profiler)
+    {
+        DM_PROFILE(Script, "FlushLuaProfiler");
+
+        dmArray<ProfilerNode>& nodes = profiler->m_Nodes;
+        uint32_t node_count = nodes.Size();
+        for (uint32_t i = 0; i < node_count; ++i)
+        {
+            nodes[i].m_TotalTicks = nodes[i].m_Ticks;
+        }
+        // Children are always added after their parents
+        for (uint32_t i = node_count - 1; i > 0; --i)
+        {
+            nodes[nodes[i].m_Parent].m_TotalTicks += nodes[i].m_TotalTicks;
+        }
+
+        uint64_t total = nodes[0].m_TotalTicks;
+        if (total > 0)
+        {
+            uint32_t tick = dmProfile::GetTickSinceBegin();
+            if (tick < g_LastFlushTick)
+            {
+                // A new frame
+                g_FlushOffset = 0;
+            }
+            g_LastFlushTick = tick;
+
+            AddSamples(profiler, 0, g_FlushOffset);
+            g_FlushOffset += total;
+        }
+
+        for (uint32_t i = 0; i < node_count; ++i)
+        {
+            nodes[i].m_Ticks = 0;
+        }
+        UpdateSampleInterval(profiler);
+    }
+}
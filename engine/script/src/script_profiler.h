@@ -0,0 +1,70 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_SCRIPT_PROFILER_H
+#define DM_SCRIPT_PROFILER_H
+
+#include <stdint.h>
+
+extern "C"
+{
+#include <lua/lua.h>
+}
+
+namespace dmScript
+{
+    /**
+     * Sampling profiler of the Lua code run in a Lua state.
+     *
+     * A count hook checks the time every few hundred VM instructions. Once per sample interval the
+     * call stack is recorded into a call tree, and the time since the previous sample is attributed to
+     * the function and line that is running. The tree is added to dmProfile as nested samples in the
+     * "Lua" scope once per frame, see FlushLuaProfiler().
+     */
+    typedef struct LuaProfiler* HLuaProfiler;
+
+    /**
+     * Create a profiler and install its hook
+     * @param L Lua state
+     * @param sample_interval Time between samples in microseconds
+     * @return The profiler
+     */
+    HLuaProfiler NewLuaProfiler(lua_State* L, uint32_t sample_interval);
+
+    /**
+     * Remove the hook and delete the profiler
+     * @param profiler The profiler
+     */
+    void DeleteLuaProfiler(HLuaProfiler profiler);
+
+    /**
+     * Start measuring a call into Lua. The function must be on the stack below its arguments.
+     * @param profiler The profiler, may be 0
+     * @param L Lua state
+     * @param nargs Number of arguments
+     */
+    void BeginLuaProfilerCall(HLuaProfiler profiler, lua_State* L, int nargs);
+
+    /**
+     * Stop measuring a call started with BeginLuaProfilerCall()
+     * @param profiler The profiler, may be 0
+     */
+    void EndLuaProfilerCall(HLuaProfiler profiler);
+
+    /**
+     * Add the time measured since the last flush to the profile, and reset the times
+     * @param profiler The profiler
+     */
+    void FlushLuaProfiler(HLuaProfiler profiler);
+}
+
+#endif // DM_SCRIPT_PROFILER_H
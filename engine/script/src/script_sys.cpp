@@ -27,13 +27,17 @@
 #include <direct.h>
 #endif
 
+#include <dlib/atomic.h>
 #include <dlib/dstrings.h>
+#include <dlib/job.h>
+#include <dlib/profile.h>
 #include <dlib/sys.h>
 #include <dlib/log.h>
 #include <dlib/socket.h>
 #include <dlib/path.h>
 #include <resource/resource.h>
 #include "script.h"
+#include "script_sys.h"
 #include "script/sys_ddf.h"
 
 #include <string.h>
@@ -96,72 +100,322 @@ union SaveLoadBuffer
      * ```
      */
 
-#if !defined(__EMSCRIPTEN__)
-    int Sys_Save(lua_State* L)
+    enum SaveResult
     {
-        luaL_checktype(L, 2, LUA_TTABLE);
-        uint32_t n_used = CheckTable(L, g_saveload.m_buffer, sizeof(g_saveload.m_buffer), 2);
+        SAVE_RESULT_OK,
+        SAVE_RESULT_PATH_TOO_LONG,
+        SAVE_RESULT_OPEN_ERROR,
+        SAVE_RESULT_WRITE_ERROR,
+        SAVE_RESULT_RENAME_ERROR,
+    };
 
-        const char* filename = luaL_checkstring(L, 1);
-        char tmp_filename[DMPATH_MAX_PATH];
+    // Writes a serialized table to a file. Used by sys.save on the main thread and by sys.save_async on a job thread.
+#if !defined(__EMSCRIPTEN__)
+    static SaveResult WriteSaveFile(const char* filename, const char* data, uint32_t data_size, char* tmp_filename, uint32_t tmp_filename_size)
+    {
         // The counter and hash are there to make the files unique enough to avoid that the user
         // accidentally writes to it.
-        static int save_counter = 0;
+        static int32_atomic_t save_counter = 0;
         uint32_t hash = dmHashString32(filename);
-        int res = dmSnPrintf(tmp_filename, sizeof(tmp_filename), "%s.defoldtmp_%x_%d", filename, hash, save_counter++);
+        int res = dmSnPrintf(tmp_filename, tmp_filename_size, "%s.defoldtmp_%x_%d", filename, hash, dmAtomicIncrement32(&save_counter));
         if (res == -1)
         {
-            return luaL_error(L, "Could not write to the file %s. Path too long.", filename);
+            return SAVE_RESULT_PATH_TOO_LONG;
         }
 
         FILE* file = fopen(tmp_filename, "wb");
         if (!file)
         {
-            return luaL_error(L, "Could not open the file %s.", tmp_filename);
+            return SAVE_RESULT_OPEN_ERROR;
         }
 
-        bool result = fwrite(g_saveload.m_buffer, 1, n_used, file) == n_used;
+        bool result = fwrite(data, 1, data_size, file) == data_size;
         result = (fclose(file) == 0) && result;
 
         if (!result)
         {
             dmSys::Unlink(tmp_filename);
-            return luaL_error(L, "Could not write to the file %s.", filename);
+            return SAVE_RESULT_WRITE_ERROR;
         }
 
-        if (dmSys::RenameFile(filename, tmp_filename) == dmSys::RESULT_OK)
+        if (dmSys::RenameFile(filename, tmp_filename) != dmSys::RESULT_OK)
         {
-            lua_pushboolean(L, result);
-            return 1;
+            return SAVE_RESULT_RENAME_ERROR;
         }
-        return luaL_error(L, "Could not rename %s to the file %s.", tmp_filename, filename);
+        return SAVE_RESULT_OK;
     }
 
 #else // __EMSCRIPTEN__
 
-    int Sys_Save(lua_State* L)
+    static SaveResult WriteSaveFile(const char* filename, const char* data, uint32_t data_size, char* tmp_filename, uint32_t tmp_filename_size)
     {
-        const char* filename = luaL_checkstring(L, 1);
-        luaL_checktype(L, 2, LUA_TTABLE);
-        uint32_t n_used = CheckTable(L, g_saveload.m_buffer, sizeof(g_saveload.m_buffer), 2);
+        tmp_filename[0] = 0;
         FILE* file = fopen(filename, "wb");
         if (file != 0x0)
         {
-            bool result = fwrite(g_saveload.m_buffer, 1, n_used, file) == n_used;
+            bool result = fwrite(data, 1, data_size, file) == data_size;
             result = (fclose(file) == 0) && result;
             if (result)
             {
-                lua_pushboolean(L, result);
-                return 1;
+                return SAVE_RESULT_OK;
             }
 
             dmSys::Unlink(filename);
         }
-        return luaL_error(L, "Could not write to the file %s.", filename);
+        return SAVE_RESULT_WRITE_ERROR;
     }
 
 #endif
 
+    static void FormatSaveError(SaveResult result, const char* filename, const char* tmp_filename, char* buffer, uint32_t buffer_size)
+    {
+        switch (result)
+        {
+        case SAVE_RESULT_PATH_TOO_LONG:
+            dmSnPrintf(buffer, buffer_size, "Could not write to the file %s. Path too long.", filename);
+            break;
+        case SAVE_RESULT_OPEN_ERROR:
+            dmSnPrintf(buffer, buffer_size, "Could not open the file %s.", tmp_filename);
+            break;
+        case SAVE_RESULT_RENAME_ERROR:
+            dmSnPrintf(buffer, buffer_size, "Could not rename %s to the file %s.", tmp_filename, filename);
+            break;
+        default:
+            dmSnPrintf(buffer, buffer_size, "Could not write to the file %s.", filename);
+            break;
+        }
+    }
+
+    int Sys_Save(lua_State* L)
+    {
+        luaL_checktype(L, 2, LUA_TTABLE);
+        uint32_t n_used = CheckTable(L, g_saveload.m_buffer, sizeof(g_saveload.m_buffer), 2);
+        const char* filename = luaL_checkstring(L, 1);
+
+        // Pending sys.save_async() calls must not overwrite this file afterwards
+        WaitSaveRequests(GetScriptContext(L));
+
+        char tmp_filename[DMPATH_MAX_PATH];
+        SaveResult result = WriteSaveFile(filename, g_saveload.m_buffer, n_used, tmp_filename, sizeof(tmp_filename));
+        if (result != SAVE_RESULT_OK)
+        {
+            char error[DMPATH_MAX_PATH * 2 + 64];
+            FormatSaveError(result, filename, tmp_filename, error, sizeof(error));
+            return luaL_error(L, "%s", error);
+        }
+        lua_pushboolean(L, 1);
+        return 1;
+    }
+
+    struct SaveRequest
+    {
+        // 0 if sys.save_async() was called without a callback
+        LuaCallbackInfo*    m_Callback;
+        // Copy of the serialized table, so that the table can be changed while the file is written
+        char*               m_Data;
+        uint32_t            m_DataSize;
+        dmJob::HJob         m_Job;
+        SaveResult          m_Result;
+        char                m_Filename[DMPATH_MAX_PATH];
+        char                m_TmpFilename[DMPATH_MAX_PATH];
+    };
+
+    static void WriteSaveRequest(void* context, void* data)
+    {
+        DM_PROFILE(Script, "WriteSaveFile");
+        SaveRequest* request = (SaveRequest*) data;
+        request->m_Result = WriteSaveFile(request->m_Filename, request->m_Data, request->m_DataSize, request->m_TmpFilename, sizeof(request->m_TmpFilename));
+    }
+
+    /*# saves a lua table to a file stored on disk without blocking the game
+     * Same as <code>sys.save</code>, but the file is written on a worker thread when the engine
+     * runs with job threads. The table is serialized immediately, so it can be changed as soon as the
+     * function returns. The callback is called from the main thread in a later frame.
+     * Saves are written in the order they were made, and <code>sys.save</code> and <code>sys.load</code> wait for pending saves.
+     *
+     * @name sys.save_async
+     * @param filename [type:string] file to write to
+     * @param table [type:table] lua table to save
+     * @param [callback] [type:function(self, success, error)] optional function called when the file has been written
+     *
+     * `self`
+     * : [type:object] The current object.
+     *
+     * `success`
+     * : [type:boolean] `true` if the table was saved
+     *
+     * `error`
+     * : [type:string] The error message if the table could not be saved, otherwise `nil`
+     *
+     * @examples
+     *
+     * Save data without stalling the game:
+     *
+     * ```lua
+     * local my_file_path = sys.get_save_file("my_game", "my_file")
+     * sys.save_async(my_file_path, self.progress, function(self, success, error)
+     *     if not success then
+     *         print(error)
+     *     end
+     * end)
+     * ```
+     */
+    int Sys_SaveAsync(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        const char* filename = luaL_checkstring(L, 1);
+        luaL_checktype(L, 2, LUA_TTABLE);
+        if (strlen(filename) >= DMPATH_MAX_PATH)
+        {
+            return DM_LUA_ERROR("Could not write to the file %s. Path too long.", filename);
+        }
+        uint32_t n_used = CheckTable(L, g_saveload.m_buffer, sizeof(g_saveload.m_buffer), 2);
+
+        LuaCallbackInfo* callback = 0x0;
+        if (!lua_isnoneornil(L, 3))
+        {
+            callback = CreateCallback(L, 3);
+            if (callback == 0x0)
+            {
+                return DM_LUA_ERROR("sys.save_async can only be called with a callback from a script instance");
+            }
+        }
+
+        SaveRequest* request = new SaveRequest;
+        request->m_Callback = callback;
+        request->m_Data = (char*) malloc(n_used);
+        memcpy(request->m_Data, g_saveload.m_buffer, n_used);
+        request->m_DataSize = n_used;
+        request->m_Job = dmJob::INVALID_JOB;
+        request->m_Result = SAVE_RESULT_WRITE_ERROR;
+        dmStrlCpy(request->m_Filename, filename, sizeof(request->m_Filename));
+        request->m_TmpFilename[0] = 0;
+
+        HContext context = GetScriptContext(L);
+        dmArray<SaveRequest*>& requests = context->m_SaveRequests;
+        if (context->m_JobContext)
+        {
+            request->m_Job = dmJob::CreateJob(context->m_JobContext, WriteSaveRequest, 0, request, dmJob::INVALID_JOB);
+            if (request->m_Job != dmJob::INVALID_JOB)
+            {
+                // Write after the previous save, an older table must never replace a newer one
+                dmJob::HJob previous = requests.Empty() ? dmJob::INVALID_JOB : requests.Back()->m_Job;
+                if (previous != dmJob::INVALID_JOB && dmJob::AddDependency(context->m_JobContext, request->m_Job, previous) != dmJob::RESULT_OK)
+                {
+                    dmJob::Wait(context->m_JobContext, previous);
+                }
+                dmJob::Run(context->m_JobContext, request->m_Job);
+            }
+        }
+        if (request->m_Job == dmJob::INVALID_JOB)
+        {
+            // No job threads, write now. The callback is still called in the next update.
+            WriteSaveRequest(0, request);
+        }
+
+        if (requests.Full())
+        {
+            requests.OffsetCapacity(8);
+        }
+        requests.Push(request);
+        return 0;
+    }
+
+    static void CompleteSaveRequest(HContext context, SaveRequest* request, bool invoke_callback)
+    {
+        lua_State* L = context->m_LuaState;
+        DM_LUA_STACK_CHECK(L, 0);
+
+        char error[DMPATH_MAX_PATH * 2 + 64];
+        bool success = request->m_Result == SAVE_RESULT_OK;
+        if (!success)
+        {
+            FormatSaveError(request->m_Result, request->m_Filename, request->m_TmpFilename, error, sizeof(error));
+        }
+
+        if (invoke_callback && request->m_Callback && SetupCallback(request->m_Callback))
+        {
+            lua_pushboolean(L, success);
+            if (success) {
+                lua_pushnil(L);
+            } else {
+                lua_pushstring(L, error);
+            }
+            PCall(L, 3, 0);
+            TeardownCallback(request->m_Callback);
+        }
+        else if (!success)
+        {
+            dmLogWarning("%s", error);
+        }
+
+        if (request->m_Callback)
+        {
+            DestroyCallback(request->m_Callback);
+        }
+        free(request->m_Data);
+        delete request;
+    }
+
+    void WaitSaveRequests(HContext context)
+    {
+        dmArray<SaveRequest*>& requests = context->m_SaveRequests;
+        for (uint32_t i = 0; i < requests.Size(); ++i)
+        {
+            if (requests[i]->m_Job != dmJob::INVALID_JOB) {
+                dmJob::Wait(context->m_JobContext, requests[i]->m_Job);
+                requests[i]->m_Job = dmJob::INVALID_JOB;
+            }
+        }
+    }
+
+    static void SaveRequestsUpdate(HContext context)
+    {
+        dmArray<SaveRequest*>& requests = context->m_SaveRequests;
+        if (requests.Empty()) {
+            return;
+        }
+
+        DM_PROFILE(Script, "SaveRequests");
+        // Callbacks are called in the order the saves were made, unfinished requests are kept
+        uint32_t pending = 0;
+        for (uint32_t i = 0; i < requests.Size(); ++i)
+        {
+            SaveRequest* request = requests[i];
+            if (pending > 0 || (request->m_Job != dmJob::INVALID_JOB && !dmJob::IsFinished(context->m_JobContext, request->m_Job))) {
+                requests[pending++] = request;
+                continue;
+            }
+            CompleteSaveRequest(context, request, true);
+        }
+        requests.SetSize(pending);
+    }
+
+    static void SaveRequestsFinalize(HContext context)
+    {
+        WaitSaveRequests(context);
+        dmArray<SaveRequest*>& requests = context->m_SaveRequests;
+        for (uint32_t i = 0; i < requests.Size(); ++i)
+        {
+            CompleteSaveRequest(context, requests[i], false);
+        }
+        requests.SetSize(0);
+    }
+
+    void InitializeSaveRequests(HContext context)
+    {
+        static ScriptExtension sl;
+        sl.Initialize = 0x0;
+        sl.Update = SaveRequestsUpdate;
+        sl.Finalize = SaveRequestsFinalize;
+        sl.NewScriptWorld = 0x0;
+        sl.DeleteScriptWorld = 0x0;
+        sl.UpdateScriptWorld = 0x0;
+        sl.InitializeScriptInstance = 0x0;
+        sl.FinalizeScriptInstance = 0x0;
+        RegisterScriptExtension(context, &sl);
+    }
+
     /*# loads a lua table from a file on disk
      * If the file exists, it must have been created by <code>sys.save</code> to be loaded.
      *
@@ -183,6 +437,8 @@ union SaveLoadBuffer
     int Sys_Load(lua_State* L)
     {
         const char* filename = luaL_checkstring(L, 1);
+        // The file may still be written by sys.save_async()
+        WaitSaveRequests(GetScriptContext(L));
         FILE* file = fopen(filename, "rb");
         if (file == 0x0)
         {
@@ -1133,6 +1389,7 @@ union SaveLoadBuffer
     static const luaL_reg ScriptSys_methods[] =
     {
         {"save", Sys_Save},
+        {"save_async", Sys_SaveAsync},
         {"load", Sys_Load},
         {"get_save_file", Sys_GetSaveFile},
         {"get_config", Sys_GetConfig},
@@ -20,7 +20,15 @@ extern "C"
 
 namespace dmScript
 {
+    typedef struct Context* HContext;
+
     void InitializeSys(lua_State* L);
+
+    // Registers the script extension that delivers the results of sys.save_async()
+    void InitializeSaveRequests(HContext context);
+
+    // Waits for the save requests that are written on the job threads of the context
+    void WaitSaveRequests(HContext context);
 }
 
 #endif // DM_SCRIPT_SYS_H
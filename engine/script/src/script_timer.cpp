@@ -37,20 +37,18 @@ namespace dmScript
      */
 
     /*
-        The timers are stored in a flat array with no holes which we scan sequenctially on each update.
+        The timers are stored in a pool of slots that never move, a freed slot is reused by the next timer.
 
-        When a timer is removed the last timer in the list may change location (EraseSwap).
+        The timers that are scheduled to fire are kept in a binary min-heap of slot indices, ordered by the
+        world time at which they expire. An update only pops the timers that expire during that update, so
+        the cost of an update scales with the number of triggered timers rather than the number of live timers.
+        Timers with the same expiry fire in the order they were scheduled.
 
-        This is to keep the array sweep fast and handle cases where multiple short lived timers are
-        created followed by one long-lived timer. If we did not re-shuffle and keep holes we would keep
-        scanning the array to the end where the only live timer exists skipping all the holes.
-        How much of an issue this is guesswork at this point.
-
-        The timer identity is an index into an indirection layer combined with a generation counter,
-        this makes it possible to reuse the index for the indirection layer without risk of using
-        stale indexes - the caller to CancelTimer is allowed to call with an handle of a timer that already
-        has expired.
+        The timer identity is a slot index combined with a generation counter that is incremented each time the
+        slot is reused, this makes it possible to reuse slots without risk of using stale handles - the caller
+        to CancelTimer is allowed to call with an handle of a timer that already has expired.
 
+        The timers of each owner are linked together so that KillTimers only visits the timers of that owner.
         Each script instance needs to call KillTimers for its owner to clean up potential timers
         that has not yet been cancelled or completed (one-shot).
     */
@@ -67,116 +65,288 @@ namespace dmScript
         // Store complete timer handle with generation here to identify stale timer handles
         HTimer          m_Handle;
 
-        // How much time remaining until the timer fires
-        float           m_Remaining;
+        // The world time when the timer fires
+        double          m_Expiry;
 
         // The timer delay, we need to keep this for repeating timers
         float           m_Delay;
 
+        // Incremented each time a timer is scheduled, used to order timers with the same expiry
+        uint32_t        m_Sequence;
+
+        // Position in the expiry heap, INVALID_TIMER_INDEX if the timer is not scheduled
+        uint32_t        m_HeapIndex;
+
+        // Siblings in the list of timers with the same owner
+        uint32_t        m_PrevOwnerTimer;
+        uint32_t        m_NextOwnerTimer;
+
         // Flag if the timer should repeat
         uint32_t        m_Repeat : 1;
         // Flag if the timer is alive
         uint32_t        m_IsAlive : 1;
     };
 
-    #define INVALID_TIMER_LOOKUP_INDEX  0xffffu
+    #define INVALID_TIMER_INDEX         0xffffffffu
+    #define TIMER_INDEX_BITS            20u
+    #define TIMER_INDEX_MASK            ((1u << TIMER_INDEX_BITS) - 1u)
+    #define TIMER_GENERATION_MASK       (0xffffffffu >> TIMER_INDEX_BITS)
     #define INITIAL_TIMER_CAPACITY      8u
-    #define MAX_TIMER_CAPACITY          65000u  // Needs to be less that 65535 since 65535 is reserved for invalid index
+    #define MAX_TIMER_CAPACITY          TIMER_INDEX_MASK  // The highest index is never used, so that a handle can't be INVALID_TIMER_HANDLE
     #define TIMER_CAPACITY_GROWTH       16u
+    #define OWNER_TABLE_SIZE            256u
 
     struct TimerWorld
     {
         dmArray<Timer>                      m_Timers;
-        dmArray<uint16_t>                   m_IndexLookup;
-        dmIndexPool<uint16_t>               m_IndexPool;
-        uint16_t                            m_Version;   // Incremented to avoid collisions each time we push timer indexes back to the m_IndexPool
+        dmIndexPool32                       m_IndexPool;
+        dmArray<uint32_t>                   m_Heap;
+        dmArray<HTimer>                     m_Triggered;
+        dmHashTable64<uint32_t>             m_OwnerTimers;  // The first timer of each owner
+        double                              m_Time;
+        uint32_t                            m_Sequence;
+        uint32_t                            m_AliveCount;
         uint16_t                            m_InUpdate : 1;
     };
 
-    static uint16_t GetLookupIndex(HTimer handle)
+    static uint32_t GetTimerIndex(HTimer handle)
     {
-        return (uint16_t)(handle & 0xffffu);
+        return handle & TIMER_INDEX_MASK;
     }
 
-    static HTimer MakeHandle(uint16_t generation, uint16_t lookup_index)
+    static HTimer MakeHandle(uint32_t generation, uint32_t timer_index)
     {
-        return (((uint32_t)generation) << 16) | (lookup_index);
+        return ((generation & TIMER_GENERATION_MASK) << TIMER_INDEX_BITS) | timer_index;
     }
 
-    static Timer* AllocateTimer(HTimerWorld timer_world, uintptr_t owner)
+    static Timer* GetAliveTimer(HTimerWorld timer_world, HTimer handle)
     {
-        assert(timer_world != 0x0);
-        uint32_t timer_count = timer_world->m_Timers.Size();
-        if (timer_count == MAX_TIMER_CAPACITY)
+        uint32_t timer_index = GetTimerIndex(handle);
+        if (timer_index >= timer_world->m_Timers.Size())
         {
-            dmLogError("Timer could not be stored since the timer buffer is full (%d).", MAX_TIMER_CAPACITY);
             return 0x0;
         }
 
-        if (timer_world->m_IndexPool.Remaining() == 0)
+        Timer* timer = &timer_world->m_Timers[timer_index];
+        if (timer->m_Handle != handle || timer->m_IsAlive == 0)
         {
-            uint32_t old_capacity = timer_world->m_IndexPool.Capacity();
-            uint32_t capacity = dmMath::Min(old_capacity + TIMER_CAPACITY_GROWTH, MAX_TIMER_CAPACITY);
-            timer_world->m_IndexPool.SetCapacity(capacity);
-            timer_world->m_IndexLookup.SetCapacity(capacity);
-            timer_world->m_IndexLookup.SetSize(capacity);
-            memset(&timer_world->m_IndexLookup[old_capacity], 0u, (capacity - old_capacity) * sizeof(uint16_t));
+            return 0x0;
+        }
+        return timer;
+    }
+
+    static bool FiresBefore(const Timer& a, const Timer& b)
+    {
+        if (a.m_Expiry != b.m_Expiry)
+        {
+            return a.m_Expiry < b.m_Expiry;
         }
+        return (int32_t)(a.m_Sequence - b.m_Sequence) < 0;
+    }
 
-        HTimer handle = MakeHandle(timer_world->m_Version, timer_world->m_IndexPool.Pop());
+    static void SetHeapEntry(HTimerWorld timer_world, uint32_t heap_index, uint32_t timer_index)
+    {
+        timer_world->m_Heap[heap_index] = timer_index;
+        timer_world->m_Timers[timer_index].m_HeapIndex = heap_index;
+    }
 
-        if (timer_world->m_Timers.Full())
+    static void SiftUp(HTimerWorld timer_world, uint32_t heap_index)
+    {
+        dmArray<uint32_t>& heap = timer_world->m_Heap;
+        uint32_t timer_index = heap[heap_index];
+        const Timer& timer = timer_world->m_Timers[timer_index];
+        while (heap_index > 0)
         {
-            uint32_t capacity = timer_world->m_Timers.Capacity();
-            capacity = dmMath::Min(capacity + TIMER_CAPACITY_GROWTH, MAX_TIMER_CAPACITY);
-            timer_world->m_Timers.SetCapacity(capacity);
+            uint32_t parent = (heap_index - 1) / 2;
+            if (!FiresBefore(timer, timer_world->m_Timers[heap[parent]]))
+            {
+                break;
+            }
+            SetHeapEntry(timer_world, heap_index, heap[parent]);
+            heap_index = parent;
         }
+        SetHeapEntry(timer_world, heap_index, timer_index);
+    }
 
-        timer_world->m_Timers.SetSize(timer_count + 1);
-        Timer& timer = timer_world->m_Timers[timer_count];
-        timer.m_Handle = handle;
-        timer.m_Owner = owner;
+    static void SiftDown(HTimerWorld timer_world, uint32_t heap_index)
+    {
+        dmArray<uint32_t>& heap = timer_world->m_Heap;
+        uint32_t size = heap.Size();
+        uint32_t timer_index = heap[heap_index];
+        const Timer& timer = timer_world->m_Timers[timer_index];
+        while (true)
+        {
+            uint32_t child = heap_index * 2 + 1;
+            if (child >= size)
+            {
+                break;
+            }
+            if (child + 1 < size && FiresBefore(timer_world->m_Timers[heap[child + 1]], timer_world->m_Timers[heap[child]]))
+            {
+                ++child;
+            }
+            if (!FiresBefore(timer_world->m_Timers[heap[child]], timer))
+            {
+                break;
+            }
+            SetHeapEntry(timer_world, heap_index, heap[child]);
+            heap_index = child;
+        }
+        SetHeapEntry(timer_world, heap_index, timer_index);
+    }
 
-        uint16_t lookup_index = GetLookupIndex(handle);
+    static void ScheduleTimer(HTimerWorld timer_world, uint32_t timer_index, double expiry)
+    {
+        Timer& timer = timer_world->m_Timers[timer_index];
+        timer.m_Expiry = expiry;
+        timer.m_Sequence = timer_world->m_Sequence++;
 
-        timer_world->m_IndexLookup[lookup_index] = timer_count;
-        return &timer;
+        dmArray<uint32_t>& heap = timer_world->m_Heap;
+        if (heap.Full())
+        {
+            heap.OffsetCapacity(dmMath::Max(TIMER_CAPACITY_GROWTH, heap.Capacity() / 2));
+        }
+        heap.Push(timer_index);
+        SiftUp(timer_world, heap.Size() - 1);
+    }
+
+    static void UnscheduleTimer(HTimerWorld timer_world, uint32_t timer_index)
+    {
+        Timer& timer = timer_world->m_Timers[timer_index];
+        uint32_t heap_index = timer.m_HeapIndex;
+        if (heap_index == INVALID_TIMER_INDEX)
+        {
+            return;
+        }
+        timer.m_HeapIndex = INVALID_TIMER_INDEX;
+
+        dmArray<uint32_t>& heap = timer_world->m_Heap;
+        uint32_t last_index = heap.Size() - 1;
+        uint32_t last = heap[last_index];
+        heap.Pop();
+        if (heap_index == last_index)
+        {
+            return;
+        }
+
+        // Move the last entry into the hole and restore the heap order in whichever direction it is broken
+        SetHeapEntry(timer_world, heap_index, last);
+        if (heap_index > 0 && FiresBefore(timer_world->m_Timers[last], timer_world->m_Timers[heap[(heap_index - 1) / 2]]))
+        {
+            SiftUp(timer_world, heap_index);
+        }
+        else
+        {
+            SiftDown(timer_world, heap_index);
+        }
+    }
+
+    static void LinkOwnerTimer(HTimerWorld timer_world, uint32_t timer_index)
+    {
+        Timer& timer = timer_world->m_Timers[timer_index];
+        timer.m_PrevOwnerTimer = INVALID_TIMER_INDEX;
+        timer.m_NextOwnerTimer = INVALID_TIMER_INDEX;
+
+        uint32_t* first = timer_world->m_OwnerTimers.Get(timer.m_Owner);
+        if (first != 0x0)
+        {
+            timer.m_NextOwnerTimer = *first;
+            timer_world->m_Timers[*first].m_PrevOwnerTimer = timer_index;
+            *first = timer_index;
+            return;
+        }
+
+        if (timer_world->m_OwnerTimers.Full())
+        {
+            uint32_t capacity = timer_world->m_OwnerTimers.Capacity();
+            timer_world->m_OwnerTimers.SetCapacity(OWNER_TABLE_SIZE, capacity + dmMath::Max(TIMER_CAPACITY_GROWTH, capacity / 2));
+        }
+        timer_world->m_OwnerTimers.Put(timer.m_Owner, timer_index);
+    }
+
+    static void UnlinkOwnerTimer(HTimerWorld timer_world, uint32_t timer_index)
+    {
+        Timer& timer = timer_world->m_Timers[timer_index];
+        if (timer.m_NextOwnerTimer != INVALID_TIMER_INDEX)
+        {
+            timer_world->m_Timers[timer.m_NextOwnerTimer].m_PrevOwnerTimer = timer.m_PrevOwnerTimer;
+        }
+
+        if (timer.m_PrevOwnerTimer != INVALID_TIMER_INDEX)
+        {
+            timer_world->m_Timers[timer.m_PrevOwnerTimer].m_NextOwnerTimer = timer.m_NextOwnerTimer;
+        }
+        else if (timer.m_NextOwnerTimer != INVALID_TIMER_INDEX)
+        {
+            *timer_world->m_OwnerTimers.Get(timer.m_Owner) = timer.m_NextOwnerTimer;
+        }
+        else
+        {
+            timer_world->m_OwnerTimers.Erase(timer.m_Owner);
+        }
     }
 
-    static void EraseTimer(HTimerWorld timer_world, uint32_t timer_index)
+    static Timer* AllocateTimer(HTimerWorld timer_world, uintptr_t owner)
     {
         assert(timer_world != 0x0);
 
-        Timer& movedTimer = timer_world->m_Timers.EraseSwap(timer_index);
+        if (timer_world->m_IndexPool.Remaining() == 0)
+        {
+            uint32_t old_capacity = timer_world->m_IndexPool.Capacity();
+            if (old_capacity == MAX_TIMER_CAPACITY)
+            {
+                dmLogError("Timer could not be stored since the timer buffer is full (%d).", MAX_TIMER_CAPACITY);
+                return 0x0;
+            }
+            uint32_t capacity = dmMath::Min(old_capacity + dmMath::Max(TIMER_CAPACITY_GROWTH, old_capacity / 2), MAX_TIMER_CAPACITY);
+            timer_world->m_IndexPool.SetCapacity(capacity);
+            timer_world->m_Timers.SetCapacity(capacity);
+        }
 
+        uint32_t timer_index = timer_world->m_IndexPool.Pop();
+        uint32_t generation = 0;
         if (timer_index < timer_world->m_Timers.Size())
         {
-            uint16_t moved_lookup_index = GetLookupIndex(movedTimer.m_Handle);
-            timer_world->m_IndexLookup[moved_lookup_index] = timer_index;
+            generation = (timer_world->m_Timers[timer_index].m_Handle >> TIMER_INDEX_BITS) + 1;
+        }
+        else
+        {
+            timer_world->m_Timers.SetSize(timer_index + 1);
         }
+
+        Timer& timer = timer_world->m_Timers[timer_index];
+        timer.m_Handle = MakeHandle(generation, timer_index);
+        timer.m_Owner = owner;
+        timer.m_HeapIndex = INVALID_TIMER_INDEX;
+        LinkOwnerTimer(timer_world, timer_index);
+        ++timer_world->m_AliveCount;
+        return &timer;
     }
 
+    // Kills the timer and returns the slot to the pool, the slot may be reused by the next AddTimer
     static void FreeTimer(HTimerWorld timer_world, Timer& timer)
     {
         assert(timer_world != 0x0);
-        assert(timer.m_IsAlive == 0);
-
-        uint16_t lookup_index = GetLookupIndex(timer.m_Handle);
-        uint16_t timer_index = timer_world->m_IndexLookup[lookup_index];
-        timer_world->m_IndexPool.Push(lookup_index);
+        assert(timer.m_IsAlive == 1);
 
-        EraseTimer(timer_world, timer_index);
+        uint32_t timer_index = GetTimerIndex(timer.m_Handle);
+        timer.m_IsAlive = 0;
+        --timer_world->m_AliveCount;
+        UnscheduleTimer(timer_world, timer_index);
+        UnlinkOwnerTimer(timer_world, timer_index);
+        timer_world->m_IndexPool.Push(timer_index);
     }
 
     HTimerWorld NewTimerWorld()
     {
         TimerWorld* timer_world = new TimerWorld();
         timer_world->m_Timers.SetCapacity(INITIAL_TIMER_CAPACITY);
-        timer_world->m_IndexLookup.SetCapacity(INITIAL_TIMER_CAPACITY);
-        timer_world->m_IndexLookup.SetSize(INITIAL_TIMER_CAPACITY);
-        memset(&timer_world->m_IndexLookup[0], 0u, INITIAL_TIMER_CAPACITY * sizeof(uint16_t));
         timer_world->m_IndexPool.SetCapacity(INITIAL_TIMER_CAPACITY);
-        timer_world->m_Version = 0;
+        timer_world->m_Heap.SetCapacity(INITIAL_TIMER_CAPACITY);
+        timer_world->m_OwnerTimers.SetCapacity(OWNER_TABLE_SIZE, INITIAL_TIMER_CAPACITY);
+        timer_world->m_Time = 0.0;
+        timer_world->m_Sequence = 0;
+        timer_world->m_AliveCount = 0;
         timer_world->m_InUpdate = 0;
         return timer_world;
     }
@@ -193,81 +363,79 @@ namespace dmScript
         DM_PROFILE(TimerWorld, "Update");
 
         timer_world->m_InUpdate = 1;
+        timer_world->m_Time += dt;
+        const double time = timer_world->m_Time;
 
-        // We only scan timers for trigger if the timer *existed at entry to UpdateTimers*, any timers added
-        // in a trigger callback will always be added at the end of m_Timers and not triggered in this scope.
-        uint32_t size = timer_world->m_Timers.Size();
-        DM_COUNTER("timerc", size);
+        DM_COUNTER("timerc", timer_world->m_AliveCount);
 
-        for (uint32_t i = 0; i < size; ++i)
+        // We only trigger timers that are *due at entry to UpdateTimers*, so we collect them before calling
+        // any callbacks. Timers added or rescheduled in a trigger callback are not triggered in this scope.
+        dmArray<uint32_t>& heap = timer_world->m_Heap;
+        dmArray<HTimer>& triggered = timer_world->m_Triggered;
+        triggered.SetSize(0);
+        while (heap.Size() > 0)
         {
-            Timer* timer = &timer_world->m_Timers[i];
-            if (timer->m_IsAlive == 0)
+            uint32_t timer_index = heap[0];
+            Timer& timer = timer_world->m_Timers[timer_index];
+            if (timer.m_Expiry > time)
             {
-                continue;
+                break;
             }
+            UnscheduleTimer(timer_world, timer_index);
+            if (triggered.Full())
+            {
+                triggered.OffsetCapacity(dmMath::Max(TIMER_CAPACITY_GROWTH, triggered.Capacity() / 2));
+            }
+            triggered.Push(timer.m_Handle);
+        }
 
-            timer->m_Remaining -= dt;
-            if (timer->m_Remaining > 0.0f)
+        uint32_t size = triggered.Size();
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            HTimer handle = triggered[i];
+
+            // The timer might have been cancelled or killed by an earlier callback
+            Timer* timer = GetAliveTimer(timer_world, handle);
+            if (timer == 0x0)
             {
                 continue;
             }
 
-            float elapsed_time = timer->m_Delay - timer->m_Remaining;
+            float elapsed_time = (float)(time - (timer->m_Expiry - timer->m_Delay));
 
             TimerEventType eventType = timer->m_Repeat == 0 ? TIMER_EVENT_TRIGGER_WILL_DIE : TIMER_EVENT_TRIGGER_WILL_REPEAT;
 
-            timer->m_Callback(timer_world, eventType, timer->m_Handle, elapsed_time, timer->m_Owner, timer->m_UserData);
+            timer->m_Callback(timer_world, eventType, handle, elapsed_time, timer->m_Owner, timer->m_UserData);
 
-            // The array might have been reallocated here! So grab the pointer again...
-            timer = &timer_world->m_Timers[i];
-
-            if (timer->m_IsAlive == 0)
+            // The array might have been reallocated and the timer freed here! So grab the pointer again...
+            timer = GetAliveTimer(timer_world, handle);
+            if (timer == 0x0)
             {
                 continue;
             }
 
             if (timer->m_Repeat == 0)
             {
-                timer->m_IsAlive = 0;
+                FreeTimer(timer_world, *timer);
                 continue;
             }
 
+            uint32_t timer_index = GetTimerIndex(handle);
             if (timer->m_Delay == 0.0f)
             {
-                timer->m_Remaining = 0.0f;
+                ScheduleTimer(timer_world, timer_index, time);
                 continue;
             }
 
-            float wrapped_count = ((-timer->m_Remaining) / timer->m_Delay) + 1.f;
-            float offset_to_next_trigger  = floor(wrapped_count) * timer->m_Delay;
-            timer->m_Remaining += offset_to_next_trigger;
-            assert(timer->m_Remaining >= 0.f);
+            double overdue = time - timer->m_Expiry;
+            double wrapped_count = (overdue / timer->m_Delay) + 1.0;
+            double expiry = timer->m_Expiry + floor(wrapped_count) * timer->m_Delay;
+            assert(expiry >= time);
+            ScheduleTimer(timer_world, timer_index, expiry);
         }
 
+        triggered.SetSize(0);
         timer_world->m_InUpdate = 0;
-
-        size = timer_world->m_Timers.Size();
-        uint32_t original_size = size;
-        uint32_t i = 0;
-        while (i < size)
-        {
-            Timer& timer = timer_world->m_Timers[i];
-            if (timer.m_IsAlive == 0)
-            {
-                FreeTimer(timer_world, timer);
-                --size;
-            }
-            else
-            {
-                ++i;
-            }
-        }
-
-        if (size != original_size)
-        {
-            ++timer_world->m_Version;
-        }
     }
 
     HTimer AddTimer(HTimerWorld timer_world,
@@ -287,49 +455,31 @@ namespace dmScript
         }
 
         timer->m_Delay = delay;
-        timer->m_Remaining = delay;
         timer->m_UserData = userdata;
         timer->m_Callback = timer_callback;
         timer->m_Repeat = repeat;
         timer->m_IsAlive = 1;
 
-        return timer->m_Handle;
+        HTimer handle = timer->m_Handle;
+        ScheduleTimer(timer_world, GetTimerIndex(handle), timer_world->m_Time + delay);
+        return handle;
     }
 
     bool CancelTimer(HTimerWorld timer_world, HTimer handle)
     {
         assert(timer_world != 0x0);
-        uint16_t lookup_index = GetLookupIndex(handle);
-        if (lookup_index >= timer_world->m_IndexLookup.Size())
-        {
-            return false;
-        }
-
-        uint16_t timer_index = timer_world->m_IndexLookup[lookup_index];
-        if (timer_index >= timer_world->m_Timers.Size())
-        {
-            return false;
-        }
-
-        Timer& timer = timer_world->m_Timers[timer_index];
-        if (timer.m_Handle != handle)
-        {
-            return false;
-        }
-
-        if (timer.m_IsAlive == 0)
+        Timer* timer = GetAliveTimer(timer_world, handle);
+        if (timer == 0x0)
         {
             return false;
         }
 
-        timer.m_IsAlive = 0;
-        timer.m_Callback(timer_world, TIMER_EVENT_CANCELLED, timer.m_Handle, 0.f, timer.m_Owner, timer.m_UserData);
+        TimerCallback callback = timer->m_Callback;
+        uintptr_t owner = timer->m_Owner;
+        uintptr_t userdata = timer->m_UserData;
+        FreeTimer(timer_world, *timer);
 
-        if (timer_world->m_InUpdate == 0)
-        {
-            FreeTimer(timer_world, timer);
-            ++timer_world->m_Version;
-        }
+        callback(timer_world, TIMER_EVENT_CANCELLED, handle, 0.f, owner, userdata);
         return true;
     }
 
@@ -337,60 +487,28 @@ namespace dmScript
     {
         assert(timer_world != 0x0);
 
-        uint32_t size = timer_world->m_Timers.Size();
-        uint32_t cancelled_count = 0;
-        uint32_t timer_index = 0;
-        while (timer_index < size)
+        uint32_t* first = timer_world->m_OwnerTimers.Get(owner);
+        if (first == 0x0)
         {
-            Timer& timer = timer_world->m_Timers[timer_index];
-            if (timer.m_Owner != owner)
-            {
-                ++timer_index;
-                continue;
-            }
-
-            if (timer.m_IsAlive == 1)
-            {
-                timer.m_IsAlive = 0;
-                ++cancelled_count;
-            }
-
-            if (timer_world->m_InUpdate == 0)
-            {
-                FreeTimer(timer_world, timer);
-                --size;
-            }
-            else
-            {
-                ++timer_index;
-            }
+            return 0;
         }
 
-        if (cancelled_count > 0)
+        uint32_t killed_count = 0;
+        uint32_t timer_index = *first;
+        while (timer_index != INVALID_TIMER_INDEX)
         {
-            ++timer_world->m_Version;
+            Timer& timer = timer_world->m_Timers[timer_index];
+            timer_index = timer.m_NextOwnerTimer;
+            FreeTimer(timer_world, timer);
+            ++killed_count;
         }
-
-        return cancelled_count;
+        return killed_count;
     }
 
     uint32_t GetAliveTimers(HTimerWorld timer_world)
     {
         assert(timer_world != 0x0);
-
-        uint32_t alive_timers = 0u;
-        uint32_t size = timer_world->m_Timers.Size();
-        uint32_t i = 0;
-        while (i < size)
-        {
-            Timer& timer = timer_world->m_Timers[i];
-            if(timer.m_IsAlive == 1)
-            {
-                ++alive_timers;
-            }
-            ++i;
-        }
-        return alive_timers;
+        return timer_world->m_AliveCount;
     }
 
     static void SetTimerWorld(HScriptWorld script_world, HTimerWorld timer_world)
@@ -603,7 +721,7 @@ namespace dmScript
     static int TimerCancel(lua_State* L)
     {
         int top = lua_gettop(L);
-        const int handle = luaL_checkint(L, 1);
+        const dmScript::HTimer handle = (dmScript::HTimer)luaL_checknumber(L, 1);
 
         dmScript::HTimerWorld timer_world = GetTimerWorld(L);
         if (timer_world == 0x0)
@@ -612,7 +730,7 @@ namespace dmScript
             return 1;
         }
 
-        bool cancelled = dmScript::CancelTimer(timer_world, (dmScript::HTimer)handle);
+        bool cancelled = dmScript::CancelTimer(timer_world, handle);
         lua_pushboolean(L, cancelled ? 1 : 0);
         assert(top + 1 == lua_gettop(L));
         return 1;
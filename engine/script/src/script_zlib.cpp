@@ -15,9 +15,7 @@
 #include <stdint.h>
 #include <string.h>
 
-#include <dlib/array.h>
 #include <dlib/zlib.h>
-#include <dlib/math.h>
 #include "script.h"
 
 extern "C"
@@ -41,15 +39,11 @@ namespace dmScript
      * @namespace zlib
      */
 
+    // Output is streamed straight into a Lua string buffer, so it is never copied into an intermediate array
     static bool Writer(void* context, const void* buffer, uint32_t buffer_size)
     {
-        dmArray<uint8_t>* out = (dmArray<uint8_t>*) context;
-        if (out->Remaining() < buffer_size) {
-            int r = out->Remaining();
-            int offset = dmMath::Max((int) buffer_size - r, 32 * 1024);
-            out->OffsetCapacity(offset);
-        }
-        out->PushArray((const uint8_t*) buffer, buffer_size);
+        luaL_Buffer* out = (luaL_Buffer*) context;
+        luaL_addlstring(out, (const char*) buffer, buffer_size);
         return true;
     }
 
@@ -69,19 +63,19 @@ namespace dmScript
      */
     int Zlib_Inflate(lua_State* L)
     {
-        dmArray<uint8_t> out;
-        out.SetCapacity(32 * 1024);
         const char* in = luaL_checkstring(L, 1);
         int in_len = lua_strlen(L, 1);
+        luaL_Buffer out;
+        luaL_buffinit(L, &out);
         dmZlib::Result r = dmZlib::InflateBuffer(in, in_len, &out, Writer);
+        luaL_pushresult(&out);
         if (r == dmZlib::RESULT_OK)
         {
-            lua_pushlstring(L, (const char*) out.Begin(), out.Size());
             return 1;
         }
         else
         {
-            out.SetCapacity(0); // Required as the destructor isn't run
+            lua_pop(L, 1);
             luaL_error(L, "Failed to inflate buffer (%d)", r);
             return 0;
         }
@@ -110,18 +104,19 @@ namespace dmScript
      */
     int Zlib_Deflate(lua_State* L)
     {
-        dmArray<uint8_t> out;
-        out.SetCapacity(32 * 1024);
         const char* in = luaL_checkstring(L, 1);
         int in_len = lua_strlen(L, 1);
+        luaL_Buffer out;
+        luaL_buffinit(L, &out);
         dmZlib::Result r = dmZlib::DeflateBuffer(in, in_len, 3, &out, Writer);
+        luaL_pushresult(&out);
         if (r == dmZlib::RESULT_OK)
         {
-            lua_pushlstring(L, (const char*) out.Begin(), out.Size());
             return 1;
         }
         else
         {
+            lua_pop(L, 1);
             luaL_error(L, "Failed to deflate buffer (%d)", r);
             return 0;
         }
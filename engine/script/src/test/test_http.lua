@@ -13,7 +13,7 @@
 function callback(response)
 end
 
-requests_left = 7
+requests_left = 8
 
 function test_http()
     local headers = {}
@@ -77,6 +77,22 @@ function test_http()
         end,
     headers)
 
+    local download_path = "test_http_download.tmp"
+    os.remove(download_path)
+    http.request("http://127.0.0.1:" .. PORT, "GET",
+        function(response)
+            assert(response.status == 200)
+            assert(response.path == download_path)
+            assert(response.response == nil)
+            assert(response.error == nil)
+            local f = io.open(download_path, "rb")
+            assert(f:read("*a") == "Hello Defold!")
+            f:close()
+            os.remove(download_path)
+            requests_left = requests_left - 1
+        end,
+    headers, nil, { path = download_path })
+
     http.request("http://foo.___", "GET",
         function(response)
             assert(response.status == 0)
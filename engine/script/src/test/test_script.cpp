@@ -14,11 +14,14 @@
 #include <jc_test/jc_test.h>
 
 #include "script.h"
+#include "script_allocator.h"
 
 #include <dlib/dstrings.h>
 #include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/configfile.h>
+#include <dlib/math.h>
+#include <dlib/profile.h>
 
 #include <string.h>
 
@@ -994,6 +997,134 @@ TEST_F(ScriptTest, InstanceId)
 }
 
 
+TEST_F(ScriptTest, MemoryStats)
+{
+    ASSERT_TRUE(RunString(L, "local t = {} for i=1,1000 do t[i] = {i} end _G.memory_stats_tables = t"));
+    dmScript::Update(m_Context);
+
+    dmScript::LuaMemoryStats stats;
+    dmScript::GetLuaMemoryStats(m_Context, &stats);
+    ASSERT_LE((uint64_t) dmScript::GetLuaGCCount(L) * 1024, stats.m_LiveBytes);
+    ASSERT_GT((uint64_t) (dmScript::GetLuaGCCount(L) + 1) * 1024, stats.m_LiveBytes);
+    ASSERT_EQ(0u, stats.m_GCTime);
+
+    ASSERT_TRUE(RunString(L, "_G.memory_stats_tables = nil"));
+}
+
+TEST(dmScriptAllocator, Alloc)
+{
+    dmScript::HLuaAllocator allocator = dmScript::NewLuaAllocator();
+
+    // Grow a block through the small size classes into a large block, and back
+    const size_t sizes[] = {1, 8, 16, 17, 100, 256, 257, 4096, 300, 40, 0};
+    uint8_t* p = 0;
+    size_t size = 0;
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        size_t new_size = sizes[i];
+        p = (uint8_t*) dmScript::LuaAlloc(allocator, p, size, new_size);
+        for (size_t j = 0; j < dmMath::Min(size, new_size); ++j)
+            ASSERT_EQ((uint8_t) j, p[j]);
+        for (size_t j = 0; j < new_size; ++j)
+            p[j] = (uint8_t) j;
+        size = new_size;
+        ASSERT_EQ((uint64_t) size, dmScript::GetLiveBytes(allocator));
+    }
+    ASSERT_EQ((void*) 0, (void*) p);
+    ASSERT_EQ(10u, dmScript::ResetAllocationCount(allocator));
+    ASSERT_EQ(0u, dmScript::ResetAllocationCount(allocator));
+
+    // Freed blocks are reused
+    void* a = dmScript::LuaAlloc(allocator, 0, 0, 24);
+    dmScript::LuaAlloc(allocator, a, 24, 0);
+    void* b = dmScript::LuaAlloc(allocator, 0, 0, 32);
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(0u, (uintptr_t) b % sizeof(double));
+    dmScript::LuaAlloc(allocator, b, 32, 0);
+    ASSERT_EQ(0u, dmScript::GetLiveBytes(allocator));
+
+    dmScript::DeleteLuaAllocator(allocator);
+}
+
+TEST(ScriptGC, TimeBudget)
+{
+    const char* config_buffer = "[script]\ngc_time_budget = 0.5\n";
+    dmConfigFile::HConfig config;
+    ASSERT_EQ(dmConfigFile::RESULT_OK, dmConfigFile::LoadFromBuffer(config_buffer, strlen(config_buffer), 0, 0, &config));
+
+    dmScript::HContext context = dmScript::NewContext(config, 0, true);
+    dmScript::Initialize(context);
+    lua_State* L = dmScript::GetLuaState(context);
+
+    // The garbage is collected in budgeted steps from Update()
+    uint64_t max_live_bytes = 0;
+    uint32_t gc_time = 0;
+    for (uint32_t i = 0; i < 200; ++i)
+    {
+        ASSERT_TRUE(RunString(L, "for i=1,1000 do local t = {i, tostring(i)} end"));
+        dmScript::Update(context);
+
+        dmScript::LuaMemoryStats stats;
+        dmScript::GetLuaMemoryStats(context, &stats);
+        max_live_bytes = dmMath::Max(max_live_bytes, stats.m_LiveBytes);
+        gc_time += stats.m_GCTime;
+    }
+    ASSERT_GT(gc_time, 0u);
+    ASSERT_LT(max_live_bytes, 8u * 1024 * 1024);
+
+    dmScript::Finalize(context);
+    dmScript::DeleteContext(context);
+    dmConfigFile::Delete(config);
+}
+
+static void CollectLuaSampleNames(void* context, const dmProfile::Sample* sample)
+{
+    if (sample->m_ThreadId == dmProfile::LUA_THREAD_ID)
+    {
+        ((dmArray<const char*>*) context)->Push(sample->m_Name);
+    }
+}
+
+TEST(ScriptProfiler, Samples)
+{
+    dmProfile::Initialize(128, 1024, 16);
+
+    const char* config_buffer = "[script]\nprofiler_sample_interval = 100\n";
+    dmConfigFile::HConfig config;
+    ASSERT_EQ(dmConfigFile::RESULT_OK, dmConfigFile::LoadFromBuffer(config_buffer, strlen(config_buffer), 0, 0, &config));
+
+    dmScript::HContext context = dmScript::NewContext(config, 0, true);
+    dmScript::Initialize(context);
+    lua_State* L = dmScript::GetLuaState(context);
+
+    ASSERT_TRUE(RunString(L, "local function inner() local s = 0 for i=1,200000 do s = s + math.sin(i) end return s end\n"
+                             "function busy() return inner() end"));
+    dmProfile::Release(dmProfile::Begin());
+
+    lua_getglobal(L, "busy");
+    ASSERT_EQ(0, dmScript::PCall(L, 0, 0));
+    dmScript::Update(context);
+
+    dmArray<const char*> names;
+    names.SetCapacity(1024);
+    dmProfile::HProfile profile = dmProfile::Begin();
+    dmProfile::IterateSamples(profile, &names, false, &CollectLuaSampleNames);
+    dmProfile::Release(profile);
+
+    // The called function is named after the line it's defined on, see GetProfilerString()
+    bool found_busy = false;
+    for (uint32_t i = 0; i < names.Size(); ++i)
+    {
+        found_busy |= strncmp(names[i], "l(2)@", 5) == 0;
+    }
+    ASSERT_TRUE(found_busy);
+
+    dmScript::Finalize(context);
+    dmScript::DeleteContext(context);
+    dmConfigFile::Delete(config);
+    dmProfile::Finalize();
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -113,6 +113,32 @@ TEST_F(ScriptDDFTest, TransformToLua)
     ASSERT_EQ(top, lua_gettop(L));
 }
 
+TEST_F(ScriptDDFTest, TransformRoundTrip)
+{
+    int top = lua_gettop(L);
+
+    TestScript::Transform t;
+    t.m_Position = Vectormath::Aos::Vector3(1.0f, 2.0f, 3.0f);
+    t.m_Rotation = Vectormath::Aos::Quat(4.0f, 5.0f, 6.0f, 7.0f);
+
+    // The conversion plan and field names are cached on first use, convert more than once
+    for (int i = 0; i < 3; ++i)
+    {
+        dmScript::PushDDF(L, TestScript::Transform::m_DDFDescriptor, (const char*) &t);
+
+        TestScript::Transform result;
+        uint32_t size = dmScript::CheckDDF(L, TestScript::Transform::m_DDFDescriptor, (char*) &result, sizeof(result), -1);
+        ASSERT_EQ(sizeof(TestScript::Transform), size);
+        ASSERT_EQ(1.0f, result.m_Position.getX());
+        ASSERT_EQ(3.0f, result.m_Position.getZ());
+        ASSERT_EQ(4.0f, result.m_Rotation.getX());
+        ASSERT_EQ(7.0f, result.m_Rotation.getW());
+
+        lua_pop(L, 1);
+        ASSERT_EQ(top, lua_gettop(L));
+    }
+}
+
 TEST_F(ScriptDDFTest, MessageInMessageToDDF)
 {
     int top = lua_gettop(L);
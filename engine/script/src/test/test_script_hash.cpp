@@ -194,6 +194,40 @@ TEST_F(ScriptHashTest, TestHashTString) // def2821 - Making sure that the string
     ASSERT_EQ(hash_tostring, hash_tolstring);
 }
 
+TEST_F(ScriptHashTest, TestHashStringCache)
+{
+    int top = lua_gettop(L);
+
+    lua_pushstring(L, "play_animation");
+    ASSERT_EQ(dmHashString64("play_animation"), dmScript::HashString(L, -1));
+    // Cached
+    ASSERT_EQ(dmHashString64("play_animation"), dmScript::HashString(L, -1));
+    lua_pop(L, 1);
+
+    lua_pushnumber(L, 123);
+    ASSERT_EQ(dmHashString64("123"), dmScript::HashString(L, -1));
+    lua_pop(L, 1);
+
+    ASSERT_EQ(top, lua_gettop(L));
+
+    // Strings that are no longer referenced in scripts must not leave stale hashes behind
+    char buffer[32];
+    for (int i = 0; i < 2; ++i)
+    {
+        for (int j = 0; j < 1000; ++j)
+        {
+            dmSnPrintf(buffer, sizeof(buffer), "prop_%d", j * (i + 1));
+            lua_pushstring(L, buffer);
+            ASSERT_EQ(dmHashString64(buffer), dmScript::HashString(L, -1));
+            lua_pop(L, 1);
+        }
+        lua_gc(L, LUA_GCCOLLECT, 0);
+    }
+    ASSERT_TRUE(RunString(L, "assert(hash(\"prop_\" .. 7) == hash(\"prop_7\"))"));
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -724,6 +724,38 @@ TEST_F(ScriptTimerTest, TestKillTimers)
     dmScript::DeleteTimerWorld(timer_world);
 }
 
+TEST_F(ScriptTimerTest, TestManyTimers)
+{
+    dmScript::HTimerWorld timer_world = dmScript::NewTimerWorld();
+
+    // More timers than fit in a 16 bit index, due in reverse order of creation
+    const uint32_t timer_count = 100000u;
+    for (uint32_t i = 0; i < timer_count; ++i)
+    {
+        uintptr_t owner = i < timer_count / 2 ? 1u : 2u;
+        dmScript::HTimer handle = dmScript::AddTimer(timer_world, (timer_count - i) * 0.001f, false, TestCallback, owner, 0x0);
+        ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, handle);
+    }
+    ASSERT_EQ(timer_count, dmScript::GetAliveTimers(timer_world));
+
+    dmScript::UpdateTimers(timer_world, 1.0005f);
+    ASSERT_EQ(1000u, TimerTestCallback::callback_count);
+    ASSERT_EQ(timer_count - 1000u, dmScript::GetAliveTimers(timer_world));
+
+    uint32_t kill_count = dmScript::KillTimers(timer_world, 1u);
+    ASSERT_EQ(timer_count / 2, kill_count);
+    ASSERT_EQ(0u, TimerTestCallback::cancel_count);
+
+    dmScript::UpdateTimers(timer_world, 1.0f);
+    ASSERT_EQ(2000u, TimerTestCallback::callback_count);
+
+    kill_count = dmScript::KillTimers(timer_world, 2u);
+    ASSERT_EQ(timer_count / 2 - 2000u, kill_count);
+    ASSERT_EQ(0u, dmScript::GetAliveTimers(timer_world));
+
+    dmScript::DeleteTimerWorld(timer_world);
+}
+
 static bool RunString(lua_State* L, const char* script)
 {
     luaL_loadstring(L, script);
@@ -53,6 +53,15 @@ function test_sys()
     assert(data['xp'] == data_prim['xp'])
     assert(data['name'] == data_prim['name'])
 
+    -- save file without blocking, sys.load waits for the pending save
+    data = { high_score = 4321, location = vmath.vector3(3,2,1), xp = 101, name = "Async Player" }
+    sys.save_async(file, data)
+    data.high_score = 0
+    data_prim = sys.load(file)
+    assert(data_prim['high_score'] == 4321)
+    assert(data['location'] == data_prim['location'])
+    assert(data['name'] == data_prim['name'])
+
     -- load file exceeding max buffer size, expected to fail
     fh = io.open(file, "a+")
     for i=1,(max_table_size/8) do fh:write("deadbeef") end
@@ -11,6 +11,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <dlib/index_pool.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
@@ -33,7 +34,43 @@ namespace dmSoundCodec
             const char *m_Buffer;
             ogg_int64_t m_SeekTo;
             ogg_int64_t m_PcmLength;
+
+            // Streaming, the compressed data is read in parts into m_Buffer
+            FStreamRead m_Read;
+            void* m_ReadContext;
+            size_t m_BufferOffset;
+            size_t m_BufferSize;
         };
+
+        // Size of the read buffer of streamed files
+        const uint32_t STREAM_BUFFER_SIZE = 16 * 1024;
+    }
+
+    // Reads from a streamed file, through a buffer to keep the number of reads down
+    static size_t OggStreamRead(DecodeStreamInfo* info, char* ptr, size_t size)
+    {
+        size_t tot = 0;
+        while (tot < size && info->m_Cursor < info->m_Size)
+        {
+            if (info->m_Cursor < info->m_BufferOffset || info->m_Cursor >= info->m_BufferOffset + info->m_BufferSize)
+            {
+                uint32_t nread = 0;
+                info->m_BufferOffset = info->m_Cursor;
+                info->m_BufferSize = 0;
+                if (info->m_Read(info->m_ReadContext, (uint32_t) info->m_Cursor, (void*) info->m_Buffer, STREAM_BUFFER_SIZE, &nread) != RESULT_OK || nread == 0)
+                {
+                    break;
+                }
+                info->m_BufferSize = nread;
+            }
+
+            size_t available = info->m_BufferOffset + info->m_BufferSize - info->m_Cursor;
+            size_t n = dmMath::Min(size - tot, available);
+            memcpy(&ptr[tot], &info->m_Buffer[info->m_Cursor - info->m_BufferOffset], n);
+            info->m_Cursor += n;
+            tot += n;
+        }
+        return tot;
     }
 
     // The functions below mimic the usual fopen/fread etc functions, reading from a buffer
@@ -43,6 +80,10 @@ namespace dmSoundCodec
         DecodeStreamInfo *info = (DecodeStreamInfo*) datasource;
 
         size_t tot = nmemb * size;
+        if (info->m_Read) {
+            return OggStreamRead(info, (char*) ptr, tot);
+        }
+
         if (tot > (info->m_Size - info->m_Cursor)) {
             tot = info->m_Size - info->m_Cursor;
         }
@@ -78,13 +119,8 @@ namespace dmSoundCodec
         return info->m_Cursor;
     }
 
-    static Result TremoloOpenStream(const void* buffer, uint32_t buffer_size, HDecodeStream* stream)
+    static Result TremoloOpen(DecodeStreamInfo* tmp, HDecodeStream* stream)
     {
-        DecodeStreamInfo *tmp = new DecodeStreamInfo();
-        tmp->m_Buffer = (const char*) buffer;
-        tmp->m_Size = buffer_size;
-        tmp->m_Cursor = 0;
-
         ov_callbacks cb;
         cb.read_func = OggRead;
         cb.close_func = OggClose;
@@ -94,6 +130,8 @@ namespace dmSoundCodec
         int res = ov_open_callbacks(tmp, &tmp->m_File, 0, 0, cb);
         if (res)
         {
+            if (tmp->m_Read)
+                free((void*) tmp->m_Buffer);
             delete tmp;
             return RESULT_INVALID_FORMAT;
         }
@@ -112,6 +150,29 @@ namespace dmSoundCodec
         return RESULT_OK;
     }
 
+    static Result TremoloOpenStream(const void* buffer, uint32_t buffer_size, HDecodeStream* stream)
+    {
+        DecodeStreamInfo *tmp = new DecodeStreamInfo();
+        tmp->m_Buffer = (const char*) buffer;
+        tmp->m_Size = buffer_size;
+        tmp->m_Cursor = 0;
+        tmp->m_Read = 0;
+        return TremoloOpen(tmp, stream);
+    }
+
+    static Result TremoloOpenStreamingStream(FStreamRead read, void* read_context, uint32_t size, HDecodeStream* stream)
+    {
+        DecodeStreamInfo *tmp = new DecodeStreamInfo();
+        tmp->m_Buffer = (const char*) malloc(STREAM_BUFFER_SIZE);
+        tmp->m_Size = size;
+        tmp->m_Cursor = 0;
+        tmp->m_Read = read;
+        tmp->m_ReadContext = read_context;
+        tmp->m_BufferOffset = 0;
+        tmp->m_BufferSize = 0;
+        return TremoloOpen(tmp, stream);
+    }
+
     static Result TremoloDecode(HDecodeStream stream, char* buffer, uint32_t buffer_size, uint32_t* decoded)
     {
         DM_PROFILE(SoundCodec, "Tremolo")
@@ -198,6 +259,8 @@ namespace dmSoundCodec
     {
         DecodeStreamInfo *streamInfo = (DecodeStreamInfo*) stream;
         ov_clear(&streamInfo->m_File);
+        if (streamInfo->m_Read)
+            free((void*) streamInfo->m_Buffer);
         delete streamInfo;
     }
 
@@ -207,5 +270,5 @@ namespace dmSoundCodec
     }
 
     DM_DECLARE_SOUND_DECODER(AudioDecoderTremolo, "VorbisDecoderTremolo", FORMAT_VORBIS, 8,
-                             TremoloOpenStream, TremoloCloseStream, TremoloDecode, TremoloResetStream, TremoloSkipInStream, TremoloGetInfo);
+                             TremoloOpenStream, TremoloOpenStreamingStream, TremoloCloseStream, TremoloDecode, TremoloResetStream, TremoloSkipInStream, TremoloGetInfo);
 }
@@ -110,45 +110,66 @@ namespace dmSoundCodec
             Info m_Info;
             uint32_t m_Cursor;
             const void* m_Buffer;
+            // A streamed wav is read with m_Read from m_DataOffset, instead of from m_Buffer
+            FStreamRead m_Read;
+            void* m_ReadContext;
+            uint32_t m_DataOffset;
         };
-    }
 
-    static Result WavOpenStream(const void* buffer, uint32_t buffer_size, HDecodeStream* stream)
-    {
-        RiffHeader* header = (RiffHeader*) buffer;
-        DecodeStreamInfo streamTemp;
+        struct MemoryReadContext {
+            const char* m_Buffer;
+            uint32_t m_Size;
+        };
 
-        bool fmt_found = false;
-        bool data_found = false;
+        static Result MemoryRead(void* context, uint32_t offset, void* buffer, uint32_t buffer_size, uint32_t* nread)
+        {
+            MemoryReadContext* ctx = (MemoryReadContext*) context;
+            uint32_t n = offset < ctx->m_Size ? dmMath::Min(buffer_size, ctx->m_Size - offset) : 0;
+            memcpy(buffer, ctx->m_Buffer + offset, n);
+            *nread = n;
+            return RESULT_OK;
+        }
 
-        if (buffer_size < sizeof(RiffHeader)) {
-            return RESULT_INVALID_FORMAT;
+        static bool ReadExact(FStreamRead read, void* context, uint32_t offset, void* buffer, uint32_t size)
+        {
+            uint32_t nread = 0;
+            return read(context, offset, buffer, size, &nread) == RESULT_OK && nread == size;
         }
 
-        if (header->m_ChunkID == FOUR_CC('R', 'I', 'F', 'F') &&
-            header->m_Format == FOUR_CC('W', 'A', 'V', 'E')) {
+        // Reads the fmt and data chunks. Only the chunk headers are read, not the PCM data
+        static Result ParseWav(FStreamRead read, void* context, uint32_t size, DecodeStreamInfo* info, uint32_t* data_offset)
+        {
+            RiffHeader header;
+            if (size < sizeof(RiffHeader) || !ReadExact(read, context, 0, &header, sizeof(header))) {
+                return RESULT_INVALID_FORMAT;
+            }
 
-            const char* begin = (const char*) buffer;
-            const char* current = (const char*) buffer;
-            const char* end = (const char*) buffer + buffer_size;
-            current += sizeof(RiffHeader);
+            if (header.m_ChunkID != FOUR_CC('R', 'I', 'F', 'F') ||
+                header.m_Format != FOUR_CC('W', 'A', 'V', 'E')) {
+                return RESULT_INVALID_FORMAT;
+            }
+
+            bool fmt_found = false;
+            bool data_found = false;
+            uint64_t current = sizeof(RiffHeader);
             do {
-                CommonHeader header;
-                if (current + sizeof(header) > end) {
+                CommonHeader chunk;
+                if (current + sizeof(chunk) > size) {
                     // not enough bytes left for a full header. just ignore this.
                     break;
                 }
 
-                memcpy(&header, current, sizeof(header));
-                header.SwapHeader();
-                if (header.m_ChunkID == FOUR_CC('f', 'm', 't', ' ')) {
+                if (!ReadExact(read, context, (uint32_t) current, &chunk, sizeof(chunk))) {
+                    return RESULT_INVALID_FORMAT;
+                }
+                chunk.SwapHeader();
+                if (chunk.m_ChunkID == FOUR_CC('f', 'm', 't', ' ')) {
                     FmtChunk fmt;
-                    if (current + sizeof(fmt) > end) {
-                        dmLogWarning("WAV sound data seems corrupt or truncated at position %d out of %d", (int)(current - begin), buffer_size);
+                    if (current + sizeof(fmt) > size || !ReadExact(read, context, (uint32_t) current, &fmt, sizeof(fmt))) {
+                        dmLogWarning("WAV sound data seems corrupt or truncated at position %d out of %d", (int)current, size);
                         return RESULT_INVALID_FORMAT;
                     }
 
-                    memcpy(&fmt, current, sizeof(fmt));
                     fmt.Swap();
                     fmt_found = true;
 
@@ -157,44 +178,71 @@ namespace dmSoundCodec
                         dmLogWarning("Only wav-files with 8 or 16 bit PCM format (format=1) supported, got format=%d and bitdepth=%d", fmt.m_AudioFormat, fmt.m_BitsPerSample);
                         return RESULT_INVALID_FORMAT;
                     }
-                    streamTemp.m_Info.m_Rate = fmt.m_SampleRate;
-                    streamTemp.m_Info.m_Channels = fmt.m_NumChannels;
-                    streamTemp.m_Info.m_BitsPerSample = fmt.m_BitsPerSample;
+                    info->m_Info.m_Rate = fmt.m_SampleRate;
+                    info->m_Info.m_Channels = fmt.m_NumChannels;
+                    info->m_Info.m_BitsPerSample = fmt.m_BitsPerSample;
 
-                } else if (header.m_ChunkID == FOUR_CC('d', 'a', 't', 'a')) {
+                } else if (chunk.m_ChunkID == FOUR_CC('d', 'a', 't', 'a')) {
                     // NOTE: We don't byte-swap PCM-data and a potential problem on big-endian architectures
-                    DataChunk data;
-                    if (current + sizeof(data) > end) {
-                        dmLogWarning("WAV sound data seems corrupt or truncated at position %d out of %d", (int)(current - begin), buffer_size);
+                    if (current + sizeof(DataChunk) > size) {
+                        dmLogWarning("WAV sound data seems corrupt or truncated at position %d out of %d", (int)current, size);
                         return RESULT_INVALID_FORMAT;
                     }
 
-                    memcpy(&data, current, sizeof(data));
-                    data.Swap();
-                    streamTemp.m_Buffer = (void*) (current + sizeof(DataChunk));
-                    streamTemp.m_Info.m_Size = data.m_ChunkSize;
+                    *data_offset = (uint32_t) (current + sizeof(DataChunk));
+                    info->m_Info.m_Size = dmMath::Min(chunk.m_ChunkSize, size - *data_offset);
                     data_found = true;
                 }
-                current += header.m_ChunkSize + sizeof(CommonHeader);
-            } while (current < end && !(fmt_found && data_found));
-
-            if (fmt_found && data_found) {
-                // Allocate stream output and copy temporary data over there.
-                // Doing this last-minute avoids having to worry about deallocating
-                // on failure. NOTE: Maybe pool allocate here.
-                streamTemp.m_Cursor = 0;
-                DecodeStreamInfo *streamOut = new DecodeStreamInfo;
-                *streamOut = streamTemp;
-                *stream = streamOut;
-                return RESULT_OK;
-            } else {
-                return RESULT_INVALID_FORMAT;
-            }
-        } else {
-            return RESULT_INVALID_FORMAT;
+                current += (uint64_t) chunk.m_ChunkSize + sizeof(CommonHeader);
+            } while (current < size && !(fmt_found && data_found));
+
+            return (fmt_found && data_found) ? RESULT_OK : RESULT_INVALID_FORMAT;
         }
     }
 
+    static Result WavOpenStream(const void* buffer, uint32_t buffer_size, HDecodeStream* stream)
+    {
+        DecodeStreamInfo streamTemp;
+        memset(&streamTemp, 0, sizeof(streamTemp));
+
+        MemoryReadContext context = { (const char*) buffer, buffer_size };
+        uint32_t data_offset = 0;
+        Result r = ParseWav(MemoryRead, &context, buffer_size, &streamTemp, &data_offset);
+        if (r != RESULT_OK) {
+            return r;
+        }
+
+        // Allocate stream output and copy temporary data over there.
+        // Doing this last-minute avoids having to worry about deallocating
+        // on failure. NOTE: Maybe pool allocate here.
+        streamTemp.m_Buffer = (const char*) buffer + data_offset;
+        DecodeStreamInfo *streamOut = new DecodeStreamInfo;
+        *streamOut = streamTemp;
+        *stream = streamOut;
+        return RESULT_OK;
+    }
+
+    // The PCM data is read in parts while decoding, so a large wav doesn't have to be kept in memory
+    static Result WavOpenStreamingStream(FStreamRead read, void* read_context, const uint32_t size, HDecodeStream* stream)
+    {
+        DecodeStreamInfo streamTemp;
+        memset(&streamTemp, 0, sizeof(streamTemp));
+
+        uint32_t data_offset = 0;
+        Result r = ParseWav(read, read_context, size, &streamTemp, &data_offset);
+        if (r != RESULT_OK) {
+            return r;
+        }
+
+        streamTemp.m_Read = read;
+        streamTemp.m_ReadContext = read_context;
+        streamTemp.m_DataOffset = data_offset;
+        DecodeStreamInfo *streamOut = new DecodeStreamInfo;
+        *streamOut = streamTemp;
+        *stream = streamOut;
+        return RESULT_OK;
+    }
+
     void WavCloseStream(HDecodeStream stream)
     {
         assert(stream);
@@ -217,8 +265,22 @@ namespace dmSoundCodec
 
         assert(streamInfo->m_Cursor <= streamInfo->m_Info.m_Size);
         uint32_t n = dmMath::Min(buffer_size, streamInfo->m_Info.m_Size - streamInfo->m_Cursor);
+        if (streamInfo->m_Read)
+        {
+            uint32_t nread = 0;
+            Result r = streamInfo->m_Read(streamInfo->m_ReadContext, streamInfo->m_DataOffset + streamInfo->m_Cursor, buffer, n, &nread);
+            if (r != RESULT_OK)
+            {
+                *decoded = 0;
+                return r;
+            }
+            n = nread;
+        }
+        else
+        {
+            memcpy(buffer, (const char*) streamInfo->m_Buffer + streamInfo->m_Cursor, n);
+        }
         *decoded = n;
-        memcpy(buffer, (const char*) streamInfo->m_Buffer + streamInfo->m_Cursor, n);
         streamInfo->m_Cursor += n;
         return RESULT_OK;
     }
@@ -240,5 +302,5 @@ namespace dmSoundCodec
 
     DM_DECLARE_SOUND_DECODER(AudioDecoderWav, "WavDecoder", FORMAT_WAV,
                              0,
-                             WavOpenStream, WavCloseStream, WavDecodeStream, WavResetStream, WavSkipInStream, WavGetInfo);
+                             WavOpenStream, WavOpenStreamingStream, WavCloseStream, WavDecodeStream, WavResetStream, WavSkipInStream, WavGetInfo);
 }
@@ -0,0 +1,321 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <assert.h>
+#include <dlfcn.h>
+#include <stdint.h>
+#include <string.h>
+#include <dlib/atomic.h>
+#include <dlib/log.h>
+#include <dlib/mutex.h>
+#include <dlib/thread.h>
+#include <dlib/time.h>
+#include "sound.h"
+
+#include <aaudio/AAudio.h>
+
+/**
+ * AAudio low latency audio device
+ *
+ * - Registered as "low_latency" and only used when sound.low_latency is set. The sound system
+ *   falls back to the OpenSL "default" device when it can't be opened.
+ * - libaaudio.so is loaded at runtime since it only exists on Android 8.0 (API 26) and later
+ * - The stream pulls its frames from the render callback, in buffers of the native burst size,
+ *   instead of having buffers queued. The buffer size is set to two bursts.
+ * - When the output is disconnected (e.g. headphones are unplugged) the stream is reopened on a
+ *   separate thread, as the stream can't be closed from its own callbacks
+ */
+namespace dmDeviceAAudio
+{
+    struct AAudioFunctions
+    {
+        aaudio_result_t (*m_CreateStreamBuilder)(AAudioStreamBuilder** builder);
+        void (*m_SetPerformanceMode)(AAudioStreamBuilder* builder, aaudio_performance_mode_t mode);
+        void (*m_SetSharingMode)(AAudioStreamBuilder* builder, aaudio_sharing_mode_t mode);
+        void (*m_SetFormat)(AAudioStreamBuilder* builder, aaudio_format_t format);
+        void (*m_SetChannelCount)(AAudioStreamBuilder* builder, int32_t channel_count);
+        void (*m_SetSampleRate)(AAudioStreamBuilder* builder, int32_t sample_rate);
+        void (*m_SetDataCallback)(AAudioStreamBuilder* builder, AAudioStream_dataCallback callback, void* user_data);
+        void (*m_SetErrorCallback)(AAudioStreamBuilder* builder, AAudioStream_errorCallback callback, void* user_data);
+        aaudio_result_t (*m_OpenStream)(AAudioStreamBuilder* builder, AAudioStream** stream);
+        aaudio_result_t (*m_DeleteStreamBuilder)(AAudioStreamBuilder* builder);
+        aaudio_result_t (*m_Close)(AAudioStream* stream);
+        aaudio_result_t (*m_RequestStart)(AAudioStream* stream);
+        aaudio_result_t (*m_RequestStop)(AAudioStream* stream);
+        aaudio_result_t (*m_SetBufferSizeInFrames)(AAudioStream* stream, int32_t frames);
+        int32_t (*m_GetFramesPerBurst)(AAudioStream* stream);
+        int32_t (*m_GetSampleRate)(AAudioStream* stream);
+        const char* (*m_ConvertResultToText)(aaudio_result_t result);
+    };
+
+    struct AAudioDevice
+    {
+        AAudioStream*                   m_Stream;
+        dmSound::DeviceRenderCallback   m_RenderCallback;
+        // Guards the stream against being reopened while it is started, stopped or closed
+        dmMutex::HMutex                 m_Mutex;
+        dmThread::Thread                m_ReopenThread;
+        int32_atomic_t                  m_Reopening;
+        uint32_t                        m_BufferCount;
+        int32_t                         m_SampleRate;
+        int32_t                         m_FramesPerBurst;
+        bool                            m_IsPlaying;
+    };
+
+    static void* g_Library = 0;
+    static AAudioFunctions g_AAudio;
+
+    template <typename T>
+    static bool LoadFunction(T* function, const char* name)
+    {
+        *function = (T) dlsym(g_Library, name);
+        if (*function == 0)
+        {
+            dmLogWarning("AAudio: Missing function %s", name);
+        }
+        return *function != 0;
+    }
+
+    static bool LoadAAudio()
+    {
+        if (g_Library)
+        {
+            return true;
+        }
+
+        void* library = dlopen("libaaudio.so", RTLD_NOW | RTLD_LOCAL);
+        if (!library)
+        {
+            return false;
+        }
+        g_Library = library;
+
+        bool ok = LoadFunction(&g_AAudio.m_CreateStreamBuilder, "AAudio_createStreamBuilder");
+        ok &= LoadFunction(&g_AAudio.m_SetPerformanceMode, "AAudioStreamBuilder_setPerformanceMode");
+        ok &= LoadFunction(&g_AAudio.m_SetSharingMode, "AAudioStreamBuilder_setSharingMode");
+        ok &= LoadFunction(&g_AAudio.m_SetFormat, "AAudioStreamBuilder_setFormat");
+        ok &= LoadFunction(&g_AAudio.m_SetChannelCount, "AAudioStreamBuilder_setChannelCount");
+        ok &= LoadFunction(&g_AAudio.m_SetSampleRate, "AAudioStreamBuilder_setSampleRate");
+        ok &= LoadFunction(&g_AAudio.m_SetDataCallback, "AAudioStreamBuilder_setDataCallback");
+        ok &= LoadFunction(&g_AAudio.m_SetErrorCallback, "AAudioStreamBuilder_setErrorCallback");
+        ok &= LoadFunction(&g_AAudio.m_OpenStream, "AAudioStreamBuilder_openStream");
+        ok &= LoadFunction(&g_AAudio.m_DeleteStreamBuilder, "AAudioStreamBuilder_delete");
+        ok &= LoadFunction(&g_AAudio.m_Close, "AAudioStream_close");
+        ok &= LoadFunction(&g_AAudio.m_RequestStart, "AAudioStream_requestStart");
+        ok &= LoadFunction(&g_AAudio.m_RequestStop, "AAudioStream_requestStop");
+        ok &= LoadFunction(&g_AAudio.m_SetBufferSizeInFrames, "AAudioStream_setBufferSizeInFrames");
+        ok &= LoadFunction(&g_AAudio.m_GetFramesPerBurst, "AAudioStream_getFramesPerBurst");
+        ok &= LoadFunction(&g_AAudio.m_GetSampleRate, "AAudioStream_getSampleRate");
+        ok &= LoadFunction(&g_AAudio.m_ConvertResultToText, "AAudio_convertResultToText");
+        if (!ok)
+        {
+            dlclose(library);
+            g_Library = 0;
+        }
+        return ok;
+    }
+
+    static bool CheckAndPrintError(aaudio_result_t result, const char* what)
+    {
+        if (result != AAUDIO_OK)
+        {
+            dmLogError("AAudio: %s failed: %s", what, g_AAudio.m_ConvertResultToText(result));
+            return true;
+        }
+        return false;
+    }
+
+    static aaudio_data_callback_result_t DataCallback(AAudioStream* stream, void* user_data, void* audio_data, int32_t frame_count)
+    {
+        AAudioDevice* aaudio = (AAudioDevice*) user_data;
+        aaudio->m_RenderCallback((int16_t*) audio_data, (uint32_t) frame_count);
+        return AAUDIO_CALLBACK_RESULT_CONTINUE;
+    }
+
+    static void ErrorCallback(AAudioStream* stream, void* user_data, aaudio_result_t error);
+
+    // Opens the stream with the current settings. Keeps the sample rate of a previous stream,
+    // since the sound system mixes for the rate it got when the device was opened
+    static aaudio_result_t OpenStream(AAudioDevice* aaudio)
+    {
+        AAudioStreamBuilder* builder = 0;
+        aaudio_result_t result = g_AAudio.m_CreateStreamBuilder(&builder);
+        if (CheckAndPrintError(result, "Create stream builder"))
+        {
+            return result;
+        }
+
+        g_AAudio.m_SetPerformanceMode(builder, AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
+        g_AAudio.m_SetSharingMode(builder, AAUDIO_SHARING_MODE_EXCLUSIVE);
+        g_AAudio.m_SetFormat(builder, AAUDIO_FORMAT_PCM_I16);
+        g_AAudio.m_SetChannelCount(builder, 2);
+        if (aaudio->m_SampleRate != 0)
+        {
+            g_AAudio.m_SetSampleRate(builder, aaudio->m_SampleRate);
+        }
+        g_AAudio.m_SetDataCallback(builder, DataCallback, aaudio);
+        g_AAudio.m_SetErrorCallback(builder, ErrorCallback, aaudio);
+
+        AAudioStream* stream = 0;
+        result = g_AAudio.m_OpenStream(builder, &stream);
+        g_AAudio.m_DeleteStreamBuilder(builder);
+        if (CheckAndPrintError(result, "Open stream"))
+        {
+            return result;
+        }
+
+        aaudio->m_Stream = stream;
+        aaudio->m_SampleRate = g_AAudio.m_GetSampleRate(stream);
+        aaudio->m_FramesPerBurst = g_AAudio.m_GetFramesPerBurst(stream);
+        // Two bursts is the lowest latency that doesn't underrun on most devices
+        g_AAudio.m_SetBufferSizeInFrames(stream, aaudio->m_FramesPerBurst * 2);
+        return AAUDIO_OK;
+    }
+
+    static void ReopenThread(void* ctx)
+    {
+        AAudioDevice* aaudio = (AAudioDevice*) ctx;
+        {
+            DM_MUTEX_SCOPED_LOCK(aaudio->m_Mutex);
+            if (aaudio->m_Stream)
+            {
+                g_AAudio.m_Close(aaudio->m_Stream);
+                aaudio->m_Stream = 0;
+            }
+            if (OpenStream(aaudio) == AAUDIO_OK && aaudio->m_IsPlaying)
+            {
+                CheckAndPrintError(g_AAudio.m_RequestStart(aaudio->m_Stream), "Start stream");
+            }
+        }
+        dmAtomicStore32(&aaudio->m_Reopening, 0);
+    }
+
+    static void ErrorCallback(AAudioStream* stream, void* user_data, aaudio_result_t error)
+    {
+        AAudioDevice* aaudio = (AAudioDevice*) user_data;
+        if (error != AAUDIO_ERROR_DISCONNECTED)
+        {
+            dmLogError("AAudio: Stream error: %s", g_AAudio.m_ConvertResultToText(error));
+            return;
+        }
+
+        if (dmAtomicCompareStore32(&aaudio->m_Reopening, 1, 0) == 0)
+        {
+            // A previous reopen thread has finished by now
+            if (aaudio->m_ReopenThread)
+            {
+                dmThread::Join(aaudio->m_ReopenThread);
+            }
+            aaudio->m_ReopenThread = dmThread::New(ReopenThread, 0x10000, aaudio, "aaudio_reopen");
+        }
+    }
+
+    dmSound::Result DeviceAAudioOpen(const dmSound::OpenDeviceParams* params, dmSound::HDevice* device)
+    {
+        if (!params->m_RenderCallback)
+        {
+            dmLogError("AAudio: The device requires a render callback");
+            return dmSound::RESULT_INIT_ERROR;
+        }
+        if (!LoadAAudio())
+        {
+            return dmSound::RESULT_DEVICE_NOT_FOUND;
+        }
+
+        AAudioDevice* aaudio = new AAudioDevice;
+        memset(aaudio, 0, sizeof(*aaudio));
+        aaudio->m_RenderCallback = params->m_RenderCallback;
+        aaudio->m_BufferCount = params->m_BufferCount;
+        aaudio->m_Mutex = dmMutex::New();
+
+        if (OpenStream(aaudio) != AAUDIO_OK)
+        {
+            dmMutex::Delete(aaudio->m_Mutex);
+            delete aaudio;
+            return dmSound::RESULT_INIT_ERROR;
+        }
+
+        dmLogInfo("AAudio: %d Hz, %d frames per burst", aaudio->m_SampleRate, aaudio->m_FramesPerBurst);
+        *device = aaudio;
+        return dmSound::RESULT_OK;
+    }
+
+    void DeviceAAudioClose(dmSound::HDevice device)
+    {
+        assert(device);
+        AAudioDevice* aaudio = (AAudioDevice*) device;
+
+        // Take the reopen flag, so that no reopen thread is started from here on, and wait for a running one
+        while (dmAtomicCompareStore32(&aaudio->m_Reopening, 1, 0) != 0)
+        {
+            dmTime::Sleep(1000);
+        }
+        if (aaudio->m_ReopenThread)
+        {
+            dmThread::Join(aaudio->m_ReopenThread);
+        }
+
+        if (aaudio->m_Stream)
+        {
+            g_AAudio.m_Close(aaudio->m_Stream);
+        }
+        dmMutex::Delete(aaudio->m_Mutex);
+        delete aaudio;
+    }
+
+    dmSound::Result DeviceAAudioQueue(dmSound::HDevice device, const int16_t* samples, uint32_t sample_count)
+    {
+        // Frames are pulled through the render callback
+        return dmSound::RESULT_UNSUPPORTED;
+    }
+
+    uint32_t DeviceAAudioFreeBufferSlots(dmSound::HDevice device)
+    {
+        // Nothing is ever queued, so the device can always be stopped right away
+        AAudioDevice* aaudio = (AAudioDevice*) device;
+        return aaudio->m_BufferCount;
+    }
+
+    void DeviceAAudioDeviceInfo(dmSound::HDevice device, dmSound::DeviceInfo* info)
+    {
+        assert(device);
+        AAudioDevice* aaudio = (AAudioDevice*) device;
+        info->m_MixRate = (uint32_t) aaudio->m_SampleRate;
+        info->m_FrameCount = (uint32_t) aaudio->m_FramesPerBurst;
+    }
+
+    void DeviceAAudioStart(dmSound::HDevice device)
+    {
+        assert(device);
+        AAudioDevice* aaudio = (AAudioDevice*) device;
+        DM_MUTEX_SCOPED_LOCK(aaudio->m_Mutex);
+        aaudio->m_IsPlaying = true;
+        if (aaudio->m_Stream)
+        {
+            CheckAndPrintError(g_AAudio.m_RequestStart(aaudio->m_Stream), "Start stream");
+        }
+    }
+
+    void DeviceAAudioStop(dmSound::HDevice device)
+    {
+        assert(device);
+        AAudioDevice* aaudio = (AAudioDevice*) device;
+        DM_MUTEX_SCOPED_LOCK(aaudio->m_Mutex);
+        aaudio->m_IsPlaying = false;
+        if (aaudio->m_Stream)
+        {
+            CheckAndPrintError(g_AAudio.m_RequestStop(aaudio->m_Stream), "Stop stream");
+        }
+    }
+
+    DM_DECLARE_SOUND_DEVICE(LowLatencySoundDevice, "low_latency", DeviceAAudioOpen, DeviceAAudioClose, DeviceAAudioQueue, DeviceAAudioFreeBufferSlots, DeviceAAudioDeviceInfo, DeviceAAudioStart, DeviceAAudioStop);
+}
@@ -11,17 +11,20 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <algorithm>
 #include <dlib/hashtable.h>
 #include <dlib/index_pool.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
 #include <dlib/mutex.h>
+#include <dlib/memprofile.h>
 #include <dlib/profile.h>
 #include <dlib/thread.h>
 #include <dlib/time.h>
 
 #include "sound.h"
 #include "sound_codec.h"
+#include "sound_mix.h"
 #include "sound_private.h"
 
 #include <math.h>
@@ -39,14 +42,29 @@ namespace dmSound
     #define SOUND_MAX_MIX_CHANNELS (2)
     #define SOUND_OUTBUFFER_COUNT (6)
     #define SOUND_MAX_SPEED (5)
+    // Number of output buffers the decode-ahead buffers hold, at normal speed
+    #define SOUND_DECODE_AHEAD_BUFFER_COUNT (2 * SOUND_OUTBUFFER_COUNT)
 
     // TODO: How many bits?
     const uint32_t RESAMPLE_FRACTION_BITS = 31;
 
     const dmhash_t MASTER_GROUP_HASH = dmHashString64("master");
     const uint32_t GROUP_MEMORY_BUFFER_COUNT = 64;
+    // The spectrum is analyzed over the last SPECTRUM_FFT_SIZE frames, giving SPECTRUM_BIN_COUNT frequency bins
+    const uint32_t SPECTRUM_FFT_SIZE = 512;
+    const uint32_t SPECTRUM_BIN_COUNT = SPECTRUM_FFT_SIZE / 2;
+    // Number of mixed buffers the spectrum is kept up to date after it was last requested
+    const uint32_t SPECTRUM_ACTIVE_BUFFERS = 2 * GROUP_MEMORY_BUFFER_COUNT;
+    // Fewer mixed instances than this are mixed on the sound thread, the jobs cost more than they save
+    const uint32_t PARALLEL_MIX_MIN_INSTANCES = 8;
+
+    struct SoundSystem;
+    struct SoundInstance;
 
     static void SoundThread(void* ctx);
+    static void RenderCallback(int16_t* frames, uint32_t frame_count);
+    static void WaitDecodeAhead(SoundSystem* sound);
+    static void ResetInstanceDecoder(SoundSystem* sound, SoundInstance* instance);
 
     /**
      * Value with memory for "ramping" of values. See also struct Ramp below.
@@ -119,6 +137,11 @@ namespace dmSound
             float mix = i * m_TotalSamplesRecip;
             return m_From + mix * (m_To - m_From);
         }
+
+        inline bool IsConstant() const
+        {
+            return m_From == m_To;
+        }
     };
 
     /**
@@ -148,9 +171,14 @@ namespace dmSound
         dmhash_t      m_NameHash;
         void*         m_Data;
         int           m_Size;
+        // Set for streamed sound data, m_Data is 0
+        FSoundDataRead m_Read;
+        void*         m_ReadContext;
         // Index in m_SoundData
         uint16_t      m_Index;
         SoundDataType m_Type;
+        // m_Data is owned by the caller, see NewSoundDataExternal
+        bool          m_External;
     };
 
     struct SoundInstance
@@ -159,29 +187,56 @@ namespace dmSound
         void*       m_Frames;
         dmhash_t    m_Group;
 
+        // Ring buffer of decoded data, filled ahead of time by the decode jobs. See DecodeAhead()
+        char*       m_AheadBuffer;
+        uint32_t    m_AheadCapacity;
+        uint32_t    m_AheadStart;
+        uint32_t    m_AheadSize;
+        dmSoundCodec::Result m_AheadResult;
+
         Value       m_Gain;     // default: 1.0f
         Value       m_Pan;      // 0 = -45deg left, 1 = 45 deg right
         float       m_Speed;    // 1.0 = normal speed, 0.5 = half speed, 2.0 = double speed
+        float       m_AudibleGain; // Estimated gain of the voice this update, see UpdateVoices()
         uint32_t    m_FrameCount;
         uint64_t    m_FrameFraction;
 
         uint16_t    m_Index;
         uint16_t    m_SoundDataIndex;
+        uint8_t     m_Priority;
         uint8_t     m_Looping : 1;
         uint8_t     m_EndOfStream : 1;
         uint8_t     m_Playing : 1;
-        uint8_t     : 5;
+        uint8_t     m_AheadEndOfStream : 1;
+        uint8_t     m_Virtual : 1; // Not decoded or mixed, only the play position is advanced
+        uint8_t     : 3;
         int8_t      m_Loopcounter; // if set to 3, there will be 3 loops effectively playing the sound 4 times.
     };
 
+    // Created for a group the first time its spectrum is requested, see GetGroupSpectrum()
+    struct GroupSpectrum
+    {
+        // The last SPECTRUM_FFT_SIZE mono frames, m_HistoryPos is the oldest
+        float    m_History[SPECTRUM_FFT_SIZE];
+        uint32_t m_HistoryPos;
+        // Normalized so that a full scale sine gives 1.0 in its bin
+        float    m_Magnitudes[SPECTRUM_BIN_COUNT];
+        // Mixed buffers left until the analysis stops, unless requested again
+        uint32_t m_ActiveBuffers;
+    };
+
     struct SoundGroup
     {
         dmhash_t m_NameHash;
         Value    m_Gain;
         float*   m_MixBuffer;
-        float    m_SumSquaredMemory[SOUND_MAX_MIX_CHANNELS * GROUP_MEMORY_BUFFER_COUNT];
+        // Running sum of squares, m_SumSquaredPrefix holds the running sum after each buffer so that
+        // the sum over any window is a subtraction. Rebased each time the memory wraps to keep the precision
+        double   m_SumSquaredTotal[SOUND_MAX_MIX_CHANNELS];
+        double   m_SumSquaredPrefix[SOUND_MAX_MIX_CHANNELS * GROUP_MEMORY_BUFFER_COUNT];
         float    m_PeakMemorySq[SOUND_MAX_MIX_CHANNELS * GROUP_MEMORY_BUFFER_COUNT];
         int      m_NextMemorySlot;
+        GroupSpectrum* m_Spectrum;
     };
 
     struct SoundSystem
@@ -198,8 +253,27 @@ namespace dmSound
         dmArray<SoundData>      m_SoundData;
         dmIndexPool16           m_SoundDataPool;
 
+        dmJob::HContext         m_JobContext;
+        // The decode jobs started at the end of the last update, see StartDecodeAhead()
+        dmJob::HJob             m_DecodeAheadJob;
+        dmArray<uint16_t>       m_DecodeAheadInstances;
+        uint32_t                m_DecodeAheadSize;
+        uint32_t                m_StreamingThreshold;
+
+        // The active instances, sorted by importance when there are more than m_MaxRealVoices. See UpdateVoices()
+        dmArray<uint16_t>       m_Voices;
+        uint32_t                m_MaxRealVoices;
+
         dmHashTable<dmhash_t, int> m_GroupMap;
         SoundGroup              m_Groups[MAX_GROUPS];
+        // Tables for the spectrum analysis, see UpdateSpectrum()
+        float                   m_SpectrumWindow[SPECTRUM_FFT_SIZE];
+        float                   m_SpectrumCos[SPECTRUM_FFT_SIZE / 2];
+        float                   m_SpectrumSin[SPECTRUM_FFT_SIZE / 2];
+        // The instances to mix ordered by group, instances of group i are in [m_GroupInstanceStart[i], m_GroupInstanceStart[i+1]).
+        // The last range holds the instances without a group. See MixInstances()
+        dmArray<uint16_t>       m_GroupInstances;
+        uint16_t                m_GroupInstanceStart[MAX_GROUPS + 2];
 
         Result                  m_Status;
         uint32_t                m_MixRate;
@@ -208,7 +282,10 @@ namespace dmSound
 
         int16_t*                m_OutBuffers[SOUND_OUTBUFFER_COUNT];
         uint16_t                m_NextOutBuffer;
+        // Frames of the first out buffer already handed to the device, when the device pulls frames. See RenderCallback()
+        uint32_t                m_RenderFrame;
 
+        bool                    m_UseRenderCallback;
         bool                    m_IsDeviceStarted;
         bool                    m_IsPhoneCallActive;
         bool                    m_HasWindowFocus;
@@ -246,6 +323,10 @@ namespace dmSound
         params->m_BufferSize = 12 * 4096;
         params->m_FrameCount = 768;
         params->m_MaxInstances = 256;
+        params->m_MaxRealVoices = 32;
+        params->m_StreamingThreshold = 1024 * 1024;
+        params->m_DecodedCacheSize = 4 * 1024 * 1024;
+        params->m_DecodedCacheThreshold = 256 * 1024;
         params->m_UseThread = true;
     }
 
@@ -307,7 +388,26 @@ namespace dmSound
         device_params.m_BufferCount = SOUND_OUTBUFFER_COUNT;
         device_params.m_FrameCount = params->m_FrameCount;
         DeviceType* device_type;
-        r = OpenDevice(params->m_OutputDevice, &device_params, &device_type, &device);
+
+        bool low_latency = params->m_LowLatency;
+        if (config)
+        {
+            low_latency = dmConfigFile::GetInt(config, "sound.low_latency", low_latency ? 1 : 0) != 0;
+        }
+
+        r = RESULT_DEVICE_NOT_FOUND;
+        if (low_latency)
+        {
+            OpenDeviceParams render_params = device_params;
+            render_params.m_RenderCallback = RenderCallback;
+            r = OpenDevice("low_latency", &render_params, &device_type, &device);
+            if (r != RESULT_OK) {
+                dmLogWarning("No low latency sound device available, using '%s'", params->m_OutputDevice);
+            }
+        }
+        if (r != RESULT_OK) {
+            r = OpenDevice(params->m_OutputDevice, &device_params, &device_type, &device);
+        }
         if (r != RESULT_OK) {
             dmLogError("Failed to Open device '%s'", params->m_OutputDevice);
             return r;
@@ -316,6 +416,10 @@ namespace dmSound
         DeviceInfo device_info;
         device_type->m_DeviceInfo(device, &device_info);
 
+        // Devices that pull their frames are mixed for in buffers of their native size
+        bool use_render_callback = device_info.m_FrameCount > 0;
+        uint32_t frame_count = use_render_callback ? device_info.m_FrameCount : params->m_FrameCount;
+
         float master_gain = params->m_MasterGain;
 
         g_SoundSystem = new SoundSystem();
@@ -325,14 +429,15 @@ namespace dmSound
         sound->m_HasWindowFocus = true; // Assume we startup with the window focused
         sound->m_DeviceType = device_type;
         sound->m_Device = device;
-        dmSoundCodec::NewCodecContextParams codec_params;
-        codec_params.m_MaxDecoders = params->m_MaxInstances;
-        sound->m_CodecContext = dmSoundCodec::New(&codec_params);
-
+        sound->m_UseRenderCallback = use_render_callback;
         uint32_t max_sound_data = params->m_MaxSoundData;
         uint32_t max_buffers = params->m_MaxBuffers;
         uint32_t max_sources = params->m_MaxSources;
         uint32_t max_instances = params->m_MaxInstances;
+        uint32_t streaming_threshold = params->m_StreamingThreshold;
+        uint32_t max_real_voices = params->m_MaxRealVoices;
+        uint32_t decoded_cache_size = params->m_DecodedCacheSize;
+        uint32_t decoded_cache_threshold = params->m_DecodedCacheThreshold;
 
         if (config)
         {
@@ -341,6 +446,30 @@ namespace dmSound
             max_buffers = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_buffers", (int32_t) max_buffers);
             max_sources = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_sources", (int32_t) max_sources);
             max_instances = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_instances", (int32_t) max_instances);
+            streaming_threshold = (uint32_t) dmConfigFile::GetInt(config, "sound.stream_threshold", (int32_t) streaming_threshold);
+            max_real_voices = (uint32_t) dmConfigFile::GetInt(config, "sound.max_real_voices", (int32_t) max_real_voices);
+            decoded_cache_size = (uint32_t) dmConfigFile::GetInt(config, "sound.decoded_cache_size", (int32_t) decoded_cache_size);
+            decoded_cache_threshold = (uint32_t) dmConfigFile::GetInt(config, "sound.decoded_cache_threshold", (int32_t) decoded_cache_threshold);
+        }
+
+        dmSoundCodec::NewCodecContextParams codec_params;
+        codec_params.m_MaxDecoders = max_instances;
+        codec_params.m_DecodedCacheSize = decoded_cache_size;
+        codec_params.m_DecodedCacheThreshold = decoded_cache_threshold;
+        sound->m_CodecContext = dmSoundCodec::New(&codec_params);
+
+        sound->m_MaxRealVoices = max_real_voices;
+        sound->m_Voices.SetCapacity(max_instances);
+        sound->m_GroupInstances.SetCapacity(max_instances);
+
+        sound->m_StreamingThreshold = streaming_threshold;
+        // The device's audio thread can't wait for the decode jobs, so sounds are decoded while mixing instead
+        sound->m_JobContext = use_render_callback ? 0 : params->m_JobContext;
+        sound->m_DecodeAheadJob = dmJob::INVALID_JOB;
+        sound->m_DecodeAheadSize = frame_count * SOUND_DECODE_AHEAD_BUFFER_COUNT * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS;
+        if (sound->m_JobContext)
+        {
+            sound->m_DecodeAheadInstances.SetCapacity(max_instances);
         }
 
         sound->m_Instances.SetCapacity(max_instances);
@@ -354,7 +483,7 @@ namespace dmSound
             instance->m_SoundDataIndex = 0xffff;
             // NOTE: +1 for "over-fetch" when up-sampling
             // NOTE: and x SOUND_MAX_SPEED for potential pitch range
-            instance->m_Frames = malloc((params->m_FrameCount * SOUND_MAX_SPEED + 1) * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
+            instance->m_Frames = malloc((frame_count * SOUND_MAX_SPEED + 1) * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
             instance->m_FrameCount = 0;
             instance->m_Speed = 1.0f;
         }
@@ -364,21 +493,32 @@ namespace dmSound
         sound->m_SoundDataPool.SetCapacity(max_sound_data);
         for (uint32_t i = 0; i < max_sound_data; ++i)
         {
+            memset(&sound->m_SoundData[i], 0, sizeof(SoundData));
             sound->m_SoundData[i].m_Index = 0xffff;
         }
 
         sound->m_MixRate = device_info.m_MixRate;
-        sound->m_FrameCount = params->m_FrameCount;
+        sound->m_FrameCount = frame_count;
         for (int i = 0; i < SOUND_OUTBUFFER_COUNT; ++i) {
-            sound->m_OutBuffers[i] = (int16_t*) malloc(params->m_FrameCount * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
+            sound->m_OutBuffers[i] = (int16_t*) malloc(frame_count * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
         }
         sound->m_NextOutBuffer = 0;
+        sound->m_RenderFrame = frame_count;
 
         sound->m_GroupMap.SetCapacity(MAX_GROUPS * 2 + 1, MAX_GROUPS);
         for (uint32_t i = 0; i < MAX_GROUPS; ++i) {
             memset(&sound->m_Groups[i], 0, sizeof(SoundGroup));
         }
 
+        // Hann window and twiddle factors
+        for (uint32_t i = 0; i < SPECTRUM_FFT_SIZE; ++i) {
+            sound->m_SpectrumWindow[i] = 0.5f - 0.5f * cosf(2.0f * (float) M_PI * i / (float) SPECTRUM_FFT_SIZE);
+        }
+        for (uint32_t i = 0; i < SPECTRUM_FFT_SIZE / 2; ++i) {
+            sound->m_SpectrumCos[i] = cosf(2.0f * (float) M_PI * i / (float) SPECTRUM_FFT_SIZE);
+            sound->m_SpectrumSin[i] = -sinf(2.0f * (float) M_PI * i / (float) SPECTRUM_FFT_SIZE);
+        }
+
         int master_index = GetOrCreateGroup("master");
         SoundGroup* master = &sound->m_Groups[master_index];
         master->m_Gain.Reset(master_gain);
@@ -389,9 +529,12 @@ namespace dmSound
 
         sound->m_Thread = 0;
         sound->m_Mutex = 0;
-        if (params->m_UseThread)
+        if (params->m_UseThread || use_render_callback)
         {
             sound->m_Mutex = dmMutex::New();
+        }
+        if (params->m_UseThread)
+        {
             sound->m_Thread = dmThread::New((dmThread::ThreadStart)SoundThread, 0x80000, sound, "sound");
         }
 
@@ -408,6 +551,12 @@ namespace dmSound
         if (sound->m_Thread)
         {
             dmThread::Join(sound->m_Thread);
+        }
+
+        // Before anything is freed, devices that pull their frames mix from their own thread
+        sound->m_DeviceType->m_Close(sound->m_Device);
+        if (sound->m_Mutex)
+        {
             dmMutex::Delete(sound->m_Mutex);
         }
 
@@ -417,6 +566,7 @@ namespace dmSound
 
         if (sound)
         {
+            WaitDecodeAhead(sound);
             dmSoundCodec::Delete(sound->m_CodecContext);
 
             for (uint32_t i = 0; i < sound->m_Instances.Size(); ++i)
@@ -425,6 +575,7 @@ namespace dmSound
                 instance->m_Index = 0xffff;
                 instance->m_SoundDataIndex = 0xffff;
                 free(instance->m_Frames);
+                free(instance->m_AheadBuffer);
                 memset(instance, 0, sizeof(*instance));
             }
 
@@ -437,10 +588,9 @@ namespace dmSound
                 if (g->m_MixBuffer) {
                     free((void*) g->m_MixBuffer);
                 }
+                free(g->m_Spectrum);
             }
 
-            sound->m_DeviceType->m_Close(sound->m_Device);
-
             delete sound;
             g_SoundSystem = 0;
         }
@@ -457,7 +607,16 @@ namespace dmSound
 
     static Result SetSoundDataNoLock(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size)
     {
-        free(sound_data->m_Data);
+        // The decode jobs might be reading the data
+        WaitDecodeAhead(g_SoundSystem);
+
+        if (sound_data->m_Data)
+            dmSoundCodec::InvalidateCache(g_SoundSystem->m_CodecContext, sound_data->m_Data);
+        if (!sound_data->m_External)
+            free(sound_data->m_Data);
+        sound_data->m_Read = 0;
+        sound_data->m_ReadContext = 0;
+        sound_data->m_External = false;
         sound_data->m_Data = malloc(sound_buffer_size);
         sound_data->m_Size = sound_buffer_size;
         memcpy(sound_data->m_Data, sound_buffer, sound_buffer_size);
@@ -484,6 +643,7 @@ namespace dmSound
         sd->m_Index = index;
         sd->m_Data = 0;
         sd->m_Size = 0;
+        sd->m_External = false;
 
         Result result = SetSoundDataNoLock(sd, sound_buffer, sound_buffer_size);
         if (result == RESULT_OK)
@@ -494,6 +654,90 @@ namespace dmSound
         return result;
     }
 
+    static dmSoundCodec::Format GetCodecFormat(SoundDataType type)
+    {
+        if (type == SOUND_DATA_TYPE_WAV) {
+            return dmSoundCodec::FORMAT_WAV;
+        } else if (type == SOUND_DATA_TYPE_OGG_VORBIS) {
+            return dmSoundCodec::FORMAT_VORBIS;
+        }
+        assert(0);
+        return dmSoundCodec::FORMAT_WAV;
+    }
+
+    Result NewSoundDataStreaming(FSoundDataRead read, void* read_context, uint32_t size, SoundDataType type, HSoundData* sound_data, dmhash_t name)
+    {
+        SoundSystem* sound = g_SoundSystem;
+
+        if (!dmSoundCodec::IsStreamingSupported(GetCodecFormat(type)))
+        {
+            *sound_data = 0;
+            return RESULT_UNSUPPORTED;
+        }
+
+        if (sound->m_SoundDataPool.Remaining() == 0)
+        {
+            *sound_data = 0;
+            dmLogError("Out of sound data slots (%u). Increase the project setting 'sound.max_sound_data'", sound->m_SoundDataPool.Capacity());
+            return RESULT_OUT_OF_INSTANCES;
+        }
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
+
+        uint16_t index = sound->m_SoundDataPool.Pop();
+
+        SoundData* sd = &sound->m_SoundData[index];
+        sd->m_NameHash = name;
+        sd->m_Type = type;
+        sd->m_Index = index;
+        sd->m_Data = 0;
+        sd->m_Size = size;
+        sd->m_Read = read;
+        sd->m_ReadContext = read_context;
+        sd->m_External = false;
+
+        *sound_data = sd;
+        return RESULT_OK;
+    }
+
+    Result NewSoundDataExternal(const void* sound_buffer, uint32_t sound_buffer_size, SoundDataType type, HSoundData* sound_data, dmhash_t name)
+    {
+        SoundSystem* sound = g_SoundSystem;
+
+        if (sound->m_SoundDataPool.Remaining() == 0)
+        {
+            *sound_data = 0;
+            dmLogError("Out of sound data slots (%u). Increase the project setting 'sound.max_sound_data'", sound->m_SoundDataPool.Capacity());
+            return RESULT_OUT_OF_INSTANCES;
+        }
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
+
+        uint16_t index = sound->m_SoundDataPool.Pop();
+
+        SoundData* sd = &sound->m_SoundData[index];
+        sd->m_NameHash = name;
+        sd->m_Type = type;
+        sd->m_Index = index;
+        sd->m_Data = (void*) sound_buffer;
+        sd->m_Size = sound_buffer_size;
+        sd->m_Read = 0;
+        sd->m_ReadContext = 0;
+        sd->m_External = true;
+
+        *sound_data = sd;
+        return RESULT_OK;
+    }
+
+    void* GetSoundDataReadContext(HSoundData sound_data)
+    {
+        return sound_data->m_Read ? sound_data->m_ReadContext : 0;
+    }
+
+    uint32_t GetStreamingThreshold()
+    {
+        SoundSystem* sound = g_SoundSystem;
+        return sound ? sound->m_StreamingThreshold : 0;
+    }
+
     Result SetSoundData(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size)
     {
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
@@ -502,15 +746,26 @@ namespace dmSound
 
     uint32_t GetSoundResourceSize(HSoundData sound_data)
     {
-        return sound_data->m_Size + sizeof(SoundData);
+        uint32_t size = (sound_data->m_Read || sound_data->m_External) ? 0 : sound_data->m_Size;
+        return size + sizeof(SoundData);
     }
 
     Result DeleteSoundData(HSoundData sound_data)
     {
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
 
+        WaitDecodeAhead(g_SoundSystem);
+
         if (sound_data->m_Data != 0x0)
-            free((void*) sound_data->m_Data);
+        {
+            dmSoundCodec::InvalidateCache(g_SoundSystem->m_CodecContext, sound_data->m_Data);
+            if (!sound_data->m_External)
+                free((void*) sound_data->m_Data);
+        }
+        sound_data->m_Data = 0;
+        sound_data->m_Read = 0;
+        sound_data->m_ReadContext = 0;
+        sound_data->m_External = false;
 
         SoundSystem* sound = g_SoundSystem;
         sound->m_SoundDataPool.Push(sound_data->m_Index);
@@ -519,6 +774,18 @@ namespace dmSound
         return RESULT_OK;
     }
 
+    static dmSoundCodec::Result SoundDataStreamRead(void* context, uint32_t offset, void* buffer, uint32_t buffer_size, uint32_t* nread)
+    {
+        SoundData* sound_data = (SoundData*) context;
+        if (!sound_data->m_Read)
+        {
+            // The sound data was replaced with SetSoundData after the decoder was created
+            return dmSoundCodec::RESULT_DECODE_ERROR;
+        }
+        Result r = sound_data->m_Read(sound_data->m_ReadContext, offset, buffer, buffer_size, nread);
+        return r == RESULT_OK ? dmSoundCodec::RESULT_OK : dmSoundCodec::RESULT_DECODE_ERROR;
+    }
+
     Result NewSoundInstance(HSoundData sound_data, HSoundInstance* sound_instance)
     {
         SoundSystem* ss = g_SoundSystem;
@@ -532,20 +799,21 @@ namespace dmSound
 
         dmSoundCodec::HDecoder decoder;
 
-        dmSoundCodec::Format codec_format = dmSoundCodec::FORMAT_WAV;
-        if (sound_data->m_Type == SOUND_DATA_TYPE_WAV) {
-            codec_format = dmSoundCodec::FORMAT_WAV;
-        } else if (sound_data->m_Type == SOUND_DATA_TYPE_OGG_VORBIS) {
-            codec_format = dmSoundCodec::FORMAT_VORBIS;
-        } else {
-            assert(0);
-        }
+        dmSoundCodec::Format codec_format = GetCodecFormat(sound_data->m_Type);
 
         uint16_t index;
         {
             DM_MUTEX_OPTIONAL_SCOPED_LOCK(ss->m_Mutex);
 
-            dmSoundCodec::Result r = dmSoundCodec::NewDecoder(ss->m_CodecContext, codec_format, sound_data->m_Data, sound_data->m_Size, &decoder);
+            dmSoundCodec::Result r;
+            if (sound_data->m_Read)
+            {
+                r = dmSoundCodec::NewStreamingDecoder(ss->m_CodecContext, codec_format, SoundDataStreamRead, sound_data, sound_data->m_Size, &decoder);
+            }
+            else
+            {
+                r = dmSoundCodec::NewCachedDecoder(ss->m_CodecContext, codec_format, sound_data->m_Data, sound_data->m_Size, &decoder);
+            }
             if (r != dmSoundCodec::RESULT_OK) {
                 dmLogError("Failed to decode sound (%d)", r);
                 return RESULT_INVALID_STREAM_DATA;
@@ -564,9 +832,25 @@ namespace dmSound
         si->m_Looping = 0;
         si->m_EndOfStream = 0;
         si->m_Playing = 0;
+        si->m_Virtual = 0;
+        si->m_Priority = 0;
+        si->m_AudibleGain = 0.0f;
         si->m_Decoder = decoder;
         si->m_Group = MASTER_GROUP_HASH;
 
+        // Only compressed sounds are worth decoding ahead of time, the cached ones are already decoded
+        si->m_AheadBuffer = 0;
+        si->m_AheadCapacity = 0;
+        if (ss->m_JobContext && codec_format == dmSoundCodec::FORMAT_VORBIS && !dmSoundCodec::IsCachedDecoder(ss->m_CodecContext, decoder))
+        {
+            si->m_AheadBuffer = (char*) malloc(ss->m_DecodeAheadSize);
+            si->m_AheadCapacity = ss->m_DecodeAheadSize;
+        }
+        si->m_AheadStart = 0;
+        si->m_AheadSize = 0;
+        si->m_AheadResult = dmSoundCodec::RESULT_OK;
+        si->m_AheadEndOfStream = 0;
+
         *sound_instance = si;
 
         return RESULT_OK;
@@ -585,12 +869,18 @@ namespace dmSound
             StopNoLock(sound, sound_instance);
         }
 
+        WaitDecodeAhead(sound);
+
         uint16_t index = sound_instance->m_Index;
         sound->m_InstancesPool.Push(index);
         sound_instance->m_Index = 0xffff;
         sound_instance->m_SoundDataIndex = 0xffff;
         dmSoundCodec::DeleteDecoder(sound->m_CodecContext, sound_instance->m_Decoder);
         sound_instance->m_Decoder = 0;
+        free(sound_instance->m_AheadBuffer);
+        sound_instance->m_AheadBuffer = 0;
+        sound_instance->m_AheadCapacity = 0;
+        sound_instance->m_AheadSize = 0;
         sound_instance->m_FrameCount = 0;
         sound_instance->m_Speed = 1.0f;
 
@@ -688,6 +978,14 @@ namespace dmSound
         return RESULT_OK;
     }
 
+    // Number of mixed buffers covering a window in seconds, at least one
+    static uint32_t GetWindowBufferCount(SoundSystem* sound, float window)
+    {
+        uint32_t frames = (uint32_t) (sound->m_MixRate * dmMath::Max(0.0f, window));
+        uint32_t count = (frames + sound->m_FrameCount - 1) / sound->m_FrameCount;
+        return dmMath::Clamp(count, 1U, GROUP_MEMORY_BUFFER_COUNT - 1);
+    }
+
     Result GetGroupRMS(dmhash_t group_hash, float window, float* rms_left, float* rms_right)
     {
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
@@ -699,23 +997,14 @@ namespace dmSound
         }
 
         SoundGroup* g = &sound->m_Groups[*index];
-        uint32_t rms_frames = (uint32_t) (sound->m_MixRate * window);
-        int left = rms_frames;
-        int ss_index = (g->m_NextMemorySlot - 1) % GROUP_MEMORY_BUFFER_COUNT;
-        float sum_sq_left = 0;
-        float sum_sq_right = 0;
-        int count = 0;
-        while (left > 0) {
-            sum_sq_left += g->m_SumSquaredMemory[2 * ss_index + 0];
-            sum_sq_right += g->m_SumSquaredMemory[2 * ss_index + 1];
-
-            left -= sound->m_FrameCount;
-            ss_index = (ss_index - 1) % GROUP_MEMORY_BUFFER_COUNT;
-            count++;
-        }
+        uint32_t count = GetWindowBufferCount(sound, window);
+        // The running sum before the first buffer in the window
+        uint32_t start = (g->m_NextMemorySlot + GROUP_MEMORY_BUFFER_COUNT - 1 - count) % GROUP_MEMORY_BUFFER_COUNT;
+        double sum_sq_left = g->m_SumSquaredTotal[0] - g->m_SumSquaredPrefix[2 * start + 0];
+        double sum_sq_right = g->m_SumSquaredTotal[1] - g->m_SumSquaredPrefix[2 * start + 1];
 
-        *rms_left = sqrtf(sum_sq_left / (float) (count * sound->m_FrameCount)) / 32767.0f;
-        *rms_right = sqrtf(sum_sq_right / (float) (count * sound->m_FrameCount)) / 32767.0f;
+        *rms_left = sqrtf(dmMath::Max(0.0f, (float) sum_sq_left) / (float) (count * sound->m_FrameCount)) / 32767.0f;
+        *rms_right = sqrtf(dmMath::Max(0.0f, (float) sum_sq_right) / (float) (count * sound->m_FrameCount)) / 32767.0f;
 
         return RESULT_OK;
     }
@@ -731,19 +1020,14 @@ namespace dmSound
         }
 
         SoundGroup* g = &sound->m_Groups[*index];
-        uint32_t rms_frames = (uint32_t) (sound->m_MixRate * window);
-        int left = rms_frames;
-        int ss_index = (g->m_NextMemorySlot - 1) % GROUP_MEMORY_BUFFER_COUNT;
+        uint32_t count = GetWindowBufferCount(sound, window);
+        uint32_t ss_index = g->m_NextMemorySlot;
         float max_peak_left_sq = 0;
         float max_peak_right_sq = 0;
-        int count = 0;
-        while (left > 0) {
+        for (uint32_t i = 0; i < count; ++i) {
+            ss_index = (ss_index + GROUP_MEMORY_BUFFER_COUNT - 1) % GROUP_MEMORY_BUFFER_COUNT;
             max_peak_left_sq = dmMath::Max(max_peak_left_sq, g->m_PeakMemorySq[2 * ss_index + 0]);
             max_peak_right_sq = dmMath::Max(max_peak_right_sq, g->m_PeakMemorySq[2 * ss_index + 1]);
-
-            left -= sound->m_FrameCount;
-            ss_index = (ss_index - 1) % GROUP_MEMORY_BUFFER_COUNT;
-            count++;
         }
 
         *peak_left = sqrtf(max_peak_left_sq) / 32767.0f;
@@ -752,6 +1036,45 @@ namespace dmSound
         return RESULT_OK;
     }
 
+    Result GetGroupSpectrum(dmhash_t group_hash, float* bands, uint32_t band_count)
+    {
+        if (band_count == 0 || band_count > SPECTRUM_BIN_COUNT - 1) {
+            return RESULT_INVALID_PROPERTY;
+        }
+
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
+
+        SoundSystem* sound = g_SoundSystem;
+        int* index = sound->m_GroupMap.Get(group_hash);
+        if (!index) {
+            return RESULT_NO_SUCH_GROUP;
+        }
+
+        SoundGroup* g = &sound->m_Groups[*index];
+        if (!g->m_Spectrum) {
+            g->m_Spectrum = (GroupSpectrum*) calloc(1, sizeof(GroupSpectrum));
+            if (!g->m_Spectrum) {
+                return RESULT_OUT_OF_MEMORY;
+            }
+        }
+        GroupSpectrum* spectrum = g->m_Spectrum;
+        spectrum->m_ActiveBuffers = SPECTRUM_ACTIVE_BUFFERS;
+
+        // Logarithmically spaced bands over the bins, skipping the DC bin. Each band has at least one bin
+        uint32_t bin = 1;
+        for (uint32_t i = 0; i < band_count; ++i) {
+            uint32_t end = (uint32_t) powf((float) SPECTRUM_BIN_COUNT, (i + 1) / (float) band_count);
+            end = dmMath::Clamp(end, bin + 1, SPECTRUM_BIN_COUNT - (band_count - 1 - i));
+            float peak = 0.0f;
+            for (; bin < end; ++bin) {
+                peak = dmMath::Max(peak, spectrum->m_Magnitudes[bin]);
+            }
+            bands[i] = peak;
+        }
+
+        return RESULT_OK;
+    }
+
     Result Play(HSoundInstance sound_instance)
     {
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
@@ -763,7 +1086,8 @@ namespace dmSound
     {
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
         sound_instance->m_Playing = 0;
-        dmSoundCodec::Reset(sound->m_CodecContext, sound_instance->m_Decoder);
+        WaitDecodeAhead(sound);
+        ResetInstanceDecoder(sound, sound_instance);
     }
 
     Result Stop(HSoundInstance sound_instance)
@@ -796,6 +1120,11 @@ namespace dmSound
         return sound_instance->m_Playing; // && !sound_instance->m_EndOfStream;
     }
 
+    bool IsVirtual(HSoundInstance sound_instance)
+    {
+        return sound_instance->m_Virtual;
+    }
+
     Result SetLooping(HSoundInstance sound_instance, bool looping, int8_t loopcounter)
     {
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
@@ -822,6 +1151,9 @@ namespace dmSound
             case PARAMETER_SPEED:
                 sound_instance->m_Speed = dmMath::Max(0.0f, dmMath::Min((float)SOUND_MAX_SPEED, value.getX()));
                 break;
+            case PARAMETER_PRIORITY:
+                sound_instance->m_Priority = (uint8_t) dmMath::Clamp(value.getX(), 0.0f, 255.0f);
+                break;
             default:
                 dmLogError("Invalid parameter: %d (%s)\n", parameter, GetSoundName(g_SoundSystem, sound_instance));
                 return RESULT_INVALID_PROPERTY;
@@ -865,18 +1197,25 @@ namespace dmSound
 
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
+
+        // The pan is usually constant, and then the (expensive) pan scale is the same for all samples
+        const bool pan_constant = pan_ramp.IsConstant();
+        float left_scale, right_scale;
+        GetPanScale(pan_ramp.m_From, &left_scale, &right_scale);
+
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
             float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
             float mix = frac * range_recip; // determines the bias between two consecutive samples in the sound instance. It ranges from 0-1. A mix of 0, makes only the first sample count while a mix of 0.5 will count equally both samples.
             T s1 = frames[index];
             T s2 = frames[index + 1];
             s1 = (s1 - offset) * scale;
             s2 = (s2 - offset) * scale;
 
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
+            if (!pan_constant)
+            {
+                GetPanScale(pan_ramp.GetValue(i), &left_scale, &right_scale);
+            }
 
             float s = (1.0f - mix) * s1 + mix * s2; // resulting destination sample value is a mix of two source samples since a kind of fractional indexing is used
             mix_buffer[2 * i] += s * gain * left_scale;
@@ -920,10 +1259,15 @@ namespace dmSound
 
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
+
+        // The pan is usually constant, and then the (expensive) pan scale is the same for all samples
+        const bool pan_constant = pan_ramp.IsConstant();
+        float left_scale, right_scale;
+        GetPanScale(pan_ramp.m_From, &left_scale, &right_scale);
+
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
             float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
             float mix = frac * range_recip;
             T sl1 = frames[2 * index];
             T sl2 = frames[2 * index + 2];
@@ -935,8 +1279,10 @@ namespace dmSound
             sr1 = (sr1 - offset) * scale;
             sr2 = (sr2 - offset) * scale;
 
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
+            if (!pan_constant)
+            {
+                GetPanScale(pan_ramp.GetValue(i), &left_scale, &right_scale);
+            }
 
             float sl = (1.0f - mix) * sl1 + mix * sl2;
             float sr = (1.0f - mix) * sr1 + mix * sr2;
@@ -967,6 +1313,15 @@ namespace dmSound
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
 
+        if (sizeof(T) == sizeof(int16_t) && pan_ramp.IsConstant())
+        {
+            float left_scale, right_scale;
+            GetPanScale(pan_ramp.m_From, &left_scale, &right_scale);
+            MixMono16((const int16_t*) frames, mix_buffer_count, gain_ramp.m_From, gain_ramp.m_To, gain_ramp.m_TotalSamplesRecip, left_scale, right_scale, mix_buffer);
+            instance->m_FrameCount -= mix_buffer_count;
+            return;
+        }
+
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
             float gain = gain_ramp.GetValue(i);
@@ -992,6 +1347,15 @@ namespace dmSound
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
 
+        if (sizeof(T) == sizeof(int16_t) && pan_ramp.IsConstant())
+        {
+            float left_scale, right_scale;
+            GetPanScale(pan_ramp.m_From, &left_scale, &right_scale);
+            MixStereo16((const int16_t*) frames, mix_buffer_count, gain_ramp.m_From, gain_ramp.m_To, gain_ramp.m_TotalSamplesRecip, left_scale, right_scale, mix_buffer);
+            instance->m_FrameCount -= mix_buffer_count;
+            return;
+        }
+
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
             float gain = gain_ramp.GetValue(i);
@@ -1090,6 +1454,142 @@ namespace dmSound
         }
     }
 
+    // Waits for the decode jobs to finish. Must be called with the mutex held, before touching
+    // the decoders, the decode-ahead buffers or the sound data
+    static void WaitDecodeAhead(SoundSystem* sound)
+    {
+        if (sound->m_DecodeAheadJob != dmJob::INVALID_JOB)
+        {
+            DM_PROFILE(Sound, "WaitDecodeAhead");
+            dmJob::Wait(sound->m_JobContext, sound->m_DecodeAheadJob);
+            sound->m_DecodeAheadJob = dmJob::INVALID_JOB;
+        }
+    }
+
+    // Fills the decode-ahead buffer of an instance. Runs on the job threads
+    static void DecodeAhead(SoundSystem* sound, SoundInstance* instance)
+    {
+        DM_PROFILE(Sound, "DecodeAhead");
+
+        dmSoundCodec::Info info;
+        dmSoundCodec::GetInfo(sound->m_CodecContext, instance->m_Decoder, &info);
+        const uint32_t stride = info.m_Channels * (info.m_BitsPerSample / 8);
+        if (stride == 0 || instance->m_AheadCapacity % stride != 0)
+        {
+            // Unsupported format, reported when mixing
+            return;
+        }
+
+        while (instance->m_AheadResult == dmSoundCodec::RESULT_OK && !instance->m_AheadEndOfStream && instance->m_AheadSize < instance->m_AheadCapacity)
+        {
+            uint32_t end = (instance->m_AheadStart + instance->m_AheadSize) % instance->m_AheadCapacity;
+            uint32_t n = dmMath::Min(instance->m_AheadCapacity - instance->m_AheadSize, instance->m_AheadCapacity - end);
+            uint32_t decoded = 0;
+            instance->m_AheadResult = dmSoundCodec::Decode(sound->m_CodecContext, instance->m_Decoder, instance->m_AheadBuffer + end, n, &decoded);
+            instance->m_AheadSize += decoded;
+            if (decoded < n)
+            {
+                instance->m_AheadEndOfStream = 1;
+            }
+        }
+    }
+
+    static void DecodeAheadRange(void* context, uint32_t start, uint32_t end)
+    {
+        SoundSystem* sound = (SoundSystem*) context;
+        for (uint32_t i = start; i < end; ++i)
+        {
+            DecodeAhead(sound, &sound->m_Instances[sound->m_DecodeAheadInstances[i]]);
+        }
+    }
+
+    // Moves up to size bytes out of the decode-ahead buffer. The data is discarded if buffer is 0
+    static uint32_t ConsumeAhead(SoundInstance* instance, char* buffer, uint32_t size)
+    {
+        uint32_t total = dmMath::Min(size, instance->m_AheadSize);
+        uint32_t consumed = 0;
+        while (consumed < total)
+        {
+            uint32_t n = dmMath::Min(total - consumed, instance->m_AheadCapacity - instance->m_AheadStart);
+            if (buffer)
+            {
+                memcpy(buffer + consumed, instance->m_AheadBuffer + instance->m_AheadStart, n);
+            }
+            instance->m_AheadStart = (instance->m_AheadStart + n) % instance->m_AheadCapacity;
+            instance->m_AheadSize -= n;
+            consumed += n;
+        }
+        return consumed;
+    }
+
+    // Decodes through the decode-ahead buffer, if the instance has one. If the decode jobs didn't keep up,
+    // the rest is decoded right away
+    static dmSoundCodec::Result DecodeInstance(SoundSystem* sound, SoundInstance* instance, char* buffer, uint32_t buffer_size, uint32_t* decoded)
+    {
+        if (!instance->m_AheadBuffer)
+        {
+            return dmSoundCodec::Decode(sound->m_CodecContext, instance->m_Decoder, buffer, buffer_size, decoded);
+        }
+
+        uint32_t n = ConsumeAhead(instance, buffer, buffer_size);
+        *decoded = n;
+        if (n == buffer_size || instance->m_AheadEndOfStream)
+        {
+            return dmSoundCodec::RESULT_OK;
+        }
+        if (instance->m_AheadResult != dmSoundCodec::RESULT_OK)
+        {
+            return instance->m_AheadResult;
+        }
+
+        DM_PROFILE(Sound, "DecodeAheadMiss");
+        uint32_t rest = 0;
+        dmSoundCodec::Result r = dmSoundCodec::Decode(sound->m_CodecContext, instance->m_Decoder, buffer + n, buffer_size - n, &rest);
+        *decoded += rest;
+        if (rest < buffer_size - n)
+        {
+            instance->m_AheadEndOfStream = 1;
+        }
+        return r;
+    }
+
+    static dmSoundCodec::Result SkipInstance(SoundSystem* sound, SoundInstance* instance, uint32_t bytes, uint32_t* skipped)
+    {
+        if (!instance->m_AheadBuffer)
+        {
+            return dmSoundCodec::Skip(sound->m_CodecContext, instance->m_Decoder, bytes, skipped);
+        }
+
+        uint32_t n = ConsumeAhead(instance, 0, bytes);
+        *skipped = n;
+        if (n == bytes || instance->m_AheadEndOfStream)
+        {
+            return dmSoundCodec::RESULT_OK;
+        }
+        if (instance->m_AheadResult != dmSoundCodec::RESULT_OK)
+        {
+            return instance->m_AheadResult;
+        }
+
+        uint32_t rest = 0;
+        dmSoundCodec::Result r = dmSoundCodec::Skip(sound->m_CodecContext, instance->m_Decoder, bytes - n, &rest);
+        *skipped += rest;
+        if (rest < bytes - n)
+        {
+            instance->m_AheadEndOfStream = 1;
+        }
+        return r;
+    }
+
+    static void ResetInstanceDecoder(SoundSystem* sound, SoundInstance* instance)
+    {
+        dmSoundCodec::Reset(sound->m_CodecContext, instance->m_Decoder);
+        instance->m_AheadStart = 0;
+        instance->m_AheadSize = 0;
+        instance->m_AheadResult = dmSoundCodec::RESULT_OK;
+        instance->m_AheadEndOfStream = 0;
+    }
+
     static bool IsMuted(SoundInstance* instance) {
         SoundSystem* sound = g_SoundSystem;
 
@@ -1120,6 +1620,53 @@ namespace dmSound
         return false;
     }
 
+    // Advances a virtual voice as far as mixing it would have, without decoding it
+    static void SkipVirtualInstance(SoundSystem* sound, SoundInstance* instance, const dmSoundCodec::Info* info)
+    {
+        DM_PROFILE(Sound, "SkipVirtual");
+
+        // The same stepping as in MixResampleUp*()
+        uint64_t delta = (((uint64_t) info->m_Rate) << RESAMPLE_FRACTION_BITS) / sound->m_MixRate;
+        delta *= instance->m_Speed;
+        uint64_t frac = instance->m_FrameFraction + delta * sound->m_FrameCount;
+        uint32_t n = (uint32_t) (frac >> RESAMPLE_FRACTION_BITS);
+        instance->m_FrameFraction = frac & ((1U << RESAMPLE_FRACTION_BITS) - 1U);
+
+        // Drop what is already decoded, it is out of date when the voice becomes real again
+        n -= dmMath::Min(n, instance->m_FrameCount);
+        instance->m_FrameCount = 0;
+
+        if (!instance->m_Playing || n == 0)
+        {
+            return;
+        }
+
+        const uint32_t stride = info->m_Channels * (info->m_BitsPerSample / 8);
+        uint32_t skipped = 0;
+        dmSoundCodec::Result r = SkipInstance(sound, instance, n * stride, &skipped);
+        if (r == dmSoundCodec::RESULT_OK && skipped < n * stride)
+        {
+            if (instance->m_Looping && instance->m_Loopcounter != 0)
+            {
+                ResetInstanceDecoder(sound, instance);
+                if (instance->m_Loopcounter > 0) {
+                    instance->m_Loopcounter--;
+                }
+                uint32_t rest = n * stride - skipped;
+                r = SkipInstance(sound, instance, rest, &skipped);
+            }
+            else
+            {
+                instance->m_EndOfStream = 1;
+            }
+        }
+
+        if (r != dmSoundCodec::RESULT_OK) {
+            dmLogWarning("Unable to decode file '%s'. Result %d", GetSoundName(sound, instance), r);
+            instance->m_Playing = 0;
+        }
+    }
+
     static void MixInstance(const MixContext* mix_context, SoundInstance* instance) {
         SoundSystem* sound = g_SoundSystem;
         uint32_t decoded = 0;
@@ -1140,6 +1687,12 @@ namespace dmSound
             return;
         }
 
+        if (instance->m_Virtual)
+        {
+            SkipVirtualInstance(sound, instance, &info);
+            return;
+        }
+
         bool is_muted = dmSound::IsMuted(instance);
 
         dmSoundCodec::Result r = dmSoundCodec::RESULT_OK;
@@ -1152,15 +1705,15 @@ namespace dmSound
 
             if (!is_muted)
             {
-                r = dmSoundCodec::Decode(sound->m_CodecContext,
-                                         instance->m_Decoder,
-                                         ((char*) instance->m_Frames) + instance->m_FrameCount * stride,
-                                         n * stride,
-                                         &decoded);
+                r = DecodeInstance(sound,
+                                   instance,
+                                   ((char*) instance->m_Frames) + instance->m_FrameCount * stride,
+                                   n * stride,
+                                   &decoded);
             }
             else
             {
-                r = dmSoundCodec::Skip(sound->m_CodecContext, instance->m_Decoder, n * stride, &decoded);
+                r = SkipInstance(sound, instance, n * stride, &decoded);
                 memset(((char*) instance->m_Frames) + instance->m_FrameCount * stride, 0x00, n * stride);
             }
 
@@ -1170,7 +1723,7 @@ namespace dmSound
             if (instance->m_FrameCount < mixed_instance_FrameCount) {
 
                 if (instance->m_Looping && instance->m_Loopcounter != 0) {
-                    dmSoundCodec::Reset(sound->m_CodecContext, instance->m_Decoder);
+                    ResetInstanceDecoder(sound, instance);
                     if ( instance->m_Loopcounter > 0 ) {
                         instance->m_Loopcounter --;
                     }
@@ -1178,15 +1731,15 @@ namespace dmSound
                     uint32_t n = mixed_instance_FrameCount - instance->m_FrameCount;
                     if (!is_muted)
                     {
-                        r = dmSoundCodec::Decode(sound->m_CodecContext,
-                                                 instance->m_Decoder,
-                                                 ((char*) instance->m_Frames) + instance->m_FrameCount * stride,
-                                                 n * stride,
-                                                 &decoded);
+                        r = DecodeInstance(sound,
+                                           instance,
+                                           ((char*) instance->m_Frames) + instance->m_FrameCount * stride,
+                                           n * stride,
+                                           &decoded);
                     }
                     else
                     {
-                        r = dmSoundCodec::Skip(sound->m_CodecContext, instance->m_Decoder, n * stride, &decoded);
+                        r = SkipInstance(sound, instance, n * stride, &decoded);
                         memset(((char*) instance->m_Frames) + instance->m_FrameCount * stride, 0x00, n * stride);
                     }
 
@@ -1222,54 +1775,193 @@ namespace dmSound
         }
     }
 
-    static void MixInstances(const MixContext* mix_context) {
-        DM_PROFILE(Sound, "MixInstances")
-        SoundSystem* sound = g_SoundSystem;
-
-        for (uint32_t i = 0; i < MAX_GROUPS; i++) {
-            SoundGroup* g = &sound->m_Groups[i];
+    // In place radix-2 FFT of SPECTRUM_FFT_SIZE complex values
+    static void FFT(SoundSystem* sound, float* re, float* im)
+    {
+        const uint32_t n = SPECTRUM_FFT_SIZE;
+        for (uint32_t i = 1, j = 0; i < n; ++i) {
+            uint32_t bit = n >> 1;
+            for (; j & bit; bit >>= 1) {
+                j ^= bit;
+            }
+            j ^= bit;
+            if (i < j) {
+                float t = re[i]; re[i] = re[j]; re[j] = t;
+                t = im[i]; im[i] = im[j]; im[j] = t;
+            }
+        }
 
-            if (g->m_MixBuffer) {
-                uint32_t frame_count = sound->m_FrameCount;
-                float sum_sq_left = 0;
-                float sum_sq_right = 0;
-                float max_sq_left = 0;
-                float max_sq_right = 0;
-                for (uint32_t j = 0; j < frame_count; j++) {
-
-                    float gain = g->m_Gain.m_Current;
-
-                    float left = g->m_MixBuffer[2 * j + 0] * gain;
-                    float right = g->m_MixBuffer[2 * j + 1] * gain;
-                    float left_sq = left * left;
-                    float right_sq = right * right;
-                    sum_sq_left += left_sq;
-                    sum_sq_right += right_sq;
-                    max_sq_left = dmMath::Max(max_sq_left, left_sq);
-                    max_sq_right = dmMath::Max(max_sq_right, right_sq);
+        for (uint32_t len = 2; len <= n; len <<= 1) {
+            uint32_t half = len >> 1;
+            uint32_t step = n / len;
+            for (uint32_t i = 0; i < n; i += len) {
+                for (uint32_t k = 0; k < half; ++k) {
+                    float wr = sound->m_SpectrumCos[k * step];
+                    float wi = sound->m_SpectrumSin[k * step];
+                    uint32_t a = i + k;
+                    uint32_t b = a + half;
+                    float tr = re[b] * wr - im[b] * wi;
+                    float ti = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
                 }
-                g->m_SumSquaredMemory[2 * g->m_NextMemorySlot + 0] = sum_sq_left;
-                g->m_SumSquaredMemory[2 * g->m_NextMemorySlot + 1] = sum_sq_right;
-                g->m_PeakMemorySq[2 * g->m_NextMemorySlot + 0] = max_sq_left;
-                g->m_PeakMemorySq[2 * g->m_NextMemorySlot + 1] = max_sq_right;
-                g->m_NextMemorySlot = (g->m_NextMemorySlot + 1) % GROUP_MEMORY_BUFFER_COUNT;
+            }
+        }
+    }
+
+    // Adds the last mixed buffer to the spectrum history and analyzes it. Only runs while the spectrum is requested
+    static void UpdateSpectrum(SoundSystem* sound, SoundGroup* g)
+    {
+        DM_PROFILE(Sound, "Spectrum");
+
+        GroupSpectrum* spectrum = g->m_Spectrum;
+        spectrum->m_ActiveBuffers--;
+
+        float gain = g->m_Gain.m_Current * 0.5f;
+        uint32_t frame_count = sound->m_FrameCount;
+        uint32_t first = frame_count > SPECTRUM_FFT_SIZE ? frame_count - SPECTRUM_FFT_SIZE : 0;
+        for (uint32_t i = first; i < frame_count; ++i) {
+            spectrum->m_History[spectrum->m_HistoryPos] = (g->m_MixBuffer[2 * i] + g->m_MixBuffer[2 * i + 1]) * gain;
+            spectrum->m_HistoryPos = (spectrum->m_HistoryPos + 1) % SPECTRUM_FFT_SIZE;
+        }
+
+        float re[SPECTRUM_FFT_SIZE];
+        float im[SPECTRUM_FFT_SIZE];
+        for (uint32_t i = 0; i < SPECTRUM_FFT_SIZE; ++i) {
+            re[i] = spectrum->m_History[(spectrum->m_HistoryPos + i) % SPECTRUM_FFT_SIZE] * sound->m_SpectrumWindow[i];
+            im[i] = 0.0f;
+        }
+        FFT(sound, re, im);
+
+        // One sided spectrum, compensated for the gain of the Hann window
+        const float scale = 4.0f / (SPECTRUM_FFT_SIZE * 32767.0f);
+        for (uint32_t i = 0; i < SPECTRUM_BIN_COUNT; ++i) {
+            spectrum->m_Magnitudes[i] = sqrtf(re[i] * re[i] + im[i] * im[i]) * scale;
+        }
+    }
+
+    // Updates the meters of a group from the last mixed buffer and clears its mix buffer
+    static void ResetGroupMixBuffer(SoundSystem* sound, SoundGroup* g)
+    {
+        float sum_sq[SOUND_MAX_MIX_CHANNELS];
+        float peak_sq[SOUND_MAX_MIX_CHANNELS];
+        SumSquaresAndPeak(g->m_MixBuffer, sound->m_FrameCount, g->m_Gain.m_Current, sum_sq, peak_sq);
+
+        int slot = g->m_NextMemorySlot;
+        g->m_SumSquaredTotal[0] += sum_sq[0];
+        g->m_SumSquaredTotal[1] += sum_sq[1];
+        g->m_SumSquaredPrefix[2 * slot + 0] = g->m_SumSquaredTotal[0];
+        g->m_SumSquaredPrefix[2 * slot + 1] = g->m_SumSquaredTotal[1];
+        g->m_PeakMemorySq[2 * slot + 0] = peak_sq[0];
+        g->m_PeakMemorySq[2 * slot + 1] = peak_sq[1];
+        g->m_NextMemorySlot = (slot + 1) % GROUP_MEMORY_BUFFER_COUNT;
+
+        if (g->m_NextMemorySlot == 0) {
+            // Only differences of the running sums are used, so subtracting the same base keeps them valid
+            double base_left = g->m_SumSquaredPrefix[0];
+            double base_right = g->m_SumSquaredPrefix[1];
+            for (uint32_t i = 0; i < GROUP_MEMORY_BUFFER_COUNT; ++i) {
+                g->m_SumSquaredPrefix[2 * i + 0] -= base_left;
+                g->m_SumSquaredPrefix[2 * i + 1] -= base_right;
+            }
+            g->m_SumSquaredTotal[0] -= base_left;
+            g->m_SumSquaredTotal[1] -= base_right;
+        }
+
+        if (g->m_Spectrum && g->m_Spectrum->m_ActiveBuffers > 0) {
+            UpdateSpectrum(sound, g);
+        }
+
+        memset(g->m_MixBuffer, 0, sound->m_FrameCount * sizeof(float) * 2);
+    }
+
+    struct MixGroupsContext
+    {
+        SoundSystem*        m_Sound;
+        const MixContext*   m_MixContext;
+    };
+
+    // Mixes all instances of a range of groups. Each group only touches its own mix buffer and its own
+    // instances, so the groups can be mixed in parallel on the job threads
+    static void MixGroupRange(void* context, uint32_t start, uint32_t end)
+    {
+        DM_PROFILE(Sound, "MixGroup");
+        MixGroupsContext* ctx = (MixGroupsContext*) context;
+        SoundSystem* sound = ctx->m_Sound;
+
+        for (uint32_t group = start; group < end; ++group)
+        {
+            if (group < MAX_GROUPS && sound->m_Groups[group].m_MixBuffer)
+            {
+                ResetGroupMixBuffer(sound, &sound->m_Groups[group]);
+            }
+
+            for (uint32_t i = sound->m_GroupInstanceStart[group]; i < sound->m_GroupInstanceStart[group + 1]; ++i)
+            {
+                SoundInstance* instance = &sound->m_Instances[sound->m_GroupInstances[i]];
+                MixInstance(ctx->m_MixContext, instance);
 
-                memset(g->m_MixBuffer, 0, sound->m_FrameCount * sizeof(float) * 2);
+                if (instance->m_EndOfStream && instance->m_FrameCount == 0) {
+                    instance->m_Playing = 0;
+                }
             }
         }
+    }
+
+    static void MixInstances(const MixContext* mix_context) {
+        DM_PROFILE(Sound, "MixInstances")
+        SoundSystem* sound = g_SoundSystem;
+
+        // Sort the instances to mix by group, with a counting sort
+        uint16_t* start = sound->m_GroupInstanceStart;
+        memset(start, 0, sizeof(sound->m_GroupInstanceStart));
 
         uint32_t instances = sound->m_Instances.Size();
         for (uint32_t i = 0; i < instances; ++i) {
             SoundInstance* instance = &sound->m_Instances[i];
             if (instance->m_Playing || instance->m_FrameCount > 0)
             {
-                MixInstance(mix_context, instance);
+                int* index = sound->m_GroupMap.Get(instance->m_Group);
+                start[(index ? *index : MAX_GROUPS) + 1]++;
             }
+        }
+
+        uint32_t mixed_groups = 0;
+        for (uint32_t i = 0; i < MAX_GROUPS + 1; ++i) {
+            mixed_groups += start[i + 1] > 0 ? 1 : 0;
+            start[i + 1] += start[i];
+        }
 
-            if (instance->m_EndOfStream && instance->m_FrameCount == 0) {
-                instance->m_Playing = 0;
+        uint32_t mix_count = start[MAX_GROUPS + 1];
+        sound->m_GroupInstances.SetSize(mix_count);
+        uint16_t next[MAX_GROUPS + 1];
+        memcpy(next, start, sizeof(next));
+        for (uint32_t i = 0; i < instances; ++i) {
+            SoundInstance* instance = &sound->m_Instances[i];
+            if (instance->m_Playing || instance->m_FrameCount > 0)
+            {
+                int* index = sound->m_GroupMap.Get(instance->m_Group);
+                sound->m_GroupInstances[next[index ? *index : MAX_GROUPS]++] = (uint16_t) i;
             }
         }
+
+        MixGroupsContext ctx;
+        ctx.m_Sound = sound;
+        ctx.m_MixContext = mix_context;
+
+        // ParallelFor() mixes everything right away when there is no job context
+        dmJob::HContext job_context = 0;
+        if (mixed_groups > 1 && mix_count >= PARALLEL_MIX_MIN_INSTANCES)
+        {
+            job_context = sound->m_JobContext;
+        }
+        dmJob::HJob job = dmJob::ParallelFor(job_context, MixGroupRange, &ctx, MAX_GROUPS + 1, 1, dmJob::INVALID_JOB);
+        if (job != dmJob::INVALID_JOB)
+        {
+            dmJob::Wait(sound->m_JobContext, job);
+        }
     }
 
     static void Master(const MixContext* mix_context) {
@@ -1303,28 +1995,116 @@ namespace dmSound
                 continue;
             }
             Ramp ramp = GetRamp(mix_context, &g->m_Gain, n);
-            for (uint32_t i = 0; i < n; i++) {
-                float gain = ramp.GetValue(i);
-                gain = dmMath::Clamp(gain, 0.0f, 1.0f);
+            MixGroup(g->m_MixBuffer, n, ramp.m_From, ramp.m_To, ramp.m_TotalSamplesRecip, mix_buffer);
+        }
+
+        Ramp ramp = GetRamp(mix_context, &master->m_Gain, n);
+        MixMaster(mix_buffer, n, ramp.m_From, ramp.m_To, ramp.m_TotalSamplesRecip, out);
+    }
 
-                float s1 = g->m_MixBuffer[2 * i];
-                float s2 = g->m_MixBuffer[2 * i + 1];
-                mix_buffer[2 * i] += s1 * gain;
-                mix_buffer[2 * i + 1] += s2 * gain;
+    // Starts jobs that fill the decode-ahead buffers, so that they are ready for the next update
+    static void StartDecodeAhead(SoundSystem* sound)
+    {
+        if (!sound->m_JobContext)
+        {
+            return;
+        }
+
+        DM_PROFILE(Sound, "StartDecodeAhead");
+        sound->m_DecodeAheadInstances.SetSize(0);
+        uint32_t instances = sound->m_Instances.Size();
+        for (uint32_t i = 0; i < instances; ++i) {
+            SoundInstance* instance = &sound->m_Instances[i];
+            if (instance->m_AheadBuffer && instance->m_Playing && !instance->m_Virtual && !instance->m_AheadEndOfStream &&
+                instance->m_AheadResult == dmSoundCodec::RESULT_OK && instance->m_AheadSize < instance->m_AheadCapacity &&
+                !IsMuted(instance))
+            {
+                sound->m_DecodeAheadInstances.Push((uint16_t) i);
             }
         }
 
-        Ramp ramp = GetRamp(mix_context, &master->m_Gain, n);
-        for (uint32_t i = 0; i < n; i++) {
-            float gain = ramp.GetValue(i);
-            float s1 = mix_buffer[2 * i] * gain;
-            float s2 = mix_buffer[2 * i + 1] * gain;
-            s1 = dmMath::Min(32767.0f, s1);
-            s1 = dmMath::Max(-32768.0f, s1);
-            s2 = dmMath::Min(32767.0f, s2);
-            s2 = dmMath::Max(-32768.0f, s2);
-            out[2 * i] = (int16_t) s1;
-            out[2 * i + 1] = (int16_t) s2;
+        if (!sound->m_DecodeAheadInstances.Empty())
+        {
+            sound->m_DecodeAheadJob = dmJob::ParallelFor(sound->m_JobContext, DecodeAheadRange, sound, sound->m_DecodeAheadInstances.Size(), 1, dmJob::INVALID_JOB);
+        }
+    }
+
+    static float GetAudibleGain(SoundSystem* sound, SoundInstance* instance)
+    {
+        if (IsMuted(instance))
+        {
+            return 0.0f;
+        }
+
+        // The gains ramp from the previous to the current value during the update. The master gain is the same for all voices
+        float gain = dmMath::Max(instance->m_Gain.m_Prev, instance->m_Gain.m_Current);
+        int* group_index = sound->m_GroupMap.Get(instance->m_Group);
+        if (group_index != NULL)
+        {
+            const Value& group_gain = sound->m_Groups[*group_index].m_Gain;
+            gain *= dmMath::Max(group_gain.m_Prev, group_gain.m_Current);
+        }
+        return gain;
+    }
+
+    struct VoicePred
+    {
+        const SoundInstance* m_Instances;
+
+        bool operator()(uint16_t a, uint16_t b) const
+        {
+            const SoundInstance& ia = m_Instances[a];
+            const SoundInstance& ib = m_Instances[b];
+            if (ia.m_Priority != ib.m_Priority)
+                return ia.m_Priority > ib.m_Priority;
+            if (ia.m_AudibleGain != ib.m_AudibleGain)
+                return ia.m_AudibleGain > ib.m_AudibleGain;
+            // Prefer the voices that are already real, so that equal voices don't swap back and forth
+            if (ia.m_Virtual != ib.m_Virtual)
+                return !ia.m_Virtual;
+            return a < b;
+        }
+    };
+
+    // Decides which voices to mix this update. Inaudible voices are always virtual. If there are more than
+    // m_MaxRealVoices audible voices, the ones with the highest priority, and then the highest gain, are mixed
+    static void UpdateVoices(SoundSystem* sound)
+    {
+        DM_PROFILE(Sound, "UpdateVoices");
+
+        sound->m_Voices.SetSize(0);
+        uint32_t instances = sound->m_Instances.Size();
+        for (uint32_t i = 0; i < instances; ++i) {
+            SoundInstance* instance = &sound->m_Instances[i];
+            if (instance->m_Playing || instance->m_FrameCount > 0) {
+                instance->m_AudibleGain = GetAudibleGain(sound, instance);
+                sound->m_Voices.Push((uint16_t) i);
+            }
+        }
+
+        const uint32_t max_real_voices = sound->m_MaxRealVoices;
+        if (max_real_voices != 0 && sound->m_Voices.Size() > max_real_voices)
+        {
+            VoicePred pred;
+            pred.m_Instances = sound->m_Instances.Begin();
+            std::sort(sound->m_Voices.Begin(), sound->m_Voices.End(), pred);
+        }
+
+        uint32_t real_voices = 0;
+        uint32_t voices = sound->m_Voices.Size();
+        for (uint32_t i = 0; i < voices; ++i) {
+            SoundInstance* instance = &sound->m_Instances[sound->m_Voices[i]];
+            bool is_virtual = instance->m_AudibleGain <= 0.0f || (max_real_voices != 0 && real_voices >= max_real_voices);
+            if (!is_virtual)
+            {
+                if (instance->m_Virtual)
+                {
+                    // Fade in, to avoid a click when it starts in the middle of the sound
+                    instance->m_Gain.m_Prev = 0.0f;
+                }
+                ++real_voices;
+            }
+            instance->m_Virtual = is_virtual;
         }
     }
 
@@ -1357,6 +2137,7 @@ namespace dmSound
     static Result UpdateInternal(SoundSystem* sound)
     {
         DM_PROFILE(Sound, "Update")
+        DM_MEM_SCOPE(Sound);
 
         uint16_t active_instance_count = sound->m_InstancesPool.Size();
 
@@ -1417,12 +2198,22 @@ namespace dmSound
             sound->m_IsDeviceStarted = true;
         }
 
+        if (sound->m_UseRenderCallback)
+        {
+            // The device mixes from its own thread, see RenderCallback()
+            return RESULT_OK;
+        }
+
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
 
+        // The decode jobs have had since the last update to finish
+        WaitDecodeAhead(sound);
+
         uint32_t free_slots = sound->m_DeviceType->m_FreeBufferSlots(sound->m_Device);
         if (free_slots > 0) {
             StepGroupValues();
             StepInstanceValues();
+            UpdateVoices(sound);
         }
 
         uint32_t current_buffer = 0;
@@ -1443,9 +2234,59 @@ namespace dmSound
             free_slots--;
         }
 
+        StartDecodeAhead(sound);
+
         return RESULT_OK;
     }
 
+    // Mixes the first out buffer for RenderCallback()
+    static void MixRenderBuffer(SoundSystem* sound)
+    {
+        int16_t* out = sound->m_OutBuffers[0];
+        if (sound->m_IsPaused || sound->m_IsPhoneCallActive || sound->m_InstancesPool.Size() == 0)
+        {
+            memset(out, 0, sound->m_FrameCount * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
+            return;
+        }
+
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound->m_Mutex);
+
+        StepGroupValues();
+        StepInstanceValues();
+        UpdateVoices(sound);
+
+        MixContext mix_context(0, 1);
+        MixInstances(&mix_context);
+        Master(&mix_context);
+    }
+
+    // Called from the audio thread of devices that pull their frames. The frames are mixed m_FrameCount
+    // at a time, which is the native buffer size of the device, so normally there is nothing left over
+    static void RenderCallback(int16_t* frames, uint32_t frame_count)
+    {
+        SoundSystem* sound = g_SoundSystem;
+        if (!sound)
+        {
+            memset(frames, 0, frame_count * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
+            return;
+        }
+
+        while (frame_count > 0)
+        {
+            if (sound->m_RenderFrame == sound->m_FrameCount)
+            {
+                MixRenderBuffer(sound);
+                sound->m_RenderFrame = 0;
+            }
+
+            uint32_t n = dmMath::Min(frame_count, sound->m_FrameCount - sound->m_RenderFrame);
+            memcpy(frames, sound->m_OutBuffers[0] + sound->m_RenderFrame * SOUND_MAX_MIX_CHANNELS, n * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
+            frames += n * SOUND_MAX_MIX_CHANNELS;
+            frame_count -= n;
+            sound->m_RenderFrame += n;
+        }
+    }
+
     static void SoundThread(void* ctx)
     {
         SoundSystem* sound = (SoundSystem*)ctx;
@@ -15,6 +15,7 @@
 
 #include <dlib/configfile.h>
 #include <dlib/hash.h>
+#include <dlib/job.h>
 
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
 
@@ -34,7 +35,8 @@ namespace dmSound
         PARAMETER_GAIN  = 0,
         PARAMETER_PAN   = 1,
         PARAMETER_SPEED = 2,
-        PARAMETER_MAX   = 3
+        PARAMETER_PRIORITY = 3, // [0, 255]. Voices with higher priority are mixed first, see InitializeParams::m_MaxRealVoices
+        PARAMETER_MAX   = 4
     };
 
     enum Result
@@ -65,9 +67,6 @@ namespace dmSound
 
     const uint32_t MAX_GROUPS = 32;
 
-    // TODO:
-    // - Music streaming.
-
     struct InitializeParams;
     void SetDefaultInitializeParams(InitializeParams* params);
 
@@ -81,7 +80,20 @@ namespace dmSound
         uint32_t m_BufferSize;
         uint32_t m_FrameCount;
         uint32_t m_MaxInstances;
+        // Max number of voices that are decoded and mixed. The rest, and all inaudible voices, are virtual and
+        // only advance their play position. 0 means no limit
+        uint32_t m_MaxRealVoices;
+        // Sound data at least this large should be streamed, see NewSoundDataStreaming. 0 disables streaming
+        uint32_t m_StreamingThreshold;
+        // Max total size in bytes of the fully decoded compressed sounds shared between instances. 0 disables the cache
+        uint32_t m_DecodedCacheSize;
+        // Compressed sounds that decode to at most this many bytes are kept in the decoded cache
+        uint32_t m_DecodedCacheThreshold;
+        // Optional. Compressed sounds are decoded ahead of time on the job threads when set
+        dmJob::HContext m_JobContext;
         bool     m_UseThread;
+        // Mix from the callback of a "low_latency" device if there is one, see OpenDeviceParams::m_RenderCallback
+        bool     m_LowLatency;
 
         InitializeParams()
         {
@@ -101,9 +113,24 @@ namespace dmSound
     // Thread safe
     Result NewSoundData(const void* sound_buffer, uint32_t sound_buffer_size, SoundDataType type, HSoundData* sound_data, dmhash_t name);
     Result SetSoundData(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size);
+    // Creates a sound data that uses the buffer in place instead of copying it, e.g. a memory mapped resource.
+    // The buffer is owned by the caller and must be kept alive until the sound data is deleted or replaced with SetSoundData
+    Result NewSoundDataExternal(const void* sound_buffer, uint32_t sound_buffer_size, SoundDataType type, HSoundData* sound_data, dmhash_t name);
     uint32_t GetSoundResourceSize(HSoundData sound_data);
     Result DeleteSoundData(HSoundData sound_data);
 
+    // Reads a part of a streamed sound data. Called from the sound thread or the job threads
+    typedef Result (*FSoundDataRead)(void* context, uint32_t offset, void* buffer, uint32_t buffer_size, uint32_t* nread);
+
+    // Creates a sound data that is read in parts while playing, instead of being kept in memory.
+    // Returns RESULT_UNSUPPORTED if the type can't be streamed. The read context is owned by the
+    // caller and must be kept alive until the sound data is deleted or replaced with SetSoundData.
+    Result NewSoundDataStreaming(FSoundDataRead read, void* read_context, uint32_t size, SoundDataType type, HSoundData* sound_data, dmhash_t name);
+    // Gets the read context of a streamed sound data, 0 if not streamed
+    void* GetSoundDataReadContext(HSoundData sound_data);
+    // Sound data at least this large should be streamed, 0 if streaming is disabled
+    uint32_t GetStreamingThreshold();
+
     Result NewSoundInstance(HSoundData sound_data, HSoundInstance* sound_instance);
     Result DeleteSoundInstance(HSoundInstance sound_instance);
 
@@ -117,11 +144,16 @@ namespace dmSound
 
     Result GetGroupRMS(dmhash_t group_hash, float window, float* rms_left, float* rms_right);
     Result GetGroupPeak(dmhash_t group_hash, float window, float* peak_left, float* peak_right);
+    // Peak magnitude of logarithmically spaced frequency bands, up to half the mix rate. The spectrum is only
+    // analyzed while it is requested, so the first call for a group returns silence
+    Result GetGroupSpectrum(dmhash_t group_hash, float* bands, uint32_t band_count);
 
     Result Play(HSoundInstance sound_instance);
     Result Stop(HSoundInstance sound_instance);
     Result Pause(HSoundInstance sound_instance, bool pause);
     bool IsPlaying(HSoundInstance sound_instance);
+    // True if the instance isn't mixed at the moment, see InitializeParams::m_MaxRealVoices
+    bool IsVirtual(HSoundInstance sound_instance);
     uint32_t GetAndIncreasePlayCounter();
 
     Result SetLooping(HSoundInstance sound_instance, bool looping, int8_t loopcount);
@@ -143,16 +175,26 @@ namespace dmSound
      */
     typedef void* HDevice;
 
+    /**
+     * Callback used by devices that pull frames instead of having them queued
+     * @note Buffer data in 16-bit signed PCM stereo
+     * @param frames buffer to fill
+     * @param frame_count number of frames to fill
+     */
+    typedef void (*DeviceRenderCallback)(int16_t* frames, uint32_t frame_count);
+
     /**
      * Parameters
      */
     struct OpenDeviceParams
     {
-        OpenDeviceParams() : m_BufferCount(0), m_FrameCount(0)
+        OpenDeviceParams() : m_BufferCount(0), m_FrameCount(0), m_RenderCallback(0)
         {
         }
         uint32_t m_BufferCount;
         uint32_t m_FrameCount;
+        /// Called from the device's own audio thread by devices that pull their frames. Queue based devices ignore it
+        DeviceRenderCallback m_RenderCallback;
     };
 
     /**
@@ -160,7 +202,12 @@ namespace dmSound
      */
     struct DeviceInfo
     {
+        DeviceInfo() : m_MixRate(0), m_FrameCount(0)
+        {
+        }
         uint32_t m_MixRate;
+        /// Native number of frames per render callback for devices that pull their frames, 0 for queue based devices
+        uint32_t m_FrameCount;
     };
 
     /**
@@ -11,6 +11,8 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <dlib/array.h>
 #include <dlib/index_pool.h>
 #include <dlib/endian.h>
@@ -23,11 +25,33 @@
 
 namespace dmSoundCodec
 {
+    /**
+     * Fully decoded PCM of a compressed clip, shared by the decoders of the clip.
+     * Freed when evicted, or when invalidated and no longer referenced
+     */
+    struct DecodedClip
+    {
+        const void* m_Key;
+        char*       m_Data;
+        uint32_t    m_Size;
+        Info        m_Info;
+        uint32_t    m_RefCount;
+        uint32_t    m_LastUsed;
+        uint32_t    m_Cached : 1;
+    };
+
+    struct DecodedStream
+    {
+        DecodedClip* m_Clip;
+        uint32_t     m_Cursor;
+    };
+
     struct Decoder
     {
         int m_Index;
         HDecodeStream m_Stream;
         const DecoderInfo* m_DecoderInfo;
+        DecodedClip* m_Clip;
 
         void Clear()
         {
@@ -39,8 +63,143 @@ namespace dmSoundCodec
     {
         dmArray<Decoder> m_Decoders;
         dmIndexPool16    m_DecodersPool;
+        dmArray<DecodedClip*> m_DecodedClips;
+        uint32_t         m_DecodedSize;
+        uint32_t         m_MaxDecodedSize;
+        uint32_t         m_DecodedThreshold;
+        uint32_t         m_DecodedUseCounter;
+    };
+
+    static Result DecodedOpenStream(const void* buffer, const uint32_t size, HDecodeStream* stream)
+    {
+        DecodedStream* s = new DecodedStream;
+        s->m_Clip = (DecodedClip*) buffer;
+        s->m_Cursor = 0;
+        *stream = s;
+        return RESULT_OK;
+    }
+
+    static void DecodedCloseStream(HDecodeStream stream)
+    {
+        delete (DecodedStream*) stream;
+    }
+
+    static Result DecodedDecode(HDecodeStream stream, char* buffer, uint32_t buffer_size, uint32_t* decoded)
+    {
+        DecodedStream* s = (DecodedStream*) stream;
+        uint32_t n = dmMath::Min(buffer_size, s->m_Clip->m_Size - s->m_Cursor);
+        memcpy(buffer, s->m_Clip->m_Data + s->m_Cursor, n);
+        s->m_Cursor += n;
+        *decoded = n;
+        return RESULT_OK;
+    }
+
+    static Result DecodedResetStream(HDecodeStream stream)
+    {
+        ((DecodedStream*) stream)->m_Cursor = 0;
+        return RESULT_OK;
+    }
+
+    static Result DecodedSkipInStream(HDecodeStream stream, uint32_t bytes, uint32_t* skipped)
+    {
+        DecodedStream* s = (DecodedStream*) stream;
+        uint32_t n = dmMath::Min(bytes, s->m_Clip->m_Size - s->m_Cursor);
+        s->m_Cursor += n;
+        *skipped = n;
+        return RESULT_OK;
+    }
+
+    static void DecodedGetInfo(HDecodeStream stream, Info* out)
+    {
+        *out = ((DecodedStream*) stream)->m_Clip->m_Info;
+    }
+
+    // Not registered, only used for the clips in the decoded cache
+    static DecoderInfo g_DecodedDecoderInfo = {
+        "DecodedCache", FORMAT_WAV, 0,
+        DecodedOpenStream, 0, DecodedCloseStream, DecodedDecode, DecodedResetStream, DecodedSkipInStream, DecodedGetInfo, 0
     };
 
+    static void FreeDecodedClip(DecodedClip* clip)
+    {
+        free(clip->m_Data);
+        delete clip;
+    }
+
+    static void RemoveDecodedClip(HCodecContext context, uint32_t i)
+    {
+        DecodedClip* clip = context->m_DecodedClips[i];
+        context->m_DecodedClips.EraseSwap(i);
+        context->m_DecodedSize -= clip->m_Size;
+        clip->m_Cached = 0;
+        if (clip->m_RefCount == 0) {
+            FreeDecodedClip(clip);
+        }
+    }
+
+    // Evicts the least recently used clips not in use until size bytes fit in the cache
+    static bool MakeRoom(HCodecContext context, uint32_t size)
+    {
+        while (context->m_DecodedSize + size > context->m_MaxDecodedSize)
+        {
+            uint32_t lru = 0xffffffff;
+            for (uint32_t i = 0; i < context->m_DecodedClips.Size(); ++i)
+            {
+                DecodedClip* clip = context->m_DecodedClips[i];
+                if (clip->m_RefCount == 0 && (lru == 0xffffffff || clip->m_LastUsed < context->m_DecodedClips[lru]->m_LastUsed)) {
+                    lru = i;
+                }
+            }
+            if (lru == 0xffffffff) {
+                return false;
+            }
+            RemoveDecodedClip(context, lru);
+        }
+        return true;
+    }
+
+    // Decodes the whole clip, or returns 0 if it's larger than the threshold
+    static DecodedClip* DecodeClip(HCodecContext context, HDecoder decoder, const void* buffer)
+    {
+        DM_PROFILE(Sound, "DecodeClip");
+
+        const uint32_t chunk_size = 16 * 1024;
+        uint32_t capacity = 0;
+        uint32_t size = 0;
+        char* data = 0;
+
+        while (true)
+        {
+            if (size + chunk_size > capacity)
+            {
+                capacity = dmMath::Min(capacity + dmMath::Max(capacity, chunk_size), context->m_DecodedThreshold + chunk_size);
+                data = (char*) realloc(data, capacity);
+            }
+
+            uint32_t decoded = 0;
+            Result r = Decode(context, decoder, data + size, chunk_size, &decoded);
+            size += decoded;
+            if (r != RESULT_OK || size > context->m_DecodedThreshold)
+            {
+                free(data);
+                return 0;
+            }
+            if (decoded < chunk_size) {
+                break;
+            }
+        }
+
+        DecodedClip* clip = new DecodedClip;
+        clip->m_Key = buffer;
+        clip->m_Data = (char*) realloc(data, dmMath::Max(size, 1U));
+        clip->m_Size = size;
+        GetInfo(context, decoder, &clip->m_Info);
+        clip->m_Info.m_Size = size;
+        clip->m_RefCount = 0;
+        clip->m_Cached = 0;
+        return clip;
+    }
+
     HCodecContext New(const NewCodecContextParams* params)
     {
         CodecContext* c = new CodecContext;
@@ -50,6 +209,10 @@ namespace dmSoundCodec
             c->m_Decoders[i].Clear();
         }
         c->m_DecodersPool.SetCapacity(params->m_MaxDecoders);
+        c->m_DecodedSize = 0;
+        c->m_MaxDecodedSize = params->m_DecodedCacheSize;
+        c->m_DecodedThreshold = dmMath::Min(params->m_DecodedCacheThreshold, params->m_DecodedCacheSize);
+        c->m_DecodedUseCounter = 0;
         return c;
     }
 
@@ -59,6 +222,9 @@ namespace dmSoundCodec
         if (n > 0) {
             dmLogError("Dangling decoders in codec context (%d)", n);
         }
+        while (!context->m_DecodedClips.Empty()) {
+            RemoveDecodedClip(context, context->m_DecodedClips.Size() - 1);
+        }
         delete context;
     }
 
@@ -88,6 +254,118 @@ namespace dmSoundCodec
         return RESULT_OK;
     }
 
+    Result NewCachedDecoder(HCodecContext context, Format format, const void* buffer, uint32_t buffer_size, HDecoder* decoder)
+    {
+        // Wav data is already PCM, the decoder reads it in place
+        if (format == FORMAT_WAV || context->m_DecodedThreshold == 0) {
+            return NewDecoder(context, format, buffer, buffer_size, decoder);
+        }
+
+        if (context->m_DecodersPool.Remaining() == 0) {
+            return RESULT_OUT_OF_RESOURCES;
+        }
+
+        DecodedClip* clip = 0;
+        for (uint32_t i = 0; i < context->m_DecodedClips.Size(); ++i)
+        {
+            if (context->m_DecodedClips[i]->m_Key == buffer) {
+                clip = context->m_DecodedClips[i];
+                break;
+            }
+        }
+
+        if (!clip)
+        {
+            Result r = NewDecoder(context, format, buffer, buffer_size, decoder);
+            if (r != RESULT_OK) {
+                return r;
+            }
+
+            clip = DecodeClip(context, *decoder, buffer);
+            if (!clip || !MakeRoom(context, clip->m_Size))
+            {
+                if (clip) {
+                    FreeDecodedClip(clip);
+                }
+                // Too large, or the cache is full of clips in use
+                r = Reset(context, *decoder);
+                if (r != RESULT_OK) {
+                    DeleteDecoder(context, *decoder);
+                }
+                return r;
+            }
+            DeleteDecoder(context, *decoder);
+
+            if (context->m_DecodedClips.Full()) {
+                context->m_DecodedClips.OffsetCapacity(16);
+            }
+            context->m_DecodedClips.Push(clip);
+            context->m_DecodedSize += clip->m_Size;
+            clip->m_Cached = 1;
+        }
+
+        uint16_t index = context->m_DecodersPool.Pop();
+        Decoder* d = &context->m_Decoders[index];
+        d->m_Index = index;
+        d->m_DecoderInfo = &g_DecodedDecoderInfo;
+        d->m_Clip = clip;
+        g_DecodedDecoderInfo.m_OpenStream(clip, clip->m_Size, &d->m_Stream);
+
+        clip->m_RefCount++;
+        clip->m_LastUsed = ++context->m_DecodedUseCounter;
+
+        *decoder = d;
+        return RESULT_OK;
+    }
+
+    void InvalidateCache(HCodecContext context, const void* buffer)
+    {
+        for (uint32_t i = 0; i < context->m_DecodedClips.Size(); ++i)
+        {
+            if (context->m_DecodedClips[i]->m_Key == buffer) {
+                RemoveDecodedClip(context, i);
+                return;
+            }
+        }
+    }
+
+    bool IsCachedDecoder(HCodecContext context, HDecoder decoder)
+    {
+        assert(decoder);
+        return decoder->m_Clip != 0;
+    }
+
+    Result NewStreamingDecoder(HCodecContext context, Format format, FStreamRead read, void* read_context, uint32_t size, HDecoder* decoder)
+    {
+        if (context->m_DecodersPool.Remaining() == 0) {
+            return RESULT_OUT_OF_RESOURCES;
+        }
+
+        const DecoderInfo* decoderImpl = FindBestStreamingDecoder(format);
+        if (!decoderImpl) {
+            return RESULT_UNSUPPORTED;
+        }
+
+        uint16_t index = context->m_DecodersPool.Pop();
+        Decoder* d = &context->m_Decoders[index];
+        d->m_Index = index;
+        d->m_DecoderInfo = decoderImpl;
+
+        Result r = decoderImpl->m_OpenStreamingStream(read, read_context, size, &d->m_Stream);
+        if (r != RESULT_OK) {
+            context->m_DecodersPool.Push(index);
+            return r;
+        }
+
+        *decoder = d;
+        return RESULT_OK;
+    }
+
+    bool IsStreamingSupported(Format format)
+    {
+        return FindBestStreamingDecoder(format) != 0;
+    }
+
     void GetInfo(HCodecContext context, HDecoder decoder, Info* info)
     {
         assert(decoder);
@@ -118,6 +396,10 @@ namespace dmSoundCodec
     {
         assert(decoder);
         decoder->m_DecoderInfo->m_CloseStream(decoder->m_Stream);
+        DecodedClip* clip = decoder->m_Clip;
+        if (clip && --clip->m_RefCount == 0 && !clip->m_Cached) {
+            FreeDecodedClip(clip);
+        }
         context->m_DecodersPool.Push(decoder->m_Index);
         decoder->Clear();
     }
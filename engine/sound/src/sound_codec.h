@@ -60,6 +60,17 @@ namespace dmSoundCodec
         uint8_t  m_BitsPerSample;
     };
 
+    /**
+     * Read a part of a compressed stream, see NewStreamingDecoder()
+     * @param context read context
+     * @param offset offset in bytes from the start of the stream
+     * @param buffer buffer
+     * @param buffer_size number of bytes to read
+     * @param nread actual bytes read, less than buffer_size at the end of the stream (out)
+     * @return RESULT_OK on success
+     */
+    typedef Result (*FStreamRead)(void* context, uint32_t offset, void* buffer, uint32_t buffer_size, uint32_t* nread);
+
     /**
      * Parameters for new codec context
      */
@@ -67,10 +78,16 @@ namespace dmSoundCodec
     {
         /// Maximum number of decoders supported in context
         uint32_t m_MaxDecoders;
+        /// Maximum total size in bytes of the decoded clips kept by NewCachedDecoder(). 0 disables the cache
+        uint32_t m_DecodedCacheSize;
+        /// Maximum decoded size in bytes of a clip kept by NewCachedDecoder()
+        uint32_t m_DecodedCacheThreshold;
 
         NewCodecContextParams()
         {
             m_MaxDecoders = 32;
+            m_DecodedCacheSize = 0;
+            m_DecodedCacheThreshold = 0;
         }
     };
 
@@ -98,6 +115,59 @@ namespace dmSoundCodec
      */
     Result NewDecoder(HCodecContext context, Format format, const void* buffer, uint32_t buffer_size, HDecoder* decoder);
 
+    /**
+     * Create a new decoder for a compressed clip, sharing the decoded PCM data
+     * between all decoders of the same buffer. Clips are decoded fully on the first
+     * call and kept in a size bounded cache, where the least recently used clip not
+     * in use is evicted first. Clips that decode to more than m_DecodedCacheThreshold
+     * bytes, and uncompressed formats, get a regular decoder, see NewDecoder().
+     * The buffer is the cache key, call InvalidateCache() before it is changed or freed.
+     * @param context context
+     * @param format format
+     * @param buffer buffer
+     * @param buffer_size buffer size
+     * @param decoder decoder (out)
+     * @return RESULT_OK on success
+     */
+    Result NewCachedDecoder(HCodecContext context, Format format, const void* buffer, uint32_t buffer_size, HDecoder* decoder);
+
+    /**
+     * Remove the decoded clip of a buffer from the cache, see NewCachedDecoder().
+     * Decoders already playing the clip keep it until they are deleted.
+     * @param context context
+     * @param buffer buffer
+     */
+    void InvalidateCache(HCodecContext context, const void* buffer);
+
+    /**
+     * Check if the decoder plays a decoded clip from the cache, see NewCachedDecoder()
+     * @param context context
+     * @param decoder decoder
+     * @return true if the decoder reads cached PCM data
+     */
+    bool IsCachedDecoder(HCodecContext context, HDecoder decoder);
+
+    /**
+     * Create a new decoder that reads the compressed stream in parts, without
+     * having the whole stream in memory. The read function is called from the thread
+     * decoding the stream.
+     * @param context context
+     * @param format format
+     * @param read read function
+     * @param read_context context passed to the read function
+     * @param size size of the compressed stream in bytes
+     * @param decoder decoder (out)
+     * @return RESULT_OK on success, RESULT_UNSUPPORTED if no decoder of the format supports streaming
+     */
+    Result NewStreamingDecoder(HCodecContext context, Format format, FStreamRead read, void* read_context, uint32_t size, HDecoder* decoder);
+
+    /**
+     * Check if there is a decoder of the format that supports streaming, see NewStreamingDecoder()
+     * @param format format
+     * @return true if streaming is supported
+     */
+    bool IsStreamingSupported(Format format);
+
     /**
      * Delete decoder
      * @param context context
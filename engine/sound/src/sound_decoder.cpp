@@ -72,4 +72,23 @@ namespace dmSoundCodec
         assert(best != 0);
         return best;
     }
+
+    const DecoderInfo* FindBestStreamingDecoder(Format format)
+    {
+        const DecoderInfo *best = 0;
+        const DecoderInfo *decoder = g_FirstDecoder;
+
+        while (decoder)
+        {
+            if (decoder->m_Format == format && decoder->m_OpenStreamingStream != 0 &&
+                (!best || decoder->m_Score > best->m_Score))
+            {
+                best = decoder;
+            }
+
+            decoder = decoder->m_Next;
+        }
+
+        return best;
+    }
 }
@@ -49,6 +49,11 @@ namespace dmSoundCodec
          */
         Result (*m_OpenStream)(const void* buffer, const uint32_t size, HDecodeStream* out);
 
+        /**
+         * Open a stream for decoding that reads the compressed data in parts. Optional.
+         */
+        Result (*m_OpenStreamingStream)(FStreamRead read, void* read_context, const uint32_t size, HDecodeStream* out);
+
         /**
          * Close and free decoding resources
          */
@@ -88,6 +93,12 @@ namespace dmSoundCodec
      */
     const DecoderInfo* FindBestDecoder(Format format);
 
+    /**
+     * Finds the best match among the decoders that support streaming, see m_OpenStreamingStream.
+     * Returns 0 if there is none.
+     */
+    const DecoderInfo* FindBestStreamingDecoder(Format format);
+
     /**
      * Get by name of implementation
      */
@@ -117,12 +128,13 @@ namespace dmSoundCodec
     /**
      * Declare a new stream decoder
      */
-    #define DM_DECLARE_SOUND_DECODER(symbol, name, format, score, open, close, decode, reset, skip, getinfo) \
+    #define DM_DECLARE_SOUND_DECODER(symbol, name, format, score, open, open_streaming, close, decode, reset, skip, getinfo) \
             dmSoundCodec::DecoderInfo DM_SOUND_PASTE2(symbol, __LINE__) = { \
                     name, \
                     format, \
                     score, \
                     open, \
+                    open_streaming, \
                     close, \
                     decode, \
                     reset, \
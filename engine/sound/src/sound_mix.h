@@ -0,0 +1,322 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_SOUND_MIX_H
+#define DM_SOUND_MIX_H
+
+#include <stdint.h>
+
+// The mixing kernels use SSE2 or NEON when the target always has it (x86-64, arm64 and armv7 builds with neon),
+// otherwise plain C
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_SOUND_MIX_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define DM_SOUND_MIX_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace dmSound
+{
+    /*
+     * All kernels work on interleaved stereo float mix buffers, and take a linear gain ramp over the
+     * frames as (from, to, recip), where the gain for frame i is from + (i * recip) * (to - from).
+     * This is the same as Ramp::GetValue() so that the output matches the scalar mixers.
+     */
+
+    static inline float GetMixGain(float from, float to, float recip, uint32_t i)
+    {
+        float mix = i * recip;
+        return from + mix * (to - from);
+    }
+
+    /**
+     * Mixes 16-bit mono frames into the mix buffer, with a constant pan
+     */
+    static inline void MixMono16(const int16_t* frames, uint32_t count, float gain_from, float gain_to, float gain_recip,
+                                 float left_scale, float right_scale, float* mix_buffer)
+    {
+        uint32_t i = 0;
+#if defined(DM_SOUND_MIX_SSE2)
+        const __m128 from = _mm_set1_ps(gain_from);
+        const __m128 diff = _mm_set1_ps(gain_to - gain_from);
+        const __m128 recip = _mm_set1_ps(gain_recip);
+        const __m128 pan = _mm_setr_ps(left_scale, right_scale, left_scale, right_scale);
+        __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i s16 = _mm_loadl_epi64((const __m128i*) (frames + i));
+            __m128 s = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16));
+            __m128 gain = _mm_add_ps(from, _mm_mul_ps(_mm_mul_ps(index, recip), diff));
+            s = _mm_mul_ps(s, gain);
+
+            float* out = mix_buffer + 2 * i;
+            _mm_storeu_ps(out,     _mm_add_ps(_mm_loadu_ps(out),     _mm_mul_ps(_mm_unpacklo_ps(s, s), pan)));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(_mm_unpackhi_ps(s, s), pan)));
+            index = _mm_add_ps(index, _mm_set1_ps(4.0f));
+        }
+#elif defined(DM_SOUND_MIX_NEON)
+        const float32x4_t from = vdupq_n_f32(gain_from);
+        const float32x4_t diff = vdupq_n_f32(gain_to - gain_from);
+        const float32x4_t recip = vdupq_n_f32(gain_recip);
+        const float pan_data[4] = { left_scale, right_scale, left_scale, right_scale };
+        const float32x4_t pan = vld1q_f32(pan_data);
+        const float index_data[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        float32x4_t index = vld1q_f32(index_data);
+        for (; i + 4 <= count; i += 4)
+        {
+            float32x4_t s = vcvtq_f32_s32(vmovl_s16(vld1_s16(frames + i)));
+            float32x4_t gain = vaddq_f32(from, vmulq_f32(vmulq_f32(index, recip), diff));
+            s = vmulq_f32(s, gain);
+
+            float32x4x2_t lr = vzipq_f32(s, s);
+            float* out = mix_buffer + 2 * i;
+            vst1q_f32(out,     vaddq_f32(vld1q_f32(out),     vmulq_f32(lr.val[0], pan)));
+            vst1q_f32(out + 4, vaddq_f32(vld1q_f32(out + 4), vmulq_f32(lr.val[1], pan)));
+            index = vaddq_f32(index, vdupq_n_f32(4.0f));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            float s = frames[i] * GetMixGain(gain_from, gain_to, gain_recip, i);
+            mix_buffer[2 * i]     += s * left_scale;
+            mix_buffer[2 * i + 1] += s * right_scale;
+        }
+    }
+
+    /**
+     * Mixes 16-bit stereo frames into the mix buffer, with a constant pan
+     */
+    static inline void MixStereo16(const int16_t* frames, uint32_t count, float gain_from, float gain_to, float gain_recip,
+                                   float left_scale, float right_scale, float* mix_buffer)
+    {
+        uint32_t i = 0;
+#if defined(DM_SOUND_MIX_SSE2)
+        const __m128 from = _mm_set1_ps(gain_from);
+        const __m128 diff = _mm_set1_ps(gain_to - gain_from);
+        const __m128 recip = _mm_set1_ps(gain_recip);
+        const __m128 pan = _mm_setr_ps(left_scale, right_scale, left_scale, right_scale);
+        __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i s16 = _mm_loadu_si128((const __m128i*) (frames + 2 * i));
+            __m128 s01 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16));
+            __m128 s23 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16));
+            __m128 gain = _mm_add_ps(from, _mm_mul_ps(_mm_mul_ps(index, recip), diff));
+
+            float* out = mix_buffer + 2 * i;
+            _mm_storeu_ps(out,     _mm_add_ps(_mm_loadu_ps(out),     _mm_mul_ps(_mm_mul_ps(s01, _mm_unpacklo_ps(gain, gain)), pan)));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(_mm_mul_ps(s23, _mm_unpackhi_ps(gain, gain)), pan)));
+            index = _mm_add_ps(index, _mm_set1_ps(4.0f));
+        }
+#elif defined(DM_SOUND_MIX_NEON)
+        const float32x4_t from = vdupq_n_f32(gain_from);
+        const float32x4_t diff = vdupq_n_f32(gain_to - gain_from);
+        const float32x4_t recip = vdupq_n_f32(gain_recip);
+        const float pan_data[4] = { left_scale, right_scale, left_scale, right_scale };
+        const float32x4_t pan = vld1q_f32(pan_data);
+        const float index_data[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        float32x4_t index = vld1q_f32(index_data);
+        for (; i + 4 <= count; i += 4)
+        {
+            int16x8_t s16 = vld1q_s16(frames + 2 * i);
+            float32x4_t s01 = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16)));
+            float32x4_t s23 = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s16)));
+            float32x4_t gain = vaddq_f32(from, vmulq_f32(vmulq_f32(index, recip), diff));
+            float32x4x2_t g = vzipq_f32(gain, gain);
+
+            float* out = mix_buffer + 2 * i;
+            vst1q_f32(out,     vaddq_f32(vld1q_f32(out),     vmulq_f32(vmulq_f32(s01, g.val[0]), pan)));
+            vst1q_f32(out + 4, vaddq_f32(vld1q_f32(out + 4), vmulq_f32(vmulq_f32(s23, g.val[1]), pan)));
+            index = vaddq_f32(index, vdupq_n_f32(4.0f));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            float gain = GetMixGain(gain_from, gain_to, gain_recip, i);
+            mix_buffer[2 * i]     += frames[2 * i] * gain * left_scale;
+            mix_buffer[2 * i + 1] += frames[2 * i + 1] * gain * right_scale;
+        }
+    }
+
+    /**
+     * Adds a group mix buffer to the master mix buffer. The gain is clamped to [0, 1]
+     */
+    static inline void MixGroup(const float* src, uint32_t count, float gain_from, float gain_to, float gain_recip, float* mix_buffer)
+    {
+        uint32_t i = 0;
+#if defined(DM_SOUND_MIX_SSE2)
+        const __m128 from = _mm_set1_ps(gain_from);
+        const __m128 diff = _mm_set1_ps(gain_to - gain_from);
+        const __m128 recip = _mm_set1_ps(gain_recip);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 gain = _mm_add_ps(from, _mm_mul_ps(_mm_mul_ps(index, recip), diff));
+            gain = _mm_min_ps(_mm_max_ps(gain, zero), one);
+
+            float* out = mix_buffer + 2 * i;
+            _mm_storeu_ps(out,     _mm_add_ps(_mm_loadu_ps(out),     _mm_mul_ps(_mm_loadu_ps(src + 2 * i),     _mm_unpacklo_ps(gain, gain))));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(_mm_loadu_ps(src + 2 * i + 4), _mm_unpackhi_ps(gain, gain))));
+            index = _mm_add_ps(index, _mm_set1_ps(4.0f));
+        }
+#elif defined(DM_SOUND_MIX_NEON)
+        const float32x4_t from = vdupq_n_f32(gain_from);
+        const float32x4_t diff = vdupq_n_f32(gain_to - gain_from);
+        const float32x4_t recip = vdupq_n_f32(gain_recip);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float index_data[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        float32x4_t index = vld1q_f32(index_data);
+        for (; i + 4 <= count; i += 4)
+        {
+            float32x4_t gain = vaddq_f32(from, vmulq_f32(vmulq_f32(index, recip), diff));
+            gain = vminq_f32(vmaxq_f32(gain, zero), one);
+            float32x4x2_t g = vzipq_f32(gain, gain);
+
+            float* out = mix_buffer + 2 * i;
+            vst1q_f32(out,     vaddq_f32(vld1q_f32(out),     vmulq_f32(vld1q_f32(src + 2 * i),     g.val[0])));
+            vst1q_f32(out + 4, vaddq_f32(vld1q_f32(out + 4), vmulq_f32(vld1q_f32(src + 2 * i + 4), g.val[1])));
+            index = vaddq_f32(index, vdupq_n_f32(4.0f));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            float gain = GetMixGain(gain_from, gain_to, gain_recip, i);
+            gain = gain < 0.0f ? 0.0f : (gain > 1.0f ? 1.0f : gain);
+            mix_buffer[2 * i]     += src[2 * i] * gain;
+            mix_buffer[2 * i + 1] += src[2 * i + 1] * gain;
+        }
+    }
+
+    /**
+     * Applies the master gain and converts the mix buffer to 16-bit, clipping the samples
+     */
+    static inline void MixMaster(const float* mix_buffer, uint32_t count, float gain_from, float gain_to, float gain_recip, int16_t* out)
+    {
+        uint32_t i = 0;
+#if defined(DM_SOUND_MIX_SSE2)
+        const __m128 from = _mm_set1_ps(gain_from);
+        const __m128 diff = _mm_set1_ps(gain_to - gain_from);
+        const __m128 recip = _mm_set1_ps(gain_recip);
+        const __m128 max = _mm_set1_ps(32767.0f);
+        const __m128 min = _mm_set1_ps(-32768.0f);
+        __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 gain = _mm_add_ps(from, _mm_mul_ps(_mm_mul_ps(index, recip), diff));
+            __m128 s01 = _mm_mul_ps(_mm_loadu_ps(mix_buffer + 2 * i),     _mm_unpacklo_ps(gain, gain));
+            __m128 s23 = _mm_mul_ps(_mm_loadu_ps(mix_buffer + 2 * i + 4), _mm_unpackhi_ps(gain, gain));
+            // Clip before the conversion, since out of range floats convert to INT_MIN
+            s01 = _mm_max_ps(_mm_min_ps(s01, max), min);
+            s23 = _mm_max_ps(_mm_min_ps(s23, max), min);
+            __m128i s16 = _mm_packs_epi32(_mm_cvttps_epi32(s01), _mm_cvttps_epi32(s23));
+            _mm_storeu_si128((__m128i*) (out + 2 * i), s16);
+            index = _mm_add_ps(index, _mm_set1_ps(4.0f));
+        }
+#elif defined(DM_SOUND_MIX_NEON)
+        const float32x4_t from = vdupq_n_f32(gain_from);
+        const float32x4_t diff = vdupq_n_f32(gain_to - gain_from);
+        const float32x4_t recip = vdupq_n_f32(gain_recip);
+        const float index_data[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        float32x4_t index = vld1q_f32(index_data);
+        for (; i + 4 <= count; i += 4)
+        {
+            float32x4_t gain = vaddq_f32(from, vmulq_f32(vmulq_f32(index, recip), diff));
+            float32x4x2_t g = vzipq_f32(gain, gain);
+            float32x4_t s01 = vmulq_f32(vld1q_f32(mix_buffer + 2 * i),     g.val[0]);
+            float32x4_t s23 = vmulq_f32(vld1q_f32(mix_buffer + 2 * i + 4), g.val[1]);
+            // The conversion saturates to 32-bit and the narrowing to 16-bit
+            int16x8_t s16 = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(s01)), vqmovn_s32(vcvtq_s32_f32(s23)));
+            vst1q_s16(out + 2 * i, s16);
+            index = vaddq_f32(index, vdupq_n_f32(4.0f));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            float gain = GetMixGain(gain_from, gain_to, gain_recip, i);
+            float s1 = mix_buffer[2 * i] * gain;
+            float s2 = mix_buffer[2 * i + 1] * gain;
+            s1 = s1 > 32767.0f ? 32767.0f : (s1 < -32768.0f ? -32768.0f : s1);
+            s2 = s2 > 32767.0f ? 32767.0f : (s2 < -32768.0f ? -32768.0f : s2);
+            out[2 * i] = (int16_t) s1;
+            out[2 * i + 1] = (int16_t) s2;
+        }
+    }
+
+    /**
+     * Sums the squares of the samples of each channel, and finds the largest square, after applying a constant gain.
+     * Used for the group meters
+     */
+    static inline void SumSquaresAndPeak(const float* mix_buffer, uint32_t count, float gain, float sum_sq[2], float peak_sq[2])
+    {
+        uint32_t i = 0;
+        float sum_left = 0.0f, sum_right = 0.0f;
+        float peak_left = 0.0f, peak_right = 0.0f;
+#if defined(DM_SOUND_MIX_SSE2)
+        const __m128 g = _mm_set1_ps(gain);
+        __m128 sum = _mm_setzero_ps();
+        __m128 peak = _mm_setzero_ps();
+        for (; i + 2 <= count; i += 2)
+        {
+            __m128 s = _mm_mul_ps(_mm_loadu_ps(mix_buffer + 2 * i), g);
+            s = _mm_mul_ps(s, s);
+            sum = _mm_add_ps(sum, s);
+            peak = _mm_max_ps(peak, s);
+        }
+        // Lanes are left, right, left, right
+        float sums[4], peaks[4];
+        _mm_storeu_ps(sums, sum);
+        _mm_storeu_ps(peaks, peak);
+        sum_left = sums[0] + sums[2];
+        sum_right = sums[1] + sums[3];
+        peak_left = peaks[0] > peaks[2] ? peaks[0] : peaks[2];
+        peak_right = peaks[1] > peaks[3] ? peaks[1] : peaks[3];
+#elif defined(DM_SOUND_MIX_NEON)
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        float32x4_t peak = vdupq_n_f32(0.0f);
+        for (; i + 2 <= count; i += 2)
+        {
+            float32x4_t s = vmulq_n_f32(vld1q_f32(mix_buffer + 2 * i), gain);
+            s = vmulq_f32(s, s);
+            sum = vaddq_f32(sum, s);
+            peak = vmaxq_f32(peak, s);
+        }
+        // Lanes are left, right, left, right
+        float32x2_t sum2 = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+        float32x2_t peak2 = vmax_f32(vget_low_f32(peak), vget_high_f32(peak));
+        sum_left = vget_lane_f32(sum2, 0);
+        sum_right = vget_lane_f32(sum2, 1);
+        peak_left = vget_lane_f32(peak2, 0);
+        peak_right = vget_lane_f32(peak2, 1);
+#endif
+        for (; i < count; ++i)
+        {
+            float left = mix_buffer[2 * i] * gain;
+            float right = mix_buffer[2 * i + 1] * gain;
+            left *= left;
+            right *= right;
+            sum_left += left;
+            sum_right += right;
+            peak_left = peak_left > left ? peak_left : left;
+            peak_right = peak_right > right ? peak_right : right;
+        }
+        sum_sq[0] = sum_left;
+        sum_sq[1] = sum_right;
+        peak_sq[0] = peak_left;
+        peak_sq[1] = peak_right;
+    }
+}
+
+#endif // DM_SOUND_MIX_H
@@ -79,6 +79,27 @@ namespace dmSound
         return RESULT_OK;
     }
 
+    Result NewSoundDataExternal(const void* sound_buffer, uint32_t sound_buffer_size, SoundDataType type, HSoundData* sound_data, dmhash_t name)
+    {
+        return NewSoundData(sound_buffer, sound_buffer_size, type, sound_data, name);
+    }
+
+    Result NewSoundDataStreaming(FSoundDataRead read, void* read_context, uint32_t size, SoundDataType type, HSoundData* sound_data, dmhash_t name)
+    {
+        *sound_data = 0;
+        return RESULT_UNSUPPORTED;
+    }
+
+    void* GetSoundDataReadContext(HSoundData sound_data)
+    {
+        return 0;
+    }
+
+    uint32_t GetStreamingThreshold()
+    {
+        return 0;
+    }
+
     uint32_t GetSoundResourceSize(HSoundData sound_data)
     {
         return sizeof(SoundData) + sound_data->m_BufferSize;
@@ -211,6 +232,11 @@ namespace dmSound
         return sound_instance->m_Playing == 1;
     }
 
+    bool IsVirtual(HSoundInstance sound_instance)
+    {
+        return false;
+    }
+
     Result SetLooping(HSoundInstance sound_instance, bool looping, int8_t loopcount)
     {
         sound_instance->m_Looping = looping ? 1 : 0;
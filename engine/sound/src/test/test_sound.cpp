@@ -17,13 +17,16 @@
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include <dlib/array.h>
+#include <dlib/atomic.h>
 #include <dlib/hash.h>
+#include <dlib/job.h>
 #include <dlib/message.h>
 #include <dlib/log.h>
 #include <dlib/time.h>
 #include <dlib/math.h>
 #include "../sound.h"
 #include "../sound_codec.h"
+#include "../sound_mix.h"
 #include "../stb_vorbis/stb_vorbis.h"
 
 #include "test/mono_tone_440_22050_44100.wav.embed.h"
@@ -292,6 +295,63 @@ class dmSoundMixerTest : public dmSoundTest2
 {
 };
 
+// Only mixes two voices at a time
+class dmSoundVoiceTest : public jc_test_params_class<TestParams>
+{
+public:
+    virtual void SetUp()
+    {
+        dmSound::InitializeParams params;
+        params.m_MaxBuffers = MAX_BUFFERS;
+        params.m_MaxSources = MAX_SOURCES;
+        params.m_OutputDevice = GetParam().m_DeviceName;
+        params.m_FrameCount = GetParam().m_BufferFrameCount;
+        params.m_MaxRealVoices = 2;
+        params.m_UseThread = false;
+
+        dmSound::Result r = dmSound::Initialize(0, &params);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+
+    virtual void TearDown()
+    {
+        dmSound::Result r = dmSound::Finalize();
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+};
+
+// Decodes ahead on the job threads
+class dmSoundVerifyStreamingOggTest : public jc_test_params_class<TestParams>
+{
+public:
+    dmJob::HContext m_JobContext;
+
+    virtual void SetUp()
+    {
+        dmJob::NewContextParams job_params;
+        job_params.m_WorkerCount = 2;
+        m_JobContext = dmJob::NewContext(job_params);
+
+        dmSound::InitializeParams params;
+        params.m_MaxBuffers = MAX_BUFFERS;
+        params.m_MaxSources = MAX_SOURCES;
+        params.m_OutputDevice = GetParam().m_DeviceName;
+        params.m_FrameCount = GetParam().m_BufferFrameCount;
+        params.m_UseThread = false;
+        params.m_JobContext = m_JobContext;
+
+        dmSound::Result r = dmSound::Initialize(0, &params);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+
+    virtual void TearDown()
+    {
+        dmSound::Result r = dmSound::Finalize();
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+        dmJob::DeleteContext(m_JobContext);
+    }
+};
+
 // Some arbitrary process "time" for loopback-device buffers
 #define LOOPBACK_DEVICE_PROCESS_TIME (4)
 
@@ -543,6 +603,39 @@ TEST_P(dmSoundVerifyTest, Mix)
 }
 #endif
 
+TEST_P(dmSoundVerifyTest, ExternalData)
+{
+    TestParams params = GetParam();
+    dmSound::Result r;
+    dmSound::HSoundData sd = 0;
+    r = dmSound::NewSoundDataExternal(params.m_Sound, params.m_SoundSize, params.m_Type, &sd, 1234);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    // The data is used in place and isn't counted
+    ASSERT_GT(params.m_SoundSize, dmSound::GetSoundResourceSize(sd));
+
+    dmSound::HSoundInstance instance = 0;
+    r = dmSound::NewSoundInstance(sd, &instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    r = dmSound::Play(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    do {
+        r = dmSound::Update();
+    } while (dmSound::IsPlaying(instance));
+    ASSERT_LT(0u, g_LoopbackDevice->m_TotalBuffersQueued);
+
+    r = dmSound::DeleteSoundInstance(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    // Replacing the data makes the sound data own a copy
+    r = dmSound::SetSoundData(sd, params.m_Sound, params.m_SoundSize);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    ASSERT_LE(params.m_SoundSize, dmSound::GetSoundResourceSize(sd));
+
+    r = dmSound::DeleteSoundData(sd);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+}
+
 TEST_P(dmSoundVerifyTest, EarlyBailOnNoSoundInstances)
 {
     ASSERT_EQ(dmSound::RESULT_NOTHING_TO_PLAY, dmSound::Update());
@@ -989,9 +1082,138 @@ const TestParams params_verify_ogg_test[] = {TestParams("loopback",
                                             35200,
                                             2048)};
 INSTANTIATE_TEST_CASE_P(dmSoundVerifyOggTest, dmSoundVerifyOggTest, jc_test_values_in(params_verify_ogg_test));
+
+struct StreamingReadContext
+{
+    const uint8_t* m_Data;
+    uint32_t       m_Size;
+    int32_atomic_t m_ReadCount; // Reads are done on the job threads
+};
+
+static dmSound::Result StreamingRead(void* context, uint32_t offset, void* buffer, uint32_t buffer_size, uint32_t* nread)
+{
+    StreamingReadContext* ctx = (StreamingReadContext*) context;
+    if (offset > ctx->m_Size)
+        return dmSound::RESULT_UNKNOWN_ERROR;
+    uint32_t n = dmMath::Min(buffer_size, ctx->m_Size - offset);
+    memcpy(buffer, ctx->m_Data + offset, n);
+    *nread = n;
+    dmAtomicIncrement32(&ctx->m_ReadCount);
+    return dmSound::RESULT_OK;
+}
+
+TEST_P(dmSoundVerifyStreamingOggTest, Mix)
+{
+    TestParams params = GetParam();
+    StreamingReadContext ctx;
+    ctx.m_Data = (const uint8_t*) params.m_Sound;
+    ctx.m_Size = params.m_SoundSize;
+    ctx.m_ReadCount = 0;
+
+    dmSound::HSoundData sd = 0;
+    dmSound::Result r = dmSound::NewSoundDataStreaming(StreamingRead, &ctx, params.m_SoundSize, params.m_Type, &sd, 1234);
+    if (r == dmSound::RESULT_UNSUPPORTED)
+    {
+        // No streaming decoder on this platform
+        return;
+    }
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    ASSERT_EQ(&ctx, dmSound::GetSoundDataReadContext(sd));
+    // The compressed data isn't kept in memory
+    ASSERT_GT(params.m_SoundSize, dmSound::GetSoundResourceSize(sd));
+
+    dmSound::HSoundInstance instance = 0;
+    r = dmSound::NewSoundInstance(sd, &instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    r = dmSound::Play(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    do {
+        r = dmSound::Update();
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    } while (dmSound::IsPlaying(instance));
+
+    ASSERT_LT(0, (int32_t) ctx.m_ReadCount);
+
+    r = dmSound::DeleteSoundInstance(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    r = dmSound::DeleteSoundData(sd);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+}
+
+INSTANTIATE_TEST_CASE_P(dmSoundVerifyStreamingOggTest, dmSoundVerifyStreamingOggTest, jc_test_values_in(params_verify_ogg_test));
+// Uncompressed wavs are streamed the same way
+INSTANTIATE_TEST_CASE_P(dmSoundVerifyStreamingWavTest, dmSoundVerifyStreamingOggTest, jc_test_values_in(params_verify_test));
 #endif
 
 #if !defined(GITHUB_CI) || (defined(GITHUB_CI) && !(defined(WIN32) || defined(__MACH__)))
+TEST_P(dmSoundVoiceTest, Virtualize)
+{
+    TestParams params = GetParam();
+    dmSound::Result r;
+    dmSound::HSoundData sd = 0;
+    dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd, 1234);
+
+    const uint32_t count = 5;
+    const float gains[count] = { 1.0f, 0.8f, 0.4f, 0.2f, 0.0f };
+    const float priorities[count] = { 0, 0, 10, 0, 0 };
+    // The high priority voice, and then the loudest one
+    const bool expected_virtual[count] = { false, true, false, true, true };
+
+    dmSound::HSoundInstance instances[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        r = dmSound::NewSoundInstance(sd, &instances[i]);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+        r = dmSound::SetParameter(instances[i], dmSound::PARAMETER_GAIN, Vectormath::Aos::Vector4(gains[i], 0, 0, 0));
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+        r = dmSound::SetParameter(instances[i], dmSound::PARAMETER_PRIORITY, Vectormath::Aos::Vector4(priorities[i], 0, 0, 0));
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+        r = dmSound::Play(instances[i]);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+
+    r = dmSound::Update();
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(expected_virtual[i], dmSound::IsVirtual(instances[i]));
+    }
+
+    // Virtual voices keep playing, and end at the same time as the real ones
+    uint32_t updates = 0;
+    while (dmSound::IsPlaying(instances[0]))
+    {
+        r = dmSound::Update();
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+        ASSERT_GT(1000U, ++updates);
+    }
+    r = dmSound::Update();
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_FALSE(dmSound::IsPlaying(instances[i]));
+        r = dmSound::DeleteSoundInstance(instances[i]);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+
+    r = dmSound::DeleteSoundData(sd);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+}
+
+const TestParams params_voice_test[] = {
+    TestParams("loopback",
+            MONO_TONE_440_22050_44100_WAV,
+            MONO_TONE_440_22050_44100_WAV_SIZE,
+            dmSound::SOUND_DATA_TYPE_WAV,
+            440,
+            44100,
+            44100,
+            2048),
+};
+INSTANTIATE_TEST_CASE_P(dmSoundVoiceTest, dmSoundVoiceTest, jc_test_values_in(params_voice_test));
+
 TEST_P(dmSoundTestPlayTest, Play)
 {
     TestParams params = GetParam();
@@ -1484,7 +1706,466 @@ const TestParams2 params_mixer_test[] = {
 INSTANTIATE_TEST_CASE_P(dmSoundMixerTest, dmSoundMixerTest, jc_test_values_in(params_mixer_test));
 #endif
 
+// The mix kernels must match the plain C mixing, an odd count also tests the remainder loops.
+// Allow for some rounding differences, since the compiler might fuse the multiply-adds in the C version
+#define MIX_KERNEL_FRAME_COUNT (1027)
+#define ASSERT_MIX_EQ(expected, actual) ASSERT_NEAR(expected, actual, fabsf(expected) * 0.00001f)
+
+TEST(dmSoundMixKernels, Mix16)
+{
+    const uint32_t n = MIX_KERNEL_FRAME_COUNT;
+    const float from = 0.2f, to = 1.7f, recip = 1.0f / n;
+    const float left = 0.7f, right = 0.3f;
+
+    int16_t* frames = new int16_t[2 * n];
+    float* mix_buffer = new float[2 * n];
+    float* expected = new float[2 * n];
+    for (uint32_t i = 0; i < 2 * n; ++i)
+        frames[i] = (int16_t) (rand() % 65536 - 32768);
+
+    for (uint32_t i = 0; i < 2 * n; ++i)
+        mix_buffer[i] = expected[i] = (float) (i % 7);
+    dmSound::MixMono16(frames, n, from, to, recip, left, right, mix_buffer);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        float s = frames[i] * dmSound::GetMixGain(from, to, recip, i);
+        expected[2 * i] += s * left;
+        expected[2 * i + 1] += s * right;
+    }
+    for (uint32_t i = 0; i < 2 * n; ++i)
+        ASSERT_MIX_EQ(expected[i], mix_buffer[i]);
+
+    for (uint32_t i = 0; i < 2 * n; ++i)
+        mix_buffer[i] = expected[i] = (float) (i % 7);
+    dmSound::MixStereo16(frames, n, from, to, recip, left, right, mix_buffer);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        float gain = dmSound::GetMixGain(from, to, recip, i);
+        expected[2 * i] += frames[2 * i] * gain * left;
+        expected[2 * i + 1] += frames[2 * i + 1] * gain * right;
+    }
+    for (uint32_t i = 0; i < 2 * n; ++i)
+        ASSERT_MIX_EQ(expected[i], mix_buffer[i]);
+
+    delete [] frames;
+    delete [] mix_buffer;
+    delete [] expected;
+}
+
+TEST(dmSoundMixKernels, Master)
+{
+    const uint32_t n = MIX_KERNEL_FRAME_COUNT;
+    const float recip = 1.0f / n;
+
+    float* src = new float[2 * n];
+    float* mix_buffer = new float[2 * n];
+    float* expected = new float[2 * n];
+    int16_t* out = new int16_t[2 * n];
+    for (uint32_t i = 0; i < 2 * n; ++i)
+        src[i] = (float) (rand() % 65536 - 32768) * 3.3f;
+    // Way out of range, must still clip
+    src[5] = 1e12f;
+    src[9] = -1e12f;
+
+    // The gain ramp goes outside [0, 1], where it is clamped
+    for (uint32_t i = 0; i < 2 * n; ++i)
+        mix_buffer[i] = expected[i] = (float) (i % 7);
+    dmSound::MixGroup(src, n, -0.5f, 1.5f, recip, mix_buffer);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        float gain = dmMath::Clamp(dmSound::GetMixGain(-0.5f, 1.5f, recip, i), 0.0f, 1.0f);
+        expected[2 * i] += src[2 * i] * gain;
+        expected[2 * i + 1] += src[2 * i + 1] * gain;
+    }
+    for (uint32_t i = 0; i < 2 * n; ++i)
+        ASSERT_MIX_EQ(expected[i], mix_buffer[i]);
+
+    dmSound::MixMaster(src, n, 0.1f, 2.0f, recip, out);
+    for (uint32_t i = 0; i < 2 * n; ++i)
+    {
+        float s = src[i] * dmSound::GetMixGain(0.1f, 2.0f, recip, i / 2);
+        s = dmMath::Clamp(s, -32768.0f, 32767.0f);
+        ASSERT_NEAR((int16_t) s, out[i], 1);
+    }
+
+    delete [] src;
+    delete [] mix_buffer;
+    delete [] expected;
+    delete [] out;
+}
+
+TEST(dmSoundMixKernels, Meter)
+{
+    const uint32_t n = MIX_KERNEL_FRAME_COUNT;
+
+    float* src = new float[2 * n];
+    for (uint32_t i = 0; i < 2 * n; ++i)
+        src[i] = (float) (rand() % 65536 - 32768);
+    src[6] = 40000.0f;
+    src[2 * n - 1] = -50000.0f; // In the scalar tail
+
+    double expected_sum[2] = { 0, 0 };
+    float expected_peak[2] = { 0, 0 };
+    for (uint32_t i = 0; i < 2 * n; ++i)
+    {
+        float s = src[i] * 0.5f;
+        expected_sum[i % 2] += s * s;
+        expected_peak[i % 2] = dmMath::Max(expected_peak[i % 2], s * s);
+    }
+
+    float sum_sq[2], peak_sq[2];
+    dmSound::SumSquaresAndPeak(src, n, 0.5f, sum_sq, peak_sq);
+    for (uint32_t c = 0; c < 2; ++c)
+    {
+        ASSERT_NEAR((float) expected_sum[c], sum_sq[c], (float) expected_sum[c] * 0.0001f);
+        ASSERT_EQ(expected_peak[c], peak_sq[c]);
+    }
+
+    delete [] src;
+}
+
+static uint32_t DecodeAll(dmSoundCodec::HCodecContext context, dmSoundCodec::HDecoder decoder, char* buffer, uint32_t buffer_size)
+{
+    uint32_t total = 0;
+    while (total < buffer_size)
+    {
+        uint32_t decoded = 0;
+        dmSoundCodec::Result r = dmSoundCodec::Decode(context, decoder, buffer + total, dmMath::Min(buffer_size - total, 4096U), &decoded);
+        if (r != dmSoundCodec::RESULT_OK || decoded == 0)
+            break;
+        total += decoded;
+    }
+    return total;
+}
+
+TEST(dmSoundCodecCache, Cache)
+{
+    const void* ogg = MONO_RESAMPLE_FRAMECOUNT_16000_OGG;
+    const uint32_t ogg_size = MONO_RESAMPLE_FRAMECOUNT_16000_OGG_SIZE;
+    const uint32_t max_pcm_size = 256 * 1024;
+
+    char* expected = new char[max_pcm_size];
+    char* actual = new char[max_pcm_size];
+
+    dmSoundCodec::NewCodecContextParams params;
+    params.m_MaxDecoders = 4;
+    dmSoundCodec::HCodecContext context = dmSoundCodec::New(&params);
+    dmSoundCodec::HDecoder plain;
+    ASSERT_EQ(dmSoundCodec::RESULT_OK, dmSoundCodec::NewDecoder(context, dmSoundCodec::FORMAT_VORBIS, ogg, ogg_size, &plain));
+    dmSoundCodec::Info plain_info;
+    dmSoundCodec::GetInfo(context, plain, &plain_info);
+    const uint32_t pcm_size = DecodeAll(context, plain, expected, max_pcm_size);
+    ASSERT_LT(pcm_size, max_pcm_size);
+    dmSoundCodec::DeleteDecoder(context, plain);
+    dmSoundCodec::Delete(context);
+
+    // Room for exactly one clip
+    params.m_DecodedCacheSize = pcm_size;
+    params.m_DecodedCacheThreshold = pcm_size;
+    context = dmSoundCodec::New(&params);
+
+    dmSoundCodec::HDecoder a, b;
+    ASSERT_EQ(dmSoundCodec::RESULT_OK, dmSoundCodec::NewCachedDecoder(context, dmSoundCodec::FORMAT_VORBIS, ogg, ogg_size, &a));
+    ASSERT_EQ(dmSoundCodec::RESULT_OK, dmSoundCodec::NewCachedDecoder(context, dmSoundCodec::FORMAT_VORBIS, ogg, ogg_size, &b));
+    ASSERT_TRUE(dmSoundCodec::IsCachedDecoder(context, a));
+    ASSERT_TRUE(dmSoundCodec::IsCachedDecoder(context, b));
+
+    dmSoundCodec::Info info;
+    dmSoundCodec::GetInfo(context, a, &info);
+    ASSERT_EQ(pcm_size, info.m_Size);
+    ASSERT_EQ(plain_info.m_Rate, info.m_Rate);
+    ASSERT_EQ(plain_info.m_Channels, info.m_Channels);
+
+    ASSERT_EQ(pcm_size, DecodeAll(context, a, actual, max_pcm_size));
+    ASSERT_EQ(0, memcmp(expected, actual, pcm_size));
+
+    uint32_t skipped = 0;
+    ASSERT_EQ(dmSoundCodec::RESULT_OK, dmSoundCodec::Skip(context, b, 1000, &skipped));
+    ASSERT_EQ(1000U, skipped);
+    ASSERT_EQ(pcm_size - 1000, DecodeAll(context, b, actual, max_pcm_size));
+    ASSERT_EQ(0, memcmp(expected + 1000, actual, pcm_size - 1000));
+
+    // Invalidated while in use, the playing decoders keep the clip
+    dmSoundCodec::InvalidateCache(context, ogg);
+    ASSERT_EQ(dmSoundCodec::RESULT_OK, dmSoundCodec::Reset(context, a));
+    ASSERT_EQ(pcm_size, DecodeAll(context, a, actual, max_pcm_size));
+    ASSERT_EQ(0, memcmp(expected, actual, pcm_size));
+
+    // The cache only fits one clip, another buffer can't be cached while it's in use
+    char* copy = (char*) malloc(ogg_size);
+    memcpy(copy, ogg, ogg_size);
+    dmSoundCodec::HDecoder c, d;
+    ASSERT_EQ(dmSoundCodec::RESULT_OK, dmSoundCodec::NewCachedDecoder(context, dmSoundCodec::FORMAT_VORBIS, ogg, ogg_size, &c));
+    ASSERT_TRUE(dmSoundCodec::IsCachedDecoder(context, c));
+    ASSERT_EQ(dmSoundCodec::RESULT_OK, dmSoundCodec::NewCachedDecoder(context, dmSoundCodec::FORMAT_VORBIS, copy, ogg_size, &d));
+    ASSERT_FALSE(dmSoundCodec::IsCachedDecoder(context, d));
+    ASSERT_EQ(pcm_size, DecodeAll(context, d, actual, max_pcm_size));
+    ASSERT_EQ(0, memcmp(expected, actual, pcm_size));
+    dmSoundCodec::DeleteDecoder(context, d);
+
+    // Unused clips are evicted
+    dmSoundCodec::DeleteDecoder(context, c);
+    ASSERT_EQ(dmSoundCodec::RESULT_OK, dmSoundCodec::NewCachedDecoder(context, dmSoundCodec::FORMAT_VORBIS, copy, ogg_size, &d));
+    ASSERT_TRUE(dmSoundCodec::IsCachedDecoder(context, d));
+
+    dmSoundCodec::DeleteDecoder(context, a);
+    dmSoundCodec::DeleteDecoder(context, b);
+    dmSoundCodec::DeleteDecoder(context, d);
+    free(copy);
+
+    delete [] expected;
+    delete [] actual;
+    dmSoundCodec::Delete(context);
+}
+
+TEST(dmSoundCodecCache, Threshold)
+{
+    const uint32_t max_pcm_size = 256 * 1024;
+    char* buffer = new char[max_pcm_size];
+
+    dmSoundCodec::NewCodecContextParams params;
+    params.m_MaxDecoders = 1;
+    params.m_DecodedCacheSize = max_pcm_size;
+    params.m_DecodedCacheThreshold = 1024;
+    dmSoundCodec::HCodecContext context = dmSoundCodec::New(&params);
+
+    dmSoundCodec::HDecoder decoder;
+    ASSERT_EQ(dmSoundCodec::RESULT_OK, dmSoundCodec::NewDecoder(context, dmSoundCodec::FORMAT_VORBIS, MONO_RESAMPLE_FRAMECOUNT_16000_OGG, MONO_RESAMPLE_FRAMECOUNT_16000_OGG_SIZE, &decoder));
+    uint32_t pcm_size = DecodeAll(context, decoder, buffer, max_pcm_size);
+    dmSoundCodec::DeleteDecoder(context, decoder);
+
+    // Decodes to more than the threshold, the decoder is reset and plays from the start
+    ASSERT_EQ(dmSoundCodec::RESULT_OK, dmSoundCodec::NewCachedDecoder(context, dmSoundCodec::FORMAT_VORBIS, MONO_RESAMPLE_FRAMECOUNT_16000_OGG, MONO_RESAMPLE_FRAMECOUNT_16000_OGG_SIZE, &decoder));
+    ASSERT_FALSE(dmSoundCodec::IsCachedDecoder(context, decoder));
+    ASSERT_EQ(pcm_size, DecodeAll(context, decoder, buffer, max_pcm_size));
+    dmSoundCodec::DeleteDecoder(context, decoder);
+
+    delete [] buffer;
+    dmSoundCodec::Delete(context);
+}
+
+// A device that pulls its frames through the render callback, see dmSound::OpenDeviceParams::m_RenderCallback
+#define RENDER_DEVICE_FRAME_COUNT (96)
+
+struct RenderDevice
+{
+    dmSound::DeviceRenderCallback m_RenderCallback;
+    uint32_t m_BufferCount;
+    bool     m_Started;
+};
+
+RenderDevice* g_RenderDevice = 0;
+
+dmSound::Result DeviceRenderOpen(const dmSound::OpenDeviceParams* params, dmSound::HDevice* device)
+{
+    if (!params->m_RenderCallback)
+    {
+        return dmSound::RESULT_INIT_ERROR;
+    }
+    RenderDevice* d = new RenderDevice;
+    d->m_RenderCallback = params->m_RenderCallback;
+    d->m_BufferCount = params->m_BufferCount;
+    d->m_Started = false;
+    *device = d;
+    g_RenderDevice = d;
+    return dmSound::RESULT_OK;
+}
+
+void DeviceRenderClose(dmSound::HDevice device)
+{
+    delete (RenderDevice*) device;
+    g_RenderDevice = 0;
+}
+
+dmSound::Result DeviceRenderQueue(dmSound::HDevice device, const int16_t* samples, uint32_t sample_count)
+{
+    return dmSound::RESULT_UNSUPPORTED;
+}
+
+uint32_t DeviceRenderFreeBufferSlots(dmSound::HDevice device)
+{
+    return ((RenderDevice*) device)->m_BufferCount;
+}
+
+void DeviceRenderDeviceInfo(dmSound::HDevice device, dmSound::DeviceInfo* info)
+{
+    info->m_MixRate = 44100;
+    info->m_FrameCount = RENDER_DEVICE_FRAME_COUNT;
+}
+
+void DeviceRenderStart(dmSound::HDevice device)
+{
+    ((RenderDevice*) device)->m_Started = true;
+}
+
+void DeviceRenderStop(dmSound::HDevice device)
+{
+    ((RenderDevice*) device)->m_Started = false;
+}
+
+TEST(dmSoundRenderCallback, Mix)
+{
+    dmSound::InitializeParams params;
+    params.m_OutputDevice = "loopback";
+    params.m_UseThread = false;
+    params.m_LowLatency = true;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Initialize(0, &params));
+    ASSERT_NE((RenderDevice*) 0, g_RenderDevice);
+    ASSERT_EQ((LoopbackDevice*) 0, g_LoopbackDevice);
+
+    dmSound::HSoundData sd = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(MONO_TONE_440_44100_88200_WAV, MONO_TONE_440_44100_88200_WAV_SIZE, dmSound::SOUND_DATA_TYPE_WAV, &sd, 1234));
+    dmSound::HSoundInstance instance = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instance));
+
+    // Update starts the device, but doesn't mix anything
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+    ASSERT_TRUE(g_RenderDevice->m_Started);
+
+    // Pull a frame count that doesn't match the native one, so that mixed buffers are split over callbacks
+    const uint32_t frame_count = 250;
+    int16_t frames[frame_count * 2];
+    uint32_t total_frames = 0;
+    int16_t peak = 0;
+    while (dmSound::IsPlaying(instance))
+    {
+        g_RenderDevice->m_RenderCallback(frames, frame_count);
+        for (uint32_t i = 0; i < frame_count * 2; ++i)
+        {
+            peak = dmMath::Max(peak, frames[i]);
+        }
+        total_frames += frame_count;
+        ASSERT_LT(total_frames, 88200u * 2);
+    }
+
+    // The whole tone is played, at 0.8 amplitude and panned to the center
+    ASSERT_GE(total_frames, 88200u - RENDER_DEVICE_FRAME_COUNT);
+    ASSERT_NEAR(0.8f * 0.707107f * 32768.0f, (float) peak, 100.0f);
+
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+    ASSERT_EQ((RenderDevice*) 0, g_RenderDevice);
+}
+
+TEST(dmSoundSpectrum, Tone)
+{
+    dmSound::InitializeParams params;
+    params.m_OutputDevice = "loopback";
+    params.m_UseThread = false;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Initialize(0, &params));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::AddGroup("music"));
+
+    dmSound::HSoundData sd = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(MONO_TONE_440_44100_88200_WAV, MONO_TONE_440_44100_88200_WAV_SIZE, dmSound::SOUND_DATA_TYPE_WAV, &sd, 1234));
+    dmSound::HSoundInstance instance = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetInstanceGroup(instance, "music"));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instance));
+
+    const uint32_t band_count = 8;
+    float bands[band_count];
+    ASSERT_EQ(dmSound::RESULT_NO_SUCH_GROUP, dmSound::GetGroupSpectrum(dmHashString64("no_such_group"), bands, band_count));
+    ASSERT_EQ(dmSound::RESULT_INVALID_PROPERTY, dmSound::GetGroupSpectrum(dmHashString64("music"), bands, 0));
+
+    // Nothing is analyzed until the spectrum is requested
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::GetGroupSpectrum(dmHashString64("music"), bands, band_count));
+    for (uint32_t i = 0; i < band_count; ++i)
+    {
+        ASSERT_EQ(0.0f, bands[i]);
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+    }
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::GetGroupSpectrum(dmHashString64("music"), bands, band_count));
+
+    // The 440 Hz tone is in bin 5 of 256, which is in the third of 8 bands. It is centered and mixed to mono
+    uint32_t loudest = 0;
+    for (uint32_t i = 1; i < band_count; ++i)
+    {
+        if (bands[i] > bands[loudest])
+            loudest = i;
+    }
+    ASSERT_EQ(2u, loudest);
+    ASSERT_NEAR(0.8f * 0.707107f, bands[2], 0.1f);
+    ASSERT_GT(0.02f, bands[band_count - 1]);
+
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+}
+
+// Plays sounds in a few groups and returns all frames queued to the loopback device
+static void MixGroups(dmJob::HContext job_context, dmArray<int16_t>& output)
+{
+    const uint32_t instance_count = 12;
+    const char* groups[] = { "music", "fx", "voice" };
+
+    dmSound::InitializeParams params;
+    params.m_OutputDevice = "loopback";
+    params.m_UseThread = false;
+    params.m_JobContext = job_context;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Initialize(0, &params));
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::AddGroup(groups[i]));
+    }
+
+    dmSound::HSoundData sd = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(MONO_TONE_440_44100_88200_WAV, MONO_TONE_440_44100_88200_WAV_SIZE, dmSound::SOUND_DATA_TYPE_WAV, &sd, 1234));
+
+    dmSound::HSoundInstance instances[instance_count];
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &instances[i]));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetInstanceGroup(instances[i], groups[i % 3]));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetParameter(instances[i], dmSound::PARAMETER_GAIN, Vectormath::Aos::Vector4(0.05f + 0.01f * i, 0, 0, 0)));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetParameter(instances[i], dmSound::PARAMETER_PAN, Vectormath::Aos::Vector4(-1.0f + 0.15f * i, 0, 0, 0)));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instances[i]));
+    }
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetGroupGain(dmHashString64("fx"), 0.5f));
+
+    while (dmSound::IsPlaying(instances[0]))
+    {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+        ASSERT_LT(g_LoopbackDevice->m_NumWrites, 1000);
+    }
+
+    output.SetCapacity(g_LoopbackDevice->m_AllOutput.Size());
+    output.PushArray(g_LoopbackDevice->m_AllOutput.Begin(), g_LoopbackDevice->m_AllOutput.Size());
+
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instances[i]));
+    }
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+}
+
+TEST(dmSoundParallelMix, MatchesSerial)
+{
+    dmArray<int16_t> serial;
+    MixGroups(0, serial);
+
+    dmJob::NewContextParams job_params;
+    job_params.m_WorkerCount = 3;
+    dmJob::HContext job_context = dmJob::NewContext(job_params);
+    dmArray<int16_t> parallel;
+    MixGroups(job_context, parallel);
+    dmJob::DeleteContext(job_context);
+
+    // Each group is mixed in the same order on the job threads, so the output is identical
+    ASSERT_LT(0u, serial.Size());
+    ASSERT_EQ(serial.Size(), parallel.Size());
+    ASSERT_EQ(0, memcmp(serial.Begin(), parallel.Begin(), serial.Size() * sizeof(int16_t)));
+}
+
 DM_DECLARE_SOUND_DEVICE(LoopBackDevice, "loopback", DeviceLoopbackOpen, DeviceLoopbackClose, DeviceLoopbackQueue, DeviceLoopbackFreeBufferSlots, DeviceLoopbackDeviceInfo, DeviceLoopbackRestart, DeviceLoopbackStop);
+DM_DECLARE_SOUND_DEVICE(RenderSoundDevice, "low_latency", DeviceRenderOpen, DeviceRenderClose, DeviceRenderQueue, DeviceRenderFreeBufferSlots, DeviceRenderDeviceInfo, DeviceRenderStart, DeviceRenderStop);
 
 int main(int argc, char **argv)
 {
@@ -228,6 +228,85 @@ TEST_F(TexcTest, MipMaps)
 }
 
 
+TEST_F(TexcTest, EncodeBatch)
+{
+    dmTexc::EncodeBatchItem items[format_count];
+    memset(items, 0, sizeof(items));
+    for (uint32_t i = 0; i < format_count; ++i)
+    {
+        Format& format = formats[i];
+        items[i].m_Texture = (*format.m_CreateFn)(format.m_CompressionType);
+        items[i].m_PixelFormat = dmTexc::PF_R8G8B8A8;
+        items[i].m_ColorSpace = dmTexc::CS_LRGB;
+        items[i].m_CompressionLevel = dmTexc::CL_FAST;
+        items[i].m_CompressionType = format.m_CompressionType;
+        items[i].m_Width = 4;
+        items[i].m_Height = 4;
+        items[i].m_MipMaps = 1;
+    }
+
+    ASSERT_TRUE(dmTexc::EncodeBatch(items, format_count, 4, 0));
+
+    for (uint32_t i = 0; i < format_count; ++i)
+    {
+        ASSERT_TRUE(items[i].m_Encoded);
+        ASSERT_FALSE(items[i].m_FromCache);
+
+        // Same result as encoding the texture by itself
+        Format& format = formats[i];
+        dmTexc::HTexture texture = (*format.m_CreateFn)(format.m_CompressionType);
+        ASSERT_TRUE(dmTexc::Resize(texture, 4, 4));
+        ASSERT_TRUE(dmTexc::GenMipMaps(texture));
+        ASSERT_TRUE(dmTexc::Encode(texture, dmTexc::PF_R8G8B8A8, dmTexc::CS_LRGB, dmTexc::CL_FAST, format.m_CompressionType, true, 1));
+
+        uint32_t size = dmTexc::GetTotalDataSize(texture);
+        ASSERT_EQ(size, dmTexc::GetTotalDataSize(items[i].m_Texture));
+        uint8_t expected[256];
+        uint8_t actual[256];
+        ASSERT_GE(sizeof(expected), size);
+        dmTexc::GetData(texture, expected, size);
+        dmTexc::GetData(items[i].m_Texture, actual, size);
+        ASSERT_ARRAY_EQ_LEN(expected, actual, size);
+
+        dmTexc::Destroy(texture);
+        dmTexc::Destroy(items[i].m_Texture);
+    }
+}
+
+TEST_F(TexcTest, EncodeBatchCache)
+{
+    const char* cache_dir = ".";
+    dmTexc::EncodeBatchItem item;
+    memset(&item, 0, sizeof(item));
+    item.m_PixelFormat = dmTexc::PF_R5G6B5;
+    item.m_ColorSpace = dmTexc::CS_LRGB;
+    item.m_CompressionLevel = dmTexc::CL_FAST;
+    item.m_CompressionType = dmTexc::CT_DEFAULT;
+    item.m_MipMaps = 1;
+
+    uint8_t encoded[2][64];
+    uint32_t sizes[2];
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        item.m_Texture = CreateDefaultRGB24(dmTexc::CT_DEFAULT);
+        ASSERT_TRUE(dmTexc::EncodeBatch(&item, 1, 1, cache_dir));
+        ASSERT_TRUE(item.m_Encoded);
+        if (i == 1)
+            ASSERT_TRUE(item.m_FromCache);
+        sizes[i] = dmTexc::GetTotalDataSize(item.m_Texture);
+        ASSERT_GE(sizeof(encoded[i]), sizes[i]);
+        dmTexc::GetData(item.m_Texture, encoded[i], sizes[i]);
+
+        dmTexc::Header header;
+        dmTexc::GetHeader(item.m_Texture, &header);
+        ASSERT_EQ(2u, header.m_MipMapCount);
+        dmTexc::Destroy(item.m_Texture);
+    }
+    // The second time, the result may come from the cache and must be identical
+    ASSERT_EQ(sizes[0], sizes[1]);
+    ASSERT_ARRAY_EQ_LEN(encoded[0], encoded[1], sizes[0]);
+}
+
 #define ASSERT_RGBA(exp, act)\
     ASSERT_EQ((exp)[0], (act)[0]);\
     ASSERT_EQ((exp)[1], (act)[1]);\
@@ -129,7 +129,7 @@ namespace dmTexc
         return t->m_Encoder.m_FnFlip(t, flip_axis);
     }
 
-    static uint32_t GetNumThreads(int max_threads)
+    uint32_t GetNumThreads(int max_threads)
     {
         uint32_t num_threads = max_threads;
         if (max_threads > 1)
@@ -212,6 +212,7 @@ namespace dmTexc
     DM_TEXC_TRAMPOLINE1(bool, GenMipMaps, HTexture);
     DM_TEXC_TRAMPOLINE2(bool, Flip, HTexture, FlipAxis);
     DM_TEXC_TRAMPOLINE7(bool, Encode, HTexture, PixelFormat, ColorSpace, CompressionLevel, CompressionType, bool, int);
+    DM_TEXC_TRAMPOLINE4(bool, EncodeBatch, EncodeBatchItem*, uint32_t, int, const char*);
     DM_TEXC_TRAMPOLINE2(HBuffer, CompressBuffer, void*, uint32_t);
     DM_TEXC_TRAMPOLINE1(uint32_t, GetTotalBufferDataSize, HBuffer);
     DM_TEXC_TRAMPOLINE3(uint32_t, GetBufferData, HBuffer, void*, uint32_t);
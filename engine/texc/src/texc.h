@@ -121,6 +121,31 @@ namespace dmTexc
      */
     const HTexture INVALID_TEXTURE = 0;
 
+    /**
+     * A texture to process with EncodeBatch.
+     * The steps are applied in the same order as when calling the functions one by one:
+     * resize, pre-multiply alpha, generate mip maps, flip and encode.
+     */
+    struct EncodeBatchItem
+    {
+        HTexture            m_Texture;
+        PixelFormat         m_PixelFormat;
+        ColorSpace          m_ColorSpace;
+        CompressionLevel    m_CompressionLevel;
+        CompressionType     m_CompressionType;
+        /// Size to resize to, 0 keeps the current size
+        uint32_t            m_Width;
+        uint32_t            m_Height;
+        uint8_t             m_PreMultiplyAlpha;
+        uint8_t             m_MipMaps;
+        uint8_t             m_FlipX;
+        uint8_t             m_FlipY;
+        /// Output. Set when the texture was encoded
+        uint8_t             m_Encoded;
+        /// Output. Set when the encoded result was read from the cache
+        uint8_t             m_FromCache;
+    };
+
 #define DM_TEXC_PROTO(ret, name,  ...) \
     \
     ret name(__VA_ARGS__);\
@@ -188,6 +213,14 @@ namespace dmTexc
      */
     DM_TEXC_PROTO(bool, Encode, HTexture texture, PixelFormat pixelFormat, ColorSpace color_space, CompressionLevel compressionLevel, CompressionType compression_type, bool mipmaps, int max_threads);
 
+    /**
+     * Process and encode many textures, spread across up to max_threads threads.
+     * If cache_dir is set, results are stored there keyed on a hash of the source pixels and
+     * the settings, and textures with a matching entry are restored instead of being encoded again.
+     * @return true if all items were encoded
+     */
+    DM_TEXC_PROTO(bool, EncodeBatch, EncodeBatchItem* items, uint32_t item_count, int max_threads, const char* cache_dir);
+
     // Now only used for font glyphs
     // Compresses an image buffer
     DM_TEXC_PROTO(HBuffer, CompressBuffer, void* data, uint32_t size);
@@ -0,0 +1,290 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "texc.h"
+#include "texc_private.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <dlib/dstrings.h>
+#include <dlib/hash.h>
+#include <dlib/log.h>
+#include <dlib/math.h>
+#include <dlib/sys.h>
+
+namespace dmTexc
+{
+    // Bump when the output of any encoder changes, to invalidate old cache entries
+    static const uint32_t CACHE_VERSION = 1;
+    static const uint32_t CACHE_MAGIC = 0x43584554; // "TEXC"
+
+    struct CacheHeader
+    {
+        uint32_t m_Magic;
+        uint32_t m_Version;
+        uint32_t m_Width;
+        uint32_t m_Height;
+        uint32_t m_MipCount;
+        uint32_t m_DataSize;
+    };
+
+    struct CacheMip
+    {
+        uint32_t m_Width;
+        uint32_t m_Height;
+        uint32_t m_ByteSize;
+        uint32_t m_IsCompressed;
+    };
+
+    struct BatchContext
+    {
+        EncodeBatchItem*        m_Items;
+        std::vector<uint32_t>   m_Order;
+        std::atomic<uint32_t>   m_Next;
+        std::atomic<uint32_t>   m_Failed;
+        const char*             m_CacheDir;
+        uint32_t                m_ThreadsPerItem;
+    };
+
+    // Both encoders keep the source image as RGBA8888 until it is encoded
+    static const uint8_t* GetSourcePixels(Texture* t)
+    {
+        if (t->m_CompressionType == CT_DEFAULT)
+            return t->m_Mips[0].m_Data;
+        return (const uint8_t*)t->m_BasisImage.get_ptr();
+    }
+
+    static uint64_t HashItem(const EncodeBatchItem* item)
+    {
+        Texture* t = (Texture*)item->m_Texture;
+
+        uint32_t settings[] = {
+            CACHE_VERSION,
+            t->m_Width, t->m_Height, (uint32_t)t->m_PixelFormat, (uint32_t)t->m_CompressionType,
+            (uint32_t)item->m_PixelFormat, (uint32_t)item->m_ColorSpace, (uint32_t)item->m_CompressionLevel, (uint32_t)item->m_CompressionType,
+            item->m_Width, item->m_Height, item->m_PreMultiplyAlpha, item->m_MipMaps, item->m_FlipX, item->m_FlipY,
+        };
+
+        HashState64 state;
+        dmHashInit64(&state, false);
+        dmHashUpdateBuffer64(&state, settings, sizeof(settings));
+        dmHashUpdateBuffer64(&state, GetSourcePixels(t), t->m_Width * t->m_Height * 4);
+        return dmHashFinal64(&state);
+    }
+
+    static void GetCachePath(const char* cache_dir, uint64_t hash, char* path, uint32_t path_size)
+    {
+        dmSnPrintf(path, path_size, "%s/%016llx.texc", cache_dir, (unsigned long long)hash);
+    }
+
+    static bool ReadCache(const char* path, Texture* t)
+    {
+        FILE* f = fopen(path, "rb");
+        if (!f)
+            return false;
+
+        CacheHeader header;
+        bool ok = fread(&header, sizeof(header), 1, f) == 1 && header.m_Magic == CACHE_MAGIC && header.m_Version == CACHE_VERSION;
+
+        dmArray<CacheMip> mips;
+        dmArray<uint8_t> data;
+        if (ok)
+        {
+            mips.SetCapacity(header.m_MipCount);
+            mips.SetSize(header.m_MipCount);
+            data.SetCapacity(header.m_DataSize);
+            data.SetSize(header.m_DataSize);
+            ok = (header.m_MipCount == 0 || fread(mips.Begin(), sizeof(CacheMip), header.m_MipCount, f) == header.m_MipCount) &&
+                 (header.m_DataSize == 0 || fread(data.Begin(), 1, header.m_DataSize, f) == header.m_DataSize);
+        }
+        fclose(f);
+        if (!ok)
+            return false;
+
+        t->m_Width = header.m_Width;
+        t->m_Height = header.m_Height;
+        if (t->m_CompressionType == CT_DEFAULT)
+        {
+            for (uint32_t i = 0; i < t->m_Mips.Size(); ++i)
+            {
+                delete[] t->m_Mips[i].m_Data;
+            }
+            t->m_Mips.SetSize(0);
+            if (t->m_Mips.Capacity() < header.m_MipCount)
+                t->m_Mips.SetCapacity(header.m_MipCount);
+
+            const uint8_t* read_ptr = data.Begin();
+            for (uint32_t i = 0; i < header.m_MipCount; ++i)
+            {
+                TextureData mip_level;
+                mip_level.m_Width = mips[i].m_Width;
+                mip_level.m_Height = mips[i].m_Height;
+                mip_level.m_ByteSize = mips[i].m_ByteSize;
+                mip_level.m_IsCompressed = (uint8_t)mips[i].m_IsCompressed;
+                mip_level.m_Data = new uint8_t[mip_level.m_ByteSize];
+                memcpy(mip_level.m_Data, read_ptr, mip_level.m_ByteSize);
+                read_ptr += mip_level.m_ByteSize;
+                t->m_Mips.Push(mip_level);
+            }
+        }
+        else
+        {
+            t->m_BasisFile.Swap(data);
+        }
+        return true;
+    }
+
+    static void WriteCache(const char* path, const char* tmp_path, Texture* t)
+    {
+        uint32_t data_size = GetTotalDataSize(t);
+        uint8_t* data = new uint8_t[data_size];
+        GetData(t, data, data_size);
+
+        CacheHeader header;
+        header.m_Magic = CACHE_MAGIC;
+        header.m_Version = CACHE_VERSION;
+        header.m_Width = t->m_Width;
+        header.m_Height = t->m_Height;
+        header.m_MipCount = t->m_CompressionType == CT_DEFAULT ? t->m_Mips.Size() : 0;
+        header.m_DataSize = data_size;
+
+        // Write to a temporary file first, so that concurrent bundles never see a partial entry
+        FILE* f = fopen(tmp_path, "wb");
+        if (f)
+        {
+            bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+            for (uint32_t i = 0; ok && i < header.m_MipCount; ++i)
+            {
+                const TextureData& mip_level = t->m_Mips[i];
+                CacheMip mip = { mip_level.m_Width, mip_level.m_Height, mip_level.m_ByteSize, mip_level.m_IsCompressed };
+                ok = fwrite(&mip, sizeof(mip), 1, f) == 1;
+            }
+            ok = ok && (data_size == 0 || fwrite(data, 1, data_size, f) == data_size);
+            fclose(f);
+
+            if (!ok || dmSys::RenameFile(path, tmp_path) != dmSys::RESULT_OK)
+            {
+                dmLogWarning("Failed to write texture cache entry '%s'", path);
+                dmSys::Unlink(tmp_path);
+            }
+        }
+        delete[] data;
+    }
+
+    static bool ProcessItem(EncodeBatchItem* item, uint32_t num_threads)
+    {
+        HTexture texture = item->m_Texture;
+        Texture* t = (Texture*)texture;
+
+        if (item->m_Width != 0 && item->m_Height != 0 && (item->m_Width != t->m_Width || item->m_Height != t->m_Height))
+        {
+            if (!Resize(texture, item->m_Width, item->m_Height))
+                return false;
+        }
+        if (item->m_PreMultiplyAlpha && !PreMultiplyAlpha(texture))
+            return false;
+        if (item->m_MipMaps && !GenMipMaps(texture))
+            return false;
+        if (item->m_FlipX && !Flip(texture, FLIP_AXIS_X))
+            return false;
+        if (item->m_FlipY && !Flip(texture, FLIP_AXIS_Y))
+            return false;
+
+        return t->m_Encoder.m_FnEncode(t, num_threads, item->m_PixelFormat, item->m_CompressionType, item->m_CompressionLevel);
+    }
+
+    static void BatchWorker(BatchContext* ctx)
+    {
+        while (true)
+        {
+            uint32_t next = ctx->m_Next++;
+            if (next >= ctx->m_Order.size())
+                break;
+
+            EncodeBatchItem* item = &ctx->m_Items[ctx->m_Order[next]];
+            item->m_Encoded = 0;
+            item->m_FromCache = 0;
+
+            char path[1024];
+            if (ctx->m_CacheDir)
+            {
+                GetCachePath(ctx->m_CacheDir, HashItem(item), path, sizeof(path));
+                if (ReadCache(path, (Texture*)item->m_Texture))
+                {
+                    item->m_Encoded = 1;
+                    item->m_FromCache = 1;
+                    continue;
+                }
+            }
+
+            if (!ProcessItem(item, ctx->m_ThreadsPerItem))
+            {
+                ctx->m_Failed++;
+                continue;
+            }
+            item->m_Encoded = 1;
+
+            if (ctx->m_CacheDir)
+            {
+                char tmp_path[1024 + 16];
+                dmSnPrintf(tmp_path, sizeof(tmp_path), "%s.tmp%u", path, ctx->m_Order[next]);
+                WriteCache(path, tmp_path, (Texture*)item->m_Texture);
+            }
+        }
+    }
+
+    bool EncodeBatch(EncodeBatchItem* items, uint32_t item_count, int max_threads, const char* cache_dir)
+    {
+        if (item_count == 0)
+            return true;
+
+        BatchContext ctx;
+        ctx.m_Items = items;
+        ctx.m_Next = 0;
+        ctx.m_Failed = 0;
+        ctx.m_CacheDir = cache_dir && cache_dir[0] ? cache_dir : 0;
+
+        // Start with the largest textures, so that a big one isn't left running alone at the end
+        ctx.m_Order.resize(item_count);
+        for (uint32_t i = 0; i < item_count; ++i)
+            ctx.m_Order[i] = i;
+        std::sort(ctx.m_Order.begin(), ctx.m_Order.end(), [items](uint32_t a, uint32_t b) {
+            Texture* ta = (Texture*)items[a].m_Texture;
+            Texture* tb = (Texture*)items[b].m_Texture;
+            return ta->m_Width * ta->m_Height > tb->m_Width * tb->m_Height;
+        });
+
+        uint32_t num_threads = dmMath::Max(1U, GetNumThreads(max_threads));
+        uint32_t num_workers = dmMath::Min(num_threads, item_count);
+        // Threads not needed for a worker of their own are handed to the encoders of each item
+        ctx.m_ThreadsPerItem = dmMath::Max(1U, num_threads / item_count);
+
+        std::vector<std::thread> workers;
+        for (uint32_t i = 1; i < num_workers; ++i)
+            workers.push_back(std::thread(BatchWorker, &ctx));
+        BatchWorker(&ctx);
+        for (uint32_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+
+        if (ctx.m_Failed > 0)
+        {
+            dmLogError("Failed to encode %u of %u textures", ctx.m_Failed.load(), item_count);
+            return false;
+        }
+        return true;
+    }
+}
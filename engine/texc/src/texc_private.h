@@ -101,6 +101,9 @@ namespace dmTexc
     // Input/output image is RGBA8888
     void        DitherRGBx565(uint8_t* data, uint32_t width, uint32_t height);
 
+    // Number of threads to use, given the max_threads passed to the public api
+    uint32_t    GetNumThreads(int max_threads);
+
     void        DebugPrint(uint8_t* p, uint32_t width, uint32_t height, uint32_t num_channels);
 }
 